@@ -0,0 +1,415 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ *
+ * Compression advisor. It samples records spread through an existing evio file,
+ * re-encodes their events through RecordOutput with each combination of chosen
+ * compression types, record sizes and thread counts, then decompresses them with
+ * RecordInput. For each combination it reports the compression ratio and both the
+ * total and per-core compress and decompress throughput. Given the rate at which
+ * data arrives, it recommends the EventWriter configuration with the best ratio
+ * which keeps up with it.
+ */
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+static void usage() {
+    cout << "Usage: evioCompressionAdvisor [options] <file>" << endl;
+    cout << "  -c <types>      compression types to try, comma separated: none, lz4, lz4best, gzip, zstd" << endl;
+    cout << "                  (default all those supported)" << endl;
+    cout << "  -r <sizes>      max bytes of events in a record, comma separated, K or M suffix allowed" << endl;
+    cout << "                  (default 1M,4M,8M)" << endl;
+    cout << "  -t <threads>    thread counts, comma separated (default 1,2,4,... up to one per core)" << endl;
+    cout << "  -n <records>    records of file to sample, spread evenly through it (default 16)" << endl;
+    cout << "  -m <MB>         most MB of events to sample (default 64)" << endl;
+    cout << "  -s <seconds>    least time spent measuring each phase of each setting (default 0.5)" << endl;
+    cout << "  -b <MB/s>       rate data arrives at, for recommending a configuration" << endl;
+    cout << endl;
+    cout << "  Throughput is of uncompressed bytes. The recommended configuration is the one with" << endl;
+    cout << "  the best ratio whose compression keeps up with the arrival rate plus 20%." << endl;
+}
+
+
+static bool toCompression(string const & name, evio::Compressor::CompressionType & type) {
+    using evio::Compressor;
+    if      (name == "none")    type = Compressor::UNCOMPRESSED;
+    else if (name == "lz4")     type = Compressor::LZ4;
+    else if (name == "lz4best") type = Compressor::LZ4_BEST;
+    else if (name == "gzip")    type = Compressor::GZIP;
+    else if (name == "zstd")    type = Compressor::ZSTD;
+    else return false;
+    return true;
+}
+
+
+static const char *compressionName(evio::Compressor::CompressionType type) {
+    using evio::Compressor;
+    switch (type) {
+        case Compressor::LZ4:      return "lz4";
+        case Compressor::LZ4_BEST: return "lz4best";
+        case Compressor::GZIP:     return "gzip";
+        case Compressor::ZSTD:     return "zstd";
+        default:                   return "none";
+    }
+}
+
+
+static const char *compressionEnum(evio::Compressor::CompressionType type) {
+    using evio::Compressor;
+    switch (type) {
+        case Compressor::LZ4:      return "Compressor::LZ4";
+        case Compressor::LZ4_BEST: return "Compressor::LZ4_BEST";
+        case Compressor::GZIP:     return "Compressor::GZIP";
+        case Compressor::ZSTD:     return "Compressor::ZSTD";
+        default:                   return "Compressor::UNCOMPRESSED";
+    }
+}
+
+
+/** @return list split at commas. */
+static vector<string> splitList(string const & s) {
+    vector<string> items;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+
+/** @return bytes given as a number with an optional K or M suffix. */
+static uint32_t toBytes(string const & s) {
+    size_t end;
+    uint64_t n = stoull(s, &end);
+    if (end < s.size()) {
+        char c = s[end];
+        if      (c == 'K' || c == 'k') n *= 1024;
+        else if (c == 'M' || c == 'm') n *= 1024 * 1024;
+        else throw invalid_argument(s);
+    }
+    if (n < 1024 || n > 512 * 1024 * 1024) throw out_of_range(s);
+    return (uint32_t) n;
+}
+
+
+/** Sampled events, one after another. */
+struct Sample {
+    vector<uint8_t> data;
+    vector<uint32_t> offsets, lengths;
+    evio::ByteOrder order = evio::ByteOrder::ENDIAN_LOCAL;
+};
+
+
+/** Events of one record and that record compressed, for one setting. */
+struct Batch {
+    uint32_t first = 0, count = 0;
+    uint64_t bytes = 0;
+    shared_ptr<evio::ByteBuffer> record;
+};
+
+
+/** Results of one combination of settings. */
+struct Result {
+    evio::Compressor::CompressionType type;
+    uint32_t recordSize;
+    uint32_t threads;
+    double ratio;
+    double compressMB;
+    double decompressMB;
+};
+
+
+/**
+ * Run a job on each batch, in the given number of threads, over and over until
+ * at least the given time has passed.
+ * @return uncompressed MB processed each second by all threads.
+ */
+template<typename Job>
+static double measure(vector<Batch> const & batches, uint64_t sampleBytes, uint32_t threads,
+                      double minSeconds, Job const & job) {
+
+    uint64_t rounds = 0;
+    auto start = chrono::steady_clock::now();
+    double seconds;
+
+    do {
+        atomic<size_t> next {0};
+        vector<thread> workers;
+        for (uint32_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                for (size_t b; (b = next++) < batches.size(); ) {
+                    job(batches[b], t);
+                }
+            });
+        }
+        for (auto & w : workers) w.join();
+        rounds++;
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (seconds < minSeconds);
+
+    return (double) sampleBytes * rounds / seconds / 1e6;
+}
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    string fileName;
+    vector<Compressor::CompressionType> types;
+    vector<uint32_t> recordSizes, threadCounts;
+    uint32_t sampleRecords = 16;
+    double sampleMB = 64., minSeconds = 0.5, arrivalMB = 0.;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg(argv[i]);
+            bool more = i + 1 < argc;
+            if      (arg == "-n" && more) sampleRecords = stoul(argv[++i]);
+            else if (arg == "-m" && more) sampleMB = stod(argv[++i]);
+            else if (arg == "-s" && more) minSeconds = stod(argv[++i]);
+            else if (arg == "-b" && more) arrivalMB = stod(argv[++i]);
+            else if (arg == "-c" && more) {
+                for (auto & name : splitList(argv[++i])) {
+                    Compressor::CompressionType type;
+                    if (!toCompression(name, type)) {
+                        usage();
+                        return 1;
+                    }
+                    types.push_back(type);
+                }
+            }
+            else if (arg == "-r" && more) {
+                for (auto & size : splitList(argv[++i])) recordSizes.push_back(toBytes(size));
+            }
+            else if (arg == "-t" && more) {
+                for (auto & count : splitList(argv[++i])) threadCounts.push_back((uint32_t) stoul(count));
+            }
+            else if (arg == "-h" || arg == "--help") {
+                usage();
+                return 0;
+            }
+            else if (arg[0] != '-' && fileName.empty()) {
+                fileName = arg;
+            }
+            else {
+                usage();
+                return 1;
+            }
+        }
+    }
+    catch (std::exception & e) {
+        usage();
+        return 1;
+    }
+
+    if (fileName.empty() || sampleRecords < 1 || sampleMB <= 0. || minSeconds < 0. || arrivalMB < 0. ||
+        find(threadCounts.begin(), threadCounts.end(), 0U) != threadCounts.end()) {
+        usage();
+        return 1;
+    }
+
+    uint32_t cores = max(1U, thread::hardware_concurrency());
+    if (types.empty()) {
+        for (auto type : {Compressor::UNCOMPRESSED, Compressor::LZ4, Compressor::LZ4_BEST,
+                          Compressor::GZIP, Compressor::ZSTD}) {
+            if (Compressor::isSupported(type)) types.push_back(type);
+        }
+    }
+    if (recordSizes.empty()) {
+        recordSizes = {1024 * 1024, 4 * 1024 * 1024, 8 * 1024 * 1024};
+    }
+    if (threadCounts.empty()) {
+        for (uint32_t t = 1; t < cores; t *= 2) threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    try {
+        for (auto type : types) {
+            if (!Compressor::isSupported(type)) {
+                throw EvioException(string("compression ") + compressionName(type) + " not supported by this build");
+            }
+        }
+
+        //-------------------------------------------
+        // Sample events from records spread evenly through the file
+        //-------------------------------------------
+        Sample sample;
+        Reader reader(fileName);
+        sample.order = reader.getByteOrder();
+        uint32_t recordCount = reader.getRecordCount();
+        uint32_t want = min(sampleRecords, recordCount);
+        auto maxBytes = (uint64_t) (sampleMB * 1024 * 1024);
+
+        for (uint32_t s = 0; s < want && sample.data.size() < maxBytes; s++) {
+            uint32_t r = (uint32_t) ((uint64_t) s * recordCount / want);
+            if (!reader.readRecord(r)) continue;
+            RecordInput & record = reader.getCurrentRecordStream();
+            for (uint32_t i = 0; i < record.getEntries() && sample.data.size() < maxBytes; i++) {
+                ByteBufferView event = record.getEventView(i);
+                sample.offsets.push_back((uint32_t) sample.data.size());
+                sample.lengths.push_back((uint32_t) event.size());
+                sample.data.insert(sample.data.end(), event.data(), event.data() + event.size());
+            }
+        }
+
+        if (sample.lengths.empty()) {
+            throw EvioException("no events in " + fileName);
+        }
+
+        uint64_t sampleBytes = sample.data.size();
+        cout << "Sampled " << sample.lengths.size() << " events, " << sampleBytes << " bytes, from " <<
+                want << " of " << recordCount << " records of " << fileName << endl;
+        cout << "Measuring on " << cores << " cores" << endl << endl;
+
+        cout << setw(9) << "type" << setw(10) << "record" << setw(9) << "threads" << setw(8) << "ratio" <<
+                setw(13) << "comp MB/s" << setw(12) << "per core" <<
+                setw(15) << "decomp MB/s" << setw(12) << "per core" << endl;
+
+        vector<Result> results;
+
+        for (auto type : types) {
+            for (uint32_t recordSize : recordSizes) {
+
+                //-------------------------------------------
+                // Fill records as a writer would, keeping each compressed
+                //-------------------------------------------
+                vector<Batch> batches;
+                uint64_t compressedBytes = 0;
+                {
+                    RecordOutput out(sample.order, 1000000, recordSize, type);
+                    auto finish = [&](Batch & batch) {
+                        out.build();
+                        auto bin = out.getBinaryBuffer();
+                        batch.record = make_shared<ByteBuffer>(bin->limit());
+                        batch.record->order(sample.order);
+                        memcpy(batch.record->array(), bin->array() + bin->arrayOffset(), bin->limit());
+                        compressedBytes += bin->limit();
+                        batches.push_back(move(batch));
+                        out.reset();
+                    };
+
+                    Batch batch;
+                    for (uint32_t i = 0; i < sample.lengths.size(); i++) {
+                        const uint8_t *event = sample.data.data() + sample.offsets[i];
+                        if (!out.addEvent(event, sample.lengths[i])) {
+                            if (batch.count == 0) {
+                                throw EvioException("event of " + to_string(sample.lengths[i]) +
+                                                    " bytes does not fit in record of " + to_string(recordSize));
+                            }
+                            finish(batch);
+                            batch = Batch();
+                            batch.first = i;
+                            out.addEvent(event, sample.lengths[i]);
+                        }
+                        batch.count++;
+                        batch.bytes += sample.lengths[i];
+                    }
+                    finish(batch);
+                }
+
+                double ratio = compressedBytes > 0 ? (double) sampleBytes / compressedBytes : 0.;
+
+                for (uint32_t threads : threadCounts) {
+                    // Each thread has its own record to fill and one to read into
+                    vector<unique_ptr<RecordOutput>> outs;
+                    vector<unique_ptr<RecordInput>> ins;
+                    for (uint32_t t = 0; t < threads; t++) {
+                        outs.emplace_back(new RecordOutput(sample.order, 1000000, recordSize, type));
+                        ins.emplace_back(new RecordInput(sample.order));
+                    }
+
+                    double compressMB = measure(batches, sampleBytes, threads, minSeconds,
+                        [&](Batch const & batch, uint32_t t) {
+                            RecordOutput & out = *outs[t];
+                            out.reset();
+                            for (uint32_t i = batch.first; i < batch.first + batch.count; i++) {
+                                out.addEvent(sample.data.data() + sample.offsets[i], sample.lengths[i]);
+                            }
+                            out.build();
+                        });
+
+                    double decompressMB = measure(batches, sampleBytes, threads, minSeconds,
+                        [&](Batch const & batch, uint32_t t) {
+                            ins[t]->readRecord(*batch.record, 0);
+                        });
+
+                    results.push_back({type, recordSize, threads, ratio, compressMB, decompressMB});
+
+                    cout << setw(9) << compressionName(type) << setw(9) << recordSize / 1024 << "K" <<
+                            setw(9) << threads << fixed << setw(8) << setprecision(2) << ratio <<
+                            setw(13) << setprecision(1) << compressMB << setw(12) << compressMB / threads <<
+                            setw(15) << decompressMB << setw(12) << decompressMB / threads << endl;
+                }
+            }
+        }
+
+        //-------------------------------------------
+        // Recommend the best ratio which keeps up, with the fewest threads
+        //-------------------------------------------
+        cout << endl;
+        if (arrivalMB <= 0.) {
+            cout << "Give the rate data arrives at with -b for a recommended configuration" << endl;
+            return 0;
+        }
+
+        const Result *best = nullptr, *fastest = nullptr;
+        for (auto & r : results) {
+            if (fastest == nullptr || r.compressMB > fastest->compressMB) fastest = &r;
+            if (r.compressMB < 1.2 * arrivalMB) continue;
+            if (best == nullptr || r.ratio > best->ratio * 1.01 ||
+                (r.ratio > best->ratio / 1.01 && r.threads < best->threads)) {
+                best = &r;
+            }
+        }
+
+        if (best == nullptr) {
+            cout << "No setting keeps up with " << setprecision(1) << arrivalMB << " MB/s; the fastest, " <<
+                    compressionName(fastest->type) << " with " << fastest->threads << " threads, compresses " <<
+                    fastest->compressMB << " MB/s. Write to more files or streams in parallel." << endl;
+            return 0;
+        }
+
+        cout << "For " << setprecision(1) << arrivalMB << " MB/s: " << compressionName(best->type) <<
+                " with " << best->threads << " threads and records of " << best->recordSize / 1024 <<
+                "K, ratio " << setprecision(2) << best->ratio << ", writing " << setprecision(1) <<
+                arrivalMB / best->ratio << " MB/s, " << 100. * arrivalMB / best->compressMB <<
+                "% of compression capacity" << endl;
+        cout << "Reading back needs " << (uint32_t) ceil(arrivalMB / (best->decompressMB / best->threads)) <<
+                " cores to keep up" << endl << endl;
+
+        cout << "    EventWriter writer(fileName, \"\", \"\", 1, 0, " << best->recordSize << ", 0, order, \"\"," << endl;
+        cout << "                       false, false, nullptr, 0, 0, 1, 1, " << compressionEnum(best->type) <<
+                ", " << best->threads << ", 0, 0);" << endl;
+    }
+    catch (EvioException & e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ *
+ * Convert evio version 1-4 files into compressed evio version 6 files,
+ * reading, repacking, compressing and writing in parallel.
+ */
+
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+static void usage() {
+    cout << "Usage: evioConvert [options] -o <output> <file>" << endl;
+    cout << "       evioConvert [options] -d <dir> <file> [<file> ...]" << endl;
+    cout << "  -o <output>   file to write" << endl;
+    cout << "  -d <dir>      directory to write each converted file into, under its own name" << endl;
+    cout << "  -c <type>     compression: none, lz4, lz4best, gzip, zstd (default lz4)" << endl;
+    cout << "  -t <threads>  compression threads (default 1 per core)" << endl;
+    cout << "  -r <bytes>    max bytes of events in a record" << endl;
+    cout << "  -m            memory map input files" << endl;
+    cout << "  -f            overwrite existing output files" << endl;
+}
+
+
+static bool toCompression(string const & name, evio::Compressor::CompressionType & type) {
+    using evio::Compressor;
+    if      (name == "none")    type = Compressor::UNCOMPRESSED;
+    else if (name == "lz4")     type = Compressor::LZ4;
+    else if (name == "lz4best") type = Compressor::LZ4_BEST;
+    else if (name == "gzip")    type = Compressor::GZIP;
+    else if (name == "zstd")    type = Compressor::ZSTD;
+    else return false;
+    return true;
+}
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    string outName, outDir;
+    vector<string> inNames;
+    EvioConverter::Options options;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "-o" && i + 1 < argc) {
+            outName = argv[++i];
+        }
+        else if (arg == "-d" && i + 1 < argc) {
+            outDir = argv[++i];
+        }
+        else if (arg == "-c" && i + 1 < argc) {
+            if (!toCompression(argv[++i], options.compression)) {
+                usage();
+                return 1;
+            }
+        }
+        else if (arg == "-t" && i + 1 < argc) {
+            options.compressionThreads = stoul(argv[++i]);
+        }
+        else if (arg == "-r" && i + 1 < argc) {
+            options.maxRecordSize = stoul(argv[++i]);
+        }
+        else if (arg == "-m") {
+            options.memoryMapped = true;
+        }
+        else if (arg == "-f") {
+            options.overwrite = true;
+        }
+        else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        else {
+            inNames.push_back(arg);
+        }
+    }
+
+    if (inNames.empty() || (outName.empty() == outDir.empty()) ||
+        (!outName.empty() && inNames.size() > 1)) {
+        usage();
+        return 1;
+    }
+
+    try {
+        for (auto & inName : inNames) {
+            string out = outName;
+            if (out.empty()) {
+                out = outDir + "/" + fs::path(inName).filename().string();
+            }
+
+            auto stats = EvioConverter::convert(inName, out, options);
+
+            cout << inName << " -> " << out << ": " << stats.events << " events, " <<
+                    stats.bytesRead << " -> " << stats.bytesWritten << " bytes (" <<
+                    fixed << setprecision(1) <<
+                    (stats.bytesRead > 0 ? 100.*stats.bytesWritten/stats.bytesRead : 0.) << "%), " <<
+                    setprecision(2) << stats.seconds << " s" << endl;
+        }
+    }
+    catch (EvioException & e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ *
+ * Generate a C++ header from an xml dictionary file with one struct for each
+ * dictionary entry. Each is based on the evio::EvioSchema template which holds
+ * the entry's tag, num, and data type as compile time constants, so decoders can
+ * match structures and get typed pointers to their data without looking up names.
+ */
+
+
+#include <string>
+#include <vector>
+#include <set>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+static void usage() {
+    cout << "Usage: evioDictGen [-n <namespace>] [-o <output file>] <xml dictionary file>" << endl;
+    cout << "         -n  namespace of generated structs (default evioschema)" << endl;
+    cout << "         -o  file to write header to (default standard out)" << endl;
+}
+
+
+/**
+ * Turn a dictionary name into a C++ identifier.
+ * @param name dictionary name.
+ * @return identifier.
+ */
+static string identifier(string const & name) {
+    string id;
+    for (char c : name) {
+        id += isalnum((unsigned char)c) ? c : '_';
+    }
+    if (id.empty() || isdigit((unsigned char)id[0])) {
+        id = "n" + id;
+    }
+    return id;
+}
+
+
+/**
+ * Turn a string into a C++ string literal.
+ * @param s string.
+ * @return quoted, escaped string.
+ */
+static string literal(string const & s) {
+    stringstream ss;
+    ss << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') ss << '\\' << c;
+        else if (c == '\n') ss << "\\n";
+        else if (c == '\t') ss << "\\t";
+        else if ((unsigned char)c < 0x20) ss << ' ';
+        else ss << c;
+    }
+    ss << '"';
+    return ss.str();
+}
+
+
+/**
+ * Make a string safe to put on one line of a comment.
+ * @param s string.
+ * @return string without line breaks or comment ends.
+ */
+static string comment(string const & s) {
+    string c;
+    for (char ch : s) {
+        if (ch == '/' && !c.empty() && c.back() == '*') c += ' ';
+        c += (ch == '\n' || ch == '\r' || ch == '\t') ? ' ' : ch;
+    }
+    return c;
+}
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    string nameSpace = "evioschema";
+    string outFile;
+    string dictFile;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "-n" && i + 1 < argc) {
+            nameSpace = argv[++i];
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            outFile = argv[++i];
+        }
+        else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        else if (dictFile.empty() && arg[0] != '-') {
+            dictFile = arg;
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (dictFile.empty()) {
+        usage();
+        return 1;
+    }
+
+    // Entries sorted by tag and num so output doesn't change from run to run
+    vector<pair<string, shared_ptr<EvioDictionaryEntry>>> entries;
+    try {
+        EvioXMLDictionary dict(dictFile);
+        for (auto & e : dict.getMap()) {
+            entries.emplace_back(e.first, e.second);
+        }
+    }
+    catch (EvioException & e) {
+        cerr << dictFile << ": " << e.what() << endl;
+        return 1;
+    }
+
+    sort(entries.begin(), entries.end(),
+         [](pair<string, shared_ptr<EvioDictionaryEntry>> const & a,
+            pair<string, shared_ptr<EvioDictionaryEntry>> const & b) {
+             auto & x = *a.second, & y = *b.second;
+             if (x.getTag() != y.getTag()) return x.getTag() < y.getTag();
+             if (x.getNum() != y.getNum()) return x.getNum() < y.getNum();
+             return a.first < b.first;
+         });
+
+    string guard = identifier(nameSpace) + "_EVIOSCHEMA_H";
+    transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+
+    stringstream out;
+    out << "// Generated by evioDictGen from " << dictFile << ", do not edit." << endl << endl;
+    out << "#ifndef " << guard << endl;
+    out << "#define " << guard << endl << endl << endl;
+    out << "#include \"EvioSchema.h\"" << endl << endl << endl;
+    out << "namespace " << nameSpace << " {" << endl << endl;
+
+    set<string> used;
+    for (auto & e : entries) {
+        auto & entry = *e.second;
+
+        string id = identifier(e.first);
+        string base = id;
+        for (int n = 2; used.count(id) > 0; n++) {
+            id = base + "_" + to_string(n);
+        }
+        used.insert(id);
+
+        bool isRange = entry.getEntryType() == EvioDictionaryEntry::TAG_RANGE;
+
+        out << "    /** " << comment(e.first);
+        if (!entry.getDescription().empty()) out << ": " << comment(entry.getDescription());
+        out << " */" << endl;
+        out << "    struct " << id << " : public evio::EvioSchema<" << entry.getTag() << ", " <<
+               (int)(entry.isNumValid() ? entry.getNum() : 0) << ", 0x" << hex << entry.getType().getValue() <<
+               dec << ", " << (entry.isNumValid() ? "true" : "false") << ", " <<
+               (isRange ? entry.getTagEnd() : 0) << "> {" << endl;
+        out << "        static constexpr const char * name   = " << literal(e.first) << ";" << endl;
+        out << "        static constexpr const char * format = " << literal(entry.getFormat()) << ";" << endl;
+        out << "    };" << endl << endl;
+    }
+
+    out << "}" << endl << endl << endl;
+    out << "#endif // " << guard << endl;
+
+    if (outFile.empty()) {
+        cout << out.str();
+    }
+    else {
+        ofstream file(outFile);
+        file << out.str();
+        if (!file) {
+            cerr << outFile << ": cannot write" << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ *
+ * Build the sidecar index file of one or more existing, possibly damaged, evio version 6 files
+ * so that readers can find their records and events without scanning them.
+ */
+
+
+#include <string>
+#include <iostream>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+static void usage() {
+    cout << "Usage: evioIndex [-t] [-p] [-r] <file> [<file> ...]" << endl;
+    cout << "         -t  also index the tag and num of each event" << endl;
+    cout << "         -r  recover records of a damaged file, for example one without a trailer" << endl;
+    cout << "         -p  print the index of each file" << endl;
+    cout << "       Index of <file> is written to <file>" << evio::EventIndexFile::sidecarName("") << endl;
+}
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    bool withTags = false;
+    bool print = false;
+    bool recover = false;
+    int fileCount = 0;
+    int errors = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "-t") {
+            withTags = true;
+        }
+        else if (arg == "-p") {
+            print = true;
+        }
+        else if (arg == "-r") {
+            recover = true;
+        }
+        else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        else {
+            fileCount++;
+            try {
+                auto index = recover ? EventIndexFile::recover(arg, withTags) :
+                                       EventIndexFile::build(arg, withTags);
+                string idxName = EventIndexFile::sidecarName(arg);
+                index->write(idxName);
+                cout << "Wrote " << idxName << ": " << index->getRecordCount() << " records, " <<
+                        index->getEventCount() << " events" << endl;
+                if (print) {
+                    cout << index->toString();
+                }
+            }
+            catch (EvioException & e) {
+                cout << arg << ": " << e.what() << endl;
+                errors++;
+            }
+        }
+    }
+
+    if (fileCount == 0) {
+        usage();
+        return 1;
+    }
+
+    return errors > 0 ? 1 : 0;
+}
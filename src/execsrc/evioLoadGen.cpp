@@ -0,0 +1,568 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ *
+ * DAQ-like load generator used to qualify hardware and evio releases.
+ * It synthesizes events of a chosen size distribution, bank structure and
+ * compressibility, and has one or more producer threads write them through an
+ * EventWriter or WriterMT into a file or buffer, or through a SocketWriter to
+ * a socket, for a set time and at an optional target rate. Once every interval,
+ * and for the whole run, it reports throughput, the p50/p99/p999 latency of
+ * publishing an event, and how full the writer's ring of records is, which
+ * shows backpressure from compression or writing.
+ */
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+static void usage() {
+    cout << "Usage: evioLoadGen [options] (-o <file> | -b <MB> | -s <host:port>)" << endl;
+    cout << "  -o <file>           write to file" << endl;
+    cout << "  -b <MB>             write into a pair of recycled buffers of this size" << endl;
+    cout << "  -s <host:port>      send to socket, see SocketWriter" << endl;
+    cout << "  -w <writer>         file writer: event (EventWriter) or mt (WriterMT) (default event)" << endl;
+    cout << "  -p <producers>      producer threads (default 1)" << endl;
+    cout << "  -order <order>      WriterMT producer order: arrival or producer (default producer)" << endl;
+    cout << "  -size <dist>        event bytes: fixed:N, uniform:MIN:MAX or lognormal:MEDIAN:SIGMA" << endl;
+    cout << "                      (default fixed:16384)" << endl;
+    cout << "  -banks <n>          child banks of each event (default 4)" << endl;
+    cout << "  -x <fraction>       fraction of data words which compress well, 0 to 1 (default 0.5)" << endl;
+    cout << "  -c <type>           compression: none, lz4, lz4best, gzip, zstd (default none)" << endl;
+    cout << "  -t <threads>        compression threads (default 1)" << endl;
+    cout << "  -ring <size>        records in writer's ring (default 16)" << endl;
+    cout << "  -split <bytes>      split EventWriter file at this many bytes (default 0, none)" << endl;
+    cout << "  -rate <MB/s>        target rate of all producers, 0 for as fast as possible (default 0)" << endl;
+    cout << "  -d <seconds>        duration (default 10)" << endl;
+    cout << "  -i <seconds>        report interval (default 1)" << endl;
+    cout << "  -pool <events>      distinct events generated ahead of time (default 1024)" << endl;
+    cout << "  -seed <n>           random seed (default 1)" << endl;
+    cout << "  -f                  overwrite existing file" << endl;
+    cout << endl;
+    cout << "  Latency is the time taken by each call publishing an event. With a target rate it's" << endl;
+    cout << "  measured from when the event was due, so that time spent behind is not hidden." << endl;
+}
+
+
+static bool toCompression(string const & name, evio::Compressor::CompressionType & type) {
+    using evio::Compressor;
+    if      (name == "none")    type = Compressor::UNCOMPRESSED;
+    else if (name == "lz4")     type = Compressor::LZ4;
+    else if (name == "lz4best") type = Compressor::LZ4_BEST;
+    else if (name == "gzip")    type = Compressor::GZIP;
+    else if (name == "zstd")    type = Compressor::ZSTD;
+    else return false;
+    return true;
+}
+
+
+/** Distribution of event sizes. */
+struct SizeDistribution {
+    enum Type {FIXED, UNIFORM, LOGNORMAL};
+    Type type = FIXED;
+    double a = 16384.;
+    double b = 0.;
+
+    /**
+     * Parse from "fixed:N", "uniform:MIN:MAX" or "lognormal:MEDIAN:SIGMA".
+     * @return false if badly formatted.
+     */
+    bool parse(string const & s) {
+        auto colon1 = s.find(':');
+        if (colon1 == string::npos) return false;
+        string name = s.substr(0, colon1);
+        auto colon2 = s.find(':', colon1 + 1);
+
+        try {
+            a = stod(s.substr(colon1 + 1, colon2 - colon1 - 1));
+            if (colon2 != string::npos) b = stod(s.substr(colon2 + 1));
+        }
+        catch (std::exception & e) {
+            return false;
+        }
+
+        if      (name == "fixed"     && colon2 == string::npos) type = FIXED;
+        else if (name == "uniform"   && colon2 != string::npos && b >= a) type = UNIFORM;
+        else if (name == "lognormal" && colon2 != string::npos && b >= 0.) type = LOGNORMAL;
+        else return false;
+        return a > 0.;
+    }
+
+    /** @return next size in bytes. */
+    double next(mt19937_64 & rng) const {
+        switch (type) {
+            case UNIFORM:
+                return uniform_real_distribution<double>(a, b)(rng);
+            case LOGNORMAL:
+                return lognormal_distribution<double>(log(a), b)(rng);
+            default:
+                return a;
+        }
+    }
+};
+
+
+/**
+ * Histogram of latencies in nanoseconds with 8 bins per power of 2, so each value
+ * is known to within 12.5%. Only one thread adds to it, while another may read it.
+ */
+class LatencyHistogram {
+
+public:
+
+    static const uint32_t SUB_BITS = 3;
+    static const uint32_t SUB_BINS = 1U << SUB_BITS;
+    static const uint32_t BINS = (64 - SUB_BITS + 1) * SUB_BINS;
+
+private:
+
+    std::atomic<uint64_t> counts[BINS] {};
+
+    static uint32_t binOf(uint64_t nanos) {
+        if (nanos < SUB_BINS) return (uint32_t) nanos;
+        uint32_t msb = 63 - __builtin_clzll(nanos);
+        uint32_t sub = (uint32_t) (nanos >> (msb - SUB_BITS)) & (SUB_BINS - 1);
+        return (msb - SUB_BITS + 1) * SUB_BINS + sub;
+    }
+
+public:
+
+    /** @return smallest value falling into a bin. */
+    static uint64_t lowestOf(uint32_t bin) {
+        if (bin < SUB_BINS) return bin;
+        uint32_t msb = bin / SUB_BINS + SUB_BITS - 1;
+        return (uint64_t) (SUB_BINS + bin % SUB_BINS) << (msb - SUB_BITS);
+    }
+
+    /** Add a value. Called by the owning thread only. */
+    void add(uint64_t nanos) {
+        auto & c = counts[binOf(nanos)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /** @param bin index of bin. @return number of values in bin. */
+    uint64_t count(uint32_t bin) const {return counts[bin].load(std::memory_order_relaxed);}
+};
+
+
+/** Counts, summed over producers, of bin of latency histogram, plus the totals. */
+struct LatencySnapshot {
+    vector<uint64_t> counts = vector<uint64_t>(LatencyHistogram::BINS);
+    uint64_t events = 0;
+
+    /** @return this minus an earlier snapshot. */
+    LatencySnapshot since(LatencySnapshot const & earlier) const {
+        LatencySnapshot diff;
+        for (uint32_t i = 0; i < LatencyHistogram::BINS; i++) {
+            diff.counts[i] = counts[i] - earlier.counts[i];
+        }
+        diff.events = events - earlier.events;
+        return diff;
+    }
+
+    /** @param fraction 0 to 1. @return latency in microseconds at this quantile. */
+    double quantile(double fraction) const {
+        if (events == 0) return 0.;
+        auto target = (uint64_t) ceil(fraction * (double) events);
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < LatencyHistogram::BINS; i++) {
+            sum += counts[i];
+            if (sum >= target && sum > 0) {
+                return (double) LatencyHistogram::lowestOf(i) / 1000.;
+            }
+        }
+        return 0.;
+    }
+
+    /** @return largest latency's bin in microseconds. */
+    double max() const {
+        for (uint32_t i = LatencyHistogram::BINS; i > 0; i--) {
+            if (counts[i - 1] > 0) return (double) LatencyHistogram::lowestOf(i - 1) / 1000.;
+        }
+        return 0.;
+    }
+};
+
+
+/** Per producer counts. Each is kept in its own cache line. */
+struct alignas(64) ProducerStats {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> events {0};
+    std::atomic<uint64_t> bytes {0};
+};
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    string outFile, socketAddress, writerName = "event", orderName = "producer";
+    uint32_t bufferMB = 0, producers = 1, banks = 4, compressionThreads = 1, ringSize = 16;
+    uint32_t poolSize = 1024;
+    uint64_t split = 0, seed = 1;
+    double compressible = 0.5, rateMB = 0., duration = 10., interval = 1.;
+    bool overwrite = false;
+    SizeDistribution sizes;
+    Compressor::CompressionType compression = Compressor::UNCOMPRESSED;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg(argv[i]);
+            bool more = i + 1 < argc;
+            if      (arg == "-o" && more)     outFile = argv[++i];
+            else if (arg == "-b" && more)     bufferMB = stoul(argv[++i]);
+            else if (arg == "-s" && more)     socketAddress = argv[++i];
+            else if (arg == "-w" && more)     writerName = argv[++i];
+            else if (arg == "-p" && more)     producers = stoul(argv[++i]);
+            else if (arg == "-order" && more) orderName = argv[++i];
+            else if (arg == "-banks" && more) banks = stoul(argv[++i]);
+            else if (arg == "-x" && more)     compressible = stod(argv[++i]);
+            else if (arg == "-t" && more)     compressionThreads = stoul(argv[++i]);
+            else if (arg == "-ring" && more)  ringSize = stoul(argv[++i]);
+            else if (arg == "-split" && more) split = stoull(argv[++i]);
+            else if (arg == "-rate" && more)  rateMB = stod(argv[++i]);
+            else if (arg == "-d" && more)     duration = stod(argv[++i]);
+            else if (arg == "-i" && more)     interval = stod(argv[++i]);
+            else if (arg == "-pool" && more)  poolSize = stoul(argv[++i]);
+            else if (arg == "-seed" && more)  seed = stoull(argv[++i]);
+            else if (arg == "-f")             overwrite = true;
+            else if (arg == "-size" && more) {
+                if (!sizes.parse(argv[++i])) {
+                    usage();
+                    return 1;
+                }
+            }
+            else if (arg == "-c" && more) {
+                if (!toCompression(argv[++i], compression)) {
+                    usage();
+                    return 1;
+                }
+            }
+            else if (arg == "-h" || arg == "--help") {
+                usage();
+                return 0;
+            }
+            else {
+                usage();
+                return 1;
+            }
+        }
+    }
+    catch (std::exception & e) {
+        usage();
+        return 1;
+    }
+
+    int outputs = !outFile.empty() + (bufferMB > 0) + !socketAddress.empty();
+    bool useMT = (writerName == "mt");
+    if (outputs != 1 || producers < 1 || poolSize < 1 || interval <= 0. || duration <= 0. ||
+        compressible < 0. || compressible > 1. || (writerName != "event" && !useMT) ||
+        (useMT && outFile.empty()) || (orderName != "arrival" && orderName != "producer")) {
+        usage();
+        return 1;
+    }
+
+    try {
+        ByteOrder order = ByteOrder::ENDIAN_LOCAL;
+
+        //-------------------------------------------
+        // Generate events ahead of time, each a bank of banks of 32 bit ints,
+        // or a bank of ints if there are no child banks. A fraction of each bank's
+        // words repeat a short pattern and compress well, the rest are random and don't.
+        //-------------------------------------------
+        mt19937_64 rng(seed);
+        uniform_real_distribution<double> coin(0., 1.);
+        uint32_t leaves = banks > 0 ? banks : 1;
+        uint32_t minBytes = 8 + banks * 8 + leaves * 4;
+        vector<uint8_t> pool;
+        vector<uint32_t> offsets, lengths;
+        vector<uint32_t> words;
+
+        for (uint32_t n = 0; n < poolSize; n++) {
+            double size = sizes.next(rng);
+            uint32_t bytes = size < minBytes ? minBytes : (uint32_t) min(size, 64. * 1024 * 1024);
+            uint32_t dataWords = (bytes - 8 - banks * 8) / 4;
+
+            CompactEventBuilder builder(bytes + 64, order);
+            if (banks > 0) {
+                builder.openBank(1, DataType::BANK, (uint8_t) n);
+            }
+            for (uint32_t b = 0; b < leaves; b++) {
+                uint32_t count = dataWords / leaves + (b < dataWords % leaves ? 1 : 0);
+                words.resize(count);
+                for (uint32_t w = 0; w < count; w++) {
+                    words[w] = coin(rng) < compressible ? (0x100 + (w & 0xf)) : (uint32_t) rng();
+                }
+                builder.openBank((uint16_t) (banks > 0 ? b + 2 : 1), DataType::UINT32, (uint8_t) b);
+                builder.addIntData(words.data(), count);
+                builder.closeStructure();
+            }
+            builder.closeAll();
+
+            auto buf = builder.getBuffer();
+            offsets.push_back((uint32_t) pool.size());
+            lengths.push_back((uint32_t) buf->remaining());
+            pool.insert(pool.end(), buf->array() + buf->arrayOffset() + buf->position(),
+                        buf->array() + buf->arrayOffset() + buf->position() + buf->remaining());
+        }
+
+        uint64_t poolBytes = pool.size();
+        cout << "Generated " << poolSize << " events of average " << poolBytes / poolSize <<
+                " bytes, " << banks << " banks each, " << fixed << setprecision(2) <<
+                compressible << " compressible" << endl;
+
+        //-------------------------------------------
+        // Writer
+        //-------------------------------------------
+        unique_ptr<EventWriter> eventWriter;
+        unique_ptr<WriterMT> writerMT;
+        unique_ptr<SocketWriter> socketWriter;
+        vector<shared_ptr<WriterMT::Producer>> mtProducers;
+        mutex writerMutex;
+        string dictionary;
+
+        if (!socketAddress.empty()) {
+            auto colon = socketAddress.rfind(':');
+            if (colon == string::npos) {
+                usage();
+                return 1;
+            }
+            socketWriter.reset(new SocketWriter(socketAddress.substr(0, colon),
+                                                (uint16_t) stoul(socketAddress.substr(colon + 1)),
+                                                order, 0, 0, compression, SocketWriter::BATCHED));
+        }
+        else if (bufferMB > 0) {
+            // Hand each full buffer straight back to be written into again
+            auto buf = make_shared<ByteBuffer>((size_t) bufferMB * 1024 * 1024);
+            buf->order(order);
+            eventWriter.reset(new EventWriter(buf, 0, 0, dictionary, 1, nullptr, compression));
+            auto spare = make_shared<ByteBuffer>(buf->capacity());
+            eventWriter->addFreeBuffer(spare);
+            EventWriter *w = eventWriter.get();
+            eventWriter->setBufferPool([w](shared_ptr<ByteBuffer> & full) {w->addFreeBuffer(full);});
+        }
+        else if (useMT) {
+            WriterMT::ProducerOrder producerOrder = WriterMT::SINGLE_PRODUCER;
+            if (producers > 1) {
+                producerOrder = orderName == "arrival" ? WriterMT::ARRIVAL_ORDER : WriterMT::PER_PRODUCER_ORDER;
+            }
+            writerMT.reset(new WriterMT(HeaderType::EVIO_FILE, order, 0, 0, dictionary, nullptr, 0,
+                                        compression, compressionThreads, true, ringSize, producerOrder));
+            if (overwrite) {
+                fs::remove(outFile);
+            }
+            else if (fs::exists(outFile)) {
+                throw EvioException("File exists but user requested no over-writing of " + outFile);
+            }
+            writerMT->open(outFile);
+            if (producerOrder == WriterMT::PER_PRODUCER_ORDER) {
+                for (uint32_t p = 0; p < producers; p++) {
+                    mtProducers.push_back(writerMT->createProducer());
+                }
+            }
+        }
+        else {
+            eventWriter.reset(new EventWriter(outFile, "", "", 1, split, 0, 0, order, dictionary,
+                                              overwrite, false, nullptr, 0, 0, 1, 1, compression,
+                                              compressionThreads, ringSize, 0));
+        }
+
+        auto metrics = [&]() {
+            if (writerMT != nullptr) return writerMT->getMetrics();
+            if (eventWriter != nullptr) {
+                lock_guard<mutex> lock(writerMutex);
+                return eventWriter->getMetrics();
+            }
+            return WriterMetrics();
+        };
+
+        //-------------------------------------------
+        // Producers
+        //-------------------------------------------
+        vector<ProducerStats> stats(producers);
+        atomic_bool stop {false};
+        vector<future<void>> threads;
+        double bytesPerNanoPerProducer = rateMB * 1e6 / 1e9 / producers;
+
+        auto start = chrono::steady_clock::now();
+
+        for (uint32_t p = 0; p < producers; p++) {
+            threads.push_back(async(launch::async, [&, p]() {
+                auto & st = stats[p];
+                uint8_t *data = pool.data();
+                uint64_t sent = 0;
+                uint32_t n = (uint32_t) ((uint64_t) p * poolSize / producers);
+
+                while (!stop.load(std::memory_order_relaxed)) {
+                    uint32_t off = offsets[n], len = lengths[n];
+                    auto begin = chrono::steady_clock::now();
+
+                    if (rateMB > 0.) {
+                        // Event is due once those before it were sent at the target rate.
+                        // If behind, latency counts from when it was due.
+                        auto due = start + chrono::nanoseconds((int64_t) (sent / bytesPerNanoPerProducer));
+                        if (due > begin) {
+                            this_thread::sleep_until(due);
+                            begin = chrono::steady_clock::now();
+                        }
+                        else {
+                            begin = due;
+                        }
+                    }
+
+                    if (!mtProducers.empty()) {
+                        mtProducers[p]->addEvent(data, off, len);
+                    }
+                    else if (writerMT != nullptr) {
+                        writerMT->addEvent(data, off, len);
+                    }
+                    else {
+                        lock_guard<mutex> lock(writerMutex);
+                        if (socketWriter != nullptr) {
+                            socketWriter->addEvent(data + off, len);
+                        }
+                        else {
+                            eventWriter->writeEvent(ByteBufferView(data + off, len, order));
+                        }
+                    }
+
+                    auto end = chrono::steady_clock::now();
+                    st.latency.add((uint64_t) chrono::duration_cast<chrono::nanoseconds>(end - begin).count());
+                    st.events.store(st.events.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    st.bytes.store(st.bytes.load(std::memory_order_relaxed) + len, std::memory_order_relaxed);
+                    sent += len;
+                    if (++n == poolSize) n = 0;
+                }
+
+                if (!mtProducers.empty()) {
+                    mtProducers[p]->flush();
+                }
+            }));
+        }
+
+        //-------------------------------------------
+        // Report once an interval
+        //-------------------------------------------
+        auto snapshot = [&]() {
+            LatencySnapshot snap;
+            for (auto & st : stats) {
+                for (uint32_t i = 0; i < LatencyHistogram::BINS; i++) {
+                    snap.counts[i] += st.latency.count(i);
+                }
+            }
+            for (uint32_t i = 0; i < LatencyHistogram::BINS; i++) {
+                snap.events += snap.counts[i];
+            }
+            return snap;
+        };
+
+        auto totalBytes = [&]() {
+            uint64_t sum = 0;
+            for (auto & st : stats) sum += st.bytes.load(std::memory_order_relaxed);
+            return sum;
+        };
+
+        cout << endl << setw(8) << "time(s)" << setw(10) << "MB/s" << setw(10) << "events/s" <<
+                setw(10) << "p50(us)" << setw(10) << "p99(us)" << setw(11) << "p999(us)" <<
+                setw(9) << "ring" << setw(9) << "to comp" << setw(9) << "to write" <<
+                setw(13) << "prod wait%" << endl;
+
+        LatencySnapshot lastSnap = snapshot();
+        uint64_t lastBytes = 0, lastWait = 0;
+        auto lastTime = start;
+        auto stopTime = start + chrono::nanoseconds((int64_t) (duration * 1e9));
+
+        while (true) {
+            auto next = lastTime + chrono::nanoseconds((int64_t) (interval * 1e9));
+            if (next > stopTime) next = stopTime;
+            this_thread::sleep_until(next);
+
+            auto now = chrono::steady_clock::now();
+            auto snap = snapshot();
+            auto diff = snap.since(lastSnap);
+            uint64_t bytes = totalBytes();
+            auto m = metrics();
+            double secs = chrono::duration<double>(now - lastTime).count();
+
+            cout << setw(8) << setprecision(1) << chrono::duration<double>(now - start).count() <<
+                    setw(10) << setprecision(1) << (bytes - lastBytes) / secs / 1e6 <<
+                    setw(10) << setprecision(0) << diff.events / secs <<
+                    setw(10) << setprecision(2) << diff.quantile(0.5) <<
+                    setw(10) << diff.quantile(0.99) <<
+                    setw(11) << diff.quantile(0.999) <<
+                    setw(9) << (to_string(m.ringOccupancy) + "/" + to_string(m.ringSize)) <<
+                    setw(9) << m.waitingToCompress << setw(9) << m.waitingToWrite <<
+                    setw(13) << setprecision(1) <<
+                    100. * (m.producerWaitTime - lastWait) / 1e6 / secs / producers << endl;
+
+            lastSnap = snap;
+            lastBytes = bytes;
+            lastWait = m.producerWaitTime;
+            lastTime = now;
+            if (now >= stopTime) break;
+        }
+
+        stop = true;
+        for (auto & t : threads) t.get();
+        auto published = chrono::steady_clock::now();
+
+        WriterMetrics finalMetrics = metrics();
+        if (socketWriter != nullptr) socketWriter->close();
+        if (writerMT != nullptr)     writerMT->close();
+        if (eventWriter != nullptr)  eventWriter->close();
+        auto closed = chrono::steady_clock::now();
+
+        //-------------------------------------------
+        // Whole run
+        //-------------------------------------------
+        auto all = snapshot();
+        uint64_t bytes = totalBytes();
+        double pubSecs = chrono::duration<double>(published - start).count();
+        double allSecs = chrono::duration<double>(closed - start).count();
+
+        cout << endl << "Events " << all.events << ", bytes " << bytes << " in " <<
+                setprecision(2) << pubSecs << " s" << endl;
+        cout << "Published " << setprecision(1) << bytes / pubSecs / 1e6 << " MB/s, " <<
+                setprecision(0) << all.events / pubSecs << " events/s; including close " <<
+                setprecision(1) << bytes / allSecs / 1e6 << " MB/s" << endl;
+        cout << "Latency (us): p50 " << setprecision(2) << all.quantile(0.5) << ", p99 " <<
+                all.quantile(0.99) << ", p999 " << all.quantile(0.999) << ", max " << all.max() << endl;
+        if (socketWriter != nullptr) {
+            cout << "Sent " << socketWriter->getBytesSent() << " bytes in " <<
+                    socketWriter->getRecordsSent() << " records" << endl;
+        }
+        else {
+            cout << endl << finalMetrics.toString() << endl;
+        }
+        if (eventWriter != nullptr && bufferMB > 0) {
+            cout << "Buffers filled " << eventWriter->getBuffersFilled() << endl;
+        }
+    }
+    catch (EvioException & e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ *
+ * Merge evio version 6 files into one, copying whole records without
+ * decompressing or parsing them whenever their compression matches
+ * that of the output.
+ */
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+static void usage() {
+    cout << "Usage: evioMerge -o <output> <file> [<file> ...]" << endl;
+    cout << "       Byte order, compression, dictionary and first event are taken from the first <file>" << endl;
+}
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    string outName;
+    vector<string> inNames;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "-o" && i + 1 < argc) {
+            outName = argv[++i];
+        }
+        else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        else {
+            inNames.push_back(arg);
+        }
+    }
+
+    if (outName.empty() || inNames.empty()) {
+        usage();
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<Writer> writer;
+        Compressor::CompressionType compression = Compressor::UNCOMPRESSED;
+        ByteOrder order = ByteOrder::ENDIAN_LOCAL;
+        std::vector<uint8_t> storage;
+        size_t copied = 0, rewritten = 0;
+
+        for (auto & inName : inNames) {
+            Reader reader(inName);
+
+            if (writer == nullptr) {
+                order = reader.getByteOrder();
+                compression = reader.getFirstRecordHeader()->getCompressionType();
+
+                uint32_t firstLen = 0;
+                uint8_t *firstEvent = nullptr;
+                if (reader.hasFirstEvent()) {
+                    firstEvent = reader.getFirstEvent(&firstLen).get();
+                }
+
+                writer.reset(new Writer(HeaderType::EVIO_FILE, order, 0, 0, reader.getDictionary(),
+                                        firstEvent, firstLen, compression, true));
+                writer->open(outName);
+            }
+
+            auto & positions = reader.getRecordPositions();
+            uint32_t eventIndex = 0;
+
+            for (uint32_t i = 0; i < reader.getRecordCount(); i++) {
+                uint32_t count = positions[i].getCount();
+
+                ByteBufferView record = reader.getRawRecord(i, storage);
+                uint32_t word = record.getInt(RecordHeader::COMPRESSION_TYPE_OFFSET);
+
+                if (reader.getByteOrder() == order &&
+                    Compressor::toCompressionType((word >> 28) & 0xf) == compression) {
+                    writer->writeRecord(record);
+                    copied++;
+                }
+                else {
+                    // Must be decompressed or swapped, so go event by event
+                    for (uint32_t j = 0; j < count; j++) {
+                        uint32_t len;
+                        auto event = reader.getEvent(eventIndex + j, &len);
+                        writer->addEvent(event.get(), len);
+                    }
+                    rewritten++;
+                }
+                eventIndex += count;
+            }
+        }
+
+        writer->close();
+        cout << "Wrote " << outName << ": " << copied << " records copied, " <<
+                rewritten << " records rewritten" << endl;
+    }
+    catch (EvioException & e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -51,7 +51,7 @@
  *      Fix bug in mutex handling.
  *      Allow mutexes to be turned off.
  *      Allow setting buffer size.
- * 
+ *
  * Routines:
  * ---------
  * 
@@ -61,10 +61,12 @@
  * int  evRead                 (int handle, uint32_t *buffer, uint32_t buflen)
  * int  evReadAlloc            (int handle, uint32_t **buffer, uint32_t *buflen)
  * int  evReadNoCopy           (int handle, const uint32_t **buffer, uint32_t *buflen)
+ * int  evReleaseEvent         (int handle, const uint32_t *event)
  * int  evReadRandom           (int handle, const uint32_t **pEvent, uint32_t *buflen, uint32_t eventNumber)
  * int  evWrite                (int handle, const uint32_t *buffer)
  * int  evIoctl                (int handle, char *request, void *argp)
  * int  evClose                (int handle)
+ * int  evSendFile             (char *fileName, int sockFd, uint64_t *bytesSent)
  * int  evFlush                (int handle)
  * int  evGetBufferLength      (int handle, uint32_t *length)
  * int  evGetRandomAccessTable (int handle, const uint32_t *** const table, uint32_t *len)
@@ -98,6 +100,13 @@
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zlib.h>
 #include "evio.h"
 
 
@@ -122,8 +131,11 @@
 /** Version 4&6's target block size in 32 bit words (16MB).
  * It is a soft limit since a single event larger than
  * this limit may need to be written. */
-//#define EV_BLOCKSIZE 4000000
-#define EV_BLOCKSIZE 150
+#define EV_BLOCKSIZE 4000000
+
+/** Initial size in bytes of a file written through a memory map if not splitting (64MB).
+ * The file doubles in size as needed and is cut to its actual size when closed. */
+#define EV_MMAP_WRITE_SIZE 67108864
 
 /** Minimum block size in 32 bit words allowed if size reset (4MB) */
 #define EV_BLOCKSIZE_MIN 1000000
@@ -482,7 +494,8 @@
  *    +-----------------------+----------+
  *
  *
- * Records may be compressed, but that is only handled in the Java and C++ libs.
+ * Records may be compressed. This lib can read LZ4 and gzip compressed records
+ * sequentially, but not in random access mode, and never writes them.
  * The record header is never compressed and so is always readable.
  * If events are in the evio format, pad_2 will be 0.
  *
@@ -633,7 +646,7 @@
 #define isLastBlockInt_V6(i)    ((i & EV_LASTBLOCK_MASK_V6) > 0 ? 1 : 0)
 
 /** Is the record data compressed (version 6, 10th header word)? */
-#define isCompressed(i) (((i >> 28) && 0xf) == 0 ? 0 : 1)
+#define isCompressed(i) (((i >> 28) & 0xf) == 0 ? 0 : 1)
 
 /** Get padding #1 from bitinfo word (v6). */
 #define getPad1(i) (((int)i >> 20) & 0x3)
@@ -696,10 +709,97 @@
     (a)[13]  = 0; \
 }
 
+/* States of a buffer in a ring of socket receive buffers */
+#define EV_RING_FREE     0   /**< may be filled. */
+#define EV_RING_FILLING  1   /**< being filled by the receiving thread. */
+#define EV_RING_FILLED   2   /**< holds a block not yet read. */
+#define EV_RING_READING  3   /**< holds the block events are being read from. */
+#define EV_RING_HELD     4   /**< holds a block already read, some of whose events are not yet released. */
+
+
+/** One buffer of a ring of socket receive buffers. */
+typedef struct evSockRingBuf {
+    uint32_t *buf;           /**< block header and data. */
+    uint32_t  bufSize;       /**< size of buf in 32 bit words. */
+    uint32_t *uncompBuf;     /**< uncompressed events of block if compressed (v6), else NULL. */
+    uint32_t  uncompBufSize; /**< size of uncompBuf in bytes. */
+    uint32_t  holds;         /**< number of events given out by evReadNoCopy and not yet released. */
+    int       state;         /**< EV_RING_FREE, _FILLING, _FILLED, _READING, or _HELD. */
+} evSockRingBuf;
+
+
+/**
+ * Ring of buffers into which another thread receives blocks from a socket,
+ * so reading from the network overlaps with the processing of events.
+ * Buffers are filled and read in order.
+ */
+typedef struct evSockRing {
+    pthread_t       thread;      /**< thread receiving blocks. */
+    int             started;     /**< 1 if thread was started, else 0. */
+    pthread_mutex_t mutex;       /**< protects buffer states and the items below. */
+    pthread_cond_t  cond;        /**< signaled when a buffer changes state or the thread stops. */
+    evSockRingBuf  *bufs;        /**< array of buffers. */
+    uint32_t        count;       /**< number of buffers. */
+    uint32_t        fillIndex;   /**< index of next buffer to fill. */
+    uint32_t        readIndex;   /**< index of next buffer to read. */
+    int             current;     /**< index of buffer being read, -1 if none. */
+    int             receiving;   /**< 1 while thread is reading from the socket, else 0. */
+    int             stop;        /**< 1 if thread is told to stop, else 0. */
+    int             status;      /**< S_SUCCESS while thread runs, else why it stopped (EOF or error). */
+    uint32_t       *ownBuf;      /**< handle's block buffer, given back when ring is stopped. */
+    uint32_t        ownBufSize;  /**< size of ownBuf in 32 bit words. */
+    uint32_t       *ownUncompBuf;     /**< handle's uncompressed data buffer, given back when ring is stopped. */
+    uint32_t        ownUncompBufSize; /**< size of ownUncompBuf in bytes. */
+} evSockRing;
+
+
+/** One record of a ring of records being compressed for writing (v6). */
+typedef struct evCompRecord {
+    uint32_t *in;          /**< record header, index and events as written. */
+    uint32_t *out;         /**< record header and compressed index and events. */
+    uint32_t  size;        /**< size of in and of out in bytes. */
+    uint32_t  inBytes;     /**< bytes of record in in. */
+    uint32_t *result;      /**< out if compressing made record smaller, else in. */
+    uint32_t  resultBytes; /**< bytes of record in result. */
+    int       done;        /**< 1 once compressed (or found not to get smaller), else 0. */
+} evCompRecord;
+
+
+/**
+ * Ring of records compressed by a pool of threads while the writer fills the following
+ * ones, in the spirit of the C++ lib's RecordSupply. Records are handed to the threads
+ * in the order written, compressed in any order, and copied into the internal buffer
+ * in the order written. Sequences only ever increase, a record's place in the ring
+ * being its sequence modulo the ring size.
+ */
+typedef struct evCompressor {
+    pthread_t      *threads;     /**< compressing threads. */
+    uint32_t        threadCount; /**< number of threads, 0 if the writer compresses each record itself. */
+    pthread_mutex_t mutex;       /**< protects done flags and the sequences and stop flag below. */
+    pthread_cond_t  cond;        /**< signaled when a record is handed out or done, or threads are stopped. */
+    evCompRecord   *records;     /**< ring of records. */
+    uint32_t        count;       /**< number of records in ring. */
+    uint64_t        putSeq;      /**< sequence of next record handed to the threads. */
+    uint64_t        takeSeq;     /**< sequence of next record a thread compresses. */
+    uint64_t        writeSeq;    /**< sequence of next record copied into the internal buffer. */
+    int             type;        /**< compression type, 1 = LZ4, 2 = LZ4 best, 3 = gzip. */
+    int             stop;        /**< 1 if threads are told to stop, else 0. */
+} evCompressor;
+
+
 /* Prototypes for static routines */
 static  int      fileExists(char *filename);
 static  int      evOpenImpl(char *srcDest, uint32_t bufLen, int sockFd, char *flags, int *handle);
 static  int      evGetNewBuffer(EVFILE *a);
+static  int      evPrepareNewBuffer(EVFILE *a);
+static  int      getRingBuffer(EVFILE *a);
+static  int      startSocketRing(EVFILE *a, uint32_t count);
+static  void     stopSocketRing(EVFILE *a);
+static  void     holdRingBuffer(EVFILE *a);
+static  int      startCompressor(EVFILE *a, int type, uint32_t threadCount);
+static  void     stopCompressor(EVFILE *a);
+static  int      compressLater(EVFILE *a);
+static  int      writeCompressedRecords(EVFILE *a, uint64_t untilSeq);
 static  char *   evTrim(char *s, int skip);
 static  int      tcpWrite(int fd, const void *vptr, int n);
 static  int      tcpRead(int fd, void *vptr, int n);
@@ -723,6 +823,7 @@ static  int      writeNewHeader(EVFILE *a,
                                 uint32_t eventCount, uint32_t blockNumber,
                                 int hasDictionary, int isLast);
 static int       evGetNewBufferFileV3(EVFILE *a);
+static int       uncompressRecordV6(EVFILE *a, const uint32_t *data);
 static int       evReadAllocImplFileV3(EVFILE *a, uint32_t **buffer, uint32_t *buflen);
 static int       evReadFileV3(EVFILE *a, uint32_t *buffer, uint32_t buflen);
 static void      resetBufferV6(EVFILE *a);
@@ -735,6 +836,10 @@ static void      handleUnlock(int handle);
 static void      handleUnlockUnconditional(int handle);
 static void      getHandleLock(void);
 static void      getHandleUnlock(void);
+static size_t    getHandleCount(void);
+static EVFILE   *getHandle(int handle);
+static void      setHandle(size_t index, EVFILE *a);
+static pthread_mutex_t *getHandleMutexOf(int handle);
 
 /* Append Mode */
 static  int      toAppendPosition(EVFILE *a);
@@ -743,14 +848,36 @@ static  int      toAppendPosition(EVFILE *a);
 static  int      memoryMapFile(EVFILE *a, const char *fileName);
 static  int      generatePointerTable(EVFILE *a);
 static  int      generatePointerTableV6(EVFILE *a);
+static  int      scanRecordV6(EVFILE *a, uint32_t record);
+static  int      mapFileForWriting(EVFILE *a, uint64_t bytesNeeded);
+static  int      unmapFileForWriting(EVFILE *a, uint64_t fileBytes);
+static  int      closeFileInBackground(EVFILE *a);
+static  int      waitForClosedFile(EVFILE *a);
+static  void     preCreateNextFile(EVFILE *a);
+static  int      usePreCreatedFile(EVFILE *a);
+static  void     removePreCreatedFile(EVFILE *a);
+static  int      findEventV6(EVFILE *a, uint32_t index);
 
 /* Array that holds all pointers to structures created with evOpen().
  * Space in the array is allocated as needed, beginning with 100
- * and adding 50% every time more are needed. */
+ * and adding 50% every time more are needed.
+ * It's only changed while holding getHandleMutex, but is read without
+ * any lock by getHandle(), so the pointer, its elements, and handleCount
+ * are accessed atomically. */
 EVFILE **handleList = NULL;
 /* The number of handles available for use. */
 static size_t handleCount = 0;
 
+/* When the handle table grows, the old arrays are kept here instead of being freed
+ * since a thread looking up a handle may still be reading them. They add up to less
+ * than the size of the current arrays, and are never freed. Each growth retires two
+ * arrays, so the table can grow 64 times, to over 10^13 handles. After that,
+ * expandHandles() fails with S_EVFILE_ALLOCFAIL, as does any evOpen() finding
+ * no free handle. */
+#define EV_RETIRED_HANDLE_ARRAYS 128
+static void *retiredHandleArrays[EV_RETIRED_HANDLE_ARRAYS];
+static int retiredHandleArrayCount = 0;
+
 /* Pthread mutex for serializing calls to get and free handles. */
 #ifdef __APPLE__
 static pthread_mutex_t getHandleMutex = PTHREAD_ERRORCHECK_MUTEX_INITIALIZER;
@@ -985,6 +1112,19 @@ static void structInit(EVFILE *a) {
     a->mmapFileSize = 0;
     a->mmapFile = NULL;
     a->pTable   = NULL;
+    a->recordTable      = NULL;
+    a->recordFirstEvent = NULL;
+    a->recordScanned    = NULL;
+    a->recordCount      = 0;
+
+    /* memory mapped writing */
+    a->mmapWrite = 0;
+    a->mmapFd    = -1;
+    a->closeJob  = NULL;
+    a->openJob   = NULL;
+
+    /* socket receive ring */
+    a->sockRing  = NULL;
 
     /* dictionary */
     a->hasAppendDictionary = 0;
@@ -1014,10 +1154,14 @@ static void structInit(EVFILE *a) {
 
     a->eventLengths = NULL;
     a->eventLengthsLen = 0;
+    a->uncompBuf = NULL;
+    a->uncompBufSize = 0;
     a->dataBuf = NULL;
     a->dataNext = NULL;
     a->dataLeft = EV_BLOCKSIZE;
     a->bytesToDataBuf = 0;
+    a->compressor = NULL;
+    a->bytesPending = 0;
 }
 
 
@@ -1027,6 +1171,11 @@ static void structInit(EVFILE *a) {
  */
 static void freeEVFILE(EVFILE *a) {
 
+    /* Gets back the handle's own buffers */
+    stopSocketRing(a);
+    /* Any records not yet written are dropped */
+    stopCompressor(a);
+
     if (a->buf != NULL && a->rw != EV_WRITEBUF) {
         if (a->pBuf != NULL) {
             free((void *)(a->pBuf));
@@ -1037,12 +1186,16 @@ static void freeEVFILE(EVFILE *a) {
     }
 
     if (a->pTable        != NULL) free((void *)(a->pTable));
+    if (a->recordTable   != NULL) free((void *)(a->recordTable));
+    if (a->recordFirstEvent != NULL) free((void *)(a->recordFirstEvent));
+    if (a->recordScanned != NULL) free((void *)(a->recordScanned));
     if (a->dictBuf       != NULL) free((void *)(a->dictBuf));
     if (a->dictionary    != NULL) free((void *)(a->dictionary));
     if (a->fileName      != NULL) free((void *)(a->fileName));
     if (a->baseFileName  != NULL) free((void *)(a->baseFileName));
     if (a->runType       != NULL) free((void *)(a->runType));
     if (a->eventLengths  != NULL) free((void *)(a->eventLengths));
+    if (a->uncompBuf     != NULL) free((void *)(a->uncompBuf));
     if (a->dataBuf       != NULL) free((void *)(a->dataBuf));
 
     free((void *)a);
@@ -1075,16 +1228,60 @@ static void getHandleUnlock(void) {
 }
 
 
+/**
+ * Routine to get the number of handles in the handle table without locking.
+ * A handle greater than this is invalid.
+ * @return number of handles.
+ */
+static size_t getHandleCount(void) {
+    return __atomic_load_n(&handleCount, __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * Routine to look up the file structure of a handle without locking.
+ * Since handleCount is published after the arrays it describes, a handle
+ * checked against getHandleCount() is always within the array seen here.
+ * Multiple threads each using their own handle never wait on each other.
+ *
+ * @param handle evio handle, from 1 to getHandleCount().
+ * @return pointer to file structure or NULL if handle not in use.
+ */
+static EVFILE *getHandle(int handle) {
+    EVFILE **list = __atomic_load_n(&handleList, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&list[handle-1], __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * Routine to store a file structure in a slot of the handle table.
+ * Must be called while holding the get handle lock.
+ * @param index  index into table (handle - 1).
+ * @param a      file structure or NULL.
+ */
+static void setHandle(size_t index, EVFILE *a) {
+    __atomic_store_n(&handleList[index], a, __ATOMIC_RELEASE);
+}
+
+
+/** Routine to get the mutex of a handle without locking. */
+static pthread_mutex_t *getHandleMutexOf(int handle) {
+    pthread_mutex_t **locks = __atomic_load_n(&handleLocks, __ATOMIC_ACQUIRE);
+    return locks[handle-1];
+}
+
+
 /** Routine to grab read lock used to prevent simultaneous
- *  calls to evClose and read/write routines. */
+ *  calls to evClose and read/write routines.
+ *  Handles opened with an "x" flag do no locking. */
 static void handleLock(int handle) {
-    EVFILE *a = handleList[handle-1];
+    EVFILE *a = getHandle(handle);
     pthread_mutex_t *lock;
     int status;
 
     if (a == NULL || !a->lockingOn) return;
 
-    lock = handleLocks[handle-1];
+    lock = getHandleMutexOf(handle);
     status = pthread_mutex_lock(lock);
     if (status != 0) {
         evio_err_abort(status, "Failed handle lock");
@@ -1095,13 +1292,13 @@ static void handleLock(int handle) {
 /** Routine to release read lock used to prevent simultaneous
  *  calls to evClose and read/write routines. */
 static void handleUnlock(int handle) {
-    EVFILE *a = handleList[handle-1];
+    EVFILE *a = getHandle(handle);
     pthread_mutex_t *lock;
     int status;
 
     if (a == NULL || !a->lockingOn) return;
 
-    lock = handleLocks[handle-1];
+    lock = getHandleMutexOf(handle);
     status = pthread_mutex_unlock(lock);
     if (status != 0) {
         evio_err_abort(status, "Failed handle unlock");
@@ -1112,7 +1309,7 @@ static void handleUnlock(int handle) {
  *  calls to evClose and read/write routines. Called only by evClose
  *  when handleList array member has already been cleared. */
 static void handleUnlockUnconditional(int handle) {
-    pthread_mutex_t *lock = handleLocks[handle-1];
+    pthread_mutex_t *lock = getHandleMutexOf(handle);
     int status = pthread_mutex_unlock(lock);
     if (status != 0) {
         evio_err_abort(status, "Failed handle unlock");
@@ -1122,7 +1319,9 @@ static void handleUnlockUnconditional(int handle) {
 
 /**
  * Routine to expand existing storage space for EVFILE structures
- * (one for each evOpen() call).
+ * (one for each evOpen() call). Must be called while holding the get handle lock.
+ * New arrays are filled in before being published, and the old ones are
+ * retired but not freed, so threads reading the table need no lock.
  * 
  * @return S_SUCCESS if success
  * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
@@ -1130,25 +1329,31 @@ static void handleUnlockUnconditional(int handle) {
 static int expandHandles() {
     /* If this is the first initialization, add 100 places for 100 evOpen()'s */
     if (handleCount < 1 || handleList == NULL) {
-        size_t i;
-        
-        handleCount = 100;
+        size_t i, count = 100;
+        EVFILE **newHandleList;
+        pthread_mutex_t **newHandleLocks;
 
-        handleList = (EVFILE **) calloc(handleCount, sizeof(EVFILE *));
-        if (handleList == NULL) {
+        newHandleList = (EVFILE **) calloc(count, sizeof(EVFILE *));
+        if (newHandleList == NULL) {
             return S_EVFILE_ALLOCFAIL;
         }
 
-        handleLocks = (pthread_mutex_t **) calloc(handleCount, sizeof(pthread_mutex_t *));
-        if (handleLocks == NULL) {
+        newHandleLocks = (pthread_mutex_t **) calloc(count, sizeof(pthread_mutex_t *));
+        if (newHandleLocks == NULL) {
+            free((void *)newHandleList);
             return S_EVFILE_ALLOCFAIL;
         }
         /* Initialize new array of mutexes */
-        for (i=0; i < handleCount; i++) {
+        for (i=0; i < count; i++) {
             pthread_mutex_t *plock = (pthread_mutex_t *) calloc(1, sizeof(pthread_mutex_t));
             pthread_mutex_init(plock, NULL);
-            handleLocks[i] = plock;
+            newHandleLocks[i] = plock;
         }
+
+        /* Publish arrays before the count which allows their use */
+        __atomic_store_n(&handleList,  newHandleList,  __ATOMIC_RELEASE);
+        __atomic_store_n(&handleLocks, newHandleLocks, __ATOMIC_RELEASE);
+        __atomic_store_n(&handleCount, count,          __ATOMIC_RELEASE);
     }
     /* We're expanding the exiting arrays */
     else {
@@ -1166,6 +1371,13 @@ static int expandHandles() {
 
         newHandleList = (EVFILE **) calloc(newCount, sizeof(EVFILE *));
         if (newHandleList == NULL) {
+            free((void *)newHandleLocks);
+            return S_EVFILE_ALLOCFAIL;
+        }
+
+        if (retiredHandleArrayCount > EV_RETIRED_HANDLE_ARRAYS - 2) {
+            free((void *)newHandleLocks);
+            free((void *)newHandleList);
             return S_EVFILE_ALLOCFAIL;
         }
 
@@ -1182,14 +1394,14 @@ static int expandHandles() {
             newHandleLocks[i] = plock;
         }
         
-        /* Free the unused arrays */
-        free((void *)handleLocks);
-        free((void *)handleList);
+        /* Other threads may still be reading the old arrays, so keep them */
+        retiredHandleArrays[retiredHandleArrayCount++] = (void *)handleLocks;
+        retiredHandleArrays[retiredHandleArrayCount++] = (void *)handleList;
 
-        /* Update variables */
-        handleCount = newCount;
-        handleList  = newHandleList;
-        handleLocks = newHandleLocks;
+        /* Publish arrays before the count which allows their use */
+        __atomic_store_n(&handleList,  newHandleList,  __ATOMIC_RELEASE);
+        __atomic_store_n(&handleLocks, newHandleLocks, __ATOMIC_RELEASE);
+        __atomic_store_n(&handleCount, newCount,       __ATOMIC_RELEASE);
     }
 
     return S_SUCCESS;
@@ -1968,7 +2180,11 @@ char *evGenerateFileName(EVFILE *a, int specifierCount, int runNumber,
  *                  "r" for reading, "a" for appending, "ra" for random
  *                  access reading of a file which means memory mapping it,
  *                  or "s" for splitting a file while writing.
- *                  The w, r, a, s, or ra, may be followed by an x which means
+ *                  "wm" and "sm" write or split a file through a memory map
+ *                  instead of with fwrite. Such a file is made larger than needed
+ *                  ahead of time (to the split size when splitting) and cut to size
+ *                  when closed. Not for stdout or pipes.
+ *                  The w, r, a, s, ra, wm, or sm may be followed by an x which means
  *                  do not do any mutex locking (not thread safe).
  * @param handle    pointer to int which gets filled with handle
  *
@@ -1987,11 +2203,15 @@ int evOpen(char *filename, char *flags, int *handle)
         strcasecmp(flags, "r")   != 0 &&
         strcasecmp(flags, "a")   != 0 &&
         strcasecmp(flags, "ra")  != 0 &&
+        strcasecmp(flags, "wm")  != 0 &&
+        strcasecmp(flags, "sm")  != 0 &&
         strcasecmp(flags, "wx")  != 0 &&
         strcasecmp(flags, "sx")  != 0 &&
         strcasecmp(flags, "rx")  != 0 &&
         strcasecmp(flags, "ax")  != 0 &&
-        strcasecmp(flags, "rax") != 0)  {
+        strcasecmp(flags, "rax") != 0 &&
+        strcasecmp(flags, "wmx") != 0 &&
+        strcasecmp(flags, "smx") != 0)  {
         return(S_EVFILE_BADARG);
     }
 
@@ -2117,13 +2337,15 @@ int evOpenFake(char *filename, char *flags, int *handle, char **evf)
     a = (EVFILE *)calloc(1, sizeof(EVFILE));
     structInit(a);
 
-     for (ihandle=0; ihandle < handleCount; ihandle++) {
+    getHandleLock();
+    for (ihandle=0; ihandle < handleCount; ihandle++) {
         if (handleList[ihandle] == 0) {
-            handleList[ihandle] = a;
+            setHandle(ihandle, a);
             *handle = ihandle+1;
             break;
         }
     }
+    getHandleUnlock();
     
     a->rw = EV_WRITEFILE;
     a->baseFileName = filename;
@@ -2146,6 +2368,7 @@ int evOpenFake(char *filename, char *flags, int *handle, char **evf)
  * @param flags   pointer to case-independent string:
  *                "w", "s, "r", "a", & "ra"
  *                for writing/splitting/reading/append/random-access-reading to/from a file;
+ *                "wm" & "sm" for writing/splitting a file through a memory map;
  *                "ws" & "rs"
  *                for writing/reading to/from a socket;
  *                "wb", "rb", "ab", & "rab"
@@ -2181,7 +2404,8 @@ static int evOpenImpl(char *srcDest, uint32_t bufLen, int sockFd, char *flags, i
     int64_t nBytes=0;
     const int debug=0;
     int useFile=0, useBuffer=0, useSocket=0;
-    int reading=0, randomAccess=0, append=0, splitting=0, specifierCount=0, lockingOn=1;
+    int reading=0, randomAccess=0, append=0, splitting=0, specifierCount=0, lockingOn=1, compressed=0;
+    int mmapWrite=0;
 
     
     /* Check args */
@@ -2202,6 +2426,8 @@ if (debug) printf("EV_HDSIZ in evio.h set to be too small (%d). Must be >= 8.\n"
         strcasecmp(flags, "rx")   == 0  ||
         strcasecmp(flags, "ax")   == 0  ||
         strcasecmp(flags, "rax")  == 0  ||
+        strcasecmp(flags, "wmx")  == 0  ||
+        strcasecmp(flags, "smx")  == 0  ||
 
         strcasecmp(flags, "wbx")  == 0  ||
         strcasecmp(flags, "rbx")  == 0  ||
@@ -2220,12 +2446,16 @@ if (debug) printf("EV_HDSIZ in evio.h set to be too small (%d). Must be >= 8.\n"
         strcasecmp(flags, "r")    == 0  ||
         strcasecmp(flags, "a")    == 0  ||
         strcasecmp(flags, "ra")   == 0  ||
+        strcasecmp(flags, "wm")   == 0  ||
+        strcasecmp(flags, "sm")   == 0  ||
 
         strcasecmp(flags, "wx")   == 0  ||
         strcasecmp(flags, "sx")   == 0  ||
         strcasecmp(flags, "rx")   == 0  ||
         strcasecmp(flags, "ax")   == 0  ||
-        strcasecmp(flags, "rax")  == 0)   {
+        strcasecmp(flags, "rax")  == 0  ||
+        strcasecmp(flags, "wmx")  == 0  ||
+        strcasecmp(flags, "smx")  == 0)   {
 
         useFile = 1;
 
@@ -2233,9 +2463,11 @@ if (debug) printf("EV_HDSIZ in evio.h set to be too small (%d). Must be >= 8.\n"
         else if (strncasecmp(flags,  "s", 1) == 0) splitting = 1;
         else if (strncasecmp(flags, "ra", 2) == 0) randomAccess = 1;
 
+        if (strncasecmp(flags + 1, "m", 1) == 0) mmapWrite = 1;
+
 #if defined _MSC_VER
-        /* No random access support in Windows */
-        if (randomAccess) {
+        /* No random access or memory mapped writing support in Windows */
+        if (randomAccess || mmapWrite) {
             return(S_EVFILE_BADARG);
         }
 #endif
@@ -2314,6 +2546,7 @@ if (debug) printf("EV_HDSIZ in evio.h set to be too small (%d). Must be >= 8.\n"
 
     /* Set the mutex locking */
     a->lockingOn = lockingOn;
+    a->mmapWrite = mmapWrite;
 
     /*********************************************************/
     /* If we're reading a version 1-6 file/socket/buffer,
@@ -2582,10 +2815,16 @@ if (debug) printf("Header has unsupported evio version (%d), quit\n", version);
                     int headerSize = EV_HDSIZ_BYTES_V6;
                     char *pHead = (char *) fileHeader;
 
+                    // A pipe cannot back up, so keep what was read and read the rest
+                    if (a->rw == EV_READPIPE) {
+                        memcpy((void *) fileHeader, (const void *) header, EV_HDSIZ_BYTES);
+                        bytesRead = EV_HDSIZ_BYTES;
+                    }
+
                     /* Read in v6 file header */
                     while (bytesRead < headerSize) {
                         // Back up to file beginning
-                        fseek(a->file, 0, 0);
+                        if (a->rw != EV_READPIPE) fseek(a->file, 0, 0);
                         nBytes = (int64_t) fread((void *) (pHead + bytesRead), 1,
                                                  (size_t) (headerSize - bytesRead), a->file);
                         if (nBytes < 1) {
@@ -2606,7 +2845,7 @@ if (debug) printf("Header has unsupported evio version (%d), quit\n", version);
                     }
 
                     /* Check to see if all bytes are there */
-                    if (nBytes != headerSize) {
+                    if (bytesRead != headerSize) {
                         localClose(a);
                         free(filename);
                         freeEVFILE(a);
@@ -2663,7 +2902,14 @@ printf("evOpenImpl: index array len = %u,  user header len = %u, version word =
 
                     // Do the actual skipping over index array and user header here
                     if (a->fileIndexArrayLen + a->fileUserHeaderLen + padding > 0) {
-                        fseek(a->file, a->filePosition, 0);
+                        if (a->rw == EV_READPIPE) {
+                            // A pipe cannot seek, so read past them
+                            uint32_t skip = a->fileIndexArrayLen + a->fileUserHeaderLen + padding;
+                            while (skip > 0 && fgetc(a->file) != EOF) skip--;
+                        }
+                        else {
+                            fseek(a->file, a->filePosition, 0);
+                        }
                     }
 
                     /* Read in v6 file header */
@@ -2768,20 +3014,13 @@ if (debug) printf("evOpen: read in rest of header, bytes = %d\n", (int)(EV_HDSIZ
                 }
             }
 
-            // C library is not equipped to (un)compress data
-            uint32_t compWord = header[EV_HD_COMPDATALEN];
-            if (isCompressed(compWord)) {
-                printf("evOpen: compressed data cannot be read by C evio lib");
-                if (useFile) {
-                    localClose(a);
-                    free(filename);
-                }
-                freeEVFILE(a);
-                return (S_EVFILE_BADFILE);
-            }
+            // Index array and user header of a compressed record are read
+            // along with its data, then uncompressed together
+            compressed = isCompressed(header[EV_HD_COMPDATALEN]);
 
             // bytes in index array
             uint32_t indexLen = a->curRecordIndexArrayLen = header[EV_HD_INDEXARRAYLEN];
+            if (compressed) indexLen = 0;
 if (debug) printf("evOpen: index array len = %u bytes\n", indexLen);
 
             // Read event lengths if there are any
@@ -2876,7 +3115,7 @@ if (debug) printf("evOpen: read in index array, len = %u bytes\n", indexLen);
             a->curRecordUserHeaderLen = header[EV_HD_USERHDRLEN];
             // padding bytes in user header
             int padding = getPad1(header[EV_HD_VER]);
-            uint32_t bytesToSkip = a->curRecordUserHeaderLen + padding;
+            uint32_t bytesToSkip = compressed ? 0 : a->curRecordUserHeaderLen + padding;
 
             if (bytesToSkip > 0) {
                 if (useFile) {
@@ -3106,6 +3345,19 @@ printf("ERROR retrieving DICTIONARY, status = %#.8x\n", status);
                     }
                 }
             }
+            else if (compressed) {
+                /* Compressed data was read in right after the standard size header */
+                err = uncompressRecordV6(a, a->buf + EV_HDSIZ_V6);
+                if (err != S_SUCCESS) {
+                    if (useFile) {
+                        localClose(a);
+                        free(filename);
+                    }
+                    freeEVFILE(a);
+                    return(err);
+                }
+                a->isLastBlock = isLastBlock_V6(a->buf);
+            }
             else {
                 a->next = a->buf + EV_HDSIZ_V6 + a->eventLengthsLen;
 //printf("evOpen: a->next = a->buf + 0x%x, a->eventLengthsLen = %u\n", (EV_HDSIZ_V6 + a->eventLengthsLen), a->eventLengthsLen);
@@ -3135,6 +3387,13 @@ if (debug) printf("evOpen: append while writing to %s\n", filename);
             a->rw = EV_WRITEFILE;
 #else
             a->rw = EV_WRITEFILE;
+            if (mmapWrite && (strcmp(filename,"-") == 0 || filename[0] == '|')) {
+                /* Cannot memory map stdout or pipe */
+                freeEVFILE(a);
+                free(filename);
+                return (S_EVFILE_BADARG);
+            }
+
             if (strcmp(filename,"-") == 0) {
                 /* Cannot append to stdout */
                 if (append) {
@@ -3378,7 +3637,15 @@ if (debug) printf("evOpen: append, call toAppendPosition\n");
 
     /* Do the first-time initialization */
     if (handleCount < 1 || handleList == NULL) {
-        expandHandles();
+        if (expandHandles() != S_SUCCESS) {
+            getHandleUnlock();
+            if (useFile) {
+                localClose(a);
+                free(filename);
+            }
+            freeEVFILE(a);
+            return(S_EVFILE_ALLOCFAIL);
+        }
     }
 
     {
@@ -3387,7 +3654,7 @@ if (debug) printf("evOpen: append, call toAppendPosition\n");
         for (ihandle=0; ihandle < handleCount; ihandle++) {
             /* If a slot is available ... */
             if (handleList[ihandle] == NULL) {
-                handleList[ihandle] = a;
+                setHandle(ihandle, a);
                 *handle = ihandle + 1;
                 /* store handle in structure for later convenience */
                 a->handle = ihandle + 1;
@@ -3401,11 +3668,19 @@ if (debug) printf("evOpen: append, call toAppendPosition\n");
             /* Remember old handle count */
             int oldHandleLimit = (int) handleCount;
             /* Create 50% more handles (and increase handleCount) */
-            expandHandles();
+            if (expandHandles() != S_SUCCESS) {
+                getHandleUnlock();
+                if (useFile) {
+                    localClose(a);
+                    free(filename);
+                }
+                freeEVFILE(a);
+                return(S_EVFILE_ALLOCFAIL);
+            }
 
             /* Use a newly created handle */
             ihandle = oldHandleLimit;
-            handleList[ihandle] = a;
+            setHandle(ihandle, a);
             *handle = ihandle + 1;
             a->handle = ihandle + 1;
         }
@@ -3425,7 +3700,8 @@ if (debug) printf("evOpen: append, call toAppendPosition\n");
 static void localClose(EVFILE *a) {
     /* Close file */
     if (a->rw == EV_WRITEFILE) {
-        if (a->file != NULL) fclose(a->file);
+        if (a->mmapWrite) unmapFileForWriting(a, a->bytesToFile);
+        else if (a->file != NULL) fclose(a->file);
     }
     else if (a->rw == EV_READFILE) {
         if (a->randomAccess) {
@@ -3473,8 +3749,9 @@ static int memoryMapFile(EVFILE *a, const char *fileName) {
     }
     fileSize = (size_t)fileInfo.st_size;
 
-    /* Map file to local memory in read-only mode. */
-    if ((pmem = (uint32_t *)mmap((void *)0, fileSize, PROT_READ,
+    /* Map file to local memory. It's private, so the file is never written,
+     * but writable so evReadRandom can swap events in place. */
+    if ((pmem = (uint32_t *)mmap((void *)0, fileSize, PROT_READ | PROT_WRITE,
                                    MAP_PRIVATE, fd, (off_t)0)) == MAP_FAILED) {
         /* errno is set */
         close(fd);
@@ -3493,181 +3770,548 @@ static int memoryMapFile(EVFILE *a, const char *fileName) {
 
 
 /**
- * This function returns a count of the number of events in a file or buffer.
- * If reading with random access, it returns the count taken when initially
- * generating the table of event pointers. If regular reading, the count is
- * generated when asked for in evIoctl. If writing, the count gets incremented
- * by 1 for each evWrite. If appending, the count is set when moving to the
- * correct file position during evOpen and is thereafter incremented with each
- * evWrite.
+ * This function creates the file being written in "wm" or "sm" mode and memory maps it,
+ * or if done already, makes the file and its mapping big enough to hold the given
+ * number of bytes. Since making a file bigger means mapping it again, the file is
+ * first made big enough for all of a split, or 64MB when not splitting, and doubled
+ * in size after that. It's cut to its actual size by {@link #unmapFileForWriting}.
  *
- * @param a     handle structure
- * @param count pointer to int which gets filled with number of events
+ * @param a           handle structure
+ * @param bytesNeeded number of bytes, from the start of the file, which must fit into the map
  *
- * @return S_SUCCESS          if successful
- * @return S_FAILURE          if using sockets 
- * @return S_EVFILE_BADFILE   if file too small or problem reading file
- * @return S_EVFILE_UNXPTDEOF if buffer too small
- * @return errno              if error in fseek, ftell
+ * @return S_SUCCESS   if successful
+ * @return S_FAILURE   if failure to create, size, or memory map file (errno is set)
  */
-static int getEventCount(EVFILE *a, uint32_t *count) {
-    int        i, usingBuffer = 0, nBytes;
-    ssize_t    startingPosition=0;
-    uint32_t   bytesUsed=0, blockEventCount, blockSize, header[EV_HDSIZ];
-
-    /* Already protected with read lock since it's called only by evIoctl */
-
-    /* Reject if using sockets/pipes */
-    if (a->rw == EV_WRITESOCK || a->rw == EV_READSOCK ||
-        a->rw == EV_WRITEPIPE || a->rw == EV_READPIPE) {
-        return(S_FAILURE);
-    }
+static int mapFileForWriting(EVFILE *a, uint64_t bytesNeeded) {
+    uint64_t  newSize;
+    uint32_t *pmem;
+    long      pageSize = sysconf(_SC_PAGESIZE);
+    mode_t    mode;
 
-    /* If using random access, counting is already done. */
-    if (a->randomAccess) {
-        *count = a->eventCount;
+    if (bytesNeeded <= a->mmapFileSize) {
         return(S_SUCCESS);
     }
 
-    /* If we have a non-zero event count that means
-     * it has already been found and is up-to-date. */
-    if (a->eventCount > 0) {
-        *count = a->eventCount;
-        return(S_SUCCESS);
+    if (a->mmapFile == NULL) {
+        /* File may have been created ahead of time by preCreateNextFile */
+        if (a->mmapFd < 0) {
+            /* Same permissions as fopen gives */
+            mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+            if ((a->mmapFd = open(a->fileName, O_RDWR | O_CREAT | O_TRUNC, mode)) < 0) {
+                /* errno is set */
+                return(S_FAILURE);
+            }
+        }
+        newSize = a->splitting ? a->split + 4*(uint64_t)a->bufSize : EV_MMAP_WRITE_SIZE;
     }
-
-    /* If we have a zero event count and we're writing (NOT in append mode), 
-     * it means nothing has been written yet so nothing to read. */
-    if (!a->append && (a->rw == EV_WRITEBUF || a->rw == EV_WRITEFILE)) {
-        *count = a->eventCount;
-        return(S_SUCCESS);
+    else {
+        newSize = 2*(uint64_t)a->mmapFileSize;
     }
 
-    /* A zero event count may, in fact, be up-to-date. If it is, recounting is
-     * not a big deal since there are no events. If it isn't, we need to count
-     * the events. So go ahead and count the events now. */
+    if (newSize < bytesNeeded) {
+        newSize = bytesNeeded;
+    }
+    newSize = (newSize + pageSize - 1) / pageSize * pageSize;
 
-    /* Buffer or file? */
-    if (a->rw == EV_READBUF) {
-        usingBuffer = 1;
+    /* Sparse file, no disk space is taken up until written to */
+    if (ftruncate(a->mmapFd, (off_t)newSize) < 0) {
+        return(S_FAILURE);
     }
 
-    /* Go to starting position */
-    if (usingBuffer) {
-        bytesUsed = 0;
+    if (a->mmapFile != NULL) {
+        munmap(a->mmapFile, a->mmapFileSize);
+        a->mmapFile = NULL;
+        a->mmapFileSize = 0;
     }
-    else {
-        /* Record starting position, return here when finished */
-        if ((startingPosition = ftell(a->file)) < 0) return(errno);
 
-        /* Go to back to first record of file */
-        if (fseek(a->file, a->firstRecordPosition, SEEK_SET) < 0) return(errno);
+    if ((pmem = (uint32_t *)mmap((void *)0, (size_t)newSize, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED, a->mmapFd, (off_t)0)) == MAP_FAILED) {
+        /* errno is set */
+        return(S_FAILURE);
     }
 
-    while (1) {
-        /* Read in EV_HDSIZ (8) ints of header */
-        if (usingBuffer) {
-            /* Is there enough data to read in header? */
-            if (a->rwBufSize - bytesUsed < sizeof(header)) {
-                /* unexpected EOF or end-of-buffer in this case */
-                return(S_EVFILE_UNXPTDEOF);
-            }
-            /* Read (copy) in header */
-            memcpy(header, (a->rwBuf + bytesUsed), 4*EV_HDSIZ);
-        }
-        else {
-            nBytes = (int) (sizeof(header)*fread(header, sizeof(header), 1, a->file));
-                
-            /* Check to see if we read the whole header */
-            if (nBytes != sizeof(header)) {
-                return(S_EVFILE_BADFILE);
-            }
-        }
+    a->mmapFile = pmem;
+    a->mmapFileSize = (size_t)newSize;
 
-        /* Swap header if necessary */
-        if (a->byte_swapped) {
-            swap_int32_t(header, EV_HDSIZ, NULL);
-        }
+    return(S_SUCCESS);
+}
 
-        /* Look at block header to get info */
-        i               = header[EV_HD_VER];
-        blockSize       = header[EV_HD_BLKSIZ];
-        blockEventCount = header[EV_HD_COUNT];
-//printf("getEventCount: ver = 0x%x, blk size = 0x%x, blk ev cnt = %u\n", i, blockSize, blockEventCount);
-        
-        /* Add to the number of events. Dictionary is NOT
-         * included in the header's event count. */
-        a->eventCount += blockEventCount;
 
-        /* Stop at the last block */
-        if (a->version > 5 && isLastBlockInt_V6(i)) {
-            break;
-        }
-        else if (isLastBlockInt(i)) {
-            break;
-        }
+/**
+ * This function unmaps and closes a file written in "wm" or "sm" mode,
+ * cutting off the unused part it was made bigger with. Data is
+ * left for the kernel to write to disk as with a regular close.
+ *
+ * @param a         handle structure
+ * @param fileBytes number of bytes actually written to file
+ *
+ * @return S_SUCCESS   if successful or nothing to do
+ * @return S_FAILURE   if failure to unmap, size, or close file
+ */
+static int unmapFileForWriting(EVFILE *a, uint64_t fileBytes) {
+    int status = S_SUCCESS;
 
-        /* Hop to next block header */
-        if (usingBuffer) {
-            /* Is there enough buffer space to hop over block? */
-            if (a->rwBufSize - bytesUsed < 4*blockSize) {
-                /* unexpected EOF or end-of-buffer in this case */
-                return(S_EVFILE_UNXPTDEOF);
-            }
-            bytesUsed += 4*blockSize;
-        }
-        else {
-//printf("getEventCount: hop to next record = %u words\n", (blockSize-EV_HDSIZ));
-            if (fseek(a->file, 4*(blockSize-EV_HDSIZ), SEEK_CUR) < 0) return(errno);
-        }
+    if (a->mmapFile != NULL) {
+        if (munmap(a->mmapFile, a->mmapFileSize) < 0) status = S_FAILURE;
+        a->mmapFile = NULL;
+        a->mmapFileSize = 0;
     }
 
-    /* Reset file to original position (buffer needs no resetting) */
-    if (!usingBuffer) {
-        if (fseek(a->file, startingPosition, SEEK_SET) < 0) return(errno);
+    if (a->mmapFd >= 0) {
+        if (ftruncate(a->mmapFd, (off_t)fileBytes) < 0) status = S_FAILURE;
+        if (close(a->mmapFd) < 0) status = S_FAILURE;
+        a->mmapFd = -1;
     }
-    if (count != NULL) *count = a->eventCount;
 
-    return(S_SUCCESS);
+    return(status);
 }
 
 
 /**
- * This function steps through a memory mapped file or buffer and creates
- * a table containing pointers to the beginning of all events.
- *
- * @param a  handle structure
- *
- * @return S_SUCCESS          if successful or not random access handle (does nothing).
- * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated.
- * @return S_EVFILE_BADFILE   if bad data format.
- * @return S_EVFILE_UNXPTDEOF if unexpected EOF or end-of-valid-data
- *                            while reading data (perhaps bad block header).
+ * Work on a split file done in another thread so that writing events is not held up
+ * by the file system. It either closes a file which is finished (flushing what's left
+ * of it, unmapping it, cutting it to size), or creates the next file of a split.
  */
-static int generatePointerTable(EVFILE *a) {
+typedef struct evFileJob {
+    pthread_t thread;    /**< thread doing the work. */
+    FILE     *file;      /**< file written with fwrite, NULL if none. */
+    int       fd;        /**< descriptor of file written through memory map, -1 if none. */
+    uint32_t *map;       /**< memory map of file being closed, NULL if none. */
+    size_t    mapSize;   /**< size of map in bytes. */
+    uint64_t  fileBytes; /**< number of bytes written to memory mapped file being closed. */
+    char     *fileName;  /**< name of file being created. */
+    int       mmapWrite; /**< if true, file being created is to be written through a memory map. */
+    int       status;    /**< S_SUCCESS or S_FAILURE once the work is done. */
+    int       joined;    /**< 1 if thread has been joined, else 0. */
+} evFileJob;
 
-    int        i, usingBuffer=0, lastBlock=0, firstBlock=1;
-    size_t     bytesLeft;
-    uint32_t  *pmem, len, numPointers, blockEventCount, blockHdrSize, evIndex = 0L;
 
-    if (a->version > 4) {
-        return generatePointerTableV6(a);
-    }
+/**
+ * Thread routine which closes a finished split file.
+ * @param arg pointer to evFileJob.
+ * @return NULL
+ */
+static void *closeFileThread(void *arg) {
+    evFileJob *job = (evFileJob *)arg;
 
-    /* Only random access handles need apply */
-    if (!a->randomAccess) {
-        return(S_SUCCESS);
+    job->status = S_SUCCESS;
+
+    if (job->map != NULL) {
+        if (munmap(job->map, job->mapSize) < 0) job->status = S_FAILURE;
     }
 
-    if (a->rw == EV_READBUF) {
-        usingBuffer = 1;
+    if (job->fd >= 0) {
+        if (ftruncate(job->fd, (off_t)job->fileBytes) < 0) job->status = S_FAILURE;
+        if (close(job->fd) < 0) job->status = S_FAILURE;
     }
 
-    /* Start with space for 10,000 event pointers */
-    numPointers = 10000;
-    a->pTable = (uint32_t **) malloc(numPointers * sizeof(uint32_t *));
-    if (!a->pTable) {
-        return (S_EVFILE_ALLOCFAIL);
+    if (job->file != NULL) {
+        if (fclose(job->file) == EOF) job->status = S_FAILURE;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Thread routine which creates the next split file.
+ * The file is not created if it already exists, since split files are never overwritten.
+ * @param arg pointer to evFileJob.
+ * @return NULL
+ */
+static void *createFileThread(void *arg) {
+    evFileJob *job = (evFileJob *)arg;
+    /* Same permissions as fopen gives */
+    mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+
+    job->status = S_FAILURE;
+
+    job->fd = open(job->fileName, (job->mmapWrite ? O_RDWR : O_WRONLY) | O_CREAT | O_EXCL, mode);
+    if (job->fd < 0) {
+        return NULL;
+    }
+
+    if (!job->mmapWrite) {
+        job->file = fdopen(job->fd, "w");
+        if (job->file == NULL) {
+            close(job->fd);
+            unlink(job->fileName);
+            job->fd = -1;
+            return NULL;
+        }
+        job->fd = -1;
+    }
+
+    job->status = S_SUCCESS;
+    return NULL;
+}
+
+
+/**
+ * This function hands the file being written, which must be completely flushed,
+ * over to another thread to close, so splitting a file does not wait on the
+ * file system. Only one file is closed at a time. If the last one is still
+ * being closed, this waits for it first.
+ *
+ * @param a handle structure
+ *
+ * @return S_SUCCESS   if successful
+ * @return S_FAILURE   if the last file closed in the background failed to close properly,
+ *                     or if this file was closed here and failed to close properly
+ */
+static int closeFileInBackground(EVFILE *a) {
+    int status;
+    evFileJob *job;
+
+    status = waitForClosedFile(a);
+
+    if (a->file == NULL && a->mmapFd < 0 && a->mmapFile == NULL) {
+        return(status);
+    }
+
+    job = (evFileJob *) calloc(1, sizeof(evFileJob));
+    if (job == NULL) {
+        if (a->mmapWrite) {
+            if (unmapFileForWriting(a, a->bytesToFile) != S_SUCCESS) status = S_FAILURE;
+        }
+        else if (fclose(a->file) == EOF) {
+            status = S_FAILURE;
+        }
+        a->file = NULL;
+        return(status);
+    }
+
+    job->file      = a->file;
+    job->fd        = a->mmapFd;
+    job->map       = a->mmapFile;
+    job->mapSize   = a->mmapFileSize;
+    job->fileBytes = a->bytesToFile;
+
+    a->file = NULL;
+    a->mmapFd = -1;
+    a->mmapFile = NULL;
+    a->mmapFileSize = 0;
+
+    if (pthread_create(&job->thread, NULL, closeFileThread, (void *)job) != 0) {
+        /* No thread, so do it here */
+        closeFileThread((void *)job);
+        if (job->status != S_SUCCESS) status = S_FAILURE;
+        free(job);
+        return(status);
+    }
+
+    a->closeJob = job;
+    return(status);
+}
+
+
+/**
+ * This function waits for the file being closed in the background, if any, to finish.
+ *
+ * @param a handle structure
+ *
+ * @return S_SUCCESS   if successful or no file being closed
+ * @return S_FAILURE   if the file failed to close properly
+ */
+static int waitForClosedFile(EVFILE *a) {
+    int status;
+    evFileJob *job = a->closeJob;
+
+    if (job == NULL) {
+        return(S_SUCCESS);
+    }
+
+    pthread_join(job->thread, NULL);
+    status = job->status;
+    free(job);
+    a->closeJob = NULL;
+
+    return(status);
+}
+
+
+/**
+ * When splitting a file, this function starts creating the next split file in another
+ * thread so that it's ready by the time the current one is full. Any failure here
+ * is ignored, since the file is created again, as usual, if it's not ready when needed.
+ *
+ * @param a handle structure
+ */
+static void preCreateNextFile(EVFILE *a) {
+    evFileJob *job;
+
+    if (!a->splitting || a->rw != EV_WRITEFILE || a->openJob != NULL) {
+        return;
+    }
+
+    job = (evFileJob *) calloc(1, sizeof(evFileJob));
+    if (job == NULL) {
+        return;
+    }
+
+    /* Name the next file will have, without using up its number */
+    job->fileName = evGenerateFileName(a, a->specifierCount, a->runNumber,
+                                       a->splitting, a->splitNumber,
+                                       a->runType, a->streamId);
+    if (job->fileName == NULL) {
+        free(job);
+        return;
+    }
+
+    job->fd = -1;
+    job->mmapWrite = a->mmapWrite;
+
+    if (pthread_create(&job->thread, NULL, createFileThread, (void *)job) != 0) {
+        free(job->fileName);
+        free(job);
+        return;
+    }
+
+    a->openJob = job;
+}
+
+
+/**
+ * This function uses the file created by {@link #preCreateNextFile}, if it has
+ * the name of the file about to be written, as the file being written.
+ * If it has any other name, it's removed.
+ *
+ * @param a handle structure
+ *
+ * @return 1 if the created file is now being written, else 0
+ */
+static int usePreCreatedFile(EVFILE *a) {
+    evFileJob *job = a->openJob;
+
+    if (job == NULL) {
+        return 0;
+    }
+
+    pthread_join(job->thread, NULL);
+    job->joined = 1;
+
+    if (job->status != S_SUCCESS || strcmp(job->fileName, a->fileName) != 0) {
+        removePreCreatedFile(a);
+        return 0;
+    }
+
+    a->file = job->file;
+    if (a->mmapWrite) a->mmapFd = job->fd;
+
+    free(job->fileName);
+    free(job);
+    a->openJob = NULL;
+
+    return 1;
+}
+
+
+/**
+ * This function waits for the file being created by {@link #preCreateNextFile},
+ * if any, and removes it since it will not be used.
+ *
+ * @param a handle structure
+ */
+static void removePreCreatedFile(EVFILE *a) {
+    evFileJob *job = a->openJob;
+
+    if (job == NULL) {
+        return;
+    }
+
+    if (!job->joined) {
+        pthread_join(job->thread, NULL);
+        job->joined = 1;
+    }
+
+    if (job->status == S_SUCCESS) {
+        if (job->file != NULL) fclose(job->file);
+        if (job->fd >= 0) close(job->fd);
+        unlink(job->fileName);
+    }
+
+    free(job->fileName);
+    free(job);
+    a->openJob = NULL;
+}
+
+
+/**
+ * This function returns a count of the number of events in a file or buffer.
+ * If reading with random access, it returns the count taken when initially
+ * generating the table of event pointers. If regular reading, the count is
+ * generated when asked for in evIoctl. If writing, the count gets incremented
+ * by 1 for each evWrite. If appending, the count is set when moving to the
+ * correct file position during evOpen and is thereafter incremented with each
+ * evWrite.
+ *
+ * @param a     handle structure
+ * @param count pointer to int which gets filled with number of events
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_FAILURE          if using sockets 
+ * @return S_EVFILE_BADFILE   if file too small or problem reading file
+ * @return S_EVFILE_UNXPTDEOF if buffer too small
+ * @return errno              if error in fseek, ftell
+ */
+static int getEventCount(EVFILE *a, uint32_t *count) {
+    int        i, usingBuffer = 0, nBytes;
+    ssize_t    startingPosition=0;
+    uint32_t   bytesUsed=0, blockEventCount, blockSize, header[EV_HDSIZ];
+
+    /* Already protected with read lock since it's called only by evIoctl */
+
+    /* Reject if using sockets/pipes */
+    if (a->rw == EV_WRITESOCK || a->rw == EV_READSOCK ||
+        a->rw == EV_WRITEPIPE || a->rw == EV_READPIPE) {
+        return(S_FAILURE);
+    }
+
+    /* If using random access, counting is already done. */
+    if (a->randomAccess) {
+        *count = a->eventCount;
+        return(S_SUCCESS);
+    }
+
+    /* If we have a non-zero event count that means
+     * it has already been found and is up-to-date. */
+    if (a->eventCount > 0) {
+        *count = a->eventCount;
+        return(S_SUCCESS);
+    }
+
+    /* If we have a zero event count and we're writing (NOT in append mode), 
+     * it means nothing has been written yet so nothing to read. */
+    if (!a->append && (a->rw == EV_WRITEBUF || a->rw == EV_WRITEFILE)) {
+        *count = a->eventCount;
+        return(S_SUCCESS);
+    }
+
+    /* A zero event count may, in fact, be up-to-date. If it is, recounting is
+     * not a big deal since there are no events. If it isn't, we need to count
+     * the events. So go ahead and count the events now. */
+
+    /* Buffer or file? */
+    if (a->rw == EV_READBUF) {
+        usingBuffer = 1;
+    }
+
+    /* Go to starting position */
+    if (usingBuffer) {
+        bytesUsed = 0;
+    }
+    else {
+        /* Record starting position, return here when finished */
+        if ((startingPosition = ftell(a->file)) < 0) return(errno);
+
+        /* Go to back to first record of file */
+        if (fseek(a->file, a->firstRecordPosition, SEEK_SET) < 0) return(errno);
+    }
+
+    while (1) {
+        /* Read in EV_HDSIZ (8) ints of header */
+        if (usingBuffer) {
+            /* Is there enough data to read in header? */
+            if (a->rwBufSize - bytesUsed < sizeof(header)) {
+                /* unexpected EOF or end-of-buffer in this case */
+                return(S_EVFILE_UNXPTDEOF);
+            }
+            /* Read (copy) in header */
+            memcpy(header, (a->rwBuf + bytesUsed), 4*EV_HDSIZ);
+        }
+        else {
+            nBytes = (int) (sizeof(header)*fread(header, sizeof(header), 1, a->file));
+                
+            /* Check to see if we read the whole header */
+            if (nBytes != sizeof(header)) {
+                return(S_EVFILE_BADFILE);
+            }
+        }
+
+        /* Swap header if necessary */
+        if (a->byte_swapped) {
+            swap_int32_t(header, EV_HDSIZ, NULL);
+        }
+
+        /* Look at block header to get info */
+        i               = header[EV_HD_VER];
+        blockSize       = header[EV_HD_BLKSIZ];
+        blockEventCount = header[EV_HD_COUNT];
+//printf("getEventCount: ver = 0x%x, blk size = 0x%x, blk ev cnt = %u\n", i, blockSize, blockEventCount);
+        
+        /* Add to the number of events. Dictionary is NOT
+         * included in the header's event count. */
+        a->eventCount += blockEventCount;
+
+        /* Stop at the last block */
+        if (a->version > 5 && isLastBlockInt_V6(i)) {
+            break;
+        }
+        else if (isLastBlockInt(i)) {
+            break;
+        }
+
+        /* Hop to next block header */
+        if (usingBuffer) {
+            /* Is there enough buffer space to hop over block? */
+            if (a->rwBufSize - bytesUsed < 4*blockSize) {
+                /* unexpected EOF or end-of-buffer in this case */
+                return(S_EVFILE_UNXPTDEOF);
+            }
+            bytesUsed += 4*blockSize;
+        }
+        else {
+//printf("getEventCount: hop to next record = %u words\n", (blockSize-EV_HDSIZ));
+            if (fseek(a->file, 4*(blockSize-EV_HDSIZ), SEEK_CUR) < 0) return(errno);
+        }
+    }
+
+    /* Reset file to original position (buffer needs no resetting) */
+    if (!usingBuffer) {
+        if (fseek(a->file, startingPosition, SEEK_SET) < 0) return(errno);
+    }
+    if (count != NULL) *count = a->eventCount;
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * This function steps through a memory mapped file or buffer and creates
+ * a table containing pointers to the beginning of all events.
+ *
+ * @param a  handle structure
+ *
+ * @return S_SUCCESS          if successful or not random access handle (does nothing).
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated.
+ * @return S_EVFILE_BADFILE   if bad data format.
+ * @return S_EVFILE_UNXPTDEOF if unexpected EOF or end-of-valid-data
+ *                            while reading data (perhaps bad block header).
+ */
+static int generatePointerTable(EVFILE *a) {
+
+    int        i, usingBuffer=0, lastBlock=0, firstBlock=1;
+    size_t     bytesLeft;
+    uint32_t  *pmem, len, numPointers, blockEventCount, blockHdrSize, evIndex = 0L;
+
+    if (a->version > 4) {
+        return generatePointerTableV6(a);
+    }
+
+    /* Only random access handles need apply */
+    if (!a->randomAccess) {
+        return(S_SUCCESS);
+    }
+
+    if (a->rw == EV_READBUF) {
+        usingBuffer = 1;
+    }
+
+    /* Start with space for 10,000 event pointers */
+    numPointers = 10000;
+    a->pTable = (uint32_t **) malloc(numPointers * sizeof(uint32_t *));
+    if (!a->pTable) {
+        return (S_EVFILE_ALLOCFAIL);
     }
 
     if (usingBuffer) {
@@ -3756,8 +4400,124 @@ static int generatePointerTable(EVFILE *a) {
 
 
 /**
- * This function steps through a memory mapped file or buffer and creates
- * a table containing pointers to the beginning of all events. For evio version 6 only.
+ * This function returns a word of a record header in local byte order.
+ *
+ * @param a     handle structure
+ * @param pmem  pointer to record header
+ * @param index index of word in header
+ *
+ * @return header word
+ */
+static uint32_t recordWordV6(EVFILE *a, const uint32_t *pmem, int index) {
+    return a->byte_swapped ? EVIO_SWAP32(pmem[index]) : pmem[index];
+}
+
+
+/**
+ * This function adds a record to the table of records used for random access. For evio version 6 only.
+ *
+ * @param a          handle structure
+ * @param pmem       pointer to record header in memory mapped file or buffer
+ * @param eventCount number of events in record
+ * @param tableSize  pointer to number of records there's room for in table, updated as it grows
+ *
+ * @return S_SUCCESS          if successful.
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated.
+ */
+static int addRecordV6(EVFILE *a, uint32_t *pmem, uint32_t eventCount, uint32_t *tableSize) {
+
+    /* Need more space, double it each time (first event index has 1 more entry) */
+    if (a->recordCount + 1 >= *tableSize) {
+        uint32_t newSize = *tableSize < 1024 ? 1024 : 2 * *tableSize;
+        uint32_t **recs  = (uint32_t **) realloc(a->recordTable, newSize*sizeof(uint32_t *));
+        if (recs == NULL) return(S_EVFILE_ALLOCFAIL);
+        a->recordTable = recs;
+
+        uint32_t *first  = (uint32_t *) realloc(a->recordFirstEvent, newSize*sizeof(uint32_t));
+        if (first == NULL) return(S_EVFILE_ALLOCFAIL);
+        if (a->recordFirstEvent == NULL) first[0] = 0;
+        a->recordFirstEvent = first;
+
+        *tableSize = newSize;
+    }
+
+    a->recordTable[a->recordCount] = pmem;
+    a->recordFirstEvent[a->recordCount + 1] = a->recordFirstEvent[a->recordCount] + eventCount;
+    a->recordCount++;
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * This function fills the table of records from the index of the file's trailer
+ * which holds the length in bytes and the number of events of each record.
+ * Only the trailer is read, not the records. For evio version 6 files only.
+ *
+ * @param a         handle structure
+ * @param tableSize pointer to number of records there's room for in table
+ *
+ * @return S_SUCCESS          if successful.
+ * @return S_FAILURE          if there's no usable trailer index (table is left empty).
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated.
+ */
+static int recordTableFromTrailerV6(EVFILE *a, uint32_t *tableSize) {
+
+    uint32_t *trailer, *index, *pmem, hdrSize, indexLen, i;
+    uint64_t pos;
+    int err;
+
+    if (a->trailerPosition < a->firstRecordPosition ||
+        a->trailerPosition % 4 != 0 ||
+        a->trailerPosition + EV_HDSIZ_BYTES_V6 > a->mmapFileSize) {
+        return(S_FAILURE);
+    }
+
+    trailer  = a->mmapFile + a->trailerPosition/4;
+    hdrSize  = recordWordV6(a, trailer, EV_HD_HDSIZ);
+    indexLen = recordWordV6(a, trailer, EV_HD_INDEXARRAYLEN);
+
+    if (recordWordV6(a, trailer, EV_HD_MAGIC) != EV_MAGIC || indexLen == 0 || indexLen % 8 != 0 ||
+        a->trailerPosition + 4*(uint64_t)hdrSize + indexLen > a->mmapFileSize) {
+        return(S_FAILURE);
+    }
+
+    /* Index is pairs of record length in bytes and event count */
+    index = trailer + hdrSize;
+    pos   = a->firstRecordPosition;
+
+    for (i=0; i < indexLen/4; i += 2) {
+        uint32_t recordBytes = recordWordV6(a, index, i);
+        uint32_t eventCount  = recordWordV6(a, index, i+1);
+
+        if (recordBytes % 4 != 0 || pos + recordBytes > a->trailerPosition) {
+            a->recordCount = 0;
+            return(S_FAILURE);
+        }
+
+        pmem = a->mmapFile + pos/4;
+        err = addRecordV6(a, pmem, eventCount, tableSize);
+        if (err != S_SUCCESS) return(err);
+        pos += recordBytes;
+    }
+
+    /* Records must end right where the trailer starts */
+    if (pos != a->trailerPosition) {
+        a->recordCount = 0;
+        return(S_FAILURE);
+    }
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * This function creates the tables used for random access of a memory mapped file
+ * or buffer without looking at any events. For a file whose trailer contains an
+ * index of record lengths, only the trailer is read. Otherwise it hops from one record
+ * header to the next. A table of event pointers is allocated but each record's entries
+ * stay NULL until {@link #scanRecordV6} is called on it, which is done the first time
+ * one of its events is asked for. For evio version 6 only.
  *
  * @param a  handle structure
  *
@@ -3769,143 +4529,271 @@ static int generatePointerTable(EVFILE *a) {
  */
 static int generatePointerTableV6(EVFILE *a) {
 
-    int        usingBuffer=0, lastRecord=0, firstRecord=1;
-    size_t     bytesLeft;
-    uint32_t  *pmem, numPointers, evIndex = 0L;
+    int        err, lastRecord=0;
+    size_t     bytesLeft;
+    uint32_t  *pmem, tableSize = 0;
+
+
+    /* Only random access */
+    if (!a->randomAccess) {
+        return(S_SUCCESS);
+    }
+
+    err = S_FAILURE;
+    if (a->rw != EV_READBUF && a->trailerPosition > 0) {
+        err = recordTableFromTrailerV6(a, &tableSize);
+        if (err == (int)S_EVFILE_ALLOCFAIL) return(err);
+    }
+
+    /* No trailer index, so hop over record headers */
+    if (err != S_SUCCESS) {
+        if (a->rw == EV_READBUF) {
+            pmem = (uint32_t *)a->rwBuf;
+            bytesLeft = a->rwBufSize; /* limit on size only */
+        }
+        else {
+            pmem = a->mmapFile + (a->firstRecordPosition)/4;
+            bytesLeft = a->mmapFileSize - a->firstRecordPosition;
+        }
+
+        while (!lastRecord && bytesLeft > 0) {
+
+            if (bytesLeft < EV_HDSIZ_BYTES_V6) {
+                return(S_EVFILE_UNXPTDEOF);
+            }
+
+            uint32_t recordLen     = recordWordV6(a, pmem, EV_HD_BLKSIZ);
+            uint32_t recordHdrSize = recordWordV6(a, pmem, EV_HD_HDSIZ);
+
+            if (recordWordV6(a, pmem, EV_HD_MAGIC) != EV_MAGIC || recordLen < recordHdrSize ||
+                recordHdrSize < EV_HDSIZ_V6) {
+                return(S_EVFILE_BADFILE);
+            }
+
+            if (4*(size_t)recordLen > bytesLeft) {
+                return(S_EVFILE_UNXPTDEOF);
+            }
+
+            lastRecord = isLastBlockInt_V6(recordWordV6(a, pmem, EV_HD_VER));
+
+            err = addRecordV6(a, pmem, recordWordV6(a, pmem, EV_HD_COUNT), &tableSize);
+            if (err != S_SUCCESS) return(err);
+
+            pmem += recordLen;
+            bytesLeft -= 4*(size_t)recordLen;
+        }
+    }
+
+    if (a->recordCount < 1) {
+        /* No records, no events */
+        a->eventCount = 0;
+        return(S_SUCCESS);
+    }
+
+    a->eventCount = a->recordFirstEvent[a->recordCount];
+
+    /* Untouched entries of a calloc'd table may not even take up memory */
+    a->recordScanned = (char *) calloc(a->recordCount, 1);
+    a->pTable = (uint32_t **) calloc(a->eventCount + 1, sizeof(uint32_t *));
+    if (a->recordScanned == NULL || a->pTable == NULL) {
+        return(S_EVFILE_ALLOCFAIL);
+    }
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * This function fills in the random access table's pointers to each event of one record,
+ * found from the record's index of event lengths. For evio version 6 only.
+ *
+ * @param a      handle structure
+ * @param record index of record in a->recordTable
+ *
+ * @return S_SUCCESS          if successful.
+ * @return S_EVFILE_BADFILE   if bad data format or compressed data.
+ */
+static int scanRecordV6(EVFILE *a, uint32_t record) {
+
+    uint32_t *pmem, *pevent, *end, i, evIndex;
+
+    /* Nothing to do if done already or if no events, as in a trailer */
+    if (a->recordScanned[record] ||
+        a->recordFirstEvent[record + 1] == a->recordFirstEvent[record]) {
+        return(S_SUCCESS);
+    }
+
+    pmem = a->recordTable[record];
+
+    uint32_t recordLen        = recordWordV6(a, pmem, EV_HD_BLKSIZ);
+    uint32_t recordHdrSize    = recordWordV6(a, pmem, EV_HD_HDSIZ);
+    uint32_t recordEventCount = recordWordV6(a, pmem, EV_HD_COUNT);
+    uint32_t bitInfo          = recordWordV6(a, pmem, EV_HD_VER);
+    uint32_t compWord         = recordWordV6(a, pmem, EV_HD_COMPDATALEN);
+    uint32_t indexLen         = recordWordV6(a, pmem, EV_HD_INDEXARRAYLEN);
+    uint32_t usrHdrLen        = recordWordV6(a, pmem, EV_HD_USERHDRLEN);
+
+    /* May have been found from the trailer's index, so check it's really a record */
+    if (recordWordV6(a, pmem, EV_HD_MAGIC) != EV_MAGIC ||
+        recordEventCount != a->recordFirstEvent[record + 1] - a->recordFirstEvent[record]) {
+        return(S_EVFILE_BADFILE);
+    }
+
+    // Random access points into the memory map, so compressed data can't be used
+    if (isCompressed(compWord)) {
+        printf("scanRecordV6: compressed data cannot be read in random access mode by C evio lib\n");
+        return(S_EVFILE_BADFILE);
+    }
+
+    end     = pmem + recordLen;
+    evIndex = a->recordFirstEvent[record];
+
+    // Hop over record header
+    pmem += recordHdrSize;
+    pevent = pmem + (indexLen + usrHdrLen + getPad1(bitInfo))/4;
+
+    // If there's an index of event lengths, use that.
+    // There should always be one, but in case there isn't,
+    // hop through record event by event.
+    if (indexLen > 0 && indexLen != 4*recordEventCount) {
+        printf("scanRecordV6: index array has bad size\n");
+        return(S_EVFILE_BADFILE);
+    }
+
+    for (i=0; i < recordEventCount; i++) {
+        uint32_t eventWordLen;
+
+        if (pevent + 2 > end) {
+            return(S_EVFILE_BADFILE);
+        }
+
+        if (indexLen > 0) {
+            eventWordLen = recordWordV6(a, pmem, i)/4;
+        }
+        else {
+            // Bank's len does not include itself
+            eventWordLen = recordWordV6(a, pevent, 0) + 1;
+        }
+
+        if (eventWordLen < 2 || pevent + eventWordLen > end) {
+            return(S_EVFILE_BADFILE);
+        }
+
+        a->pTable[evIndex + i] = pevent;
+        pevent += eventWordLen;
+    }
+
+    a->recordScanned[record] = 1;
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * This function makes sure the random access table's pointer to the given event
+ * is filled in by scanning the record it's in, if not done already. For evio version 6 only.
+ *
+ * @param a     handle structure
+ * @param index index of event into a->pTable, starting at 0
+ *
+ * @return S_SUCCESS          if successful.
+ * @return S_EVFILE_BADFILE   if bad data format or compressed data.
+ */
+static int findEventV6(EVFILE *a, uint32_t index) {
+
+    /* Binary search for first record which ends after index,
+     * which skips over any records with no events */
+    uint32_t lo = 0, hi = a->recordCount - 1;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo)/2;
+        if (a->recordFirstEvent[mid + 1] > index) hi = mid;
+        else lo = mid + 1;
+    }
+
+    return scanRecordV6(a, lo);
+}
 
 
-    /* Only random access */
-    if (!a->randomAccess) {
-        return(S_SUCCESS);
-    }
+/**
+ * This function positions a file for the first {@link #evWrite} in append mode by
+ * using the index in its trailer, instead of reading every record header.
+ * The trailer is removed by cutting the file short at its start, and the file
+ * header's trailer position is zeroed since no trailer index is written when closing.
+ * Nothing is changed if the index does not account for every byte between the
+ * first record and the trailer. Evio version 6 files only.
+ *
+ * @param a              handle structure
+ * @param firstRecordPos file position of first record
+ * @param trailerPos     file position of trailer
+ * @param recordCount    pointer to int filled with number of records before the trailer
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_FAILURE          if there's no usable trailer index (file must be read)
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ * @return errno              if any file seeking/writing errors
+ */
+static int appendAtTrailerV6(EVFILE *a, uint64_t firstRecordPos, uint64_t trailerPos,
+                             uint32_t *recordCount) {
 
-    if (a->rw == EV_READBUF) {
-        usingBuffer = 1;
-    }
+    uint32_t trailer[EV_HDSIZ_V6], *index, indexLen, i, events = 0;
+    uint64_t pos = firstRecordPos, zero = 0;
 
-    /* Start with space for 10,000 event pointers */
-    numPointers = 10000;
-    a->pTable = (uint32_t **) malloc(numPointers * sizeof(uint32_t *));
-    if (!a->pTable) {
-        return (S_EVFILE_ALLOCFAIL);
+    if (trailerPos < firstRecordPos || trailerPos % 4 != 0) {
+        return(S_FAILURE);
     }
 
-    if (usingBuffer) {
-        pmem = (uint32_t *)a->rwBuf;
-        bytesLeft = a->rwBufSize; /* limit on size only */
+    if (fseek(a->file, trailerPos, SEEK_SET) < 0) return(errno);
+    if (fread(trailer, 1, EV_HDSIZ_BYTES_V6, a->file) != EV_HDSIZ_BYTES_V6) {
+        clearerr(a->file);
+        return(S_FAILURE);
     }
-    else {
-        pmem = a->mmapFile + (a->firstRecordPosition)/4;
-        bytesLeft = a->mmapFileSize - a->firstRecordPosition;
+    if (a->byte_swapped) {
+        swap_int32_t(trailer, EV_HDSIZ_V6, NULL);
     }
 
-    while (!lastRecord) {
-
-        /* Look at block header to get info */
-        int i                     = pmem[EV_HD_VER];
-        uint32_t recordHdrSize    = pmem[EV_HD_HDSIZ];
-        uint32_t recordEventCount = pmem[EV_HD_COUNT];
-        uint32_t compWord         = pmem[EV_HD_COMPDATALEN];
-        uint32_t indexLen         = pmem[EV_HD_INDEXARRAYLEN];
-        uint32_t usrHdrLen        = pmem[EV_HD_USERHDRLEN];
-
-        /* Swap if necessary */
-        if (a->byte_swapped) {
-            i                = EVIO_SWAP32(i);
-            recordHdrSize    = EVIO_SWAP32(recordHdrSize);
-            recordEventCount = EVIO_SWAP32(recordEventCount);
-            compWord         = EVIO_SWAP32(compWord);
-            indexLen         = EVIO_SWAP32(indexLen);
-            usrHdrLen        = EVIO_SWAP32(usrHdrLen);
-        }
-        lastRecord = isLastBlockInt_V6(i);
-
-//        printf("generatePointerTable:\n");
-//        printf("  ver word = 0x%x\n", i);
-//        printf("  hdr size = 0x%x\n", recordHdrSize);
-//        printf("  ev count = %u\n", recordEventCount);
-//        printf("  indexLen = %u\n", indexLen);
-//        printf("  hdr size = %u\n", recordHdrSize);
-//        printf("  usr hdr size = %u\n", usrHdrLen);
-
-        // C library is not equipped to (un)compress data
-        if (isCompressed(compWord)) {
-            printf("generatePointerTableV6: compressed data cannot be read by C evio lib");
-            return (S_EVFILE_BADFILE);
-        }
-
-        if (indexLen % 4 != 0 || (indexLen != 4*recordEventCount)) {
-            printf("generatePointerTableV6: index array has bad size");
-            return (S_EVFILE_BADFILE);
-        }
-
-        // Need more space for the table, increase by 10,000 pointers each time
-        if (evIndex + recordEventCount >= numPointers) {
-            uint32_t** old_pTable = a->pTable;
-            numPointers += 10000 + recordEventCount;
-            a->pTable = realloc(a->pTable, numPointers*sizeof(uint32_t *));
-            if (a->pTable == NULL) {
-                free(old_pTable);
-                return(S_EVFILE_ALLOCFAIL);
-            }
-        }
-
-        // Hop over record header
-        pmem += recordHdrSize;
-        bytesLeft -= 4 * recordHdrSize;
-
-        // If there's an index of event lengths, use that.
-        // There should always be one, but in case there isn't.
-        if (indexLen > 0) {
-            // Create pointer to start of first event
-            uint32_t  *pevent = pmem + (indexLen + usrHdrLen)/4;
-            int j;
+    indexLen = trailer[EV_HD_INDEXARRAYLEN];
+    if (trailer[EV_HD_MAGIC] != EV_MAGIC || indexLen == 0 || indexLen % 8 != 0) {
+        return(S_FAILURE);
+    }
 
-            // For each event in block, store its location
-            for (j=0; j < (int)recordEventCount; j++) {
-                uint32_t eventByteLen = pmem[j];
-                if (a->byte_swapped) {
-                    eventByteLen = EVIO_SWAP32(eventByteLen);
-                }
+    /* Index is pairs of record length in bytes and event count */
+    index = (uint32_t *) malloc(indexLen);
+    if (index == NULL) return(S_EVFILE_ALLOCFAIL);
 
-                a->pTable[evIndex++] = pevent;
-                pevent += eventByteLen/4;
-            }
+    if (fseek(a->file, trailerPos + 4*trailer[EV_HD_HDSIZ], SEEK_SET) < 0 ||
+        fread(index, 1, indexLen, a->file) != indexLen) {
+        clearerr(a->file);
+        free(index);
+        return(S_FAILURE);
+    }
+    if (a->byte_swapped) {
+        swap_int32_t(index, indexLen/4, NULL);
+    }
 
-            // Hop over index and user header
-            pmem = pevent;
-            bytesLeft -= indexLen + usrHdrLen;
-        }
-        else {
-            // Else hop through record event by event.
-            // Start by hopping over user header
-            pmem += usrHdrLen/4;
-
-            for (i=0; i < (int)recordEventCount; i++) {
-                // Sanity check - must have at least 2 ints left
-                if (bytesLeft < 8) {
-                    free(a->pTable);
-                    return(S_EVFILE_UNXPTDEOF);
-                }
+    for (i=0; i < indexLen/4; i += 2) {
+        if (index[i] % 4 != 0 || pos + index[i] > trailerPos) break;
+        pos    += index[i];
+        events += index[i+1];
+    }
+    free(index);
 
-                // Bank's length is first word of bank
-                uint32_t eventWordLen = *pmem;
-                if (a->byte_swapped) {
-                    eventWordLen = EVIO_SWAP32(eventWordLen);
-                }
+    /* Records must end right where the trailer starts */
+    if (pos != trailerPos) {
+        return(S_FAILURE);
+    }
 
-                // Bank's len does not include itself
-                eventWordLen++;
-                a->pTable[evIndex++] = pmem;
+    /* Remove the trailer */
+    fflush(a->file);
+    if (ftruncate(fileno(a->file), (off_t)trailerPos) < 0) return(errno);
 
-                pmem += eventWordLen;
-                bytesLeft -= 4*eventWordLen;
-            }
-        }
-    }
+    /* File header must no longer point to it */
+    if (fseek(a->file, 4*EV_HD_TRAILERPOS, SEEK_SET) < 0) return(errno);
+    if (fwrite(&zero, 1, sizeof(zero), a->file) != sizeof(zero)) return(errno);
 
-    a->eventCount = evIndex;
+    if (fseek(a->file, trailerPos, SEEK_SET) < 0) return(errno);
 
+    a->eventCount += events;
+    *recordCount = indexLen/8;
     return(S_SUCCESS);
 }
 
@@ -3952,33 +4840,50 @@ static int toAppendPosition(EVFILE *a) {
             return (errno);
         }
 
-        /* Read in 8 words of file header */
-        nBytes = (int64_t)(fread(header, 1, EV_HDSIZ_BYTES, a->file));
-        if (nBytes != EV_HDSIZ_BYTES) {
+        /* Read in the file header, including the trailer position */
+        uint32_t fileHeader[EV_HDSIZ_V6];
+        nBytes = (int64_t)(fread(fileHeader, 1, EV_HDSIZ_BYTES_V6, a->file));
+        if (nBytes != EV_HDSIZ_BYTES_V6) {
             return(S_EVFILE_BADFILE);
         }
 
         // We already read in part of this before so we know version and endianness
         if (a->byte_swapped) {
-            swap_int32_t(header, EV_HDSIZ_BYTES / 4, NULL);
+            evioSwapFileHeaderV6(fileHeader);
         }
 
         // Size info from file header
-        uint32_t indexLen = header[EV_HD_INDEXARRAYLEN];
-        uint32_t userHeaderLen = header[EV_HD_USERHDRLEN];
+        uint32_t indexLen = fileHeader[EV_HD_INDEXARRAYLEN];
+        uint32_t userHeaderLen = fileHeader[EV_HD_USERHDRLEN];
 
         // Skip over file's header (including those of unusual size)
-        uint32_t actualHeaderBytes = 4*header[EV_HD_HDSIZ];
+        uint32_t actualHeaderBytes = 4*fileHeader[EV_HD_HDSIZ];
         // Skip over file's index array, user header and user header's padding
-        int padding = getPad1(header[EV_HD_VER]);
+        int padding = getPad1(fileHeader[EV_HD_VER]);
         long skipBytes = actualHeaderBytes + indexLen + userHeaderLen + padding;
 
-        if (fseek(a->file, skipBytes, SEEK_SET) < 0) {
+        // Jump straight to the end if the trailer has an index of all records
+        uint64_t trailerPos = evioToLongWord(fileHeader[EV_HD_TRAILERPOS],
+                                             fileHeader[EV_HD_TRAILERPOS + 1], 0);
+        if (trailerPos > 0) {
+            uint32_t recordCount = 0;
+            int err = appendAtTrailerV6(a, skipBytes, trailerPos, &recordCount);
+            if (err == S_SUCCESS) {
+                /* Same state as running into EOF right after the last record */
+                recordNumber += recordCount + 1;
+                readEOF = 1;
+            }
+            else if (err != S_FAILURE) {
+                return(err);
+            }
+        }
+
+        if (!readEOF && fseek(a->file, skipBytes, SEEK_SET) < 0) {
             return (errno);
         }
     }
 
-    while (1) {
+    while (!readEOF) {
         /* Read in EV_HDSIZ (8) ints of header. Even though the version 6 header is 14 words,
          * all the data we need is in the first 8. */
         if (usingBuffer) {
@@ -4535,6 +5440,7 @@ static int evReadFileV3(EVFILE *a, uint32_t *buffer, uint32_t buflen)
 {
     int       status,  swap;
     uint32_t  nleft, ncopy;
+    uint32_t *event = buffer;
 
     /* If no more data left to read from current BLOCK, get a new block */
     if (a->left < 1) {
@@ -4590,7 +5496,7 @@ static int evReadFileV3(EVFILE *a, uint32_t *buffer, uint32_t buflen)
     
     /* Swap event if necessary */
     if (swap) {
-        evioswap(buffer, 1, NULL);
+        evioswap(event, 1, NULL);
     }
 
     return(S_SUCCESS);
@@ -4624,8 +5530,9 @@ int evRead(int handle, uint32_t *buffer, uint32_t buflen)
     EVFILE   *a;
     int       status,  swap;
     uint32_t  nleft, ncopy;
+    uint32_t *event = buffer;
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -4637,7 +5544,7 @@ int evRead(int handle, uint32_t *buffer, uint32_t buflen)
     handleLock(handle);
 
     /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL) {
@@ -4733,7 +5640,7 @@ int evRead(int handle, uint32_t *buffer, uint32_t buflen)
 
     /* Swap event if necessary */
     if (swap) {
-        evioswap(buffer, 1, NULL);
+        evioswap(event, 1, NULL);
     }
 
 //    {
@@ -4779,7 +5686,7 @@ int evReadAlloc(int handle, uint32_t **buffer, uint32_t *buflen)
     int status;
 
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -4787,7 +5694,7 @@ int evReadAlloc(int handle, uint32_t **buffer, uint32_t *buflen)
     handleLock(handle);
 
     /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     if (a == NULL) {
         handleUnlock(handle);
@@ -4817,6 +5724,8 @@ int evReadAlloc(int handle, uint32_t **buffer, uint32_t *buflen)
  * @param buffer pointer to pointer to buffer gets filled with pointer to location in
  *               internal buffer which is guaranteed to be valid only until the next
  *               {@link #evRead}, {@link #evReadNoAlloc}, or {@link #evReadNoCopy} call.
+ *               When receiving a socket into a ring of buffers (see the "Q" request of
+ *               {@link #evIoctl}), it is instead valid until given to {@link #evReleaseEvent}.
  * @param buflen pointer to int gets filled with length of buffer in 32 bit words
  *               including the full (8 byte) bank header
  *
@@ -4839,7 +5748,7 @@ int evReadNoCopy(int handle, const uint32_t **buffer, uint32_t *buflen)
     uint32_t  nleft;
 
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
     
@@ -4851,7 +5760,7 @@ int evReadNoCopy(int handle, const uint32_t **buffer, uint32_t *buflen)
     handleLock(handle);
 
     /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL) {
@@ -4907,6 +5816,11 @@ int evReadNoCopy(int handle, const uint32_t **buffer, uint32_t *buflen)
 
     a->next += nleft;
     a->left -= nleft;
+
+    /* Event stays valid until released */
+    if (a->sockRing != NULL) {
+        holdRingBuffer(a);
+    }
     
     handleUnlock(handle);
 
@@ -4914,6 +5828,70 @@ int evReadNoCopy(int handle, const uint32_t **buffer, uint32_t *buflen)
 }
 
 
+/**
+ * This routine releases an event obtained with {@link #evReadNoCopy} from a socket
+ * whose blocks are received into a ring of buffers (see the "Q" request of
+ * {@link #evIoctl}). A buffer is given back to be filled again once its block has
+ * been read and all the events taken from it have been released, so every such event
+ * must be released or receiving stops once the ring is full. Any thread may release
+ * events, even while another is blocked reading, but not after the handle is closed.
+ * When not using a ring, nothing is done.
+ *
+ * @param handle evio handle
+ * @param event  pointer to event returned by {@link #evReadNoCopy}
+ *
+ * @return S_SUCCESS          if successful, or event not found in ring
+ * @return S_EVFILE_BADARG    if event is NULL
+ * @return S_EVFILE_BADHANDLE if bad handle arg
+ */
+int evReleaseEvent(int handle, const uint32_t *event)
+{
+    EVFILE        *a;
+    evSockRing    *r;
+    evSockRingBuf *b;
+    uint32_t       i;
+
+
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
+        return(S_EVFILE_BADHANDLE);
+    }
+
+    if (event == NULL) {
+        return(S_EVFILE_BADARG);
+    }
+
+    /* No handle lock, since the reading thread may hold it while waiting for a buffer */
+    a = getHandle(handle);
+    if (a == NULL) {
+        return(S_EVFILE_BADHANDLE);
+    }
+
+    r = a->sockRing;
+    if (r == NULL) {
+        return(S_SUCCESS);
+    }
+
+    pthread_mutex_lock(&r->mutex);
+    for (i=0; i < r->count; i++) {
+        b = &r->bufs[i];
+        if (b->state != EV_RING_READING && b->state != EV_RING_HELD) continue;
+
+        if ((event >= b->buf && event < b->buf + b->bufSize) ||
+            (b->uncompBuf != NULL && event >= b->uncompBuf && event < b->uncompBuf + b->uncompBufSize/4)) {
+            if (b->holds > 0) b->holds--;
+            if (b->holds == 0 && b->state == EV_RING_HELD) {
+                b->state = EV_RING_FREE;
+                pthread_cond_broadcast(&r->cond);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&r->mutex);
+
+    return(S_SUCCESS);
+}
+
+
 /**
  * This routine does a random access read from an evio format file/buffer opened
  * with routines {@link #evOpen} or {@link #evOpenBuffer}. It returns a
@@ -4951,73 +5929,421 @@ int evReadRandom(int handle, const uint32_t **pEvent, uint32_t *buflen, uint32_t
         return(S_EVFILE_BADARG);
     }
 
-    if (handle < 1 || (size_t)handle > handleCount) {
-        return(S_EVFILE_BADHANDLE);
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
+        return(S_EVFILE_BADHANDLE);
+    }
+
+    /* For thread-safe function calls */
+    handleLock(handle);
+
+    /* Look up file struct (which contains block buffer) from handle */
+    a = getHandle(handle);
+
+    /* Check args */
+    if (a == NULL) {
+        handleUnlock(handle);
+        return(S_EVFILE_BADHANDLE);
+    }
+
+    /* Returning a pointer into a block only works in evio version 4 and
+    * up since in earlier versions events may be split between blocks. */
+    if (a->version < 4) {
+        handleUnlock(handle);
+        return(S_EVFILE_BADFILE);
+    }
+
+    /* Need to be *** random access *** reading (not from socket or pipe) and not writing */
+    if ((a->rw != EV_READFILE && a->rw != EV_READBUF) || !a->randomAccess) {
+        handleUnlock(handle);
+        return(S_EVFILE_BADMODE);
+    }
+
+    /* event not in file/buf */
+    if (eventNumber < 1 || eventNumber > a->eventCount || a->pTable == NULL) {
+        handleUnlock(handle);
+        return(S_FAILURE);
+    }
+
+    /* Version 6 finds the events of a record the first time one is asked for */
+    if (a->version > 4) {
+        int err = findEventV6(a, eventNumber - 1);
+        if (err != S_SUCCESS) {
+            handleUnlock(handle);
+            return(err);
+        }
+    }
+
+    pev = a->pTable[eventNumber - 1];
+
+    /* event not in file/buf */
+    if (pev == NULL) {
+        handleUnlock(handle);
+        return(S_FAILURE);
+    }
+
+    /* Find number of words to read in next event (including header) */
+    /* and swap data in buf/mem-map if necessary */
+    if (a->byte_swapped) {
+        /* Length of bank, including header, in 32 bit words */
+        *buflen = EVIO_SWAP32(*pev) + 1;
+                        
+        /* swap data in buf/mem-map buffer */
+        evioswap(pev, 1, NULL);
+    }
+    else {
+        /* Length of bank, including header, in 32 bit words */
+        *buflen = *pev + 1;
+    }
+
+    /* return pointer to event in memory map / buffer */
+    *pEvent = pev;
+
+    handleUnlock(handle);
+
+    return(S_SUCCESS);
+}
+
+
+/** @} */
+
+
+/**
+ * Routine to read bytes from the socket of a handle in socket ring mode.
+ *
+ * @param a     pointer to handle structure
+ * @param dest  where the bytes go
+ * @param bytes number of bytes to read
+ * @param first 1 if these are the first bytes of a block, else 0
+ *
+ * @return S_SUCCESS          if successful
+ * @return EOF                if other end closed the socket between blocks
+ * @return S_EVFILE_UNXPTDEOF if other end closed the socket within a block
+ * @return errno              if socket read error
+ */
+static int ringRead(EVFILE *a, void *dest, uint32_t bytes, int first)
+{
+    int n = tcpRead(a->sockFd, dest, (int)bytes);
+    if (n == (int)bytes) return(S_SUCCESS);
+    if (n < 0)   return(errno);
+    if (n == 0 && first) return(EOF);
+    return(S_EVFILE_UNXPTDEOF);
+}
+
+
+/**
+ * Routine to receive the next block from the socket of a handle into a ring buffer,
+ * which is enlarged if needed. The block header is swapped if necessary, just as
+ * {@link #evGetNewBuffer} does.
+ *
+ * @param a pointer to handle structure
+ * @param b buffer to fill
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ * @return S_EVFILE_BADFILE   if bad block header
+ * @return EOF                if other end closed the socket between blocks
+ * @return S_EVFILE_UNXPTDEOF if other end closed the socket within a block
+ * @return errno              if socket read error
+ */
+static int fillRingBuffer(EVFILE *a, evSockRingBuf *b)
+{
+    uint32_t *newBuf, blkHdrSize, blkSize;
+    uint32_t headerWords = (a->version > 4) ? EV_HDSIZ_V6 : EV_HDSIZ;
+    int status;
+
+    status = ringRead(a, b->buf, 4*headerWords, 1);
+    if (status != S_SUCCESS) return(status);
+
+    if (a->byte_swapped) {
+        swap_int32_t(b->buf, headerWords, NULL);
+    }
+
+    blkHdrSize = b->buf[EV_HD_HDSIZ];
+    blkSize    = b->buf[EV_HD_BLKSIZ];
+    if (blkHdrSize < headerWords || blkSize < blkHdrSize) {
+        return(S_EVFILE_BADFILE);
+    }
+
+    /* Nothing points into a buffer being filled, so it may be replaced */
+    if (b->bufSize < blkSize) {
+        newBuf = (uint32_t *)malloc(4*blkSize);
+        if (newBuf == NULL) {
+            return(S_EVFILE_ALLOCFAIL);
+        }
+        memcpy((void *)newBuf, (void *)b->buf, 4*headerWords);
+        free(b->buf);
+        b->buf = newBuf;
+        b->bufSize = blkSize;
+    }
+
+    /* Any extra header words (see evGetNewBuffer) */
+    if (blkHdrSize > headerWords) {
+        status = ringRead(a, b->buf + headerWords, 4*(blkHdrSize - headerWords), 0);
+        if (status != S_SUCCESS) return(status);
+        if (a->byte_swapped) {
+            swap_int32_t(b->buf + headerWords, blkHdrSize - headerWords, NULL);
+        }
+    }
+
+    return(ringRead(a, b->buf + blkHdrSize, 4*(blkSize - blkHdrSize), 0));
+}
+
+
+/**
+ * Thread routine which receives blocks from the socket of a handle into the free
+ * buffers of its ring one after the other, until the last block, the end of the
+ * stream, an error, or being told to stop.
+ *
+ * @param arg pointer to handle structure.
+ * @return NULL
+ */
+static void *socketRingThread(void *arg)
+{
+    EVFILE *a = (EVFILE *)arg;
+    evSockRing *r = a->sockRing;
+    evSockRingBuf *b;
+    int status, last;
+
+    while (1) {
+        pthread_mutex_lock(&r->mutex);
+        b = &r->bufs[r->fillIndex];
+        while (!r->stop && b->state != EV_RING_FREE) {
+            pthread_cond_wait(&r->cond, &r->mutex);
+        }
+        if (r->stop) {
+            r->status = S_FAILURE;
+            pthread_mutex_unlock(&r->mutex);
+            break;
+        }
+        b->state = EV_RING_FILLING;
+        r->receiving = 1;
+        pthread_mutex_unlock(&r->mutex);
+
+        status = fillRingBuffer(a, b);
+        last = (status == S_SUCCESS) &&
+               ((a->version == 4 && isLastBlock(b->buf)) ||
+                (a->version > 4  && isLastBlock_V6(b->buf)));
+
+        pthread_mutex_lock(&r->mutex);
+        r->receiving = 0;
+        if (status == S_SUCCESS) {
+            b->state = EV_RING_FILLED;
+            r->fillIndex = (r->fillIndex + 1) % r->count;
+            /* Reader finds out about the last block from its header */
+            if (last) r->status = EOF;
+        }
+        else {
+            b->state = EV_RING_FREE;
+            r->status = r->stop ? S_FAILURE : status;
+        }
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->mutex);
+
+        if (status != S_SUCCESS || last) break;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Routine to start receiving the blocks of a handle reading from a socket into a ring of
+ * buffers in another thread. It may be done at any time, the events of the block being
+ * read when it starts remaining valid until the handle is closed.
+ *
+ * @param a     pointer to handle structure
+ * @param count number of buffers in ring
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_FAILURE          if thread cannot be started
+ * @return S_EVFILE_BADMODE   if not reading from a socket, version < 4, or ring already started
+ * @return S_EVFILE_BADSIZEREQ if count < 1
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ */
+static int startSocketRing(EVFILE *a, uint32_t count)
+{
+    evSockRing *r;
+    uint32_t i;
+
+    if (a->rw != EV_READSOCK || a->version < 4 || a->sockRing != NULL) {
+        return(S_EVFILE_BADMODE);
+    }
+    if (count < 1) {
+        return(S_EVFILE_BADSIZEREQ);
+    }
+
+    r = (evSockRing *) calloc(1, sizeof(evSockRing));
+    if (r == NULL) {
+        return(S_EVFILE_ALLOCFAIL);
+    }
+    r->bufs = (evSockRingBuf *) calloc(count, sizeof(evSockRingBuf));
+    if (r->bufs == NULL) {
+        free(r);
+        return(S_EVFILE_ALLOCFAIL);
+    }
+    r->count = count;
+    for (i=0; i < count; i++) {
+        r->bufs[i].bufSize = a->bufSize;
+        r->bufs[i].buf = (uint32_t *)malloc(4*a->bufSize);
+        if (r->bufs[i].buf == NULL) {
+            while (i > 0) free(r->bufs[--i].buf);
+            free(r->bufs);
+            free(r);
+            return(S_EVFILE_ALLOCFAIL);
+        }
+        r->bufs[i].state = EV_RING_FREE;
+    }
+
+    pthread_mutex_init(&r->mutex, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    r->current = -1;
+    r->status  = S_SUCCESS;
+    r->ownBuf  = a->buf;
+    r->ownBufSize = a->bufSize;
+    r->ownUncompBuf = a->uncompBuf;
+    r->ownUncompBufSize = a->uncompBufSize;
+    a->sockRing = r;
+
+    /* Nothing more to receive if the last block has been read */
+    if (a->isLastBlock) {
+        r->status = EOF;
+        return(S_SUCCESS);
+    }
+
+    if (pthread_create(&r->thread, NULL, socketRingThread, (void *)a) != 0) {
+        a->sockRing = NULL;
+        pthread_mutex_destroy(&r->mutex);
+        pthread_cond_destroy(&r->cond);
+        for (i=0; i < count; i++) free(r->bufs[i].buf);
+        free(r->bufs);
+        free(r);
+        return(S_FAILURE);
     }
+    r->started = 1;
 
-    /* For thread-safe function calls */
-    handleLock(handle);
+    return(S_SUCCESS);
+}
 
-    /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle-1];
 
-    /* Check args */
-    if (a == NULL) {
-        handleUnlock(handle);
-        return(S_EVFILE_BADHANDLE);
-    }
+/**
+ * Routine to stop the thread receiving blocks into the ring of a handle, if any,
+ * and free the ring. If the thread is waiting on the socket, the socket is shut
+ * down for reading. The handle gets its own buffers back.
+ *
+ * @param a pointer to handle structure
+ */
+static void stopSocketRing(EVFILE *a)
+{
+    evSockRing *r = a->sockRing;
+    uint32_t i;
 
-    /* Returning a pointer into a block only works in evio version 4 and
-    * up since in earlier versions events may be split between blocks. */
-    if (a->version < 4) {
-        handleUnlock(handle);
-        return(S_EVFILE_BADFILE);
+    if (r == NULL) return;
+
+    pthread_mutex_lock(&r->mutex);
+    r->stop = 1;
+    if (r->receiving) {
+        shutdown(a->sockFd, SHUT_RD);
     }
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->mutex);
 
-    /* Need to be *** random access *** reading (not from socket or pipe) and not writing */
-    if ((a->rw != EV_READFILE && a->rw != EV_READBUF) || !a->randomAccess) {
-        handleUnlock(handle);
-        return(S_EVFILE_BADMODE);
+    if (r->started) {
+        pthread_join(r->thread, NULL);
     }
 
-    /* event not in file/buf */
-    if (eventNumber > a->eventCount || a->pTable == NULL) {
-        handleUnlock(handle);
-        return(S_FAILURE);
+    a->buf = r->ownBuf;
+    a->bufSize = r->ownBufSize;
+    a->uncompBuf = r->ownUncompBuf;
+    a->uncompBufSize = r->ownUncompBufSize;
+    a->sockRing = NULL;
+
+    for (i=0; i < r->count; i++) {
+        free(r->bufs[i].buf);
+        if (r->bufs[i].uncompBuf != NULL) free(r->bufs[i].uncompBuf);
     }
+    pthread_mutex_destroy(&r->mutex);
+    pthread_cond_destroy(&r->cond);
+    free(r->bufs);
+    free(r);
+}
 
-    pev = a->pTable[eventNumber - 1];
 
-    /* event not in file/buf */
-    if (pev == NULL) {
-        handleUnlock(handle);
-        return(S_FAILURE);
+/**
+ * Routine to get the next block of a handle from its ring of socket receive buffers,
+ * waiting for it to be received if necessary. The buffer of the block read until now
+ * goes back to be filled again unless some of its events have not been released.
+ *
+ * @param a pointer to handle structure
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ * @return S_EVFILE_BADFILE   if bad block header, or compressed data cannot be uncompressed
+ * @return S_EVFILE_UNXPTDEOF if unexpected end of stream
+ * @return EOF                if end of stream
+ * @return errno              if socket read error
+ */
+static int getRingBuffer(EVFILE *a)
+{
+    evSockRing *r = a->sockRing;
+    evSockRingBuf *b;
+    int status;
+
+    pthread_mutex_lock(&r->mutex);
+
+    if (r->current >= 0) {
+        b = &r->bufs[r->current];
+        b->state = (b->holds > 0) ? EV_RING_HELD : EV_RING_FREE;
+        r->current = -1;
+        pthread_cond_broadcast(&r->cond);
     }
 
-    /* Find number of words to read in next event (including header) */
-    /* and swap data in buf/mem-map if necessary */
-    if (a->byte_swapped) {
-        /* Length of bank, including header, in 32 bit words */
-        *buflen = EVIO_SWAP32(*pev) + 1;
-                        
-        /* swap data in buf/mem-map buffer */
-        evioswap(pev, 1, NULL);
+    b = &r->bufs[r->readIndex];
+    while (b->state != EV_RING_FILLED && r->status == S_SUCCESS) {
+        pthread_cond_wait(&r->cond, &r->mutex);
     }
-    else {
-        /* Length of bank, including header, in 32 bit words */
-        *buflen = *pev + 1;
+    if (b->state != EV_RING_FILLED) {
+        status = r->status;
+        pthread_mutex_unlock(&r->mutex);
+        return(status);
     }
 
-    /* return pointer to event in memory map / buffer */
-    *pEvent = pev;
+    b->state = EV_RING_READING;
+    r->current = (int)r->readIndex;
+    r->readIndex = (r->readIndex + 1) % r->count;
+    pthread_mutex_unlock(&r->mutex);
 
-    handleUnlock(handle);
+    /* Each buffer keeps its own uncompressed data so its events stay valid while held */
+    a->buf = b->buf;
+    a->bufSize = b->bufSize;
+    a->uncompBuf = b->uncompBuf;
+    a->uncompBufSize = b->uncompBufSize;
 
-    return(S_SUCCESS);
+    status = evPrepareNewBuffer(a);
+
+    pthread_mutex_lock(&r->mutex);
+    b->uncompBuf = a->uncompBuf;
+    b->uncompBufSize = a->uncompBufSize;
+    pthread_mutex_unlock(&r->mutex);
+
+    return(status);
 }
 
 
-/** @} */
+/**
+ * Routine to keep the ring buffer holding the block being read from being filled again
+ * until one more of its events is released with {@link #evReleaseEvent}.
+ * @param a pointer to handle structure
+ */
+static void holdRingBuffer(EVFILE *a)
+{
+    evSockRing *r = a->sockRing;
+
+    pthread_mutex_lock(&r->mutex);
+    if (r->current >= 0) {
+        r->bufs[r->current].holds++;
+    }
+    pthread_mutex_unlock(&r->mutex);
+}
 
 
 /**
@@ -5039,7 +6365,6 @@ static int evGetNewBuffer(EVFILE *a)
     uint32_t *newBuf, blkHdrSize, headerBytes, headerWords;
     size_t    nBytes=0, bytesToRead;
     const int debug=0;
-    int status = S_SUCCESS;
 
     assert(a != NULL && a->buf != NULL);       /* else internal error */
 
@@ -5048,6 +6373,11 @@ static int evGetNewBuffer(EVFILE *a)
         return(EOF);
     }
 
+    /* Block may already have been received by another thread */
+    if (a->sockRing != NULL) {
+        return(getRingBuffer(a));
+    }
+
     /* First read block header from file/sock/buf */
     if (a->version > 4) {
         // Bigger header in evio 6
@@ -5179,7 +6509,7 @@ if (debug) printf("HEADER IS TOO BIG, reading an extra %lu bytes\n", bytesToRead
     else if (a->rw == EV_READSOCK) {
         nBytes = (size_t) tcpRead(a->sockFd, (a->buf + blkHdrSize), (int) bytesToRead);
     }
-    else if (a->rw == EV_READSOCK) {
+    else if (a->rw == EV_READPIPE) {
         nBytes = fread((a->buf + blkHdrSize), 1, bytesToRead, a->file);
     }
     else if (a->rw == EV_READBUF) {
@@ -5191,66 +6521,523 @@ if (debug) printf("HEADER IS TOO BIG, reading an extra %lu bytes\n", bytesToRead
         a->rwBytesIn += bytesToRead;
     }
 
-    /* Return any read error */
-    if (nBytes != bytesToRead) {
-        return(errno);
+    /* Return any read error */
+    if (nBytes != bytesToRead) {
+        return(errno);
+    }
+
+    return(evPrepareNewBuffer(a));
+}
+
+
+/**
+ * Routine to get ready to read the events of the block which has just been read into a->buf,
+ * whose header has already been swapped if necessary. It does the block bookkeeping, finds
+ * whether it's the last block, uncompresses its data if needed (v6), and sets a->next and
+ * a->left to the first event and the number of words of events.
+ *
+ * @param a pointer to file structure
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ * @return S_EVFILE_BADFILE   if compressed data cannot be uncompressed
+ * @return S_EVFILE_UNXPTDEOF if block has no events and is not the last one
+ * @return EOF                if last block has no events
+ */
+static int evPrepareNewBuffer(EVFILE *a)
+{
+    uint32_t blkHdrSize = a->buf[EV_HD_HDSIZ];
+    int status = S_SUCCESS;
+
+    a->blksiz = a->buf[EV_HD_BLKSIZ];
+
+    /* Keep track of the # of blocks read */
+    a->blknum++;
+    
+    /* Is our block # consistent with block header's? */
+    if (a->buf[EV_HD_BLKNUM] != a->blknum + a->blkNumDiff) {
+        /* Record the difference so we don't print out a message
+        * every single time if things get out of sync. */
+        a->blkNumDiff = a->buf[EV_HD_BLKNUM] - a->blknum;
+#ifdef DEBUG
+        fprintf(stderr,"evGetNewBuffer: block # read(%d) is different than expected(%d)\n",
+                a->buf[EV_HD_BLKNUM], a->blknum);
+#endif
+    }
+
+    /* Check to see if we just read in the last block (v4,6) */
+    if ( (a->version == 4 && isLastBlock(a->buf)) ||
+         (a->version > 4 && isLastBlock_V6(a->buf))) {
+        a->isLastBlock = 1;
+    }
+
+    /* Start out pointing to the data right after the block header.
+     * If we're in the middle of reading an event, this will allow
+     * us to continue reading it. If we've looking to read a new
+     * event, this should point to the next one. */
+
+    // Additional words after header, to get to data, evio 6
+    uint32_t additionalHeaderWordsV6 = 0;
+
+    if (a->version > 4 && isCompressed(a->buf[EV_HD_COMPDATALEN])) {
+        // Events are read from the uncompressed copy of the record's data
+        status = uncompressRecordV6(a, a->buf + blkHdrSize);
+        if (status != S_SUCCESS) {
+            return(status);
+        }
+    }
+    else {
+        if (a->version > 4) {
+            // Need to hop over index and user header and user header's padding besides the header
+            uint32_t indexLen = a->buf[EV_HD_INDEXARRAYLEN];
+            uint32_t userHeaderLen = a->buf[EV_HD_USERHDRLEN];
+            int padding = getPad1(a->buf[EV_HD_VER]);
+            additionalHeaderWordsV6 = (indexLen + userHeaderLen + padding)/4;
+        }
+        a->next = a->buf + blkHdrSize + additionalHeaderWordsV6;
+
+        /* Find number of valid words left to read (w/ evRead) in block */
+        if (a->version < 4) {
+            a->left = (a->buf)[EV_HD_USED] - blkHdrSize;
+        }
+        else {
+            a->left = a->blksiz - blkHdrSize - additionalHeaderWordsV6;
+        }
+    }
+
+    /* If there are no valid data left in block ... */
+    if (a->left < 1) {
+        /* Hit end of valid data in file/sock/buf in v4 */
+        if (a->isLastBlock) {
+            return(EOF);
+        }
+        return(S_EVFILE_UNXPTDEOF);
+    }
+
+    return(status);
+}
+
+
+/**
+ * Routine to uncompress the data of an evio version 6 record, whose header is in a->buf,
+ * into a->uncompBuf which is enlarged as needed and kept for the following records.
+ * This data is the record's index array, user header and events, so a->next is set to
+ * point to the first event in a->uncompBuf and a->left to the number of event words.
+ * Thus pointers given out by evReadNoCopy point into a->uncompBuf and, just as with
+ * uncompressed records, are valid until the next record is read.
+ * LZ4 and gzip compressed records can be read.
+ *
+ * @param a    pointer to handle structure
+ * @param data pointer to compressed data
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ * @return S_EVFILE_BADFILE   if compression type unsupported or data cannot be uncompressed
+ */
+static int uncompressRecordV6(EVFILE *a, const uint32_t *data)
+{
+    uint32_t *header = a->buf;
+    uint32_t bitInfo = header[EV_HD_VER];
+    uint32_t compWord = header[EV_HD_COMPDATALEN];
+    int compType = (int) ((compWord >> 28) & 0xf);
+    uint32_t compBytes = 4*(compWord & 0x0fffffff) - getPad3(bitInfo);
+
+    /* Bytes before events (index, user header and its padding) and of events */
+    uint32_t skipBytes  = header[EV_HD_INDEXARRAYLEN] + header[EV_HD_USERHDRLEN] + getPad1(bitInfo);
+    uint32_t eventBytes = header[EV_HD_UNCOMPDATALEN];
+    uint32_t totalBytes = skipBytes + eventBytes + getPad2(bitInfo);
+    uint32_t uncompBytes;
+
+    if (a->uncompBufSize < totalBytes) {
+        if (a->uncompBuf != NULL) free((void *)a->uncompBuf);
+        a->uncompBuf = (uint32_t *) malloc(totalBytes);
+        if (a->uncompBuf == NULL) {
+            a->uncompBufSize = 0;
+            return(S_EVFILE_ALLOCFAIL);
+        }
+        a->uncompBufSize = totalBytes;
+    }
+
+    if (compType == 1 || compType == 2) {
+        /* LZ4 fastest or best */
+        int bytes = LZ4_decompress_safe((const char *)data, (char *)a->uncompBuf,
+                                        (int)compBytes, (int)totalBytes);
+        if (bytes < 0) {
+            return(S_EVFILE_BADFILE);
+        }
+        uncompBytes = (uint32_t) bytes;
+    }
+    else if (compType == 3) {
+        /* gzip */
+        int err;
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+
+        /* 16 more bits of window means gzip, not zlib, format */
+        if (inflateInit2(&strm, 15 + 16) != Z_OK) {
+            return(S_EVFILE_BADFILE);
+        }
+        strm.next_in   = (Bytef *)data;
+        strm.avail_in  = compBytes;
+        strm.next_out  = (Bytef *)a->uncompBuf;
+        strm.avail_out = totalBytes;
+
+        err = inflate(&strm, Z_FINISH);
+        uncompBytes = (uint32_t) strm.total_out;
+        inflateEnd(&strm);
+
+        if (err != Z_STREAM_END) {
+            return(S_EVFILE_BADFILE);
+        }
+    }
+    else {
+        /* Zstandard is only handled by the C++ and Java libs */
+        return(S_EVFILE_BADFILE);
+    }
+
+    /* Writers need not compress the padding after the events */
+    if (uncompBytes < skipBytes + eventBytes) {
+        return(S_EVFILE_BADFILE);
+    }
+    if (uncompBytes < totalBytes) {
+        memset((char *)a->uncompBuf + uncompBytes, 0, totalBytes - uncompBytes);
+    }
+
+    a->next = a->uncompBuf + skipBytes/4;
+    a->left = (totalBytes - skipBytes)/4;
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * Routine to compress the index and events of a record handed to the compressor.
+ * If that doesn't make the record smaller, it's written as is.
+ * Called by compressing threads, or by the writer if there are none.
+ *
+ * @param type compression type, 1 = LZ4, 2 = LZ4 best, 3 = gzip
+ * @param r    record to compress
+ */
+static void compressRecord(int type, evCompRecord *r)
+{
+    const char *src = (const char *)(r->in + EV_HDSIZ_V6);
+    char *dest = (char *)(r->out + EV_HDSIZ_V6);
+    int srcBytes = (int)(r->inBytes - EV_HDSIZ_BYTES_V6);
+    /* Only of use if at least a word smaller */
+    int maxBytes = srcBytes - 4;
+    int bytes = 0;
+    uint32_t words, pad;
+
+    r->result = r->in;
+    r->resultBytes = r->inBytes;
+
+    if (maxBytes < 1) return;
+
+    if (type == 1) {
+        bytes = LZ4_compress_default(src, dest, srcBytes, maxBytes);
+    }
+    else if (type == 2) {
+        /* Same level as the C++ lib */
+        bytes = LZ4_compress_HC(src, dest, srcBytes, maxBytes, 1);
+    }
+    else if (type == 3) {
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+
+        /* 16 more bits of window means gzip, not zlib, format */
+        if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16,
+                         9, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return;
+        }
+        strm.next_in   = (Bytef *)src;
+        strm.avail_in  = (uInt)srcBytes;
+        strm.next_out  = (Bytef *)dest;
+        strm.avail_out = (uInt)maxBytes;
+
+        /* Anything but the end of stream means it didn't fit */
+        if (deflate(&strm, Z_FINISH) == Z_STREAM_END) {
+            bytes = (int)strm.total_out;
+        }
+        deflateEnd(&strm);
+    }
+
+    if (bytes < 1) return;
+
+    /* Compressed data is padded to a whole word */
+    words = (uint32_t)(bytes + 3)/4;
+    pad = 4*words - (uint32_t)bytes;
+    memset(dest + bytes, 0, pad);
+
+    memcpy(r->out, r->in, EV_HDSIZ_BYTES_V6);
+    r->out[EV_HD_BLKSIZ] = EV_HDSIZ_V6 + words;
+    r->out[EV_HD_VER] = (r->in[EV_HD_VER] & ~(0x3U << 24)) | (pad << 24);
+    r->out[EV_HD_COMPDATALEN] = ((uint32_t)type << 28) | words;
+
+    r->result = r->out;
+    r->resultBytes = 4*(EV_HDSIZ_V6 + words);
+}
+
+
+/**
+ * Routine run by each thread of a compressor. It takes the records handed out,
+ * oldest first, and compresses them until told to stop.
+ *
+ * @param arg pointer to compressor
+ * @return NULL
+ */
+static void *compressThread(void *arg)
+{
+    evCompressor *c = (evCompressor *)arg;
+    evCompRecord *r;
+
+    pthread_mutex_lock(&c->mutex);
+    while (1) {
+        while (!c->stop && c->takeSeq >= c->putSeq) {
+            pthread_cond_wait(&c->cond, &c->mutex);
+        }
+        if (c->stop) break;
+
+        r = &c->records[c->takeSeq++ % c->count];
+        pthread_mutex_unlock(&c->mutex);
+
+        compressRecord(c->type, r);
+
+        pthread_mutex_lock(&c->mutex);
+        r->done = 1;
+        pthread_cond_broadcast(&c->cond);
+    }
+    pthread_mutex_unlock(&c->mutex);
+
+    return NULL;
+}
+
+
+/**
+ * Routine to start compressing the records of a handle opened for writing, by the given
+ * number of threads. The ring holds twice as many records as threads so they stay busy
+ * while finished records wait their turn to be written. With no threads, each record is
+ * compressed by the writer when it's full. The record being filled must not yet hold
+ * any events.
+ *
+ * @param a           pointer to handle structure
+ * @param type        compression type, 1 = LZ4, 2 = LZ4 best, 3 = gzip
+ * @param threadCount number of compressing threads, 0 for none
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_FAILURE          if a thread cannot be started
+ * @return S_EVFILE_BADARG    if type unknown
+ * @return S_EVFILE_BADMODE   if not writing a file, socket or pipe in version 6,
+ *                            if appending, if events already written, or if already compressing
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ */
+static int startCompressor(EVFILE *a, int type, uint32_t threadCount)
+{
+    evCompressor *c;
+    uint32_t i;
+
+    if (type < 1 || type > 3) {
+        return(S_EVFILE_BADARG);
+    }
+    if ((a->rw != EV_WRITEFILE && a->rw != EV_WRITEPIPE && a->rw != EV_WRITESOCK) ||
+        a->version < 6 || a->append || a->compressor != NULL ||
+        a->blknum != 2 || a->blkEvCount != 0) {
+        return(S_EVFILE_BADMODE);
+    }
+
+    c = (evCompressor *) calloc(1, sizeof(evCompressor));
+    if (c == NULL) {
+        return(S_EVFILE_ALLOCFAIL);
+    }
+    c->count = threadCount > 0 ? 2*threadCount : 1;
+    c->records = (evCompRecord *) calloc(c->count, sizeof(evCompRecord));
+    if (threadCount > 0) {
+        c->threads = (pthread_t *) calloc(threadCount, sizeof(pthread_t));
+    }
+    if (c->records == NULL || (threadCount > 0 && c->threads == NULL)) {
+        if (c->records != NULL) free(c->records);
+        free(c);
+        return(S_EVFILE_ALLOCFAIL);
+    }
+    c->type = type;
+
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->cond, NULL);
+    a->compressor = c;
+
+    for (i=0; i < threadCount; i++) {
+        if (pthread_create(&c->threads[i], NULL, compressThread, (void *)c) != 0) {
+            stopCompressor(a);
+            return(S_FAILURE);
+        }
+        c->threadCount++;
+    }
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * Routine to stop the threads compressing the records of a handle, if any,
+ * and free the compressor. Records not yet written are dropped.
+ *
+ * @param a pointer to handle structure
+ */
+static void stopCompressor(EVFILE *a)
+{
+    evCompressor *c = a->compressor;
+    uint32_t i;
+
+    if (c == NULL) return;
+
+    pthread_mutex_lock(&c->mutex);
+    c->stop = 1;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->mutex);
+
+    for (i=0; i < c->threadCount; i++) {
+        pthread_join(c->threads[i], NULL);
     }
 
-    /* Keep track of the # of blocks read */
-    a->blknum++;
-    
-    /* Is our block # consistent with block header's? */
-    if (a->buf[EV_HD_BLKNUM] != a->blknum + a->blkNumDiff) {
-        /* Record the difference so we don't print out a message
-        * every single time if things get out of sync. */
-        a->blkNumDiff = a->buf[EV_HD_BLKNUM] - a->blknum;
-#ifdef DEBUG
-        fprintf(stderr,"evGetNewBuffer: block # read(%d) is different than expected(%d)\n",
-                a->buf[EV_HD_BLKNUM], a->blknum);
-#endif
+    for (i=0; i < c->count; i++) {
+        if (c->records[i].in  != NULL) free(c->records[i].in);
+        if (c->records[i].out != NULL) free(c->records[i].out);
     }
+    pthread_mutex_destroy(&c->mutex);
+    pthread_cond_destroy(&c->cond);
+    if (c->threads != NULL) free(c->threads);
+    free(c->records);
+    free(c);
 
-    /* Check to see if we just read in the last block (v4,6) */
-    if ( (a->version == 4 && isLastBlock(a->buf)) ||
-         (a->version > 4 && isLastBlock_V6(a->buf))) {
-        a->isLastBlock = 1;
+    a->compressor = NULL;
+    a->bytesPending = 0;
+}
+
+
+/**
+ * Routine to copy records finished by the compressor into the internal buffer,
+ * in the order they were written, stopping at the first one not yet done.
+ * Records before the given sequence are waited for. If the header of the record
+ * being filled is in the internal buffer, it's moved behind each record copied in
+ * so records stay in order.
+ *
+ * @param a        pointer to handle structure
+ * @param untilSeq sequence of first record not waited for,
+ *                 0 for none, UINT64_MAX for all
+ *
+ * @return S_SUCCESS if successful
+ * @return S_FAILURE if not enough room in internal buffer
+ */
+static int writeCompressedRecords(EVFILE *a, uint64_t untilSeq)
+{
+    evCompressor *c = a->compressor;
+    evCompRecord *r;
+
+    pthread_mutex_lock(&c->mutex);
+    while (c->writeSeq < c->putSeq) {
+        r = &c->records[c->writeSeq % c->count];
+        if (!r->done) {
+            if (c->writeSeq >= untilSeq) break;
+            pthread_cond_wait(&c->cond, &c->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&c->mutex);
+
+        /* Room was kept for the record before it was compressed */
+        if (4*a->bufSize - a->bytesToBuf < r->resultBytes) {
+            return(S_FAILURE);
+        }
+
+        /* The header being filled, if any, is the last thing in the buffer */
+        if (a->next != a->currentHeader) {
+            memmove(a->currentHeader + r->resultBytes/4, a->currentHeader, EV_HDSIZ_BYTES_V6);
+        }
+        memcpy(a->currentHeader, r->result, r->resultBytes);
+        a->currentHeader += r->resultBytes/4;
+        a->next += r->resultBytes/4;
+        a->left -= r->resultBytes/4;
+        a->bytesToBuf += r->resultBytes;
+        a->bytesPending -= r->inBytes;
+
+        pthread_mutex_lock(&c->mutex);
+        r->done = 0;
+        c->writeSeq++;
     }
+    pthread_mutex_unlock(&c->mutex);
 
-    /* Start out pointing to the data right after the block header.
-     * If we're in the middle of reading an event, this will allow
-     * us to continue reading it. If we've looking to read a new
-     * event, this should point to the next one. */
+    return(S_SUCCESS);
+}
 
-    // Additional words after header, to get to data, evio 6
-    uint32_t additionalHeaderWordsV6 = 0;
 
-    if (a->version > 4) {
-        // Need to hop over index and user header and user header's padding besides the header
-        uint32_t indexLen = a->buf[EV_HD_INDEXARRAYLEN];
-        uint32_t userHeaderLen = a->buf[EV_HD_USERHDRLEN];
-        int padding = getPad1(a->buf[EV_HD_VER]);
-        additionalHeaderWordsV6 = (indexLen + userHeaderLen + padding)/4;
+/**
+ * Routine to hand the record being written, whose header is the last thing in the
+ * internal buffer, to the compressor instead of copying its index and events after
+ * its header. The header is taken out of the internal buffer, so the next record's
+ * header is written in its place, and is put back in front of the compressed data
+ * once done. Until a new header is written, a->currentHeader equals a->next.
+ * The room the record takes until then is kept in a->bytesPending.
+ * Any records already compressed are copied into the internal buffer.
+ * If the ring is full, the oldest record is waited for.
+ *
+ * @param a pointer to handle structure
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_FAILURE          if not enough room in internal buffer
+ * @return S_EVFILE_ALLOCFAIL if memory cannot be allocated
+ */
+static int compressLater(EVFILE *a)
+{
+    evCompressor *c = a->compressor;
+    evCompRecord *r;
+    uint32_t recordBytes = EV_HDSIZ_BYTES_V6 + 4*(a->blkEvCount) + a->bytesToDataBuf;
+    int err;
+
+    /* Only this thread changes putSeq and writeSeq */
+    if (c->putSeq - c->writeSeq >= c->count) {
+        err = writeCompressedRecords(a, c->writeSeq + 1);
+        if (err != S_SUCCESS) return(err);
+    }
+
+    r = &c->records[c->putSeq % c->count];
+    if (r->size < recordBytes) {
+        if (r->in  != NULL) free(r->in);
+        if (r->out != NULL) free(r->out);
+        r->in  = (uint32_t *) malloc(recordBytes);
+        r->out = (uint32_t *) malloc(recordBytes);
+        if (r->in == NULL || r->out == NULL) {
+            if (r->in  != NULL) free(r->in);
+            if (r->out != NULL) free(r->out);
+            r->in = r->out = NULL;
+            r->size = 0;
+            return(S_EVFILE_ALLOCFAIL);
+        }
+        r->size = recordBytes;
     }
-    a->next = a->buf + blkHdrSize + additionalHeaderWordsV6;
 
-    /* Find number of valid words left to read (w/ evRead) in block */
-    if (a->version < 4) {
-        a->left = (a->buf)[EV_HD_USED] - blkHdrSize;
+    memcpy(r->in, a->currentHeader, EV_HDSIZ_BYTES_V6);
+    memcpy(r->in + EV_HDSIZ_V6, a->eventLengths, 4*(a->blkEvCount));
+    memcpy(r->in + EV_HDSIZ_V6 + a->blkEvCount, a->dataBuf, a->bytesToDataBuf);
+    r->inBytes = recordBytes;
+
+    /* Header no longer in internal buffer */
+    a->next = a->currentHeader;
+    a->left += EV_HDSIZ_V6;
+    a->bytesToBuf -= EV_HDSIZ_BYTES_V6;
+    a->bytesPending += recordBytes;
+
+    if (c->threadCount == 0) {
+        compressRecord(c->type, r);
+        r->done = 1;
+        c->putSeq++;
     }
     else {
-        a->left = a->blksiz - blkHdrSize - additionalHeaderWordsV6;
-    }
-
-    /* If there are no valid data left in block ... */
-    if (a->left < 1) {
-        /* Hit end of valid data in file/sock/buf in v4 */
-        if (a->isLastBlock) {
-            return(EOF);
-        }
-        return(S_EVFILE_UNXPTDEOF);
+        pthread_mutex_lock(&c->mutex);
+        r->done = 0;
+        c->putSeq++;
+        pthread_cond_broadcast(&c->cond);
+        pthread_mutex_unlock(&c->mutex);
     }
 
-    return(status);
+    return writeCompressedRecords(a, 0);
 }
 
 
@@ -5306,27 +7093,37 @@ static int writeNewHeader(EVFILE *a,
     // They are kept in a->eventLengths and a->dataBuf. Write these for the
     // previous record before writing the new record's header.
 
+    // When compressing, the previous record, if any, goes to the compressor instead
+    if (a->compressor != NULL) {
+        if (a->next != a->currentHeader) {
+            int err = compressLater(a);
+            if (err != S_SUCCESS) {
+                return (err);
+            }
+        }
+    }
     // If no room left for rest of current record ...
-    if ((a->bufSize - a->bytesToBuf/4) < (a->blkEvCount + a->bytesToDataBuf/4)) {
+    else if ((a->bufSize - a->bytesToBuf/4) < (a->blkEvCount + a->bytesToDataBuf/4)) {
         if (debug) printf("  writeNewHeaderV6: no room in buffer, return, buf size = %u - to buf (words) = %u <? %u\n",
                           a->bufSize, a->bytesToBuf/4, (a->blkEvCount + a->bytesToDataBuf/4));
         return (S_FAILURE);
     }
-
-    // Then write the index of events lengths
-    memcpy(a->buf + a->bytesToBuf/4, a->eventLengths, 4*(a->blkEvCount));
+    else {
+        // Then write the index of events lengths
+        memcpy(a->buf + a->bytesToBuf/4, a->eventLengths, 4*(a->blkEvCount));
 if (debug) printf("  writeNewHeaderV6: write index of byte len = %u, bytes past buf = %u\n",
                   4*(a->blkEvCount), a->bytesToBuf);
-    a->bytesToBuf += 4*(a->blkEvCount);
+        a->bytesToBuf += 4*(a->blkEvCount);
 if (debug) printf("  writeNewHeaderV6: reset bytes past buf = %u\n", a->bytesToBuf);
 
-    // Finally write the data
-    memcpy(a->buf + a->bytesToBuf/4, a->dataBuf, a->bytesToDataBuf);
-    a->bytesToBuf += a->bytesToDataBuf;
+        // Finally write the data
+        memcpy(a->buf + a->bytesToBuf/4, a->dataBuf, a->bytesToDataBuf);
+        a->bytesToBuf += a->bytesToDataBuf;
 if (debug) printf("  writeNewHeaderV6: copied data bytes = %u\n", a->bytesToDataBuf);
 
-    a->next += a->blkEvCount + a->bytesToDataBuf/4;
-    a->left -= a->blkEvCount + a->bytesToDataBuf/4;
+        a->next += a->blkEvCount + a->bytesToDataBuf/4;
+        a->left -= a->blkEvCount + a->bytesToDataBuf/4;
+    }
 
     /* If no room left for a header to be written in buffer ... */
     if ((a->bufSize - a->bytesToBuf/4) < EV_HDSIZ_V6) {
@@ -5643,6 +7440,17 @@ static void resetBufferV6(EVFILE *a) {
     /* Space in number of words, not in header, left for writing in block buffer */
     a->left = a->bufSize;
 
+    /* A file just split off starts with its own file header */
+    if (a->rw == EV_WRITEFILE && a->bytesToFile == 0) {
+        initFileHeader(a->buf);
+        a->next += EV_HDSIZ_V6;
+        a->left -= EV_HDSIZ_V6;
+        a->bytesToBuf = EV_HDSIZ_BYTES_V6;
+    }
+
+    /* No record header in the buffer yet */
+    a->currentHeader = a->next;
+
     /* Initialize block header as empty block and start writing after it.
      * No support for dictionaries in version 6 - too much hassle, use C++ lib. */
     writeNewHeader(a, 0, a->blknum++, 0, 0);
@@ -5721,7 +7529,7 @@ static int evWriteImpl(int handle, const uint32_t *buffer, int useMutex)
     int writeNewBlockHeader = 1, fileActuallySplit = 0;
     const int debug=0;
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
     
@@ -5733,7 +7541,7 @@ static int evWriteImpl(int handle, const uint32_t *buffer, int useMutex)
     if (useMutex) handleLock(handle);
 
     /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL) {
@@ -5761,6 +7569,9 @@ static int evWriteImpl(int handle, const uint32_t *buffer, int useMutex)
     // Amount of data and index not written yet into buf, but need to account for it
     uint32_t bytesCommittedToWrite = a->bytesToDataBuf + 4*(a->blkEvCount);
 
+    // Records being compressed will take no more room in buf than before
+    uint32_t bytesToBuf = a->bytesToBuf + a->bytesPending;
+
     if (debug && a->splitting) {
 printf("evWrite: splitting, bytesToFile = %llu, event bytes = %u, bytesToBuf = %u, split = %llu\n",
                a->bytesToFile, bytesToWrite, a->bytesToBuf, a->split);
@@ -5786,11 +7597,18 @@ printf("evWrite: too many events in block, already have %u\n", a->blkEvCount );
         }
     }
 
+    /* When writing through a memory map, flush each record as soon as it's full so
+     * its index and data are copied only once, straight from their own buffers into
+     * the map, instead of into the internal buffer first. */
+    if (a->mmapWrite && a->compressor == NULL && writeNewBlockHeader && a->eventsToBuf > 0) {
+        doFlush = 1;
+    }
+
     /* Are we splitting files in general? */
     while (a->splitting) {
         /* Is this event (together with the current buffer, current file,
          *  and ending block header) large enough to split the file? */
-        uint64_t totalSize = a->bytesToFile + bytesToWrite + a->bytesToBuf +
+        uint64_t totalSize = a->bytesToFile + bytesToWrite + bytesToBuf +
                              bytesCommittedToWrite + headerBytes;
 
         /* If we have to add another record header before this event, account for it. */
@@ -5848,8 +7666,8 @@ if (debug) printf("evWrite: NEED another buffer & block for 1 big event, bufferS
     }
     /* Is this event plus ending block header, in combination with events previously written
      * to the current internal buffer, too big for it? */
-    else if ((!writeNewBlockHeader && ((4*a->bufSize - a->bytesToBuf - bytesCommittedToWrite) < bytesToWrite + headerBytes)) ||
-             ( writeNewBlockHeader && ((4*a->bufSize - a->bytesToBuf - bytesCommittedToWrite) < bytesToWrite + 2*headerBytes)))  {
+    else if ((!writeNewBlockHeader && ((4*a->bufSize - bytesToBuf - bytesCommittedToWrite) < bytesToWrite + headerBytes)) ||
+             ( writeNewBlockHeader && ((4*a->bufSize - bytesToBuf - bytesCommittedToWrite) < bytesToWrite + 2*headerBytes)))  {
 
         /* Not enough room in user-supplied buffer for this event */
         if (a->rw == EV_WRITEBUF) {
@@ -6015,7 +7833,7 @@ int evFlush(int handle) {
     const int debug=0;
 
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -6023,7 +7841,7 @@ int evFlush(int handle) {
     handleLock(handle);
 
     /* Look up file struct from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* If already closed, ignore */
     if (a == NULL) {
@@ -6090,11 +7908,24 @@ if (debug) printf("evFlush: call lastEmptyBlockHeaderExists = %d\n", a->lastEmpt
 static int flushToDestination(EVFILE *a, int force, int *wroteData) {
 
     size_t nBytes=0;
-    uint32_t bytesToWrite=0;
+    uint32_t bytesToWrite=0, bytesNotInBuf=0;
     const int debug=0;
 
     // Find out if we have data not yet written into a->buf. If so, write it all
-    if (a->bytesToDataBuf > 0) {
+    if (a->compressor != NULL) {
+        // Hand over the last record, then wait for all to be compressed and copied
+        if (a->next != a->currentHeader) {
+            int err = compressLater(a);
+            if (err != S_SUCCESS) return(err);
+        }
+        if (writeCompressedRecords(a, UINT64_MAX) != S_SUCCESS) return(S_FAILURE);
+    }
+    else if (a->bytesToDataBuf > 0 && a->mmapWrite) {
+        // Index and data get copied straight into the memory map below
+        bytesNotInBuf = 4*(a->blkEvCount) + a->bytesToDataBuf;
+        a->bytesToBuf += bytesNotInBuf;
+    }
+    else if (a->bytesToDataBuf > 0) {
 if (debug) printf("    flushToDestination: no write events lengths, blk count = %u\n", a->blkEvCount);
         // Write index to internal data buffer
         memcpy((void *)a->next, (const void *)a->eventLengths, 4*(a->blkEvCount));
@@ -6151,7 +7982,7 @@ if (debug) printf("    flushToDestination: write data, bytes = %u\n", a->bytesTo
         if (a->file != NULL)
             clearerr(a->file);
 
-        else {
+        else if (a->mmapFd < 0) {
             /* a->file == NULL: create the file now */
 
             assert (a->bytesToFile < 1);  /* else EVFILE incorrectly initialized */
@@ -6172,44 +8003,77 @@ if (debug) printf("    flushToDestination: write data, bytes = %u\n", a->bytesTo
 
             if (debug) printf("    flushToDestination: create file = %s\n", a->fileName);
 
-            /* If splitting, don't overwrite a file ... */
-            if (a->splitting) {
-                if (fileExists(a->fileName)) {
-                    printf("    flushToDestination: will not overwrite file = %s\n", a->fileName);
-                    return(S_FAILURE);
+            /* Use the file if created ahead of time (never an existing file) */
+            if (!usePreCreatedFile(a)) {
+                /* If splitting, don't overwrite a file ... */
+                if (a->splitting) {
+                    if (fileExists(a->fileName)) {
+                        printf("    flushToDestination: will not overwrite file = %s\n", a->fileName);
+                        return(S_FAILURE);
+                    }
                 }
-            }
 
-            a->file = fopen(a->fileName,"w");
-            if (a->file == NULL) {
-                return(S_FAILURE);
+                if (!a->mmapWrite) {
+                    a->file = fopen(a->fileName,"w");
+                    if (a->file == NULL) {
+                        return(S_FAILURE);
+                    }
+                }
             }
+
+            /* If splitting, start creating the one after this */
+            preCreateNextFile(a);
         }
         /*if (debug) printf("    flushToDestination: write %d bytes\n", bytesToWrite);*/
 
-        /* It may take more than one fwrite to write all data */
-        while (nBytes < bytesToWrite) {
-            char *pBuf = (char *)(a->buf) + nBytes;
-            /* Write block to file */
-            nBytes += fwrite((const void *)pBuf, 1, bytesToWrite - nBytes, a->file);
+        if (a->mmapWrite) {
+            /* Create the file or make it bigger if necessary */
+            if (mapFileForWriting(a, a->bytesToFile + bytesToWrite) != S_SUCCESS) {
+                return(S_FAILURE);
+            }
 
-            /* Return for error condition of file stream */
-            if (ferror(a->file)) return(S_FAILURE);
+            char *pMap = (char *)(a->mmapFile) + a->bytesToFile;
+            memcpy(pMap, a->buf, bytesToWrite - bytesNotInBuf);
+            if (bytesNotInBuf > 0) {
+                pMap += bytesToWrite - bytesNotInBuf;
+                memcpy(pMap, a->eventLengths, 4*(a->blkEvCount));
+                memcpy(pMap + 4*(a->blkEvCount), a->dataBuf, a->bytesToDataBuf);
+            }
+
+            // Update the file header's record count
+            a->mmapFile[3] = a->blknum;
+
+            // Start writing the new data to disk, but don't wait for it
+            long pageSize = sysconf(_SC_PAGESIZE);
+            uint64_t syncStart = a->bytesToFile / pageSize * pageSize;
+            msync((char *)(a->mmapFile) + syncStart,
+                  (size_t)(a->bytesToFile + bytesToWrite - syncStart), MS_ASYNC);
         }
+        else {
+            /* It may take more than one fwrite to write all data */
+            while (nBytes < bytesToWrite) {
+                char *pBuf = (char *)(a->buf) + nBytes;
+                /* Write block to file */
+                nBytes += fwrite((const void *)pBuf, 1, bytesToWrite - nBytes, a->file);
 
-        // Now we need to update the file header to set # of records in file.
-        // Don't bother updating the trailer position since we don't write the trailer's index
-        fseek(a->file, 12, 0);
-        uint32_t numBlocks = a->blknum;
-        fwrite((const void *)(&numBlocks), 4, 1, a->file);
-        if (ferror(a->file)) return(S_FAILURE);
+                /* Return for error condition of file stream */
+                if (ferror(a->file)) return(S_FAILURE);
+            }
+
+            // Now we need to update the file header to set # of records in file.
+            // Don't bother updating the trailer position since we don't write the trailer's index
+            fseek(a->file, 12, 0);
+            uint32_t numBlocks = a->blknum;
+            fwrite((const void *)(&numBlocks), 4, 1, a->file);
+            if (ferror(a->file)) return(S_FAILURE);
 if (debug) printf("    flushToDestination: write %u as record count to file header\n", numBlocks);
 
-        // Go back to where we were
-        fseek(a->file, a->bytesToFile + bytesToWrite, 0);
+            // Go back to where we were
+            fseek(a->file, a->bytesToFile + bytesToWrite, 0);
 
-        if (force) {
-            fflush(a->file);
+            if (force) {
+                fflush(a->file);
+            }
         }
     }
 
@@ -6247,7 +8111,9 @@ if (debug) printf("    flushToDestination: write %u as record count to file head
 /**
  * This routine splits the file being written to.
  * Does nothing when output destination is not a file.
- * It resets file variables, closes the old file, and opens the new.
+ * It resets file variables, hands the old file to another thread to close,
+ * and names the new one, which is opened at the next flush or was already
+ * created in the background by {@link #preCreateNextFile}.
  *
  * @param a  pointer to data structure
  *
@@ -6255,7 +8121,7 @@ if (debug) printf("    flushToDestination: write %u as record count to file head
  * @return  0  if no error but file not split
  * @return -1  if mapped memory does not unmap;
  *             if failure to generate file name;
- *             if failure to close file;
+ *             if failure to close the file before the old one;
  */
 static int splitFile(EVFILE *a) {
     char *fname;
@@ -6268,6 +8134,14 @@ static int splitFile(EVFILE *a) {
         return(0);
     }
 
+    // When writing through a memory map, write the last record without copying it
+    if (a->mmapWrite && a->eventsToBuf > 0) {
+        err = flushToDestination(a, 0, NULL);
+        if (err) {
+            return (-1);
+        }
+    }
+
     // We need to end the file with an empty block header.
     // However, if resetBuffer (or flush) was just called,
     // a last block header will already exist.
@@ -6284,6 +8158,15 @@ if(debug) printf("    splitFile: write last empty header\n");
         return (-1);
     }
 
+    /* Close file in another thread, while its size is still known, so as not to wait
+     * on the file system. Any error closing the previous file is found here. */
+    if (!a->randomAccess) {
+        if (closeFileInBackground(a) != S_SUCCESS) {
+if (debug) printf("    splitFile: error closing file, %s\n", strerror(errno));
+            status = -1;
+        }
+    }
+
     /* Reset first-block & file values for reuse */
     a->blknum = 1;
     a->bytesToFile  = 0;
@@ -6302,15 +8185,6 @@ if (debug) printf("    splitFile: error unmapping memory, %s\n", strerror(errno)
             free(a->pTable);
         }
     }
-    else {
-        if (a->file != NULL) {
-            err = fclose(a->file);
-        }
-        if (err == EOF) {
-if (debug) printf("    splitFile: error closing file, %s\n", strerror(errno));
-            status = -1;
-        }
-    }
 
     /* Right now no file is open for writing */
     a->file = NULL;
@@ -6365,7 +8239,7 @@ int evClose(int handle) {
     int status = S_SUCCESS;
 
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -6373,7 +8247,7 @@ int evClose(int handle) {
     handleLock(handle);
 
     /* Look up file struct from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check arg */
     if (a == NULL) {
@@ -6386,6 +8260,11 @@ if(debug) printf("evClose: eventsToBuf = %u, bytesToBuf = %u\n", a->eventsToBuf,
 
     /* If file writing ... */
     if (a->rw == EV_WRITEFILE || a->rw == EV_WRITEPIPE || a->rw == EV_WRITESOCK) {
+        // When writing through a memory map, write the last record without copying it
+        if (a->mmapWrite && a->eventsToBuf > 0) {
+            flushToDestination(a, 0, NULL);
+        }
+
         // We need to end the file with an empty block header.
         // However, if resetBuffer (or flush) was just called,
         // a last block header will already exist.
@@ -6394,6 +8273,12 @@ if(debug) printf("evClose: write header, free bytes In Buffer = %d\n", (int)(a->
             writeNewHeader(a, 0, a->blknum, 0, 1);
         }
         flushToDestination(a, 1, NULL);
+
+        /* Finish closing the last split file and get rid of an unused next one */
+        if (a->rw == EV_WRITEFILE) {
+            status = waitForClosedFile(a);
+            removePreCreatedFile(a);
+        }
     }
     else if ( a->rw == EV_WRITEBUF) {
         writeNewHeader(a, 0, a->blknum, 0, 1);
@@ -6406,10 +8291,11 @@ if(debug) printf("evClose: write header, free bytes In Buffer = %d\n", (int)(a->
             if (status < 0) status = S_FAILURE;
             else status = S_SUCCESS;
         }
+        else if (a->mmapWrite) {
+            if (unmapFileForWriting(a, a->bytesToFile) != S_SUCCESS) status = S_FAILURE;
+        }
         else {
-            if (a->file != NULL) status = fclose(a->file);
-            if (status == EOF) status = S_FAILURE;
-            else status = S_SUCCESS;
+            if (a->file != NULL && fclose(a->file) == EOF) status = S_FAILURE;
         }
     }
     /* Pipes requires special close */
@@ -6426,7 +8312,7 @@ if(debug) printf("evClose: write header, free bytes In Buffer = %d\n", (int)(a->
 
     /* Remove this handle from the list */
     getHandleLock();
-    handleList[handle-1] = 0;
+    setHandle(handle-1, NULL);
     getHandleUnlock();
 
     if (lockOn) handleUnlockUnconditional(handle);
@@ -6435,6 +8321,190 @@ if(debug) printf("evClose: write header, free bytes In Buffer = %d\n", (int)(a->
 }
 
 
+/**
+ * This routine sends part of an open file to a socket. On Linux, the data is
+ * moved by the kernel with sendfile, otherwise it's read into a buffer and written.
+ *
+ * @param fd      file descriptor of file
+ * @param sockFd  socket file descriptor
+ * @param offset  position in file in bytes of data to send
+ * @param bytes   number of bytes to send
+ *
+ * @return S_SUCCESS if successful
+ * @return S_FAILURE if error reading file or writing to socket (errno is set)
+ */
+static int sendFileBytes(int fd, int sockFd, uint64_t offset, uint64_t bytes) {
+
+#ifdef __linux__
+    off_t off = (off_t)offset;
+    while (bytes > 0) {
+        /* Linux sends at most about 2GB in one call */
+        size_t chunk = bytes > 0x40000000 ? 0x40000000 : (size_t)bytes;
+        ssize_t n = sendfile(sockFd, fd, &off, chunk);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return(S_FAILURE);
+        }
+        if (n == 0) {
+            /* File shorter than expected */
+            errno = EIO;
+            return(S_FAILURE);
+        }
+        bytes -= (uint64_t)n;
+    }
+#else
+    char buf[65536];
+    while (bytes > 0) {
+        size_t chunk = bytes > sizeof(buf) ? sizeof(buf) : (size_t)bytes;
+        ssize_t n = pread(fd, buf, chunk, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return(S_FAILURE);
+        }
+        if (n == 0) {
+            errno = EIO;
+            return(S_FAILURE);
+        }
+        if (tcpWrite(sockFd, buf, (int)n) != n) {
+            return(S_FAILURE);
+        }
+        offset += (uint64_t)n;
+        bytes  -= (uint64_t)n;
+    }
+#endif
+
+    return(S_SUCCESS);
+}
+
+
+/**
+ * This routine sends the records of an evio file over a socket in the form expected by
+ * {@link #evOpenSocket} when reading, which is what writing events to a socket with
+ * {@link #evWrite} gives. It's done without reading the events into user space, so
+ * it's a much faster way to forward a closed file than reading and writing each event.<p>
+ *
+ * Only the record headers are read, to find where the data ends. For evio version 6,
+ * the file header and whatever follows it are skipped and records are sent up to and
+ * including the last one, normally the trailer. If the file doesn't have a last record,
+ * as when its writer never closed it, an empty last record header is sent after the
+ * last complete record. Files of earlier versions are sent whole.
+ *
+ * @param fileName  name of evio file
+ * @param sockFd    connected socket file descriptor
+ * @param bytesSent if not NULL, filled with the number of bytes sent
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_FAILURE          if error writing to socket (errno is set)
+ * @return S_EVFILE_BADARG    if fileName is NULL or sockFd &lt; 0
+ * @return S_EVFILE_BADFILE   if file is not in evio format
+ * @return errno              if file could not be opened or read
+ */
+int evSendFile(char *fileName, int sockFd, uint64_t *bytesSent) {
+
+    int fd, err, swap, version, lastRecord = 0;
+    uint32_t header[EV_HDSIZ_V6], recordNumber = 0;
+    uint64_t fileSize, start = 0, end, pos;
+    struct stat fileInfo;
+
+    if (fileName == NULL || sockFd < 0) {
+        return(S_EVFILE_BADARG);
+    }
+
+    if (bytesSent != NULL) *bytesSent = 0;
+
+    if ((fd = open(fileName, O_RDONLY)) < 0) {
+        return(errno);
+    }
+
+    if (fstat(fd, &fileInfo) != 0) {
+        err = errno;
+        close(fd);
+        return(err);
+    }
+    fileSize = (uint64_t)fileInfo.st_size;
+
+    /* First header may be a file header (v6) or block header (v1-4) */
+    if (pread(fd, header, EV_HDSIZ_BYTES, 0) != EV_HDSIZ_BYTES) {
+        close(fd);
+        return(S_EVFILE_BADFILE);
+    }
+
+    if (header[EV_HD_MAGIC] == EV_MAGIC) {
+        swap = 0;
+    }
+    else if (header[EV_HD_MAGIC] == EVIO_SWAP32(EV_MAGIC)) {
+        swap = 1;
+    }
+    else {
+        close(fd);
+        return(S_EVFILE_BADFILE);
+    }
+
+#define SEND_WORD(i) (swap ? EVIO_SWAP32(header[i]) : header[i])
+
+    end = fileSize;
+    version = SEND_WORD(EV_HD_VER) & EV_VERSION_MASK;
+
+    if (version >= 6) {
+        if (pread(fd, header, EV_HDSIZ_BYTES_V6, 0) != EV_HDSIZ_BYTES_V6) {
+            close(fd);
+            return(S_EVFILE_BADFILE);
+        }
+
+        /* Skip over file header, its index, user header and padding */
+        start = 4*(uint64_t)SEND_WORD(EV_HD_HDSIZ) + SEND_WORD(EV_HD_INDEXARRAYLEN) +
+                SEND_WORD(EV_HD_USERHDRLEN) + getPad1(SEND_WORD(EV_HD_VER));
+
+        /* Hop from one record header to the next to find the end */
+        end = pos = start;
+        while (!lastRecord && pos + EV_HDSIZ_BYTES_V6 <= fileSize) {
+            if (pread(fd, header, EV_HDSIZ_BYTES_V6, (off_t)pos) != EV_HDSIZ_BYTES_V6) {
+                err = errno;
+                close(fd);
+                return(err);
+            }
+
+            uint32_t recordWords = SEND_WORD(EV_HD_BLKSIZ);
+            if (SEND_WORD(EV_HD_MAGIC) != EV_MAGIC || recordWords < EV_HDSIZ_V6 ||
+                pos + 4*(uint64_t)recordWords > fileSize) {
+                /* Bad or incomplete record, send only what's before it */
+                break;
+            }
+
+            recordNumber = SEND_WORD(EV_HD_BLKNUM);
+            lastRecord = isLastBlockInt_V6(SEND_WORD(EV_HD_VER));
+            pos += 4*(uint64_t)recordWords;
+            end = pos;
+        }
+    }
+
+    err = sendFileBytes(fd, sockFd, start, end - start);
+    close(fd);
+    if (err != S_SUCCESS) {
+        return(err);
+    }
+    if (bytesSent != NULL) *bytesSent = end - start;
+
+    /* Receiver needs a last record to know data has ended */
+    if (version >= 6 && !lastRecord) {
+        initBlockHeader2(header, recordNumber + 1);
+        header[EV_HD_VER] = (uint32_t) generateSixthWord(EV_VERSION, 0, 1, 0);
+        if (swap) {
+            evioSwapRecordHeaderV6(header);
+        }
+
+        if (tcpWrite(sockFd, header, EV_HDSIZ_BYTES_V6) != EV_HDSIZ_BYTES_V6) {
+            return(S_FAILURE);
+        }
+        if (bytesSent != NULL) *bytesSent += EV_HDSIZ_BYTES_V6;
+    }
+
+#undef SEND_WORD
+
+    return(S_SUCCESS);
+}
+
+
 /** @} */
 
 
@@ -6464,7 +8534,7 @@ int evGetFileName(int handle, char *name, size_t maxLength) {
     EVFILE *a;
     int err = S_SUCCESS;
 
-    if (handle < 1 || (size_t) handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return (S_EVFILE_BADHANDLE);
     }
 
@@ -6472,7 +8542,7 @@ int evGetFileName(int handle, char *name, size_t maxLength) {
     handleLock(handle);
 
     /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle - 1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL || name == NULL || maxLength < 1) {
@@ -6526,7 +8596,7 @@ int evGetBufferLength(int handle, uint32_t *length)
     if (length == NULL)
         return (S_SUCCESS);
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -6534,7 +8604,7 @@ int evGetBufferLength(int handle, uint32_t *length)
     handleLock(handle);
 
     /* Look up file struct (which contains block buffer) from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check arg */
     if (a == NULL) {
@@ -6592,6 +8662,19 @@ int evGetBufferLength(int handle, uint32_t *length)
  * opened for reading or writing if request = "E". Includes any
  * event added with {@link #evWrite} call. Used only in version 4.<p>
  *
+ * It starts receiving the blocks of a socket opened for reading into a ring of
+ * buffers in another thread if request = "Q", so the network is read while events
+ * are processed. Events from {@link #evReadNoCopy} then point into these buffers and
+ * stay valid until given back with {@link #evReleaseEvent}, which must be done for
+ * each one. When the handle is closed, the thread is stopped, if need be by shutting
+ * down the socket for reading. Used only in versions 4 and 6.<p>
+ *
+ * It starts compressing the records written to a file, socket or pipe if request = "C".
+ * Once a record is full, it's handed to a pool of threads to be compressed while the
+ * next one is filled, and records are written out in order. Records which would not
+ * get smaller are written uncompressed. This must be done before any event is written
+ * and only applies to version 6.<p>
+ *
  * NOTE: all request strings are case insensitive. All version 4 commands to
  * version 3 files are ignored.
  *
@@ -6608,6 +8691,8 @@ int evGetBufferLength(int handle, uint32_t *length)
  * <LI>  "V"  for getting evio version #
  * <LI>  "H"  for getting 14 ints of block header info (only 8 valid for version < 6)
  * <LI>  "E"  for getting # of events in file/buffer
+ * <LI>  "Q"  for receiving socket blocks into a ring of buffers
+ * <LI>  "C"  for setting record compression when writing
  * </OL>
  *
  * @param argp
@@ -6625,16 +8710,25 @@ int evGetBufferLength(int handle, uint32_t *length)
  *              This pointer must be freed by caller since it points to allocated memory.
  * <LI> pointer to uin32_t returning total # of original events in existing
  *              file/buffer when reading or appending if request = E, or
+ * <LI> pointer to uin32_t containing number of ring buffers if request = Q, or
+ * <LI> pointer to 2 uin32_t's containing compression type (1 = LZ4, 2 = LZ4 best,
+ *              3 = gzip) and number of compressing threads (0 to compress in the
+ *              writing thread) if request = C.
  * </OL>
  *
  * @return S_SUCCESS           if successful
  * @return S_FAILURE           if using sockets when request = E
- * @return S_EVFILE_BADARG     if request is NULL or argp is NULL
+ * @return S_EVFILE_BADARG     if request is NULL or argp is NULL;
+ *                              if request = C and compression type unknown
  * @return S_EVFILE_BADFILE    if file too small or problem reading file when request = E
  * @return S_EVFILE_BADHANDLE  if bad handle arg
  * @return S_EVFILE_ALLOCFAIL  if cannot allocate memory
  * @return S_EVFILE_UNXPTDEOF  if buffer too small when request = E
  * @return S_EVFILE_UNKOPTION  if unknown option specified in request arg
+ * @return S_EVFILE_BADMODE    if request = Q and not reading a socket,
+ *                              version < 4, or ring already started; if request = C and not writing
+ *                              a file, socket or pipe, version < 6, appending, events
+ *                              already written, or already compressing
  * @return S_EVFILE_BADSIZEREQ  when setting block/buffer size - if currently reading,
  *                              have already written events with different block size,
  *                              or is smaller than min allowed size (header size + 1K),
@@ -6652,7 +8746,7 @@ int evIoctl(int handle, char *request, void *argp)
     uint32_t  eventsMax, blockSize, bufferSize, runNumber;
     uint64_t  splitSize;
 
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -6660,7 +8754,7 @@ int evIoctl(int handle, char *request, void *argp)
     handleLock(handle);
 
     /* Look up file struct from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL) {
@@ -7088,6 +9182,44 @@ if (debug) printf("evIoctl: split file at %llu (0x%llx) bytes\n", splitSize, spl
 
             break;
 
+        /*****************************************/
+        /* Receiving socket blocks into a ring   */
+        /*****************************************/
+        case 'q':
+        case 'Q':
+            /* Need to specify number of buffers */
+            if (argp == NULL) {
+                handleUnlock(handle);
+                return(S_EVFILE_BADARG);
+            }
+
+            err = startSocketRing(a, *(uint32_t *) argp);
+            if (err != S_SUCCESS) {
+                handleUnlock(handle);
+                return(err);
+            }
+
+            break;
+
+        /*****************************************/
+        /* Compressing records when writing      */
+        /*****************************************/
+        case 'c':
+        case 'C':
+            /* Need to specify type and number of threads */
+            if (argp == NULL) {
+                handleUnlock(handle);
+                return(S_EVFILE_BADARG);
+            }
+
+            err = startCompressor(a, (int) ((uint32_t *) argp)[0], ((uint32_t *) argp)[1]);
+            if (err != S_SUCCESS) {
+                handleUnlock(handle);
+                return(err);
+            }
+
+            break;
+
         default:
             handleUnlock(handle);
             return(S_EVFILE_UNKOPTION);
@@ -7112,16 +9244,20 @@ if (debug) printf("evIoctl: split file at %llu (0x%llx) bytes\n", splitSize, spl
  * @param len     pointer to int which gets filled with the number of
  *                pointers in the array. If this arg = NULL, error is returned.
  *                   
+ * For evio version 6, the records not yet looked at by {@link #evReadRandom}
+ * are scanned first, so it's quicker to use that for reading only some events.
+ *
  * @return S_SUCCESS           if successful
  * @return S_EVFILE_BADMODE    if handle not opened in random access mode
  * @return S_EVFILE_BADARG     if table or len arg(s) is NULL
  * @return S_EVFILE_BADHANDLE  if bad handle arg
+ * @return S_EVFILE_BADFILE    if bad data format or compressed data (version 6)
  */
 int evGetRandomAccessTable(int handle, uint32_t *** const table, uint32_t *len) {
     EVFILE *a;
 
     
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -7129,7 +9265,7 @@ int evGetRandomAccessTable(int handle, uint32_t *** const table, uint32_t *len)
     handleLock(handle);
 
     /* Look up file struct from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL) {
@@ -7148,6 +9284,18 @@ int evGetRandomAccessTable(int handle, uint32_t *** const table, uint32_t *len)
         return(S_EVFILE_BADMODE);
     }
             
+    /* Version 6 tables are only filled in as needed, so finish it */
+    if (a->version > 4 && a->recordScanned != NULL) {
+        uint32_t i;
+        for (i=0; i < a->recordCount; i++) {
+            int err = scanRecordV6(a, i);
+            if (err != S_SUCCESS) {
+                handleUnlock(handle);
+                return(err);
+            }
+        }
+    }
+
     *table = a->pTable;
     *len = a->eventCount;
 
@@ -7182,7 +9330,7 @@ int evGetDictionary(int handle, char **dictionary, uint32_t *len) {
     char *dictCpy;
 
     
-    if (handle < 1 || (size_t)handle > handleCount) {
+    if (handle < 1 || (size_t)handle > getHandleCount()) {
         return(S_EVFILE_BADHANDLE);
     }
 
@@ -7190,7 +9338,7 @@ int evGetDictionary(int handle, char **dictionary, uint32_t *len) {
     handleLock(handle);
 
     /* Look up file struct from handle */
-    a = handleList[handle-1];
+    a = getHandle(handle);
 
     /* Check args */
     if (a == NULL) {
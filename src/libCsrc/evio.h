@@ -197,12 +197,28 @@ typedef struct evfilestruct {
 
     /* socket stuff */
     int   sockFd;            /**< socket file descriptor if reading/writing from/to socket. */
+    struct evSockRing *sockRing; /**< when reading a socket, ring of buffers blocks are received
+                                  *   into by another thread, NULL if none. */
 
     /* randomAcess stuff */
     int        randomAccess; /**< if true, use random access file/buffer reading. */
     size_t     mmapFileSize; /**< size of mapped file in bytes. */
     uint32_t  *mmapFile;     /**< pointer to memory mapped file. */
-    uint32_t  **pTable;      /**< array of pointers to events in memory mapped file or buffer. */
+    uint32_t  **pTable;      /**< array of pointers to events in memory mapped file or buffer.
+                              *   In version 6, an entry is NULL until its record has been scanned. */
+    uint32_t  **recordTable; /**< array of pointers to record headers in memory mapped file or buffer (v6). */
+    uint32_t  *recordFirstEvent; /**< index into pTable of each record's first event,
+                                  *   with recordCount + 1 entries (v6). */
+    char      *recordScanned; /**< for each record, 1 if its events are in pTable, else 0 (v6). */
+    uint32_t   recordCount;  /**< number of records in recordTable (v6). */
+
+    /* memory mapped writing */
+    int        mmapWrite;    /**< if true, write file through a shared memory map (mmapFile) instead of fwrite. */
+    int        mmapFd;       /**< descriptor of file being written through memory map, -1 if none. */
+
+    /* split files closed and created in the background */
+    struct evFileJob *closeJob; /**< closing of the last split file in another thread, NULL if none. */
+    struct evFileJob *openJob;  /**< creating of the next split file in another thread, NULL if none. */
 
 
     /* dictionary */
@@ -239,6 +255,10 @@ typedef struct evfilestruct {
                                 * blkEvCount tracks how many events and therefore entries in this array. */
     uint32_t eventLengthsLen; /**< Size of eventLengths array in words, convenience variable when reading. */
 
+    uint32_t *uncompBuf;      /**< For reading compressed records, buffer holding the current record's
+                                * uncompressed index, user header and events. Kept for the next record. */
+    uint32_t uncompBufSize;   /**< Size of uncompBuf in bytes. */
+
     //// WRITING ////
 
     uint32_t *dataBuf;      /**< For writing, pointer to buffer of events (data) to be written.
@@ -252,6 +272,11 @@ typedef struct evfilestruct {
     uint32_t  dataLeft;     /**< # of valid 32 bit unwritten words in dataBuf. */
     uint32_t  bytesToDataBuf;  /**< # data bytes written to dataBuf. */
 
+    struct evCompressor *compressor; /**< For writing compressed records, threads compressing them
+                                      *   and ring of records not yet written, NULL if none. */
+    uint32_t  bytesPending;    /**< # bytes, before compression, of records handed to the
+                                *   compressor and not yet copied into buf. */
+
 } EVFILE;
 
 
@@ -284,6 +309,9 @@ typedef struct evioBlockHeaderV4_t {
 /** Offset in bytes from beginning of block header to magic number. */
 #define EVIO_BH_MAGNUM_OFFSET 224
 
+/** Composite data format compiled by evFmtCompile. */
+typedef struct evioFormat_t evioFormat;
+
 /* prototypes */
 void set_user_frag_select_func( int32_t (*f) (int32_t tag) );
 int evioIsLocalHostBigEndian();
@@ -304,6 +332,7 @@ int evOpenSocket(int sockFd, char *flags, int *handle);
 int evRead(int handle, uint32_t *buffer, uint32_t size);
 int evReadAlloc(int handle, uint32_t **buffer, uint32_t *buflen);
 int evReadNoCopy(int handle, const uint32_t **buffer, uint32_t *buflen);
+int evReleaseEvent(int handle, const uint32_t *event);
 int evReadRandom(int handle, const uint32_t **pEvent, uint32_t *buflen, uint32_t eventNumber);
 int evGetRandomAccessTable(int handle, uint32_t *** const table, uint32_t *len);
 
@@ -313,6 +342,7 @@ int evFlush(int handle);
 int evClose(int handle);
 int evGetBufferLength(int handle, uint32_t *length);
 int evGetFileName(int handle, char *name, size_t maxLength);
+int evSendFile(char *fileName, int sockFd, uint64_t *bytesSent);
 
 int evIsLastBlock(uint32_t sixthWord);
 
@@ -334,6 +364,13 @@ int   evGenerateBaseFileName(char *origName, char **baseName, int *count);
 char *evGenerateFileName(EVFILE *a, int specifierCount, int runNumber,
                          int splitting, int splitNumber, char *runType, uint32_t streamId);
 
+int  evFmtCompile(const char *fmt, const evioFormat **handle);
+int  evFmtCompileData(const char *fmt, size_t maxLen, const evioFormat **handle);
+const char *evFmtString(const evioFormat *handle);
+int  evFmtSwap(int32_t *iarr, int nwrd, const evioFormat *handle, int tolocal, int padding);
+int  evFmtDump(int32_t *arr, int nwrd, const evioFormat *handle, int nextrabytes, char *xml);
+void evFmtCacheClear(void);
+
 #ifdef __cplusplus
 }
 
@@ -12,7 +12,8 @@
  *  Code to translate a string containing a data format
  *  into an array of integer codes. To be used with the
  *  function eviofmtswap for swapping data held in this
- *  format.
+ *  format. Translated formats may be cached and used through
+ *  a handle (evFmtCompile, evFmtSwap, evFmtDump).
  *  
  * Author:  Sergey Boiarinov, Hall B
  */
@@ -110,7 +111,7 @@ eviofmt(char *fmt, unsigned short *ifmt, int ifmtLen)
       if (isdigit(ch))
       {
         if (nr < 0) return(-1);
-        nr = 10*MAX(0,nr) + atoi((char *)&ch);
+        nr = 10*MAX(0,nr) + (ch - '0');
         if (nr > 15) return(-2);
 #ifdef DEBUG
         printf("the number of repeats nr=%d\n",nr);
@@ -253,3 +254,266 @@ eviofmt(char *fmt, unsigned short *ifmt, int ifmtLen)
 
     return(n);
 }
+
+
+/*---------------------------------------------------------------
+ * Cache of compiled formats
+ *---------------------------------------------------------------*/
+
+extern int eviofmtswap(int32_t *iarr, int nwrd, unsigned short *ifmt, int nfmt, int tolocal, int padding);
+extern int eviofmtdump(int32_t *arr, int nwrd, unsigned short *ifmt, int nfmt, int nextrabytes, char *xml);
+
+/** Number of hash table buckets of the format cache. */
+#define EV_FMT_BUCKETS 64
+
+/** Most codes a compiled format may have. */
+#define EV_FMT_MAX_CODES 1024
+
+/** Format string translated by eviofmt, kept in the cache. */
+struct evioFormat_t {
+    char           *fmt;   /**< format string, null-terminated */
+    size_t          len;   /**< length of format string */
+    int             nfmt;  /**< number of codes in ifmt */
+    unsigned short *ifmt;  /**< translated format */
+    struct evioFormat_t *next; /**< next format in same bucket */
+};
+
+/** Compiled formats, hashed by format string. */
+static evioFormat *fmtCache[EV_FMT_BUCKETS];
+
+/** Lock on fmtCache. Lookups share it, adding a format takes it alone. */
+static pthread_rwlock_t fmtCacheLock = PTHREAD_RWLOCK_INITIALIZER;
+
+
+/**
+ * Hash a format string (FNV-1a).
+ * @param fmt format string.
+ * @param len length of format string.
+ * @return hash of format string.
+ */
+static uint32_t fmtHash(const char *fmt, size_t len) {
+    size_t i;
+    uint32_t h = 2166136261U;
+    for (i=0; i < len; i++) {
+        h ^= (unsigned char)fmt[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+
+/**
+ * Look for a format string in the cache. The cache must be locked.
+ * @param fmt    format string, need not be null-terminated.
+ * @param len    length of format string.
+ * @param bucket bucket of format string.
+ * @return compiled format, or NULL if not cached.
+ */
+static evioFormat *fmtCacheFind(const char *fmt, size_t len, uint32_t bucket) {
+    evioFormat *f;
+    for (f = fmtCache[bucket]; f != NULL; f = f->next) {
+        if (f->len == len && memcmp(f->fmt, fmt, len) == 0) {
+            return f;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Get the compiled form of a format string, translating and caching it
+ * if this is the first time it's asked for.
+ *
+ * @param fmt    format string, need not be null-terminated.
+ * @param len    length of format string.
+ * @param handle filled with compiled format.
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_BADARG    if improper format string
+ * @return S_EVFILE_ALLOCFAIL if cannot allocate memory
+ */
+static int fmtCacheGet(const char *fmt, size_t len, const evioFormat **handle) {
+    int nfmt;
+    uint32_t bucket = fmtHash(fmt, len) % EV_FMT_BUCKETS;
+    unsigned short ifmt[EV_FMT_MAX_CODES];
+    evioFormat *f;
+
+    pthread_rwlock_rdlock(&fmtCacheLock);
+    f = fmtCacheFind(fmt, len, bucket);
+    pthread_rwlock_unlock(&fmtCacheLock);
+
+    if (f != NULL) {
+        *handle = f;
+        return S_SUCCESS;
+    }
+
+    /* Translate outside the lock, from a null-terminated copy */
+    f = (evioFormat *) calloc(1, sizeof(evioFormat));
+    if (f == NULL) return S_EVFILE_ALLOCFAIL;
+
+    f->fmt = (char *) malloc(len + 1);
+    if (f->fmt == NULL) {
+        free(f);
+        return S_EVFILE_ALLOCFAIL;
+    }
+    memcpy(f->fmt, fmt, len);
+    f->fmt[len] = '\0';
+    f->len = len;
+
+    nfmt = eviofmt(f->fmt, ifmt, EV_FMT_MAX_CODES);
+    if (nfmt <= 0) {
+        free(f->fmt);
+        free(f);
+        return S_EVFILE_BADARG;
+    }
+
+    f->ifmt = (unsigned short *) malloc(nfmt * sizeof(unsigned short));
+    if (f->ifmt == NULL) {
+        free(f->fmt);
+        free(f);
+        return S_EVFILE_ALLOCFAIL;
+    }
+    memcpy(f->ifmt, ifmt, nfmt * sizeof(unsigned short));
+    f->nfmt = nfmt;
+
+    /* Another thread may have added it in the meantime */
+    pthread_rwlock_wrlock(&fmtCacheLock);
+    *handle = fmtCacheFind(fmt, len, bucket);
+    if (*handle == NULL) {
+        f->next = fmtCache[bucket];
+        fmtCache[bucket] = f;
+        *handle = f;
+        f = NULL;
+    }
+    pthread_rwlock_unlock(&fmtCacheLock);
+
+    if (f != NULL) {
+        free(f->ifmt);
+        free(f->fmt);
+        free(f);
+    }
+
+    return S_SUCCESS;
+}
+
+
+/**
+ * Get the compiled form of a composite data format string, for use with
+ * {@link #evFmtSwap} and {@link #evFmtDump}. The string is translated by
+ * {@link #eviofmt} only the first time it's asked for. After that, its compiled
+ * form is found in a cache, so asking for it again is cheap and always returns the
+ * same handle. Handles stay valid until {@link #evFmtCacheClear} is called.
+ * This routine is thread-safe.
+ *
+ * @param fmt    null-terminated composite data format string
+ * @param handle filled with compiled format
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_BADARG    if either arg is NULL or improper format string
+ * @return S_EVFILE_ALLOCFAIL if cannot allocate memory
+ */
+int evFmtCompile(const char *fmt, const evioFormat **handle)
+{
+    if (fmt == NULL || handle == NULL) return S_EVFILE_BADARG;
+    return fmtCacheGet(fmt, strlen(fmt), handle);
+}
+
+
+/**
+ * Get the compiled form of the format string of composite data, as found in the data
+ * itself, where it may be padded with '\0' and '\4' characters but need not be
+ * null-terminated. See {@link #evFmtCompile}.
+ *
+ * @param fmt    composite data format string
+ * @param maxLen most characters in fmt, its length in words * 4
+ * @param handle filled with compiled format
+ *
+ * @return S_SUCCESS          if successful
+ * @return S_EVFILE_BADARG    if either pointer arg is NULL or improper format string
+ * @return S_EVFILE_ALLOCFAIL if cannot allocate memory
+ */
+int evFmtCompileData(const char *fmt, size_t maxLen, const evioFormat **handle)
+{
+    size_t len = 0;
+
+    if (fmt == NULL || handle == NULL) return S_EVFILE_BADARG;
+    while (len < maxLen && fmt[len] != '\0' && fmt[len] != '\4') len++;
+    return fmtCacheGet(fmt, len, handle);
+}
+
+
+/**
+ * Get the format string of a compiled format.
+ * @param handle compiled format
+ * @return null-terminated format string, or NULL if handle is NULL
+ */
+const char *evFmtString(const evioFormat *handle)
+{
+    return handle == NULL ? NULL : handle->fmt;
+}
+
+
+/**
+ * This routine does the same as {@link #eviofmtswap} but with a format compiled by
+ * {@link #evFmtCompile}, so the format string is not translated again.
+ *
+ * @param iarr    pointer to data to be swapped
+ * @param nwrd    number of data words (32-bit ints) to be swapped
+ * @param handle  compiled format
+ * @param tolocal if 0 data is of same endian as local host,
+ *                else data is of opposite endian
+ * @param padding number of bytes to ignore in last data word (starting from data end)
+ *
+ * @return S_SUCCESS       if successful
+ * @return S_EVFILE_BADARG if handle is NULL or nwrd < 1
+ */
+int evFmtSwap(int32_t *iarr, int nwrd, const evioFormat *handle, int tolocal, int padding)
+{
+    if (handle == NULL) return S_EVFILE_BADARG;
+    if (eviofmtswap(iarr, nwrd, handle->ifmt, handle->nfmt, tolocal, padding)) {
+        return S_EVFILE_BADARG;
+    }
+    return S_SUCCESS;
+}
+
+
+/**
+ * This routine does the same as {@link #eviofmtdump} but with a format compiled by
+ * {@link #evFmtCompile}, so the format string is not translated again.
+ *
+ * @param arr         pointer to data to be dumped
+ * @param nwrd        number of data words (32-bit ints)
+ * @param handle      compiled format
+ * @param nextrabytes number of bytes to ignore at the end of data
+ * @param xml         where to write the XML
+ *
+ * @return the number of bytes written into xml, 0 if bad arg(s)
+ */
+int evFmtDump(int32_t *arr, int nwrd, const evioFormat *handle, int nextrabytes, char *xml)
+{
+    if (handle == NULL) return 0;
+    return eviofmtdump(arr, nwrd, handle->ifmt, handle->nfmt, nextrabytes, xml);
+}
+
+
+/**
+ * Free all compiled formats. Any handle obtained from {@link #evFmtCompile} is
+ * invalid afterwards, so call this only when no thread is using one.
+ */
+void evFmtCacheClear(void)
+{
+    int i;
+    evioFormat *f, *next;
+
+    pthread_rwlock_wrlock(&fmtCacheLock);
+    for (i=0; i < EV_FMT_BUCKETS; i++) {
+        for (f = fmtCache[i]; f != NULL; f = next) {
+            next = f->next;
+            free(f->ifmt);
+            free(f->fmt);
+            free(f);
+        }
+        fmtCache[i] = NULL;
+    }
+    pthread_rwlock_unlock(&fmtCacheLock);
+}
@@ -72,12 +72,19 @@
 
 /* include files */
 #include <stdio.h>
+#include <pthread.h>
 #include "evio.h"
 
+/* Arrays are swapped with byte shuffles. On x86 the widest instruction set
+ * available is picked at run time, on 64 bit ARM NEON is always there. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define EVIO_SWAP_X86 1
+    #include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #define EVIO_SWAP_NEON 1
+    #include <arm_neon.h>
+#endif
 
-/* from Sergey's composite swap library */
-extern int eviofmt(char *fmt, unsigned short *ifmt, int ifmtLen);
-extern int eviofmtswap(uint32_t *iarr, int nwrd, unsigned short *ifmt, int nfmt, int tolocal, int padding);
 
 /* internal prototypes */
 static void swap_bank(uint32_t *buf, int tolocal, uint32_t *dest);
@@ -86,6 +93,7 @@ static void swap_tagsegment(uint32_t *buf, int tolocal, uint32_t *dest);
 static void swap_data(uint32_t *data, int type, uint32_t length, int tolocal, uint32_t *dest);
 static void copy_data(uint32_t *data, uint32_t length, uint32_t *dest);
 static int  swap_composite_t(uint32_t *data, int tolocal, uint32_t *dest, uint32_t length);
+static int  all_32bit_words(const uint32_t *data, int type, uint32_t length, int tolocal);
 
 
 /**
@@ -208,9 +216,20 @@ void evioSwapRecordHeaderV6(uint32_t *header) {
  */
 void evioswap(uint32_t *buf, int tolocal, uint32_t *dest) {
 
-  swap_bank(buf, tolocal, dest);
+    uint32_t length = tolocal ? EVIO_SWAP32(buf[0]) : buf[0];
+    uint32_t type   = tolocal ? EVIO_SWAP32(buf[1]) : buf[1];
 
-  return;
+    /* If the event holds only containers and 32 bit data, as most do, every word
+     * of it is swapped the same way. Swap it all at once instead of bank by bank. */
+    if (length > 0 && length < 0xffffffff &&
+        all_32bit_words(&buf[2], (type >> 8) & 0x3f, length - 1, tolocal)) {
+        swap_int32_t(buf, length + 1, dest);
+        return;
+    }
+
+    swap_bank(buf, tolocal, dest);
+
+    return;
 }
 
 
@@ -322,6 +341,66 @@ static void swap_tagsegment(uint32_t *buf, int tolocal, uint32_t *dest) {
 
 
 
+/**
+ * Routine to look through evio data, without changing it, to see if it's made up of only
+ * 32 bit words to be swapped. This is the case when it holds nothing but containers
+ * (banks, segments, tagsegments), whose headers are 32 bit words, and 32 bit data.
+ * Containers which run past the end of their parents also give 0, leaving them
+ * to be handled by the usual swapping routines.
+ *
+ * @param data    buffer of evio data
+ * @param type    type of evio data
+ * @param length  length of evio data in 32 bit words
+ * @param tolocal if 0 data is of same endian as local host,
+ *                else data is of opposite endian
+ * @return 1 if all 32 bit words, else 0
+ */
+static int all_32bit_words(const uint32_t *data, int type, uint32_t length, int tolocal) {
+    uint32_t word, fraglen, l=0;
+
+    switch (type) {
+
+        /* 32-bit types: uint, float, or int */
+        case 0x1:
+        case 0x2:
+        case 0xb:
+            return 1;
+
+        /* bank */
+        case 0xe:
+        case 0x10:
+            while (l < length) {
+                if (length - l < 2) return 0;
+                word = tolocal ? EVIO_SWAP32(data[l]) : data[l];
+                fraglen = word + 1;
+                if (fraglen < 2 || fraglen > length - l) return 0;
+                word = tolocal ? EVIO_SWAP32(data[l+1]) : data[l+1];
+                if (!all_32bit_words(&data[l+2], (word >> 8) & 0x3f, fraglen - 2, tolocal)) return 0;
+                l += fraglen;
+            }
+            return 1;
+
+        /* segment or tagsegment */
+        case 0xd:
+        case 0x20:
+        case 0xc:
+            while (l < length) {
+                word = tolocal ? EVIO_SWAP32(data[l]) : data[l];
+                fraglen = (word & 0xffff) + 1;
+                if (fraglen > length - l) return 0;
+                if (!all_32bit_words(&data[l+1], (word >> 16) & (type == 0xc ? 0xf : 0x3f),
+                                     fraglen - 1, tolocal)) return 0;
+                l += fraglen;
+            }
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+
+
 /**
  * Routine to swap any type of evio data.
  *
@@ -458,6 +537,131 @@ int32_t swap_int32_t_value(int32_t val) {
 */
 
 
+/*--------------------------------------------------------------------------*/
+/* Vectorized swapping */
+
+/* Byte order, within each 16 bytes, of data after swapping 2, 4, & 8 byte elements. */
+static const uint8_t swap16Mask[16] = {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14};
+static const uint8_t swap32Mask[16] = {3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12};
+static const uint8_t swap64Mask[16] = {7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8};
+
+/*
+ * Type of routine which shuffles bytes, 16 at a time, according to mask.
+ * It does as many whole vectors as fit in bytes and returns how many bytes it did.
+ * Src and dst may be the same, or dst may be below src, but not overlap otherwise.
+ */
+typedef size_t (*swapKernel)(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask);
+
+/* Kernel in use, NULL if none, picked once by select_swap_kernel. */
+static swapKernel swapKernelFunc = NULL;
+static pthread_once_t swapKernelOnce = PTHREAD_ONCE_INIT;
+
+
+#ifdef EVIO_SWAP_X86
+
+__attribute__((target("ssse3")))
+static size_t swap_ssse3(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+    size_t i = 0;
+    const __m128i m = _mm_loadu_si128((const __m128i *) mask);
+
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_shuffle_epi8(v, m));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t swap_avx2(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+    size_t i = 0;
+    /* shuffles stay within each 128 bit lane, so the same mask goes in both */
+    const __m256i m = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) mask));
+
+    for (; i + 64 <= bytes; i += 64) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *) (src + i + 32));
+        _mm256_storeu_si256((__m256i *) (dst + i),      _mm256_shuffle_epi8(v0, m));
+        _mm256_storeu_si256((__m256i *) (dst + i + 32), _mm256_shuffle_epi8(v1, m));
+    }
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_shuffle_epi8(v, m));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t swap_avx512(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+    size_t i = 0;
+    const __m512i m = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) mask));
+
+    for (; i + 64 <= bytes; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *) (src + i));
+        _mm512_storeu_si512((void *) (dst + i), _mm512_shuffle_epi8(v, m));
+    }
+    return i;
+}
+
+static void select_swap_kernel(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        swapKernelFunc = swap_avx512;
+    }
+    else if (__builtin_cpu_supports("avx2")) {
+        swapKernelFunc = swap_avx2;
+    }
+    else if (__builtin_cpu_supports("ssse3")) {
+        swapKernelFunc = swap_ssse3;
+    }
+}
+
+#elif defined(EVIO_SWAP_NEON)
+
+static size_t swap_neon(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+    size_t i = 0;
+    const uint8x16_t m = vld1q_u8(mask);
+
+    for (; i + 32 <= bytes; i += 32) {
+        uint8x16_t v0 = vld1q_u8(src + i);
+        uint8x16_t v1 = vld1q_u8(src + i + 16);
+        vst1q_u8(dst + i,      vqtbl1q_u8(v0, m));
+        vst1q_u8(dst + i + 16, vqtbl1q_u8(v1, m));
+    }
+    for (; i + 16 <= bytes; i += 16) {
+        vst1q_u8(dst + i, vqtbl1q_u8(vld1q_u8(src + i), m));
+    }
+    return i;
+}
+
+static void select_swap_kernel(void) {
+    swapKernelFunc = swap_neon;
+}
+
+#else
+
+static void select_swap_kernel(void) {}
+
+#endif
+
+
+/**
+ * This routine swaps as much of the given data as possible with vector instructions.
+ * Arrays too small to fill a vector are left entirely to the caller.
+ *
+ * @param src   pointer to data to be swapped
+ * @param dst   pointer to where swapped data is to be copied to, may be src
+ * @param bytes number of bytes to swap
+ * @param mask  byte shuffle for the element size
+ * @return number of bytes swapped, always a multiple of 16
+ */
+static size_t swap_vectorized(const void *src, void *dst, size_t bytes, const uint8_t *mask) {
+    if (bytes < 16) return 0;
+    pthread_once(&swapKernelOnce, select_swap_kernel);
+    if (swapKernelFunc == NULL) return 0;
+    return swapKernelFunc((const uint8_t *) src, (uint8_t *) dst, bytes, mask);
+}
+
+
 /**
  * @addtogroup swap
  * @{
@@ -481,7 +685,9 @@ uint32_t *swap_int32_t(uint32_t *data, unsigned int length, uint32_t *dest) {
         dest = data;
     }
 
-    for (i=0; i < length; i++) {
+    /* large arrays are swapped mostly with vector instructions, the rest here */
+    i = (unsigned int) (swap_vectorized(data, dest, (size_t)length * 4, swap32Mask) / 4);
+    for (; i < length; i++) {
         dest[i] = EVIO_SWAP32(data[i]);
     }
     
@@ -506,7 +712,9 @@ uint64_t *swap_int64_t(uint64_t *data, unsigned int length, uint64_t *dest) {
         dest = data;
     }
 
-    for (i=0; i < length; i++) {
+    /* large arrays are swapped mostly with vector instructions, the rest here */
+    i = (unsigned int) (swap_vectorized(data, dest, (size_t)length * 8, swap64Mask) / 8);
+    for (; i < length; i++) {
         dest[i] = EVIO_SWAP64(data[i]);
     }
 
@@ -531,7 +739,9 @@ uint16_t *swap_int16_t(uint16_t *data, unsigned int length, uint16_t *dest) {
         dest = data;
     }
 
-    for (i=0; i < length; i++) {
+    /* large arrays are swapped mostly with vector instructions, the rest here */
+    i = (unsigned int) (swap_vectorized(data, dest, (size_t)length * 2, swap16Mask) / 2);
+    for (; i < length; i++) {
         dest[i] = (uint16_t) EVIO_SWAP16(data[i]);
     }
 
@@ -581,8 +791,8 @@ static int swap_composite_t(uint32_t *data, int tolocal, uint32_t *dest, uint32_
 
     char *formatString;
     uint32_t *d, *pData, formatLen, dataLen;
-    int nfmt, inPlace, wordLen;
-    unsigned short ifmt[1024];
+    int status, inPlace, wordLen;
+    const evioFormat *format;
     int64_t len = length;  /* the algorithm below does not guarantee positive length */
 
     /* swap in place or copy ? */
@@ -636,15 +846,15 @@ static int swap_composite_t(uint32_t *data, int tolocal, uint32_t *dest, uint32_
         /* get start of composite data, will be swapped in place */
         pData = &(d[formatLen+3]);
 
-        /* swap composite data: convert format string to internal format, then call formatted swap routine */
-        if ((nfmt = eviofmt(formatString, ifmt, 1024)) > 0 ) {
-            if (eviofmtswap(pData, dataLen, ifmt, nfmt, tolocal, 0)) {
-                printf("swap_composite_t: eviofmtswap returned error, bad arg(s)\n");
+        /* swap composite data: get format string's cached internal format, then call formatted swap routine */
+        if ((status = evFmtCompileData(formatString, 4*formatLen, &format)) == S_SUCCESS) {
+            if (evFmtSwap((int32_t *)pData, dataLen, format, tolocal, 0) != S_SUCCESS) {
+                printf("swap_composite_t: evFmtSwap returned error, bad arg(s)\n");
                 return S_FAILURE;
             }
         }
         else {
-            printf("swap_composite_t: error %d in eviofmt\n", nfmt);
+            printf("swap_composite_t: error 0x%x translating format\n", status);
             return S_FAILURE;
         }
 
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#include "AsyncFileWriteBackend.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param queueDepth max number of writes in flight at once.
+     */
+    AsyncFileWriteBackend::AsyncFileWriteBackend(uint32_t queueDepth) : FileWriteBackend(queueDepth) {}
+
+
+    /** Destructor. Waits for writes in flight since they use this object's file descriptor. */
+    AsyncFileWriteBackend::~AsyncFileWriteBackend() {
+        try {
+            waitForAll();
+        }
+        catch (EvioException & e) {}
+    }
+
+
+    /**
+     * Get the type of this backend.
+     * @return ASYNC.
+     */
+    FileWriteBackend::Type AsyncFileWriteBackend::getType() const {return ASYNC;}
+
+
+    /**
+     * Wait for the oldest write in flight to finish and release its ring item.
+     * Call while holding writeMutex.
+     */
+    void AsyncFileWriteBackend::completeOldest() {
+        PendingWrite & oldest = pending.front();
+
+        try {
+            oldest.future.get();
+        }
+        catch (EvioException & e) {
+            setError(e.what());
+        }
+
+        writeDone(oldest.item);
+        pending.pop_front();
+    }
+
+
+    /** {@inheritDoc} */
+    void AsyncFileWriteBackend::queueWrite(const uint8_t *data, size_t len, uint64_t position,
+                                           std::shared_ptr<RecordRingItem> const & item) {
+        while (pending.size() >= queueDepth) {
+            completeOldest();
+        }
+        throwIfError();
+
+        void (*write)(int, const uint8_t *, size_t, uint64_t) = writeFully;
+        pending.push_back(PendingWrite{std::async(std::launch::async,  // run in a separate thread
+                                                  write,               // function to run
+                                                  fd, data, len, position),
+                                       item});
+        writesQueued++;
+    }
+
+
+    /**
+     * Queue a write of data gathered from several buffers, done with a single pwritev
+     * in a std::async thread. Called while holding writeMutex.
+     *
+     * @param segments  data to write, in order.
+     * @param position  position in the file at which to write the first segment.
+     * @param item      ring item containing the data, may be null.
+     */
+    void AsyncFileWriteBackend::queueGatherWrite(const std::vector<ByteBufferView> & segments, uint64_t position,
+                                                 std::shared_ptr<RecordRingItem> const & item) {
+        while (pending.size() >= queueDepth) {
+            completeOldest();
+        }
+        throwIfError();
+
+        void (*gatherWrite)(int, std::vector<ByteBufferView>, uint64_t) = writeFully;
+        pending.push_back(PendingWrite{std::async(std::launch::async,  // run in a separate thread
+                                                  gatherWrite,         // function to run
+                                                  fd, segments, position),
+                                       item});
+        writesQueued++;
+    }
+
+
+    /** {@inheritDoc} */
+    void AsyncFileWriteBackend::waitForWrites(uint64_t count) {
+        while (!pending.empty() && writesCompleted < count) {
+            completeOldest();
+        }
+    }
+
+}
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#ifndef EVIO_6_0_ASYNCFILEWRITEBACKEND_H
+#define EVIO_6_0_ASYNCFILEWRITEBACKEND_H
+
+
+#include <deque>
+#include <future>
+#include <memory>
+
+
+#include "FileWriteBackend.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is the portable {@link FileWriteBackend}. Each write is done with pwrite
+     * in a separate thread started by std::async. With a queue depth of 1 this is how
+     * EventWriter has always written files.
+     */
+    class AsyncFileWriteBackend : public FileWriteBackend {
+
+    private:
+
+        /** A write in flight. */
+        struct PendingWrite {
+            /** Future of the thread doing the write. */
+            std::future<void> future;
+            /** Ring item being written, may be null. */
+            std::shared_ptr<RecordRingItem> item;
+        };
+
+        /** Writes in flight, oldest first. */
+        std::deque<PendingWrite> pending;
+
+        void completeOldest();
+
+    protected:
+
+        void queueWrite(const uint8_t *data, size_t len, uint64_t position,
+                        std::shared_ptr<RecordRingItem> const & item) override;
+        void queueGatherWrite(const std::vector<ByteBufferView> & segments, uint64_t position,
+                              std::shared_ptr<RecordRingItem> const & item) override;
+        void waitForWrites(uint64_t count) override;
+
+    public:
+
+        explicit AsyncFileWriteBackend(uint32_t queueDepth);
+        ~AsyncFileWriteBackend() override;
+
+        Type getType() const override;
+    };
+
+}
+
+
+#endif //EVIO_6_0_ASYNCFILEWRITEBACKEND_H
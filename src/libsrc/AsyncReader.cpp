@@ -0,0 +1,208 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "AsyncReader.h"
+
+#include "RecordInput.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which starts the threads.
+     * @param threadCount number of threads, 0 for one per cpu core.
+     */
+    AsyncReadPool::AsyncReadPool(uint32_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1U, boost::thread::hardware_concurrency());
+        }
+
+        threads.reserve(threadCount);
+        for (uint32_t i=0; i < threadCount; i++) {
+            threads.emplace_back([this]() {this->run();});
+        }
+    }
+
+
+    /** Destructor which runs the tasks already submitted, then stops the threads. */
+    AsyncReadPool::~AsyncReadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cond.notify_all();
+
+        for (auto & thd : threads) {
+            thd.join();
+        }
+    }
+
+
+    /**
+     * Hand a task to the next free thread.
+     * @param task task to run.
+     */
+    void AsyncReadPool::submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.push_back(std::move(task));
+        }
+        cond.notify_one();
+    }
+
+
+    /** Method to run in each thread. */
+    void AsyncReadPool::run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cond.wait(lock, [this]() {return stopping || !tasks.empty();});
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+
+    //////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Constructor. Reading starts with the first record.
+     * Both reader and pool must outlive this object.
+     * @param reader reader of the file or buffer.
+     * @param pool   threads doing the reads.
+     */
+    AsyncReader::AsyncReader(Reader & reader, AsyncReadPool & pool) : reader(reader), pool(pool) {}
+
+
+    /**
+     * Go back to reading from the first record.
+     * @throws EvioException if a read is in flight.
+     */
+    void AsyncReader::rewind() {
+        claim();
+        nextRecordIndex = 0;
+        nextEventIndex  = 0;
+        eventsInRecord  = 0;
+        busy = false;
+    }
+
+
+    /**
+     * Mark a read as in flight.
+     * @throws EvioException if one already is.
+     */
+    void AsyncReader::claim() {
+        if (busy.exchange(true)) {
+            throw EvioException("an asynchronous read is already in flight");
+        }
+    }
+
+
+    /**
+     * Read the next record, done in a pool thread.
+     * @return true if read, false if there are no more.
+     */
+    bool AsyncReader::readRecord() {
+        if (nextRecordIndex >= reader.getRecordCount()) {
+            return false;
+        }
+        reader.readRecord(nextRecordIndex++);
+        nextEventIndex = 0;
+        eventsInRecord = reader.getCurrentRecordStream().getEntries();
+        return true;
+    }
+
+
+    /**
+     * Get the next event of the current record.
+     * @param event set to the event if there is one.
+     * @return true if there was one.
+     */
+    bool AsyncReader::currentEvent(ByteBufferView & event) {
+        if (nextEventIndex >= eventsInRecord) {
+            return false;
+        }
+        event = reader.getCurrentRecordStream().getEventView(nextEventIndex++);
+        return true;
+    }
+
+
+    /**
+     * Read the next record in a pool thread, which then calls the callback.
+     * The record is then the Reader's current record.
+     * @param callback called, in a pool thread, once the record is read.
+     * @throws EvioException if a read is already in flight.
+     */
+    void AsyncReader::readNextRecord(RecordCallback callback) {
+        claim();
+
+        pool.submit([this, callback]() {
+            bool haveRecord = false;
+            std::exception_ptr error;
+            try {
+                haveRecord = readRecord();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            busy = false;
+            callback(haveRecord, error);
+        });
+    }
+
+
+    /**
+     * Get the next event, reading records in a pool thread until one is found,
+     * which then calls the callback. The event is valid until the next record is read.
+     * If the current record has more events, use {@link #tryNextEvent(ByteBufferView &)}
+     * to get one without a thread switch.
+     * @param callback called, in a pool thread, with the event, empty if no more.
+     * @throws EvioException if a read is already in flight.
+     */
+    void AsyncReader::readNextEvent(EventCallback callback) {
+        claim();
+
+        pool.submit([this, callback]() {
+            ByteBufferView event;
+            std::exception_ptr error;
+            try {
+                // Skip any records with no events
+                while (!currentEvent(event) && readRecord()) {}
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            busy = false;
+            callback(event, error);
+        });
+    }
+
+
+    /**
+     * Get the next event if it's in the record already read, without blocking.
+     * @param event set to the event if there is one.
+     * @return true if there was one, false if a record must be read
+     *         with {@link #readNextEvent(EventCallback)}.
+     * @throws EvioException if a read is in flight.
+     */
+    bool AsyncReader::tryNextEvent(ByteBufferView & event) {
+        if (busy) {
+            throw EvioException("an asynchronous read is already in flight");
+        }
+        return currentEvent(event);
+    }
+
+}
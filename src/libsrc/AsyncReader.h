@@ -0,0 +1,221 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_ASYNCREADER_H
+#define EVIO_6_0_ASYNCREADER_H
+
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+
+// Coroutines are only available when compiled as C++20 or later
+#if defined(__has_include)
+    #if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+        #include <coroutine>
+        #define EVIO_HAVE_COROUTINES 1
+    #endif
+#endif
+
+
+#include "Reader.h"
+#include "ByteBufferView.h"
+#include "EvioException.h"
+
+
+#include <boost/thread.hpp>
+
+
+namespace evio {
+
+
+    /**
+     * This class is a small pool of threads doing the blocking reads of any number of
+     * {@link AsyncReader}s. Many files can be read by a few threads, none of which belong
+     * to the application, so that an event-driven service never blocks when a record
+     * must be read and uncompressed.
+     */
+    class AsyncReadPool {
+
+    private:
+
+        /** Tasks waiting for a thread, oldest first. */
+        std::deque<std::function<void()>> tasks;
+        /** Guards tasks and stopping. */
+        std::mutex mtx;
+        /** Wakes threads when there's a task or it's time to stop. */
+        std::condition_variable cond;
+        /** Has the pool been told to stop? */
+        bool stopping = false;
+        /** Threads running tasks. */
+        std::vector<boost::thread> threads;
+
+        void run();
+
+    public:
+
+        explicit AsyncReadPool(uint32_t threadCount = 1);
+        AsyncReadPool(const AsyncReadPool & pool) = delete;
+        AsyncReadPool & operator=(const AsyncReadPool & pool) = delete;
+        ~AsyncReadPool();
+
+        void submit(std::function<void()> task);
+
+        /** @return number of threads in pool. */
+        uint32_t getThreadCount() const {return (uint32_t) threads.size();}
+    };
+
+
+    /**
+     * This class reads the records and events of a {@link Reader} asynchronously.
+     * Each read which needs a new record is handed to an {@link AsyncReadPool} thread,
+     * which reads (and uncompresses) it with the Reader's own {@link Reader#readRecord(uint32_t)}.
+     * Completion is signaled through a callback or, when compiled as C++20,
+     * by resuming a coroutine:
+     *
+     * <pre><code>
+     *    AsyncReadPool pool(2);
+     *    Reader reader("run.evio");
+     *    AsyncReader async(reader, pool);
+     *
+     *    Task process(AsyncReader &amp; async) {
+     *        while (true) {
+     *            ByteBufferView event = co_await async.nextEvent();
+     *            if (event.empty()) break;
+     *            ...
+     *        }
+     *    }
+     * </code></pre>
+     *
+     * The record read is the Reader's current record, so the synchronous API sees the same
+     * record (for example {@link Reader#getCurrentRecordStream()}) and the Reader's
+     * decompression read-ahead, if on, is used by both. Only one asynchronous read may be
+     * in flight at a time, and the Reader must not be used otherwise while one is.
+     * Callbacks are run, and coroutines resumed, in a pool thread.
+     */
+    class AsyncReader {
+
+    public:
+
+        /** Called once a record is read, with true if there was one, or with the exception thrown. */
+        typedef std::function<void(bool haveRecord, std::exception_ptr error)> RecordCallback;
+
+        /** Called once an event is found, empty if there are no more, or with the exception thrown. */
+        typedef std::function<void(ByteBufferView const & event, std::exception_ptr error)> EventCallback;
+
+    private:
+
+        /** Reader of the file or buffer. */
+        Reader & reader;
+        /** Threads doing the reads. */
+        AsyncReadPool & pool;
+
+        /** Index of next record to read. */
+        uint32_t nextRecordIndex = 0;
+        /** Index of next event in the current record. */
+        uint32_t nextEventIndex = 0;
+        /** Number of events in the current record, 0 if none read. */
+        uint32_t eventsInRecord = 0;
+        /** Is a read in flight? */
+        std::atomic<bool> busy{false};
+
+        void claim();
+        bool readRecord();
+        bool currentEvent(ByteBufferView & event);
+
+    public:
+
+        AsyncReader(Reader & reader, AsyncReadPool & pool);
+
+        /** @return reader of the file or buffer. */
+        Reader & getReader() {return reader;}
+        /** @return index of the next record to be read. */
+        uint32_t getNextRecordIndex() const {return nextRecordIndex;}
+
+        void rewind();
+
+        void readNextRecord(RecordCallback callback);
+        void readNextEvent(EventCallback callback);
+        bool tryNextEvent(ByteBufferView & event);
+
+
+#ifdef EVIO_HAVE_COROUTINES
+
+        /** Awaitable which reads the next record, giving true if there was one. */
+        class RecordAwaiter {
+            AsyncReader & async;
+            bool haveRecord = false;
+            std::exception_ptr error;
+        public:
+            explicit RecordAwaiter(AsyncReader & asyncReader) : async(asyncReader) {}
+            bool await_ready() const noexcept {return false;}
+            void await_suspend(std::coroutine_handle<> handle) {
+                async.readNextRecord([this, handle](bool have, std::exception_ptr e) {
+                    haveRecord = have;
+                    error = e;
+                    handle.resume();
+                });
+            }
+            bool await_resume() {
+                if (error) std::rethrow_exception(error);
+                return haveRecord;
+            }
+        };
+
+
+        /** Awaitable which gives the next event, empty if there are no more.
+         *  It only suspends if a record must be read. */
+        class EventAwaiter {
+            AsyncReader & async;
+            ByteBufferView event;
+            std::exception_ptr error;
+        public:
+            explicit EventAwaiter(AsyncReader & asyncReader) : async(asyncReader) {}
+            bool await_ready() {return async.tryNextEvent(event);}
+            void await_suspend(std::coroutine_handle<> handle) {
+                async.readNextEvent([this, handle](ByteBufferView const & ev, std::exception_ptr e) {
+                    event = ev;
+                    error = e;
+                    handle.resume();
+                });
+            }
+            ByteBufferView await_resume() {
+                if (error) std::rethrow_exception(error);
+                return event;
+            }
+        };
+
+
+        /**
+         * Read the next record: <code>bool haveRecord = co_await async.nextRecord();</code>
+         * @return awaitable giving true if a record was read, false if there are no more.
+         */
+        RecordAwaiter nextRecord() {return RecordAwaiter(*this);}
+
+        /**
+         * Get the next event: <code>ByteBufferView event = co_await async.nextEvent();</code>
+         * The event is valid until the next record is read.
+         * @return awaitable giving the event, empty if there are no more.
+         */
+        EventAwaiter nextEvent() {return EventAwaiter(*this);}
+
+#endif
+    };
+
+}
+
+
+#endif //EVIO_6_0_ASYNCREADER_H
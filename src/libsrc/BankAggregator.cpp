@@ -0,0 +1,666 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "BankAggregator.h"
+#include "EventHeaderParser.h"
+#include "ParallelEventReader.h"
+#include "RecordInput.h"
+#include "Reader.h"
+#include "ByteOrder.h"
+#include "DataType.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <boost/thread.hpp>
+
+
+// Reductions of 32-bit integers, floats and doubles use AVX2 if the cpu has it,
+// which is found at run time, the same as for byte swapping (see ByteOrder.cpp).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define EVIO_AGGREGATE_X86 1
+    #include <immintrin.h>
+#endif
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** Number of values reduced at a time from a buffer, once swapped or copied. */
+        const size_t BLOCK_VALUES = 1024;
+
+        /** Sums, extremes and counts found by a kernel, added into a Result. */
+        struct Moments {
+            double sum = 0.;
+            double sumSquares = 0.;
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+            uint64_t above = 0;
+
+            void addTo(BankAggregator::Result & r, size_t count) const {
+                r.count      += count;
+                r.above      += above;
+                r.sum        += sum;
+                r.sumSquares += sumSquares;
+                r.min = std::min(r.min, min);
+                r.max = std::max(r.max, max);
+            }
+        };
+
+        /**
+         * Type of function which reduces values of one type in local byte order, 4-byte aligned,
+         * as many whole vectors as fit. It returns how many values it did.
+         */
+        typedef size_t (*VectorKernel)(const uint8_t *data, size_t count, double threshold, Moments & m);
+
+        /** Name of the kernels in use, returned by BankAggregator::getKernelImplementation(). */
+        const char *kernelName = "scalar";
+
+#ifdef EVIO_AGGREGATE_X86
+
+        __attribute__((target("avx2")))
+        size_t reduceInt32Avx2(const uint8_t *data, size_t count, double threshold, Moments & m) {
+            // For integers, x > threshold is x > floor(threshold), leave the odd cases to scalar code
+            if (std::isnan(threshold) || threshold < (double)INT32_MIN) return 0;
+            double t = std::floor(threshold);
+            int32_t thr = t >= (double)INT32_MAX ? INT32_MAX : (int32_t)t;
+
+            __m256i vmin   = _mm256_set1_epi32(INT32_MAX);
+            __m256i vmax   = _mm256_set1_epi32(INT32_MIN);
+            __m256i vthr   = _mm256_set1_epi32(thr);
+            __m256i vabove = _mm256_setzero_si256();
+            __m256i vsum   = _mm256_setzero_si256();
+            __m256d vsq    = _mm256_setzero_pd();
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 4*i));
+                vmin = _mm256_min_epi32(vmin, x);
+                vmax = _mm256_max_epi32(vmax, x);
+                // Comparison gives -1 for each lane above
+                vabove = _mm256_sub_epi32(vabove, _mm256_cmpgt_epi32(x, vthr));
+
+                __m128i lo = _mm256_castsi256_si128(x);
+                __m128i hi = _mm256_extracti128_si256(x, 1);
+                vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(lo));
+                vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(hi));
+                __m256d dlo = _mm256_cvtepi32_pd(lo);
+                __m256d dhi = _mm256_cvtepi32_pd(hi);
+                vsq = _mm256_add_pd(vsq, _mm256_mul_pd(dlo, dlo));
+                vsq = _mm256_add_pd(vsq, _mm256_mul_pd(dhi, dhi));
+            }
+            if (i == 0) return 0;
+
+            alignas(32) int32_t mins[8], maxs[8], aboves[8];
+            alignas(32) int64_t sums[4];
+            alignas(32) double sqs[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(mins), vmin);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(maxs), vmax);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(aboves), vabove);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(sums), vsum);
+            _mm256_store_pd(sqs, vsq);
+
+            int64_t sum = 0;
+            for (int j=0; j < 8; j++) {
+                m.min = std::min(m.min, (double)mins[j]);
+                m.max = std::max(m.max, (double)maxs[j]);
+                m.above += (uint32_t)aboves[j];
+            }
+            for (int j=0; j < 4; j++) {
+                sum += sums[j];
+                m.sumSquares += sqs[j];
+            }
+            m.sum += (double)sum;
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        size_t reduceFloatAvx2(const uint8_t *data, size_t count, double threshold, Moments & m) {
+            if (std::isnan(threshold)) return 0;
+
+            // Values are summed as doubles, as the scalar code does
+            __m256  vmin = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+            __m256  vmax = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+            __m256d vthr = _mm256_set1_pd(threshold);
+            __m256d vsum = _mm256_setzero_pd();
+            __m256d vsq  = _mm256_setzero_pd();
+            uint64_t above = 0;
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m256 x = _mm256_loadu_ps(reinterpret_cast<const float *>(data + 4*i));
+                // With x first, a NaN in x leaves min and max alone
+                vmin = _mm256_min_ps(x, vmin);
+                vmax = _mm256_max_ps(x, vmax);
+
+                __m256d dlo = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+                __m256d dhi = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+                vsum = _mm256_add_pd(vsum, _mm256_add_pd(dlo, dhi));
+                vsq  = _mm256_add_pd(vsq, _mm256_add_pd(_mm256_mul_pd(dlo, dlo), _mm256_mul_pd(dhi, dhi)));
+                above += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(dlo, vthr, _CMP_GT_OQ)));
+                above += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(dhi, vthr, _CMP_GT_OQ)));
+            }
+            if (i == 0) return 0;
+
+            alignas(32) float mins[8], maxs[8];
+            alignas(32) double sums[4], sqs[4];
+            _mm256_store_ps(mins, vmin);
+            _mm256_store_ps(maxs, vmax);
+            _mm256_store_pd(sums, vsum);
+            _mm256_store_pd(sqs, vsq);
+
+            for (int j=0; j < 8; j++) {
+                m.min = std::min(m.min, (double)mins[j]);
+                m.max = std::max(m.max, (double)maxs[j]);
+            }
+            for (int j=0; j < 4; j++) {
+                m.sum += sums[j];
+                m.sumSquares += sqs[j];
+            }
+            m.above += above;
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        size_t reduceDoubleAvx2(const uint8_t *data, size_t count, double threshold, Moments & m) {
+            if (std::isnan(threshold)) return 0;
+
+            __m256d vmin = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+            __m256d vmax = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+            __m256d vthr = _mm256_set1_pd(threshold);
+            __m256d vsum = _mm256_setzero_pd();
+            __m256d vsq  = _mm256_setzero_pd();
+            uint64_t above = 0;
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d x = _mm256_loadu_pd(reinterpret_cast<const double *>(data + 8*i));
+                vmin = _mm256_min_pd(x, vmin);
+                vmax = _mm256_max_pd(x, vmax);
+                vsum = _mm256_add_pd(vsum, x);
+                vsq  = _mm256_add_pd(vsq, _mm256_mul_pd(x, x));
+                above += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(x, vthr, _CMP_GT_OQ)));
+            }
+            if (i == 0) return 0;
+
+            alignas(32) double mins[4], maxs[4], sums[4], sqs[4];
+            _mm256_store_pd(mins, vmin);
+            _mm256_store_pd(maxs, vmax);
+            _mm256_store_pd(sums, vsum);
+            _mm256_store_pd(sqs, vsq);
+
+            for (int j=0; j < 4; j++) {
+                m.min = std::min(m.min, mins[j]);
+                m.max = std::max(m.max, maxs[j]);
+                m.sum += sums[j];
+                m.sumSquares += sqs[j];
+            }
+            m.above += above;
+            return i;
+        }
+
+        /** Vector kernels picked for this cpu, null where there are none. */
+        struct VectorKernels {
+            VectorKernel int32 = nullptr;
+            VectorKernel float32 = nullptr;
+            VectorKernel float64 = nullptr;
+        };
+
+        VectorKernels selectKernels() {
+            VectorKernels k;
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                kernelName = "avx2";
+                k.int32   = reduceInt32Avx2;
+                k.float32 = reduceFloatAvx2;
+                k.float64 = reduceDoubleAvx2;
+            }
+            return k;
+        }
+
+#else
+
+        struct VectorKernels {
+            VectorKernel int32 = nullptr;
+            VectorKernel float32 = nullptr;
+            VectorKernel float64 = nullptr;
+        };
+
+        VectorKernels selectKernels() {return VectorKernels();}
+
+#endif
+
+        /** @return kernels picked the first time this is called (thread safe). */
+        VectorKernels const & getKernels() {
+            static const VectorKernels kernels = selectKernels();
+            return kernels;
+        }
+
+        /** @return vector kernel for values of the given type, null if none. */
+        template<typename T> VectorKernel vectorKernel() {return nullptr;}
+        template<> VectorKernel vectorKernel<int32_t>() {return getKernels().int32;}
+        template<> VectorKernel vectorKernel<float>()   {return getKernels().float32;}
+        template<> VectorKernel vectorKernel<double>()  {return getKernels().float64;}
+
+
+        /**
+         * Reduce values, in local byte order and aligned, one at a time.
+         * @param v         values.
+         * @param count     number of values.
+         * @param threshold values greater than this are counted.
+         * @param m         moments to add to.
+         */
+        template<typename T>
+        void reduceScalar(const T *v, size_t count, double threshold, Moments & m) {
+            double sum = 0., sq = 0., mn = m.min, mx = m.max;
+            uint64_t above = 0;
+            for (size_t i=0; i < count; i++) {
+                double x = (double)v[i];
+                sum += x;
+                sq  += x*x;
+                mn = x < mn ? x : mn;
+                mx = x > mx ? x : mx;
+                above += x > threshold;
+            }
+            m.sum += sum;
+            m.sumSquares += sq;
+            m.min = mn;
+            m.max = mx;
+            m.above += above;
+        }
+
+
+        /**
+         * Copy values into dst, swapping them if need be.
+         * @param src   values.
+         * @param count number of values.
+         * @param swap  if true, swap values.
+         * @param dst   4-byte aligned destination.
+         */
+        template<typename T>
+        void copyValues(const uint8_t *src, size_t count, bool swap, T *dst) {
+            if (!swap || sizeof(T) == 1) {
+                std::memcpy(dst, src, count*sizeof(T));
+            }
+            else if (sizeof(T) == 2) {
+                ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(const_cast<uint8_t *>(src)), count,
+                                      reinterpret_cast<uint16_t *>(dst));
+            }
+            else if (sizeof(T) == 4) {
+                ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(src)), count,
+                                      reinterpret_cast<uint32_t *>(dst));
+            }
+            else {
+                ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(src)), count,
+                                      reinterpret_cast<uint64_t *>(dst));
+            }
+        }
+
+
+        /**
+         * Reduce values of one type. Values in local byte order are reduced in place by
+         * a vector kernel if there is one. The rest are swapped or copied, a block at a time,
+         * into an aligned buffer and reduced from there.
+         * @param data      values.
+         * @param count     number of values.
+         * @param swap      if true, values are in the other byte order.
+         * @param threshold values greater than this are counted.
+         * @param r         result to add to.
+         */
+        template<typename T>
+        void reduceValues(const uint8_t *data, size_t count, bool swap, double threshold,
+                          BankAggregator::Result & r) {
+            Moments m;
+            VectorKernel vk = vectorKernel<T>();
+
+            size_t done = 0;
+            if (vk != nullptr && !swap) {
+                done = vk(data, count, threshold, m);
+            }
+
+            alignas(32) T block[BLOCK_VALUES];
+            while (done < count) {
+                size_t n = std::min(BLOCK_VALUES, count - done);
+                copyValues<T>(data + done*sizeof(T), n, swap, block);
+
+                size_t i = 0;
+                if (vk != nullptr) {
+                    i = vk(reinterpret_cast<const uint8_t *>(block), n, threshold, m);
+                }
+                reduceScalar<T>(block + i, n - i, threshold, m);
+                done += n;
+            }
+
+            m.addTo(r, count);
+        }
+
+
+        /**
+         * Size of the values of a data type.
+         * @param dataType type of data, as a DataType value.
+         * @return bytes in each value, 0 if not a type of numbers.
+         */
+        size_t valueBytes(uint8_t dataType) {
+            switch (dataType) {
+                case 0x6: case 0x7:                      return 1;
+                case 0x4: case 0x5:                      return 2;
+                case 0x1: case 0x2: case 0xb:            return 4;
+                case 0x8: case 0x9: case 0xa:            return 8;
+                default:                                 return 0;
+            }
+        }
+
+
+        /**
+         * Reduce the values of a bank.
+         * @param data      values.
+         * @param count     number of values.
+         * @param dataType  type of data, as a DataType value.
+         * @param swap      if true, values are in the other byte order.
+         * @param threshold values greater than this are counted.
+         * @param r         result to add to.
+         */
+        void reduceData(const uint8_t *data, size_t count, uint8_t dataType, bool swap,
+                        double threshold, BankAggregator::Result & r) {
+            switch (dataType) {
+                case 0x1: reduceValues<uint32_t>(data, count, swap, threshold, r); break;
+                case 0x2: reduceValues<float>   (data, count, swap, threshold, r); break;
+                case 0x4: reduceValues<int16_t> (data, count, swap, threshold, r); break;
+                case 0x5: reduceValues<uint16_t>(data, count, swap, threshold, r); break;
+                case 0x6: reduceValues<int8_t>  (data, count, swap, threshold, r); break;
+                case 0x7: reduceValues<uint8_t> (data, count, swap, threshold, r); break;
+                case 0x8: reduceValues<double>  (data, count, swap, threshold, r); break;
+                case 0x9: reduceValues<int64_t> (data, count, swap, threshold, r); break;
+                case 0xa: reduceValues<uint64_t>(data, count, swap, threshold, r); break;
+                case 0xb: reduceValues<int32_t> (data, count, swap, threshold, r); break;
+                default: break;
+            }
+        }
+    }
+
+
+    //---------------------------------------
+    // Result
+    //---------------------------------------
+
+
+    /**
+     * Add another partial result into this one.
+     * User values are added element by element, this one growing as needed.
+     * @param other partial result to add.
+     */
+    void BankAggregator::Result::merge(Result const & other) {
+        events     += other.events;
+        banks      += other.banks;
+        count      += other.count;
+        above      += other.above;
+        sum        += other.sum;
+        sumSquares += other.sumSquares;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+
+        if (user.size() < other.user.size()) {
+            user.resize(other.user.size(), 0.);
+        }
+        for (size_t i=0; i < other.user.size(); i++) {
+            user[i] += other.user[i];
+        }
+    }
+
+
+    /**
+     * Get the variance of the values.
+     * @return variance of values, 0 if none.
+     */
+    double BankAggregator::Result::variance() const {
+        if (count < 1) return 0.;
+        double m = mean();
+        double v = sumSquares/count - m*m;
+        return v > 0. ? v : 0.;
+    }
+
+
+    //---------------------------------------
+    // BankAggregator
+    //---------------------------------------
+
+
+    /**
+     * Constructor selecting banks of a tag and num.
+     * @param tag tag of banks.
+     * @param num num of banks.
+     */
+    BankAggregator::BankAggregator(uint16_t tag, uint8_t num) : tag(tag), num(num) {}
+
+
+    /**
+     * Constructor selecting banks of a tag, regardless of num.
+     * @param tag tag of banks.
+     */
+    BankAggregator::BankAggregator(uint16_t tag) : tag(tag), anyNum(true) {}
+
+
+    /**
+     * Constructor selecting banks of a dictionary name.
+     * @param name       dictionary name of banks.
+     * @param dictionary dictionary giving the banks' tag and num.
+     * @throws EvioException if name is not in dictionary.
+     */
+    BankAggregator::BankAggregator(std::string const & name, EvioXMLDictionary const & dictionary) : tag(0) {
+        uint16_t tagEnd;
+        if (!dictionary.getTagNum(name, &tag, &num, &tagEnd)) {
+            throw EvioException("no dictionary entry for " + name);
+        }
+    }
+
+
+    /**
+     * Get the name of the vector instructions used by the built-in kernel on this cpu.
+     * @return "avx2" or "scalar".
+     */
+    const char * BankAggregator::getKernelImplementation() {
+        getKernels();
+        return kernelName;
+    }
+
+
+    /**
+     * Add the built-in quantities of a bank's data to a result, not counting the bank.
+     * Meant to be called by a user kernel which wants these too.
+     * @param payload   bank's data, in local byte order.
+     * @param threshold values greater than this are counted.
+     * @param result    result to add to.
+     */
+    void BankAggregator::reduce(Payload const & payload, double threshold, Result & result) {
+        reduceData(payload.data, payload.count, payload.dataType, false, threshold, result);
+    }
+
+
+    /**
+     * Add the selected banks of an event to a result.
+     * @param event  event.
+     * @param result result to add to.
+     * @throws EvioException if event is not properly formed.
+     *         Rethrows any exception thrown by a user kernel.
+     */
+    void BankAggregator::addEvent(ByteBufferView const & event, Result & result) {
+        addEvent(event, result, scratch);
+    }
+
+
+    /**
+     * Add the selected banks of all the events of a record to a result.
+     * @param record record read and uncompressed.
+     * @param result result to add to.
+     * @throws EvioException if an event is not properly formed.
+     *         Rethrows any exception thrown by a user kernel.
+     */
+    void BankAggregator::addRecord(RecordInput & record, Result & result) {
+        uint32_t count = record.getEntries();
+        for (uint32_t i=0; i < count; i++) {
+            addEvent(record.getEventView(i), result, scratch);
+        }
+    }
+
+
+    /**
+     * Reduce the selected banks of all the events of a reader.
+     * @param reader reader of file or buffer.
+     * @return result of all events.
+     * @throws EvioException if an event is not properly formed or cannot be read.
+     *         Rethrows any exception thrown by a user kernel.
+     */
+    BankAggregator::Result BankAggregator::aggregate(Reader & reader) {
+        Result result;
+        uint32_t count = reader.getEventCount();
+        for (uint32_t i=0; i < count; i++) {
+            addEvent(reader.getEventView(i), result, scratch);
+        }
+        return result;
+    }
+
+
+    /**
+     * Reduce the selected banks of all the events of the given files, in parallel.
+     * Records are read, uncompressed and reduced by worker threads (see
+     * {@link ParallelEventReader#forEachRecord}), each adding to its own partial result.
+     * Those are merged once all records are done.
+     *
+     * @param files   names of evio version 6 files.
+     * @param threads number of worker threads, 0 for one per cpu core.
+     * @param records if not null, cleared and filled with the partial result of each record,
+     *                in the order of the files and the records in them.
+     * @return result of all events.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format,
+     *                       or if an event is not properly formed.
+     *         Rethrows any exception thrown by a user kernel.
+     */
+    BankAggregator::Result BankAggregator::aggregate(std::vector<std::string> const & files, uint32_t threads,
+                                                     std::vector<RecordResult> *records) {
+
+        if (threads == 0) threads = std::max(1U, boost::thread::hardware_concurrency());
+
+        std::vector<Result> partials(threads);
+        std::vector<Scratch> scratches(threads);
+        std::mutex recordsMutex;
+        if (records != nullptr) records->clear();
+
+        ParallelEventReader::forEachRecord(files, threads,
+            [this, &partials, &scratches, &recordsMutex, records](RecordInput & record,
+                                                                 ParallelEventReader::EventInfo const & info) {
+                Scratch & s = scratches[info.threadNumber];
+                uint32_t count = record.getEntries();
+
+                if (records == nullptr) {
+                    for (uint32_t i=0; i < count; i++) {
+                        addEvent(record.getEventView(i), partials[info.threadNumber], s);
+                    }
+                    return;
+                }
+
+                RecordResult rr {info.fileIndex, info.recordIndex, Result()};
+                for (uint32_t i=0; i < count; i++) {
+                    addEvent(record.getEventView(i), rr.result, s);
+                }
+                partials[info.threadNumber].merge(rr.result);
+
+                std::lock_guard<std::mutex> lock(recordsMutex);
+                records->push_back(std::move(rr));
+            });
+
+        if (records != nullptr) {
+            std::sort(records->begin(), records->end(), [](RecordResult const & a, RecordResult const & b) {
+                return a.fileIndex != b.fileIndex ? a.fileIndex < b.fileIndex : a.recordIndex < b.recordIndex;
+            });
+        }
+
+        Result result;
+        for (auto const & p : partials) {
+            result.merge(p);
+        }
+        return result;
+    }
+
+
+    /**
+     * Add the selected banks of an event to a result.
+     * @param event  event.
+     * @param result result to add to.
+     * @param s      index and buffers of the calling thread.
+     * @throws EvioException if event is not properly formed.
+     */
+    void BankAggregator::addEvent(ByteBufferView const & event, Result & result, Scratch & s) {
+        result.events++;
+
+        EventHeaderParser::indexEvent(event.data(), event.size(), event.order(), s.index);
+        if (anyNum) {
+            s.index.search(tag, s.found);
+        }
+        else {
+            s.index.search(tag, num, s.found);
+        }
+
+        bool swap = !event.order().isLocalEndian();
+        for (uint32_t i : s.found) {
+            if (s.index.getType(i) != DataType::BANK.getValue()) continue;
+
+            size_t bytes = 4*(size_t)s.index.getDataLength(i);
+            if (s.index.getPad(i) <= bytes) bytes -= s.index.getPad(i);
+
+            addBank(event.data() + s.index.getDataPosition(i), bytes, s.index.getDataType(i), swap,
+                    s.index.getTag(i), s.index.getNum(i), result, s);
+        }
+    }
+
+
+    /**
+     * Add the data of a selected bank to a result, with the user kernel if there is one.
+     * Banks not holding numbers are passed over.
+     * @param data     bank's data.
+     * @param bytes    bytes of data, not including padding.
+     * @param dataType type of data, as a DataType value.
+     * @param swap     if true, data is in the other byte order.
+     * @param bankTag  tag of bank.
+     * @param bankNum  num of bank.
+     * @param result   result to add to.
+     * @param s        buffers of the calling thread.
+     */
+    void BankAggregator::addBank(const uint8_t *data, size_t bytes, uint8_t dataType, bool swap,
+                                 uint16_t bankTag, uint8_t bankNum, Result & result, Scratch & s) {
+        size_t width = valueBytes(dataType);
+        if (width == 0) return;
+
+        result.banks++;
+        size_t count = bytes/width;
+
+        if (!kernel) {
+            reduceData(data, count, dataType, swap, threshold, result);
+            return;
+        }
+
+        // A user kernel gets the whole bank's data in local byte order
+        if (swap && width > 1) {
+            s.swapped.resize(count*width);
+            switch (width) {
+                case 2: copyValues<uint16_t>(data, count, true, reinterpret_cast<uint16_t *>(s.swapped.data())); break;
+                case 4: copyValues<uint32_t>(data, count, true, reinterpret_cast<uint32_t *>(s.swapped.data())); break;
+                default: copyValues<uint64_t>(data, count, true, reinterpret_cast<uint64_t *>(s.swapped.data()));
+            }
+            data = s.swapped.data();
+        }
+
+        Payload payload {data, count, dataType, bankTag, bankNum};
+        kernel(payload, result);
+    }
+
+}
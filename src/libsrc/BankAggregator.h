@@ -0,0 +1,193 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_BANKAGGREGATOR_H
+#define EVIO_6_0_BANKAGGREGATOR_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <limits>
+#include <functional>
+
+
+#include "ByteBufferView.h"
+#include "StructureIndex.h"
+#include "EvioXMLDictionary.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class Reader;
+    class RecordInput;
+
+
+    /**
+     * This class computes quantities, such as those filling online histograms, over the
+     * data of one kind of bank across many events, without creating {@link EvioNode}s or
+     * copying data into vectors. The banks are found in each event's bytes with a
+     * {@link StructureIndex}, and their data is reduced where it lies.<p>
+     *
+     * Banks are selected by tag and num, by tag alone, or by dictionary name, and may
+     * be anywhere in an event. Only banks of numbers are used; others are passed over.
+     * The built-in kernel finds the count, sum, sum of squares, min, max, and number of
+     * values above a threshold. For 32-bit integers, floats and doubles it uses AVX2
+     * when the cpu has it, picked at run time. Data in the other byte order is swapped,
+     * a block at a time, into a small buffer first.<p>
+     *
+     * A user kernel may be set instead, which is handed each selected bank's data in local
+     * byte order and the partial {@link Result} to add to. Its own quantities, histogram
+     * bins for example, go into the result's vector of user values, which are merged by
+     * adding them. It may call {@link #reduce} to get the built-in quantities too.<p>
+     *
+     * Results are partial: one may be made for each event, record, or thread and merged
+     * with {@link Result#merge}. {@link #aggregate(std::vector<std::string> const &, uint32_t, std::vector<RecordResult> *)}
+     * reduces the records of files in parallel with {@link ParallelEventReader} and can
+     * return the partial result of each record as well as their merge.
+     *
+     * <pre><code>
+     *    BankAggregator agg(5, 1);
+     *    agg.setThreshold(100.);
+     *    BankAggregator::Result r = agg.aggregate(files, 8);
+     *    double mean = r.mean();
+     * </code></pre>
+     *
+     * A kernel set on an object is called from several threads at once when reducing
+     * files in parallel. Otherwise this class is not thread-safe.
+     */
+    class BankAggregator {
+
+    public:
+
+        /** Quantities computed over the data of selected banks, partial until all are merged. */
+        struct Result {
+            /** Number of events looked at. */
+            uint64_t events = 0;
+            /** Number of banks selected. */
+            uint64_t banks = 0;
+            /** Number of values reduced. */
+            uint64_t count = 0;
+            /** Number of values greater than the threshold. */
+            uint64_t above = 0;
+            /** Sum of values. */
+            double sum = 0.;
+            /** Sum of squares of values. */
+            double sumSquares = 0.;
+            /** Smallest value, +infinity if none. */
+            double min = std::numeric_limits<double>::infinity();
+            /** Largest value, -infinity if none. */
+            double max = -std::numeric_limits<double>::infinity();
+            /** Values of a user kernel, merged by adding element by element. */
+            std::vector<double> user;
+
+            void merge(Result const & other);
+
+            /** @return mean of values, 0 if none. */
+            double mean() const {return count > 0 ? sum/count : 0.;}
+            double variance() const;
+        };
+
+        /** Partial result of one record. */
+        struct RecordResult {
+            /** Index into the list of files. */
+            uint32_t fileIndex;
+            /** Index of the record in its file. */
+            uint32_t recordIndex;
+            /** Result of the record's events. */
+            Result result;
+        };
+
+        /** Data of a selected bank, in local byte order, valid only while a kernel is called. */
+        struct Payload {
+            /** Start of the data, aligned to 4 bytes. */
+            const uint8_t *data;
+            /** Number of values. */
+            size_t count;
+            /** Type of data, as a DataType value. */
+            uint8_t dataType;
+            /** Tag of bank. */
+            uint16_t tag;
+            /** Num of bank. */
+            uint8_t num;
+        };
+
+        /** User kernel, adding a bank's data to a partial result. */
+        typedef std::function<void(Payload const & payload, Result & partial)> Kernel;
+
+    private:
+
+        /** What's reused from event to event by one thread. */
+        struct Scratch {
+            /** Index of event. */
+            StructureIndex index;
+            /** Selected structures of event. */
+            std::vector<uint32_t> found;
+            /** Swapped data of a bank handed to a user kernel. */
+            std::vector<uint8_t> swapped;
+        };
+
+        /** Tag of banks selected. */
+        uint16_t tag;
+        /** Num of banks selected. */
+        uint8_t num = 0;
+        /** Select banks of any num? */
+        bool anyNum = false;
+        /** Values greater than this are counted. */
+        double threshold = 0.;
+        /** User kernel, called instead of the built-in one if set. */
+        Kernel kernel;
+        /** Used by the methods called from one thread. */
+        Scratch scratch;
+
+    public:
+
+        BankAggregator(uint16_t tag, uint8_t num);
+        explicit BankAggregator(uint16_t tag);
+        BankAggregator(std::string const & name, EvioXMLDictionary const & dictionary);
+
+        /** @param value values greater than this are counted in Result's above. */
+        void setThreshold(double value) {threshold = value;}
+        /** @return values greater than this are counted in Result's above. */
+        double getThreshold()     const {return threshold;}
+        /** @param k user kernel called instead of the built-in one, or an empty one for built-in. */
+        void setKernel(Kernel const & k) {kernel = k;}
+
+        /** @return tag of banks selected. */
+        uint16_t getTag()         const {return tag;}
+        /** @return num of banks selected. */
+        uint8_t getNum()          const {return num;}
+        /** @return true if banks of any num are selected. */
+        bool isAnyNum()           const {return anyNum;}
+
+        void addEvent(ByteBufferView const & event, Result & result);
+        void addRecord(RecordInput & record, Result & result);
+
+        Result aggregate(Reader & reader);
+        Result aggregate(std::vector<std::string> const & files, uint32_t threads = 0,
+                         std::vector<RecordResult> *records = nullptr);
+
+        static void reduce(Payload const & payload, double threshold, Result & result);
+        static const char * getKernelImplementation();
+
+    private:
+
+        void addEvent(ByteBufferView const & event, Result & result, Scratch & s);
+        void addBank(const uint8_t *data, size_t bytes, uint8_t dataType, bool swap,
+                     uint16_t bankTag, uint8_t bankNum, Result & result, Scratch & s);
+    };
+
+}
+
+
+#endif //EVIO_6_0_BANKAGGREGATOR_H
@@ -9,6 +9,11 @@
 
 #include "BaseStructure.h"
 
+#include <algorithm>
+
+#include "StructureQueryIndex.h"
+#include "EvioSwap.h"
+
 
 namespace evio {
 
@@ -62,6 +67,10 @@ namespace evio {
             header          = std::move(base.header);
 
             rawBytes        = std::move(base.rawBytes);
+            viewSource      = std::move(base.viewSource);
+            viewOffset      = base.viewOffset;
+            viewLength      = base.viewLength;
+            viewData        = base.viewData;
             shortData       = std::move(base.shortData);
             ushortData      = std::move(base.ushortData);
             intData         = std::move(base.intData);
@@ -99,6 +108,10 @@ namespace evio {
             header          = std::move(other.header);
 
             rawBytes        = std::move(other.rawBytes);
+            viewSource      = std::move(other.viewSource);
+            viewOffset      = other.viewOffset;
+            viewLength      = other.viewLength;
+            viewData        = other.viewData;
             shortData       = std::move(other.shortData);
             ushortData      = std::move(other.ushortData);
             intData         = std::move(other.intData);
@@ -165,6 +178,7 @@ namespace evio {
             for (auto const & kid : structure->children) {
                 children.push_back(kid);
             }
+            header->changed();
         }
     }
 
@@ -174,8 +188,10 @@ namespace evio {
      * @param other structure to copy data from.
      */
     void BaseStructure::copyData(BaseStructure const & other) {
-        // Copy over raw data
-        rawBytes = other.rawBytes;
+        // Copy over raw data, even if only viewed by other
+        rawBytes.assign(other.rawData(), other.rawData() + other.rawSize());
+        viewSource = nullptr;
+        viewData = nullptr;
 
         // Clear out old data
         shortData.clear();
@@ -262,8 +278,10 @@ namespace evio {
      * @param other structure to copy data from.
      */
     void BaseStructure::copyData(std::shared_ptr<BaseStructure> const & other) {
-        // Copy over raw data
-        rawBytes = other->rawBytes;
+        // Copy over raw data, even if only viewed by other
+        rawBytes.assign(other->rawData(), other->rawData() + other->rawSize());
+        viewSource = nullptr;
+        viewData = nullptr;
 
         // Clear out old data
         shortData.clear();
@@ -398,9 +416,22 @@ namespace evio {
         }
         newChild->setParent(getThis());
 
+        // An empty container's length is that of its data, not of children
+        bool hadChildren = !children.empty();
         children.insert(children.begin() + childIndex, newChild);
 
-        setLengthsUpToDate(false);
+        // Any index of either tree is now out of date
+        newChild->header->changed();
+        header->changed();
+
+        // Rather than have the whole tree recomputed later,
+        // add the child's length to this structure's and its ancestors' lengths
+        if (lengthsUpToDate && hadChildren) {
+            addToLengths((int64_t)newChild->setAllHeaderLengths() + 1);
+        }
+        else {
+            setLengthsUpToDate(false);
+        }
     }
 
 
@@ -428,7 +459,15 @@ namespace evio {
         }
 
         child->setParent(nullptr);
-        setLengthsUpToDate(false);
+        child->header->changed();
+        header->changed();
+
+        if (lengthsUpToDate && !children.empty()) {
+            addToLengths(-((int64_t)child->header->getLength() + 1));
+        }
+        else {
+            setLengthsUpToDate(false);
+        }
     }
 
 
@@ -441,10 +480,12 @@ namespace evio {
 
 
     /**
-     * Get the children of this structure.
+     * Get the children of this structure. Nothing is copied; the reference is valid
+     * only as long as this structure is and until a child is added or removed.
+     * Copy it to keep a snapshot.
      * @return the children of this structure.
      */
-    std::vector<std::shared_ptr<BaseStructure>> BaseStructure::getChildren() const {return children;}
+    const BaseStructure::Children & BaseStructure::getChildren() const {return children;}
 
 
     /**
@@ -770,15 +811,14 @@ namespace evio {
      * @return  the depth of the tree whose root is this node.
      */
     uint32_t BaseStructure::getDepth() {
-        auto iter1 = bbegin();
-        auto iter2 = bend();
-        auto last = iter1;
+        size_t depth = 0;
 
-        for (; iter1 != iter2; iter1++) {
-            last = iter1;
+        auto walk = depthFirst();
+        for (auto it = walk.begin(); it != walk.end(); ++it) {
+            depth = std::max(depth, it.getDepth());
         }
 
-        return (*last)->getLevel() - getLevel();
+        return static_cast<uint32_t>(depth);
     }
 
 
@@ -793,8 +833,8 @@ namespace evio {
     uint32_t BaseStructure::getLevel() const {
         uint32_t levels = 0;
 
-        auto ancestor = getThisConst();
-        while ((ancestor = ancestor->getParent()) != nullptr) {
+        // Follow raw pointers so no reference counts change
+        for (auto ancestor = parent.get(); ancestor != nullptr; ancestor = ancestor->parent.get()) {
             levels++;
         }
 
@@ -812,7 +852,29 @@ namespace evio {
       *         element is this node.
       */
     std::vector<std::shared_ptr<BaseStructure>> BaseStructure::getPath() {
-        return getPathToRoot(getThis(), 0);
+        std::vector<std::shared_ptr<BaseStructure>> path;
+        getPath(path);
+        return path;
+    }
+
+
+    /**
+     * Fill a vector with the path from the root, to get to this node.
+     * The vector's storage is reused, so calling this repeatedly with the
+     * same vector allocates only when a path is longer than any before it.
+     *
+     * @param path vector cleared, then filled with the path, where the first
+     *             element is the root and the last element is this node.
+     */
+    void BaseStructure::getPath(std::vector<std::shared_ptr<BaseStructure>> & path) {
+        path.clear();
+        path.resize(getLevel() + 1);
+
+        auto i = path.size();
+        path[--i] = getThis();
+        for (auto ancestor = parent.get(); ancestor != nullptr; ancestor = ancestor->parent.get()) {
+            path[--i] = ancestor->getThis();
+        }
     }
 
 
@@ -1382,7 +1444,8 @@ namespace evio {
       * @param listener a listener to notify as each structure is visited.
       */
     void BaseStructure::visitAllStructures(std::shared_ptr<IEvioListener> listener) {
-        visitAllDescendants(getThis(), listener, nullptr);
+        auto top = getThis();
+        visitAllDescendants(top, top, listener, nullptr);
     }
 
 
@@ -1398,7 +1461,8 @@ namespace evio {
      */
     void BaseStructure::visitAllStructures(std::shared_ptr<IEvioListener> listener,
                                           std::shared_ptr<IEvioFilter> filter) {
-        visitAllDescendants(getThis(), listener, filter);
+        auto top = getThis();
+        visitAllDescendants(top, top, listener, filter);
     }
 
 
@@ -1406,6 +1470,7 @@ namespace evio {
     * Visit all the descendants of a given structure
     * (which is considered a descendant of itself.)
     *
+    * @param top       the structure the visit started from, handed to the listener.
     * @param structure the starting structure.
     * @param listener a listener to notify as each structure is visited.
     * @param filter an optional filter that must "accept" structures before
@@ -1413,9 +1478,10 @@ namespace evio {
     *               structures are passed. In this way, specific types of
     *               structures can be captured.
     */
-    void BaseStructure::visitAllDescendants(std::shared_ptr<BaseStructure> structure,
-                                            std::shared_ptr<IEvioListener> listener,
-                                            std::shared_ptr<IEvioFilter>   filter) {
+    void BaseStructure::visitAllDescendants(std::shared_ptr<BaseStructure> const & top,
+                                            std::shared_ptr<BaseStructure> const & structure,
+                                            std::shared_ptr<IEvioListener> const & listener,
+                                            std::shared_ptr<IEvioFilter>   const & filter) {
         if (listener != nullptr) {
             bool accept = true;
             if (filter != nullptr) {
@@ -1423,15 +1489,63 @@ namespace evio {
             }
 
             if (accept) {
-                listener->gotStructure(getThis(), structure);
+                listener->gotStructure(top, structure);
             }
         }
 
-        if (!(structure->isLeaf())) {
-            for (auto const & child : structure->getChildren()) {
-                visitAllDescendants(child, listener, filter);
-            }
+        for (auto const & child : structure->children) {
+            visitAllDescendants(top, child, listener, filter);
+        }
+    }
+
+
+    /**
+     * Visit all the descendants of a given structure
+     * (which is considered a descendant of itself) with a callable.
+     *
+     * @param structure the starting structure.
+     * @param visitor   called with each structure visited.
+     * @param filter    an optional callable that must accept structures before
+     *                  they are passed to the visitor. If empty, all are passed.
+     */
+    void BaseStructure::visitAllDescendants(std::shared_ptr<BaseStructure> const & structure,
+                                            StructureVisitor const & visitor,
+                                            StructureFilter  const & filter) {
+        if (!filter || filter(structure)) {
+            visitor(structure);
         }
+
+        for (auto const & child : structure->children) {
+            visitAllDescendants(child, visitor, filter);
+        }
+    }
+
+
+    /**
+     * Visit all the structures in this structure (including the structure itself --
+     * which is considered its own descendant) in a depth first manner.
+     * Unlike the listener version, no shared pointers are copied or objects made.
+     *
+     * @param visitor called with each structure visited.
+     */
+    void BaseStructure::visitAllStructures(StructureVisitor const & visitor) {
+        visitAllStructures(visitor, nullptr);
+    }
+
+
+    /**
+     * Visit all the structures in this structure (including the structure itself --
+     * which is considered its own descendant) in a depth first manner.
+     * Unlike the listener version, no shared pointers are copied or objects made.
+     *
+     * @param visitor called with each structure visited.
+     * @param filter  an optional callable that must return true for structures before
+     *                they are passed to the visitor. If empty, all structures are passed.
+     */
+    void BaseStructure::visitAllStructures(StructureVisitor const & visitor,
+                                           StructureFilter const & filter) {
+        if (!visitor) return;
+        visitAllDescendants(getThis(), visitor, filter);
     }
 
 
@@ -1443,24 +1557,68 @@ namespace evio {
      */
     void BaseStructure::getMatchingStructures(std::shared_ptr<IEvioFilter> filter,
                                               std::vector<std::shared_ptr<BaseStructure>> & vec) {
+        vec.clear();
+
+        if (filter == nullptr) {
+            getMatchingStructures(nullptr, vec);
+            return;
+        }
 
-        class myListener : public IEvioListener {
-            std::vector<std::shared_ptr<BaseStructure>> & vec;
-          public:
-            explicit myListener(std::vector<std::shared_ptr<BaseStructure>> & v) : vec(v) {}
+        visitAllDescendants(getThis(),
+                            [&vec](std::shared_ptr<BaseStructure> const & s) {vec.push_back(s);},
+                            [&filter](std::shared_ptr<BaseStructure> const & s) {
+                                return filter->accept(s->getStructureType(), s);
+                            });
+    }
+
+
+    /**
+     * Collect all the descendant structures, this one included.
+     * @param filter null.
+     * @param vec    vector provided to contain all structures.
+     */
+    void BaseStructure::getMatchingStructures(std::nullptr_t /*filter*/,
+                                              std::vector<std::shared_ptr<BaseStructure>> & vec) {
+        vec.clear();
+        for (auto const & s : depthFirst()) {
+            vec.push_back(s);
+        }
+    }
 
-            void startEventParse(std::shared_ptr<BaseStructure> structure) { }
-            void endEventParse(std::shared_ptr<BaseStructure> structure) { }
-            void gotStructure(std::shared_ptr<BaseStructure> topStructure,
-                              std::shared_ptr<BaseStructure> structure) {
-                vec.push_back(structure);
-            }
-        };
 
+    /**
+     * Visit all the descendant structures, and collect those that a callable accepts.
+     * @param filter callable returning true for structures to collect. If empty,
+     *               this will return all the structures.
+     * @param vec    vector provided to contain all structures that are accepted by the filter.
+     */
+    void BaseStructure::getMatchingStructures(StructureFilter const & filter,
+                                              std::vector<std::shared_ptr<BaseStructure>> & vec) {
         vec.clear();
-        auto listener = std::make_shared<myListener>(vec);
+        visitAllDescendants(getThis(),
+                            [&vec](std::shared_ptr<BaseStructure> const & s) {vec.push_back(s);},
+                            filter);
+    }
+
+
+    /**
+     * Get an index of all the structures in this tree, used by {@link StructureFinder}
+     * to answer searches without walking the tree. It's made the first time it's asked for
+     * and made again if the tree has changed since then, by adding or removing structures
+     * or by changing a tag or num. Only a structure with no parent, normally an event,
+     * has an index.
+     *
+     * @return index of this tree, or null if this structure has a parent.
+     */
+    std::shared_ptr<StructureQueryIndex> BaseStructure::getQueryIndex() {
+        if (parent != nullptr) {
+            return nullptr;
+        }
 
-        visitAllStructures(listener, filter);
+        if (queryIndex == nullptr || !queryIndex->isValid(*this)) {
+            queryIndex = std::make_shared<StructureQueryIndex>(*this);
+        }
+        return queryIndex;
     }
 
 
@@ -1469,12 +1627,55 @@ namespace evio {
     //---------------------------------------------
 
 
-    /** Clear all existing data from a non-container structure. */
+    /**
+     * Clear all existing data from a non-container structure.
+     * Its header length, and those of its ancestors, are set to match.
+     */
     void BaseStructure::clearData() {
 
         if (header->getDataType().isStructure()) return;
 
         rawBytes.clear();
+        viewSource = nullptr;
+        viewData = nullptr;
+        viewOffset = viewLength = 0;
+        shortData.clear();
+        ushortData.clear();
+        intData.clear();
+        uintData.clear();
+        longData.clear();
+        ulongData.clear();
+        doubleData.clear();
+        floatData.clear();
+        compositeData.clear();
+
+        charData.clear();
+        ucharData.clear();
+        stringList.clear();
+        stringEnd = 0;
+
+        numberDataItems = 0;
+        badStringFormat = false;
+
+        header->setPadding(0);
+        dataLengthChanged();
+    }
+
+
+    /**
+     * Empty this structure so it can be filled by parsing another event, keeping
+     * the capacity of all its vectors. Its parent, children, data, and any index are removed.
+     * The header is left as it is, to be overwritten.
+     */
+    void BaseStructure::resetForReuse() {
+        parent = nullptr;
+        children.clear();
+        queryIndex = nullptr;
+
+        rawBytes.clear();
+        viewSource = nullptr;
+        viewData = nullptr;
+        viewOffset = viewLength = 0;
         shortData.clear();
         ushortData.clear();
         intData.clear();
@@ -1492,6 +1693,7 @@ namespace evio {
 
         numberDataItems = 0;
         badStringFormat = false;
+        setLengthsUpToDate(false);
     }
 
 
@@ -1541,11 +1743,11 @@ namespace evio {
             ss << "  num=" << ((int)(header->getNumber())) << std::hex << "(" << ((int)(header->getNumber())) << ")" << std::dec;
         }
 
-        if (rawBytes.empty()) {
+        if (rawSize() == 0) {
             ss << "  dataLen=" << header->getDataLength();
         }
         else {
-            ss << "  dataLen=" << (rawBytes.size()/4);
+            ss << "  dataLen=" << (rawSize()/4);
         }
 
         if (header->getPadding() != 0) {
@@ -1644,8 +1846,8 @@ namespace evio {
                 numberDataItems = compositeData.size();
             }
 
-            if (divisor > 0 && !rawBytes.empty()) {
-                numberDataItems = (rawBytes.size() - padding)/divisor;
+            if (divisor > 0 && rawSize() > 0) {
+                numberDataItems = (rawSize() - padding)/divisor;
             }
         }
 
@@ -1664,7 +1866,10 @@ namespace evio {
      * Get the raw data of the structure.
      * @return the raw data of the structure.
      */
-    std::vector<uint8_t> & BaseStructure::getRawBytes() {return rawBytes;}
+    std::vector<uint8_t> & BaseStructure::getRawBytes() {
+        materializeView();
+        return rawBytes;
+    }
 
 
     /**
@@ -1672,7 +1877,9 @@ namespace evio {
      * @param bytes pointer to the data to be copied.
      * @param len number of bytes to be copied.
      */
-    void BaseStructure::setRawBytes(uint8_t *bytes, uint32_t len) {
+    void BaseStructure::setRawBytes(const uint8_t *bytes, uint32_t len) {
+        viewSource = nullptr;
+        viewData = nullptr;
         rawBytes.resize(len, 0);
         std::memcpy(rawBytes.data(), bytes, len);
     }
@@ -1682,7 +1889,187 @@ namespace evio {
      * Set the data for the structure.
      * @param bytes vector of data to be copied.
      */
-    void BaseStructure::setRawBytes(std::vector<uint8_t> & bytes) {rawBytes = bytes;}
+    void BaseStructure::setRawBytes(std::vector<uint8_t> & bytes) {
+        viewSource = nullptr;
+        viewData = nullptr;
+        rawBytes = bytes;
+    }
+
+
+    /**
+     * Set the data for the structure by taking over the given vector's memory.
+     * @param bytes vector of data to be moved; it is left empty.
+     */
+    void BaseStructure::setRawBytes(std::vector<uint8_t> && bytes) {
+        viewSource = nullptr;
+        viewData = nullptr;
+        rawBytes = std::move(bytes);
+    }
+
+
+    /**
+     * Set the data for the structure to be a view of part of another structure's raw bytes,
+     * normally those of the event it was parsed from, instead of a copy of them.
+     * The other structure is kept alive by this one, but its raw bytes must not be changed
+     * while this one is a view. Anything needing this structure's data as a vector,
+     * such as {@link #getRawBytes()}, {@link #getIntData()}, or the write methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param source structure whose raw bytes contain this structure's data.
+     * @param offset offset into source's raw bytes of this structure's data.
+     * @param len    number of bytes of this structure's data, padding included.
+     */
+    void BaseStructure::setRawBytesView(std::shared_ptr<BaseStructure> const & source, size_t offset, size_t len) {
+        // Always view the bytes of the structure that actually holds them
+        if (source->viewData != nullptr) {
+            viewSource = nullptr;
+            viewData = source->viewData + offset;
+            viewOffset = 0;
+        }
+        else if (source->viewSource != nullptr) {
+            viewSource = source->viewSource;
+            viewData = nullptr;
+            viewOffset = source->viewOffset + offset;
+        }
+        else {
+            viewSource = source;
+            viewData = nullptr;
+            viewOffset = offset;
+        }
+        viewLength = len;
+        rawBytes.clear();
+    }
+
+
+    /**
+     * Is this structure's raw data a view of another structure's raw bytes or of the caller's memory?
+     * @return true if this structure's raw data is a view.
+     * @see #setRawBytesView
+     * @see #setDataView
+     */
+    bool BaseStructure::isRawBytesView() const {return viewSource != nullptr || viewData != nullptr;}
+
+
+    /**
+     * Get a view of the raw data of the structure without copying it, whether or not
+     * the data is itself a view. Valid until the data is changed.
+     * @return view of the raw data, padding included, in this structure's byte order.
+     */
+    ByteBufferView BaseStructure::getRawBytesView() const {
+        return ByteBufferView(rawData(), rawSize(), byteOrder);
+    }
+
+
+    /**
+     * If the raw data is a view of another structure's raw bytes or of the caller's memory,
+     * copy it into rawBytes and stop being a view.
+     */
+    void BaseStructure::materializeView() {
+        if (viewSource == nullptr && viewData == nullptr) return;
+        const uint8_t *src = rawData();
+        rawBytes.assign(src, src + viewLength);
+        viewSource = nullptr;
+        viewData = nullptr;
+        viewOffset = viewLength = 0;
+    }
+
+
+    /** @return pointer to the raw data, whether in rawBytes or viewed. */
+    const uint8_t * BaseStructure::rawData() const {
+        if (viewData != nullptr) return viewData;
+        return viewSource == nullptr ? rawBytes.data() : viewSource->rawBytes.data() + viewOffset;
+    }
+
+
+    /** @return number of bytes of raw data, padding included, whether in rawBytes or viewed. */
+    size_t BaseStructure::rawSize() const {
+        return (viewSource == nullptr && viewData == nullptr) ? rawBytes.size() : viewLength;
+    }
+
+
+    /**
+     * Get a typed view of the raw data, padding excluded, without copying or swapping it.
+     * @tparam T type of value.
+     * @param type data type this structure must contain.
+     * @return typed view of the raw data.
+     * @throws EvioException if contained data type is not the given type.
+     */
+    template<typename T> TypedView<T> BaseStructure::dataView(DataType const & type) const {
+        if (header->getDataType() != type) {
+            throw EvioException("wrong data type");
+        }
+        size_t bytes = rawSize();
+        size_t pad = header->getPadding();
+        bytes = bytes > pad ? bytes - pad : 0;
+        return TypedView<T>(rawData(), bytes / sizeof(T), byteOrder);
+    }
+
+
+    /**
+     * Get a view of the data as int16_t values, without copying it into a vector as
+     * {@link #getShortData()} does. Values are swapped, if necessary, as they're read.
+     * Valid until this structure's data is changed.
+     *
+     * @return view of the data as int16_t values.
+     * @throws EvioException if contained data type is not int16_t.
+     */
+    TypedView<int16_t> BaseStructure::getShortView() const {return dataView<int16_t>(DataType::SHORT16);}
+
+
+    /**
+     * Get a view of the data as uint16_t values, see {@link #getShortView()}.
+     * @return view of the data as uint16_t values.
+     * @throws EvioException if contained data type is not uint16_t.
+     */
+    TypedView<uint16_t> BaseStructure::getUShortView() const {return dataView<uint16_t>(DataType::USHORT16);}
+
+
+    /**
+     * Get a view of the data as int32_t values, see {@link #getShortView()}.
+     * @return view of the data as int32_t values.
+     * @throws EvioException if contained data type is not int32_t.
+     */
+    TypedView<int32_t> BaseStructure::getIntView() const {return dataView<int32_t>(DataType::INT32);}
+
+
+    /**
+     * Get a view of the data as uint32_t values, see {@link #getShortView()}.
+     * @return view of the data as uint32_t values.
+     * @throws EvioException if contained data type is not uint32_t.
+     */
+    TypedView<uint32_t> BaseStructure::getUIntView() const {return dataView<uint32_t>(DataType::UINT32);}
+
+
+    /**
+     * Get a view of the data as int64_t values, see {@link #getShortView()}.
+     * @return view of the data as int64_t values.
+     * @throws EvioException if contained data type is not int64_t.
+     */
+    TypedView<int64_t> BaseStructure::getLongView() const {return dataView<int64_t>(DataType::LONG64);}
+
+
+    /**
+     * Get a view of the data as uint64_t values, see {@link #getShortView()}.
+     * @return view of the data as uint64_t values.
+     * @throws EvioException if contained data type is not uint64_t.
+     */
+    TypedView<uint64_t> BaseStructure::getULongView() const {return dataView<uint64_t>(DataType::ULONG64);}
+
+
+    /**
+     * Get a view of the data as float values, see {@link #getShortView()}.
+     * @return view of the data as float values.
+     * @throws EvioException if contained data type is not float.
+     */
+    TypedView<float> BaseStructure::getFloatView() const {return dataView<float>(DataType::FLOAT32);}
+
+
+    /**
+     * Get a view of the data as double values, see {@link #getShortView()}.
+     * @return view of the data as double values.
+     * @throws EvioException if contained data type is not double.
+     */
+    TypedView<double> BaseStructure::getDoubleView() const {return dataView<double>(DataType::DOUBLE64);}
 
 
     /**
@@ -1694,22 +2081,22 @@ namespace evio {
      * @throws EvioException if contained data type is not int16_t.
      */
     std::vector<int16_t> & BaseStructure::getShortData() {
+        materializeView();
         // If we're asking for the data type actually contained ...
         if (header->getDataType() == DataType::SHORT16) {
             // If int data has not been transformed from the raw bytes yet ...
             if (shortData.empty() && (!rawBytes.empty())) {
 
                 // Fill int vector with transformed raw data
-                auto pInt = reinterpret_cast<int16_t *>(rawBytes.data());
                 uint32_t numInts = (rawBytes.size() - header->getPadding()) / sizeof(int16_t);
                 shortData.resize(numInts);
 
-                for (int i=0; i < numInts; ++i) {
-                    int16_t dat = *(pInt++);
-                    if (needSwap()) {
-                        dat = SWAP_16(dat);
-                    }
-                    shortData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(rawBytes.data()), numInts,
+                                          reinterpret_cast<uint16_t *>(shortData.data()));
+                }
+                else {
+                    std::memcpy(shortData.data(), rawBytes.data(), numInts*sizeof(int16_t));
                 }
             }
 
@@ -1729,19 +2116,19 @@ namespace evio {
      * @throws EvioException if contained data type is not uint16_t.
      */
     std::vector<uint16_t> & BaseStructure::getUShortData() {
+        materializeView();
         if (header->getDataType() == DataType::USHORT16) {
             if (ushortData.empty() && (!rawBytes.empty())) {
 
-                auto pInt = reinterpret_cast<uint16_t *>(rawBytes.data());
                 uint32_t numInts = (rawBytes.size() - header->getPadding()) / sizeof(uint16_t);
                 ushortData.resize(numInts);
 
-                for (int i=0; i < numInts; ++i) {
-                    int16_t dat = *(pInt++);
-                    if (needSwap()) {
-                        dat = SWAP_16(dat);
-                    }
-                    ushortData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(rawBytes.data()), numInts,
+                                          reinterpret_cast<uint16_t *>(ushortData.data()));
+                }
+                else {
+                    std::memcpy(ushortData.data(), rawBytes.data(), numInts*sizeof(uint16_t));
                 }
             }
             return ushortData;
@@ -1759,19 +2146,19 @@ namespace evio {
      * @throws EvioException if contained data type is not int32_t.
      */
     std::vector<int32_t> & BaseStructure::getIntData() {
+        materializeView();
         if (header->getDataType() == DataType::INT32) {
             if (intData.empty() && (!rawBytes.empty())) {
 
-                auto pInt = reinterpret_cast<int32_t *>(rawBytes.data());
                 uint32_t numInts = (rawBytes.size() - header->getPadding()) / sizeof(int32_t);
                 intData.resize(numInts);
 
-                for (int i=0; i < numInts; ++i) {
-                    int32_t dat = *(pInt++);
-                    if (needSwap()) {
-                        dat = SWAP_32(dat);
-                    }
-                    intData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(rawBytes.data()), numInts,
+                                          reinterpret_cast<uint32_t *>(intData.data()));
+                }
+                else {
+                    std::memcpy(intData.data(), rawBytes.data(), numInts*sizeof(int32_t));
                 }
             }
             return intData;
@@ -1789,19 +2176,19 @@ namespace evio {
      * @throws EvioException if contained data type is not uint32_t.
      */
     std::vector<uint32_t> & BaseStructure::getUIntData() {
+        materializeView();
         if (header->getDataType() == DataType::UINT32) {
             if (uintData.empty() && (!rawBytes.empty())) {
 
-                auto pInt = reinterpret_cast<uint32_t *>(rawBytes.data());
                 uint32_t numInts = (rawBytes.size() - header->getPadding()) / sizeof(uint32_t);
                 uintData.resize(numInts);
 
-                for (int i=0; i < numInts; ++i) {
-                    uint32_t dat = *(pInt++);
-                    if (needSwap()) {
-                        dat = SWAP_32(dat);
-                    }
-                    uintData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(rawBytes.data()), numInts,
+                                          reinterpret_cast<uint32_t *>(uintData.data()));
+                }
+                else {
+                    std::memcpy(uintData.data(), rawBytes.data(), numInts*sizeof(uint32_t));
                 }
             }
             return uintData;
@@ -1819,19 +2206,19 @@ namespace evio {
      * @throws EvioException if contained data type is not int64_t.
      */
     std::vector<int64_t> & BaseStructure::getLongData() {
+        materializeView();
         if (header->getDataType() == DataType::LONG64) {
             if (longData.empty() && (!rawBytes.empty())) {
 
-                auto pLong = reinterpret_cast<int64_t *>(rawBytes.data());
                 uint32_t numLongs = (rawBytes.size() - header->getPadding()) / sizeof(int64_t);
                 longData.resize(numLongs);
 
-                for (int i=0; i < numLongs; ++i) {
-                    int64_t dat = *(pLong++);
-                    if (needSwap()) {
-                        dat = SWAP_64(dat);
-                    }
-                    longData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(rawBytes.data()), numLongs,
+                                          reinterpret_cast<uint64_t *>(longData.data()));
+                }
+                else {
+                    std::memcpy(longData.data(), rawBytes.data(), numLongs*sizeof(int64_t));
                 }
             }
             return longData;
@@ -1849,19 +2236,19 @@ namespace evio {
      * @throws EvioException if contained data type is not uint64_t.
      */
     std::vector<uint64_t> & BaseStructure::getULongData() {
+        materializeView();
         if (header->getDataType() == DataType::ULONG64) {
             if (ulongData.empty() && (!rawBytes.empty())) {
 
-                auto pLong = reinterpret_cast<uint64_t *>(rawBytes.data());
                 uint32_t numLongs = (rawBytes.size() - header->getPadding()) / sizeof(uint64_t);
                 ulongData.resize(numLongs);
 
-                for (int i=0; i < numLongs; ++i) {
-                    uint64_t dat = *(pLong++);
-                    if (needSwap()) {
-                        dat = SWAP_64(dat);
-                    }
-                    ulongData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(rawBytes.data()), numLongs,
+                                          reinterpret_cast<uint64_t *>(ulongData.data()));
+                }
+                else {
+                    std::memcpy(ulongData.data(), rawBytes.data(), numLongs*sizeof(uint64_t));
                 }
             }
             return ulongData;
@@ -1879,19 +2266,19 @@ namespace evio {
      * @throws EvioException if contained data type is not float.
      */
     std::vector<float> & BaseStructure::getFloatData() {
+        materializeView();
         if (header->getDataType() == DataType::FLOAT32) {
             if (floatData.empty() && (!rawBytes.empty())) {
 
-                auto pFlt = reinterpret_cast<float *>(rawBytes.data());
                 uint32_t numReals = (rawBytes.size() - header->getPadding()) / sizeof(float);
                 floatData.resize(numReals);
 
-                for (int i=0; i < numReals; ++i) {
-                    float dat = *(pFlt++);
-                    if (needSwap()) {
-                        dat = SWAP_32(dat);
-                    }
-                    floatData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(rawBytes.data()), numReals,
+                                          reinterpret_cast<uint32_t *>(floatData.data()));
+                }
+                else {
+                    std::memcpy(floatData.data(), rawBytes.data(), numReals*sizeof(float));
                 }
             }
             return floatData;
@@ -1909,19 +2296,19 @@ namespace evio {
      * @throws EvioException if contained data type is not double.
      */
     std::vector<double> & BaseStructure::getDoubleData() {
+        materializeView();
         if (header->getDataType() == DataType::DOUBLE64) {
             if (doubleData.empty() && (!rawBytes.empty())) {
 
-                auto pFlt = reinterpret_cast<float *>(rawBytes.data());
                 uint32_t numReals = (rawBytes.size() - header->getPadding()) / sizeof(double);
                 doubleData.resize(numReals);
 
-                for (int i=0; i < numReals; ++i) {
-                    double dat = *(pFlt++);
-                    if (needSwap()) {
-                        dat = SWAP_64(dat);
-                    }
-                    doubleData[i] = dat;
+                if (needSwap()) {
+                    ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(rawBytes.data()), numReals,
+                                          reinterpret_cast<uint64_t *>(doubleData.data()));
+                }
+                else {
+                    std::memcpy(doubleData.data(), rawBytes.data(), numReals*sizeof(double));
                 }
             }
             return doubleData;
@@ -1940,6 +2327,7 @@ namespace evio {
      * @throws EvioException if the data is internally inconsistent.
      */
     std::vector<std::shared_ptr<CompositeData>> & BaseStructure::getCompositeData() {
+        materializeView();
 
         if (header->getDataType() == DataType::COMPOSITE) {
             if (compositeData.empty() && (!rawBytes.empty())) {
@@ -1961,6 +2349,7 @@ namespace evio {
      *          if this makes no sense for the given contents type.
      */
     std::vector<signed char> & BaseStructure::getCharData() {
+        materializeView();
         if (header->getDataType() == DataType::CHAR8) {
             if (charData.empty() && (!rawBytes.empty())) {
 
@@ -1985,6 +2374,7 @@ namespace evio {
      *         if this makes no sense for the given contents type.
      */
     std::vector<unsigned char> & BaseStructure::getUCharData() {
+        materializeView();
         if (header->getDataType() == DataType::UCHAR8) {
             if (ucharData.empty() && (!rawBytes.empty())) {
 
@@ -2025,6 +2415,7 @@ namespace evio {
      *
      */
     std::vector<std::string> & BaseStructure::getStringData() {
+        materializeView();
         if (header->getDataType() == DataType::CHARSTAR8) {
             if (!stringList.empty()) {
                 return stringList;
@@ -2108,47 +2499,7 @@ namespace evio {
      */
     void BaseStructure::stringsToRawBytes(std::vector<std::string> & strings,
                                           std::vector<uint8_t> & bytes) {
-        if (strings.empty()) {
-            bytes.clear();
-            return;
-        }
-
-        // create some storage
-        int dataLen = stringsToRawSize(strings);
-        std::string strData;
-        strData.reserve(dataLen);
-
-        for (std::string const & s : strings) {
-            // add string
-            strData.append(s);
-            // add ending null
-            strData.append(1, '\000');
-        }
-
-        // Add any necessary padding to 4 byte boundaries.
-        // IMPORTANT: There must be at least one '\004'
-        // character at the end. This distinguishes evio
-        // string array version from earlier version.
-        int pads[] = {4,3,2,1};
-        switch (pads[strData.length()%4]) {
-            case 4:
-                strData.append(4, '\004');
-                break;
-            case 3:
-                strData.append(3, '\004');
-                break;
-            case 2:
-                strData.append(2, '\004');
-                break;
-            case 1:
-                strData.append(1, '\004');
-        }
-
-        // Transform to ASCII
-        bytes.resize(dataLen);
-        for (int i=0; i < strData.length(); i++) {
-            bytes[i] = strData[i];
-        }
+        Util::stringsToRawBytes(strings, bytes);
     }
 
 
@@ -2165,42 +2516,8 @@ namespace evio {
             return;
         }
 
-        // create some storage
-        int dataLen = Util::stringsToRawSize(stringList);
-        std::string strData;
-        strData.reserve(dataLen);
-
-        for (std::string const & s : stringList) {
-            // add string
-            strData.append(s);
-            // add ending null
-            strData.append(1, '\000');
-        }
-
-        // Add any necessary padding to 4 byte boundaries.
-        // IMPORTANT: There must be at least one '\004'
-        // character at the end. This distinguishes evio
-        // string array version from earlier version.
-        int pads[] = {4,3,2,1};
-        switch (pads[strData.length()%4]) {
-            case 4:
-                strData.append(4, '\004');
-                break;
-            case 3:
-                strData.append(3, '\004');
-                break;
-            case 2:
-                strData.append(2, '\004');
-                break;
-            case 1:
-                strData.append(1, '\004');
-        }
-
-        // Transform to ASCII
-        rawBytes.resize(dataLen);
-        for (int i=0; i < strData.length(); i++) {
-            rawBytes[i] = strData[i];
-        }
+        // Written straight into rawBytes in one pass
+        Util::stringsToRawBytes(stringList, rawBytes);
 
         numberDataItems = stringList.size();
     }
@@ -2238,8 +2555,7 @@ namespace evio {
         // Don't read read more than maxLength ASCII characters
         length = length > maxLength ? maxLength : length;
 
-        std::string sData(reinterpret_cast<const char *>(bytes.data()) + offset, length);
-        return stringBuilderToStrings(sData, true, strData);
+        Util::unpackStrings(bytes.data() + offset, length, true, strData);
     }
 
 
@@ -2256,8 +2572,7 @@ namespace evio {
                                                 std::vector<std::string> & strData) {
         if (bytes == nullptr) return;
 
-        std::string sData(reinterpret_cast<const char *>(bytes), length);
-        return stringBuilderToStrings(sData, true, strData);
+        Util::unpackStrings(bytes, length, true, strData);
     }
 
 
@@ -2275,8 +2590,7 @@ namespace evio {
 
         if (length < 4) return;
 
-        std::string sData(reinterpret_cast<const char *>(buffer.array() + buffer.arrayOffset()) + pos, length);
-        return stringBuilderToStrings(sData, false, strData);
+        Util::unpackStrings(buffer.array() + buffer.arrayOffset() + pos, length, false, strData);
     }
 
 
@@ -2409,6 +2723,7 @@ namespace evio {
      * @return number of strings extracted from bytes.
      */
     uint32_t BaseStructure::unpackRawBytesToStrings() {
+        materializeView();
 
         badStringFormat = true;
 
@@ -2417,111 +2732,15 @@ namespace evio {
             return 0;
         }
 
-        // Each string is terminated with a null (char val = 0)
-        // and in addition, the end is padded by ASCII 4's (char val = 4).
-        // However, in the legacy versions of evio, there is only one
-        // null-terminated string and anything as padding. To accommodate legacy evio, if
-        // there is not an ending ASCII value 4, anything past the first null is ignored.
-        // After doing so, split at the nulls.
-
-        char c;
-        int nullCount = 0;
-        std::vector<int> nullIndexList;
-
-        int rawLength = rawBytes.size();
-        bool noEnding4 = false;
-        if (rawBytes[rawLength - 1] != 4) {
-            noEnding4 = true;
-        }
-
-        for (int i=0; i < rawLength; i++) {
-            c = rawBytes[i];
-
-            // If char is a null
-            if (c == 0) {
-                nullCount++;
-                nullIndexList.push_back(i);
-                // If evio v2 or 3, only 1 null terminated string exists
-                // and padding is just junk or nonexistent.
-                if (noEnding4) {
-                    badStringFormat = false;
-                    break;
-                }
-            }
-
-            // Look for any non-printing/control characters (not including null)
-            // and end the string there. Allow tab and newline whitespace.
-            else if ((c < 32 || c > 126) && c != 9 && c != 10) {
-//std::cout << "unpackRawBytesToStrings: found non-printing c = 0x" << std::hex << ((int)c) << std::dec << " at i = " << i << std::endl;
-                if (nullCount < 1) {
-                    // Getting garbage before first null.
-//std::cout << "BAD FORMAT 1: garbage char before null" << std::endl;
-                    break;
-                }
-
-                // Already have at least one null & therefore a String.
-                // Now we have junk or non-printing ascii which is
-                // possibly the ending 4.
-
-                // If we have a 4, investigate further to see if format
-                // is entirely valid.
-                if (c == '\004') {
-                    // How many more chars are there?
-                    int charsLeft = rawLength - (i+1);
-
-                    // Should be no more than 3 additional 4's before the end
-                    if (charsLeft > 3) {
-//std::cout << "BAD FORMAT 2: too many chars, " << charsLeft << ", after 4" << std::endl;
-                        break;
-                    }
-                    else {
-                        // Check to see if remaining chars are all 4's. If not, bad.
-                        for (int j=1; j <= charsLeft; j++) {
-                            c = rawBytes[i+j];
-                            if (c != '\004') {
-//std::cout << "BAD FORMAT 3: padding chars are not all 4's" << std::endl;
-                                goto pastOuterLoop;
-                            }
-                        }
-                        badStringFormat = false;
-                        break;
-                    }
-                }
-                else {
-//std::cout << "BAD FORMAT 4: got bad char, ascii val = " << c << std::endl;
-                    break;
-                }
-            }
-        }
-        pastOuterLoop:
-
-
-        // What if the raw bytes are all valid ascii with no null or other non-printing chars?
-        // Then format is bad so return everything as one string.
-
-        // If error, return everything in one String including possible garbage
-        if (badStringFormat) {
-//std::cout << "unpackRawBytesToStrings: bad format, return all chars in 1 string" << std::endl;
-            std::string everything(reinterpret_cast<char *>(rawBytes.data()), rawLength);
-            stringList.push_back(everything);
-            return 1;
-        }
-
-        // If here, raw bytes are in the proper format
-
-//std::cout << "  split into " << nullCount << " strings" << std::endl;
-        int firstIndex=0;
-        for (int nullIndex : nullIndexList) {
-            std::string subString(reinterpret_cast<char *>(rawBytes.data()) + firstIndex, (nullIndex-firstIndex));
-            stringList.push_back(subString);
-//std::cout << "    add " << subString << std::endl;
-            firstIndex = nullIndex + 1;
-        }
+        // If the format is bad, this views everything as one string including possible garbage
+        StringArrayView view(rawBytes.data(), rawBytes.size());
+        badStringFormat = view.isBadFormat();
+        view.appendTo(stringList);
 
         // Set length of everything up to & including last null (not padding)
-        stringEnd = firstIndex;
-        //stringData.setLength(stringEnd);
-//std::cout << "    good string len = " << stringEnd << std::endl;
+        if (!badStringFormat) {
+            stringEnd = view.getStringEnd();
+        }
         return stringList.size();
     }
 
@@ -2578,8 +2797,8 @@ namespace evio {
 
             // Special cases:
             if (type == DataType::CHARSTAR8 || type == DataType::COMPOSITE) {
-                if (!rawBytes.empty()) {
-                    datalen = 1 + ((rawBytes.size() - 1) / 4);
+                if (rawSize() > 0) {
+                    datalen = 1 + ((rawSize() - 1) / 4);
                 }
             }
             else if (type == DataType::CHAR8 || type == DataType::UCHAR8 || type == DataType::UNKNOWN32) {
@@ -2626,6 +2845,48 @@ namespace evio {
     }
 
 
+    /**
+     * Add to the header length of this structure and to those of its ancestors
+     * whose lengths are up to date, after this structure's length changed.
+     * This keeps lengths up to date by touching only the path to the root.
+     *
+     * @param words change in length in 32 bit words.
+     * @throws EvioException if a length becomes too large.
+     */
+    void BaseStructure::addToLengths(int64_t words) {
+        for (BaseStructure *s = this; s != nullptr && s->lengthsUpToDate; s = s->parent.get()) {
+            int64_t len = (int64_t)s->header->getLength() + words;
+            if (len < 0 || len > std::numeric_limits<uint32_t>::max()) {
+                throw EvioException("added data overflowed containing structure");
+            }
+            s->header->setLength((uint32_t)len);
+        }
+    }
+
+
+    /**
+     * Set this structure's header length after its data changed. If its length was up to date
+     * and it's a leaf, the difference is added to its ancestors' lengths instead of them all
+     * being recomputed later.
+     *
+     * @throws EvioException if the length is too large.
+     */
+    void BaseStructure::dataLengthChanged() {
+        if (!lengthsUpToDate || !isLeaf()) {
+            setLengthsUpToDate(false);
+            setAllHeaderLengths();
+            return;
+        }
+
+        int64_t oldLen = header->getLength();
+        lengthsUpToDate = false;
+        int64_t newLen = setAllHeaderLengths();
+        if (parent != nullptr) {
+            parent->addToLengths(newLen - oldLen);
+        }
+    }
+
+
     /**
      * Compute and set length of all header fields for this structure and all its descendants.
      * For writing events, this will be crucial for setting the values in the headers.
@@ -2693,6 +2954,7 @@ namespace evio {
     * @return the number of bytes written.
     */
     size_t BaseStructure::writeQuick(ByteBuffer & dest) {
+        materializeView();
         header->write(dest);
         dest.put(rawBytes.data(), rawBytes.size());
         dest.order(getByteOrder());
@@ -2713,6 +2975,7 @@ namespace evio {
      * @return the number of bytes written.
      */
     size_t BaseStructure::writeQuick(uint8_t *dest) {
+        materializeView();
          // write the header
         header->write(dest, byteOrder);
         // write the rest
@@ -2729,6 +2992,9 @@ namespace evio {
      * @return the number of bytes written.
      */
     size_t BaseStructure::write(uint8_t *dest, ByteOrder const & order) {
+        if (viewData == nullptr) {
+            materializeView();
+        }
 
         uint8_t *curPos = dest;
 
@@ -2736,7 +3002,11 @@ namespace evio {
         header->write(curPos, order);
         curPos += 4*header->getHeaderLength();
 
-        if (isLeaf()) {
+        // Data viewed in the caller's memory is written straight from there
+        if (viewData != nullptr) {
+            curPos += writeViewedData(curPos, order);
+        }
+        else if (isLeaf()) {
 
             DataType type = header->getDataType();
 
@@ -2869,6 +3139,103 @@ namespace evio {
     }
 
 
+    /**
+     * Write myself, and all my descendants, out to a pointer in a single pass, setting all
+     * header lengths along the way. Unlike {@link #write(uint8_t *, ByteOrder const &)}, this
+     * does not need {@link #setAllHeaderLengths()} to be called first: each structure's data
+     * is written first, and its header is written after once its length is known.
+     * The data must be as kept by this object's update methods, as is done by
+     * {@link EventBuilder}.
+     *
+     * @param dest     pointer at which to write evio format data of this structure.
+     * @param capacity number of bytes available at dest.
+     * @param order    byte order in which to write.
+     * @return the number of bytes written, or 0 if it didn't fit in capacity,
+     *         in which case the bytes at dest are garbage.
+     * @throws EvioException if a segment or tagsegment is too large for its 16 bit length.
+     */
+    size_t BaseStructure::writeDirect(uint8_t *dest, size_t capacity, ByteOrder const & order) {
+        uint8_t *end = writeDirectTo(dest, dest + capacity, order);
+        return end == nullptr ? 0 : end - dest;
+    }
+
+
+    /**
+     * Write myself, and all my descendants, out to a pointer, setting all header lengths.
+     *
+     * @param dest   pointer at which to write evio format data of this structure.
+     * @param limit  pointer past the last byte available.
+     * @param order  byte order in which to write.
+     * @return pointer past the last byte written, or null if it didn't fit.
+     * @throws EvioException if a segment or tagsegment is too large for its 16 bit length.
+     */
+    uint8_t * BaseStructure::writeDirectTo(uint8_t *dest, const uint8_t *limit, ByteOrder const & order) {
+        if (viewData == nullptr) {
+            materializeView();
+        }
+
+        size_t headerBytes = 4*header->getHeaderLength();
+        if ((size_t)(limit - dest) < headerBytes) {
+            return nullptr;
+        }
+
+        // Leave room for the header, written once the length is known
+        uint8_t *pos = dest + headerBytes;
+
+        if (viewData != nullptr) {
+            if ((size_t)(limit - pos) < viewLength) {
+                return nullptr;
+            }
+            pos += writeViewedData(pos, order);
+        }
+        else if (isLeaf()) {
+            size_t bytes = rawBytes.size();
+            size_t paddedBytes = (bytes + 3) & ~((size_t)3);
+            if ((size_t)(limit - pos) < paddedBytes) {
+                return nullptr;
+            }
+
+            if (bytes > 0) {
+                bool swap = (byteOrder != order);
+                if (swap && bytes == paddedBytes) {
+                    EvioSwap::swapData(reinterpret_cast<uint32_t *>(rawBytes.data()), header->getDataTypeValue(),
+                                       bytes/4, !byteOrder.isLocalEndian(), reinterpret_cast<uint32_t *>(pos));
+                }
+                else {
+                    std::memcpy(pos, rawBytes.data(), bytes);
+                    std::memset(pos + bytes, 0, paddedBytes - bytes);
+                    if (swap) {
+                        EvioSwap::swapData(reinterpret_cast<uint32_t *>(pos), header->getDataTypeValue(),
+                                           paddedBytes/4, !byteOrder.isLocalEndian(), nullptr);
+                    }
+                }
+                pos += paddedBytes;
+            }
+        }
+        else {
+            for (auto const & child : children) {
+                pos = child->writeDirectTo(pos, limit, order);
+                if (pos == nullptr) {
+                    return nullptr;
+                }
+            }
+        }
+
+        // Length does not include the length word itself
+        size_t len = (pos - dest)/4 - 1;
+        if (len > std::numeric_limits<uint32_t>::max() ||
+            (headerBytes == 4 && len > std::numeric_limits<uint16_t>::max())) {
+            throw EvioException("added data overflowed containing structure");
+        }
+
+        header->setLength((uint32_t)len);
+        header->write(dest, order);
+        lengthsUpToDate = true;
+
+        return pos;
+    }
+
+
     /**
      * Write myself out into a byte buffer with fastest algorithm I could find.
      *
@@ -2902,6 +3269,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateIntData() {
+        materializeView();
 
         // Make sure the structure is set to hold this kind of data
         DataType dataType = header->getDataType();
@@ -2920,7 +3288,6 @@ namespace evio {
             rawBytes.resize(4 * numberDataItems);
 
             if (ByteOrder::needToSwap(byteOrder)) {
-                std::cout << "updateIntData(): swapping ..." << std::endl;
                 ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(intData.data()),
                                       numberDataItems,
                                       reinterpret_cast<uint32_t *>(rawBytes.data()));
@@ -2930,8 +3297,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -2943,6 +3309,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateUIntData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::UINT32) {
@@ -2966,8 +3333,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -2979,6 +3345,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateShortData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::SHORT16) {
@@ -3019,8 +3386,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3032,6 +3398,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateUShortData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::USHORT16) {
@@ -3069,8 +3436,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3082,6 +3448,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateLongData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::LONG64) {
@@ -3106,8 +3473,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3119,6 +3485,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateULongData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::ULONG64) {
@@ -3142,8 +3509,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3155,6 +3521,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateCharData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::CHAR8) {
@@ -3179,8 +3546,7 @@ namespace evio {
             std::memset(rawBytes.data()+numberDataItems, 0, pad);
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3192,6 +3558,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateUCharData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::UCHAR8) {
@@ -3215,8 +3582,7 @@ namespace evio {
             std::memset(rawBytes.data()+numberDataItems, 0, pad);
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3228,6 +3594,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateFloatData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::FLOAT32) {
@@ -3252,8 +3619,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3265,6 +3631,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateDoubleData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::DOUBLE64) {
@@ -3289,8 +3656,7 @@ namespace evio {
             }
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3302,6 +3668,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateStringData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::CHARSTAR8) {
@@ -3310,8 +3677,7 @@ namespace evio {
 
         stringsToRawBytes();
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
     }
 
 
@@ -3323,6 +3689,7 @@ namespace evio {
      * @throws EvioException if this object corresponds to a different data type.
      */
     void BaseStructure::updateCompositeData() {
+        materializeView();
 
         DataType dataType = header->getDataType();
         if (dataType != DataType::COMPOSITE) {
@@ -3352,8 +3719,376 @@ namespace evio {
             CompositeData::generateRawBytes(compositeData, rawBytes, byteOrder);
         }
 
-        setLengthsUpToDate(false);
-        setAllHeaderLengths();
+        dataLengthChanged();
+    }
+
+
+    //----------------------------------------------------------------------
+    // Methods to set the data by taking over the caller's vector.
+    //----------------------------------------------------------------------
+
+
+    /**
+     * Replace any existing data with the given vector, taking over its memory,
+     * and make this structure hold data of the given type.
+     *
+     * @param type   type of data.
+     * @param member vector of this object to hold the data.
+     * @param data   vector of data to be moved; it is left empty.
+     * @throws EvioException if this structure has children.
+     */
+    template<typename T>
+    void BaseStructure::adoptData(DataType const & type, std::vector<T> & member, std::vector<T> && data) {
+        if (!isLeaf()) {
+            throw EvioException("cannot set data in a structure with children");
+        }
+
+        header->setDataType(type);
+        clearData();
+        member = std::move(data);
+    }
+
+
+    /**
+     * Set the data to the given ints, replacing any existing data even if of a different type.
+     * The vector is moved into this object and left empty, so its values are copied only once,
+     * into the raw data, instead of once into this object and again into the raw data.
+     * Its memory is then freed, and {@link #getIntData()} gets the values back from
+     * the raw data if asked.
+     *
+     * @param data vector of ints to be moved.
+     * @throws EvioException if this structure has children.
+     */
+    void BaseStructure::setIntData(std::vector<int32_t> && data) {
+        adoptData(DataType::INT32, intData, std::move(data));
+        updateIntData();
+        intData.clear();
+        intData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given unsigned ints, replacing any existing data even if of a different type.
+     * @param data vector of unsigned ints to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setUIntData(std::vector<uint32_t> && data) {
+        adoptData(DataType::UINT32, uintData, std::move(data));
+        updateUIntData();
+        uintData.clear();
+        uintData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given shorts, replacing any existing data even if of a different type.
+     * @param data vector of shorts to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setShortData(std::vector<int16_t> && data) {
+        adoptData(DataType::SHORT16, shortData, std::move(data));
+        updateShortData();
+        shortData.clear();
+        shortData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given unsigned shorts, replacing any existing data even if of a different type.
+     * @param data vector of unsigned shorts to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setUShortData(std::vector<uint16_t> && data) {
+        adoptData(DataType::USHORT16, ushortData, std::move(data));
+        updateUShortData();
+        ushortData.clear();
+        ushortData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given longs, replacing any existing data even if of a different type.
+     * @param data vector of longs to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setLongData(std::vector<int64_t> && data) {
+        adoptData(DataType::LONG64, longData, std::move(data));
+        updateLongData();
+        longData.clear();
+        longData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given unsigned longs, replacing any existing data even if of a different type.
+     * @param data vector of unsigned longs to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setULongData(std::vector<uint64_t> && data) {
+        adoptData(DataType::ULONG64, ulongData, std::move(data));
+        updateULongData();
+        ulongData.clear();
+        ulongData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given signed chars, replacing any existing data even if of a different type.
+     * @param data vector of signed chars to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setCharData(std::vector<signed char> && data) {
+        adoptData(DataType::CHAR8, charData, std::move(data));
+        updateCharData();
+        charData.clear();
+        charData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given unsigned chars, replacing any existing data even if of
+     * a different type. Unlike the other types, nothing is copied: the vector's memory
+     * becomes this structure's raw data, padded to a 4-byte boundary, and it is left empty.
+     *
+     * @param data vector of unsigned chars to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setUCharData(std::vector<unsigned char> && data) {
+        adoptData(DataType::UCHAR8, rawBytes, std::move(data));
+
+        numberDataItems = rawBytes.size();
+        uint32_t pad = padCount[numberDataItems%4];
+        header->setPadding(pad);
+        rawBytes.resize(numberDataItems + pad, 0);
+
+        dataLengthChanged();
+    }
+
+
+    /**
+     * Set the data to the given floats, replacing any existing data even if of a different type.
+     * @param data vector of floats to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setFloatData(std::vector<float> && data) {
+        adoptData(DataType::FLOAT32, floatData, std::move(data));
+        updateFloatData();
+        floatData.clear();
+        floatData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given doubles, replacing any existing data even if of a different type.
+     * @param data vector of doubles to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setDoubleData(std::vector<double> && data) {
+        adoptData(DataType::DOUBLE64, doubleData, std::move(data));
+        updateDoubleData();
+        doubleData.clear();
+        doubleData.shrink_to_fit();
+    }
+
+
+    /**
+     * Set the data to the given strings, replacing any existing data even if of a different type.
+     * Unlike the numeric types, the vector is kept as well as written into the raw data.
+     * @param data vector of strings to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setStringData(std::vector<std::string> && data) {
+        adoptData(DataType::CHARSTAR8, stringList, std::move(data));
+        updateStringData();
+    }
+
+
+    /**
+     * Set the data to the given composite data, replacing any existing data even if of a different type.
+     * Unlike the numeric types, the vector is kept as well as written into the raw data.
+     * @param data vector of composite data to be moved.
+     * @throws EvioException if this structure has children.
+     * @see #setIntData(std::vector<int32_t> &&)
+     */
+    void BaseStructure::setCompositeData(std::vector<std::shared_ptr<CompositeData>> && data) {
+        adoptData(DataType::COMPOSITE, compositeData, std::move(data));
+        updateCompositeData();
+    }
+
+
+    //----------------------------------------------------------------------
+    // Methods to view the caller's data, for structures which only need to be written.
+    //----------------------------------------------------------------------
+
+
+    /**
+     * Make this structure's data a view of the caller's array, replacing any existing data.
+     * Nothing is copied until this structure is written, at which point the array is
+     * copied (or swapped) straight into the output. This structure's byte order becomes
+     * the local one, since that's the array's.
+     *
+     * @param type      type of data.
+     * @param data      pointer to array.
+     * @param count     number of items in array.
+     * @param itemBytes number of bytes in each item, 4 or 8.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(DataType const & type, const void *data, size_t count, size_t itemBytes) {
+        if (!isLeaf()) {
+            throw EvioException("cannot set data in a structure with children");
+        }
+        if (data == nullptr && count > 0) {
+            throw EvioException("null data arg");
+        }
+
+        header->setDataType(type);
+        clearData();
+        byteOrder = ByteOrder::ENDIAN_LOCAL;
+
+        if (count > 0) {
+            viewData = static_cast<const uint8_t *>(data);
+            viewLength = count * itemBytes;
+        }
+        numberDataItems = count;
+        header->setPadding(0);
+
+        dataLengthChanged();
+    }
+
+
+    /**
+     * Make this structure's data a view of the caller's ints, replacing any existing data
+     * even if of a different type, instead of a copy of them. This is for structures which
+     * only need to be written: the array is copied straight into the output,
+     * so it must not be changed or freed until then. Anything else needing
+     * this structure's data, such as {@link #getRawBytes()} or the get data methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param data  pointer to ints, in local byte order.
+     * @param count number of ints.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(const int32_t *data, size_t count) {
+        setDataView(DataType::INT32, data, count, sizeof(int32_t));
+    }
+
+
+    /**
+     * Make this structure's data a view of the caller's unsigned ints, replacing any existing data
+     * even if of a different type, instead of a copy of them. This is for structures which
+     * only need to be written: the array is copied straight into the output,
+     * so it must not be changed or freed until then. Anything else needing
+     * this structure's data, such as {@link #getRawBytes()} or the get data methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param data  pointer to unsigned ints, in local byte order.
+     * @param count number of unsigned ints.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(const uint32_t *data, size_t count) {
+        setDataView(DataType::UINT32, data, count, sizeof(uint32_t));
+    }
+
+
+    /**
+     * Make this structure's data a view of the caller's longs, replacing any existing data
+     * even if of a different type, instead of a copy of them. This is for structures which
+     * only need to be written: the array is copied straight into the output,
+     * so it must not be changed or freed until then. Anything else needing
+     * this structure's data, such as {@link #getRawBytes()} or the get data methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param data  pointer to longs, in local byte order.
+     * @param count number of longs.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(const int64_t *data, size_t count) {
+        setDataView(DataType::LONG64, data, count, sizeof(int64_t));
+    }
+
+
+    /**
+     * Make this structure's data a view of the caller's unsigned longs, replacing any existing data
+     * even if of a different type, instead of a copy of them. This is for structures which
+     * only need to be written: the array is copied straight into the output,
+     * so it must not be changed or freed until then. Anything else needing
+     * this structure's data, such as {@link #getRawBytes()} or the get data methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param data  pointer to unsigned longs, in local byte order.
+     * @param count number of unsigned longs.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(const uint64_t *data, size_t count) {
+        setDataView(DataType::ULONG64, data, count, sizeof(uint64_t));
+    }
+
+
+    /**
+     * Make this structure's data a view of the caller's floats, replacing any existing data
+     * even if of a different type, instead of a copy of them. This is for structures which
+     * only need to be written: the array is copied straight into the output,
+     * so it must not be changed or freed until then. Anything else needing
+     * this structure's data, such as {@link #getRawBytes()} or the get data methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param data  pointer to floats, in local byte order.
+     * @param count number of floats.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(const float *data, size_t count) {
+        setDataView(DataType::FLOAT32, data, count, sizeof(float));
+    }
+
+
+    /**
+     * Make this structure's data a view of the caller's doubles, replacing any existing data
+     * even if of a different type, instead of a copy of them. This is for structures which
+     * only need to be written: the array is copied straight into the output,
+     * so it must not be changed or freed until then. Anything else needing
+     * this structure's data, such as {@link #getRawBytes()} or the get data methods,
+     * first copies it into this structure, which then stops being a view.
+     *
+     * @param data  pointer to doubles, in local byte order.
+     * @param count number of doubles.
+     * @throws EvioException if this structure has children, or data is null and count is not 0.
+     */
+    void BaseStructure::setDataView(const double *data, size_t count) {
+        setDataView(DataType::DOUBLE64, data, count, sizeof(double));
+    }
+
+
+    /**
+     * Write the data viewed in the caller's memory.
+     *
+     * @param dest  pointer at which to write data.
+     * @param order byte order in which to write.
+     * @return the number of bytes written.
+     */
+    size_t BaseStructure::writeViewedData(uint8_t *dest, ByteOrder const & order) const {
+        // Swapping reads, but does not change, the viewed data
+        if (order.isLocalEndian()) {
+            std::memcpy(dest, viewData, viewLength);
+        }
+        else if (header->getDataType().getBytes() == 8) {
+            ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(viewData)),
+                                  viewLength/8, reinterpret_cast<uint64_t *>(dest));
+        }
+        else {
+            ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(viewData)),
+                                  viewLength/4, reinterpret_cast<uint32_t *>(dest));
+        }
+        return viewLength;
     }
 
 
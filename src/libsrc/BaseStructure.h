@@ -27,10 +27,12 @@
 #include <queue>
 #include <utility>
 #include <stdexcept>
+#include <functional>
 
 
 #include "ByteOrder.h"
 #include "ByteBuffer.h"
+#include "ByteBufferView.h"
 #include "DataType.h"
 #include "StructureType.h"
 #include "EvioException.h"
@@ -47,6 +49,9 @@ using namespace std::literals;
 namespace evio {
 
 
+    class StructureQueryIndex;
+
+
     /////////////////////////////////// DEPTH FIRST ITERATOR
 
     template<typename R>
@@ -402,6 +407,217 @@ namespace evio {
          */
         breadth_iterator bend()   { auto arg = getThis(); return breadth_iterator(arg, true); }
 
+        /** A structure's children, in order. */
+        typedef std::vector<std::shared_ptr<BaseStructure>> Children;
+
+        /**
+         * Callable handed each structure visited by {@link #visitAllStructures(StructureVisitor const &)}.
+         * The reference is only valid during the call.
+         */
+        typedef std::function<void(std::shared_ptr<BaseStructure> const & structure)> StructureVisitor;
+
+        /** Callable that returns true if a visited structure is to be accepted. */
+        typedef std::function<bool(std::shared_ptr<BaseStructure> const & structure)> StructureFilter;
+
+        class DepthFirstWalk;
+        class BreadthFirstWalk;
+
+        /**
+         * Iterator over a tree of structures, depth first (pre-order), starting with its root.
+         * Unlike {@link #iterator}, it hands out references into the tree instead of copies
+         * of shared pointers and keeps its place in a fixed array, only allocating once the
+         * tree is deeper than {@link #INLINE_LEVELS}.
+         * Adding or removing children while walking invalidates it.
+         */
+        class DepthFirstIterator {
+
+            friend class DepthFirstWalk;
+
+            public:
+
+            typedef std::forward_iterator_tag iterator_category;
+            typedef std::shared_ptr<BaseStructure> value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const std::shared_ptr<BaseStructure> * pointer;
+            typedef const std::shared_ptr<BaseStructure> & reference;
+
+            /** Levels of the tree tracked without allocating. */
+            static constexpr size_t INLINE_LEVELS = 16;
+
+            private:
+
+            /** Place in the children of one level. */
+            struct Level {
+                const Children *kids;
+                size_t next;
+            };
+
+            /** Current structure, null at the end. */
+            const std::shared_ptr<BaseStructure> *current = nullptr;
+
+            /** First levels below the root. */
+            Level levels[INLINE_LEVELS] {};
+
+            /** Any levels deeper than INLINE_LEVELS. */
+            std::vector<Level> deeper;
+
+            /** Number of levels currently below the root. */
+            size_t depth = 0;
+
+            explicit DepthFirstIterator(const std::shared_ptr<BaseStructure> *root) : current(root) {}
+
+            Level & level(size_t i) {return i < INLINE_LEVELS ? levels[i] : deeper[i - INLINE_LEVELS];}
+
+            public:
+
+            DepthFirstIterator() = default;
+
+            reference operator*()  const {return *current;}
+            pointer   operator->() const {return current;}
+
+            /**
+             * Get the number of levels the current structure is below the root of this walk.
+             * @return number of levels the current structure is below the root.
+             */
+            size_t getDepth() const {return depth;}
+
+            DepthFirstIterator & operator++() {
+                auto const & kids = (*current)->children;
+                if (!kids.empty()) {
+                    if (depth < INLINE_LEVELS) {
+                        levels[depth] = {&kids, 1};
+                    }
+                    else if (depth - INLINE_LEVELS < deeper.size()) {
+                        deeper[depth - INLINE_LEVELS] = {&kids, 1};
+                    }
+                    else {
+                        deeper.push_back({&kids, 1});
+                    }
+                    depth++;
+                    current = &kids[0];
+                    return *this;
+                }
+
+                while (depth > 0) {
+                    Level & top = level(depth - 1);
+                    if (top.next < top.kids->size()) {
+                        current = &(*top.kids)[top.next++];
+                        return *this;
+                    }
+                    depth--;
+                }
+
+                current = nullptr;
+                return *this;
+            }
+
+            bool operator==(const DepthFirstIterator &other) const {return current == other.current;}
+            bool operator!=(const DepthFirstIterator &other) const {return current != other.current;}
+        };
+
+        /**
+         * Range over a tree of structures, depth first, for use in range-based for loops.
+         * It holds the root so the tree stays alive while walked.
+         */
+        class DepthFirstWalk {
+            std::shared_ptr<BaseStructure> root;
+          public:
+            explicit DepthFirstWalk(std::shared_ptr<BaseStructure> root) : root(std::move(root)) {}
+            DepthFirstIterator begin() const {return DepthFirstIterator(&root);}
+            DepthFirstIterator end()   const {return DepthFirstIterator();}
+        };
+
+        /**
+         * Iterator over a tree of structures, breadth first, starting with its root.
+         * Unlike {@link #breadth_iterator}, it hands out references into the tree instead of
+         * copies of shared pointers and queues whole vectors of children, not each structure,
+         * in one vector which only grows as the walk widens.
+         * Adding or removing children while walking invalidates it.
+         */
+        class BreadthFirstIterator {
+
+            friend class BreadthFirstWalk;
+
+            public:
+
+            typedef std::forward_iterator_tag iterator_category;
+            typedef std::shared_ptr<BaseStructure> value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const std::shared_ptr<BaseStructure> * pointer;
+            typedef const std::shared_ptr<BaseStructure> & reference;
+
+            private:
+
+            /** Current structure, null at the end. */
+            const std::shared_ptr<BaseStructure> *current = nullptr;
+
+            /** Children vectors still to visit, from index head on. */
+            std::vector<const Children *> queue;
+
+            /** Index into queue of the children vector being visited. */
+            size_t head = 0;
+
+            /** Index of the next child in the children vector being visited. */
+            size_t next = 0;
+
+            explicit BreadthFirstIterator(const std::shared_ptr<BaseStructure> *root) : current(root) {}
+
+            public:
+
+            BreadthFirstIterator() = default;
+
+            reference operator*()  const {return *current;}
+            pointer   operator->() const {return current;}
+
+            BreadthFirstIterator & operator++() {
+                auto const & kids = (*current)->children;
+                if (!kids.empty()) {
+                    queue.push_back(&kids);
+                }
+
+                while (head < queue.size()) {
+                    if (next < queue[head]->size()) {
+                        current = &(*queue[head])[next++];
+                        return *this;
+                    }
+                    head++;
+                    next = 0;
+                }
+
+                current = nullptr;
+                return *this;
+            }
+
+            bool operator==(const BreadthFirstIterator &other) const {return current == other.current;}
+            bool operator!=(const BreadthFirstIterator &other) const {return current != other.current;}
+        };
+
+        /**
+         * Range over a tree of structures, breadth first, for use in range-based for loops.
+         * It holds the root so the tree stays alive while walked.
+         */
+        class BreadthFirstWalk {
+            std::shared_ptr<BaseStructure> root;
+          public:
+            explicit BreadthFirstWalk(std::shared_ptr<BaseStructure> root) : root(std::move(root)) {}
+            BreadthFirstIterator begin() const {return BreadthFirstIterator(&root);}
+            BreadthFirstIterator end()   const {return BreadthFirstIterator();}
+        };
+
+        /**
+         * Get a range over this structure and all its descendants, depth first,
+         * which does not copy shared pointers or allocate: <code>for (auto const & s : event->depthFirst())</code>.
+         * @return range over this tree, depth first.
+         */
+        DepthFirstWalk depthFirst() {return DepthFirstWalk(getThis());}
+
+        /**
+         * Get a range over this structure and all its descendants, breadth first,
+         * which does not copy shared pointers: <code>for (auto const & s : event->breadthFirst())</code>.
+         * @return range over this tree, breadth first.
+         */
+        BreadthFirstWalk breadthFirst() {return BreadthFirstWalk(getThis());}
+
     protected:
 
         /** This node's parent, or null if this node has no parent. */
@@ -413,6 +629,9 @@ namespace evio {
         /** True if the node is able to have children. */
         bool allowsChildren = true;
 
+        /** Index of this tree's structures made by {@link #getQueryIndex()}, if any. */
+        std::shared_ptr<StructureQueryIndex> queryIndex;
+
     public:
 
         std::shared_ptr<BaseStructure> getThis() {return shared_from_this();}
@@ -428,7 +647,7 @@ namespace evio {
         void remove(size_t childIndex);
 
         std::shared_ptr<BaseStructure> getParent() const;
-        std::vector<std::shared_ptr<BaseStructure>> getChildren() const;
+        const Children & getChildren() const;
         std::shared_ptr<BaseStructure> getChildAt(size_t index) const;
 
         size_t getChildCount() const;
@@ -459,6 +678,7 @@ namespace evio {
         uint32_t getDepth();
         uint32_t getLevel() const;
         std::vector<std::shared_ptr<BaseStructure>> getPath();
+        void getPath(std::vector<std::shared_ptr<BaseStructure>> & path);
 
     protected:
 
@@ -510,10 +730,23 @@ namespace evio {
                                std::shared_ptr<IEvioFilter> filter);
         void getMatchingStructures(std::shared_ptr<IEvioFilter> filter,
                                    std::vector<std::shared_ptr<BaseStructure>> & vec);
+        void getMatchingStructures(std::nullptr_t filter,
+                                   std::vector<std::shared_ptr<BaseStructure>> & vec);
+
+        void visitAllStructures(StructureVisitor const & visitor);
+        void visitAllStructures(StructureVisitor const & visitor, StructureFilter const & filter);
+        void getMatchingStructures(StructureFilter const & filter,
+                                   std::vector<std::shared_ptr<BaseStructure>> & vec);
+
+        std::shared_ptr<StructureQueryIndex> getQueryIndex();
     private:
-        void visitAllDescendants(std::shared_ptr<BaseStructure> structure,
-                                 std::shared_ptr<IEvioListener> listener,
-                                 std::shared_ptr<IEvioFilter> filter);
+        void visitAllDescendants(std::shared_ptr<BaseStructure> const & top,
+                                 std::shared_ptr<BaseStructure> const & structure,
+                                 std::shared_ptr<IEvioListener> const & listener,
+                                 std::shared_ptr<IEvioFilter> const & filter);
+        static void visitAllDescendants(std::shared_ptr<BaseStructure> const & structure,
+                                        StructureVisitor const & visitor,
+                                        StructureFilter const & filter);
 
 
 
@@ -530,6 +763,25 @@ namespace evio {
         /** The raw data of the structure. May contain padding. */
         std::vector<uint8_t> rawBytes;
 
+        /**
+         * If not null, this structure's raw data is not in rawBytes but is viewed
+         * in the raw bytes of this structure, the event it was parsed from.
+         * See {@link #setRawBytesView}.
+         */
+        std::shared_ptr<BaseStructure> viewSource;
+
+        /** Offset of this structure's raw data into viewSource's raw bytes. */
+        size_t viewOffset = 0;
+
+        /** Number of bytes of raw data, padding included, viewed in viewSource or viewData. */
+        size_t viewLength = 0;
+
+        /**
+         * If not null, this structure's raw data is not in rawBytes but is viewed
+         * in memory owned by the caller, in local byte order. See {@link #setDataView}.
+         */
+        const uint8_t *viewData = nullptr;
+
         /** Used if raw data should be interpreted as shorts. */
         std::vector<int16_t> shortData;
 
@@ -601,7 +853,10 @@ namespace evio {
         /** Endianness of the raw data if appropriate. Initialize to local endian. */
         ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
 
-        /** Keep track of whether header length data is up-to-date or not. */
+        /**
+         * Keep track of whether header length data is up-to-date or not.
+         * If true, so are the lengths of all descendants. If false, so are those of all ancestors.
+         */
         bool lengthsUpToDate = false;
 
     private:
@@ -616,12 +871,20 @@ namespace evio {
 
         bool getLengthsUpToDate() const;
         void setLengthsUpToDate(bool lengthsUpToDate);
+        void addToLengths(int64_t words);
+        void dataLengthChanged();
         uint32_t dataLength();
         void stringsToRawBytes();
 
     private:
 
         void clearData();
+        void resetForReuse();
+        void materializeView();
+        const uint8_t * rawData() const;
+        size_t rawSize() const;
+        template<typename T> TypedView<T> dataView(DataType const & type) const;
+        uint8_t * writeDirectTo(uint8_t *dest, const uint8_t *limit, ByteOrder const & order);
         void copyData(BaseStructure const & other);
         void copyData(std::shared_ptr<BaseStructure> const & other);
 
@@ -657,6 +920,7 @@ namespace evio {
         size_t write(uint8_t *dest, ByteOrder const & order);
 
         size_t writeQuick(uint8_t *dest);
+        size_t writeDirect(uint8_t *dest, size_t capacity, ByteOrder const & order);
         size_t writeQuick(ByteBuffer & dest);
 
         uint32_t getNumberDataItems();
@@ -669,10 +933,25 @@ namespace evio {
 
     protected:
 
-        void setRawBytes(uint8_t *bytes, uint32_t len);
+        void setRawBytes(const uint8_t *bytes, uint32_t len);
         void setRawBytes(std::vector<uint8_t> &bytes);
+        void setRawBytes(std::vector<uint8_t> &&bytes);
+        void setRawBytesView(std::shared_ptr<BaseStructure> const & source, size_t offset, size_t len);
 
     public:
+
+        bool isRawBytesView() const;
+        ByteBufferView getRawBytesView() const;
+
+        TypedView<int16_t>  getShortView() const;
+        TypedView<uint16_t> getUShortView() const;
+        TypedView<int32_t>  getIntView() const;
+        TypedView<uint32_t> getUIntView() const;
+        TypedView<int64_t>  getLongView() const;
+        TypedView<uint64_t> getULongView() const;
+        TypedView<float>    getFloatView() const;
+        TypedView<double>   getDoubleView() const;
+
         std::vector<int16_t>  &getShortData();
         std::vector<uint16_t> &getUShortData();
 
@@ -723,8 +1002,33 @@ namespace evio {
         void updateStringData();
         void updateCompositeData();
 
+        void setIntData(std::vector<int32_t> && data);
+        void setUIntData(std::vector<uint32_t> && data);
+        void setShortData(std::vector<int16_t> && data);
+        void setUShortData(std::vector<uint16_t> && data);
+        void setLongData(std::vector<int64_t> && data);
+        void setULongData(std::vector<uint64_t> && data);
+        void setCharData(std::vector<signed char> && data);
+        void setUCharData(std::vector<unsigned char> && data);
+        void setFloatData(std::vector<float> && data);
+        void setDoubleData(std::vector<double> && data);
+        void setStringData(std::vector<std::string> && data);
+        void setCompositeData(std::vector<std::shared_ptr<CompositeData>> && data);
+
+        void setDataView(const int32_t *data, size_t count);
+        void setDataView(const uint32_t *data, size_t count);
+        void setDataView(const int64_t *data, size_t count);
+        void setDataView(const uint64_t *data, size_t count);
+        void setDataView(const float *data, size_t count);
+        void setDataView(const double *data, size_t count);
+
     private:
 
+        template<typename T> void adoptData(DataType const & type, std::vector<T> & member,
+                                            std::vector<T> && data);
+        void setDataView(DataType const & type, const void *data, size_t count, size_t itemBytes);
+        size_t writeViewedData(uint8_t *dest, ByteOrder const & order) const;
+
         static void stringBuilderToStrings(std::string const & strData, bool onlyGoodChars,
                                            std::vector<std::string> & strings);
 
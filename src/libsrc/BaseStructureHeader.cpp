@@ -36,6 +36,7 @@ namespace evio {
         number   = head->number;
         length   = head->length;
         padding  = head->padding;
+        changed();
     }
 
     /**
@@ -48,7 +49,7 @@ namespace evio {
      * Set the number. Only Banks have a number field in their header, so this is only relevant for Banks.
      * @param num the number.
      */
-    void BaseStructureHeader::setNumber(uint8_t num) {number = num;}
+    void BaseStructureHeader::setNumber(uint8_t num) {number = num; changed();}
 
     /**
      * Get the data type for the structure.
@@ -60,13 +61,13 @@ namespace evio {
      * Set the numeric data type for the structure.
      * @param type the numeric data type for the structure.
      */
-    void BaseStructureHeader::setDataType(uint32_t type) {dataType = DataType::getDataType(type);}
+    void BaseStructureHeader::setDataType(uint32_t type) {dataType = DataType::getDataType(type); changed();}
 
     /**
      * Set the numeric data type for the structure.
      * @param type the numeric data type for the structure.
      */
-    void BaseStructureHeader::setDataType(DataType const & type) {dataType = type;}
+    void BaseStructureHeader::setDataType(DataType const & type) {dataType = type; changed();}
 
     /**
      * Returns the data type for data stored in this structure as a <code>DataType</code> enum.
@@ -117,6 +118,6 @@ namespace evio {
      * Set the structure tag.
      * @param t the structure tag.
      */
-    void BaseStructureHeader::setTag(uint16_t t) {tag = t;}
+    void BaseStructureHeader::setTag(uint16_t t) {tag = t; changed();}
 }
 
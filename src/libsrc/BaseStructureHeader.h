@@ -16,6 +16,7 @@
 #include <cstring>
 #include <cstdint>
 #include <sstream>
+#include <memory>
 
 
 #include "Util.h"
@@ -44,6 +45,7 @@ namespace evio {
         friend class EvioReaderV4;
         friend class EventHeaderParser;
         friend class StructureTransformer;
+        friend class StructureQueryIndex;
 
     protected:
 
@@ -72,9 +74,19 @@ namespace evio {
          */
         uint8_t number = 0;
 
+        /**
+         * Count of changes shared by all headers of a tree of structures which has
+         * a {@link StructureQueryIndex}, or null if none. Changing tag, num, or type ups it,
+         * which tells the index it's out of date.
+         */
+        std::shared_ptr<uint64_t> indexStamp;
+
     protected:
 
         void setPadding(uint8_t pad);
+
+        /** Tell any index of the tree holding this header that it changed. */
+        void changed() {if (indexStamp) (*indexStamp)++;}
         void copy(std::shared_ptr<BaseStructureHeader> const & head);
 
     public:
@@ -18,6 +18,45 @@ namespace evio {
     void null_deleter(uint8_t *) {};
 
 
+    std::shared_ptr<ByteBufferAllocator> ByteBuffer::defaultAllocator = nullptr;
+
+
+    /**
+     * Set the allocator used for the internal arrays of all ByteBuffers subsequently created,
+     * expanded, or copied. Buffers already allocated keep their memory and release it through
+     * the allocator that supplied it. Thread-safe.
+     * @param allocator allocator to use, or nullptr to go back to plain new and delete.
+     */
+    void ByteBuffer::setDefaultAllocator(const std::shared_ptr<ByteBufferAllocator> & allocator) {
+        std::atomic_store(&defaultAllocator, allocator);
+    }
+
+
+    /**
+     * Get the allocator used for the internal arrays of ByteBuffers. Thread-safe.
+     * @return allocator used, or nullptr if plain new and delete are used.
+     */
+    std::shared_ptr<ByteBufferAllocator> ByteBuffer::getDefaultAllocator() {
+        return std::atomic_load(&defaultAllocator);
+    }
+
+
+    /**
+     * Allocate an internal array through the default allocator if one is set
+     * and it accepts the request, otherwise with new.
+     * @param size size in bytes of array.
+     * @return shared pointer to array.
+     */
+    std::shared_ptr<uint8_t> ByteBuffer::allocateArray(size_t size) {
+        auto allocator = std::atomic_load(&defaultAllocator);
+        if (allocator != nullptr) {
+            auto mem = allocator->allocate(size);
+            if (mem != nullptr) return mem;
+        }
+        return std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+    }
+
+
     /** Default constructor, size of 4096 bytes.  */
     ByteBuffer::ByteBuffer() : ByteBuffer(4096) {}
 
@@ -28,7 +67,33 @@ namespace evio {
      */
     ByteBuffer::ByteBuffer(size_t size) {
 
-        buf = std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+        buf = allocateArray(size);
+        totalSize = cap = size;
+        clear();
+
+        isLittleEndian = byteOrder.isLittleEndian();
+        isHostEndian = true;
+    }
+
+
+    /**
+     * Constructor. Reserves specified size in internal array which starts
+     * on the given memory boundary, as needed for direct (unbuffered) file I/O.
+     * The alignment is not kept if the array is later expanded or copied.
+     *
+     * @param size size (in bytes) of space to preallocate internally.
+     * @param alignment boundary in bytes, a power of 2 and multiple of sizeof(void *).
+     * @throws EvioException if alignment invalid or out of memory.
+     */
+    ByteBuffer::ByteBuffer(size_t size, size_t alignment) {
+
+        void *mem = nullptr;
+        if (posix_memalign(&mem, alignment, size < 1 ? 1 : size) != 0) {
+            throw EvioException("cannot allocate " + std::to_string(size) +
+                                " bytes aligned to " + std::to_string(alignment));
+        }
+
+        buf = std::shared_ptr<uint8_t>(static_cast<uint8_t *>(mem), [](uint8_t *p) {free(p);});
         totalSize = cap = size;
         clear();
 
@@ -104,6 +169,23 @@ namespace evio {
     }
 
 
+    /**
+     * Constructor which wraps an array held by a shared pointer, so that
+     * memory it doesn't own, such as a caller's, can be wrapped without copying
+     * by giving the shared pointer a deleter which does nothing.
+     *
+     * @param byteArray shared pointer to array which this object will wrap.
+     * @param len length of array in bytes.
+     */
+    ByteBuffer::ByteBuffer(std::shared_ptr<uint8_t> byteArray, size_t len) : buf(std::move(byteArray)) {
+        totalSize = cap = len;
+        clear();
+
+        isLittleEndian = byteOrder.isLittleEndian();
+        isHostEndian = true;
+    }
+
+
     /** Destructor. Be sure to unmap any memory mapped file. */
     ByteBuffer::~ByteBuffer() {
         if (isMappedMemory) {
@@ -224,7 +306,7 @@ namespace evio {
         // Avoid self copy ...
         if (this != &srcBuf) {
             // A copy should not use the same shared pointer, copy data over
-            buf = std::shared_ptr<uint8_t>(new uint8_t[srcBuf.totalSize], std::default_delete<uint8_t[]>());
+            buf = allocateArray(srcBuf.totalSize);
 
             pos = srcBuf.pos;
             cap = srcBuf.cap;
@@ -287,7 +369,7 @@ namespace evio {
         if (newSize < 1) return;
         if (newSize > cap) {
 //std::cout << "copyData:  REALLOCATING MEM!!!\n";
-            buf = std::shared_ptr<uint8_t>(new uint8_t[newSize], std::default_delete<uint8_t[]>());
+            buf = allocateArray(newSize);
             cap = newSize;
             totalSize = newSize;
         }
@@ -388,12 +470,12 @@ namespace evio {
 
         // If there's data copy it over
         if (lim > 0) {
-            auto tempBuf = std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+            auto tempBuf = allocateArray(size);
             std::memcpy((void *)(tempBuf.get()), (const void *)(buf.get() + off), lim);
             buf = tempBuf;
         }
         else {
-            buf = std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+            buf = allocateArray(size);
         }
         totalSize = cap = size;
         off = 0;
@@ -735,7 +817,9 @@ namespace evio {
      * @return  the same byte buffer as passed in as the argument.
      */
     std::shared_ptr<ByteBuffer> ByteBuffer::duplicate() {
-        auto destBuf = std::make_shared<ByteBuffer>(cap);
+        // Do not allocate memory that will immediately be replaced by shared data
+        auto destBuf = std::make_shared<ByteBuffer>(0);
+        destBuf->cap = cap;
         destBuf->lim = lim;
         destBuf->pos = pos;
         destBuf->mrk = mrk;
@@ -771,7 +855,8 @@ namespace evio {
 
         size_t remaining = (pos <= lim ? lim - pos : 0);
 
-        auto sliceBuf = std::make_shared<ByteBuffer>(remaining);
+        // Do not allocate memory that will immediately be replaced by shared data
+        auto sliceBuf = std::make_shared<ByteBuffer>(0);
         sliceBuf->cap = remaining;
         sliceBuf->lim = remaining;
         sliceBuf->pos = 0;
@@ -916,6 +1001,136 @@ namespace evio {
     }
 
 
+    /**
+     * Relative bulk <i>get</i> method for reading short values.
+     *
+     * This method transfers <tt>count</tt> 2-byte values from this buffer into
+     * the given destination array, composing them according to the current byte order.
+     * If there are fewer than <tt>2*count</tt> bytes remaining in the buffer,
+     * then nothing is transferred and an underflow_error is thrown.
+     * The position of this buffer is then incremented by <tt>2*count</tt>.<p>
+     *
+     * This is much faster than calling {@link #getShort()} repeatedly
+     * since swapping, if needed, is done with vector instructions.
+     *
+     * @param  dst   array into which values are to be written.
+     * @param  count number of values to be written to the given array.
+     * @return  this buffer.
+     * @throws  underflow_error if fewer than <tt>2*count</tt> bytes remaining in buffer.
+     */
+    const ByteBuffer & ByteBuffer::getShorts(uint16_t *dst, size_t count) const {
+        size_t length = 2*count;
+        if (length > remaining()) {
+            throw std::underflow_error("buffer underflow");
+        }
+
+        if (isHostEndian) {
+            memcpy((void *)dst, (const void *)(buf.get() + off + pos), length);
+        }
+        else {
+            ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(buf.get() + off + pos), count, dst);
+        }
+        pos += length;
+        return *this;
+    }
+
+
+    /**
+     * Relative bulk <i>get</i> method for reading int values.
+     *
+     * This method transfers <tt>count</tt> 4-byte values from this buffer into
+     * the given destination array, composing them according to the current byte order.
+     * If there are fewer than <tt>4*count</tt> bytes remaining in the buffer,
+     * then nothing is transferred and an underflow_error is thrown.
+     * The position of this buffer is then incremented by <tt>4*count</tt>.<p>
+     *
+     * This is much faster than calling {@link #getInt()} repeatedly
+     * since swapping, if needed, is done with vector instructions.
+     *
+     * @param  dst   array into which values are to be written.
+     * @param  count number of values to be written to the given array.
+     * @return  this buffer.
+     * @throws  underflow_error if fewer than <tt>4*count</tt> bytes remaining in buffer.
+     */
+    const ByteBuffer & ByteBuffer::getInts(uint32_t *dst, size_t count) const {
+        size_t length = 4*count;
+        if (length > remaining()) {
+            throw std::underflow_error("buffer underflow");
+        }
+
+        if (isHostEndian) {
+            memcpy((void *)dst, (const void *)(buf.get() + off + pos), length);
+        }
+        else {
+            ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(buf.get() + off + pos), count, dst);
+        }
+        pos += length;
+        return *this;
+    }
+
+
+    /**
+     * Relative bulk <i>get</i> method for reading long values.
+     *
+     * This method transfers <tt>count</tt> 8-byte values from this buffer into
+     * the given destination array, composing them according to the current byte order.
+     * If there are fewer than <tt>8*count</tt> bytes remaining in the buffer,
+     * then nothing is transferred and an underflow_error is thrown.
+     * The position of this buffer is then incremented by <tt>8*count</tt>.<p>
+     *
+     * This is much faster than calling {@link #getLong()} repeatedly
+     * since swapping, if needed, is done with vector instructions.
+     *
+     * @param  dst   array into which values are to be written.
+     * @param  count number of values to be written to the given array.
+     * @return  this buffer.
+     * @throws  underflow_error if fewer than <tt>8*count</tt> bytes remaining in buffer.
+     */
+    const ByteBuffer & ByteBuffer::getLongs(uint64_t *dst, size_t count) const {
+        size_t length = 8*count;
+        if (length > remaining()) {
+            throw std::underflow_error("buffer underflow");
+        }
+
+        if (isHostEndian) {
+            memcpy((void *)dst, (const void *)(buf.get() + off + pos), length);
+        }
+        else {
+            ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(buf.get() + off + pos), count, dst);
+        }
+        pos += length;
+        return *this;
+    }
+
+
+    /**
+     * Relative bulk <i>get</i> method for reading float values.
+     * Works just like {@link #getInts(uint32_t *, size_t)}.
+     *
+     * @param  dst   array into which values are to be written.
+     * @param  count number of values to be written to the given array.
+     * @return  this buffer.
+     * @throws  underflow_error if fewer than <tt>4*count</tt> bytes remaining in buffer.
+     */
+    const ByteBuffer & ByteBuffer::getFloats(float *dst, size_t count) const {
+        return getInts(reinterpret_cast<uint32_t *>(dst), count);
+    }
+
+
+    /**
+     * Relative bulk <i>get</i> method for reading double values.
+     * Works just like {@link #getLongs(uint64_t *, size_t)}.
+     *
+     * @param  dst   array into which values are to be written.
+     * @param  count number of values to be written to the given array.
+     * @return  this buffer.
+     * @throws  underflow_error if fewer than <tt>8*count</tt> bytes remaining in buffer.
+     */
+    const ByteBuffer & ByteBuffer::getDoubles(double *dst, size_t count) const {
+        return getLongs(reinterpret_cast<uint64_t *>(dst), count);
+    }
+
+
     /**
      * Relative <i>get</i> method. Reads the byte at this buffer's
      * current position, but does not increments the position.
@@ -1436,6 +1651,142 @@ namespace evio {
     }
 
 
+    /**
+     * Relative bulk <i>put</i> method for writing short values.
+     *
+     * This method transfers <tt>count</tt> 2-byte values from the given source
+     * array into this buffer, writing them in the current byte order.
+     * If there are fewer than <tt>2*count</tt> bytes remaining in the buffer,
+     * then nothing is transferred and an overflow_error is thrown.
+     * The position of this buffer is then incremented by <tt>2*count</tt>.<p>
+     *
+     * This is much faster than calling {@link #putShort(uint16_t)} repeatedly
+     * since swapping, if needed, is done with vector instructions.
+     *
+     * @param  src   array from which values are to be read.
+     * @param  count number of values to be read from the given array.
+     * @return  this buffer.
+     * @throws  overflow_error if fewer than <tt>2*count</tt> bytes remaining in buffer.
+     */
+    ByteBuffer & ByteBuffer::putShorts(const uint16_t *src, size_t count) {
+        size_t length = 2*count;
+        if (length > remaining()) {
+            throw std::overflow_error("buffer overflow");
+        }
+
+        if (isHostEndian) {
+            std::memcpy((void *)(buf.get() + off + pos), (const void *)src, length);
+        }
+        else {
+            // src is only read when a destination is given
+            ByteOrder::byteSwap16(const_cast<uint16_t *>(src), count,
+                                  reinterpret_cast<uint16_t *>(buf.get() + off + pos));
+        }
+        pos += length;
+        return *this;
+    }
+
+
+    /**
+     * Relative bulk <i>put</i> method for writing int values.
+     *
+     * This method transfers <tt>count</tt> 4-byte values from the given source
+     * array into this buffer, writing them in the current byte order.
+     * If there are fewer than <tt>4*count</tt> bytes remaining in the buffer,
+     * then nothing is transferred and an overflow_error is thrown.
+     * The position of this buffer is then incremented by <tt>4*count</tt>.<p>
+     *
+     * This is much faster than calling {@link #putInt(uint32_t)} repeatedly
+     * since swapping, if needed, is done with vector instructions.
+     *
+     * @param  src   array from which values are to be read.
+     * @param  count number of values to be read from the given array.
+     * @return  this buffer.
+     * @throws  overflow_error if fewer than <tt>4*count</tt> bytes remaining in buffer.
+     */
+    ByteBuffer & ByteBuffer::putInts(const uint32_t *src, size_t count) {
+        size_t length = 4*count;
+        if (length > remaining()) {
+            throw std::overflow_error("buffer overflow");
+        }
+
+        if (isHostEndian) {
+            std::memcpy((void *)(buf.get() + off + pos), (const void *)src, length);
+        }
+        else {
+            // src is only read when a destination is given
+            ByteOrder::byteSwap32(const_cast<uint32_t *>(src), count,
+                                  reinterpret_cast<uint32_t *>(buf.get() + off + pos));
+        }
+        pos += length;
+        return *this;
+    }
+
+
+    /**
+     * Relative bulk <i>put</i> method for writing long values.
+     *
+     * This method transfers <tt>count</tt> 8-byte values from the given source
+     * array into this buffer, writing them in the current byte order.
+     * If there are fewer than <tt>8*count</tt> bytes remaining in the buffer,
+     * then nothing is transferred and an overflow_error is thrown.
+     * The position of this buffer is then incremented by <tt>8*count</tt>.<p>
+     *
+     * This is much faster than calling {@link #putLong(uint64_t)} repeatedly
+     * since swapping, if needed, is done with vector instructions.
+     *
+     * @param  src   array from which values are to be read.
+     * @param  count number of values to be read from the given array.
+     * @return  this buffer.
+     * @throws  overflow_error if fewer than <tt>8*count</tt> bytes remaining in buffer.
+     */
+    ByteBuffer & ByteBuffer::putLongs(const uint64_t *src, size_t count) {
+        size_t length = 8*count;
+        if (length > remaining()) {
+            throw std::overflow_error("buffer overflow");
+        }
+
+        if (isHostEndian) {
+            std::memcpy((void *)(buf.get() + off + pos), (const void *)src, length);
+        }
+        else {
+            // src is only read when a destination is given
+            ByteOrder::byteSwap64(const_cast<uint64_t *>(src), count,
+                                  reinterpret_cast<uint64_t *>(buf.get() + off + pos));
+        }
+        pos += length;
+        return *this;
+    }
+
+
+    /**
+     * Relative bulk <i>put</i> method for writing float values.
+     * Works just like {@link #putInts(const uint32_t *, size_t)}.
+     *
+     * @param  src   array from which values are to be read.
+     * @param  count number of values to be read from the given array.
+     * @return  this buffer.
+     * @throws  overflow_error if fewer than <tt>4*count</tt> bytes remaining in buffer.
+     */
+    ByteBuffer & ByteBuffer::putFloats(const float *src, size_t count) {
+        return putInts(reinterpret_cast<const uint32_t *>(src), count);
+    }
+
+
+    /**
+     * Relative bulk <i>put</i> method for writing double values.
+     * Works just like {@link #putLongs(const uint64_t *, size_t)}.
+     *
+     * @param  src   array from which values are to be read.
+     * @param  count number of values to be read from the given array.
+     * @return  this buffer.
+     * @throws  overflow_error if fewer than <tt>8*count</tt> bytes remaining in buffer.
+     */
+    ByteBuffer & ByteBuffer::putDoubles(const double *src, size_t count) {
+        return putLongs(reinterpret_cast<const uint64_t *>(src), count);
+    }
+
+
     /**
      * Relative <i>put</i> method.
      * Writes the given byte into this buffer at the current
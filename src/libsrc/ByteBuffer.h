@@ -25,6 +25,7 @@
 
 #include "ByteOrder.h"
 #include "EvioException.h"
+#include "ByteBufferAllocator.h"
 
 
 namespace evio {
@@ -87,14 +88,21 @@ namespace evio {
          */
         bool isMappedMemory = false;
 
+        /** Allocator of internal arrays for all ByteBuffers, nullptr means use new. */
+        static std::shared_ptr<ByteBufferAllocator> defaultAllocator;
+
+        static std::shared_ptr<uint8_t> allocateArray(size_t size);
+
     public:
 
         ByteBuffer();
         explicit ByteBuffer(size_t size);
+        ByteBuffer(size_t size, size_t alignment);
         ByteBuffer(const ByteBuffer & srcBuf);
         ByteBuffer(ByteBuffer && srcBuf) noexcept;
         ByteBuffer(char* byteArray, size_t len, bool isMappedMem = false);
         ByteBuffer(uint8_t* byteArray, size_t len, bool isMappedMem = false);
+        ByteBuffer(std::shared_ptr<uint8_t> byteArray, size_t len);
 
         ~ByteBuffer();
 
@@ -107,6 +115,9 @@ namespace evio {
         ByteBuffer & compact();
         ByteBuffer & zero();
 
+        static void setDefaultAllocator(const std::shared_ptr<ByteBufferAllocator> & allocator);
+        static std::shared_ptr<ByteBufferAllocator> getDefaultAllocator();
+
         static std::shared_ptr<ByteBuffer> copyBuffer(const std::shared_ptr<const ByteBuffer> & srcBuf);
         void copyData(const std::shared_ptr<const ByteBuffer> & srcBuf, size_t pos, size_t limit);
         void copy(const ByteBuffer & srcBuf);
@@ -148,6 +159,11 @@ namespace evio {
 
         const ByteBuffer & getBytes(uint8_t * dst, size_t length) const;
         const ByteBuffer & getBytes(std::vector<uint8_t> & dst, size_t offset, size_t length) const;
+        const ByteBuffer & getShorts(uint16_t * dst, size_t count) const;
+        const ByteBuffer & getInts(uint32_t * dst, size_t count) const;
+        const ByteBuffer & getLongs(uint64_t * dst, size_t count) const;
+        const ByteBuffer & getFloats(float * dst, size_t count) const;
+        const ByteBuffer & getDoubles(double * dst, size_t count) const;
 
         uint8_t  peek() const;
         uint8_t  getByte()  const;
@@ -176,6 +192,31 @@ namespace evio {
         double   getDouble() const;
         double   getDouble(size_t index) const;
 
+        /** @return true if data must be swapped to be read in the local byte order. */
+        bool     isSwapped() const {return !isHostEndian;}
+
+        /**
+         * Absolute get of a 16, 32, or 64 bit integer with the swap fixed at compile time,
+         * regardless of this buffer's byte order. A method reading many values can test
+         * {@link #isSwapped()} once and then loop with the matching instantiation,
+         * instead of having the byte order tested on each read.
+         *
+         * @tparam SWAP true if the value is to be swapped.
+         * @tparam T    integer type to read.
+         * @param index byte index to read from.
+         * @return value at index.
+         * @throws underflow_error if fewer than sizeof(T) bytes remaining in buffer.
+         */
+        template<bool SWAP, typename T> T getAs(size_t index) const {
+            T data = read<T>(index);
+            if constexpr (SWAP) {
+                if      constexpr (sizeof(T) == 2) data = SWAP_16(data);
+                else if constexpr (sizeof(T) == 4) data = SWAP_32(data);
+                else if constexpr (sizeof(T) == 8) data = SWAP_64(data);
+            }
+            return data;
+        }
+
         // Write
 
         // Bulk byte writes
@@ -184,6 +225,13 @@ namespace evio {
         ByteBuffer & put(const uint8_t * src, size_t length);
         ByteBuffer & put(const std::vector<uint8_t> & src, size_t offset, size_t length);
 
+        // Bulk typed writes
+        ByteBuffer & putShorts(const uint16_t * src, size_t count);
+        ByteBuffer & putInts(const uint32_t * src, size_t count);
+        ByteBuffer & putLongs(const uint64_t * src, size_t count);
+        ByteBuffer & putFloats(const float * src, size_t count);
+        ByteBuffer & putDoubles(const double * src, size_t count);
+
         ByteBuffer & put(uint8_t val);               // Relative write
         ByteBuffer & put(size_t index, uint8_t val); // Absolute write at index
 
@@ -0,0 +1,51 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_BYTEBUFFERALLOCATOR_H
+#define EVIO_6_0_BYTEBUFFERALLOCATOR_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+
+namespace evio {
+
+
+    /**
+     * Interface used by {@link ByteBuffer} to obtain the memory backing its internal array.
+     * Installing an implementation with {@link ByteBuffer#setDefaultAllocator} lets all
+     * buffers created internally, such as those of RecordInput, RecordOutput, RecordRingItem,
+     * CompactEventBuilder and Reader, reuse memory instead of calling new and delete
+     * for each one. See {@link ByteBufferPool}.
+     */
+    class ByteBufferAllocator {
+
+    public:
+
+        virtual ~ByteBufferAllocator() = default;
+
+        /**
+         * Allocate memory of at least the given size. The returned shared pointer
+         * must carry the deleter which releases the memory.
+         * Must be thread-safe.
+         *
+         * @param size number of bytes needed.
+         * @return shared pointer to memory, or nullptr if this allocator declines the request,
+         *         in which case ByteBuffer allocates with new.
+         */
+        virtual std::shared_ptr<uint8_t> allocate(size_t size) = 0;
+    };
+
+}
+
+
+#endif //EVIO_6_0_BYTEBUFFERALLOCATOR_H
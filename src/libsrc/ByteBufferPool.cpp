@@ -0,0 +1,234 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "ByteBufferPool.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <sys/mman.h>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param alignment byte boundary at which blocks start, a power of 2 from sizeof(void *) to 4096.
+     * @param hugePages if true, back blocks of 2 MB or more with huge pages (Linux only).
+     * @param maxCachedBytes maximum number of bytes kept in free lists for reuse.
+     * @param minSize requests for fewer bytes are not pooled, but left to new.
+     * @throws EvioException if alignment is invalid.
+     */
+    ByteBufferPool::ByteBufferPool(size_t alignment, bool hugePages, size_t maxCachedBytes, size_t minSize) :
+            alignment(alignment), hugePages(hugePages), maxCachedBytes(maxCachedBytes), minSize(minSize) {
+
+        if (alignment < sizeof(void *) || alignment > 4096 || (alignment & (alignment - 1)) != 0) {
+            throw EvioException("alignment must be a power of 2 from " +
+                                std::to_string(sizeof(void *)) + " to 4096");
+        }
+#ifndef __linux__
+        this->hugePages = false;
+#endif
+    }
+
+
+    /** Destructor. Frees all cached blocks. Blocks in use are freed when their buffers are done. */
+    ByteBufferPool::~ByteBufferPool() {
+        trim();
+    }
+
+
+    /**
+     * Size class of a request, the power of 2 which the request is rounded up to.
+     * @param size number of bytes requested.
+     * @return index of size class.
+     */
+    int ByteBufferPool::sizeClass(size_t size) {
+        int index = 0;
+        while (((size_t)1 << index) < size) index++;
+        return index;
+    }
+
+
+    /**
+     * Is a block of this size backed by huge pages?
+     * @param blockSize size of block in bytes.
+     * @return true if block uses huge pages.
+     */
+    bool ByteBufferPool::isHuge(size_t blockSize) const {
+        return hugePages && blockSize >= HUGE_PAGE_SIZE;
+    }
+
+
+    /**
+     * Allocate a new block from the system.
+     * @param blockSize size of block in bytes, a power of 2.
+     * @param huge if true, back the block with huge pages.
+     * @return pointer to block, or nullptr if out of memory.
+     */
+    uint8_t * ByteBufferPool::allocateBlock(size_t blockSize, bool huge) const {
+
+#ifdef __linux__
+        if (huge) {
+            // Explicit huge pages, available only if the system has some reserved
+            void *mem = ::mmap(nullptr, blockSize, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mem != MAP_FAILED) return static_cast<uint8_t *>(mem);
+
+            // Otherwise map extra so the block can start on a huge page boundary,
+            // unmap what's left over on either side, and ask for transparent huge pages.
+            size_t mapSize = blockSize + HUGE_PAGE_SIZE;
+            mem = ::mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) return nullptr;
+
+            auto start = reinterpret_cast<uintptr_t>(mem);
+            uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+            size_t head = aligned - start;
+            size_t tail = mapSize - head - blockSize;
+            if (head > 0) ::munmap(mem, head);
+            if (tail > 0) ::munmap(reinterpret_cast<void *>(aligned + blockSize), tail);
+
+            ::madvise(reinterpret_cast<void *>(aligned), blockSize, MADV_HUGEPAGE);
+            return reinterpret_cast<uint8_t *>(aligned);
+        }
+#endif
+
+        void *mem = nullptr;
+        if (posix_memalign(&mem, alignment, blockSize) != 0) return nullptr;
+        return static_cast<uint8_t *>(mem);
+    }
+
+
+    /**
+     * Return a block to the system.
+     * @param block pointer to block.
+     * @param blockSize size of block in bytes.
+     * @param huge true if block was mapped with huge pages.
+     */
+    void ByteBufferPool::freeBlock(uint8_t *block, size_t blockSize, bool huge) {
+        if (huge) {
+            ::munmap(block, blockSize);
+        }
+        else {
+            free(block);
+        }
+    }
+
+
+    /**
+     * Put a block, no longer used, back onto its free list,
+     * or free it if the maximum number of bytes is already cached.
+     * @param block pointer to block.
+     * @param index size class of block.
+     */
+    void ByteBufferPool::release(uint8_t *block, int index) {
+        size_t blockSize = (size_t)1 << index;
+
+        if (cachedBytes + blockSize <= maxCachedBytes) {
+            SizeClass & sc = classes[index];
+            std::lock_guard<std::mutex> lock(sc.mutex);
+            sc.blocks.push_back(block);
+            cachedBytes += blockSize;
+            return;
+        }
+
+        freeBlock(block, blockSize, isHuge(blockSize));
+    }
+
+
+    /**
+     * Get a block of at least the given size, reusing a cached one if possible.
+     * The returned memory goes back to this pool when its last shared pointer
+     * is destroyed. Thread-safe.
+     *
+     * @param size number of bytes needed.
+     * @return shared pointer to memory, or nullptr if size is too small to pool.
+     * @throws EvioException if out of memory.
+     */
+    std::shared_ptr<uint8_t> ByteBufferPool::allocate(size_t size) {
+
+        if (size < minSize) return nullptr;
+
+        int index = sizeClass(size);
+        if (index >= CLASS_COUNT) {
+            throw EvioException("cannot allocate " + std::to_string(size) + " bytes");
+        }
+        size_t blockSize = (size_t)1 << index;
+        bool huge = isHuge(blockSize);
+        uint8_t *block = nullptr;
+
+        {
+            SizeClass & sc = classes[index];
+            std::lock_guard<std::mutex> lock(sc.mutex);
+            if (!sc.blocks.empty()) {
+                block = sc.blocks.back();
+                sc.blocks.pop_back();
+                cachedBytes -= blockSize;
+            }
+        }
+
+        if (block != nullptr) {
+            reuses++;
+        }
+        else {
+            block = allocateBlock(blockSize, huge);
+            if (block == nullptr) {
+                // Give back what's cached and try once more
+                trim();
+                block = allocateBlock(blockSize, huge);
+                if (block == nullptr) {
+                    throw EvioException("cannot allocate " + std::to_string(blockSize) + " bytes");
+                }
+            }
+            allocations++;
+        }
+
+        // If the pool is gone by the time the memory is released, free it directly
+        std::weak_ptr<ByteBufferPool> pool = weak_from_this();
+        return std::shared_ptr<uint8_t>(block, [pool, index, blockSize, huge](uint8_t *p) {
+            auto owner = pool.lock();
+            if (owner != nullptr) {
+                owner->release(p, index);
+            }
+            else {
+                freeBlock(p, blockSize, huge);
+            }
+        });
+    }
+
+
+    /** Free all cached blocks. Thread-safe. */
+    void ByteBufferPool::trim() {
+        for (int i=0; i < CLASS_COUNT; i++) {
+            SizeClass & sc = classes[i];
+            size_t blockSize = (size_t)1 << i;
+            std::lock_guard<std::mutex> lock(sc.mutex);
+            for (uint8_t *block : sc.blocks) {
+                freeBlock(block, blockSize, isHuge(blockSize));
+                cachedBytes -= blockSize;
+            }
+            sc.blocks.clear();
+        }
+    }
+
+
+    /**
+     * Obtain a string representation of this pool's usage.
+     * @return string representation of this pool's usage.
+     */
+    std::string ByteBufferPool::toString() const {
+        std::stringstream ss;
+        ss << "ByteBufferPool: alignment = " << alignment << ", huge pages = " << hugePages <<
+              ", allocations = " << allocations << ", reuses = " << reuses <<
+              ", cached bytes = " << cachedBytes;
+        return ss.str();
+    }
+
+}
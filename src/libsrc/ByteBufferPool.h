@@ -0,0 +1,131 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_BYTEBUFFERPOOL_H
+#define EVIO_6_0_BYTEBUFFERPOOL_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <string>
+
+
+#include "ByteBufferAllocator.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * Thread-safe pool of aligned memory blocks for {@link ByteBuffer} arrays.
+     * Requests are rounded up to a power of 2 and served from a free list for that size class.
+     * When a ByteBuffer (and every buffer sharing its memory) is done with a block,
+     * the block goes back to its free list instead of being deleted - unless the pool no longer
+     * exists or already caches its maximum number of bytes, in which case it is freed.
+     * Thus the records and buffers which evio keeps reallocating when reading and writing
+     * reuse the same memory.<p>
+     *
+     * Blocks start on a 64 byte (cache line) boundary by default, or any power of 2 up to
+     * 4 KiB (page) as needed for direct I/O. On Linux, blocks of 2 MB or more can be backed
+     * by huge pages: explicit ones (MAP_HUGETLB) if the system has them reserved, otherwise
+     * transparent huge pages are requested through madvise.<p>
+     *
+     * Typical use:
+     * <pre><code>
+     *    ByteBuffer::setDefaultAllocator(std::make_shared&lt;ByteBufferPool&gt;());
+     * </code></pre>
+     */
+    class ByteBufferPool : public ByteBufferAllocator, public std::enable_shared_from_this<ByteBufferPool> {
+
+    public:
+
+        /** Size of a huge page in bytes. */
+        static const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+
+    private:
+
+        /** Number of size classes, one for each power of 2. */
+        static const int CLASS_COUNT = 48;
+
+        /** Free list of blocks of a single size. */
+        struct SizeClass {
+            std::mutex mutex;
+            std::vector<uint8_t *> blocks;
+        };
+
+        /** One free list for each power of 2 size. */
+        SizeClass classes[CLASS_COUNT];
+
+        /** Byte boundary at which blocks start. */
+        size_t alignment;
+
+        /** Back blocks of HUGE_PAGE_SIZE or more with huge pages? */
+        bool hugePages;
+
+        /** Maximum number of bytes kept in free lists. */
+        size_t maxCachedBytes;
+
+        /** Requests smaller than this are left to new. */
+        size_t minSize;
+
+        /** Number of bytes in free lists. */
+        std::atomic<size_t> cachedBytes {0};
+
+        /** Number of blocks newly allocated from the system. */
+        std::atomic<uint64_t> allocations {0};
+
+        /** Number of requests served from a free list. */
+        std::atomic<uint64_t> reuses {0};
+
+    public:
+
+        explicit ByteBufferPool(size_t alignment = 64, bool hugePages = false,
+                                size_t maxCachedBytes = 256*1024*1024, size_t minSize = 4096);
+        ~ByteBufferPool() override;
+
+        ByteBufferPool(const ByteBufferPool &) = delete;
+        ByteBufferPool & operator=(const ByteBufferPool &) = delete;
+
+        std::shared_ptr<uint8_t> allocate(size_t size) override;
+
+        void trim();
+
+        /** @return byte boundary at which blocks start. */
+        size_t getAlignment()       const {return alignment;}
+        /** @return true if large blocks are backed by huge pages. */
+        bool usesHugePages()        const {return hugePages;}
+        /** @return number of bytes currently kept in free lists. */
+        size_t getCachedBytes()     const {return cachedBytes;}
+        /** @return number of blocks allocated from the system. */
+        uint64_t getAllocations()   const {return allocations;}
+        /** @return number of requests served by reusing a block. */
+        uint64_t getReuses()        const {return reuses;}
+
+        std::string toString() const;
+
+    private:
+
+        static int sizeClass(size_t size);
+
+        bool isHuge(size_t blockSize) const;
+        uint8_t * allocateBlock(size_t blockSize, bool huge) const;
+        static void freeBlock(uint8_t *block, size_t blockSize, bool huge);
+        void release(uint8_t *block, int index);
+    };
+
+}
+
+
+#endif //EVIO_6_0_BYTEBUFFERPOOL_H
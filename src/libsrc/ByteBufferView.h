@@ -0,0 +1,372 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_BYTEBUFFERVIEW_H
+#define EVIO_6_0_BYTEBUFFERVIEW_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+#include "ByteOrder.h"
+#include "ByteBuffer.h"
+
+
+namespace evio {
+
+
+    /**
+     * Lightweight, non-owning, read-only view of an array of 16, 32, or 64 bit values,
+     * much like a std::span of const T except that values not in the local byte order
+     * are swapped only as they're read. It follows the same lifetime rules as
+     * {@link ByteBufferView}, from which it's usually obtained with {@link ByteBufferView#as()}.
+     *
+     * @tparam T type of value: int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t, float or double.
+     */
+    template<typename T> class TypedView {
+
+        static_assert(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                      "TypedView holds 16, 32, or 64 bit values");
+
+    private:
+
+        /** Pointer to first byte of first value. */
+        const uint8_t *ptr = nullptr;
+
+        /** Number of values viewed. */
+        size_t count = 0;
+
+        /** Do values need swapping into local byte order? */
+        bool swap = false;
+
+
+        /** Swap the bytes of a value. */
+        static T swapValue(T val) {
+            if constexpr (sizeof(T) == 2) {
+                uint16_t u; std::memcpy(&u, &val, 2); u = SWAP_16(u); std::memcpy(&val, &u, 2);
+            }
+            else if constexpr (sizeof(T) == 4) {
+                uint32_t u; std::memcpy(&u, &val, 4); u = SWAP_32(u); std::memcpy(&val, &u, 4);
+            }
+            else {
+                uint64_t u; std::memcpy(&u, &val, 8); u = SWAP_64(u); std::memcpy(&val, &u, 8);
+            }
+            return val;
+        }
+
+    public:
+
+        /** Default constructor of an empty view. */
+        TypedView() = default;
+
+        /**
+         * Constructor.
+         * @param data  pointer to first byte of first value.
+         * @param items number of values viewed.
+         * @param order byte order of data.
+         */
+        TypedView(const uint8_t *data, size_t items, ByteOrder const & order = ByteOrder::ENDIAN_LOCAL) :
+                ptr(data), count(items), swap(!order.isLocalEndian()) {}
+
+        /** @return number of values viewed. */
+        size_t size()      const {return count;}
+        /** @return true if no values are viewed. */
+        bool empty()       const {return count == 0;}
+        /** @return true if values must be swapped to be in the local byte order. */
+        bool isSwapped()   const {return swap;}
+        /** @return pointer to the first value, usable as an array only if {@link #isSwapped()} is false
+         *          and the data is suitably aligned. */
+        const T * data()   const {return reinterpret_cast<const T *>(ptr);}
+
+        /** @param index index of value, unchecked. @return value in local byte order. */
+        T operator[] (size_t index) const {
+            T val;
+            std::memcpy(&val, ptr + index*sizeof(T), sizeof(T));
+            return swap ? swapValue(val) : val;
+        }
+
+        /** @param index index of value. @return value in local byte order.
+         *  @throws std::underflow_error if out of bounds. */
+        T at(size_t index) const {
+            if (index >= count) {
+                throw std::underflow_error("buffer underflow");
+            }
+            return (*this)[index];
+        }
+
+        /**
+         * Copy all values, in local byte order, into an array, swapping with vector instructions if necessary.
+         * @param dst array with room for {@link #size()} values.
+         */
+        void copyTo(T *dst) const {
+            if (count == 0) return;
+            if (!swap) {
+                std::memcpy(dst, ptr, count*sizeof(T));
+            }
+            // The source is only read when a destination is given
+            else if constexpr (sizeof(T) == 2) {
+                ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(const_cast<uint8_t *>(ptr)), count,
+                                      reinterpret_cast<uint16_t *>(dst));
+            }
+            else if constexpr (sizeof(T) == 4) {
+                ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(ptr)), count,
+                                      reinterpret_cast<uint32_t *>(dst));
+            }
+            else {
+                ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(ptr)), count,
+                                      reinterpret_cast<uint64_t *>(dst));
+            }
+        }
+
+        /** @return copy of all values in local byte order. */
+        std::vector<T> toVector() const {
+            std::vector<T> vec(count);
+            copyTo(vec.data());
+            return vec;
+        }
+    };
+
+
+    /**
+     * Lightweight, non-owning, read-only view of values of type T which are a fixed
+     * number of bytes apart in memory, such as one column of a table stored row by row
+     * or column by column. Values are read with memcpy so need not be aligned,
+     * and swapped into the local byte order if necessary.
+     *
+     * @tparam T type of value, 1, 2, 4, or 8 bytes.
+     */
+    template<typename T> class StridedView {
+
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                      "StridedView holds 8, 16, 32, or 64 bit values");
+
+    private:
+
+        /** Pointer to first byte of first value. */
+        const uint8_t *ptr = nullptr;
+
+        /** Number of values viewed. */
+        size_t count = 0;
+
+        /** Bytes from the start of one value to the start of the next. */
+        size_t step = sizeof(T);
+
+        /** Do values need swapping into local byte order? */
+        bool swap = false;
+
+    public:
+
+        /** Default constructor of an empty view. */
+        StridedView() = default;
+
+        /**
+         * Constructor.
+         * @param data   pointer to first byte of first value.
+         * @param items  number of values viewed.
+         * @param stride bytes from the start of one value to the start of the next.
+         * @param order  byte order of data.
+         */
+        StridedView(const uint8_t *data, size_t items, size_t stride,
+                    ByteOrder const & order = ByteOrder::ENDIAN_LOCAL) :
+                ptr(data), count(items), step(stride), swap(sizeof(T) > 1 && !order.isLocalEndian()) {}
+
+        /** @return number of values viewed. */
+        size_t size()      const {return count;}
+        /** @return true if no values are viewed. */
+        bool empty()       const {return count == 0;}
+        /** @return bytes from the start of one value to the start of the next. */
+        size_t stride()    const {return step;}
+        /** @return true if values must be swapped to be in the local byte order. */
+        bool isSwapped()   const {return swap;}
+        /** @return true if values are packed with no gaps and need no swapping,
+         *          so {@link #data()} may be used as an array if suitably aligned. */
+        bool isContiguous() const {return step == sizeof(T) && !swap;}
+        /** @return pointer to the first value. */
+        const T * data()   const {return reinterpret_cast<const T *>(ptr);}
+
+        /** @param index index of value, unchecked. @return value in local byte order. */
+        T operator[] (size_t index) const {
+            T val;
+            std::memcpy(&val, ptr + index*step, sizeof(T));
+            if (swap) {
+                if constexpr (sizeof(T) == 2) {
+                    uint16_t u; std::memcpy(&u, &val, 2); u = SWAP_16(u); std::memcpy(&val, &u, 2);
+                }
+                else if constexpr (sizeof(T) == 4) {
+                    uint32_t u; std::memcpy(&u, &val, 4); u = SWAP_32(u); std::memcpy(&val, &u, 4);
+                }
+                else if constexpr (sizeof(T) == 8) {
+                    uint64_t u; std::memcpy(&u, &val, 8); u = SWAP_64(u); std::memcpy(&val, &u, 8);
+                }
+            }
+            return val;
+        }
+
+        /** @param index index of value. @return value in local byte order.
+         *  @throws std::underflow_error if out of bounds. */
+        T at(size_t index) const {
+            if (index >= count) {
+                throw std::underflow_error("buffer underflow");
+            }
+            return (*this)[index];
+        }
+
+        /** @return copy of all values in local byte order. */
+        std::vector<T> toVector() const {
+            std::vector<T> vec(count);
+            if (isContiguous()) {
+                if (count > 0) std::memcpy(vec.data(), ptr, count*sizeof(T));
+            }
+            else {
+                for (size_t i=0; i < count; i++) vec[i] = (*this)[i];
+            }
+            return vec;
+        }
+    };
+
+
+    /**
+     * Lightweight, non-owning, read-only view of bytes somewhere in memory:
+     * a pointer, a length, and the byte order of the data.
+     * It's returned by the "view" getters of {@link Reader}, {@link RecordInput},
+     * {@link EvioNode} and {@link EvioCompactReader} which let an event be inspected
+     * without copying it into a ByteBuffer.<p>
+     *
+     * A view does not keep the memory it points to alive. One obtained from a Reader
+     * or RecordInput is valid only until the next record is read, and one from an EvioNode
+     * or EvioCompactReader only as long as the buffer being parsed. Use {@link #toBuffer()}
+     * to keep a copy.
+     */
+    class ByteBufferView {
+
+    private:
+
+        /** Pointer to first byte. */
+        const uint8_t *ptr = nullptr;
+
+        /** Number of bytes viewed. */
+        size_t len = 0;
+
+        /** Byte order of the data. */
+        ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
+
+
+        /** Template for reading values, swapped to local byte order if necessary. */
+        template<typename T> T read(size_t index) const {
+            if (index + sizeof(T) > len) {
+                throw std::underflow_error("buffer underflow");
+            }
+            T data;
+            std::memcpy(&data, ptr + index, sizeof(T));
+            if (!byteOrder.isLocalEndian()) {
+                if      constexpr (sizeof(T) == 2) data = SWAP_16(data);
+                else if constexpr (sizeof(T) == 4) data = SWAP_32(data);
+                else if constexpr (sizeof(T) == 8) data = SWAP_64(data);
+            }
+            return data;
+        }
+
+    public:
+
+        /** Default constructor of an empty view. */
+        ByteBufferView() = default;
+
+        /**
+         * Constructor.
+         * @param data pointer to first byte viewed.
+         * @param length number of bytes viewed.
+         * @param order byte order of data.
+         */
+        ByteBufferView(const uint8_t *data, size_t length, ByteOrder const & order = ByteOrder::ENDIAN_LOCAL) :
+                ptr(data), len(length), byteOrder(order) {}
+
+        /**
+         * Constructor of a view of the remaining bytes (position to limit) of a buffer.
+         * @param buf buffer to view.
+         */
+        explicit ByteBufferView(ByteBuffer const & buf) :
+                ptr(buf.array() + buf.arrayOffset() + buf.position()),
+                len(buf.remaining()), byteOrder(buf.order()) {}
+
+        /** @return pointer to first byte. */
+        const uint8_t * data()                const {return ptr;}
+        /** @return number of bytes viewed. */
+        size_t size()                         const {return len;}
+        /** @return true if no bytes are viewed. */
+        bool empty()                          const {return len == 0;}
+        /** @return byte order of data. */
+        ByteOrder const & order()             const {return byteOrder;}
+
+        /** @param index byte index, unchecked. @return byte at index. */
+        uint8_t operator[] (size_t index)     const {return ptr[index];}
+
+        /** @param index byte index. @return byte at index. @throws std::underflow_error if out of bounds. */
+        uint8_t  getByte(size_t index)        const {return read<uint8_t>(index);}
+        /** @param index byte index. @return 16 bit value at index in local byte order.
+         *  @throws std::underflow_error if out of bounds. */
+        uint16_t getShort(size_t index)       const {return read<uint16_t>(index);}
+        /** @param index byte index. @return 32 bit value at index in local byte order.
+         *  @throws std::underflow_error if out of bounds. */
+        uint32_t getInt(size_t index)         const {return read<uint32_t>(index);}
+        /** @param index byte index. @return 64 bit value at index in local byte order.
+         *  @throws std::underflow_error if out of bounds. */
+        uint64_t getLong(size_t index)        const {return read<uint64_t>(index);}
+
+
+        /**
+         * Get a view of this one's bytes as an array of values of type T.
+         * Any bytes left over at the end are not part of the returned view.
+         * @tparam T type of value.
+         * @return typed view of the same bytes in the same byte order.
+         */
+        template<typename T> TypedView<T> as() const {
+            return TypedView<T>(ptr, len / sizeof(T), byteOrder);
+        }
+
+
+        /**
+         * Get a view of part of this view.
+         * @param offset offset in bytes of the first byte of the new view.
+         * @param length number of bytes in the new view.
+         * @return new view.
+         * @throws std::underflow_error if exceeding this view.
+         */
+        ByteBufferView subView(size_t offset, size_t length) const {
+            if (offset + length > len) {
+                throw std::underflow_error("buffer underflow");
+            }
+            return ByteBufferView(ptr + offset, length, byteOrder);
+        }
+
+
+        /**
+         * Copy the viewed bytes into a new buffer, ready to read.
+         * @return new buffer with a copy of the viewed bytes.
+         */
+        std::shared_ptr<ByteBuffer> toBuffer() const {
+            auto buf = std::make_shared<ByteBuffer>(len);
+            buf->order(byteOrder);
+            if (len > 0) {
+                std::memcpy(buf->array(), ptr, len);
+            }
+            buf->limit(len).position(0);
+            return buf;
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_BYTEBUFFERVIEW_H
@@ -11,9 +11,167 @@
 #include "ByteOrder.h"
 
 
+// Vectorized swapping is done with byte shuffles. On x86 the widest instruction set
+// available is picked at run time, on 64 bit ARM NEON is always there.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define EVIO_SWAP_X86 1
+    #include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #define EVIO_SWAP_NEON 1
+    #include <arm_neon.h>
+#endif
+
+
 namespace evio {
 
 
+    namespace {
+
+        /** Byte order, within each 16 bytes, of data after swapping 2-byte elements. */
+        alignas(16) const uint8_t SWAP16_MASK[16] = {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14};
+        /** Byte order, within each 16 bytes, of data after swapping 4-byte elements. */
+        alignas(16) const uint8_t SWAP32_MASK[16] = {3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12};
+        /** Byte order, within each 16 bytes, of data after swapping 8-byte elements. */
+        alignas(16) const uint8_t SWAP64_MASK[16] = {7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8};
+
+        /**
+         * Type of function which shuffles bytes, 16 at a time, according to mask.
+         * It does as many whole vectors as fit in bytes and returns how many bytes it did.
+         * Src and dst may be the same, or dst may be below src, but not overlap otherwise.
+         */
+        typedef size_t (*SwapKernel)(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask);
+
+        /** Name of the kernel in use, returned by ByteOrder::getSwapImplementation(). */
+        const char *swapKernelName = "scalar";
+
+#ifdef EVIO_SWAP_X86
+
+        __attribute__((target("ssse3")))
+        size_t swapSsse3(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+            const __m128i m = _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+            size_t i = 0;
+            for (; i + 16 <= bytes; i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(v, m));
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        size_t swapAvx2(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+            // Shuffles stay within each 128 bit lane, so the same mask goes in both
+            const __m256i m = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(mask)));
+            size_t i = 0;
+            for (; i + 64 <= bytes; i += 64) {
+                __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 32));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),      _mm256_shuffle_epi8(v0, m));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 32), _mm256_shuffle_epi8(v1, m));
+            }
+            for (; i + 32 <= bytes; i += 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v, m));
+            }
+            return i;
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        size_t swapAvx512(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+            const __m512i m = _mm512_broadcast_i32x4(_mm_load_si128(reinterpret_cast<const __m128i *>(mask)));
+            size_t i = 0;
+            for (; i + 64 <= bytes; i += 64) {
+                __m512i v = _mm512_loadu_si512(reinterpret_cast<const void *>(src + i));
+                _mm512_storeu_si512(reinterpret_cast<void *>(dst + i), _mm512_shuffle_epi8(v, m));
+            }
+            return i;
+        }
+
+        /**
+         * Pick the kernel for the widest instruction set this cpu supports.
+         * @return kernel, or nullptr if ssse3 is not supported.
+         */
+        SwapKernel selectSwapKernel() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512bw")) {
+                swapKernelName = "avx512bw";
+                return swapAvx512;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                swapKernelName = "avx2";
+                return swapAvx2;
+            }
+            if (__builtin_cpu_supports("ssse3")) {
+                swapKernelName = "ssse3";
+                return swapSsse3;
+            }
+            return nullptr;
+        }
+
+#elif defined(EVIO_SWAP_NEON)
+
+        size_t swapNeon(const uint8_t *src, uint8_t *dst, size_t bytes, const uint8_t *mask) {
+            const uint8x16_t m = vld1q_u8(mask);
+            size_t i = 0;
+            for (; i + 32 <= bytes; i += 32) {
+                uint8x16_t v0 = vld1q_u8(src + i);
+                uint8x16_t v1 = vld1q_u8(src + i + 16);
+                vst1q_u8(dst + i,      vqtbl1q_u8(v0, m));
+                vst1q_u8(dst + i + 16, vqtbl1q_u8(v1, m));
+            }
+            for (; i + 16 <= bytes; i += 16) {
+                vst1q_u8(dst + i, vqtbl1q_u8(vld1q_u8(src + i), m));
+            }
+            return i;
+        }
+
+        SwapKernel selectSwapKernel() {
+            swapKernelName = "neon";
+            return swapNeon;
+        }
+
+#else
+
+        SwapKernel selectSwapKernel() {return nullptr;}
+
+#endif
+
+        /** @return kernel picked the first time this is called (thread safe), or nullptr if none. */
+        SwapKernel getSwapKernel() {
+            static const SwapKernel kernel = selectSwapKernel();
+            return kernel;
+        }
+
+        /**
+         * Swap as much of the given data as possible with vector instructions.
+         * Arrays too small to fill a vector are left entirely to the caller.
+         *
+         * @param src   data to swap.
+         * @param dst   where to put swapped data, may be src.
+         * @param bytes number of bytes to swap.
+         * @param mask  byte shuffle for the element size.
+         * @return number of bytes swapped, always a multiple of 16.
+         */
+        inline size_t swapVectorized(const void *src, void *dst, size_t bytes, const uint8_t *mask) {
+            if (bytes < 16) return 0;
+            SwapKernel kernel = getSwapKernel();
+            if (kernel == nullptr) return 0;
+            return kernel(static_cast<const uint8_t *>(src), static_cast<uint8_t *>(dst), bytes, mask);
+        }
+    }
+
+
+    /**
+     * Get the name of the instruction set used to swap arrays in
+     * {@link #byteSwap16}, {@link #byteSwap32} and {@link #byteSwap64}.
+     * It is picked, the first time it's needed, as the best this cpu supports.
+     * @return "avx512bw", "avx2", "ssse3", "neon", or "scalar" if none is used.
+     */
+    std::string ByteOrder::getSwapImplementation() {
+        getSwapKernel();
+        return swapKernelName;
+    }
+
+
     template <typename T>
     void ByteOrder::byteSwapInPlace(T& var) {
         char* varArray = reinterpret_cast<char*>(&var);
@@ -90,7 +248,9 @@ namespace evio {
             dst = src;
         }
 
-        for (size_t i=0; i < elements; i++) {
+        // Large arrays are swapped mostly with vector instructions, the rest here
+        size_t i = swapVectorized(src, dst, 2*elements, SWAP16_MASK) / 2;
+        for (; i < elements; i++) {
             dst[i] = SWAP_16(src[i]);
         }
         return dst;
@@ -113,7 +273,9 @@ namespace evio {
             dst = src;
         }
 
-        for (size_t i=0; i < elements; i++) {
+        // Large arrays are swapped mostly with vector instructions, the rest here
+        size_t i = swapVectorized(src, dst, 4*elements, SWAP32_MASK) / 4;
+        for (; i < elements; i++) {
             dst[i] = SWAP_32(src[i]);
         }
         return dst;
@@ -136,7 +298,9 @@ namespace evio {
             dst = src;
         }
 
-        for (size_t i=0; i < elements; i++) {
+        // Large arrays are swapped mostly with vector instructions, the rest here
+        size_t i = swapVectorized(src, dst, 8*elements, SWAP64_MASK) / 8;
+        for (; i < elements; i++) {
             dst[i] = SWAP_64(src[i]);
         }
         return dst;
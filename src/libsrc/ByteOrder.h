@@ -190,6 +190,7 @@ namespace evio {
         static uint32_t* byteSwap32(uint32_t* src, size_t elements, uint32_t* dst);
         static uint64_t* byteSwap64(uint64_t* src, size_t elements, uint64_t* dst);
         static void      byteNoSwap32(const uint32_t* src, size_t elements, uint32_t* dst);
+        static std::string getSwapImplementation();
 
     };
 
@@ -0,0 +1,69 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_BYTESOURCE_H
+#define EVIO_6_0_BYTESOURCE_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This abstract class is the interface through which {@link SourceReader} reads the
+     * bytes of an evio file, wherever they are. {@link FileByteSource} reads a local file.
+     * Remote backends, like XRootD or an S3 gateway, implement it with range requests
+     * so that files can be read in place instead of being staged to local disk first.<p>
+     *
+     * Each read is given an explicit position so that several may be in flight at once.
+     * Implementations must allow {@link #read} to be called from several threads at once.
+     */
+    class ByteSource {
+
+    public:
+
+        virtual ~ByteSource() = default;
+
+        /**
+         * Get the name of the source, for example a file name or URL.
+         * @return name of the source.
+         */
+        virtual std::string getName() const = 0;
+
+        /**
+         * Get the size of the source.
+         * @return size of the source in bytes.
+         * @throws EvioException if size cannot be found.
+         */
+        virtual uint64_t getSize() = 0;
+
+        /**
+         * Read bytes from the source. Blocks until all are read.
+         * May be called from several threads at once.
+         *
+         * @param position position in the source of the first byte.
+         * @param length   number of bytes to read.
+         * @param dest     where to read the bytes into.
+         * @throws EvioException if the bytes cannot all be read.
+         */
+        virtual void read(uint64_t position, size_t length, uint8_t *dest) = 0;
+    };
+
+}
+
+
+#endif //EVIO_6_0_BYTESOURCE_H
@@ -0,0 +1,65 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_CLOSEDFILEINFO_H
+#define EVIO_6_0_CLOSEDFILEINFO_H
+
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+
+
+namespace evio {
+
+
+    /**
+     * This class describes a file which a writer has completely finished with.
+     * It's handed to a callback registered with the writer once the file's trailer
+     * and header have been updated and the file has been closed, so that the file
+     * can be moved or processed right away.
+     */
+    class ClosedFileInfo {
+
+    public:
+
+        /** Name of file. */
+        std::string fileName;
+        /** Size of file in bytes. */
+        uint64_t fileSize = 0;
+        /** Number of events in file, including any dictionary and first event. */
+        uint32_t eventCount = 0;
+        /** Number of records in file, not including the trailer. */
+        uint32_t recordCount = 0;
+        /** Was a trailer written? */
+        bool hasTrailer = false;
+        /** Does the trailer contain an index of all records? */
+        bool hasTrailerIndex = false;
+        /** Was the file closed without any error? */
+        bool complete = true;
+
+
+        /**
+         * Obtain a string representation of this object.
+         * @return string representation of this object.
+         */
+        std::string toString() const {
+            std::stringstream ss;
+            ss << "closed " << fileName << ": size = " << fileSize << ", events = " << eventCount <<
+                  ", records = " << recordCount << ", trailer = " << hasTrailer <<
+                  ", trailer index = " << hasTrailerIndex << ", complete = " << complete;
+            return ss.str();
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_CLOSEDFILEINFO_H
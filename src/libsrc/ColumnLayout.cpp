@@ -0,0 +1,561 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "ColumnLayout.h"
+
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "DataType.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** Get an int stored in the given byte order. */
+        uint32_t getInt(const uint8_t *p, ByteOrder const & order) {
+            uint32_t i;
+            std::memcpy(&i, p, 4);
+            return (order != ByteOrder::ENDIAN_LOCAL) ? SWAP_32(i) : i;
+        }
+
+        /** Put an int in the given byte order. */
+        void putInt(uint8_t *p, uint32_t i, ByteOrder const & order) {
+            if (order != ByteOrder::ENDIAN_LOCAL) i = SWAP_32(i);
+            std::memcpy(p, &i, 4);
+        }
+
+        /** Append an int in the given byte order. */
+        void appendInt(std::vector<uint8_t> & v, uint32_t i, ByteOrder const & order) {
+            v.resize(v.size() + 4);
+            putInt(v.data() + v.size() - 4, i, order);
+        }
+
+        /** Get the column key from the 2nd word of a bank, dropping its data type. */
+        uint32_t keyOf(uint32_t word) {return word & 0xffff00ff;}
+
+        /**
+         * Count the banks directly inside an event, if it is a bank of banks they exactly fill.
+         * @return number of banks, 0 if event is to be stored whole.
+         */
+        uint32_t countBanks(const uint8_t *event, uint32_t len, ByteOrder const & order) {
+            if (len < 16 || len % 4 != 0 || getInt(event, order) != len/4 - 1) return 0;
+            if (!DataType::isBank((getInt(event + 4, order) >> 8) & 0x3f)) return 0;
+
+            uint32_t count = 0;
+            for (uint32_t off = 8; off < len; count++) {
+                uint32_t words = getInt(event + off, order);
+                if (words < 1 || words > (len - off)/4 - 1) return 0;
+                off += 4*(words + 1);
+            }
+            return count;
+        }
+    }
+
+
+    /**
+     * Read the chunk table of compressed data.
+     * @param src          compressed data.
+     * @param srcLen       bytes of compressed data.
+     * @param order        byte order of record.
+     * @param entries      filled with number of events.
+     * @param eventsOffset filled with bytes of index and user header.
+     * @param chunks       filled with the chunks, skeleton first.
+     * @throws EvioException if table is malformed.
+     */
+    void ColumnLayout::readTable(const uint8_t *src, uint32_t srcLen, ByteOrder const & order,
+                                 uint32_t & entries, uint32_t & eventsOffset, std::vector<Chunk> & chunks) {
+        if (srcLen < 12) {
+            throw EvioException("column data too short for chunk table");
+        }
+
+        uint32_t count = getInt(src, order);
+        entries        = getInt(src + 4, order);
+        eventsOffset   = getInt(src + 8, order);
+        if (count < 1 || count > (srcLen - 12)/12) {
+            throw EvioException("column data too short for chunk table");
+        }
+
+        chunks.resize(count);
+        uint64_t offset = 12 + 12*count;
+        for (uint32_t c=0; c < count; c++) {
+            const uint8_t *p = src + 12 + 12*c;
+            Chunk & chunk = chunks[c];
+            chunk.key    = getInt(p, order);
+            chunk.length = getInt(p + 4, order);
+            chunk.stored = getInt(p + 8, order);
+            chunk.offset = (uint32_t)offset;
+            offset += chunk.stored;
+            if (chunk.stored > chunk.length || offset > srcLen) {
+                throw EvioException("column chunk past end of data");
+            }
+        }
+
+        if (chunks[0].key != SKELETON_KEY) {
+            throw EvioException("column data does not start with skeleton");
+        }
+    }
+
+
+    /**
+     * Compress one chunk, keeping it as is if compressing does not make it smaller.
+     * @param chunk       data of chunk.
+     * @param dst         where to write it.
+     * @param dstCapacity bytes available in dst.
+     * @param type        type of compression.
+     * @param dict        trained dictionary to compress with, or null.
+     * @return bytes written, or UINT32_MAX if dst is too small.
+     */
+    uint32_t ColumnLayout::compressChunk(std::vector<uint8_t> & chunk, uint8_t *dst, uint32_t dstCapacity,
+                                         Compressor::CompressionType type, const CompressionDictionary *dict) {
+        uint32_t len = chunk.size();
+        if (len == 0) return 0;
+
+        int bound = Compressor::getMaxCompressedLength(type, len);
+        std::vector<uint8_t> scratch;
+        uint8_t *out = dst;
+        if (bound > 0 && (uint32_t)bound > dstCapacity) {
+            scratch.resize(bound);
+            out = scratch.data();
+        }
+
+        int size = 0;
+        switch (type) {
+            case Compressor::LZ4:
+                size = Compressor::compressLZ4(chunk.data(), 0, len, out, 0, bound, dict);
+                break;
+
+            case Compressor::LZ4_BEST:
+                size = Compressor::compressLZ4Best(chunk.data(), 0, len, out, 0, bound, dict);
+                break;
+
+            case Compressor::GZIP:
+#ifdef USE_GZIP
+            {
+                uint32_t compLen = 0;
+                uint8_t *gzipped = Compressor::compressGZIP(chunk.data(), 0, len, &compLen);
+                if (compLen < len && compLen <= (uint32_t)bound) {
+                    std::memcpy(out, gzipped, compLen);
+                    size = compLen;
+                }
+                delete[] gzipped;
+            }
+#endif
+                break;
+
+            case Compressor::ZSTD:
+#ifdef USE_ZSTD
+                size = Compressor::compressZstd(chunk.data(), 0, len, out, 0, bound, dict);
+#endif
+                break;
+
+            default:
+                break;
+        }
+
+        if (size > 0 && (uint32_t)size < len) {
+            if ((uint32_t)size > dstCapacity) return UINT32_MAX;
+            if (out != dst) std::memcpy(dst, out, size);
+            return size;
+        }
+
+        // Not worth compressing
+        if (len > dstCapacity) return UINT32_MAX;
+        std::memcpy(dst, chunk.data(), len);
+        return len;
+    }
+
+
+    /**
+     * Decompress one chunk.
+     * @param src   compressed data, table included.
+     * @param chunk chunk to decompress.
+     * @param dst   where to write its chunk.length bytes.
+     * @param type  type of compression.
+     * @param dict  trained dictionary data was compressed with, or null.
+     * @throws EvioException if data is malformed or its compression not compiled in.
+     */
+    void ColumnLayout::uncompressChunk(const uint8_t *src, Chunk const & chunk, uint8_t *dst,
+                                       Compressor::CompressionType type, const CompressionDictionary *dict) {
+        if (chunk.length == 0) return;
+
+        // Chunks which did not get smaller are kept as is
+        if (chunk.stored == chunk.length) {
+            std::memcpy(dst, src + chunk.offset, chunk.length);
+            return;
+        }
+
+        uint8_t *in = const_cast<uint8_t *>(src);
+        uint32_t size = 0;
+
+        switch (type) {
+            case Compressor::LZ4:
+            case Compressor::LZ4_BEST:
+                size = Compressor::uncompressLZ4(in, chunk.offset, chunk.stored, dst, 0, chunk.length, dict);
+                break;
+
+            case Compressor::GZIP:
+#ifdef USE_GZIP
+            {
+                size = chunk.length;
+                uint8_t *ungzipped = Compressor::uncompressGZIP(in, chunk.offset, chunk.stored,
+                                                                &size, chunk.length);
+                std::memcpy(dst, ungzipped, std::min(size, chunk.length));
+                delete[] ungzipped;
+            }
+                break;
+#else
+                throw EvioException("gzip compressed data, but gzip not compiled in");
+#endif
+
+            case Compressor::ZSTD:
+#ifdef USE_ZSTD
+                size = Compressor::uncompressZstd(in, chunk.offset, chunk.stored, dst, 0, chunk.length, dict);
+                break;
+#else
+                throw EvioException("zstd compressed data, but zstd not compiled in");
+#endif
+
+            default:
+                throw EvioException("column chunk of uncompressed record is compressed");
+        }
+
+        if (size != chunk.length) {
+            throw EvioException("column chunk has wrong length");
+        }
+    }
+
+
+    /**
+     * Compress the data of a record with the banks of its events grouped by column.
+     * Events which are not banks of banks exactly filled by the banks inside them are
+     * stored whole in the skeleton.
+     *
+     * @param src          index, user header and events of record.
+     * @param srcLen       bytes of src.
+     * @param entries      number of events, whose lengths are in the index at the start of src.
+     * @param eventsOffset bytes of index and padded user header, where events start in src.
+     * @param dst          where to write the table and the compressed chunks.
+     * @param dstCapacity  bytes available in dst.
+     * @param type         type of compression, not UNCOMPRESSED.
+     * @param order        byte order of record.
+     * @param dict         trained dictionary to compress each chunk with, or null.
+     * @return bytes written into dst, 0 if no event could be split into columns
+     *         or the result does not fit in dst.
+     * @throws EvioException if compression fails.
+     */
+    uint32_t ColumnLayout::compress(const uint8_t *src, uint32_t srcLen,
+                                    uint32_t entries, uint32_t eventsOffset,
+                                    uint8_t *dst, uint32_t dstCapacity,
+                                    Compressor::CompressionType type,
+                                    ByteOrder const & order,
+                                    const CompressionDictionary *dict) {
+
+        if (entries == 0 || eventsOffset < 4*entries || eventsOffset > srcLen) {
+            return 0;
+        }
+
+        std::vector<uint8_t> skeleton(src, src + eventsOffset);
+        std::vector<uint32_t> keys;
+        std::vector<std::vector<uint8_t>> columns;
+        std::unordered_map<uint32_t, uint32_t> columnOf;
+
+        uint32_t pos = eventsOffset;
+        for (uint32_t i=0; i < entries; i++) {
+            uint32_t len = getInt(src + 4*i, order);
+            if (len > srcLen - pos) return 0;
+            const uint8_t *event = src + pos;
+            pos += len;
+
+            uint32_t banks = countBanks(event, len, order);
+            if (banks == 0) {
+                appendInt(skeleton, WHOLE_EVENT, order);
+                skeleton.insert(skeleton.end(), event, event + len);
+                continue;
+            }
+
+            appendInt(skeleton, banks, order);
+            skeleton.insert(skeleton.end(), event, event + 8);
+
+            for (uint32_t off = 8; off < len; ) {
+                const uint8_t *bank = event + off;
+                uint32_t bytes = 4*(getInt(bank, order) + 1);
+                uint32_t key = keyOf(getInt(bank + 4, order));
+                skeleton.insert(skeleton.end(), bank, bank + 8);
+
+                auto it = columnOf.find(key);
+                if (it == columnOf.end()) {
+                    it = columnOf.emplace(key, (uint32_t)columns.size()).first;
+                    keys.push_back(key);
+                    columns.emplace_back();
+                }
+                auto & column = columns[it->second];
+                column.insert(column.end(), bank + 8, bank + bytes);
+                off += bytes;
+            }
+        }
+
+        if (columns.empty() || pos != srcLen) {
+            return 0;
+        }
+
+        uint32_t chunks = columns.size() + 1;
+        uint32_t tableBytes = 12 + 12*chunks;
+        if (tableBytes > dstCapacity) {
+            return 0;
+        }
+
+        putInt(dst,     chunks, order);
+        putInt(dst + 4, entries, order);
+        putInt(dst + 8, eventsOffset, order);
+
+        uint32_t offset = tableBytes;
+        for (uint32_t c=0; c < chunks; c++) {
+            auto & data = (c == 0) ? skeleton : columns[c-1];
+            uint32_t stored = compressChunk(data, dst + offset, dstCapacity - offset, type, dict);
+            if (stored == UINT32_MAX) {
+                return 0;
+            }
+
+            uint8_t *p = dst + 12 + 12*c;
+            putInt(p,     (c == 0) ? SKELETON_KEY : keys[c-1], order);
+            putInt(p + 4, data.size(), order);
+            putInt(p + 8, stored, order);
+            offset += stored;
+        }
+
+        return offset;
+    }
+
+
+    /**
+     * Decompress data compressed with
+     * {@link #compress(const uint8_t *, uint32_t, uint32_t, uint32_t, uint8_t *, uint32_t, Compressor::CompressionType, ByteOrder const &, const CompressionDictionary *)},
+     * putting every event back together as it was.
+     *
+     * @param src         compressed data, table included.
+     * @param srcLen      bytes of compressed data.
+     * @param dst         where to write the index, user header and events.
+     * @param dstCapacity bytes available in dst.
+     * @param type        type of compression.
+     * @param order       byte order of record.
+     * @param dict        trained dictionary data was compressed with, or null.
+     * @return bytes of uncompressed data.
+     * @throws EvioException if data is malformed or dst is too small.
+     */
+    uint32_t ColumnLayout::uncompress(const uint8_t *src, uint32_t srcLen,
+                                      uint8_t *dst, uint32_t dstCapacity,
+                                      Compressor::CompressionType type,
+                                      ByteOrder const & order,
+                                      const CompressionDictionary *dict) {
+
+        uint32_t entries, eventsOffset;
+        std::vector<Chunk> chunks;
+        readTable(src, srcLen, order, entries, eventsOffset, chunks);
+
+        std::vector<std::vector<uint8_t>> data(chunks.size());
+        std::unordered_map<uint32_t, uint32_t> columnOf;
+        for (uint32_t c=0; c < chunks.size(); c++) {
+            data[c].resize(chunks[c].length);
+            uncompressChunk(src, chunks[c], data[c].data(), type, dict);
+            if (c > 0) columnOf[chunks[c].key] = c;
+        }
+
+        const uint8_t *skeleton = data[0].data();
+        uint32_t skeletonLen = data[0].size();
+        if (eventsOffset > skeletonLen || eventsOffset/4 < entries) {
+            throw EvioException("bad column skeleton");
+        }
+        if (eventsOffset > dstCapacity) {
+            throw EvioException("destination buffer too small");
+        }
+        std::memcpy(dst, skeleton, eventsOffset);
+
+        std::vector<uint32_t> used(chunks.size(), 0);
+        uint32_t in = eventsOffset, out = eventsOffset;
+
+        for (uint32_t i=0; i < entries; i++) {
+            uint32_t len = getInt(skeleton + 4*i, order);
+            if (len > dstCapacity - out) {
+                throw EvioException("destination buffer too small");
+            }
+            if (skeletonLen - in < 4) {
+                throw EvioException("bad column skeleton");
+            }
+            uint32_t banks = getInt(skeleton + in, order);
+            in += 4;
+
+            if (banks == WHOLE_EVENT) {
+                if (skeletonLen - in < len) {
+                    throw EvioException("bad column skeleton");
+                }
+                std::memcpy(dst + out, skeleton + in, len);
+                in  += len;
+                out += len;
+                continue;
+            }
+
+            if (len < 8 || skeletonLen - in < 8 || (skeletonLen - in - 8)/8 < banks) {
+                throw EvioException("bad column skeleton");
+            }
+            uint32_t end = out + len;
+            std::memcpy(dst + out, skeleton + in, 8);
+            in  += 8;
+            out += 8;
+
+            for (uint32_t b=0; b < banks; b++) {
+                uint32_t words = getInt(skeleton + in, order);
+                auto it = columnOf.find(keyOf(getInt(skeleton + in + 4, order)));
+                if (words < 1 || it == columnOf.end()) {
+                    throw EvioException("bad column skeleton");
+                }
+
+                uint32_t c = it->second;
+                uint32_t payload = 4*(words - 1);
+                if (end - out < 8 || payload > end - out - 8 || payload > data[c].size() - used[c]) {
+                    throw EvioException("bank past end of its column or event");
+                }
+
+                std::memcpy(dst + out, skeleton + in, 8);
+                std::memcpy(dst + out + 8, data[c].data() + used[c], payload);
+                in      += 8;
+                out     += 8 + payload;
+                used[c] += payload;
+            }
+
+            if (out != end) {
+                throw EvioException("event length does not match its banks");
+            }
+        }
+
+        return out;
+    }
+
+
+    /**
+     * Get the keys of all columns of compressed data, in the order they are stored.
+     * See {@link #makeKey(uint16_t, uint8_t)}.
+     *
+     * @param src    compressed data, table included.
+     * @param srcLen bytes of compressed data.
+     * @param order  byte order of record.
+     * @param keys   filled with keys of columns.
+     * @throws EvioException if table is malformed.
+     */
+    void ColumnLayout::getKeys(const uint8_t *src, uint32_t srcLen, ByteOrder const & order,
+                               std::vector<uint32_t> & keys) {
+        uint32_t entries, eventsOffset;
+        std::vector<Chunk> chunks;
+        readTable(src, srcLen, order, entries, eventsOffset, chunks);
+
+        keys.clear();
+        for (uint32_t c=1; c < chunks.size(); c++) {
+            keys.push_back(chunks[c].key);
+        }
+    }
+
+
+    /**
+     * Decompress only the skeleton and one column of compressed data.
+     * The payloads of the column's banks in event i, if any, are the bytes of data from
+     * eventOffsets[i] up to eventOffsets[i+1]. Banks inside events stored whole are not
+     * part of any column.
+     *
+     * @param src          compressed data, table included.
+     * @param srcLen       bytes of compressed data.
+     * @param key          key of column, see {@link #makeKey(uint16_t, uint8_t)}.
+     * @param data         filled with the payloads of the column's banks.
+     * @param eventOffsets filled with number of events + 1 offsets into data.
+     * @param type         type of compression.
+     * @param order        byte order of record.
+     * @param dict         trained dictionary data was compressed with, or null.
+     * @return bytes of column data, 0 if there is no such column.
+     * @throws EvioException if data is malformed.
+     */
+    uint32_t ColumnLayout::readColumn(const uint8_t *src, uint32_t srcLen, uint32_t key,
+                                      std::vector<uint8_t> & data, std::vector<uint32_t> & eventOffsets,
+                                      Compressor::CompressionType type,
+                                      ByteOrder const & order,
+                                      const CompressionDictionary *dict) {
+
+        uint32_t entries, eventsOffset;
+        std::vector<Chunk> chunks;
+        readTable(src, srcLen, order, entries, eventsOffset, chunks);
+
+        data.clear();
+        eventOffsets.assign(entries + 1, 0);
+
+        uint32_t column = 0;
+        for (uint32_t c=1; c < chunks.size(); c++) {
+            if (chunks[c].key == key) {
+                column = c;
+                break;
+            }
+        }
+        if (column == 0) {
+            return 0;
+        }
+
+        std::vector<uint8_t> skel(chunks[0].length);
+        uncompressChunk(src, chunks[0], skel.data(), type, dict);
+        data.resize(chunks[column].length);
+        uncompressChunk(src, chunks[column], data.data(), type, dict);
+
+        const uint8_t *skeleton = skel.data();
+        uint32_t skeletonLen = skel.size();
+        if (eventsOffset > skeletonLen || eventsOffset/4 < entries) {
+            throw EvioException("bad column skeleton");
+        }
+
+        // Only the headers in the skeleton are needed to find each event's part of the column
+        uint32_t in = eventsOffset, pos = 0;
+        for (uint32_t i=0; i < entries; i++) {
+            eventOffsets[i] = pos;
+            if (skeletonLen - in < 4) {
+                throw EvioException("bad column skeleton");
+            }
+            uint32_t banks = getInt(skeleton + in, order);
+            in += 4;
+
+            if (banks == WHOLE_EVENT) {
+                uint32_t len = getInt(skeleton + 4*i, order);
+                if (skeletonLen - in < len) {
+                    throw EvioException("bad column skeleton");
+                }
+                in += len;
+                continue;
+            }
+
+            if (skeletonLen - in < 8 || (skeletonLen - in - 8)/8 < banks) {
+                throw EvioException("bad column skeleton");
+            }
+            in += 8;
+            for (uint32_t b=0; b < banks; b++, in += 8) {
+                uint32_t words = getInt(skeleton + in, order);
+                if (words < 1) {
+                    throw EvioException("bad column skeleton");
+                }
+                if (keyOf(getInt(skeleton + in + 4, order)) == key) {
+                    pos += 4*(words - 1);
+                }
+            }
+        }
+        eventOffsets[entries] = pos;
+
+        if (pos != data.size()) {
+            throw EvioException("column length does not match its banks");
+        }
+        return pos;
+    }
+
+}
@@ -0,0 +1,133 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COLUMNLAYOUT_H
+#define EVIO_6_0_COLUMNLAYOUT_H
+
+
+#include <cstdint>
+#include <vector>
+
+
+#include "ByteOrder.h"
+#include "Compressor.h"
+#include "CompressionDictionary.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class compresses and decompresses the data of a record (index, user header and
+     * events) with the banks of its events grouped by column. This is the layout of records
+     * whose header type is {@link HeaderType#EVIO_COLUMN_RECORD}. The payloads of all banks
+     * with the same tag and num, found one level down in each event, are put one after the
+     * other into a column, and each column is compressed on its own. Data from one detector
+     * then sits together, which compresses better than the same data spread between banks of
+     * other detectors, and a reader wanting only some banks decompresses only their columns.<p>
+     *
+     * Everything else, the index, the user header, the headers of events and their banks,
+     * and whole events which are not banks of banks, goes into a skeleton compressed ahead
+     * of the columns. The compressed data consists of, all in the record's byte order:
+     *
+     * <pre><code>
+     *    +----------------------------------+
+     *    |      Number of chunks, N         |  // skeleton + columns
+     *    +----------------------------------+
+     *    |    Number of events in record    |
+     *    +----------------------------------+
+     *    |  Bytes of index + user header    |
+     *    +----------------------------------+
+     *    |  Key of chunk 0                  |  // SKELETON_KEY, then tag << 16 | num
+     *    |  Uncompressed bytes of chunk 0   |
+     *    |  Stored bytes of chunk 0         |  // same as uncompressed if kept as is
+     *    |               ...                |
+     *    |  Key, sizes of chunk N-1         |
+     *    +----------------------------------+
+     *    |    Chunk 0 ... chunk N-1         |  // back to back, no padding
+     *    +----------------------------------+
+     * </code></pre>
+     *
+     * For each event the skeleton holds the number of its banks followed by its header and
+     * theirs, or {@link #WHOLE_EVENT} followed by the entire event. Columns are in the order
+     * their tag and num first appear.<p>
+     */
+    class ColumnLayout {
+
+    public:
+
+        /** Key of the skeleton chunk. */
+        static const uint32_t SKELETON_KEY = 0xffffffff;
+
+        /** Skeleton entry of an event stored whole instead of by column. */
+        static const uint32_t WHOLE_EVENT = 0xffffffff;
+
+        /**
+         * Get the key of the column holding banks of the given tag and num.
+         * @param tag tag of banks.
+         * @param num num of banks.
+         * @return key of column.
+         */
+        static uint32_t makeKey(uint16_t tag, uint8_t num) {return ((uint32_t)tag << 16) | num;}
+
+
+    private:
+
+        /** Where one chunk is in compressed data. */
+        struct Chunk {
+            /** Key of chunk. */
+            uint32_t key;
+            /** Bytes of chunk once uncompressed. */
+            uint32_t length;
+            /** Bytes of chunk as stored. */
+            uint32_t stored;
+            /** Offset of chunk in compressed data. */
+            uint32_t offset;
+        };
+
+        static void readTable(const uint8_t *src, uint32_t srcLen, ByteOrder const & order,
+                              uint32_t & entries, uint32_t & eventsOffset, std::vector<Chunk> & chunks);
+
+        static uint32_t compressChunk(std::vector<uint8_t> & chunk, uint8_t *dst, uint32_t dstCapacity,
+                                      Compressor::CompressionType type, const CompressionDictionary *dict);
+
+        static void uncompressChunk(const uint8_t *src, Chunk const & chunk, uint8_t *dst,
+                                    Compressor::CompressionType type, const CompressionDictionary *dict);
+
+    public:
+
+        static uint32_t compress(const uint8_t *src, uint32_t srcLen,
+                                 uint32_t entries, uint32_t eventsOffset,
+                                 uint8_t *dst, uint32_t dstCapacity,
+                                 Compressor::CompressionType type,
+                                 ByteOrder const & order,
+                                 const CompressionDictionary *dict = nullptr);
+
+        static uint32_t uncompress(const uint8_t *src, uint32_t srcLen,
+                                   uint8_t *dst, uint32_t dstCapacity,
+                                   Compressor::CompressionType type,
+                                   ByteOrder const & order,
+                                   const CompressionDictionary *dict = nullptr);
+
+        static void getKeys(const uint8_t *src, uint32_t srcLen, ByteOrder const & order,
+                            std::vector<uint32_t> & keys);
+
+        static uint32_t readColumn(const uint8_t *src, uint32_t srcLen, uint32_t key,
+                                   std::vector<uint8_t> & data, std::vector<uint32_t> & eventOffsets,
+                                   Compressor::CompressionType type,
+                                   ByteOrder const & order,
+                                   const CompressionDictionary *dict = nullptr);
+    };
+
+}
+
+
+#endif //EVIO_6_0_COLUMNLAYOUT_H
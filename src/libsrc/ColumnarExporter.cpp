@@ -0,0 +1,300 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "ColumnarExporter.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <mutex>
+
+#include "ByteBufferView.h"
+#include "CompositeCursor.h"
+#include "ParallelEventReader.h"
+#include "Reader.h"
+#include "RecordInput.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /**
+         * Read a 32 bit word.
+         * @param p    pointer to word, need not be aligned.
+         * @param swap true if word must be swapped.
+         * @return word in local byte order.
+         */
+        uint32_t loadWord(const uint8_t *p, bool swap) {
+            uint32_t word;
+            std::memcpy(&word, p, 4);
+            return swap ? SWAP_32(word) : word;
+        }
+
+
+        /**
+         * Append values to a column, swapping each one if necessary.
+         * @param values column values.
+         * @param src    values to add.
+         * @param bytes  number of bytes to add, a multiple of size.
+         * @param size   bytes in each value.
+         * @param swap   true if values must be swapped.
+         */
+        void appendValues(std::vector<uint8_t> & values, const uint8_t *src, size_t bytes,
+                          uint32_t size, bool swap) {
+            size_t start = values.size();
+            values.insert(values.end(), src, src + bytes);
+            if (!swap || size < 2) return;
+            for (uint8_t *p = values.data() + start, *end = p + bytes; p < end; p += size) {
+                std::reverse(p, p + size);
+            }
+        }
+
+
+        /**
+         * Walk the structures held in a container, depth first, calling visit for each bank
+         * with its tag, num, data type, and data (not including padding).
+         *
+         * @param p        start of container's data.
+         * @param bytes    number of bytes of container's data.
+         * @param kind     data type of container, which says what kind of structures it holds.
+         * @param swap     true if headers must be swapped.
+         * @param visit    called for each bank.
+         * @throws EvioException if a structure extends past the end of its parent.
+         */
+        template<typename Visitor>
+        void walkStructures(const uint8_t *p, size_t bytes, uint32_t kind, bool swap, Visitor & visit) {
+            const uint8_t *end = p + bytes;
+            size_t headerBytes = DataType::isBank(kind) ? 8 : 4;
+
+            while (p < end) {
+                if ((size_t)(end - p) < headerBytes) {
+                    throw EvioException("structure header extends past end of its parent");
+                }
+
+                uint32_t word = loadWord(p, swap);
+                size_t total;
+                uint32_t dataType;
+
+                if (DataType::isBank(kind)) {
+                    total = 4*((size_t)word + 1);
+                    if (total < 8 || total > (size_t)(end - p)) {
+                        throw EvioException("bank extends past end of its parent");
+                    }
+                    word = loadWord(p + 4, swap);
+                    dataType = (word >> 8) & 0x3f;
+                    uint32_t pad = (word >> 14) & 0x3;
+                    size_t dataBytes = total - 8;
+                    if (pad <= dataBytes) dataBytes -= pad;
+                    visit((uint16_t)(word >> 16), (uint8_t)(word & 0xff), dataType, p + 8, dataBytes);
+                }
+                else {
+                    total = 4*((size_t)(word & 0xffff) + 1);
+                    if (total > (size_t)(end - p)) {
+                        throw EvioException("segment extends past end of its parent");
+                    }
+                    dataType = DataType::isSegment(kind) ? (word >> 16) & 0x3f : (word >> 16) & 0xf;
+                }
+
+                if (DataType::isStructure(dataType)) {
+                    walkStructures(p + headerBytes, total - headerBytes, dataType, swap, visit);
+                }
+                p += total;
+            }
+        }
+    }
+
+
+    /**
+     * Constructor.
+     * @param selectors banks to copy, one column for each.
+     * @throws EvioException if a selector's type is not one of the numeric types or CHARSTAR8.
+     */
+    ColumnarExporter::ColumnarExporter(std::vector<ColumnSelector> selectors) : selectors(std::move(selectors)) {
+        for (auto const & s : this->selectors) {
+            if (s.type.getBytes() < 1 && s.type != DataType::CHARSTAR8) {
+                throw EvioException("cannot make column of type " + s.type.getName());
+            }
+        }
+    }
+
+
+    /**
+     * Get the bank selectors, one for each column.
+     * @return bank selectors.
+     */
+    std::vector<ColumnarExporter::ColumnSelector> const & ColumnarExporter::getSelectors() const {return selectors;}
+
+
+    /**
+     * Fill the rows and columns of a batch from the events of a record.
+     * The batch's file index, record index and first event are left alone.
+     *
+     * @param record record which has been read.
+     * @param batch  batch to fill, its columns are replaced.
+     * @throws EvioException if an event is not properly formed.
+     */
+    void ColumnarExporter::fillBatch(RecordInput & record, ColumnBatch & batch) const {
+        uint32_t count = record.getEntries();
+
+        batch.rows = count;
+        batch.columns.clear();
+        batch.columns.reserve(selectors.size());
+        for (auto const & s : selectors) {
+            uint32_t size = s.type.getBytes() < 1 ? 1 : s.type.getBytes();
+            batch.columns.push_back({s.name, s.type, size, {}, {}});
+            batch.columns.back().offsets.reserve(count + 1);
+            batch.columns.back().offsets.push_back(0);
+        }
+
+        for (uint32_t i=0; i < count; i++) {
+            ByteBufferView event = record.getEventView(i);
+            addEvent(event.data(), event.size(), event.order(), batch.columns);
+        }
+    }
+
+
+    /**
+     * Add one row to each column from an event.
+     * @param event   start of event.
+     * @param bytes   number of bytes in event.
+     * @param order   byte order of event.
+     * @param columns columns to add to.
+     * @throws EvioException if event is not properly formed, or a column gets too big for 32 bit offsets.
+     */
+    void ColumnarExporter::addEvent(const uint8_t *event, size_t bytes, ByteOrder const & order,
+                                    std::vector<Column> & columns) const {
+
+        auto visit = [this, &order, &columns](uint16_t tag, uint8_t num, uint32_t dataType,
+                                             const uint8_t *data, size_t dataBytes) {
+            addBank(tag, num, dataType, data, dataBytes, order, columns);
+        };
+        walkStructures(event, bytes, DataType::BANK.getValue(), !order.isLocalEndian(), visit);
+
+        for (auto & c : columns) {
+            size_t values = c.getValueCount();
+            if (values > INT32_MAX) {
+                throw EvioException("column " + c.name + " has too many values for 32 bit offsets");
+            }
+            c.offsets.push_back((int32_t)values);
+        }
+    }
+
+
+    /**
+     * Add the values of a bank to every column whose selector it matches.
+     * @param tag      bank's tag.
+     * @param num      bank's num.
+     * @param dataType bank's data type.
+     * @param data     start of bank's data.
+     * @param bytes    number of bytes of data, not including padding.
+     * @param order    byte order of data.
+     * @param columns  columns to add to.
+     * @throws EvioException if composite data is not properly formed.
+     */
+    void ColumnarExporter::addBank(uint16_t tag, uint8_t num, uint32_t dataType, const uint8_t *data, size_t bytes,
+                                   ByteOrder const & order, std::vector<Column> & columns) const {
+
+        bool swap = !order.isLocalEndian();
+
+        for (size_t c=0; c < selectors.size(); c++) {
+            ColumnSelector const & s = selectors[c];
+            if (s.tag != tag || s.num != num) continue;
+
+            Column & column = columns[c];
+
+            if (dataType == s.type.getValue()) {
+                appendValues(column.values, data, bytes - bytes % column.valueBytes,
+                             column.valueBytes, swap);
+            }
+            else if (dataType == DataType::COMPOSITE.getValue()) {
+                CompositeCursor cursor(data, bytes, order);
+                while (cursor.nextItem()) {
+                    while (cursor.next()) {
+                        if (cursor.getType() == s.type) {
+                            appendValues(column.values, cursor.getValueBytes(), cursor.getValueLength(),
+                                         column.valueBytes, swap);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+    /**
+     * Fill a batch from each record of the given files, in parallel, and hand it to a handler
+     * in the worker thread which filled it. Batches are handed out in no particular order.
+     *
+     * @param files    names of evio version 6 files.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @param handler  called, in a worker thread, with each batch.
+     * @return number of rows (events) exported.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format,
+     *         or an event is not properly formed. Rethrows any exception thrown by the handler.
+     */
+    uint64_t ColumnarExporter::exportFiles(std::vector<std::string> const & files, uint32_t threads,
+                                           BatchHandler const & handler) const {
+        return ParallelEventReader::forEachRecord(files, threads,
+            [this, &handler](RecordInput & record, ParallelEventReader::EventInfo const & info) {
+                ColumnBatch batch;
+                batch.fileIndex = info.fileIndex;
+                batch.recordIndex = info.recordIndex;
+                batch.firstEvent = info.eventIndex;
+                fillBatch(record, batch);
+                handler(batch);
+            });
+    }
+
+
+    /**
+     * Fill a batch from each record of the given files, in parallel.
+     *
+     * @param files    names of evio version 6 files.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @return batches in the order of files and the records in them.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format,
+     *         or an event is not properly formed.
+     */
+    std::vector<ColumnarExporter::ColumnBatch>
+    ColumnarExporter::exportFiles(std::vector<std::string> const & files, uint32_t threads) const {
+        std::vector<ColumnBatch> batches;
+        std::mutex mtx;
+
+        exportFiles(files, threads, [&batches, &mtx](ColumnBatch & batch) {
+            std::lock_guard<std::mutex> lock(mtx);
+            batches.push_back(std::move(batch));
+        });
+
+        std::sort(batches.begin(), batches.end(), [](ColumnBatch const & a, ColumnBatch const & b) {
+            return a.fileIndex != b.fileIndex ? a.fileIndex < b.fileIndex : a.recordIndex < b.recordIndex;
+        });
+        return batches;
+    }
+
+
+    /**
+     * Fill a batch from each record of the file a reader has open, in parallel.
+     * The reader itself is not used to read, so it's left as it is.
+     *
+     * @param reader   reader of a file.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @return batches in the order of records in the file.
+     * @throws EvioException if reader is reading a buffer, or an event is not properly formed.
+     */
+    std::vector<ColumnarExporter::ColumnBatch> ColumnarExporter::exportReader(Reader & reader, uint32_t threads) const {
+        if (!reader.isFile()) {
+            throw EvioException("reader must be reading a file");
+        }
+        return exportFiles({reader.getFileName()}, threads);
+    }
+
+}
@@ -0,0 +1,140 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COLUMNAREXPORTER_H
+#define EVIO_6_0_COLUMNAREXPORTER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+
+#include "ByteOrder.h"
+#include "DataType.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class Reader;
+    class RecordInput;
+
+
+    /**
+     * This class copies the data of selected banks out of the events of evio version 6
+     * files into columns, one column for each (tag, num, type) selector and one row for
+     * each event. Records are handled in parallel by {@link ParallelEventReader}, each
+     * record filling one {@link ColumnBatch}. Events are walked in place, without creating
+     * {@link EvioNode} or {@link BaseStructure} objects.<p>
+     *
+     * Columns are laid out as Apache Arrow list arrays so they can be wrapped by Arrow,
+     * pyarrow or ROOT's RDataFrame without copying or any dependency of evio on Arrow:
+     * a row's values are <code>values[offsets[row]]</code> up to, not including,
+     * <code>values[offsets[row+1]]</code>, with offsets counted in values.
+     * Values are local endian. CHARSTAR8 data is kept as raw bytes.<p>
+     *
+     * A row gets the values of every bank in its event matching a selector's tag and num
+     * whose data type is that of the selector, in the order they appear in the event.
+     * If the matching bank holds composite data instead, values of the selector's type
+     * are picked out of it with a {@link CompositeCursor}, which uses the cache of
+     * compiled formats. Events without a matching bank have an empty row.
+     *
+     * <pre><code>
+     *    ColumnarExporter exporter({{1, 0, DataType::FLOAT32, "energy"},
+     *                               {2, 0, DataType::INT32,   "channel"}});
+     *    auto batches = exporter.exportFiles(files, 8);
+     * </code></pre>
+     */
+    class ColumnarExporter {
+
+    public:
+
+        /** Which banks fill a column. */
+        struct ColumnSelector {
+            /** Tag of banks. */
+            uint16_t tag;
+            /** Num of banks. */
+            uint8_t num;
+            /** Type of values. */
+            DataType type;
+            /** Name of column. */
+            std::string name;
+        };
+
+        /** One column of a batch, laid out as an Arrow list array. */
+        struct Column {
+            /** Name of column. */
+            std::string name;
+            /** Type of values. */
+            DataType type;
+            /** Bytes in each value. */
+            uint32_t valueBytes;
+            /** Index of each row's first value, plus one past the last row's values (rows + 1 entries). */
+            std::vector<int32_t> offsets;
+            /** Values of all rows, local endian. */
+            std::vector<uint8_t> values;
+
+            /** @return number of values in all rows. */
+            size_t getValueCount() const {return values.size() / valueBytes;}
+        };
+
+        /** Columns filled from the events of one record. */
+        struct ColumnBatch {
+            /** Index into the list of files. */
+            uint32_t fileIndex;
+            /** Index of the record in its file. */
+            uint32_t recordIndex;
+            /** Index in its file of the event of the first row. */
+            uint64_t firstEvent;
+            /** Number of rows, one for each event of the record. */
+            uint32_t rows;
+            /** Columns, in the order of the selectors. */
+            std::vector<Column> columns;
+        };
+
+        /** Callback handed each filled batch in a worker thread. */
+        typedef std::function<void(ColumnBatch & batch)> BatchHandler;
+
+    private:
+
+        /** Bank selectors, one for each column. */
+        std::vector<ColumnSelector> selectors;
+
+    public:
+
+        explicit ColumnarExporter(std::vector<ColumnSelector> selectors);
+
+        std::vector<ColumnSelector> const & getSelectors() const;
+
+        void fillBatch(RecordInput & record, ColumnBatch & batch) const;
+
+        uint64_t exportFiles(std::vector<std::string> const & files, uint32_t threads,
+                             BatchHandler const & handler) const;
+
+        std::vector<ColumnBatch> exportFiles(std::vector<std::string> const & files, uint32_t threads) const;
+
+        std::vector<ColumnBatch> exportReader(Reader & reader, uint32_t threads) const;
+
+    private:
+
+        void addEvent(const uint8_t *event, size_t bytes, ByteOrder const & order,
+                      std::vector<Column> & columns) const;
+
+        void addBank(uint16_t tag, uint8_t num, uint32_t dataType, const uint8_t *data, size_t bytes,
+                     ByteOrder const & order, std::vector<Column> & columns) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_COLUMNAREXPORTER_H
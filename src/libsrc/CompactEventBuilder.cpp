@@ -24,11 +24,15 @@ namespace evio {
      * @param order      byte order of created buffer.
      * @param generateNodes generate and store an EvioNode object
      *                      for each evio structure created.
+     * @param autoGrow   if true, replace the buffer with one twice as large, or as large as needed,
+     *                   whenever it's too small for what's being added, and copy what's been
+     *                   written into it. If false, throw an exception instead.
      *
      * @throws EvioException if bufferSize arg too small
      */
-    CompactEventBuilder::CompactEventBuilder(size_t bufferSize, ByteOrder const & order, bool generateNodes) :
-            order(order), generateNodes(generateNodes) {
+    CompactEventBuilder::CompactEventBuilder(size_t bufferSize, ByteOrder const & order,
+                                             bool generateNodes, bool autoGrow) :
+            order(order), createdBuffer(true), generateNodes(generateNodes), autoGrow(autoGrow) {
 
         if (bufferSize < 8) {
             throw EvioException("bufferSize arg too small");
@@ -39,11 +43,8 @@ namespace evio {
         array = buffer->array();
         buffer->order(order);
 
-        // Init variables
-        createdBuffer = true;
-
         totalLengths.assign(MAX_LEVELS, 0);
-        stackArray.reserve(MAX_LEVELS);
+        stackArray.resize(MAX_LEVELS);
 
         // Fill stackArray vector with pre-allocated objects so each openBank/Seg/TagSeg
         // doesn't have to create a new StructureContent object each time they're called.
@@ -126,12 +127,50 @@ namespace evio {
 
         // Init variables
         nodes.clear();
+        position = 0;
         currentLevel = -1;
         createdBuffer = false;
         currentStructure = nullptr;
     }
 
 
+    /**
+     * Make sure there's room in the buffer to write the given number of bytes at the current
+     * position. If there isn't, and this object was told to grow a buffer it created,
+     * replace the buffer with one twice as large (or as large as needed) and copy what's been
+     * written so far into it. Any generated nodes are moved to the new buffer.
+     *
+     * @param bytes number of bytes to be written.
+     * @throws EvioException if no room in buffer and it may not be replaced.
+     */
+    void CompactEventBuilder::ensureRoom(size_t bytes) {
+        if (buffer->capacity() - position >= bytes) {
+            return;
+        }
+
+        if (!autoGrow || !createdBuffer) {
+            throw EvioException("no room in buffer");
+        }
+
+        size_t newSize = 2*buffer->capacity();
+        if (newSize < position + bytes) {
+            newSize = position + bytes;
+        }
+
+        auto newBuffer = std::make_shared<ByteBuffer>(newSize);
+        newBuffer->order(order);
+        std::memcpy(newBuffer->array(), array + arrayOffset, position);
+
+        buffer = newBuffer;
+        array = buffer->array();
+        arrayOffset = 0;
+
+        for (auto & node : nodes) {
+            node->setBuffer(buffer);
+        }
+    }
+
+
     /**
      * Get the buffer being written into.
      * The buffer is ready to read.
@@ -150,6 +189,43 @@ namespace evio {
     size_t CompactEventBuilder::getTotalBytes() const {return position;}
 
 
+    /**
+     * Hand over the buffer with the finished event, which is ready to read, and go on
+     * with a new buffer of the same size and byte order - taken from the pool if a
+     * {@link ByteBufferPool} is the default allocator - as if {@link #reset()} were called.
+     * Unlike with {@link #getBuffer()}, the caller may keep the returned buffer while this
+     * object builds the next event. Nodes generated for the finished event stay with it.
+     *
+     * @return buffer containing the event just built.
+     */
+    std::shared_ptr<ByteBuffer> CompactEventBuilder::releaseBuffer() {
+        auto finished = getBuffer();
+
+        buffer = std::make_shared<ByteBuffer>(finished->capacity());
+        buffer->order(order);
+        array = buffer->array();
+        arrayOffset = 0;
+        createdBuffer = true;
+
+        reset();
+        return finished;
+    }
+
+
+    /**
+     * Discard the event being built in order to start on a new one in the same buffer,
+     * keeping its size (including any growth) and byte order. Generated nodes are forgotten.
+     */
+    void CompactEventBuilder::reset() {
+        buffer->clear();
+        totalLengths.assign(MAX_LEVELS, 0);
+        nodes.clear();
+        position = 0;
+        currentLevel = -1;
+        currentStructure = nullptr;
+    }
+
+
     /**
      * This method adds an evio segment structure to the buffer.
      *
@@ -182,9 +258,7 @@ namespace evio {
         // in our own variable, "position".
         buffer->clear();
 
-        if ((buffer->limit() - position) < 4) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(4);
 
         // For now, assume length and padding = 0
         if (order == ByteOrder::ENDIAN_BIG) {
@@ -257,9 +331,7 @@ namespace evio {
         // in our own variable, "position".
         buffer->clear();
 
-        if (buffer->limit() - position < 4) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(4);
 
         // Because Java automatically sets all members of a new
         // byte array to zero, we don't have to specifically write
@@ -337,9 +409,7 @@ namespace evio {
         // in our own variable, "position".
         buffer->clear();
 
-        if (buffer->limit() - position < 8) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(8);
 
         // Write bank header into buffer, assuming padding = 0.
         // Bank w/ no data has len = 1
@@ -696,9 +766,7 @@ namespace evio {
         //std::cout << "addEvioNode: buf lim = " << buffer->limit() <<
         //                           " - pos = " << position << " = (" << (buffer->limit() - position) <<
         //                           ") must be >= " << node->getTotalBytes() << " node total bytes");
-        if ((buffer->limit() - position) < len) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(len);
 
         addToAllLengths(len/4);  // # 32-bit words
 
@@ -748,9 +816,8 @@ namespace evio {
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
 
-        if ((buffer->limit() - position) < len) {
-            throw EvioException("no room in buffer");
-        }
+        // Leave room for padding
+        ensureRoom(len + 3);
 
         // Things get tricky if this method is called multiple times in succession.
         // Keep track of how much data we write each time so length and padding
@@ -777,8 +844,9 @@ namespace evio {
         // Copy the data in one chunk
         std::memcpy(array + arrayOffset + position, data, len);
 
-        // Calculate the padding
+        // Calculate the padding and zero it since the buffer may hold old data
         currentStructure->padding = padCount[currentStructure->dataLen % 4];
+        std::memset(array + arrayOffset + position + len, 0, currentStructure->padding);
 
         // Advance buffer position
         position += len + currentStructure->padding;
@@ -816,26 +884,13 @@ namespace evio {
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
 
-        if ((buffer->limit() - position) < 4*len) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(4*len);
 
         addToAllLengths(len);  // # 32-bit words
 
-        if (order.isLocalEndian()) {
-            std::memcpy(array + arrayOffset + position, data, 4*len);
-        }
-        else {
-            size_t pos = position;
-            for (int i=0; i < len; i++) {
-                uint8_t* bytes = reinterpret_cast<uint8_t *>(data);
-                array[arrayOffset + pos++] = bytes[3];
-                array[arrayOffset + pos++] = bytes[2];
-                array[arrayOffset + pos++] = bytes[1];
-                array[arrayOffset + pos++] = bytes[0];
-                data++;
-            }
-        }
+        // One bounds check and a vectorized swap if needed
+        buffer->position(position);
+        buffer->putInts(data, len);
         position += 4*len;     // # bytes
     }
 
@@ -871,9 +926,8 @@ namespace evio {
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
 
-        if ((buffer->limit() - position) < 2*len) {
-            throw EvioException("no room in buffer");
-        }
+        // Leave room for padding
+        ensureRoom(2*len + 2);
 
         // Things get tricky if this method is called multiple times in succession.
         // Keep track of how much data we write each time so length and padding
@@ -901,20 +955,12 @@ namespace evio {
         // Increase lengths by the difference
         addToAllLengths(totalWordLen - lastWordLen);
 
-        if (order.isLocalEndian()) {
-            std::memcpy(array + arrayOffset + position, data, 2*len);
-        }
-        else {
-            size_t pos = position;
-            for (int i=0; i < len; i++) {
-                uint8_t* bytes = reinterpret_cast<uint8_t *>(data);
-                array[arrayOffset + pos++] = bytes[1];
-                array[arrayOffset + pos++] = bytes[0];
-                data++;
-            }
-        }
+        // One bounds check and a vectorized swap if needed
+        buffer->position(position);
+        buffer->putShorts(data, len);
 
         currentStructure->padding = 2*(currentStructure->dataLen % 2);
+        std::memset(array + arrayOffset + position + 2*len, 0, currentStructure->padding);
         // Advance position
         position += 2*len + currentStructure->padding;
     }
@@ -950,30 +996,13 @@ namespace evio {
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
 
-        if ((buffer->limit() - position) < 8*len) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(8*len);
 
         addToAllLengths(2*len);  // # 32-bit words
 
-        if (order.isLocalEndian()) {
-            std::memcpy(array + arrayOffset + position, data, 8*len);
-        }
-        else {
-            size_t pos = position;
-            for (int i = 0; i < len; i++) {
-                uint8_t *bytes = reinterpret_cast<uint8_t *>(data);
-                array[arrayOffset + pos++] = bytes[7];
-                array[arrayOffset + pos++] = bytes[6];
-                array[arrayOffset + pos++] = bytes[5];
-                array[arrayOffset + pos++] = bytes[4];
-                array[arrayOffset + pos++] = bytes[3];
-                array[arrayOffset + pos++] = bytes[2];
-                array[arrayOffset + pos++] = bytes[1];
-                array[arrayOffset + pos++] = bytes[0];
-                data++;
-            }
-        }
+        // One bounds check and a vectorized swap if needed
+        buffer->position(position);
+        buffer->putLongs(data, len);
 
         position += 8*len;       // # bytes
     }
@@ -1005,26 +1034,13 @@ namespace evio {
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
 
-        if ((buffer->limit() - position) < 4*len) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(4*len);
 
         addToAllLengths(len);  // # 32-bit words
 
-        if (order.isLocalEndian()) {
-            std::memcpy(array + arrayOffset + position, data, 4*len);
-        }
-        else {
-            size_t pos = position;
-            for (int i=0; i < len; i++) {
-                uint8_t* bytes = reinterpret_cast<uint8_t *>(data);
-                array[arrayOffset + pos++] = bytes[3];
-                array[arrayOffset + pos++] = bytes[2];
-                array[arrayOffset + pos++] = bytes[1];
-                array[arrayOffset + pos++] = bytes[0];
-                data++;
-            }
-        }
+        // One bounds check and a vectorized swap if needed
+        buffer->position(position);
+        buffer->putFloats(data, len);
 
         position += 4*len;     // # bytes
     }
@@ -1056,26 +1072,13 @@ namespace evio {
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
 
+        ensureRoom(8*len);
+
         addToAllLengths(2*len);  // # 32-bit words
 
-        if (order.isLocalEndian()) {
-            std::memcpy(array + arrayOffset + position, data, 8*len);
-        }
-        else {
-            size_t pos = position;
-            for (int i=0; i < len; i++) {
-                uint8_t* bytes = reinterpret_cast<uint8_t *>(data);
-                array[arrayOffset + pos++] = bytes[7];
-                array[arrayOffset + pos++] = bytes[6];
-                array[arrayOffset + pos++] = bytes[5];
-                array[arrayOffset + pos++] = bytes[4];
-                array[arrayOffset + pos++] = bytes[3];
-                array[arrayOffset + pos++] = bytes[2];
-                array[arrayOffset + pos++] = bytes[1];
-                array[arrayOffset + pos++] = bytes[0];
-                data++;
-            }
-        }
+        // One bounds check and a vectorized swap if needed
+        buffer->position(position);
+        buffer->putDoubles(data, len);
 
         position += 8*len;     // # bytes
     }
@@ -1103,10 +1106,8 @@ namespace evio {
             throw EvioException("may NOT add " + currentStructure->dataType.toString() + " data");
         }
 
-        // Convert strings into byte array (already padded)
-        std::vector<uint8_t> data;
-        Util::stringsToRawBytes(strings, data);
-        size_t len = data.size();
+        // Size of strings in evio format (already padded)
+        size_t len = Util::stringsToRawSize(strings);
 
         // Sets pos = 0, limit = capacity, & does NOT clear data
         buffer->clear();
@@ -1117,7 +1118,10 @@ namespace evio {
             throw EvioException("addStringData() may only be called once per structure");
         }
 
-        std::memcpy(array + arrayOffset + position, data.data(), len);
+        ensureRoom(len);
+
+        // Convert strings straight into the buffer
+        Util::stringsToRawBytes(strings, array + arrayOffset + position);
         currentStructure->dataLen += len;
         addToAllLengths(len/4);
 
@@ -1160,9 +1164,7 @@ namespace evio {
         buffer->clear();
 
         size_t len = rawBytes.size();
-        if (buffer->limit() - position < len) {
-            throw EvioException("no room in buffer");
-        }
+        ensureRoom(len);
 
         // This method cannot be called multiple times in succession.
         if (currentStructure->dataLen > 0) {
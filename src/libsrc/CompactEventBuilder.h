@@ -38,7 +38,14 @@ namespace evio {
      *
      * The methods of this class are not synchronized so it is NOT
      * threadsafe. This is done for speed. The buffer retrieved by
-     * {@link #getBuffer()} is ready to read.
+     * {@link #getBuffer()} is ready to read.<p>
+     *
+     * A builder which creates its own buffer can be told to grow it as needed
+     * instead of throwing an exception when it's full, so the size of an event need not
+     * be known beforehand. Its buffers are allocated through {@link ByteBuffer}'s default
+     * allocator, so if a {@link ByteBufferPool} is installed, a builder reused with
+     * {@link #reset()} or {@link #releaseBuffer()} makes event after event without
+     * going to the system for memory.
      *
      * @author timmer
      * @date 2/6/2014 (Java)
@@ -70,6 +77,9 @@ namespace evio {
          *  structures are being created. */
         bool generateNodes = false;
 
+        /** Replace the buffer with a larger one when it's full instead of throwing an exception. */
+        bool autoGrow = false;
+
         /** If {@link #generateNodes} is {@code true}, then store
          *  generated node objects in this list (in buffer order. */
         std::vector<std::shared_ptr<EvioNode>> nodes;
@@ -134,7 +144,8 @@ namespace evio {
 
     public:
 
-        CompactEventBuilder(size_t bufferSize, ByteOrder const & order, bool generateNodes = false);
+        CompactEventBuilder(size_t bufferSize, ByteOrder const & order,
+                            bool generateNodes = false, bool autoGrow = false);
         explicit CompactEventBuilder(std::shared_ptr<ByteBuffer> buffer, bool generateNodes = false);
 
         void setBuffer(std::shared_ptr<ByteBuffer> buffer, bool generateNodes = false);
@@ -142,10 +153,17 @@ namespace evio {
     private:
 
         void initBuffer(std::shared_ptr<ByteBuffer> buffer, bool generateNodes);
+        void ensureRoom(size_t bytes);
 
     public:
 
         std::shared_ptr<ByteBuffer> getBuffer();
+        std::shared_ptr<ByteBuffer> releaseBuffer();
+
+        void reset();
+
+        /** @return true if the buffer is replaced with a larger one when full. */
+        bool isAutoGrow() const {return autoGrow;}
 
         size_t getTotalBytes() const;
 
@@ -0,0 +1,206 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompactEventIndex.h"
+
+#include <algorithm>
+#include <string>
+
+
+namespace evio {
+
+
+    /** Remove all records and events from this index. */
+    void CompactEventIndex::clear() {
+        firstEvents.assign(1, 0);
+        minLengths.clear();
+        bitWidths.clear();
+        bitStarts.clear();
+        checkpointStarts.clear();
+        checkpoints.clear();
+        packed.clear();
+        bitCount = 0;
+    }
+
+
+    /**
+     * Get a value stored in the packed bits.
+     * @param bitPos position of value's first bit.
+     * @param width  number of bits in value, at most 32.
+     * @return value.
+     */
+    uint32_t CompactEventIndex::getBits(uint64_t bitPos, uint32_t width) const {
+        if (width == 0) return 0;
+
+        size_t word = bitPos / 64;
+        uint32_t shift = bitPos % 64;
+        uint64_t value = packed[word] >> shift;
+        if (shift + width > 64) {
+            value |= packed[word + 1] << (64 - shift);
+        }
+        return (uint32_t)(value & ((1ULL << width) - 1));
+    }
+
+
+    /**
+     * Append a value to the packed bits.
+     * @param value value, which must fit in width bits.
+     * @param width number of bits to store value in, at most 32.
+     */
+    void CompactEventIndex::putBits(uint32_t value, uint32_t width) {
+        if (width == 0) return;
+
+        size_t word = bitCount / 64;
+        uint32_t shift = bitCount % 64;
+        packed.resize((bitCount + width + 63) / 64, 0);
+        packed[word] |= (uint64_t)value << shift;
+        if (shift + width > 64) {
+            packed[word + 1] |= (uint64_t)value >> (64 - shift);
+        }
+        bitCount += width;
+    }
+
+
+    /**
+     * Add a record to the end of this index.
+     * @param lengths length of each event in record, in bytes.
+     * @param count   number of events in record.
+     */
+    void CompactEventIndex::addRecord(const uint32_t *lengths, uint32_t count) {
+        uint32_t minLen = 0, maxLen = 0;
+        if (count > 0) {
+            auto range = std::minmax_element(lengths, lengths + count);
+            minLen = *range.first;
+            maxLen = *range.second;
+        }
+
+        uint32_t width = 0;
+        for (uint32_t diff = maxLen - minLen; diff > 0; diff >>= 1) {
+            width++;
+        }
+
+        firstEvents.push_back(firstEvents.back() + count);
+        minLengths.push_back(minLen);
+        bitWidths.push_back(width);
+        bitStarts.push_back(bitCount);
+        checkpointStarts.push_back(checkpoints.size());
+
+        uint32_t offset = 0;
+        for (uint32_t i=0; i < count; i++) {
+            if (i % CHECKPOINT_INTERVAL == 0) {
+                checkpoints.push_back(offset);
+            }
+            putBits(lengths[i] - minLen, width);
+            offset += lengths[i];
+        }
+    }
+
+
+    /**
+     * Remove all but the given number of records, and their events, from this index.
+     * @param records number of records to keep.
+     */
+    void CompactEventIndex::truncate(uint32_t records) {
+        if (records >= getRecordCount()) return;
+
+        bitCount = bitStarts[records];
+        packed.resize((bitCount + 63) / 64);
+        if (bitCount % 64 != 0) {
+            // Clear bits of removed events so more can be added
+            packed.back() &= (1ULL << (bitCount % 64)) - 1;
+        }
+        checkpoints.resize(checkpointStarts[records]);
+
+        firstEvents.resize(records + 1);
+        minLengths.resize(records);
+        bitWidths.resize(records);
+        bitStarts.resize(records);
+        checkpointStarts.resize(records);
+    }
+
+
+    /** Free memory reserved for records not yet added. */
+    void CompactEventIndex::shrinkToFit() {
+        firstEvents.shrink_to_fit();
+        minLengths.shrink_to_fit();
+        bitWidths.shrink_to_fit();
+        bitStarts.shrink_to_fit();
+        checkpointStarts.shrink_to_fit();
+        checkpoints.shrink_to_fit();
+        packed.shrink_to_fit();
+    }
+
+
+    /**
+     * Get the index of the record containing an event.
+     * @param event event index.
+     * @return index of record containing event.
+     * @throws EvioException if event index is out of range.
+     */
+    uint32_t CompactEventIndex::getRecordOfEvent(uint32_t event) const {
+        if (event >= getEventCount()) {
+            throw EvioException("event index " + std::to_string(event) + " out of range");
+        }
+        // First element of firstEvents greater than event is one past the record
+        auto it = std::upper_bound(firstEvents.cbegin(), firstEvents.cend(), event);
+        return std::distance(firstEvents.cbegin(), it) - 1;
+    }
+
+
+    /**
+     * Get the length of an event.
+     * @param event event index.
+     * @return length of event in bytes.
+     * @throws EvioException if event index is out of range.
+     */
+    uint32_t CompactEventIndex::getEventLength(uint32_t event) const {
+        uint32_t record = getRecordOfEvent(event);
+        uint32_t width = bitWidths[record];
+        uint32_t i = event - firstEvents[record];
+        return minLengths[record] + getBits(bitStarts[record] + (uint64_t)i*width, width);
+    }
+
+
+    /**
+     * Get the offset of an event from the first event in its record,
+     * summing the lengths of at most {@link #CHECKPOINT_INTERVAL} - 1 events.
+     * @param event event index.
+     * @return offset of event in bytes.
+     * @throws EvioException if event index is out of range.
+     */
+    uint32_t CompactEventIndex::getEventOffset(uint32_t event) const {
+        uint32_t record = getRecordOfEvent(event);
+        uint32_t width  = bitWidths[record];
+        uint32_t minLen = minLengths[record];
+        uint32_t i = event - firstEvents[record];
+
+        uint32_t first = i - i % CHECKPOINT_INTERVAL;
+        uint32_t offset = checkpoints[checkpointStarts[record] + i / CHECKPOINT_INTERVAL];
+        uint64_t bitPos = bitStarts[record] + (uint64_t)first*width;
+        for (uint32_t j = first; j < i; j++) {
+            offset += minLen + getBits(bitPos, width);
+            bitPos += width;
+        }
+        return offset;
+    }
+
+
+    /**
+     * Get the memory taken by this index.
+     * @return bytes of memory used by this index's tables.
+     */
+    size_t CompactEventIndex::getMemoryBytes() const {
+        return sizeof(uint32_t) * (firstEvents.capacity() + minLengths.capacity() +
+                                   checkpointStarts.capacity() + checkpoints.capacity()) +
+               sizeof(uint64_t) * (bitStarts.capacity() + packed.capacity()) +
+               bitWidths.capacity();
+    }
+
+}
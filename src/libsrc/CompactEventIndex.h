@@ -0,0 +1,94 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPACTEVENTINDEX_H
+#define EVIO_6_0_COMPACTEVENTINDEX_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a memory-compact index of the events of a file, for files with so many
+     * events that a table of the offset and length of each takes up too much memory.
+     * Records are found from a cumulative count of their events by binary search.
+     * Within a record, the length of each event is stored, less the smallest in the record,
+     * in just as many bits as the largest such difference needs. Event offsets are not stored
+     * but summed from those lengths, starting from a checkpoint kept every
+     * {@link #CHECKPOINT_INTERVAL} events. Events of similar size thus take a few bits each,
+     * about a tenth of a plain table, and finding any event stays O(log records).<p>
+     *
+     * Offsets assume the events of a record are back to back, as evio writes them.
+     */
+    class CompactEventIndex {
+
+    public:
+
+        /** Number of events between stored offsets within a record. */
+        static const uint32_t CHECKPOINT_INTERVAL = 32;
+
+    private:
+
+        /** Index of first event of each record, one entry larger than number of records. */
+        std::vector<uint32_t> firstEvents {0};
+        /** Smallest event length of each record, subtracted from the lengths stored. */
+        std::vector<uint32_t> minLengths;
+        /** Bits in which each event length of a record is stored. */
+        std::vector<uint8_t>  bitWidths;
+        /** Bit position of each record's first stored length. */
+        std::vector<uint64_t> bitStarts;
+        /** Index into checkpoints of each record's first. */
+        std::vector<uint32_t> checkpointStarts;
+
+        /** Offset from its record's first event of every CHECKPOINT_INTERVAL'th event. */
+        std::vector<uint32_t> checkpoints;
+        /** Event lengths, less their record's smallest, packed into words. */
+        std::vector<uint64_t> packed;
+        /** Number of bits used in packed. */
+        uint64_t bitCount = 0;
+
+        uint32_t getBits(uint64_t bitPos, uint32_t width) const;
+        void putBits(uint32_t value, uint32_t width);
+
+    public:
+
+        CompactEventIndex() = default;
+
+        void clear();
+        void addRecord(const uint32_t *lengths, uint32_t count);
+        void truncate(uint32_t records);
+        void shrinkToFit();
+
+        /** @return number of records in the index. */
+        uint32_t getRecordCount() const {return (uint32_t)minLengths.size();}
+        /** @return number of events in the index. */
+        uint32_t getEventCount()  const {return firstEvents.back();}
+        /** @param record record index, which may be one past the last. @return index of record's first event. */
+        uint32_t getFirstEventOfRecord(uint32_t record) const {return firstEvents[record];}
+
+        uint32_t getRecordOfEvent(uint32_t event) const;
+        uint32_t getEventLength(uint32_t event) const;
+        uint32_t getEventOffset(uint32_t event) const;
+
+        size_t getMemoryBytes() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPACTEVENTINDEX_H
@@ -0,0 +1,343 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompositeBatchDecoder.h"
+
+#include <climits>
+#include <cstring>
+
+#include "ByteBufferView.h"
+#include "CompositeBatchGpu.h"
+#include "EventHeaderParser.h"
+#include "RecordInput.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param selectors banks to copy, one column for each, as for {@link ColumnarExporter}.
+     * @param useGpu    if true, decode on a GPU if one is available.
+     * @throws EvioException if a selector's type is not one of the numeric types or CHARSTAR8.
+     */
+    CompositeBatchDecoder::CompositeBatchDecoder(std::vector<ColumnarExporter::ColumnSelector> selectors,
+                                                 bool useGpu) : selectors(std::move(selectors)) {
+        for (auto const & s : this->selectors) {
+            if (s.type.getBytes() < 1 && s.type != DataType::CHARSTAR8) {
+                throw EvioException("cannot make column of type " + s.type.getName());
+            }
+            uint32_t size = s.type.getBytes() < 1 ? 1 : s.type.getBytes();
+            columns.push_back({s.type.getValue(), size});
+        }
+
+#ifdef USE_CUDA
+        if (useGpu && CompositeBatchGpu::isAvailable()) {
+            gpu.reset(new CompositeBatchGpu());
+        }
+#else
+        (void)useGpu;
+#endif
+    }
+
+
+    /** Destructor. */
+    CompositeBatchDecoder::~CompositeBatchDecoder() = default;
+
+
+    /**
+     * Was evio built with GPU decoding and is there a device to decode on?
+     * @return true if batches can be decoded on a GPU.
+     */
+    bool CompositeBatchDecoder::isGpuAvailable() {
+#ifdef USE_CUDA
+        return CompositeBatchGpu::isAvailable();
+#else
+        return false;
+#endif
+    }
+
+
+    /**
+     * Are batches decoded on a GPU?
+     * @return true if batches are decoded on a GPU, false if on the host.
+     */
+    bool CompositeBatchDecoder::isUsingGpu() const {return gpu != nullptr;}
+
+
+    /**
+     * Get the bank selectors, one for each column.
+     * @return bank selectors.
+     */
+    std::vector<ColumnarExporter::ColumnSelector> const & CompositeBatchDecoder::getSelectors() const {return selectors;}
+
+
+    /**
+     * Get the columns of the last batch decoded on a GPU, which are left in device memory
+     * in the same layout as in the batch. They stay valid until the next call to
+     * {@link #decode}. Empty if decoding on the host.
+     * @return columns in device memory, in the order of the selectors.
+     */
+    std::vector<CompositeDeviceColumn> const & CompositeBatchDecoder::getDeviceColumns() const {return deviceColumns;}
+
+
+    /**
+     * Fill the rows and columns of a batch from the events of a record.
+     * The batch's file index, record index and first event are left alone.
+     *
+     * @param record record which has been read.
+     * @param batch  batch to fill, its columns are replaced.
+     * @throws EvioException if an event is not properly formed,
+     *         a column gets too big for 32 bit offsets, or GPU work fails.
+     */
+    void CompositeBatchDecoder::decode(RecordInput & record, ColumnarExporter::ColumnBatch & batch) {
+        uint32_t count = record.getEntries();
+
+        batch.rows = count;
+        batch.columns.clear();
+        batch.columns.reserve(selectors.size());
+        for (size_t c=0; c < selectors.size(); c++) {
+            batch.columns.push_back({selectors[c].name, selectors[c].type, columns[c].valueBytes, {}, {}});
+        }
+
+        // Events of a record lie one after another
+        const uint8_t *events = nullptr;
+#ifdef USE_CUDA
+        size_t eventBytes = 0;
+#endif
+        if (count > 0) {
+            events = record.getEventView(0).data();
+#ifdef USE_CUDA
+            ByteBufferView last = record.getEventView(count - 1);
+            eventBytes = (last.data() + last.size()) - events;
+#endif
+        }
+
+        findItems(record, events);
+        bool swap = !record.getByteOrder().isLocalEndian();
+
+        // Count what each item adds to its column
+#ifdef USE_CUDA
+        if (gpu != nullptr) {
+            gpu->count(events, eventBytes, program, items, columns, swap, itemBytes);
+        }
+        else
+#endif
+        {
+            itemBytes.resize(items.size());
+            for (size_t i=0; i < items.size(); i++) {
+                itemBytes[i] = compositeItemBytes(items[i], program.data(), events, columns[items[i].column], swap);
+            }
+        }
+
+        findPositions(count);
+
+        // Unpack
+#ifdef USE_CUDA
+        if (gpu != nullptr) {
+            gpu->fill(itemPositions, rowOffsets, columnBytes, deviceColumns);
+            for (size_t c=0; c < columns.size(); c++) {
+                batch.columns[c].values.resize(columnBytes[c]);
+                gpu->copyColumn(c, batch.columns[c].values.data(), columnBytes[c]);
+            }
+        }
+        else
+#endif
+        {
+            for (size_t c=0; c < columns.size(); c++) {
+                batch.columns[c].values.resize(columnBytes[c]);
+            }
+            for (size_t i=0; i < items.size(); i++) {
+                auto & item = items[i];
+                compositeItemCopy(item, program.data(), events, columns[item.column], swap,
+                                  batch.columns[item.column].values.data() + itemPositions[i]);
+            }
+        }
+
+        for (size_t c=0; c < columns.size(); c++) {
+            batch.columns[c].offsets = rowOffsets[c];
+        }
+    }
+
+
+    /**
+     * Find every bank of every event matching a selector and make work items of them.
+     * Items come in the order of events and, within an event, of the banks in it,
+     * so each column's values end up in the same order as with ColumnarExporter.
+     *
+     * @param record record which has been read.
+     * @param events start of record's events.
+     * @throws EvioException if an event is not properly formed.
+     */
+    void CompositeBatchDecoder::findItems(RecordInput & record, const uint8_t *events) {
+        items.clear();
+        itemRows.clear();
+
+        // Don't let a stream of ever-changing formats use up memory
+        if (formats.size() > MAX_FORMATS) {
+            program.clear();
+            formats.clear();
+            programStarts.clear();
+        }
+
+        uint32_t bankType = DataType::BANK.getValue();
+        uint32_t compositeType = DataType::COMPOSITE.getValue();
+
+        for (uint32_t row=0; row < record.getEntries(); row++) {
+            ByteBufferView event = record.getEventView(row);
+            EventHeaderParser::indexEvent(event.data(), event.size(), event.order(), index);
+            bool swap = !event.order().isLocalEndian();
+            uint64_t eventOffset = event.data() - events;
+
+            for (size_t s=0; s < index.size(); s++) {
+                if (index.getType(s) != bankType) continue;
+
+                uint32_t dataType = index.getDataType(s);
+                size_t dataBytes = 4*(size_t)index.getDataLength(s);
+                if (index.getPad(s) <= dataBytes) dataBytes -= index.getPad(s);
+                uint64_t dataOffset = eventOffset + index.getDataPosition(s);
+
+                for (uint32_t c=0; c < selectors.size(); c++) {
+                    auto const & sel = selectors[c];
+                    if (sel.tag != index.getTag(s) || sel.num != index.getNum(s)) continue;
+
+                    if (dataType == columns[c].type) {
+                        items.push_back({dataOffset, (uint32_t)dataBytes, 0, 0, c});
+                        itemRows.push_back(row);
+                    }
+                    else if (dataType == compositeType) {
+                        addComposite(events + dataOffset, dataBytes, swap, dataOffset, row, c);
+                    }
+                }
+            }
+        }
+    }
+
+
+    /**
+     * Make a work item of each composite item in a bank's composite data, checking
+     * their headers the same way {@link CompositeCursor#nextItem()} does.
+     *
+     * @param data   start of composite data.
+     * @param bytes  bytes of composite data.
+     * @param swap   true if data is not local endian.
+     * @param offset offset of data from the start of the record's events.
+     * @param row    row (event) of bank.
+     * @param column column data goes into.
+     * @throws EvioException if an item's headers do not fit in the data, or its format is improper.
+     */
+    void CompositeBatchDecoder::addComposite(const uint8_t *data, size_t bytes, bool swap, uint64_t offset,
+                                             uint32_t row, uint32_t column) {
+
+        auto read32 = [swap](const uint8_t *p) {
+            uint32_t val;
+            std::memcpy(&val, p, 4);
+            return swap ? SWAP_32(val) : val;
+        };
+
+        const uint8_t *end = data + bytes;
+        const uint8_t *p = data;
+
+        // A composite item is at least a tagsegment header, format word, and bank header
+        while (p + 16 <= end) {
+            // Tagsegment header: tag (12 bits), type (4 bits), length in words (16 bits)
+            uint32_t formatBytes = 4*(read32(p) & 0xffff);
+            if (formatBytes < 4 || p + 4 + formatBytes + 8 > end) {
+                throw EvioException("bad composite format length");
+            }
+
+            // Format string is null-terminated and padded with 4s
+            auto fmt = reinterpret_cast<const char *>(p + 4);
+            size_t fmtLen = 0;
+            while (fmtLen < formatBytes && fmt[fmtLen] != '\0' && fmt[fmtLen] != '\4') fmtLen++;
+            auto format = CompositeFormat::get(std::string(fmt, fmtLen));
+            if (!format->isCompiled()) {
+                throw EvioException("bad composite format, " + format->getFormat());
+            }
+
+            // Bank header: length in words, then tag, padding, type, num
+            p += 4 + formatBytes;
+            uint32_t bankWords = read32(p);
+            uint32_t padding = (read32(p + 4) >> 14) & 0x3;
+            if (bankWords < 1 || p + 4 + 4*(size_t)bankWords > end || 4*(bankWords - 1) < padding) {
+                throw EvioException("bad composite data length");
+            }
+
+            const uint8_t *dataStart = p + 8;
+            uint32_t dataBytes = 4*(bankWords - 1) - padding;
+
+            items.push_back({offset + (dataStart - data), dataBytes, programStart(format),
+                             (uint32_t)format->program.size(), column});
+            itemRows.push_back(row);
+
+            p += 4 + 4*(size_t)bankWords;
+        }
+    }
+
+
+    /**
+     * Get the position of a format's first operation in the program array,
+     * adding its operations the first time it's seen.
+     * @param format compiled format.
+     * @return position of first operation.
+     */
+    uint32_t CompositeBatchDecoder::programStart(const std::shared_ptr<const CompositeFormat> & format) {
+        auto it = programStarts.find(format.get());
+        if (it != programStarts.end()) {
+            return it->second;
+        }
+
+        auto start = (uint32_t)program.size();
+        for (auto const & op : format->program) {
+            program.push_back({(uint32_t)op.type, op.code, op.width, op.count,
+                               op.countBytes, op.match, op.toEnd ? 1u : 0u});
+        }
+        formats.push_back(format);
+        programStarts.emplace(format.get(), start);
+        return start;
+    }
+
+
+    /**
+     * From the bytes each item adds, find where each item's values go in its column,
+     * the row offsets, and each column's size.
+     * @param rows number of rows.
+     * @throws EvioException if a column gets too big for 32 bit offsets.
+     */
+    void CompositeBatchDecoder::findPositions(uint32_t rows) {
+        size_t columnCount = columns.size();
+        columnBytes.assign(columnCount, 0);
+        rowOffsets.resize(columnCount);
+        for (auto & offsets : rowOffsets) {
+            offsets.clear();
+            offsets.reserve(rows + 1);
+            offsets.push_back(0);
+        }
+        itemPositions.resize(items.size());
+
+        size_t i = 0;
+        for (uint32_t row=0; row < rows; row++) {
+            for (; i < items.size() && itemRows[i] == row; i++) {
+                uint32_t c = items[i].column;
+                itemPositions[i] = columnBytes[c];
+                columnBytes[c] += itemBytes[i];
+            }
+
+            for (size_t c=0; c < columnCount; c++) {
+                uint64_t values = columnBytes[c] / columns[c].valueBytes;
+                if (values > INT32_MAX) {
+                    throw EvioException("column " + selectors[c].name + " has too many values for 32 bit offsets");
+                }
+                rowOffsets[c].push_back((int32_t)values);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,137 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPOSITEBATCHDECODER_H
+#define EVIO_6_0_COMPOSITEBATCHDECODER_H
+
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+
+#include "ColumnarExporter.h"
+#include "CompositeFormat.h"
+#include "CompositeProgram.h"
+#include "StructureIndex.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class RecordInput;
+    class CompositeBatchGpu;
+
+
+    /**
+     * This class fills the columns of a {@link ColumnarExporter::ColumnBatch} from all the
+     * events of a record at once, unpacking composite banks, such as FADC waveforms, on a
+     * GPU when there is one. The batch is exactly what {@link ColumnarExporter#fillBatch}
+     * makes from the same selectors, so the two are interchangeable.<p>
+     *
+     * Matching banks are found on the host through each event's {@link StructureIndex}.
+     * Each bank, and each composite item of a composite bank, becomes one work item, and
+     * the compiled programs of all formats seen (see {@link CompositeFormat}) are flattened
+     * into one array. Then, one GPU thread per item, the bytes each item adds to its column
+     * are counted, positions are found, and values are unpacked and swapped into place.
+     * The columns are left in device memory, available through {@link #getDeviceColumns()}
+     * until the next batch, as well as copied into the batch.<p>
+     *
+     * GPU decoding is only compiled in if evio is configured with EVIO_USE_CUDA and the CUDA
+     * toolkit is found. Otherwise, or if there is no device, the same code runs on the host.
+     * This class is not thread-safe; use one object per thread.
+     *
+     * <pre><code>
+     *    CompositeBatchDecoder decoder({{5, 1, DataType::SHORT16, "samples"}});
+     *    decoder.decode(record, batch);
+     * </code></pre>
+     */
+    class CompositeBatchDecoder {
+
+    private:
+
+        /** Max number of formats whose programs are kept. */
+        static const size_t MAX_FORMATS = 4096;
+
+        /** Bank selectors, one for each column. */
+        std::vector<ColumnarExporter::ColumnSelector> selectors;
+
+        /** Type and value size of each column. */
+        std::vector<CompositeBatchColumn> columns;
+
+        /** Structures of the event being looked at. */
+        StructureIndex index;
+
+        /** Operations of all formats seen. */
+        std::vector<CompositeProgramOp> program;
+
+        /** Formats seen, kept so their addresses stay unique. */
+        std::vector<std::shared_ptr<const CompositeFormat>> formats;
+
+        /** Position in program of each format's first operation. */
+        std::unordered_map<const CompositeFormat *, uint32_t> programStarts;
+
+        /** Work items of current batch. */
+        std::vector<CompositeBatchItem> items;
+
+        /** Row (event) of each item. */
+        std::vector<uint32_t> itemRows;
+
+        /** Bytes each item adds to its column. */
+        std::vector<uint64_t> itemBytes;
+
+        /** Where each item's values go in its column. */
+        std::vector<uint64_t> itemPositions;
+
+        /** Row offsets of each column. */
+        std::vector<std::vector<int32_t>> rowOffsets;
+
+        /** Bytes of values of each column. */
+        std::vector<uint64_t> columnBytes;
+
+        /** Columns of last batch decoded on the GPU. */
+        std::vector<CompositeDeviceColumn> deviceColumns;
+
+        /** GPU work, null if decoding on the host. */
+        std::unique_ptr<CompositeBatchGpu> gpu;
+
+    public:
+
+        explicit CompositeBatchDecoder(std::vector<ColumnarExporter::ColumnSelector> selectors,
+                                       bool useGpu = true);
+
+        CompositeBatchDecoder(const CompositeBatchDecoder & other) = delete;
+        CompositeBatchDecoder & operator=(const CompositeBatchDecoder & other) = delete;
+
+        ~CompositeBatchDecoder();
+
+        static bool isGpuAvailable();
+        bool isUsingGpu() const;
+
+        std::vector<ColumnarExporter::ColumnSelector> const & getSelectors() const;
+        std::vector<CompositeDeviceColumn> const & getDeviceColumns() const;
+
+        void decode(RecordInput & record, ColumnarExporter::ColumnBatch & batch);
+
+    private:
+
+        void findItems(RecordInput & record, const uint8_t *events);
+        void addComposite(const uint8_t *data, size_t bytes, bool swap, uint64_t offset,
+                          uint32_t row, uint32_t column);
+        uint32_t programStart(const std::shared_ptr<const CompositeFormat> & format);
+        void findPositions(uint32_t rows);
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPOSITEBATCHDECODER_H
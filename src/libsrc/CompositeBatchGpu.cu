@@ -0,0 +1,218 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompositeBatchGpu.h"
+
+
+#include <string>
+#include <cuda_runtime.h>
+
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** Threads in each block. */
+        const uint32_t BLOCK_THREADS = 128;
+
+
+        /**
+         * Throw an exception if a CUDA call failed.
+         * @param err  return value of call.
+         * @param what what was being done.
+         * @throws EvioException if err is not cudaSuccess.
+         */
+        void check(cudaError_t err, const char *what) {
+            if (err != cudaSuccess) {
+                throw EvioException(std::string(what) + ", " + cudaGetErrorString(err));
+            }
+        }
+
+
+        /**
+         * Make sure device memory holds at least the given number of objects.
+         * Contents are not kept when it grows.
+         * @param ptr   device memory.
+         * @param cap   number of objects it holds.
+         * @param count number of objects needed.
+         */
+        template<typename T>
+        void ensure(T *& ptr, size_t & cap, size_t count) {
+            if (count <= cap && ptr != nullptr) return;
+            if (ptr != nullptr) cudaFree(ptr);
+            ptr = nullptr;
+            cap = 0;
+            // Grow by half again to avoid doing this for every batch
+            size_t newCap = count + count/2 + 1;
+            check(cudaMalloc((void **)&ptr, newCap * sizeof(T)), "cannot allocate GPU memory");
+            cap = newCap;
+        }
+
+
+        /** Find the bytes each item adds to its column, one thread for each item. */
+        __global__ void countKernel(const CompositeBatchItem *items, size_t count,
+                                    const CompositeProgramOp *program, const uint8_t *events,
+                                    const CompositeBatchColumn *columns, bool swap, uint64_t *bytes) {
+            size_t i = (size_t)blockIdx.x * blockDim.x + threadIdx.x;
+            if (i >= count) return;
+            const CompositeBatchItem & item = items[i];
+            bytes[i] = compositeItemBytes(item, program, events, columns[item.column], swap);
+        }
+
+
+        /** Copy each item's values into its column, one thread for each item. */
+        __global__ void fillKernel(const CompositeBatchItem *items, size_t count,
+                                   const CompositeProgramOp *program, const uint8_t *events,
+                                   const CompositeBatchColumn *columns, bool swap,
+                                   const uint64_t *positions, uint8_t **values) {
+            size_t i = (size_t)blockIdx.x * blockDim.x + threadIdx.x;
+            if (i >= count) return;
+            const CompositeBatchItem & item = items[i];
+            compositeItemCopy(item, program, events, columns[item.column], swap,
+                              values[item.column] + positions[i]);
+        }
+    }
+
+
+    /** Destructor which frees all device memory. */
+    CompositeBatchGpu::~CompositeBatchGpu() {
+        cudaFree(events);
+        cudaFree(program);
+        cudaFree(items);
+        cudaFree(columns);
+        cudaFree(itemBytes);
+        cudaFree(itemOffsets);
+        cudaFree(valuePointers);
+        for (auto p : values)  cudaFree(p);
+        for (auto p : offsets) cudaFree(p);
+    }
+
+
+    /**
+     * Is there a CUDA device to use?
+     * @return true if there is a CUDA device.
+     */
+    bool CompositeBatchGpu::isAvailable() {
+        int count = 0;
+        return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+    }
+
+
+    /**
+     * Copy a record's events and the batch's items to the device
+     * and find the bytes each item adds to its column.
+     *
+     * @param eventData    start of record's events.
+     * @param eventBytes   bytes of events.
+     * @param ops          operations of all formats.
+     * @param batchItems   items of batch.
+     * @param batchColumns column descriptions.
+     * @param swapData     true if events are not local endian.
+     * @param bytes        filled with the bytes each item adds to its column.
+     * @throws EvioException if a CUDA call fails.
+     */
+    void CompositeBatchGpu::count(const uint8_t *eventData, size_t eventBytes,
+                                  std::vector<CompositeProgramOp> const & ops,
+                                  std::vector<CompositeBatchItem> const & batchItems,
+                                  std::vector<CompositeBatchColumn> const & batchColumns,
+                                  bool swapData, std::vector<uint64_t> & bytes) {
+
+        itemCount = batchItems.size();
+        swap = swapData;
+        bytes.resize(itemCount);
+        if (itemCount == 0) return;
+
+        ensure(events, eventsCap, eventBytes);
+        ensure(program, programCap, ops.size());
+        ensure(items, itemsCap, itemCount);
+        ensure(columns, columnsCap, batchColumns.size());
+        ensure(itemBytes, itemBytesCap, itemCount);
+
+        check(cudaMemcpy(events, eventData, eventBytes, cudaMemcpyHostToDevice), "cannot copy events to GPU");
+        if (!ops.empty()) {
+            check(cudaMemcpy(program, ops.data(), ops.size() * sizeof(CompositeProgramOp),
+                             cudaMemcpyHostToDevice), "cannot copy formats to GPU");
+        }
+        check(cudaMemcpy(items, batchItems.data(), itemCount * sizeof(CompositeBatchItem),
+                         cudaMemcpyHostToDevice), "cannot copy items to GPU");
+        check(cudaMemcpy(columns, batchColumns.data(), batchColumns.size() * sizeof(CompositeBatchColumn),
+                         cudaMemcpyHostToDevice), "cannot copy columns to GPU");
+
+        uint32_t blocks = (uint32_t)((itemCount + BLOCK_THREADS - 1) / BLOCK_THREADS);
+        countKernel<<<blocks, BLOCK_THREADS>>>(items, itemCount, program, events, columns, swap, itemBytes);
+        check(cudaGetLastError(), "cannot run count kernel");
+
+        check(cudaMemcpy(bytes.data(), itemBytes, itemCount * sizeof(uint64_t), cudaMemcpyDeviceToHost),
+              "cannot copy item sizes from GPU");
+    }
+
+
+    /**
+     * Copy the values of all items of the batch last counted into columns on the device.
+     *
+     * @param itemPositions where each item's values go in its column.
+     * @param rowOffsets    row offsets of each column.
+     * @param columnBytes   bytes of values of each column.
+     * @param deviceColumns filled with the device memory holding each column.
+     * @throws EvioException if a CUDA call fails.
+     */
+    void CompositeBatchGpu::fill(std::vector<uint64_t> const & itemPositions,
+                                 std::vector<std::vector<int32_t>> const & rowOffsets,
+                                 std::vector<uint64_t> const & columnBytes,
+                                 std::vector<CompositeDeviceColumn> & deviceColumns) {
+
+        size_t columnCount = columnBytes.size();
+        values.resize(columnCount, nullptr);
+        valuesCap.resize(columnCount, 0);
+        offsets.resize(columnCount, nullptr);
+        offsetsCap.resize(columnCount, 0);
+        deviceColumns.resize(columnCount);
+
+        for (size_t c=0; c < columnCount; c++) {
+            ensure(values[c], valuesCap[c], columnBytes[c]);
+            ensure(offsets[c], offsetsCap[c], rowOffsets[c].size());
+            check(cudaMemcpy(offsets[c], rowOffsets[c].data(), rowOffsets[c].size() * sizeof(int32_t),
+                             cudaMemcpyHostToDevice), "cannot copy row offsets to GPU");
+            deviceColumns[c] = {values[c], offsets[c], columnBytes[c]};
+        }
+
+        if (itemCount == 0) return;
+
+        ensure(itemOffsets, itemOffsetsCap, itemCount);
+        ensure(valuePointers, valuePointersCap, columnCount);
+        check(cudaMemcpy(itemOffsets, itemPositions.data(), itemCount * sizeof(uint64_t),
+                         cudaMemcpyHostToDevice), "cannot copy item positions to GPU");
+        check(cudaMemcpy(valuePointers, values.data(), columnCount * sizeof(uint8_t *),
+                         cudaMemcpyHostToDevice), "cannot copy column pointers to GPU");
+
+        uint32_t blocks = (uint32_t)((itemCount + BLOCK_THREADS - 1) / BLOCK_THREADS);
+        fillKernel<<<blocks, BLOCK_THREADS>>>(items, itemCount, program, events, columns, swap,
+                                              itemOffsets, valuePointers);
+        check(cudaGetLastError(), "cannot run fill kernel");
+        check(cudaDeviceSynchronize(), "fill kernel failed");
+    }
+
+
+    /**
+     * Copy the values of a column from the device.
+     * @param column index of column.
+     * @param dest   where to copy them.
+     * @param bytes  number of bytes.
+     * @throws EvioException if the copy fails.
+     */
+    void CompositeBatchGpu::copyColumn(size_t column, uint8_t *dest, size_t bytes) const {
+        if (bytes == 0) return;
+        check(cudaMemcpy(dest, values[column], bytes, cudaMemcpyDeviceToHost), "cannot copy column from GPU");
+    }
+
+}
@@ -0,0 +1,110 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPOSITEBATCHGPU_H
+#define EVIO_6_0_COMPOSITEBATCHGPU_H
+
+
+#include <cstdint>
+#include <vector>
+
+
+#include "CompositeProgram.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class runs the work of a {@link CompositeBatchDecoder} on a CUDA device.
+     * It's only built if evio is configured with EVIO_USE_CUDA and the CUDA toolkit
+     * is found, in which case USE_CUDA is defined. Device memory is kept from one
+     * batch to the next and only grown when needed.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class CompositeBatchGpu {
+
+    private:
+
+        /** Record's events. */
+        uint8_t *events = nullptr;
+        size_t eventsCap = 0;
+
+        /** Operations of all formats. */
+        CompositeProgramOp *program = nullptr;
+        size_t programCap = 0;
+
+        /** Items of batch. */
+        CompositeBatchItem *items = nullptr;
+        size_t itemsCap = 0;
+
+        /** Column descriptions. */
+        CompositeBatchColumn *columns = nullptr;
+        size_t columnsCap = 0;
+
+        /** Bytes each item adds to its column. */
+        uint64_t *itemBytes = nullptr;
+        size_t itemBytesCap = 0;
+
+        /** Where each item's values go in its column. */
+        uint64_t *itemOffsets = nullptr;
+        size_t itemOffsetsCap = 0;
+
+        /** Device pointer to each column's values. */
+        uint8_t **valuePointers = nullptr;
+        size_t valuePointersCap = 0;
+
+        /** Values of each column. */
+        std::vector<uint8_t *> values;
+        std::vector<size_t> valuesCap;
+
+        /** Row offsets of each column. */
+        std::vector<int32_t *> offsets;
+        std::vector<size_t> offsetsCap;
+
+        /** Number of items in the current batch. */
+        size_t itemCount = 0;
+
+        /** Are the current events not local endian? */
+        bool swap = false;
+
+    public:
+
+        CompositeBatchGpu() = default;
+        CompositeBatchGpu(const CompositeBatchGpu & other) = delete;
+        CompositeBatchGpu & operator=(const CompositeBatchGpu & other) = delete;
+#ifdef USE_CUDA
+        ~CompositeBatchGpu();
+#else
+        // Never made without CUDA
+        ~CompositeBatchGpu() = default;
+#endif
+
+        static bool isAvailable();
+
+        void count(const uint8_t *eventData, size_t eventBytes,
+                   std::vector<CompositeProgramOp> const & ops,
+                   std::vector<CompositeBatchItem> const & batchItems,
+                   std::vector<CompositeBatchColumn> const & batchColumns,
+                   bool swapData, std::vector<uint64_t> & bytes);
+
+        void fill(std::vector<uint64_t> const & itemPositions,
+                  std::vector<std::vector<int32_t>> const & rowOffsets,
+                  std::vector<uint64_t> const & columnBytes,
+                  std::vector<CompositeDeviceColumn> & deviceColumns);
+
+        void copyColumn(size_t column, uint8_t *dest, size_t bytes) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPOSITEBATCHGPU_H
@@ -0,0 +1,478 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompositeCursor.h"
+
+
+#include <cstring>
+#include <limits>
+
+#include "EvioNode.h"
+#include "BaseStructure.h"
+#include "Util.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor over the raw bytes of composite data.
+     * @param bytes   raw composite data: one or more composite items each starting
+     *                with the tagsegment header of its format.
+     * @param byteLen number of bytes.
+     * @param order   byte order of data.
+     * @throws EvioException if bytes is null.
+     */
+    CompositeCursor::CompositeCursor(const uint8_t *bytes, size_t byteLen, ByteOrder const & order) {
+        if (bytes == nullptr) {
+            throw EvioException("null bytes arg");
+        }
+        init(bytes, byteLen, order);
+    }
+
+
+    /**
+     * Constructor over the data of a node representing a structure of composite data.
+     * @param node node whose data is composite.
+     * @throws EvioException if node's data is not composite.
+     */
+    CompositeCursor::CompositeCursor(EvioNode & node) {
+        if (node.getDataTypeObj() != DataType::COMPOSITE) {
+            throw EvioException("node does not contain composite data");
+        }
+        auto buf = node.getBuffer();
+        init(buf->array() + buf->arrayOffset() + node.getDataPosition(),
+             4*node.getDataLength(), buf->order());
+    }
+
+
+    /**
+     * Constructor over the data of a structure containing composite data.
+     * The structure's raw bytes are used, so use this before, or instead of,
+     * getting its CompositeData objects.
+     * @param structure structure whose data is composite.
+     * @throws EvioException if structure's data is not composite.
+     */
+    CompositeCursor::CompositeCursor(BaseStructure & structure) {
+        if (structure.getHeader()->getDataType() != DataType::COMPOSITE) {
+            throw EvioException("structure does not contain composite data");
+        }
+        auto & raw = structure.getRawBytes();
+        init(raw.data(), raw.size(), structure.getByteOrder());
+    }
+
+
+    /**
+     * Set the data to be read.
+     * @param bytes     raw composite data.
+     * @param byteLen   number of bytes.
+     * @param byteOrder byte order of data.
+     */
+    void CompositeCursor::init(const uint8_t *bytes, size_t byteLen, ByteOrder const & byteOrder) {
+        start = bytes;
+        end = bytes + byteLen;
+        order = byteOrder;
+        needSwap = !order.isLocalEndian();
+        reset();
+    }
+
+
+    /** Go back to before the first composite item. */
+    void CompositeCursor::reset() {
+        nextItemStart = start;
+        haveItem = false;
+        finished = true;
+        value = nullptr;
+        valueBytes = 0;
+        type = &DataType::NOT_A_VALID_TYPE;
+    }
+
+
+    /**
+     * Read a 32 bit word, swapping it if necessary.
+     * @param p pointer to word.
+     * @return word.
+     */
+    uint32_t CompositeCursor::read32(const uint8_t *p) const {
+        uint32_t val;
+        std::memcpy(&val, p, 4);
+        return needSwap ? SWAP_32(val) : val;
+    }
+
+
+    /**
+     * Move to the next composite item, making its values available through {@link #next()}.
+     * @return true if there is another item, false if there are no more.
+     * @throws EvioException if the item's headers do not fit in the data,
+     *                       or its format is improper.
+     */
+    bool CompositeCursor::nextItem() {
+        haveItem = false;
+        finished = true;
+
+        // A composite item is at least a tagsegment header, format word, and bank header
+        if (nextItemStart + 16 > end) {
+            return false;
+        }
+
+        // Tagsegment header: tag (12 bits), type (4 bits), length in words (16 bits)
+        const uint8_t *p = nextItemStart;
+        uint32_t word = read32(p);
+        formatTag = word >> 20;
+        uint32_t formatBytes = 4*(word & 0xffff);
+        if (formatBytes < 4 || p + 4 + formatBytes + 8 > end) {
+            throw EvioException("bad composite format length");
+        }
+
+        // Format string is null-terminated and padded with 4s
+        auto fmt = reinterpret_cast<const char *>(p + 4);
+        size_t fmtLen = 0;
+        while (fmtLen < formatBytes && fmt[fmtLen] != '\0' && fmt[fmtLen] != '\4') fmtLen++;
+        format = CompositeFormat::get(std::string(fmt, fmtLen));
+        if (!format->isCompiled()) {
+            throw EvioException("bad composite format, " + format->getFormat());
+        }
+
+        // Bank header: length in words, then tag (16 bits), padding (2 bits), type (6 bits), num (8 bits)
+        p += 4 + formatBytes;
+        uint32_t bankWords = read32(p);
+        word = read32(p + 4);
+        dataTag = word >> 16;
+        dataNum = word & 0xff;
+        uint32_t padding = (word >> 14) & 0x3;
+        if (bankWords < 1 || p + 4 + 4*(size_t)bankWords > end || 4*(bankWords - 1) < padding) {
+            throw EvioException("bad composite data length");
+        }
+
+        dataStart = p + 8;
+        dataEnd = dataStart + 4*(bankWords - 1) - padding;
+        nextItemStart = p + 4 + 4*(size_t)bankWords;
+
+        pos = dataStart;
+        restartPos = nullptr;
+        pc = 0;
+        level = 0;
+        checked = false;
+        valuesLeft = 0;
+        value = nullptr;
+        valueBytes = 0;
+        type = &DataType::NOT_A_VALID_TYPE;
+
+        haveItem = true;
+        finished = false;
+        return true;
+    }
+
+
+    /**
+     * Move to the next value of the current composite item.
+     * If there is no current item, move to the first one.
+     * @return true if there is another value, false if all have been read.
+     */
+    bool CompositeCursor::next() {
+        if (!haveItem) {
+            if (nextItemStart != start || !nextItem()) return false;
+        }
+        if (finished) return false;
+
+        while (true) {
+            // Values left over from the last format code
+            if (valuesLeft > 0) {
+                if (pos + valueWidth > dataEnd) {
+                    finished = true;
+                    return false;
+                }
+                value = pos;
+                valueBytes = valueWidth;
+                type = valueType;
+                pos += valueWidth;
+                if (--valuesLeft == 0) checked = false;
+                return true;
+            }
+
+            // Use the format to find the next values, a count read from data is a value itself
+            StepResult result = step();
+            if (result == STEP_END) {
+                finished = true;
+                return false;
+            }
+            if (result == STEP_COUNT) {
+                return true;
+            }
+        }
+    }
+
+
+    /**
+     * Go through the format's program until the next format code with data.
+     * If a repeat count is read from data, it becomes the current value.
+     * @return STEP_END if the end of data was reached, STEP_COUNT if a repeat count
+     *         was read, else STEP_VALUES.
+     */
+    CompositeCursor::StepResult CompositeCursor::step() {
+        const auto & program = format->program;
+
+        while (true) {
+            // End of format reached, start it over, unless nothing was read since last time
+            if (pc == program.size()) {
+                if (pos == restartPos) return STEP_END;
+                restartPos = pos;
+                pc = 0;
+            }
+
+            const CompositeFormat::Op & op = program[pc];
+
+            if (op.type == CompositeFormat::GROUP_END) {
+                Level & lv = levels[level-1];
+                if (++lv.done >= lv.repeats) {
+                    level--;
+                    pc++;
+                }
+                else {
+                    pc = lv.begin + 1;
+                }
+                continue;
+            }
+
+            // As in the interpreter, check for the end of data once between format codes
+            if (!checked) {
+                if (pos >= dataEnd) return STEP_END;
+                checked = true;
+            }
+
+            if (op.type == CompositeFormat::GROUP_BEGIN) {
+                int64_t repeats = op.count;
+                bool counted = op.countBytes > 0;
+                if (counted) {
+                    if (pos + op.countBytes > dataEnd) return STEP_END;
+                    repeats = readCount(op.countBytes);
+                }
+
+                // Parenthesis contents are always done at least once
+                levels[level].begin = pc;
+                levels[level].repeats = repeats < 1 ? 1 : repeats;
+                levels[level].done = 0;
+                level++;
+                pc++;
+
+                if (counted) {
+                    valuesLeft = 0;
+                    return STEP_COUNT;
+                }
+                continue;
+            }
+
+            // Format code for data
+            pc++;
+            bool counted = false;
+            uint64_t count = op.count;
+            if (op.toEnd) {
+                count = std::numeric_limits<uint64_t>::max();
+            }
+            else if (op.countBytes > 0) {
+                if (pos + op.countBytes > dataEnd) return STEP_END;
+                int64_t n = readCount(op.countBytes);
+                count = n < 0 ? 0 : n;
+                counted = true;
+            }
+
+            if (op.code == 3) {
+                // All chars of a string format are one value
+                size_t left = dataEnd - pos;
+                valueWidth = count > left ? left : count;
+                valuesLeft = 1;
+                valueType = &DataType::CHARSTAR8;
+            }
+            else {
+                valueWidth = op.width;
+                valuesLeft = count;
+                valueType = (op.code == 12) ? &DataType::HOLLERIT : &DataType::getDataType(op.code);
+            }
+
+            if (valuesLeft == 0) checked = false;
+
+            // Return any count now, the values on the following calls to next()
+            return counted ? STEP_COUNT : STEP_VALUES;
+        }
+    }
+
+
+    /**
+     * Read a repeat count from data and make it the current value.
+     * @param countBytes number of bytes holding the count, 4, 2, or 1.
+     * @return count.
+     */
+    int64_t CompositeCursor::readCount(uint32_t countBytes) {
+        int64_t count;
+        value = pos;
+        valueBytes = countBytes;
+
+        if (countBytes == 4) {
+            count = static_cast<int32_t>(read32(pos));
+            type = &DataType::NVALUE;
+        }
+        else if (countBytes == 2) {
+            uint16_t val;
+            std::memcpy(&val, pos, 2);
+            count = needSwap ? SWAP_16(val) : val;
+            type = &DataType::nVALUE;
+        }
+        else {
+            count = *pos;
+            type = &DataType::mVALUE;
+        }
+
+        pos += countBytes;
+        return count;
+    }
+
+
+    /**
+     * Make sure the current value has the given size.
+     * @param bytes size of value being asked for.
+     * @throws EvioException if current value is of a different size.
+     */
+    void CompositeCursor::checkSize(uint32_t bytes) const {
+        if (value == nullptr || valueBytes != bytes) {
+            throw EvioException("current value is not " + std::to_string(bytes) + " bytes");
+        }
+    }
+
+
+    /**
+     * Get the current value as a signed 8 bit integer. Also for m counts.
+     * @return current value.
+     * @throws EvioException if current value is not 1 byte.
+     */
+    int8_t CompositeCursor::getChar() const {
+        checkSize(1);
+        return static_cast<int8_t>(*value);
+    }
+
+
+    /**
+     * Get the current value as an unsigned 8 bit integer.
+     * @return current value.
+     * @throws EvioException if current value is not 1 byte.
+     */
+    uint8_t CompositeCursor::getUChar() const {
+        checkSize(1);
+        return *value;
+    }
+
+
+    /**
+     * Get the current value as a signed 16 bit integer. Also for n counts.
+     * @return current value.
+     * @throws EvioException if current value is not 2 bytes.
+     */
+    int16_t CompositeCursor::getShort() const {
+        return static_cast<int16_t>(getUShort());
+    }
+
+
+    /**
+     * Get the current value as an unsigned 16 bit integer.
+     * @return current value.
+     * @throws EvioException if current value is not 2 bytes.
+     */
+    uint16_t CompositeCursor::getUShort() const {
+        checkSize(2);
+        uint16_t val;
+        std::memcpy(&val, value, 2);
+        return needSwap ? SWAP_16(val) : val;
+    }
+
+
+    /**
+     * Get the current value as a signed 32 bit integer. Also for N counts and Hollerith.
+     * @return current value.
+     * @throws EvioException if current value is not 4 bytes.
+     */
+    int32_t CompositeCursor::getInt() const {
+        return static_cast<int32_t>(getUInt());
+    }
+
+
+    /**
+     * Get the current value as an unsigned 32 bit integer.
+     * @return current value.
+     * @throws EvioException if current value is not 4 bytes.
+     */
+    uint32_t CompositeCursor::getUInt() const {
+        checkSize(4);
+        return read32(value);
+    }
+
+
+    /**
+     * Get the current value as a signed 64 bit integer.
+     * @return current value.
+     * @throws EvioException if current value is not 8 bytes.
+     */
+    int64_t CompositeCursor::getLong() const {
+        return static_cast<int64_t>(getULong());
+    }
+
+
+    /**
+     * Get the current value as an unsigned 64 bit integer.
+     * @return current value.
+     * @throws EvioException if current value is not 8 bytes.
+     */
+    uint64_t CompositeCursor::getULong() const {
+        checkSize(8);
+        uint64_t val;
+        std::memcpy(&val, value, 8);
+        return needSwap ? SWAP_64(val) : val;
+    }
+
+
+    /**
+     * Get the current value as a float.
+     * @return current value.
+     * @throws EvioException if current value is not 4 bytes.
+     */
+    float CompositeCursor::getFloat() const {
+        uint32_t bits = getUInt();
+        float val;
+        std::memcpy(&val, &bits, 4);
+        return val;
+    }
+
+
+    /**
+     * Get the current value as a double.
+     * @return current value.
+     * @throws EvioException if current value is not 8 bytes.
+     */
+    double CompositeCursor::getDouble() const {
+        uint64_t bits = getULong();
+        double val;
+        std::memcpy(&val, &bits, 8);
+        return val;
+    }
+
+
+    /**
+     * Get the strings of the current value, when its type is CHARSTAR8.
+     * Unlike the other getters, this allocates.
+     * @param strings vector filled with the strings.
+     * @throws EvioException if there is no current value.
+     */
+    void CompositeCursor::getStrings(std::vector<std::string> & strings) const {
+        if (value == nullptr) {
+            throw EvioException("no current value");
+        }
+        strings.clear();
+        Util::unpackRawBytesToStrings(const_cast<uint8_t *>(value), valueBytes, strings);
+    }
+
+}
@@ -0,0 +1,213 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPOSITECURSOR_H
+#define EVIO_6_0_COMPOSITECURSOR_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+
+
+#include "ByteOrder.h"
+#include "DataType.h"
+#include "CompositeFormat.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class EvioNode;
+    class BaseStructure;
+
+
+    /**
+     * This class reads composite data in place, one value at a time, without creating
+     * {@link CompositeData} objects. It works on the raw bytes of composite data, which may
+     * hold several composite items one after another, each with its own tagsegment holding
+     * the format, a bank header, and the data. It walks each item's data following its
+     * compiled format (see {@link CompositeFormat}) and hands out typed values, swapping
+     * them as they're read if the data is not local endian. Nothing is copied and, once a
+     * format has been seen, nothing is allocated.<p>
+     *
+     * The values come in the same order as those in {@link CompositeData#getItems()},
+     * including the N, n, and m repeat counts taken from data. A string format, 'a', gives
+     * one value of all its bytes. Typical use:
+     * <pre>
+     *   CompositeCursor cursor(node);
+     *   while (cursor.nextItem()) {
+     *       while (cursor.next()) {
+     *           if (cursor.getType() == DataType::INT32) sum += cursor.getInt();
+     *       }
+     *   }
+     * </pre>
+     *
+     * The data must not change or go away while this object is used.
+     * This class is not thread-safe.
+     */
+    class CompositeCursor {
+
+    private:
+
+        /** State of one level of parentheses. */
+        struct Level {
+            /** Index of left parenthesis in program. */
+            uint32_t begin;
+            /** Number of times to go through contents. */
+            int64_t repeats;
+            /** Number of times contents have been gone through. */
+            int64_t done;
+        };
+
+        /** What {@link #step()} found. */
+        enum StepResult {
+            /** End of data. */
+            STEP_END = 0,
+            /** Repeat count, now the current value. */
+            STEP_COUNT,
+            /** Values of a format code. */
+            STEP_VALUES
+        };
+
+        /** Max parenthesis nesting. */
+        static const int MAX_LEVELS = 10;
+
+        /** Start of all composite items. */
+        const uint8_t *start = nullptr;
+
+        /** Past end of all composite items. */
+        const uint8_t *end = nullptr;
+
+        /** Byte order of data. */
+        ByteOrder order {ByteOrder::ENDIAN_LOCAL};
+
+        /** Does data need swapping to be read? */
+        bool needSwap = false;
+
+        /** Start of next composite item. */
+        const uint8_t *nextItemStart = nullptr;
+
+        /** Compiled format of current item. */
+        std::shared_ptr<const CompositeFormat> format;
+
+        /** Tag of current item's tagsegment. */
+        uint16_t formatTag = 0;
+
+        /** Tag of current item's bank. */
+        uint16_t dataTag = 0;
+
+        /** Num of current item's bank. */
+        uint8_t dataNum = 0;
+
+        /** Start of current item's data. */
+        const uint8_t *dataStart = nullptr;
+
+        /** Past end of current item's data, not including padding. */
+        const uint8_t *dataEnd = nullptr;
+
+        /** Next data to read. */
+        const uint8_t *pos = nullptr;
+
+        /** Value of pos when the format was last started over. */
+        const uint8_t *restartPos = nullptr;
+
+        /** Index of next operation in format's program. */
+        size_t pc = 0;
+
+        /** Parentheses being worked on. */
+        Level levels[MAX_LEVELS] {};
+
+        /** Number of levels in use. */
+        int level = 0;
+
+        /** Has the end of data been checked for since the last item? */
+        bool checked = false;
+
+        /** Number of values left from the current format code. */
+        uint64_t valuesLeft = 0;
+
+        /** Bytes in each value of the current format code. */
+        uint32_t valueWidth = 0;
+
+        /** Type of values of the current format code. */
+        const DataType * valueType = &DataType::NOT_A_VALID_TYPE;
+
+        /** Is there a current item? */
+        bool haveItem = false;
+
+        /** Have all values of the current item been read? */
+        bool finished = true;
+
+        /** Current value. */
+        const uint8_t *value = nullptr;
+
+        /** Bytes in current value. */
+        uint32_t valueBytes = 0;
+
+        /** Type of current value. */
+        const DataType * type = &DataType::NOT_A_VALID_TYPE;
+
+    public:
+
+        CompositeCursor(const uint8_t *bytes, size_t byteLen, ByteOrder const & order);
+        explicit CompositeCursor(EvioNode & node);
+        explicit CompositeCursor(BaseStructure & structure);
+
+        void reset();
+        bool nextItem();
+        bool next();
+
+        /** @return format string of current item. */
+        const std::string & getFormat() const {return format->getFormat();}
+        /** @return tag of current item's tagsegment (the format's tag). */
+        uint16_t getFormatTag()         const {return formatTag;}
+        /** @return tag of current item's data bank. */
+        uint16_t getDataTag()           const {return dataTag;}
+        /** @return num of current item's data bank. */
+        uint8_t getDataNum()            const {return dataNum;}
+        /** @return byte order of data. */
+        const ByteOrder & getByteOrder() const {return order;}
+
+        /** @return type of current value. N, n, and m counts are NVALUE, nVALUE, and mVALUE. */
+        const DataType & getType()      const {return *type;}
+        /** @return pointer to current value's bytes, as they are in the data. */
+        const uint8_t * getValueBytes() const {return value;}
+        /** @return number of bytes in current value. */
+        uint32_t getValueLength()       const {return valueBytes;}
+
+        int8_t   getChar()   const;
+        uint8_t  getUChar()  const;
+        int16_t  getShort()  const;
+        uint16_t getUShort() const;
+        int32_t  getInt()    const;
+        uint32_t getUInt()   const;
+        int64_t  getLong()   const;
+        uint64_t getULong()  const;
+        float    getFloat()  const;
+        double   getDouble() const;
+        void     getStrings(std::vector<std::string> & strings) const;
+
+    private:
+
+        void init(const uint8_t *bytes, size_t byteLen, ByteOrder const & byteOrder);
+        StepResult step();
+        int64_t readCount(uint32_t countBytes);
+        uint32_t read32(const uint8_t *p) const;
+        void checkSize(uint32_t bytes) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPOSITECURSOR_H
@@ -9,6 +9,7 @@
 
 
 #include "CompositeData.h"
+#include "CompositeFormat.h"
 
 
 namespace evio {
@@ -52,7 +53,7 @@ namespace evio {
         }
 
         // Analyze format string
-        compositeFormatToInt(format, formatInts);
+        formatInts = CompositeFormat::get(format)->getCodes();
         if (formatInts.empty()) {
             throw EvioException("format string is empty");
         }
@@ -98,14 +99,9 @@ namespace evio {
         // Copy tag segment header (4 bytes) to rawBytes
         tsHeader->write(rawBytes.data(), byteOrder);
 
-        // Change tag seg data (format string) into evio format
-        std::vector<uint8_t> bytes;
-        size_t tsBytes = 4*(tsHeader->getLength());
-        bytes.reserve(tsBytes);
-        Util::stringsToRawBytes(strings, bytes);
-
-        // Copy tag segment data to rawBytes vector (char data doesn't need swapping)
-        std::memcpy(rawBytes.data() + 4, bytes.data(), tsBytes);
+        // Change tag seg data (format string) into evio format, straight into
+        // rawBytes vector (char data doesn't need swapping)
+        uint32_t tsBytes = Util::stringsToRawBytes(strings, rawBytes.data() + 4);
 
         // Write bank header to buffer
         bHeader->write(rawBytes.data() + 4 + tsBytes, byteOrder);
@@ -164,8 +160,7 @@ namespace evio {
         }
 
         // Transform string format into int array format
-        std::vector<uint16_t> fmtInts;
-        CompositeData::compositeFormatToInt(format, formatInts);
+        formatInts = CompositeFormat::get(format)->getCodes();
         if (formatInts.empty()) {
             throw EvioException("bad format string data");
         }
@@ -358,7 +353,7 @@ namespace evio {
             }
 
             // Chew on format string & spit out array of ints
-            CompositeData::compositeFormatToInt(cd->format, cd->formatInts);
+            cd->formatInts = CompositeFormat::get(cd->format)->getCodes();
             if (cd->formatInts.empty()) {
                 throw EvioException("bad format string data");
             }
@@ -474,10 +469,9 @@ namespace evio {
      */
     std::string CompositeData::stringsToFormat(std::vector<std::string> strings) {
 
-        std::vector<uint8_t> bytes;
-        Util::stringsToRawBytes(strings, bytes);
-        if (!bytes.empty()) {
-            return std::to_string(bytes.size()) + "a";
+        uint32_t bytes = Util::stringsToRawSize(strings);
+        if (bytes > 0) {
+            return std::to_string(bytes) + "a";
         }
 
         return "";
@@ -1075,8 +1069,8 @@ namespace evio {
             }
             std::string fmt = strs[0];
 
-            std::vector<uint16_t> fmtInts;
-            CompositeData::compositeFormatToInt(fmt, fmtInts);
+            auto compiled = CompositeFormat::get(fmt);
+            auto & fmtInts = compiled->getCodes();
             if (fmtInts.empty()) {
                 throw EvioException("bad format string data");
             }
@@ -1112,10 +1106,13 @@ namespace evio {
             destOff += 4*headerLen;
             dataOff += 4*headerLen;
 
-            // Swap data
-            CompositeData::swapData(reinterpret_cast<int32_t *>(src + srcOff),
-                                    reinterpret_cast<int32_t *>(dest + destOff),
-                                    dataLength, fmtInts, padding, srcIsLocal);
+            // Swap data, with the compiled format if possible
+            if (dataLength < 2 ||
+                !compiled->swap(src + srcOff, dest + destOff, 4*dataLength - padding, srcIsLocal)) {
+                CompositeData::swapData(reinterpret_cast<int32_t *>(src + srcOff),
+                                        reinterpret_cast<int32_t *>(dest + destOff),
+                                        dataLength, fmtInts, padding, srcIsLocal);
+            }
 
             // Adjust data length by switching units from
             // ints to bytes and accounting for padding.
@@ -1268,8 +1265,8 @@ namespace evio {
             std::string fmt = strs[0];
 
             // Transform string format into int array format
-            std::vector<uint16_t> fmtInts;
-            CompositeData::compositeFormatToInt(fmt, fmtInts);
+            auto compiled = CompositeFormat::get(fmt);
+            auto & fmtInts = compiled->getCodes();
             if (fmtInts.empty()) {
                 throw EvioException("bad format string data");
             }
@@ -1301,8 +1298,18 @@ namespace evio {
             // Bank data length in bytes
             byteLen = 4*node.getDataLength();
 
-            // Swap data (accounting for padding)
-            CompositeData::swapData(srcBuffer, destBuffer, srcPos, destPos, (byteLen - node.getPad()), fmtInts);
+            // Swap data (accounting for padding), with the compiled format if possible.
+            // Leave swapping within one buffer, which also changes its byte order, to swapData.
+            uint32_t dataBytes = byteLen - node.getPad();
+            uint8_t *srcData  = srcBuffer.array() + srcBuffer.arrayOffset() + srcPos;
+            uint8_t *destData = destBuffer.array() + destBuffer.arrayOffset() + destPos;
+            bool separate = (destData + dataBytes <= srcData) || (srcData + dataBytes <= destData);
+
+            if (!separate || dataBytes < 8 ||
+                srcBuffer.limit() < srcPos + dataBytes || destBuffer.limit() < destPos + dataBytes ||
+                !compiled->swap(srcData, destData, dataBytes, srcBuffer.order().isLocalEndian())) {
+                CompositeData::swapData(srcBuffer, destBuffer, srcPos, destPos, dataBytes, fmtInts);
+            }
 
             // Move past bank data
             srcPos    += byteLen;
@@ -2050,10 +2057,12 @@ namespace evio {
                     b64end = reinterpret_cast<int64_t *>(b8end);
                 }
 
-                while (b64 < b64end) {
-                    *b64dest = SWAP_64(*b64);
-                    b64++;
-                    b64dest++;
+                if (b64 < b64end) {
+                    size_t count = b64end - b64;
+                    ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(b64), count,
+                                          reinterpret_cast<uint64_t *>(b64dest));
+                    b64     += count;
+                    b64dest += count;
                 }
 
                 b8     = reinterpret_cast<int8_t *>(b64);
@@ -2073,10 +2082,12 @@ namespace evio {
                     b32end = reinterpret_cast<int32_t *>(b8end);
                 }
 
-                while (b32 < b32end) {
-                    *b32dest = SWAP_32(*b32);
-                    b32++;
-                    b32dest++;
+                if (b32 < b32end) {
+                    size_t count = b32end - b32;
+                    ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(b32), count,
+                                          reinterpret_cast<uint32_t *>(b32dest));
+                    b32     += count;
+                    b32dest += count;
                 }
 
                 b8     = reinterpret_cast<int8_t *>(b32);
@@ -2096,10 +2107,12 @@ namespace evio {
                     b16end = reinterpret_cast<int16_t *>(b8end);
                 }
 
-                while (b16 < b16end) {
-                    *b16dest = SWAP_16(*b16);
-                    b16++;
-                    b16dest++;
+                if (b16 < b16end) {
+                    size_t count = b16end - b16;
+                    ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(b16), count,
+                                          reinterpret_cast<uint16_t *>(b16dest));
+                    b16     += count;
+                    b16dest += count;
                 }
 
                 b8     = reinterpret_cast<int8_t *>(b16);
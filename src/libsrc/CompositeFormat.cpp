@@ -0,0 +1,420 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompositeFormat.h"
+
+
+#include <cstring>
+#include <limits>
+
+#include "ByteOrder.h"
+#include "CompositeData.h"
+
+
+namespace evio {
+
+
+    std::unordered_map<std::string, std::shared_ptr<const CompositeFormat>> CompositeFormat::cache;
+    std::mutex CompositeFormat::cacheMutex;
+    std::atomic_bool CompositeFormat::useProgram {true};
+
+    /** Max parenthesis nesting handled by the format interpreters. */
+    static const size_t MAX_LEVELS = 10;
+
+
+    /**
+     * Constructor which transforms the format string into codes and compiles them.
+     * Use {@link #get(const std::string &)} instead to avoid doing this repeatedly.
+     * @param fmt composite data format string.
+     */
+    CompositeFormat::CompositeFormat(const std::string & fmt) : format(fmt) {
+        status = CompositeData::compositeFormatToInt(format, codes);
+        compile();
+    }
+
+
+    /**
+     * Get the compiled form of a format string. The first time a format is seen it's
+     * compiled and cached; afterwards the cached object is returned. Thread-safe.
+     * @param format composite data format string.
+     * @return compiled format.
+     */
+    std::shared_ptr<const CompositeFormat> CompositeFormat::get(const std::string & format) {
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            auto it = cache.find(format);
+            if (it != cache.end()) {
+                return it->second;
+            }
+        }
+
+        // Compile outside the lock, it's fine if 2 threads happen to do it at once
+        auto compiled = std::make_shared<const CompositeFormat>(format);
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        // Don't let a stream of ever-changing formats use up memory
+        if (cache.size() < MAX_CACHED) {
+            auto result = cache.emplace(format, compiled);
+            return result.first->second;
+        }
+        return compiled;
+    }
+
+
+    /** Remove all compiled formats from the cache. */
+    void CompositeFormat::clearCache() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.clear();
+    }
+
+
+    /**
+     * Get the number of compiled formats in the cache.
+     * @return number of compiled formats in the cache.
+     */
+    size_t CompositeFormat::cacheSize() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return cache.size();
+    }
+
+
+    /**
+     * Set whether data is swapped with compiled programs, when available,
+     * or always with the original interpreter. Used to compare the two.
+     * @param use true (default) to swap with compiled programs.
+     */
+    void CompositeFormat::setCompiledSwap(bool use) {useProgram = use;}
+
+
+    /**
+     * Is data swapped with compiled programs when available?
+     * @return true if data is swapped with compiled programs when available.
+     */
+    bool CompositeFormat::getCompiledSwap() {return useProgram;}
+
+
+    /**
+     * Turn the format codes into a program of pre-decoded operations.
+     * The program does exactly what the interpreter in
+     * {@link CompositeData#swapData(int32_t *, int32_t *, size_t, const std::vector<uint16_t> &, uint32_t, bool)}
+     * does. Improper formats are left uncompiled. The few odd cases the interpreter
+     * handles by accident are compiled for reading but left to it for swapping.
+     */
+    void CompositeFormat::compile() {
+        if (status <= 0 || codes.empty()) return;
+
+        size_t nfmt = codes.size();
+        bool canSwap = true;
+        std::vector<Op> ops;
+        ops.reserve(nfmt);
+        std::vector<uint32_t> open;
+
+        for (size_t i=0; i < nfmt; i++) {
+            uint16_t code = codes[i];
+            uint32_t ncnf = (code >> 8) & 0x3F;   // how many times to repeat format code
+            uint32_t kcnf =  code & 0xFF;         // format code
+            uint32_t mcnf = (code >> 14) & 0x3;   // repeat code
+
+            // Bytes holding count in data for N, n, m
+            static const uint32_t countSizes[] = {0, 4, 2, 1};
+
+            Op op;
+
+            // Right parenthesis
+            if (code == 0) {
+                if (open.empty()) return;
+                op.type  = GROUP_END;
+                op.match = open.back();
+                ops[open.back()].match = i;
+                open.pop_back();
+            }
+            // Left parenthesis, its repeat count is always read from data if mcnf is set
+            else if (kcnf == 0) {
+                op.type = GROUP_BEGIN;
+                op.count = ncnf;
+                op.countBytes = countSizes[mcnf];
+                open.push_back(i);
+                if (open.size() > MAX_LEVELS) return;
+            }
+            else {
+                op.type = ITEM;
+                op.code = kcnf;
+                if (kcnf == 8 || kcnf == 9 || kcnf == 10) {
+                    op.width = 8;
+                }
+                else if (kcnf == 1 || kcnf == 2 || kcnf == 11 || kcnf == 12) {
+                    op.width = 4;
+                }
+                else if (kcnf == 4 || kcnf == 5) {
+                    op.width = 2;
+                }
+                else if (kcnf == 6 || kcnf == 7 || kcnf == 3) {
+                    op.width = 1;
+                }
+                else {
+                    return;
+                }
+
+                op.count = ncnf;
+                // Repeat code may linger from an earlier N, used only if no count is given
+                if (ncnf == 0) {
+                    op.countBytes = countSizes[mcnf];
+                }
+
+                // A single format in the last parenthesis repeats to the end
+                op.toEnd = (i == nfmt - 2) && (i > 0) && (codes[i-1] != 0) && ((codes[i-1] & 0xFF) == 0);
+
+                // Swap interpreter copies chars past the end of data in this case
+                if (op.toEnd && op.width == 1) canSwap = false;
+            }
+
+            ops.push_back(op);
+        }
+
+        if (!open.empty()) return;
+
+        // Find groups which are only fixed numbers of items of one size
+        for (size_t i=0; i < ops.size(); i++) {
+            if (ops[i].type != GROUP_BEGIN) continue;
+
+            uint32_t width = 0, items = 0;
+            bool uniform = true;
+            for (size_t j = i+1; j < ops[i].match; j++) {
+                const Op & op = ops[j];
+                if (op.type != ITEM || op.countBytes > 0 || op.toEnd ||
+                    (width > 0 && op.width != width)) {
+                    uniform = false;
+                    break;
+                }
+                width = op.width;
+                items += op.count;
+            }
+
+            if (uniform && items > 0) {
+                ops[i].width = width;
+                ops[i].groupItems = items;
+            }
+        }
+
+        // Is the whole format made of fixed numbers of items of one size?
+        uint32_t width = 0;
+        for (const Op & op : ops) {
+            if (op.type != ITEM || op.countBytes > 0 || (width > 0 && op.width != width)) {
+                width = 0;
+                break;
+            }
+            width = op.width;
+        }
+        uniformWidth = width;
+
+        program = std::move(ops);
+        swappable = canSwap;
+    }
+
+
+    /**
+     * Swap composite data (not including tagsegment, format string, or bank header)
+     * using the compiled program.
+     *
+     * @param src        data to swap.
+     * @param dest       where to put swapped data, may be src or null to swap in place.
+     *                   Otherwise it must not overlap src.
+     * @param bytes      number of data bytes, not including padding.
+     * @param srcIsLocal true if src is local endian, else false.
+     * @return true if swapped, false if this format cannot be swapped this way or compiled
+     *         swapping is turned off, in which case the interpreter must be used.
+     */
+    bool CompositeFormat::swap(const uint8_t *src, uint8_t *dest, size_t bytes, bool srcIsLocal) const {
+        if (!swappable || !useProgram) return false;
+
+        Cursor c;
+        c.src = src;
+        c.dest = (dest == nullptr) ? const_cast<uint8_t *>(src) : dest;
+        c.end = src + bytes;
+        c.srcIsLocal = srcIsLocal;
+        c.inPlace = (c.dest == src);
+        c.checked = false;
+        c.done = false;
+        c.lastSrc = src;
+
+        // Like "i" or "2F,I": all data are one size, so swap it all at once
+        if (uniformWidth > 0) {
+            swapItems(c, uniformWidth, std::numeric_limits<uint64_t>::max());
+            return true;
+        }
+
+        // Once the end of the format is reached, start again from its beginning
+        while (run(0, program.size(), c) && progressed(c)) {}
+        return true;
+    }
+
+
+    /**
+     * Did the last pass through (part of) the program use up any data? If not, the data
+     * does not fit the format and what's left of it is smaller than the next item.
+     * The interpreter would never finish, just stop here.
+     * @param c where data is being swapped.
+     * @return true if data was used up since the last call.
+     */
+    bool CompositeFormat::progressed(Cursor & c) {
+        if (c.src == c.lastSrc) {
+            c.done = true;
+            return false;
+        }
+        c.lastSrc = c.src;
+        return true;
+    }
+
+
+    /**
+     * Before working on the next item of data, see if the end of data was reached.
+     * As in the interpreter, this is done only once between items, no matter
+     * how many parentheses come in between.
+     * @param c where data is being swapped.
+     * @return false if the end of data was reached.
+     */
+    bool CompositeFormat::startStep(Cursor & c) const {
+        if (!c.checked) {
+            if (c.src >= c.end) {
+                c.done = true;
+                return false;
+            }
+            c.checked = true;
+        }
+        return true;
+    }
+
+
+    /**
+     * Run the operations of the compiled program in [first, last) once.
+     * @param first index of first operation.
+     * @param last  index past last operation.
+     * @param c     where data is being swapped.
+     * @return false if the end of data was reached.
+     */
+    bool CompositeFormat::run(size_t first, size_t last, Cursor & c) const {
+
+        for (size_t i = first; i < last; i++) {
+            const Op & op = program[i];
+
+            if (op.type == ITEM) {
+                if (!startStep(c)) return false;
+
+                uint64_t count = op.count;
+                if (op.toEnd) {
+                    count = std::numeric_limits<uint64_t>::max();
+                }
+                else if (op.countBytes > 0) {
+                    int64_t n = readCount(c, op.countBytes);
+                    count = n < 0 ? 0 : n;
+                }
+
+                swapItems(c, op.width, count);
+                c.checked = false;
+            }
+            else if (op.type == GROUP_BEGIN) {
+                if (!startStep(c)) return false;
+
+                int64_t repeats = op.count;
+                if (op.countBytes > 0) {
+                    repeats = readCount(c, op.countBytes);
+                }
+                // Parenthesis contents are always done at least once
+                if (repeats < 1) repeats = 1;
+
+                if (op.groupItems > 0) {
+                    swapItems(c, op.width, repeats * op.groupItems);
+                    c.checked = false;
+                }
+                else {
+                    for (int64_t r=0; r < repeats; r++) {
+                        if (!run(i+1, op.match, c) || !progressed(c)) return false;
+                    }
+                }
+
+                // Continue after the right parenthesis
+                i = op.match;
+            }
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Read a repeat count from data, writing it swapped to the destination.
+     * @param c          where data is being swapped.
+     * @param countBytes number of bytes holding the count, 4, 2, or 1.
+     * @return count.
+     */
+    int64_t CompositeFormat::readCount(Cursor & c, uint32_t countBytes) {
+        int64_t count;
+
+        if (countBytes == 4) {
+            uint32_t val;
+            std::memcpy(&val, c.src, 4);
+            uint32_t swapped = SWAP_32(val);
+            std::memcpy(c.dest, &swapped, 4);
+            count = static_cast<int32_t>(c.srcIsLocal ? val : swapped);
+        }
+        else if (countBytes == 2) {
+            uint16_t val;
+            std::memcpy(&val, c.src, 2);
+            uint16_t swapped = SWAP_16(val);
+            std::memcpy(c.dest, &swapped, 2);
+            count = c.srcIsLocal ? val : swapped;
+        }
+        else {
+            *c.dest = *c.src;
+            count = *c.src;
+        }
+
+        c.src  += countBytes;
+        c.dest += countBytes;
+        return count;
+    }
+
+
+    /**
+     * Swap a number of items of the same size, but not past the end of data.
+     * As in the interpreter, running into the end of data does not stop things
+     * since the data may not have been a multiple of the item size.
+     * @param c     where data is being swapped.
+     * @param width bytes in each item.
+     * @param count number of items.
+     */
+    void CompositeFormat::swapItems(Cursor & c, uint32_t width, uint64_t count) {
+        uint64_t left = (c.src < c.end) ? (c.end - c.src) / width : 0;
+        if (count > left) {
+            count = left;
+        }
+
+        auto src = const_cast<uint8_t *>(c.src);
+        if (width == 8) {
+            ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(src), count,
+                                  reinterpret_cast<uint64_t *>(c.dest));
+        }
+        else if (width == 4) {
+            ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(src), count,
+                                  reinterpret_cast<uint32_t *>(c.dest));
+        }
+        else if (width == 2) {
+            ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(src), count,
+                                  reinterpret_cast<uint16_t *>(c.dest));
+        }
+        else if (!c.inPlace && count > 0) {
+            std::memcpy(c.dest, c.src, count);
+        }
+
+        c.src  += width*count;
+        c.dest += width*count;
+    }
+
+}
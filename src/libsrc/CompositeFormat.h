@@ -0,0 +1,161 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPOSITEFORMAT_H
+#define EVIO_6_0_COMPOSITEFORMAT_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+
+namespace evio {
+
+
+    /**
+     * This class holds a composite data format string compiled once and for all.
+     * It contains the format codes produced by
+     * {@link CompositeData#compositeFormatToInt(const std::string &, std::vector<uint16_t> &)},
+     * and, for well-formed formats, a program of pre-decoded items and groups used to swap
+     * data without interpreting each code anew for every item. The same program is walked by
+     * {@link CompositeCursor} to read data. Groups containing nothing
+     * but a fixed number of items of the same size, such as "N(I,2F)", are swapped in
+     * one call for all their repeats.<p>
+     *
+     * Objects are obtained through {@link #get(const std::string &)}, which keeps them
+     * in a global, thread-safe cache so a format is only compiled the first time it's seen.
+     * Objects are immutable and may be used by any number of threads at once.
+     */
+    class CompositeFormat {
+
+        friend class CompositeCursor;
+        friend class CompositeBatchDecoder;
+
+    private:
+
+        /** Kinds of operations in a compiled program. */
+        enum OpType {
+            /** One format code: items of a single type. */
+            ITEM = 0,
+            /** Left parenthesis. */
+            GROUP_BEGIN,
+            /** Right parenthesis. */
+            GROUP_END
+        };
+
+        /** One pre-decoded operation of a compiled program. */
+        struct Op {
+            /** Kind of operation. */
+            OpType type = ITEM;
+            /** For items, format code (data type), as in CompositeData's codes. */
+            uint32_t code = 0;
+            /** Bytes in each item, 1, 2, 4, or 8. For groups, size of all items if uniform, else 0. */
+            uint32_t width = 0;
+            /** Number of items or group repeats, unless taken from data. */
+            uint32_t count = 0;
+            /** If > 0, number of bytes (1, 2, or 4) in data holding the count. */
+            uint32_t countBytes = 0;
+            /** For groups, index of matching GROUP_END or GROUP_BEGIN. */
+            uint32_t match = 0;
+            /** Item repeated until the end of the data (last format in parenthesis). */
+            bool toEnd = false;
+            /** For uniform groups, number of items swapped for each repeat. */
+            uint32_t groupItems = 0;
+        };
+
+        /** Where data is being swapped from and to. */
+        struct Cursor {
+            const uint8_t *src;
+            uint8_t *dest;
+            const uint8_t *end;
+            bool srcIsLocal;
+            bool inPlace;
+            /** Has the end of data been checked for since the last item? */
+            bool checked;
+            /** Has the end of data been reached? */
+            bool done;
+            /** Value of src when last checked for progress. */
+            const uint8_t *lastSrc;
+        };
+
+        /** Max number of formats kept in the cache. */
+        static const size_t MAX_CACHED = 4096;
+
+        /** Format string. */
+        std::string format;
+
+        /** Format codes. */
+        std::vector<uint16_t> codes;
+
+        /** Return value of compositeFormatToInt, negative if the format is improper. */
+        int status = 0;
+
+        /** Compiled program, empty if format cannot be handled. */
+        std::vector<Op> program;
+
+        /** Can data be swapped with the compiled program? */
+        bool swappable = false;
+
+        /** If > 0, the whole format is made of items of this size, repeated to the end of data. */
+        uint32_t uniformWidth = 0;
+
+        /** Cache of compiled formats. */
+        static std::unordered_map<std::string, std::shared_ptr<const CompositeFormat>> cache;
+
+        /** Guards cache. */
+        static std::mutex cacheMutex;
+
+        /** Swap using the compiled program when there is one? */
+        static std::atomic_bool useProgram;
+
+    public:
+
+        explicit CompositeFormat(const std::string & format);
+
+        static std::shared_ptr<const CompositeFormat> get(const std::string & format);
+        static void clearCache();
+        static size_t cacheSize();
+
+        static void setCompiledSwap(bool use);
+        static bool getCompiledSwap();
+
+        /** @return format string. */
+        const std::string & getFormat()         const {return format;}
+        /** @return format codes as produced by CompositeData::compositeFormatToInt. */
+        const std::vector<uint16_t> & getCodes() const {return codes;}
+        /** @return return value of CompositeData::compositeFormatToInt, negative if format is improper. */
+        int getStatus()                          const {return status;}
+        /** @return true if this format has been compiled into a program. */
+        bool isCompiled()                        const {return !program.empty();}
+        /** @return true if data of this format can be swapped with the compiled program. */
+        bool isSwappable()                       const {return swappable;}
+
+        bool swap(const uint8_t *src, uint8_t *dest, size_t bytes, bool srcIsLocal) const;
+
+    private:
+
+        void compile();
+        bool run(size_t first, size_t last, Cursor & c) const;
+        bool startStep(Cursor & c) const;
+        static bool progressed(Cursor & c);
+        static int64_t readCount(Cursor & c, uint32_t countBytes);
+        static void swapItems(Cursor & c, uint32_t width, uint64_t count);
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPOSITEFORMAT_H
@@ -0,0 +1,340 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPOSITEPROGRAM_H
+#define EVIO_6_0_COMPOSITEPROGRAM_H
+
+
+#include <cstdint>
+#include <cstring>
+
+
+// Functions here are compiled for both the host and, by nvcc, a CUDA device
+#ifdef __CUDACC__
+    #define EVIO_HOST_DEVICE __host__ __device__
+#else
+    #define EVIO_HOST_DEVICE
+#endif
+
+
+namespace evio {
+
+
+    /**
+     * Plain copy of one operation of a {@link CompositeFormat}'s compiled program,
+     * which can be handed to a GPU. Operations of all the formats in a batch are kept
+     * one after another in a single array.
+     */
+    struct CompositeProgramOp {
+        /** 0 for an item, 1 for a left parenthesis, 2 for a right one (CompositeFormat::OpType). */
+        uint32_t type;
+        /** For items, format code (data type). */
+        uint32_t code;
+        /** Bytes in each item, 1, 2, 4, or 8. */
+        uint32_t width;
+        /** Number of items or group repeats, unless taken from data. */
+        uint32_t count;
+        /** If > 0, number of bytes (1, 2, or 4) in data holding the count. */
+        uint32_t countBytes;
+        /** For groups, index of matching parenthesis, counted from the start of its format. */
+        uint32_t match;
+        /** Non-zero if item repeats until the end of the data. */
+        uint32_t toEnd;
+    };
+
+
+    /**
+     * One bank whose values go into one column of a batch. A bank of composite data
+     * holding several composite items has one of these for each item.
+     */
+    struct CompositeBatchItem {
+        /** Offset of data from the start of the record's events. */
+        uint64_t dataOffset;
+        /** Bytes of data, not including padding. */
+        uint32_t dataBytes;
+        /** Index of format's first operation in the program array. */
+        uint32_t programStart;
+        /** Number of operations in format, 0 if bank holds the column's type directly. */
+        uint32_t programLength;
+        /** Index of column. */
+        uint32_t column;
+    };
+
+
+    /** What one column of a batch is made of. */
+    struct CompositeBatchColumn {
+        /** Data type of values, as a DataType value. */
+        uint32_t type;
+        /** Bytes in each value. */
+        uint32_t valueBytes;
+    };
+
+
+    /** One column of a batch left in GPU memory, laid out as a columnar exporter's column. */
+    struct CompositeDeviceColumn {
+        /** Values of all rows, local endian, in device memory. */
+        uint8_t *values;
+        /** Index of each row's first value, plus one past the last row's (rows + 1 entries), in device memory. */
+        int32_t *offsets;
+        /** Number of bytes of values. */
+        uint64_t valueBytes;
+    };
+
+
+    /** Max parenthesis nesting, as in CompositeCursor. */
+    static const int COMPOSITE_MAX_LEVELS = 10;
+
+    /** DataType values of what composite data holds besides its format codes. */
+    static const uint32_t COMPOSITE_CHARSTAR8 = 0x3;
+    static const uint32_t COMPOSITE_HOLLERIT  = 0x21;
+    static const uint32_t COMPOSITE_NVALUE    = 0x22;
+    static const uint32_t COMPOSITE_nVALUE    = 0x23;
+    static const uint32_t COMPOSITE_mVALUE    = 0x24;
+
+
+    /**
+     * Read a repeat count, 4, 2, or 1 bytes, from composite data.
+     * @param p          pointer to count.
+     * @param countBytes number of bytes holding count.
+     * @param swap       true if count must be swapped.
+     * @return count.
+     */
+    EVIO_HOST_DEVICE inline int64_t compositeReadCount(const uint8_t *p, uint32_t countBytes, bool swap) {
+        if (countBytes == 4) {
+            uint32_t val;
+            memcpy(&val, p, 4);
+            if (swap) val = (val >> 24) | ((val >> 8) & 0xff00) | ((val << 8) & 0xff0000) | (val << 24);
+            return (int32_t)val;
+        }
+        if (countBytes == 2) {
+            uint16_t val;
+            memcpy(&val, p, 2);
+            if (swap) val = (uint16_t)((val >> 8) | (val << 8));
+            return val;
+        }
+        return *p;
+    }
+
+
+    /**
+     * Walk the data of one composite item following its compiled format, in exactly the
+     * same way as {@link CompositeCursor#next()}, and hand out what's found.
+     * Repeat counts taken from data are values of type NVALUE, nVALUE, or mVALUE.
+     * Consecutive values of one format code are handed out together, a string as one value.
+     *
+     * @param program first operation of format.
+     * @param length  number of operations.
+     * @param data    start of item's data.
+     * @param dataEnd past end of item's data, not including padding.
+     * @param swap    true if data is not local endian.
+     * @param emit    called as emit(type, pointer, bytes) for each run of values.
+     */
+    template<typename Emit>
+    EVIO_HOST_DEVICE inline void walkCompositeItem(const CompositeProgramOp *program, uint32_t length,
+                                                   const uint8_t *data, const uint8_t *dataEnd,
+                                                   bool swap, Emit & emit) {
+        struct Level {
+            uint32_t begin;
+            int64_t repeats;
+            int64_t done;
+        };
+
+        Level levels[COMPOSITE_MAX_LEVELS];
+        int level = 0;
+        const uint8_t *pos = data;
+        const uint8_t *restartPos = nullptr;
+        uint32_t pc = 0;
+        bool checked = false;
+
+        while (true) {
+            // End of format reached, start it over, unless nothing was read since last time
+            if (pc == length) {
+                if (pos == restartPos) return;
+                restartPos = pos;
+                pc = 0;
+            }
+
+            const CompositeProgramOp & op = program[pc];
+
+            if (op.type == 2) {
+                Level & lv = levels[level-1];
+                if (++lv.done >= lv.repeats) {
+                    level--;
+                    pc++;
+                }
+                else {
+                    pc = lv.begin + 1;
+                }
+                continue;
+            }
+
+            // Check for the end of data once between format codes
+            if (!checked) {
+                if (pos >= dataEnd) return;
+                checked = true;
+            }
+
+            uint32_t countType = op.countBytes == 4 ? COMPOSITE_NVALUE :
+                                 op.countBytes == 2 ? COMPOSITE_nVALUE : COMPOSITE_mVALUE;
+
+            if (op.type == 1) {
+                int64_t repeats = op.count;
+                if (op.countBytes > 0) {
+                    if (pos + op.countBytes > dataEnd) return;
+                    repeats = compositeReadCount(pos, op.countBytes, swap);
+                    emit(countType, pos, (uint64_t)op.countBytes);
+                    pos += op.countBytes;
+                }
+                if (level == COMPOSITE_MAX_LEVELS) return;
+
+                // Parenthesis contents are always done at least once
+                levels[level].begin = pc;
+                levels[level].repeats = repeats < 1 ? 1 : repeats;
+                levels[level].done = 0;
+                level++;
+                pc++;
+                continue;
+            }
+
+            // Format code for data
+            pc++;
+            uint64_t count = op.count;
+            if (op.toEnd) {
+                count = UINT64_MAX;
+            }
+            else if (op.countBytes > 0) {
+                if (pos + op.countBytes > dataEnd) return;
+                int64_t n = compositeReadCount(pos, op.countBytes, swap);
+                emit(countType, pos, (uint64_t)op.countBytes);
+                pos += op.countBytes;
+                count = n < 0 ? 0 : n;
+            }
+
+            if (op.code == 3) {
+                // All chars of a string format are one value
+                uint64_t left = dataEnd - pos;
+                uint64_t bytes = count > left ? left : count;
+                emit(COMPOSITE_CHARSTAR8, pos, bytes);
+                pos += bytes;
+            }
+            else {
+                uint64_t avail = (dataEnd - pos) / op.width;
+                uint64_t items = count > avail ? avail : count;
+                if (items > 0) {
+                    emit(op.code == 12 ? COMPOSITE_HOLLERIT : op.code, pos, items * op.width);
+                }
+                pos += items * op.width;
+                // Ran into the end of data
+                if (items < count) return;
+            }
+            checked = false;
+        }
+    }
+
+
+    /**
+     * Copy values to a column, swapping each one if necessary.
+     * @param dest  where to copy to.
+     * @param src   values.
+     * @param bytes number of bytes.
+     * @param size  bytes in each value.
+     * @param swap  true if values must be swapped.
+     */
+    EVIO_HOST_DEVICE inline void compositeCopyValues(uint8_t *dest, const uint8_t *src, uint64_t bytes,
+                                                     uint32_t size, bool swap) {
+        if (!swap || size < 2) {
+            for (uint64_t i=0; i < bytes; i++) dest[i] = src[i];
+            return;
+        }
+        uint64_t whole = bytes - bytes % size;
+        for (uint64_t i=0; i < whole; i += size) {
+            for (uint32_t j=0; j < size; j++) dest[i + j] = src[i + size - 1 - j];
+        }
+        for (uint64_t i = whole; i < bytes; i++) dest[i] = src[i];
+    }
+
+
+    /** Adds up the bytes of the values of one type. */
+    struct CompositeCountEmitter {
+        uint32_t type;
+        uint64_t bytes;
+
+        EVIO_HOST_DEVICE void operator()(uint32_t t, const uint8_t *, uint64_t n) {
+            if (t == type) bytes += n;
+        }
+    };
+
+
+    /** Copies the values of one type into a column. */
+    struct CompositeCopyEmitter {
+        uint32_t type;
+        uint32_t valueBytes;
+        bool swap;
+        uint8_t *dest;
+
+        EVIO_HOST_DEVICE void operator()(uint32_t t, const uint8_t *p, uint64_t n) {
+            if (t != type) return;
+            compositeCopyValues(dest, p, n, valueBytes, swap);
+            dest += n;
+        }
+    };
+
+
+    /**
+     * Get the number of bytes an item adds to its column.
+     * @param item    item.
+     * @param program all operations of the batch.
+     * @param events  start of record's events.
+     * @param column  item's column.
+     * @param swap    true if data is not local endian.
+     * @return number of bytes.
+     */
+    EVIO_HOST_DEVICE inline uint64_t compositeItemBytes(const CompositeBatchItem & item,
+                                                        const CompositeProgramOp *program,
+                                                        const uint8_t *events,
+                                                        const CompositeBatchColumn & column, bool swap) {
+        if (item.programLength == 0) {
+            return item.dataBytes - item.dataBytes % column.valueBytes;
+        }
+        const uint8_t *data = events + item.dataOffset;
+        CompositeCountEmitter emit {column.type, 0};
+        walkCompositeItem(program + item.programStart, item.programLength, data, data + item.dataBytes, swap, emit);
+        return emit.bytes;
+    }
+
+
+    /**
+     * Copy the values of an item into its column.
+     * @param item    item.
+     * @param program all operations of the batch.
+     * @param events  start of record's events.
+     * @param column  item's column.
+     * @param swap    true if data is not local endian.
+     * @param dest    where in the column to put the values.
+     */
+    EVIO_HOST_DEVICE inline void compositeItemCopy(const CompositeBatchItem & item,
+                                                   const CompositeProgramOp *program,
+                                                   const uint8_t *events,
+                                                   const CompositeBatchColumn & column, bool swap,
+                                                   uint8_t *dest) {
+        const uint8_t *data = events + item.dataOffset;
+        if (item.programLength == 0) {
+            compositeCopyValues(dest, data, item.dataBytes - item.dataBytes % column.valueBytes,
+                                column.valueBytes, swap);
+            return;
+        }
+        CompositeCopyEmitter emit {column.type, column.valueBytes, swap, dest};
+        walkCompositeItem(program + item.programStart, item.programLength, data, data + item.dataBytes, swap, emit);
+    }
+
+}
+
+
+#endif //EVIO_6_0_COMPOSITEPROGRAM_H
@@ -0,0 +1,143 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompressionDictionary.h"
+#include "Compressor.h"
+
+
+#include <cstring>
+
+
+namespace evio {
+
+
+    const uint32_t CompressionDictionary::MAGIC;
+
+
+    /**
+     * Constructor.
+     * If compiled with USE_ZSTD, the dictionary is digested here for zstd compression,
+     * at {@link Compressor#getZstdLevel()}, and for zstd decompression.
+     *
+     * @param dictionary dictionary bytes.
+     * @throws EvioException if dictionary is empty, or zstd fails to digest it.
+     */
+    CompressionDictionary::CompressionDictionary(std::vector<uint8_t> dictionary) :
+            bytes(std::move(dictionary)) {
+
+        if (bytes.empty()) {
+            throw EvioException("compression dictionary is empty");
+        }
+
+#ifdef USE_ZSTD
+        cdict = ZSTD_createCDict(bytes.data(), bytes.size(), Compressor::getZstdLevel());
+        ddict = ZSTD_createDDict(bytes.data(), bytes.size());
+        if (cdict == nullptr || ddict == nullptr) {
+            if (cdict != nullptr) ZSTD_freeCDict(cdict);
+            if (ddict != nullptr) ZSTD_freeDDict(ddict);
+            throw EvioException("cannot create zstd dictionary");
+        }
+#endif
+    }
+
+
+    /** Destructor. */
+    CompressionDictionary::~CompressionDictionary() {
+#ifdef USE_ZSTD
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+#endif
+    }
+
+
+    /**
+     * Get the dictionary bytes.
+     * @return pointer to dictionary bytes.
+     */
+    const uint8_t * CompressionDictionary::getData() const {return bytes.data();}
+
+
+    /**
+     * Get the number of dictionary bytes.
+     * @return number of dictionary bytes.
+     */
+    size_t CompressionDictionary::getSize() const {return bytes.size();}
+
+
+    /**
+     * Get the dictionary bytes.
+     * @return dictionary bytes.
+     */
+    std::vector<uint8_t> const & CompressionDictionary::getBytes() const {return bytes;}
+
+
+#ifdef USE_ZSTD
+
+    /**
+     * Get zstd's digested form of the dictionary for compression.
+     * It may be used by several threads at once.
+     * @return zstd's digested form of the dictionary for compression.
+     */
+    ZSTD_CDict * CompressionDictionary::getZstdCDict() const {return cdict;}
+
+
+    /**
+     * Get zstd's digested form of the dictionary for decompression.
+     * It may be used by several threads at once.
+     * @return zstd's digested form of the dictionary for decompression.
+     */
+    ZSTD_DDict * CompressionDictionary::getZstdDDict() const {return ddict;}
+
+#endif
+
+
+    /**
+     * Get this dictionary as an event to be placed in the common record.
+     * @param order byte order of the record the event is written into.
+     * @return event holding this dictionary.
+     */
+    std::vector<uint8_t> CompressionDictionary::toEvent(ByteOrder const & order) const {
+        std::vector<uint8_t> event(4 + bytes.size());
+        uint32_t magic = order.isLocalEndian() ? MAGIC : SWAP_32(MAGIC);
+        std::memcpy(event.data(), &magic, 4);
+        std::memcpy(event.data() + 4, bytes.data(), bytes.size());
+        return event;
+    }
+
+
+    /**
+     * Is the given event one holding a compression dictionary, in either byte order?
+     * @param data start of event.
+     * @param len  number of bytes in event.
+     * @return true if data holds a compression dictionary.
+     */
+    bool CompressionDictionary::isCompressionDictionary(const uint8_t *data, size_t len) {
+        if (data == nullptr || len < 5) return false;
+        uint32_t word;
+        std::memcpy(&word, data, 4);
+        return (word == MAGIC || SWAP_32(word) == MAGIC);
+    }
+
+
+    /**
+     * Create a dictionary from the event holding it.
+     * @param data start of event.
+     * @param len  number of bytes in event.
+     * @return dictionary held in event.
+     * @throws EvioException if data does not hold a compression dictionary.
+     */
+    std::shared_ptr<CompressionDictionary> CompressionDictionary::fromEvent(const uint8_t *data, size_t len) {
+        if (!isCompressionDictionary(data, len)) {
+            throw EvioException("not a compression dictionary");
+        }
+        return std::make_shared<CompressionDictionary>(std::vector<uint8_t>(data + 4, data + len));
+    }
+
+}
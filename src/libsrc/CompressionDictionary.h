@@ -0,0 +1,91 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPRESSIONDICTIONARY_H
+#define EVIO_6_0_COMPRESSIONDICTIONARY_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+
+#include "ByteOrder.h"
+#include "EvioException.h"
+
+#ifdef USE_ZSTD
+    #include "zstd.h"
+#endif
+
+
+namespace evio {
+
+
+    /**
+     * This class holds a dictionary trained on typical record data (for example with
+     * <code>zstd --train</code>) which is used to compress and decompress records.
+     * Small records compress poorly on their own since each one starts without any history.
+     * Starting from a dictionary of what data usually looks like makes up for most of that.<p>
+     *
+     * The dictionary is stored once, as an event of the common record which is the file
+     * header's user header, next to the xml dictionary and first event. Records compressed
+     * with it have {@link RecordHeader#COMPRESSION_DICT_BIT} set.
+     * For LZ4, only the last 64kB of the dictionary are used.
+     * For zstd, the dictionary is digested once, at the level set when it's created.<p>
+     *
+     * Stored as an event, it's the 32 bit {@link #MAGIC} number
+     * followed by the dictionary bytes.
+     */
+    class CompressionDictionary {
+
+    public:
+
+        /** Magic number which starts the common record's event holding the dictionary. */
+        static const uint32_t MAGIC = 0xc0dad1c7;
+
+    private:
+
+        /** Dictionary bytes. */
+        std::vector<uint8_t> bytes;
+
+#ifdef USE_ZSTD
+        /** Zstd's digested form of the dictionary for compression. */
+        ZSTD_CDict *cdict = nullptr;
+        /** Zstd's digested form of the dictionary for decompression. */
+        ZSTD_DDict *ddict = nullptr;
+#endif
+
+    public:
+
+        explicit CompressionDictionary(std::vector<uint8_t> dictionary);
+        CompressionDictionary(const CompressionDictionary & other) = delete;
+        CompressionDictionary & operator=(const CompressionDictionary & other) = delete;
+        ~CompressionDictionary();
+
+        const uint8_t * getData() const;
+        size_t getSize() const;
+        std::vector<uint8_t> const & getBytes() const;
+
+#ifdef USE_ZSTD
+        ZSTD_CDict * getZstdCDict() const;
+        ZSTD_DDict * getZstdDDict() const;
+#endif
+
+        std::vector<uint8_t> toEvent(ByteOrder const & order) const;
+
+        static bool isCompressionDictionary(const uint8_t *data, size_t len);
+        static std::shared_ptr<CompressionDictionary> fromEvent(const uint8_t *data, size_t len);
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPRESSIONDICTIONARY_H
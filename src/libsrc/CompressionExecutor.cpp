@@ -0,0 +1,254 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "CompressionExecutor.h"
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+
+namespace evio {
+
+
+    /** Destructor which stops the threads. */
+    CompressionExecutor::~CompressionExecutor() {stop();}
+
+
+    /**
+     * Start the compression threads. Writers created from now on use them instead of starting
+     * their own. If already started, the threads running are first stopped.
+     * @param threads number of threads, 0 to stop them.
+     */
+    void CompressionExecutor::start(uint32_t threads) {
+        stop();
+        if (threads == 0) return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = false;
+        this->threads.reserve(threads);
+        for (uint32_t i=0; i < threads; i++) {
+            this->threads.emplace_back([this]() {this->run();});
+        }
+        threadCount = threads;
+    }
+
+
+    /**
+     * Stop the compression threads once they finish the records they are compressing.
+     * Records still queued stay queued until threads are started again, so only
+     * stop once no writer uses this pool.
+     */
+    void CompressionExecutor::stop() {
+        std::vector<std::thread> running;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            threadCount = 0;
+            stopping = true;
+            running.swap(threads);
+        }
+        workCond.notify_all();
+
+        for (auto & thd : running) {
+            thd.join();
+        }
+    }
+
+
+    /**
+     * Have the compression threads been started?
+     * @return true if writers created now use this pool.
+     */
+    bool CompressionExecutor::isEnabled() const {return threadCount > 0;}
+
+
+    /**
+     * Get the number of compression threads.
+     * @return number of compression threads, 0 if not started.
+     */
+    uint32_t CompressionExecutor::getThreadCount() const {return threadCount;}
+
+
+    /**
+     * Have this pool compress every record published into a writer's supply.
+     * Called by a writer in place of starting compression threads of its own.
+     * @param supply supply of the writer's records.
+     * @param type   type of compression to do.
+     */
+    void CompressionExecutor::addSupply(std::shared_ptr<RecordSupply> const & supply,
+                                        Compressor::CompressionType type) {
+        auto client = std::make_shared<Client>();
+        client->supply = supply;
+        client->compressionType = type;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (auto & c : clients) {
+                if (c->supply == supply) {
+                    c->compressionType = type;
+                    return;
+                }
+            }
+            clients.push_back(client);
+        }
+
+        std::weak_ptr<Client> weak = client;
+        supply->setPublishListener([this, weak](const std::shared_ptr<RecordRingItem> & item) {
+            submit(weak, item);
+        });
+    }
+
+
+    /**
+     * Stop compressing a writer's records. Records not yet taken by a thread are dropped,
+     * and this waits for those being compressed to finish.
+     * Called by a writer once it has written its last record.
+     * @param supply supply of the writer's records.
+     */
+    void CompressionExecutor::removeSupply(std::shared_ptr<RecordSupply> const & supply) {
+        if (supply == nullptr) return;
+        supply->setPublishListener(nullptr);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        auto it = std::find_if(clients.begin(), clients.end(),
+                               [&supply](std::shared_ptr<Client> const & c) {return c->supply == supply;});
+        if (it == clients.end()) return;
+
+        auto client = *it;
+        client->queue.clear();
+        idleCond.wait(lock, [&client]() {return client->busy == 0;});
+
+        // Others may have been removed while waiting
+        it = std::find(clients.begin(), clients.end(), client);
+        if (it != clients.end()) {
+            size_t index = it - clients.begin();
+            clients.erase(it);
+            if (nextClient > index) nextClient--;
+            if (nextClient >= clients.size()) nextClient = 0;
+        }
+    }
+
+
+    /**
+     * Get the number of writers using this pool.
+     * @return number of writers using this pool.
+     */
+    size_t CompressionExecutor::getSupplyCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return clients.size();
+    }
+
+
+    /**
+     * Get the number of records compressed by this pool.
+     * @return number of records compressed.
+     */
+    uint64_t CompressionExecutor::getRecordsCompressed() const {return recordsCompressed;}
+
+
+    /**
+     * Queue a record just published by a writer.
+     * @param client writer's entry, which may have been removed.
+     * @param item   record to compress.
+     */
+    void CompressionExecutor::submit(std::weak_ptr<Client> const & client, const std::shared_ptr<RecordRingItem> & item) {
+        auto c = client.lock();
+        if (c == nullptr) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            c->queue.push_back(item);
+        }
+        workCond.notify_one();
+    }
+
+
+    /**
+     * Take the oldest waiting record of the next writer, in turn, having one.
+     * Must be called with mtx locked.
+     * @param client set to writer's entry.
+     * @param item   set to record to compress.
+     * @return true if a record was taken, false if none is waiting.
+     */
+    bool CompressionExecutor::takeNext(std::shared_ptr<Client> & client, std::shared_ptr<RecordRingItem> & item) {
+        size_t count = clients.size();
+        for (size_t i=0; i < count; i++) {
+            size_t index = (nextClient + i) % count;
+            auto & c = clients[index];
+            if (!c->queue.empty()) {
+                client = c;
+                item = c->queue.front();
+                c->queue.pop_front();
+                c->busy++;
+                nextClient = (index + 1) % count;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    /**
+     * Compress a record as a {@link RecordCompressor} does, then release it to its supply.
+     * Any error is reported to the supply, which alerts the writer's threads.
+     * @param client writer's entry.
+     * @param item   record to compress.
+     */
+    void CompressionExecutor::compress(Client & client, const std::shared_ptr<RecordRingItem> & item) {
+        auto & supply = client.supply;
+        try {
+            std::shared_ptr<RecordOutput> & record = item->getRecord();
+            auto & header = record->getHeader();
+            header->setCompressionType(client.compressionType);
+            // Go easy on compression if records are backing up
+            record->setFastCompression(supply->useFastCompression());
+
+            uint32_t bytesIn = record->getUncompressedSize();
+            auto t1 = std::chrono::steady_clock::now();
+            record->build();
+            supply->addCompressionStats(0,
+                                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                std::chrono::steady_clock::now() - t1).count(),
+                                        bytesIn, header->getLength());
+            supply->releaseCompressor(item);
+            recordsCompressed++;
+        }
+        catch (std::exception & e) {
+            std::string err = std::string("error compressing record: ") + e.what();
+            supply->setError(err);
+            supply->haveError(true);
+            supply->errorAlert();
+        }
+    }
+
+
+    /** Method run by each compression thread. */
+    void CompressionExecutor::run() {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        while (true) {
+            std::shared_ptr<Client> client;
+            std::shared_ptr<RecordRingItem> item;
+
+            while (!stopping && !takeNext(client, item)) {
+                workCond.wait(lock);
+            }
+            if (client == nullptr) return;
+
+            lock.unlock();
+            compress(*client, item);
+            lock.lock();
+
+            if (--client->busy == 0) {
+                idleCond.notify_all();
+            }
+        }
+    }
+
+}
@@ -0,0 +1,124 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_COMPRESSIONEXECUTOR_H
+#define EVIO_6_0_COMPRESSIONEXECUTOR_H
+
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+
+#include "Compressor.h"
+#include "RecordSupply.h"
+#include "RecordRingItem.h"
+
+
+namespace evio {
+
+
+    /**
+     * This singleton class is a process-wide pool of threads compressing the records of
+     * many writers. Each {@link EventWriter} or {@link WriterMT} otherwise starts its own
+     * compression threads, so a process with dozens of writers has hundreds of threads,
+     * mostly idle, all competing for cores during bursts.<p>
+     *
+     * Once started with {@link #start(uint32_t)}, writers created afterwards start no
+     * compression threads. Instead each record they publish into their {@link RecordSupply}
+     * is queued here for that writer. Threads take records from the writers in turn, one
+     * at a time, so a writer with a burst of records does not starve the others. Records
+     * of one writer may be compressed by several threads at once and finish out of order,
+     * but its supply still has its writing thread write them out in order.<p>
+     *
+     * Stop the pool with {@link #stop()} only once no writer uses it.
+     */
+    class CompressionExecutor {
+
+    public:
+
+        /**
+         * Get the instance of this singleton class.
+         * @return the instance of this singleton class.
+         */
+        static CompressionExecutor & getInstance() {
+            static CompressionExecutor theExecutor;
+            return theExecutor;
+        }
+
+    private:
+
+        /** A writer's supply and its records waiting to be compressed. */
+        struct Client {
+            /** Supply records come from and go back to. */
+            std::shared_ptr<RecordSupply> supply;
+            /** Type of compression to do. */
+            Compressor::CompressionType compressionType;
+            /** Published records not yet taken by a thread, in order. */
+            std::deque<std::shared_ptr<RecordRingItem>> queue;
+            /** Number of this client's records being compressed. */
+            uint32_t busy = 0;
+        };
+
+        /** Writers using this pool. */
+        std::vector<std::shared_ptr<Client>> clients;
+        /** Index into clients of the next to take a record from. */
+        size_t nextClient = 0;
+
+        /** Compression threads. */
+        std::vector<std::thread> threads;
+        /** Number of compression threads, 0 if not started. */
+        std::atomic<uint32_t> threadCount{0};
+        /** Are threads to quit? */
+        bool stopping = false;
+
+        /** Guards clients, nextClient, threads and stopping. */
+        std::mutex mtx;
+        /** Wakes threads when a record is queued or they're to quit. */
+        std::condition_variable workCond;
+        /** Wakes a thread removing a client when its records are done. */
+        std::condition_variable idleCond;
+
+        /** Number of records compressed. */
+        std::atomic<uint64_t> recordsCompressed{0};
+
+        CompressionExecutor() = default;
+        ~CompressionExecutor();
+        CompressionExecutor(const CompressionExecutor &) = delete;
+        CompressionExecutor & operator=(const CompressionExecutor &) = delete;
+
+        bool takeNext(std::shared_ptr<Client> & client, std::shared_ptr<RecordRingItem> & item);
+        void compress(Client & client, const std::shared_ptr<RecordRingItem> & item);
+        void submit(std::weak_ptr<Client> const & client, const std::shared_ptr<RecordRingItem> & item);
+        void run();
+
+    public:
+
+        void start(uint32_t threads);
+        void stop();
+        bool isEnabled() const;
+        uint32_t getThreadCount() const;
+
+        void addSupply(std::shared_ptr<RecordSupply> const & supply, Compressor::CompressionType type);
+        void removeSupply(std::shared_ptr<RecordSupply> const & supply);
+
+        size_t getSupplyCount();
+        uint64_t getRecordsCompressed() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_COMPRESSIONEXECUTOR_H
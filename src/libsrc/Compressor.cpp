@@ -17,9 +17,129 @@
 namespace evio {
 
 
+    std::atomic<int> Compressor::zstdLevel {3};
+    std::atomic<int> Compressor::zstdWorkers {0};
+    std::atomic<bool> Compressor::useHardwareGzip {true};
+    bool Compressor::haveHardwareGzip = false;
+
+
+#ifdef USE_ZSTD
+    /**
+     * Zstd contexts of one thread. Creating them for each record would be slow,
+     * while sharing them among threads is not allowed. So each thread keeps its own.
+     */
+    struct ZstdContexts {
+        ZSTD_CCtx *cctx = nullptr;
+        ZSTD_DCtx *dctx = nullptr;
+
+        ~ZstdContexts() {
+            if (cctx != nullptr) ZSTD_freeCCtx(cctx);
+            if (dctx != nullptr) ZSTD_freeDCtx(dctx);
+        }
+    };
+
+    static thread_local ZstdContexts zstdContexts;
+#endif
+
+
 #ifdef USE_GZIP
-    z_stream Compressor::strmDeflate;
-    z_stream Compressor::strmInflate;
+    /**
+     * Gzip streams of one thread. A z_stream may only be used by one thread at a time,
+     * and initializing one for each record would be slow. So each thread keeps its own
+     * and resets it after each use.
+     */
+    struct GzipStreams {
+        z_stream deflateStrm {};
+        z_stream inflateStrm {};
+        bool haveDeflate = false;
+        bool haveInflate = false;
+
+        ~GzipStreams() {
+            if (haveDeflate) deflateEnd(&deflateStrm);
+            if (haveInflate) inflateEnd(&inflateStrm);
+        }
+    };
+
+    static thread_local GzipStreams gzipStreams;
+#endif
+
+
+    /**
+     * Lz4 compression states of one thread. Lz4 otherwise sets up a state for each call,
+     * and allocates it from the heap for high compression. So each thread keeps its own.
+     * They're stored as uint64_t for alignment. The streams are used when compressing
+     * with a dictionary.
+     */
+    struct Lz4States {
+        std::unique_ptr<uint64_t[]> fast;
+        std::unique_ptr<uint64_t[]> hc;
+        LZ4_stream_t   *dictStream   = nullptr;
+        LZ4_streamHC_t *dictStreamHC = nullptr;
+
+        ~Lz4States() {
+            if (dictStream   != nullptr) LZ4_freeStream(dictStream);
+            if (dictStreamHC != nullptr) LZ4_freeStreamHC(dictStreamHC);
+        }
+    };
+
+    static thread_local Lz4States lz4States;
+
+
+    /** Scratch space of one thread for rearranging data in {@link Compressor#filter} and {@link Compressor#unfilter}. */
+    static thread_local std::vector<uint8_t> filterScratch;
+
+
+#ifdef USE_QATZIP
+    /**
+     * QATzip session of one thread. Sessions must not be shared among threads.
+     * Each thread sets up its own with the hardware the first time it compresses.
+     */
+    struct QatSession {
+        QzSession_T session {};
+        bool ready  = false;
+        bool failed = false;
+
+        ~QatSession() {
+            if (ready) {
+                qzTeardownSession(&session);
+                qzClose(&session);
+            }
+        }
+    };
+
+    static thread_local QatSession qatSession;
+
+
+    /**
+     * Get the calling thread's QATzip session, setting it up the first time.
+     * @return calling thread's QATzip session, or null if no QAT hardware can be used.
+     */
+    static QzSession_T* getQatSession() {
+        if (!qatSession.ready && !qatSession.failed) {
+            // No software backup in QATzip itself since we fall back to zlib
+            int rc = qzInit(&qatSession.session, 0);
+            if (rc != QZ_OK && rc != QZ_DUPLICATE) {
+                qatSession.failed = true;
+                return nullptr;
+            }
+
+            // Plain gzip so data can be read without QAT
+            QzSessionParams_T params;
+            qzGetDefaults(&params);
+            params.data_fmt = QZ_DEFLATE_GZIP;
+            params.sw_backup = 0;
+
+            rc = qzSetupSession(&qatSession.session, &params);
+            if (rc != QZ_OK && rc != QZ_DUPLICATE) {
+                qzClose(&qatSession.session);
+                qatSession.failed = true;
+                return nullptr;
+            }
+            qatSession.ready = true;
+        }
+
+        return qatSession.ready ? &qatSession.session : nullptr;
+    }
 #endif
 
 
@@ -78,6 +198,8 @@ namespace evio {
      */
     Compressor::CompressionType Compressor::toCompressionType(uint32_t type) {
         switch (type) {
+            case ZSTD:
+                return ZSTD;
             case GZIP:
                 return GZIP;
             case LZ4_BEST:
@@ -92,147 +214,382 @@ namespace evio {
 
 
     /**
-     * Method to setup use of z library for gzip compression.
+     * Method to convert an integer to a PreFilter object.
+     * @param filter integer to convert.
+     * @return corresponding PreFilter object.
+     */
+    Compressor::PreFilter Compressor::toPreFilter(uint32_t filter) {
+        switch (filter) {
+            case DELTA_SHUFFLE_32:
+                return DELTA_SHUFFLE_32;
+            case SHUFFLE_32:
+                return SHUFFLE_32;
+            case SHUFFLE_16:
+                return SHUFFLE_16;
+            case NO_FILTER:
+            default:
+                return NO_FILTER;
+        }
+    }
+
+
+    /**
+     * Group the bytes of values by significance: all first bytes, then all second bytes, etc.
+     * Bytes past the last whole value are copied as is. Plain loops of fixed stride
+     * which the compiler vectorizes.
+     * @tparam N  bytes in each value.
+     * @param src data.
+     * @param dst where to write rearranged data, not overlapping src.
+     * @param len bytes of data.
+     */
+    template <size_t N>
+    static void shuffleBytes(const uint8_t * __restrict src, uint8_t * __restrict dst, uint32_t len) {
+        uint32_t count = len / N;
+        for (size_t j=0; j < N; j++) {
+            uint8_t *out = dst + j*count;
+            for (uint32_t i=0; i < count; i++) {
+                out[i] = src[i*N + j];
+            }
+        }
+        std::memcpy(dst + N*count, src + N*count, len - N*count);
+    }
+
+
+    /**
+     * Undo {@link #shuffleBytes}.
+     * @tparam N  bytes in each value.
+     * @param src rearranged data.
+     * @param dst where to write original data, not overlapping src.
+     * @param len bytes of data.
+     */
+    template <size_t N>
+    static void unshuffleBytes(const uint8_t * __restrict src, uint8_t * __restrict dst, uint32_t len) {
+        uint32_t count = len / N;
+        for (size_t j=0; j < N; j++) {
+            const uint8_t *in = src + j*count;
+            for (uint32_t i=0; i < count; i++) {
+                dst[i*N + j] = in[i];
+            }
+        }
+        std::memcpy(dst + N*count, src + N*count, len - N*count);
+    }
+
+
+    /**
+     * Replace each 32 bit value, in the given byte order, by its difference from the one before.
+     * @param data  data.
+     * @param count number of values.
+     * @param swap  true if byte order of data is not local.
+     */
+    static void deltaEncode(uint8_t *data, uint32_t count, bool swap) {
+        uint32_t prev = 0;
+        for (uint32_t i=0; i < count; i++) {
+            uint32_t val;
+            std::memcpy(&val, data + 4*i, 4);
+            if (swap) val = SWAP_32(val);
+            uint32_t diff = val - prev;
+            prev = val;
+            if (swap) diff = SWAP_32(diff);
+            std::memcpy(data + 4*i, &diff, 4);
+        }
+    }
+
+
+    /**
+     * Undo {@link #deltaEncode}.
+     * @param data  data.
+     * @param count number of values.
+     * @param swap  true if byte order of data is not local.
+     */
+    static void deltaDecode(uint8_t *data, uint32_t count, bool swap) {
+        uint32_t val = 0;
+        for (uint32_t i=0; i < count; i++) {
+            uint32_t diff;
+            std::memcpy(&diff, data + 4*i, 4);
+            if (swap) diff = SWAP_32(diff);
+            val += diff;
+            uint32_t out = swap ? SWAP_32(val) : val;
+            std::memcpy(data + 4*i, &out, 4);
+        }
+    }
+
+
+    /**
+     * Rearrange data in place with a filter, before it is compressed, so it compresses better.
+     * @param type  filter to apply.
+     * @param data  data.
+     * @param len   bytes of data.
+     * @param order byte order of data, which matters for DELTA_SHUFFLE_32.
+     */
+    void Compressor::filter(PreFilter type, uint8_t *data, uint32_t len, ByteOrder const & order) {
+        if (type == NO_FILTER || len == 0) return;
+
+        if (filterScratch.size() < len) {
+            filterScratch.resize(len);
+        }
+        uint8_t *scratch = filterScratch.data();
+
+        switch (type) {
+            case SHUFFLE_16:
+                shuffleBytes<2>(data, scratch, len);
+                break;
+            case DELTA_SHUFFLE_32:
+                deltaEncode(data, len/4, order != ByteOrder::ENDIAN_LOCAL);
+                // fall through
+            case SHUFFLE_32:
+            default:
+                shuffleBytes<4>(data, scratch, len);
+        }
+        std::memcpy(data, scratch, len);
+    }
+
+
+    /**
+     * Undo in place the filter applied to data by
+     * {@link #filter(PreFilter, uint8_t *, uint32_t, ByteOrder const &)}, after it is decompressed.
+     * @param type  filter that was applied.
+     * @param data  data.
+     * @param len   bytes of data.
+     * @param order byte order of data, which matters for DELTA_SHUFFLE_32.
+     */
+    void Compressor::unfilter(PreFilter type, uint8_t *data, uint32_t len, ByteOrder const & order) {
+        if (type == NO_FILTER || len == 0) return;
+
+        if (filterScratch.size() < len) {
+            filterScratch.resize(len);
+        }
+        uint8_t *scratch = filterScratch.data();
+
+        if (type == SHUFFLE_16) {
+            unshuffleBytes<2>(data, scratch, len);
+        }
+        else {
+            unshuffleBytes<4>(data, scratch, len);
+        }
+        std::memcpy(data, scratch, len);
+
+        if (type == DELTA_SHUFFLE_32) {
+            deltaDecode(data, len/4, order != ByteOrder::ENDIAN_LOCAL);
+        }
+    }
+
+
+    /**
+     * Method to setup use of z library for gzip compression
+     * by creating the gzip streams of the calling thread.
      */
     void Compressor::setUpZlib() {
+#ifdef USE_GZIP
+        getDeflateStream();
+        getInflateStream();
+#endif
+    }
+
 
 #ifdef USE_GZIP
+    /**
+     * Get the calling thread's gzip deflate stream, creating it the first time.
+     * @return calling thread's gzip deflate stream.
+     * @throws EvioException if stream cannot be initialized.
+     */
+    z_stream & Compressor::getDeflateStream() {
+        if (!gzipStreams.haveDeflate) {
+            z_stream & strm = gzipStreams.deflateStrm;
+            strm.next_in = Z_NULL;
+            strm.zalloc  = Z_NULL;
+            strm.zfree   = Z_NULL;
+            strm.opaque  = Z_NULL;
+
+            int level = Z_DEFAULT_COMPRESSION; // =6, 1 gives top speed, 9 top compression
+            int windowBits = 15 + 16; // 15 is default and adding 16 makes it gzip and not zlib format
+            int memLevel = 9;         // Highest mem usage for best speed
+
+            int ret = deflateInit2(&strm, level, Z_DEFLATED, windowBits,
+                                   memLevel, Z_DEFAULT_STRATEGY);
+            if (ret != Z_OK)
+                throw EvioException("error initializing gzip deflate stream");
+
+            gzipStreams.haveDeflate = true;
+        }
+        return gzipStreams.deflateStrm;
+    }
+
 
-        // init deflate state
-        strmDeflate.next_in = Z_NULL;
-        strmDeflate.zalloc  = Z_NULL;
-        strmDeflate.zfree   = Z_NULL;
-        strmDeflate.opaque  = Z_NULL;
-
-        int level = Z_DEFAULT_COMPRESSION; // =6, 1 gives top speed, 9 top compression
-        int windowBits = 15 + 16; // 15 is default and adding 16 makes it gzip and not zlib format
-        int memLevel = 9;         // Highest mem usage for best speed
-
-        int ret = deflateInit2(&strmDeflate, level, Z_DEFLATED, windowBits,
-                               memLevel, Z_DEFAULT_STRATEGY);
-        if (ret != Z_OK)
-            throw EvioException("error initializing gzip deflate stream");
-
-        //-----------------------------------------------------------------
-
-        /* init deflate state */
-        strmInflate.next_in  = Z_NULL;
-        strmInflate.avail_in = Z_NULL;
-        strmInflate.zalloc   = Z_NULL;
-        strmInflate.zfree    = Z_NULL;
-        strmInflate.opaque   = Z_NULL;
-
-        ret = inflateInit2(&strmInflate, windowBits);
-        if (ret != Z_OK)
-            throw EvioException("error initializing gzip inflate stream");
+    /**
+     * Get the calling thread's gzip inflate stream, creating it the first time.
+     * @return calling thread's gzip inflate stream.
+     * @throws EvioException if stream cannot be initialized.
+     */
+    z_stream & Compressor::getInflateStream() {
+        if (!gzipStreams.haveInflate) {
+            z_stream & strm = gzipStreams.inflateStrm;
+            strm.next_in  = Z_NULL;
+            strm.avail_in = 0;
+            strm.zalloc   = Z_NULL;
+            strm.zfree    = Z_NULL;
+            strm.opaque   = Z_NULL;
+
+            int windowBits = 15 + 16; // gzip and not zlib format
+
+            int ret = inflateInit2(&strm, windowBits);
+            if (ret != Z_OK)
+                throw EvioException("error initializing gzip inflate stream");
+
+            gzipStreams.haveInflate = true;
+        }
+        return gzipStreams.inflateStrm;
+    }
 #endif
 
+
+    /**
+     * Get the calling thread's state for fast lz4 compression, creating it the first time.
+     * @return calling thread's state for fast lz4 compression.
+     */
+    void* Compressor::getLz4State() {
+        if (lz4States.fast == nullptr) {
+            lz4States.fast.reset(new uint64_t[(LZ4_sizeofState() + 7) / 8]);
+        }
+        return lz4States.fast.get();
+    }
+
+
+    /**
+     * Get the calling thread's state for high lz4 compression, creating it the first time.
+     * @return calling thread's state for high lz4 compression.
+     */
+    void* Compressor::getLz4HCState() {
+        if (lz4States.hc == nullptr) {
+            lz4States.hc.reset(new uint64_t[(LZ4_sizeofStateHC() + 7) / 8]);
+        }
+        return lz4States.hc.get();
+    }
+
+
+    /**
+     * Get the calling thread's stream for fast lz4 compression with a dictionary,
+     * creating it the first time, and load the dictionary into it.
+     * @param dict dictionary to compress with.
+     * @return calling thread's stream for fast lz4 compression, loaded with dict.
+     * @throws EvioException if stream cannot be created.
+     */
+    LZ4_stream_t* Compressor::getLz4DictStream(const CompressionDictionary *dict) {
+        if (lz4States.dictStream == nullptr) {
+            lz4States.dictStream = LZ4_createStream();
+            if (lz4States.dictStream == nullptr) {
+                throw EvioException("cannot create lz4 stream");
+            }
+        }
+        LZ4_resetStream_fast(lz4States.dictStream);
+        // Only the last 64kB are used
+        LZ4_loadDict(lz4States.dictStream, (const char*)dict->getData(), (int)dict->getSize());
+        return lz4States.dictStream;
     }
 
+
     /**
-     * Check for existence of AHA3641/2 board for gzip hardware compression.
-     * This will most likely not be used so comment it out.
+     * Get the calling thread's stream for high lz4 compression with a dictionary,
+     * creating it the first time, and load the dictionary into it.
+     * @param dict dictionary to compress with.
+     * @return calling thread's stream for high lz4 compression, loaded with dict.
+     * @throws EvioException if stream cannot be created.
+     */
+    LZ4_streamHC_t* Compressor::getLz4HCDictStream(const CompressionDictionary *dict) {
+        if (lz4States.dictStreamHC == nullptr) {
+            lz4States.dictStreamHC = LZ4_createStreamHC();
+            if (lz4States.dictStreamHC == nullptr) {
+                throw EvioException("cannot create lz4 stream");
+            }
+        }
+        LZ4_resetStreamHC_fast(lz4States.dictStreamHC, 1);
+        LZ4_loadDictHC(lz4States.dictStreamHC, (const char*)dict->getData(), (int)dict->getSize());
+        return lz4States.dictStreamHC;
+    }
+
+
+    /**
+     * LZ4 decompression, with or without a dictionary.
+     * @param src      start of compressed data.
+     * @param dst      start of destination.
+     * @param srcSize  number of compressed bytes.
+     * @param dstCapacity number of bytes available in dst.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
+     * @return number of uncompressed bytes, or &lt; 0 if dst is too small or data malformed.
+     */
+    static int lz4Decompress(const uint8_t *src, uint8_t *dst, int srcSize, int dstCapacity,
+                             const CompressionDictionary *dict) {
+        if (dict == nullptr) {
+            return LZ4_decompress_safe((const char*)src, (char*)dst, srcSize, dstCapacity);
+        }
+        return LZ4_decompress_safe_usingDict((const char*)src, (char*)dst, srcSize, dstCapacity,
+                                             (const char*)dict->getData(), (int)dict->getSize());
+    }
+
+
+    /**
+     * Check for hardware which can do gzip compression, and if found,
+     * prepare the calling thread to use it. Currently this is Intel QAT accessed
+     * through the QATzip library, which is only used if compiled with USE_QATZIP.
+     * Previously this looked for an AHA3641/2 board.
      */
     void Compressor::setUpCompressionHardware() {
+#ifdef USE_QATZIP
+        haveHardwareGzip = (getQatSession() != nullptr);
+#endif
+    }
+
 
-        //    // Check for an AHA374 FPGA data compression board for hardware (de)compression.
-        //    // Only want to do this once. Need the jar which uses native methods,
-        //    // the C lib which it wraps using jni, and the C lib which does the compression.
-        //    // Both C libs must have their directory in LD_LIBRARY_PATH for this to work!
-        //
-        //    /** Do we have an AHA374 data compression board on the local host? */
-        //    static bool haveHardwareGzipCompression = false;
-        //
-        //    try {
-        //
-        //        AHACompressionAPI apiObj = new AHACompressionAPI();
-        //        ByteBuffer as(8);
-        //        as.order(ByteOrder::ENDIAN_LOCAL);
-        //        int rv = AHACompressionAPI.Open(apiObj, as, 0, 0);
-        //        cout << "rv = " << rv << endl;
-        //
-        //        rv = 0;
-        //        string betaString;
-        //        int versionArgSize = 89;
-        //        ByteBuffer versionArg(versionArgSize);
-        //        versionArg.order(ByteOrder::ENDIAN_LOCAL);
-        //
-        //        long longrv = AHACompressionAPI.Version(apiObj, as, versionArg);
-        //        if(longrv != 0){
-        //            rv = -1;
-        //        }
-        //
-        //        int loopMax = versionArg.get(8);
-        //        if(versionArg.get(0) != 0){
-        //            betaString = " Beta " + to_string(versionArg.get(0));
-        //        }else{
-        //            betaString = "";
-        //        }
-        //
-        //        string receivedDriverVersion = to_string(versionArg.get(3)) + "." +
-        //                                       to_string(versionArg.get(2)) + "." +
-        //                                       to_string(versionArg.get(1)) + betaString;
-        //        string receivedReleaseDate = to_string(versionArg.get(5)) + "/" +
-        //                                     to_string(versionArg.get(4)) + "/" +
-        //                                     to_string(getYear(versionArg));
-        //        string receivedNumBoards = "" + to_string(versionArg.get(8));
-        //
-        //        cout << "driver version  = "  << receivedDriverVersion << endl;
-        //        cout << "release date    = " << receivedReleaseDate << endl;
-        //        cout << "number of chips = " << receivedNumBoards << endl;
-        //
-        //        for(int j = 0; j < loopMax; j++) {
-        //            stringstream ss;
-        //
-        //            // show 0x for hex
-        //            ss << showbase << hex;
-        //
-        //            ss << setw(2) << getRevisionId(versionArg, j) << endl;
-        //            string receivedHwRevisionId = ss.str();
-        //            ss.str("");
-        //            ss.clear();
-        //
-        //            ss << setw(4) << getSubsystemId(versionArg, j) << endl;
-        //            string receivedHwSubsystemId = ss.str();
-        //            ss.str("");
-        //            ss.clear();
-        //
-        //            ss << setw(4) << getDeviceId(versionArg, j) << endl;
-        //            string receivedHwDeviceId = ss.str();
-        //            ss.str("");
-        //            ss.clear();
-        //
-        //            cout << "revision  id (" << j << ")= " << receivedHwRevisionId << endl;
-        //            cout << "subsystem id (" << j << ")= " << receivedHwSubsystemId << endl;
-        //            cout << "device    id (" << j << ")= " << receivedHwDeviceId << endl;
-        //        }
-        //
-        //        haveHardwareGzipCompression = true;
-        //        cout << endl << "Successfully loaded aha3xx jni shared lib for gzip hardware compression available" << endl << endl;
-        //    }
-        //    catch (Error & e) {
-        //        // If the library cannot be found, we can still do compression -
-        //        // just not with the AHA374 compression board.
-        //        cout << endl << "Cannot load aha3xx jni shared lib so no gzip hardware compression available" << endl << endl;
-        //    }
+    /**
+     * Is there hardware, usable by the calling thread, which can do gzip compression?
+     * That is only possible if compiled with USE_QATZIP and an Intel QAT device is present.
+     * @return true if hardware can do gzip compression.
+     */
+    bool Compressor::isHardwareGzipAvailable() {
+#ifdef USE_QATZIP
+        return getQatSession() != nullptr;
+#else
+        return false;
+#endif
     }
 
 
+    /**
+     * Is hardware to be used for gzip compression if available? The default is true.
+     * @return true if hardware is to be used for gzip compression if available.
+     */
+    bool Compressor::getUseHardwareGzip() {return useHardwareGzip;}
+
+
+    /**
+     * Set whether hardware is to be used for gzip compression if available.
+     * If not, or if hardware compression fails, zlib is used in software.
+     * Either way the output is standard gzip format.
+     * @param use true if hardware is to be used for gzip compression if available.
+     */
+    void Compressor::setUseHardwareGzip(bool use) {useHardwareGzip = use;}
+
+
     /**
      * Returns the maximum number of bytes needed to compress the given length
      * of uncompressed data. Depends on compression type. Unknown for gzip.
      *
      * @param compressionType type of data compression to do
-     *                        (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip).
+     *                        (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd).
      *                        Default to none.
      * @param uncompressedLength uncompressed data length in bytes.
      * @return maximum compressed length in bytes or -1 if unknown.
      */
     int Compressor::getMaxCompressedLength(CompressionType compressionType, uint32_t uncompressedLength) {
         switch(compressionType) {
+            case ZSTD:
+#ifdef USE_ZSTD
+                return (int) ZSTD_compressBound(uncompressedLength);
+#else
+                return -1;
+#endif
             case GZIP:
 #ifdef USE_GZIP
-                return deflateBound(&strmDeflate, uncompressedLength);
+                return deflateBound(&getDeflateStream(), uncompressedLength);
 #else
                 return -1;
 #endif
@@ -246,6 +603,32 @@ namespace evio {
     }
 
 
+    /**
+     * Is the given type of compression compiled into this library?
+     * Gzip requires USE_GZIP and zstd requires USE_ZSTD to be defined.
+     * @param compressionType type of data compression.
+     * @return true if data can be compressed and uncompressed with this type.
+     */
+    bool Compressor::isSupported(CompressionType compressionType) {
+        switch(compressionType) {
+            case ZSTD:
+#ifdef USE_ZSTD
+                return true;
+#else
+                return false;
+#endif
+            case GZIP:
+#ifdef USE_GZIP
+                return true;
+#else
+                return false;
+#endif
+            default:
+                return true;
+        }
+    }
+
+
     //---------------------------
     // GZIP Compression
     //---------------------------
@@ -270,7 +653,7 @@ uint8_t* Compressor::compressGZIP(uint8_t* ungzipped, uint32_t offset,
         throw EvioException("ungzipped and/or compLen arg is null");
     }
 
-    uint32_t dstLen = deflateBound(&strmDeflate, length);
+    uint32_t dstLen = deflateBound(&getDeflateStream(), length);
     auto *dst = new uint8_t[dstLen];
 
     // This should not generate an error
@@ -355,10 +738,28 @@ int Compressor::compressGZIP(uint8_t* dest, uint32_t *destLen,
         throw EvioException("null pointer for one or both buffer args");
     }
 
-    if ((deflateBound(&strmDeflate, sourceLen)) < *destLen) {
+    z_stream & strmDeflate = getDeflateStream();
+
+    if (*destLen < deflateBound(&strmDeflate, sourceLen)) {
         throw EvioException("destination buffer is too small");
     }
 
+#ifdef USE_QATZIP
+    // Use hardware if possible, but if it fails for any reason, use zlib
+    if (useHardwareGzip) {
+        QzSession_T *session = getQatSession();
+        if (session != nullptr) {
+            unsigned int srcLen = sourceLen;
+            unsigned int dstLen = *destLen;
+            int rc = qzCompress(session, source, &srcLen, dest, &dstLen, 1);
+            if (rc == QZ_OK && srcLen == sourceLen) {
+                *destLen = dstLen;
+                return Z_OK;
+            }
+        }
+    }
+#endif
+
     strmDeflate.next_out  = dest;
     strmDeflate.avail_out = *destLen;
 
@@ -418,6 +819,8 @@ int Compressor::uncompressGZIP(uint8_t* dest, uint32_t *destLen,
         throw EvioException("destination buffer is too small");
     }
 
+    z_stream & strmInflate = getInflateStream();
+
     uint32_t len  = *sourceLen;
     uint32_t left = *destLen;
 
@@ -502,9 +905,10 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
                                         std::to_string(LZ4_compressBound(srcSize)) + ")");
         }
 
-        int size = LZ4_compress_fast((const char*)(src.array() + src.position()),
-                                     (char*)(dst.array() + dst.position()),
-                                     srcSize, maxSize, lz4Acceleration);
+        int size = LZ4_compress_fast_extState(getLz4State(),
+                                              (const char*)(src.array() + src.position()),
+                                              (char*)(dst.array() + dst.position()),
+                                              srcSize, maxSize, lz4Acceleration);
         if (size < 1) {
             throw EvioException("compression failed");
         }
@@ -522,11 +926,13 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
      * @param dst      destination array.
      * @param dstOff   start offset in dst.
      * @param maxSize  maximum number of bytes to write in dst.
+     * @param dict     dictionary to compress with, or nullptr if none.
      * @return length of compressed data in bytes.
      * @throws EvioException if maxSize &lt; max # of compressed bytes or compression failed.
      */
     int Compressor::compressLZ4(uint8_t *src, int srcOff, int srcSize,
-                                uint8_t *dst, int dstOff, int maxSize) {
+                                uint8_t *dst, int dstOff, int maxSize,
+                                const CompressionDictionary *dict) {
 
         if (LZ4_compressBound(srcSize) > maxSize) {
             throw EvioException("maxSize (" + std::to_string(maxSize) +
@@ -534,8 +940,19 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
                                         std::to_string(LZ4_compressBound(srcSize)) + ")");
         }
 
-        int size = LZ4_compress_fast((const char*)(src + srcOff), (char*)(dst + dstOff),
-                                     srcSize, maxSize, lz4Acceleration);
+        int size;
+        if (dict == nullptr) {
+            size = LZ4_compress_fast_extState(getLz4State(),
+                                              (const char*)(src + srcOff),
+                                              (char*)(dst + dstOff),
+                                              srcSize, maxSize, lz4Acceleration);
+        }
+        else {
+            size = LZ4_compress_fast_continue(getLz4DictStream(dict),
+                                              (const char*)(src + srcOff),
+                                              (char*)(dst + dstOff),
+                                              srcSize, maxSize, lz4Acceleration);
+        }
         if (size < 1) {
             throw EvioException("compression failed");
         }
@@ -565,9 +982,10 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
                                         std::to_string(LZ4_compressBound(srcSize)) + ")");
         }
 
-        int size = LZ4_compress_fast((const char*)(src.array() + srcOff),
-                                     (char*)(dst.array() + dstOff),
-                                     srcSize, maxSize, lz4Acceleration);
+        int size = LZ4_compress_fast_extState(getLz4State(),
+                                              (const char*)(src.array() + srcOff),
+                                              (char*)(dst.array() + dstOff),
+                                              srcSize, maxSize, lz4Acceleration);
         if (size < 1) {
             throw EvioException("compression failed");
         }
@@ -599,9 +1017,10 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
                                         std::to_string(LZ4_compressBound(srcSize)) + ")");
         }
 
-        int size = LZ4_compress_HC((const char*)(src.array() + src.position()),
-                                   (char*)(dst.array() + dst.position()),
-                                   srcSize, maxSize, 1);
+        int size = LZ4_compress_HC_extStateHC(getLz4HCState(),
+                                              (const char*)(src.array() + src.position()),
+                                              (char*)(dst.array() + dst.position()),
+                                              srcSize, maxSize, 1);
         if (size < 1) {
             throw EvioException("compression failed");
         }
@@ -619,19 +1038,32 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
      * @param dst      destination array.
      * @param dstOff   start offset in dst.
      * @param maxSize  maximum number of bytes to write in dst.
+     * @param dict     dictionary to compress with, or nullptr if none.
      * @return length of compressed data in bytes.
      * @throws EvioException if maxSize &lt; max # of compressed bytes or compression failed.
      */
     int Compressor::compressLZ4Best(uint8_t *src, int srcOff, int srcSize,
-                                    uint8_t *dst, int dstOff, int maxSize) {
+                                    uint8_t *dst, int dstOff, int maxSize,
+                                    const CompressionDictionary *dict) {
         if (LZ4_compressBound(srcSize) > maxSize) {
             throw EvioException("maxSize (" + std::to_string(maxSize) +
                                 ") is < max # of compressed bytes (" +
                                         std::to_string(LZ4_compressBound(srcSize)) + ")");
         }
 
-        int size = LZ4_compress_HC((const char*)(src + srcOff), (char*)(dst + dstOff),
-                                   srcSize, maxSize, 1);
+        int size;
+        if (dict == nullptr) {
+            size = LZ4_compress_HC_extStateHC(getLz4HCState(),
+                                              (const char*)(src + srcOff),
+                                              (char*)(dst + dstOff),
+                                              srcSize, maxSize, 1);
+        }
+        else {
+            size = LZ4_compress_HC_continue(getLz4HCDictStream(dict),
+                                            (const char*)(src + srcOff),
+                                            (char*)(dst + dstOff),
+                                            srcSize, maxSize);
+        }
         if (size < 1) {
             throw EvioException("compression failed");
         }
@@ -660,9 +1092,10 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
                                         std::to_string(LZ4_compressBound(srcSize)) + ")");
         }
 
-        int size = LZ4_compress_HC((const char*)(src.array() + srcOff),
-                                   (char*)(dst.array() + dstOff),
-                                   srcSize, maxSize, 1);
+        int size = LZ4_compress_HC_extStateHC(getLz4HCState(),
+                                              (const char*)(src.array() + srcOff),
+                                              (char*)(dst.array() + dstOff),
+                                              srcSize, maxSize, 1);
         if (size < 1) {
             throw EvioException("compression failed");
         }
@@ -682,12 +1115,14 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
      * @param src      source of compressed data.
      * @param srcSize  number of compressed bytes.
      * @param dst      destination array.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
      * @return original (uncompressed) input size.
      * @throws EvioException if destination buffer is too small to hold uncompressed data or
      *                       source data is malformed.
      */
-    int Compressor::uncompressLZ4(ByteBuffer & src, int srcSize, ByteBuffer & dst) {
-        return uncompressLZ4(src, src.position(), srcSize, dst);
+    int Compressor::uncompressLZ4(ByteBuffer & src, int srcSize, ByteBuffer & dst,
+                                  const CompressionDictionary *dict) {
+        return uncompressLZ4(src, src.position(), srcSize, dst, dict);
     }
 
 
@@ -698,17 +1133,18 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
      * @param srcOff   start offset in src.
      * @param srcSize  number of compressed bytes.
      * @param dst      destination array.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
      * @return original (uncompressed) input size.
      * @throws EvioException if destination buffer is too small to hold uncompressed data or
      *                       source data is malformed.
      */
-    int Compressor::uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst) {
+    int Compressor::uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst,
+                                  const CompressionDictionary *dict) {
 
         int dstOff = dst.position();
 
-        int size = LZ4_decompress_safe((const char*)(src.array() + srcOff),
-                                       (char*)(dst.array() + dstOff),
-                                       srcSize, dst.remaining());
+        int size = lz4Decompress(src.array() + srcOff, dst.array() + dstOff,
+                                 srcSize, dst.remaining(), dict);
 
         if (size < 0) {
             throw EvioException("destination buffer too small or data malformed");
@@ -728,15 +1164,16 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
      * @param srcSize  number of compressed bytes.
      * @param dst      destination array.
      * @param dstOff   start offset in dst.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
      * @return original (uncompressed) input size.
      * @throws EvioException if destination buffer is too small to hold uncompressed data or
      *                       source data is malformed.
      */
-    int Compressor::uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst, int dstOff) {
+    int Compressor::uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst, int dstOff,
+                                  const CompressionDictionary *dict) {
 
-        int size = LZ4_decompress_safe((const char*)(src.array() + srcOff),
-                                       (char*)(dst.array() + dstOff),
-                                       srcSize, dst.remaining());
+        int size = lz4Decompress(src.array() + srcOff, dst.array() + dstOff,
+                                 srcSize, dst.remaining(), dict);
 
         if (size < 0) {
             throw EvioException("destination buffer too small or data malformed");
@@ -757,16 +1194,15 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
      * @param dst      destination array.
      * @param dstOff   start offset in dst.
      * @param dstCapacity size of destination buffer in bytes, which must be already allocated.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
      * @return original (uncompressed) input size.
      * @throws EvioException if uncompressed data bytes &gt; dstCapacity or
      *                       source data is malformed.
      */
     int Compressor::uncompressLZ4(uint8_t *src, int srcOff, int srcSize, uint8_t *dst,
-                                  int dstOff, int dstCapacity) {
+                                  int dstOff, int dstCapacity, const CompressionDictionary *dict) {
 
-        int size = LZ4_decompress_safe((const char*)(src + srcOff),
-                                       (char*)(dst + dstOff),
-                                       srcSize, dstCapacity);
+        int size = lz4Decompress(src + srcOff, dst + dstOff, srcSize, dstCapacity, dict);
         if (size < 0) {
             throw EvioException("destination buffer too small or data malformed");
         }
@@ -774,4 +1210,194 @@ uint8_t* Compressor::uncompressGZIP(ByteBuffer & gzipped, uint32_t * uncompLen)
         return size;
     }
 
+
+    //---------------------------
+    // ZSTD
+    //---------------------------
+
+
+    /**
+     * Get the zstd compression level used for all zstd compression.
+     * @return zstd compression level.
+     */
+    int Compressor::getZstdLevel() {return zstdLevel;}
+
+
+    /**
+     * Set the zstd compression level used for all subsequent zstd compression,
+     * in every thread. Lower levels are faster, higher levels compress more.
+     * Level 3 is the default and is about as fast as LZ4 best while compressing
+     * better than gzip. Negative levels are faster still.
+     * Values out of zstd's range are set to the nearest limit.
+     * @param level zstd compression level.
+     */
+    void Compressor::setZstdLevel(int level) {
+#ifdef USE_ZSTD
+        if (level < ZSTD_minCLevel()) level = ZSTD_minCLevel();
+        if (level > ZSTD_maxCLevel()) level = ZSTD_maxCLevel();
+#endif
+        zstdLevel = level;
+    }
+
+
+    /**
+     * Get the number of threads zstd uses to compress each record.
+     * @return number of threads zstd uses to compress each record, 0 meaning the calling thread only.
+     */
+    int Compressor::getZstdWorkers() {return zstdWorkers;}
+
+
+    /**
+     * Set the number of additional threads zstd uses to compress each record.
+     * This helps when records are big and compressed by a single thread, as in {@link Writer}.
+     * When {@link EventWriter} already compresses with several threads, it's best left at 0.
+     * Ignored if the zstd library was built without multithreading.
+     * @param workers number of threads, 0 meaning the calling thread only. Values &lt; 0 are set to 0.
+     */
+    void Compressor::setZstdWorkers(int workers) {
+        zstdWorkers = workers < 0 ? 0 : workers;
+    }
+
+
+#ifdef USE_ZSTD
+
+
+    /**
+     * Zstd compression. Returns length of compressed data in bytes.
+     * The output is a standard zstd frame which includes the uncompressed size.
+     *
+     * @param src      source of uncompressed data.
+     * @param srcOff   start offset in src.
+     * @param srcSize  number of bytes to compress.
+     * @param dst      destination array.
+     * @param dstOff   start offset in dst.
+     * @param maxSize  maximum number of bytes to write in dst.
+     * @param dict     dictionary to compress with, or nullptr if none.
+     *                 Its zstd level is used instead of {@link #getZstdLevel()}.
+     * @return length of compressed data in bytes.
+     * @throws EvioException if maxSize &lt; max # of compressed bytes or compression failed.
+     */
+    int Compressor::compressZstd(uint8_t *src, int srcOff, int srcSize,
+                                 uint8_t *dst, int dstOff, int maxSize,
+                                 const CompressionDictionary *dict) {
+
+        if (ZSTD_compressBound(srcSize) > (size_t)maxSize) {
+            throw EvioException("maxSize (" + std::to_string(maxSize) +
+                                ") is < max # of compressed bytes (" +
+                                        std::to_string(ZSTD_compressBound(srcSize)) + ")");
+        }
+
+        ZSTD_CCtx *cctx = zstdContexts.cctx;
+        if (cctx == nullptr) {
+            cctx = zstdContexts.cctx = ZSTD_createCCtx();
+            if (cctx == nullptr) {
+                throw EvioException("cannot create zstd compression context");
+            }
+        }
+
+        // Parameters are sticky, but may have been changed since last call
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, zstdLevel);
+        // Fails harmlessly if the library has no multithreading
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, zstdWorkers);
+        // Dictionary is sticky too, nullptr goes back to none
+        ZSTD_CCtx_refCDict(cctx, dict == nullptr ? nullptr : dict->getZstdCDict());
+
+        size_t size = ZSTD_compress2(cctx, dst + dstOff, maxSize, src + srcOff, srcSize);
+        if (ZSTD_isError(size)) {
+            throw EvioException("compression failed: " + std::string(ZSTD_getErrorName(size)));
+        }
+
+        return (int) size;
+    }
+
+
+    /**
+     * Zstd compression. Returns length of compressed data in bytes.
+     *
+     * @param src      source of uncompressed data.
+     * @param srcOff   start offset in src regardless of position.
+     * @param srcSize  number of bytes to compress.
+     * @param dst      destination array.
+     * @param dstOff   start offset in dst regardless of position.
+     * @param maxSize  maximum number of bytes to write in dst.
+     * @param dict     dictionary to compress with, or nullptr if none.
+     * @return length of compressed data in bytes.
+     * @throws EvioException if maxSize &lt; max # of compressed bytes or compression failed.
+     */
+    int Compressor::compressZstd(ByteBuffer & src, int srcOff, int srcSize,
+                                 ByteBuffer & dst, int dstOff, int maxSize,
+                                 const CompressionDictionary *dict) {
+        return compressZstd(src.array(), srcOff, srcSize, dst.array(), dstOff, maxSize, dict);
+    }
+
+
+    /**
+     * Zstd decompression into dst starting at its position.
+     * Returns original length of decompressed data in bytes.
+     *
+     * @param src      source of compressed data.
+     * @param srcOff   start offset in src.
+     * @param srcSize  number of compressed bytes.
+     * @param dst      destination buffer.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
+     * @return original (uncompressed) input size.
+     * @throws EvioException if destination buffer is too small to hold uncompressed data or
+     *                       source data is malformed.
+     */
+    int Compressor::uncompressZstd(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst,
+                                   const CompressionDictionary *dict) {
+
+        int dstOff = dst.position();
+        int size = uncompressZstd(src.array(), srcOff, srcSize, dst.array(), dstOff, dst.remaining(), dict);
+
+        // Prepare buffer for reading
+        dst.limit(dstOff + size).position(dstOff);
+        return size;
+    }
+
+
+    /**
+     * Zstd decompression. Returns original length of decompressed data in bytes.
+     *
+     * @param src      source of compressed data.
+     * @param srcOff   start offset in src.
+     * @param srcSize  number of compressed bytes.
+     * @param dst      destination array.
+     * @param dstOff   start offset in dst.
+     * @param dstCapacity size of destination buffer in bytes, which must be already allocated.
+     * @param dict     dictionary data was compressed with, or nullptr if none.
+     * @return original (uncompressed) input size.
+     * @throws EvioException if uncompressed data bytes &gt; dstCapacity or
+     *                       source data is malformed.
+     */
+    int Compressor::uncompressZstd(uint8_t *src, int srcOff, int srcSize, uint8_t *dst,
+                                   int dstOff, int dstCapacity, const CompressionDictionary *dict) {
+
+        ZSTD_DCtx *dctx = zstdContexts.dctx;
+        if (dctx == nullptr) {
+            dctx = zstdContexts.dctx = ZSTD_createDCtx();
+            if (dctx == nullptr) {
+                throw EvioException("cannot create zstd decompression context");
+            }
+        }
+
+        size_t size;
+        if (dict == nullptr) {
+            size = ZSTD_decompressDCtx(dctx, dst + dstOff, dstCapacity, src + srcOff, srcSize);
+        }
+        else {
+            size = ZSTD_decompress_usingDDict(dctx, dst + dstOff, dstCapacity,
+                                              src + srcOff, srcSize, dict->getZstdDDict());
+        }
+        if (ZSTD_isError(size)) {
+            throw EvioException("destination buffer too small or data malformed: " +
+                                std::string(ZSTD_getErrorName(size)));
+        }
+
+        return (int) size;
+    }
+
+
+#endif
+
 }
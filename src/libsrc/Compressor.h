@@ -17,10 +17,15 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstring>
 
 
 #include "EvioException.h"
 #include "ByteBuffer.h"
+#include "CompressionDictionary.h"
 #include "lz4.h"
 #include "lz4hc.h"
 
@@ -28,13 +33,26 @@
     #include "zlib.h"
 #endif
 
+#ifdef USE_ZSTD
+    #include "zstd.h"
+#endif
+
+#ifdef USE_QATZIP
+    #include "qatzip.h"
+#endif
+
 
 namespace evio {
 
 
     /**
      * Singleton class used to provide data compression and decompression in a variety of formats.
-     * This class in NOT thread safe when using the gzip deflating and inflating routines.
+     * This class is thread safe. Each thread calling it gets its own gzip streams, lz4 states
+     * and zstd contexts, which are created once and reused for every call made by that thread.
+     * LZ4 and zstd data may be compressed starting from a trained {@link CompressionDictionary},
+     * which must then also be used to decompress it.
+     * If compiled with USE_QATZIP, gzip compression is done by Intel QAT hardware when present,
+     * falling back to zlib otherwise.
      * @date 04/29/2019
      * @author timmer
      */
@@ -66,24 +84,64 @@ namespace evio {
             UNCOMPRESSED = 0,
             LZ4,
             LZ4_BEST,
-            GZIP
+            GZIP,
+            /** Zstandard, only available if compiled with USE_ZSTD. Not known to jevio 6.0. */
+            ZSTD
         };
 
         static CompressionType toCompressionType(uint32_t type);
 
+        /**
+         * Enum of filters which may rearrange data just before it is compressed so it
+         * compresses better, and which are undone just after it is decompressed.
+         * Arrays of 16 or 32 bit ADC values, whose high bytes change little, compress
+         * poorly as they are but well once the bytes of the same significance
+         * in all values are grouped together.
+         */
+        enum PreFilter {
+            NO_FILTER = 0,
+            /** Group the bytes of 16 bit values by significance. */
+            SHUFFLE_16,
+            /** Group the bytes of 32 bit values by significance. */
+            SHUFFLE_32,
+            /** Replace each 32 bit value by its difference from the one before, then group bytes as SHUFFLE_32. */
+            DELTA_SHUFFLE_32
+        };
+
+        static PreFilter toPreFilter(uint32_t filter);
+        static void filter(PreFilter type, uint8_t *data, uint32_t len, ByteOrder const & order);
+        static void unfilter(PreFilter type, uint8_t *data, uint32_t len, ByteOrder const & order);
+
     private:
 
 #ifdef USE_GZIP
-        static z_stream strmDeflate;
-        static z_stream strmInflate;
+        static z_stream & getDeflateStream();
+        static z_stream & getInflateStream();
 #endif
 
+        static void* getLz4State();
+        static void* getLz4HCState();
+        static LZ4_stream_t*   getLz4DictStream(const CompressionDictionary *dict);
+        static LZ4_streamHC_t* getLz4HCDictStream(const CompressionDictionary *dict);
+
         /** Number of bytes to read in a single call while doing gzip decompression. */
         static const uint32_t MTU = 1024*1024;
 
         /* Makes regular lz4 compression to be lz4Acceleration * 3% speed up. */
         static const int lz4Acceleration = 1;
 
+        /** Zstd compression level, 3 being zstd's own default. */
+        static std::atomic<int> zstdLevel;
+
+        /** Number of threads zstd uses to compress each record, 0 meaning the calling thread only. */
+        static std::atomic<int> zstdWorkers;
+
+        /** Use hardware for gzip compression if available? */
+        static std::atomic<bool> useHardwareGzip;
+
+        /** Was hardware for gzip compression found by the thread creating the singleton? */
+        static bool haveHardwareGzip;
+
         static uint32_t getYear(       ByteBuffer & buf);
         static uint32_t getRevisionId( ByteBuffer & buf, uint32_t board_id);
         static uint32_t getSubsystemId(ByteBuffer & buf, uint32_t board_id);
@@ -96,9 +154,38 @@ namespace evio {
 
         static int getMaxCompressedLength(CompressionType compressionType, uint32_t uncompressedLength);
 
+        static bool isSupported(CompressionType compressionType);
+
+        //---------------
+        // ZSTD
+        //---------------
+        static int  getZstdLevel();
+        static void setZstdLevel(int level);
+        static int  getZstdWorkers();
+        static void setZstdWorkers(int workers);
+
+#ifdef USE_ZSTD
+        static int compressZstd(uint8_t *src, int srcOff, int srcSize,
+                                uint8_t *dst, int dstOff, int maxSize,
+                                const CompressionDictionary *dict = nullptr);
+        static int compressZstd(ByteBuffer & src, int srcOff, int srcSize,
+                                ByteBuffer & dst, int dstOff, int maxSize,
+                                const CompressionDictionary *dict = nullptr);
+
+        static int uncompressZstd(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst,
+                                  const CompressionDictionary *dict = nullptr);
+        static int uncompressZstd(uint8_t *src, int srcOff, int srcSize, uint8_t *dst,
+                                  int dstOff, int dstCapacity,
+                                  const CompressionDictionary *dict = nullptr);
+#endif
+
         //---------------
         // GZIP
         //---------------
+        static bool isHardwareGzipAvailable();
+        static bool getUseHardwareGzip();
+        static void setUseHardwareGzip(bool use);
+
 #ifdef USE_GZIP
         static uint8_t* compressGZIP(uint8_t* ungzipped, uint32_t offset,
                                      uint32_t length, uint32_t *compLen);
@@ -121,20 +208,26 @@ namespace evio {
         //---------------
         static int compressLZ4(ByteBuffer & src, int srcSize, ByteBuffer & dst, int maxSize);
         static int compressLZ4(uint8_t *src, int srcOff, int srcSize,
-                               uint8_t *dst, int dstOff, int maxSize);
+                               uint8_t *dst, int dstOff, int maxSize,
+                               const CompressionDictionary *dict = nullptr);
         static int compressLZ4(ByteBuffer & src, int srcOff, int srcSize,
                                ByteBuffer & dst, int dstOff, int maxSize);
         static int compressLZ4Best(ByteBuffer & src, int srcSize, ByteBuffer & dst, int maxSize);
         static int compressLZ4Best(uint8_t *src, int srcOff, int srcSize,
-                                   uint8_t *dst, int dstOff, int maxSize);
+                                   uint8_t *dst, int dstOff, int maxSize,
+                                   const CompressionDictionary *dict = nullptr);
         static int compressLZ4Best(ByteBuffer & src, int srcOff, int srcSize,
                                    ByteBuffer & dst, int dstOff, int maxSize);
 
-        static int uncompressLZ4(ByteBuffer & src, int srcSize, ByteBuffer & dst);
-        static int uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst);
-        static int uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst, int dstOff);
+        static int uncompressLZ4(ByteBuffer & src, int srcSize, ByteBuffer & dst,
+                                 const CompressionDictionary *dict = nullptr);
+        static int uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst,
+                                 const CompressionDictionary *dict = nullptr);
+        static int uncompressLZ4(ByteBuffer & src, int srcOff, int srcSize, ByteBuffer & dst, int dstOff,
+                                 const CompressionDictionary *dict = nullptr);
         static int uncompressLZ4(uint8_t *src, int srcOff, int srcSize, uint8_t *dst,
-                                 int dstOff, int dstCapacity);
+                                 int dstOff, int dstCapacity,
+                                 const CompressionDictionary *dict = nullptr);
 
 
     };
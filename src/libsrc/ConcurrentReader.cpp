@@ -0,0 +1,325 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "ConcurrentReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Reader.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which scans the file, using its index of records if it has one.
+     * @param filename        name of file.
+     * @param memoryMap       if true, memory map the file and read records from memory,
+     *                        uncompressed ones in place, instead of with pread.
+     * @param verifyChecksums if true, check each record read against any checksum in its header.
+     * @throws EvioException if file cannot be opened or mapped,
+     *                       or is not in the proper format or earlier than version 6.
+     */
+    ConcurrentReader::ConcurrentReader(std::string const & filename, bool memoryMap, bool verifyChecksums) :
+            fileName(filename), verifyChecksums(verifyChecksums) {
+
+        {
+            // Only used to build the index, which is then never changed
+            Reader reader(filename, false, false);
+            byteOrder = reader.getByteOrder();
+            compressionDictionary = reader.getCompressionDictionary();
+
+            auto & positions = reader.getRecordPositions();
+            records.reserve(positions.size());
+            firstEvents.reserve(positions.size() + 1);
+            firstEvents.push_back(0);
+            for (auto & pos : positions) {
+                records.push_back({pos.getPosition(), pos.getLength(), pos.getCount()});
+                firstEvents.push_back(firstEvents.back() + pos.getCount());
+            }
+        }
+
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw EvioException("cannot open file " + filename);
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw EvioException("cannot get size of file " + filename);
+        }
+        fileSize = st.st_size;
+
+        if (memoryMap) {
+            void *pmem = fileSize > 0 ? ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            // Mapping stays valid after fd is closed
+            ::close(fd);
+            fd = -1;
+
+            if (pmem == MAP_FAILED) {
+                throw EvioException("cannot map file " + filename);
+            }
+            mappedFile = std::make_shared<ByteBuffer>(static_cast<char *>(pmem), fileSize, true);
+            mappedFile->order(byteOrder);
+        }
+    }
+
+
+    /**
+     * Destructor which closes the file. A memory mapped file is unmapped
+     * once no session, or event read in place, refers to it any longer.
+     */
+    ConcurrentReader::~ConcurrentReader() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+
+    /**
+     * Get the name of the file being read.
+     * @return name of file.
+     */
+    std::string ConcurrentReader::getFileName() const {return fileName;}
+
+
+    /**
+     * Is the file memory mapped?
+     * @return true if file is memory mapped, false if read with pread.
+     */
+    bool ConcurrentReader::isMemoryMapped() const {return mappedFile != nullptr;}
+
+
+    /**
+     * Get the byte order of the file.
+     * @return byte order of file.
+     */
+    const ByteOrder & ConcurrentReader::getByteOrder() const {return byteOrder;}
+
+
+    /**
+     * Get the number of events in the file.
+     * @return number of events in file.
+     */
+    uint32_t ConcurrentReader::getEventCount() const {return firstEvents.back();}
+
+
+    /**
+     * Get the number of records in the file.
+     * @return number of records in file.
+     */
+    uint32_t ConcurrentReader::getRecordCount() const {return (uint32_t)records.size();}
+
+
+    /**
+     * Read a whole record from the file with pread, which leaves no file position
+     * to share between threads.
+     * @param recordIndex index of record.
+     * @param dest        where to read record into.
+     * @throws EvioException if read fails or file is too short.
+     */
+    void ConcurrentReader::readFile(uint32_t recordIndex, uint8_t *dest) {
+        size_t pos  = records[recordIndex].position;
+        size_t left = records[recordIndex].length;
+
+        while (left > 0) {
+            ssize_t n = ::pread(fd, dest, left, pos);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException("error reading file " + fileName + ": " + std::strerror(errno));
+            }
+            if (n == 0) {
+                throw EvioException("file " + fileName + " too short to contain record");
+            }
+            dest += n;
+            pos  += n;
+            left -= n;
+        }
+    }
+
+
+    /**
+     * Find the record holding an event.
+     * @param index of event in file.
+     * @return index of record.
+     */
+    uint32_t ConcurrentReader::findRecord(uint32_t index) const {
+        // Last record starting at or before index, which skips over any with no events
+        auto it = std::upper_bound(firstEvents.begin(), firstEvents.end(), index);
+        return (uint32_t)(it - firstEvents.begin()) - 1;
+    }
+
+
+    /**
+     * Read a record into a session, unless it holds that record already.
+     * The record stays valid until the session reads another.
+     *
+     * @param session     state of the calling thread.
+     * @param recordIndex index of record.
+     * @return record read.
+     * @throws EvioException if index out of bounds, or record cannot be read or is malformed.
+     */
+    RecordInput & ConcurrentReader::readRecord(Session & session, uint32_t recordIndex) {
+        if (recordIndex >= records.size()) {
+            throw EvioException("index out of bounds");
+        }
+
+        if (session.haveRecord && session.recordIndex == recordIndex) {
+            return session.record;
+        }
+        session.haveRecord = false;
+
+        session.record.setVerifyChecksum(verifyChecksums);
+        session.record.setCompressionDictionary(compressionDictionary);
+
+        if (mappedFile != nullptr) {
+            // Reading a buffer changes its byte order and limit, so each session has its own.
+            // Unlike a duplicate, it shares ownership of the mapping, so events in place
+            // keep the file mapped even once this reader is gone.
+            if (session.mappedView == nullptr) {
+                session.mappedView = std::make_shared<ByteBuffer>(
+                        std::shared_ptr<uint8_t>(mappedFile, mappedFile->array()), mappedFile->capacity());
+                session.mappedView->order(byteOrder);
+            }
+            session.record.readRecordInPlace(session.mappedView, records[recordIndex].position);
+        }
+        else {
+            uint32_t length = records[recordIndex].length;
+            if (session.fileBuffer == nullptr || session.fileBuffer->capacity() < length) {
+                session.fileBuffer = std::make_shared<ByteBuffer>(length);
+            }
+            readFile(recordIndex, session.fileBuffer->array());
+            session.fileBuffer->clear();
+            session.fileBuffer->limit(length);
+            session.record.readRecord(*(session.fileBuffer.get()), 0);
+        }
+
+        session.recordIndex = recordIndex;
+        session.haveRecord = true;
+        return session.record;
+    }
+
+
+    /**
+     * Read the record holding an event into a session.
+     * @param session       state of the calling thread.
+     * @param index         index of event in file.
+     * @param eventInRecord set to index of event in record.
+     * @return record read.
+     * @throws EvioException if record cannot be read or is malformed.
+     */
+    RecordInput & ConcurrentReader::loadEventRecord(Session & session, uint32_t index, uint32_t & eventInRecord) {
+        uint32_t recordIndex = findRecord(index);
+        eventInRecord = index - firstEvents[recordIndex];
+        return readRecord(session, recordIndex);
+    }
+
+
+    /**
+     * Get a copy of an event, or, from an uncompressed record of a memory mapped file,
+     * the event in place.
+     * @param session state of the calling thread.
+     * @param index   index of event in file, starting at 0.
+     * @param len     pointer to int that gets filled with the event's length in bytes.
+     * @return event, or null if index is out of bounds.
+     * @throws EvioException if record cannot be read or is malformed.
+     */
+    std::shared_ptr<uint8_t> ConcurrentReader::getEvent(Session & session, uint32_t index, uint32_t *len) {
+        if (index >= getEventCount()) {
+            return nullptr;
+        }
+
+        uint32_t eventInRecord;
+        RecordInput & record = loadEventRecord(session, index, eventInRecord);
+        return record.getEvent(eventInRecord, len);
+    }
+
+
+    /**
+     * Get a view of an event without copying it.
+     * The view is valid only until the session reads another record.
+     * @param session state of the calling thread.
+     * @param index   index of event in file, starting at 0.
+     * @return view of the event's bytes, empty if index is out of bounds.
+     * @throws EvioException if record cannot be read or is malformed.
+     */
+    ByteBufferView ConcurrentReader::getEventView(Session & session, uint32_t index) {
+        if (index >= getEventCount()) {
+            return ByteBufferView();
+        }
+
+        uint32_t eventInRecord;
+        RecordInput & record = loadEventRecord(session, index, eventInRecord);
+        return record.getEventView(eventInRecord);
+    }
+
+
+    /**
+     * Get the length of an event.
+     * @param session state of the calling thread.
+     * @param index   index of event in file, starting at 0.
+     * @return length of event in bytes, 0 if index is out of bounds.
+     * @throws EvioException if record cannot be read or is malformed.
+     */
+    uint32_t ConcurrentReader::getEventLength(Session & session, uint32_t index) {
+        if (index >= getEventCount()) {
+            return 0;
+        }
+
+        uint32_t eventInRecord;
+        RecordInput & record = loadEventRecord(session, index, eventInRecord);
+        return record.getEventLength(eventInRecord);
+    }
+
+
+    /**
+     * Get an event as {@link #getEvent(Session &, uint32_t, uint32_t *)} does,
+     * with a session borrowed from a pool shared by all threads.
+     * @param index index of event in file, starting at 0.
+     * @param len   pointer to int that gets filled with the event's length in bytes.
+     * @return event, or null if index is out of bounds.
+     * @throws EvioException if record cannot be read or is malformed.
+     */
+    std::shared_ptr<uint8_t> ConcurrentReader::getEvent(uint32_t index, uint32_t *len) {
+        std::unique_ptr<Session> session;
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            if (!sessions.empty()) {
+                session = std::move(sessions.back());
+                sessions.pop_back();
+            }
+        }
+        if (session == nullptr) {
+            session.reset(new Session());
+        }
+
+        std::shared_ptr<uint8_t> event;
+        try {
+            event = getEvent(*session, index, len);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            sessions.push_back(std::move(session));
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        sessions.push_back(std::move(session));
+        return event;
+    }
+
+}
@@ -0,0 +1,145 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_CONCURRENTREADER_H
+#define EVIO_6_0_CONCURRENTREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+
+#include "ByteOrder.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "RecordInput.h"
+#include "CompressionDictionary.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads events of an evio version 6 file at random from many threads at once.
+     * Unlike {@link Reader}, which has one file position and one record being read, it has no
+     * state that changes once constructed: the file is scanned once into an index of records
+     * and events shared by all threads, and records are read with positional reads (pread)
+     * or, if the file is memory mapped, straight from memory. Each thread has its own
+     * {@link Session} holding the record it read last, which it decompresses into.<p>
+     *
+     * <pre><code>
+     *    ConcurrentReader reader("run.evio");
+     *    // In each thread
+     *    ConcurrentReader::Session session;
+     *    uint32_t len;
+     *    auto event = reader.getEvent(session, index, &len);
+     * </code></pre>
+     *
+     * Threads without a session of their own may call {@link #getEvent(uint32_t, uint32_t *)},
+     * which borrows one from a pool.
+     */
+    class ConcurrentReader {
+
+    public:
+
+        /** State of one thread reading: the record it read last. Use in one thread at a time. */
+        class Session {
+
+            friend class ConcurrentReader;
+
+        private:
+
+            /** Record read last, decompressed. */
+            RecordInput record;
+            /** Record as read from file, before decompression. */
+            std::shared_ptr<ByteBuffer> fileBuffer = nullptr;
+            /** This session's own view of the memory mapped file. */
+            std::shared_ptr<ByteBuffer> mappedView = nullptr;
+            /** Index of record read last. */
+            uint32_t recordIndex = 0;
+            /** Has a record been read? */
+            bool haveRecord = false;
+        };
+
+
+    private:
+
+        /** Place and size of a record in the file. */
+        struct RecordEntry {
+            /** Position in file. */
+            size_t position;
+            /** Length in bytes, header included. */
+            uint32_t length;
+            /** Number of events. */
+            uint32_t count;
+        };
+
+        /** File name. */
+        std::string fileName;
+        /** File descriptor read with pread, -1 if memory mapped. */
+        int fd = -1;
+        /** File size in bytes. */
+        size_t fileSize = 0;
+        /** Buffer wrapping the memory mapped file, null if not mapped. */
+        std::shared_ptr<ByteBuffer> mappedFile = nullptr;
+        /** Byte order of file. */
+        ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
+
+        /** Records in the file, in order. */
+        std::vector<RecordEntry> records;
+        /** Index of each record's first event in the file, with one more entry for the total. */
+        std::vector<uint32_t> firstEvents;
+
+        /** Trained dictionary needed to decompress records, else null. */
+        std::shared_ptr<CompressionDictionary> compressionDictionary = nullptr;
+        /** If true, check each record read against any checksum in its header. */
+        bool verifyChecksums = false;
+
+        /** Sessions not in use by {@link #getEvent(uint32_t, uint32_t *)}. */
+        std::vector<std::unique_ptr<Session>> sessions;
+        /** Guards sessions. */
+        std::mutex sessionMutex;
+
+        void readFile(uint32_t recordIndex, uint8_t *dest);
+        uint32_t findRecord(uint32_t index) const;
+        RecordInput & loadEventRecord(Session & session, uint32_t index, uint32_t & eventInRecord);
+
+    public:
+
+        explicit ConcurrentReader(std::string const & filename, bool memoryMap = false,
+                                  bool verifyChecksums = false);
+        ~ConcurrentReader();
+
+        ConcurrentReader(const ConcurrentReader &) = delete;
+        ConcurrentReader & operator=(const ConcurrentReader &) = delete;
+
+        std::string getFileName() const;
+        bool isMemoryMapped() const;
+        const ByteOrder & getByteOrder() const;
+        uint32_t getEventCount() const;
+        uint32_t getRecordCount() const;
+
+        RecordInput & readRecord(Session & session, uint32_t recordIndex);
+
+        std::shared_ptr<uint8_t> getEvent(Session & session, uint32_t index, uint32_t *len);
+        ByteBufferView getEventView(Session & session, uint32_t index);
+        uint32_t getEventLength(Session & session, uint32_t index);
+
+        std::shared_ptr<uint8_t> getEvent(uint32_t index, uint32_t *len);
+    };
+
+}
+
+
+#endif //EVIO_6_0_CONCURRENTREADER_H
@@ -0,0 +1,144 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "Crc32c.h"
+
+#include <cstring>
+
+
+// On x86 the crc instruction is used if found at run time. On 64 bit ARM
+// it's used only if the compiler was told the cpu has it.
+#if defined(__GNUC__) && defined(__x86_64__)
+    #define EVIO_CRC_X86 1
+    #include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #define EVIO_CRC_ARM 1
+    #include <arm_acle.h>
+#endif
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** Type of function which continues a checksum over the given data, not inverted. */
+        typedef uint32_t (*CrcKernel)(uint32_t crc, const uint8_t *data, size_t length);
+
+        /** Name of the kernel in use, returned by Crc32c::getImplementation(). */
+        const char *crcKernelName = "table";
+
+        /** Table of the checksum of each byte value, reflected Castagnoli polynomial. */
+        struct CrcTable {
+            uint32_t entry[256];
+            CrcTable() {
+                for (uint32_t i=0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int j=0; j < 8; j++) {
+                        c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1;
+                    }
+                    entry[i] = c;
+                }
+            }
+        };
+
+        uint32_t crcTable(uint32_t crc, const uint8_t *data, size_t length) {
+            static const CrcTable table;
+            for (size_t i=0; i < length; i++) {
+                crc = table.entry[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+#ifdef EVIO_CRC_X86
+
+        __attribute__((target("sse4.2")))
+        uint32_t crcSse42(uint32_t crc, const uint8_t *data, size_t length) {
+            uint64_t c = crc;
+            size_t i = 0;
+            for (; i + 8 <= length; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, data + i, 8);
+                c = _mm_crc32_u64(c, word);
+            }
+            uint32_t c32 = static_cast<uint32_t>(c);
+            for (; i < length; i++) {
+                c32 = _mm_crc32_u8(c32, data[i]);
+            }
+            return c32;
+        }
+
+        CrcKernel selectCrcKernel() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse4.2")) {
+                crcKernelName = "sse4.2";
+                return crcSse42;
+            }
+            return crcTable;
+        }
+
+#elif defined(EVIO_CRC_ARM)
+
+        uint32_t crcArm(uint32_t crc, const uint8_t *data, size_t length) {
+            size_t i = 0;
+            for (; i + 8 <= length; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, data + i, 8);
+                crc = __crc32cd(crc, word);
+            }
+            for (; i < length; i++) {
+                crc = __crc32cb(crc, data[i]);
+            }
+            return crc;
+        }
+
+        CrcKernel selectCrcKernel() {
+            crcKernelName = "armv8 crc";
+            return crcArm;
+        }
+
+#else
+
+        CrcKernel selectCrcKernel() {return crcTable;}
+
+#endif
+
+        /** @return kernel picked the first time this is called (thread safe). */
+        CrcKernel getCrcKernel() {
+            static const CrcKernel kernel = selectCrcKernel();
+            return kernel;
+        }
+    }
+
+
+    /**
+     * Calculate the CRC32C checksum of the given data.
+     *
+     * @param data   data to checksum.
+     * @param length number of bytes.
+     * @param crc    checksum of preceding data, if calculating in pieces, else 0.
+     * @return checksum.
+     */
+    uint32_t Crc32c::compute(const uint8_t *data, size_t length, uint32_t crc) {
+        return ~getCrcKernel()(~crc, data, length);
+    }
+
+
+    /**
+     * Get the name of the method used to calculate checksums.
+     * It is picked, the first time it's needed, as the best this cpu supports.
+     * @return "sse4.2", "armv8 crc", or "table" if no crc instruction is used.
+     */
+    std::string Crc32c::getImplementation() {
+        getCrcKernel();
+        return crcKernelName;
+    }
+
+}
@@ -0,0 +1,44 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_CRC32C_H
+#define EVIO_6_0_CRC32C_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+
+namespace evio {
+
+
+    /**
+     * This class calculates the CRC32C (Castagnoli) checksum used to check the integrity
+     * of records (see {@link RecordHeader#CHECKSUM_BIT}). The cpu's crc instruction is
+     * used if it has one (SSE4.2 on x86, the CRC extension on 64 bit ARM), which runs at
+     * close to memory bandwidth. Otherwise a table is used, one byte at a time.<p>
+     *
+     * A checksum may be calculated in pieces by passing the result of one call
+     * as the starting value of the next.
+     */
+    class Crc32c {
+
+    public:
+
+        static uint32_t compute(const uint8_t *data, size_t length, uint32_t crc = 0);
+        static std::string getImplementation();
+
+    };
+
+}
+
+
+#endif //EVIO_6_0_CRC32C_H
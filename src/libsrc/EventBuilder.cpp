@@ -162,11 +162,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::INT32);
 
-        auto vect = structure->getIntData();
+        auto & vect = structure->getIntData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateIntData();
         setAllHeaderLengths();
     }
@@ -187,11 +185,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::UINT32);
 
-        auto vect = structure->getUIntData();
+        auto & vect = structure->getUIntData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateUIntData();
         setAllHeaderLengths();
     }
@@ -212,11 +208,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::SHORT16);
 
-        auto vect = structure->getShortData();
+        auto & vect = structure->getShortData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateShortData();
         setAllHeaderLengths();
     }
@@ -237,11 +231,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::USHORT16);
 
-        auto vect = structure->getUShortData();
+        auto & vect = structure->getUShortData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateUShortData();
         setAllHeaderLengths();
     }
@@ -262,11 +254,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::LONG64);
 
-        auto vect = structure->getLongData();
+        auto & vect = structure->getLongData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateLongData();
         setAllHeaderLengths();
     }
@@ -287,11 +277,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::ULONG64);
 
-        auto vect = structure->getULongData();
+        auto & vect = structure->getULongData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateULongData();
         setAllHeaderLengths();
     }
@@ -312,11 +300,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::CHAR8);
 
-        auto vect = structure->getCharData();
+        auto & vect = structure->getCharData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateCharData();
         setAllHeaderLengths();
     }
@@ -337,11 +323,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::UCHAR8);
 
-        auto vect = structure->getUCharData();
+        auto & vect = structure->getUCharData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateUCharData();
         setAllHeaderLengths();
     }
@@ -362,11 +346,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::FLOAT32);
 
-        auto vect = structure->getFloatData();
+        auto & vect = structure->getFloatData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateFloatData();
         setAllHeaderLengths();
     }
@@ -387,11 +369,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::DOUBLE64);
 
-        auto vect = structure->getDoubleData();
+        auto & vect = structure->getDoubleData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateDoubleData();
         setAllHeaderLengths();
     }
@@ -412,11 +392,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::CHARSTAR8);
 
-        auto vect = structure->getStringData();
+        auto & vect = structure->getStringData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateStringData();
         setAllHeaderLengths();
     }
@@ -438,11 +416,9 @@ namespace evio {
 
         structure->getHeader()->setDataType(DataType::COMPOSITE);
 
-        auto vect = structure->getCompositeData();
+        auto & vect = structure->getCompositeData();
         vect.clear();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        vect.insert(vect.end(), data, data + count);
         structure->updateCompositeData();
         setAllHeaderLengths();
     }
@@ -469,10 +445,8 @@ namespace evio {
                                 structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getIntData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getIntData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateIntData();
         setAllHeaderLengths();
     }
@@ -495,10 +469,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getUIntData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getUIntData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateUIntData();
         setAllHeaderLengths();
     }
@@ -521,10 +493,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getShortData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getShortData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateShortData();
         setAllHeaderLengths();
     }
@@ -547,10 +517,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getUShortData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getUShortData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateUShortData();
         setAllHeaderLengths();
     }
@@ -573,10 +541,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getLongData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getLongData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateLongData();
         setAllHeaderLengths();
     }
@@ -599,10 +565,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getULongData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getULongData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateULongData();
         setAllHeaderLengths();
     }
@@ -625,10 +589,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getCharData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getCharData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateCharData();
         setAllHeaderLengths();
     }
@@ -651,10 +613,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getUCharData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getUCharData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateUCharData();
         setAllHeaderLengths();
     }
@@ -677,10 +637,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getFloatData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getFloatData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateFloatData();
         setAllHeaderLengths();
     }
@@ -703,10 +661,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getDoubleData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getDoubleData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateDoubleData();
         setAllHeaderLengths();
     }
@@ -729,10 +685,8 @@ namespace evio {
             throw EvioException("cannot append ints to structure of type " + structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getStringData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getStringData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateStringData();
         setAllHeaderLengths();
     }
@@ -757,15 +711,715 @@ namespace evio {
                                 structure->getHeader()->getDataType().getName());
         }
 
-        auto vect = structure->getCompositeData();
-        for (int i=0; i < count; i++) {
-            vect.push_back(data[i]);
-        }
+        auto & vect = structure->getCompositeData();
+        vect.insert(vect.end(), data, data + count);
         structure->updateCompositeData();
         setAllHeaderLengths();
     }
 
 
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Set ints in the structure, moving the vector into it and leaving it empty.
+     * This saves one copy of the data compared to passing a vector by reference.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data vector of ints to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see BaseStructure#setIntData(std::vector<int32_t> &&)
+     */
+    void EventBuilder::setIntData(std::shared_ptr<BaseStructure> structure, std::vector<int32_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setIntData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set unsigned ints in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned ints to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setUIntData(std::shared_ptr<BaseStructure> structure, std::vector<uint32_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setUIntData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set shorts in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of shorts to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setShortData(std::shared_ptr<BaseStructure> structure, std::vector<int16_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setShortData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set unsigned shorts in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned shorts to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setUShortData(std::shared_ptr<BaseStructure> structure, std::vector<uint16_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setUShortData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set longs in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of longs to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setLongData(std::shared_ptr<BaseStructure> structure, std::vector<int64_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setLongData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set unsigned longs in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned longs to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setULongData(std::shared_ptr<BaseStructure> structure, std::vector<uint64_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setULongData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set signed chars in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of signed chars to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setCharData(std::shared_ptr<BaseStructure> structure, std::vector<signed char> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setCharData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set unsigned chars in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned chars to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setUCharData(std::shared_ptr<BaseStructure> structure, std::vector<unsigned char> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setUCharData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set floats in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of floats to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setFloatData(std::shared_ptr<BaseStructure> structure, std::vector<float> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setFloatData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set doubles in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of doubles to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setDoubleData(std::shared_ptr<BaseStructure> structure, std::vector<double> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDoubleData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set strings in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of strings to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setStringData(std::shared_ptr<BaseStructure> structure, std::vector<std::string> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setStringData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Set composite data items in the structure, moving the vector into it and leaving it empty.
+     * @param structure the structure to receive the data.
+     * @param data vector of composite data items to be moved.
+     * @throws EvioException if structure arg is null, or structure has children.
+     * @see #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::setCompositeData(std::shared_ptr<BaseStructure> structure, std::vector<std::shared_ptr<CompositeData>> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setCompositeData(std::move(data));
+        setAllHeaderLengths();
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Append ints to the structure. If the structure has no data, this is the same as
+     * setting it with {@link #setIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)},
+     * except the data type may not be changed. Otherwise the ints are added after the existing ones.
+     * @param structure the structure to receive the data.
+     * @param data vector of ints to be moved.
+     * @throws EvioException if structure arg is null, data type is not INT32.
+     */
+    void EventBuilder::appendIntData(std::shared_ptr<BaseStructure> structure, std::vector<int32_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::INT32) {
+            throw EvioException("cannot append ints to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setIntData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getIntData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateIntData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append unsigned ints to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned ints to be moved.
+     * @throws EvioException if structure arg is null, data type is not UINT32.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendUIntData(std::shared_ptr<BaseStructure> structure, std::vector<uint32_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::UINT32) {
+            throw EvioException("cannot append unsigned ints to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setUIntData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getUIntData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateUIntData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append shorts to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of shorts to be moved.
+     * @throws EvioException if structure arg is null, data type is not SHORT16.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendShortData(std::shared_ptr<BaseStructure> structure, std::vector<int16_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::SHORT16) {
+            throw EvioException("cannot append shorts to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setShortData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getShortData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateShortData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append unsigned shorts to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned shorts to be moved.
+     * @throws EvioException if structure arg is null, data type is not USHORT16.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendUShortData(std::shared_ptr<BaseStructure> structure, std::vector<uint16_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::USHORT16) {
+            throw EvioException("cannot append unsigned shorts to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setUShortData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getUShortData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateUShortData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append longs to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of longs to be moved.
+     * @throws EvioException if structure arg is null, data type is not LONG64.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendLongData(std::shared_ptr<BaseStructure> structure, std::vector<int64_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::LONG64) {
+            throw EvioException("cannot append longs to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setLongData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getLongData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateLongData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append unsigned longs to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned longs to be moved.
+     * @throws EvioException if structure arg is null, data type is not ULONG64.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendULongData(std::shared_ptr<BaseStructure> structure, std::vector<uint64_t> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::ULONG64) {
+            throw EvioException("cannot append unsigned longs to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setULongData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getULongData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateULongData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append signed chars to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of signed chars to be moved.
+     * @throws EvioException if structure arg is null, data type is not CHAR8.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendCharData(std::shared_ptr<BaseStructure> structure, std::vector<signed char> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::CHAR8) {
+            throw EvioException("cannot append signed chars to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setCharData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getCharData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateCharData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append unsigned chars to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of unsigned chars to be moved.
+     * @throws EvioException if structure arg is null, data type is not UCHAR8.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendUCharData(std::shared_ptr<BaseStructure> structure, std::vector<unsigned char> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::UCHAR8) {
+            throw EvioException("cannot append unsigned chars to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setUCharData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getUCharData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateUCharData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append floats to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of floats to be moved.
+     * @throws EvioException if structure arg is null, data type is not FLOAT32.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendFloatData(std::shared_ptr<BaseStructure> structure, std::vector<float> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::FLOAT32) {
+            throw EvioException("cannot append floats to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setFloatData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getFloatData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateFloatData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append doubles to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of doubles to be moved.
+     * @throws EvioException if structure arg is null, data type is not DOUBLE64.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendDoubleData(std::shared_ptr<BaseStructure> structure, std::vector<double> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::DOUBLE64) {
+            throw EvioException("cannot append doubles to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setDoubleData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getDoubleData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateDoubleData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append strings to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of strings to be moved.
+     * @throws EvioException if structure arg is null, data type is not CHARSTAR8.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendStringData(std::shared_ptr<BaseStructure> structure, std::vector<std::string> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::CHARSTAR8) {
+            throw EvioException("cannot append strings to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setStringData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getStringData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateStringData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Append composite data items to the structure.
+     * @param structure the structure to receive the data.
+     * @param data vector of composite data items to be moved.
+     * @throws EvioException if structure arg is null, data type is not COMPOSITE.
+     * @see #appendIntData(std::shared_ptr<BaseStructure>, std::vector<int32_t> &&)
+     */
+    void EventBuilder::appendCompositeData(std::shared_ptr<BaseStructure> structure, std::vector<std::shared_ptr<CompositeData>> && data) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        if (structure->getHeader()->getDataType() != DataType::COMPOSITE) {
+            throw EvioException("cannot append composite data items to structure of type " +
+                                structure->getHeader()->getDataType().getName());
+        }
+
+        if (structure->getRawBytesView().size() == 0) {
+            structure->setCompositeData(std::move(data));
+        }
+        else {
+            auto & vect = structure->getCompositeData();
+            vect.insert(vect.end(), std::make_move_iterator(data.begin()), std::make_move_iterator(data.end()));
+            data.clear();
+            structure->updateCompositeData();
+        }
+        setAllHeaderLengths();
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Make the structure's data a view of an array of ints, for a structure which only
+     * needs to be written. Nothing is copied until the event is written, when the ints
+     * go straight into the output, so the array must not be changed or freed until then.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data pointer to data (array of ints, in local byte order).
+     * @param count number of ints.
+     * @throws EvioException if structure or data arg(s) is null, or structure has children.
+     * @see BaseStructure#setDataView
+     */
+    void EventBuilder::setDataView(std::shared_ptr<BaseStructure> structure, const int32_t *data, size_t count) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDataView(data, count);
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Make the structure's data a view of an array of unsigned ints, for a structure which only
+     * needs to be written. Nothing is copied until the event is written, when the unsigned ints
+     * go straight into the output, so the array must not be changed or freed until then.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data pointer to data (array of unsigned ints, in local byte order).
+     * @param count number of unsigned ints.
+     * @throws EvioException if structure or data arg(s) is null, or structure has children.
+     * @see BaseStructure#setDataView
+     */
+    void EventBuilder::setDataView(std::shared_ptr<BaseStructure> structure, const uint32_t *data, size_t count) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDataView(data, count);
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Make the structure's data a view of an array of longs, for a structure which only
+     * needs to be written. Nothing is copied until the event is written, when the longs
+     * go straight into the output, so the array must not be changed or freed until then.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data pointer to data (array of longs, in local byte order).
+     * @param count number of longs.
+     * @throws EvioException if structure or data arg(s) is null, or structure has children.
+     * @see BaseStructure#setDataView
+     */
+    void EventBuilder::setDataView(std::shared_ptr<BaseStructure> structure, const int64_t *data, size_t count) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDataView(data, count);
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Make the structure's data a view of an array of unsigned longs, for a structure which only
+     * needs to be written. Nothing is copied until the event is written, when the unsigned longs
+     * go straight into the output, so the array must not be changed or freed until then.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data pointer to data (array of unsigned longs, in local byte order).
+     * @param count number of unsigned longs.
+     * @throws EvioException if structure or data arg(s) is null, or structure has children.
+     * @see BaseStructure#setDataView
+     */
+    void EventBuilder::setDataView(std::shared_ptr<BaseStructure> structure, const uint64_t *data, size_t count) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDataView(data, count);
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Make the structure's data a view of an array of floats, for a structure which only
+     * needs to be written. Nothing is copied until the event is written, when the floats
+     * go straight into the output, so the array must not be changed or freed until then.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data pointer to data (array of floats, in local byte order).
+     * @param count number of floats.
+     * @throws EvioException if structure or data arg(s) is null, or structure has children.
+     * @see BaseStructure#setDataView
+     */
+    void EventBuilder::setDataView(std::shared_ptr<BaseStructure> structure, const float *data, size_t count) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDataView(data, count);
+        setAllHeaderLengths();
+    }
+
+
+    /**
+     * Make the structure's data a view of an array of doubles, for a structure which only
+     * needs to be written. Nothing is copied until the event is written, when the doubles
+     * go straight into the output, so the array must not be changed or freed until then.
+     * If the structure has data, it is overwritten even if the existing data is of a different type.
+     * @param structure the structure to receive the data.
+     * @param data pointer to data (array of doubles, in local byte order).
+     * @param count number of doubles.
+     * @throws EvioException if structure or data arg(s) is null, or structure has children.
+     * @see BaseStructure#setDataView
+     */
+    void EventBuilder::setDataView(std::shared_ptr<BaseStructure> structure, const double *data, size_t count) {
+        if (structure == nullptr) {
+            throw EvioException("structure arg is null");
+        }
+
+        structure->setDataView(data, count);
+        setAllHeaderLengths();
+    }
+
+
     /**
      * Get the underlying event.
      * @return the underlying event.
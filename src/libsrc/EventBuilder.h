@@ -16,6 +16,8 @@
 #include <cstdio>
 #include <stdexcept>
 #include <memory>
+#include <vector>
+#include <iterator>
 
 
 #include "DataType.h"
@@ -87,6 +89,39 @@ namespace evio {
         void appendCompositeData(std::shared_ptr<BaseStructure> structure,
                                  std::shared_ptr<CompositeData> *data, size_t count);
 
+        void setIntData(std::shared_ptr<BaseStructure> structure, std::vector<int32_t> && data);
+        void setUIntData(std::shared_ptr<BaseStructure> structure, std::vector<uint32_t> && data);
+        void setShortData(std::shared_ptr<BaseStructure> structure, std::vector<int16_t> && data);
+        void setUShortData(std::shared_ptr<BaseStructure> structure, std::vector<uint16_t> && data);
+        void setLongData(std::shared_ptr<BaseStructure> structure, std::vector<int64_t> && data);
+        void setULongData(std::shared_ptr<BaseStructure> structure, std::vector<uint64_t> && data);
+        void setCharData(std::shared_ptr<BaseStructure> structure, std::vector<signed char> && data);
+        void setUCharData(std::shared_ptr<BaseStructure> structure, std::vector<unsigned char> && data);
+        void setFloatData(std::shared_ptr<BaseStructure> structure, std::vector<float> && data);
+        void setDoubleData(std::shared_ptr<BaseStructure> structure, std::vector<double> && data);
+        void setStringData(std::shared_ptr<BaseStructure> structure, std::vector<std::string> && data);
+        void setCompositeData(std::shared_ptr<BaseStructure> structure, std::vector<std::shared_ptr<CompositeData>> && data);
+
+        void appendIntData(std::shared_ptr<BaseStructure> structure, std::vector<int32_t> && data);
+        void appendUIntData(std::shared_ptr<BaseStructure> structure, std::vector<uint32_t> && data);
+        void appendShortData(std::shared_ptr<BaseStructure> structure, std::vector<int16_t> && data);
+        void appendUShortData(std::shared_ptr<BaseStructure> structure, std::vector<uint16_t> && data);
+        void appendLongData(std::shared_ptr<BaseStructure> structure, std::vector<int64_t> && data);
+        void appendULongData(std::shared_ptr<BaseStructure> structure, std::vector<uint64_t> && data);
+        void appendCharData(std::shared_ptr<BaseStructure> structure, std::vector<signed char> && data);
+        void appendUCharData(std::shared_ptr<BaseStructure> structure, std::vector<unsigned char> && data);
+        void appendFloatData(std::shared_ptr<BaseStructure> structure, std::vector<float> && data);
+        void appendDoubleData(std::shared_ptr<BaseStructure> structure, std::vector<double> && data);
+        void appendStringData(std::shared_ptr<BaseStructure> structure, std::vector<std::string> && data);
+        void appendCompositeData(std::shared_ptr<BaseStructure> structure, std::vector<std::shared_ptr<CompositeData>> && data);
+
+        void setDataView(std::shared_ptr<BaseStructure> structure, const int32_t *data, size_t count);
+        void setDataView(std::shared_ptr<BaseStructure> structure, const uint32_t *data, size_t count);
+        void setDataView(std::shared_ptr<BaseStructure> structure, const int64_t *data, size_t count);
+        void setDataView(std::shared_ptr<BaseStructure> structure, const uint64_t *data, size_t count);
+        void setDataView(std::shared_ptr<BaseStructure> structure, const float *data, size_t count);
+        void setDataView(std::shared_ptr<BaseStructure> structure, const double *data, size_t count);
+
         std::shared_ptr<EvioEvent> getEvent();
         void setEvent(std::shared_ptr<EvioEvent> & ev);
 
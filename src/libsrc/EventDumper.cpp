@@ -0,0 +1,805 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "EventDumper.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "CompositeCursor.h"
+#include "DataType.h"
+#include "ParallelEventReader.h"
+#include "Reader.h"
+
+
+namespace evio {
+
+
+    /** Header and data of one structure being written. */
+    struct EventDumper::Structure {
+        /** Element name in XML, structure kind in JSON. */
+        const char *name;
+        /** Event number, or -1 if not an event. */
+        int64_t number;
+        /** Tag. */
+        uint16_t tag;
+        /** Num, banks only. */
+        uint8_t num;
+        /** Is this a bank, with a num? */
+        bool isBank;
+        /** Type of data. */
+        uint32_t dataType;
+        /** Length from header, in words not counting the length word. */
+        uint32_t length;
+        /** Start of data. */
+        const uint8_t *data;
+        /** Bytes of data, not including padding. */
+        size_t dataBytes;
+    };
+
+
+    namespace {
+
+        /**
+         * Read a 32 bit word.
+         * @param p    pointer to word, need not be aligned.
+         * @param swap true if word must be swapped.
+         * @return word in local byte order.
+         */
+        uint32_t loadWord(const uint8_t *p, bool swap) {
+            uint32_t word;
+            std::memcpy(&word, p, 4);
+            return swap ? SWAP_32(word) : word;
+        }
+
+
+        /**
+         * Read a value of arithmetic type T.
+         * @param p    pointer to value, need not be aligned.
+         * @param swap true if value must be swapped.
+         * @return value in local byte order.
+         */
+        template<typename T>
+        T loadValue(const uint8_t *p, bool swap) {
+            uint8_t bytes[sizeof(T)];
+            std::memcpy(bytes, p, sizeof(T));
+            if (swap) {
+                for (size_t i=0; i < sizeof(T)/2; i++) std::swap(bytes[i], bytes[sizeof(T)-1-i]);
+            }
+            T value;
+            std::memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+
+
+        /**
+         * Append an integer in decimal.
+         * @param out   text to append to.
+         * @param value integer.
+         */
+        template<typename T>
+        void appendInt(std::string & out, T value) {
+            char buf[24];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr - buf);
+        }
+
+
+        /**
+         * Append an unsigned 32 bit integer as 0x followed by 8 hex digits.
+         * @param out   text to append to.
+         * @param value integer.
+         */
+        void appendHex(std::string & out, uint32_t value) {
+            static const char digits[] = "0123456789abcdef";
+            char buf[10] = {'0', 'x'};
+            for (int i=9; i > 1; i--, value >>= 4) buf[i] = digits[value & 0xf];
+            out.append(buf, 10);
+        }
+
+
+        /**
+         * Append a floating point number in the shortest form which reads back the same.
+         * @param out   text to append to.
+         * @param value number.
+         * @param json  true if JSON, which has no infinity or NaN, so those are written as null.
+         */
+        template<typename T>
+        void appendFloat(std::string & out, T value, bool json) {
+            if (json && !std::isfinite(value)) {
+                out += "null";
+                return;
+            }
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr - buf);
+        }
+
+
+        /**
+         * Append characters, escaped for XML text and attributes or for a JSON string.
+         * @param out   text to append to.
+         * @param chars characters.
+         * @param len   number of characters.
+         * @param json  true if JSON.
+         */
+        void appendEscaped(std::string & out, const char *chars, size_t len, bool json) {
+            const char *start = chars, *end = chars + len;
+            for (const char *p = chars; p < end; p++) {
+                const char *sub;
+                char ctl[12];
+                unsigned char c = *p;
+                switch (c) {
+                    case '&':  sub = json ? nullptr : "&amp;";  break;
+                    case '<':  sub = json ? nullptr : "&lt;";   break;
+                    case '>':  sub = json ? nullptr : "&gt;";   break;
+                    case '\'': sub = json ? nullptr : "&apos;"; break;
+                    case '"':  sub = json ? "\\\"" : "&quot;";  break;
+                    case '\\': sub = json ? "\\\\" : nullptr;   break;
+                    case '\n': sub = json ? "\\n" : nullptr;    break;
+                    case '\t': sub = json ? "\\t" : nullptr;    break;
+                    default:
+                        if (c >= 0x20) {
+                            sub = nullptr;
+                        }
+                        else {
+                            // Control characters are not allowed in XML 1.0 at all
+                            std::snprintf(ctl, sizeof(ctl), json ? "\\u%04x" : "&#xfffd;", c);
+                            sub = ctl;
+                        }
+                }
+                if (sub == nullptr) continue;
+                out.append(start, p - start);
+                out += sub;
+                start = p + 1;
+            }
+            out.append(start, end - start);
+        }
+
+
+        /**
+         * Get the name of a type of data as written in the "content" attribute.
+         * @param dataType type of data.
+         * @return name.
+         */
+        const char *contentName(uint32_t dataType) {
+            switch (dataType) {
+                case 0x1:  return "uint32";
+                case 0x2:  return "float32";
+                case 0x3:  return "string";
+                case 0x4:  return "int16";
+                case 0x5:  return "uint16";
+                case 0x6:  return "int8";
+                case 0x7:  return "uint8";
+                case 0x8:  return "double64";
+                case 0x9:  return "int64";
+                case 0xa:  return "uint64";
+                case 0xb:  return "int32";
+                case 0xc:  return "tagsegment";
+                case 0xd:
+                case 0x20: return "segment";
+                case 0xe:
+                case 0x10: return "bank";
+                case 0xf:  return "composite";
+                default:   return "unknown32";
+            }
+        }
+
+
+        /** Writes values separated by spaces, a limited number on each indented line, in XML,
+         *  or separated by commas in JSON. */
+        class ValueList {
+            std::string & out;
+            int depth;
+            uint32_t perLine;
+            bool json;
+            uint32_t count = 0;
+
+        public:
+
+            ValueList(std::string & out, int depth, uint32_t perLine, bool json) :
+                    out(out), depth(depth), perLine(perLine), json(json) {}
+
+            /** Write what comes before the next value. */
+            void next() {
+                if (json) {
+                    if (count++ > 0) out += ',';
+                    return;
+                }
+                if (count % perLine == 0) {
+                    if (count > 0) out += '\n';
+                    out.append(2*depth, ' ');
+                }
+                else {
+                    out += ' ';
+                }
+                count++;
+            }
+
+            /** End the line of values, if any, in XML. */
+            void endLine() {
+                if (!json && count > 0) out += '\n';
+                if (!json) count = 0;
+            }
+
+            /**
+             * Write a string, on its own line in XML.
+             * @param chars characters of string.
+             * @param len   number of characters.
+             */
+            void string(const char *chars, size_t len) {
+                if (json) {
+                    next();
+                    out += '"';
+                    appendEscaped(out, chars, len, true);
+                    out += '"';
+                    return;
+                }
+                endLine();
+                out.append(2*depth, ' ');
+                out += "<string>";
+                appendEscaped(out, chars, len, false);
+                out += "</string>\n";
+            }
+        };
+
+
+        /**
+         * Write each string of evio string data: strings ending in a null,
+         * padded with '\4's. Data with no null is taken as one string.
+         * @param list  where to write strings.
+         * @param data  start of string data.
+         * @param bytes number of bytes of data.
+         */
+        void appendStrings(ValueList & list, const uint8_t *data, size_t bytes) {
+            const char *p = reinterpret_cast<const char *>(data);
+            const char *end = p + bytes;
+
+            if (std::memchr(p, '\0', bytes) == nullptr) {
+                const char *pad = static_cast<const char *>(std::memchr(p, '\4', bytes));
+                list.string(p, (pad == nullptr ? end : pad) - p);
+                return;
+            }
+
+            while (p < end && *p != '\4') {
+                auto zero = static_cast<const char *>(std::memchr(p, '\0', end - p));
+                if (zero == nullptr) break;
+                list.string(p, zero - p);
+                p = zero + 1;
+            }
+        }
+    }
+
+
+    /**
+     * Constructor.
+     * @param format format of text, XML or JSON.
+     */
+    EventDumper::EventDumper(Format format) : format(format) {}
+
+
+    /**
+     * Append the text of an event.
+     * @param event  start of event, an evio bank.
+     * @param bytes  number of bytes in event.
+     * @param order  byte order of event.
+     * @param number number of the event, written with it.
+     * @param out    text to append to.
+     * @throws EvioException if event is not properly formed.
+     */
+    void EventDumper::appendEvent(const uint8_t *event, size_t bytes, ByteOrder const & order,
+                                  uint64_t number, std::string & out) const {
+        appendEvent(event, bytes, order, number, 1, out);
+    }
+
+
+    /**
+     * Append the text of an event.
+     * @param event  start of event, an evio bank.
+     * @param bytes  number of bytes in event.
+     * @param order  byte order of event.
+     * @param number number of the event, written with it.
+     * @param depth  depth of event element, for indenting XML.
+     * @param out    text to append to.
+     * @throws EvioException if event is not properly formed.
+     */
+    void EventDumper::appendEvent(const uint8_t *event, size_t bytes, ByteOrder const & order,
+                                  uint64_t number, int depth, std::string & out) const {
+
+        if (event == nullptr || bytes < 8) {
+            throw EvioException("event too small");
+        }
+
+        bool swap = !order.isLocalEndian();
+        uint32_t length = loadWord(event, swap);
+        size_t total = 4*((size_t)length + 1);
+        if (total > bytes) {
+            throw EvioException("event's length, " + std::to_string(total) +
+                                " bytes, is more than the " + std::to_string(bytes) + " given");
+        }
+
+        uint32_t word = loadWord(event + 4, swap);
+        uint32_t pad = (word >> 14) & 0x3;
+        size_t dataBytes = total - 8;
+        if (pad <= dataBytes) dataBytes -= pad;
+
+        Structure s {"event", (int64_t)number, (uint16_t)(word >> 16), (uint8_t)(word & 0xff), true,
+                     (word >> 8) & 0x3f, length, event + 8, dataBytes};
+        appendStructure(s, swap, order, format == JSON ? 0 : depth, out);
+    }
+
+
+    /**
+     * Append the text of an event.
+     * @param event  view of event.
+     * @param number number of the event, written with it.
+     * @param out    text to append to.
+     * @throws EvioException if event is not properly formed.
+     */
+    void EventDumper::appendEvent(ByteBufferView const & event, uint64_t number, std::string & out) const {
+        appendEvent(event.data(), event.size(), event.order(), number, out);
+    }
+
+
+    /**
+     * Append the text of the event represented by a node, read from its backing buffer.
+     * @param node   node of event.
+     * @param number number of the event, written with it.
+     * @param out    text to append to.
+     * @throws EvioException if event is not properly formed.
+     */
+    void EventDumper::appendEvent(EvioNode & node, uint64_t number, std::string & out) const {
+        auto buf = node.getBuffer();
+        appendEvent(buf->array() + buf->arrayOffset() + node.getPosition(),
+                    node.getTotalBytes(), buf->order(), number, out);
+    }
+
+
+    /**
+     * Append the text of one structure: its header, then its data or children.
+     * @param s      structure.
+     * @param swap   true if data is not local endian.
+     * @param order  byte order of data.
+     * @param depth  depth of structure, for indenting XML.
+     * @param out    text to append to.
+     * @throws EvioException if structure is not properly formed.
+     */
+    void EventDumper::appendStructure(Structure const & s, bool swap, ByteOrder const & order,
+                                      int depth, std::string & out) const {
+
+        bool json = (format == JSON);
+
+        if (json) {
+            out += '{';
+            if (s.number >= 0) {
+                out += "\"number\":";
+                appendInt(out, s.number);
+                out += ',';
+            }
+            out += "\"structure\":\"";
+            out += s.name[0] == 'e' ? "bank" : s.name;
+            out += "\",\"content\":\"";
+            out += contentName(s.dataType);
+            out += "\",\"data_type\":";
+            appendInt(out, s.dataType);
+            out += ",\"tag\":";
+            appendInt(out, s.tag);
+            if (s.isBank) {
+                out += ",\"num\":";
+                appendInt(out, s.num);
+            }
+            out += ",\"length\":";
+            appendInt(out, s.length);
+            out += DataType::isStructure(s.dataType) ? ",\"children\":[" : ",\"data\":[";
+        }
+        else {
+            out.append(2*depth, ' ');
+            out += '<';
+            out += s.name;
+            if (s.number >= 0) {
+                out += " number=\"";
+                appendInt(out, s.number);
+                out += '"';
+            }
+            out += " content=\"";
+            out += contentName(s.dataType);
+            out += "\" data_type=\"0x";
+            char buf[8];
+            auto res = std::to_chars(buf, buf + sizeof(buf), s.dataType, 16);
+            out.append(buf, res.ptr - buf);
+            out += "\" tag=\"";
+            appendInt(out, s.tag);
+            if (s.isBank) {
+                out += "\" num=\"";
+                appendInt(out, s.num);
+            }
+            out += "\" length=\"";
+            appendInt(out, s.length);
+            out += "\">\n";
+        }
+
+        if (DataType::isStructure(s.dataType)) {
+            appendChildren(s.data, s.dataBytes, s.dataType, swap, order, depth + 1, out);
+        }
+        else {
+            appendData(s.data, s.dataBytes, s.dataType, order, depth + 1, out);
+        }
+
+        if (json) {
+            out += "]}";
+        }
+        else {
+            out.append(2*depth, ' ');
+            out += "</";
+            out += s.name;
+            out += ">\n";
+        }
+    }
+
+
+    /**
+     * Append the text of the structures held in a container.
+     * @param p      start of container's data.
+     * @param bytes  number of bytes of container's data.
+     * @param kind   data type of container, which says what kind of structures it holds.
+     * @param swap   true if data is not local endian.
+     * @param order  byte order of data.
+     * @param depth  depth of structures, for indenting XML.
+     * @param out    text to append to.
+     * @throws EvioException if a structure extends past the end of its parent.
+     */
+    void EventDumper::appendChildren(const uint8_t *p, size_t bytes, uint32_t kind, bool swap,
+                                     ByteOrder const & order, int depth, std::string & out) const {
+
+        const uint8_t *end = p + bytes;
+        bool bank = DataType::isBank(kind);
+        size_t headerBytes = bank ? 8 : 4;
+
+        for (bool first = true; p < end; first = false) {
+            if ((size_t)(end - p) < headerBytes) {
+                throw EvioException("structure header extends past end of its parent");
+            }
+
+            uint32_t word = loadWord(p, swap);
+            Structure s {};
+            s.number = -1;
+            size_t total;
+            uint32_t pad = 0;
+
+            if (bank) {
+                s.length = word;
+                total = 4*((size_t)word + 1);
+                if (total < 8 || total > (size_t)(end - p)) {
+                    throw EvioException("bank extends past end of its parent");
+                }
+                word = loadWord(p + 4, swap);
+                s.name = "bank";
+                s.isBank = true;
+                s.tag = (uint16_t)(word >> 16);
+                s.num = (uint8_t)(word & 0xff);
+                s.dataType = (word >> 8) & 0x3f;
+                pad = (word >> 14) & 0x3;
+            }
+            else {
+                s.length = word & 0xffff;
+                total = 4*((size_t)s.length + 1);
+                if (total > (size_t)(end - p)) {
+                    throw EvioException("segment extends past end of its parent");
+                }
+                if (DataType::isSegment(kind)) {
+                    s.name = "segment";
+                    s.tag = (uint16_t)(word >> 24);
+                    s.dataType = (word >> 16) & 0x3f;
+                    pad = (word >> 22) & 0x3;
+                }
+                else {
+                    s.name = "tagsegment";
+                    s.tag = (uint16_t)(word >> 20);
+                    s.dataType = (word >> 16) & 0xf;
+                }
+            }
+
+            s.data = p + headerBytes;
+            s.dataBytes = total - headerBytes;
+            if (pad <= s.dataBytes) s.dataBytes -= pad;
+
+            if (format == JSON && !first) out += ',';
+            appendStructure(s, swap, order, depth, out);
+            p += total;
+        }
+    }
+
+
+    /**
+     * Append the values of a structure's data.
+     * @param data     start of data.
+     * @param bytes    number of bytes of data, not including padding.
+     * @param dataType type of data.
+     * @param order    byte order of data.
+     * @param depth    depth of values, for indenting XML.
+     * @param out      text to append to.
+     * @throws EvioException if composite data is not properly formed.
+     */
+    void EventDumper::appendData(const uint8_t *data, size_t bytes, uint32_t dataType,
+                                 ByteOrder const & order, int depth, std::string & out) const {
+
+        if (dataType == DataType::COMPOSITE.getValue()) {
+            appendComposite(data, bytes, order, depth, out);
+            return;
+        }
+
+        bool json = (format == JSON);
+        bool swap = !order.isLocalEndian();
+        ValueList list(out, depth, valuesPerLine, json);
+        const uint8_t *end;
+
+        switch (dataType) {
+            case 0x3:
+                appendStrings(list, data, bytes);
+                break;
+            case 0x6:
+                for (end = data + bytes; data < end; data++) {list.next(); appendInt(out, (int8_t)*data);}
+                break;
+            case 0x7:
+                for (end = data + bytes; data < end; data++) {list.next(); appendInt(out, *data);}
+                break;
+            case 0x4:
+                for (end = data + bytes - bytes % 2; data < end; data += 2) {
+                    list.next(); appendInt(out, loadValue<int16_t>(data, swap));
+                }
+                break;
+            case 0x5:
+                for (end = data + bytes - bytes % 2; data < end; data += 2) {
+                    list.next(); appendInt(out, loadValue<uint16_t>(data, swap));
+                }
+                break;
+            case 0xb:
+                for (end = data + bytes - bytes % 4; data < end; data += 4) {
+                    list.next(); appendInt(out, loadValue<int32_t>(data, swap));
+                }
+                break;
+            case 0x1:
+                for (end = data + bytes - bytes % 4; data < end; data += 4) {
+                    list.next(); appendInt(out, loadValue<uint32_t>(data, swap));
+                }
+                break;
+            case 0x2:
+                for (end = data + bytes - bytes % 4; data < end; data += 4) {
+                    list.next(); appendFloat(out, loadValue<float>(data, swap), json);
+                }
+                break;
+            case 0x9:
+                for (end = data + bytes - bytes % 8; data < end; data += 8) {
+                    list.next(); appendInt(out, loadValue<int64_t>(data, swap));
+                }
+                break;
+            case 0xa:
+                for (end = data + bytes - bytes % 8; data < end; data += 8) {
+                    list.next(); appendInt(out, loadValue<uint64_t>(data, swap));
+                }
+                break;
+            case 0x8:
+                for (end = data + bytes - bytes % 8; data < end; data += 8) {
+                    list.next(); appendFloat(out, loadValue<double>(data, swap), json);
+                }
+                break;
+            default:
+                // Unknown data is written as words, in hex in XML
+                for (end = data + bytes - bytes % 4; data < end; data += 4) {
+                    list.next();
+                    if (json) appendInt(out, loadValue<uint32_t>(data, swap));
+                    else appendHex(out, loadValue<uint32_t>(data, swap));
+                }
+        }
+
+        list.endLine();
+    }
+
+
+    /**
+     * Append the values of composite data, item by item, with each item's format.
+     * @param data   start of composite data.
+     * @param bytes  number of bytes of data.
+     * @param order  byte order of data.
+     * @param depth  depth of values, for indenting XML.
+     * @param out    text to append to.
+     * @throws EvioException if composite data is not properly formed.
+     */
+    void EventDumper::appendComposite(const uint8_t *data, size_t bytes, ByteOrder const & order,
+                                      int depth, std::string & out) const {
+
+        bool json = (format == JSON);
+        CompositeCursor cursor(data, bytes, order);
+
+        for (bool first = true; cursor.nextItem(); first = false) {
+            if (json) {
+                if (!first) out += ',';
+                out += "{\"format\":\"";
+                appendEscaped(out, cursor.getFormat().data(), cursor.getFormat().size(), true);
+                out += "\",\"values\":[";
+            }
+            else {
+                out.append(2*depth, ' ');
+                out += "<composite format=\"";
+                appendEscaped(out, cursor.getFormat().data(), cursor.getFormat().size(), false);
+                out += "\">\n";
+            }
+
+            ValueList list(out, depth + 1, valuesPerLine, json);
+
+            while (cursor.next()) {
+                DataType const & type = cursor.getType();
+
+                if (type == DataType::CHARSTAR8) {
+                    appendStrings(list, cursor.getValueBytes(), cursor.getValueLength());
+                    continue;
+                }
+
+                list.next();
+                if      (type == DataType::INT32)    appendInt(out, cursor.getInt());
+                else if (type == DataType::UINT32)   appendInt(out, cursor.getUInt());
+                else if (type == DataType::FLOAT32)  appendFloat(out, cursor.getFloat(), json);
+                else if (type == DataType::DOUBLE64) appendFloat(out, cursor.getDouble(), json);
+                else if (type == DataType::SHORT16)  appendInt(out, cursor.getShort());
+                else if (type == DataType::USHORT16) appendInt(out, cursor.getUShort());
+                else if (type == DataType::CHAR8)    appendInt(out, cursor.getChar());
+                else if (type == DataType::UCHAR8)   appendInt(out, cursor.getUChar());
+                else if (type == DataType::LONG64)   appendInt(out, cursor.getLong());
+                else if (type == DataType::ULONG64)  appendInt(out, cursor.getULong());
+                else if (type == DataType::NVALUE)   appendInt(out, cursor.getInt());
+                else if (type == DataType::nVALUE)   appendInt(out, cursor.getShort());
+                else if (type == DataType::mVALUE)   appendInt(out, cursor.getUChar());
+                else if (json)                       appendInt(out, cursor.getUInt());
+                else                                 appendHex(out, cursor.getUInt());
+            }
+
+            list.endLine();
+
+            if (json) {
+                out += "]}";
+            }
+            else {
+                out.append(2*depth, ' ');
+                out += "</composite>\n";
+            }
+        }
+    }
+
+
+    /**
+     * Write held text to an output stream if there is enough of it, or if forced.
+     * @param text  held text, emptied when written.
+     * @param out   output stream.
+     * @param force write whatever there is.
+     * @throws EvioException if writing fails.
+     */
+    void EventDumper::flush(std::string & text, std::ostream & out, bool force) const {
+        if (text.empty() || (!force && text.size() < flushBytes)) return;
+        out.write(text.data(), text.size());
+        if (!out) {
+            throw EvioException("error writing text");
+        }
+        text.clear();
+    }
+
+
+    /**
+     * Write all events of a reader's file or buffer, numbered from 0, to an output stream.
+     * In XML they're inside an evio-data element, and in JSON they're the "events" array
+     * of an object, one event on each line.
+     *
+     * @param reader reader of events.
+     * @param out    output stream.
+     * @return number of events written.
+     * @throws EvioException if an event is not properly formed, or writing fails.
+     */
+    uint64_t EventDumper::dump(Reader & reader, std::ostream & out) const {
+        bool json = (format == JSON);
+        std::string text;
+        text.reserve(flushBytes + 64*1024);
+
+        text += json ? "{\"events\":[\n" : "<evio-data>\n";
+
+        uint32_t count = reader.getEventCount();
+        for (uint32_t i=0; i < count; i++) {
+            if (json && i > 0) text += ",\n";
+            appendEvent(reader.getEventView(i), i, text);
+            flush(text, out, false);
+        }
+
+        text += json ? "\n]}\n" : "</evio-data>\n";
+        flush(text, out, true);
+        return count;
+    }
+
+
+    /**
+     * Write all events of the given files to an output stream, formatting the events of
+     * each record in parallel, in worker threads, and writing them in order, in the calling
+     * thread. Events are numbered from 0 in each file.
+     * In XML, each file is a file element, with a name attribute, inside an evio-data element.
+     * In JSON, each file is an object with a name and an "events" array, in a "files" array.
+     *
+     * @param files    names of evio version 6 files.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @param out      output stream.
+     * @return number of events written.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format,
+     *         an event is not properly formed, or writing fails.
+     */
+    uint64_t EventDumper::dumpFiles(std::vector<std::string> const & files, uint32_t threads,
+                                    std::ostream & out) const {
+
+        bool json = (format == JSON);
+        std::string text;
+        text.reserve(flushBytes + 64*1024);
+        text += json ? "{\"files\":[\n" : "<evio-data>\n";
+
+        // File whose events are being written, -1 if none yet
+        int64_t openFile = -1;
+
+        auto closeFile = [json, &text]() {
+            text += json ? "\n]}" : "  </file>\n";
+        };
+
+        auto openNext = [&](uint32_t fileIndex) {
+            // Files with no events get an element too
+            for (int64_t f = openFile + 1; f <= fileIndex; f++) {
+                if (openFile >= 0) {
+                    closeFile();
+                    if (json) text += ",\n";
+                }
+                if (json) {
+                    text += "{\"name\":\"";
+                    appendEscaped(text, files[f].data(), files[f].size(), true);
+                    text += "\",\"events\":[\n";
+                }
+                else {
+                    text += "  <file name=\"";
+                    appendEscaped(text, files[f].data(), files[f].size(), false);
+                    text += "\">\n";
+                }
+                openFile = f;
+            }
+        };
+
+        uint64_t count = ParallelEventReader::forEachEvent(files, threads,
+            [this](ByteBufferView const & event, ParallelEventReader::EventInfo const & info) {
+                // Format into a reused string, then copy once into the result
+                thread_local std::string eventText;
+                eventText.clear();
+                appendEvent(event.data(), event.size(), event.order(), info.eventIndex, 2, eventText);
+                auto result = std::make_shared<ByteBuffer>(eventText.size());
+                std::memcpy(result->array(), eventText.data(), eventText.size());
+                return result;
+            },
+            [&](std::shared_ptr<ByteBuffer> & result, ParallelEventReader::EventInfo const & info) {
+                if ((int64_t)info.fileIndex != openFile) {
+                    openNext(info.fileIndex);
+                }
+                else if (json) {
+                    text += ",\n";
+                }
+                text.append(reinterpret_cast<const char *>(result->array()), result->capacity());
+                flush(text, out, false);
+            });
+
+        if (!files.empty()) {
+            openNext((uint32_t)files.size() - 1);
+            closeFile();
+        }
+        text += json ? "\n]}\n" : "</evio-data>\n";
+        flush(text, out, true);
+        return count;
+    }
+
+}
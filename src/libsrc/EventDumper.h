@@ -0,0 +1,132 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVENTDUMPER_H
+#define EVIO_6_0_EVENTDUMPER_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <ostream>
+
+
+#include "ByteOrder.h"
+#include "ByteBufferView.h"
+#include "EvioNode.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class Reader;
+
+
+    /**
+     * This class writes evio events as XML or JSON text, for debugging or for systems
+     * which take text. Events are walked in place, in their buffers, without creating
+     * {@link EvioNode} or {@link BaseStructure} objects, and their text is appended to
+     * a string which is written to an output stream in large pieces. Numbers are
+     * formatted with std::to_chars, floating point ones in the shortest form which reads
+     * back the same. Composite data is taken apart by a {@link CompositeCursor}.<p>
+     *
+     * {@link #dumpFiles(std::vector<std::string> const &, uint32_t, std::ostream &)}
+     * formats the events of each record in parallel with {@link ParallelEventReader},
+     * and writes them in the order of the files and events in them.<p>
+     *
+     * In XML, each event is an element, each structure in it is a bank, segment or
+     * tagsegment element, and data is written inside the element of its structure:
+     *
+     * <pre><code>
+     *    &lt;event number="0" content="bank" data_type="0x10" tag="1" num="1" length="6"&gt;
+     *      &lt;bank content="int32" data_type="0xb" tag="2" num="0" length="4"&gt;
+     *        1 2 3
+     *      &lt;/bank&gt;
+     *    &lt;/event&gt;
+     * </code></pre>
+     *
+     * In JSON, each event is an object on one line, with the same names, and data in an
+     * array called "data" or child structures in one called "children".
+     * Infinite and NaN floating point values, which JSON does not have, are written as null.
+     */
+    class EventDumper {
+
+    public:
+
+        /** Text formats. */
+        enum Format {
+            /** XML. */
+            XML,
+            /** JSON. */
+            JSON
+        };
+
+    private:
+
+        /** Format of text. */
+        Format format;
+
+        /** In XML, most values written on one line. */
+        uint32_t valuesPerLine = 8;
+
+        /** Bytes of text held before being written to the output stream. */
+        size_t flushBytes = 1024*1024;
+
+    public:
+
+        explicit EventDumper(Format format = XML);
+
+        /** @return format of text. */
+        Format getFormat()               const {return format;}
+        /** @return in XML, most values written on one line. */
+        uint32_t getValuesPerLine()      const {return valuesPerLine;}
+
+        /** @param count in XML, most values written on one line, at least 1. */
+        void setValuesPerLine(uint32_t count) {valuesPerLine = count < 1 ? 1 : count;}
+        /** @param bytes bytes of text held before being written to the output stream. */
+        void setFlushBytes(size_t bytes)      {flushBytes = bytes;}
+
+        void appendEvent(const uint8_t *event, size_t bytes, ByteOrder const & order,
+                         uint64_t number, std::string & out) const;
+        void appendEvent(ByteBufferView const & event, uint64_t number, std::string & out) const;
+        void appendEvent(EvioNode & node, uint64_t number, std::string & out) const;
+
+        uint64_t dump(Reader & reader, std::ostream & out) const;
+        uint64_t dumpFiles(std::vector<std::string> const & files, uint32_t threads,
+                           std::ostream & out) const;
+
+    private:
+
+        struct Structure;
+
+        void appendEvent(const uint8_t *event, size_t bytes, ByteOrder const & order,
+                         uint64_t number, int depth, std::string & out) const;
+
+        void appendStructure(Structure const & s, bool swap, ByteOrder const & order,
+                             int depth, std::string & out) const;
+
+        void appendChildren(const uint8_t *p, size_t bytes, uint32_t kind, bool swap,
+                            ByteOrder const & order, int depth, std::string & out) const;
+
+        void appendData(const uint8_t *data, size_t bytes, uint32_t dataType,
+                        ByteOrder const & order, int depth, std::string & out) const;
+
+        void appendComposite(const uint8_t *data, size_t bytes, ByteOrder const & order,
+                             int depth, std::string & out) const;
+
+        void flush(std::string & text, std::ostream & out, bool force) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVENTDUMPER_H
@@ -14,7 +14,8 @@
 
 #include <cstring>
 #include <memory>
-#include <cstring>
+#include <vector>
+#include <string>
 
 
 #include "ByteOrder.h"
@@ -22,6 +23,7 @@
 #include "SegmentHeader.h"
 #include "TagSegmentHeader.h"
 #include "EvioNode.h"
+#include "StructureIndex.h"
 
 
 namespace evio {
@@ -51,29 +53,41 @@ namespace evio {
          * @return the new bank header.
          */
         static std::shared_ptr<BankHeader> createBankHeader(uint8_t * bytes, ByteOrder const & byteOrder) {
-
             std::shared_ptr<BankHeader> header = std::make_shared<BankHeader>();
+            readBankHeader(bytes, byteOrder, *header);
+            return header;
+        }
+
+
+        /**
+         * Fill an existing bank header from the first eight bytes of the data array.
+         * Nothing is allocated, so this may be used to look at a header before deciding
+         * whether to create a bank from it.
+         *
+         * @param bytes the byte array, probably from a bank that encloses this new bank.
+         * @param byteOrder byte order of array, {@link ByteOrder#ENDIAN_BIG} or {@link ByteOrder#ENDIAN_LITTLE}.
+         * @param header the bank header to fill.
+         */
+        static void readBankHeader(const uint8_t * bytes, ByteOrder const & byteOrder, BankHeader & header) {
 
             // Does the length make sense?
             uint32_t len = 0;
-            Util::toIntArray(reinterpret_cast<char *>(bytes), 4, byteOrder, &len);
+            Util::toIntArray(reinterpret_cast<char const *>(bytes), 4, byteOrder, &len);
 
-            header->setLength(len);
+            header.setLength(len);
             bytes += 4;
 
             // Read and parse second header word
             uint32_t word = 0;
-            Util::toIntArray(reinterpret_cast<char *>(bytes), 4, byteOrder, &word);
+            Util::toIntArray(reinterpret_cast<char const *>(bytes), 4, byteOrder, &word);
 
-            header->setTag(word >> 16);
+            header.setTag(word >> 16);
             int dt = (word >> 8) & 0xff;
             int type = dt & 0x3f;
             uint8_t padding = dt >> 6;
-            header->setDataType(type);
-            header->setPadding(padding);
-            header->setNumber(word);
-
-            return header;
+            header.setDataType(type);
+            header.setPadding(padding);
+            header.setNumber(word);
         }
 
 
@@ -87,24 +101,35 @@ namespace evio {
          * @return the new segment header.
          */
         static std::shared_ptr<SegmentHeader> createSegmentHeader(uint8_t * bytes, ByteOrder const & byteOrder) {
-
             std::shared_ptr<SegmentHeader> header = std::make_shared<SegmentHeader>();
+            readSegmentHeader(bytes, byteOrder, *header);
+            return header;
+        }
+
+
+        /**
+         * Fill an existing segment header from the first four bytes of the data array.
+         * Nothing is allocated.
+         *
+         * @param bytes the byte array, probably from a bank that encloses this new segment.
+         * @param byteOrder byte order of array, {@link ByteOrder#ENDIAN_BIG} or {@link ByteOrder#ENDIAN_LITTLE}.
+         * @param header the segment header to fill.
+         */
+        static void readSegmentHeader(const uint8_t * bytes, ByteOrder const & byteOrder, SegmentHeader & header) {
 
             // Read and parse header word
             uint32_t word = 0;
-            Util::toIntArray(reinterpret_cast<char *>(bytes), 4, byteOrder, &word);
+            Util::toIntArray(reinterpret_cast<char const *>(bytes), 4, byteOrder, &word);
 
             uint32_t len = word & 0xffff;
-            header->setLength(len);
+            header.setLength(len);
 
             int dt = (word >> 16) & 0xff;
             int type = dt & 0x3f;
             int padding = dt >> 6;
-            header->setDataType(type);
-            header->setPadding(padding);
-            header->setTag(word >> 24);
-
-            return header;
+            header.setDataType(type);
+            header.setPadding(padding);
+            header.setTag(word >> 24);
         }
 
 
@@ -118,19 +143,30 @@ namespace evio {
          * @return the new tagsegment header.
          */
         static std::shared_ptr<TagSegmentHeader> createTagSegmentHeader(uint8_t * bytes, ByteOrder const & byteOrder) {
-
             std::shared_ptr<TagSegmentHeader> header = std::make_shared<TagSegmentHeader>();
+            readTagSegmentHeader(bytes, byteOrder, *header);
+            return header;
+        }
+
+
+        /**
+         * Fill an existing tag segment header from the first four bytes of the data array.
+         * Nothing is allocated.
+         *
+         * @param bytes the byte array, probably from a bank that encloses this new tag segment.
+         * @param byteOrder byte order of array, {@link ByteOrder#ENDIAN_BIG} or {@link ByteOrder#ENDIAN_LITTLE}.
+         * @param header the tag segment header to fill.
+         */
+        static void readTagSegmentHeader(const uint8_t * bytes, ByteOrder const & byteOrder, TagSegmentHeader & header) {
 
             // Read and parse header word
             uint32_t word = 0;
-            Util::toIntArray(reinterpret_cast<char *>(bytes), 4, byteOrder, &word);
+            Util::toIntArray(reinterpret_cast<char const *>(bytes), 4, byteOrder, &word);
 
             uint32_t len = word & 0xffff;
-            header->setLength(len);
-            header->setDataType((word >> 16) & 0xf);
-            header->setTag(word >> 20);
-
-            return header;
+            header.setLength(len);
+            header.setDataType((word >> 16) & 0xf);
+            header.setTag(word >> 20);
         }
 
 
@@ -334,6 +370,274 @@ namespace evio {
         }
 
 
+
+
+        /**
+         * This method fills a flat index of an evio event and all the structures it contains
+         * in a single pass over the buffer, without creating any EvioNode objects.
+         * Structures are indexed in the order of EvioNode's allNodes list.
+         * The buffer's position does <b>not</b> change.
+         *
+         * @param buffer    buffer containing event.
+         * @param position  position of event (bank header) in buffer.
+         * @param index     index to be cleared and filled.
+         * @throws EvioException if buffer does not contain the whole event;
+         *                       if a contained structure extends past the end of its parent.
+         */
+        static void indexEvent(ByteBuffer & buffer, size_t position, StructureIndex & index) {
+            index.clear();
+            const uint8_t *data = buffer.array() + buffer.arrayOffset();
+            if (buffer.order().isLocalEndian()) {
+                scanEvent<false, false>(data, position, buffer.limit(), index);
+            }
+            else {
+                scanEvent<true, false>(data, position, buffer.limit(), index);
+            }
+        }
+
+
+        /**
+         * This method fills a flat index of an evio event held in memory, such as a
+         * {@link ByteBufferView} of an event, the same way as
+         * {@link #indexEvent(ByteBuffer &, size_t, StructureIndex &)}.
+         * Positions in the index are relative to the start of the event.
+         *
+         * @param event  pointer to event (bank header).
+         * @param bytes  number of bytes available at event.
+         * @param order  byte order of event.
+         * @param index  index to be cleared and filled.
+         * @throws EvioException if bytes do not hold the whole event;
+         *                       if a contained structure extends past the end of its parent.
+         */
+        static void indexEvent(const uint8_t *event, size_t bytes, ByteOrder const & order, StructureIndex & index) {
+            index.clear();
+            if (order.isLocalEndian()) {
+                scanEvent<false, false>(event, 0, bytes, index);
+            }
+            else {
+                scanEvent<true, false>(event, 0, bytes, index);
+            }
+        }
+
+
+        /**
+         * This method checks that an evio event is properly formed by walking the headers
+         * of all the structures it contains, without creating any objects or looking at data.
+         * Each structure must lie within its parent, containers must be exactly filled by their
+         * children, banks must have a full header, and data types must be valid.
+         *
+         * @param event  pointer to event (bank header).
+         * @param bytes  number of bytes available at event.
+         * @param order  byte order of event.
+         * @return number of structures in event, including the event itself.
+         * @throws EvioException if event is not properly formed, saying why and where.
+         */
+        static uint32_t validateEvent(const uint8_t *event, size_t bytes, ByteOrder const & order) {
+            StructureCounter counter;
+            if (order.isLocalEndian()) {
+                scanEvent<false, true>(event, 0, bytes, counter);
+            }
+            else {
+                scanEvent<true, true>(event, 0, bytes, counter);
+            }
+            return counter.count;
+        }
+
+
+        /**
+         * This method checks that an evio event is properly formed.
+         * The buffer's position does <b>not</b> change.
+         * @see #validateEvent(const uint8_t *, size_t, ByteOrder const &)
+         *
+         * @param buffer    buffer containing event.
+         * @param position  position of event (bank header) in buffer.
+         * @return number of structures in event, including the event itself.
+         * @throws EvioException if event is not properly formed, saying why and where.
+         */
+        static uint32_t validateEvent(ByteBuffer & buffer, size_t position) {
+            if (position > buffer.limit()) {
+                throw EvioException("buffer underflow");
+            }
+            return validateEvent(buffer.array() + buffer.arrayOffset() + position,
+                                 buffer.limit() - position, buffer.order());
+        }
+
+    private:
+
+        /** Counts the structures found by {@link #scanEvent}, keeping nothing else. */
+        struct StructureCounter {
+            uint32_t count = 0;
+            int32_t add(uint16_t, uint8_t, uint8_t, uint8_t, uint8_t, size_t, uint32_t, int32_t) {
+                return (int32_t)(count++);
+            }
+        };
+
+
+        /**
+         * Read a 32 bit word.
+         * @tparam Swap true if word must be swapped.
+         * @param p pointer to word, need not be aligned.
+         * @return word in local byte order.
+         */
+        template<bool Swap>
+        static uint32_t loadWord(const uint8_t *p) {
+            uint32_t word;
+            std::memcpy(&word, p, 4);
+            return Swap ? SWAP_32(word) : word;
+        }
+
+
+        /**
+         * Build an error for a badly formed structure.
+         * @param what     what's wrong.
+         * @param position position of structure's header.
+         * @return exception to throw.
+         */
+        static EvioException badStructure(const char *what, size_t position) {
+            return EvioException(std::string(what) + " (structure at byte " + std::to_string(position) + ")");
+        }
+
+
+        /**
+         * Walk the headers of an event and all its structures depth first, handing the
+         * values of each to a sink, in the order of EvioNode's allNodes list. Each header
+         * is read straight from memory with the byte order fixed at compile time, and
+         * the kind of header found in a container is decided once for all its children.
+         * The walk itself can't be done in parallel since each header's position depends
+         * on the length in the one before.
+         *
+         * @tparam Swap     true if data must be swapped.
+         * @tparam Strict   true to check everything checked by {@link #validateEvent},
+         *                  otherwise only that structures fit in their parents.
+         * @tparam Sink     anything with the method
+         *                  <code>int32_t add(tag, num, type, dataType, pad, position, length, parent)</code>
+         *                  such as {@link StructureIndex}, returning the index of what was added.
+         * @param data      start of memory that positions are relative to.
+         * @param position  position of event (bank header).
+         * @param limit     position past the last usable byte.
+         * @param sink      gets the values of each structure.
+         * @throws EvioException if event is not properly formed.
+         */
+        template<bool Swap, bool Strict, typename Sink>
+        static void scanEvent(const uint8_t *data, size_t position, size_t limit, Sink & sink) {
+
+            // Kinds of headers
+            enum {KIDS_BANK, KIDS_SEGMENT, KIDS_TAGSEGMENT};
+
+            // Structure whose children are being scanned
+            struct Container {
+                size_t   pos;       // position of next child
+                size_t   end;       // position just past the container's data
+                int32_t  parent;    // index of container
+                uint32_t kids;      // kind of children's headers
+            };
+
+            auto kindOf = [](uint32_t dataType) -> uint32_t {
+                return DataType::isBank(dataType) ? KIDS_BANK :
+                       (DataType::isSegment(dataType) ? KIDS_SEGMENT : KIDS_TAGSEGMENT);
+            };
+
+            auto badType = [](uint32_t dataType) -> bool {
+                return dataType > 0x24 || (dataType > 0x10 && dataType < 0x20);
+            };
+
+            if (position + 8 > limit) {
+                throw EvioException("buffer underflow");
+            }
+
+            // Event is a bank
+            uint32_t len  = loadWord<Swap>(data + position);
+            uint32_t word = loadWord<Swap>(data + position + 4);
+            uint32_t dt   = (word >> 8) & 0xff;
+            uint32_t dataType = dt & 0x3f;
+            size_t end = position + 4*((size_t)len + 1);
+
+            if (end > limit) {
+                throw EvioException("buffer underflow");
+            }
+            if (Strict) {
+                if (len < 1)            throw badStructure("bank length too small for its header", position);
+                if (badType(dataType))  throw badStructure("bad data type", position);
+            }
+
+            sink.add(word >> 16, word & 0xff, DataType::BANK.getValue(), dataType, dt >> 6,
+                     position, len, StructureIndex::NO_PARENT);
+
+            if (!DataType::isStructure(dataType)) {
+                return;
+            }
+
+            std::vector<Container> stack;
+            stack.reserve(16);
+            stack.push_back(Container{position + 8, end, 0, kindOf(dataType)});
+
+            while (!stack.empty()) {
+                Container & c = stack.back();
+
+                size_t left = c.end - c.pos;
+                size_t headerBytes = c.kids == KIDS_BANK ? 8 : 4;
+                if (left < headerBytes) {
+                    // No more children in this container
+                    if (Strict && left != 0) {
+                        throw badStructure("container not filled by its children", c.pos);
+                    }
+                    stack.pop_back();
+                    continue;
+                }
+
+                size_t kidPos = c.pos;
+                uint16_t tag;
+                uint8_t num = 0, pad = 0, type;
+
+                if (c.kids == KIDS_BANK) {
+                    len  = loadWord<Swap>(data + kidPos);
+                    word = loadWord<Swap>(data + kidPos + 4);
+                    tag  = word >> 16;
+                    dt   = (word >> 8) & 0xff;
+                    dataType = dt & 0x3f;
+                    pad  = dt >> 6;
+                    num  = word & 0xff;
+                    type = DataType::BANK.getValue();
+                    if (Strict && len < 1) {
+                        throw badStructure("bank length too small for its header", kidPos);
+                    }
+                }
+                else if (c.kids == KIDS_SEGMENT) {
+                    word = loadWord<Swap>(data + kidPos);
+                    len  = word & 0xffff;
+                    tag  = word >> 24;
+                    dt   = (word >> 16) & 0xff;
+                    dataType = dt & 0x3f;
+                    pad  = dt >> 6;
+                    type = DataType::SEGMENT.getValue();
+                }
+                else {
+                    word = loadWord<Swap>(data + kidPos);
+                    len  = word & 0xffff;
+                    tag  = word >> 20;
+                    dataType = (word >> 16) & 0xf;
+                    type = DataType::TAGSEGMENT.getValue();
+                }
+
+                end = kidPos + 4*((size_t)len + 1);
+                if (end > c.end) {
+                    if (Strict) throw badStructure("structure extends past end of its parent", kidPos);
+                    throw EvioException("structure extends past end of its parent");
+                }
+                if (Strict && badType(dataType)) {
+                    throw badStructure("bad data type", kidPos);
+                }
+
+                // Hop over the child before possibly adding to the stack, which invalidates c
+                c.pos = end;
+                int32_t kid = sink.add(tag, num, type, dataType, pad, kidPos, len, c.parent);
+
+                if (DataType::isStructure(dataType)) {
+                    stack.push_back(Container{kidPos + headerBytes, end, kid, kindOf(dataType)});
+                }
+            }
+        }
+
     };
 
 
@@ -0,0 +1,498 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "EventIndexFile.h"
+#include "RecordOutput.h"
+#include "Reader.h"
+
+
+namespace evio {
+
+
+    /**
+     * Get the name of the sidecar index file belonging to an evio file.
+     * @param fileName name of evio file.
+     * @return name of its sidecar index file.
+     */
+    std::string EventIndexFile::sidecarName(std::string const & fileName) {
+        return fileName + ".idx";
+    }
+
+
+    /** Remove all records and events from this index. */
+    void EventIndexFile::clear() {
+        recordPositions.clear();
+        recordLengths.clear();
+        recordCounts.clear();
+        recordDataOffsets.clear();
+        firstEvents.assign(1, 0);
+        eventOffsets.clear();
+        eventLengths.clear();
+        eventTagNums.clear();
+        compactEvents.clear();
+        compacted = false;
+        dataEnd = 0;
+    }
+
+
+    /**
+     * Add a record, which has already been built, to the end of this index.
+     * @param position file position at which the record is written.
+     * @param record   built record.
+     */
+    void EventIndexFile::addRecord(uint64_t position, RecordOutput & record) {
+        auto & header = record.getHeader();
+        uint32_t count = record.getEventCount();
+
+        // Events of an uncompressed record follow its header, index and padded user header
+        uint32_t dataOffset = 0;
+        if (header->getCompressionType() == Compressor::UNCOMPRESSED) {
+            dataOffset = header->getHeaderLength() + header->getIndexLength() +
+                         4*header->getUserHeaderLengthWords();
+        }
+
+        recordPositions.push_back(position);
+        recordLengths.push_back(header->getLength());
+        recordCounts.push_back(count);
+        recordDataOffsets.push_back(dataOffset);
+        firstEvents.push_back(firstEvents.back() + count);
+
+        auto events = record.getEventBuffer();
+        std::vector<uint32_t> lengths;
+        uint32_t offset = 0;
+        for (uint32_t i=0; i < count; i++) {
+            uint32_t len = record.getEventLength(i);
+            if (compacted) {
+                lengths.push_back(len);
+            }
+            else {
+                eventOffsets.push_back(offset);
+                eventLengths.push_back(len);
+            }
+            if (withTags) {
+                // Tag & num are in the 2nd word of an evio bank
+                uint32_t word = len > 7 ? events->getUInt(offset + 4) : 0;
+                eventTagNums.push_back((word & 0xffff0000) | (word & 0xff));
+            }
+            offset += len;
+        }
+        if (compacted) {
+            compactEvents.addRecord(lengths.data(), count);
+        }
+
+        dataEnd = position + header->getLength();
+    }
+
+
+    /**
+     * Add a record to the end of this index.
+     * @param position   file position of record.
+     * @param length     length of record in bytes.
+     * @param dataOffset offset from beginning of record to its first event, 0 if compressed.
+     * @param lengths    length of each event in record.
+     * @param tagNums    tag (upper 16 bits) and num (lower 8 bits) of each event,
+     *                   ignored if this index does not keep tags.
+     * @throws EvioException if tags are kept and there are fewer tagNums than lengths.
+     */
+    void EventIndexFile::addRecord(uint64_t position, uint32_t length, uint32_t dataOffset,
+                                   const std::vector<uint32_t> & lengths,
+                                   const std::vector<uint32_t> & tagNums) {
+        if (withTags && tagNums.size() < lengths.size()) {
+            throw EvioException("need tag & num of each event");
+        }
+
+        uint32_t count = lengths.size();
+        recordPositions.push_back(position);
+        recordLengths.push_back(length);
+        recordCounts.push_back(count);
+        recordDataOffsets.push_back(dataOffset);
+        firstEvents.push_back(firstEvents.back() + count);
+
+        if (compacted) {
+            compactEvents.addRecord(lengths.data(), count);
+        }
+        uint32_t offset = 0;
+        for (uint32_t i=0; i < count; i++) {
+            if (!compacted) {
+                eventOffsets.push_back(offset);
+                eventLengths.push_back(lengths[i]);
+            }
+            if (withTags) eventTagNums.push_back(tagNums[i]);
+            offset += lengths[i];
+        }
+
+        dataEnd = position + length;
+    }
+
+
+    /**
+     * Write this index into a file.
+     * @param fileName name of file to write.
+     * @throws EvioException if file cannot be written.
+     */
+    void EventIndexFile::write(std::string const & fileName) const {
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc | std::ios::out);
+        if (!file.is_open()) {
+            throw EvioException("cannot open index file " + fileName);
+        }
+
+        uint32_t header[HEADER_WORDS] = {MAGIC, VERSION, withTags ? HAS_TAGS_BIT : 0,
+                                         getRecordCount(), getEventCount(), 0,
+                                         static_cast<uint32_t>(dataEnd),
+                                         static_cast<uint32_t>(dataEnd >> 32)};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+        uint32_t records = getRecordCount();
+        uint32_t events  = getEventCount();
+
+        // A compact index is written as a plain one
+        std::vector<uint32_t> offsets, lengths;
+        if (compacted) {
+            offsets.reserve(events);
+            lengths.reserve(events);
+            for (uint32_t i=0; i < records; i++) {
+                uint32_t offset = 0;
+                for (uint32_t j = firstEvents[i]; j < firstEvents[i+1]; j++) {
+                    uint32_t len = compactEvents.getEventLength(j);
+                    offsets.push_back(offset);
+                    lengths.push_back(len);
+                    offset += len;
+                }
+            }
+        }
+        const std::vector<uint32_t> & offsetsOut = compacted ? offsets : eventOffsets;
+        const std::vector<uint32_t> & lengthsOut = compacted ? lengths : eventLengths;
+
+        file.write(reinterpret_cast<const char *>(recordPositions.data()),   8*records);
+        file.write(reinterpret_cast<const char *>(recordLengths.data()),     4*records);
+        file.write(reinterpret_cast<const char *>(recordCounts.data()),      4*records);
+        file.write(reinterpret_cast<const char *>(recordDataOffsets.data()), 4*records);
+        file.write(reinterpret_cast<const char *>(offsetsOut.data()),        4*events);
+        file.write(reinterpret_cast<const char *>(lengthsOut.data()),        4*events);
+        if (withTags) {
+            file.write(reinterpret_cast<const char *>(eventTagNums.data()),  4*events);
+        }
+
+        file.close();
+        if (file.fail()) {
+            throw EvioException("error writing index file " + fileName);
+        }
+    }
+
+
+    /**
+     * Replace the contents of this index with those read from a file.
+     * On failure this index is left empty.
+     * @param fileName name of file to read.
+     * @return true if file was read, false if it does not exist or is not a valid index file.
+     */
+    bool EventIndexFile::read(std::string const & fileName) {
+        clear();
+
+        std::ifstream file(fileName, std::ios::binary | std::ios::in);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        uint32_t header[HEADER_WORDS];
+        file.read(reinterpret_cast<char *>(header), sizeof(header));
+        if (!file.good()) {
+            return false;
+        }
+
+        bool swap = false;
+        if (header[0] == SWAP_32(MAGIC)) {
+            swap = true;
+            for (uint32_t &word : header) word = SWAP_32(word);
+        }
+        if (header[0] != MAGIC || header[1] != VERSION) {
+            return false;
+        }
+
+        withTags = (header[2] & HAS_TAGS_BIT) != 0;
+        uint32_t records = header[3];
+        uint32_t events  = header[4];
+
+        recordPositions.resize(records);
+        recordLengths.resize(records);
+        recordCounts.resize(records);
+        recordDataOffsets.resize(records);
+        eventOffsets.resize(events);
+        eventLengths.resize(events);
+        eventTagNums.resize(withTags ? events : 0);
+
+        file.read(reinterpret_cast<char *>(recordPositions.data()),   8*records);
+        file.read(reinterpret_cast<char *>(recordLengths.data()),     4*records);
+        file.read(reinterpret_cast<char *>(recordCounts.data()),      4*records);
+        file.read(reinterpret_cast<char *>(recordDataOffsets.data()), 4*records);
+        file.read(reinterpret_cast<char *>(eventOffsets.data()),      4*events);
+        file.read(reinterpret_cast<char *>(eventLengths.data()),      4*events);
+        if (withTags) {
+            file.read(reinterpret_cast<char *>(eventTagNums.data()),  4*events);
+        }
+        if (!file.good()) {
+            clear();
+            return false;
+        }
+
+        if (swap) {
+            for (uint64_t &val : recordPositions)   val = SWAP_64(val);
+            for (uint32_t &val : recordLengths)     val = SWAP_32(val);
+            for (uint32_t &val : recordCounts)      val = SWAP_32(val);
+            for (uint32_t &val : recordDataOffsets) val = SWAP_32(val);
+            for (uint32_t &val : eventOffsets)      val = SWAP_32(val);
+            for (uint32_t &val : eventLengths)      val = SWAP_32(val);
+            for (uint32_t &val : eventTagNums)      val = SWAP_32(val);
+        }
+
+        firstEvents.reserve(records + 1);
+        for (uint32_t i=0; i < records; i++) {
+            firstEvents.push_back(firstEvents.back() + recordCounts[i]);
+        }
+
+        // Record event counts must agree with the number of events
+        if (firstEvents.back() != events) {
+            clear();
+            return false;
+        }
+
+        dataEnd = (static_cast<uint64_t>(header[7]) << 32) | header[6];
+        return true;
+    }
+
+
+    /**
+     * Remove all records not entirely contained in a file of the given size.
+     * Used when the evio file was cut short after its index was written.
+     * @param fileSize size of evio file in bytes.
+     */
+    void EventIndexFile::truncate(uint64_t fileSize) {
+        uint32_t records = getRecordCount();
+        while (records > 0 && recordPositions[records-1] + recordLengths[records-1] > fileSize) {
+            records--;
+        }
+        if (records == getRecordCount()) return;
+
+        uint32_t events = firstEvents[records];
+        recordPositions.resize(records);
+        recordLengths.resize(records);
+        recordCounts.resize(records);
+        recordDataOffsets.resize(records);
+        firstEvents.resize(records + 1);
+        if (compacted) {
+            compactEvents.truncate(records);
+        }
+        else {
+            eventOffsets.resize(events);
+            eventLengths.resize(events);
+        }
+        if (withTags) eventTagNums.resize(events);
+
+        dataEnd = records > 0 ? recordPositions[records-1] + recordLengths[records-1] : 0;
+    }
+
+
+    /**
+     * Hold the offsets and lengths of events in a {@link CompactEventIndex}, which for
+     * events of similar size takes about a tenth of the memory, at the cost of decoding
+     * them when asked for. Records can still be added. Tags and nums are not compacted.
+     * Not done if events of some record are not back to back.
+     * @return true if index is compact.
+     */
+    bool EventIndexFile::compact() {
+        if (compacted) return true;
+
+        CompactEventIndex index;
+        for (uint32_t i=0; i < getRecordCount(); i++) {
+            uint32_t first = firstEvents[i];
+            uint32_t offset = 0;
+            for (uint32_t j = first; j < firstEvents[i+1]; j++) {
+                if (eventOffsets[j] != offset) {
+                    return false;
+                }
+                offset += eventLengths[j];
+            }
+            index.addRecord(eventLengths.data() + first, recordCounts[i]);
+        }
+        index.shrinkToFit();
+
+        compactEvents = std::move(index);
+        compacted = true;
+        std::vector<uint32_t>().swap(eventOffsets);
+        std::vector<uint32_t>().swap(eventLengths);
+        return true;
+    }
+
+
+    /**
+     * Get the index of the record containing an event.
+     * @param event event index.
+     * @return index of record containing event.
+     * @throws EvioException if event index is out of range.
+     */
+    uint32_t EventIndexFile::getRecordOfEvent(uint32_t event) const {
+        if (event >= getEventCount()) {
+            throw EvioException("event index " + std::to_string(event) + " out of range");
+        }
+        // First element of firstEvents greater than event is one past the record
+        auto it = std::upper_bound(firstEvents.cbegin(), firstEvents.cend(), event);
+        return std::distance(firstEvents.cbegin(), it) - 1;
+    }
+
+
+    /**
+     * Get the position of an event in the evio file, allowing it to be read directly.
+     * @param event event index.
+     * @return file position of event, or 0 if it is in a compressed record.
+     * @throws EvioException if event index is out of range.
+     */
+    uint64_t EventIndexFile::getEventFilePosition(uint32_t event) const {
+        uint32_t record = getRecordOfEvent(event);
+        if (recordDataOffsets[record] == 0) {
+            return 0;
+        }
+        return recordPositions[record] + recordDataOffsets[record] + getEventOffset(event);
+    }
+
+
+    /**
+     * Find all events with the given tag and num.
+     * @param tag tag to match.
+     * @param num num to match.
+     * @param vec vector to be filled with indexes of matching events
+     *            (empty if none found or if tags are not kept).
+     */
+    void EventIndexFile::findEvents(uint16_t tag, uint8_t num, std::vector<uint32_t> & vec) const {
+        vec.clear();
+        if (!withTags) return;
+
+        uint32_t tagNum = (static_cast<uint32_t>(tag) << 16) | num;
+        for (size_t i=0; i < eventTagNums.size(); i++) {
+            if (eventTagNums[i] == tagNum) {
+                vec.push_back(i);
+            }
+        }
+    }
+
+
+    /**
+     * Add a record, read from file, with the length of each of its events
+     * and, if keeping them, each event's tag and num.
+     *
+     * @param position file position of record.
+     * @param length   length of record in bytes.
+     * @param record   record read from the file.
+     */
+    void EventIndexFile::addRecord(uint64_t position, uint32_t length, RecordInput & record) {
+        std::vector<uint32_t> lengths;
+        std::vector<uint32_t> tagNums;
+
+        auto header = record.getHeader();
+        uint32_t dataOffset = 0;
+        if (header->getCompressionType() == Compressor::UNCOMPRESSED) {
+            dataOffset = header->getHeaderLength() + header->getIndexLength() +
+                         4*header->getUserHeaderLengthWords();
+        }
+
+        uint32_t count = record.getEntries();
+        for (uint32_t j=0; j < count; j++) {
+            uint32_t len = record.getEventLength(j);
+            lengths.push_back(len);
+            if (withTags) {
+                uint32_t word = 0;
+                if (len > 7) {
+                    uint32_t evLen;
+                    auto event = record.getEvent(j, &evLen);
+                    std::memcpy(&word, event.get() + 4, 4);
+                    if (!record.getByteOrder().isLocalEndian()) word = SWAP_32(word);
+                }
+                tagNums.push_back((word & 0xffff0000) | (word & 0xff));
+            }
+        }
+
+        addRecord(position, length, dataOffset, lengths, tagNums);
+    }
+
+
+    /**
+     * Build an index of an existing evio version 6 file.
+     * Each record is read in turn, and decompressed if necessary.
+     *
+     * @param fileName name of evio file.
+     * @param tags if true, keep the tag and num of each event.
+     * @return index of file.
+     * @throws EvioException if file cannot be read or is not in evio version 6 format.
+     */
+    std::shared_ptr<EventIndexFile> EventIndexFile::build(std::string const & fileName, bool tags) {
+        auto index = std::make_shared<EventIndexFile>(tags);
+        Reader reader(fileName);
+
+        auto & positions = reader.getRecordPositions();
+        for (uint32_t i=0; i < positions.size(); i++) {
+            reader.readRecord(i);
+            index->addRecord(positions[i].getPosition(), positions[i].getLength(),
+                             reader.getCurrentRecordStream());
+        }
+
+        return index;
+    }
+
+
+    /**
+     * Build an index of a damaged evio version 6 file which a {@link Reader} cannot open,
+     * such as one cut short without a trailer. Its records are found in parallel by
+     * {@link Reader#recoverRecords}, and any which cannot be read are left out.
+     * Once written next to the file, a Reader of the file uses it to find the records.
+     *
+     * @param fileName name of evio file.
+     * @param tags     if true, keep the tag and num of each event.
+     * @param threads  number of threads to search the file with, 0 for one per cpu core.
+     * @return index of file.
+     * @throws EvioException if file cannot be read or its file header is not evio version 6.
+     */
+    std::shared_ptr<EventIndexFile> EventIndexFile::recover(std::string const & fileName, bool tags,
+                                                            uint32_t threads) {
+        auto index = std::make_shared<EventIndexFile>(tags);
+        auto positions = Reader::recoverRecords(fileName, threads);
+
+        std::ifstream file(fileName, std::ios::binary);
+        RecordInput record;
+        for (auto & pos : positions) {
+            try {
+                record.readRecord(file, pos.getPosition());
+            }
+            catch (EvioException & e) {
+                file.clear();
+                continue;
+            }
+            index->addRecord(pos.getPosition(), pos.getLength(), record);
+        }
+
+        return index;
+    }
+
+
+    /**
+     * Obtain a string representation of this index.
+     * @return string representation of this index.
+     */
+    std::string EventIndexFile::toString() const {
+        std::stringstream ss;
+        ss << "EventIndexFile of " << getRecordCount() << " records, " << getEventCount() <<
+              " events, data end = " << dataEnd << ", tags = " << withTags << std::endl;
+        for (uint32_t i=0; i < getRecordCount(); i++) {
+            ss << "  record " << i << ": pos = " << recordPositions[i] << ", len = " << recordLengths[i] <<
+                  ", events = " << recordCounts[i] << ", first event = " << firstEvents[i] <<
+                  ", data offset = " << recordDataOffsets[i] << std::endl;
+        }
+        return ss.str();
+    }
+
+}
@@ -0,0 +1,193 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVENTINDEXFILE_H
+#define EVIO_6_0_EVENTINDEXFILE_H
+
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+
+#include "EvioException.h"
+#include "ByteOrder.h"
+#include "CompactEventIndex.h"
+
+
+namespace evio {
+
+
+    class RecordOutput;
+    class RecordInput;
+
+
+    /**
+     * This class is an index of all the records and events in an evio version 6 file,
+     * kept in a separate, "sidecar" file next to it. Record positions, lengths and event
+     * counts are stored along with the offset and length of each event and, optionally,
+     * each event's tag and num. With it, a {@link Reader} of a file lacking a trailer index,
+     * or a file that was cut short, can find its records without scanning through every
+     * record header, and the file position of any event in an uncompressed record is known
+     * without reading anything at all.<p>
+     *
+     * An index is filled by {@link EventWriter} or {@link Writer} as records are written and
+     * saved when their file is closed, or it is built afterwards from an existing file by
+     * {@link #build(std::string const &, bool)} (see the evioIndex program).<p>
+     *
+     * The sidecar file is in local byte order, which is detected by its magic number when read.
+     * It consists of an 8 word header followed by parallel arrays:
+     * <pre><code>
+     *    word 0     magic # (0x45564958, "EVIX")
+     *    word 1     version
+     *    word 2     bit info (bit 0 = has tag/num of each event)
+     *    word 3     number of records
+     *    word 4     number of events
+     *    word 5     reserved
+     *    word 6,7   64 bit position in evio file just past the last indexed record
+     *
+     *    64 bit file position of each record
+     *    length of each record in bytes
+     *    number of events in each record
+     *    offset from beginning of each record to its first event, 0 if compressed
+     *    offset of each event from the first event in its record
+     *    length of each event in bytes
+     *    tag (upper 16 bits) and num (lower 8 bits) of each event, if present
+     * </code></pre>
+     */
+    class EventIndexFile {
+
+    public:
+
+        /** Magic number identifying a sidecar index file ("EVIX"). */
+        static const uint32_t MAGIC = 0x45564958;
+        /** Version of the sidecar index file format. */
+        static const uint32_t VERSION = 1;
+        /** Number of 32-bit words in the sidecar index file header. */
+        static const uint32_t HEADER_WORDS = 8;
+        /** Bit in header's bit info word set if each event's tag and num are included. */
+        static const uint32_t HAS_TAGS_BIT = 0x1;
+
+    private:
+
+        /** File position of each record. */
+        std::vector<uint64_t> recordPositions;
+        /** Length of each record in bytes. */
+        std::vector<uint32_t> recordLengths;
+        /** Number of events in each record. */
+        std::vector<uint32_t> recordCounts;
+        /** Offset from beginning of each record to its first event, 0 if record is compressed. */
+        std::vector<uint32_t> recordDataOffsets;
+        /** Index of first event of each record, one entry larger than number of records. */
+        std::vector<uint32_t> firstEvents {0};
+
+        /** Offset of each event from the first event in its record. */
+        std::vector<uint32_t> eventOffsets;
+        /** Length of each event in bytes. */
+        std::vector<uint32_t> eventLengths;
+        /** Tag (upper 16 bits) and num (lower 8 bits) of each event if withTags is true. */
+        std::vector<uint32_t> eventTagNums;
+
+        /** Offsets and lengths of events once {@link #compact()} is called,
+         *  instead of eventOffsets and eventLengths. */
+        CompactEventIndex compactEvents;
+        /** Are offsets and lengths of events in compactEvents? */
+        bool compacted = false;
+
+        /** File position just past the last indexed record. */
+        uint64_t dataEnd = 0;
+
+        /** Keep the tag and num of each event? */
+        bool withTags = false;
+
+    public:
+
+        /**
+         * Constructor.
+         * @param tags if true, keep the tag and num of each event.
+         */
+        explicit EventIndexFile(bool tags = false) : withTags(tags) {}
+
+        static std::string sidecarName(std::string const & fileName);
+        static std::shared_ptr<EventIndexFile> build(std::string const & fileName, bool tags = false);
+        static std::shared_ptr<EventIndexFile> recover(std::string const & fileName, bool tags = false,
+                                                       uint32_t threads = 0);
+
+        void clear();
+
+        void addRecord(uint64_t position, RecordOutput & record);
+        void addRecord(uint64_t position, uint32_t length, uint32_t dataOffset,
+                       const std::vector<uint32_t> & lengths,
+                       const std::vector<uint32_t> & tagNums);
+        void addRecord(uint64_t position, uint32_t length, RecordInput & record);
+
+        void write(std::string const & fileName) const;
+        bool read(std::string const & fileName);
+        void truncate(uint64_t fileSize);
+        bool compact();
+
+        /** @return true if offsets and lengths of events are held compactly. */
+        bool isCompact()              const {return compacted;}
+
+        /** @return true if the tag and num of each event are kept. */
+        bool hasTags()                const {return withTags;}
+        /** @return number of records in the index. */
+        uint32_t getRecordCount()     const {return recordPositions.size();}
+        /** @return number of events in the index. */
+        uint32_t getEventCount()      const {return firstEvents.back();}
+        /** @return file position just past the last indexed record. */
+        uint64_t getDataEnd()         const {return dataEnd;}
+
+        /** @param index record index. @return file position of record. */
+        uint64_t getRecordPosition(uint32_t index)   const {return recordPositions[index];}
+        /** @param index record index. @return length of record in bytes. */
+        uint32_t getRecordLength(uint32_t index)     const {return recordLengths[index];}
+        /** @param index record index. @return number of events in record. */
+        uint32_t getRecordEventCount(uint32_t index) const {return recordCounts[index];}
+        /** @param index record index. @return index of first event in record. */
+        uint32_t getRecordFirstEvent(uint32_t index) const {return firstEvents[index];}
+        /** @param index record index. @return true if record is compressed. */
+        bool isRecordCompressed(uint32_t index)      const {return recordDataOffsets[index] == 0;}
+
+        uint32_t getRecordOfEvent(uint32_t event) const;
+        uint64_t getEventFilePosition(uint32_t event) const;
+
+        /** @param event event index. @return length of event in bytes. */
+        uint32_t getEventLength(uint32_t event) const {
+            return compacted ? compactEvents.getEventLength(event) : eventLengths[event];
+        }
+        /** @param event event index. @return offset of event from first event in its record. */
+        uint32_t getEventOffset(uint32_t event) const {
+            return compacted ? compactEvents.getEventOffset(event) : eventOffsets[event];
+        }
+        /** @return bytes of memory used by the offsets and lengths of events. */
+        size_t getEventMemoryBytes() const {
+            return compacted ? compactEvents.getMemoryBytes() :
+                   4*(eventOffsets.capacity() + eventLengths.capacity());
+        }
+        /** @param event event index. @return tag of event, 0 if tags not kept. */
+        uint16_t getEventTag(uint32_t event) const {return withTags ? eventTagNums[event] >> 16 : 0;}
+        /** @param event event index. @return num of event, 0 if tags not kept. */
+        uint8_t  getEventNum(uint32_t event) const {return withTags ? eventTagNums[event] & 0xff : 0;}
+
+        void findEvents(uint16_t tag, uint8_t num, std::vector<uint32_t> & vec) const;
+
+        std::string toString() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVENTINDEXFILE_H
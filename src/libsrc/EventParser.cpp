@@ -9,6 +9,7 @@
 
 
 #include "EventParser.h"
+#include "Profiler.h"
 
 
 namespace  evio {
@@ -25,6 +26,21 @@ namespace  evio {
     }
 
 
+    /**
+     * Method for parsing the event which will drill down and uncover only those structures
+     * whose headers are accepted by the filter's {@link IEvioFilter#acceptHeader} method.
+     * Rejected structures, and all they contain, are never created. The event itself is always kept.
+     * No listeners are notified.
+     *
+     * @param evioEvent the event to parse.
+     * @param filter    filter deciding which structures to create. If null, all are created.
+     * @throws EvioException if data not in evio format.
+     */
+    void EventParser::eventParse(std::shared_ptr<EvioEvent> & evioEvent, std::shared_ptr<IEvioFilter> const & filter) {
+        parsePruned(evioEvent, filter.get(), nullptr);
+    }
+
+
     /**
      * Parse a structure. If it is a structure of structures, such as a bank of banks or a segment of tag segments,
      * parse recursively.
@@ -47,7 +63,8 @@ namespace  evio {
         // Does the present structure contain structures? (as opposed to a leaf, which contains primitives). If
         // it is a leaf we are done. That will leave the raw bytes in the "leaf" structures (e.g., a bank of ints)
         // --which will be interpreted by the various "get data" methods.
-        auto bytes = structure->getRawBytes();
+        // Reference, not copy, since children take their bytes from it
+        auto & bytes = structure->getRawBytes();
         ByteOrder byteOrder = structure->getByteOrder();
 
         if (bytes.empty()) {
@@ -122,6 +139,164 @@ namespace  evio {
         }
     }
 
+    /**
+     * Take the last of a list of structures to be reused.
+     * @param spares structures to be reused, not empty.
+     * @return structure taken from spares.
+     */
+    std::shared_ptr<BaseStructure> EventParser::takeSpare(std::vector<std::shared_ptr<BaseStructure>> & spares) {
+        std::shared_ptr<BaseStructure> structure = std::move(spares.back());
+        spares.pop_back();
+        return structure;
+    }
+
+
+    /**
+     * Empty a structure and move all its descendants into the spare lists of an event,
+     * each emptied too. They go in the reverse of the order parsing finds them so that,
+     * taken from the back, an event of the same shape gets back the same objects
+     * in the same places, already grown to the right size.
+     *
+     * @param structure structure to empty.
+     * @param event     event whose spare lists get the descendants.
+     */
+    void EventParser::recycle(BaseStructure & structure, EvioEvent & event) {
+        for (auto it = structure.children.rbegin(); it != structure.children.rend(); ++it) {
+            recycle(**it, event);
+            StructureType type = (*it)->getStructureType();
+            if (type == StructureType::STRUCT_BANK) {
+                event.spareBanks.push_back(std::move(*it));
+            }
+            else if (type == StructureType::STRUCT_SEGMENT) {
+                event.spareSegments.push_back(std::move(*it));
+            }
+            else {
+                event.spareTagSegments.push_back(std::move(*it));
+            }
+        }
+        structure.resetForReuse();
+    }
+
+
+    /**
+     * Parse an event without recursion, skipping structures whose headers the filter rejects
+     * before anything is allocated for them. Structures are added to the tree as they're found,
+     * and listeners are notified of each, children before parents, as when parsing recursively.
+     * If viewing, no structure gets a copy of its data; each only views its part of
+     * the event's raw bytes (see {@link BaseStructure#setRawBytesView}).
+     * Structures left over from the event's last parse are reused before any new ones are made.
+     *
+     * @param evioEvent the event to parse.
+     * @param filter    filter rejecting unwanted headers. If null, all structures are created.
+     * @param notifier  parser whose listeners are notified of each structure created. If null, no notification.
+     * @param view      if true, structures view the event's raw bytes instead of copying them.
+     * @throws EvioException if data not in evio format.
+     */
+    void EventParser::parsePruned(std::shared_ptr<EvioEvent> & evioEvent, IEvioFilter * filter,
+                                  EventParser * notifier, bool view) {
+
+        std::vector<ParseFrame> stack;
+        stack.reserve(16);
+        stack.push_back({evioEvent, 0});
+
+        while (!stack.empty()) {
+            ParseFrame & frame = stack.back();
+            DataType dataType = frame.structure->getHeader()->getDataType();
+            ByteBufferView bytes = frame.structure->getRawBytesView();
+
+            if (dataType.isStructure() && frame.offset == 0 && bytes.empty()) {
+                throw EvioException("Null data in structure");
+            }
+
+            // Leaf, or all children done, so this structure is finished
+            if (!dataType.isStructure() || frame.offset >= bytes.size()) {
+                std::shared_ptr<BaseStructure> structure = std::move(frame.structure);
+                stack.pop_back();
+                if (notifier != nullptr) {
+                    notifier->notifyEvioListeners(evioEvent, structure);
+                }
+                continue;
+            }
+
+            size_t childOffset = frame.offset;
+            const uint8_t *childBytes = bytes.data() + childOffset;
+            size_t bytesLeft = bytes.size() - childOffset;
+            ByteOrder byteOrder = frame.structure->getByteOrder();
+            std::shared_ptr<BaseStructure> child;
+            size_t totalBytes, headerBytes;
+
+            if (dataType == DataType::BANK || dataType == DataType::ALSOBANK) {
+                // Read straight into the header of a structure to be reused, if any
+                auto & spares = evioEvent->spareBanks;
+                BankHeader local;
+                BankHeader & header = spares.empty() ? local : static_cast<BankHeader &>(*spares.back()->header);
+                EventHeaderParser::readBankHeader(childBytes, byteOrder, header);
+                totalBytes = 4 * ((size_t)header.getLength() + 1);
+                if (header.getLength() < 1 || totalBytes > bytesLeft) {
+                    throw EvioException("Bank length too large for its parent");
+                }
+                frame.offset += totalBytes;
+
+                if (filter != nullptr && !filter->acceptHeader(StructureType::STRUCT_BANK, header)) {
+                    continue;
+                }
+                child = spares.empty() ? EvioBank::getInstance(std::make_shared<BankHeader>(header)) :
+                                         takeSpare(spares);
+                headerBytes = 8;
+            }
+            else if (dataType == DataType::SEGMENT || dataType == DataType::ALSOSEGMENT) {
+                auto & spares = evioEvent->spareSegments;
+                SegmentHeader local;
+                SegmentHeader & header = spares.empty() ? local : static_cast<SegmentHeader &>(*spares.back()->header);
+                EventHeaderParser::readSegmentHeader(childBytes, byteOrder, header);
+                totalBytes = 4 * ((size_t)header.getLength() + 1);
+                if (totalBytes > bytesLeft) {
+                    throw EvioException("Segment length too large for its parent");
+                }
+                frame.offset += totalBytes;
+
+                if (filter != nullptr && !filter->acceptHeader(StructureType::STRUCT_SEGMENT, header)) {
+                    continue;
+                }
+                child = spares.empty() ? EvioSegment::getInstance(std::make_shared<SegmentHeader>(header)) :
+                                         takeSpare(spares);
+                headerBytes = 4;
+            }
+            else {
+                auto & spares = evioEvent->spareTagSegments;
+                TagSegmentHeader local;
+                TagSegmentHeader & header = spares.empty() ? local : static_cast<TagSegmentHeader &>(*spares.back()->header);
+                EventHeaderParser::readTagSegmentHeader(childBytes, byteOrder, header);
+                totalBytes = 4 * ((size_t)header.getLength() + 1);
+                if (totalBytes > bytesLeft) {
+                    throw EvioException("Tagsegment length too large for its parent");
+                }
+                frame.offset += totalBytes;
+
+                if (filter != nullptr && !filter->acceptHeader(StructureType::STRUCT_TAGSEGMENT, header)) {
+                    continue;
+                }
+                child = spares.empty() ? EvioTagSegment::getInstance(std::make_shared<TagSegmentHeader>(header)) :
+                                         takeSpare(spares);
+                headerBytes = 4;
+            }
+
+            if (view) {
+                child->setRawBytesView(frame.structure, childOffset + headerBytes, totalBytes - headerBytes);
+            }
+            else {
+                child->setRawBytes(childBytes + headerBytes, totalBytes - headerBytes);
+            }
+
+            frame.structure->add(child);
+            child->setByteOrder(byteOrder);
+
+            // frame is no longer valid after this
+            stack.push_back({child, 0});
+        }
+    }
+
+
     // Now the non-static parser
 
     /**
@@ -132,6 +307,7 @@ namespace  evio {
    	 * @throws EvioException if arg is null or data not in evio format.
    	 */
     void EventParser::parseEvent(std::shared_ptr<EvioEvent> & evioEvent) {
+        EVIO_PROFILE_SCOPE(EVENT_PARSE);
 
         auto lock = std::unique_lock<std::recursive_mutex>(mtx); // equivalent to mtx.lock();
 
@@ -147,9 +323,17 @@ namespace  evio {
         //let listeners know we started
         notifyStart(evioEvent);
 
-        // The event itself is a structure (EvioEvent extends EvioBank) so just
-        // parse it as such. The recursive drill down will take care of the rest.
-        parseStructure(evioEvent, evioEvent);
+        if (pruning || viewing) {
+            parsePruned(evioEvent, pruning ? evioFilter.get() : nullptr, this, viewing);
+        }
+        else if (parseThreads > 1 && evioEvent->getRawBytes().size() >= PARALLEL_PARSE_MIN_BYTES) {
+            parseParallel(evioEvent);
+        }
+        else {
+            // The event itself is a structure (EvioEvent extends EvioBank) so just
+            // parse it as such. The recursive drill down will take care of the rest.
+            parseStructure(evioEvent, evioEvent);
+        }
 
         evioEvent->setParsed(true);
 
@@ -175,6 +359,8 @@ namespace  evio {
             return;
         }
 
+        EVIO_PROFILE_SCOPE(EVENT_PARSE);
+
         if (evioEvent == nullptr) {
             throw EvioException("Null event in parseEvent");
         }
@@ -187,9 +373,17 @@ namespace  evio {
         //let listeners know we started
         notifyStart(evioEvent);
 
-        // The event itself is a structure (EvioEvent extends EvioBank) so just
-        // parse it as such. The recursive drill down will take care of the rest.
-        parseStructure(evioEvent, evioEvent);
+        if (pruning || viewing) {
+            parsePruned(evioEvent, pruning ? evioFilter.get() : nullptr, this, viewing);
+        }
+        else if (parseThreads > 1 && evioEvent->getRawBytes().size() >= PARALLEL_PARSE_MIN_BYTES) {
+            parseParallel(evioEvent);
+        }
+        else {
+            // The event itself is a structure (EvioEvent extends EvioBank) so just
+            // parse it as such. The recursive drill down will take care of the rest.
+            parseStructure(evioEvent, evioEvent);
+        }
 
         evioEvent->setParsed(true);
 
@@ -198,6 +392,57 @@ namespace  evio {
     }
 
 
+    /**
+     * Parse the bytes of an event into a given event object, reusing it and all the structures
+     * it held from any earlier parse, as well as the capacity of their vectors, instead of
+     * allocating new ones. Once the number and sizes of structures per event level off, parsing
+     * event after event into the same object allocates close to nothing.
+     * Listeners are notified and the filter used, when pruning, as in {@link #parseEvent}.
+     * Structures gotten from the event before this call must not be kept since they are emptied
+     * and refilled.
+     *
+     * @param src       bytes of event, starting with its bank header.
+     * @param len       max number of valid bytes in src.
+     * @param order     byte order of src.
+     * @param evioEvent event to fill. If null, a new one is made and returned here.
+     * @throws EvioException if src is null, too little data, or data not in evio format.
+     */
+    void EventParser::parseEvent(const uint8_t *src, size_t len, ByteOrder const & order,
+                                 std::shared_ptr<EvioEvent> & evioEvent) {
+        EVIO_PROFILE_SCOPE(EVENT_PARSE);
+
+        auto lock = std::unique_lock<std::recursive_mutex>(mtx);
+
+        if (src == nullptr || len < 8) {
+            throw EvioException("arg null or too little data");
+        }
+
+        if (evioEvent == nullptr) {
+            evioEvent = EvioEvent::getInstance();
+        }
+        else {
+            recycle(*evioEvent, *evioEvent);
+        }
+
+        auto & header = static_cast<BankHeader &>(*evioEvent->header);
+        EventHeaderParser::readBankHeader(src, order, header);
+        size_t totalBytes = 4 * ((size_t)header.getLength() + 1);
+        if (header.getLength() < 1 || totalBytes > len) {
+            throw EvioException("bank length too large (needed " + std::to_string(totalBytes) +
+                                " but have " + std::to_string(len) + " bytes)");
+        }
+
+        evioEvent->setRawBytes(src + 8, totalBytes - 8);
+        evioEvent->setByteOrder(order);
+        evioEvent->setParsed(false);
+
+        notifyStart(evioEvent);
+        parsePruned(evioEvent, pruning ? evioFilter.get() : nullptr, this, viewing);
+        evioEvent->setParsed(true);
+        notifyStop(evioEvent);
+    }
+
+
     /**
 	 * Parse a structure. If it is a structure of structures, such as a bank of banks or a segment of tag segments,
 	 * parse recursively. Listeners are notified AFTER all their children have been handled, not before. Thus the
@@ -225,7 +470,8 @@ namespace  evio {
         // Does the present structure contain structures? (as opposed to a leaf, which contains primitives). If
         // it is a leaf we are done. That will leave the raw bytes in the "leaf" structures (e.g., a bank of ints)
         // --which will be interpreted by the various "get data" methods.
-        auto bytes = structure->getRawBytes();
+        // Reference, not copy, since children take their bytes from it
+        auto & bytes = structure->getRawBytes();
         ByteOrder byteOrder = structure->getByteOrder();
 
         if (bytes.empty()) {
@@ -305,6 +551,128 @@ namespace  evio {
     }
 
 
+    /**
+     * Parse an event by splitting its top level children among several threads.
+     * First, in this thread, the children's headers are read, one after the other, to find
+     * where each child starts and ends and to create it. Then each thread takes children,
+     * one at a time, copies in their data and parses their subtrees, which are independent of
+     * each other. Once all are done, the children are added to the event in order and
+     * the listeners notified of every structure, children before parents,
+     * just as {@link #parseStructure} would have done on one thread.
+     *
+     * @param evioEvent the event to parse.
+     * @throws EvioException if data not in evio format.
+     */
+    void EventParser::parseParallel(std::shared_ptr<EvioEvent> & evioEvent) {
+
+        DataType dataType = evioEvent->getHeader()->getDataType();
+        if (!dataType.isStructure()) {
+            parseStructure(evioEvent, evioEvent);
+            return;
+        }
+
+        auto & bytes = evioEvent->getRawBytes();
+        ByteOrder byteOrder = evioEvent->getByteOrder();
+        size_t length = bytes.size();
+
+        // Header pass: find each child's place in the event and create it
+        std::vector<std::shared_ptr<BaseStructure>> kids;
+        std::vector<size_t> offsets;
+        size_t headerBytes = 4;
+        size_t offset = 0;
+
+        while (offset < length) {
+            uint8_t *childBytes = bytes.data() + offset;
+            size_t bytesLeft = length - offset;
+            size_t totalBytes;
+
+            if (dataType == DataType::BANK || dataType == DataType::ALSOBANK) {
+                if (bytesLeft < 8) {
+                    throw EvioException("Bank length too large for its parent");
+                }
+                auto header = EventHeaderParser::createBankHeader(childBytes, byteOrder);
+                totalBytes = 4 * ((size_t)header->getLength() + 1);
+                if (header->getLength() < 1 || totalBytes > bytesLeft) {
+                    throw EvioException("Bank length too large for its parent");
+                }
+                kids.push_back(EvioBank::getInstance(header));
+                headerBytes = 8;
+            }
+            else if (dataType == DataType::SEGMENT || dataType == DataType::ALSOSEGMENT) {
+                auto header = EventHeaderParser::createSegmentHeader(childBytes, byteOrder);
+                totalBytes = 4 * ((size_t)header->getLength() + 1);
+                if (totalBytes > bytesLeft) {
+                    throw EvioException("Segment length too large for its parent");
+                }
+                kids.push_back(EvioSegment::getInstance(header));
+            }
+            else {
+                auto header = EventHeaderParser::createTagSegmentHeader(childBytes, byteOrder);
+                totalBytes = 4 * ((size_t)header->getLength() + 1);
+                if (totalBytes > bytesLeft) {
+                    throw EvioException("Tagsegment length too large for its parent");
+                }
+                kids.push_back(EvioTagSegment::getInstance(header));
+            }
+
+            offsets.push_back(offset);
+            offset += totalBytes;
+        }
+
+        // Children are taken one at a time since their sizes may differ greatly
+        std::atomic<size_t> nextKid{0};
+        auto work = [&]() {
+            size_t i;
+            while ((i = nextKid.fetch_add(1)) < kids.size()) {
+                auto & kid = kids[i];
+                size_t dataBytes = 4 * (size_t)kid->getHeader()->getLength() - (headerBytes - 4);
+                kid->setRawBytes(bytes.data() + offsets[i] + headerBytes, dataBytes);
+                kid->setByteOrder(byteOrder);
+                parseStruct(kid);
+            }
+        };
+
+        uint32_t threads = std::min((size_t)parseThreads, kids.size());
+        {
+            // Futures wait for their threads when destroyed, even if work throws
+            std::vector<std::future<void>> others;
+            for (uint32_t t=1; t < threads; t++) {
+                others.push_back(std::async(std::launch::async, work));
+            }
+            work();
+            for (auto & f : others) {
+                f.get();
+            }
+        }
+
+        for (auto & kid : kids) {
+            evioEvent->add(kid);
+        }
+
+        // notify the listeners
+        for (auto & kid : kids) {
+            notifyTree(evioEvent, kid);
+        }
+        std::shared_ptr<BaseStructure> structure = evioEvent;
+        notifyEvioListeners(evioEvent, structure);
+    }
+
+
+    /**
+     * Notify listeners of a parsed structure and all its descendants, children before parents.
+     *
+     * @param evioEvent event being parsed
+     * @param structure the structure whose tree is to be notified of.
+     */
+    void EventParser::notifyTree(std::shared_ptr<EvioEvent> & evioEvent,
+                                 std::shared_ptr<BaseStructure> & structure) {
+        for (auto & child : structure->children) {
+            notifyTree(evioEvent, child);
+        }
+        notifyEvioListeners(evioEvent, structure);
+    }
+
+
     /**
      * This is when a structure is encountered while parsing an event.
      * It notifies all listeners about the structure.
@@ -445,6 +813,71 @@ namespace  evio {
     void EventParser::setEvioFilter(std::shared_ptr<IEvioFilter> filter) {evioFilter = filter;}
 
 
+    /**
+     * Is the filter being used to skip unwanted structures before they are created?
+     * @return <code>true</code> if pruning.
+     * @see #setPruning(bool)
+     */
+    bool EventParser::isPruning() const {return pruning;}
+
+
+    /**
+     * Set whether the global filter is used to skip unwanted structures before they are created.
+     * If <code>true</code>, the filter's {@link IEvioFilter#acceptHeader} method is called with each header as
+     * it's found. A rejected structure, along with everything inside it, is never created, added to the event's
+     * tree, or given to the listeners. Structures that are created are still passed to the filter's
+     * {@link IEvioFilter#accept} method before notifying listeners. Defaults to <code>false</code>.
+     *
+     * @param prune <code>true</code> to skip structures whose headers are rejected by the filter.
+     * @see IEvioFilter
+     */
+    void EventParser::setPruning(bool prune) {pruning = prune;}
+
+
+    /**
+     * Are parsed structures given views of the event's raw bytes instead of copies?
+     * @return <code>true</code> if viewing.
+     * @see #setViewing(bool)
+     */
+    bool EventParser::isViewing() const {return viewing;}
+
+
+    /**
+     * Set whether parsed structures are given views of the event's raw bytes instead of copies.
+     * Normally each structure gets a copy of its data, so an event's bytes are stored once for
+     * each level of nesting. If <code>true</code>, structures only point into the event's bytes,
+     * which can then be read without copying through {@link BaseStructure#getIntView()} and
+     * the like. The event must not be changed while its structures are views. Defaults to <code>false</code>.
+     *
+     * @param view <code>true</code> to give parsed structures views of the event's raw bytes.
+     * @see BaseStructure#setRawBytesView
+     */
+    void EventParser::setViewing(bool view) {viewing = view;}
+
+
+    /**
+     * Get the number of threads parsing a giant event's top level children.
+     * @return number of threads, 1 if parsing is done on one thread.
+     * @see #setParseThreads(uint32_t)
+     */
+    uint32_t EventParser::getParseThreads() const {return parseThreads;}
+
+
+    /**
+     * Set the number of threads parsing the top level children of events of at least
+     * {@link #PARALLEL_PARSE_MIN_BYTES}, each child with all it contains being parsed by one thread.
+     * Listeners are notified of the structures in the same order as with one thread, but only once
+     * the whole event is parsed. Events parsed when pruning or viewing use one thread.
+     * Defaults to 1.
+     *
+     * @param threads number of threads. If 0, the number of cores is used.
+     */
+    void EventParser::setParseThreads(uint32_t threads) {
+        if (threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+        parseThreads = threads;
+    }
+
+
     ///////////////////////////////////////////
     //
     //   Scanning parsed BaseStructure trees
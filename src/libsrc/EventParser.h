@@ -18,6 +18,9 @@
 #include <cstring>
 #include <iostream>
 #include <mutex>
+#include <future>
+#include <atomic>
+#include <thread>
 
 
 #include "ByteOrder.h"
@@ -48,18 +51,58 @@ namespace evio {
      * but since that results in C++ circular references, it is now in this class
      * and slightly modified to be static.<p>
      *
+     * When pruning (see {@link #setPruning(bool)}), the filter's {@link IEvioFilter#acceptHeader} is asked about
+     * each header before a structure is created, so unwanted structures and everything in them are never built.
+     * Pruned parsing walks the event with an explicit stack rather than by recursion.<p>
+     *
+     * When viewing (see {@link #setViewing(bool)}), parsed structures point into the event's
+     * raw bytes instead of each holding a copy of its own, and parsing is done as when pruning.<p>
+     *
+     * To avoid allocating a new tree for each event, an event object can be filled again and again
+     * (see {@link #parseEvent(const uint8_t *, size_t, ByteOrder const &, std::shared_ptr<EvioEvent> &)}),
+     * reusing the structures it held last time. Parsing is then done as when pruning.<p>
+     *
+     * Giant events, with many top level children, can be parsed by several threads
+     * (see {@link #setParseThreads(uint32_t)}). A quick pass over the event's children's headers
+     * finds where each starts and ends, then the threads each parse whole children. Listeners
+     * are notified once all is parsed, in the same order as when parsing on one thread.<p>
+     *
      * @author heddle (original Java file).
      * @author timmer
      * @date 5/19/2020
      */
     class EventParser {
 
+    public:
+
+        /** Events with fewer bytes than this are parsed on one thread, even if {@link #setParseThreads} says more. */
+        static const size_t PARALLEL_PARSE_MIN_BYTES = 4*1024*1024;
+
     private:
 
+        /** A structure whose children are being parsed, used in place of recursion. */
+        struct ParseFrame {
+            /** Structure being parsed. */
+            std::shared_ptr<BaseStructure> structure;
+            /** Offset into structure's raw bytes of next child's header. */
+            size_t offset;
+        };
+
         std::vector<std::shared_ptr<IEvioListener>> evioListenerList;
         std::shared_ptr<IEvioFilter> evioFilter;
 
+        /** Use filter on headers to skip unwanted structures before they're created? */
+        bool pruning = false;
+
+        /** Give parsed structures views of the event's raw bytes instead of copies? */
+        bool viewing = false;
+
+        /** Number of threads parsing an event's top level children. */
+        uint32_t parseThreads = 1;
+
         void parseStructure(std::shared_ptr<EvioEvent> evioEvent, std::shared_ptr<BaseStructure> structure);
+        void parseParallel(std::shared_ptr<EvioEvent> & evioEvent);
+        void notifyTree(std::shared_ptr<EvioEvent> & evioEvent, std::shared_ptr<BaseStructure> & structure);
 
     protected:
 
@@ -70,13 +113,20 @@ namespace evio {
     public:
 
         static void eventParse(std::shared_ptr<EvioEvent> & evioEvent);
+        static void eventParse(std::shared_ptr<EvioEvent> & evioEvent, std::shared_ptr<IEvioFilter> const & filter);
 
         void parseEvent(std::shared_ptr<EvioEvent> & evioEvent);
         void parseEvent(std::shared_ptr<EvioEvent> & evioEvent, bool synced);
+        void parseEvent(const uint8_t *src, size_t len, ByteOrder const & order,
+                        std::shared_ptr<EvioEvent> & evioEvent);
 
     private:
 
         static void parseStruct(std::shared_ptr<BaseStructure> structure);
+        static std::shared_ptr<BaseStructure> takeSpare(std::vector<std::shared_ptr<BaseStructure>> & spares);
+        static void recycle(BaseStructure & structure, EvioEvent & event);
+        static void parsePruned(std::shared_ptr<EvioEvent> & evioEvent, IEvioFilter * filter,
+                                EventParser * notifier, bool view = false);
 
 // Moved to EventHeaderParser to avoid circular references to BaseStructure:
 //        static std::shared_ptr<BankHeader> createBankHeader(uint8_t * bytes, ByteOrder const & byteOrder);
@@ -98,6 +148,12 @@ namespace evio {
         bool isNotificationActive() const;
         void setNotificationActive(bool notificationActive);
         void setEvioFilter(std::shared_ptr<IEvioFilter> evioFilter);
+        bool isPruning() const;
+        void setPruning(bool prune);
+        bool isViewing() const;
+        void setViewing(bool view);
+        uint32_t getParseThreads() const;
+        void setParseThreads(uint32_t threads);
 
     public:
 
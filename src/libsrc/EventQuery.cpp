@@ -0,0 +1,438 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "EventQuery.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "EventHeaderParser.h"
+#include "IEvioCompactReader.h"
+#include "EvioNode.h"
+#include "Reader.h"
+#include "Writer.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /**
+         * Read a value.
+         * @tparam T   type of value.
+         * @param p    pointer to value, need not be aligned.
+         * @param swap true if value must be swapped.
+         * @return value in local byte order.
+         */
+        template<typename T>
+        T readValue(const uint8_t *p, bool swap) {
+            uint8_t bytes[sizeof(T)];
+            std::memcpy(bytes, p, sizeof(T));
+            if (swap) std::reverse(bytes, bytes + sizeof(T));
+            T val;
+            std::memcpy(&val, bytes, sizeof(T));
+            return val;
+        }
+
+
+        /**
+         * Compare two numbers.
+         * @param a  left side.
+         * @param op comparison.
+         * @param b  right side.
+         * @return result of comparison.
+         */
+        bool compare(double a, EventQuery::Comparison op, double b) {
+            switch (op) {
+                case EventQuery::EQ: return a == b;
+                case EventQuery::NE: return a != b;
+                case EventQuery::LT: return a <  b;
+                case EventQuery::LE: return a <= b;
+                case EventQuery::GT: return a >  b;
+                case EventQuery::GE: return a >= b;
+            }
+            return false;
+        }
+
+
+        /**
+         * Does any one of an array of values pass a comparison?
+         * @tparam T    type of values.
+         * @param p     pointer to first value.
+         * @param bytes number of bytes of values.
+         * @param swap  true if values must be swapped.
+         * @param op    comparison.
+         * @param value number each value is compared to.
+         * @return true if any value passes.
+         */
+        template<typename T>
+        bool anyValue(const uint8_t *p, size_t bytes, bool swap, EventQuery::Comparison op, double value) {
+            for (size_t i=0; i + sizeof(T) <= bytes; i += sizeof(T)) {
+                if (compare((double)readValue<T>(p + i, swap), op, value)) return true;
+            }
+            return false;
+        }
+    }
+
+
+    /**
+     * Select only events whose top-level bank has the given tag.
+     * @param tag tag of top-level bank.
+     * @return this object.
+     */
+    EventQuery & EventQuery::whereTag(uint16_t tag) {
+        haveTag = true;
+        haveNum = false;
+        topTag = tag;
+        return *this;
+    }
+
+
+    /**
+     * Select only events whose top-level bank has the given tag and num.
+     * @param tag tag of top-level bank.
+     * @param num num of top-level bank.
+     * @return this object.
+     */
+    EventQuery & EventQuery::whereTagNum(uint16_t tag, uint8_t num) {
+        haveTag = true;
+        haveNum = true;
+        topTag = tag;
+        topNum = num;
+        return *this;
+    }
+
+
+    /**
+     * Select only events whose top-level bank has a number of children in the given range.
+     * @param min min number of children.
+     * @param max max number of children.
+     * @return this object.
+     */
+    EventQuery & EventQuery::whereChildren(uint32_t min, uint32_t max) {
+        minChildren = min;
+        maxChildren = max;
+        return *this;
+    }
+
+
+    /**
+     * Select only events holding a bank of the given tag and num with at least one value
+     * for which <code>value op number</code> is true. Only banks of numeric data are tested.
+     * @param tag   tag of bank.
+     * @param num   num of bank.
+     * @param op    comparison.
+     * @param value number each value is compared to.
+     * @return this object.
+     */
+    EventQuery & EventQuery::whereValue(uint16_t tag, uint8_t num, Comparison op, double value) {
+        valuePredicates.push_back({tag, num, op, value});
+        return *this;
+    }
+
+
+    /**
+     * Select only events holding a bank of the given dictionary name with at least one value
+     * for which <code>value op number</code> is true. Only banks of numeric data are tested.
+     * @param name       dictionary name of bank.
+     * @param dictionary dictionary giving the bank's tag and num.
+     * @param op         comparison.
+     * @param value      number each value is compared to.
+     * @return this object.
+     * @throws EvioException if name is not in dictionary.
+     */
+    EventQuery & EventQuery::whereValue(std::string const & name, EvioXMLDictionary const & dictionary,
+                                        Comparison op, double value) {
+        uint16_t tag; uint8_t num;
+        lookUp(name, dictionary, tag, num);
+        return whereValue(tag, num, op, value);
+    }
+
+
+    /**
+     * Keep banks of the given tag and num, found anywhere below the top-level bank,
+     * in the events written. Once any projection is added, only projected banks are kept.
+     * @param tag tag of bank.
+     * @param num num of bank.
+     * @return this object.
+     */
+    EventQuery & EventQuery::project(uint16_t tag, uint8_t num) {
+        projections.push_back({tag, num});
+        return *this;
+    }
+
+
+    /**
+     * Keep banks of the given dictionary name, found anywhere below the top-level bank,
+     * in the events written.
+     * @param name       dictionary name of bank.
+     * @param dictionary dictionary giving the bank's tag and num.
+     * @return this object.
+     * @throws EvioException if name is not in dictionary.
+     */
+    EventQuery & EventQuery::project(std::string const & name, EvioXMLDictionary const & dictionary) {
+        uint16_t tag; uint8_t num;
+        lookUp(name, dictionary, tag, num);
+        return project(tag, num);
+    }
+
+
+    /**
+     * Get the tag and num of a dictionary name.
+     * @param name       dictionary name.
+     * @param dictionary dictionary.
+     * @param tag        filled with tag.
+     * @param num        filled with num.
+     * @throws EvioException if name is not in dictionary.
+     */
+    void EventQuery::lookUp(std::string const & name, EvioXMLDictionary const & dictionary,
+                            uint16_t & tag, uint8_t & num) {
+        uint16_t tagEnd;
+        if (!dictionary.getTagNum(name, &tag, &num, &tagEnd)) {
+            throw EvioException("no dictionary entry for " + name);
+        }
+    }
+
+
+    /**
+     * Does an event pass all predicates?
+     * @param event event to test.
+     * @return true if event passes all predicates.
+     * @throws EvioException if event is not properly formed.
+     */
+    bool EventQuery::matches(ByteBufferView const & event) {
+        if (event.size() < 8) {
+            throw EvioException("event too small");
+        }
+
+        // The top-level bank's header alone
+        uint32_t word = event.getInt(4);
+        if (haveTag && (word >> 16) != topTag) return false;
+        if (haveNum && (word & 0xff) != topNum) return false;
+
+        bool needIndex = minChildren > 0 || maxChildren < UINT32_MAX ||
+                         !valuePredicates.empty() || !projections.empty();
+        if (!needIndex) return true;
+
+        EventHeaderParser::indexEvent(event.data(), event.size(), event.order(), index);
+
+        if (minChildren > 0 || maxChildren < UINT32_MAX) {
+            index.getChildren(0, found);
+            if (found.size() < minChildren || found.size() > maxChildren) return false;
+        }
+
+        for (auto const & p : valuePredicates) {
+            if (!testValues(p, event)) return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Does any value of any bank of a predicate's tag and num pass its comparison?
+     * The event must have been indexed.
+     * @param p     predicate.
+     * @param event event being tested.
+     * @return true if any value passes.
+     */
+    bool EventQuery::testValues(ValuePredicate const & p, ByteBufferView const & event) {
+        bool swap = !event.order().isLocalEndian();
+        index.search(p.tag, p.num, found);
+
+        for (uint32_t i : found) {
+            if (index.getType(i) != DataType::BANK.getValue()) continue;
+
+            const uint8_t *data = event.data() + index.getDataPosition(i);
+            size_t bytes = 4*(size_t)index.getDataLength(i);
+            if (index.getPad(i) <= bytes) bytes -= index.getPad(i);
+
+            bool pass;
+            switch (index.getDataType(i)) {
+                case 0x1:  pass = anyValue<uint32_t>(data, bytes, swap, p.op, p.value); break;
+                case 0x2:  pass = anyValue<float>   (data, bytes, swap, p.op, p.value); break;
+                case 0x4:  pass = anyValue<int16_t> (data, bytes, swap, p.op, p.value); break;
+                case 0x5:  pass = anyValue<uint16_t>(data, bytes, swap, p.op, p.value); break;
+                case 0x6:  pass = anyValue<int8_t>  (data, bytes, swap, p.op, p.value); break;
+                case 0x7:  pass = anyValue<uint8_t> (data, bytes, swap, p.op, p.value); break;
+                case 0x8:  pass = anyValue<double>  (data, bytes, swap, p.op, p.value); break;
+                case 0x9:  pass = anyValue<int64_t> (data, bytes, swap, p.op, p.value); break;
+                case 0xa:  pass = anyValue<uint64_t>(data, bytes, swap, p.op, p.value); break;
+                case 0xb:  pass = anyValue<int32_t> (data, bytes, swap, p.op, p.value); break;
+                default:   pass = false;
+            }
+            if (pass) return true;
+        }
+        return false;
+    }
+
+
+    /**
+     * Hand each event of a reader that may pass the predicates to a function.
+     * Records whose tag filter rules out the top-level tag predicate are skipped.
+     * @param reader reader of file or buffer.
+     * @param func   called with the index of each event and the event.
+     */
+    void EventQuery::forEach(Reader & reader, std::function<void(uint32_t, ByteBufferView const &)> const & func) {
+        auto & positions = reader.getRecordPositions();
+        uint32_t event = 0;
+
+        for (uint32_t r=0; r < positions.size(); r++) {
+            uint32_t count = positions[r].getCount();
+            bool skip = haveNum ? !reader.recordMayContain(r, topTag, topNum) :
+                        (haveTag && !reader.recordMayContainTag(r, topTag));
+            if (!skip) {
+                for (uint32_t i=0; i < count; i++) {
+                    func(event + i, reader.getEventView(event + i));
+                }
+            }
+            event += count;
+        }
+    }
+
+
+    /**
+     * Hand each event of a compact reader to a function.
+     * @param reader compact reader.
+     * @param func   called with the number (starting at 1) of each event and the event.
+     */
+    void EventQuery::forEach(IEvioCompactReader & reader, std::function<void(uint32_t, ByteBufferView const &)> const & func) {
+        uint32_t count = reader.getEventCount();
+        for (uint32_t n=1; n <= count; n++) {
+            auto node = reader.getEvent(n);
+            auto buf = node->getBuffer();
+            func(n, ByteBufferView(buf->array() + buf->arrayOffset() + node->getPosition(),
+                                   node->getTotalBytes(), buf->order()));
+        }
+    }
+
+
+    /**
+     * Find the events of a reader which pass all predicates.
+     * @param reader reader of file or buffer.
+     * @return indexes (starting at 0) of the selected events.
+     * @throws EvioException if an event is not properly formed or cannot be read.
+     */
+    std::vector<uint32_t> EventQuery::select(Reader & reader) {
+        std::vector<uint32_t> selected;
+        forEach(reader, [this, &selected](uint32_t i, ByteBufferView const & event) {
+            if (matches(event)) selected.push_back(i);
+        });
+        return selected;
+    }
+
+
+    /**
+     * Find the events of a compact reader which pass all predicates.
+     * @param reader compact reader.
+     * @return numbers (starting at 1, as used by the compact reader) of the selected events.
+     * @throws EvioException if an event is not properly formed.
+     */
+    std::vector<uint32_t> EventQuery::select(IEvioCompactReader & reader) {
+        std::vector<uint32_t> selected;
+        forEach(reader, [this, &selected](uint32_t n, ByteBufferView const & event) {
+            if (matches(event)) selected.push_back(n);
+        });
+        return selected;
+    }
+
+
+    /**
+     * Write the events of a reader which pass all predicates, keeping only the
+     * projected banks if there are any.
+     * @param reader reader of file or buffer.
+     * @param writer writer of the selected events, in the byte order of the reader's events.
+     * @return number of events written.
+     * @throws EvioException if an event is not properly formed or cannot be read,
+     *                       or the writer's byte order differs from that of the events.
+     */
+    uint32_t EventQuery::write(Reader & reader, Writer & writer) {
+        uint32_t written = 0;
+        forEach(reader, [this, &writer, &written](uint32_t, ByteBufferView const & event) {
+            if (matches(event)) {
+                writeEvent(event, writer);
+                written++;
+            }
+        });
+        return written;
+    }
+
+
+    /**
+     * Write the events of a compact reader which pass all predicates, keeping only the
+     * projected banks if there are any.
+     * @param reader compact reader.
+     * @param writer writer of the selected events, in the byte order of the reader's events.
+     * @return number of events written.
+     * @throws EvioException if an event is not properly formed,
+     *                       or the writer's byte order differs from that of the events.
+     */
+    uint32_t EventQuery::write(IEvioCompactReader & reader, Writer & writer) {
+        uint32_t written = 0;
+        forEach(reader, [this, &writer, &written](uint32_t, ByteBufferView const & event) {
+            if (matches(event)) {
+                writeEvent(event, writer);
+                written++;
+            }
+        });
+        return written;
+    }
+
+
+    /**
+     * Write a selected event, or only its projected banks in a copy of its top-level
+     * bank's header. A projected bank inside another one being kept is not repeated.
+     * The event must have been indexed if there are projections.
+     * @param event  selected event.
+     * @param writer writer.
+     * @throws EvioException if the writer's byte order differs from that of the event.
+     */
+    void EventQuery::writeEvent(ByteBufferView const & event, Writer & writer) {
+        if (writer.getByteOrder() != event.order()) {
+            throw EvioException("writer byte order must be that of events");
+        }
+
+        if (projections.empty()) {
+            writer.addEvent(const_cast<uint8_t *>(event.data()), event.size());
+            return;
+        }
+
+        projected.resize(8);
+        size_t keptEnd = 0;   // position past the end of the last bank kept
+
+        // The index is in event order, so descendants of a kept bank come before keptEnd
+        for (uint32_t i=1; i < index.size(); i++) {
+            if (index.getType(i) != DataType::BANK.getValue() || index.getPosition(i) < keptEnd) continue;
+
+            for (auto const & p : projections) {
+                if (index.getTag(i) == p.tag && index.getNum(i) == p.num) {
+                    const uint8_t *start = event.data() + index.getPosition(i);
+                    projected.insert(projected.end(), start, start + index.getTotalBytes(i));
+                    keptEnd = index.getPosition(i) + index.getTotalBytes(i);
+                    break;
+                }
+            }
+        }
+
+        // Top-level header: same tag and num, now a bank of banks
+        uint32_t header[2];
+        header[0] = (uint32_t)(projected.size()/4 - 1);
+        header[1] = (event.getInt(4) & 0xffff00ff) | (DataType::BANK.getValue() << 8);
+        if (!event.order().isLocalEndian()) {
+            header[0] = SWAP_32(header[0]);
+            header[1] = SWAP_32(header[1]);
+        }
+        std::memcpy(projected.data(), header, 8);
+
+        writer.addEvent(projected.data(), projected.size());
+    }
+
+}
@@ -0,0 +1,152 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVENTQUERY_H
+#define EVIO_6_0_EVENTQUERY_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+
+#include "ByteOrder.h"
+#include "ByteBufferView.h"
+#include "StructureIndex.h"
+#include "EvioXMLDictionary.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class Reader;
+    class Writer;
+    class IEvioCompactReader;
+
+
+    /**
+     * This class selects events and projects banks out of them, replacing the usual
+     * hand-written skim program. Predicates are tested directly on each event's bytes
+     * using a {@link StructureIndex}, without creating {@link EvioEvent} trees or
+     * {@link EvioNode}s for the structures inside an event. An event is selected
+     * only if it passes every predicate:
+     * <ul>
+     * <li>the tag, or tag and num, of its top-level bank;</li>
+     * <li>the number of its top-level bank's children;</li>
+     * <li>a value held in a bank (anywhere in the event) of a given tag and num, or
+     *     a given dictionary name, compared to a number. Any one value passing is enough.</li>
+     * </ul>
+     *
+     * The result is either the numbers of the selected events, or the selected events
+     * written to a {@link Writer}. If banks are projected, each event written holds only
+     * those banks, in the order found, inside a copy of the top-level bank's header.
+     * When reading with a {@link Reader}, records whose tag filter
+     * (see {@link RecordHeader#mayContain(uint16_t, uint8_t)}) rules out a top-level
+     * tag predicate are skipped without being read.<p>
+     *
+     * <pre><code>
+     *    EventQuery query;
+     *    query.whereTagNum(1, 1).whereValue("BCAL.energy", dict, EventQuery::GT, 2.5).project(5, 0);
+     *    Writer writer("skim.evio", ByteOrder::ENDIAN_LOCAL, 0, 0);
+     *    query.write(reader, writer);
+     *    writer.close();
+     * </code></pre>
+     *
+     * This class is not thread-safe.
+     */
+    class EventQuery {
+
+    public:
+
+        /** How a bank's value is compared to a predicate's number. */
+        enum Comparison {EQ = 0, NE, LT, LE, GT, GE};
+
+    private:
+
+        /** Test of the values of banks with a tag and num. */
+        struct ValuePredicate {
+            uint16_t tag;
+            uint8_t num;
+            Comparison op;
+            double value;
+        };
+
+        /** Bank with a tag and num. */
+        struct BankKey {
+            uint16_t tag;
+            uint8_t num;
+        };
+
+        /** Is there a predicate on the top-level tag? */
+        bool haveTag = false;
+        /** Is there a predicate on the top-level num? */
+        bool haveNum = false;
+        /** Tag of top-level bank to select. */
+        uint16_t topTag = 0;
+        /** Num of top-level bank to select. */
+        uint8_t topNum = 0;
+
+        /** Min number of children of top-level bank. */
+        uint32_t minChildren = 0;
+        /** Max number of children of top-level bank. */
+        uint32_t maxChildren = UINT32_MAX;
+
+        /** Tests of bank values. */
+        std::vector<ValuePredicate> valuePredicates;
+        /** Banks to project, none if whole events are kept. */
+        std::vector<BankKey> projections;
+
+        /** Index of the event being tested, reused for all events. */
+        StructureIndex index;
+        /** Results of searching index, reused for all events. */
+        std::vector<uint32_t> found;
+        /** Projected event, reused for all events. */
+        std::vector<uint8_t> projected;
+
+    public:
+
+        EventQuery() = default;
+
+        EventQuery & whereTag(uint16_t tag);
+        EventQuery & whereTagNum(uint16_t tag, uint8_t num);
+        EventQuery & whereChildren(uint32_t min, uint32_t max = UINT32_MAX);
+        EventQuery & whereValue(uint16_t tag, uint8_t num, Comparison op, double value);
+        EventQuery & whereValue(std::string const & name, EvioXMLDictionary const & dictionary,
+                                Comparison op, double value);
+        EventQuery & project(uint16_t tag, uint8_t num);
+        EventQuery & project(std::string const & name, EvioXMLDictionary const & dictionary);
+
+        bool matches(ByteBufferView const & event);
+
+        std::vector<uint32_t> select(Reader & reader);
+        std::vector<uint32_t> select(IEvioCompactReader & reader);
+
+        uint32_t write(Reader & reader, Writer & writer);
+        uint32_t write(IEvioCompactReader & reader, Writer & writer);
+
+    private:
+
+        static void lookUp(std::string const & name, EvioXMLDictionary const & dictionary,
+                           uint16_t & tag, uint8_t & num);
+
+        bool testValues(ValuePredicate const & p, ByteBufferView const & event);
+
+        void forEach(Reader & reader, std::function<void(uint32_t, ByteBufferView const &)> const & func);
+        void forEach(IEvioCompactReader & reader, std::function<void(uint32_t, ByteBufferView const &)> const & func);
+
+        void writeEvent(ByteBufferView const & event, Writer & writer);
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVENTQUERY_H
@@ -9,6 +9,9 @@
 
 
 #include "EventWriter.h"
+#include "EvioBinaryDictionary.h"
+
+#include <unistd.h>
 
 
 namespace evio {
@@ -134,14 +137,17 @@ namespace evio {
      * @param splitNumber   number at which to start the split numbers
      * @param splitIncrement amount to increment split number each time another file is created.
      * @param streamCount    total number of streams in DAQ.
-     * @param compressionType    type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip).
+     * @param compressionType    type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd).
      * @param compressionThreads number of threads doing compression simultaneously.
-     * @param ringSize           number of records in supply ring. If set to &lt; compressionThreads,
-     *                           it is forced to equal that value and is also forced to be a multiple of
-     *                           2, rounded up.
+     * @param ringSize           number of records in supply ring, 16 if set to 0. If set to &lt;
+     *                           compressionThreads + 2, it is forced to equal that value and is also
+     *                           forced to be a power of 2, rounded up.
      * @param bufferSize    number of bytes to make each internal buffer which will
      *                      be storing events before writing them to a file.
      *                      9MB = default if bufferSize = 0.
+     * @param waitStrategy  how compression and writing threads wait for records.
+     *                      Only used if compressionThreads &gt; 1.
+     * @param waitTimeout   if &gt; 0, max microseconds a blocking wait lasts before waiting again.
      *
      * @throws EvioException if maxRecordSize or maxEventCount exceed limits;
      *                       if streamCount &gt; 1 and streamId &lt; 0;
@@ -160,7 +166,8 @@ namespace evio {
                              std::shared_ptr<EvioBank> firstEvent, uint32_t streamId,
                              uint32_t splitNumber, uint32_t splitIncrement, uint32_t streamCount,
                              Compressor::CompressionType compressionType, uint32_t compressionThreads,
-                             uint32_t ringSize, uint32_t bufferSize) {
+                             uint32_t ringSize, uint32_t bufferSize,
+                             RecordSupply::WaitStrategyType waitStrategy, uint32_t waitTimeout) {
 
         if (baseName.empty()) {
             throw EvioException("baseName arg is empty");
@@ -209,6 +216,10 @@ namespace evio {
             createCommonRecord(xmlDictionary, firstEvent, nullptr, nullptr);
         }
 
+        // Records are not compressed if the type is not compiled in (see RecordHeader)
+        if (!Compressor::isSupported(compressionType)) {
+            compressionType = Compressor::UNCOMPRESSED;
+        }
         this->compressionType = compressionType;
 
         // How much compression will data experience? Percentage of original size.
@@ -222,6 +233,9 @@ namespace evio {
             case Compressor::GZIP:
                 compressionFactor = 42;
                 break;
+            case Compressor::ZSTD:
+                compressionFactor = 40;
+                break;
 
             case Compressor::UNCOMPRESSED:
             default:
@@ -341,11 +355,15 @@ namespace evio {
             currentRecord = std::make_shared<RecordOutput>(buffer, maxEventCount,
                                                            compressionType,
                                                            HeaderType::EVIO_RECORD);
+            currentRecord->setFillStats(&fillStats);
+            fileWriterBuffers = internalBuffers;
         }
         else {
             // Number of ring items must be >= # of compressionThreads, plus 1 which
             // is being written, plus 1 being filled - all simultaneously.
-            ringSize = 16;
+            if (ringSize == 0) {
+                ringSize = 16;
+            }
             if (ringSize < compressionThreads + 2) {
                 ringSize = compressionThreads + 2;
             }
@@ -354,16 +372,33 @@ namespace evio {
             ringSize = Util::powerOfTwo(ringSize, true);
             //cout << "EventWriter constr: record ring size set to " << ringSize << endl;
 
+            // Uncompressed records are built as they're published and go straight to the writing thread
             supply = std::make_shared<RecordSupply>(ringSize, this->byteOrder,
                                                     compressionThreads,
                                                     maxEventCount, maxRecordSize,
-                                                    compressionType);
+                                                    compressionType, false,
+                                                    waitStrategy, waitTimeout,
+                                                    compressionType == Compressor::UNCOMPRESSED);
 
             // Do a quick calculation as to how much data a ring full
             // of records can hold since we may have to write that to
             // disk before we can shut off the spigot when disk is full.
             maxSupplyBytes = supply->getMaxRingBytes();
 
+            // Map the ring's memory now rather than page by page while writing
+            supply->touchRecords();
+            supply->setFillStats(&fillStats);
+
+            // Records are written from these buffers. Get them before other threads use the ring.
+            for (uint32_t i=0; i < ringSize; i++) {
+                fileWriterBuffers.push_back(supply->getRingItem(i)->getRecord()->getBinaryBuffer());
+            }
+
+            // Uncompressed events are written straight from where they were added
+            if (compressionType == Compressor::UNCOMPRESSED) {
+                supply->setGatherOutput(true);
+            }
+
             // Number of available bytes in file's disk partition
             //cout << "EventWriter constr: call fs::space(" << currentFilePath.parent_path().generic_string() << ")" << endl;
 #ifdef __APPLE__
@@ -382,16 +417,24 @@ namespace evio {
                 diskIsFullVolatile = true;
             }
 
-            // Create compression threads
-            recordCompressorThreads.reserve(compressionThreads);
-            for (int i = 0; i < compressionThreads; i++) {
-                recordCompressorThreads.emplace_back(i, compressionType, supply);
+            // Have the shared pool, if any, compress records, else our own threads.
+            // There are none to compress if they go straight to the writing thread.
+            sharedCompression = !supply->isPassThrough() && CompressionExecutor::getInstance().isEnabled();
+            if (sharedCompression) {
+                CompressionExecutor::getInstance().addSupply(supply, compressionType);
             }
-            //cout << "EventWriter constr: created " << compressionThreads << " number of comp thds" << endl;
+            else if (!supply->isPassThrough()) {
+                // Create compression threads
+                recordCompressorThreads.reserve(compressionThreads);
+                for (int i = 0; i < compressionThreads; i++) {
+                    recordCompressorThreads.emplace_back(i, compressionType, supply);
+                }
+                //cout << "EventWriter constr: created " << compressionThreads << " number of comp thds" << endl;
 
-            // Start compression threads
-            for (int i=0; i < compressionThreads; i++) {
-                recordCompressorThreads[i].startThread();
+                // Start compression threads
+                for (int i=0; i < compressionThreads; i++) {
+                    recordCompressorThreads[i].startThread();
+                }
             }
 
             // Create and start writing thread
@@ -468,7 +511,7 @@ namespace evio {
      * @param firstEvent      the first event written into the buffer (after any dictionary).
      *                        May be null. Not useful when writing to a buffer as this
      *                        event may be written using normal means.
-     * @param compressionType type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip)
+     * @param compressionType type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd)
      *
      * @throws EvioException if maxRecordSize or maxEventCount exceed limits;
      */
@@ -486,6 +529,10 @@ namespace evio {
 //std::cout << "EventWriter constr: record # set to " << recordNumber << std::endl;
 
         this->xmlDictionary   = xmlDictionary;
+        // Records are not compressed if the type is not compiled in (see RecordHeader)
+        if (!Compressor::isSupported(compressionType)) {
+            compressionType = Compressor::UNCOMPRESSED;
+        }
         this->compressionType = compressionType;
 
         // How much compression will data experience? Percentage of original size.
@@ -499,6 +546,9 @@ namespace evio {
             case Compressor::GZIP:
                 compressionFactor = 42;
                 break;
+            case Compressor::ZSTD:
+                compressionFactor = 40;
+                break;
 
             case Compressor::UNCOMPRESSED:
             default:
@@ -521,6 +571,7 @@ namespace evio {
         currentRecord = std::make_shared<RecordOutput>(buf, maxEventCount,
                                                        compressionType,
                                                        HeaderType::EVIO_RECORD);
+        currentRecord->setFillStats(&fillStats);
 
         auto & header = currentRecord->getHeader();
         header->setBitInfo(false, haveFirstEvent, !xmlDictionary.empty());
@@ -575,26 +626,95 @@ namespace evio {
 
 
     /**
-     * Static wrapper function used to asynchronously run threads to write to file.
-     * Necesssary because std::async cannot run member functions (i.e. asyncFileChannel->write)
-     * directly.
+     * Create the object which writes records to the current file, which must already exist.
+     * It is given the buffers records are written from and, if compressing with
+     * multiple threads, the supply to release written records back into.
      *
-     * @param pWriter pointer to this object.
-     * @param data    pointer to data.
-     * @param len     number of bytes to write.
+     * @throws EvioException if file cannot be opened.
      */
-    void EventWriter::staticWriteFunction(EventWriter *pWriter, const char* data, size_t len) {
-        pWriter->asyncFileChannel->write(data, len);
+    void EventWriter::createFileWriter() {
+        fileWriter = FileWriteBackend::create(fileWriterType, fileWriterQueueDepth);
+        fileWriter->setDurability(durability, durabilityMillis, durabilityBytes);
+        fileWriter->open(currentFileName, fileWriterDirectIO);
+        if (supply != nullptr) {
+            fileWriter->setSupply(supply);
+        }
+        fileWriter->registerBuffers(fileWriterBuffers);
     }
 
 
     /**
-     * Static wrapper function used to asynchronously run threads to do nothing.
-     * Used when testing this software but not actually writing to file.
+     * Open the current file, which is created unless it was already created ahead of time,
+     * and write its file header. If preallocating split files, disk space is reserved for it
+     * and, if pre-creating them, the creation of the next split file is started.
      *
-     * @param pWriter pointer to this object.
+     * @throws EvioException if file cannot be opened or written to.
+     */
+    void EventWriter::openNewFile() {
+        // New shared pointer for each file ...
+        asyncFileChannel = std::make_shared<std::fstream>();
+        // A file created ahead of time must not be truncated, which gives back its reserved space
+        if (currentFilePreCreated) {
+            asyncFileChannel->open(currentFileName, std::ios::binary | std::ios::in | std::ios::out);
+        }
+        else {
+            asyncFileChannel->open(currentFileName, std::ios::binary | std::ios::trunc | std::ios::out);
+        }
+        if (asyncFileChannel->fail()) {
+            throw EvioException("error opening file " + currentFileName);
+        }
+
+        // Right now file is open for writing
+        fileOpen = true;
+        fileWritingPosition = 0L;
+        splitCount++;
+
+        // Records are written separately, and so is the header if bypassing the page cache
+        createFileWriter();
+
+        if (preallocateSplits && split > 0 && !currentFilePreCreated) {
+            fileWriter->preallocate(split);
+        }
+        currentFilePreCreated = false;
+
+        // Write out the beginning file header including common record
+        writeFileHeader();
+
+        preCreateNextFile();
+    }
+
+
+    /**
+     * If pre-creating split files, start creating the next one in another thread,
+     * reserving disk space for it if preallocating, so that {@link #splitFile()} does not
+     * wait on the file system. It is not created if it exists and overwriting is not allowed.
+     */
+    void EventWriter::preCreateNextFile() {
+        if (!preCreateSplits || split < 1 || nextFileCreated.valid()) return;
+
+        nextFileName = Util::generateFileName(baseFileName, specifierCount,
+                                              runNumber, split, splitNumber,
+                                              streamId, streamCount);
+
+        nextFileCreated = std::async(std::launch::async, FileWriteBackend::createFile,
+                                     nextFileName, preallocateSplits ? split : 0, overWriteOK);
+    }
+
+
+    /**
+     * Length of the current file once its trailer has been written.
+     * @return length of the current file in bytes once closed.
      */
-    void EventWriter::staticDoNothingFunction(EventWriter *pWriter) {}
+    uint64_t EventWriter::closedFileLength() const {
+        uint64_t length = bytesWritten;
+        if (addingTrailer && !noFileWriting) {
+            length += RecordHeader::HEADER_SIZE_BYTES;
+            if (addTrailerIndex) {
+                length += 4*recordLengths->size();
+            }
+        }
+        return length;
+    }
 
 
     /**
@@ -662,6 +782,95 @@ namespace evio {
     }
 
 
+    /**
+     * Write into a pool of buffers instead of a single one. Once the buffer being written
+     * into is full, it's finished as {@link #close()} would, with its record and trailer,
+     * and handed to the callback ready to read. Writing then goes on, without returning
+     * false, in the next of the free buffers given through {@link #addFreeBuffer}.
+     * This way one buffer can be sent over the network while the next is being filled.
+     * Only if no free buffer is left does writing an event return false as usual, while the
+     * full buffer is kept. Adding a free buffer and writing the event again then goes on.
+     * On closing, the last buffer is also handed to the callback if it holds any events,
+     * as a duplicate sharing its data since {@link #getByteBuffer()} still works with it.<p>
+     *
+     * Each buffer holds one record, numbered one more than the record before it.
+     * Does nothing if writing to a file.
+     *
+     * @param callback function handed each full buffer, or empty to stop using a pool.
+     */
+    void EventWriter::setBufferPool(const std::function<void(std::shared_ptr<ByteBuffer> &)> & callback) {
+        if (toFile) return;
+        fullBufferCallback = callback;
+    }
+
+
+    /**
+     * Add an empty buffer to those written into once the current one is full when using
+     * a buffer pool (see {@link #setBufferPool}). It should be as large as the first buffer.
+     * Buffers handed to the pool's callback are typically added back this way once sent.
+     * This may be called from any thread.
+     * @param buf empty buffer.
+     * @throws EvioException if buf is null.
+     */
+    void EventWriter::addFreeBuffer(std::shared_ptr<ByteBuffer> const & buf) {
+        if (buf == nullptr) {
+            throw EvioException("Buffer arg null");
+        }
+        std::lock_guard<std::mutex> lock(freeBuffersMutex);
+        freeBuffers.push_back(buf);
+    }
+
+
+    /**
+     * Get the number of empty buffers waiting to be written into when using a buffer pool.
+     * @return number of empty buffers in the pool.
+     */
+    size_t EventWriter::getFreeBufferCount() {
+        std::lock_guard<std::mutex> lock(freeBuffersMutex);
+        return freeBuffers.size();
+    }
+
+
+    /**
+     * Get the number of full buffers handed to the callback when using a buffer pool.
+     * @return number of full buffers handed to the callback.
+     */
+    uint64_t EventWriter::getBuffersFilled() const {return buffersFilled;}
+
+
+    /**
+     * When using a buffer pool, finish the full buffer being written into, hand it to
+     * the callback, and go on writing into the next free buffer with the next record number.
+     * Counts of events written carry over.
+     * @return false if there is no free buffer, in which case nothing is done.
+     */
+    bool EventWriter::nextPoolBuffer() {
+        std::shared_ptr<ByteBuffer> next;
+        {
+            std::lock_guard<std::mutex> lock(freeBuffersMutex);
+            if (freeBuffers.empty()) return false;
+            next = freeBuffers.front();
+            freeBuffers.pop_front();
+        }
+
+        // Finish the full buffer as close() does
+        flushCurrentRecordToBuffer();
+        writeTrailerToBuffer(addTrailerIndex);
+        recordLengths->clear();
+        auto full = buffer;
+        full->flip();
+
+        uint32_t eventsTotal = eventsWrittenTotal;
+        next->order(byteOrder);
+        reInitializeBuffer(next, nullptr, recordNumber + 1, true);
+        eventsWrittenTotal = eventsTotal;
+
+        buffersFilled++;
+        fullBufferCallback(full);
+        return true;
+    }
+
+
     /**
      * Get the buffer being written into.
      * If writing to a buffer, this was initially supplied by user in constructor.
@@ -862,430 +1071,1502 @@ namespace evio {
 
 
     /**
-     * Set an event which will be written to the file as
-     * well as to all split files. It's called the "first event" as it will be the
-     * first event written to each split file if this method
-     * is called early enough or the first event was defined in the constructor.
-     * In evio version 6, any dictionary and the first event are written to a
-     * common record which is stored in the user-header part of the file header if
-     * writing to a file. When writing to a buffer it's stored in the first record's
-     * user-header. The common record data is never compressed.<p>
-     *
-     * <b>FILE:</b>
-     * Since this method can only be called after the constructor, the common record may
-     * have already been written with its dictionary and possibly another firstEvent.
-     * If that is the case, the event given here will be written immediately somewhere
-     * in the body of the file. Any subsequent splits will have this event as the first
-     * event in the file header. On the other hand, if the common record has not yet been
-     * written to the file, this event becomes the first event in the file header.<p>
-     *
-     * <b>BUFFER:</b>
-     * By its nature this method is not all that useful for writing to a buffer since
-     * the buffer is never split. Writing this event is done by storing the common record
-     * in the main record's user-header. When writing to a buffer, the common record is not
-     * written until main buffer is full and flushCurrentRecordToBuffer() is called. That is not
-     * done until close() or flush() is called. In other words, there is still time to change
-     * the common record up until close is called.<p>
-     *
-     * Do not call this while simultaneously calling
-     * close, flush, writeEvent, or getByteBuffer.
-     *
-     * @param node node representing event to be placed first in each file written
-     *             including all splits.
+     * Set how records are written to file. By default each is written by a separate
+     * thread (FileWriteBackend::ASYNC), one at a time. On Linux, FileWriteBackend::IO_URING
+     * submits them to the kernel through io_uring instead. A queueDepth > 1 allows that many
+     * records to be in flight at once, which helps keep fast devices (e.g. RAID arrays) busy.
+     * This applies when writing with multiple compression threads. With single-threaded
+     * compression there are only 2 internal buffers, so only 1 write is ever in flight.<p>
+     * Setting directIO bypasses the page cache (O_DIRECT) so that writing large runs does not
+     * push everything else out of memory. Records are then copied into aligned staging buffers
+     * which are written in large blocks. If the file system does not support it, the page
+     * cache is used as before.<p>
+     * This method does nothing if writing to a buffer or if events have already been written.
+     * Otherwise, it takes effect with the next file opened.
      *
-     * @throws EvioException if error writing to file
-     *                       if first event is opposite byte order of internal buffer;
-     *                       if bad data format;
-     *                       if close() already called;
-     *                       if file could not be opened for writing;
-     *                       if file exists but user requested no over-writing;
-     *                       if no room when writing to user-given buffer;
+     * @param type        type of backend. If IO_URING is not available, ASYNC is used.
+     * @param queueDepth  max number of record writes in flight at once. Values < 1 are set to 1.
+     * @param directIO    if true, bypass the page cache.
      */
-    void EventWriter::setFirstEvent(std::shared_ptr<EvioNode> & node) {
+    void EventWriter::setFileWriteBackend(FileWriteBackend::Type type, uint32_t queueDepth,
+                                          bool directIO) {
+        if (!toFile || eventsWrittenTotal > 0) return;
+        fileWriterType = type;
+        fileWriterQueueDepth = queueDepth < 1 ? 1 : queueDepth;
+        fileWriterDirectIO = directIO;
+    }
 
-        if (closed) {return;}
 
-        // There's no way to remove an event from a record, so reconstruct it.
-        createCommonRecord(xmlDictionary, nullptr, node, nullptr);
+    /**
+     * Get the type of backend requested for writing records to file.
+     * @return type of backend requested for writing records to file.
+     */
+    FileWriteBackend::Type EventWriter::getFileWriteBackendType() const {return fileWriterType;}
 
-        // When writing to a buffer, the common record is not written until
-        // buffer is full and flushCurrentRecordToBuffer() is called. That
-        // is not done until close() or flush() is called. In other words,
-        // there is still time to change the common record.
 
-        if (toFile && (recordsWritten > 0)) {
-            // If we've already written the file header, it's too late to place
-            // the common record there, so write first event as a regular event.
-            // The new common record will be written to the file header of the
-            // next split.
-            writeEvent(node, false);
-        }
-    }
+    /**
+     * Get the max number of record writes in flight at once.
+     * @return max number of record writes in flight at once.
+     */
+    uint32_t EventWriter::getFileWriteQueueDepth() const {return fileWriterQueueDepth;}
 
 
     /**
-     * Set an event which will be written to the file as
-     * well as to all split files. It's called the "first event" as it will be the
-     * first event written to each split file if this method
-     * is called early enough or the first event was defined in the constructor.
-     * In evio version 6, any dictionary and the first event are written to a
-     * common record which is stored in the user-header part of the file header if
-     * writing to a file. When writing to a buffer it's stored in the first record's
-     * user-header. The common record data is never compressed.<p>
-     *
-     * <b>FILE:</b>
-     * Since this method can only be called after the constructor, the common record may
-     * have already been written with its dictionary and possibly another firstEvent.
-     * If that is the case, the event given here will be written immediately somewhere
-     * in the body of the file. Any subsequent splits will have this event as the first
-     * event in the file header. On the other hand, if the common record has not yet been
-     * written to the file, this event becomes the first event in the file header.<p>
-     *
-     * <b>BUFFER:</b>
-     * By its nature this method is not all that useful for writing to a buffer since
-     * the buffer is never split. Writing this event is done by storing the common record
-     * in the main record's user-header. When writing to a buffer, the common record is not
-     * written until main buffer is full and flushCurrentRecordToBuffer() is called. That is not
-     * done until close() or flush() is called. In other words, there is still time to change
-     * the common record up until close is called.<p>
-     *
-     * Do not call this while simultaneously calling
-     * close, flush, writeEvent, or getByteBuffer.
-     *
-     * @param buf buffer containing event to be placed first in each file written
-     *               including all splits.
+     * Was bypassing the page cache requested when writing files?
+     * @return true if bypassing the page cache was requested.
+     */
+    bool EventWriter::isDirectIO() const {return fileWriterDirectIO;}
+
+
+    /**
+     * Set the policy for forcing written files physically to disk. By default it's left
+     * to the operating system (FileSyncer::NO_SYNC). With FileSyncer::SYNC_ON_CLOSE, each
+     * file is synced when closed, so that once the file closed callback is run, the file
+     * is on disk. With FileSyncer::GROUP_COMMIT, a separate thread also syncs the file
+     * (fdatasync) every intervalMillis milliseconds or intervalBytes bytes, whichever
+     * comes first, so that writing never waits on the disk. Run control may then use
+     * {@link #getDurableOffset()} as a safe checkpoint.<p>
+     * This method does nothing if writing to a buffer or if events have already been written.
      *
-     * @throws EvioException if error writing to file
-     *                       if first event is opposite byte order of internal buffer;
-     *                       if bad data format;
-     *                       if close() already called;
-     *                       if file could not be opened for writing;
-     *                       if file exists but user requested no over-writing;
-     *                       if no room when writing to user-given buffer;
+     * @param policy         policy for forcing data to disk.
+     * @param intervalMillis with GROUP_COMMIT, max milliseconds between syncs, 0 for no limit.
+     * @param intervalBytes  with GROUP_COMMIT, max bytes written between syncs, 0 for no limit.
      */
-    void EventWriter::setFirstEvent(std::shared_ptr<ByteBuffer> & buf) {
+    void EventWriter::setDurability(FileSyncer::Durability policy,
+                                    uint32_t intervalMillis, uint64_t intervalBytes) {
+        if (!toFile || eventsWrittenTotal > 0) return;
+        durability = policy;
+        durabilityMillis = intervalMillis;
+        durabilityBytes = intervalBytes;
+    }
 
-        if (closed) {return;}
 
-        if ((buf->remaining() < 8) && (xmlDictionary.empty())) {
-            commonRecord = nullptr;
-            return;
-        }
+    /**
+     * Get the policy for forcing written files to disk.
+     * @return policy for forcing written files to disk.
+     */
+    FileSyncer::Durability EventWriter::getDurability() const {return durability;}
 
-        createCommonRecord(xmlDictionary, nullptr, nullptr, buf);
 
-        if (toFile && (recordsWritten > 0) && (buf->remaining() > 7)) {
-            writeEvent(buf, false);
-        }
+    /**
+     * Get the position in the file being written up to which all records are known to be
+     * on disk. It starts over at 0 with each split file and is always 0 with
+     * FileSyncer::NO_SYNC. Since the file writer is replaced when splitting,
+     * call this from the thread writing events.
+     * @return position in the current file up to which all records are on disk.
+     */
+    uint64_t EventWriter::getDurableOffset() const {
+        auto writer = fileWriter;
+        return writer != nullptr ? writer->getDurableOffset() : 0;
     }
 
 
     /**
-     * Set an event which will be written to the file as
-     * well as to all split files. It's called the "first event" as it will be the
-     * first event written to each split file if this method
-     * is called early enough or the first event was defined in the constructor.
-     * In evio version 6, any dictionary and the first event are written to a
-     * common record which is stored in the user-header part of the file header if
-     * writing to a file. When writing to a buffer it's stored in the first record's
-     * user-header. The common record data is never compressed.<p>
-     *
-     * <b>FILE:</b>
-     * Since this method can only be called after the constructor, the common record may
-     * have already been written with its dictionary and possibly another firstEvent.
-     * If that is the case, the event given here will be written immediately somewhere
-     * in the body of the file. Any subsequent splits will have this event as the first
-     * event in the file header. On the other hand, if the common record has not yet been
-     * written to the file, this event becomes the first event in the file header.<p>
-     *
-     * <b>BUFFER:</b>
-     * By its nature this method is not all that useful for writing to a buffer since
-     * the buffer is never split. Writing this event is done by storing the common record
-     * in the main record's user-header. When writing to a buffer, the common record is not
-     * written until main buffer is full and flushCurrentRecordToBuffer() is called. That is not
-     * done until close() or flush() is called. In other words, there is still time to change
-     * the common record up until close is called.<p>
-     *
-     * Do not call this while simultaneously calling
-     * close, flush, writeEvent, or getByteBuffer.
-     *
-     * @param bank event to be placed first in each file written including all splits.
+     * Reserve disk space for each split file when it's created, and/or create each split
+     * file ahead of time. Preallocating keeps a file which grows by appending from being
+     * spread over many small extents, cutting fragmentation and metadata overhead on file
+     * systems like XFS and Lustre. Space for the split size is reserved (Linux only) without
+     * changing the file's size, and whatever is unused is given back when the file is closed.
+     * Pre-creating makes the next split file in a separate thread while the current one is
+     * written, so that splitting does not wait on the file system. A pre-created file that
+     * is never used is removed in {@link #close()}.<p>
+     * This method does nothing if writing to a buffer, if not splitting files,
+     * or if events have already been written.
      *
-     * @throws EvioException if error writing to file
-     *                       if first event is opposite byte order of internal buffer;
-     *                       if bad data format;
-     *                       if close() already called;
-     *                       if file could not be opened for writing;
-     *                       if file exists but user requested no over-writing;
-     *                       if no room when writing to user-given buffer;
+     * @param preallocate if true, reserve disk space for each split file.
+     * @param preCreate   if true, create each split file ahead of time.
      */
-    void EventWriter::setFirstEvent(std::shared_ptr<EvioBank> bank) {
+    void EventWriter::setSplitPreallocation(bool preallocate, bool preCreate) {
+        if (!toFile || split < 1 || eventsWrittenTotal > 0) return;
+        preallocateSplits = preallocate;
+        preCreateSplits = preCreate;
+    }
 
-        if (closed) {return;}
 
-        createCommonRecord(xmlDictionary, bank, nullptr, nullptr);
+    /**
+     * Is disk space reserved for each split file when it's created?
+     * @return true if disk space is reserved for each split file when it's created.
+     */
+    bool EventWriter::isPreallocatingSplits() const {return preallocateSplits;}
+
 
-        if (toFile && (recordsWritten > 0)) {
-            writeEvent(bank, nullptr, false);
+    /**
+     * Is each split file created ahead of time?
+     * @return true if each split file is created ahead of time.
+     */
+    bool EventWriter::isPreCreatingSplits() const {return preCreateSplits;}
+
+
+    /**
+     * Limit how long events may wait in a partially filled record before being written
+     * to the file. With a low event rate, a record may take a long time to fill, and any
+     * reader following the file sees nothing of its events until it's written. When a
+     * limit is set, a thread checks the age of the current record and, once its first
+     * event is older than the limit, sends it to be compressed and written just as
+     * {@link #flush()} does, but without forcing it to disk. The application does not
+     * have to call flush() itself.<p>
+     *
+     * While a limit is set, writing events, flushing, closing and setting the first event
+     * are synchronized with this thread, so each costs an additional uncontested lock.
+     * This method does nothing if writing to a buffer or if close() already called.
+     *
+     * @param millisec max time events may wait in a record in milliseconds, 0 for no limit.
+     */
+    void EventWriter::setMaxRecordAge(uint32_t millisec) {
+        if (!toFile || closed) return;
+
+        stopRecordAgeTimer();
+        maxRecordAge = millisec;
+        if (millisec > 0) {
+            recordStartTime = std::chrono::steady_clock::now();
+            recordAgeThread = boost::thread([this, millisec]() {this->runRecordAgeTimer(millisec);});
         }
     }
 
 
     /**
-     * Create and fill the common record which contains the dictionary and first event.
-     * Use the firstBank as the first event if specified, else try using the
-     * firstNode if specified, else try the firstBuf.
+     * Get the max time events may wait in a partially filled record before being written.
+     * @return max time events may wait in a record in milliseconds, 0 if no limit.
+     */
+    uint32_t EventWriter::getMaxRecordAge() const {return maxRecordAge;}
+
+
+    /**
+     * Turn auto-tuning on or off. While on, a thread adjusts the number of active compression
+     * threads, and optionally the size of records, to the incoming data rate
+     * (see {@link WriterAutoTuner}). Data rates may change by an order of magnitude between
+     * beam on and off, and threads not needed are parked instead of using cores.
+     * A latency goal works along with {@link #setMaxRecordAge(uint32_t)}: the first makes
+     * records small enough to fill in time, the second sends off those that do not.
+     * When turned off, all compression threads are made active and records fill their memory.<p>
      *
-     * @param xmlDict        xml dictionary
-     * @param firstBank      first event as EvioBank
-     * @param firstNode      first event as EvioNode
-     * @param firstBuf       first event as ByteBuffer
-     * @throws EvioException if dictionary is in improper format
+     * This method does nothing if compressing in the calling thread
+     * (only 1 compression thread or writing to a buffer) or if close() already called.
+     *
+     * @param tune   if true, auto-tune, else stop.
+     * @param config goals of tuning.
      */
-    void EventWriter::createCommonRecord(const std::string & xmlDict,
-                                         std::shared_ptr<EvioBank> const & firstBank,
-                                         std::shared_ptr<EvioNode> const & firstNode,
-                                         std::shared_ptr<ByteBuffer> const & firstBuf) {
+    void EventWriter::setAutoTune(bool tune, const AutoTuneConfig & config) {
+        if (supply == nullptr || closed) return;
 
-        // Create record if necessary, else clear it
-        if (commonRecord == nullptr) {
-            // No compression please ...
-            commonRecord = std::make_shared<RecordOutput>(byteOrder, 0, 0,
-                                                          Compressor::CompressionType::UNCOMPRESSED);
+        if (autoTuner != nullptr) {
+            autoTuner->stopThread();
+            autoTuner.reset();
         }
-        else {
-            commonRecord->reset();
+
+        if (tune) {
+            autoTuner = std::make_unique<WriterAutoTuner>(supply, fillStats, config);
+            autoTuner->startThread();
         }
+    }
 
-        // Place dictionary & first event into a single record
-        if (!xmlDict.empty()) {
-//std::cout << "createCommonRecord: got dictionary, # chars = " << xmlDict.size() << std::endl;
-            // 56 is the minimum number of characters for a valid xml dictionary
-            if (xmlDict.length() < 56) {
-                throw EvioException("Dictionary improper format, too few characters");
-            }
 
-            // Turn dictionary data into ascii (not evio bank)
-            Util::stringToASCII(xmlDict, dictionaryByteArray);
+    /**
+     * Is auto-tuning on?
+     * @return true if auto-tuning is on.
+     */
+    bool EventWriter::getAutoTune() const {return autoTuner != nullptr;}
 
-            // Add to record which will be our file header's "user header"
-            commonRecord->addEvent(dictionaryByteArray);
-//std::cout << "createCommonRecord: turned dictionary into ascii & added to commonRecord, byte size = " <<
-//             dictionaryByteArray.size() << std::endl;
-        }
-        else {
-            dictionaryByteArray.clear();
+
+    /**
+     * Lock the current record against being written by the record age thread,
+     * but only if there is such a thread. Mark the time if the record is empty
+     * since the events about to be added are the first.
+     * @return lock which is released when it goes out of scope.
+     */
+    std::unique_lock<std::mutex> EventWriter::lockCurrentRecord() {
+        std::unique_lock<std::mutex> lock(recordMutex, std::defer_lock);
+        if (maxRecordAge > 0) {
+            lock.lock();
+            if (currentRecord != nullptr && currentRecord->getEventCount() == 0) {
+                recordStartTime = std::chrono::steady_clock::now();
+            }
         }
+        return lock;
+    }
 
-        // Convert first event into bytes
-        haveFirstEvent = true;
-        if (firstBank != nullptr) {
-            firstEventByteArray.resize(firstBank->getTotalBytes());
-            firstBank->write(firstEventByteArray.data(), byteOrder);
 
-            // Add to record which will be our file header's "user header"
-            commonRecord->addEvent(firstEventByteArray);
-        }
-        else if (firstNode != nullptr) {
-            ByteBuffer firstEventBuf(firstNode->getTotalBytes());
-            firstNode->getStructureBuffer(firstEventBuf, true);
-            commonRecord->addEvent(firstEventBuf);
+    /**
+     * Run by recordAgeThread. Write the current record once its first event
+     * is older than the given age.
+     * @param millisec max age of record in milliseconds.
+     */
+    void EventWriter::runRecordAgeTimer(uint32_t millisec) {
+        auto maxAge = std::chrono::milliseconds(millisec);
+        // Look often enough that records are not written much later than their max age
+        auto period = boost::chrono::milliseconds(std::max(1U, millisec/4));
+
+        try {
+            while (true) {
+                boost::this_thread::sleep_for(period);
+
+                std::lock_guard<std::mutex> lock(recordMutex);
+                if (closed) return;
+                if (currentRecord->getEventCount() > 0 &&
+                    std::chrono::steady_clock::now() - recordStartTime >= maxAge) {
+                    flushToFile(false);
+                }
+            }
         }
-        else if (firstBuf != nullptr) {
-            commonRecord->addEvent(firstBuf);
+        catch (boost::thread_interrupted & e) {}
+        catch (std::exception & e) {
+            std::cout << "EventWriter: record age thread, " << e.what() << std::endl;
         }
-        else {
-            haveFirstEvent = false;
+    }
+
+
+    /** Stop the record age thread, if any, and wait for it to end. */
+    void EventWriter::stopRecordAgeTimer() {
+        if (recordAgeThread.joinable()) {
+            recordAgeThread.interrupt();
+            recordAgeThread.join();
         }
+    }
 
-        commonRecord->build();
-        commonRecordBytesToBuffer = 4*commonRecord->getHeader()->getLengthWords();
-//std::cout << "createCommonRecord: padded commonRecord size is " << commonRecordBytesToBuffer << " bytes" << std::endl;
+
+    /**
+     * Have a thread look at the free space of the file's disk partition every so often,
+     * instead of asking the OS each time the disk is checked before writing. Asking
+     * (statvfs) can take milliseconds on a network filesystem. Between looks, the free
+     * space is estimated by subtracting the bytes written since the last one, and whether
+     * the disk is full is always known without a system call. The period should be short
+     * enough that other programs filling the same partition are noticed in time.<p>
+     *
+     * This method does nothing if writing to a buffer or if close() already called.
+     *
+     * @param millisec time between looks at the disk in milliseconds, 0 for no monitor.
+     * @see #setDiskSpaceThresholds(uint64_t, double)
+     */
+    void EventWriter::setDiskSpaceMonitor(uint32_t millisec) {
+        if (!toFile || closed) return;
+
+        stopDiskMonitor();
+        diskCheckPeriod = millisec;
+        if (millisec > 0) {
+#ifndef __APPLE__
+            diskMonitorDir = currentFilePath.parent_path();
+#endif
+            // Start out with a current look at the disk
+            lookAtDisk();
+            diskMonitorThread = boost::thread([this, millisec]() {this->runDiskMonitor(millisec);});
+        }
     }
 
 
     /**
-     * Create and write a general file header into the file.
-     * The general header's user header is the common record which
-     * contains any existing dictionary and first event.<p>
+     * Get the time between looks at the free space of the file's disk partition.
+     * @return time between looks at the disk in milliseconds, 0 if no monitor.
+     */
+    uint32_t EventWriter::getDiskSpaceMonitorPeriod() const {return diskCheckPeriod;}
+
+
+    /**
+     * Set when the file's disk partition is considered full. It is full if it cannot hold
+     * 1 full split, 1 full supply of records, and the reserve. It is also full if the
+     * fraction of the partition in use is above a high-water mark, if one is given.
+     * Those defaults are a 10MB reserve and no high-water mark.
      *
-     * Call this method AFTER file split or, in constructor, after the file
-     * name is created in order to ensure a consistent value for file split number.
+     * @param reserveBytes  bytes to keep free on top of 1 split and 1 supply of records.
+     * @param highWaterMark full if more than this fraction of the partition (0 to 1) is used.
+     *                      0 for no limit.
      */
-    void EventWriter::writeFileHeader() {
-        // For the file header, our "user header" will be the common record,
-        // which is a record containing the dictionary and first event.
+    void EventWriter::setDiskSpaceThresholds(uint64_t reserveBytes, double highWaterMark) {
+        diskReserveBytes = reserveBytes;
+        diskHighWaterMark = (highWaterMark > 0. && highWaterMark < 1.) ? highWaterMark : 0.;
+    }
 
-        fileHeader.reset();
-        // File split # in header. Go back to last one as currently is set for the next split.
-        fileHeader.setFileNumber(splitNumber - splitIncrement);
 
-        // Check to see if we have dictionary and/or first event
-        int commonRecordBytes = 0;
-        int commonRecordCount = 0;
+    /**
+     * Get the bytes which must be free on the file's disk partition
+     * in addition to 1 full split and 1 full supply of records.
+     * @return bytes which must be free on the disk in addition to 1 split and 1 supply.
+     */
+    uint64_t EventWriter::getDiskReserveBytes() const {return diskReserveBytes;}
 
-        if (commonRecord != nullptr) {
-            commonRecordCount = commonRecord->getEventCount();
-            if (commonRecordCount > 0) {
-                commonRecordBytes = commonRecord->getHeader()->getLength();
-                bool haveDict = !dictionaryByteArray.empty();
-                fileHeader.setBitInfo(haveFirstEvent, haveDict, false);
-            }
-            // Sets file header length too
-            fileHeader.setUserHeaderLength(commonRecordBytes);
+
+    /**
+     * Get the fraction of the file's disk partition which, when used, makes it full.
+     * @return fraction of disk which may be used, 0 if no limit.
+     */
+    double EventWriter::getDiskHighWaterMark() const {return diskHighWaterMark;}
+
+
+    /**
+     * Is there too little space on the disk for the next, complete file?
+     * @param freeBytes free bytes in the file's disk partition.
+     * @param capacity  total bytes in the file's disk partition.
+     * @return true if too little space, else false.
+     */
+    bool EventWriter::tooLittleSpace(uint64_t freeBytes, uint64_t capacity) const {
+        if (freeBytes < split + maxSupplyBytes + diskReserveBytes) {
+            return true;
         }
+        return (diskHighWaterMark > 0. && capacity > 0 &&
+                (double)(capacity - freeBytes) > diskHighWaterMark * (double)capacity);
+    }
 
-        // Index array is unused
 
-        // Total header size in bytes
-        int bytes = fileHeader.getLength();
-        ByteBuffer buf(bytes);
-        uint8_t* array = buf.array();
-        buf.order(byteOrder);
+    /**
+     * Ask the OS how much space is free on the file's disk partition and
+     * publish whether the disk is full. The count of bytes written since
+     * the last look is restarted.
+     */
+    void EventWriter::lookAtDisk() {
+        // Start counting before asking so anything written meanwhile
+        // is subtracted from the free space, even if counted in it too
+        bytesSinceDiskCheck = 0;
+#ifdef __APPLE__
+        uint64_t freeBytes = 20000000000L, capacity = 0;
+#else
+        fs::space_info dirInfo = fs::space(diskMonitorDir);
+        uint64_t freeBytes = dirInfo.available, capacity = dirInfo.capacity;
+#endif
+        diskFreeBytes = freeBytes;
+        diskCapacityBytes = capacity;
+        diskIsFullVolatile = tooLittleSpace(freeBytes, capacity);
+    }
+
+
+    /**
+     * Run by diskMonitorThread. Look at the free space on the file's disk partition
+     * once every period.
+     * @param millisec time between looks in milliseconds.
+     */
+    void EventWriter::runDiskMonitor(uint32_t millisec) {
+        auto period = boost::chrono::milliseconds(millisec);
 
-        // Write file header into array
         try {
-            fileHeader.writeHeader(buf, 0);
+            while (true) {
+                boost::this_thread::sleep_for(period);
+                if (closed) return;
+                lookAtDisk();
+            }
         }
-        catch (EvioException & e) {/* never happen */}
+        catch (boost::thread_interrupted & e) {}
+        catch (std::exception & e) {
+            std::cout << "EventWriter: disk monitor thread, " << e.what() << std::endl;
+        }
+    }
 
-        // Write user header into array if necessary
-        if (commonRecordBytes > 0) {
-            auto commonBuf = commonRecord->getBinaryBuffer();
-            uint8_t* commonArray = commonBuf->array();
-            if (commonArray != nullptr) {
-                std::memcpy((void *)(array + FileHeader::HEADER_SIZE_BYTES),
-                            (const void *)(commonArray + commonBuf->arrayOffset()), commonRecordBytes);
-            }
-            else {
-                commonBuf->getBytes(array + FileHeader::HEADER_SIZE_BYTES, commonRecordBytes);
-            }
+
+    /** Stop the disk monitor thread, if any, and wait for it to end. */
+    void EventWriter::stopDiskMonitor() {
+        if (diskMonitorThread.joinable()) {
+            diskMonitorThread.interrupt();
+            diskMonitorThread.join();
         }
+    }
 
-        // Write array into file
-        asyncFileChannel->write(reinterpret_cast<char *>(array), bytes);
 
-        eventsWrittenTotal = eventsWrittenToFile = commonRecordCount;
-        bytesWritten = bytes;
-        fileWritingPosition += bytes;
+    /** Destructor which stops the record age and disk monitor threads, if any. */
+    EventWriter::~EventWriter() {
+        stopRecordAgeTimer();
+        stopDiskMonitor();
+        // Don't leave the supply of an unclosed writer with the shared pool
+        if (sharedCompression) {
+            CompressionExecutor::getInstance().removeSupply(supply);
+        }
     }
 
 
     /**
-     * This method flushes any remaining internally buffered data to file.
-     * Calling {@link #close()} automatically does this so it isn't necessary
-     * to call before closing. This method should only be used when writing
-     * events at such a low rate that it takes an inordinate amount of time
-     * for internally buffered data to be written to the file.<p>
+     * Make compression adaptive. A record whose compressed data would be larger than
+     * maxRatio times its uncompressed data is stored uncompressed, which saves both
+     * space and, for the slower compression types, the time spent compressing data that
+     * do not compress (e.g. already compressed payloads). Each record carries its own
+     * compression type so mixing compressed and uncompressed records is legal.<p>
+     * When writing with multiple compression threads, records may also be compressed with
+     * the fastest lz4 whenever they back up in the internal ring. This starts once the
+     * percentage of filled but unwritten records in the ring reaches fillLevel, and stops
+     * once it drops to half of that.<p>
+     * This method does nothing if no compression is being done or if events have
+     * already been written.
      *
-     * Calling this may easily kill performance. May not call this when simultaneously
-     * calling writeEvent, close, setFirstEvent, or getByteBuffer.
+     * @param maxRatio  largest allowed ratio of compressed to uncompressed size (e.g. 0.9).
+     *                  Value &lt;= 0 turns this off, values &gt; 1 are set to 1.
+     * @param fillLevel ring fill level in percent at which to compress with the fastest lz4,
+     *                  0 for never. Ignored for single-threaded compression.
      */
-    void EventWriter::flush() {
+    void EventWriter::setAdaptiveCompression(float maxRatio, uint32_t fillLevel) {
+        if (compressionType == Compressor::UNCOMPRESSED || eventsWrittenTotal > 0) return;
 
-        if (closed) {
-            return;
+        maxCompressionRatio = maxRatio <= 0.F ? 0.F : (maxRatio > 1.F ? 1.F : maxRatio);
+
+        if (singleThreadedCompression) {
+            currentRecord->setMaxCompressionRatio(maxCompressionRatio);
+        }
+        else {
+            supply->setAdaptiveCompression(maxCompressionRatio, fillLevel);
         }
+    }
 
-        if (toFile) {
-            if (singleThreadedCompression) {
-                try {
-                    compressAndWriteToFile(true);
-                }
-                catch (EvioException & e) {
-                    std::cout << e.what() << std::endl;
-                }
-            }
-            else {
-                // Write any existing data.
-                currentRingItem->forceToDisk(true);
-                if (currentRecord->getEventCount() > 0) {
-                    // Send current record back to ring
-                    supply->publish(currentRingItem);
-                }
 
-                // Get another empty record from ring
-                std::cout << "EventWriter: flush, get ring item, seq = " << currentRingItem->getSequence() << std::endl;
-                currentRingItem = supply->get();
-                currentRecord = currentRingItem->getRecord();
-            }
+    /**
+     * Get the largest allowed ratio of compressed to uncompressed record size
+     * for adaptive compression.
+     * @return largest allowed ratio of compressed to uncompressed record size, 0 if off.
+     */
+    float EventWriter::getMaxCompressionRatio() const {return maxCompressionRatio;}
+
+
+    /**
+     * Store a Bloom filter of the tags and nums of the top-level banks of each record's
+     * events in user register 2 of its header, letting {@link Reader} skip records
+     * without any wanted events without decompressing them.
+     * Only done if no events have been written yet.
+     * @param filter true if a tag filter is to be stored in each record's header.
+     */
+    void EventWriter::setTagFilter(bool filter) {
+        if (eventsWrittenTotal > 0) return;
+
+        tagFilter = filter;
+        if (supply != nullptr) {
+            supply->setTagFilter(tagFilter);
         }
         else {
-            flushCurrentRecordToBuffer();
+            currentRecord->setTagFilter(tagFilter);
         }
     }
 
 
     /**
-     * This method flushes any remaining data to file and disables this object.
-     * May not call this when simultaneously calling
-     * writeEvent, flush, setFirstEvent, or getByteBuffer.
+     * Is a filter of the tags and nums of its events stored in each record's header?
+     * @return true if a tag filter is stored in each record's header.
      */
-    void EventWriter::close() {
-        if (closed) {
-            return;
-        }
-        // If buffer ...
-        if (!toFile) {
-            flushCurrentRecordToBuffer();
-            // Write empty last header
-            try {
-                writeTrailerToBuffer(addTrailerIndex);
-            }
-            catch (std::exception & e) {
-                // We're here if buffer is too small
-                std::cout << e.what() << std::endl;
-            }
+    bool EventWriter::getTagFilter() const {return tagFilter;}
+
+
+    /**
+     * Store a CRC32C of each record's data in its header so that corruption
+     * can be detected when read (see {@link Reader#setVerifyChecksums(bool)}).
+     * Only done if no events have been written yet.
+     * @param sum true if a checksum is to be stored in each record's header.
+     */
+    void EventWriter::setChecksum(bool sum) {
+        if (eventsWrittenTotal > 0) return;
+
+        checksum = sum;
+        if (supply != nullptr) {
+            supply->setChecksum(checksum);
         }
-        // If file ...
         else {
-            // Write record to file
-            if (singleThreadedCompression) {
-                try {compressAndWriteToFile(false);}
-                catch (std::exception & e) {
-                    std::cout << e.what() << std::endl;
-                }
-            }
-            else {
-                // If we're building a record, send it off
-                // to compressing thread since we're done.
-                // This should never happen as END event forces things through.
-                if (currentRecord->getEventCount() > 0) {
-                    // Put it back in supply for compressing and force to disk
-                    supply->publish(currentRingItem);
-                }
+            currentRecord->setChecksum(checksum);
+        }
+    }
 
-                // Since the writer thread is the last to process each record,
-                // wait until it's done with the last item, then exit the thread.
-                std::cout << "Close: waiting 4 writing thd" << std::endl;
-                recordWriterThread[0].waitForLastItem();
-                std::cout << "Close: done waiting 4 writing thd" << std::endl;
 
-                // Stop all compressing threads which by now are stuck on get
-                for (RecordCompressor &thd : recordCompressorThreads) {
-                    thd.stopThread();
-                }
-            }
+    /**
+     * Is a CRC32C of its data stored in each record's header?
+     * @return true if a checksum is stored in each record's header.
+     */
+    bool EventWriter::getChecksum() const {return checksum;}
 
-            // Finish writing record to current file
-            try {
-                if (future1 != nullptr && future1->valid()) {
-                    // Wait for last write to end before we continue
-                    future1->get();
-                }
-            }
-            catch (std::exception & e) {}
 
-            // Write trailer
-            if (addingTrailer) {
-                // Write the trailer
-                try {
-                    writeTrailerToFile(addTrailerIndex);
-                }
-                catch (std::exception & e) {
-                    std::cout << e.what() << std::endl;
+    /**
+     * Store the min and max timestamps of each record's events in its header
+     * (see {@link RecordOutput#setTimestampExtractor(RecordOutput::TimestampExtractor)}),
+     * letting {@link Reader#getRecordsInTimeRange} find the records of a time window
+     * without reading any others. With multiple compression threads,
+     * the callback is called by each, so it must be thread safe.
+     * Only done if no events have been written yet.
+     * @param extractor callback finding the timestamp of an event, empty to store none.
+     */
+    void EventWriter::setTimestampExtractor(RecordOutput::TimestampExtractor extractor) {
+        if (eventsWrittenTotal > 0) return;
+
+        timestampExtractor = std::move(extractor);
+        if (supply != nullptr) {
+            supply->setTimestampExtractor(timestampExtractor);
+        }
+        else {
+            currentRecord->setTimestampExtractor(timestampExtractor);
+        }
+    }
+
+
+    /**
+     * Store the min and max timestamps of each record's events in its header, taking as
+     * an event's timestamp the first 64-bit word of the first bank with the given tag,
+     * the event itself or one of its children (see {@link RecordOutput#bankTimestamp(uint16_t)}).
+     * Only done if no events have been written yet.
+     * @param tag tag of bank whose first 64-bit word is the timestamp.
+     */
+    void EventWriter::setTimestampTag(uint16_t tag) {
+        setTimestampExtractor(RecordOutput::bankTimestamp(tag));
+    }
+
+
+    /**
+     * Run a user stage on the events of each record before it is compressed
+     * (see {@link RecordOutput#setRecordProcessor(RecordOutput::RecordProcessor)}).
+     * It may drop, rewrite or add events, such as filtering events, stripping banks or
+     * adding a summary bank. With multiple compression threads it runs on them, in parallel,
+     * instead of in the thread writing events, so it must be thread safe.
+     * Counts of events written are of those given to this writer, while each record's header
+     * and the file's index count those actually written.
+     * Only done if no events have been written yet.
+     * @param processor callback run on each record's events, empty for none.
+     */
+    void EventWriter::setRecordProcessor(RecordOutput::RecordProcessor processor) {
+        if (eventsWrittenTotal > 0) return;
+
+        recordProcessor = std::move(processor);
+        if (supply != nullptr) {
+            supply->setRecordProcessor(recordProcessor);
+        }
+        else {
+            currentRecord->setRecordProcessor(recordProcessor);
+        }
+    }
+
+
+    /**
+     * Compress lz4 records as independent blocks so that
+     * {@link Reader#getEvent(uint32_t, uint32_t *)} decompresses only the blocks holding an event,
+     * not the whole record (see {@link SeekableCompression}).
+     * Such files cannot be read by versions of evio which do not know of seekable records.
+     * Only done if no events have been written yet.
+     * @param blockSize uncompressed bytes in each block, 0 for ordinary records.
+     */
+    void EventWriter::setSeekableCompression(uint32_t blockSize) {
+        if (eventsWrittenTotal > 0) return;
+
+        seekableBlockSize = blockSize;
+        if (supply != nullptr) {
+            supply->setSeekableCompression(seekableBlockSize);
+        }
+        else {
+            currentRecord->setSeekableCompression(seekableBlockSize);
+        }
+    }
+
+
+    /**
+     * Get the uncompressed bytes in each block of seekable lz4 records.
+     * @return uncompressed bytes in each block, 0 if records are not seekable.
+     */
+    uint32_t EventWriter::getSeekableCompression() const {return seekableBlockSize;}
+
+
+    /**
+     * Rearrange the data of compressed records, before compressing it, so it compresses better.
+     * Arrays of 16 or 32 bit ADC values compress much better once their bytes are grouped
+     * by significance (see {@link RecordOutput#setPreFilter(Compressor::PreFilter)}).
+     * Such files cannot be read by versions of evio which do not know of filtered records.
+     * Only done if no events have been written yet.
+     * @param filter filter to apply, NO_FILTER for none.
+     */
+    void EventWriter::setPreFilter(Compressor::PreFilter filter) {
+        if (eventsWrittenTotal > 0) return;
+
+        preFilter = filter;
+        if (supply != nullptr) {
+            supply->setPreFilter(preFilter);
+        }
+        else {
+            currentRecord->setPreFilter(preFilter);
+        }
+    }
+
+
+    /**
+     * Get the filter applied to the data of compressed records before compressing it.
+     * @return filter applied to data.
+     */
+    Compressor::PreFilter EventWriter::getPreFilter() const {return preFilter;}
+
+
+    /**
+     * Group the payloads of banks one level down in the events of compressed records by
+     * tag and num into separately compressed columns, so they compress better and readers
+     * can decompress only the banks they want (see {@link RecordOutput#setColumnLayout(bool)}).
+     * Such files cannot be read by versions of evio which do not know of column records.
+     * Only done if no events have been written yet.
+     * @param byColumn true to group banks by column.
+     */
+    void EventWriter::setColumnLayout(bool byColumn) {
+        if (eventsWrittenTotal > 0) return;
+
+        columnLayout = byColumn;
+        if (supply != nullptr) {
+            supply->setColumnLayout(columnLayout);
+        }
+        else {
+            currentRecord->setColumnLayout(columnLayout);
+        }
+    }
+
+
+    /**
+     * Are the banks of compressed records grouped by column?
+     * @return true if banks of compressed records are grouped by column.
+     */
+    bool EventWriter::getColumnLayout() const {return columnLayout;}
+
+
+    /**
+     * Compress records with LZ4 or zstd starting from a dictionary trained on typical
+     * data (for example with <code>zstd --train</code>), which greatly improves the
+     * compression of small records. The dictionary is stored once in the common record,
+     * in the file header's user header of each file including splits, and each record
+     * compressed with it is marked in its header. {@link Reader} loads it before
+     * decompressing. Gzip compressed records don't use it.<p>
+     *
+     * Since the common record is never compressed but the first record holding it is
+     * when writing to a buffer, this is only done when writing to a file.
+     * It must be called once, before any events are written.
+     *
+     * @param dictionary trained dictionary.
+     * @throws EvioException if writing to a buffer, events have already been written,
+     *                       a dictionary was already set, or dictionary is empty.
+     */
+    void EventWriter::setCompressionDictionary(std::vector<uint8_t> const & dictionary) {
+        if (!toFile) {
+            throw EvioException("compression dictionary only used when writing a file");
+        }
+        if (closed || fileOpen || eventsWrittenTotal > 0) {
+            throw EvioException("compression dictionary must be set before writing");
+        }
+        if (compressionDictionary != nullptr) {
+            throw EvioException("compression dictionary already set");
+        }
+
+        auto dict = std::make_shared<CompressionDictionary>(dictionary);
+
+        {
+            // The common record goes into the header of any file opened by a record write
+            auto lock = lockCurrentRecord();
+
+            compressionDictionary = dict;
+            compressionDictionaryByteArray = dict->toEvent(byteOrder);
+
+            if (commonRecord == nullptr) {
+                createCommonRecord(xmlDictionary, nullptr, nullptr, nullptr);
+            }
+            else {
+                // It goes after everything else
+                if (!commonRecord->addEvent(compressionDictionaryByteArray)) {
+                    throw EvioException("compression dictionary too large");
+                }
+                commonRecord->build();
+                commonRecordBytesToBuffer = 4*commonRecord->getHeader()->getLengthWords();
+            }
+        }
+
+        if (supply != nullptr) {
+            supply->setCompressionDictionary(compressionDictionary);
+        }
+        else {
+            currentRecord->setCompressionDictionary(compressionDictionary);
+        }
+    }
+
+
+    /**
+     * Get the trained dictionary records are compressed with.
+     * @return trained compression dictionary, or null if none.
+     */
+    std::shared_ptr<CompressionDictionary> EventWriter::getCompressionDictionary() const {
+        return compressionDictionary;
+    }
+
+
+    /**
+     * Pin compression and writing threads to sets of CPUs (Linux only).
+     * Only used when writing a file with multiple compression threads.
+     * Optionally, spread the memory of the records in the internal ring evenly over the
+     * NUMA nodes of the compression threads. Since records go to whichever compression
+     * thread is free, a record is not always compressed on the node holding it.
+     * This only works if the number of compression threads divides the ring size
+     * (e.g. both are powers of 2) and is only done if no events have been written yet.
+     *
+     * @param compressorCpus   CPU sets for compression threads. Thread n uses set
+     *                         n modulo (number of sets). Empty for no pinning.
+     * @param writerCpus       CPU set for writing thread. Empty for no pinning.
+     * @param numaLocalRecords if true, spread records' memory over the compression threads' nodes.
+     */
+    void EventWriter::setThreadAffinity(const std::vector<std::vector<uint32_t>> & compressorCpus,
+                                        const std::vector<uint32_t> & writerCpus,
+                                        bool numaLocalRecords) {
+        if (supply == nullptr || closed) return;
+
+        // Records in use must not be touched
+        bool placeRecords = numaLocalRecords && eventsWrittenTotal == 0;
+
+        if (!compressorCpus.empty()) {
+            for (uint32_t i=0; i < recordCompressorThreads.size(); i++) {
+                recordCompressorThreads[i].setAffinity(compressorCpus[i % compressorCpus.size()],
+                                                       placeRecords);
+            }
+        }
+
+        if (!recordWriterThread.empty()) {
+            recordWriterThread[0].setAffinity(writerCpus);
+        }
+    }
+
+
+    /**
+     * Get the total time spent waiting for an empty record to fill, which happens when
+     * all records are being compressed or written. Always 0 without multiple compression threads.
+     * @return total producer wait time in microseconds.
+     */
+    uint64_t EventWriter::getProducerWaitTime() const {
+        return supply == nullptr ? 0 : supply->getProducerWaitTime();
+    }
+
+
+    /**
+     * Get the total time compression threads spent idle, waiting for records to compress.
+     * Always 0 without multiple compression threads.
+     * @return total compression thread wait time in microseconds, summed over all threads.
+     */
+    uint64_t EventWriter::getCompressWaitTime() const {
+        return supply == nullptr ? 0 : supply->getCompressWaitTime();
+    }
+
+
+    /**
+     * Get the total time the writing thread spent idle, waiting for records to write.
+     * Always 0 without multiple compression threads.
+     * @return total writing thread wait time in microseconds.
+     */
+    uint64_t EventWriter::getWriteWaitTime() const {
+        return supply == nullptr ? 0 : supply->getWriteWaitTime();
+    }
+
+
+    /**
+     * Get a snapshot of the state of writing. May be called from any thread.
+     * Ring values are only available when compressing with multiple threads.
+     * When compressing in the calling thread, write latency is the time spent in
+     * writing each record, including waiting for the write of the previous one.
+     * Otherwise it is the time from the writing thread taking a record to the
+     * completion of its write.
+     * @return current metrics.
+     */
+    WriterMetrics EventWriter::getMetrics() const {
+        WriterMetrics metrics;
+
+        if (supply != nullptr) {
+            supply->getMetrics(metrics);
+        }
+        else {
+            metrics = singleThreadMetrics;
+            uint64_t in = 0, out = 0;
+            if (!metrics.compressors.empty()) {
+                in  = metrics.compressors[0].bytesIn;
+                out = metrics.compressors[0].bytesOut;
+            }
+            metrics.compressionRatio = in > 0 ? (double)out / (double)in : 0.;
+            metrics.avgWriteLatency  = metrics.recordsWritten > 0 ?
+                                       singleThreadWriteNanos / 1000 / metrics.recordsWritten : 0;
+            metrics.diskFull = diskIsFull;
+        }
+
+        fillStats.getMetrics(metrics);
+        metrics.splitCount = splitCount;
+        return metrics;
+    }
+
+
+    /**
+     * Set a callback to be handed the current metrics once every recordInterval
+     * records written and after each file split. It's run in the thread doing the
+     * writing, which is an internal thread when compressing with multiple threads,
+     * so it must be quick and thread-safe.
+     * @param callback       function to call, or empty to stop calling.
+     * @param recordInterval number of records written between calls, 0 is treated as 1.
+     */
+    void EventWriter::setMetricsCallback(const std::function<void(const WriterMetrics &)> & callback,
+                                         uint32_t recordInterval) {
+        metricsCallback = callback;
+        metricsInterval = recordInterval < 1 ? 1 : recordInterval;
+        recordsSinceMetrics = 0;
+    }
+
+
+    /**
+     * Write a sidecar index file next to each file written, holding the position,
+     * length and event count of each record as well as the offset and length of each event.
+     * A {@link Reader} uses it to find records if the file has no index of its own,
+     * for example if it has no trailer or was cut short. The index is saved when its
+     * file is closed, either by a split or by {@link #close()}.
+     * Ignored if writing to a buffer, if appending, or if events have already been written.
+     *
+     * @param write    if true, write a sidecar index for each file.
+     * @param withTags if true, also save the tag and num of each event.
+     */
+    void EventWriter::setSidecarIndex(bool write, bool withTags) {
+        if (!toFile || append || eventsWrittenTotal > 0) return;
+        sidecarIndex = write ? std::make_shared<EventIndexFile>(withTags) : nullptr;
+    }
+
+
+    /**
+     * Is a sidecar index file written for each file?
+     * @return true if a sidecar index file is written for each file.
+     */
+    bool EventWriter::isWritingSidecarIndex() const {return sidecarIndex != nullptr;}
+
+
+    /**
+     * Publish each record into a shared memory ring as it's written to file,
+     * so processes on the same node can read it without going through the file.
+     * Records too large for the ring's slots are only written to file.
+     * Ignored if writing to a buffer.
+     *
+     * @param writer shared memory writer, or null to stop publishing.
+     */
+    void EventWriter::setSharedMemoryWriter(std::shared_ptr<SharedMemoryWriter> & writer) {
+        if (!toFile) return;
+        sharedMemoryWriter = writer;
+    }
+
+
+    /**
+     * Get the shared memory writer each record is published to.
+     * @return shared memory writer, or null if none.
+     */
+    std::shared_ptr<SharedMemoryWriter> EventWriter::getSharedMemoryWriter() const {return sharedMemoryWriter;}
+
+
+    /**
+     * Add a mirror, which writes a second copy of each file to another directory or over a
+     * socket. Each record is compressed once, and handed to every mirror as it's written to
+     * file. Mirrors write with their own threads, and a slow one holds up writing or stops
+     * mirroring as set by {@link MirrorWriter#setBackpressure}. Mirrors are closed
+     * along with this writer. Ignored if writing to a buffer.
+     *
+     * @param mirror mirror to add.
+     * @throws EvioException if mirror is null, or a file has already been opened.
+     */
+    void EventWriter::addMirror(std::shared_ptr<MirrorWriter> const & mirror) {
+        if (!toFile) return;
+        if (mirror == nullptr) {
+            throw EvioException("null mirror");
+        }
+        if (fileOpen) {
+            throw EvioException("mirrors must be added before the file is opened");
+        }
+        mirrors.push_back(mirror);
+    }
+
+
+    /**
+     * Get the mirrors each file is copied to.
+     * @return mirrors, empty if none.
+     */
+    std::vector<std::shared_ptr<MirrorWriter>> const & EventWriter::getMirrors() const {return mirrors;}
+
+
+    /**
+     * Split the file once it holds the given number of events, in addition to splitting
+     * it by size. Since split file names need a split number, this only has an effect if
+     * this writer is splitting files. To split by event count alone, give a split size
+     * larger than any file will get.
+     * @param events number of events per file, 0 to not split by event count.
+     */
+    void EventWriter::setSplitEventCount(uint32_t events) {splitEvents = events;}
+
+
+    /**
+     * Get the number of events at which the file is split.
+     * @return number of events per file, 0 if not splitting by event count.
+     */
+    uint32_t EventWriter::getSplitEventCount() const {return splitEvents;}
+
+
+    /**
+     * Split the file once the given number of seconds have passed since events started
+     * going into it, in addition to splitting it by size. As with
+     * {@link #setSplitEventCount(uint32_t)}, this only has an effect if this writer is
+     * splitting files. A split only happens when an event is written, so a file
+     * receiving no events stays open.
+     * @param seconds age of file at which it's split, 0 to not split by time.
+     */
+    void EventWriter::setSplitTime(uint32_t seconds) {splitSeconds = seconds;}
+
+
+    /**
+     * Get the age of a file at which it's split.
+     * @return age of file in seconds, 0 if not splitting by time.
+     */
+    uint32_t EventWriter::getSplitTime() const {return splitSeconds;}
+
+
+    /**
+     * Is it time to split the file because of its event count or age?
+     * @param eventCount number of events in file so far.
+     * @return true if the event count or time limit has been reached.
+     */
+    bool EventWriter::splitLimitReached(uint32_t eventCount) const {
+        if (splitEvents > 0 && eventCount >= splitEvents) return true;
+        return splitSeconds > 0 &&
+               std::chrono::steady_clock::now() - splitStartTime >= std::chrono::seconds(splitSeconds);
+    }
+
+
+    /**
+     * Set a callback to be handed the name, size, event count and trailer status of
+     * each file once it has been completely written and closed, so it may be
+     * moved elsewhere right away. Files closed by a split are reported from the thread
+     * closing them, while the last file is reported from {@link #close()}.
+     * Since several files may be closing at once, the callback must be thread-safe.
+     * Ignored if writing to a buffer.
+     * @param callback function to call, or empty to stop calling.
+     */
+    void EventWriter::setFileClosedCallback(const std::function<void(const ClosedFileInfo &)> & callback) {
+        fileClosedCallback = callback;
+    }
+
+
+    /**
+     * Set an event which will be written to the file as
+     * well as to all split files. It's called the "first event" as it will be the
+     * first event written to each split file if this method
+     * is called early enough or the first event was defined in the constructor.
+     * In evio version 6, any dictionary and the first event are written to a
+     * common record which is stored in the user-header part of the file header if
+     * writing to a file. When writing to a buffer it's stored in the first record's
+     * user-header. The common record data is never compressed.<p>
+     *
+     * <b>FILE:</b>
+     * Since this method can only be called after the constructor, the common record may
+     * have already been written with its dictionary and possibly another firstEvent.
+     * If that is the case, the event given here will be written immediately somewhere
+     * in the body of the file. Any subsequent splits will have this event as the first
+     * event in the file header. On the other hand, if the common record has not yet been
+     * written to the file, this event becomes the first event in the file header.<p>
+     *
+     * <b>BUFFER:</b>
+     * By its nature this method is not all that useful for writing to a buffer since
+     * the buffer is never split. Writing this event is done by storing the common record
+     * in the main record's user-header. When writing to a buffer, the common record is not
+     * written until main buffer is full and flushCurrentRecordToBuffer() is called. That is not
+     * done until close() or flush() is called. In other words, there is still time to change
+     * the common record up until close is called.<p>
+     *
+     * Do not call this while simultaneously calling
+     * close, flush, writeEvent, or getByteBuffer.
+     *
+     * @param node node representing event to be placed first in each file written
+     *             including all splits.
+     *
+     * @throws EvioException if error writing to file
+     *                       if first event is opposite byte order of internal buffer;
+     *                       if bad data format;
+     *                       if close() already called;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing;
+     *                       if no room when writing to user-given buffer;
+     */
+    void EventWriter::setFirstEvent(std::shared_ptr<EvioNode> & node) {
+
+        if (closed) {return;}
+
+        {
+            // The common record goes into the header of any file opened by a record write
+            auto lock = lockCurrentRecord();
+            // There's no way to remove an event from a record, so reconstruct it.
+            createCommonRecord(xmlDictionary, nullptr, node, nullptr);
+        }
+
+        // When writing to a buffer, the common record is not written until
+        // buffer is full and flushCurrentRecordToBuffer() is called. That
+        // is not done until close() or flush() is called. In other words,
+        // there is still time to change the common record.
+
+        if (toFile && (recordsWritten > 0)) {
+            // If we've already written the file header, it's too late to place
+            // the common record there, so write first event as a regular event.
+            // The new common record will be written to the file header of the
+            // next split.
+            writeEvent(node, false);
+        }
+    }
+
+
+    /**
+     * Set an event which will be written to the file as
+     * well as to all split files. It's called the "first event" as it will be the
+     * first event written to each split file if this method
+     * is called early enough or the first event was defined in the constructor.
+     * In evio version 6, any dictionary and the first event are written to a
+     * common record which is stored in the user-header part of the file header if
+     * writing to a file. When writing to a buffer it's stored in the first record's
+     * user-header. The common record data is never compressed.<p>
+     *
+     * <b>FILE:</b>
+     * Since this method can only be called after the constructor, the common record may
+     * have already been written with its dictionary and possibly another firstEvent.
+     * If that is the case, the event given here will be written immediately somewhere
+     * in the body of the file. Any subsequent splits will have this event as the first
+     * event in the file header. On the other hand, if the common record has not yet been
+     * written to the file, this event becomes the first event in the file header.<p>
+     *
+     * <b>BUFFER:</b>
+     * By its nature this method is not all that useful for writing to a buffer since
+     * the buffer is never split. Writing this event is done by storing the common record
+     * in the main record's user-header. When writing to a buffer, the common record is not
+     * written until main buffer is full and flushCurrentRecordToBuffer() is called. That is not
+     * done until close() or flush() is called. In other words, there is still time to change
+     * the common record up until close is called.<p>
+     *
+     * Do not call this while simultaneously calling
+     * close, flush, writeEvent, or getByteBuffer.
+     *
+     * @param buf buffer containing event to be placed first in each file written
+     *               including all splits.
+     *
+     * @throws EvioException if error writing to file
+     *                       if first event is opposite byte order of internal buffer;
+     *                       if bad data format;
+     *                       if close() already called;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing;
+     *                       if no room when writing to user-given buffer;
+     */
+    void EventWriter::setFirstEvent(std::shared_ptr<ByteBuffer> & buf) {
+
+        if (closed) {return;}
+
+        {
+            // The common record goes into the header of any file opened by a record write
+            auto lock = lockCurrentRecord();
+
+            if ((buf->remaining() < 8) && (xmlDictionary.empty())) {
+                commonRecord = nullptr;
+                return;
+            }
+
+            createCommonRecord(xmlDictionary, nullptr, nullptr, buf);
+        }
+
+        if (toFile && (recordsWritten > 0) && (buf->remaining() > 7)) {
+            writeEvent(buf, false);
+        }
+    }
+
+
+    /**
+     * Set an event which will be written to the file as
+     * well as to all split files. It's called the "first event" as it will be the
+     * first event written to each split file if this method
+     * is called early enough or the first event was defined in the constructor.
+     * In evio version 6, any dictionary and the first event are written to a
+     * common record which is stored in the user-header part of the file header if
+     * writing to a file. When writing to a buffer it's stored in the first record's
+     * user-header. The common record data is never compressed.<p>
+     *
+     * <b>FILE:</b>
+     * Since this method can only be called after the constructor, the common record may
+     * have already been written with its dictionary and possibly another firstEvent.
+     * If that is the case, the event given here will be written immediately somewhere
+     * in the body of the file. Any subsequent splits will have this event as the first
+     * event in the file header. On the other hand, if the common record has not yet been
+     * written to the file, this event becomes the first event in the file header.<p>
+     *
+     * <b>BUFFER:</b>
+     * By its nature this method is not all that useful for writing to a buffer since
+     * the buffer is never split. Writing this event is done by storing the common record
+     * in the main record's user-header. When writing to a buffer, the common record is not
+     * written until main buffer is full and flushCurrentRecordToBuffer() is called. That is not
+     * done until close() or flush() is called. In other words, there is still time to change
+     * the common record up until close is called.<p>
+     *
+     * Do not call this while simultaneously calling
+     * close, flush, writeEvent, or getByteBuffer.
+     *
+     * @param bank event to be placed first in each file written including all splits.
+     *
+     * @throws EvioException if error writing to file
+     *                       if first event is opposite byte order of internal buffer;
+     *                       if bad data format;
+     *                       if close() already called;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing;
+     *                       if no room when writing to user-given buffer;
+     */
+    void EventWriter::setFirstEvent(std::shared_ptr<EvioBank> bank) {
+
+        if (closed) {return;}
+
+        {
+            // The common record goes into the header of any file opened by a record write
+            auto lock = lockCurrentRecord();
+            createCommonRecord(xmlDictionary, bank, nullptr, nullptr);
+        }
+
+        if (toFile && (recordsWritten > 0)) {
+            writeEvent(bank, nullptr, false);
+        }
+    }
+
+
+    /**
+     * Create and fill the common record which contains the dictionary and first event.
+     * Use the firstBank as the first event if specified, else try using the
+     * firstNode if specified, else try the firstBuf. If there is a dictionary,
+     * its binary form (see {@link EvioBinaryDictionary}) is added after those,
+     * followed by any trained compression dictionary.
+     *
+     * @param xmlDict        xml dictionary
+     * @param firstBank      first event as EvioBank
+     * @param firstNode      first event as EvioNode
+     * @param firstBuf       first event as ByteBuffer
+     * @throws EvioException if dictionary is in improper format
+     */
+    void EventWriter::createCommonRecord(const std::string & xmlDict,
+                                         std::shared_ptr<EvioBank> const & firstBank,
+                                         std::shared_ptr<EvioNode> const & firstNode,
+                                         std::shared_ptr<ByteBuffer> const & firstBuf) {
+
+        // Create record if necessary, else clear it
+        if (commonRecord == nullptr) {
+            // No compression please ...
+            commonRecord = std::make_shared<RecordOutput>(byteOrder, 0, 0,
+                                                          Compressor::CompressionType::UNCOMPRESSED);
+        }
+        else {
+            commonRecord->reset();
+        }
+
+        // Place dictionary & first event into a single record
+        if (!xmlDict.empty()) {
+//std::cout << "createCommonRecord: got dictionary, # chars = " << xmlDict.size() << std::endl;
+            // 56 is the minimum number of characters for a valid xml dictionary
+            if (xmlDict.length() < 56) {
+                throw EvioException("Dictionary improper format, too few characters");
+            }
+
+            // Turn dictionary data into ascii (not evio bank)
+            Util::stringToASCII(xmlDict, dictionaryByteArray);
+
+            // Add to record which will be our file header's "user header"
+            commonRecord->addEvent(dictionaryByteArray);
+//std::cout << "createCommonRecord: turned dictionary into ascii & added to commonRecord, byte size = " <<
+//             dictionaryByteArray.size() << std::endl;
+        }
+        else {
+            dictionaryByteArray.clear();
+        }
+
+        // Convert first event into bytes
+        haveFirstEvent = true;
+        if (firstBank != nullptr) {
+            firstEventByteArray.resize(firstBank->getTotalBytes());
+            firstBank->write(firstEventByteArray.data(), byteOrder);
+
+            // Add to record which will be our file header's "user header"
+            commonRecord->addEvent(firstEventByteArray);
+        }
+        else if (firstNode != nullptr) {
+            ByteBuffer firstEventBuf(firstNode->getTotalBytes());
+            firstNode->getStructureBuffer(firstEventBuf, true);
+            commonRecord->addEvent(firstEventBuf);
+        }
+        else if (firstBuf != nullptr) {
+            commonRecord->addEvent(firstBuf);
+        }
+        else {
+            haveFirstEvent = false;
+        }
+
+        // The binary form of the dictionary goes last so readers that
+        // don't know about it still find the first event where expected.
+        if (!xmlDict.empty()) {
+            if (binaryDictionaryByteArray.empty()) {
+                try {
+                    EvioXMLDictionary dict(xmlDict, 0);
+                    EvioBinaryDictionary::encode(dict, binaryDictionaryByteArray, byteOrder);
+                }
+                catch (EvioException & e) {
+                    // Readers will have to parse the xml
+                    binaryDictionaryByteArray.clear();
+                }
+            }
+
+            if (!binaryDictionaryByteArray.empty()) {
+                commonRecord->addEvent(binaryDictionaryByteArray);
+            }
+        }
+
+        if (!compressionDictionaryByteArray.empty()) {
+            commonRecord->addEvent(compressionDictionaryByteArray);
+        }
+
+        commonRecord->build();
+        commonRecordBytesToBuffer = 4*commonRecord->getHeader()->getLengthWords();
+//std::cout << "createCommonRecord: padded commonRecord size is " << commonRecordBytesToBuffer << " bytes" << std::endl;
+    }
+
+
+    /**
+     * Create and write a general file header into the file.
+     * The general header's user header is the common record which
+     * contains any existing dictionary and first event.<p>
+     *
+     * Call this method AFTER file split or, in constructor, after the file
+     * name is created in order to ensure a consistent value for file split number.
+     */
+    void EventWriter::writeFileHeader() {
+        // For the file header, our "user header" will be the common record,
+        // which is a record containing the dictionary and first event.
+
+        fileHeader.reset();
+        // File split # in header. Go back to last one as currently is set for the next split.
+        fileHeader.setFileNumber(splitNumber - splitIncrement);
+
+        // Check to see if we have dictionary and/or first event
+        int commonRecordBytes = 0;
+        int commonRecordCount = 0;
+
+        if (commonRecord != nullptr) {
+            commonRecordCount = commonRecord->getEventCount();
+            if (commonRecordCount > 0) {
+                commonRecordBytes = commonRecord->getHeader()->getLength();
+                bool haveDict = !dictionaryByteArray.empty();
+                fileHeader.setBitInfo(haveFirstEvent, haveDict, false);
+                fileHeader.hasCompressionDictionary(compressionDictionary != nullptr);
+            }
+            // Sets file header length too
+            fileHeader.setUserHeaderLength(commonRecordBytes);
+        }
+
+        // Index array is unused
+
+        // Total header size in bytes
+        int bytes = fileHeader.getLength();
+        ByteBuffer buf(bytes);
+        uint8_t* array = buf.array();
+        buf.order(byteOrder);
+
+        // Write file header into array
+        try {
+            fileHeader.writeHeader(buf, 0);
+        }
+        catch (EvioException & e) {/* never happen */}
+
+        // Write user header into array if necessary
+        if (commonRecordBytes > 0) {
+            auto commonBuf = commonRecord->getBinaryBuffer();
+            uint8_t* commonArray = commonBuf->array();
+            if (commonArray != nullptr) {
+                std::memcpy((void *)(array + FileHeader::HEADER_SIZE_BYTES),
+                            (const void *)(commonArray + commonBuf->arrayOffset()), commonRecordBytes);
+            }
+            else {
+                commonBuf->getBytes(array + FileHeader::HEADER_SIZE_BYTES, commonRecordBytes);
+            }
+        }
+
+        // Write array into file. When bypassing the page cache, it must go
+        // through the file writer which copies it before returning.
+        if (fileWriter != nullptr && fileWriter->isDirect()) {
+            fileWriter->write(array, bytes, fileWritingPosition, nullptr);
+        }
+        else {
+            asyncFileChannel->write(reinterpret_cast<char *>(array), bytes);
+        }
+
+        for (auto & mirror : mirrors) {
+            mirror->openFile(currentFileName, array, bytes);
+        }
+
+        eventsWrittenTotal = eventsWrittenToFile = commonRecordCount;
+        bytesWritten = bytes;
+        fileWritingPosition += bytes;
+    }
+
+
+    /**
+     * This method flushes any remaining internally buffered data to file.
+     * Calling {@link #close()} automatically does this so it isn't necessary
+     * to call before closing. This method should only be used when writing
+     * events at such a low rate that it takes an inordinate amount of time
+     * for internally buffered data to be written to the file.
+     * To have that done automatically, see {@link #setMaxRecordAge(uint32_t)}.<p>
+     *
+     * Calling this may easily kill performance. May not call this when simultaneously
+     * calling writeEvent, close, setFirstEvent, or getByteBuffer.
+     */
+    void EventWriter::flush() {
+
+        auto lock = lockCurrentRecord();
+
+        if (closed) {
+            return;
+        }
+
+        if (toFile) {
+            flushToFile(true);
+        }
+        else {
+            flushCurrentRecordToBuffer();
+        }
+    }
+
+
+    /**
+     * Send the current record, if it has any events, to be compressed and written
+     * to file, and start a new one.
+     * @param force if true, force the record physically to disk.
+     */
+    void EventWriter::flushToFile(bool force) {
+        if (singleThreadedCompression) {
+            try {
+                compressAndWriteToFile(force);
+            }
+            catch (EvioException & e) {
+                std::cout << e.what() << std::endl;
+            }
+        }
+        else {
+            // Write any existing data.
+            if (force) currentRingItem->forceToDisk(true);
+            if (currentRecord->getEventCount() > 0) {
+                // Send current record back to ring
+                supply->publish(currentRingItem);
+            }
+
+            // Get another empty record from ring
+            if (force) {
+                std::cout << "EventWriter: flush, get ring item, seq = " << currentRingItem->getSequence() << std::endl;
+            }
+            currentRingItem = supply->get();
+            currentRecord = currentRingItem->getRecord();
+        }
+    }
+
+
+    /**
+     * This method flushes any remaining data to file and disables this object.
+     * May not call this when simultaneously calling
+     * writeEvent, flush, setFirstEvent, or getByteBuffer.
+     */
+    void EventWriter::close() {
+        if (closed) {
+            return;
+        }
+
+        // Do not have records written behind our backs while finishing up
+        stopRecordAgeTimer();
+        maxRecordAge = 0;
+        stopDiskMonitor();
+        diskCheckPeriod = 0;
+        // Finish with all compression threads active
+        if (autoTuner != nullptr) {
+            autoTuner->stopThread();
+            autoTuner.reset();
+        }
+        // If buffer ...
+        if (!toFile) {
+            bool haveEvents = currentRecord->getEventCount() > 0;
+            flushCurrentRecordToBuffer();
+            // Write empty last header
+            try {
+                writeTrailerToBuffer(addTrailerIndex);
+            }
+            catch (std::exception & e) {
+                // We're here if buffer is too small
+                std::cout << e.what() << std::endl;
+            }
+
+            // Hand the last buffer of a pool over too
+            if (fullBufferCallback && haveEvents) {
+                auto full = buffer->duplicate();
+                full->order(buffer->order());
+                full->flip();
+                buffersFilled++;
+                fullBufferCallback(full);
+            }
+        }
+        // If file ...
+        else {
+            // Finish any streamed event, as best as possible
+            if (streamingEvent) {
+                try {
+                    endStreamedEvent(false);
+                }
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                    streamingEvent = false;
+                }
+            }
+
+            // Write record to file
+            if (singleThreadedCompression) {
+                try {compressAndWriteToFile(false);}
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+            else {
+                // If we're building a record, send it off
+                // to compressing thread since we're done.
+                // This should never happen as END event forces things through.
+                if (currentRecord->getEventCount() > 0) {
+                    // Put it back in supply for compressing and force to disk
+                    supply->publish(currentRingItem);
+                }
+
+                // Since the writer thread is the last to process each record,
+                // wait until it's done with the last item, then exit the thread.
+                std::cout << "Close: waiting 4 writing thd" << std::endl;
+                recordWriterThread[0].waitForLastItem();
+                std::cout << "Close: done waiting 4 writing thd" << std::endl;
+
+                // Stop all compressing threads which by now are stuck on get
+                for (RecordCompressor &thd : recordCompressorThreads) {
+                    thd.stopThread();
+                }
+            }
+
+            // Finish writing records to current file
+            try {
+                if (fileWriter != nullptr) {
+                    // Wait for last write to end before we continue
+                    fileWriter->waitForAll();
+                }
+            }
+            catch (std::exception & e) {
+                std::cout << e.what() << std::endl;
+            }
+
+            // Write trailer
+            bool trailerWritten = false;
+            if (addingTrailer) {
+                // Write the trailer
+                try {
+                    writeTrailerToFile(addTrailerIndex);
+                    trailerWritten = !noFileWriting;
+                }
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+
+            // Mirrors finish their copies of the file and stop
+            for (auto & mirror : mirrors) {
+                try {
+                    mirror->closeFile(recordNumber, addingTrailer, addTrailerIndex);
+                    mirror->close();
+                }
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+
+            // The file header is updated only once all else is written
+            try {
+                if (fileWriter != nullptr) {
+                    fileWriter->close();
                 }
             }
+            catch (std::exception & e) {
+                std::cout << e.what() << std::endl;
+            }
 
             try {
                 // Find & update file header's record count word
@@ -1307,12 +2588,61 @@ namespace evio {
             }
             catch (std::exception & e) {}
 
+            // Give back disk space reserved but not used
+            if (preallocateSplits && fileOpen) {
+                try {
+                    FileWriteBackend::truncateFile(currentFileName, closedFileLength());
+                }
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+
+            // Header was updated after the file writer synced the rest
+            if (durability != FileSyncer::NO_SYNC && fileOpen && !noFileWriting) {
+                try {
+                    FileSyncer::syncFile(currentFileName);
+                }
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+
+            // Remove the next split file if it was created ahead of time
+            if (nextFileCreated.valid() && nextFileCreated.get()) {
+                std::remove(nextFileName.c_str());
+            }
+
+            writeSidecarIndex();
+
+            if (fileClosedCallback && fileOpen) {
+                ClosedFileInfo info;
+                info.fileName        = currentFileName;
+                info.fileSize        = closedFileLength();
+                info.eventCount      = eventsWrittenToFile;
+                info.recordCount     = recordNumber - 1;
+                info.hasTrailer      = trailerWritten;
+                info.hasTrailerIndex = trailerWritten && addTrailerIndex;
+                info.complete        = trailerWritten || !addingTrailer || noFileWriting;
+                try {
+                    fileClosedCallback(info);
+                }
+                catch (std::exception & e) {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+
             // release resources
+            if (sharedCompression) {
+                CompressionExecutor::getInstance().removeSupply(supply);
+                sharedCompression = false;
+            }
+            fileWriter.reset();
+            fileWriterBuffers.clear();
             supply.reset();
             currentRecord.reset();
             recordWriterThread.clear();
             recordCompressorThreads.clear();
-            ringItem1.reset();
             currentRingItem.reset();
         }
 
@@ -1409,6 +2739,12 @@ namespace evio {
         uint64_t fileSize = fs::file_size(currentFileName);
 std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fileWritingPosition << std::endl;
 #endif
+        // Jump straight to the end if the trailer has an index of all records
+        if (hasTrailerWithIndex && appendAtTrailer(fileSize)) {
+            buffer->clear();
+            return;
+        }
+
         bool lastRecord, isTrailer, readEOF = false;
         uint32_t recordLen, eventCount, nBytes, bitInfo, headerPosition;
         std::future<void> future;
@@ -1616,6 +2952,95 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
     }
 
 
+    /**
+     * Position a file for appending by using its trailer's index, instead of reading
+     * the header of every record as {@link #toAppendPosition()} does. The index
+     * supplies the length and event count of each record. The trailer is removed, by
+     * cutting the file short at its start, and new records are written in its place.
+     * Nothing is changed if the index does not account for every byte between the
+     * first record and the trailer.
+     *
+     * @param fileSize size of file in bytes.
+     * @return true if positioned for appending, false if the whole file must be read.
+     * @throws EvioException if file reading or truncating problems.
+     */
+    bool EventWriter::appendAtTrailer(uint64_t fileSize) {
+
+        uint64_t trailerPos = appendFileHeader.getTrailerPosition();
+        uint64_t firstRecordPos = FileHeader::HEADER_SIZE_BYTES + indexLength +
+                                  userHeaderLength + userHeaderPadding;
+
+        if (trailerPos < firstRecordPos || trailerPos % 4 != 0 ||
+            trailerPos + RecordHeader::HEADER_SIZE_BYTES > fileSize) {
+            return false;
+        }
+
+        ByteBuffer header(RecordHeader::HEADER_SIZE_BYTES);
+        header.order(byteOrder);
+        asyncFileChannel->seekg(trailerPos);
+        asyncFileChannel->read(reinterpret_cast<char *>(header.array()), RecordHeader::HEADER_SIZE_BYTES);
+        if (asyncFileChannel->fail()) {
+            throw EvioException("error reading trailer from " + currentFileName);
+        }
+
+        uint32_t bitInfo   = header.getInt(RecordHeader::BIT_INFO_OFFSET);
+        uint32_t headerLen = 4*header.getInt(RecordHeader::HEADER_LENGTH_OFFSET);
+        uint32_t indexLen  = header.getInt(RecordHeader::INDEX_ARRAY_OFFSET);
+
+        if (header.getUInt(RecordHeader::MAGIC_OFFSET) != RecordHeader::HEADER_MAGIC ||
+            !RecordHeader::isEvioTrailer(bitInfo) || indexLen == 0 || indexLen % 8 != 0 ||
+            trailerPos + headerLen + indexLen > fileSize) {
+            return false;
+        }
+
+        // Index is pairs of record length in bytes and event count
+        ByteBuffer index(indexLen);
+        index.order(byteOrder);
+        asyncFileChannel->seekg(trailerPos + headerLen);
+        asyncFileChannel->read(reinterpret_cast<char *>(index.array()), indexLen);
+        if (asyncFileChannel->fail()) {
+            throw EvioException("error reading trailer index from " + currentFileName);
+        }
+
+        uint64_t pos = firstRecordPos;
+        uint32_t events = 0;
+        for (uint32_t i=0; i < indexLen; i += 8) {
+            uint32_t recordBytes = index.getInt(i);
+            if (recordBytes % 4 != 0 || pos + recordBytes > trailerPos) {
+                return false;
+            }
+            pos += recordBytes;
+            events += index.getInt(i + 4);
+        }
+
+        // Records must end right where the trailer starts
+        if (pos != trailerPos) {
+            return false;
+        }
+
+        for (uint32_t i=0; i < indexLen; i += 4) {
+            recordLengths->push_back(index.getInt(i));
+        }
+
+        // Remove the old trailer, a new one is written when closing
+        if (::truncate(currentFileName.c_str(), trailerPos) != 0) {
+            throw EvioException("error removing trailer from " + currentFileName);
+        }
+
+        eventsWrittenTotal = events;
+        eventsWrittenToFile = eventsWrittenToBuffer = hasAppendDictionary ? events + 1 : events;
+
+        // Next record written follows the last one in the index
+        recordsWritten = indexLen/8;
+        recordNumber = recordsWritten + 1;
+
+        fileWritingPosition = trailerPos;
+        bytesWritten = trailerPos;
+        asyncFileChannel->seekg(fileWritingPosition);
+        return true;
+    }
+
+
     /**
      * Is there room to write this many bytes to an output buffer as a single event?
      * Will always return true when writing to a file.
@@ -1661,7 +3086,6 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *         or record event count limit exceeded.
      *
      * @throws EvioException if error writing file
-     *                       if event is opposite byte order of internal buffer;
      *                       if close() already called;
      *                       if bad eventBuffer format;
      *                       if file could not be opened for writing;
@@ -1709,7 +3133,6 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *         or record event count limit exceeded.
      *
      * @throws EvioException if error writing file
-     *                       if event is opposite byte order of internal buffer;
      *                       if close() already called;
      *                       if bad eventBuffer format;
      *                       if file could not be opened for writing;
@@ -1777,7 +3200,6 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *         False if interrupted. If force arg is true, write anyway.
      *
      * @throws EvioException if error writing file
-     *                       if event is opposite byte order of internal buffer;
      *                       if close() already called;
      *                       if bad eventBuffer format;
      *                       if file could not be opened for writing;
@@ -1814,8 +3236,206 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      * To finish the writing process, call {@link #close()}. This will
      * compress the data if desired and then write it to the buffer.<p>
      *
-     * The buffer must contain only the event's data (event header and event data)
-     * and must <b>not</b> be in complete evio file format.
+     * The buffer must contain only the event's data (event header and event data)
+     * and must <b>not</b> be in complete evio file format.
+     * Do not call this while simultaneously calling
+     * close, flush, setFirstEvent, or getByteBuffer.<p>
+     *
+     * This method is not used to write the dictionary or the first event
+     * which are both placed in the common record which, in turn, is the
+     * user header part of the file header.<p>
+     *
+     * @param bankBuffer the bank (as a ByteBuffer object) to write.
+     * @return if writing to buffer: true if event was added to record, false if buffer full,
+     *         or record event count limit exceeded.
+     *
+     * @throws EvioException if error writing file
+     *                       if close() already called;
+     *                       if bad eventBuffer format;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing.
+     */
+    bool EventWriter::writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer) {
+        return writeEvent(nullptr, bankBuffer, false);
+    }
+
+    /**
+     * Write an event (bank) into a record in evio/hipo version 6 format.
+     * Once the record is full and if writing to a file (for multiple compression
+     * threads), the record will be sent to a thread which may compress the data,
+     * then it will be sent to a thread to write the record to file.
+     * If there is only 1 compression thread, it's all done in the thread which
+     * call this method.<p>
+     * If writing to a buffer, once the record is full this method returns
+     * false - indicating that the last event was NOT written to the record.
+     * To finish the writing process, call {@link #close()}. This will
+     * compress the data if desired and then write it to the buffer.<p>
+     *
+     * The buffer must contain only the event's data (event header and event data)
+     * and must <b>not</b> be in complete evio file format.
+     * Do not call this while simultaneously calling
+     * close, flush, setFirstEvent, or getByteBuffer.<p>
+     *
+     * Be warned that injudicious use of a true 2nd arg, the force flag, will
+     * <b>kill</b> performance when writing to a file.
+     *
+     * This method is not used to write the dictionary or the first event
+     * which are both placed in the common record which, in turn, is the
+     * user header part of the file header.<p>
+     *
+     * @param bankBuffer the bank (as a ByteBuffer object) to write.
+     * @param force      if writing to disk, force it to write event to the disk.
+     * @return if writing to buffer: true if event was added to record, false if buffer full,
+     *         or record event count limit exceeded.
+     *
+     * @throws EvioException if error writing file
+     *                       if close() already called;
+     *                       if bad eventBuffer format;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing.
+     */
+    bool EventWriter::writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer, bool force) {
+        return writeEvent(nullptr, bankBuffer, force);
+    }
+
+
+    /**
+     * Write an event (bank) viewed in memory, such as one obtained from
+     * {@link Reader#getEventView(uint32_t)}, into a record in evio/hipo version 6 format.
+     * This is the way to pass events read from one file on to another, as when skimming:
+     * the event is neither parsed nor serialized, and its bytes are copied only once,
+     * straight into the record being filled. The viewed memory need only remain valid
+     * until this method returns. Otherwise it behaves like
+     * {@link #writeEvent(std::shared_ptr<ByteBuffer> &, bool)}.
+     *
+     * @param event view of the event's data (event header and event data).
+     * @param force if writing to disk, force it to write event to the disk.
+     * @return if writing to buffer: true if event was added to record, false if buffer full,
+     *         or record event count limit exceeded.
+     *
+     * @throws EvioException if error writing file
+     *                       if close() already called;
+     *                       if bad event format;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing.
+     */
+    bool EventWriter::writeEvent(ByteBufferView const & event, bool force) {
+        if (event.empty()) {
+            throw EvioException("bad event format");
+        }
+
+        // Wrap the viewed bytes without copying or taking ownership of them.
+        // They're only read, once, when added to the record.
+        std::shared_ptr<uint8_t> data(const_cast<uint8_t *>(event.data()), [](uint8_t *) {});
+        auto bankBuffer = std::make_shared<ByteBuffer>(data, event.size());
+        bankBuffer->order(event.order());
+        return writeEvent(nullptr, bankBuffer, force);
+    }
+
+
+    /**
+     * Write an event built from fragments, each left where it is, in evio/hipo version 6 format.
+     * The event's header is written and each fragment copied straight into the current
+     * record, once, swapped and given its new tag and num in that same copy if need be
+     * (see {@link RecordOutput#addEvent(GatheredEvent const &, uint32_t)}).
+     * This saves first copying the fragments into an event with a {@link CompactEventBuilder}.
+     * Records, file splitting and forcing are handled just as for
+     * {@link #writeEvent(std::shared_ptr<ByteBuffer> &, bool)}.
+     * The fragments are no longer needed once this returns.
+     * Do not call this while simultaneously calling
+     * close, flush, setFirstEvent, or getByteBuffer.<p>
+     *
+     * @param event description of event and its fragments.
+     * @param force if writing to disk, force it to write event to the disk.
+     * @return if writing to buffer: true if event was added to record, false if buffer full,
+     *         or record event count limit exceeded. If writing to file, false if interrupted.
+     *
+     * @throws EvioException if error writing file
+     *                       if close() already called;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing.
+     */
+    bool EventWriter::writeEvent(GatheredEvent const & event, bool force) {
+
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+        if (streamingEvent) {
+            throw EvioException("streamed event begun but not ended");
+        }
+
+        if (!toFile) {
+            auto lock = lockCurrentRecord();
+
+            bool fitInRecord = currentRecord->addEvent(event, trailerBytes());
+
+            // If using a buffer pool, go on in the next buffer, unless the event doesn't fit an empty one
+            if (!fitInRecord && fullBufferCallback && currentRecord->getEventCount() > 0 && nextPoolBuffer()) {
+                fitInRecord = currentRecord->addEvent(event, trailerBytes());
+            }
+
+            if (fitInRecord) {
+                bytesWritten = commonRecordBytesToBuffer + currentRecord->getUncompressedSize();
+                eventsWrittenTotal++;
+                eventsWrittenToBuffer++;
+            }
+            return fitInRecord;
+        }
+
+        batchLengths.clear();
+        batchLengths.push_back(event.getTotalBytes());
+
+        return writeEventsToFile([&event, this](size_t, size_t) {
+                                     return currentRecord->addEvent(event) ? 1u : 0u;
+                                 }, force) == 1;
+    }
+
+
+    /**
+     * Write an event (bank) into a record in evio/hipo version 6 format.
+     * Once the record is full and if writing to a file (for multiple compression
+     * threads), the record will be sent to a thread which may compress the data,
+     * then it will be sent to a thread to write the record to file.
+     * If there is only 1 compression thread, it's all done in the thread which
+     * call this method.<p>
+     * If writing to a buffer, once the record is full this method returns
+     * false - indicating that the last event was NOT written to the record.
+     * To finish the writing process, call {@link #close()}. This will
+     * compress the data if desired and then write it to the buffer.<p>
+     *
+     * Do not call this while simultaneously calling
+     * close, flush, setFirstEvent, or getByteBuffer.<p>
+     *
+     * This method is not used to write the dictionary or the first event
+     * which are both placed in the common record which, in turn, is the
+     * user header part of the file header.<p>
+     *
+     * @param bank   the bank to write.
+     * @return if writing to buffer: true if event was added to record, false if buffer full,
+     *         or record event count limit exceeded.
+     *
+     * @throws EvioException if error writing file
+     *                       if close() already called;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing;.
+     */
+    bool EventWriter::writeEvent(std::shared_ptr<EvioBank> bank) {
+        return writeEvent(bank, nullptr, false);
+    }
+
+
+    /**
+     * Write an event (bank) into a record in evio/hipo version 6 format.
+     * Once the record is full and if writing to a file (for multiple compression
+     * threads), the record will be sent to a thread which may compress the data,
+     * then it will be sent to a thread to write the record to file.
+     * If there is only 1 compression thread, it's all done in the thread which
+     * call this method.<p>
+     * If writing to a buffer, once the record is full this method returns
+     * false - indicating that the last event was NOT written to the record.
+     * To finish the writing process, call {@link #close()}. This will
+     * compress the data if desired and then write it to the buffer.<p>
+     *
      * Do not call this while simultaneously calling
      * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
@@ -1823,21 +3443,24 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      * which are both placed in the common record which, in turn, is the
      * user header part of the file header.<p>
      *
-     * @param bankBuffer the bank (as a ByteBuffer object) to write.
+     * Be warned that injudicious use of the 2nd arg, the force flag, will
+     * <b>kill</b> performance when writing to a file.
+     *
+     * @param bank   the bank to write.
+     * @param force  if writing to disk, force it to write event to the disk.
      * @return if writing to buffer: true if event was added to record, false if buffer full,
      *         or record event count limit exceeded.
      *
      * @throws EvioException if error writing file
-     *                       if event is opposite byte order of internal buffer;
      *                       if close() already called;
-     *                       if bad eventBuffer format;
      *                       if file could not be opened for writing;
-     *                       if file exists but user requested no over-writing.
+     *                       if file exists but user requested no over-writing;.
      */
-    bool EventWriter::writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer) {
-        return writeEvent(nullptr, bankBuffer, false);
+    bool EventWriter::writeEvent(std::shared_ptr<EvioBank> bank, bool force) {
+        return writeEvent(bank, nullptr, force);
     }
 
+
     /**
      * Write an event (bank) into a record in evio/hipo version 6 format.
      * Once the record is full and if writing to a file (for multiple compression
@@ -1850,336 +3473,944 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      * To finish the writing process, call {@link #close()}. This will
      * compress the data if desired and then write it to the buffer.<p>
      *
-     * The buffer must contain only the event's data (event header and event data)
-     * and must <b>not</b> be in complete evio file format.
+     * The event to be written may be in one of two forms.
+     * The first is as an EvioBank object and the second is as a ByteBuffer
+     * containing only the event's data (event header and event data) and must
+     * <b>not</b> be in complete evio file format.
+     * The first non-null of the bank arguments will be written.
+     * A buffer in the opposite byte order of this writer is swapped as it is
+     * copied into the record, in one pass.
      * Do not call this while simultaneously calling
      * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
      * Be warned that injudicious use of a true 2nd arg, the force flag, will
-     * <b>kill</b> performance when writing to a file.
+     *<b>kill</b> performance when writing to a file.<p>
      *
      * This method is not used to write the dictionary or the first event
      * which are both placed in the common record which, in turn, is the
      * user header part of the file header.<p>
      *
+     * @param bank       the bank (as an EvioBank object) to write.
      * @param bankBuffer the bank (as a ByteBuffer object) to write.
      * @param force      if writing to disk, force it to write event to the disk.
      * @return if writing to buffer: true if event was added to record, false if buffer full,
-     *         or record event count limit exceeded.
+     *         record event count limit exceeded, or bank and bankBuffer args are both null.
      *
-     * @throws EvioException if error writing file
-     *                       if event is opposite byte order of internal buffer;
+     * @throws EvioException if error writing file;
+     *                       if bad bankBuffer format;
      *                       if close() already called;
-     *                       if bad eventBuffer format;
      *                       if file could not be opened for writing;
      *                       if file exists but user requested no over-writing.
      */
-    bool EventWriter::writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer, bool force) {
-        return writeEvent(nullptr, bankBuffer, force);
+    bool EventWriter::writeEvent(std::shared_ptr<EvioBank> bank,
+                                 std::shared_ptr<ByteBuffer> bankBuffer, bool force) {
+
+        auto lock = lockCurrentRecord();
+
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+        if (streamingEvent) {
+            throw EvioException("streamed event begun but not ended");
+        }
+
+        bool fitInRecord;
+        bool splittingFile = false;
+        // See how much space the event will take up
+        int currentEventBytes;
+
+        // Which bank do we write?
+        if (bankBuffer != nullptr) {
+            // Event size in bytes (from buffer ready to read)
+            currentEventBytes = bankBuffer->remaining();
+
+            // Size must be multiple of 4 bytes (whole 32-bit ints)
+            // The following is the equivalent of the mod operation:
+            //  (currentEventBytes % 4 != 0) but is much faster (x mod 2^n == x & (2^n - 1))
+            if ((currentEventBytes & 3) != 0) {
+                throw EvioException("bad bankBuffer format");
+            }
+
+            // Check for inconsistent lengths
+            if (currentEventBytes != 4 * (bankBuffer->getInt(bankBuffer->position()) + 1)) {
+                throw EvioException("inconsistent event lengths: total bytes from event = " +
+                                            std::to_string(4*(bankBuffer->getInt(bankBuffer->position()) + 1)) +
+                                    ", from buffer = " + std::to_string(currentEventBytes));
+            }
+        }
+        else if (bank != nullptr) {
+            currentEventBytes = bank->getTotalBytes();
+        }
+        else {
+            return false;
+        }
+
+        // If writing to buffer, we're not multi-threading compression & writing.
+        // Do it all in this thread, right now.
+        if (!toFile) {
+            return writeToBuffer(bank, bankBuffer);
+        }
+
+        // If here, we're writing to a file ...
+
+        // If we're splitting files,
+        // we must have written at least one real event before we
+        // can actually split the file.
+        if ((split > 0) && (splitEventCount > 0)) {
+            // Is event, along with the previous events, large enough to split the file?
+            // For simplicity ignore the headers which will take < 2Kb.
+            // Take any compression roughly into account.
+            uint64_t totalSize = (currentEventBytes + splitEventBytes)*compressionFactor/100;
+
+            // If we're going to split the file, set a couple flags
+            if (totalSize > split || splitLimitReached(splitEventCount)) {
+                //                std::cout << "Split at total size = " << totalSize <<
+                //                                   ", ev = " << currentEventBytes <<
+                //                                   ", prev = " << splitEventBytes <<
+                //                                   ", compressed data = " <<
+                //                                   ((currentEventBytes + splitEventBytes)*compressionFactor/100) << std::endl;
+                splittingFile = true;
+            }
+        }
+
+        // First, if multithreaded write, check for any errors that may have
+        // occurred asynchronously in the write or one of the compression threads.
+        if (!singleThreadedCompression && supply->haveError()) {
+            // Wake up any of these threads waiting for another record
+            supply->errorAlert();
+            throw EvioException(supply->getError());
+        }
+
+        // Including this event, this is the total data size & event count
+        // for this split file.
+        splitEventBytes += currentEventBytes;
+        splitEventCount++;
+
+        // If event is big enough to split the file ...
+        if (splittingFile) {
+            if (singleThreadedCompression) {
+                try {
+                    compressAndWriteToFile(false);
+                }
+                catch (boost::thread_interrupted & e) {
+                    return false;
+                }
+                catch (std::exception & e) {
+                    throw EvioException(e);
+                }
+
+                splitFile();
+            }
+            else {
+                // Set flag to split file
+                currentRingItem->splitFileAfterWrite(true);
+                //currentRecord->getHeader().setRecordNumber(recordNumber);
+                // Send current record back to ring without adding event
+                supply->publish(currentRingItem);
+
+                // Get another empty record from ring.
+                // Record number reset for new file.
+                recordNumber = 1;
+                currentRingItem = supply->get();
+                currentRecord = currentRingItem->getRecord();
+                currentRecord->getHeader()->setRecordNumber(recordNumber++);
+                //std::cout << "writeEvent: split after just published rec, new rec# = 1, next = " << recordNumber << std::endl;
+                // Reset record number for records coming after this one
+            }
+
+            // Reset split-tracking variables
+            splitEventBytes = 0L;
+            splitEventCount = 0;
+            splitStartTime = std::chrono::steady_clock::now();
+        }
+
+        // Try adding event to current record.
+        // One event is guaranteed to fit in a record no matter the size.
+        if (bankBuffer != nullptr) {
+            fitInRecord = currentRecord->addEvent(bankBuffer);
+        }
+        else {
+            fitInRecord = currentRecord->addEvent(bank);
+        }
+
+        // If no room or too many events ...
+        if (!fitInRecord) {
+            if (singleThreadedCompression) {
+                try {
+                    compressAndWriteToFile(false);
+                }
+                catch (boost::thread_interrupted & e) {
+                    return false;
+                }
+                catch (std::exception & e) {
+                    throw EvioException(e);
+                }
+            }
+            else {
+                // Send current record back to ring without adding event
+                supply->publish(currentRingItem);
+
+                // Get another empty record from ring
+                currentRingItem = supply->get();
+                currentRecord = currentRingItem->getRecord();
+                currentRecord->getHeader()->setRecordNumber(recordNumber++);
+                //std::cout << "writeEvent: just published rec, new rec# = " << (recordNumber - 1) << ", next = " << recordNumber << std::endl;
+            }
+
+            // Add event to it (guaranteed to fit)
+            if (bankBuffer != nullptr) {
+                currentRecord->addEvent(bankBuffer);
+            }
+            else {
+                currentRecord->addEvent(bank);
+            }
+        }
+
+        // If event must be physically written to disk ...
+        if (force) {
+            if (singleThreadedCompression) {
+                try {
+                    compressAndWriteToFile(true);
+                }
+                catch (boost::thread_interrupted & e) {
+                    return false;
+                }
+                catch (std::exception & e) {
+                    throw EvioException(e);
+                }
+            }
+            else {
+                // Tell writer to force this record to disk
+                currentRingItem->forceToDisk(true);
+                // Send current record back to ring
+                supply->publish(currentRingItem);
+
+                // Get another empty record from ring
+                currentRingItem = supply->get();
+                currentRecord = currentRingItem->getRecord();
+                currentRecord->getHeader()->setRecordNumber(recordNumber++);
+                //std::cout << "writeEvent: FORCED published rec, new rec# = " << (recordNumber - 1) << ", next = " << recordNumber << std::endl;
+            }
+        }
+
+        return true;
     }
 
 
     /**
-     * Write an event (bank) into a record in evio/hipo version 6 format.
-     * Once the record is full and if writing to a file (for multiple compression
-     * threads), the record will be sent to a thread which may compress the data,
-     * then it will be sent to a thread to write the record to file.
-     * If there is only 1 compression thread, it's all done in the thread which
-     * call this method.<p>
-     * If writing to a buffer, once the record is full this method returns
-     * false - indicating that the last event was NOT written to the record.
-     * To finish the writing process, call {@link #close()}. This will
-     * compress the data if desired and then write it to the buffer.<p>
+     * Write a batch of events (banks), each in its own ByteBuffer, in evio/hipo version 6 format.
+     * This does the same as calling {@link #writeEvent(std::shared_ptr<ByteBuffer> &, bool)}
+     * for each event, but when writing to a file, the checks for record space, event count
+     * limits and file splitting, as well as getting and publishing records to the compression
+     * and writing threads, are done once per record instead of once per event.
+     * For small events this is much faster.<p>
+     * Each buffer must contain only the event's data (event header and event data) from its
+     * position to limit, and must <b>not</b> be in complete evio file format.
+     * Do not call this while simultaneously calling
+     * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
+     * @param bankBuffers the banks (as ByteBuffer objects) to write.
+     * @param force       if writing to disk, force the last record to be written to the disk.
+     * @return number of events written. If writing to buffer, this is less than the number
+     *         of events given once the buffer is full or the record event count limit
+     *         is reached. If writing to file, this is less only if interrupted.
+     *
+     * @throws EvioException if error writing file
+     *                       if close() already called;
+     *                       if bad eventBuffer format;
+     *                       if file could not be opened for writing;
+     *                       if file exists but user requested no over-writing.
+     */
+    uint32_t EventWriter::writeEvents(const std::vector<std::shared_ptr<ByteBuffer>> & bankBuffers,
+                                      bool force) {
+
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+
+        batchLengths.clear();
+        for (auto & bankBuffer : bankBuffers) {
+            uint32_t currentEventBytes = bankBuffer->remaining();
+            if ((currentEventBytes & 3) != 0) {
+                throw EvioException("bad bankBuffer format");
+            }
+
+            if (currentEventBytes != 4u * (bankBuffer->getInt(bankBuffer->position()) + 1)) {
+                throw EvioException("inconsistent event lengths: total bytes from event = " +
+                                    std::to_string(4*(bankBuffer->getInt(bankBuffer->position()) + 1)) +
+                                    ", from buffer = " + std::to_string(currentEventBytes));
+            }
+            batchLengths.push_back(currentEventBytes);
+        }
+
+        if (!toFile) {
+            uint32_t written = 0;
+            for (auto & bankBuffer : bankBuffers) {
+                std::shared_ptr<EvioBank> noBank = nullptr;
+                auto buf = bankBuffer;
+                if (!writeToBuffer(noBank, buf)) break;
+                written++;
+            }
+            return written;
+        }
+
+        return writeEventsToFile([&bankBuffers, this](size_t offset, size_t count) {
+                                     return currentRecord->addEvents(bankBuffers, offset, count);
+                                 }, force);
+    }
+
+
+    /**
+     * Write a batch of events (banks), each represented by an EvioNode, in evio/hipo version 6 format.
+     * This does the same as calling {@link #writeEvent(std::shared_ptr<EvioNode> &, bool, bool)}
+     * for each event, but when writing to a file, the checks for record space, event count
+     * limits and file splitting, as well as getting and publishing records to the compression
+     * and writing threads, are done once per record instead of once per event.
+     * When writing to a file, the nodes' backing buffers are read without changing their
+     * position or limit, so they may be accessed by other threads at the same time.<p>
      * Do not call this while simultaneously calling
      * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
-     * This method is not used to write the dictionary or the first event
-     * which are both placed in the common record which, in turn, is the
-     * user header part of the file header.<p>
-     *
-     * @param bank   the bank to write.
-     * @return if writing to buffer: true if event was added to record, false if buffer full,
-     *         or record event count limit exceeded.
+     * @param nodes objects representing the events to write in buffer form.
+     * @param force if writing to disk, force the last record to be written to the disk.
+     * @return number of events written. If writing to buffer, this is less than the number
+     *         of events given once the buffer is full or the record event count limit
+     *         is reached. If writing to file, this is less only if interrupted.
      *
      * @throws EvioException if error writing file
+     *                       if a node does not represent a bank;
      *                       if close() already called;
      *                       if file could not be opened for writing;
-     *                       if file exists but user requested no over-writing;.
+     *                       if file exists but user requested no over-writing.
      */
-    bool EventWriter::writeEvent(std::shared_ptr<EvioBank> bank) {
-        return writeEvent(bank, nullptr, false);
+    uint32_t EventWriter::writeEvents(const std::vector<std::shared_ptr<EvioNode>> & nodes, bool force) {
+
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+
+        batchLengths.clear();
+        for (auto & node : nodes) {
+            batchLengths.push_back(node->getTotalBytes());
+        }
+
+        if (!toFile) {
+            uint32_t written = 0;
+            for (auto node : nodes) {
+                if (!writeEvent(node, false, true)) break;
+                written++;
+            }
+            return written;
+        }
+
+        return writeEventsToFile([&nodes, this](size_t offset, size_t count) {
+                                     return currentRecord->addEvents(nodes, offset, count);
+                                 }, force);
     }
 
 
     /**
-     * Write an event (bank) into a record in evio/hipo version 6 format.
-     * Once the record is full and if writing to a file (for multiple compression
-     * threads), the record will be sent to a thread which may compress the data,
-     * then it will be sent to a thread to write the record to file.
-     * If there is only 1 compression thread, it's all done in the thread which
-     * call this method.<p>
-     * If writing to a buffer, once the record is full this method returns
-     * false - indicating that the last event was NOT written to the record.
-     * To finish the writing process, call {@link #close()}. This will
-     * compress the data if desired and then write it to the buffer.<p>
-     *
+     * Write a batch of events (banks) in evio/hipo version 6 format.
+     * This does the same as calling {@link #writeEvent(std::shared_ptr<EvioBank>, bool)}
+     * for each event, but when writing to a file, the checks for record space, event count
+     * limits and file splitting, as well as getting and publishing records to the compression
+     * and writing threads, are done once per record instead of once per event.<p>
      * Do not call this while simultaneously calling
      * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
-     * This method is not used to write the dictionary or the first event
-     * which are both placed in the common record which, in turn, is the
-     * user header part of the file header.<p>
-     *
-     * Be warned that injudicious use of the 2nd arg, the force flag, will
-     * <b>kill</b> performance when writing to a file.
-     *
-     * @param bank   the bank to write.
-     * @param force  if writing to disk, force it to write event to the disk.
-     * @return if writing to buffer: true if event was added to record, false if buffer full,
-     *         or record event count limit exceeded.
+     * @param banks the banks to write.
+     * @param force if writing to disk, force the last record to be written to the disk.
+     * @return number of events written. If writing to buffer, this is less than the number
+     *         of events given once the buffer is full or the record event count limit
+     *         is reached. If writing to file, this is less only if interrupted.
      *
      * @throws EvioException if error writing file
      *                       if close() already called;
      *                       if file could not be opened for writing;
-     *                       if file exists but user requested no over-writing;.
+     *                       if file exists but user requested no over-writing.
      */
-    bool EventWriter::writeEvent(std::shared_ptr<EvioBank> bank, bool force) {
-        return writeEvent(bank, nullptr, force);
+    uint32_t EventWriter::writeEvents(const std::vector<std::shared_ptr<EvioBank>> & banks, bool force) {
+
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+
+        if (!toFile) {
+            uint32_t written = 0;
+            for (auto & bank : banks) {
+                if (!writeEvent(bank, nullptr, false)) break;
+                written++;
+            }
+            return written;
+        }
+
+        batchLengths.clear();
+        for (auto & bank : banks) {
+            batchLengths.push_back(bank->getTotalBytes());
+        }
+
+        return writeEventsToFile([&banks, this](size_t offset, size_t count) {
+                                     return currentRecord->addEvents(banks, offset, count);
+                                 }, force);
     }
 
 
     /**
-     * Write an event (bank) into a record in evio/hipo version 6 format.
-     * Once the record is full and if writing to a file (for multiple compression
-     * threads), the record will be sent to a thread which may compress the data,
-     * then it will be sent to a thread to write the record to file.
-     * If there is only 1 compression thread, it's all done in the thread which
-     * call this method.<p>
-     * If writing to a buffer, once the record is full this method returns
-     * false - indicating that the last event was NOT written to the record.
-     * To finish the writing process, call {@link #close()}. This will
-     * compress the data if desired and then write it to the buffer.<p>
-     *
-     * The event to be written may be in one of two forms.
-     * The first is as an EvioBank object and the second is as a ByteBuffer
-     * containing only the event's data (event header and event data) and must
-     * <b>not</b> be in complete evio file format.
-     * The first non-null of the bank arguments will be written.
+     * Write a batch of events (banks) stored one after another in a single array,
+     * such as a run of consecutive events of a record read by {@link Reader}, in evio/hipo
+     * version 6 format. When writing to a file in the same byte order, events are copied
+     * into each record as a block, with one memcpy (see
+     * {@link RecordOutput#addEvents(const uint8_t*, const uint32_t*, uint32_t)}), and
+     * the checks for record space, event count limits and file splitting are done once per
+     * record as in {@link #writeEvents(const std::vector<std::shared_ptr<ByteBuffer>> &, bool)}.
+     * Otherwise the events are written one by one, swapped if necessary.
      * Do not call this while simultaneously calling
      * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
-     * Be warned that injudicious use of a true 2nd arg, the force flag, will
-     *<b>kill</b> performance when writing to a file.<p>
-     *
-     * This method is not used to write the dictionary or the first event
-     * which are both placed in the common record which, in turn, is the
-     * user header part of the file header.<p>
-     *
-     * @param bank       the bank (as an EvioBank object) to write.
-     * @param bankBuffer the bank (as a ByteBuffer object) to write.
-     * @param force      if writing to disk, force it to write event to the disk.
-     * @return if writing to buffer: true if event was added to record, false if buffer full,
-     *         record event count limit exceeded, or bank and bankBuffer args are both null.
+     * @param events    array holding events back to back.
+     * @param eventLens array of each event's length in bytes.
+     * @param count     number of events in array.
+     * @param order     byte order of events.
+     * @param force     if writing to disk, force the last record to be written to the disk.
+     * @return number of events written. If writing to buffer, this is less than the number
+     *         of events given once the buffer is full or the record event count limit
+     *         is reached. If writing to file, this is less only if interrupted.
      *
-     * @throws EvioException if error writing file;
-     *                       if event is opposite byte order of internal buffer;
-     *                       if bad bankBuffer format;
+     * @throws EvioException if error writing file
      *                       if close() already called;
+     *                       if bad event format;
      *                       if file could not be opened for writing;
      *                       if file exists but user requested no over-writing.
      */
-    bool EventWriter::writeEvent(std::shared_ptr<EvioBank> bank,
-                                 std::shared_ptr<ByteBuffer> bankBuffer, bool force) {
+    uint32_t EventWriter::writeEvents(const uint8_t *events, const uint32_t *eventLens, uint32_t count,
+                                      ByteOrder const & order, bool force) {
 
         if (closed) {
             throw EvioException("close() has already been called");
         }
 
-        bool fitInRecord;
+        batchLengths.clear();
+        batchOffsets.clear();
+        size_t offset = 0;
+        for (uint32_t i=0; i < count; i++) {
+            uint32_t len = eventLens[i];
+            if (len < 8 || (len & 3) != 0 ||
+                len != 4 * (ByteBufferView(events + offset, len, order).getInt(0) + 1)) {
+                throw EvioException("bad event format");
+            }
+            batchLengths.push_back(len);
+            batchOffsets.push_back(offset);
+            offset += len;
+        }
+
+        if (!toFile || order != byteOrder) {
+            uint32_t written = 0;
+            for (uint32_t i=0; i < count; i++) {
+                ByteBufferView event(events + batchOffsets[i], eventLens[i], order);
+                if (!writeEvent(event, force && i == count - 1)) break;
+                written++;
+            }
+            return written;
+        }
+
+        return writeEventsToFile([events, eventLens, this](size_t offset, size_t count) {
+                                     return currentRecord->addEvents(events + batchOffsets[offset],
+                                                                     eventLens + offset, count);
+                                 }, force);
+    }
+
+
+    /**
+     * Begin writing an event in chunks, for an event too large to be held in memory
+     * in one piece, such as a calibration time frame of several GB. The event's bytes,
+     * bank header first, are then given in any number of pieces of any size with
+     * {@link #appendToStreamedEvent} and the event finished with {@link #endStreamedEvent}.
+     * The pieces are gathered into two buffers of {@link #STREAMED_EVENT_BUFFER_BYTES} each,
+     * one written to file while the other is filled, so the whole event is never held and
+     * no record or ring item is made to grow for it. The event gets an uncompressed record
+     * of its own, written once all records before it have been.<p>
+     *
+     * If the event's length is not known beforehand, give 0 and the record header, as well
+     * as the length word of the event's bank header, is written once the event ends,
+     * so the bank header may be given with any length. Otherwise the bank header must
+     * agree with the given length.<p>
+     *
+     * The pieces must be in this writer's byte order since they are not swapped.
+     * The event, whose length must be a multiple of 4, must be less than 4GB since
+     * that is the most a record may hold. Streamed events are not handed to a
+     * {@link SharedMemoryWriter} or any {@link MirrorWriter}, so this may not be used
+     * with either. No other event may be written until the streamed event ends.
+     * A file split, if one is due, is done before the streamed event is begun.
+     *
+     * @param bytes length of event in bytes, 0 if not known until it ends.
+     * @throws EvioException if close() already called;
+     *                       if not writing to a file;
+     *                       if another streamed event was begun and not ended;
+     *                       if bytes is not a multiple of 4, is less than 8, or is too large;
+     *                       if bytes is 0 and bypassing the page cache, which allows no
+     *                       going back to write the record header;
+     *                       if writing to shared memory or to mirrors;
+     *                       if error writing file.
+     */
+    void EventWriter::beginStreamedEvent(uint32_t bytes) {
+
+        auto lock = lockCurrentRecord();
+
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+        if (!toFile) {
+            throw EvioException("events are streamed only to files");
+        }
+        if (streamingEvent) {
+            throw EvioException("streamed event begun but not ended");
+        }
+        if ((bytes & 3) != 0 || (bytes > 0 && bytes < 8) ||
+            bytes > UINT32_MAX - RecordHeader::HEADER_SIZE_BYTES - 4) {
+            throw EvioException("bad event length, " + std::to_string(bytes));
+        }
+        if (bytes == 0 && fileWriterDirectIO) {
+            throw EvioException("event length must be given when bypassing the page cache");
+        }
+        if (sharedMemoryWriter != nullptr || !mirrors.empty()) {
+            throw EvioException("streamed events cannot be written to shared memory or mirrors");
+        }
+        if (!singleThreadedCompression && supply->haveError()) {
+            supply->errorAlert();
+            throw EvioException(supply->getError());
+        }
+
+        // Is it time to split the file? The event itself is not compressed.
         bool splittingFile = false;
-        // See how much space the event will take up
-        int currentEventBytes;
+        if ((split > 0) && (splitEventCount > 0)) {
+            uint64_t totalSize = splitEventBytes*compressionFactor/100 + bytes;
+            if (totalSize > split || splitLimitReached(splitEventCount)) {
+                splittingFile = true;
+            }
+        }
 
-        // Which bank do we write?
-        if (bankBuffer != nullptr) {
-            if (bankBuffer->order() != byteOrder) {
-                throw EvioException("event buf is " + bankBuffer->order().getName() +
-                                    ", and writer is " + byteOrder.getName());
+        // Write any records begun or in the pipeline first,
+        // so the streamed record can go into the file right after them
+        if (singleThreadedCompression) {
+            try {
+                if (currentRecord->getEventCount() > 0) {
+                    compressAndWriteToFile(false);
+                }
+                if (splittingFile) {
+                    splitFile();
+                }
+            }
+            catch (std::exception & e) {
+                throw EvioException(e);
             }
 
-            // Event size in bytes (from buffer ready to read)
-            currentEventBytes = bankBuffer->remaining();
+            streamedRecordNumber = recordNumber;
+        }
+        else {
+            if (splittingFile) {
+                currentRingItem->splitFileAfterWrite(true);
+                currentRingItem->setCheckDisk(false);
+                supply->publish(currentRingItem);
 
-            // Size must be multiple of 4 bytes (whole 32-bit ints)
-            // The following is the equivalent of the mod operation:
-            //  (currentEventBytes % 4 != 0) but is much faster (x mod 2^n == x & (2^n - 1))
-            if ((currentEventBytes & 3) != 0) {
-                throw EvioException("bad bankBuffer format");
+                // Record number reset for new file
+                recordNumber = 1;
+                currentRingItem = supply->get();
+                currentRecord = currentRingItem->getRecord();
+                currentRecord->getHeader()->setRecordNumber(recordNumber++);
+            }
+            else if (currentRecord->getEventCount() > 0) {
+                supply->publish(currentRingItem);
+                currentRingItem = supply->get();
+                currentRecord = currentRingItem->getRecord();
+                currentRecord->getHeader()->setRecordNumber(recordNumber++);
             }
 
-            // Check for inconsistent lengths
-            if (currentEventBytes != 4 * (bankBuffer->getInt(bankBuffer->position()) + 1)) {
-                throw EvioException("inconsistent event lengths: total bytes from event = " +
-                                            std::to_string(4*(bankBuffer->getInt(bankBuffer->position()) + 1)) +
-                                    ", from buffer = " + std::to_string(currentEventBytes));
+            // The writing thread is left idle until the streamed event ends
+            recordWriterThread[0].waitForPublishedItems();
+            if (supply->haveError()) {
+                supply->errorAlert();
+                throw EvioException(supply->getError());
             }
+
+            // Streamed record takes the number of the current, empty one which gets the next
+            streamedRecordNumber = currentRecord->getHeader()->getRecordNumber();
+            currentRecord->getHeader()->setRecordNumber(recordNumber++);
         }
-        else if (bank != nullptr) {
-            currentEventBytes = bank->getTotalBytes();
+
+        if (splittingFile) {
+            splitEventBytes = 0L;
+            splitEventCount = 0;
+            splitStartTime = std::chrono::steady_clock::now();
         }
-        else {
-            return false;
+
+        if (fileWriter != nullptr) {
+            fileWriter->waitForAll();
+        }
+
+        // This creates the file if it's not there yet
+        if (bytesWritten < 1) {
+            openNewFile();
+        }
+        else if (fileWriter == nullptr) {
+            createFileWriter();
+        }
+
+        if (streamBuffers[0].empty()) {
+            streamBuffers[0].resize(STREAMED_EVENT_BUFFER_BYTES);
+            streamBuffers[1].resize(STREAMED_EVENT_BUFFER_BYTES);
         }
+        streamBufferIndex = 0;
+        streamBufferFill = 0;
+
+        streamingEvent = true;
+        streamedEventBytes = bytes;
+        streamedBytesAppended = 0;
+        streamedBytesWritten = 0;
+        streamedRecordPosition = fileWritingPosition;
+
+        // Without a length, leave room for the record header and index to be written once ended
+        buildStreamedRecordStart(bytes);
+        stageStreamedBytes(streamedRecordStart.data(), RecordHeader::HEADER_SIZE_BYTES + 4);
+    }
+
+
+    /**
+     * Append the next piece of the event begun with {@link #beginStreamedEvent}.
+     * The piece is copied before this returns, so it may then be reused.
+     *
+     * @param data  the next bytes of the event, in this writer's byte order.
+     * @param bytes number of bytes.
+     * @throws EvioException if no streamed event has been begun;
+     *                       if more bytes are given than the event's length or the most
+     *                       a record may hold;
+     *                       if error writing file.
+     */
+    void EventWriter::appendToStreamedEvent(const uint8_t *data, size_t bytes) {
+
+        if (!streamingEvent) {
+            throw EvioException("no streamed event begun");
+        }
+
+        uint64_t maxBytes = UINT32_MAX - RecordHeader::HEADER_SIZE_BYTES - 4;
+        if (streamedEventBytes > 0) {
+            maxBytes = streamedEventBytes;
+        }
+        if (streamedBytesAppended + bytes > maxBytes) {
+            throw EvioException("streamed event longer than " + std::to_string(maxBytes) + " bytes");
+        }
+
+        // Keep the bank header to check its length and for the sidecar index
+        if (streamedBytesAppended < 8) {
+            size_t len = std::min(bytes, (size_t)(8 - streamedBytesAppended));
+            std::memcpy(streamedEventHeader + streamedBytesAppended, data, len);
+        }
+
+        stageStreamedBytes(data, bytes);
+        streamedBytesAppended += bytes;
+    }
+
+
+    /**
+     * Finish the event begun with {@link #beginStreamedEvent}, writing the rest of it
+     * and, if its length was not given, its record header and bank length word.
+     * The event is then counted as written, just like any other.
+     *
+     * @param force if true, force the event physically to disk.
+     * @throws EvioException if no streamed event has been begun;
+     *                       if fewer bytes were appended than the event's given length;
+     *                       if the event is shorter than 8 bytes or not a multiple of 4;
+     *                       if the event's bank header does not agree with its given length;
+     *                       if error writing file.
+     */
+    void EventWriter::endStreamedEvent(bool force) {
+
+        if (!streamingEvent) {
+            throw EvioException("no streamed event begun");
+        }
+
+        uint64_t bytes = streamedBytesAppended;
+        if (streamedEventBytes > 0 && bytes != streamedEventBytes) {
+            throw EvioException("streamed event has " + std::to_string(bytes) +
+                                " bytes, but was begun with " + std::to_string(streamedEventBytes));
+        }
+        if (bytes < 8 || (bytes & 3) != 0) {
+            throw EvioException("bad event format");
+        }
+
+        uint32_t words[2];
+        std::memcpy(words, streamedEventHeader, 8);
+        if (byteOrder != ByteOrder::ENDIAN_LOCAL) {
+            words[0] = SWAP_32(words[0]);
+            words[1] = SWAP_32(words[1]);
+        }
+        if (streamedEventBytes > 0 && 4*((uint64_t)words[0] + 1) != bytes) {
+            throw EvioException("inconsistent event lengths: total bytes from event = " +
+                                std::to_string(4*((uint64_t)words[0] + 1)) +
+                                ", appended = " + std::to_string(bytes));
+        }
+
+        auto lock = lockCurrentRecord();
+
+        writeStreamBuffer();
+        fileWriter->waitForAll();
+
+        // Go back to write the record header, index, and bank length
+        if (streamedEventBytes == 0) {
+            buildStreamedRecordStart(bytes);
+            if (!noFileWriting) {
+                fileWriter->write(streamedRecordStart.data(), streamedRecordStart.size(),
+                                  streamedRecordPosition, nullptr);
+                fileWriter->waitForAll();
+            }
+        }
+
+        if (force) fileWriter->sync();
+
+        uint32_t recordBytes = RecordHeader::HEADER_SIZE_BYTES + 4 + bytes;
+        recordLengths->push_back(recordBytes);
+        // Trailer's index has count following length
+        recordLengths->push_back(1);
+
+        if (sidecarIndex != nullptr) {
+            std::vector<uint32_t> lengths {(uint32_t)bytes};
+            std::vector<uint32_t> tagNums {(words[1] & 0xffff0000) | (words[1] & 0xff)};
+            sidecarIndex->addRecord(streamedRecordPosition, recordBytes,
+                                    RecordHeader::HEADER_SIZE_BYTES + 4, lengths, tagNums);
+        }
+
+        // Keep track of what is written to this, one, file
+        if (singleThreadedCompression) {
+            recordNumber++;
+            singleThreadMetrics.recordsWritten++;
+        }
+        recordsWritten++;
+        bytesWritten        += recordBytes;
+        fileWritingPosition += recordBytes;
+        bytesSinceDiskCheck += recordBytes;
+        eventsWrittenToFile++;
+        eventsWrittenTotal++;
+        splitEventBytes += bytes;
+        splitEventCount++;
+
+        streamingEvent = false;
+        reportMetrics(false);
+    }
+
+
+    /**
+     * Is an event being written in chunks?
+     * @return true if a streamed event has been begun but not ended.
+     */
+    bool EventWriter::isStreamingEvent() const {return streamingEvent;}
+
+
+    /**
+     * Fill streamedRecordStart with the header and index of a streamed event's record
+     * followed by the event's bank length word.
+     * @param eventBytes length of event in bytes, 0 for an all-zero placeholder.
+     */
+    void EventWriter::buildStreamedRecordStart(uint32_t eventBytes) {
+        streamedRecordStart.assign(RecordHeader::HEADER_SIZE_BYTES + 8, 0);
+        if (eventBytes == 0) return;
+
+        RecordHeader header(HeaderType::EVIO_RECORD);
+        header.setRecordNumber(streamedRecordNumber);
+        header.setCompressionType(Compressor::UNCOMPRESSED);
+        header.setEntries(1);
+        header.setIndexLength(4);
+        header.setUserHeaderLength(0);
+        header.setDataLength(eventBytes);
+        header.setCompressedDataLength(0);
+        header.setLength(RecordHeader::HEADER_SIZE_BYTES + 4 + eventBytes);
+
+        ByteBuffer buf(streamedRecordStart.size());
+        buf.order(byteOrder);
+        header.writeHeader(buf, 0);
+        buf.putInt(RecordHeader::HEADER_SIZE_BYTES, eventBytes);
+        buf.putInt(RecordHeader::HEADER_SIZE_BYTES + 4, eventBytes/4 - 1);
+        std::memcpy(streamedRecordStart.data(), buf.array(), streamedRecordStart.size());
+    }
+
+
+    /**
+     * Copy bytes of the streamed event's record into the streaming buffer being filled,
+     * writing it to file each time it's full.
+     * @param data  bytes to write.
+     * @param bytes number of bytes.
+     * @throws EvioException if error writing file.
+     */
+    void EventWriter::stageStreamedBytes(const uint8_t *data, size_t bytes) {
+        while (bytes > 0) {
+            auto & buf = streamBuffers[streamBufferIndex];
+            size_t len = std::min(bytes, buf.size() - streamBufferFill);
+            std::memcpy(buf.data() + streamBufferFill, data, len);
+            streamBufferFill += len;
+            data  += len;
+            bytes -= len;
+
+            if (streamBufferFill == buf.size()) {
+                writeStreamBuffer();
+            }
+        }
+    }
 
-        // If writing to buffer, we're not multi-threading compression & writing.
-        // Do it all in this thread, right now.
-        if (!toFile) {
-            return writeToBuffer(bank, bankBuffer);
+
+    /**
+     * Write the streaming buffer being filled to file, then switch to filling the other
+     * once the write from it, the only one that may still be in flight, is done.
+     * @throws EvioException if error writing file.
+     */
+    void EventWriter::writeStreamBuffer() {
+        if (streamBufferFill == 0) return;
+
+        fileWriter->waitForAll();
+        if (!noFileWriting) {
+            fileWriter->write(streamBuffers[streamBufferIndex].data(), streamBufferFill,
+                              streamedRecordPosition + streamedBytesWritten, nullptr);
         }
 
-        // If here, we're writing to a file ...
+        streamedBytesWritten += streamBufferFill;
+        streamBufferIndex = 1 - streamBufferIndex;
+        streamBufferFill = 0;
+    }
 
-        // If we're splitting files,
-        // we must have written at least one real event before we
-        // can actually split the file.
-        if ((split > 0) && (splitEventCount > 0)) {
-            // Is event, along with the previous events, large enough to split the file?
-            // For simplicity ignore the headers which will take < 2Kb.
-            // Take any compression roughly into account.
-            uint64_t totalSize = (currentEventBytes + splitEventBytes)*compressionFactor/100;
 
-            // If we're going to split the file, set a couple flags
-            if (totalSize > split) {
-                //                std::cout << "Split at total size = " << totalSize <<
-                //                                   ", ev = " << currentEventBytes <<
-                //                                   ", prev = " << splitEventBytes <<
-                //                                   ", compressed data = " <<
-                //                                   ((currentEventBytes + splitEventBytes)*compressionFactor/100) << std::endl;
-                splittingFile = true;
-            }
+    /**
+     * Write the batch of events whose lengths are in batchLengths into records and
+     * eventually to a file. File splitting is handled just as for individual events,
+     * but records are filled with as many events as fit at once, and then either compressed
+     * and written (single compression thread) or published to the ring (multiple threads).
+     *
+     * @param addToRecord function adding (offset, count) events of the batch to the current
+     *                    record and returning the number actually added.
+     * @param force       force the last record to disk.
+     * @return number of events written, less than the batch size only if interrupted.
+     * @throws EvioException if error writing file.
+     */
+    uint32_t EventWriter::writeEventsToFile(const std::function<uint32_t(size_t, size_t)> & addToRecord,
+                                            bool force) {
+
+        auto lock = lockCurrentRecord();
+
+        if (streamingEvent) {
+            throw EvioException("streamed event begun but not ended");
         }
 
-        // First, if multithreaded write, check for any errors that may have
+        // If multithreaded write, check for any errors that may have
         // occurred asynchronously in the write or one of the compression threads.
         if (!singleThreadedCompression && supply->haveError()) {
-            // Wake up any of these threads waiting for another record
             supply->errorAlert();
             throw EvioException(supply->getError());
         }
 
-        // Including this event, this is the total data size & event count
-        // for this split file.
-        splitEventBytes += currentEventBytes;
-        splitEventCount++;
+        size_t total = batchLengths.size();
+        size_t written = 0;
 
-        // If event is big enough to split the file ...
-        if (splittingFile) {
-            if (singleThreadedCompression) {
-                try {
-                    compressAndWriteToFile(false);
-                }
-                catch (boost::thread_interrupted & e) {
-                    return false;
-                }
-                catch (std::exception & e) {
-                    throw EvioException(e);
-                }
+        while (written < total) {
 
-                splitFile();
-            }
-            else {
-                // Set flag to split file
-                currentRingItem->splitFileAfterWrite(true);
-                //currentRecord->getHeader().setRecordNumber(recordNumber);
-                // Send current record back to ring without adding event
-                supply->publish(currentRingItem);
+            // How many of the following events go into the current split file?
+            size_t last = total;
+            bool splittingFile = false;
 
-                // Get another empty record from ring.
-                // Record number reset for new file.
-                recordNumber = 1;
-                currentRingItem = supply->get();
-                currentRecord = currentRingItem->getRecord();
-                currentRecord->getHeader()->setRecordNumber(recordNumber++);
-                //std::cout << "writeEvent: split after just published rec, new rec# = 1, next = " << recordNumber << std::endl;
-                // Reset record number for records coming after this one
+            if (split > 0) {
+                uint64_t bytes = splitEventBytes;
+                uint32_t count = splitEventCount;
+                for (last = written; last < total; last++) {
+                    // Must have written at least one real event before splitting
+                    if ((count > 0) && ((batchLengths[last] + bytes)*compressionFactor/100 > split ||
+                                        splitLimitReached(count))) {
+                        splittingFile = true;
+                        break;
+                    }
+                    bytes += batchLengths[last];
+                    count++;
+                }
             }
 
-            // Reset split-tracking variables
-            splitEventBytes = 0L;
-            splitEventCount = 0;
-        }
-
-        // Try adding event to current record.
-        // One event is guaranteed to fit in a record no matter the size.
-        if (bankBuffer != nullptr) {
-            fitInRecord = currentRecord->addEvent(bankBuffer);
-        }
-        else {
-            fitInRecord = currentRecord->addEvent(bank);
-        }
-
-        // If no room or too many events ...
-        if (!fitInRecord) {
-            if (singleThreadedCompression) {
-                try {
-                    compressAndWriteToFile(false);
-                }
-                catch (boost::thread_interrupted & e) {
-                    return false;
+            // Fill as many records as needed with these events
+            while (written < last) {
+                uint32_t added = addToRecord(written, last - written);
+                for (size_t i = written; i < written + added; i++) {
+                    splitEventBytes += batchLengths[i];
                 }
-                catch (std::exception & e) {
-                    throw EvioException(e);
+                splitEventCount += added;
+                written += added;
+
+                if (written < last) {
+                    // Current record is full
+                    if (singleThreadedCompression) {
+                        try {
+                            compressAndWriteToFile(false);
+                        }
+                        catch (boost::thread_interrupted & e) {
+                            return written;
+                        }
+                        catch (std::exception & e) {
+                            throw EvioException(e);
+                        }
+                    }
+                    else {
+                        supply->publish(currentRingItem);
+                        currentRingItem = supply->get();
+                        currentRecord = currentRingItem->getRecord();
+                        currentRecord->getHeader()->setRecordNumber(recordNumber++);
+                    }
                 }
             }
-            else {
-                // Send current record back to ring without adding event
-                supply->publish(currentRingItem);
 
-                // Get another empty record from ring
-                currentRingItem = supply->get();
-                currentRecord = currentRingItem->getRecord();
-                currentRecord->getHeader()->setRecordNumber(recordNumber++);
-                //std::cout << "writeEvent: just published rec, new rec# = " << (recordNumber - 1) << ", next = " << recordNumber << std::endl;
-            }
+            if (splittingFile) {
+                if (singleThreadedCompression) {
+                    try {
+                        compressAndWriteToFile(false);
+                    }
+                    catch (boost::thread_interrupted & e) {
+                        return written;
+                    }
+                    catch (std::exception & e) {
+                        throw EvioException(e);
+                    }
 
-            // Add event to it (guaranteed to fit)
-            if (bankBuffer != nullptr) {
-                currentRecord->addEvent(bankBuffer);
-            }
-            else {
-                currentRecord->addEvent(bank);
+                    splitFile();
+                }
+                else {
+                    currentRingItem->splitFileAfterWrite(true);
+                    supply->publish(currentRingItem);
+
+                    // Record number reset for new file
+                    recordNumber = 1;
+                    currentRingItem = supply->get();
+                    currentRecord = currentRingItem->getRecord();
+                    currentRecord->getHeader()->setRecordNumber(recordNumber++);
+                }
+
+                splitEventBytes = 0L;
+                splitEventCount = 0;
+                splitStartTime = std::chrono::steady_clock::now();
             }
         }
 
-        // If event must be physically written to disk ...
-        if (force) {
+        if (force && written > 0) {
             if (singleThreadedCompression) {
                 try {
                     compressAndWriteToFile(true);
                 }
                 catch (boost::thread_interrupted & e) {
-                    return false;
+                    return written;
                 }
                 catch (std::exception & e) {
                     throw EvioException(e);
                 }
             }
             else {
-                // Tell writer to force this record to disk
                 currentRingItem->forceToDisk(true);
-                // Send current record back to ring
                 supply->publish(currentRingItem);
-
-                // Get another empty record from ring
                 currentRingItem = supply->get();
                 currentRecord = currentRingItem->getRecord();
                 currentRecord->getHeader()->setRecordNumber(recordNumber++);
-                //std::cout << "writeEvent: FORCED published rec, new rec# = " << (recordNumber - 1) << ", next = " << recordNumber << std::endl;
             }
         }
 
-        return true;
+        return written;
     }
 
     /**
@@ -2206,6 +4437,8 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      * containing only the event's data (event header and event data) and must
      * <b>not</b> be in complete evio file format.
      * The first non-null of the bank arguments will be written.
+     * A buffer in the opposite byte order of this writer is swapped as it is
+     * copied into the record, in one pass.
      * Do not call this while simultaneously calling
      * close, flush, setFirstEvent, or getByteBuffer.<p>
      *
@@ -2224,7 +4457,6 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *         False if interrupted. If force arg is true, write anyway.
      *
      * @throws EvioException if error writing file
-     *                       if event is opposite byte order of internal buffer;
      *                       if both buffer args are null;
      *                       if bad bankBuffer format;
      *                       if close() already called;
@@ -2235,9 +4467,14 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
     bool EventWriter::writeEventToFile(std::shared_ptr<EvioBank> bank,
                                        std::shared_ptr<ByteBuffer> bankBuffer, bool force) {
 
+        auto lock = lockCurrentRecord();
+
         if (closed) {
             throw EvioException("close() has already been called");
         }
+        if (streamingEvent) {
+            throw EvioException("streamed event begun but not ended");
+        }
 
         if (!toFile) {
             throw EvioException("cannot write to buffer with this method");
@@ -2283,11 +4520,6 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
 
         // Which bank do we write?
         if (bankBuffer != nullptr) {
-            if (bankBuffer->order() != byteOrder) {
-                throw EvioException("event buf is " + bankBuffer->order().getName() +
-                                    ", and writer is " + byteOrder.getName());
-            }
-
             // Event size in bytes (from buffer ready to read)
             currentEventBytes = bankBuffer->remaining();
 
@@ -2322,7 +4554,7 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             uint64_t totalSize = (currentEventBytes + splitEventBytes)*compressionFactor/100;
 
             // If we're going to split the file, set a couple flags
-            if (totalSize > split) {
+            if (totalSize > split || splitLimitReached(splitEventCount)) {
                 splittingFile = true;
             }
         }
@@ -2371,6 +4603,7 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             // Reset split-tracking variables
             splitEventBytes = 0L;
             splitEventCount = 0;
+            splitStartTime = std::chrono::steady_clock::now();
             //cout << "Will split, reset splitEventBytes = "  << splitEventBytes << endl;
         }
 
@@ -2471,21 +4704,36 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
 
     /**
      * Check to see if the disk is full.
-     * Is it able to store 1 full split, 1 supply of records, and a 10MB buffer zone?
+     * Is it able to store 1 full split, 1 supply of records, and the reserve (10MB by default)?
+     * If a disk monitor is running, this is found without a system call.
      * Two variables are set, one atomic and one not, depending on needs.
      * @return  true if full, else false.
      */
     bool EventWriter::fullDisk() {
+        uint64_t freeBytes, capacity;
+
+        if (diskCheckPeriod > 0) {
+            // The monitor's last look less what's been written since, no system call
+            uint64_t lastFree = diskFreeBytes.load();
+            uint64_t written  = bytesSinceDiskCheck.load();
+            freeBytes = lastFree > written ? lastFree - written : 0;
+            capacity  = diskCapacityBytes.load();
+        }
+        else {
 #ifdef __APPLE__
-        uint64_t freeBytes = 20000000000L;
+            freeBytes = 20000000000L;
+            capacity  = 0;
 #else
-        // How much free space is available on the disk?
-    fs::space_info dirInfo = fs::space(currentFilePath.parent_path());
-    uint64_t freeBytes = dirInfo.available;
+            // How much free space is available on the disk?
+            fs::space_info dirInfo = fs::space(currentFilePath.parent_path());
+            freeBytes = dirInfo.available;
+            capacity  = dirInfo.capacity;
 #endif
+        }
+
         // If there isn't enough free space to write the complete, projected size file
-        // plus full records + 10MB extra ...
-        diskIsFull = freeBytes < split + maxSupplyBytes + 10000000;
+        // plus full records + reserve ...
+        diskIsFull = tooLittleSpace(freeBytes, capacity);
         if (!singleThreadedCompression) {
             diskIsFullVolatile = diskIsFull;
         }
@@ -2505,11 +4753,7 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *                       if error opening/writing/forcing write to file.
      */
     void EventWriter::compressAndWriteToFile(bool force) {
-
-        auto & header = currentRecord->getHeader();
-        header->setRecordNumber(recordNumber);
-        header->setCompressionType(compressionType);
-        currentRecord->build();
+        buildCurrentRecord();
         // Resets currentRecord too
         writeToFile(force, false);
     }
@@ -2532,12 +4776,68 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *                       if error opening/writing/forcing write to file.
      */
     bool EventWriter::tryCompressAndWriteToFile(bool force) {
+        buildCurrentRecord();
+        return writeToFile(force, true);
+    }
+
 
+    /**
+     * Compress the current record in the calling thread, keeping track of time and sizes.
+     * Used when doing compression & writing to file in a single thread.
+     */
+    void EventWriter::buildCurrentRecord() {
         auto & header = currentRecord->getHeader();
         header->setRecordNumber(recordNumber);
         header->setCompressionType(compressionType);
+
+        uint32_t bytesIn = currentRecord->getUncompressedSize();
+        auto t1 = std::chrono::steady_clock::now();
         currentRecord->build();
-        return writeToFile(force, true);
+        singleThreadCompressNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - t1).count();
+
+        if (singleThreadMetrics.compressors.empty()) {
+            singleThreadMetrics.compressors.resize(1);
+        }
+        auto & stats = singleThreadMetrics.compressors[0];
+        stats.busyTime  = singleThreadCompressNanos / 1000;
+        stats.bytesIn  += bytesIn;
+        stats.bytesOut += header->getLength();
+        stats.records++;
+    }
+
+
+    /**
+     * Call the metrics callback, if any, once every metricsInterval records written
+     * and after each file split.
+     * @param fileSplit true if called because the file was just split.
+     */
+    void EventWriter::reportMetrics(bool fileSplit) {
+        if (!metricsCallback) return;
+        if (!fileSplit && ++recordsSinceMetrics < metricsInterval) return;
+
+        recordsSinceMetrics = 0;
+        metricsCallback(getMetrics());
+    }
+
+
+    /**
+     * Save the index of the current file's records and events, if any,
+     * to its sidecar file and clear it for the next file.
+     * Errors are printed but otherwise ignored since the index is optional.
+     */
+    void EventWriter::writeSidecarIndex() {
+        if (sidecarIndex == nullptr) return;
+
+        try {
+            if (sidecarIndex->getRecordCount() > 0) {
+                sidecarIndex->write(EventIndexFile::sidecarName(currentFileName));
+            }
+        }
+        catch (EvioException & e) {
+            std::cout << e.what() << std::endl;
+        }
+        sidecarIndex->clear();
     }
 
 
@@ -2567,6 +4867,28 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             throw EvioException("close() has already been called");
         }
 
+        // Time spent here, including waiting for the previous write, is this record's latency
+        auto t1 = std::chrono::steady_clock::now();
+
+        // Which buffer do we fill next?
+        std::shared_ptr<ByteBuffer> unusedBuffer;
+
+        // If 1st time thru, proceed without waiting
+        if (usedBuffer == nullptr) {
+            // Fill 2nd buffer next
+            unusedBuffer = internalBuffers[1];
+        }
+        // After first time, wait until the previous write (perhaps to
+        // the previous split file) is finished before proceeding
+        else {
+            if (fileWriter != nullptr) {
+                fileWriter->waitForAll();
+            }
+
+            // Reuse the buffer just finished being written
+            unusedBuffer = usedBuffer;
+        }
+
         // This actually creates the file so do it only once
         if (bytesWritten < 1) {
 
@@ -2580,41 +4902,11 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
                 return false;
             }
 
-            // New shared pointer for each file ...
-            asyncFileChannel = std::make_shared<std::fstream>();
-            asyncFileChannel->open(currentFileName, std::ios::binary | std::ios::trunc | std::ios::out);
-            if (asyncFileChannel->fail()) {
-                throw EvioException("error opening file " + currentFileName);
-            }
-
-            // Right now file is open for writing
-            fileOpen = true;
-            fileWritingPosition = 0L;
-            splitCount++;
-
-            // Write out the beginning file header including common record
-            writeFileHeader();
-        }
-
-        // Which buffer do we fill next?
-        std::shared_ptr<ByteBuffer> unusedBuffer;
-
-        // We need future job to be completed in order to proceed
-
-        // If 1st time thru, proceed without waiting
-        if (future1 == nullptr) {
-            // Fill 2nd buffer next
-            unusedBuffer = internalBuffers[1];
+            openNewFile();
         }
-        // After first time, wait until the future is finished before proceeding
-        else {
-            // If previous write in progress ...
-            if (future1->valid()) {
-                future1->get();
-
-                // Reuse the buffer future1 just finished using
-                unusedBuffer = usedBuffer;
-            }
+        // If appending, file was opened in constructor
+        else if (fileWriter == nullptr) {
+            createFileWriter();
         }
 
         // Get record to write
@@ -2629,20 +4921,27 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
         // Trailer's index has count following length
         recordLengths->push_back(eventCount);
 
+        if (sidecarIndex != nullptr) {
+            sidecarIndex->addRecord(fileWritingPosition, *record);
+        }
+
+        if (sharedMemoryWriter != nullptr) {
+            sharedMemoryWriter->publish(*record);
+        }
+
+        for (auto & mirror : mirrors) {
+            mirror->writeRecord(*record);
+        }
+
         // Data to write
         auto buf = record->getBinaryBuffer();
 
 //std::cout << "\nwriteToFile: file pos = " << asyncFileChannel->tellg() << ", fileWritingPOsition = " <<
   //           fileWritingPosition << std::endl;
 
-        future1 = std::make_shared<std::future<void>>(std::future<void>(
-                std::async(std::launch::async,  // run in a separate thread
-                           staticWriteFunction, // function to run
-                           this,                // arguments to function ...
-                           reinterpret_cast<const char *>(buf->array()),
-                           bytesToWrite)));
+        fileWriter->write(buf->array(), bytesToWrite, fileWritingPosition, nullptr);
 
-        // Keep track of which buffer future1 used so it can be reused when done
+        // Keep track of which buffer is being written so it can be reused when done
         usedBuffer = buf;
 
         // Next buffer to work with
@@ -2654,19 +4953,27 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
         record->reset();
 
         // Force it to write to physical disk (KILLS PERFORMANCE!!!, 15x-20x slower),
-        // but don't bother writing the metadata (arg to force()) since that slows it
-        // down even more.
-        // TODO: This may not work since data may NOT have been written yet!
-        if (force) asyncFileChannel->sync();
+        // but don't bother writing the metadata since that slows it down even more.
+        // This waits for the write to complete.
+        if (force) fileWriter->sync();
 
         // Keep track of what is written to this, one, file
         recordNumber++;
         recordsWritten++;
         bytesWritten        += bytesToWrite;
         fileWritingPosition += bytesToWrite;
+        bytesSinceDiskCheck += bytesToWrite;
         eventsWrittenToFile += eventCount;
         eventsWrittenTotal  += eventCount;
 
+        uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - t1).count();
+        singleThreadWriteNanos += nanos;
+        singleThreadMetrics.recordsWritten++;
+        singleThreadMetrics.lastWriteLatency = nanos / 1000;
+        singleThreadMetrics.maxWriteLatency  = std::max(singleThreadMetrics.maxWriteLatency, nanos / 1000);
+        reportMetrics(false);
+
         //        if (false) {
         //            std::cout << "    writeToFile: after last header written, Events written to:" << std::endl;
         //            std::cout << "                 cnt total (no dict) = " << eventsWrittenTotal << std::endl;
@@ -2695,7 +5002,7 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
      *                       if file exists but user requested no over-writing;
      * @throws IOException   if error writing file
      */
-    void EventWriter::writeToFileMT(std::shared_ptr<RecordRingItem> & item, bool force) {
+    void EventWriter::writeToFileMT(const std::shared_ptr<RecordRingItem> & item, bool force) {
         if (closed) {
             throw EvioException("close() has already been called");
         }
@@ -2704,31 +5011,11 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
         if (bytesWritten < 1) {
             std::cout << "Creating channel to " << currentFileName << std::endl;
 
-            // New shared pointer for each file ...
-            asyncFileChannel = std::make_shared<std::fstream>();
-            asyncFileChannel->open(currentFileName, std::ios::binary | std::ios::trunc | std::ios::out);
-            if (asyncFileChannel->fail()) {
-                throw EvioException("error opening file " + currentFileName);
-            }
-
-            // Right now file is open for writing
-            fileOpen = true;
-            fileWritingPosition = 0L;
-            splitCount++;
-
-            // Write out the beginning file header including common record
-            writeFileHeader();
+            openNewFile();
         }
-
-        // We the future job to be completed in order to proceed
-
-        // If 1st time thru, proceed without waiting
-        if (future1 != nullptr) {
-            // If previous write in progress ...
-            if (future1->valid()) {
-                future1->get();
-            }
-            supply->releaseWriterSequential(ringItem1);
+        // If appending, file was opened in constructor
+        else if (fileWriter == nullptr) {
+            createFileWriter();
         }
 
         // Get record to write
@@ -2738,47 +5025,50 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
         // Length of this record
         int bytesToWrite = header->getLength();
         int eventCount   = header->getEntries();
-        std::cout << "   **** added to recordLengths MT: " << bytesToWrite << ", " <<
-             eventCount << std::endl;
+        //std::cout << "   **** added to recordLengths MT: " << bytesToWrite << ", " <<
+        //     eventCount << std::endl;
         recordLengths->push_back(bytesToWrite);
         // Trailer's index has count following length
         recordLengths->push_back(eventCount);
 
-        // Data to write
-        auto buf = record->getBinaryBuffer();
+        if (sidecarIndex != nullptr) {
+            sidecarIndex->addRecord(fileWritingPosition, *record);
+        }
 
-        if (noFileWriting) {
-            future1 = std::make_shared<std::future<void>>(std::future<void>(
-                    std::async(std::launch::async,
-                               staticDoNothingFunction,
-                               this)));
+        if (sharedMemoryWriter != nullptr) {
+            sharedMemoryWriter->publish(*record);
+        }
+
+        for (auto & mirror : mirrors) {
+            mirror->writeRecord(*record);
+        }
 
+        if (noFileWriting) {
+            supply->releaseWriter(item);
         }
         else {
-            future1 = std::make_shared<std::future<void>>(std::future<void>(
-                    std::async(std::launch::async,  // run in a separate thread
-                               staticWriteFunction,        // function to run
-                               this,                       // arguments to function ...
-                               reinterpret_cast<const char *>(buf->array()),
-                               bytesToWrite)));
+            // Item is released back to supply once written.
+            // Up to fileWriterQueueDepth records may be in flight.
+            record->getSegments(fileWriterSegments);
+            fileWriter->write(fileWriterSegments, fileWritingPosition, item);
         }
 
-        ringItem1 = item;
-
         // Force it to write to physical disk (KILLS PERFORMANCE!!!, 15x-20x slower),
-        // but don't bother writing the metadata (arg to force()) since that slows it
-        // down even more.
-        // TODO: This may not work since data may NOT have been written yet!
-        if (force) asyncFileChannel->sync();
+        // but don't bother writing the metadata since that slows it down even more.
+        // This waits for the write to complete.
+        if (force) fileWriter->sync();
 
         // Keep track of what is written to this, one, file
         //recordNumber++;
         recordsWritten++;
         bytesWritten        += bytesToWrite;
         fileWritingPosition += bytesToWrite;
+        bytesSinceDiskCheck += bytesToWrite;
         eventsWrittenToFile += eventCount;
         eventsWrittenTotal  += eventCount;
 
+        reportMetrics(false);
+
         //fileWritingPosition += 20;
         //bytesWritten  += 20;
 
@@ -2808,22 +5098,32 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
     void EventWriter::splitFile() {
 
         if (fileOpen) {
+            for (auto & mirror : mirrors) {
+                mirror->closeFile(recordNumber, addingTrailer, addTrailerIndex);
+            }
+
             // Finish writing data & trailer and then close existing file -
             // all in a separate thread for speed. Copy over values so they
             // don't change in the meantime.
-            fileCloser->closeAsyncFile(asyncFileChannel, future1, supply, ringItem1,
+            fileCloser->closeAsyncFile(asyncFileChannel, fileWriter,
                                        fileHeader, recordLengths, bytesWritten,
                                        recordNumber,
                                        addingTrailer, addTrailerIndex,
-                                       noFileWriting, byteOrder);
+                                       noFileWriting, byteOrder,
+                                       preallocateSplits ? currentFileName : "",
+                                       closedFileLength(), currentFileName,
+                                       eventsWrittenToFile, fileClosedCallback);
 
-            // Reset for next write
+            // Reset for next write. With single threaded compression, keep fileWriter
+            // so the next write can wait for it to be done with the buffer it's writing.
             if (!singleThreadedCompression) {
-                future1 = nullptr;
+                fileWriter = nullptr;
             }
             recordLengths->clear();
             // Right now no file is open for writing
             fileOpen = false;
+
+            writeSidecarIndex();
         }
 
         // Create the next file's name
@@ -2837,8 +5137,15 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
         currentFilePath = fs::path(fileName);
         currentFileName = currentFilePath.generic_string();
 
+        // Use the file created ahead of time, if it's this one
+        currentFilePreCreated = false;
+        if (nextFileCreated.valid()) {
+            currentFilePreCreated = nextFileCreated.get() && (nextFileName == currentFileName);
+        }
+
         // If we can't overwrite and file exists, throw exception
-        if (!overWriteOK && fs::exists(currentFilePath) && fs::is_regular_file(currentFilePath)) {
+        if (!overWriteOK && !currentFilePreCreated &&
+            fs::exists(currentFilePath) && fs::is_regular_file(currentFilePath)) {
             // If we're doing a multithreaded write ...
             if (supply != nullptr) {
                 supply->haveError(true);
@@ -2859,6 +5166,30 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
         eventsWrittenToFile = 0;
 
         std::cout << "    splitFile: generated file name = " << fileName << ", record # = " << recordNumber << std::endl;
+        reportMetrics(true);
+    }
+
+
+    /**
+     * Write the trailer in headerArray to the file at the current position.
+     * When bypassing the page cache, it must go through the file writer,
+     * which is then closed so that the header can be updated afterwards.
+     *
+     * @param bytes number of bytes in trailer.
+     * @throws EvioException if problems writing to file.
+     */
+    void EventWriter::writeTrailerBytes(size_t bytes) {
+        if (fileWriter != nullptr && fileWriter->isOpen() && fileWriter->isDirect()) {
+            fileWriter->write(headerArray.data(), bytes, fileWritingPosition, nullptr);
+            fileWriter->close();
+            return;
+        }
+
+        asyncFileChannel->seekg(fileWritingPosition);
+        asyncFileChannel->write(reinterpret_cast<char *>(headerArray.data()), bytes);
+        if (asyncFileChannel->fail()) {
+            throw EvioException("error writing to  file " + currentFileName);
+        }
     }
 
 
@@ -2883,12 +5214,7 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             // this write completes since it'll just complicate the code.
             // As this is the absolute last write to the file,
             // just make sure it gets done right here.
-            asyncFileChannel->seekg(fileWritingPosition);
-            asyncFileChannel->write(reinterpret_cast<char *>(headerArray.data()),
-                                    RecordHeader::HEADER_SIZE_BYTES);
-            if (asyncFileChannel->fail()) {
-                throw EvioException("error writing to  file " + currentFileName);
-            }
+            writeTrailerBytes(RecordHeader::HEADER_SIZE_BYTES);
         }
         else {
             // Write trailer with index
@@ -2906,12 +5232,7 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
 
             //std::cout << "\nwriteTrailerToFile: file pos = " << asyncFileChannel->tellg() << ", fileWritingPOsition = " <<
             //                 fileWritingPosition << std::endl;
-            // TODO: is this seekg really necessary?
-            asyncFileChannel->seekg(fileWritingPosition);
-            asyncFileChannel->write(reinterpret_cast<char *>(headerArray.data()), bytesToWrite);
-            if (asyncFileChannel->fail()) {
-                throw EvioException("error writing to  file " + currentFileName);
-            }
+            writeTrailerBytes(bytesToWrite);
 
             //            asyncFileChannel->flush();
             //            std::cout << "After writing trailer to " + currentFileName << std::endl;
@@ -2928,11 +5249,9 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             throw EvioException("error writing to  file " + currentFileName);
         }
 
-        // Update file header's bit-info word
+        // Update file header's bit-info word, keeping its other bits
         if (addTrailerIndex) {
-            uint32_t bitInfo = fileHeader.setBitInfo(fileHeader.hasFirstEvent(),
-                                                     fileHeader.hasDictionary(),
-                                                     true);
+            uint32_t bitInfo = fileHeader.hasTrailerWithIndex(true);
             if (!byteOrder.isLocalEndian()) {
                 bitInfo = SWAP_32(bitInfo);
             }
@@ -2966,6 +5285,9 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             return;
         }
 
+        // Adaptive compression may have stored the last record uncompressed
+        currentRecord->getHeader()->setCompressionType(compressionType);
+
         // Do construction of record in buffer and possibly compression of its data
         if (commonRecord != nullptr) {
             currentRecord->build(*(commonRecord->getBinaryBuffer().get()));
@@ -3030,6 +5352,10 @@ std::cout << "toAppendPos:  fileSize = " << fileSize << ", jump to pos = " << fi
             eventsWrittenTotal++;
             eventsWrittenToBuffer++;
         }
+        // If using a buffer pool, go on in the next buffer, unless the event doesn't fit an empty one
+        else if (fullBufferCallback && currentRecord->getEventCount() > 0 && nextPoolBuffer()) {
+            return writeToBuffer(bank, bankBuffer);
+        }
 
         return fitInRecord;
     }
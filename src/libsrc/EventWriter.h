@@ -18,6 +18,7 @@
 #include <vector>
 #include <string>
 #include <queue>
+#include <deque>
 #include <chrono>
 #include <memory>
 #include <bitset>
@@ -25,6 +26,8 @@
 #include <atomic>
 #include <algorithm>
 #include <future>
+#include <mutex>
+#include <functional>
 
 #ifndef __APPLE__
     #include <experimental/filesystem>
@@ -38,8 +41,17 @@
 #include "RecordOutput.h"
 #include "RecordHeader.h"
 #include "Compressor.h"
+#include "SeekableCompression.h"
 #include "RecordSupply.h"
+#include "WriterMetrics.h"
+#include "ClosedFileInfo.h"
+#include "EventIndexFile.h"
+#include "SharedMemoryWriter.h"
+#include "MirrorWriter.h"
 #include "RecordCompressor.h"
+#include "CompressionExecutor.h"
+#include "WriterAutoTuner.h"
+#include "FileWriteBackend.h"
 #include "Util.h"
 #include "EvioException.h"
 #include "EvioBank.h"
@@ -214,6 +226,14 @@ namespace evio {
                 thd = boost::thread([this]() {this->run();});
             }
 
+            /**
+             * Restrict this thread, once started, to run only on the given CPUs (Linux only).
+             * @param cpus ids of CPUs this thread may run on.
+             */
+            void setAffinity(const std::vector<uint32_t> & cpus) {
+                Util::setThreadAffinity(thd.native_handle(), cpus);
+            }
+
             /** Stop the thread. */
             void stopThread() {
                 // Send signal to interrupt it
@@ -234,6 +254,16 @@ namespace evio {
                 stopThread();
             }
 
+            /**
+             * Wait for all items published so far to be processed, including any
+             * file split, leaving the thread running but idle.
+             */
+            void waitForPublishedItems() {
+                while (supply->getLastSequence() > lastSeqProcessed.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
             /**
              * Store the id of the record which is forcing a write to disk,
              * even if disk is "full".
@@ -251,7 +281,7 @@ namespace evio {
                 forceToDisk = true;
             }
 
-            std::shared_ptr<RecordRingItem> storeRecordCopy(std::shared_ptr<RecordRingItem> & rec) {
+            std::shared_ptr<RecordRingItem> storeRecordCopy(const std::shared_ptr<RecordRingItem> & rec) {
                 // Call copy constructor of RecordRingItem, then make into shared pointer
                 storedItem = std::make_shared<RecordRingItem>(*(rec.get()));
                 return storedItem;
@@ -264,22 +294,22 @@ namespace evio {
 
                     while (true) {
 
-                        // Get the next record for this thread to write
-                        // shared_ptr<RecordRingItem>
-                        auto item = supply->getToWrite();
+                        // Get the next record for this thread to write.
+                        // Refer to its slot in the ring instead of copying the shared pointer.
+                        const std::shared_ptr<RecordRingItem> & ringItem = supply->getToWrite();
+                        // Copy of item, written in its place, if disk was full
+                        std::shared_ptr<RecordRingItem> copiedItem = nullptr;
 
                         {
                             // Only allow interruption when blocked on trying to get item
                             boost::this_thread::disable_interruption d1;
 
-                            int64_t currentSeq = item->getSequence();
-                            // Pull record out of wrapping object
-                            auto record = item->getRecord();
+                            int64_t currentSeq = ringItem->getSequence();
 
                             // Only need to check the disk when writing the first record following
                             // a file split. That first write will create the file. If there isn't
                             // enough room, then flag will be set.
-                            bool checkDisk = item->isCheckDisk();
+                            bool checkDisk = ringItem->isCheckDisk();
 
                             // Check the disk before we try to write if about to create another file,
                             // we're told to check the disk, and we're not forcing to disk
@@ -312,12 +342,11 @@ namespace evio {
                                     std::this_thread::sleep_for(std::chrono::seconds(1));
 
                                     // If we released the item in a previous loop, don't do it again
-                                    if (!item->isAlreadyReleased()) {
+                                    if (copiedItem == nullptr) {
                                         // Copy item
-                                        auto copiedItem = storeRecordCopy(item);
+                                        copiedItem = storeRecordCopy(ringItem);
                                         // Release original so we don't block writeEvent()
-                                        supply->releaseWriter(item);
-                                        item = copiedItem;
+                                        supply->releaseWriter(ringItem);
                                     }
 
                                     // Wait until space opens up
@@ -327,6 +356,9 @@ namespace evio {
                                 // if there previously wasn't.
                             }
 
+                            // Write the copy if the original was released
+                            const std::shared_ptr<RecordRingItem> & item = (copiedItem != nullptr) ? copiedItem : ringItem;
+
                             // Do write
                             // Write current item to file
                             //cout << "EventWriter: Calling writeToFileMT(item)\n";
@@ -339,16 +371,15 @@ namespace evio {
                                 forceToDisk = false;
                             }
 
-                            // Now we're done with this sequence
-                            lastSeqProcessed = currentSeq;
-
                             // Split file if needed
                             if (item->splitFileAfterWrite()) {
                                 writer->splitFile();
                             }
 
-                            // Release back to supply
-                            supply->releaseWriter(item);
+                            // Now we're done with this sequence
+                            lastSeqProcessed = currentSeq;
+
+                            // Item is released back to supply once its write completes
                         }
                     }
                 }
@@ -373,9 +404,7 @@ namespace evio {
                 // Store quantities from exterior classes or store quantities that
                 // may change between when this object is created and when this thread is run.
                 std::shared_ptr<std::fstream> afChannel;
-                std::shared_ptr<std::future<void>> future;
-                std::shared_ptr<RecordSupply> supply;
-                std::shared_ptr<RecordRingItem> item;
+                std::shared_ptr<FileWriteBackend> fileWriter;
                 FileHeader fHeader;
                 std::shared_ptr<std::vector<uint32_t>> recLengths;
                 uint64_t bytesWrittenToFile;
@@ -384,6 +413,14 @@ namespace evio {
                 bool writeIndx;
                 bool noFileWriting;
                 ByteOrder byteOrder;
+                /** If not empty, name of file to truncate to fileLength once closed. */
+                std::string truncateName;
+                uint64_t fileLength;
+                /** Name of file, passed to fileClosed. */
+                std::string fileName;
+                uint32_t eventCount;
+                /** If set, called once file is closed. */
+                std::function<void(const ClosedFileInfo &)> fileClosed;
 
                 // A couple of things used to clean up after thread is done
                 FileCloser *closer;
@@ -401,19 +438,22 @@ namespace evio {
 
                 /** Constructor.  */
                 CloseAsyncFChan(std::shared_ptr<std::fstream> &afc,
-                                std::shared_ptr<std::future<void>> &future1,
-                                std::shared_ptr<RecordSupply> &supply,
-                                std::shared_ptr<RecordRingItem> &ringItem,
+                                std::shared_ptr<FileWriteBackend> &writer,
                                 FileHeader &fileHeader, std::shared_ptr<std::vector<uint32_t>> recordLengths,
                                 uint64_t bytesWritten, uint32_t recordNumber,
                                 bool addingTrailer, bool writeIndex, bool noWriting,
-                                ByteOrder &order, FileCloser *fc) :
+                                ByteOrder &order, std::string const & truncName, uint64_t length,
+                                std::string const & name, uint32_t events,
+                                std::function<void(const ClosedFileInfo &)> const & callback,
+                                FileCloser *fc) :
 
-                        afChannel(afc), future(future1), supply(supply),
-                        item(ringItem), byteOrder(order) {
+                        afChannel(afc), fileWriter(writer), byteOrder(order),
+                        truncateName(truncName), fileLength(length),
+                        fileName(name), eventCount(events), fileClosed(callback) {
 
                     fHeader            = fileHeader;
-                    recLengths         = recordLengths;
+                    // Copy since caller clears it for the next file
+                    recLengths         = std::make_shared<std::vector<uint32_t>>(*recordLengths);
                     bytesWrittenToFile = bytesWritten;
                     recordNum          = recordNumber;
                     addTrailer         = addingTrailer;
@@ -464,31 +504,87 @@ namespace evio {
                 }
 
                 void run() {
-                    // Finish writing to current file
-                    if (future != nullptr) {
+                    // When bypassing the page cache, the trailer follows the records through
+                    // the file writer, so it's closed after (see writeTrailerBytes).
+                    bool trailerThruWriter = fileWriter != nullptr && fileWriter->isDirect() &&
+                                             addTrailer && !noFileWriting;
+                    bool complete = true;
+                    bool trailerWritten = false;
+
+                    // Finish writing to current file, which releases resources back to the ring
+                    if (fileWriter != nullptr && !trailerThruWriter) {
                         try {
-                            // Wait for last write to end before we continue
-                            future->get();
+                            fileWriter->close();
+                        }
+                        catch (std::exception &e) {
+                            std::cout << e.what() << std::endl;
+                            complete = false;
                         }
-                        catch (std::exception &e) {}
                     }
 
-                    // Release resources back to the ring
-                    std::cout << "Closer: releaseWriterSequential, will release item seq = " << item->getSequence() << std::endl;
-                    supply->releaseWriterSequential(item);
-
                     try {
                         if (addTrailer && !noFileWriting) {
                             writeTrailerToFile();
+                            trailerWritten = true;
+                        }
+                    }
+                    catch (std::exception &e) {
+                        complete = false;
+                    }
+
+                    // In case writing trailer failed
+                    if (trailerThruWriter) {
+                        try {
+                            fileWriter->close();
                         }
+                        catch (std::exception &e) {}
                     }
-                    catch (std::exception &e) {}
 
                     try {
                         afChannel->close();
                     }
                     catch (std::exception &e) {
                         std::cout << e.what() << std::endl;
+                        complete = false;
+                    }
+
+                    // Give back disk space reserved but not used
+                    if (!truncateName.empty()) {
+                        try {
+                            FileWriteBackend::truncateFile(truncateName, fileLength);
+                        }
+                        catch (std::exception &e) {
+                            std::cout << e.what() << std::endl;
+                        }
+                    }
+
+                    // Header was updated after the file writer synced the rest
+                    if (fileWriter != nullptr && fileWriter->getDurability() != FileSyncer::NO_SYNC) {
+                        try {
+                            FileSyncer::syncFile(fileName);
+                        }
+                        catch (std::exception &e) {
+                            std::cout << e.what() << std::endl;
+                            complete = false;
+                        }
+                    }
+
+                    // File is sealed, let the user know
+                    if (fileClosed) {
+                        ClosedFileInfo info;
+                        info.fileName        = fileName;
+                        info.fileSize        = fileLength;
+                        info.eventCount      = eventCount;
+                        info.recordCount     = recordNum - 1;
+                        info.hasTrailer      = trailerWritten;
+                        info.hasTrailerIndex = trailerWritten && writeIndx;
+                        info.complete        = complete;
+                        try {
+                            fileClosed(info);
+                        }
+                        catch (std::exception &e) {
+                            std::cout << e.what() << std::endl;
+                        }
                     }
 
                     try {
@@ -499,6 +595,30 @@ namespace evio {
                 }
 
 
+                /**
+                 * Write the trailer in hdrArray to file. When bypassing the page cache,
+                 * it must go through the file writer, which is then closed so that
+                 * the header can be updated afterwards through afChannel.
+                 *
+                 * @param bytes    number of bytes in trailer.
+                 * @param position position of trailer in file.
+                 * @throws EvioException if problems writing to file.
+                 */
+                void writeTrailerBytes(size_t bytes, uint64_t position) {
+                    if (fileWriter != nullptr && fileWriter->isDirect()) {
+                        fileWriter->write(hdrArray, bytes, position, nullptr);
+                        fileWriter->close();
+                        return;
+                    }
+
+                    afChannel->seekg(position);
+                    afChannel->write(reinterpret_cast<char *>(hdrArray), bytes);
+                    if (afChannel->fail()) {
+                        throw EvioException("error writing to file");
+                    }
+                }
+
+
                 /**
                  * Write a general header as the last "header" or trailer in the file
                  * optionally followed by an index of all record lengths.
@@ -523,11 +643,7 @@ namespace evio {
                         }
                         catch (EvioException &e) {/* never happen */}
 
-                        afChannel->write(reinterpret_cast<char *>(hdrArray),
-                                         RecordHeader::HEADER_SIZE_BYTES);
-                        if (afChannel->fail()) {
-                            throw EvioException("error writing to file");
-                        }
+                        writeTrailerBytes(RecordHeader::HEADER_SIZE_BYTES, trailerPosition);
                     }
                     else {
                         // Write trailer with index
@@ -547,10 +663,7 @@ namespace evio {
                             RecordHeader::writeTrailer(hdrBuffer, (size_t)0, recordNum, recLengths);
                         }
                         catch (EvioException &e) {/* never happen */}
-                        afChannel->write(reinterpret_cast<char *>(hdrArray), bytesToWrite);
-                        if (afChannel->fail()) {
-                            throw EvioException("error writing to file");
-                        }
+                        writeTrailerBytes(bytesToWrite, trailerPosition);
                     }
 
                     // Update file header's trailer position word
@@ -599,16 +712,25 @@ namespace evio {
             /** Store all currently active closing threads. */
             std::vector<std::shared_ptr<CloseAsyncFChan>> threads;
 
+            /** Each closing thread removes itself from threads when done. */
+            std::mutex threadsMutex;
+
 
         public:
 
 
             /** Stop & delete every thread that was started. */
             void close() {
-                for (const std::shared_ptr<CloseAsyncFChan> & thread : threads) {
+                // Threads remove themselves from the vector, so don't iterate over it
+                std::vector<std::shared_ptr<CloseAsyncFChan>> stopping;
+                {
+                    std::lock_guard<std::mutex> lock(threadsMutex);
+                    stopping.swap(threads);
+                }
+
+                for (const std::shared_ptr<CloseAsyncFChan> & thread : stopping) {
                     thread->stopThread();
                 }
-                threads.clear();
             }
 
 
@@ -618,6 +740,7 @@ namespace evio {
              */
             void removeThread(std::shared_ptr<CloseAsyncFChan> & thread) {
                 // Look for this pointer among the shared pointers
+                std::lock_guard<std::mutex> lock(threadsMutex);
                 threads.erase(std::remove(threads.begin(), threads.end(), thread), threads.end());
             }
 
@@ -625,9 +748,7 @@ namespace evio {
              /**
               * Close the given file, in the order received, in a separate thread.
               * @param afc file channel to close
-              * @param future1
-              * @param supply
-              * @param ringItem
+              * @param writer backend writing records (and if bypassing page cache, trailer) to the file
               * @param fileHeader
               * @param recordLengths
               * @param bytesWritten
@@ -636,23 +757,34 @@ namespace evio {
               * @param writeIndex
               * @param noFileWriting
               * @param order
+              * @param truncateName if not empty, name of file to truncate once closed.
+              * @param fileLength length of file once closed.
+              * @param fileName name of file, handed to callback.
+              * @param eventCount number of events in file, handed to callback.
+              * @param callback if set, called from the closing thread once file is closed.
               */
             void closeAsyncFile( std::shared_ptr<std::fstream> &afc,
-                                 std::shared_ptr<std::future<void>> &future1,
-                                 std::shared_ptr<RecordSupply> &supply,
-                                 std::shared_ptr<RecordRingItem> &ringItem,
+                                 std::shared_ptr<FileWriteBackend> &writer,
                                  FileHeader &fileHeader, std::shared_ptr<std::vector<uint32_t>> &recordLengths,
                                  uint64_t bytesWritten, uint32_t recordNumber,
                                  bool addingTrailer, bool writeIndex, bool noFileWriting,
-                                 ByteOrder &order) {
+                                 ByteOrder &order, std::string const & truncateName = "",
+                                 uint64_t fileLength = 0, std::string const & fileName = "",
+                                 uint32_t eventCount = 0,
+                                 std::function<void(const ClosedFileInfo &)> const & callback = nullptr) {
 
-                auto a = std::make_shared<CloseAsyncFChan>(afc, future1, supply, ringItem,
+                auto a = std::make_shared<CloseAsyncFChan>(afc, writer,
                                                            fileHeader, recordLengths,
                                                            bytesWritten, recordNumber,
                                                            addingTrailer, writeIndex,
-                                                           noFileWriting, order, this);
+                                                           noFileWriting, order,
+                                                           truncateName, fileLength,
+                                                           fileName, eventCount, callback, this);
 
-                threads.push_back(a);
+                {
+                    std::lock_guard<std::mutex> lock(threadsMutex);
+                    threads.push_back(a);
+                }
                 a->setSharedPointerOfThis(a);
             }
 
@@ -685,7 +817,7 @@ namespace evio {
         uint32_t maxSupplyBytes = 0;
 
         /** Type of compression being done on data
-         *  (0=none, 1=LZ4fastest, 2=LZ4best, 3=gzip). */
+         *  (0=none, 1=LZ4fastest, 2=LZ4best, 3=gzip, 4=zstd). */
         Compressor::CompressionType compressionType{Compressor::UNCOMPRESSED};
 
         /** The estimated ratio of compressed to uncompressed data.
@@ -713,6 +845,10 @@ namespace evio {
         /** Threads used to compress data. */
         std::vector<RecordCompressor> recordCompressorThreads;
 
+        /** Are records compressed by the process-wide {@link CompressionExecutor}
+         *  instead of recordCompressorThreads? */
+        bool sharedCompression = false;
+
         /** Thread used to write data to file/buffer.
          *  Easier to use vector here so we don't have to construct it immediately. */
         std::vector<EventWriter::RecordWriter> recordWriterThread;
@@ -733,6 +869,15 @@ namespace evio {
         /** Byte array containing dictionary in evio format but <b>without</b> record header. */
         std::vector<uint8_t> dictionaryByteArray;
 
+        /** Byte array containing dictionary in binary form (see EvioBinaryDictionary), empty if none. */
+        std::vector<uint8_t> binaryDictionaryByteArray;
+
+        /** Trained dictionary the records are compressed with, null if none. */
+        std::shared_ptr<CompressionDictionary> compressionDictionary;
+
+        /** Byte array containing compressionDictionary as an event of the common record, empty if none. */
+        std::vector<uint8_t> compressionDictionaryByteArray;
+
         /** Byte array containing firstEvent in evio format but <b>without</b> record header. */
         std::vector<uint8_t> firstEventByteArray;
 
@@ -782,8 +927,7 @@ namespace evio {
          */
         std::shared_ptr<ByteBuffer> buffer;
 
-        /** Two internal buffers, first element last used in the future1 write,
-         * the second last used in future2 write. */
+        /** Internal buffer last handed to fileWriter, which may still be writing it. */
         std::shared_ptr<ByteBuffer> usedBuffer;
 
         /** Three internal buffers used for writing to a file. */
@@ -792,6 +936,15 @@ namespace evio {
         /** Number of bytes written to the current buffer for the common record. */
         uint32_t commonRecordBytesToBuffer = 0;
 
+        /** If set, each full buffer is handed to this and writing goes on in one of freeBuffers. */
+        std::function<void(std::shared_ptr<ByteBuffer> &)> fullBufferCallback;
+        /** Empty buffers to write into once the current one is full, when using a buffer pool. */
+        std::deque<std::shared_ptr<ByteBuffer>> freeBuffers;
+        /** Guards freeBuffers which are returned by other threads. */
+        std::mutex freeBuffersMutex;
+        /** Number of full buffers handed to fullBufferCallback. */
+        uint64_t buffersFilled = 0;
+
         /** Number of events written to final destination buffer or file's current record
          * NOT including dictionary (& first event?). */
         uint32_t eventsWrittenToBuffer = 0;
@@ -828,17 +981,190 @@ namespace evio {
         fs::path currentFilePath;
 #endif
 
-        /** Objects to allow efficient, asynchronous file writing. */
-        std::shared_ptr<std::future<void>> future1;
+        /** Object which writes records to the current file, asynchronously.
+         *  When a record's write is finished, its ring item is released - but not before! */
+        std::shared_ptr<FileWriteBackend> fileWriter;
+
+        /** Type of backend used to write records to file. */
+        FileWriteBackend::Type fileWriterType = FileWriteBackend::ASYNC;
+
+        /** Max number of record writes in flight at once. */
+        uint32_t fileWriterQueueDepth = 1;
+
+        /** Bypass the page cache when writing files (O_DIRECT)? */
+        bool fileWriterDirectIO = false;
+
+        /** Policy for forcing written files to disk. */
+        FileSyncer::Durability durability = FileSyncer::NO_SYNC;
+
+        /** With FileSyncer::GROUP_COMMIT, max milliseconds between syncs. */
+        uint32_t durabilityMillis = FileSyncer::DEFAULT_INTERVAL_MILLIS;
+
+        /** With FileSyncer::GROUP_COMMIT, max bytes written between syncs. */
+        uint64_t durabilityBytes = FileSyncer::DEFAULT_INTERVAL_BYTES;
+
+        /** Reserve disk space for each split file when it's created? */
+        bool preallocateSplits = false;
+
+        /** Create each split file ahead of time? */
+        bool preCreateSplits = false;
+
+        /** Was the current file created ahead of time? */
+        bool currentFilePreCreated = false;
+
+        /** Name of the next split file, being created ahead of time. */
+        std::string nextFileName;
+
+        /** Result of creating the next split file ahead of time, true if created. */
+        std::future<bool> nextFileCreated;
+
+        /** Max time, in milliseconds, events may wait in a partially filled record
+         *  before it's written to file. 0 means no limit. */
+        uint32_t maxRecordAge = 0;
+
+        /** Time the first event was placed into the current record, when limiting record age. */
+        std::chrono::steady_clock::time_point recordStartTime;
+
+        /** Guards the current record when it's written by recordAgeThread. */
+        std::mutex recordMutex;
+
+        /** Thread writing records once they're older than maxRecordAge. */
+        boost::thread recordAgeThread;
+
+        /** Time, in milliseconds, between looks at the free space of the file's disk partition
+         *  by diskMonitorThread. 0 means no monitor, so each check of the disk asks the OS. */
+        uint32_t diskCheckPeriod = 0;
+
+        /** Bytes which must be free on the file's disk partition
+         *  in addition to 1 full split and 1 full supply of records. */
+        uint64_t diskReserveBytes = 10000000;
+
+        /** Disk is full if more than this fraction of its partition is used. 0 means no limit. */
+        double diskHighWaterMark = 0.;
+
+        /** Free bytes in the file's disk partition at the monitor's last look. */
+        std::atomic<uint64_t> diskFreeBytes{0};
+
+        /** Total bytes in the file's disk partition at the monitor's last look. */
+        std::atomic<uint64_t> diskCapacityBytes{0};
+
+        /** Bytes written to file since the monitor's last look at the disk. */
+        std::atomic<uint64_t> bytesSinceDiskCheck{0};
+
+#ifndef __APPLE__
+        /** Directory of the file, whose disk partition the monitor looks at. */
+        fs::path diskMonitorDir;
+#endif
+
+        /** Thread periodically looking at the free space of the file's disk partition. */
+        boost::thread diskMonitorThread;
+
+        /** Adaptive compression: records whose compressed data are larger than this
+         *  fraction of their uncompressed data are stored uncompressed. 0 means off. */
+        float maxCompressionRatio = 0.F;
+
+        /** Store a filter of the tags and nums of its events in each record's header? */
+        bool tagFilter = false;
+
+        /** Store a CRC32C of its data in each record's header? */
+        bool checksum = false;
+
+        /** If set, finds the event timestamps whose range is stored in each record's header. */
+        RecordOutput::TimestampExtractor timestampExtractor;
+
+        /** If set, run on the events of each record before it is compressed. */
+        RecordOutput::RecordProcessor recordProcessor;
+
+        /** If not 0, uncompressed bytes in each block of seekable lz4 records. */
+        uint32_t seekableBlockSize = 0;
+
+        /** Filter applied to data of compressed records before compressing it. */
+        Compressor::PreFilter preFilter = Compressor::NO_FILTER;
 
-        /** RingItem1 is associated with future1, etc. When a write is finished,
-         * the associated ring item need to be released - but not before! */
-        std::shared_ptr<RecordRingItem> ringItem1;
+        /** Are banks of compressed records grouped by column? */
+        bool columnLayout = false;
 
-        /** Index for selecting which future (1 or 2) to use for next file write. */
-        uint32_t futureIndex = 0;
+        /** Lengths of the events in the batch being written by writeEvents(). */
+        std::vector<uint32_t> batchLengths;
 
-        /** The asynchronous file channel, used for writing a file. */
+        /** Offsets of the events in the array of the batch being written by writeEvents(). */
+        std::vector<size_t> batchOffsets;
+
+        /** Called with current metrics as records are written and files are split. */
+        std::function<void(const WriterMetrics &)> metricsCallback;
+        /** Number of records written between calls to metricsCallback. */
+        uint32_t metricsInterval = 100;
+        /** Number of records written since metricsCallback was last called. */
+        uint32_t recordsSinceMetrics = 0;
+
+        /** Called from the closing thread each time a file is completely written and closed. */
+        std::function<void(const ClosedFileInfo &)> fileClosedCallback;
+
+        /** Compression and write values when compressing in the calling thread. */
+        WriterMetrics singleThreadMetrics;
+        /** Sizes of events added and fill of records built, counted by all records. */
+        RecordFillStats fillStats;
+        /** Thread adjusting compression threads and record size, null if not auto-tuning. */
+        std::unique_ptr<WriterAutoTuner> autoTuner;
+        /** Time spent compressing in the calling thread, in nanoseconds. */
+        uint64_t singleThreadCompressNanos = 0;
+        /** Time spent writing records in the calling thread, in nanoseconds. */
+        uint64_t singleThreadWriteNanos = 0;
+
+        /** Index of the records and events in the current file, saved to a sidecar
+         *  file when it's closed. Null if not writing a sidecar index. */
+        std::shared_ptr<EventIndexFile> sidecarIndex = nullptr;
+
+        /** Local consumers which are handed each record written, null if none. */
+        std::shared_ptr<SharedMemoryWriter> sharedMemoryWriter = nullptr;
+
+        /** Other directories or sockets each file is copied to, empty if none. */
+        std::vector<std::shared_ptr<MirrorWriter>> mirrors;
+
+        /** Bytes of each buffer in which the chunks of a streamed event are gathered. */
+        static const size_t STREAMED_EVENT_BUFFER_BYTES = 4*1024*1024;
+
+        /** Is an event being written in chunks, see {@link #beginStreamedEvent}? */
+        bool streamingEvent = false;
+
+        /** Length in bytes of the streamed event given when begun, 0 if found once ended. */
+        uint32_t streamedEventBytes = 0;
+
+        /** Bytes of the streamed event appended so far. */
+        uint64_t streamedBytesAppended = 0;
+
+        /** Bytes of the streamed event's record handed to fileWriter so far. */
+        uint64_t streamedBytesWritten = 0;
+
+        /** File position of the streamed event's record. */
+        uint64_t streamedRecordPosition = 0;
+
+        /** Record number of the streamed event's record. */
+        uint32_t streamedRecordNumber = 0;
+
+        /** First 2 words of the streamed event, its bank header. */
+        uint8_t streamedEventHeader[8] = {};
+
+        /** Header and index of the streamed event's record, followed by the event's first word. */
+        std::vector<uint8_t> streamedRecordStart;
+
+        /** Two buffers in which chunks of a streamed event are gathered,
+         *  one being written to file while the other is filled. */
+        std::vector<uint8_t> streamBuffers[2];
+
+        /** Index of the streaming buffer being filled. */
+        uint32_t streamBufferIndex = 0;
+
+        /** Bytes in the streaming buffer being filled. */
+        size_t streamBufferFill = 0;
+
+        /** Buffers which records are written from, registered with each fileWriter. */
+        std::vector<std::shared_ptr<ByteBuffer>> fileWriterBuffers;
+
+        /** Parts of the record being written, see {@link RecordOutput#getSegments}. */
+        std::vector<ByteBufferView> fileWriterSegments;
+
+        /** The file channel, used for writing file headers and trailers and for reading when appending. */
         std::shared_ptr<std::fstream> asyncFileChannel = nullptr;
 
         /** The location of the next write in the file. */
@@ -877,6 +1203,15 @@ namespace evio {
         /** Track events written to help split a file. */
         uint32_t splitEventCount = 0;
 
+        /** If &gt; 0, split the file once it holds this many events. */
+        uint32_t splitEvents = 0;
+
+        /** If &gt; 0, split the file once this many seconds have passed since it was started. */
+        uint32_t splitSeconds = 0;
+
+        /** Time at which events started going into the current split file. */
+        std::chrono::steady_clock::time_point splitStartTime = std::chrono::steady_clock::now();
+
         /**
          * Id of this specific data stream.
          * In CODA, a data stream is a chain of ROCS and EBs ending in a single specific ER.
@@ -938,7 +1273,9 @@ namespace evio {
                     const ByteOrder & byteOrder, const std::string & xmlDictionary, bool overWriteOK,
                     bool append, std::shared_ptr<EvioBank> firstEvent, uint32_t streamId, uint32_t splitNumber,
                     uint32_t splitIncrement, uint32_t streamCount, Compressor::CompressionType compressionType,
-                    uint32_t compressionThreads, uint32_t ringSize, uint32_t bufferSize);
+                    uint32_t compressionThreads, uint32_t ringSize, uint32_t bufferSize,
+                    RecordSupply::WaitStrategyType waitStrategy = RecordSupply::SPIN_THEN_BLOCK,
+                    uint32_t waitTimeout = 0);
 
         //---------------------------------------------
         // BUFFER Constructors
@@ -950,13 +1287,17 @@ namespace evio {
                     const std::string & xmlDictionary, uint32_t recordNumber, std::shared_ptr<EvioBank> const & firstEvent,
                     Compressor::CompressionType compressionType);
 
+        ~EventWriter();
+
     private:
 
         void reInitializeBuffer(std::shared_ptr<ByteBuffer> & buf, const std::bitset<24> *bitInfo,
                                 uint32_t recordNumber, bool useCurrentBitInfo);
 
-        static void staticWriteFunction(EventWriter *pWriter, const char* data, size_t len);
-        static void staticDoNothingFunction(EventWriter *pWriter);
+        void createFileWriter();
+        void openNewFile();
+        void preCreateNextFile();
+        uint64_t closedFileLength() const;
 
     public:
 
@@ -964,6 +1305,11 @@ namespace evio {
         void setBuffer(std::shared_ptr<ByteBuffer> & buf, std::bitset<24> *bitInfo, uint32_t recNumber);
         void setBuffer(std::shared_ptr<ByteBuffer> & buf);
 
+        void setBufferPool(const std::function<void(std::shared_ptr<ByteBuffer> &)> & callback);
+        void addFreeBuffer(std::shared_ptr<ByteBuffer> const & buf);
+        size_t getFreeBufferCount();
+        uint64_t getBuffersFilled() const;
+
     private:
 
         std::shared_ptr<ByteBuffer> getBuffer();
@@ -989,6 +1335,78 @@ namespace evio {
 
         void setStartingRecordNumber(uint32_t startingRecordNumber);
 
+        void setFileWriteBackend(FileWriteBackend::Type type, uint32_t queueDepth,
+                                 bool directIO = false);
+        FileWriteBackend::Type getFileWriteBackendType() const;
+        uint32_t getFileWriteQueueDepth() const;
+        bool isDirectIO() const;
+
+        void setDurability(FileSyncer::Durability policy,
+                           uint32_t intervalMillis = FileSyncer::DEFAULT_INTERVAL_MILLIS,
+                           uint64_t intervalBytes  = FileSyncer::DEFAULT_INTERVAL_BYTES);
+        FileSyncer::Durability getDurability() const;
+        uint64_t getDurableOffset() const;
+
+        void setSplitPreallocation(bool preallocate, bool preCreate = false);
+        bool isPreallocatingSplits() const;
+        bool isPreCreatingSplits() const;
+
+        void setMaxRecordAge(uint32_t millisec);
+        uint32_t getMaxRecordAge() const;
+        void setAutoTune(bool tune, const AutoTuneConfig & config = AutoTuneConfig());
+        bool getAutoTune() const;
+
+        void setDiskSpaceMonitor(uint32_t millisec);
+        uint32_t getDiskSpaceMonitorPeriod() const;
+        void setDiskSpaceThresholds(uint64_t reserveBytes, double highWaterMark = 0.);
+        uint64_t getDiskReserveBytes() const;
+        double getDiskHighWaterMark() const;
+
+        void setAdaptiveCompression(float maxRatio, uint32_t fillLevel = 0);
+        float getMaxCompressionRatio() const;
+        void setTagFilter(bool filter);
+        bool getTagFilter() const;
+        void setChecksum(bool sum);
+        bool getChecksum() const;
+        void setTimestampExtractor(RecordOutput::TimestampExtractor extractor);
+        void setTimestampTag(uint16_t tag);
+        void setRecordProcessor(RecordOutput::RecordProcessor processor);
+        void setSeekableCompression(uint32_t blockSize = SeekableCompression::DEFAULT_BLOCK_SIZE);
+        uint32_t getSeekableCompression() const;
+        void setPreFilter(Compressor::PreFilter filter);
+        Compressor::PreFilter getPreFilter() const;
+        void setColumnLayout(bool byColumn);
+        bool getColumnLayout() const;
+        void setCompressionDictionary(std::vector<uint8_t> const & dictionary);
+        std::shared_ptr<CompressionDictionary> getCompressionDictionary() const;
+
+        void setThreadAffinity(const std::vector<std::vector<uint32_t>> & compressorCpus,
+                               const std::vector<uint32_t> & writerCpus,
+                               bool numaLocalRecords = false);
+
+        uint64_t getProducerWaitTime() const;
+        uint64_t getCompressWaitTime() const;
+        uint64_t getWriteWaitTime() const;
+
+        WriterMetrics getMetrics() const;
+        void setMetricsCallback(const std::function<void(const WriterMetrics &)> & callback,
+                                uint32_t recordInterval = 100);
+
+        void setSidecarIndex(bool write, bool withTags = false);
+        bool isWritingSidecarIndex() const;
+
+        void setSharedMemoryWriter(std::shared_ptr<SharedMemoryWriter> & writer);
+        std::shared_ptr<SharedMemoryWriter> getSharedMemoryWriter() const;
+
+        void addMirror(std::shared_ptr<MirrorWriter> const & mirror);
+        std::vector<std::shared_ptr<MirrorWriter>> const & getMirrors() const;
+
+        void setSplitEventCount(uint32_t events);
+        uint32_t getSplitEventCount() const;
+        void setSplitTime(uint32_t seconds);
+        uint32_t getSplitTime() const;
+        void setFileClosedCallback(const std::function<void(const ClosedFileInfo &)> & callback);
+
         void setFirstEvent(std::shared_ptr<EvioNode> & node);
         void setFirstEvent(std::shared_ptr<ByteBuffer> & buf);
         void setFirstEvent(std::shared_ptr<EvioBank> bank);
@@ -1015,6 +1433,15 @@ namespace evio {
     private:
 
         void toAppendPosition();
+        bool appendAtTrailer(uint64_t fileSize);
+        void flushToFile(bool force);
+        std::unique_lock<std::mutex> lockCurrentRecord();
+        void runRecordAgeTimer(uint32_t millisec);
+        void stopRecordAgeTimer();
+        void lookAtDisk();
+        bool tooLittleSpace(uint64_t freeBytes, uint64_t capacity) const;
+        void runDiskMonitor(uint32_t millisec);
+        void stopDiskMonitor();
 
     public:
 
@@ -1026,12 +1453,32 @@ namespace evio {
 
         bool writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer);
         bool writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer, bool force);
+        bool writeEvent(ByteBufferView const & event, bool force = false);
 
         bool writeEvent(std::shared_ptr<EvioBank> bank);
         bool writeEvent(std::shared_ptr<EvioBank> bank, bool force);
 
+        bool writeEvent(GatheredEvent const & event, bool force = false);
+
+        uint32_t writeEvents(const std::vector<std::shared_ptr<ByteBuffer>> & bankBuffers, bool force = false);
+        uint32_t writeEvents(const std::vector<std::shared_ptr<EvioNode>> & nodes, bool force = false);
+        uint32_t writeEvents(const std::vector<std::shared_ptr<EvioBank>> & banks, bool force = false);
+        uint32_t writeEvents(const uint8_t *events, const uint32_t *eventLens, uint32_t count,
+                             ByteOrder const & order, bool force = false);
+
+        void beginStreamedEvent(uint32_t bytes = 0);
+        void appendToStreamedEvent(const uint8_t *data, size_t bytes);
+        void endStreamedEvent(bool force = false);
+        bool isStreamingEvent() const;
+
     private:
 
+        void buildStreamedRecordStart(uint32_t eventBytes);
+        void stageStreamedBytes(const uint8_t *data, size_t bytes);
+        void writeStreamBuffer();
+
+        uint32_t writeEventsToFile(const std::function<uint32_t(size_t, size_t)> & addToRecord, bool force);
+
         bool writeEvent(std::shared_ptr<EvioBank> bank,
                         std::shared_ptr<ByteBuffer> bankBuffer, bool force);
         bool writeEventToFile(std::shared_ptr<EvioBank> bank,
@@ -1039,16 +1486,22 @@ namespace evio {
 
         bool fullDisk();
 
+        void buildCurrentRecord();
+        void reportMetrics(bool fileSplit);
+        void writeSidecarIndex();
         void compressAndWriteToFile(bool force);
         bool tryCompressAndWriteToFile(bool force);
 
         bool writeToFile(bool force, bool checkDisk);
-        void writeToFileMT(std::shared_ptr<RecordRingItem> & item, bool force);
+        void writeToFileMT(const std::shared_ptr<RecordRingItem> & item, bool force);
 
         void splitFile();
+        bool splitLimitReached(uint32_t eventCount) const;
+        void writeTrailerBytes(size_t bytes);
         void writeTrailerToFile(bool writeIndex);
         void flushCurrentRecordToBuffer() ;
         bool writeToBuffer(std::shared_ptr<EvioBank> & bank, std::shared_ptr<ByteBuffer> & bankBuffer) ;
+        bool nextPoolBuffer();
 
         uint32_t trailerBytes();
         void writeTrailerToBuffer(bool writeIndex);
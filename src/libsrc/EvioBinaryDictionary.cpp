@@ -0,0 +1,730 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "EvioBinaryDictionary.h"
+
+
+#include <cstring>
+#include <algorithm>
+#include <tuple>
+
+
+namespace evio {
+
+
+    const uint32_t EvioBinaryDictionary::MAGIC;
+    const uint32_t EvioBinaryDictionary::VERSION;
+
+
+    /**
+     * Constructor using the bytes of a binary dictionary as they are, without copying,
+     * if they're local endian and 4-byte aligned. In that case the bytes must not change
+     * or go away while this object is used. Otherwise they're copied.
+     *
+     * @param data start of binary dictionary.
+     * @param len  number of bytes available.
+     * @throws EvioException if data is not a valid binary dictionary.
+     */
+    EvioBinaryDictionary::EvioBinaryDictionary(const uint8_t *data, size_t len) {
+        init(data, len);
+    }
+
+
+    /**
+     * Constructor which keeps the given bytes of a binary dictionary.
+     *
+     * @param data binary dictionary.
+     * @throws EvioException if data is not a valid binary dictionary.
+     */
+    EvioBinaryDictionary::EvioBinaryDictionary(std::vector<uint8_t> data) : ownedData(std::move(data)) {
+        init(ownedData.data(), ownedData.size());
+    }
+
+
+    /**
+     * Do the given bytes start with the header of a binary dictionary, in either byte order?
+     * @param data start of bytes.
+     * @param len  number of bytes.
+     * @return true if data looks like a binary dictionary.
+     */
+    bool EvioBinaryDictionary::isBinaryDictionary(const uint8_t *data, size_t len) {
+        if (data == nullptr || len < 4*HEADER_WORDS) return false;
+        uint32_t word;
+        std::memcpy(&word, data, 4);
+        return (word == MAGIC || SWAP_32(word) == MAGIC);
+    }
+
+
+    /**
+     * Check the layout of a binary dictionary and find its parts.
+     * @param data start of binary dictionary.
+     * @param len  number of bytes available.
+     * @throws EvioException if data is not a valid binary dictionary.
+     */
+    void EvioBinaryDictionary::init(const uint8_t *data, size_t len) {
+
+        if (!isBinaryDictionary(data, len)) {
+            throw EvioException("not a binary dictionary");
+        }
+
+        uint32_t first;
+        std::memcpy(&first, data, 4);
+        bool swap = (first != MAGIC);
+
+        // Words must be local endian and aligned to be used in place
+        bool haveCopy = (data == ownedData.data());
+        if (!haveCopy && (swap || (reinterpret_cast<uintptr_t>(data) & 3) != 0)) {
+            ownedData.assign(data, data + len);
+            data = ownedData.data();
+        }
+
+        auto *w = reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(data));
+
+        if (swap) {
+            for (uint32_t i = 0; i < HEADER_WORDS; i++) {
+                w[i] = SWAP_32(w[i]);
+            }
+        }
+
+        if (w[1] != VERSION) {
+            throw EvioException("binary dictionary version " + std::to_string(w[1]) + " not supported");
+        }
+
+        uint32_t totalBytes = w[2];
+        entryCount    = w[3];
+        slotCount     = w[4];
+        rangeCount    = w[5];
+        nameSlotCount = w[6];
+        stringBytes   = w[7];
+
+        uint64_t wordCount = HEADER_WORDS + (uint64_t)entryCount*ENTRY_WORDS + (uint64_t)slotCount*SLOT_WORDS +
+                             (uint64_t)rangeCount*RANGE_WORDS + nameSlotCount;
+
+        if (totalBytes > len || 4*wordCount + stringBytes > totalBytes) {
+            throw EvioException("binary dictionary too small");
+        }
+        if ((slotCount & (slotCount - 1)) != 0 || (nameSlotCount & (nameSlotCount - 1)) != 0 ||
+            (entryCount > 0 && (slotCount == 0 || nameSlotCount == 0))) {
+            throw EvioException("binary dictionary has bad hash tables");
+        }
+
+        if (swap) {
+            for (uint64_t i = HEADER_WORDS; i < wordCount; i++) {
+                w[i] = SWAP_32(w[i]);
+            }
+        }
+
+        words     = w;
+        entries   = words + HEADER_WORDS;
+        slots     = entries + entryCount*ENTRY_WORDS;
+        ranges    = slots + slotCount*SLOT_WORDS;
+        nameSlots = ranges + rangeCount*RANGE_WORDS;
+        strings   = reinterpret_cast<const char *>(nameSlots + nameSlotCount);
+
+        // Make sure nothing points outside of the data
+        for (uint32_t i = 0; i < entryCount; i++) {
+            const uint32_t *e = entries + i*ENTRY_WORDS;
+            for (int j = 4; j < 10; j += 2) {
+                if ((uint64_t)e[j] + e[j+1] > stringBytes) {
+                    throw EvioException("binary dictionary has bad string");
+                }
+            }
+        }
+        for (uint32_t i = 0; i < slotCount; i++) {
+            const uint32_t *s = slots + i*SLOT_WORDS;
+            if ((uint64_t)s[2] + s[3] > entryCount) {
+                throw EvioException("binary dictionary has bad hash table");
+            }
+        }
+        for (uint32_t i = 0; i < rangeCount; i++) {
+            if (ranges[i*RANGE_WORDS + 2] >= entryCount) {
+                throw EvioException("binary dictionary has bad range");
+            }
+        }
+        for (uint32_t i = 0; i < nameSlotCount; i++) {
+            if (nameSlots[i] > entryCount) {
+                throw EvioException("binary dictionary has bad name table");
+            }
+        }
+    }
+
+
+    /**
+     * Write the given dictionary in binary form.
+     *
+     * @param dictionary dictionary to encode.
+     * @param out        vector which gets filled with binary dictionary.
+     * @param order      byte order to write in.
+     * @throws EvioException if dictionary has too many entries or strings are too long.
+     */
+    void EvioBinaryDictionary::encode(EvioXMLDictionary const & dictionary, std::vector<uint8_t> & out,
+                                      ByteOrder const & order) {
+
+        // Key, entry, name, and whether it's from tagRangeMap
+        typedef std::tuple<uint64_t, std::shared_ptr<EvioDictionaryEntry>, std::string, bool> Item;
+        std::vector<Item> items;
+        items.reserve(dictionary.tagNumMap.size() + dictionary.tagOnlyMap.size() + dictionary.tagRangeMap.size());
+
+        auto addMap = [&items](std::unordered_map<std::shared_ptr<EvioDictionaryEntry>, std::string> const & map,
+                               bool isRangeMap) {
+            for (auto const & m : map) {
+                Key k = makeKey(m.first->getTag(), m.first->getNum(), m.first->getTagEnd(), m.first->isNumValid());
+                items.emplace_back(packKey(k), m.first, m.second, isRangeMap);
+            }
+        };
+        addMap(dictionary.tagNumMap, false);
+        addMap(dictionary.tagOnlyMap, false);
+        addMap(dictionary.tagRangeMap, true);
+
+        // Put entries differing only in their parents next to each other
+        std::stable_sort(items.begin(), items.end(),
+                         [](Item const & a, Item const & b) {return std::get<0>(a) < std::get<0>(b);});
+
+        auto count = (uint32_t) items.size();
+        uint32_t slots = 0, nameSlots = 0;
+        if (count > 0) {
+            // Tables are at most half full
+            slots = nameSlots = 16;
+            while (slots < 2*count) slots <<= 1;
+            nameSlots = slots;
+        }
+
+        std::vector<uint32_t> entryWords, slotWords(slots*SLOT_WORDS, 0), rangeWords, nameWords(nameSlots, 0);
+        entryWords.reserve(count*ENTRY_WORDS);
+        std::string str;
+
+        auto addString = [&str](std::string const & s, std::vector<uint32_t> & dest) {
+            dest.push_back((uint32_t) str.size());
+            dest.push_back((uint32_t) s.size());
+            str.append(s);
+        };
+
+        std::vector<std::tuple<uint16_t, uint16_t, uint32_t>> rangeList;
+
+        for (uint32_t i = 0; i < count; i++) {
+            auto const & entry = std::get<1>(items[i]);
+            auto const & name  = std::get<2>(items[i]);
+            auto parent = entry->getParentEntry();
+
+            uint32_t flags = (entry->isNumValid() ? 1 : 0) | ((uint32_t)entry->getEntryType() << 1);
+            uint32_t parentWord = 0;
+            if (parent != nullptr) {
+                flags |= 8;
+                if (parent->isNumValid()) flags |= 16;
+                parentWord = parent->getTag() | ((uint32_t)parent->getTagEnd() << 16);
+            }
+
+            entryWords.push_back(entry->getTag() | ((uint32_t)entry->getTagEnd() << 16));
+            entryWords.push_back(entry->getNum() | (flags << 8) |
+                                 ((uint32_t)(parent != nullptr ? parent->getNum() : 0) << 16));
+            entryWords.push_back(parentWord);
+            entryWords.push_back(entry->getType().getValue());
+            addString(name, entryWords);
+            addString(entry->getDescription(), entryWords);
+            addString(entry->getFormat(), entryWords);
+
+            if (std::get<3>(items[i])) {
+                rangeList.emplace_back(entry->getTag(), entry->getTagEnd(), i);
+            }
+
+            // Name table
+            size_t ns = hashName(name.data(), name.size()) & (nameSlots - 1);
+            bool dup = false;
+            while (nameWords[ns] != 0) {
+                if (std::get<2>(items[nameWords[ns] - 1]) == name) {dup = true; break;}
+                ns = (ns + 1) & (nameSlots - 1);
+            }
+            if (!dup) nameWords[ns] = i + 1;
+
+            // Key table, once for each group of equal keys
+            uint64_t key = std::get<0>(items[i]);
+            if (i > 0 && std::get<0>(items[i-1]) == key) continue;
+
+            uint32_t same = 1;
+            while (i + same < count && std::get<0>(items[i + same]) == key) same++;
+
+            size_t s = slotOf(key, slots - 1);
+            while (slotWords[s*SLOT_WORDS + 3] != 0) {
+                s = (s + 1) & (slots - 1);
+            }
+            slotWords[s*SLOT_WORDS]     = (uint32_t) key;
+            slotWords[s*SLOT_WORDS + 1] = (uint32_t) (key >> 32);
+            slotWords[s*SLOT_WORDS + 2] = i;
+            slotWords[s*SLOT_WORDS + 3] = same;
+        }
+
+        // Ranges sorted by starting tag, with the largest tagEnd so far
+        std::stable_sort(rangeList.begin(), rangeList.end(),
+                         [](std::tuple<uint16_t, uint16_t, uint32_t> const & a,
+                            std::tuple<uint16_t, uint16_t, uint32_t> const & b) {
+                             return std::get<0>(a) < std::get<0>(b);
+                         });
+        uint16_t maxTagEnd = 0;
+        for (auto const & r : rangeList) {
+            maxTagEnd = std::max(maxTagEnd, std::get<1>(r));
+            rangeWords.push_back(std::get<0>(r) | ((uint32_t)std::get<1>(r) << 16));
+            rangeWords.push_back(maxTagEnd);
+            rangeWords.push_back(std::get<2>(r));
+        }
+
+        // Pad strings to 4 bytes
+        while (str.size() % 4) str.push_back('\0');
+
+        size_t wordCount = HEADER_WORDS + entryWords.size() + slotWords.size() + rangeWords.size() + nameWords.size();
+        size_t totalBytes = 4*wordCount + str.size();
+        if (totalBytes > UINT32_MAX) {
+            throw EvioException("dictionary too big for binary form");
+        }
+
+        std::vector<uint32_t> all;
+        all.reserve(wordCount);
+        all.push_back(MAGIC);
+        all.push_back(VERSION);
+        all.push_back((uint32_t) totalBytes);
+        all.push_back(count);
+        all.push_back(slots);
+        all.push_back((uint32_t) rangeList.size());
+        all.push_back(nameSlots);
+        all.push_back((uint32_t) str.size());
+        all.insert(all.end(), entryWords.begin(), entryWords.end());
+        all.insert(all.end(), slotWords.begin(),  slotWords.end());
+        all.insert(all.end(), rangeWords.begin(), rangeWords.end());
+        all.insert(all.end(), nameWords.begin(),  nameWords.end());
+
+        if (!order.isLocalEndian()) {
+            for (auto & word : all) word = SWAP_32(word);
+        }
+
+        out.resize(totalBytes);
+        std::memcpy(out.data(), all.data(), 4*all.size());
+        std::memcpy(out.data() + 4*all.size(), str.data(), str.size());
+    }
+
+
+    /**
+     * Make the key of a dictionary entry without a parent. This does what the
+     * EvioDictionaryEntry constructor does: a tagEnd of 0 or equal to tag means no range,
+     * and the lower of tag and tagEnd becomes tag.
+     *
+     * @param tag      tag.
+     * @param num      num.
+     * @param tagEnd   tagEnd.
+     * @param numValid is num used?
+     * @return key.
+     */
+    EvioBinaryDictionary::Key EvioBinaryDictionary::makeKey(uint16_t tag, uint8_t num, uint16_t tagEnd, bool numValid) {
+        Key k {};
+        bool isRange = !(tagEnd == tag || tagEnd == 0);
+        k.tag    = isRange ? std::min(tag, tagEnd) : tag;
+        k.tagEnd = isRange ? std::max(tag, tagEnd) : 0;
+        k.num = numValid ? num : 0;
+        k.numValid = numValid;
+        if (isRange) {
+            k.entryType = EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE;
+        }
+        else if (numValid) {
+            k.entryType = EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM;
+        }
+        else {
+            k.entryType = EvioDictionaryEntry::EvioDictionaryEntryType::TAG_ONLY;
+        }
+        return k;
+    }
+
+
+    /**
+     * Pack the values which make entries equal, except for parents, into one value.
+     * @param key key.
+     * @return packed key, never 0.
+     */
+    uint64_t EvioBinaryDictionary::packKey(Key const & key) {
+        uint64_t k = (uint64_t)key.tag | ((uint64_t)key.tagEnd << 16);
+        if (key.numValid) {
+            k |= ((uint64_t)key.num << 32) | (1ULL << 40);
+        }
+        k |= ((uint64_t)key.entryType + 1) << 41;
+        return k;
+    }
+
+
+    /**
+     * Get the hash table slot in which to start looking for a packed key.
+     * @param key  packed key.
+     * @param mask number of slots - 1.
+     * @return slot index.
+     */
+    size_t EvioBinaryDictionary::slotOf(uint64_t key, size_t mask) {
+        uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+        return (size_t)(h ^ (h >> 29)) & mask;
+    }
+
+
+    /**
+     * 32-bit FNV-1a hash of a name.
+     * @param name name.
+     * @param len  number of characters in name.
+     * @return hash.
+     */
+    uint32_t EvioBinaryDictionary::hashName(const char *name, size_t len) {
+        uint32_t h = 2166136261U;
+        for (size_t i = 0; i < len; i++) {
+            h ^= (uint8_t)name[i];
+            h *= 16777619U;
+        }
+        return h;
+    }
+
+
+    /**
+     * Find the first entry with the same tag, num, and tagEnd as the key.
+     * If the key has a parent, an entry with a different parent does not match.
+     * @param key key to look for.
+     * @return entry, or null if none.
+     */
+    const uint32_t * EvioBinaryDictionary::findKey(Key const & key) const {
+        if (slotCount == 0) return nullptr;
+
+        uint64_t packed = packKey(key);
+        size_t mask = slotCount - 1;
+        size_t s = slotOf(packed, mask);
+
+        while (slots[s*SLOT_WORDS + 3] != 0) {
+            const uint32_t *slot = slots + s*SLOT_WORDS;
+            if (slot[0] == (uint32_t)packed && slot[1] == (uint32_t)(packed >> 32)) {
+                for (uint32_t i = slot[2]; i < slot[2] + slot[3]; i++) {
+                    const uint32_t *e = entries + i*ENTRY_WORDS;
+                    uint32_t flags = (e[1] >> 8) & 0xff;
+                    if (!key.parentValid || !(flags & 8)) {
+                        return e;
+                    }
+                    bool pNumValid = (flags & 16) != 0;
+                    if ((e[2] & 0xffff) == key.pTag && (e[2] >> 16) == key.pTagEnd &&
+                        pNumValid == key.pNumValid && (!pNumValid || (e[1] >> 16) == key.pNum)) {
+                        return e;
+                    }
+                }
+                return nullptr;
+            }
+            s = (s + 1) & mask;
+        }
+        return nullptr;
+    }
+
+
+    /**
+     * Find an entry whose tag range holds the given tag.
+     * @param tag tag to look for.
+     * @return entry, or null if none.
+     */
+    const uint32_t * EvioBinaryDictionary::findInRange(uint16_t tag) const {
+        // Find first range starting after tag
+        uint32_t lo = 0, hi = rangeCount;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi)/2;
+            if ((ranges[mid*RANGE_WORDS] & 0xffff) <= tag) lo = mid + 1;
+            else hi = mid;
+        }
+
+        // Go back through those starting at or before tag while one might still reach it
+        while (lo > 0) {
+            const uint32_t *r = ranges + (--lo)*RANGE_WORDS;
+            if (r[1] < tag) break;
+            if ((r[0] >> 16) >= tag) return entries + r[2]*ENTRY_WORDS;
+        }
+        return nullptr;
+    }
+
+
+    /**
+     * Find the entry matching the key. If key is a tag/num pair, a search is made for an
+     * entry of the tag/num pair, then of the tag only, then of a tag range holding the tag.
+     * If key is a tag only, the search starts with the tag only. If key is a tag range,
+     * only an entry of the identical range is found. The key's parent is used only for the first try.
+     *
+     * @param key key to look for.
+     * @return entry, or null if none.
+     */
+    const uint32_t * EvioBinaryDictionary::lookup(Key const & key) const {
+
+        if (key.entryType == EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE) {
+            return findKey(key);
+        }
+
+        const uint32_t *e = findKey(key);
+        if (e != nullptr) return e;
+
+        if (key.entryType == EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM) {
+            e = findKey(makeKey(key.tag, 0, 0, false));
+            if (e != nullptr) return e;
+        }
+
+        return findInRange(key.tag);
+    }
+
+
+    /**
+     * Find the entry with the given name.
+     * @param name name.
+     * @return entry, or null if none.
+     */
+    const uint32_t * EvioBinaryDictionary::findName(std::string const & name) const {
+        if (nameSlotCount == 0) return nullptr;
+
+        size_t mask = nameSlotCount - 1;
+        size_t s = hashName(name.data(), name.size()) & mask;
+
+        while (nameSlots[s] != 0) {
+            const uint32_t *e = entries + (nameSlots[s] - 1)*ENTRY_WORDS;
+            if (e[5] == name.size() && std::memcmp(strings + e[4], name.data(), e[5]) == 0) {
+                return e;
+            }
+            s = (s + 1) & mask;
+        }
+        return nullptr;
+    }
+
+
+    /**
+     * Get a string from the string section.
+     * @param offset offset of string.
+     * @param length length of string.
+     * @return string.
+     */
+    std::string EvioBinaryDictionary::getString(uint32_t offset, uint32_t length) const {
+        return std::string(strings + offset, length);
+    }
+
+
+    /**
+     * Returns the name associated with the given tag.
+     * A search is made for an entry of a tag only, then of a tag range holding the tag.
+     *
+     * @param tag tag of dictionary entry to find.
+     * @return descriptive name or ??? if none found.
+     */
+    std::string EvioBinaryDictionary::getName(uint16_t tag) const {
+        const uint32_t *e = lookup(makeKey(tag, 0, 0, false));
+        return e == nullptr ? EvioXMLDictionary::NO_NAME_STRING() : getString(e[4], e[5]);
+    }
+
+
+    /**
+     * Returns the name associated with the given tag and num.
+     * A search is made for an entry of a tag/num pair,
+     * then of a tag only, then of a tag range holding the tag.
+     *
+     * @param tag tag of dictionary entry to find.
+     * @param num num of dictionary entry to find.
+     * @return descriptive name or ??? if none found.
+     */
+    std::string EvioBinaryDictionary::getName(uint16_t tag, uint8_t num) const {
+        return getName(tag, num, tag);
+    }
+
+
+    /**
+     * Returns the name associated with the given tag, num, and tagEnd.
+     * See {@link EvioXMLDictionary#getName(uint16_t, uint8_t, uint16_t)}.
+     *
+     * @param tag    tag of dictionary entry to find.
+     * @param num    num of dictionary entry to find.
+     * @param tagEnd tagEnd of dictionary entry to find.
+     * @return descriptive name or ??? if none found.
+     */
+    std::string EvioBinaryDictionary::getName(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
+        const uint32_t *e = lookup(makeKey(tag, num, tagEnd, true));
+        return e == nullptr ? EvioXMLDictionary::NO_NAME_STRING() : getString(e[4], e[5]);
+    }
+
+
+    /**
+     * Returns the name associated with the given tag, num, and tagEnd whose parent
+     * has the given tag, num, and tagEnd.
+     * See {@link EvioXMLDictionary#getName(uint16_t, uint8_t, uint16_t, uint16_t, uint8_t, uint16_t)}.
+     *
+     * @param tag     tag of dictionary entry to find.
+     * @param num     num of dictionary entry to find.
+     * @param tagEnd  tagEnd of dictionary entry to find.
+     * @param pTag    tag of dictionary entry's parent.
+     * @param pNum    num of dictionary entry's parent.
+     * @param pTagEnd tagEnd of dictionary entry's parent.
+     * @return descriptive name or ??? if none found.
+     */
+    std::string EvioBinaryDictionary::getName(uint16_t tag, uint8_t num, uint16_t tagEnd,
+                                              uint16_t pTag, uint8_t pNum, uint16_t pTagEnd) const {
+        Key key = makeKey(tag, num, tagEnd, true);
+        Key parent = makeKey(pTag, pNum, pTagEnd, true);
+        key.parentValid = true;
+        key.pTag = parent.tag;
+        key.pTagEnd = parent.tagEnd;
+        key.pNum = parent.num;
+        key.pNumValid = true;
+
+        const uint32_t *e = lookup(key);
+        return e == nullptr ? EvioXMLDictionary::NO_NAME_STRING() : getString(e[4], e[5]);
+    }
+
+
+    /**
+     * Returns the description, if any, associated with the given tag and num.
+     * @param tag tag to find the description of.
+     * @param num num to find the description of.
+     * @return description or empty string if none found.
+     */
+    std::string EvioBinaryDictionary::getDescription(uint16_t tag, uint8_t num) const {
+        return getDescription(tag, num, tag);
+    }
+
+
+    /**
+     * Returns the description, if any, associated with the given tag, num, and tagEnd.
+     * @param tag    tag to find the description of.
+     * @param num    num to find the description of.
+     * @param tagEnd tagEnd to find the description of.
+     * @return description or empty string if none found.
+     */
+    std::string EvioBinaryDictionary::getDescription(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
+        const uint32_t *e = lookup(makeKey(tag, num, tagEnd, true));
+        return e == nullptr ? "" : getString(e[6], e[7]);
+    }
+
+
+    /**
+     * Returns the description, if any, associated with the name of a dictionary entry.
+     * @param name dictionary name.
+     * @return description or empty string if none found.
+     */
+    std::string EvioBinaryDictionary::getDescription(std::string const & name) const {
+        const uint32_t *e = findName(name);
+        return e == nullptr ? "" : getString(e[6], e[7]);
+    }
+
+
+    /**
+     * Returns the format, if any, associated with the given tag and num.
+     * @param tag tag to find the format of.
+     * @param num num to find the format of.
+     * @return format or empty string if none found.
+     */
+    std::string EvioBinaryDictionary::getFormat(uint16_t tag, uint8_t num) const {
+        return getFormat(tag, num, tag);
+    }
+
+
+    /**
+     * Returns the format, if any, associated with the given tag, num, and tagEnd.
+     * @param tag    tag to find the format of.
+     * @param num    num to find the format of.
+     * @param tagEnd tagEnd to find the format of.
+     * @return format or empty string if none found.
+     */
+    std::string EvioBinaryDictionary::getFormat(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
+        const uint32_t *e = lookup(makeKey(tag, num, tagEnd, true));
+        return e == nullptr ? "" : getString(e[8], e[9]);
+    }
+
+
+    /**
+     * Returns the format, if any, associated with the name of a dictionary entry.
+     * @param name dictionary name.
+     * @return format or empty string if none found.
+     */
+    std::string EvioBinaryDictionary::getFormat(std::string const & name) const {
+        const uint32_t *e = findName(name);
+        return e == nullptr ? "" : getString(e[8], e[9]);
+    }
+
+
+    /**
+     * Returns the type, if any, associated with the given tag and num.
+     * @param tag tag to find the type of.
+     * @param num num to find the type of.
+     * @return type or DataType::NOT_A_VALID_TYPE if none found.
+     */
+    DataType EvioBinaryDictionary::getType(uint16_t tag, uint8_t num) const {
+        return getType(tag, num, tag);
+    }
+
+
+    /**
+     * Returns the type, if any, associated with the given tag, num, and tagEnd.
+     * @param tag    tag to find the type of.
+     * @param num    num to find the type of.
+     * @param tagEnd tagEnd to find the type of.
+     * @return type or DataType::NOT_A_VALID_TYPE if none found.
+     */
+    DataType EvioBinaryDictionary::getType(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
+        const uint32_t *e = lookup(makeKey(tag, num, tagEnd, true));
+        return e == nullptr ? DataType::NOT_A_VALID_TYPE : DataType::getDataType(e[3]);
+    }
+
+
+    /**
+     * Returns the type, if any, associated with the name of a dictionary entry.
+     * @param name dictionary name.
+     * @return type or DataType::NOT_A_VALID_TYPE if none found.
+     */
+    DataType EvioBinaryDictionary::getType(std::string const & name) const {
+        const uint32_t *e = findName(name);
+        return e == nullptr ? DataType::NOT_A_VALID_TYPE : DataType::getDataType(e[3]);
+    }
+
+
+    /**
+     * Returns the tag/num/tagEnd values corresponding to the name of a dictionary entry.
+     * @param name   dictionary name.
+     * @param tag    pointer which gets filled with tag value.
+     * @param num    pointer which gets filled with num value.
+     * @param tagEnd pointer which gets filled with tagEnd value.
+     * @return true if entry found, else false.
+     */
+    bool EvioBinaryDictionary::getTagNum(std::string const & name, uint16_t *tag, uint8_t *num, uint16_t *tagEnd) const {
+        const uint32_t *e = findName(name);
+        if (e == nullptr) return false;
+        if (tag != nullptr)    {*tag = e[0] & 0xffff;}
+        if (num != nullptr)    {*num = e[1] & 0xff;}
+        if (tagEnd != nullptr) {*tagEnd = e[0] >> 16;}
+        return true;
+    }
+
+
+    /**
+     * Returns the tag corresponding to the name of a dictionary entry.
+     * @param name dictionary name.
+     * @param tag  pointer which gets filled with tag value.
+     * @return true if entry found, else false.
+     */
+    bool EvioBinaryDictionary::getTag(std::string const & name, uint16_t *tag) const {
+        return tag != nullptr && getTagNum(name, tag, nullptr, nullptr);
+    }
+
+
+    /**
+     * Returns the tagEnd corresponding to the name of a dictionary entry.
+     * @param name   dictionary name.
+     * @param tagEnd pointer which gets filled with tagEnd value.
+     * @return true if entry found, else false.
+     */
+    bool EvioBinaryDictionary::getTagEnd(std::string const & name, uint16_t *tagEnd) const {
+        return tagEnd != nullptr && getTagNum(name, nullptr, nullptr, tagEnd);
+    }
+
+
+    /**
+     * Returns the num corresponding to the name of a dictionary entry.
+     * @param name dictionary name.
+     * @param num  pointer which gets filled with num value.
+     * @return true if entry found, else false.
+     */
+    bool EvioBinaryDictionary::getNum(std::string const & name, uint8_t *num) const {
+        return getTagNum(name, nullptr, num, nullptr);
+    }
+
+}
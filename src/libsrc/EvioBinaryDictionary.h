@@ -0,0 +1,184 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVIOBINARYDICTIONARY_H
+#define EVIO_6_0_EVIOBINARYDICTIONARY_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+#include "ByteOrder.h"
+#include "DataType.h"
+#include "EvioException.h"
+#include "EvioXMLDictionary.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a dictionary stored in a compact, binary form which can be used as is,
+     * without parsing, straight from a file's bytes (including memory-mapped ones). It is made from an
+     * {@link EvioXMLDictionary} by {@link #encode} and holds the same entries, along with
+     * the lookup tables used to find them. Creating one only checks the layout, so it takes
+     * microseconds no matter how many entries there are. The xml form of the dictionary remains
+     * the standard one; this is only a faster way to load it.<p>
+     *
+     * {@link EventWriter} stores this form, if it can make it, right after the xml dictionary
+     * and any first event in the common record, so readers not knowing about it are unaffected.
+     * {@link Reader#getBinaryDictionary()} returns it.<p>
+     *
+     * Lookups behave as in {@link EvioXMLDictionary}: a tag/num pair is first matched exactly,
+     * then by tag only, then by a tag range holding the tag.<p>
+     *
+     * The layout is made of 32 bit words in the byte order given when encoding,
+     * followed by string bytes:
+     * <pre>
+     *   header:      MAGIC, VERSION, total bytes, # entries, # slots, # ranges, # name slots, # string bytes
+     *   entries:     10 words each: tag | tagEnd &lt;&lt; 16,
+     *                               num | flags &lt;&lt; 8 | parent num &lt;&lt; 16,
+     *                               parent tag | parent tagEnd &lt;&lt; 16,
+     *                               data type,
+     *                               name offset, name length, description offset,
+     *                               description length, format offset, format length
+     *   slots:       4 words each: key low, key high, first entry, # entries (open addressing hash)
+     *   ranges:      3 words each: tag | tagEnd &lt;&lt; 16, max tagEnd so far, entry (sorted by tag)
+     *   name slots:  1 word each: entry + 1, or 0 if empty (open addressing hash of names)
+     *   strings:     names, descriptions, and formats, padded to 4 bytes
+     * </pre>
+     * Flags are: bit 0 num valid, bits 1-2 entry type, bit 3 parent valid, bit 4 parent num valid.
+     * Entries with the same tag, num, and tagEnd, differing only in parents, are next to each other.<p>
+     *
+     * Objects are immutable and may be used by any number of threads at once.
+     */
+    class EvioBinaryDictionary {
+
+    public:
+
+        /** First word of a binary dictionary, ascii "DICT". */
+        static const uint32_t MAGIC = 0x44494354;
+
+        /** Version of layout. */
+        static const uint32_t VERSION = 1;
+
+    private:
+
+        /** Number of words in the header. */
+        static const uint32_t HEADER_WORDS = 8;
+
+        /** Number of words in each entry. */
+        static const uint32_t ENTRY_WORDS = 10;
+
+        /** Number of words in each hash table slot. */
+        static const uint32_t SLOT_WORDS = 4;
+
+        /** Number of words in each tag range. */
+        static const uint32_t RANGE_WORDS = 3;
+
+        /** Copy of data, if it was swapped, not aligned, or given as a vector. */
+        std::vector<uint8_t> ownedData;
+
+        /** Start of data. */
+        const uint32_t *words = nullptr;
+
+        /** Number of entries. */
+        uint32_t entryCount = 0;
+
+        /** Number of hash table slots. */
+        uint32_t slotCount = 0;
+
+        /** Number of tag ranges. */
+        uint32_t rangeCount = 0;
+
+        /** Number of name hash table slots. */
+        uint32_t nameSlotCount = 0;
+
+        /** Number of string bytes. */
+        uint32_t stringBytes = 0;
+
+        const uint32_t *entries   = nullptr;
+        const uint32_t *slots     = nullptr;
+        const uint32_t *ranges    = nullptr;
+        const uint32_t *nameSlots = nullptr;
+        const char     *strings   = nullptr;
+
+    public:
+
+        EvioBinaryDictionary(const uint8_t *data, size_t len);
+        explicit EvioBinaryDictionary(std::vector<uint8_t> data);
+
+        static bool isBinaryDictionary(const uint8_t *data, size_t len);
+        static void encode(EvioXMLDictionary const & dictionary, std::vector<uint8_t> & out,
+                           ByteOrder const & order = ByteOrder::ENDIAN_LOCAL);
+
+        /** @return number of entries in this dictionary. */
+        size_t size() const {return entryCount;}
+
+        std::string getName(uint16_t tag) const;
+        std::string getName(uint16_t tag, uint8_t num) const;
+        std::string getName(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        std::string getName(uint16_t tag, uint8_t num, uint16_t tagEnd,
+                            uint16_t pTag, uint8_t pNum, uint16_t pTagEnd) const;
+
+        std::string getDescription(uint16_t tag, uint8_t num) const;
+        std::string getDescription(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        std::string getDescription(std::string const & name) const;
+
+        std::string getFormat(uint16_t tag, uint8_t num) const;
+        std::string getFormat(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        std::string getFormat(std::string const & name) const;
+
+        DataType getType(uint16_t tag, uint8_t num) const;
+        DataType getType(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        DataType getType(std::string const & name) const;
+
+        bool getTagNum(std::string const & name, uint16_t *tag, uint8_t *num, uint16_t *tagEnd) const;
+        bool getTag(std::string const & name, uint16_t *tag) const;
+        bool getTagEnd(std::string const & name, uint16_t *tagEnd) const;
+        bool getNum(std::string const & name, uint8_t *num) const;
+
+    private:
+
+        /** Values of a dictionary entry used to look it up. */
+        struct Key {
+            uint16_t tag;
+            uint16_t tagEnd;
+            uint8_t  num;
+            bool     numValid;
+            uint32_t entryType;
+            bool     parentValid;
+            uint16_t pTag;
+            uint16_t pTagEnd;
+            uint8_t  pNum;
+            bool     pNumValid;
+        };
+
+        void init(const uint8_t *data, size_t len);
+
+        static Key makeKey(uint16_t tag, uint8_t num, uint16_t tagEnd, bool numValid);
+        static uint64_t packKey(Key const & key);
+        static size_t slotOf(uint64_t key, size_t mask);
+        static uint32_t hashName(const char *name, size_t len);
+
+        const uint32_t * lookup(Key const & key) const;
+        const uint32_t * findKey(Key const & key) const;
+        const uint32_t * findInRange(uint16_t tag) const;
+        const uint32_t * findName(std::string const & name) const;
+        std::string getString(uint32_t offset, uint32_t length) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVIOBINARYDICTIONARY_H
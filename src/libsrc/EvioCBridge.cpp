@@ -0,0 +1,695 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <unordered_map>
+
+
+#include "EvioCBridge.h"
+#include "EventWriter.h"
+#include "Reader.h"
+#include "EvioNode.h"
+#include "RecordInput.h"
+#include "ParallelEventReader.h"
+#include "ColumnarExporter.h"
+#include "ByteBufferView.h"
+#include "ByteOrder.h"
+
+
+using namespace evio;
+
+
+/** Structure behind the C handle of a writer. */
+struct evioCWriter {
+    /** Writer to a file. */
+    std::unique_ptr<EventWriter> writer;
+};
+
+
+/** Structure behind the C handle of a reader. */
+struct evioCReader {
+    /** Reader of a file. */
+    std::unique_ptr<Reader> reader;
+    /** Index of next event to read. */
+    uint32_t nextIndex = 0;
+    /** Is the data opposite the local byte order? */
+    bool swapped = false;
+};
+
+
+/** Structure behind the C handle of a compact reader. */
+struct evioCCompactReader {
+    /** Reader of a file. */
+    std::unique_ptr<Reader> reader;
+    /** Buffer wrapping, without copying, the event gotten last. */
+    std::shared_ptr<ByteBuffer> eventBuffer;
+    /** Node of the event gotten last, with all its structures. */
+    std::shared_ptr<EvioNode> eventNode;
+    /** Structures of the event gotten last. */
+    std::vector<evioCNode> nodes;
+    /** Is the data opposite the local byte order? */
+    bool swapped = false;
+};
+
+
+/** Structure behind the C handle of exported columns. */
+struct evioCColumns {
+    /** One column of all files' events. */
+    struct Column {
+        /** Values of all rows, local endian. */
+        std::vector<uint8_t> values;
+        /** Index of each row's first value, plus one past the last row's values. */
+        std::vector<int64_t> offsets {0};
+        /** Bytes in each value. */
+        uint32_t valueBytes = 1;
+    };
+    /** Columns, in the order of the selectors. */
+    std::vector<Column> columns;
+};
+
+
+/** Thrown by the record handler of evioCForEachRecord to stop when asked to. */
+struct evioCStop {};
+
+
+/** Message of the last error in this thread. */
+static thread_local std::string lastError;
+
+
+/**
+ * Record the message of an exception as the last error.
+ * @param e exception.
+ * @return EVIO_C_ERROR.
+ */
+static int error(std::exception const & e) {
+    lastError = e.what();
+    return EVIO_C_ERROR;
+}
+
+
+/**
+ * Record a message as the last error.
+ * @param msg message.
+ * @return EVIO_C_ERROR.
+ */
+static int error(const char *msg) {
+    lastError = msg;
+    return EVIO_C_ERROR;
+}
+
+
+extern "C" {
+
+
+/**
+ * Get the message of the last error in the calling thread.
+ * @return message, empty if none. Valid until the next error in this thread.
+ */
+const char *evioCGetError(void) {
+    return lastError.c_str();
+}
+
+
+/**
+ * Open a file for writing events in evio version 6 format, in local byte order.
+ * As with the C library's evOpen, a single file is overwritten if it exists,
+ * but split files are not. The file name may contain the same integer format
+ * specifiers and environmental variables as in evOpen.
+ *
+ * @param fileName           name of file to write.
+ * @param split              if &gt; 0, size in bytes at which to split the file.
+ * @param compressionType    type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd).
+ * @param compressionThreads number of threads compressing records simultaneously.
+ * @param writer             handle returned here.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR.
+ */
+int evioCWriterOpen(const char *fileName, uint64_t split, int compressionType,
+                    uint32_t compressionThreads, evioCWriter **writer) {
+    if (fileName == nullptr || writer == nullptr) {
+        return error("null arg");
+    }
+    *writer = nullptr;
+
+    try {
+        auto handle = std::make_unique<evioCWriter>();
+        handle->writer = std::make_unique<EventWriter>(
+                std::string(fileName), "", "", 0, split, 0, 0,
+                ByteOrder::nativeOrder(), "", split < 1, false,
+                nullptr, 0, 0, 1, 1,
+                Compressor::toCompressionType((uint32_t) compressionType),
+                compressionThreads < 1 ? 1 : compressionThreads, 0, 0);
+        *writer = handle.release();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Write an event. It is placed into the record being filled without first being copied,
+ * so it can be reused as soon as this returns.
+ *
+ * @param writer handle.
+ * @param event  evio bank in local byte order, whose first word is its length in words - 1.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR.
+ */
+int evioCWriterWriteEvent(evioCWriter *writer, const uint32_t *event) {
+    if (writer == nullptr || event == nullptr) {
+        return error("null arg");
+    }
+
+    try {
+        size_t bytes = 4 * ((size_t) event[0] + 1);
+        ByteBufferView view(reinterpret_cast<const uint8_t *>(event), bytes, ByteOrder::nativeOrder());
+        writer->writer->writeEvent(view);
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Write any remaining events, close the file, and free the handle.
+ * @param writer handle.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR. The handle is freed either way.
+ */
+int evioCWriterClose(evioCWriter *writer) {
+    if (writer == nullptr) {
+        return error("null arg");
+    }
+
+    int status = EVIO_C_OK;
+    try {
+        writer->writer->close();
+    }
+    catch (std::exception & e) {
+        status = error(e);
+    }
+
+    delete writer;
+    return status;
+}
+
+
+/**
+ * Open a file of evio version 6 format for reading events in order.
+ *
+ * @param fileName name of file to read.
+ * @param reader   handle returned here.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR.
+ */
+int evioCReaderOpen(const char *fileName, evioCReader **reader) {
+    if (fileName == nullptr || reader == nullptr) {
+        return error("null arg");
+    }
+    *reader = nullptr;
+
+    try {
+        auto handle = std::make_unique<evioCReader>();
+        handle->reader = std::make_unique<Reader>(std::string(fileName));
+        handle->swapped = !handle->reader->getByteOrder().isLocalEndian();
+        *reader = handle.release();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Get the next event, without copying it. As in the C library's evReadNoCopy,
+ * the returned pointer is borrowed from the reader and is only valid until the next call
+ * to this routine or to evioCReaderClose. The event is in the file's byte order,
+ * see {@link #evioCReaderIsSwapped}.
+ *
+ * @param reader handle.
+ * @param event  pointer to event returned here.
+ * @param bytes  if not null, number of bytes in the event returned here.
+ * @return EVIO_C_OK if successful, EVIO_C_END if there are no more events,
+ *         else EVIO_C_ERROR.
+ */
+int evioCReaderGetNextEvent(evioCReader *reader, const uint32_t **event, uint32_t *bytes) {
+    if (reader == nullptr || event == nullptr) {
+        return error("null arg");
+    }
+
+    try {
+        if (reader->nextIndex >= reader->reader->getEventCount()) {
+            return EVIO_C_END;
+        }
+
+        ByteBufferView view = reader->reader->getEventView(reader->nextIndex++);
+        if (view.empty()) {
+            return error("cannot read event");
+        }
+
+        *event = reinterpret_cast<const uint32_t *>(view.data());
+        if (bytes != nullptr) *bytes = (uint32_t) view.size();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Are events read in the opposite of the local byte order? If so, the C library's
+ * evioswap can copy them into local byte order.
+ * @param reader handle.
+ * @return 1 if swapped, else 0.
+ */
+int evioCReaderIsSwapped(const evioCReader *reader) {
+    return reader != nullptr && reader->swapped ? 1 : 0;
+}
+
+
+/**
+ * Get the number of events in the file.
+ * @param reader handle.
+ * @return number of events, 0 if null arg.
+ */
+uint32_t evioCReaderGetEventCount(const evioCReader *reader) {
+    return reader == nullptr ? 0 : reader->reader->getEventCount();
+}
+
+
+/**
+ * Get the event of the given index, without copying it. The returned pointer is borrowed
+ * from the reader and is only valid until the next call to get an event or to evioCReaderClose.
+ * The event is in the file's byte order, see {@link #evioCReaderIsSwapped}.
+ * This does not change which event evioCReaderGetNextEvent gets.
+ *
+ * @param reader handle.
+ * @param index  index of event, starting at 0.
+ * @param event  pointer to event returned here.
+ * @param bytes  if not null, number of bytes in the event returned here.
+ * @return EVIO_C_OK if successful, EVIO_C_END if there is no such event,
+ *         else EVIO_C_ERROR.
+ */
+int evioCReaderGetEvent(evioCReader *reader, uint32_t index, const uint32_t **event, uint32_t *bytes) {
+    if (reader == nullptr || event == nullptr) {
+        return error("null arg");
+    }
+
+    try {
+        if (index >= reader->reader->getEventCount()) {
+            return EVIO_C_END;
+        }
+
+        ByteBufferView view = reader->reader->getEventView(index);
+        if (view.empty()) {
+            return error("cannot read event");
+        }
+
+        *event = reinterpret_cast<const uint32_t *>(view.data());
+        if (bytes != nullptr) *bytes = (uint32_t) view.size();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Get the number of records in the file.
+ * @param reader handle.
+ * @return number of records, 0 if null arg.
+ */
+uint32_t evioCReaderGetRecordCount(const evioCReader *reader) {
+    return reader == nullptr ? 0 : reader->reader->getRecordCount();
+}
+
+
+/**
+ * Close the file and free the handle. Any event pointers gotten from it are no longer valid.
+ * @param reader handle.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR. The handle is freed either way.
+ */
+int evioCReaderClose(evioCReader *reader) {
+    if (reader == nullptr) {
+        return error("null arg");
+    }
+
+    int status = EVIO_C_OK;
+    try {
+        reader->reader->close();
+    }
+    catch (std::exception & e) {
+        status = error(e);
+    }
+
+    delete reader;
+    return status;
+}
+
+
+/**
+ * Open a file of evio version 6 format for reading the structures of its events in place,
+ * as {@link EvioCompactReader} does for a buffer. Each event is read (and decompressed) by
+ * a Reader, then scanned into EvioNodes where it lies in the record,
+ * since EvioCompactReader itself only gives nodes of a version 6 buffer, not a file.
+ *
+ * @param fileName name of file to read.
+ * @param reader   handle returned here.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR.
+ */
+int evioCCompactReaderOpen(const char *fileName, evioCCompactReader **reader) {
+    if (fileName == nullptr || reader == nullptr) {
+        return error("null arg");
+    }
+    *reader = nullptr;
+
+    try {
+        auto handle = std::make_unique<evioCCompactReader>();
+        handle->reader = std::make_unique<Reader>(std::string(fileName));
+        handle->swapped = !handle->reader->getByteOrder().isLocalEndian();
+        *reader = handle.release();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Get the number of events in the file.
+ * @param reader handle.
+ * @return number of events, 0 if null arg.
+ */
+uint32_t evioCCompactReaderGetEventCount(const evioCCompactReader *reader) {
+    return reader == nullptr ? 0 : reader->reader->getEventCount();
+}
+
+
+/**
+ * Is data read in the opposite of the local byte order?
+ * @param reader handle.
+ * @return 1 if swapped, else 0.
+ */
+int evioCCompactReaderIsSwapped(const evioCCompactReader *reader) {
+    return reader != nullptr && reader->swapped ? 1 : 0;
+}
+
+
+/**
+ * Get all the structures of an event, the event itself first, then each structure
+ * before those it contains. Nothing is copied: each node points to its data in the
+ * reader's buffer. The nodes and their data are only valid until the next call to this
+ * routine or to evioCCompactReaderClose.
+ *
+ * @param reader handle.
+ * @param index  index of event, starting at 0.
+ * @param nodes  pointer to array of nodes returned here.
+ * @param count  number of nodes returned here.
+ * @return EVIO_C_OK if successful, EVIO_C_END if there is no such event,
+ *         else EVIO_C_ERROR.
+ */
+int evioCCompactReaderGetNodes(evioCCompactReader *reader, uint32_t index,
+                               const evioCNode **nodes, uint32_t *count) {
+    if (reader == nullptr || nodes == nullptr || count == nullptr) {
+        return error("null arg");
+    }
+
+    try {
+        if (index >= reader->reader->getEventCount()) {
+            return EVIO_C_END;
+        }
+
+        ByteBufferView view = reader->reader->getEventView(index);
+        if (view.empty()) {
+            return error("cannot read event");
+        }
+
+        // Wrap the event's bytes in the record without copying or taking ownership of them
+        std::shared_ptr<uint8_t> data(const_cast<uint8_t *>(view.data()), [](uint8_t *) {});
+        reader->eventBuffer = std::make_shared<ByteBuffer>(data, view.size());
+        reader->eventBuffer->order(view.order());
+        reader->eventNode = EvioNode::extractEventNode(reader->eventBuffer, 0, 0, index);
+        EvioNode::scanStructure(reader->eventNode);
+
+        // The event first, then all it contains
+        std::vector<std::shared_ptr<EvioNode>> all {reader->eventNode};
+        for (auto & node : reader->eventNode->getAllNodes()) {
+            if (node != reader->eventNode) all.push_back(node);
+        }
+        const uint8_t *base = view.data();
+
+        std::unordered_map<const EvioNode *, int32_t> indexes;
+        reader->nodes.clear();
+        reader->nodes.reserve(all.size());
+
+        for (auto & node : all) {
+            evioCNode n;
+            uint32_t bytes = 4 * node->getDataLength();
+            n.data     = base + node->getDataPosition();
+            n.bytes    = bytes > node->getPad() ? bytes - node->getPad() : 0;
+            n.dataType = node->getDataType();
+            n.tag      = node->getTag();
+            n.num      = node->getNum();
+
+            // Children of the event may not point to it
+            auto parent = node->getParentNode();
+            auto it = parent == nullptr ? indexes.end() : indexes.find(parent.get());
+            n.parent = it != indexes.end() ? it->second : (node == reader->eventNode ? -1 : 0);
+
+            indexes[node.get()] = (int32_t) reader->nodes.size();
+            reader->nodes.push_back(n);
+        }
+
+        *nodes = reader->nodes.data();
+        *count = (uint32_t) reader->nodes.size();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Close the file and free the handle. Any node pointers gotten from it are no longer valid.
+ * @param reader handle.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR. The handle is freed either way.
+ */
+int evioCCompactReaderClose(evioCCompactReader *reader) {
+    if (reader == nullptr) {
+        return error("null arg");
+    }
+
+    int status = EVIO_C_OK;
+    try {
+        reader->reader->close();
+    }
+    catch (std::exception & e) {
+        status = error(e);
+    }
+
+    delete reader;
+    return status;
+}
+
+
+/**
+ * Read and decompress all the records of evio version 6 files in several threads,
+ * handing each to a handler in the thread that read it
+ * (see {@link ParallelEventReader#forEachRecord}). Records are not handled in any set order.
+ *
+ * @param fileNames names of files to read.
+ * @param fileCount number of files.
+ * @param threads   number of threads.
+ * @param handler   called with each record.
+ * @param arg       passed to handler.
+ * @return EVIO_C_OK if all records were handled, EVIO_C_END if the handler stopped it,
+ *         else EVIO_C_ERROR.
+ */
+int evioCForEachRecord(const char **fileNames, uint32_t fileCount, uint32_t threads,
+                       evioCRecordHandler handler, void *arg) {
+    if (fileNames == nullptr || handler == nullptr) {
+        return error("null arg");
+    }
+
+    try {
+        std::vector<std::string> files;
+        for (uint32_t i=0; i < fileCount; i++) {
+            if (fileNames[i] == nullptr) return error("null arg");
+            files.emplace_back(fileNames[i]);
+        }
+
+        ParallelEventReader::forEachRecord(files, threads < 1 ? 1 : threads,
+            [handler, arg](RecordInput & record, ParallelEventReader::EventInfo const & info) {
+                thread_local std::vector<uint32_t> lengths;
+                uint32_t count = record.getEntries();
+                lengths.resize(count);
+                for (uint32_t i=0; i < count; i++) {
+                    lengths[i] = record.getEventLength(i);
+                }
+
+                const uint8_t *events = count > 0 ? record.getEventView(0).data() : nullptr;
+                int swapped = record.getByteOrder().isLocalEndian() ? 0 : 1;
+                if (handler(arg, info.fileIndex, info.recordIndex, info.eventIndex,
+                            events, lengths.data(), count, swapped) != 0) {
+                    throw evioCStop();
+                }
+            });
+    }
+    catch (evioCStop &) {
+        return EVIO_C_END;
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Copy the data of selected banks of all the events of evio version 6 files into columns,
+ * one for each (tag, num, type) selector, using several threads
+ * (see {@link ColumnarExporter}). Each column is laid out as an Apache Arrow list array
+ * with one row per event, in the order of files and their events.
+ *
+ * @param fileNames   names of files to read.
+ * @param fileCount   number of files.
+ * @param tags        tag of each column's banks.
+ * @param nums        num of each column's banks.
+ * @param types       evio data type of each column's values.
+ * @param columnCount number of columns.
+ * @param threads     number of threads.
+ * @param columns     handle returned here, to be freed with evioCColumnsFree.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR.
+ */
+int evioCExportColumns(const char **fileNames, uint32_t fileCount,
+                       const uint16_t *tags, const uint8_t *nums, const uint32_t *types,
+                       uint32_t columnCount, uint32_t threads, evioCColumns **columns) {
+    if (fileNames == nullptr || tags == nullptr || nums == nullptr ||
+        types == nullptr || columns == nullptr) {
+        return error("null arg");
+    }
+    *columns = nullptr;
+
+    try {
+        std::vector<std::string> files;
+        for (uint32_t i=0; i < fileCount; i++) {
+            if (fileNames[i] == nullptr) return error("null arg");
+            files.emplace_back(fileNames[i]);
+        }
+
+        std::vector<ColumnarExporter::ColumnSelector> selectors;
+        for (uint32_t i=0; i < columnCount; i++) {
+            selectors.push_back({tags[i], nums[i], DataType::getDataType(types[i]), std::to_string(i)});
+        }
+
+        ColumnarExporter exporter(selectors);
+        auto batches = exporter.exportFiles(files, threads < 1 ? 1 : threads);
+
+        // Join the batches of all records into one column each
+        auto handle = std::make_unique<evioCColumns>();
+        handle->columns.resize(columnCount);
+        for (uint32_t c=0; c < columnCount; c++) {
+            auto & col = handle->columns[c];
+            for (auto & batch : batches) {
+                auto & part = batch.columns[c];
+                col.valueBytes = part.valueBytes;
+                int64_t first = col.offsets.back();
+                for (size_t row = 1; row < part.offsets.size(); row++) {
+                    col.offsets.push_back(first + part.offsets[row]);
+                }
+                col.values.insert(col.values.end(), part.values.begin(), part.values.end());
+            }
+            for (auto & batch : batches) {
+                // Free each batch's values once joined
+                std::vector<uint8_t>().swap(batch.columns[c].values);
+            }
+        }
+
+        *columns = handle.release();
+    }
+    catch (std::exception & e) {
+        return error(e);
+    }
+
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Get the number of exported columns.
+ * @param columns handle.
+ * @return number of columns, 0 if null arg.
+ */
+uint32_t evioCColumnsGetCount(const evioCColumns *columns) {
+    return columns == nullptr ? 0 : (uint32_t) columns->columns.size();
+}
+
+
+/**
+ * Get the data of an exported column, without copying it. A row's values are
+ * <code>values[offsets[row]]</code> up to, not including, <code>values[offsets[row+1]]</code>,
+ * with offsets counted in values. Values are local endian. Pointers are valid until
+ * evioCColumnsFree is called.
+ *
+ * @param columns    handle.
+ * @param column     index of column.
+ * @param values     pointer to values returned here.
+ * @param valueCount number of values returned here.
+ * @param valueBytes number of bytes in each value returned here.
+ * @param offsets    pointer to rows + 1 offsets returned here.
+ * @param rows       number of rows returned here.
+ * @return EVIO_C_OK if successful, else EVIO_C_ERROR.
+ */
+int evioCColumnsGet(const evioCColumns *columns, uint32_t column, const void **values,
+                    uint64_t *valueCount, uint32_t *valueBytes, const int64_t **offsets, uint64_t *rows) {
+    if (columns == nullptr || values == nullptr || valueCount == nullptr ||
+        valueBytes == nullptr || offsets == nullptr || rows == nullptr) {
+        return error("null arg");
+    }
+    if (column >= columns->columns.size()) {
+        return error("no such column");
+    }
+
+    auto & col = columns->columns[column];
+    *values     = col.values.data();
+    *valueBytes = col.valueBytes;
+    *valueCount = col.values.size() / col.valueBytes;
+    *offsets    = col.offsets.data();
+    *rows       = col.offsets.size() - 1;
+    return EVIO_C_OK;
+}
+
+
+/**
+ * Free exported columns.
+ * @param columns handle.
+ */
+void evioCColumnsFree(evioCColumns *columns) {
+    delete columns;
+}
+
+
+}
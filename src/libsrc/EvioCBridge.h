@@ -0,0 +1,128 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVIOCBRIDGE_H
+#define EVIO_6_0_EVIOCBRIDGE_H
+
+
+/**
+ * @file
+ * C interface to the C++ {@link evio::EventWriter} and {@link evio::Reader}, so that
+ * programs written in C can use their features, such as compressing records in
+ * multiple threads, by linking against the C++ library. It's a thin layer: each
+ * handle holds one writer or reader and each routine makes one or two calls to it.
+ * Exceptions never cross it. Routines return EVIO_C_OK or EVIO_C_ERROR,
+ * and {@link #evioCGetError} gives the message of the last error in the calling thread.<p>
+ *
+ * Events are evio banks, as with evWrite and evRead of the C library.
+ * A handle must not be used by more than one thread at a time.<p>
+ *
+ * Event and structure data are handed out without copying, as pointers into the
+ * reader's record or file buffer, which is how the Python module in src/python
+ * wraps them as NumPy arrays.
+ */
+
+
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/** Successful return. */
+#define EVIO_C_OK     0
+/** Error return, see evioCGetError. */
+#define EVIO_C_ERROR -1
+/** No more events to read. */
+#define EVIO_C_END   -2
+
+
+/** Handle to a C++ EventWriter writing to a file. */
+typedef struct evioCWriter evioCWriter;
+
+/** Handle to a C++ Reader reading a file. */
+typedef struct evioCReader evioCReader;
+
+/** Handle to a reader of the structures of a file's events, as EvioNodes. */
+typedef struct evioCCompactReader evioCCompactReader;
+
+/** Handle to columns of bank data exported from files. */
+typedef struct evioCColumns evioCColumns;
+
+
+/** One structure of an event, as found by {@link #evioCCompactReaderGetNodes}. */
+typedef struct evioCNode {
+    /** Data of the structure, in the file's byte order. */
+    const uint8_t *data;
+    /** Number of bytes of data, not counting any padding. */
+    uint32_t bytes;
+    /** Type of data, as in the structure's header. */
+    uint32_t dataType;
+    /** Tag of structure. */
+    uint16_t tag;
+    /** Num of structure, 0 for a segment or tagsegment. */
+    uint8_t num;
+    /** Index of the parent structure, -1 for the event itself. */
+    int32_t parent;
+} evioCNode;
+
+
+/**
+ * Called with each record by {@link #evioCForEachRecord}, from one of several threads at once.
+ * The events are back to back in the record, in its byte order, and valid only during the call.
+ * Return 0 to go on, anything else to stop.
+ */
+typedef int (*evioCRecordHandler)(void *arg, uint32_t fileIndex, uint32_t recordIndex,
+                                  uint64_t firstEvent, const uint8_t *events,
+                                  const uint32_t *eventBytes, uint32_t eventCount, int swapped);
+
+
+const char *evioCGetError(void);
+
+int evioCWriterOpen(const char *fileName, uint64_t split, int compressionType,
+                    uint32_t compressionThreads, evioCWriter **writer);
+int evioCWriterWriteEvent(evioCWriter *writer, const uint32_t *event);
+int evioCWriterClose(evioCWriter *writer);
+
+int evioCReaderOpen(const char *fileName, evioCReader **reader);
+int evioCReaderGetNextEvent(evioCReader *reader, const uint32_t **event, uint32_t *bytes);
+int evioCReaderIsSwapped(const evioCReader *reader);
+uint32_t evioCReaderGetEventCount(const evioCReader *reader);
+int evioCReaderGetEvent(evioCReader *reader, uint32_t index, const uint32_t **event, uint32_t *bytes);
+uint32_t evioCReaderGetRecordCount(const evioCReader *reader);
+int evioCReaderClose(evioCReader *reader);
+
+int evioCCompactReaderOpen(const char *fileName, evioCCompactReader **reader);
+uint32_t evioCCompactReaderGetEventCount(const evioCCompactReader *reader);
+int evioCCompactReaderIsSwapped(const evioCCompactReader *reader);
+int evioCCompactReaderGetNodes(evioCCompactReader *reader, uint32_t index,
+                               const evioCNode **nodes, uint32_t *count);
+int evioCCompactReaderClose(evioCCompactReader *reader);
+
+int evioCForEachRecord(const char **fileNames, uint32_t fileCount, uint32_t threads,
+                       evioCRecordHandler handler, void *arg);
+
+int evioCExportColumns(const char **fileNames, uint32_t fileCount,
+                       const uint16_t *tags, const uint8_t *nums, const uint32_t *types,
+                       uint32_t columnCount, uint32_t threads, evioCColumns **columns);
+uint32_t evioCColumnsGetCount(const evioCColumns *columns);
+int evioCColumnsGet(const evioCColumns *columns, uint32_t column, const void **values,
+                    uint64_t *valueCount, uint32_t *valueBytes, const int64_t **offsets, uint64_t *rows);
+void evioCColumnsFree(evioCColumns *columns);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //EVIO_6_0_EVIOCBRIDGE_H
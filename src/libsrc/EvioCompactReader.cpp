@@ -77,6 +77,26 @@ namespace evio {
      *                       unsupported evio version.
      */
     EvioCompactReader::EvioCompactReader(std::shared_ptr<ByteBuffer> & bb, bool sync) :
+                            EvioCompactReader(bb, nullptr, sync) {}
+
+
+    /**
+     * Constructor for reading a buffer with option of removing synchronization
+     * for much greater speed, with all EvioNodes taken from a pool instead of
+     * being allocated. The pool is reset each time a buffer is set, so nodes
+     * from the previous buffer must not be used after that.
+     *
+     * @param bb   the buffer that contains events.
+     * @param pool source of EvioNode objects, null to create them.
+     * @param sync if true use mutex to make threadsafe.
+     * @see EventWriter
+     * @throws BufferUnderflowException if not enough buffer data;
+     * @throws EvioException if buffer arg is null;
+     *                       failure to parse first block header;
+     *                       unsupported evio version.
+     */
+    EvioCompactReader::EvioCompactReader(std::shared_ptr<ByteBuffer> & bb,
+                                         std::shared_ptr<EvioNodeSource> const & pool, bool sync) :
                             byteBuffer(bb), synced(sync) {
 
         initialPosition = byteBuffer->position();
@@ -90,10 +110,10 @@ namespace evio {
         }
 
         if (evioVersion == 4) {
-            reader = std::make_shared<EvioCompactReaderV4>(byteBuffer);
+            reader = std::make_shared<EvioCompactReaderV4>(byteBuffer, pool);
         }
         else if (evioVersion == 6) {
-            reader = std::make_shared<EvioCompactReaderV6>(byteBuffer);
+            reader = std::make_shared<EvioCompactReaderV6>(byteBuffer, pool);
         }
         else {
             throw EvioException("unsupported evio version (" + std::to_string(evioVersion) + ")");
@@ -113,6 +133,13 @@ namespace evio {
     void EvioCompactReader::setBuffer(std::shared_ptr<ByteBuffer> & buf) {reader->setBuffer(buf);}
 
 
+    /** {@inheritDoc} */
+    void EvioCompactReader::setBuffer(std::shared_ptr<ByteBuffer> & buf,
+                                      std::shared_ptr<EvioNodeSource> const & pool) {
+        reader->setBuffer(buf, pool);
+    }
+
+
     /** {@inheritDoc} */
     bool EvioCompactReader::isClosed() {
         if (synced) {
@@ -150,7 +177,7 @@ namespace evio {
 
 
     /** {@inheritDoc} */
-    std::shared_ptr<EvioXMLDictionary> EvioCompactReader::getDictionary() {
+    std::shared_ptr<const EvioXMLDictionary> EvioCompactReader::getDictionary() {
         if (synced) {
             auto lock = std::unique_lock<std::recursive_mutex>(mtx);
             return reader->getDictionary();
@@ -202,7 +229,7 @@ namespace evio {
 
     /** {@inheritDoc} */
     void EvioCompactReader::searchEvent(size_t eventNumber, std::string const & dictName,
-                                        std::shared_ptr<EvioXMLDictionary> & dictionary,
+                                        std::shared_ptr<const EvioXMLDictionary> const & dictionary,
                                         std::vector<std::shared_ptr<EvioNode>> & vec) {
         if (synced) {
             auto lock = std::unique_lock<std::recursive_mutex>(mtx);
@@ -212,6 +239,26 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    void EvioCompactReader::indexEvent(size_t eventNumber, StructureIndex & index) {
+        if (synced) {
+            auto lock = std::unique_lock<std::recursive_mutex>(mtx);
+            return reader->indexEvent(eventNumber, index);
+        }
+        return reader->indexEvent(eventNumber, index);
+    }
+
+
+    /** {@inheritDoc} */
+    uint32_t EvioCompactReader::validateEvent(size_t eventNumber) {
+        if (synced) {
+            auto lock = std::unique_lock<std::recursive_mutex>(mtx);
+            return reader->validateEvent(eventNumber);
+        }
+        return reader->validateEvent(eventNumber);
+    }
+
+
     /** {@inheritDoc} */
     std::shared_ptr<ByteBuffer> EvioCompactReader::removeEvent(size_t eventNumber) {
         if (synced) {
@@ -306,6 +353,27 @@ namespace evio {
     }
 
 
+    /**
+     * Get a view of the specified event, header included, without copying it
+     * or creating a ByteBuffer. Valid as long as the buffer being read is unchanged.
+     * @param eventNumber number of event of interest (starting at 1).
+     * @return view of event's bytes, empty if there is no such event.
+     * @throws EvioException if object closed.
+     */
+    ByteBufferView EvioCompactReader::getEventView(size_t eventNumber) {
+        std::shared_ptr<EvioNode> node;
+        if (synced) {
+            auto lock = std::unique_lock<std::recursive_mutex>(mtx);
+            node = reader->getEvent(eventNumber);
+        }
+        else {
+            node = reader->getEvent(eventNumber);
+        }
+        if (node == nullptr) return ByteBufferView();
+        return node->getStructureView();
+    }
+
+
     /** {@inheritDoc} */
     std::shared_ptr<ByteBuffer> EvioCompactReader::getStructureBuffer(std::shared_ptr<EvioNode> & node) {
         if (synced) {
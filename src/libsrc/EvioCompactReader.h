@@ -70,6 +70,8 @@ namespace evio {
 
         EvioCompactReader(std::string const & path, bool sync = false);
         EvioCompactReader(std::shared_ptr<ByteBuffer> & byteBuffer, bool sync = false) ;
+        EvioCompactReader(std::shared_ptr<ByteBuffer> & byteBuffer,
+                          std::shared_ptr<EvioNodeSource> const & pool, bool sync = false) ;
 
     public:
 
@@ -77,6 +79,7 @@ namespace evio {
         bool isCompressed() override;
 
         void setBuffer(std::shared_ptr<ByteBuffer> & buf) override;
+        void setBuffer(std::shared_ptr<ByteBuffer> & buf, std::shared_ptr<EvioNodeSource> const & pool) override;
 
         bool isClosed() override;
 
@@ -86,7 +89,7 @@ namespace evio {
         ByteOrder getFileByteOrder() override;
 
         std::string getDictionaryXML() override ;
-        std::shared_ptr<EvioXMLDictionary> getDictionary() override ;
+        std::shared_ptr<const EvioXMLDictionary> getDictionary() override ;
         bool hasDictionary() override;
 
         std::shared_ptr<ByteBuffer> getByteBuffer() override;
@@ -99,8 +102,10 @@ namespace evio {
 
         void searchEvent(size_t eventNumber, uint16_t tag, uint8_t num, std::vector<std::shared_ptr<EvioNode>> & vec) override ;
         void searchEvent(size_t eventNumber, std::string const & dictName,
-                         std::shared_ptr<EvioXMLDictionary> & dictionary,
+                         std::shared_ptr<const EvioXMLDictionary> const & dictionary,
                          std::vector<std::shared_ptr<EvioNode>> & vec) override ;
+        void indexEvent(size_t eventNumber, StructureIndex & index) override;
+        uint32_t validateEvent(size_t eventNumber) override;
 
         std::shared_ptr<ByteBuffer> removeEvent(size_t eventNumber) override;
         std::shared_ptr<ByteBuffer> removeStructure(std::shared_ptr<EvioNode> & removeNode) override;
@@ -116,6 +121,7 @@ namespace evio {
 
         std::shared_ptr<ByteBuffer> getEventBuffer(size_t eventNumber) override;
         std::shared_ptr<ByteBuffer> getEventBuffer(size_t eventNumber, bool copy) override;
+        ByteBufferView getEventView(size_t eventNumber);
 
         std::shared_ptr<ByteBuffer> getStructureBuffer(std::shared_ptr<EvioNode> & node) override;
         std::shared_ptr<ByteBuffer> getStructureBuffer(std::shared_ptr<EvioNode> & node, bool copy) override;
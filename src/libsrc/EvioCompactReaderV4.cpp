@@ -10,6 +10,7 @@
 
 
 #include "EvioCompactReaderV4.h"
+#include "EvioSwap.h"
 
 
 namespace evio {
@@ -23,7 +24,8 @@ namespace evio {
      * @see EventWriter
      * @throws EvioException if read failure, if path arg is empty
      */
-    EvioCompactReaderV4::EvioCompactReaderV4(std::string const & path) : path(path) {
+    EvioCompactReaderV4::EvioCompactReaderV4(std::string const & path, MapMode mode) :
+            path(path), mapMode(mode) {
         if (path.empty()) {
             throw EvioException("path is empty");
         }
@@ -74,11 +76,29 @@ namespace evio {
      * @throws EvioException if buffer arg is null;
      *                       failure to read first block header
      */
-    EvioCompactReaderV4::EvioCompactReaderV4(std::shared_ptr<ByteBuffer> & byteBuffer) {
+    EvioCompactReaderV4::EvioCompactReaderV4(std::shared_ptr<ByteBuffer> & byteBuffer) :
+            EvioCompactReaderV4(byteBuffer, nullptr) {}
+
+
+    /**
+     * Constructor for reading a buffer with EvioNodes taken from a pool.
+     * The pool is reset each time a buffer is set.
+     *
+     * @param byteBuffer the buffer that contains events.
+     * @param pool       source of EvioNode objects, null to create them.
+     *
+     * @see EventWriter
+     * @throws EvioException if buffer arg is null;
+     *                       failure to read first block header
+     */
+    EvioCompactReaderV4::EvioCompactReaderV4(std::shared_ptr<ByteBuffer> & byteBuffer,
+                                             std::shared_ptr<EvioNodeSource> const & pool) {
         if (byteBuffer == nullptr) {
             throw EvioException("Buffer arg is null");
         }
 
+        nodePool = pool;
+
         initialPosition = byteBuffer->position();
         this->byteBuffer = byteBuffer;
 
@@ -104,7 +124,7 @@ namespace evio {
 
         blockCount      = -1;
         eventCount      = -1;
-        dictionaryXML   = nullptr;
+        dictionaryXML.clear();
         initialPosition = buf->position();
         this->byteBuffer = buf;
 
@@ -117,10 +137,25 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    void EvioCompactReaderV4::setBuffer(std::shared_ptr<ByteBuffer> & buf,
+                                        std::shared_ptr<EvioNodeSource> const & pool) {
+        nodePool = pool;
+        setBuffer(buf);
+    }
+
+
     /** {@inheritDoc} */
     bool EvioCompactReaderV4::isFile() {return readingFile;}
 
 
+    /**
+     * Get how the file is memory mapped.
+     * @return how the file is memory mapped, READ_WRITE if reading a buffer.
+     */
+    EvioCompactReaderV4::MapMode EvioCompactReaderV4::getMapMode() const {return mapMode;}
+
+
     /** {@inheritDoc} */
     bool EvioCompactReaderV4::isCompressed() {return false;}
 
@@ -166,7 +201,7 @@ namespace evio {
 
 
     /** {@inheritDoc} */
-    std::shared_ptr<EvioXMLDictionary> EvioCompactReaderV4::getDictionary() {
+    std::shared_ptr<const EvioXMLDictionary> EvioCompactReaderV4::getDictionary() {
         if (dictionary != nullptr) return dictionary;
 
         if (closed) {
@@ -179,8 +214,8 @@ namespace evio {
                 if (dictionaryXML.empty()) {
                     readDictionary();
                 }
-                auto dict = std::make_shared<EvioXMLDictionary>(dictionaryXML);
-                return dict;
+                // Files of one run share the same dictionary, parse it only once
+                dictionary = EvioXMLDictionary::intern(dictionaryXML);
             }
             catch (EvioException & e) {}
         }
@@ -201,24 +236,31 @@ namespace evio {
      * @throws EvioException if file does not exist, cannot be opened, or cannot be mapped.
  	  */
     void EvioCompactReaderV4::mapFile(std::string const & filename, size_t fileSz) {
-        // Create a read-write memory mapped file
         int   fd;
         void *pmem;
 
-        if ((fd = ::open(filename.c_str(), O_RDWR)) < 0) {
-            throw EvioException("file does NOT exist");
-        }
-        else {
-            // set shared mem size
-            if (::ftruncate(fd, (off_t) fileSz) < 0) {
-                ::close(fd);
-                throw EvioException("fail to open file");
+        if (mapMode == READ_WRITE) {
+            // Create a read-write memory mapped file
+            if ((fd = ::open(filename.c_str(), O_RDWR)) < 0) {
+                throw EvioException("file does NOT exist");
+            }
+            else {
+                // set shared mem size
+                if (::ftruncate(fd, (off_t) fileSz) < 0) {
+                    ::close(fd);
+                    throw EvioException("fail to open file");
+                }
             }
         }
+        else if ((fd = ::open(filename.c_str(), O_RDONLY)) < 0) {
+            throw EvioException("file does NOT exist");
+        }
+
+        int prot  = (mapMode == READ_ONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+        int flags = (mapMode == COPY_ON_WRITE) ? MAP_PRIVATE : MAP_SHARED;
 
         // map file to process space
-        if ((pmem = ::mmap((caddr_t) 0, fileSz, PROT_READ | PROT_WRITE,
-                           MAP_SHARED, fd, (off_t)0)) == MAP_FAILED) {
+        if ((pmem = ::mmap((caddr_t) 0, fileSz, prot, flags, fd, (off_t)0)) == MAP_FAILED) {
             ::close(fd);
             throw EvioException("fail to map file");
         }
@@ -285,6 +327,10 @@ namespace evio {
         eventCount = 0;
         validDataWords = 0;
 
+        if (nodePool != nullptr) {
+            nodePool->reset();
+        }
+
         // uint32_t blockCounter = 0;
 
         while (bytesLeft > 0) {
@@ -369,7 +415,10 @@ namespace evio {
                     throw EvioException("Bad evio format: not enough data to read event (bad bank len?)");
                 }
 
-                auto node = EvioNode::extractEventNode(byteBuffer, *(blockNode.get()),
+                auto node = (nodePool == nullptr) ?
+                            EvioNode::extractEventNode(byteBuffer, *(blockNode.get()),
+                                                       position, eventCount + i) :
+                            EvioNode::extractEventNode(byteBuffer, *nodePool, *(blockNode.get()),
                                                        position, eventCount + i);
 //std::cout << "      event " << i << " in block: pos = " << node->getPosition() <<
 //             ", dataPos = " << node->getDataPosition() << ", ev # = " << (eventCount + i + 1) << std::endl;
@@ -576,7 +625,12 @@ namespace evio {
         // of child nodes to "true" as well.
         node->scanned = true;
 
-        EvioNode::scanStructure(node);
+        if (nodePool == nullptr) {
+            EvioNode::scanStructure(node);
+        }
+        else {
+            EvioNode::scanStructure(node, *nodePool);
+        }
 
         return node;
     }
@@ -598,7 +652,7 @@ namespace evio {
         vec.reserve(100);
 
         // Scan the node
-        auto list = scanStructure(eventNumber)->getAllNodes();
+        auto & list = scanStructure(eventNumber)->getAllNodes();
 //std::cout << "searchEvent: ev# = " << eventNumber << ", list size = " << list.size() <<
 //" for tag/num = " << tag << "/" << num << std::endl;
 
@@ -617,7 +671,7 @@ namespace evio {
 
     /** {@inheritDoc} */
     void EvioCompactReaderV4::searchEvent(size_t eventNumber, std::string const & dictName,
-                                          std::shared_ptr<EvioXMLDictionary> & dict,
+                                          std::shared_ptr<const EvioXMLDictionary> const & dictionary,
                                           std::vector<std::shared_ptr<EvioNode>> & vec) {
         if (dictName.empty()) {
             throw EvioException("empty dictionary entry name");
@@ -632,6 +686,7 @@ namespace evio {
         uint16_t tag;
         uint8_t  num;
 
+        auto dict = dictionary;
         if (dict == nullptr && hasDictionary())  {
             dict = getDictionary();
         }
@@ -651,6 +706,40 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    void EvioCompactReaderV4::indexEvent(size_t eventNumber, StructureIndex & index) {
+        // check args
+        if (eventNumber < 1 || eventNumber > (size_t)eventCount) {
+            throw EvioException("bad arg value(s)");
+        }
+
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        auto & node = eventNodes[eventNumber - 1];
+
+        EventHeaderParser::indexEvent(*(node->getBuffer()), node->getPosition(), index);
+    }
+
+
+    /** {@inheritDoc} */
+    uint32_t EvioCompactReaderV4::validateEvent(size_t eventNumber) {
+        // check args
+        if (eventNumber < 1 || eventNumber > (size_t)eventCount) {
+            throw EvioException("bad arg value(s)");
+        }
+
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        auto & node = eventNodes[eventNumber - 1];
+
+        return EventHeaderParser::validateEvent(*(node->getBuffer()), node->getPosition());
+    }
+
+
     /** {@inheritDoc} */
     std::shared_ptr<ByteBuffer> EvioCompactReaderV4::removeEvent(size_t eventNumber) {
 
@@ -1174,6 +1263,65 @@ namespace evio {
     }
 
 
+    /**
+     * Get an event in local byte order. If the data is already local endian, the returned
+     * buffer is a view into the file or buffer being read, so nothing is copied.
+     * Otherwise only this event is swapped, into a new buffer, leaving the mapped file alone.
+     *
+     * @param eventNumber number of event, starting at 1.
+     * @return buffer containing event in local byte order. Position and limit are set for reading.
+     * @throws EvioException if object closed, event does not exist, or is not in evio format.
+     */
+    std::shared_ptr<ByteBuffer> EvioCompactReaderV4::getLocalEventBuffer(size_t eventNumber) {
+        if (eventNumber < 1 || eventNumber > eventNodes.size()) {
+            throw EvioException("event " + std::to_string(eventNumber) + " does not exist");
+        }
+        return getLocalStructureBuffer(eventNodes[eventNumber - 1]);
+    }
+
+
+    /**
+     * Get a node's evio structure in local byte order. If the data is already local endian,
+     * the returned buffer is a view into the file or buffer being read, so nothing is copied.
+     * Otherwise only this structure is swapped, into a new buffer, leaving the mapped file alone.
+     *
+     * @param node node whose structure is wanted.
+     * @return buffer containing structure in local byte order. Position and limit are set for reading.
+     * @throws EvioException if object closed, or node's structure not in evio format.
+     */
+    std::shared_ptr<ByteBuffer> EvioCompactReaderV4::getLocalStructureBuffer(std::shared_ptr<EvioNode> & node) {
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        auto src = node->getBuffer();
+        if (src->order().isLocalEndian()) {
+            return getStructureBuffer(node, false);
+        }
+
+        auto buff = std::make_shared<ByteBuffer>(node->getTotalBytes());
+        auto from = reinterpret_cast<uint32_t *>(src->array() + src->arrayOffset() + node->getPosition());
+        auto to   = reinterpret_cast<uint32_t *>(buff->array() + buff->arrayOffset());
+
+        DataType type = node->getTypeObj();
+        if (type.isBank()) {
+            EvioSwap::swapBank(from, true, to);
+        }
+        else if (type.isSegment()) {
+            EvioSwap::swapSegment(from, true, to);
+        }
+        else if (type.isTagSegment()) {
+            EvioSwap::swapTagsegment(from, true, to);
+        }
+        else {
+            throw EvioException("node is not an evio structure");
+        }
+
+        buff->order(ByteOrder::ENDIAN_LOCAL);
+        return buff;
+    }
+
+
     /**
      * This only sets the position to its initial value.
      */
@@ -26,7 +26,6 @@
 #include <fstream>
 #include <sys/mman.h>
 #include <mutex>
-#include <sys/mman.h>
 
 
 #include "ByteBuffer.h"
@@ -37,6 +36,8 @@
 #include "EvioReaderV4.h"
 #include "IBlockHeader.h"
 #include "EvioNode.h"
+#include "EventHeaderParser.h"
+#include "StructureIndex.h"
 #include "RecordNode.h"
 
 
@@ -48,6 +49,12 @@ namespace evio {
      * and extract specific evio containers (bank, seg, or tagseg)
      * with actual data in them given a tag/num pair.<p>
      *
+     * A file is memory mapped in one of the ways of {@link MapMode}. By default, as always,
+     * the mapping is shared and writable so changes to mapped data go into the file.
+     * Mapping it read only, or privately with copy-on-write, lets it be read from read-only
+     * mounts and lets many processes share one page cache copy of it. Data of a file not in
+     * local byte order can be swapped as it's accessed, see {@link #getLocalStructureBuffer}.
+     *
      * @date 07/01/2020
      * @author timmer
      */
@@ -55,6 +62,18 @@ namespace evio {
 
     public:
 
+        /** Ways of memory mapping a file. */
+        enum MapMode {
+            /** Open file read-write and map it shared. Changes to mapped data go into the file. */
+            READ_WRITE = 0,
+            /** Open file read only and map it privately. The first write to a page
+             *  copies it for this process alone, the rest stay shared. */
+            COPY_ON_WRITE,
+            /** Open file and map it read only. Writing into buffers handed out
+             *  without copying is an error, copy what needs changing. */
+            READ_ONLY
+        };
+
         /** Offset to get block size from start of block. */
         static const int BLOCK_SIZE_OFFSET = 0;
 
@@ -78,6 +97,9 @@ namespace evio {
         /** Stores info of all the (top-level) events. */
         std::vector<std::shared_ptr<EvioNode>> eventNodes;
 
+        /** If not null, source of all EvioNodes, reset each time a buffer is set. */
+        std::shared_ptr<EvioNodeSource> nodePool = nullptr;
+
         /** Store info of all block headers. */
         std::unordered_map<uint32_t, std::shared_ptr<RecordNode>> blockNodes;
 
@@ -116,7 +138,7 @@ namespace evio {
         std::string dictionaryXML;
 
         /** Dictionary object created from dictionaryXML string. */
-        std::shared_ptr<EvioXMLDictionary> dictionary = nullptr;
+        std::shared_ptr<const EvioXMLDictionary> dictionary = nullptr;
 
         /** The buffer being read. */
         std::shared_ptr<ByteBuffer> byteBuffer = nullptr;
@@ -147,14 +169,20 @@ namespace evio {
         /** File size in bytes. */
         size_t fileBytes = 0;
 
+        /** How file is mapped. */
+        MapMode mapMode = READ_WRITE;
+
     public:
 
-        explicit EvioCompactReaderV4(std::string const & path);
+        explicit EvioCompactReaderV4(std::string const & path, MapMode mode = READ_WRITE);
         explicit EvioCompactReaderV4(std::shared_ptr<ByteBuffer> & byteBuffer);
+        EvioCompactReaderV4(std::shared_ptr<ByteBuffer> & byteBuffer, std::shared_ptr<EvioNodeSource> const & pool);
 
         void setBuffer(std::shared_ptr<ByteBuffer> & buf) override ;
+        void setBuffer(std::shared_ptr<ByteBuffer> & buf, std::shared_ptr<EvioNodeSource> const & pool) override ;
 
         bool isFile() override ;
+        MapMode getMapMode() const;
         bool isCompressed() override ;
         bool isClosed() override ;
         ByteOrder getByteOrder() override ;
@@ -162,7 +190,7 @@ namespace evio {
         std::string getPath() override ;
         ByteOrder getFileByteOrder() override ;
         std::string getDictionaryXML() override ;
-        std::shared_ptr<EvioXMLDictionary> getDictionary() override ;
+        std::shared_ptr<const EvioXMLDictionary> getDictionary() override ;
         bool hasDictionary() override ;
 
     private:
@@ -191,8 +219,10 @@ namespace evio {
         void searchEvent(size_t eventNumber, uint16_t tag, uint8_t num,
                          std::vector<std::shared_ptr<EvioNode>> & vec) override ;
         void searchEvent(size_t eventNumber, std::string const & dictName,
-                         std::shared_ptr<EvioXMLDictionary> & dictionary,
+                         std::shared_ptr<const EvioXMLDictionary> const & dictionary,
                          std::vector<std::shared_ptr<EvioNode>> & vec) override ;
+        void indexEvent(size_t eventNumber, StructureIndex & index) override ;
+        uint32_t validateEvent(size_t eventNumber) override ;
 
 
         std::shared_ptr<ByteBuffer> removeEvent(size_t eventNumber) override ;
@@ -214,6 +244,9 @@ namespace evio {
         std::shared_ptr<ByteBuffer> getStructureBuffer(std::shared_ptr<EvioNode> & node) override ;
         std::shared_ptr<ByteBuffer> getStructureBuffer(std::shared_ptr<EvioNode> & node, bool copy) override ;
 
+        std::shared_ptr<ByteBuffer> getLocalEventBuffer(size_t eventNumber);
+        std::shared_ptr<ByteBuffer> getLocalStructureBuffer(std::shared_ptr<EvioNode> & node);
+
         void close() override ;
 
         uint32_t  getEventCount() override ;
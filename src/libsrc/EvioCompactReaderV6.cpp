@@ -37,12 +37,28 @@ namespace evio {
      *                       buffer not in the proper format,
      *                       or earlier than version 6.
      */
-    EvioCompactReaderV6::EvioCompactReaderV6(std::shared_ptr<ByteBuffer> & byteBuffer) {
+    EvioCompactReaderV6::EvioCompactReaderV6(std::shared_ptr<ByteBuffer> & byteBuffer) :
+            EvioCompactReaderV6(byteBuffer, nullptr) {}
+
+
+    /**
+     * Constructor for reading a buffer with EvioNodes taken from a pool.
+     * The pool is reset each time a buffer is set.
+     *
+     * @param byteBuffer the buffer that contains events.
+     * @param pool       source of EvioNode objects, null to create them.
+     * @throws EvioException if buffer arg is null,
+     *                       buffer too small,
+     *                       buffer not in the proper format,
+     *                       or earlier than version 6.
+     */
+    EvioCompactReaderV6::EvioCompactReaderV6(std::shared_ptr<ByteBuffer> & byteBuffer,
+                                             std::shared_ptr<EvioNodeSource> const & pool) {
         if (byteBuffer == nullptr) {
             throw EvioException("Buffer arg is null");
         }
 
-        reader.setBuffer(byteBuffer);
+        reader.setBuffer(byteBuffer, pool);
 
         if (!reader.isEvioFormat()) {
             std::cout << "EvioCompactReaderV6: buffer is NOT in evio format" << std::endl;
@@ -64,6 +80,20 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    void EvioCompactReaderV6::setBuffer(std::shared_ptr<ByteBuffer> & buf,
+                                        std::shared_ptr<EvioNodeSource> const & pool) {
+        reader.setBuffer(buf, pool);
+        if (!reader.isEvioFormat()) {
+            std::cout << "EvioCompactReaderV6: buffer is NOT in evio format" << std::endl;
+            throw EvioException("buffer not in evio format");
+        }
+
+        dictionary = nullptr;
+        closed = false;
+    }
+
+
     /** {@inheritDoc} */
     bool EvioCompactReaderV6::isFile() {return reader.isFile();}
 
@@ -97,7 +127,7 @@ namespace evio {
 
 
     /** {@inheritDoc} */
-    std::shared_ptr<EvioXMLDictionary>  EvioCompactReaderV6::getDictionary() {
+    std::shared_ptr<const EvioXMLDictionary>  EvioCompactReaderV6::getDictionary() {
         if (dictionary != nullptr) return dictionary;
 
         if (closed) {
@@ -106,7 +136,8 @@ namespace evio {
 
         std::string dictXML = reader.getDictionary();
         if (!dictXML.empty()) {
-            dictionary = std::make_shared<EvioXMLDictionary>(dictXML);
+            // Files of one run share the same dictionary, parse it only once
+            dictionary = EvioXMLDictionary::intern(dictXML);
         }
 
         return dictionary;
@@ -178,7 +209,13 @@ namespace evio {
         // Do this before actual scan so scanStructure() sets all "scanned" fields
         // of child nodes to "true" as well.
         node->scanned = true;
-        EvioNode::scanStructure(node);
+        auto pool = reader.getNodePool();
+        if (pool == nullptr) {
+            EvioNode::scanStructure(node);
+        }
+        else {
+            EvioNode::scanStructure(node, *pool);
+        }
         return node;
     }
 
@@ -203,7 +240,7 @@ namespace evio {
             return;
         }
 
-        auto list = node->getAllNodes();
+        auto & list = node->getAllNodes();
 //std::cout << "searchEvent: ev# = " << eventNumber << ", list size = " << list.size() <<
 //             " for tag/num = " << tag << "/" << +num << std::endl;
 
@@ -221,7 +258,7 @@ namespace evio {
 
     /** {@inheritDoc} */
     void EvioCompactReaderV6::searchEvent(size_t eventNumber, std::string const & dictName,
-                                          std::shared_ptr<EvioXMLDictionary> & dictionary,
+                                          std::shared_ptr<const EvioXMLDictionary> const & dict,
                                           std::vector<std::shared_ptr<EvioNode>> & vec) {
 
         if (dictName.empty()) {
@@ -237,6 +274,7 @@ namespace evio {
         uint16_t tag;
         uint8_t  num;
 
+        auto dictionary = dict;
         if (dictionary == nullptr && hasDictionary())  {
             dictionary = getDictionary();
         }
@@ -255,6 +293,47 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    void EvioCompactReaderV6::indexEvent(size_t eventNumber, StructureIndex & index) {
+        // check args
+        if (eventNumber < 1 || eventNumber > reader.getEventCount()) {
+            throw EvioException("bad arg value(s)");
+        }
+
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        auto node = reader.getEventNode(eventNumber - 1);
+        if (node == nullptr) {
+            index.clear();
+            return;
+        }
+
+        EventHeaderParser::indexEvent(*(node->getBuffer()), node->getPosition(), index);
+    }
+
+
+    /** {@inheritDoc} */
+    uint32_t EvioCompactReaderV6::validateEvent(size_t eventNumber) {
+        // check args
+        if (eventNumber < 1 || eventNumber > reader.getEventCount()) {
+            throw EvioException("bad arg value(s)");
+        }
+
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        auto node = reader.getEventNode(eventNumber - 1);
+        if (node == nullptr) {
+            throw EvioException("event not found");
+        }
+
+        return EventHeaderParser::validateEvent(*(node->getBuffer()), node->getPosition());
+    }
+
+
     /** {@inheritDoc} */
     std::shared_ptr<ByteBuffer> EvioCompactReaderV6::removeEvent(size_t eventNumber) {
 
@@ -290,6 +369,27 @@ namespace evio {
     }
 
 
+    /**
+     * This method removes and adds all the evio structures collected in the given object
+     * at once, moving the buffer's data only once. Nodes of removed structures, and of all
+     * they contain, are obsolete. All other nodes stay valid with updated positions and lengths.
+     * The edits are cleared once made.
+     *
+     * @param edits removals and additions to make.
+     * @return buffer updated to reflect the edits, new if data had to be moved toward its end.
+     * @throws EvioException if object closed;
+     *                       if buffer has compressed data or non-evio format events;
+     *                       if a node to remove was not found in any event;
+     *                       if an event to add to does not exist or is being removed;
+     *                       if data to add is opposite endian to the buffer.
+     */
+    std::shared_ptr<ByteBuffer> EvioCompactReaderV6::applyEdits(StructureEdits & edits) {
+        auto & buf = reader.applyEdits(edits);
+        edits.clear();
+        return buf;
+    }
+
+
     /** {@inheritDoc} */
     std::shared_ptr<ByteBuffer> EvioCompactReaderV6::getData(std::shared_ptr<EvioNode> & node) {
         return getData(node, false);
@@ -35,7 +35,10 @@
 #include "Reader.h"
 #include "IBlockHeader.h"
 #include "EvioNode.h"
+#include "EventHeaderParser.h"
+#include "StructureIndex.h"
 #include "RecordNode.h"
+#include "StructureEdits.h"
 
 
 namespace evio {
@@ -60,7 +63,7 @@ namespace evio {
         bool closed = false;
 
         /** Dictionary object created from dictionaryXML string. */
-        std::shared_ptr<EvioXMLDictionary> dictionary = nullptr;
+        std::shared_ptr<const EvioXMLDictionary> dictionary = nullptr;
 
         /** File name if any. */
         std::string path;
@@ -69,8 +72,10 @@ namespace evio {
 
         explicit EvioCompactReaderV6(std::string const & path);
         explicit EvioCompactReaderV6(std::shared_ptr<ByteBuffer> & byteBuffer);
+        EvioCompactReaderV6(std::shared_ptr<ByteBuffer> & byteBuffer, std::shared_ptr<EvioNodeSource> const & pool);
 
         void setBuffer(std::shared_ptr<ByteBuffer> & buf) override ;
+        void setBuffer(std::shared_ptr<ByteBuffer> & buf, std::shared_ptr<EvioNodeSource> const & pool) override ;
 
         bool isFile() override ;
         bool isCompressed() override ;
@@ -80,7 +85,7 @@ namespace evio {
         std::string getPath() override ;
         ByteOrder getFileByteOrder() override ;
         std::string getDictionaryXML() override ;
-        std::shared_ptr<EvioXMLDictionary> getDictionary() override ;
+        std::shared_ptr<const EvioXMLDictionary> getDictionary() override ;
         bool hasDictionary() override ;
 
 
@@ -102,14 +107,17 @@ namespace evio {
         void searchEvent(size_t eventNumber, uint16_t tag, uint8_t num,
                          std::vector<std::shared_ptr<EvioNode>> & vec) override ;
         void searchEvent(size_t eventNumber, std::string const & dictName,
-                         std::shared_ptr<EvioXMLDictionary> & dictionary,
+                         std::shared_ptr<const EvioXMLDictionary> const & dictionary,
                          std::vector<std::shared_ptr<EvioNode>> & vec) override ;
+        void indexEvent(size_t eventNumber, StructureIndex & index) override ;
+        uint32_t validateEvent(size_t eventNumber) override ;
 
 
         std::shared_ptr<ByteBuffer> removeEvent(size_t eventNumber) override ;
 
         std::shared_ptr<ByteBuffer> removeStructure(std::shared_ptr<EvioNode> & removeNode) override ;
         std::shared_ptr<ByteBuffer> addStructure(size_t eventNumber, ByteBuffer & addBuffer) override ;
+        std::shared_ptr<ByteBuffer> applyEdits(StructureEdits & edits);
 
         std::shared_ptr<ByteBuffer> getData(std::shared_ptr<EvioNode> & node) override ;
         std::shared_ptr<ByteBuffer> getData(std::shared_ptr<EvioNode> & node, bool copy) override ;
@@ -0,0 +1,258 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "EvioConverter.h"
+
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+#include <exception>
+
+#include <boost/thread.hpp>
+
+#include "EvioReaderV4.h"
+#include "EventWriter.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** Whole events, one after another, handed from the reading thread to the writing one. */
+        struct Batch {
+            /** Events, headers included. */
+            std::vector<uint8_t> bytes;
+            /** Offset of the end of each event in bytes. */
+            std::vector<size_t> ends;
+        };
+
+
+        /** Batches going back and forth between the reading and writing threads. */
+        struct Pipeline {
+            std::mutex mtx;
+            std::condition_variable cond;
+            /** Batches ready to write, in order. */
+            std::deque<std::unique_ptr<Batch>> full;
+            /** Batches ready to fill. */
+            std::deque<std::unique_ptr<Batch>> free;
+            /** Has the reading thread read all events? */
+            bool done = false;
+            /** Has writing quit early? */
+            bool quit = false;
+            /** First error in reading thread. */
+            std::exception_ptr error;
+        };
+
+
+        /**
+         * Append an event, bank header and data, to the end of a vector.
+         * @param event event read.
+         * @param order byte order of event's data, and of header written.
+         * @param out   vector to append to.
+         */
+        void packEvent(EvioEvent & event, ByteOrder const & order, std::vector<uint8_t> & out) {
+            auto header = event.getHeader();
+            ByteBufferView data = event.getRawBytesView();
+
+            uint32_t words[2];
+            words[0] = header->getLength();
+            words[1] = ((uint32_t)header->getTag() << 16) | ((uint32_t)header->getPadding() << 14) |
+                       ((header->getDataTypeValue() & 0x3f) << 8) | header->getNumber();
+            if (!order.isLocalEndian()) {
+                words[0] = SWAP_32(words[0]);
+                words[1] = SWAP_32(words[1]);
+            }
+
+            size_t pos = out.size();
+            out.resize(pos + 8 + data.size());
+            std::memcpy(out.data() + pos, words, 8);
+            if (!data.empty()) {
+                std::memcpy(out.data() + pos + 8, data.data(), data.size());
+            }
+        }
+
+
+        /**
+         * Read the rest of the events of a file into batches, in the reading thread.
+         * @param reader  reader of file.
+         * @param order   byte order of file.
+         * @param options conversion options.
+         * @param pipe    where batches come from and go to.
+         */
+        void readEvents(EvioReaderV4 & reader, ByteOrder const & order,
+                        EvioConverter::Options const & options, Pipeline & pipe) {
+            try {
+                bool more = true;
+                while (more) {
+                    std::unique_ptr<Batch> batch;
+                    {
+                        std::unique_lock<std::mutex> lock(pipe.mtx);
+                        pipe.cond.wait(lock, [&pipe] {return pipe.quit || !pipe.free.empty();});
+                        if (pipe.quit) return;
+                        batch = std::move(pipe.free.front());
+                        pipe.free.pop_front();
+                    }
+
+                    batch->bytes.clear();
+                    batch->ends.clear();
+
+                    while (batch->bytes.size() < options.batchBytes) {
+                        auto event = reader.nextEvent();
+                        if (event == nullptr) {
+                            more = false;
+                            break;
+                        }
+                        packEvent(*event, order, batch->bytes);
+                        batch->ends.push_back(batch->bytes.size());
+                    }
+
+                    std::lock_guard<std::mutex> lock(pipe.mtx);
+                    pipe.full.push_back(std::move(batch));
+                    pipe.cond.notify_all();
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(pipe.mtx);
+                pipe.error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(pipe.mtx);
+            pipe.done = true;
+            pipe.cond.notify_all();
+        }
+    }
+
+
+    /**
+     * Convert an evio file of version 1-4 into an LZ4 compressed, evio version 6 file
+     * using a compression thread for each core.
+     *
+     * @param input   file to convert.
+     * @param output  file to write.
+     * @return what was converted.
+     * @throws EvioException if input cannot be read or is not evio version 1-4;
+     *                       if output exists, or cannot be written.
+     */
+    EvioConverter::Stats EvioConverter::convert(std::string const & input, std::string const & output) {
+        return convert(input, output, Options());
+    }
+
+
+    /**
+     * Convert an evio file of version 1-4 into an evio version 6 file.
+     *
+     * @param input   file to convert.
+     * @param output  file to write.
+     * @param options how to convert.
+     * @return what was converted.
+     * @throws EvioException if input cannot be read or is not evio version 1-4;
+     *                       if output exists and overwrite is not set, or cannot be written.
+     */
+    EvioConverter::Stats EvioConverter::convert(std::string const & input, std::string const & output,
+                                                Options const & options) {
+
+        auto start = std::chrono::steady_clock::now();
+        Stats stats;
+
+        EvioReaderV4 reader(input, false, false, options.memoryMapped ?
+                                                 EvioReaderV4::MEMORY_MAPPED : EvioReaderV4::READ_AHEAD);
+        if (reader.getEvioVersion() > 4) {
+            throw EvioException("not evio version 1-4, " + input);
+        }
+
+        ByteOrder order = reader.getByteOrder();
+        stats.bytesRead = reader.fileSize();
+
+        uint32_t threads = options.compressionThreads;
+        if (threads == 0) threads = std::max(1U, boost::thread::hardware_concurrency());
+
+        std::string dictionary = reader.getDictionaryXML();
+        stats.dictionary = !dictionary.empty();
+
+        EventWriter writer(output, "", "", 0, 0, options.maxRecordSize, options.maxEventCount,
+                           order, dictionary, options.overwrite, false, nullptr, 0, 0, 1, 1,
+                           options.compression, threads, options.ringSize, 0);
+
+        // The first event goes into the file header, the next event read follows it
+        if (reader.getEvioVersion() == 4 && reader.hasFirstEvent()) {
+            auto first = reader.getFirstEvent();
+            if (first != nullptr) {
+                std::vector<uint8_t> bytes;
+                packEvent(*first, order, bytes);
+                auto buf = std::make_shared<ByteBuffer>(bytes.size());
+                buf->order(order);
+                std::memcpy(buf->array(), bytes.data(), bytes.size());
+                writer.setFirstEvent(buf);
+                stats.firstEvent = true;
+            }
+        }
+
+        Pipeline pipe;
+        for (uint32_t i=0; i < std::max(2U, options.batches); i++) {
+            pipe.free.emplace_back(new Batch());
+            pipe.free.back()->bytes.reserve(options.batchBytes + 65536);
+        }
+
+        boost::thread readThread([&reader, &order, &options, &pipe] {
+            readEvents(reader, order, options, pipe);
+        });
+
+        try {
+            while (true) {
+                std::unique_ptr<Batch> batch;
+                {
+                    std::unique_lock<std::mutex> lock(pipe.mtx);
+                    pipe.cond.wait(lock, [&pipe] {return pipe.done || !pipe.full.empty();});
+                    if (pipe.full.empty()) break;
+                    batch = std::move(pipe.full.front());
+                    pipe.full.pop_front();
+                }
+
+                size_t begin = 0;
+                for (size_t end : batch->ends) {
+                    writer.writeEvent(ByteBufferView(batch->bytes.data() + begin, end - begin, order));
+                    begin = end;
+                }
+                stats.events += batch->ends.size();
+
+                std::lock_guard<std::mutex> lock(pipe.mtx);
+                pipe.free.push_back(std::move(batch));
+                pipe.cond.notify_all();
+            }
+        }
+        catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(pipe.mtx);
+                pipe.quit = true;
+                pipe.cond.notify_all();
+            }
+            readThread.join();
+            throw;
+        }
+
+        readThread.join();
+        if (pipe.error) {
+            std::rethrow_exception(pipe.error);
+        }
+
+        writer.close();
+        reader.close();
+
+        stats.bytesWritten = fs::file_size(fs::path(output));
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+}
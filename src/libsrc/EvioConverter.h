@@ -0,0 +1,94 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVIOCONVERTER_H
+#define EVIO_6_0_EVIOCONVERTER_H
+
+
+#include <cstdint>
+#include <string>
+
+
+#include "Compressor.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class converts files of evio versions 1-4 into evio version 6, compressed.
+     * The work is pipelined over threads. A reading thread reads the old file with an
+     * {@link EvioReaderV4} and packs whole events, headers included, into batches.
+     * The calling thread hands those events to an {@link EventWriter} which builds
+     * records, compresses them in multiple threads, and writes them in yet another.<p>
+     *
+     * Events are copied as they are, in their original byte order, with no parsing.
+     * Any dictionary is carried over. Any first event (version 4) becomes the
+     * first event of the new file, and so is no longer one of its regular events.
+     * The output is not split.
+     *
+     * <pre><code>
+     *    EvioConverter::Options options;
+     *    options.compression = Compressor::LZ4;
+     *    auto stats = EvioConverter::convert("run1.evio", "run1.v6.evio", options);
+     * </code></pre>
+     */
+    class EvioConverter {
+
+    public:
+
+        /** How to convert. */
+        struct Options {
+            /** Compression of output records. */
+            Compressor::CompressionType compression = Compressor::LZ4;
+            /** Number of compression threads, 0 for one per core. */
+            uint32_t compressionThreads = 0;
+            /** Max bytes of an output record's events, 0 for the EventWriter default. */
+            uint32_t maxRecordSize = 0;
+            /** Max events in an output record, 0 for the EventWriter default. */
+            uint32_t maxEventCount = 0;
+            /** Number of records in the writer's ring, 0 for the EventWriter default. */
+            uint32_t ringSize = 0;
+            /** Memory map the input instead of reading it ahead in large chunks. */
+            bool memoryMapped = false;
+            /** Overwrite an existing output file. */
+            bool overwrite = false;
+            /** Bytes of events in each batch handed from the reading thread. */
+            size_t batchBytes = 4000000;
+            /** Number of batches which may be read ahead of writing. */
+            uint32_t batches = 4;
+        };
+
+        /** What was converted. */
+        struct Stats {
+            /** Regular events written, not counting any first event. */
+            uint64_t events = 0;
+            /** Size of input file in bytes. */
+            uint64_t bytesRead = 0;
+            /** Size of output file in bytes. */
+            uint64_t bytesWritten = 0;
+            /** Was there a dictionary? */
+            bool dictionary = false;
+            /** Was there a first event? */
+            bool firstEvent = false;
+            /** Time taken in seconds. */
+            double seconds = 0.;
+        };
+
+        static Stats convert(std::string const & input, std::string const & output);
+        static Stats convert(std::string const & input, std::string const & output,
+                             Options const & options);
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVIOCONVERTER_H
@@ -329,6 +329,12 @@ namespace evio {
          */
         uint8_t getNum() const {return num;}
 
+        /**
+         * Is the num value being used?
+         * @return true if num value is valid.
+         */
+        bool isNumValid() const {return numValid;}
+
         /**
          * Get the data's type.
          * @return data type object, null if nonexistent.
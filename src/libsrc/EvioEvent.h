@@ -14,6 +14,7 @@
 #include <cstring>
 #include <sstream>
 #include <memory>
+#include <vector>
 
 #include "ByteBuffer.h"
 #include "DataType.h"
@@ -38,6 +39,8 @@ namespace evio {
      */
     class EvioEvent : public EvioBank {
 
+        friend class EventParser;
+
     private:
 
         /** Constructor. */
@@ -95,6 +98,16 @@ namespace evio {
         /** There may be a dictionary in xml associated with this event. Or there may not. */
         std::string dictionaryXML{""};
 
+        /**
+         * Banks, segments, and tagsegments which were in this event before it was last
+         * filled again by {@link EventParser#parseEvent(const uint8_t *, size_t, ByteOrder const &, std::shared_ptr<EvioEvent> &)},
+         * kept so the next parse can reuse them instead of allocating new ones.
+         * Each is held in the reverse of the order in which it was found.
+         */
+        std::vector<std::shared_ptr<BaseStructure>> spareBanks;
+        std::vector<std::shared_ptr<BaseStructure>> spareSegments;
+        std::vector<std::shared_ptr<BaseStructure>> spareTagSegments;
+
     protected:
 
         /** Has this been parsed yet or not? */
@@ -259,13 +259,13 @@ namespace evio {
 
     /**
      * Copy parameters from a parent node when scanning evio data and
-     * placing into EvioNode obtained from an EvioNodeSource.
+     * placing into a new EvioNode or one obtained from an EvioNodeSource.
+     * The parent's allNodes is not copied since only the event's is ever used.
      * @param parent parent of the object.
      */
     void EvioNode::copyParentForScan(std::shared_ptr<EvioNode> & parent) {
         recordNode = parent->recordNode;
         buffer     = parent->buffer;
-        allNodes   = parent->allNodes;
         eventNode  = parent->eventNode;
         place      = parent->place;
         scanned    = parent->scanned;
@@ -308,7 +308,7 @@ namespace evio {
         izEvent = obsolete = scanned = false;
         data.clear();
         recordNode.clear();
-        buffer->clear();
+        buffer     = nullptr;
         eventNode  = nullptr;
         parentNode = nullptr;
     }
@@ -438,6 +438,77 @@ namespace evio {
     }
 
 
+    /**
+     * This method extracts an EvioNode object representing an
+     * evio event (top level evio bank) from a given buffer, a
+     * location in the buffer, and a few other things. The node
+     * is taken from the given source instead of being created.
+     *
+     * @param buffer     buffer to examine
+     * @param nodeSource source of EvioNode objects
+     * @param recNode    object holding data about block header
+     * @param position   position in buffer
+     * @param place      place of event in buffer (starting at 0)
+     *
+     * @return EvioNode object containing evio event information
+     * @throws EvioException if not enough data in buffer to read evio bank header (8 bytes).
+     */
+    std::shared_ptr<EvioNode> EvioNode::extractEventNode(std::shared_ptr<ByteBuffer> & buffer,
+                                                         EvioNodeSource & nodeSource,
+                                                         RecordNode & recNode,
+                                                         size_t position, uint32_t place) {
+
+        if (buffer->remaining() < 8) {
+            throw EvioException("buffer underflow");
+        }
+
+        // Set the same things as the constructor used by the method above
+        auto node = nodeSource.getNode();
+        node->pos        = position;
+        node->place      = place;
+        node->recordNode = recNode;
+        node->buffer     = buffer;
+        node->izEvent    = true;
+        node->type       = DataType::BANK.getValue();
+        return extractNode(node, position);
+    }
+
+
+    /**
+     * This method extracts an EvioNode object representing an
+     * evio event (top level evio bank) from a given buffer, a
+     * location in the buffer, and a few other things. The node
+     * is taken from the given source instead of being created.
+     *
+     * @param buffer       buffer to examine
+     * @param nodeSource   source of EvioNode objects
+     * @param recPosition  position of containing record
+     * @param position     position in buffer
+     * @param place        place of event in buffer (starting at 0)
+     *
+     * @return EvioNode object containing evio event information
+     * @throws EvioException if not enough data in buffer to read evio bank header (8 bytes).
+     */
+    std::shared_ptr<EvioNode> EvioNode::extractEventNode(std::shared_ptr<ByteBuffer> & buffer,
+                                                         EvioNodeSource & nodeSource,
+                                                         size_t recPosition,
+                                                         size_t position, uint32_t place) {
+
+        if (buffer->remaining() < 8) {
+            throw EvioException("buffer underflow");
+        }
+
+        auto node = nodeSource.getNode();
+        node->pos       = position;
+        node->place     = place;
+        node->recordPos = recPosition;
+        node->buffer    = buffer;
+        node->izEvent   = true;
+        node->type      = DataType::BANK.getValue();
+        return extractNode(node, position);
+    }
+
+
     /**
      * This method populates an EvioNode object that will represent an
      * evio bank from that same node containing a reference to the
@@ -502,6 +573,68 @@ namespace evio {
      * @param node node being scanned
      */
     void EvioNode::scanStructure(std::shared_ptr<EvioNode> & node) {
+        scanStructure(node, nullptr);
+    }
+
+
+    /**
+     * This method recursively stores, in the given list, all the information
+     * about an evio structure's children found in the given ByteBuffer object.
+     * It uses absolute gets so buffer's position does <b>not</b> change.
+     * The child nodes are taken from the given source instead of being created.
+     *
+     * @param node       node being scanned
+     * @param nodeSource source of EvioNode objects
+     */
+    void EvioNode::scanStructure(std::shared_ptr<EvioNode> & node, EvioNodeSource & nodeSource) {
+        scanStructure(node, &nodeSource);
+    }
+
+
+    /**
+     * This method recursively stores, in the given list, all the information
+     * about an evio structure's children found in the given ByteBuffer object.
+     * It uses absolute gets so buffer's position does <b>not</b> change.
+     *
+     * @param node       node being scanned
+     * @param nodeSource source of EvioNode objects, or null to create them
+     */
+    void EvioNode::scanStructure(std::shared_ptr<EvioNode> & node, EvioNodeSource *nodeSource) {
+        scanStructure(node, nodeSource, node->dataPos);
+    }
+
+
+    /**
+     * This method recursively stores the information about an evio structure's children
+     * starting at the given position in its data, adding them after any children it already has.
+     * Used to scan only what was appended to a structure already scanned.
+     *
+     * @param node       node being scanned
+     * @param nodeSource source of EvioNode objects, or null to create them
+     * @param position   position in buffer of the first child to scan
+     */
+    void EvioNode::scanStructure(std::shared_ptr<EvioNode> & node, EvioNodeSource *nodeSource, size_t position) {
+        // Test byte order once for the whole event, not for each header word
+        if (node->buffer->isSwapped()) {
+            scanStructureAs<true>(node, nodeSource, position);
+        }
+        else {
+            scanStructureAs<false>(node, nodeSource, position);
+        }
+    }
+
+
+    /**
+     * Implementation of {@link #scanStructure(std::shared_ptr<EvioNode> &, EvioNodeSource *, size_t)}
+     * with the buffer's byte order fixed at compile time.
+     *
+     * @tparam SWAP      true if buffer data must be swapped.
+     * @param node       node being scanned
+     * @param nodeSource source of EvioNode objects, or null to create them
+     * @param position   position in buffer of the first child to scan
+     */
+    template<bool SWAP>
+    void EvioNode::scanStructureAs(std::shared_ptr<EvioNode> & node, EvioNodeSource *nodeSource, size_t position) {
 
         uint32_t dType = node->dataType;
 
@@ -510,13 +643,11 @@ namespace evio {
             return;
         }
 
-        // Start at beginning position of evio structure being scanned
-        size_t position = node->dataPos;
-        // Don't go past the data's end which is (position + length)
+        // Don't go past the data's end which is (data position + length)
         // of evio structure being scanned in bytes.
-        size_t endingPos = position + 4*node->dataLen;
+        size_t endingPos = node->dataPos + 4*node->dataLen;
         // Buffer we're using
-        auto buffer = node->buffer;
+        ByteBuffer *buffer = node->buffer.get();
 
         uint32_t dt, dataType, dataLen, len, word;
 
@@ -527,14 +658,12 @@ namespace evio {
             endingPos -= 8;
             while (position <= endingPos) {
 
-                // Copy node for setting stuff that's the same as the parent
-                auto kidNode = std::make_shared<EvioNode>(node);
-                // Clear children & data
-                kidNode->childNodes.clear();
-                kidNode->data.clear();
+                // Set stuff that's the same as the parent
+                auto kidNode = (nodeSource == nullptr) ? std::make_shared<EvioNode>() : nodeSource->getNode();
+                kidNode->copyParentForScan(node);
 
                 // Read first header word
-                len = buffer->getInt(position);
+                len = buffer->getAs<SWAP, uint32_t>(position);
                 kidNode->pos = position;
 
                 // Len of data (no header) for a bank
@@ -542,7 +671,7 @@ namespace evio {
                 position += 4;
 
                 // Read and parse second header word
-                word = buffer->getInt(position);
+                word = buffer->getAs<SWAP, uint32_t>(position);
                 position += 4;
                 kidNode->tag = (word >> 16) & 0xffff;
                 dt = (word >> 8) & 0xff;
@@ -558,14 +687,13 @@ namespace evio {
                 kidNode->dataType = dataType;
                 kidNode->izEvent = false;
 
-                // Create the tree structure
-                kidNode->parentNode = node;
                 // Add this to list of children and to list of all nodes in the event
+                // (copyParentForScan already made node the parent)
                 node->addChild(kidNode);
 
                 // Only scan through this child if it's a container
                 if (DataType::isStructure(dataType)) {
-                    scanStructure(kidNode);
+                    scanStructureAs<SWAP>(kidNode, nodeSource, kidNode->dataPos);
                 }
 
                 // Set position to start of next header (hop over kid's data)
@@ -578,15 +706,13 @@ namespace evio {
             // Make allowance for reading header (1 int).
             endingPos -= 4;
             while (position <= endingPos) {
-                // Copy node for setting stuff that's the same as the parent
-                auto kidNode = std::make_shared<EvioNode>(node);
-                // Clear children & data
-                kidNode->childNodes.clear();
-                kidNode->data.clear();
+                // Set stuff that's the same as the parent
+                auto kidNode = (nodeSource == nullptr) ? std::make_shared<EvioNode>() : nodeSource->getNode();
+                kidNode->copyParentForScan(node);
 
                 kidNode->pos = position;
 
-                word = buffer->getInt(position);
+                word = buffer->getAs<SWAP, uint32_t>(position);
                 position += 4;
                 kidNode->tag = (word >> 24) & 0xff;
                 dt = (word >> 16) & 0xff;
@@ -603,11 +729,10 @@ namespace evio {
                 kidNode->dataType = dataType;
                 kidNode->izEvent  = false;
 
-                kidNode->parentNode = node;
                 node->addChild(kidNode);
 
                 if (DataType::isStructure(dataType)) {
-                    scanStructure(kidNode);
+                    scanStructureAs<SWAP>(kidNode, nodeSource, kidNode->dataPos);
                 }
 
                 position += 4*len;
@@ -620,15 +745,13 @@ namespace evio {
             // Make allowance for reading header (1 int).
             endingPos -= 4;
             while (position <= endingPos) {
-                // Copy node for setting stuff that's the same as the parent
-                auto kidNode = std::make_shared<EvioNode>(node);
-                // Clear children & data
-                kidNode->childNodes.clear();
-                kidNode->data.clear();
+                // Set stuff that's the same as the parent
+                auto kidNode = (nodeSource == nullptr) ? std::make_shared<EvioNode>() : nodeSource->getNode();
+                kidNode->copyParentForScan(node);
 
                 kidNode->pos = position;
 
-                word = buffer->getInt(position);
+                word = buffer->getAs<SWAP, uint32_t>(position);
                 position += 4;
                 kidNode->tag = (word >> 20) & 0xfff;
                 dataType    = (word >> 16) & 0xf;
@@ -643,11 +766,10 @@ namespace evio {
                 kidNode->dataType = dataType;
                 kidNode->izEvent  = false;
 
-                kidNode->parentNode = node;
                 node->addChild(kidNode);
 
                 if (DataType::isStructure(dataType)) {
-                    scanStructure(kidNode);
+                    scanStructureAs<SWAP>(kidNode, nodeSource, kidNode->dataPos);
                 }
 
                 position += 4*len;
@@ -1158,15 +1280,14 @@ namespace evio {
     /**
      * Get the data associated with this node as an 32-bit integer vector.
      * Store it and return it in future calls (like in event builder).
+     * Data is copied out of the buffer and swapped to local byte order only on the first call.
      * If data is of a type less than 32 bits, the last int will be junk.
      *
      * @return integer array containing data.
      */
     std::vector<uint32_t> & EvioNode::getIntData() {
         if (data.empty()) {
-            for (int i = dataPos; i < dataPos + 4 * dataLen; i += 4) {
-                data[(i - dataPos) / 4] = buffer->getInt(i);
-            }
+            getIntData(data);
         }
         return data;
     }
@@ -1174,50 +1295,71 @@ namespace evio {
 
     /**
      * Get the data associated with this node as an 32-bit integer vector.
-     * Place data in the given vector.
+     * Place data in the given vector, swapped to local byte order.
      * If data is of a type less than 32 bits, the last int will be junk.
      *
      * @param intData vector in which to store data.
      */
     void EvioNode::getIntData(std::vector<uint32_t> & intData) {
-        intData.clear();
-
-        for (int i = dataPos; i < dataPos + 4*dataLen; i+= 4) {
-            intData[(i-dataPos)/4] = buffer->getInt(i);
+        // If cached, don't copy and swap again
+        if (!data.empty() && &intData != &data) {
+            intData = data;
+            return;
         }
 
-        // added dataLen number of elements
+        intData.resize(dataLen);
+        if (dataLen == 0) return;
+
+        const uint8_t *src = buffer->array() + buffer->arrayOffset() + dataPos;
+        if (buffer->order().isLocalEndian()) {
+            std::memcpy(intData.data(), src, 4*dataLen);
+        }
+        else {
+            ByteOrder::byteSwap32((uint32_t *) src, dataLen, intData.data());
+        }
     }
 
 
     /**
      * Get the data associated with this node as an 64-bit integer vector.
-     * Place data in the given vector.
+     * Place data in the given vector, swapped to local byte order.
      * If data is of a type less than 64 bits, the last element may be junk.
      *
      * @param longData vector in which to store data.
      */
     void EvioNode::getLongData(std::vector<uint64_t> & longData) {
-        longData.clear();
+        size_t count = dataLen/2;
+        longData.resize(count);
+        if (count == 0) return;
 
-        for (int i = dataPos; i < dataPos + 4*dataLen; i+= 8) {
-            longData[(i-dataPos)/8] = buffer->getLong(i);
+        const uint8_t *src = buffer->array() + buffer->arrayOffset() + dataPos;
+        if (buffer->order().isLocalEndian()) {
+            std::memcpy(longData.data(), src, 8*count);
+        }
+        else {
+            ByteOrder::byteSwap64((uint64_t *) src, count, longData.data());
         }
     }
 
 
     /**
      * Get the data associated with this node as an 16-bit integer vector.
-     * Place data in the given vector.
+     * Place data in the given vector, swapped to local byte order.
      * If data is of a type less than 16 bits, the last element may be junk.
      *
      * @param shortData vectro in which to store data.
      */
     void EvioNode::getShortData(std::vector<uint16_t> & shortData) {
-        shortData.clear();
+        size_t count = 2*dataLen;
+        shortData.resize(count);
+        if (count == 0) return;
 
-        for (int i = dataPos; i < dataPos + 4*dataLen; i+= 2) {
-            shortData[(i-dataPos)/2] = buffer->getShort(i);
+        const uint8_t *src = buffer->array() + buffer->arrayOffset() + dataPos;
+        if (buffer->order().isLocalEndian()) {
+            std::memcpy(shortData.data(), src, 2*count);
+        }
+        else {
+            ByteOrder::byteSwap16((uint16_t *) src, count, shortData.data());
         }
     }
 
@@ -1265,5 +1407,27 @@ namespace evio {
         return dest;
     }
 
+
+    /**
+     * Get a view of the data associated with this node without copying it
+     * or creating a ByteBuffer. Valid as long as this node's buffer is unchanged.
+     * @return view of this node's data, padding excluded, in the buffer's byte order.
+     */
+    ByteBufferView EvioNode::getByteDataView() const {
+        return ByteBufferView(buffer->array() + buffer->arrayOffset() + dataPos,
+                              4*dataLen - pad, buffer->order());
+    }
+
+
+    /**
+     * Get a view of this node's entire evio structure, header included, without copying it
+     * or creating a ByteBuffer. Valid as long as this node's buffer is unchanged.
+     * @return view of this node's evio structure in the buffer's byte order.
+     */
+    ByteBufferView EvioNode::getStructureView() const {
+        return ByteBufferView(buffer->array() + buffer->arrayOffset() + pos,
+                              getTotalBytes(), buffer->order());
+    }
+
 }
 
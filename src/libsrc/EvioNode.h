@@ -21,8 +21,10 @@
 
 #include "ByteOrder.h"
 #include "ByteBuffer.h"
+#include "ByteBufferView.h"
 #include "DataType.h"
 #include "RecordNode.h"
+#include "EvioNodeSource.h"
 #include "EvioException.h"
 
 
@@ -44,6 +46,8 @@ namespace evio {
         friend class EventHeaderParser;
         friend class EvioCompactReaderV4;
         friend class EvioCompactReaderV6;
+        friend class Reader;
+        friend class StructureTransformer;
 
     private:
 
@@ -152,6 +156,11 @@ namespace evio {
         RecordNode & getRecordNode(); // public?
         void copy(const EvioNode & src);
 
+        static void scanStructure(std::shared_ptr<EvioNode> & node, EvioNodeSource *nodeSource);
+        static void scanStructure(std::shared_ptr<EvioNode> & node, EvioNodeSource *nodeSource, size_t position);
+        template<bool SWAP>
+        static void scanStructureAs(std::shared_ptr<EvioNode> & node, EvioNodeSource *nodeSource, size_t position);
+
     protected:
 
         explicit EvioNode(std::shared_ptr<EvioNode> & firstNode, int dummy);
@@ -172,6 +181,7 @@ namespace evio {
         ~EvioNode() = default;
 
         static void scanStructure(std::shared_ptr<EvioNode> & node);
+        static void scanStructure(std::shared_ptr<EvioNode> & node, EvioNodeSource & nodeSource);
 
         static std::shared_ptr<EvioNode> & extractNode(std::shared_ptr<EvioNode> & bankNode, size_t position);
         static std::shared_ptr<EvioNode> extractEventNode(std::shared_ptr<ByteBuffer> & buffer,
@@ -180,6 +190,14 @@ namespace evio {
         static std::shared_ptr<EvioNode> extractEventNode(std::shared_ptr<ByteBuffer> & buffer,
                                                           size_t recPosition,
                                                           size_t position, uint32_t place);
+        static std::shared_ptr<EvioNode> extractEventNode(std::shared_ptr<ByteBuffer> & buffer,
+                                                          EvioNodeSource & nodeSource,
+                                                          RecordNode & recNode,
+                                                          size_t position, uint32_t place);
+        static std::shared_ptr<EvioNode> extractEventNode(std::shared_ptr<ByteBuffer> & buffer,
+                                                          EvioNodeSource & nodeSource,
+                                                          size_t recPosition,
+                                                          size_t position, uint32_t place);
 
         EvioNode & operator=(const EvioNode& other);
         bool operator==(const EvioNode& src) const;
@@ -235,6 +253,8 @@ namespace evio {
         ByteBuffer & getByteData(ByteBuffer & dest, bool copy);
         std::shared_ptr<ByteBuffer> & getByteData(std::shared_ptr<ByteBuffer> & dest, bool copy);
         std::shared_ptr<ByteBuffer> getByteData(bool copy);
+        ByteBufferView getByteDataView() const;
+        ByteBufferView getStructureView() const;
 
         std::vector<uint32_t> & getIntData();
         void getIntData(std::vector<uint32_t> & intData);
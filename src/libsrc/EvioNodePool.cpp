@@ -0,0 +1,82 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "EvioNodePool.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param initialSize number of nodes to create up front.
+     */
+    EvioNodePool::EvioNodePool(uint32_t initialSize) {
+        nodePool.reserve(initialSize);
+        for (uint32_t i=0; i < initialSize; i++) {
+            nodePool.push_back(std::make_shared<EvioNode>());
+        }
+    }
+
+
+    /**
+     * Destructor. Nodes refer to each other (parent, children, event) and
+     * would keep each other alive, so clear them all first.
+     */
+    EvioNodePool::~EvioNodePool() {
+        for (auto & node : nodePool) {
+            node->clear();
+        }
+    }
+
+
+    /** Add nodes to the pool, doubling its size but at least adding poolIncrementSize. */
+    void EvioNodePool::increasePool() {
+        size_t newSize = nodePool.size() + std::max<size_t>(nodePool.size(), poolIncrementSize);
+        nodePool.reserve(newSize);
+        while (nodePool.size() < newSize) {
+            nodePool.push_back(std::make_shared<EvioNode>());
+        }
+    }
+
+
+    /**
+     * Get the number of nodes handed out since the last reset.
+     * @return number of nodes handed out since the last reset.
+     */
+    uint32_t EvioNodePool::getUsed() const {return nodeCount;}
+
+
+    /**
+     * Get the total number of nodes in the pool.
+     * @return total number of nodes in the pool.
+     */
+    uint32_t EvioNodePool::getSize() const {return nodePool.size();}
+
+
+    /**
+     * {@inheritDoc}
+     * If all nodes are in use, the pool grows.
+     */
+    std::shared_ptr<EvioNode> EvioNodePool::getNode() {
+        if (nodeCount >= nodePool.size()) {
+            increasePool();
+        }
+
+        auto & node = nodePool[nodeCount++];
+        node->clear();
+        return node;
+    }
+
+
+    /** {@inheritDoc} */
+    void EvioNodePool::reset() {nodeCount = 0;}
+
+}
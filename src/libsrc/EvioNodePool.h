@@ -0,0 +1,70 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVIONODEPOOL_H
+#define EVIO_6_0_EVIONODEPOOL_H
+
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+#include "EvioNodeSource.h"
+#include "EvioNode.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a pool of EvioNode objects which are handed out, one after the
+     * other, and all made available again by calling {@link #reset()}.
+     * Readers given a pool reset it each time they scan a new buffer, so
+     * once warmed up, scanning events allocates no memory. That includes the
+     * storage of each node's child and data vectors which are kept when reused.<p>
+     *
+     * The pool grows as needed and never shrinks. Since it owns its nodes,
+     * clearing them when destroyed, nodes obtained from it must not be used after
+     * either the next reset or the pool's destruction. It is not thread-safe.
+     */
+    class EvioNodePool : public EvioNodeSource {
+
+    private:
+
+        /** Minimum number of nodes to add when the pool is empty. */
+        static const uint32_t poolIncrementSize = 100;
+
+        /** All the nodes in this pool. */
+        std::vector<std::shared_ptr<EvioNode>> nodePool;
+
+        /** Number of nodes handed out since last reset. */
+        uint32_t nodeCount = 0;
+
+        void increasePool();
+
+    public:
+
+        explicit EvioNodePool(uint32_t initialSize = 1000);
+        EvioNodePool(const EvioNodePool & pool) = delete;
+        EvioNodePool & operator=(const EvioNodePool & other) = delete;
+        ~EvioNodePool() override;
+
+        uint32_t getUsed() const;
+        uint32_t getSize() const;
+
+        std::shared_ptr<EvioNode> getNode() override;
+        void reset() override;
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVIONODEPOOL_H
@@ -0,0 +1,48 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVIONODESOURCE_H
+#define EVIO_6_0_EVIONODESOURCE_H
+
+
+#include <memory>
+
+
+namespace evio {
+
+    // forward declaration so we can compile
+    class EvioNode;
+
+    /**
+     * This interface is for a source of reusable EvioNode objects, so that scanning
+     * evio data does not need to allocate a new node for each evio structure found.
+     * Nodes obtained from a source are only valid until it is reset,
+     * after which they are handed out again and overwritten.
+     */
+    class EvioNodeSource {
+
+    public:
+
+        virtual ~EvioNodeSource() = default;
+
+        /**
+         * Get a node, cleared and ready to be filled.
+         * @return node, cleared and ready to be filled.
+         */
+        virtual std::shared_ptr<EvioNode> getNode() = 0;
+
+        /** Make all nodes available again. Nodes obtained previously must no longer be used. */
+        virtual void reset() = 0;
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVIONODESOURCE_H
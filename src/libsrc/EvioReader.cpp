@@ -179,6 +179,14 @@ namespace evio {
     std::shared_ptr<EvioEvent> EvioReader::parseNextEvent() {return reader->parseNextEvent();}
 
 
+    /** {@inheritDoc} */
+    bool EvioReader::parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) {return reader->parseNextEvent(evioEvent);}
+
+
+    /** {@inheritDoc} */
+    void EvioReader::parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) {reader->parseEvent(index, evioEvent);}
+
+
     /** {@inheritDoc} */
     void EvioReader::parseEvent(std::shared_ptr<EvioEvent> evioEvent) {reader->parseEvent(evioEvent);}
 
@@ -102,6 +102,8 @@ namespace evio {
         std::shared_ptr<EvioEvent> parseEvent(size_t index) override;
         std::shared_ptr<EvioEvent> nextEvent() override;
         std::shared_ptr<EvioEvent> parseNextEvent() override;
+        bool parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) override;
+        void parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) override;
         void parseEvent(std::shared_ptr<EvioEvent> evioEvent) override;
 
 
@@ -11,6 +11,9 @@
 
 #include "EvioReaderV4.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace evio {
 
     /**
@@ -24,7 +27,7 @@ namespace evio {
         currentState->blockNumberExpected = blockNumberExpected;
 
         if (sequentialRead) {
-            currentState->filePosition = file.tellg();
+            currentState->filePosition = fileTell();
         }
         currentState->byteBufferLimit = byteBuffer->limit();
         currentState->byteBufferPosition = byteBuffer->position();
@@ -50,7 +53,7 @@ namespace evio {
         blockNumberExpected = state->blockNumberExpected;
 
         if (sequentialRead) {
-            file.seekg(state->filePosition);
+            fileSeek(state->filePosition);
         }
         byteBuffer->limit(state->byteBufferLimit);
         byteBuffer->position(state->byteBufferPosition);
@@ -77,11 +80,12 @@ namespace evio {
      *                       and throw an exception if it is not sequential starting
      *                       with 1
      * @param synced if true, this class's methods are mutex protected for thread safety.
+     * @param mode   how to read the file, streaming block by block by default.
      * @see EventWriter
      * @throws EvioException if file arg is null; if read failure;
      *                       if first block number != 1 when checkBlkNumSeq arg is true
      */
-    EvioReaderV4::EvioReaderV4(std::string const & path, bool checkBlkNumSeq, bool synced) {
+    EvioReaderV4::EvioReaderV4(std::string const & path, bool checkBlkNumSeq, bool synced, ReadMode mode) {
 
         if (path.empty()) {
             throw EvioException("path is empty");
@@ -98,10 +102,12 @@ namespace evio {
             throw EvioException("File too small to have valid evio data");
         }
 
+        this->path = path;
         checkBlockNumSeq = checkBlkNumSeq;
         synchronized = synced;
         sequentialRead = true;
         initialPosition = 0;
+        readMode = mode;
 
         // Look at the first block header to get various info like endianness and version.
         // Store it for later reference in blockHeader2,4 and in other variables.
@@ -122,10 +128,32 @@ namespace evio {
 
         parser = std::make_shared<EventParser>();
 
-        // What we do from here depends on the evio format version.
-        // Do not use memory mapping as the Java version did.
+        // Memory mapping is not the default as the Java version had it.
         // Since evio data files tend to be large (> 2GB), memory mapping
         // can be slower than conventional reads.
+        if (readMode == MEMORY_MAPPED) {
+            mapFile();
+            file.close();
+            sequentialRead = false;
+
+            if (evioVersion > 3) {
+                generateEventPositions(byteBuffer);
+                if (blockHeader4->hasDictionary()) {
+                    prepareForBufferRead(byteBuffer);
+                    readDictionary(byteBuffer);
+                }
+            }
+            else {
+                prepareForBufferRead(byteBuffer);
+            }
+            return;
+        }
+
+        if (readMode == READ_AHEAD) {
+            readAheadBuf.resize(DEFAULT_READ_BYTES);
+        }
+
+        // What we do from here depends on the evio format version.
         if (evioVersion < 4) {
             // Remember, no dictionaries exist for these early versions
 //dataStream = new DataInputStream(fileInputStream);
@@ -135,6 +163,7 @@ namespace evio {
         else {
 //dataStream = new DataInputStream(fileInputStream);
             prepareForSequentialRead();
+            addBlockPosition(0, firstBlockSize, firstBlockHeader4->getEventCount(), lastBlock);
             if (blockHeader4->hasDictionary()) {
                 // Dictionary is always the first event
                 auto dict = parseNextEvent();
@@ -195,6 +224,219 @@ namespace evio {
     }
 
 
+    /**
+     * Memory map the file being read and make it the buffer being read.
+     * The mapping is private and copy-on-write so that events
+     * can be swapped in place without affecting the file.
+     * @throws EvioException if file cannot be opened or mapped.
+     */
+    void EvioReaderV4::mapFile() {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw EvioException("cannot open file " + path);
+        }
+
+        void *pmem = ::mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // Mapping stays valid after fd is closed
+        ::close(fd);
+
+        if (pmem == MAP_FAILED) {
+            throw EvioException("cannot map file " + path);
+        }
+
+        byteBuffer = std::make_shared<ByteBuffer>(static_cast<char *>(pmem), fileBytes, true);
+        byteBuffer->order(byteOrder);
+    }
+
+
+    /**
+     * Read bytes from the file's current position, moving it past them.
+     * If reading ahead, they're copied from the current chunk of file,
+     * which is refilled as needed.
+     *
+     * @param dest  where to put bytes.
+     * @param bytes number of bytes to read.
+     * @throws EvioException if file read failure or not enough data in file.
+     */
+    void EvioReaderV4::fileRead(uint8_t *dest, size_t bytes) {
+        if (readMode != READ_AHEAD) {
+            file.read(reinterpret_cast<char *>(dest), bytes);
+            if (file.fail()) {
+                throw EvioException("file read failure");
+            }
+            return;
+        }
+
+        while (bytes > 0) {
+            if (filePosition >= readAheadStart && filePosition < readAheadStart + readAheadBytes) {
+                size_t offset = filePosition - readAheadStart;
+                size_t n = std::min(bytes, readAheadBytes - offset);
+                std::memcpy(dest, readAheadBuf.data() + offset, n);
+                dest += n;
+                bytes -= n;
+                filePosition += n;
+                continue;
+            }
+
+            if (filePosition >= fileBytes) {
+                throw EvioException("file read failure, past end of file");
+            }
+
+            file.clear();
+            file.seekg(filePosition);
+
+            // Anything bigger than a chunk goes straight to its destination
+            if (bytes >= readAheadBuf.size()) {
+                file.read(reinterpret_cast<char *>(dest), bytes);
+                if (file.fail()) {
+                    throw EvioException("file read failure");
+                }
+                filePosition += bytes;
+                return;
+            }
+
+            size_t n = std::min(readAheadBuf.size(), fileBytes - filePosition);
+            file.read(reinterpret_cast<char *>(readAheadBuf.data()), n);
+            if (file.fail()) {
+                readAheadBytes = 0;
+                throw EvioException("file read failure");
+            }
+            readAheadStart = filePosition;
+            readAheadBytes = n;
+        }
+    }
+
+
+    /**
+     * Set the file's current position.
+     * @param pos position in file.
+     */
+    void EvioReaderV4::fileSeek(size_t pos) {
+        if (readMode == READ_AHEAD) {
+            filePosition = pos;
+            return;
+        }
+        file.clear();
+        file.seekg(pos);
+    }
+
+
+    /**
+     * Get the file's current position.
+     * @return position in file.
+     */
+    size_t EvioReaderV4::fileTell() {
+        if (readMode == READ_AHEAD) {
+            return filePosition;
+        }
+        return file.tellg();
+    }
+
+
+    /**
+     * Remember where a block of a version 4 file is, if it's the one following
+     * the last block found. Called when streaming, as each block is read.
+     *
+     * @param pos    position of block in file.
+     * @param bytes  size of block in bytes.
+     * @param events number of events in block (not counting any dictionary).
+     * @param last   is this the last block?
+     */
+    void EvioReaderV4::addBlockPosition(size_t pos, size_t bytes, uint32_t events, bool last) {
+        if (blockPositionsComplete) return;
+
+        size_t nextPos = 0, eventsBefore = 0;
+        if (!blockPositions.empty()) {
+            auto & prev = blockPositions.back();
+            nextPos = prev.filePosition + prev.bytes;
+            eventsBefore = prev.eventsBefore + prev.eventCount;
+        }
+        if (pos != nextPos) return;
+
+        blockPositions.push_back({pos, bytes, eventsBefore, events});
+        if (last || pos + bytes >= fileBytes) {
+            blockPositionsComplete = true;
+        }
+    }
+
+
+    /**
+     * Find blocks of a version 4 file, by reading only their headers, until the
+     * block containing the given event is found or there are no more blocks.
+     * The file's current position is not changed.
+     *
+     * @param evNumber event number in a 1,2,..N counting sense.
+     * @return true if the block containing the event has been found.
+     * @throws EvioException if file read failure or bad block header.
+     */
+    bool EvioReaderV4::scanBlocks(size_t evNumber) {
+        auto covers = [this, evNumber]() {
+            if (blockPositions.empty()) return false;
+            auto & b = blockPositions.back();
+            return b.eventsBefore + b.eventCount >= evNumber;
+        };
+
+        if (covers()) return true;
+        if (blockPositionsComplete || blockPositions.empty()) return false;
+
+        // Only headers are read, straight from the stream
+        size_t savedPos = fileTell();
+        uint32_t header[8];
+
+        while (!covers() && !blockPositionsComplete) {
+            auto & prev = blockPositions.back();
+            size_t pos = prev.filePosition + prev.bytes;
+            if (pos + 32 > fileBytes) {
+                blockPositionsComplete = true;
+                break;
+            }
+
+            file.clear();
+            file.seekg(pos);
+            file.read(reinterpret_cast<char *>(header), 32);
+            if (file.fail()) {
+                throw EvioException("file read failure");
+            }
+            if (swap) {
+                for (auto & word : header) word = SWAP_32(word);
+            }
+
+            if (header[BlockHeaderV4::EV_MAGIC] != BlockHeaderV4::MAGIC_NUMBER) {
+                throw EvioException("Bad evio format: block header magic # incorrect");
+            }
+
+            size_t blockBytes = 4*(size_t)header[BlockHeaderV4::EV_BLOCKSIZE];
+            if (blockBytes < 32 || pos + blockBytes > fileBytes) {
+                // Partial block at end of file
+                blockPositionsComplete = true;
+                break;
+            }
+
+            addBlockPosition(pos, blockBytes, header[BlockHeaderV4::EV_COUNT],
+                             BlockHeaderV4::isLastBlock(header[BlockHeaderV4::EV_VERSION]));
+        }
+
+        fileSeek(savedPos);
+        return covers();
+    }
+
+
+    /**
+     * Find which block of a version 4 file an event is in, scanning block headers if needed.
+     * @param evNumber event number in a 1,2,..N counting sense.
+     * @return index of block containing the event, or -1 if there's no such event.
+     * @throws EvioException if file read failure or bad block header.
+     */
+    ssize_t EvioReaderV4::findBlock(size_t evNumber) {
+        if (evNumber < 1 || !scanBlocks(evNumber)) return -1;
+
+        // Last block whose first event is at or before evNumber, skipping empty blocks
+        auto it = std::upper_bound(blockPositions.begin(), blockPositions.end(), evNumber - 1,
+                                   [](size_t ev, const BlockPosition & b) {return ev < b.eventsBefore;});
+        return (it - blockPositions.begin()) - 1;
+    }
+
+
     /**
      * Generate a table (vector) of positions of events in file/buffer.
      * This method does <b>not</b> affect the byteBuffer position, eventNumber,
@@ -209,11 +451,15 @@ namespace evio {
     size_t EvioReaderV4::generateEventPositions(std::shared_ptr<ByteBuffer> & bb) {
 
             uint32_t      blockSize, blockHdrSize, blockEventCount, magicNum;
-            uint32_t      byteInfo, byteLen, bytesLeft, position;
+            uint32_t      byteInfo, byteLen;
+            size_t        bytesLeft, position;
             bool          firstBlock=true, hasDictionary=false;
 //            bool          curLastBlock;
 
+            eventPositions.clear();
             eventPositions.reserve(20000);
+            eventCount = 0;
+            blockCount = 0;
 
             // Start at the beginning of byteBuffer
             position  = 0;
@@ -255,7 +501,7 @@ namespace evio {
 
                 // Check to see if the whole block is within the mapped memory.
                 // If not return the amount of memory we've used/read.
-                if (4*blockSize > bytesLeft) {
+                if (4*(size_t)blockSize > bytesLeft) {
 //std::cout << "    4*blockSize = " << std::to_string(4*blockSize) + " >? bytesLeft = " <<
 //             std::to_string(bytesLeft) + ", pos = " + std::to_string(position) << std::endl;
 //std::cout << "return, not enough to read all block data" << std::endl;
@@ -344,6 +590,9 @@ namespace evio {
         dictionaryXML       =  "";
         initialPosition     =  buf->position();
         sequentialRead      = false;
+        readMode            = STREAM;
+        blockPositions.clear();
+        blockPositionsComplete = false;
 
         byteBuffer = buf->slice();
         parseFirstHeader(byteBuffer);
@@ -415,7 +664,7 @@ namespace evio {
     /** {@inheritDoc} */
     bool EvioReaderV4::hasFirstEvent() {
         if (evioVersion < 4) {
-            firstBlockHeader2->hasFirstEvent();
+            return firstBlockHeader2->hasFirstEvent();
         }
         return firstBlockHeader4->hasFirstEvent();
     }
@@ -438,6 +687,13 @@ namespace evio {
     size_t EvioReaderV4::fileSize() {return fileBytes;}
 
 
+    /**
+     * Get how the file is read.
+     * @return how the file is read, STREAM if reading a buffer.
+     */
+    EvioReaderV4::ReadMode EvioReaderV4::getReadMode() const {return readMode;}
+
+
     /** {@inheritDoc} */
     std::shared_ptr<IBlockHeader> EvioReaderV4::getFirstBlockHeader() {return firstBlockHeader;}
 
@@ -592,7 +848,7 @@ namespace evio {
         // Reading data by 32768 byte blocks in older versions is inefficient,
         // so read in 500 block (16MB) chunks.
         else {
-            size_t bytesLeftInFile = fileBytes - file.tellg();
+            size_t bytesLeftInFile = fileBytes - fileTell();
             bytesToRead = DEFAULT_READ_BYTES < bytesLeftInFile ?
                           DEFAULT_READ_BYTES : bytesLeftInFile;
         }
@@ -604,10 +860,7 @@ namespace evio {
         byteBuffer->clear().limit(bytesToRead);
 
         // Read the first chunk of data from file
-        file.read((char *)(byteBuffer->array() + byteBuffer->arrayOffset()), bytesToRead);
-        if (file.fail()) {
-            throw EvioException("file read failure");
-        }
+        fileRead(byteBuffer->array() + byteBuffer->arrayOffset(), bytesToRead);
 
         // Buffer is ready to read since our file-read was absolute and position did NOT change
 
@@ -682,7 +935,7 @@ namespace evio {
                     if (bytesInBuf == 0) {
 
                         // How much of the file is left to read?
-                        size_t bytesLeftInFile = fileBytes - file.tellg();
+                        size_t bytesLeftInFile = fileBytes - fileTell();
                         if (bytesLeftInFile < 32L) {
                             return IEvioReader::ReadWriteStatus::END_OF_FILE;
                         }
@@ -697,10 +950,7 @@ namespace evio {
                         byteBuffer->position(0).limit(bytesToRead);
 
                         // Read the entire chunk of data
-                        file.read((char *)(byteBuffer->array() + byteBuffer->arrayOffset()), bytesToRead);
-                        if (file.fail()) {
-                            throw EvioException("file read failure");
-                        }
+                        fileRead(byteBuffer->array() + byteBuffer->arrayOffset(), bytesToRead);
                         byteBuffer->limit(bytesToRead);
 
                         // Now keeping track of pos in this new blockBuffer
@@ -716,22 +966,20 @@ namespace evio {
                 }
                 else {
                     // Enough data left to read len?
-                    if (fileBytes - file.tellg() < 4L) {
+                    size_t blockPos = fileTell();
+                    if (fileBytes - blockPos < 4L) {
                         return IEvioReader::ReadWriteStatus::END_OF_FILE;
                     }
 
                     // Read len of block in 32 bit words
                     uint32_t blkSize;
-                    file >> blkSize;
-                    if (file.fail()) {
-                        throw EvioException("file read failure");
-                    }
+                    fileRead(reinterpret_cast<uint8_t *>(&blkSize), 4);
                     if (swap) blkSize = SWAP_32(blkSize);
                     // Change to bytes
                     uint32_t blkBytes = 4 * blkSize;
 
                     // Enough data left to read rest of block?
-                    if (fileBytes - file.tellg() < blkBytes-4) {
+                    if (blkBytes < 32 || fileBytes - blockPos - 4 < blkBytes-4) {
                         return IEvioReader::ReadWriteStatus::END_OF_FILE;
                     }
 
@@ -752,10 +1000,11 @@ namespace evio {
                     byteBuffer->putInt(0, blkSize);
 
                     // Now the rest of the block (already put int, 4 bytes, in)
-                    file.read((char *)(byteBuffer->array() + byteBuffer->arrayOffset() + 4), blkBytes-4);
-                    if (file.fail()) {
-                        throw EvioException("file read failure");
-                    }
+                    fileRead(byteBuffer->array() + byteBuffer->arrayOffset() + 4, blkBytes-4);
+
+                    // Remember where it is, the first time through
+                    addBlockPosition(blockPos, blkBytes, byteBuffer->getUInt(4*BlockHeaderV4::EV_COUNT),
+                                     BlockHeaderV4::isLastBlock(byteBuffer->getUInt(4*BlockHeaderV4::EV_VERSION)));
 
                     // Now keeping track of pos in this new blockBuffer
                     blockHeader->setBufferStartingPosition(0);
@@ -932,7 +1181,13 @@ namespace evio {
             throw EvioException("object closed");
         }
 
+        if (index < 1) {
+            return nullptr;
+        }
+
         index--;
+        byteBuffer->position(eventPositions[index]);
+        eventNumber = index;
 
         std::shared_ptr<BankHeader> header;
         auto event = EvioEvent::getInstance(header);
@@ -1141,6 +1396,38 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    bool EvioReaderV4::parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) {
+        // Lock this method
+        if (synchronized) {
+            const std::lock_guard<std::mutex> lock(mtx);
+        }
+
+        // Events are read here as a header and data, so put them back together to be parsed
+        auto event = nextEvent();
+        if (event == nullptr) {
+            return false;
+        }
+
+        eventBytes.resize(event->getTotalBytes());
+        event->writeQuick(eventBytes.data());
+        parser->parseEvent(eventBytes.data(), eventBytes.size(), event->getByteOrder(), evioEvent);
+        return true;
+    }
+
+
+    /** {@inheritDoc} */
+    void EvioReaderV4::parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) {
+        // Lock this method
+        if (synchronized) {
+            const std::lock_guard<std::mutex> lock(mtx);
+        }
+
+        uint32_t len = getEventArray(index, eventBytes);
+        parser->parseEvent(eventBytes.data(), len, byteOrder, evioEvent);
+    }
+
+
     /** {@inheritDoc} */
     void EvioReaderV4::parseEvent(std::shared_ptr<EvioEvent> evioEvent) {
         // This method is called by locked methods
@@ -1211,7 +1498,7 @@ namespace evio {
         }
 
         if (sequentialRead) {
-            file.seekg(initialPosition);
+            fileSeek(initialPosition);
             prepareForSequentialRead();
         }
         else if (evioVersion < 4) {
@@ -1223,7 +1510,7 @@ namespace evio {
         eventNumber = 0;
         blockNumberExpected = 1;
 
-        if (evioVersion < 4) {
+        if (evioVersion > 3) {
             blockHeader = blockHeader4 = std::make_shared<BlockHeaderV4>(firstBlockHeader4);
         }
         else {
@@ -1253,7 +1540,7 @@ namespace evio {
         }
 
         if (sequentialRead) {
-            return file.tellg();
+            return fileTell();
         }
         return byteBuffer->position();
     }
@@ -1297,6 +1584,8 @@ namespace evio {
      * Go to a specific event in the file. The events are numbered 1..N.
      * This number is transient--it is not part of the event as stored in the evio file.
      * Before version 4, this does the work for {@link #getEvent(size_t)}.
+     * When streaming a version 4 file, only the block containing the event is read
+     * once that block's position is known.
      *
      * @param  evNumber the event number in a 1,2,..N counting sense, from beginning of file/buffer.
      * @param  parse if {@code true}, parse the desired event
@@ -1327,6 +1616,47 @@ namespace evio {
             }
         }
 
+        if (evioVersion > 3) {
+            try {
+                ssize_t index = findBlock(evNumber);
+                if (index < 0) {
+                    throw EvioException("Asked to go to event: " + std::to_string(evNumber) +
+                                        ", which is beyond the end of file");
+                }
+                auto const & block = blockPositions[index];
+
+                // Read only the block the event is in
+                fileSeek(block.filePosition);
+                lastBlock = false;
+                blockNumberExpected = index + 1;
+                if (processNextBlock() != IEvioReader::ReadWriteStatus::SUCCESS) {
+                    throw EvioException("Failed reading block header in gotoEventNumber.");
+                }
+
+                // Dictionary is always the first event of the first block
+                if (index == 0 && blockHeader4->hasDictionary()) {
+                    nextEvent();
+                }
+
+                eventNumber = block.eventsBefore;
+                for (size_t i = block.eventsBefore + 1; i < evNumber; i++) {
+                    if (nextEvent() == nullptr) {
+                        throw EvioException("Asked to go to event: " + std::to_string(evNumber) +
+                                            ", which is beyond the end of file");
+                    }
+                }
+
+                if (parse) {
+                    return parseNextEvent();
+                }
+                return nextEvent();
+            }
+            catch (EvioException & e) {
+                std::cout << e.what() << std::endl;
+            }
+            return nullptr;
+        }
+
         rewind();
         std::shared_ptr<EvioEvent> event;
 
@@ -1371,6 +1701,15 @@ namespace evio {
                 return eventCount;
             }
 
+            if (evioVersion > 3) {
+                // Only block headers need reading
+                scanBlocks(SIZE_MAX);
+                if (blockPositions.empty()) return 0;
+                auto & b = blockPositions.back();
+                eventCount = (int32_t)(b.eventsBefore + b.eventCount);
+                return eventCount;
+            }
+
             if (eventCount < 0) {
                 // The difficulty is that this method can be called at
                 // any time. So we need to save our state and then restore
@@ -1425,6 +1764,11 @@ namespace evio {
                 return blockCount;
             }
 
+            if (evioVersion > 3) {
+                scanBlocks(SIZE_MAX);
+                return blockPositions.size();
+            }
+
             if (blockCount < 0) {
                 // Although block size is theoretically adjustable, I believe
                 // that everyone used 8192 words for the block size in version 3.
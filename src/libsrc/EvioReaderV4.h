@@ -18,6 +18,9 @@
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 
 #include "ByteOrder.h"
@@ -39,9 +42,12 @@ namespace evio {
      * {@link #parseEvent(size_t)} to get new events and to stream the embedded structures
      * to an IEvioListener.<p>
      *
-     * A word to the wise, constructors for reading a file in random access mode
-     * (by setting "sequential" arg to false), will memory map the file. This is
-     * <b>not</b> a good idea if the file is not on a local disk.<p>
+     * A file is read in one of three ways, see {@link ReadMode}. By default it's read
+     * block by block through a stream. It may instead be read ahead in large chunks,
+     * or memory mapped, which is <b>not</b> a good idea if the file is not on a local disk.
+     * When streaming a version 4 file, the position of each block is remembered as it's
+     * first seen, or as block headers are scanned when an event beyond them is asked
+     * for, so going to an event after that only reads the block it's in.<p>
      *
      * The streaming effect of parsing an event is that the parser will read the event and hand off structures,
      * such as banks, to any IEvioListeners. For those familiar with XML, the event is processed SAX-like.
@@ -76,6 +82,16 @@ namespace evio {
          *  This constant <b>MUST BE</b> an integer multiple of 32768.*/
         static const uint32_t DEFAULT_READ_BYTES = 32768 * 500; // 16384000 bytes
 
+        /** Ways of reading a file. */
+        enum ReadMode {
+            /** Read each block (or, versions 1-3, 16MB of blocks) from a stream as needed. */
+            STREAM = 0,
+            /** As STREAM, but blocks are served from {@link #DEFAULT_READ_BYTES} chunks of file. */
+            READ_AHEAD,
+            /** Memory map the whole file and make a table of all event positions at once. */
+            MEMORY_MAPPED
+        };
+
     private:
 
         /** When doing a sequential read, used to assign a transient
@@ -105,10 +121,10 @@ namespace evio {
         uint32_t blockCount = 0;
 
         /** The current block header for evio versions 1-3. */
-        std::shared_ptr<BlockHeaderV2> blockHeader2;
+        std::shared_ptr<BlockHeaderV2> blockHeader2 {std::make_shared<BlockHeaderV2>()};
 
         /** The current block header for evio version 4. */
-        std::shared_ptr<BlockHeaderV4> blockHeader4;
+        std::shared_ptr<BlockHeaderV4> blockHeader4 {std::make_shared<BlockHeaderV4>()};
 
         /** Reference to current block header, any version, through interface.
          *  This must be the same object as either blockHeader2 or blockHeader4
@@ -143,17 +159,20 @@ namespace evio {
         std::string dictionaryXML;
 
         /** The buffer being read. */
-        std::shared_ptr<ByteBuffer> byteBuffer;
+        std::shared_ptr<ByteBuffer> byteBuffer {std::make_shared<ByteBuffer>(0)};
 
         /** Parser object for this file/buffer. */
         std::shared_ptr<EventParser> parser;
 
+        /** Bytes of an event parsed into a reused event object, reused too. */
+        std::vector<uint8_t> eventBytes;
+
         /** Initial position of buffer or mappedByteBuffer when reading a file. */
         size_t initialPosition = 0;
 
         /** Vector containing each event's position.
          * In Java this was contained in MemoryMappedHandler class. */
-        std::vector<uint32_t> eventPositions;
+        std::vector<size_t> eventPositions;
 
         /** Mutex used for making thread safe. */
         std::mutex mtx;
@@ -182,6 +201,39 @@ namespace evio {
          */
         bool sequentialRead = false;
 
+        /** How the file is read. */
+        ReadMode readMode = STREAM;
+
+        /** If reading ahead, chunk of file being read from. */
+        std::vector<uint8_t> readAheadBuf;
+
+        /** If reading ahead, position in file of readAheadBuf's first byte. */
+        size_t readAheadStart = 0;
+
+        /** If reading ahead, valid bytes in readAheadBuf. */
+        size_t readAheadBytes = 0;
+
+        /** If reading ahead, position in file of the next byte to read. */
+        size_t filePosition = 0;
+
+        /** Position and events of one block of a version 4 file. */
+        struct BlockPosition {
+            /** Position of block in file. */
+            size_t filePosition;
+            /** Size of block in bytes. */
+            size_t bytes;
+            /** Number of events in all previous blocks (not counting any dictionary). */
+            size_t eventsBefore;
+            /** Number of events in block (not counting any dictionary). */
+            uint32_t eventCount;
+        };
+
+        /** When streaming a version 4 file, the blocks found so far. */
+        std::vector<BlockPosition> blockPositions;
+
+        /** Have all blocks been found? */
+        bool blockPositionsComplete = false;
+
 
         //------------------------
         // EvioReader's state
@@ -214,9 +266,18 @@ namespace evio {
 
         size_t generateEventPositions(std::shared_ptr<ByteBuffer> & byteBuffer);
 
+        void mapFile();
+        void fileRead(uint8_t *dest, size_t bytes);
+        void fileSeek(size_t pos);
+        size_t fileTell();
+        void addBlockPosition(size_t pos, size_t bytes, uint32_t events, bool last);
+        bool scanBlocks(size_t evNumber);
+        ssize_t findBlock(size_t evNumber);
+
     public:
 
-        explicit EvioReaderV4(std::string const & path, bool checkBlkNumSeq = false, bool synced = false);
+        explicit EvioReaderV4(std::string const & path, bool checkBlkNumSeq = false, bool synced = false,
+                              ReadMode mode = STREAM);
         explicit EvioReaderV4(std::shared_ptr<ByteBuffer> & byteBuffer, bool checkBlkNumSeq = false, bool synced = false);
 
 
@@ -238,6 +299,7 @@ namespace evio {
         size_t getNumEventsRemaining() override;
         std::shared_ptr<ByteBuffer> getByteBuffer() override ;
         size_t fileSize() override;
+        ReadMode getReadMode() const;
         std::shared_ptr<IBlockHeader> getFirstBlockHeader() override ;
 
     protected:
@@ -259,6 +321,8 @@ namespace evio {
         std::shared_ptr<EvioEvent> parseEvent(size_t index) override ;
         std::shared_ptr<EvioEvent> nextEvent() override ;
         std::shared_ptr<EvioEvent> parseNextEvent() override ;
+        bool parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) override ;
+        void parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) override ;
         void parseEvent(std::shared_ptr<EvioEvent> evioEvent) override ;
         uint32_t getEventArray(size_t evNumber, std::vector<uint8_t> & vec) override;
         uint32_t getEventBuffer(size_t evNumber, ByteBuffer & buf) override;
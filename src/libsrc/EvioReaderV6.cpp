@@ -22,6 +22,8 @@ namespace evio {
      *                       and throw an exception if it is not sequential starting
      *                       with 1
      * @param synced if true, this class's methods are mutex protected for thread safety.
+     * @param memoryMapped if true, the file is memory mapped and its uncompressed records
+     *                     read in place instead of copied.
      *
      * @see EventWriter
      * @throws IOException   if read failure
@@ -29,12 +31,12 @@ namespace evio {
      *                       if file is too small to have valid evio format data
      *                       if first record number != 1 when checkRecNumSeq arg is true
      */
-    EvioReaderV6::EvioReaderV6(std::string const & path, bool checkSeq, bool synced) {
+    EvioReaderV6::EvioReaderV6(std::string const & path, bool checkSeq, bool synced, bool memoryMapped) {
         if (path.empty()) {
             throw EvioException("path is empty");
         }
         synchronized = synced;
-        reader = std::make_shared<Reader>(path);
+        reader = std::make_shared<Reader>(path, false, memoryMapped);
         parser = std::make_shared<EventParser>();
      }
 
@@ -213,6 +215,49 @@ namespace evio {
     }
 
 
+    /** {@inheritDoc} */
+    bool EvioReaderV6::parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) {
+        if (synchronized) {
+            const std::lock_guard<std::mutex> lock(mtx);
+        }
+
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        // Parse straight from the record, no copy of the event is made
+        ByteBufferView view = reader->getNextEventView();
+        if (view.empty()) {
+            return false;
+        }
+
+        parser->parseEvent(view.data(), view.size(), view.order(), evioEvent);
+        return true;
+    }
+
+
+    /** {@inheritDoc} */
+    void EvioReaderV6::parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) {
+        if (synchronized) {
+            const std::lock_guard<std::mutex> lock(mtx);
+        }
+
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        ByteBufferView view;
+        if (index > 0) {
+            view = reader->getEventView(index - 1);
+        }
+        if (view.empty()) {
+            throw EvioException("eventNumber (" + std::to_string(index) + ") is out of bounds");
+        }
+
+        parser->parseEvent(view.data(), view.size(), view.order(), evioEvent);
+    }
+
+
     /** {@inheritDoc} */
     void EvioReaderV6::parseEvent(std::shared_ptr<EvioEvent> evioEvent) {
         // This method is synchronized too
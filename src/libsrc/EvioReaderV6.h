@@ -72,7 +72,8 @@ namespace evio {
     public:
 
 
-        explicit EvioReaderV6(std::string const & path, bool checkRecNumSeq = false, bool synced = false);
+        explicit EvioReaderV6(std::string const & path, bool checkRecNumSeq = false,
+                              bool synced = false, bool memoryMapped = false);
         explicit EvioReaderV6(std::shared_ptr<ByteBuffer> & byteBuffer, bool checkRecNumSeq = false, bool synced = false);
 
 
@@ -100,6 +101,8 @@ namespace evio {
         std::shared_ptr<EvioEvent> parseEvent(size_t index) override ;
         std::shared_ptr<EvioEvent> nextEvent() override ;
         std::shared_ptr<EvioEvent> parseNextEvent() override ;
+        bool parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) override ;
+        void parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) override ;
         void parseEvent(std::shared_ptr<EvioEvent> evioEvent) override ;
 
         uint32_t getEventArray(size_t evNumber, std::vector<uint8_t> & vec) override;
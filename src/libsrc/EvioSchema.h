@@ -0,0 +1,248 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_EVIOSCHEMA_H
+#define EVIO_6_0_EVIOSCHEMA_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+#include "DataType.h"
+#include "EvioNode.h"
+#include "BaseStructure.h"
+#include "BaseStructureHeader.h"
+#include "ByteBufferView.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * Maps the value of an evio data type to the C++ type of its data items.
+     * Types without fixed size items, such as strings, composite data,
+     * or containers, are seen as bytes.
+     */
+    template<uint32_t Type> struct SchemaValueType {using type = uint8_t;};
+    template<> struct SchemaValueType<0x0> {using type = uint32_t;};
+    template<> struct SchemaValueType<0x1> {using type = uint32_t;};
+    template<> struct SchemaValueType<0x2> {using type = float;};
+    template<> struct SchemaValueType<0x4> {using type = int16_t;};
+    template<> struct SchemaValueType<0x5> {using type = uint16_t;};
+    template<> struct SchemaValueType<0x6> {using type = int8_t;};
+    template<> struct SchemaValueType<0x7> {using type = uint8_t;};
+    template<> struct SchemaValueType<0x8> {using type = double;};
+    template<> struct SchemaValueType<0x9> {using type = int64_t;};
+    template<> struct SchemaValueType<0xa> {using type = uint64_t;};
+    template<> struct SchemaValueType<0xb> {using type = int32_t;};
+
+
+    /**
+     * This class template describes one dictionary entry at compile time, so that finding
+     * structures which match it takes only integer compares and reading their data takes
+     * no copying. It's normally not used directly but is a base of the structs made by
+     * the <b>evioDictGen</b> program, one for each entry of an xml dictionary, which also
+     * hold the entry's name and composite format:
+     * <pre>
+     *   struct RawHits : public evio::EvioSchema&lt;1, 2, 0xb&gt; {
+     *       static constexpr const char * name   = "Raw Hits";
+     *       static constexpr const char * format = "";
+     *   };
+     *
+     *   for (auto & n : node->getChildNodes()) {
+     *       if (RawHits::matches(*n)) {
+     *           const int32_t *hits = RawHits::data(*n);
+     *           size_t count = RawHits::count(*n);
+     *       }
+     *   }
+     * </pre>
+     *
+     * Matching follows the dictionary: the tag must equal Tag, or lie in Tag to TagEnd if
+     * TagEnd is not 0; the num must equal Num if NumValid; and the data type must equal
+     * Type if it is not 0 (UNKNOWN32, meaning no type was given). Parent entries are not
+     * taken into account.
+     *
+     * @tparam Tag      tag, or first tag of a range.
+     * @tparam Num      num.
+     * @tparam Type     value of data type, 0 if none given.
+     * @tparam NumValid true if num must match.
+     * @tparam TagEnd   last tag of a range, 0 if not a range.
+     */
+    template<uint16_t Tag, uint8_t Num, uint32_t Type = 0, bool NumValid = true, uint16_t TagEnd = 0>
+    struct EvioSchema {
+
+        /** C++ type of this entry's data items. */
+        using value_type = typename SchemaValueType<Type>::type;
+
+        /** Tag, or first tag of a range. */
+        static constexpr uint16_t tag = Tag;
+        /** Last tag of a range, 0 if not a range. */
+        static constexpr uint16_t tagEnd = TagEnd;
+        /** Num. */
+        static constexpr uint8_t num = Num;
+        /** Does num need to match? */
+        static constexpr bool numValid = NumValid;
+        /** Value of data type, 0 if none. */
+        static constexpr uint32_t dataType = Type;
+
+
+        /**
+         * Are the given header values those of this entry?
+         * Banks and segments match whether or not they're marked as "also" banks or segments.
+         * @param t    tag.
+         * @param n    num.
+         * @param type value of data type.
+         * @return true if they match.
+         */
+        static constexpr bool matches(uint16_t t, uint8_t n, uint32_t type) {
+            return (TagEnd == 0 ? t == Tag : (t >= Tag && t <= TagEnd)) &&
+                   (!NumValid || n == Num) &&
+                   (Type == 0 || sameType(type, Type));
+        }
+
+
+        /**
+         * Does the given node match this entry?
+         * @param node node to check.
+         * @return true if it matches.
+         */
+        static bool matches(EvioNode const & node) {
+            return matches(node.getTag(), node.getNum(), node.getDataType());
+        }
+
+
+        /**
+         * Does the given structure match this entry?
+         * @param structure structure to check.
+         * @return true if it matches.
+         */
+        static bool matches(BaseStructure const & structure) {
+            auto header = structure.getHeader();
+            return matches(header->getTag(), header->getNumber(), header->getDataTypeValue());
+        }
+
+
+        /**
+         * Get the number of data items of a node matching this entry.
+         * @param node node of this entry.
+         * @return number of items.
+         */
+        static size_t count(EvioNode const & node) {
+            return (4*(size_t)node.getDataLength() - node.getPad()) / sizeof(value_type);
+        }
+
+
+        /**
+         * Get a pointer to the data of a node matching this entry, right in the node's buffer.
+         * Valid as long as the buffer is unchanged.
+         * @param node node of this entry.
+         * @return pointer to data.
+         * @throws EvioException if the data is not local endian or not aligned for its type.
+         */
+        static const value_type * data(EvioNode const & node) {
+            ByteBufferView view = node.getByteDataView();
+            if (!view.order().isLocalEndian()) {
+                throw EvioException("data not in local byte order, use get()");
+            }
+            if (reinterpret_cast<uintptr_t>(view.data()) % alignof(value_type) != 0) {
+                throw EvioException("data not aligned for its type, use get()");
+            }
+            return reinterpret_cast<const value_type *>(view.data());
+        }
+
+
+        /**
+         * Get one data item of a node matching this entry,
+         * swapped to local byte order if necessary.
+         * @param node  node of this entry.
+         * @param index index of item.
+         * @return data item.
+         * @throws std::underflow_error if index is out of bounds.
+         */
+        static value_type get(EvioNode const & node, size_t index) {
+            ByteBufferView view = node.getByteDataView();
+            size_t pos = index * sizeof(value_type);
+            value_type val;
+            if constexpr (sizeof(value_type) == 1) {
+                uint8_t raw = view.getByte(pos);
+                std::memcpy(&val, &raw, 1);
+            }
+            else if constexpr (sizeof(value_type) == 2) {
+                uint16_t raw = view.getShort(pos);
+                std::memcpy(&val, &raw, 2);
+            }
+            else if constexpr (sizeof(value_type) == 4) {
+                uint32_t raw = view.getInt(pos);
+                std::memcpy(&val, &raw, 4);
+            }
+            else {
+                uint64_t raw = view.getLong(pos);
+                std::memcpy(&val, &raw, 8);
+            }
+            return val;
+        }
+
+
+        /**
+         * Find the first child of a scanned node which matches this entry.
+         * @param parent node whose children are searched.
+         * @return first matching child, or null if none.
+         */
+        static std::shared_ptr<EvioNode> findChild(EvioNode & parent) {
+            for (auto & child : parent.getChildNodes()) {
+                if (matches(*child)) return child;
+            }
+            return nullptr;
+        }
+
+
+        /**
+         * Collect all descendants of a scanned node which match this entry.
+         * @param node node whose descendants are searched.
+         * @param vec  vector which is cleared, then filled with matching nodes.
+         */
+        static void findAll(EvioNode & node, std::vector<std::shared_ptr<EvioNode>> & vec) {
+            std::vector<std::shared_ptr<EvioNode>> descendants;
+            node.getAllDescendants(descendants);
+            vec.clear();
+            for (auto & n : descendants) {
+                if (matches(*n)) vec.push_back(n);
+            }
+        }
+
+
+    private:
+
+        /**
+         * Are the two data type values the same, taking ALSOBANK as BANK
+         * and ALSOSEGMENT as SEGMENT?
+         * @param a value of one type.
+         * @param b value of other type.
+         * @return true if same.
+         */
+        static constexpr bool sameType(uint32_t a, uint32_t b) {
+            return canonical(a) == canonical(b);
+        }
+
+        /** @param t data type value. @return BANK for ALSOBANK, SEGMENT for ALSOSEGMENT, else t. */
+        static constexpr uint32_t canonical(uint32_t t) {
+            return t == 0xe ? 0x10 : (t == 0xd ? 0x20 : t);
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_EVIOSCHEMA_H
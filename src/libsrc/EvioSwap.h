@@ -13,6 +13,7 @@
 
 
 #include <cstdio>
+#include <cstring>
 #include <memory>
 
 
@@ -22,6 +23,7 @@
 #include "EvioNode.h"
 #include "CompositeData.h"
 #include "BaseStructure.h"
+#include "Profiler.h"
 
 
 namespace evio {
@@ -49,6 +51,7 @@ namespace evio {
          *                If this is null, then dest = buf.
          */
         static void swapEvent(uint32_t *buf, int tolocal, uint32_t *dest) {
+            EVIO_PROFILE_SCOPE(SWAP);
             swapBank(buf, tolocal, dest);
         }
 
@@ -209,34 +212,57 @@ namespace evio {
                                  ByteBuffer & destBuf, size_t srcPos, size_t destPos,
                                  size_t len) {
 
-            // We end here
-            size_t endPos = srcPos + 4*len;
+            if (type == DataType::COMPOSITE) {
+                // new composite type
+                CompositeData::swapAll(srcBuf, destBuf, srcPos, destPos, len);
+                return;
+            }
+
+            size_t bytes = 4*len;
+            if (srcPos + bytes > srcBuf.limit() || destPos + bytes > destBuf.limit()) {
+                throw EvioException("bad pos/len, or destBuf too small");
+            }
+
+            // Swap (or copy if same byte order) straight from one backing array
+            // into the other, in one pass, with the vectorized kernels of ByteOrder
+            uint8_t *src  = srcBuf.array()  + srcBuf.arrayOffset()  + srcPos;
+            uint8_t *dest = destBuf.array() + destBuf.arrayOffset() + destPos;
+            bool sameOrder = (srcBuf.order() == destBuf.order());
 
             // 64 bit swap
             if (type == DataType::LONG64  ||
                 type == DataType::ULONG64 ||
                 type ==  DataType::DOUBLE64) {
 
-                    // When only swapping, no need to convert to double & back
-                    for (; srcPos < endPos; srcPos += 8, destPos += 8) {
-                        destBuf.putLong(destPos, srcBuf.getLong(srcPos));
-                    }
-
+                if (sameOrder) {
+                    std::memmove(dest, src, bytes);
+                }
+                else {
+                    ByteOrder::byteSwap64(reinterpret_cast<uint64_t *>(src), bytes/8,
+                                          reinterpret_cast<uint64_t *>(dest));
+                }
             }
             // 32 bit swap
             else if (type == DataType::INT32  ||
                      type == DataType::UINT32 ||
                      type == DataType::FLOAT32) {
-                // When only swapping, no need to convert to float & back
-                for (; srcPos < endPos; srcPos += 4, destPos += 4) {
-                    destBuf.putInt(destPos, srcBuf.getInt(srcPos));
+                if (sameOrder) {
+                    std::memmove(dest, src, bytes);
+                }
+                else {
+                    ByteOrder::byteSwap32(reinterpret_cast<uint32_t *>(src), bytes/4,
+                                          reinterpret_cast<uint32_t *>(dest));
                 }
             }
             // 16 bit swap
             else if (type == DataType::SHORT16  ||
                      type == DataType::USHORT16) {
-                for (; srcPos < endPos; srcPos += 2, destPos += 2) {
-                    destBuf.putShort(destPos, srcBuf.getShort(srcPos));
+                if (sameOrder) {
+                    std::memmove(dest, src, bytes);
+                }
+                else {
+                    ByteOrder::byteSwap16(reinterpret_cast<uint16_t *>(src), bytes/2,
+                                          reinterpret_cast<uint16_t *>(dest));
                 }
             }
             // no swap
@@ -245,13 +271,7 @@ namespace evio {
                      type == DataType::UCHAR8    ||
                      type == DataType::CHARSTAR8) {
                 // 8 bit swap - no swap needed, but need to copy if destBuf != srcBuf
-                for (; srcPos < endPos; srcPos++, destPos++) {
-                   destBuf.put(destPos, srcBuf.getByte(srcPos));
-                }
-            }
-            else if (type == DataType::COMPOSITE) {
-                // new composite type
-                CompositeData::swapAll(srcBuf, destBuf, srcPos, destPos, len);
+                std::memmove(dest, src, bytes);
             }
         }
 
@@ -440,7 +460,7 @@ namespace evio {
 //             }
              // For containers, just iterate over their children recursively
              else if (type.isBank() || type.isSegment() || type.isTagSegment()) {
-                 for (auto kid : strc->getChildren()) {
+                 for (auto const & kid : strc->getChildren()) {
                      swapData(kid);
                  }
              }
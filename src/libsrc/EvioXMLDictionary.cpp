@@ -81,6 +81,7 @@ namespace evio {
         tagNumReverseMap.reserve(100);
 
         parseXML(result);
+        buildLookupTables();
     };
 
 
@@ -103,9 +104,71 @@ namespace evio {
         tagNumReverseMap.reserve(100);
 
         parseXML(result);
+        buildLookupTables();
     };
 
 
+    /** Dictionaries shared by the whole process, keyed by their xml, and the lock guarding them. */
+    static std::unordered_map<std::string, std::shared_ptr<const EvioXMLDictionary>> & internedDictionaries() {
+        static std::unordered_map<std::string, std::shared_ptr<const EvioXMLDictionary>> dictionaries;
+        return dictionaries;
+    }
+
+    static std::mutex & internedMutex() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+
+    /**
+     * Get a dictionary, shared by the whole process, parsed from an xml string.
+     * The first call with a given string parses it, later ones with the same content
+     * cost only a hash and compare of the string. Meant for programs opening many files
+     * of one run, each holding the same dictionary (see {@link Reader#getDictionary()}).
+     * The dictionary is kept until {@link #clearInterned()} is called.
+     * Thread safe.
+     *
+     * @param xml string containing xml.
+     * @return shared dictionary parsed from xml.
+     * @throws EvioException if parsing error.
+     */
+    std::shared_ptr<const EvioXMLDictionary> EvioXMLDictionary::intern(std::string const & xml) {
+        auto & dictionaries = internedDictionaries();
+        {
+            std::lock_guard<std::mutex> lock(internedMutex());
+            auto it = dictionaries.find(xml);
+            if (it != dictionaries.end()) {
+                return it->second;
+            }
+        }
+
+        // Parse without holding the lock. If another thread did the same meanwhile, use its.
+        std::shared_ptr<const EvioXMLDictionary> dict = std::make_shared<EvioXMLDictionary>(xml, 0);
+        std::lock_guard<std::mutex> lock(internedMutex());
+        return dictionaries.emplace(xml, std::move(dict)).first->second;
+    }
+
+
+    /**
+     * Forget all dictionaries shared through {@link #intern(std::string const &)}.
+     * Those still in use are freed once the last user is done with them.
+     */
+    void EvioXMLDictionary::clearInterned() {
+        std::lock_guard<std::mutex> lock(internedMutex());
+        internedDictionaries().clear();
+    }
+
+
+    /**
+     * Get the number of dictionaries shared through {@link #intern(std::string const &)}.
+     * @return number of shared dictionaries.
+     */
+    size_t EvioXMLDictionary::internedCount() {
+        std::lock_guard<std::mutex> lock(internedMutex());
+        return internedDictionaries().size();
+    }
+
+
     /**
      * Create an EvioXMLDictionary from an xml Document object.
      * @param domDocument DOM object representing xml dictionary.
@@ -372,7 +435,6 @@ namespace evio {
                     num = numEnd;
                     numEnd = tmp;
                 }
-std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " << numEnd << "\n";
 
                 std::string nameOrig = name;
 
@@ -846,7 +908,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param structure the structure to find the name of.
      * @return a descriptive name or ??? if none found
      */
-    std::string EvioXMLDictionary::getName(std::shared_ptr<BaseStructure> & structure) {
+    std::string EvioXMLDictionary::getName(std::shared_ptr<BaseStructure> const & structure) const {
         if (structure == nullptr) {
             NO_NAME_STRING();
         }
@@ -873,7 +935,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tag  tag of dictionary entry to find
      * @return descriptive name or ??? if none found
      */
-    std::string EvioXMLDictionary::getName(uint16_t tag) {
+    std::string EvioXMLDictionary::getName(uint16_t tag) const {
         return getName(tag, 0, tag, 0, 0, 0, false);
     }
 
@@ -892,7 +954,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param num  num of dictionary entry to find
      * @return descriptive name or ??? if none found
      */
-    std::string EvioXMLDictionary::getName(uint16_t tag, uint8_t num) {
+    std::string EvioXMLDictionary::getName(uint16_t tag, uint8_t num) const {
         return getName(tag, num, tag);
     }
 
@@ -918,11 +980,12 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd tagEnd of dictionary entry to find
      * @return descriptive name or ??? if none found
      */
-    std::string EvioXMLDictionary::getName(uint16_t tag, uint8_t num, uint16_t tagEnd) {
+    std::string EvioXMLDictionary::getName(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
         // The generated key below is equivalent (equals() overridden)
         // to the key existing in the map. Use it to find the value.
-        auto key = std::make_shared<EvioDictionaryEntry>(tag, num, tagEnd);
-        return getName(key);
+        EvioDictionaryEntry key(tag, num, tagEnd);
+        const LookupItem *item = lookup(key);
+        return item == nullptr ? NO_NAME_STRING() : item->name;
     }
 
 
@@ -985,7 +1048,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @return descriptive name or "???" if none found
      */
     std::string EvioXMLDictionary::getName(uint16_t tag,  uint8_t num,  uint16_t tagEnd,
-                                           uint16_t pTag, uint8_t pNum, uint16_t pTagEnd) {
+                                           uint16_t pTag, uint8_t pNum, uint16_t pTagEnd) const {
         return getName(tag, num, tagEnd, pTag, pNum, pTagEnd, true, true, true);
     }
 
@@ -1060,7 +1123,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
     std::string EvioXMLDictionary::getName(uint16_t tag,  uint8_t num,  uint16_t tagEnd,
                                            uint16_t pTag, uint8_t pNum, uint16_t pTagEnd,
                                            bool numValid, bool parentValid,
-                                           bool parentNumValid) {
+                                           bool parentNumValid) const {
 
         // Do we use parent info?
         if (!parentValid) {
@@ -1099,110 +1162,195 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param key dictionary entry to look up name for.
      * @return name associated with key or "???" if none.
      */
-    std::string EvioXMLDictionary::getName(std::shared_ptr<EvioDictionaryEntry> key) {
-
-        bool debug = true;
-        uint16_t tag = key->getTag();
-        EvioDictionaryEntry::EvioDictionaryEntryType entryType = key->getEntryType();
-
-        // name = ???
-        std::string name = NO_NAME_STRING();
-
-        switch (entryType) {
-            case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM: {
-// if (debug) std::cout << "EvioXMLDictionary.getName:  FIRST TRY tagNum map, look in map:" << std::endl;
-
-                // If a tag/num pair was specified ...
-                // There may be multiple entries with the same tag/tagEnd/num values
-                // but having parents with differing values. Since we don't specify
-                // the parent info, we just get the first match found in the map.
-                //
-                // We cannot compare shared pointers, we need to compare the actual objects,
-                // which means we have to look at each entry and cannot use map.find(key) .
-                bool foundEntry = false;
-                for (auto & entry : tagNumMap) {
-                    // We need to compare the actual objects ...
-                    if (*(entry.first.get()) == *(key.get())) {
-//std::cout << "    *****   entry in tagNum map MATCHES key for name = " << entry.second << std::endl;
-//std::cout << "            key -> " << key->toString() << std::endl;
-                        name = entry.second;
-                        foundEntry = true;
-                        // need to break 2x
-                        break;
-                    }
-                }
+    std::string EvioXMLDictionary::getName(std::shared_ptr<EvioDictionaryEntry> key) const {
+        const LookupItem *item = lookup(*key);
+        return item == nullptr ? NO_NAME_STRING() : item->name;
+    }
 
-                if (foundEntry) break;
 
-                // Create tag-only key and try to find tag-only match (fall thru case)
-                key = std::make_shared<EvioDictionaryEntry>(tag);
+    /**
+     * Create the flat lookup tables from tagNumMap, tagOnlyMap, and tagRangeMap.
+     * Called once the xml has been parsed.
+     */
+    void EvioXMLDictionary::buildLookupTables() {
+
+        // Key, item, and whether it's from tagRangeMap
+        std::vector<std::tuple<uint64_t, LookupItem, bool>> all;
+        all.reserve(tagNumMap.size() + tagOnlyMap.size() + tagRangeMap.size());
+        for (auto const & m : tagNumMap)   all.emplace_back(lookupKey(*m.first), LookupItem{m.first, m.second}, false);
+        for (auto const & m : tagOnlyMap)  all.emplace_back(lookupKey(*m.first), LookupItem{m.first, m.second}, false);
+        for (auto const & m : tagRangeMap) all.emplace_back(lookupKey(*m.first), LookupItem{m.first, m.second}, true);
+
+        // Put entries with the same key, which differ only in their parents, next to each other
+        std::stable_sort(all.begin(), all.end(),
+                         [](std::tuple<uint64_t, LookupItem, bool> const & a,
+                            std::tuple<uint64_t, LookupItem, bool> const & b) {
+                             return std::get<0>(a) < std::get<0>(b);
+                         });
+
+        // Table is at most half full
+        size_t slotCount = 16;
+        while (slotCount < 2*all.size()) slotCount <<= 1;
+
+        lookupItems.clear();
+        lookupItems.reserve(all.size());
+        lookupSlots.assign(slotCount, LookupSlot{0, 0, 0});
+        rangeItems.clear();
+
+        for (size_t i = 0; i < all.size(); i++) {
+            uint64_t key = std::get<0>(all[i]);
+            auto index = (uint32_t) lookupItems.size();
+            if (std::get<2>(all[i])) {
+                auto const & entry = std::get<1>(all[i]).entry;
+                rangeItems.push_back({entry->getTag(), entry->getTagEnd(), 0, index});
             }
+            lookupItems.push_back(std::move(std::get<1>(all[i])));
 
-            case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_ONLY: {
-//if (debug) std::cout << "EvioXMLDictionary.getName:  NEXT TRY tagOnly map" << std::endl;
-                // If only a tag was specified or a tag/num pair was specified
-                // but there was no exact match for the pair ...
-                bool foundEntry = false;
-                for (auto & entry : tagOnlyMap) {
-                    // We need to compare the actual objects ...
-                    if (*(entry.first.get()) == *(key.get())) {
-//                        std::cout << "    *****   entry in tagOnly map MATCHES key for name = " << entry.second << std::endl;
-//                        std::cout << "            key -> " << key->toString() << std::endl;
-                        name = entry.second;
-                        foundEntry = true;
-                        break;
-                    }
-                }
-
-                if (foundEntry) break;
+            if (i > 0 && std::get<0>(all[i-1]) == key) {
+                continue;
+            }
 
-                // Create tag-range key and try to find tag-range match
-                key = std::make_shared<EvioDictionaryEntry>(tag, key->getTagEnd());
+            size_t slot = lookupSlot(key, slotCount - 1);
+            while (lookupSlots[slot].key != 0) {
+                slot = (slot + 1) & (slotCount - 1);
             }
+            lookupSlots[slot].key = key;
+            lookupSlots[slot].first = index;
+            size_t count = 1;
+            while (i + count < all.size() && std::get<0>(all[i + count]) == key) count++;
+            lookupSlots[slot].count = (uint32_t) count;
+        }
 
-            case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE: {
-//if (debug) std::cout << "EvioXMLDictionary.getName:  LAST TRY tagRange map" << std::endl;
-                // If a range was specified in the args, check to see if
-                // there's an exact match first ...
-                bool foundEntry = false;
-                for (auto & entry : tagRangeMap) {
-                    // We need to compare the actual objects ...
-                    if (*(entry.first.get()) == *(key.get())) {
-//                        std::cout << "    *****   entry in tagRange map MATCHES key for name = " << entry.second << std::endl;
-//                        std::cout << "            key -> " << key->toString() << std::endl;
-                        name = entry.second;
-                        foundEntry = true;
-                        break;
-                    }
-                }
+        // Sort ranges by starting tag and track the largest tagEnd so far,
+        // so the ranges holding a tag can be found by binary search
+        std::stable_sort(rangeItems.begin(), rangeItems.end(),
+                         [](RangeItem const & a, RangeItem const & b) {return a.tag < b.tag;});
+        uint16_t maxTagEnd = 0;
+        for (auto & r : rangeItems) {
+            maxTagEnd = std::max(maxTagEnd, r.tagEnd);
+            r.maxTagEnd = maxTagEnd;
+        }
+    }
 
-                if (foundEntry) break;
-
-                // If a tag/num pair or only a tag was specified in the args,
-                // see if either falls in a range of tags.
-                else if (entryType != EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE) {
-                    // Additional check to see if tag fits in a range
-                    for (auto & iter : tagRangeMap) {
-                        auto entry = iter.first;
-                        if (entry->inRange(tag)) {
-                            name = iter.second;
-//if (debug) std::cout << "    DDDDD   found entry in tagRange map with name 2 = " << name << std::endl;
-//std::cout << "            key -> " << key->toString() << std::endl;
-                            goto out;
-                        }
+
+    /**
+     * Pack the values which make dictionary entries equal into one key.
+     * It includes everything that operator== compares except for parents.
+     * @param entry dictionary entry.
+     * @return packed key, never 0.
+     */
+    uint64_t EvioXMLDictionary::lookupKey(EvioDictionaryEntry const & entry) {
+        uint64_t key = (uint64_t)entry.getTag() | ((uint64_t)entry.getTagEnd() << 16);
+        if (entry.isNumValid()) {
+            key |= ((uint64_t)entry.getNum() << 32) | (1ULL << 40);
+        }
+        key |= ((uint64_t)entry.getEntryType() + 1) << 41;
+        return key;
+    }
+
+
+    /**
+     * Get the hash table slot in which to start looking for a key.
+     * @param key  packed key.
+     * @param mask number of slots - 1.
+     * @return slot index.
+     */
+    size_t EvioXMLDictionary::lookupSlot(uint64_t key, size_t mask) {
+        // Mix high bits into low ones so keys differing only in num or tagEnd spread out
+        uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+        return (size_t)(h ^ (h >> 29)) & mask;
+    }
+
+
+    /**
+     * Find the first entry with the given packed key which equals the given entry
+     * (their parents match if both have one).
+     * @param key   packed key of entry.
+     * @param entry entry to match.
+     * @return item found or null if none.
+     */
+    const EvioXMLDictionary::LookupItem * EvioXMLDictionary::findItem(uint64_t key, EvioDictionaryEntry const & entry) const {
+        if (lookupSlots.empty()) return nullptr;
+
+        size_t mask = lookupSlots.size() - 1;
+        size_t slot = lookupSlot(key, mask);
+
+        while (lookupSlots[slot].key != 0) {
+            if (lookupSlots[slot].key == key) {
+                auto const & s = lookupSlots[slot];
+                for (uint32_t i = s.first; i < s.first + s.count; i++) {
+                    if (entry.getParentEntry() == nullptr || *(lookupItems[i].entry) == entry) {
+                        return &lookupItems[i];
                     }
                 }
+                return nullptr;
             }
+            slot = (slot + 1) & mask;
+        }
+        return nullptr;
+    }
+
 
-            default:
-                ;
-                //std::cout << "no dictionary entry for tag = " << tag << ", tagEnd = " <<
-                //          key->getTagEnd() << ", num = " << key->getNum() << std::endl;
+    /**
+     * Find an entry whose tag range holds the given tag.
+     * @param tag tag to look for.
+     * @return item found or null if none.
+     */
+    const EvioXMLDictionary::LookupItem * EvioXMLDictionary::findInRange(uint16_t tag) const {
+        // First range starting after tag
+        auto it = std::upper_bound(rangeItems.begin(), rangeItems.end(), tag,
+                                   [](uint16_t t, RangeItem const & r) {return t < r.tag;});
+
+        // Go back through those starting at or before tag while one might still reach it
+        while (it != rangeItems.begin()) {
+            --it;
+            if (it->maxTagEnd < tag) break;
+            if (it->tagEnd >= tag) return &lookupItems[it->item];
         }
+        return nullptr;
+    }
+
+
+    /**
+     * Find the dictionary entry matching the given key.
+     * If key is a tag/num pair, a search is made for an entry of the tag/num pair,
+     * then of the tag only, then of a tag range holding the tag.
+     * If key is a tag only, the search starts with the tag only.
+     * If key is a tag range, only an entry of the identical range is found.
+     * The key's parent is used only for the first try.
+     *
+     * @param key dictionary entry to look up.
+     * @return item found or null if none.
+     */
+    const EvioXMLDictionary::LookupItem * EvioXMLDictionary::lookup(EvioDictionaryEntry const & key) const {
 
-        out:
+        auto entryType = key.getEntryType();
 
-        return name;
+        // If a tag range was specified, it must match exactly
+        if (entryType == EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE) {
+            return findItem(lookupKey(key), key);
+        }
+
+        const LookupItem *item;
+
+        // There may be multiple entries with the same tag/tagEnd/num values
+        // but having parents with differing values. If the key has no parent,
+        // we just get the first match.
+        if (entryType == EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM) {
+            item = findItem(lookupKey(key), key);
+            if (item != nullptr) return item;
+
+            // Try tag-only match, without parent
+            EvioDictionaryEntry tagOnly(key.getTag());
+            item = findItem(lookupKey(tagOnly), tagOnly);
+        }
+        else {
+            item = findItem(lookupKey(key), key);
+        }
+        if (item != nullptr) return item;
+
+        // See if the tag falls in a range of tags
+        return findInRange(key.getTag());
     }
 
 
@@ -1215,80 +1363,16 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd tagEnd of dictionary entry to find
      * @return entry or null if none found
      */
-    std::shared_ptr<EvioDictionaryEntry> EvioXMLDictionary::entryLookupByData(uint16_t tag, uint8_t num, uint16_t tagEnd) {
+    std::shared_ptr<EvioDictionaryEntry> EvioXMLDictionary::entryLookupByData(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
 
         // Given data, find the entry in dictionary that corresponds to it.
         //
         // The generated key below is equivalent (equals() overridden) to the key existing
-        // in the map. Use it to find the value, then use the value to find the
-        // original key which contains other data besides tag, tagEnd, and num.
-        auto key = std::make_shared<EvioDictionaryEntry>(tag, num, tagEnd);
-        EvioDictionaryEntry::EvioDictionaryEntryType entryType = key->getEntryType();
-
-        std::string name;
-        std::shared_ptr<EvioDictionaryEntry> entry = nullptr;
-
-        switch (entryType) {
-            case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM : {
-
-                bool foundEntry = false;
-                for (auto & item : tagNumMap) {
-                    // We need to compare the actual objects ...
-                    if (*(item.first.get()) == *(key.get())) {
-                        entry = item.first;
-                        foundEntry = true;
-                        break;
-                    }
-                }
-
-                if (foundEntry) break;
-
-                // Create tag-only key and try to find tag-only match
-                key = std::make_shared<EvioDictionaryEntry>(tag);
-            }
-            case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_ONLY : {
-
-                for (auto & item : tagOnlyMap) {
-                    if (*(item.first.get()) == *(key.get())) {
-                        entry = item.first;
-                        goto out;
-                    }
-                }
-
-                // Create tag-range key and try to find tag-range match
-                key = std::make_shared<EvioDictionaryEntry>(tag, tagEnd);
-            }
-            case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE : {
-
-                for (auto & item : tagRangeMap) {
-                    if (*(item.first.get()) == *(key.get())) {
-                        entry = item.first;
-                        goto out;
-                    }
-                }
-
-                // If a tag/num pair or only a tag was specified in the args,
-                // see if either falls in a range of tags.
-                if (entryType != EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE) {
-                    // See if tag fits in a range
-                    for (auto & item : tagRangeMap) {
-                        if (item.first->inRange(tag)) {
-                            entry = item.first;
-                            goto out;
-                        }
-                    }
-                }
-            }
-
-            default:
-                ;
-                //std::cout << "no dictionary entry for tag = " << tag << ", tagEnd = " <<
-                //          key->getTagEnd() << ", num = " << key->getNum() << std::endl;
-        }
-
-        out:
-
-        return entry;
+        // in the map. Use it to find the original key which contains other data
+        // besides tag, tagEnd, and num.
+        EvioDictionaryEntry key(tag, num, tagEnd);
+        const LookupItem *item = lookup(key);
+        return item == nullptr ? nullptr : item->entry;
     }
 
 
@@ -1298,7 +1382,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param name name associated with entry
      * @return entry or null if none found
      */
-    std::shared_ptr<EvioDictionaryEntry> EvioXMLDictionary::entryLookupByName(std::string const & name) {
+    std::shared_ptr<EvioDictionaryEntry> EvioXMLDictionary::entryLookupByName(std::string const & name) const {
         // Check all entries
         auto it2 = reverseMap.find(name);
         if (it2 != reverseMap.end()) {
@@ -1317,7 +1401,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param num    to find the description of
      * @return description or null if none found
      */
-    std::string EvioXMLDictionary::getDescription(uint16_t tag, uint8_t num) {
+    std::string EvioXMLDictionary::getDescription(uint16_t tag, uint8_t num) const {
         return getDescription(tag, num, tag);
     }
 
@@ -1330,7 +1414,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd to find the description of
      * @return description or empty string if none found
      */
-    std::string EvioXMLDictionary::getDescription(uint16_t tag, uint8_t num, uint16_t tagEnd) {
+    std::string EvioXMLDictionary::getDescription(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
         auto entry = entryLookupByData(tag, num, tagEnd);
         if (entry == nullptr) {
             return "";
@@ -1346,7 +1430,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param name dictionary name
      * @return description; empty string if name or is unknown or no description is associated with it
      */
-    std::string EvioXMLDictionary::getDescription(std::string const & name) {
+    std::string EvioXMLDictionary::getDescription(std::string const & name) const {
         auto entry = entryLookupByName(name);
         if (entry == nullptr) {
             return "";
@@ -1363,7 +1447,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param num to find the format of
      * @return the format or null if none found
      */
-    std::string EvioXMLDictionary::getFormat(uint16_t tag, uint8_t num) {
+    std::string EvioXMLDictionary::getFormat(uint16_t tag, uint8_t num) const {
         return getFormat(tag, num, tag);
     }
 
@@ -1376,7 +1460,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd to find the format of
      * @return  format or null if none found
      */
-    std::string EvioXMLDictionary::getFormat(uint16_t tag, uint8_t num, uint16_t tagEnd) {
+    std::string EvioXMLDictionary::getFormat(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
         auto entry = entryLookupByData(tag, num, tagEnd);
         if (entry == nullptr) {
             return "";
@@ -1392,7 +1476,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param name dictionary name
      * @return format; null if name or is unknown or no format is associated with it
      */
-    std::string EvioXMLDictionary::getFormat(std::string const & name) {
+    std::string EvioXMLDictionary::getFormat(std::string const & name) const {
         auto entry = entryLookupByName(name);
         if (entry == nullptr) {
             return "";
@@ -1409,7 +1493,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param num to find the type of
      * @return type or null if none found
      */
-    DataType EvioXMLDictionary::getType(uint16_t tag, uint8_t num) {
+    DataType EvioXMLDictionary::getType(uint16_t tag, uint8_t num) const {
         return getType(tag, num, tag);
     }
 
@@ -1422,7 +1506,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd to find the type of.
      * @return type or DataType::NOT_A_VALID_TYPE if none found.
      */
-    DataType EvioXMLDictionary::getType(uint16_t tag, uint8_t num, uint16_t tagEnd) {
+    DataType EvioXMLDictionary::getType(uint16_t tag, uint8_t num, uint16_t tagEnd) const {
         auto entry = entryLookupByData(tag, num, tagEnd);
         if (entry == nullptr) {
             return DataType::NOT_A_VALID_TYPE;
@@ -1438,7 +1522,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param name dictionary name.
      * @return type; DataType::NOT_A_VALID_TYPE if name or is unknown or no type is associated with it.
      */
-    DataType EvioXMLDictionary::getType(std::string const & name) {
+    DataType EvioXMLDictionary::getType(std::string const & name) const {
         auto entry = entryLookupByName(name);
         if (entry == nullptr) {
             return DataType::NOT_A_VALID_TYPE;
@@ -1467,7 +1551,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd pointer which gets filled with tagEnd value.
      * @return true if entry found, else false.
      */
-    bool EvioXMLDictionary::getTagNum(std::string const & name, uint16_t *tag, uint8_t *num, uint16_t *tagEnd) {
+    bool EvioXMLDictionary::getTagNum(std::string const & name, uint16_t *tag, uint8_t *num, uint16_t *tagEnd) const {
         auto entry = entryLookupByName(name);
         if (entry != nullptr) {
             if (tag != nullptr)    {*tag = entry->getTag();}
@@ -1486,7 +1570,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tag pointer which gets filled with tag value.
      * @return true if entry found, else false.
      */
-    bool EvioXMLDictionary::getTag(std::string const & name, uint16_t *tag) {
+    bool EvioXMLDictionary::getTag(std::string const & name, uint16_t *tag) const {
         auto entry = entryLookupByName(name);
         if (entry != nullptr) {
             if (tag != nullptr) {
@@ -1505,7 +1589,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param tagEnd pointer which gets filled with tagEnd value.
      * @return true if entry found, else false.
      */
-    bool EvioXMLDictionary::getTagEnd(std::string const & name, uint16_t *tagEnd) {
+    bool EvioXMLDictionary::getTagEnd(std::string const & name, uint16_t *tagEnd) const {
         auto entry = entryLookupByName(name);
         if (entry != nullptr) {
             if (tagEnd != nullptr) {
@@ -1525,7 +1609,7 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * @param num pointer which gets filled with entry's num value.
      * @return true if entry found, else false.
      */
-    bool EvioXMLDictionary::getNum(std::string const & name, uint8_t *num) {
+    bool EvioXMLDictionary::getNum(std::string const & name, uint8_t *num) const {
         auto entry = entryLookupByName(name);
         if (entry != nullptr) {
             if (num != nullptr) {*num = entry->getNum();}
@@ -1540,53 +1624,53 @@ std::cout << "Num or num range is DEFINED => num = " << num << ", numEnd = " <<
      * Get a string representation of the dictionary.
      * @return a string representation of the dictionary.
      */
-    std::string EvioXMLDictionary::toString() {
-        if (!stringRepresentation.empty()) return stringRepresentation;
-
-        int row=1;
-        std::shared_ptr<EvioDictionaryEntry> entry;
-        std::string sb, name;
-        sb.reserve(4096);
-        sb.append("-- Dictionary --\n\n");
-
-        for (auto const & mapItem : reverseMap) {
-            // Get the entry
-            name  = mapItem.first;
-            entry = mapItem.second;
-
-            uint8_t num = entry->getNum();
-            uint16_t tag = entry->getTag();
-            uint16_t tagEnd = entry->getTagEnd();
-
-            switch (entry->getEntryType()) {
-                case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE : {
-                    std::stringstream ss;
-                    ss << std::setw(30) << name << ": tag range " << tag << "-" << tagEnd << std::endl;
-                    sb.append(ss.str());
-                    break;
-                }
-                case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_ONLY : {
-                    std::stringstream ss;
-                    ss << std::setw(30) << name << ": tag " << tag << std::endl;
-                    sb.append(ss.str());
-                    break;
+    std::string EvioXMLDictionary::toString() const {
+        std::call_once(stringOnce, [this]() {
+            int row=1;
+            std::shared_ptr<EvioDictionaryEntry> entry;
+            std::string sb, name;
+            sb.reserve(4096);
+            sb.append("-- Dictionary --\n\n");
+
+            for (auto const & mapItem : reverseMap) {
+                // Get the entry
+                name  = mapItem.first;
+                entry = mapItem.second;
+
+                uint8_t num = entry->getNum();
+                uint16_t tag = entry->getTag();
+                uint16_t tagEnd = entry->getTagEnd();
+
+                switch (entry->getEntryType()) {
+                    case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_RANGE : {
+                        std::stringstream ss;
+                        ss << std::setw(30) << name << ": tag range " << tag << "-" << tagEnd << std::endl;
+                        sb.append(ss.str());
+                        break;
+                    }
+                    case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_ONLY : {
+                        std::stringstream ss;
+                        ss << std::setw(30) << name << ": tag " << tag << std::endl;
+                        sb.append(ss.str());
+                        break;
+                    }
+                    case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM : {
+                        std::stringstream ss;
+                        ss << std::setw(30) << name << ": tag " << tag << ", num " << num << std::endl;
+                        sb.append(ss.str());
+                        break;
+                    }
+                    default: {}
                 }
-                case EvioDictionaryEntry::EvioDictionaryEntryType::TAG_NUM : {
-                    std::stringstream ss;
-                    ss << std::setw(30) << name << ": tag " << tag << ", num " << num << std::endl;
-                    sb.append(ss.str());
-                    break;
+
+                if (row++ % 4 == 0) {
+                    sb.append("\n");
                 }
-                default: {}
-            }
 
-            if (row++ % 4 == 0) {
-                sb.append("\n");
             }
 
-        }
-
-        stringRepresentation = sb;
+            stringRepresentation = sb;
+        });
         return stringRepresentation;
     }
 
@@ -21,6 +21,9 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <tuple>
+#include <memory>
+#include <mutex>
 
 #include "EvioDictionaryEntry.h"
 #include "EvioException.h"
@@ -47,7 +50,16 @@ namespace evio {
      * Similarly, an entry with a range of tags is also allowed. In this case,
      * no num &amp; type is allowed. It will match
      * a tag/num pair if no exact match exists but the tag is in the range
-     * (inclusive).
+     * (inclusive).<p>
+     *
+     * Once the xml is parsed, all entries are copied into flat lookup tables: an open addressing
+     * hash table keyed by packed tag, num, and tagEnd values, and an array of tag ranges sorted by
+     * tag for finding the range a tag falls in. Looking up entries by tag, num, and tagEnd uses only
+     * these tables, so changing tagNumMap, tagOnlyMap, or tagRangeMap afterwards has no effect on it.<p>
+     *
+     * Programs reading many files of one run, each with the same dictionary, can get a dictionary
+     * shared by the whole process through {@link #intern(std::string const &)}, which parses
+     * each distinct xml string only once. All lookups are const and safe to call from many threads.
      *
      * @author heddle
      * @author timmer
@@ -56,6 +68,32 @@ namespace evio {
 
     private:
 
+        /** One dictionary entry, with its name, in the flat lookup tables. */
+        struct LookupItem {
+            std::shared_ptr<EvioDictionaryEntry> entry;
+            std::string name;
+        };
+
+        /** Slot of the open addressing hash table. Key of 0 means empty. */
+        struct LookupSlot {
+            /** Packed tag, num, tagEnd, and entry type. */
+            uint64_t key;
+            /** Index into lookupItems of first item with this key. */
+            uint32_t first;
+            /** Number of items with this key (more than one if parents differ). */
+            uint32_t count;
+        };
+
+        /** Tag range entry. */
+        struct RangeItem {
+            uint16_t tag;
+            uint16_t tagEnd;
+            /** Largest tagEnd of this and all ranges before it. */
+            uint16_t maxTagEnd;
+            /** Index into lookupItems. */
+            uint32_t item;
+        };
+
         /** Element containing entire dictionary. */
         static const std::string DICT_TOP_LEVEL;
 
@@ -158,7 +196,19 @@ namespace evio {
          * Keep a copy of the string representation around so toString() only does hard work once.
          * @since 4.1
          */
-        std::string stringRepresentation;
+        mutable std::string stringRepresentation;
+
+        /** Makes the string representation only once, even if asked for by several threads. */
+        mutable std::once_flag stringOnce;
+
+        /** All entries of the 3 tag maps, those with the same key next to each other. */
+        std::vector<LookupItem> lookupItems;
+
+        /** Open addressing hash table of entries, size is a power of 2. */
+        std::vector<LookupSlot> lookupSlots;
+
+        /** All tag range entries sorted by tag. */
+        std::vector<RangeItem> rangeItems;
 
 
     public:
@@ -169,6 +219,10 @@ namespace evio {
         explicit EvioXMLDictionary(std::string const &path);
         EvioXMLDictionary(std::string const &xml, int dummy);
 
+        static std::shared_ptr<const EvioXMLDictionary> intern(std::string const &xml);
+        static void clearInterned();
+        static size_t internedCount();
+
 
         void parseXML(pugi::xml_parse_result &domDocument);
 
@@ -183,51 +237,58 @@ namespace evio {
         void addHierarchicalDictEntries(std::vector<pugi::xml_node> &kidList,
                                         std::string const &parentName);
 
+        void buildLookupTables();
+        static uint64_t lookupKey(EvioDictionaryEntry const & entry);
+        static size_t lookupSlot(uint64_t key, size_t mask);
+        const LookupItem * findItem(uint64_t key, EvioDictionaryEntry const & entry) const;
+        const LookupItem * findInRange(uint16_t tag) const;
+        const LookupItem * lookup(EvioDictionaryEntry const & key) const;
+
     public:
 
-        std::string getName(std::shared_ptr<BaseStructure> &structure);
-        std::string getName(uint16_t tag);
-        std::string getName(uint16_t tag, uint8_t num);
-        std::string getName(uint16_t tag, uint8_t num, uint16_t tagEnd);
+        std::string getName(std::shared_ptr<BaseStructure> const &structure) const;
+        std::string getName(uint16_t tag) const;
+        std::string getName(uint16_t tag, uint8_t num) const;
+        std::string getName(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
         std::string getName(uint16_t tag, uint8_t num, uint16_t tagEnd,
-                            uint16_t pTag, uint8_t pNum, uint16_t pTagEnd);
+                            uint16_t pTag, uint8_t pNum, uint16_t pTagEnd) const;
         std::string getName(uint16_t tag, uint8_t num, uint16_t tagEnd,
                             uint16_t pTag, uint8_t pNum, uint16_t pTagEnd,
                             bool numValid = true, bool parentValid = false,
-                            bool parentNumValid = false);
+                            bool parentNumValid = false) const;
 
 
     private:
 
 
-        std::string getName(std::shared_ptr<EvioDictionaryEntry> key);
-        std::shared_ptr<EvioDictionaryEntry> entryLookupByData(uint16_t tag, uint8_t num, uint16_t tagEnd);
-        std::shared_ptr<EvioDictionaryEntry> entryLookupByName(std::string const &name);
+        std::string getName(std::shared_ptr<EvioDictionaryEntry> key) const;
+        std::shared_ptr<EvioDictionaryEntry> entryLookupByData(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        std::shared_ptr<EvioDictionaryEntry> entryLookupByName(std::string const &name) const;
 
 
     public:
 
 
-        std::string getDescription(uint16_t tag, uint8_t num);
-        std::string getDescription(uint16_t tag, uint8_t num, uint16_t tagEnd);
-        std::string getDescription(std::string const &name);
+        std::string getDescription(uint16_t tag, uint8_t num) const;
+        std::string getDescription(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        std::string getDescription(std::string const &name) const;
 
-        std::string getFormat(uint16_t tag, uint8_t num);
-        std::string getFormat(uint16_t tag, uint8_t num, uint16_t tagEnd);
-        std::string getFormat(std::string const &name);
+        std::string getFormat(uint16_t tag, uint8_t num) const;
+        std::string getFormat(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        std::string getFormat(std::string const &name) const;
 
-        DataType getType(uint16_t tag, uint8_t num);
-        DataType getType(uint16_t tag, uint8_t num, uint16_t tagEnd);
-        DataType getType(std::string const &name);
+        DataType getType(uint16_t tag, uint8_t num) const;
+        DataType getType(uint16_t tag, uint8_t num, uint16_t tagEnd) const;
+        DataType getType(std::string const &name) const;
 
-        bool getTagNum(std::string const &name, uint16_t *tag, uint8_t *num, uint16_t *tagEnd);
-        bool getTag(std::string const &name, uint16_t *tag);
-        bool getTagEnd(std::string const &name, uint16_t *tagEnd);
+        bool getTagNum(std::string const &name, uint16_t *tag, uint8_t *num, uint16_t *tagEnd) const;
+        bool getTag(std::string const &name, uint16_t *tag) const;
+        bool getTagEnd(std::string const &name, uint16_t *tagEnd) const;
 
-        bool getNum(std::string const &name, uint8_t *num);
+        bool getNum(std::string const &name, uint8_t *num) const;
 
 
-        std::string toString();
+        std::string toString() const;
     };
 
 }
@@ -0,0 +1,76 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "FileByteSource.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which opens the file.
+     * @param filename name of file.
+     * @throws EvioException if file cannot be opened.
+     */
+    FileByteSource::FileByteSource(std::string const & filename) : fileName(filename) {
+        fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw EvioException("cannot open file " + filename);
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw EvioException("cannot get size of file " + filename);
+        }
+        fileSize = st.st_size;
+    }
+
+
+    /** Destructor which closes the file. */
+    FileByteSource::~FileByteSource() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+
+    /** {@inheritDoc} */
+    std::string FileByteSource::getName() const {return fileName;}
+
+
+    /** {@inheritDoc} */
+    uint64_t FileByteSource::getSize() {return fileSize;}
+
+
+    /** {@inheritDoc} */
+    void FileByteSource::read(uint64_t position, size_t length, uint8_t *dest) {
+        while (length > 0) {
+            ssize_t n = ::pread(fd, dest, length, (off_t)position);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException("error reading file " + fileName + ": " + std::strerror(errno));
+            }
+            if (n == 0) {
+                throw EvioException("file " + fileName + " too short");
+            }
+            dest     += n;
+            position += n;
+            length   -= n;
+        }
+    }
+
+}
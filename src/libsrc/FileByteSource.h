@@ -0,0 +1,57 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_FILEBYTESOURCE_H
+#define EVIO_6_0_FILEBYTESOURCE_H
+
+
+#include <cstdint>
+#include <string>
+
+
+#include "ByteSource.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a {@link ByteSource} reading a local file with positional reads (pread),
+     * which leave no file position to share between threads.
+     */
+    class FileByteSource : public ByteSource {
+
+    private:
+
+        /** File name. */
+        std::string fileName;
+        /** File descriptor. */
+        int fd = -1;
+        /** File size in bytes. */
+        uint64_t fileSize = 0;
+
+    public:
+
+        explicit FileByteSource(std::string const & filename);
+        ~FileByteSource() override;
+
+        FileByteSource(const FileByteSource &) = delete;
+        FileByteSource & operator=(const FileByteSource &) = delete;
+
+        std::string getName() const override;
+        uint64_t getSize() override;
+        void read(uint64_t position, size_t length, uint8_t *dest) override;
+    };
+
+}
+
+
+#endif //EVIO_6_0_FILEBYTESOURCE_H
@@ -84,6 +84,31 @@ namespace evio {
     }
 
 
+    /**
+     * Gets the number of the record containing the given event
+     * without changing the current event or record.
+     * @param event global event number, which must be less than {@link #getMaxEvents()}.
+     * @return number of record containing event.
+     */
+    uint32_t FileEventIndex::getRecordOfEvent(uint32_t event) const {
+        // The first element in recordIndex is fake, shift by 1 for record number
+        auto it = std::upper_bound(recordIndex.cbegin(), recordIndex.cend(), event);
+        return std::distance(recordIndex.cbegin(), it) - 1;
+    }
+
+
+    /**
+     * Gets the global event number of the first event in the given record.
+     * @param record record number, which may be one past the last record.
+     * @return global event number of first event in record,
+     *         or {@link #getMaxEvents()} if past the last record.
+     */
+    uint32_t FileEventIndex::getFirstEventOfRecord(uint32_t record) const {
+        if (record >= recordIndex.size()) return getMaxEvents();
+        return recordIndex[record];
+    }
+
+
     /**
      * Checks to see if the event counter reached the end.
      * @return true if there are more events to advance to, false otherwise.
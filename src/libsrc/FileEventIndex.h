@@ -68,6 +68,8 @@ namespace evio {
         uint32_t getRecordNumber()      const;
         uint32_t getRecordEventNumber() const;
         uint32_t getMaxEvents()         const;
+        uint32_t getRecordOfEvent(uint32_t event) const;
+        uint32_t getFirstEventOfRecord(uint32_t record) const;
 
         bool canAdvance() const;
         bool canRetreat() const;
@@ -10,6 +10,9 @@
 
 #include "FileHeader.h"
 
+#include <cstring>
+#include <cstddef>
+
 
 namespace evio {
 
@@ -430,6 +433,42 @@ namespace evio {
     }
 
 
+    /**
+     * Set the bit in the file header which says the user header holds a trained compression dictionary.
+     * @param hasDict  true if user header holds a trained compression dictionary.
+     * @return new bitInfo word.
+     */
+    uint32_t FileHeader::hasCompressionDictionary(bool hasDict) {
+        if (hasDict) {
+            // set bit
+            bitInfo |= COMPRESSION_DICT_BIT;
+        }
+        else {
+            // clear bit
+            bitInfo &= ~COMPRESSION_DICT_BIT;
+        }
+
+        return bitInfo;
+    }
+
+
+    /**
+     * Does this file's user header hold a trained compression dictionary?
+     * @return true if user header holds a trained compression dictionary, else false.
+     */
+    bool FileHeader::hasCompressionDictionary() const {return ((bitInfo & COMPRESSION_DICT_BIT) != 0);}
+
+
+    /**
+    * Does this bitInfo arg indicate the user header holds a trained compression dictionary?
+    * @param bitInfo bitInfo word.
+    * @return true if user header holds a trained compression dictionary, else false.
+    */
+    bool FileHeader::hasCompressionDictionary(uint32_t bitInfo) {
+        return ((bitInfo & COMPRESSION_DICT_BIT) != 0);
+    }
+
+
     /**
      * Is this header followed by a user header?
      * @return true if header followed by a user header, else false.
@@ -592,19 +631,69 @@ namespace evio {
             throw EvioException("buffer too small");
         }
 
-        buf.putInt (     off, fileId);            //  0*4
-        buf.putInt ( 4 + off, fileNumber);        //  1*4
-        buf.putInt ( 8 + off, headerLengthWords); //  2*4
-        buf.putInt (12 + off, entries);           //  3*4
-        buf.putInt (16 + off, indexLength);       //  4*4
-        buf.putInt (20 + off, getBitInfoWord());  //  5*4
-
-        buf.putInt (24 + off, userHeaderLength);  //  6*4
-        buf.putInt (28 + off, headerMagicWord);   //  7*4
-        buf.putLong(32 + off, userRegister);      //  8*4
-        buf.putLong(40 + off, trailerPosition);   // 10*4
-        buf.putInt (48 + off, userIntFirst);      // 12*4
-        buf.putInt (52 + off, userIntSecond);     // 13*4
+        uint8_t *dest = buf.array() + buf.arrayOffset() + off;
+        if (buf.isSwapped()) {
+            writeHeaderWords<true>(dest);
+        }
+        else {
+            writeHeaderWords<false>(dest);
+        }
+    }
+
+
+    /**
+     * Swap each of the header words, if need be.
+     *
+     * @tparam SWAP  true if words must be swapped.
+     * @param words  header words.
+     */
+    template<bool SWAP>
+    void FileHeader::swapWords(Words & words) {
+        if constexpr (SWAP) {
+            words.fileId           = SWAP_32(words.fileId);
+            words.fileNumber       = SWAP_32(words.fileNumber);
+            words.headerLength     = SWAP_32(words.headerLength);
+            words.entries          = SWAP_32(words.entries);
+            words.indexLength      = SWAP_32(words.indexLength);
+            words.bitInfo          = SWAP_32(words.bitInfo);
+            words.userHeaderLength = SWAP_32(words.userHeaderLength);
+            words.magic            = SWAP_32(words.magic);
+            words.userRegister     = SWAP_64(words.userRegister);
+            words.trailerPosition  = SWAP_64(words.trailerPosition);
+            words.userIntFirst     = SWAP_32(words.userIntFirst);
+            words.userIntSecond    = SWAP_32(words.userIntSecond);
+        }
+    }
+
+
+    /**
+     * Writes the header words, in one copy, with byte order known at compile time.
+     *
+     * @tparam SWAP  true if data must be swapped into the local byte order.
+     * @param dest   where to write, with room for the header.
+     */
+    template<bool SWAP>
+    void FileHeader::writeHeaderWords(uint8_t *dest) const {
+        static_assert(sizeof(Words) == HEADER_SIZE_BYTES &&
+                      offsetof(Words, userRegister) == REGISTER1_OFFSET &&
+                      offsetof(Words, userIntFirst) == INT1_OFFSET, "Words misaligned");
+
+        Words words;
+        words.fileId           = fileId;
+        words.fileNumber       = fileNumber;
+        words.headerLength     = headerLengthWords;
+        words.entries          = entries;
+        words.indexLength      = indexLength;
+        words.bitInfo          = getBitInfoWord();
+        words.userHeaderLength = userHeaderLength;
+        words.magic            = headerMagicWord;
+        words.userRegister     = userRegister;
+        words.trailerPosition  = trailerPosition;
+        words.userIntFirst     = userIntFirst;
+        words.userIntSecond    = userIntSecond;
+        swapWords<SWAP>(words);
+
+        std::memcpy(dest, &words, HEADER_SIZE_BYTES);
     }
 
 
@@ -664,29 +753,53 @@ namespace evio {
             byteOrder = buffer.order();
         }
 
+        // Byte order is now known, so read the rest without testing it for each word
+        const uint8_t *src = buffer.array() + buffer.arrayOffset() + offset;
+        if (buffer.isSwapped()) {
+            readHeaderWords<true>(src);
+        }
+        else {
+            readHeaderWords<false>(src);
+        }
+    }
+
+
+    /**
+     * Reads the header words, in one copy, following the magic word's determination of byte order.
+     *
+     * @tparam SWAP  true if data must be swapped.
+     * @param src    header to read from, at least {@link #HEADER_SIZE_BYTES} long.
+     * @throws EvioException if version earlier than 6.
+     */
+    template<bool SWAP>
+    void FileHeader::readHeaderWords(const uint8_t *src) {
+        Words words;
+        std::memcpy(&words, src, HEADER_SIZE_BYTES);
+        swapWords<SWAP>(words);
+
         // Next look at the version #
-        bitInfo = buffer.getInt(BIT_INFO_OFFSET + offset);
+        bitInfo = words.bitInfo;
         decodeBitInfoWord(bitInfo);
         if (headerVersion < 6) {
             throw EvioException("evio version < 6, = " + std::to_string(headerVersion));
         }
 
-        fileId            = buffer.getInt(FILE_ID_OFFSET + offset);
-        fileNumber        = buffer.getInt(FILE_NUMBER_OFFSET + offset);
-        headerLengthWords = buffer.getInt(HEADER_LENGTH_OFFSET + offset);
+        fileId            = words.fileId;
+        fileNumber        = words.fileNumber;
+        headerLengthWords = words.headerLength;
         setHeaderLength(4*headerLengthWords);
 
-        entries           = buffer.getInt(RECORD_COUNT_OFFSET + offset);
-        indexLength       = buffer.getInt(INDEX_ARRAY_OFFSET + offset);
+        entries           = words.entries;
+        indexLength       = words.indexLength;
         setIndexLength(indexLength);
 
-        userHeaderLength  = buffer.getInt(USER_LENGTH_OFFSET + offset);
+        userHeaderLength  = words.userHeaderLength;
         setUserHeaderLength(userHeaderLength);
 
-        userRegister     = buffer.getLong(REGISTER1_OFFSET + offset);
-        trailerPosition  = buffer.getLong(TRAILER_POSITION_OFFSET + offset);
-        userIntFirst     = buffer.getInt (INT1_OFFSET + offset);
-        userIntSecond    = buffer.getInt (INT2_OFFSET + offset);
+        userRegister     = words.userRegister;
+        trailerPosition  = words.trailerPosition;
+        userIntFirst     = words.userIntFirst;
+        userIntSecond    = words.userIntSecond;
     }
 
 
@@ -734,6 +847,7 @@ namespace evio {
         ss << std::setw(24) << "has dictionary"   << " : " << hasDictionary() << std::endl;
         ss << std::setw(24) << "has firstEvent"   << " : " << hasFirstEvent() << std::endl;
         ss << std::setw(24) << "has trailer w/ index" << " : " << hasTrailerWithIndex() << std::endl;
+        ss << std::setw(24) << "has compression dict" << " : " << hasCompressionDictionary() << std::endl;
         ss << std::dec;
         ss << std::setw(24) << "record entries"   << " : " << entries << std::endl;
         ss << std::setw(24) << "index length"     << " : " << indexLength << std::endl;
@@ -72,7 +72,8 @@ namespace evio {
      *     8    = true if dictionary is included (relevant for first record only)
      *     9    = true if this file has "first" event (in every split file)
      *    10    = File trailer with index array of record lengths exists
-     *    11-19 = reserved
+     *    11    = true if user header holds a trained compression dictionary
+     *    12-19 = reserved
      *    20-21 = pad 1
      *    22-23 = pad 2
      *    24-25 = pad 3 (always 0)
@@ -141,6 +142,8 @@ namespace evio {
         static const uint32_t   FIRST_EVENT_BIT = 0x200;
         /** 10th bit set in bitInfo word in file header means file trailer with index array exists. */
         static const uint32_t   TRAILER_WITH_INDEX_BIT = 0x400;
+        /** 11th bit set in bitInfo word in file header means user header holds a trained compression dictionary. */
+        static const uint32_t   COMPRESSION_DICT_BIT = 0x800;
 
     private:
 
@@ -211,6 +214,34 @@ namespace evio {
         void decodeBitInfoWord(uint32_t word);
         void setUserHeaderLengthPadding(uint32_t padding);
 
+        /**
+         * The words of a file header laid out just as in a buffer, so all of them
+         * are read or written with one copy and, if need be, swapped in place.
+         */
+        struct Words {
+            uint32_t fileId;             //  0*4
+            uint32_t fileNumber;         //  1*4
+            uint32_t headerLength;       //  2*4
+            uint32_t entries;            //  3*4
+            uint32_t indexLength;        //  4*4
+            uint32_t bitInfo;            //  5*4
+            uint32_t userHeaderLength;   //  6*4
+            uint32_t magic;              //  7*4
+            uint64_t userRegister;       //  8*4
+            uint64_t trailerPosition;    // 10*4
+            uint32_t userIntFirst;       // 12*4
+            uint32_t userIntSecond;      // 13*4
+        };
+
+        template<bool SWAP>
+        static void swapWords(Words & words);
+
+        template<bool SWAP>
+        void readHeaderWords(const uint8_t *src);
+
+        template<bool SWAP>
+        void writeHeaderWords(uint8_t *dest) const;
+
     public:
 
         // Getters
@@ -258,12 +289,16 @@ namespace evio {
         uint32_t hasTrailerWithIndex(bool hasTrailerWithIndex);
         bool     hasTrailerWithIndex() const;
 
+        uint32_t hasCompressionDictionary(bool hasDict);
+        bool     hasCompressionDictionary() const;
+
         bool hasUserHeader() const;
         bool hasIndex() const;
 
         static bool hasFirstEvent(uint32_t bitInfo);
         static bool hasDictionary(uint32_t bitInfo);
         static bool hasTrailerWithIndex(uint32_t bitInfo);
+        static bool hasCompressionDictionary(uint32_t bitInfo);
 
         // Setters
 
@@ -0,0 +1,244 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "FileSyncer.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace evio {
+
+
+    /**
+     * Force the data of a file descriptor to disk. Metadata is not forced,
+     * except on the Mac where there is no fdatasync.
+     * @param fd file descriptor.
+     * @return 0 if successful, else errno.
+     */
+    static int dataSync(int fd) {
+        int result;
+        do {
+#ifdef __APPLE__
+            result = ::fsync(fd);
+#else
+            result = ::fdatasync(fd);
+#endif
+        } while (result < 0 && errno == EINTR);
+
+        return result < 0 ? errno : 0;
+    }
+
+
+    /**
+     * Convert an integer to a durability policy.
+     * @param value integer value.
+     * @return durability policy, NO_SYNC if value is unknown.
+     */
+    FileSyncer::Durability FileSyncer::toDurability(uint32_t value) {
+        switch (value) {
+            case SYNC_ON_CLOSE: return SYNC_ON_CLOSE;
+            case GROUP_COMMIT:  return GROUP_COMMIT;
+            default:            return NO_SYNC;
+        }
+    }
+
+
+    /**
+     * Force the data of a closed file to disk, as after changing it once written.
+     * @param file name of file.
+     * @throws EvioException if file cannot be opened or synced.
+     */
+    void FileSyncer::syncFile(std::string const & file) {
+        // Syncing needs no write access on Linux or the Mac
+        int f = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (f < 0) {
+            throw EvioException("error opening file " + file + ": " + std::string(std::strerror(errno)));
+        }
+        int err = dataSync(f);
+        ::close(f);
+        if (err != 0) {
+            throw EvioException("error syncing file " + file + ": " + std::string(std::strerror(err)));
+        }
+    }
+
+
+    /**
+     * Constructor. With GROUP_COMMIT, the thread doing the syncing is started.
+     * @param file           name of file, which must already exist.
+     * @param durability     policy for forcing data to disk.
+     * @param intervalMillis with GROUP_COMMIT, max milliseconds between syncs, 0 for no limit.
+     * @param intervalBytes  with GROUP_COMMIT, max bytes written between syncs, 0 for no limit.
+     *                       If both are 0, DEFAULT_INTERVAL_MILLIS is used.
+     * @throws EvioException if file cannot be opened.
+     */
+    FileSyncer::FileSyncer(std::string const & file, Durability durability,
+                           uint32_t intervalMillis, uint64_t intervalBytes) :
+            fileName(file), durability(durability),
+            intervalMillis(intervalMillis), intervalBytes(intervalBytes) {
+
+        if (durability == NO_SYNC) return;
+
+        if (this->intervalMillis == 0 && this->intervalBytes == 0) {
+            this->intervalMillis = DEFAULT_INTERVAL_MILLIS;
+        }
+
+        fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw EvioException("error opening file " + file + ": " + std::string(std::strerror(errno)));
+        }
+
+        if (durability == GROUP_COMMIT) {
+            thd = std::thread([this]() {this->run();});
+        }
+    }
+
+
+    /** Destructor which stops the thread without a final sync. */
+    FileSyncer::~FileSyncer() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cond.notify_all();
+        if (thd.joinable()) thd.join();
+
+        if (fd > -1) {
+            ::close(fd);
+        }
+    }
+
+
+    /**
+     * Get the policy for forcing data to disk.
+     * @return policy for forcing data to disk.
+     */
+    FileSyncer::Durability FileSyncer::getDurability() const {return durability;}
+
+
+    /**
+     * Get the file position up to which all data is known to be on disk.
+     * Always 0 with NO_SYNC.
+     * @return file position up to which all data is on disk.
+     */
+    uint64_t FileSyncer::getDurableOffset() const {return durableOffset;}
+
+
+    /**
+     * Get the number of times the file has been synced.
+     * @return number of times the file has been synced.
+     */
+    uint64_t FileSyncer::getSyncCount() const {return syncCount;}
+
+
+    /**
+     * Tell this object that all data up to the given file position has been handed
+     * to the operating system. It does not block the caller.
+     * @param offset file position up to which data has been written.
+     */
+    void FileSyncer::written(uint64_t offset) {
+        if (durability == NO_SYNC) return;
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (offset <= writtenOffset) return;
+            writtenOffset = offset;
+            wake = intervalBytes > 0 && writtenOffset - durableOffset >= intervalBytes;
+        }
+        if (wake) {
+            cond.notify_one();
+        }
+    }
+
+
+    /**
+     * Sync the file, without holding the mutex, then advance the durable offset.
+     * @param offset file position up to which data was written before syncing.
+     * @return true if successful.
+     */
+    bool FileSyncer::syncTo(uint64_t offset) {
+        int err = dataSync(fd);
+        if (err != 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!haveError) {
+                error = "error syncing file " + fileName + ": " + std::string(std::strerror(err));
+                haveError = true;
+            }
+            return false;
+        }
+
+        if (offset > durableOffset) {
+            durableOffset = offset;
+        }
+        syncCount++;
+        return true;
+    }
+
+
+    /** Method run by the group commit thread. */
+    void FileSyncer::run() {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        auto due = [this]() {
+            return stopping || (intervalBytes > 0 && writtenOffset - durableOffset >= intervalBytes);
+        };
+
+        while (!stopping) {
+            if (intervalMillis > 0) {
+                cond.wait_for(lock, std::chrono::milliseconds(intervalMillis), due);
+            }
+            else {
+                cond.wait(lock, due);
+            }
+            if (stopping) break;
+
+            uint64_t offset = writtenOffset;
+            if (offset <= durableOffset) continue;
+
+            lock.unlock();
+            bool ok = syncTo(offset);
+            lock.lock();
+            // Syncing again is pointless once it's failed
+            if (!ok) return;
+        }
+    }
+
+
+    /**
+     * Stop syncing periodically and, unless the policy is NO_SYNC,
+     * sync everything written. Call once the file is completely written.
+     * Does nothing if already finished.
+     * @throws EvioException if syncing, now or before, failed.
+     */
+    void FileSyncer::finish() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cond.notify_all();
+        if (thd.joinable()) thd.join();
+
+        if (fd > -1) {
+            syncTo(writtenOffset);
+            ::close(fd);
+            fd = -1;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (haveError) {
+            throw EvioException(error);
+        }
+    }
+
+}
@@ -0,0 +1,126 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_FILESYNCER_H
+#define EVIO_6_0_FILESYNCER_H
+
+
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class forces the data written to a file physically to disk according to a
+     * durability policy, and keeps track of how much of the file is known to be there.
+     * Run control can use that durable byte offset as a safe checkpoint.<p>
+     *
+     * With {@link #GROUP_COMMIT}, a thread of its own calls fdatasync every so many
+     * milliseconds or bytes, whichever comes first, so that the many writes in between
+     * share the cost of one sync and writing never waits for the disk.
+     * With {@link #SYNC_ON_CLOSE}, the file is synced only once it's all written.<p>
+     *
+     * The writer tells this object, through {@link #written(uint64_t)}, once data up
+     * to a file position has been handed to the operating system. Any data before
+     * that position must also have been handed over by then.
+     * The file is synced through a file descriptor of this object's own.
+     */
+    class FileSyncer {
+
+    public:
+
+        /** Policies for forcing file data to disk. */
+        enum Durability {
+            /** Leave it to the operating system, the default. */
+            NO_SYNC = 0,
+            /** Sync the file once when it's closed. */
+            SYNC_ON_CLOSE = 1,
+            /** Sync the file every so many milliseconds or bytes, and when it's closed. */
+            GROUP_COMMIT = 2
+        };
+
+        /** Default number of milliseconds between syncs with GROUP_COMMIT. */
+        static const uint32_t DEFAULT_INTERVAL_MILLIS = 100;
+
+        /** Default number of bytes written between syncs with GROUP_COMMIT. */
+        static const uint64_t DEFAULT_INTERVAL_BYTES = 64*1024*1024;
+
+    private:
+
+        /** Name of file being synced. */
+        std::string fileName;
+        /** File descriptor used for syncing. */
+        int fd = -1;
+
+        /** Policy for forcing data to disk. */
+        Durability durability;
+        /** With GROUP_COMMIT, max milliseconds between syncs, 0 for no limit. */
+        uint32_t intervalMillis;
+        /** With GROUP_COMMIT, max bytes written between syncs, 0 for no limit. */
+        uint64_t intervalBytes;
+
+        /** File position up to which data has been handed to the operating system. */
+        uint64_t writtenOffset = 0;
+        /** File position up to which data is on disk. */
+        std::atomic<uint64_t> durableOffset{0};
+        /** Number of syncs done. */
+        std::atomic<uint64_t> syncCount{0};
+
+        /** First error from syncing. */
+        std::string error;
+        /** Has syncing failed? */
+        bool haveError = false;
+
+        /** Thread doing group commits. */
+        std::thread thd;
+        /** Is thread to quit? */
+        bool stopping = false;
+        /** Guards writtenOffset, error, haveError and stopping. */
+        std::mutex mtx;
+        /** Wakes thread when enough bytes are written or it's to quit. */
+        std::condition_variable cond;
+
+        bool syncTo(uint64_t offset);
+        void run();
+
+    public:
+
+        static Durability toDurability(uint32_t value);
+        static void syncFile(std::string const & file);
+
+        FileSyncer(std::string const & file, Durability durability,
+                   uint32_t intervalMillis = DEFAULT_INTERVAL_MILLIS,
+                   uint64_t intervalBytes  = DEFAULT_INTERVAL_BYTES);
+        ~FileSyncer();
+
+        FileSyncer(const FileSyncer &) = delete;
+        FileSyncer & operator=(const FileSyncer &) = delete;
+
+        Durability getDurability() const;
+        uint64_t getDurableOffset() const;
+        uint64_t getSyncCount() const;
+
+        void written(uint64_t offset);
+        void finish();
+    };
+
+}
+
+
+#endif //EVIO_6_0_FILESYNCER_H
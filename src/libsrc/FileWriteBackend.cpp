@@ -0,0 +1,743 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#include "FileWriteBackend.h"
+#include "AsyncFileWriteBackend.h"
+#include "UringFileWriteBackend.h"
+#include "Profiler.h"
+
+#include <iostream>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param depth max number of writes in flight at once. Values < 1 are set to 1.
+     */
+    FileWriteBackend::FileWriteBackend(uint32_t depth) {
+        queueDepth = depth < 1 ? 1 : depth;
+    }
+
+
+    /** Destructor. Any open file is closed, but errors in doing so are ignored. */
+    FileWriteBackend::~FileWriteBackend() {
+        if (fd > -1) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+
+    /**
+     * Create a backend. If an io_uring backend is requested but cannot be created,
+     * because it's not Linux or the kernel does not support or allow it,
+     * the portable ASYNC backend is returned instead.
+     *
+     * @param type       type of backend.
+     * @param queueDepth max number of writes in flight at once.
+     * @return backend.
+     */
+    std::shared_ptr<FileWriteBackend> FileWriteBackend::create(Type type, uint32_t queueDepth) {
+#ifdef EVIO_HAVE_IO_URING
+        if (type == IO_URING) {
+            try {
+                return std::make_shared<UringFileWriteBackend>(queueDepth);
+            }
+            catch (EvioException & e) {
+                std::cout << "FileWriteBackend: " << e.what() << ", use ASYNC instead" << std::endl;
+            }
+        }
+#endif
+        return std::make_shared<AsyncFileWriteBackend>(queueDepth);
+    }
+
+
+    /**
+     * Write all given data to the file at the given position, retrying on partial writes.
+     * Safe to call from several threads at once as long as the regions written do not overlap.
+     *
+     * @param fd        file descriptor.
+     * @param data      pointer to data.
+     * @param len       number of bytes to write.
+     * @param position  position in the file at which to write.
+     * @throws EvioException if error writing.
+     */
+    void FileWriteBackend::writeFully(int fd, const uint8_t *data, size_t len, uint64_t position) {
+        EVIO_PROFILE_SCOPE(FILE_WRITE);
+        while (len > 0) {
+            ssize_t n = ::pwrite(fd, data, len, (off_t)position);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException("error writing to file: " + std::string(std::strerror(errno)));
+            }
+            data     += n;
+            len      -= n;
+            position += n;
+        }
+    }
+
+
+    /**
+     * Write the given buffers, one after another, completely to a file at the given position.
+     * The segments are taken by value since this is run in other threads.
+     * @param fd        file descriptor.
+     * @param segments  data to write, in order.
+     * @param position  position in the file at which to write the first segment.
+     * @throws EvioException if error writing.
+     */
+    void FileWriteBackend::writeFully(int fd, std::vector<ByteBufferView> segments, uint64_t position) {
+        EVIO_PROFILE_SCOPE(FILE_WRITE);
+        std::vector<struct iovec> iov;
+        iov.reserve(segments.size());
+        for (auto & seg : segments) {
+            if (seg.size() > 0) {
+                iov.push_back({const_cast<uint8_t *>(seg.data()), seg.size()});
+            }
+        }
+
+        size_t first = 0;
+        while (first < iov.size()) {
+            int count = (int) std::min(iov.size() - first, (size_t) IOV_MAX);
+            ssize_t n = ::pwritev(fd, &iov[first], count, (off_t)position);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException("error writing to file: " + std::string(std::strerror(errno)));
+            }
+            position += n;
+
+            // Skip over what's been written
+            while (first < iov.size() && (size_t)n >= iov[first].iov_len) {
+                n -= iov[first].iov_len;
+                first++;
+            }
+            if (first < iov.size()) {
+                iov[first].iov_base = static_cast<uint8_t *>(iov[first].iov_base) + n;
+                iov[first].iov_len -= n;
+            }
+        }
+    }
+
+
+    /**
+     * Reserve disk space for a file descriptor without changing the file's size, so that
+     * a file which grows by appending is not spread over many small extents.
+     * Only done on Linux, and only if the file system supports it.
+     *
+     * @param fd     file descriptor.
+     * @param bytes  number of bytes, from the start of the file, to reserve.
+     * @return true if space was reserved.
+     */
+    static bool reserveSpace(int fd, uint64_t bytes) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+        while (::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)bytes) < 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+
+    /**
+     * Create an empty file and reserve disk space for it, without changing its size.
+     * Used to create the next split file ahead of time, so this is meant to be called
+     * from another thread. Reserved but unused space is given back by
+     * {@link #truncateFile(std::string const &, uint64_t)}.
+     *
+     * @param file              name of file.
+     * @param preallocateBytes  number of bytes to reserve, 0 for none.
+     * @param overwrite         if false, and file already exists, do nothing.
+     * @return true if file was created.
+     */
+    bool FileWriteBackend::createFile(std::string const & file, uint64_t preallocateBytes, bool overwrite) {
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        if (!overwrite) flags |= O_EXCL;
+
+        int f = ::open(file.c_str(), flags, 0644);
+        if (f < 0) {
+            return false;
+        }
+        if (preallocateBytes > 0) {
+            reserveSpace(f, preallocateBytes);
+        }
+        ::close(f);
+        return true;
+    }
+
+
+    /**
+     * Set the length of a closed file, giving back any space reserved past its end.
+     * @param file    name of file.
+     * @param length  length of file in bytes.
+     * @throws EvioException if error truncating file.
+     */
+    void FileWriteBackend::truncateFile(std::string const & file, uint64_t length) {
+        if (::truncate(file.c_str(), (off_t)length) < 0) {
+            throw EvioException("error truncating file " + file + ": " + std::string(std::strerror(errno)));
+        }
+    }
+
+
+    /**
+     * Called by implementations, in the order queued, as each write completes.
+     * Releases the written ring item back to its supply, if there is one.
+     * @param item ring item, may be null.
+     */
+    void FileWriteBackend::writeDone(std::shared_ptr<RecordRingItem> & item) {
+        if (supply != nullptr && item != nullptr) {
+            supply->releaseWriter(item);
+        }
+        item = nullptr;
+        writesCompleted++;
+        reportWritten();
+    }
+
+
+    /**
+     * Called, while holding writeMutex, once a write has been queued so that,
+     * when it completes, the syncer learns how far the file has been written.
+     * @param end file position just past the data written.
+     */
+    void FileWriteBackend::writeQueued(uint64_t end) {
+        if (syncer == nullptr) return;
+        unsyncedWrites.emplace_back(writesQueued, end);
+        // It may be done already
+        reportWritten();
+    }
+
+
+    /**
+     * Tell the syncer how far the file has been written by writes completed so far.
+     * Nothing is reported once a write has failed. Call while holding writeMutex.
+     */
+    void FileWriteBackend::reportWritten() {
+        if (syncer == nullptr) return;
+        if (haveError) {
+            unsyncedWrites.clear();
+            return;
+        }
+
+        uint64_t end = 0;
+        while (!unsyncedWrites.empty() && unsyncedWrites.front().first <= writesCompleted) {
+            end = std::max(end, unsyncedWrites.front().second);
+            unsyncedWrites.pop_front();
+        }
+        if (end > 0) {
+            syncer->written(end);
+        }
+    }
+
+
+    /**
+     * Record an error from a completed write. Only the first is kept.
+     * @param err error message.
+     */
+    void FileWriteBackend::setError(std::string const & err) {
+        if (!haveError) {
+            error = err;
+            haveError = true;
+        }
+    }
+
+
+    /**
+     * Throw an exception if an earlier write failed. Call while holding writeMutex.
+     * @throws EvioException if an earlier write failed.
+     */
+    void FileWriteBackend::throwIfError() {
+        if (haveError) {
+            throw EvioException(error);
+        }
+    }
+
+
+    /**
+     * Get the max number of writes in flight at once.
+     * @return max number of writes in flight at once.
+     */
+    uint32_t FileWriteBackend::getQueueDepth() const {return queueDepth;}
+
+
+    /**
+     * Get the name of the file being written.
+     * @return name of the file being written.
+     */
+    std::string FileWriteBackend::getFileName() const {return fileName;}
+
+
+    /**
+     * Is the file open?
+     * @return true if the file is open, else false.
+     */
+    bool FileWriteBackend::isOpen() const {return fd > -1;}
+
+
+    /**
+     * Is the file open for direct I/O which bypasses the page cache?
+     * This may be false even if requested, if the file system does not support it.
+     * @return true if the file is open for direct I/O, else false.
+     */
+    bool FileWriteBackend::isDirect() const {return directIO;}
+
+
+    /**
+     * Set the supply that written ring items are released back into.
+     * @param recordSupply supply of ring items.
+     */
+    void FileWriteBackend::setSupply(std::shared_ptr<RecordSupply> & recordSupply) {
+        supply = recordSupply;
+    }
+
+
+    /**
+     * Set the policy for forcing written data to disk. By default it's left to the
+     * operating system (FileSyncer::NO_SYNC). With FileSyncer::SYNC_ON_CLOSE the file is
+     * synced when closed. With FileSyncer::GROUP_COMMIT it's also synced by a separate
+     * thread at the given interval, so that writing never waits on it.
+     * Call before {@link #open}.
+     *
+     * @param policy         policy for forcing data to disk.
+     * @param intervalMillis with GROUP_COMMIT, max milliseconds between syncs, 0 for no limit.
+     * @param intervalBytes  with GROUP_COMMIT, max bytes written between syncs, 0 for no limit.
+     */
+    void FileWriteBackend::setDurability(FileSyncer::Durability policy,
+                                         uint32_t intervalMillis, uint64_t intervalBytes) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        durability = policy;
+        syncIntervalMillis = intervalMillis;
+        syncIntervalBytes = intervalBytes;
+    }
+
+
+    /**
+     * Get the policy for forcing written data to disk.
+     * @return policy for forcing written data to disk.
+     */
+    FileSyncer::Durability FileWriteBackend::getDurability() const {return durability;}
+
+
+    /**
+     * Get the file position up to which all data written is known to be on disk.
+     * Once closed, this is that of the closed file. Always 0 with FileSyncer::NO_SYNC.
+     * @return file position up to which all data written is on disk.
+     */
+    uint64_t FileWriteBackend::getDurableOffset() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        return syncer != nullptr ? syncer->getDurableOffset() : closedDurableOffset;
+    }
+
+
+    /**
+     * Tell the backend which buffers data will be written from, so that it may
+     * register them with the kernel. Call after {@link #open} and before any write.
+     * For direct I/O, the staging buffers are registered instead.
+     * @param buffers buffers data will be written from.
+     */
+    void FileWriteBackend::registerBuffers(std::vector<std::shared_ptr<ByteBuffer>> & buffers) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        registerWithKernel(directIO ? stagingBuffers : buffers);
+    }
+
+
+    /**
+     * Open an existing file for writing. It is not truncated.
+     * For direct I/O, if the file system refuses it, the file is opened normally.
+     *
+     * @param file   name of file.
+     * @param direct if true, bypass the page cache.
+     * @throws EvioException if file already open or cannot be opened.
+     */
+    void FileWriteBackend::open(std::string const & file, bool direct) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        if (fd > -1) {
+            throw EvioException("file " + fileName + " already open");
+        }
+
+        directIO = false;
+
+#if defined(O_DIRECT)
+        if (direct) {
+            // Reading is needed when appending to a partial block
+            fd = ::open(file.c_str(), O_RDWR | O_CLOEXEC | O_DIRECT);
+            if (fd > -1) {
+                directIO = true;
+            }
+            else if (errno == EINVAL) {
+                std::cout << "FileWriteBackend: direct I/O not supported for " << file <<
+                             ", use page cache" << std::endl;
+            }
+        }
+#endif
+
+        if (fd < 0) {
+            fd = ::open(file.c_str(), O_RDWR | O_CLOEXEC);
+        }
+        if (fd < 0) {
+            throw EvioException("error opening file " + file + ": " + std::string(std::strerror(errno)));
+        }
+
+#if defined(__APPLE__) && defined(F_NOCACHE)
+        if (direct && ::fcntl(fd, F_NOCACHE, 1) == 0) {
+            directIO = true;
+        }
+#endif
+
+        fileName = file;
+
+        unsyncedWrites.clear();
+        closedDurableOffset = 0;
+        if (durability != FileSyncer::NO_SYNC) {
+            try {
+                syncer.reset(new FileSyncer(file, durability, syncIntervalMillis, syncIntervalBytes));
+            }
+            catch (EvioException & e) {
+                ::close(fd);
+                fd = -1;
+                throw;
+            }
+        }
+
+        if (directIO) {
+            stagingBuffers.clear();
+            for (uint32_t i=0; i < queueDepth + 1; i++) {
+                stagingBuffers.push_back(std::make_shared<ByteBuffer>(DIRECT_IO_STAGING_BYTES,
+                                                                      DIRECT_IO_ALIGNMENT));
+            }
+            stagingWriteCount.assign(stagingBuffers.size(), 0);
+            stagingIndex = 0;
+            stagingFill = 0;
+            stagingStarted = false;
+        }
+    }
+
+
+    /**
+     * Start staging data for direct I/O at the given file position. Since the staged data
+     * must start on a block boundary, any part of the block already in the file before
+     * this position is read in first. Call while holding writeMutex.
+     *
+     * @param position position in the file of the first write.
+     * @throws EvioException if error reading file.
+     */
+    void FileWriteBackend::startStaging(uint64_t position) {
+        stagingPosition = position - (position % DIRECT_IO_ALIGNMENT);
+        stagingFill = position - stagingPosition;
+        stagingStarted = true;
+
+        if (stagingFill > 0) {
+            uint8_t *dest = stagingBuffers[stagingIndex]->array();
+            std::memset(dest, 0, DIRECT_IO_ALIGNMENT);
+
+            ssize_t n;
+            do {
+                n = ::pread(fd, dest, DIRECT_IO_ALIGNMENT, (off_t)stagingPosition);
+            } while (n < 0 && errno == EINTR);
+
+            if (n < 0) {
+                throw EvioException("error reading file: " + std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+
+    /**
+     * Queue a write of the first len bytes of the staging buffer being filled.
+     * Call while holding writeMutex.
+     * @param len number of bytes, a multiple of DIRECT_IO_ALIGNMENT.
+     * @throws EvioException if the write cannot be queued.
+     */
+    void FileWriteBackend::queueStaged(size_t len) {
+        queueWrite(stagingBuffers[stagingIndex]->array(), len, stagingPosition, nullptr);
+        stagingWriteCount[stagingIndex] = writesQueued;
+        // Padding is not data
+        writeQueued(stagingPosition + std::min(len, stagingFill));
+    }
+
+
+    /**
+     * Copy data into the staging buffers, queueing a write of each buffer once full.
+     * Call while holding writeMutex.
+     *
+     * @param data     pointer to data.
+     * @param len      number of bytes.
+     * @param position position in the file of data, which must follow that staged last.
+     * @throws EvioException if position out of sequence or a write cannot be queued.
+     */
+    void FileWriteBackend::stage(const uint8_t *data, size_t len, uint64_t position) {
+        if (!stagingStarted) {
+            startStaging(position);
+        }
+        else if (position != stagingPosition + stagingFill) {
+            throw EvioException("direct I/O writes must be sequential");
+        }
+
+        while (len > 0) {
+            size_t bytes = DIRECT_IO_STAGING_BYTES - stagingFill;
+            if (bytes > len) bytes = len;
+
+            std::memcpy(stagingBuffers[stagingIndex]->array() + stagingFill, data, bytes);
+            stagingFill += bytes;
+            data += bytes;
+            len  -= bytes;
+
+            if (stagingFill == DIRECT_IO_STAGING_BYTES) {
+                queueStaged(DIRECT_IO_STAGING_BYTES);
+                stagingIndex = (stagingIndex + 1) % stagingBuffers.size();
+                stagingPosition += DIRECT_IO_STAGING_BYTES;
+                stagingFill = 0;
+                // Next buffer cannot be changed while still being written
+                waitForWrites(stagingWriteCount[stagingIndex]);
+            }
+        }
+    }
+
+
+    /**
+     * Write out the partially filled staging buffer, padded with zeros to a whole block,
+     * and wait for it. It stays the buffer being filled, so its last block is written
+     * again later with whatever follows. Call while holding writeMutex.
+     * @throws EvioException if the write failed.
+     */
+    void FileWriteBackend::writePartialStage() {
+        if (stagingFill < 1) return;
+
+        size_t len = (stagingFill + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+        std::memset(stagingBuffers[stagingIndex]->array() + stagingFill, 0, len - stagingFill);
+        queueStaged(len);
+        waitForWrites(writesQueued);
+    }
+
+
+    /**
+     * Write data to the file at the given position. Depending on the implementation,
+     * this may return before the data is written. For direct I/O, data is copied
+     * and the ring item released before returning.
+     *
+     * @param data      pointer to data, which must not change until the write completes.
+     * @param len       number of bytes to write.
+     * @param position  position in the file at which to write.
+     * @param item      ring item containing the data, released back into the supply
+     *                  once written. May be null.
+     * @throws EvioException if file not open, or an earlier write failed.
+     */
+    void FileWriteBackend::write(const uint8_t *data, size_t len, uint64_t position,
+                                 std::shared_ptr<RecordRingItem> const & item) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        if (fd < 0) {
+            throw EvioException("file not open");
+        }
+        throwIfError();
+
+        if (directIO) {
+            stage(data, len, position);
+            if (supply != nullptr && item != nullptr) {
+                auto copied = item;
+                supply->releaseWriter(copied);
+            }
+            return;
+        }
+
+        queueWrite(data, len, position, item);
+        writeQueued(position + len);
+    }
+
+
+    /**
+     * Write data gathered from several buffers, one after another, without first copying
+     * them together. Used for records built by gathering their parts (see
+     * {@link RecordOutput#setGatherOutput(bool)}). Blocks if there are already
+     * queueDepth writes in flight. The memory of every segment must remain untouched
+     * until the write is done, as with {@link #write(const uint8_t *, size_t, uint64_t,
+     * std::shared_ptr<RecordRingItem> const &)}.
+     *
+     * @param segments  data to write, in order.
+     * @param position  position in the file at which to write the first segment.
+     * @param item      ring item containing the data, released back to its supply once written.
+     *                  May be null.
+     * @throws EvioException if file not open, a previous write failed,
+     *                       or a write to a direct I/O file is not sequential.
+     */
+    void FileWriteBackend::write(const std::vector<ByteBufferView> & segments, uint64_t position,
+                                 std::shared_ptr<RecordRingItem> const & item) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        if (fd < 0) {
+            throw EvioException("file not open");
+        }
+        throwIfError();
+
+        if (directIO) {
+            for (auto & seg : segments) {
+                stage(seg.data(), seg.size(), position);
+                position += seg.size();
+            }
+            if (supply != nullptr && item != nullptr) {
+                auto copied = item;
+                supply->releaseWriter(copied);
+            }
+            return;
+        }
+
+        queueGatherWrite(segments, position, item);
+
+        for (auto & seg : segments) {
+            position += seg.size();
+        }
+        writeQueued(position);
+    }
+
+
+    /**
+     * Reserve disk space for the open file without changing its size, so that as records
+     * are appended it is not spread over many small extents. This cuts fragmentation and
+     * metadata updates on file systems like XFS and Lustre. Reserved but unused space
+     * must be given back by truncating the file (see
+     * {@link #truncateFile(std::string const &, uint64_t)}) once it's closed.
+     * Only done on Linux, and only if the file system supports it.
+     *
+     * @param bytes number of bytes, from the start of the file, to reserve.
+     * @return true if space was reserved.
+     * @throws EvioException if file not open.
+     */
+    bool FileWriteBackend::preallocate(uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (fd < 0) {
+            throw EvioException("file not open");
+        }
+        return reserveSpace(fd, bytes);
+    }
+
+
+    /**
+     * Queue a write of data gathered from several buffers. By default, each segment is
+     * queued as a separate write with the ring item given to the last one. Since writes
+     * complete in the order queued, the item is released only once all of them are done.
+     * Called while holding writeMutex.
+     *
+     * @param segments  data to write, in order.
+     * @param position  position in the file at which to write the first segment.
+     * @param item      ring item containing the data, may be null.
+     * @throws EvioException if a write cannot be queued.
+     */
+    void FileWriteBackend::queueGatherWrite(const std::vector<ByteBufferView> & segments, uint64_t position,
+                                            std::shared_ptr<RecordRingItem> const & item) {
+        static const std::shared_ptr<RecordRingItem> noItem;
+
+        for (size_t i=0; i < segments.size(); i++) {
+            bool last = (i == segments.size() - 1);
+            queueWrite(segments[i].data(), segments[i].size(), position, last ? item : noItem);
+            position += segments[i].size();
+        }
+    }
+
+
+    /**
+     * Wait for all queued writes to complete. For direct I/O, data still being staged
+     * is not written.
+     * @throws EvioException if a write failed.
+     */
+    void FileWriteBackend::waitForAll() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        waitForWrites(writesQueued);
+        throwIfError();
+    }
+
+
+    /**
+     * Write everything, wait for all writes to complete, then force the data physically
+     * to disk. Metadata is not forced since that slows it down even more.
+     * @throws EvioException if a write failed or if error forcing data to disk.
+     */
+    void FileWriteBackend::sync() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        if (directIO && fd > -1) {
+            writePartialStage();
+        }
+        waitForWrites(writesQueued);
+        throwIfError();
+
+#ifdef __APPLE__
+        if (fd > -1 && ::fsync(fd) < 0) {
+#else
+        if (fd > -1 && ::fdatasync(fd) < 0) {
+#endif
+            throw EvioException("error syncing file: " + std::string(std::strerror(errno)));
+        }
+    }
+
+
+    /**
+     * Write everything, wait for all writes to complete, then close the file.
+     * For direct I/O, the padding of the last block is then cut off the file.
+     * Does nothing if already closed.
+     * @throws EvioException if a write failed.
+     */
+    void FileWriteBackend::close() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        std::string err;
+
+        try {
+            if (directIO && fd > -1) {
+                writePartialStage();
+            }
+            waitForWrites(writesQueued);
+            throwIfError();
+
+            if (directIO && stagingStarted && fd > -1 &&
+                ::ftruncate(fd, (off_t)(stagingPosition + stagingFill)) < 0) {
+                throw EvioException("error truncating file: " + std::string(std::strerror(errno)));
+            }
+        }
+        catch (EvioException & e) {
+            err = e.what();
+        }
+
+        if (syncer != nullptr) {
+            // Report writes only now found complete, then sync everything
+            reportWritten();
+            try {
+                syncer->finish();
+            }
+            catch (EvioException & e) {
+                if (err.empty()) err = e.what();
+            }
+            closedDurableOffset = syncer->getDurableOffset();
+            syncer.reset();
+            unsyncedWrites.clear();
+        }
+
+        if (fd > -1) {
+            ::close(fd);
+            fd = -1;
+        }
+        stagingBuffers.clear();
+        shutdown();
+
+        if (!err.empty()) {
+            throw EvioException(err);
+        }
+    }
+
+}
@@ -0,0 +1,231 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#ifndef EVIO_6_0_FILEWRITEBACKEND_H
+#define EVIO_6_0_FILEWRITEBACKEND_H
+
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "RecordRingItem.h"
+#include "RecordSupply.h"
+#include "FileSyncer.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This abstract class is the interface through which {@link EventWriter} writes records
+     * to a file. Each write is given an explicit file position so that several of them may
+     * be in flight at once. Implementations differ in how those writes are carried out.<p>
+     *
+     * When writing records taken from a {@link RecordSupply}, the ring item of each write is
+     * released back to the supply, in the order written, once its data are in the file.
+     * A ring item's buffer must not be reused until then.<p>
+     *
+     * If opened for direct I/O, the page cache is bypassed (O_DIRECT). That requires
+     * writes of whole, aligned blocks from aligned memory, which evio records are not.
+     * So writes, which must then be sequential, are copied into aligned staging buffers
+     * and each full buffer is written. Ring items are released as soon as they're copied.
+     * The last, partial block is written padded and the file truncated to its real
+     * length when closed.<p>
+     *
+     * A durability policy (see {@link FileSyncer}) may be set, which then forces written
+     * data to disk, periodically or on closing, and reports how much of it is there.<p>
+     *
+     * One object is used for each file. It writes through its own file descriptor
+     * to a file which must already exist.
+     */
+    class FileWriteBackend {
+
+    public:
+
+        /** Kinds of backends available through {@link #create(Type, uint32_t)}. */
+        enum Type {
+            /** Each write done with pwrite in a std::async thread, portable and the default. */
+            ASYNC = 0,
+            /** Writes submitted to the Linux kernel through io_uring, falls back to ASYNC. */
+            IO_URING = 1
+        };
+
+        /** Alignment, in bytes, of file positions, lengths and memory for direct I/O. */
+        static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+        /** Size, in bytes, of each staging buffer for direct I/O. */
+        static constexpr size_t DIRECT_IO_STAGING_BYTES = 4*1024*1024;
+
+    protected:
+
+        /** Mutex for thread safety, since files are closed in a separate thread when splitting. */
+        std::mutex writeMutex;
+
+        /** Name of file being written. */
+        std::string fileName;
+
+        /** File descriptor of file being written. */
+        int fd = -1;
+
+        /** Max number of writes in flight at once. */
+        uint32_t queueDepth = 1;
+
+        /** If writing ring items, the supply they're released back into. */
+        std::shared_ptr<RecordSupply> supply = nullptr;
+
+        /** Number of writes queued by the implementation. */
+        uint64_t writesQueued = 0;
+
+        /** Number of writes completed, always in the order queued. */
+        uint64_t writesCompleted = 0;
+
+        /** First error reported by completed writes. */
+        std::string error {""};
+
+        /** Has an error occurred in completed writes? */
+        bool haveError = false;
+
+        // Direct I/O
+
+        /** Is file opened for direct I/O? */
+        bool directIO = false;
+        /** Aligned buffers in which to coalesce data for direct I/O. */
+        std::vector<std::shared_ptr<ByteBuffer>> stagingBuffers;
+        /** For each staging buffer, the value of writesQueued after it was last queued. */
+        std::vector<uint64_t> stagingWriteCount;
+        /** Index of staging buffer being filled. */
+        uint32_t stagingIndex = 0;
+        /** Number of bytes in staging buffer being filled. */
+        size_t stagingFill = 0;
+        /** File position of the start of staging buffer being filled. */
+        uint64_t stagingPosition = 0;
+        /** Has a write been staged yet? */
+        bool stagingStarted = false;
+
+        // Durability
+
+        /** Policy for forcing data to disk. */
+        FileSyncer::Durability durability = FileSyncer::NO_SYNC;
+        /** With GROUP_COMMIT, max milliseconds between syncs. */
+        uint32_t syncIntervalMillis = FileSyncer::DEFAULT_INTERVAL_MILLIS;
+        /** With GROUP_COMMIT, max bytes written between syncs. */
+        uint64_t syncIntervalBytes = FileSyncer::DEFAULT_INTERVAL_BYTES;
+        /** Syncs the open file, null with NO_SYNC. */
+        std::unique_ptr<FileSyncer> syncer;
+        /** Count of writes queued, with the file position they write up to,
+         *  not yet reported to syncer. */
+        std::deque<std::pair<uint64_t, uint64_t>> unsyncedWrites;
+        /** Durable offset of file last closed. */
+        uint64_t closedDurableOffset = 0;
+
+
+        explicit FileWriteBackend(uint32_t queueDepth);
+
+        static void writeFully(int fd, const uint8_t *data, size_t len, uint64_t position);
+        static void writeFully(int fd, std::vector<ByteBufferView> segments, uint64_t position);
+
+        void writeDone(std::shared_ptr<RecordRingItem> & item);
+        void writeQueued(uint64_t end);
+        void reportWritten();
+        void setError(std::string const & err);
+        void throwIfError();
+
+        /**
+         * Queue a write, blocking first if there are already queueDepth writes in flight.
+         * Implementations increment writesQueued once the write is queued and, when it
+         * completes, call {@link #writeDone} for it. Called while holding writeMutex.
+         *
+         * @param data      pointer to data.
+         * @param len       number of bytes to write.
+         * @param position  position in the file at which to write.
+         * @param item      ring item containing the data, may be null.
+         * @throws EvioException if the write cannot be queued.
+         */
+        virtual void queueWrite(const uint8_t *data, size_t len, uint64_t position,
+                                std::shared_ptr<RecordRingItem> const & item) = 0;
+
+        virtual void queueGatherWrite(const std::vector<ByteBufferView> & segments, uint64_t position,
+                                      std::shared_ptr<RecordRingItem> const & item);
+
+        /**
+         * Block until at least count writes have completed, or none are in flight.
+         * Called while holding writeMutex.
+         * @param count number of completed writes to wait for.
+         * @throws EvioException if the writes cannot be waited on.
+         */
+        virtual void waitForWrites(uint64_t count) = 0;
+
+        /**
+         * Register buffers with the kernel, if the implementation can make use of it.
+         * Called while holding writeMutex, before any write.
+         * @param buffers buffers, which are kept alive by this object, to register.
+         */
+        virtual void registerWithKernel(std::vector<std::shared_ptr<ByteBuffer>> & /*buffers*/) {}
+
+        /** Release any resources once the file is closed. Called while holding writeMutex. */
+        virtual void shutdown() {}
+
+    private:
+
+        void startStaging(uint64_t position);
+        void stage(const uint8_t *data, size_t len, uint64_t position);
+        void queueStaged(size_t len);
+        void writePartialStage();
+
+    public:
+
+        static std::shared_ptr<FileWriteBackend> create(Type type, uint32_t queueDepth);
+        static bool createFile(std::string const & file, uint64_t preallocateBytes, bool overwrite);
+        static void truncateFile(std::string const & file, uint64_t length);
+
+        FileWriteBackend(const FileWriteBackend & backend) = delete;
+        FileWriteBackend & operator=(const FileWriteBackend & other) = delete;
+        virtual ~FileWriteBackend();
+
+        virtual Type getType() const = 0;
+
+        uint32_t getQueueDepth() const;
+        std::string getFileName() const;
+        bool isOpen() const;
+        bool isDirect() const;
+
+        void setSupply(std::shared_ptr<RecordSupply> & recordSupply);
+        void setDurability(FileSyncer::Durability policy,
+                           uint32_t intervalMillis = FileSyncer::DEFAULT_INTERVAL_MILLIS,
+                           uint64_t intervalBytes  = FileSyncer::DEFAULT_INTERVAL_BYTES);
+        FileSyncer::Durability getDurability() const;
+        uint64_t getDurableOffset();
+        void registerBuffers(std::vector<std::shared_ptr<ByteBuffer>> & buffers);
+
+        void open(std::string const & file, bool direct = false);
+        bool preallocate(uint64_t bytes);
+
+        void write(const uint8_t *data, size_t len, uint64_t position,
+                   std::shared_ptr<RecordRingItem> const & item);
+        void write(const std::vector<ByteBufferView> & segments, uint64_t position,
+                   std::shared_ptr<RecordRingItem> const & item);
+        void waitForAll();
+        void sync();
+        void close();
+    };
+
+}
+
+
+#endif //EVIO_6_0_FILEWRITEBACKEND_H
@@ -0,0 +1,203 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "GatheredEvent.h"
+
+
+#include <cstring>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param tag  tag of event.
+     * @param num  num of event.
+     * @param type type of event's data, BANK or ALSOBANK.
+     * @throws EvioException if type is not a bank.
+     */
+    GatheredEvent::GatheredEvent(uint16_t tag, uint8_t num, DataType const & type) :
+            tag(tag), num(num), dataType(type.getValue()) {
+
+        if (!DataType::isBank(dataType)) {
+            throw EvioException("event must contain banks, not " + type.toString());
+        }
+    }
+
+
+    /**
+     * Set the tag and num of the event.
+     * @param t tag of event.
+     * @param n num of event.
+     */
+    void GatheredEvent::setHeader(uint16_t t, uint8_t n) {
+        tag = t;
+        num = n;
+    }
+
+
+    /**
+     * Make room for the given number of fragments so adding them allocates no memory.
+     * @param count number of fragments.
+     */
+    void GatheredEvent::reserve(size_t count) {fragments.reserve(count);}
+
+
+    /** Remove all fragments, keeping the memory used to list them, so this object can be reused. */
+    void GatheredEvent::clear() {
+        fragments.clear();
+        fragmentBytes = 0;
+    }
+
+
+    /**
+     * Add a reference to a fragment, to be copied as is.
+     * @param data   fragment's bytes, an evio bank.
+     * @param length number of bytes in fragment.
+     * @param order  byte order of fragment.
+     * @throws EvioException if length does not match the fragment's header, or event too big.
+     */
+    void GatheredEvent::addFragment(const uint8_t *data, uint32_t length, ByteOrder const & order) {
+        add(data, length, order, false, 0, 0);
+    }
+
+
+    /**
+     * Add a reference to a fragment whose tag and num are replaced when it's copied.
+     * The fragment itself is not changed.
+     * @param data   fragment's bytes, an evio bank.
+     * @param length number of bytes in fragment.
+     * @param order  byte order of fragment.
+     * @param newTag tag the copied fragment has.
+     * @param newNum num the copied fragment has.
+     * @throws EvioException if length does not match the fragment's header, or event too big.
+     */
+    void GatheredEvent::addFragment(const uint8_t *data, uint32_t length, ByteOrder const & order,
+                                    uint16_t newTag, uint8_t newNum) {
+        add(data, length, order, true, newTag, newNum);
+    }
+
+
+    /**
+     * Add a reference to a fragment, to be copied as is.
+     * The fragment is the buffer's data from its position to its limit.
+     * @param buffer buffer holding fragment, an evio bank.
+     * @throws EvioException if length does not match the fragment's header, or event too big.
+     */
+    void GatheredEvent::addFragment(ByteBuffer const & buffer) {
+        add(buffer.array() + buffer.arrayOffset() + buffer.position(),
+            buffer.remaining(), buffer.order(), false, 0, 0);
+    }
+
+
+    /**
+     * Add a reference to a fragment whose tag and num are replaced when it's copied.
+     * The fragment is the buffer's data from its position to its limit.
+     * @param buffer buffer holding fragment, an evio bank.
+     * @param newTag tag the copied fragment has.
+     * @param newNum num the copied fragment has.
+     * @throws EvioException if length does not match the fragment's header, or event too big.
+     */
+    void GatheredEvent::addFragment(ByteBuffer const & buffer, uint16_t newTag, uint8_t newNum) {
+        add(buffer.array() + buffer.arrayOffset() + buffer.position(),
+            buffer.remaining(), buffer.order(), true, newTag, newNum);
+    }
+
+
+    /**
+     * Add a reference to the fragment represented by a node, to be copied as is.
+     * The node's backing buffer is neither copied nor changed.
+     * @param node node of fragment, which must be a bank.
+     * @throws EvioException if node is not a bank, or event too big.
+     */
+    void GatheredEvent::addFragment(EvioNode & node) {
+        if (!node.getTypeObj().isBank()) {
+            throw EvioException("node does not represent a bank (" + node.getTypeObj().toString() + ")");
+        }
+        auto buf = node.getBuffer();
+        add(buf->array() + buf->arrayOffset() + node.getPosition(),
+            node.getTotalBytes(), buf->order(), false, 0, 0);
+    }
+
+
+    /**
+     * Add a reference to the fragment represented by a node, whose tag and num are
+     * replaced when it's copied. The node's backing buffer is neither copied nor changed.
+     * @param node   node of fragment, which must be a bank.
+     * @param newTag tag the copied fragment has.
+     * @param newNum num the copied fragment has.
+     * @throws EvioException if node is not a bank, or event too big.
+     */
+    void GatheredEvent::addFragment(EvioNode & node, uint16_t newTag, uint8_t newNum) {
+        if (!node.getTypeObj().isBank()) {
+            throw EvioException("node does not represent a bank (" + node.getTypeObj().toString() + ")");
+        }
+        auto buf = node.getBuffer();
+        add(buf->array() + buf->arrayOffset() + node.getPosition(),
+            node.getTotalBytes(), buf->order(), true, newTag, newNum);
+    }
+
+
+    /**
+     * Add a reference to a fragment after checking its length.
+     * @param data   fragment's bytes.
+     * @param length number of bytes in fragment.
+     * @param order  byte order of fragment.
+     * @param retag  replace fragment's tag and num when copied?
+     * @param newTag new tag if retagging.
+     * @param newNum new num if retagging.
+     * @throws EvioException if length does not match the fragment's header, or event too big.
+     */
+    void GatheredEvent::add(const uint8_t *data, uint32_t length, ByteOrder const & order,
+                            bool retag, uint16_t newTag, uint8_t newNum) {
+
+        if (data == nullptr || length < 8 || (length & 3) != 0) {
+            throw EvioException("bad fragment format");
+        }
+
+        uint32_t words;
+        std::memcpy(&words, data, 4);
+        if (!order.isLocalEndian()) {
+            words = SWAP_32(words);
+        }
+
+        if ((uint64_t)length != 4 * ((uint64_t)words + 1)) {
+            throw EvioException("inconsistent fragment lengths: total bytes from fragment = " +
+                                std::to_string(4 * ((uint64_t)words + 1)) +
+                                ", given = " + std::to_string(length));
+        }
+
+        if ((uint64_t)fragmentBytes + length + 8 > UINT32_MAX) {
+            throw EvioException("event too big");
+        }
+
+        fragments.push_back({data, length, order.isBigEndian(), retag, newTag, newNum});
+        fragmentBytes += length;
+    }
+
+
+    /**
+     * Write the event's bank header, 2 words, into memory.
+     * @param dst   where to write header.
+     * @param order byte order to write in.
+     */
+    void GatheredEvent::writeHeader(uint8_t *dst, ByteOrder const & order) const {
+        uint32_t header[2];
+        header[0] = getTotalBytes()/4 - 1;
+        header[1] = ((uint32_t)tag << 16) | ((dataType & 0x3f) << 8) | num;
+        if (!order.isLocalEndian()) {
+            header[0] = SWAP_32(header[0]);
+            header[1] = SWAP_32(header[1]);
+        }
+        std::memcpy(dst, header, 8);
+    }
+
+}
@@ -0,0 +1,118 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_GATHEREDEVENT_H
+#define EVIO_6_0_GATHEREDEVENT_H
+
+
+#include <cstdint>
+#include <vector>
+
+
+#include "ByteOrder.h"
+#include "ByteBuffer.h"
+#include "DataType.h"
+#include "EvioNode.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class describes an event, a bank of banks, built from fragments which are left
+     * wherever they are, such as in the network buffers they arrived in. It holds only the
+     * event's tag, num and type along with an ordered list of references to its fragments,
+     * each a bank. When added to a {@link RecordOutput}, through
+     * {@link EventWriter#writeEvent(GatheredEvent const &, bool)} for example, the event's
+     * header is written and each fragment copied straight into the record, once.
+     * A fragment in the opposite byte order of the record is swapped in that same copy,
+     * and its tag and num may be changed at the same time.<p>
+     *
+     * The fragments' memory must not change or go away until the event is added.
+     * An object may be reused for the next event after calling {@link #clear()},
+     * which keeps its memory. This class is not thread-safe.
+     */
+    class GatheredEvent {
+
+    public:
+
+        /** Reference to one fragment of the event. */
+        struct Fragment {
+            /** Fragment's bytes. */
+            const uint8_t *data;
+            /** Number of bytes in fragment. */
+            uint32_t length;
+            /** Is the fragment big endian? */
+            bool bigEndian;
+            /** Replace the fragment's tag and num when copied? */
+            bool retag;
+            /** New tag if retagging. */
+            uint16_t tag;
+            /** New num if retagging. */
+            uint8_t num;
+        };
+
+    private:
+
+        /** Tag of event. */
+        uint16_t tag;
+
+        /** Num of event. */
+        uint8_t num;
+
+        /** Type of event's data, BANK or ALSOBANK. */
+        uint32_t dataType;
+
+        /** Fragments in the order they appear in event. */
+        std::vector<Fragment> fragments;
+
+        /** Bytes of all fragments. */
+        uint32_t fragmentBytes = 0;
+
+    public:
+
+        explicit GatheredEvent(uint16_t tag, uint8_t num = 0, DataType const & type = DataType::BANK);
+
+        void setHeader(uint16_t tag, uint8_t num);
+        void reserve(size_t count);
+        void clear();
+
+        void addFragment(const uint8_t *data, uint32_t length, ByteOrder const & order);
+        void addFragment(const uint8_t *data, uint32_t length, ByteOrder const & order,
+                         uint16_t newTag, uint8_t newNum);
+        void addFragment(ByteBuffer const & buffer);
+        void addFragment(ByteBuffer const & buffer, uint16_t newTag, uint8_t newNum);
+        void addFragment(EvioNode & node);
+        void addFragment(EvioNode & node, uint16_t newTag, uint8_t newNum);
+
+        /** @return tag of event. */
+        uint16_t getTag()                             const {return tag;}
+        /** @return num of event. */
+        uint8_t getNum()                              const {return num;}
+        /** @return event's fragments in order. */
+        std::vector<Fragment> const & getFragments()  const {return fragments;}
+        /** @return number of fragments. */
+        size_t getFragmentCount()                     const {return fragments.size();}
+        /** @return bytes of whole event, header included. */
+        uint32_t getTotalBytes()                      const {return 8 + fragmentBytes;}
+
+        void writeHeader(uint8_t *dst, ByteOrder const & order) const;
+
+    private:
+
+        void add(const uint8_t *data, uint32_t length, ByteOrder const & order,
+                 bool retag, uint16_t newTag, uint8_t newNum);
+    };
+
+}
+
+
+#endif //EVIO_6_0_GATHEREDEVENT_H
@@ -43,6 +43,9 @@ namespace evio {
     /** Header for an hipo trailer record. */
     const HeaderType HeaderType::HIPO_TRAILER = HeaderType(7, "HIPO_TRAILER");
 
+    /** Header for an evio record whose data is grouped by column, see {@link ColumnLayout}. */
+    const HeaderType HeaderType::EVIO_COLUMN_RECORD = HeaderType(8, "EVIO_COLUMN_RECORD");
+
     /** Unknown header. */
     const HeaderType HeaderType::UNKNOWN = HeaderType(15, "UNKNOWN");
 
@@ -57,8 +60,9 @@ namespace evio {
              "HIPO_FILE",
              "HIPO_FILE_EXTENDED",
              "HIPO_TRAILER",
+             "EVIO_COLUMN_RECORD",
                     // Line of unused elements, just fill with unknown
-             "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN",
+             "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN", "UNKNOWN",
              "UNKNOWN"};
 
     HeaderType HeaderType::intToType[16] =
@@ -70,9 +74,10 @@ namespace evio {
              HeaderType::HIPO_FILE,
              HeaderType::HIPO_FILE_EXTENDED,
              HeaderType::HIPO_TRAILER,
+             HeaderType::EVIO_COLUMN_RECORD,
                     // 2 Lines of unused elements, just fill with unknown
              HeaderType::UNKNOWN, HeaderType::UNKNOWN, HeaderType::UNKNOWN, HeaderType::UNKNOWN,
-             HeaderType::UNKNOWN, HeaderType::UNKNOWN, HeaderType::UNKNOWN,
+             HeaderType::UNKNOWN, HeaderType::UNKNOWN,
              HeaderType::UNKNOWN};
 
 }
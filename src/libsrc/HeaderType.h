@@ -41,6 +41,7 @@ namespace evio {
         static const HeaderType HIPO_FILE;
         static const HeaderType HIPO_FILE_EXTENDED;
         static const HeaderType HIPO_TRAILER;
+        static const HeaderType EVIO_COLUMN_RECORD;
         static const HeaderType UNKNOWN;
 
     private:
@@ -105,13 +106,19 @@ namespace evio {
          */
         bool isTrailer() const {return (*this == EVIO_TRAILER || *this == HIPO_TRAILER);}
 
+        /**
+         * Is this an evio record, whatever the layout of its data?
+         * @return <code>true</code> if is an evio record, else <code>false</code>
+         */
+        bool isEvioRecord() const {return (*this == EVIO_RECORD || *this == EVIO_COLUMN_RECORD);}
+
         /**
          * Get the object from the integer value.
          * @param val the value to match.
          * @return the matching enum, or <code>null</code>.
          */
         static const HeaderType & getHeaderType(uint32_t val) {
-            if (val > 7) return UNKNOWN;
+            if (val > 8) return UNKNOWN;
             return intToType[val];
         }
 
@@ -121,7 +128,7 @@ namespace evio {
          * @return the name, or <code>null</code>.
          */
         static std::string getName(uint32_t val) {
-            if (val > 7) return "UNKNOWN";
+            if (val > 8) return "UNKNOWN";
             return getHeaderType(val).names[val];
         }
 
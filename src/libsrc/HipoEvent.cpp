@@ -0,0 +1,83 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "HipoEvent.h"
+
+#include <algorithm>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param view view of the event's bytes, header included.
+     */
+    HipoEvent::HipoEvent(ByteBufferView const & view) : event(view) {
+        if (view.size() >= HEADER_BYTES) {
+            // Event's size, header included, follows its signature
+            eventSize = std::min((size_t)view.getInt(4), view.size());
+        }
+    }
+
+
+    /** @return event's tag, or 0 if it has no header. */
+    uint32_t HipoEvent::getTag() const {
+        return (eventSize >= HEADER_BYTES) ? event.getInt(8) : 0;
+    }
+
+
+    /**
+     * Find the data of the first structure of the given group and item.
+     * @param group group of structure.
+     * @param item  item of structure.
+     * @return view of structure's data, not including its header, empty if not found.
+     */
+    ByteBufferView HipoEvent::getStructure(uint16_t group, uint8_t item) const {
+        size_t position = HEADER_BYTES;
+        while (position + STRUCTURE_HEADER_BYTES <= eventSize) {
+            uint16_t gr = event.getShort(position);
+            uint8_t  it = event.getByte(position + 2);
+            size_t length = event.getInt(position + 4) & 0x00ffffff;
+
+            size_t dataPos = position + STRUCTURE_HEADER_BYTES;
+            if (dataPos + length > eventSize) {
+                break;
+            }
+            if (gr == group && it == item) {
+                return event.subView(dataPos, length);
+            }
+            position = dataPos + length;
+        }
+        return ByteBufferView();
+    }
+
+
+    /**
+     * Is there a structure of the given group and item?
+     * @param group group of structure.
+     * @param item  item of structure.
+     * @return true if found.
+     */
+    bool HipoEvent::hasStructure(uint16_t group, uint8_t item) const {
+        return !getStructure(group, item).empty();
+    }
+
+
+    /**
+     * Get the bank described by a schema.
+     * @param schema schema of bank.
+     * @return bank, with no rows if not found.
+     */
+    HipoBank HipoEvent::getBank(HipoSchema const & schema) const {
+        return HipoBank(schema, getStructure(schema.getGroup(), schema.getItem()));
+    }
+
+}
@@ -0,0 +1,189 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_HIPOEVENT_H
+#define EVIO_6_0_HIPOEVENT_H
+
+
+#include <cstdint>
+#include <string>
+
+
+#include "ByteBufferView.h"
+#include "HipoSchema.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a view of one HIPO bank: a structure whose data is a table
+     * described by a {@link HipoSchema}. Nothing is copied. Each column is returned as
+     * a {@link StridedView} straight into the event's memory, so it's valid only as long as
+     * the event is. Since columns are stored one after another, each view's values are packed.
+     *
+     * <pre><code>
+     *    HipoBank particles = event.getBank(dictionary.getSchema("REC::Particle"));
+     *    auto pid = particles.getColumn&lt;int32_t&gt;("pid");
+     *    auto px  = particles.getColumn&lt;float&gt;("px");
+     *    for (size_t row=0; row &lt; particles.getRows(); row++) {
+     *        if (pid[row] == 11) sum += px[row];
+     *    }
+     * </code></pre>
+     */
+    class HipoBank {
+
+    private:
+
+        /** Schema of bank, null if none. */
+        HipoSchema const *schema = nullptr;
+
+        /** Bank's data. */
+        ByteBufferView data;
+
+        /** Number of rows. */
+        size_t rows = 0;
+
+    public:
+
+        /** Default constructor of an empty bank. */
+        HipoBank() = default;
+
+        /**
+         * Constructor.
+         * @param bankSchema schema of bank.
+         * @param bankData   bank's data, not including its structure header.
+         */
+        HipoBank(HipoSchema const & bankSchema, ByteBufferView const & bankData) :
+                schema(&bankSchema), data(bankData),
+                rows(bankSchema.getRowLength() > 0 ? bankData.size() / bankSchema.getRowLength() : 0) {}
+
+        /** @return number of rows, 0 if bank was not in event. */
+        size_t getRows()                 const {return rows;}
+        /** @return true if bank has no rows. */
+        bool empty()                     const {return rows == 0;}
+        /** @return schema of bank, null if default constructed. */
+        HipoSchema const * getSchema()   const {return schema;}
+        /** @return view of bank's data. */
+        ByteBufferView const & getData() const {return data;}
+
+
+        /**
+         * Get a view of one column's values.
+         * @tparam T type of value, whose size must equal that of the column's type.
+         * @param column index of column.
+         * @return view of column's values, one per row.
+         * @throws EvioException if column index is out of bounds or type has the wrong size.
+         */
+        template<typename T> StridedView<T> getColumn(size_t column) const {
+            if (schema == nullptr) {
+                return StridedView<T>();
+            }
+            if (column >= schema->getColumnCount()) {
+                throw EvioException("hipo column index out of bounds");
+            }
+            auto const & col = schema->getColumn(column);
+            if (col.size != sizeof(T)) {
+                throw EvioException("hipo column " + col.name + " is not " +
+                                    std::to_string(sizeof(T)) + " bytes");
+            }
+            return StridedView<T>(data.data() + rows*col.offset, rows, sizeof(T), data.order());
+        }
+
+
+        /**
+         * Get a view of one column's values.
+         * @tparam T type of value, whose size must equal that of the column's type.
+         * @param name name of column.
+         * @return view of column's values, one per row.
+         * @throws EvioException if there is no column of that name or type has the wrong size.
+         */
+        template<typename T> StridedView<T> getColumn(std::string const & name) const {
+            if (schema == nullptr) {
+                return StridedView<T>();
+            }
+            int column = schema->getColumnIndex(name);
+            if (column < 0) {
+                throw EvioException("no hipo column " + name + " in " + schema->getName());
+            }
+            return getColumn<T>(column);
+        }
+
+
+        /**
+         * Get one value as a double, whatever the column's type.
+         * @param column index of column, unchecked.
+         * @param row    index of row, unchecked.
+         * @return value.
+         */
+        double getValue(size_t column, size_t row) const {
+            auto const & col = schema->getColumn(column);
+            const uint8_t *p = data.data() + rows*col.offset;
+            ByteOrder const & order = data.order();
+            switch (col.type) {
+                case 'B': return (int8_t) StridedView<uint8_t>(p, rows, 1, order)[row];
+                case 'S': return (int16_t)StridedView<uint16_t>(p, rows, 2, order)[row];
+                case 'I': return (int32_t)StridedView<uint32_t>(p, rows, 4, order)[row];
+                case 'F': return StridedView<float>(p, rows, 4, order)[row];
+                case 'D': return StridedView<double>(p, rows, 8, order)[row];
+                default:  return (double)(int64_t)StridedView<uint64_t>(p, rows, 8, order)[row];
+            }
+        }
+    };
+
+
+    /**
+     * This class is a view of one HIPO event. It finds the structures it contains,
+     * each with a 2 byte group, 1 byte item, 1 byte type and 4 byte length (data size
+     * in the lower 24 bits), after the 16 byte event header. Nothing is copied, so it's
+     * valid only as long as the memory viewed, for example until a {@link Reader} reads
+     * another record.
+     */
+    class HipoEvent {
+
+    public:
+
+        /** Bytes in an event's header. */
+        static const uint32_t HEADER_BYTES = 16;
+        /** Bytes in a structure's header. */
+        static const uint32_t STRUCTURE_HEADER_BYTES = 8;
+
+    private:
+
+        /** Event's bytes. */
+        ByteBufferView event;
+
+        /** Bytes of event in use, not more than the view. */
+        size_t eventSize = 0;
+
+    public:
+
+        /** Default constructor of an empty event. */
+        HipoEvent() = default;
+        explicit HipoEvent(ByteBufferView const & view);
+
+        /** @return view of whole event. */
+        ByteBufferView const & getView() const {return event;}
+        /** @return true if there are no structures. */
+        bool empty()                     const {return eventSize <= HEADER_BYTES;}
+        /** @return size of event in bytes. */
+        size_t getSize()                 const {return eventSize;}
+
+        uint32_t getTag() const;
+        ByteBufferView getStructure(uint16_t group, uint8_t item) const;
+        HipoBank getBank(HipoSchema const & schema) const;
+        bool hasStructure(uint16_t group, uint8_t item) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_HIPOEVENT_H
@@ -0,0 +1,89 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "HipoReader.h"
+
+#include "RecordInput.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which opens a HIPO file and reads its schema dictionary.
+     * @param fileName name of file.
+     * @throws EvioException if file cannot be read or is not in hipo format;
+     *                       if the user header's schemas are not in the proper format.
+     */
+    HipoReader::HipoReader(std::string const & fileName) : fileName(fileName), reader(fileName) {
+        auto userHeader = reader.readUserHeader();
+        dictionary = HipoDictionary::fromUserHeader(*userHeader);
+    }
+
+
+    /** Close the file. */
+    void HipoReader::close() {reader.close();}
+
+
+    /** @return number of events in file. */
+    uint32_t HipoReader::getEventCount() const {return reader.getEventCount();}
+
+
+    /**
+     * Get an event, valid until an event in another record is asked for.
+     * @param index index of event in file, starting at 0.
+     * @return event, empty if index is out of bounds.
+     * @throws EvioException if file not in hipo format.
+     */
+    HipoEvent HipoReader::getEvent(uint32_t index) {
+        return HipoEvent(reader.getEventView(index));
+    }
+
+
+    /**
+     * Get the next event while reading sequentially, valid until another record is read.
+     * @param event set to the next event.
+     * @return false if there are no more events.
+     * @throws EvioException if file not in hipo format.
+     */
+    bool HipoReader::nextEvent(HipoEvent & event) {
+        ByteBufferView view = reader.getNextEventView();
+        if (view.empty()) {
+            return false;
+        }
+        event = HipoEvent(view);
+        return true;
+    }
+
+
+    /**
+     * Pass every event of the file to a handler, in parallel, in no particular order.
+     * Each worker thread reads and uncompresses whole records with its own file stream.
+     *
+     * @param threads number of worker threads, 0 for one per cpu core.
+     * @param handler called, in a worker thread, with each event.
+     *                The event is valid only during the call.
+     * @return number of events handled.
+     * @throws EvioException if file cannot be read.
+     *         Rethrows any exception thrown by the handler.
+     */
+    uint64_t HipoReader::forEachEvent(uint32_t threads, EventHandler const & handler) const {
+        return ParallelEventReader::forEachRecord({fileName}, threads,
+            [&handler](RecordInput & record, ParallelEventReader::EventInfo const & info) {
+                ParallelEventReader::EventInfo eventInfo = info;
+                uint32_t count = record.getEntries();
+                for (uint32_t i=0; i < count; i++) {
+                    eventInfo.eventIndex = info.eventIndex + i;
+                    handler(HipoEvent(record.getEventView(i)), eventInfo);
+                }
+            });
+    }
+
+}
@@ -0,0 +1,91 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_HIPOREADER_H
+#define EVIO_6_0_HIPOREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <functional>
+
+
+#include "Reader.h"
+#include "HipoSchema.h"
+#include "HipoEvent.h"
+#include "ParallelEventReader.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads the banks of HIPO files. It uses a {@link Reader} to read records
+     * and the schema dictionary stored in the file's user header to describe banks.
+     * Events are {@link HipoEvent} views into the record just read and their banks'
+     * columns are typed views into the same memory, so nothing is copied or decoded
+     * until a value is read.<p>
+     *
+     * Files may also be read in parallel, a whole record at a time for each worker thread,
+     * with {@link #forEachEvent(uint32_t, EventHandler const &)}.
+     *
+     * <pre><code>
+     *    HipoReader reader("run.hipo");
+     *    auto & particle = reader.getDictionary().getSchema("REC::Particle");
+     *    reader.forEachEvent(8, [&particle](HipoEvent const & event,
+     *                                       ParallelEventReader::EventInfo const & info) {
+     *        HipoBank bank = event.getBank(particle);
+     *        auto pz = bank.getColumn&lt;float&gt;("pz");
+     *        ...
+     *    });
+     * </code></pre>
+     */
+    class HipoReader {
+
+    public:
+
+        /** Callback handed each event, valid only during the call, in a worker thread. */
+        typedef std::function<void(HipoEvent const & event,
+                                   ParallelEventReader::EventInfo const & info)> EventHandler;
+
+    private:
+
+        /** Name of file. */
+        std::string fileName;
+
+        /** Reader of records. */
+        Reader reader;
+
+        /** Schemas of banks. */
+        HipoDictionary dictionary;
+
+    public:
+
+        explicit HipoReader(std::string const & fileName);
+
+        void close();
+
+        /** @return name of file being read. */
+        std::string const & getFileName()          const {return fileName;}
+        /** @return schemas of the file's banks. */
+        HipoDictionary const & getDictionary()     const {return dictionary;}
+
+        uint32_t getEventCount() const;
+        HipoEvent getEvent(uint32_t index);
+        bool nextEvent(HipoEvent & event);
+
+        uint64_t forEachEvent(uint32_t threads, EventHandler const & handler) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_HIPOREADER_H
@@ -0,0 +1,252 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "HipoSchema.h"
+
+#include <sstream>
+
+#include "HipoEvent.h"
+#include "RecordHeader.h"
+#include "RecordInput.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** @return string without leading and trailing white space. */
+        std::string trim(std::string const & s) {
+            size_t first = s.find_first_not_of(" \t\r\n");
+            if (first == std::string::npos) return "";
+            size_t last = s.find_last_not_of(" \t\r\n");
+            return s.substr(first, last - first + 1);
+        }
+
+        /** @return parts of a string separated by the given character, trimmed. */
+        std::vector<std::string> split(std::string const & s, char separator) {
+            std::vector<std::string> parts;
+            std::stringstream ss(s);
+            std::string part;
+            while (std::getline(ss, part, separator)) {
+                parts.push_back(trim(part));
+            }
+            return parts;
+        }
+    }
+
+
+    /**
+     * Constructor of a schema with no columns yet.
+     * @param name  name of bank.
+     * @param group group of bank's structure.
+     * @param item  item of bank's structure.
+     */
+    HipoSchema::HipoSchema(std::string const & name, uint16_t group, uint8_t item) :
+            name(name), group(group), item(item) {}
+
+
+    /**
+     * Get the size of a column's values.
+     * @param type type of column: B, S, I, F, D, or L.
+     * @return size in bytes.
+     * @throws EvioException if type is unknown.
+     */
+    uint32_t HipoSchema::typeSize(char type) {
+        switch (type) {
+            case 'B': return 1;
+            case 'S': return 2;
+            case 'I':
+            case 'F': return 4;
+            case 'D':
+            case 'L': return 8;
+            default:
+                throw EvioException(std::string("unknown hipo column type ") + type);
+        }
+    }
+
+
+    /**
+     * Make a schema from its string, <code>{name/group/item}{column/type,...}</code>.
+     * @param text schema string.
+     * @return schema.
+     * @throws EvioException if text is not in the proper format.
+     */
+    HipoSchema HipoSchema::parse(std::string const & text) {
+        size_t open1 = text.find('{');
+        size_t close1 = text.find('}', open1);
+        size_t open2 = text.find('{', close1);
+        size_t close2 = text.find('}', open2);
+        if (open1 == std::string::npos || close1 == std::string::npos ||
+            open2 == std::string::npos || close2 == std::string::npos) {
+            throw EvioException("bad hipo schema format, " + text);
+        }
+
+        auto id = split(text.substr(open1 + 1, close1 - open1 - 1), '/');
+        if (id.size() != 3 || id[0].empty()) {
+            throw EvioException("bad hipo schema name/group/item, " + text);
+        }
+
+        HipoSchema schema;
+        try {
+            schema = HipoSchema(id[0], (uint16_t) std::stoul(id[1]), (uint8_t) std::stoul(id[2]));
+        }
+        catch (std::exception & e) {
+            throw EvioException("bad hipo schema group/item, " + text);
+        }
+
+        for (auto const & entry : split(text.substr(open2 + 1, close2 - open2 - 1), ',')) {
+            auto parts = split(entry, '/');
+            if (parts.size() != 2 || parts[0].empty() || parts[1].size() != 1) {
+                throw EvioException("bad hipo schema column, " + entry);
+            }
+            schema.addColumn(parts[0], parts[1][0]);
+        }
+
+        return schema;
+    }
+
+
+    /**
+     * Add a column after all existing ones.
+     * @param columnName name of column.
+     * @param type       type of column: B, S, I, F, D, or L.
+     * @throws EvioException if type is unknown.
+     */
+    void HipoSchema::addColumn(std::string const & columnName, char type) {
+        uint32_t size = typeSize(type);
+        columns.push_back({columnName, type, size, rowLength});
+        rowLength += size;
+    }
+
+
+    /**
+     * Get the index of a column.
+     * @param columnName name of column.
+     * @return index of column, or -1 if there is none of that name.
+     */
+    int HipoSchema::getColumnIndex(std::string const & columnName) const {
+        for (size_t i=0; i < columns.size(); i++) {
+            if (columns[i].name == columnName) return (int)i;
+        }
+        return -1;
+    }
+
+
+    /**
+     * Get the schema string of this object.
+     * @return schema string in the form <code>{name/group/item}{column/type,...}</code>.
+     */
+    std::string HipoSchema::toString() const {
+        std::stringstream ss;
+        ss << "{" << name << "/" << group << "/" << +item << "}{";
+        for (size_t i=0; i < columns.size(); i++) {
+            if (i > 0) ss << ",";
+            ss << columns[i].name << "/" << columns[i].type;
+        }
+        ss << "}";
+        return ss.str();
+    }
+
+
+    //---------------------------------------------
+    // HipoDictionary
+    //---------------------------------------------
+
+
+    /**
+     * Make a dictionary from the user header of a HIPO file,
+     * which is a record holding one schema per event.
+     * @param userHeader user header, its position at the start of the record.
+     * @return dictionary, empty if user header is too small to hold a record.
+     * @throws EvioException if user header is not a record or a schema is not in the proper format.
+     */
+    HipoDictionary HipoDictionary::fromUserHeader(ByteBuffer & userHeader) {
+        HipoDictionary dictionary;
+        if (userHeader.remaining() < RecordHeader::HEADER_SIZE_BYTES) {
+            return dictionary;
+        }
+
+        RecordInput record(userHeader.order());
+        record.readRecord(userHeader, userHeader.position());
+
+        for (uint32_t i=0; i < record.getEntries(); i++) {
+            HipoEvent event(record.getEventView(i));
+            ByteBufferView text = event.getStructure(SCHEMA_GROUP, SCHEMA_ITEM);
+            if (text.empty()) continue;
+
+            // Strings may be padded with nulls
+            std::string schema(reinterpret_cast<const char *>(text.data()), text.size());
+            schema = schema.substr(0, schema.find('\0'));
+            dictionary.add(HipoSchema::parse(schema));
+        }
+
+        return dictionary;
+    }
+
+
+    /**
+     * Add a schema, replacing any of the same name.
+     * @param schema schema to add.
+     */
+    void HipoDictionary::add(HipoSchema const & schema) {
+        uint32_t id = ((uint32_t)schema.getGroup() << 8) | schema.getItem();
+        auto it = byName.find(schema.getName());
+        if (it != byName.end()) {
+            auto & old = schemas[it->second];
+            byId.erase(((uint32_t)old.getGroup() << 8) | old.getItem());
+            old = schema;
+            byId[id] = it->second;
+            return;
+        }
+
+        byName[schema.getName()] = schemas.size();
+        byId[id] = schemas.size();
+        schemas.push_back(schema);
+    }
+
+
+    /**
+     * Is there a schema of the given name?
+     * @param name name of bank.
+     * @return true if there is.
+     */
+    bool HipoDictionary::hasSchema(std::string const & name) const {
+        return byName.count(name) > 0;
+    }
+
+
+    /**
+     * Get the schema of the given name.
+     * @param name name of bank.
+     * @return schema.
+     * @throws EvioException if there is none.
+     */
+    HipoSchema const & HipoDictionary::getSchema(std::string const & name) const {
+        auto it = byName.find(name);
+        if (it == byName.end()) {
+            throw EvioException("no hipo schema " + name);
+        }
+        return schemas[it->second];
+    }
+
+
+    /**
+     * Find the schema of the banks in structures of the given group and item.
+     * @param group group of structure.
+     * @param item  item of structure.
+     * @return schema, or nullptr if there is none.
+     */
+    HipoSchema const * HipoDictionary::findSchema(uint16_t group, uint8_t item) const {
+        auto it = byId.find(((uint32_t)group << 8) | item);
+        return (it == byId.end()) ? nullptr : &schemas[it->second];
+    }
+
+}
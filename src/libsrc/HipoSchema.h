@@ -0,0 +1,137 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_HIPOSCHEMA_H
+#define EVIO_6_0_HIPOSCHEMA_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+#include "ByteBuffer.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class describes the columns of one type of HIPO bank, as found in a file's
+     * schema dictionary. It's made from a schema string of the form
+     * <code>{name/group/item}{column/type,column/type,...}</code> where each type is one of
+     * B (8 bit), S (16 bit), I (32 bit), F (float), D (double), or L (64 bit).
+     * Banks store their data column by column, so column j of a bank having n rows
+     * starts at n times the bytes of all the columns before it.
+     */
+    class HipoSchema {
+
+    public:
+
+        /** One column of a bank. */
+        struct Column {
+            /** Name of column. */
+            std::string name;
+            /** Type of column: B, S, I, F, D, or L. */
+            char type;
+            /** Size of one value in bytes. */
+            uint32_t size;
+            /** Bytes of all columns before this one in one row. */
+            uint32_t offset;
+        };
+
+    private:
+
+        /** Name of bank. */
+        std::string name;
+        /** Group of bank's structure. */
+        uint16_t group = 0;
+        /** Item of bank's structure. */
+        uint8_t item = 0;
+        /** Columns in order. */
+        std::vector<Column> columns;
+        /** Bytes of one row. */
+        uint32_t rowLength = 0;
+
+    public:
+
+        HipoSchema() = default;
+        HipoSchema(std::string const & name, uint16_t group, uint8_t item);
+
+        static HipoSchema parse(std::string const & text);
+        static uint32_t typeSize(char type);
+
+        void addColumn(std::string const & columnName, char type);
+
+        /** @return name of bank. */
+        std::string const & getName()            const {return name;}
+        /** @return group of bank's structure. */
+        uint16_t getGroup()                      const {return group;}
+        /** @return item of bank's structure. */
+        uint8_t getItem()                        const {return item;}
+        /** @return bytes in one row. */
+        uint32_t getRowLength()                  const {return rowLength;}
+        /** @return number of columns. */
+        size_t getColumnCount()                  const {return columns.size();}
+        /** @return all columns in order. */
+        std::vector<Column> const & getColumns() const {return columns;}
+        /** @param index index of column, unchecked. @return column. */
+        Column const & getColumn(size_t index)   const {return columns[index];}
+
+        int getColumnIndex(std::string const & columnName) const;
+        std::string toString() const;
+    };
+
+
+    /**
+     * This class holds the schemas of all the types of HIPO banks in a file.
+     * They're stored in the file's user header, which is a record, one schema string per event,
+     * in a structure of group 120 and item 2.
+     */
+    class HipoDictionary {
+
+    public:
+
+        /** Group of the structures holding schema strings. */
+        static const uint16_t SCHEMA_GROUP = 120;
+        /** Item of the structures holding schema strings. */
+        static const uint8_t  SCHEMA_ITEM  = 2;
+
+    private:
+
+        /** Schemas in the order added. */
+        std::vector<HipoSchema> schemas;
+        /** Index into schemas of each name. */
+        std::unordered_map<std::string, size_t> byName;
+        /** Index into schemas of each (group << 8 | item). */
+        std::unordered_map<uint32_t, size_t> byId;
+
+    public:
+
+        static HipoDictionary fromUserHeader(ByteBuffer & userHeader);
+
+        void add(HipoSchema const & schema);
+
+        /** @return number of schemas. */
+        size_t size()                                const {return schemas.size();}
+        /** @return all schemas in the order added. */
+        std::vector<HipoSchema> const & getSchemas() const {return schemas;}
+
+        bool hasSchema(std::string const & name) const;
+        HipoSchema const & getSchema(std::string const & name) const;
+        HipoSchema const * findSchema(uint16_t group, uint8_t item) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_HIPOSCHEMA_H
@@ -20,6 +20,7 @@
 #include "ByteOrder.h"
 #include "EvioException.h"
 #include "EvioNode.h"
+#include "StructureIndex.h"
 #include "EvioXMLDictionary.h"
 #include "IBlockHeader.h"
 
@@ -66,6 +67,21 @@ namespace evio {
          */
         virtual void setBuffer(std::shared_ptr<ByteBuffer> & buf) = 0;
 
+        /**
+         * Same as {@link #setBuffer(std::shared_ptr<ByteBuffer> &)} except the EvioNodes
+         * representing events and their structures are taken from the given pool.
+         * The pool is reset each time a buffer is set, so nodes obtained
+         * from the previous buffer must not be used after this is called.
+         * The pool is kept for following calls to the other setBuffer.
+         *
+         * @param buf  ByteBuffer to be read
+         * @param pool source of EvioNode objects, null to create them.
+         * @throws EvioException if buf arg is null;
+         *                       if failure to read first block header;
+         *                       if buffer not in evio format.
+         */
+        virtual void setBuffer(std::shared_ptr<ByteBuffer> & buf, std::shared_ptr<EvioNodeSource> const & pool) = 0;
+
         /**
          * Has {@link #close()} been called (without reopening by calling
          * {@link #setBuffer(std::shared_ptr<ByteBuffer> &)})?
@@ -111,7 +127,7 @@ namespace evio {
          * @throws EvioException if object closed and dictionary still unread
          * @return evio dictionary if exists, else null.
          */
-        virtual std::shared_ptr<EvioXMLDictionary> getDictionary() = 0;
+        virtual std::shared_ptr<const EvioXMLDictionary> getDictionary() = 0;
 
         /**
          * Does this evio file have an associated XML dictionary?
@@ -190,9 +206,37 @@ namespace evio {
          *                       if object closed
          */
         virtual void searchEvent(size_t eventNumber, std::string const & dictName,
-                                 std::shared_ptr<EvioXMLDictionary> & dictionary,
+                                 std::shared_ptr<const EvioXMLDictionary> const & dictionary,
                                  std::vector<std::shared_ptr<EvioNode>> & vec) = 0;
 
+        /**
+         * This method fills a flat index of the specified event and all the structures it
+         * contains, without scanning it into EvioNode objects. Searching the index is much
+         * faster than searching the event's nodes, see {@link StructureIndex#search}.
+         * The index holds the positions of structures in the buffer returned by
+         * {@link #getByteBuffer()}, and becomes invalid once that buffer is changed.
+         *
+         * @param eventNumber place of event in buffer (starting with 1)
+         * @param index index to be filled.
+         * @throws EvioException if bad arg value(s);
+         *                       if object closed;
+         *                       if event is not properly formatted
+         */
+        virtual void indexEvent(size_t eventNumber, StructureIndex & index) = 0;
+
+        /**
+         * This method checks that the specified event is properly formed by walking the headers
+         * of all the structures it contains, without scanning it into EvioNode objects.
+         * See {@link EventHeaderParser#validateEvent}.
+         *
+         * @param eventNumber place of event in buffer (starting with 1)
+         * @return number of structures in event, including the event itself.
+         * @throws EvioException if bad arg value(s);
+         *                       if object closed;
+         *                       if event is not properly formed, saying why and where
+         */
+        virtual uint32_t validateEvent(size_t eventNumber) = 0;
+
         /**
          * This method removes the data of the given event from the buffer.
          * It also marks any existing EvioNodes representing the event and its
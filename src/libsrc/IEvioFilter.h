@@ -21,6 +21,7 @@ namespace evio {
 
     // forward declaration so we can compile
     class BaseStructure;
+    class BaseStructureHeader;
 
     /**
      * This interface allows applications to create filters so that they only receive certain structures
@@ -34,6 +35,9 @@ namespace evio {
      * MyFilter myfilter();
      * EventParser.getInstance().setEvioFilter(myFilter);
      * </pre>
+     * If the parser is pruning (see {@link EventParser#setPruning(bool)}), {@link #acceptHeader}
+     * is also called with each header found, before any structure is created from it.
+     *
      * @author heddle (Original java class)
      * @author timmer
      */
@@ -52,6 +56,21 @@ namespace evio {
          * @see StructureType
          */
         virtual bool accept(StructureType const & structureType, std::shared_ptr<BaseStructure> structure) = 0;
+
+        /**
+         * Accept or reject the structure with the given header before it is created.
+         * A rejected structure and everything it contains is skipped entirely: it is not created, not added
+         * to the tree, and not given to the listeners. An accepted structure is created and its own children
+         * are passed in turn to this method. Only used when pruning. The default accepts everything.
+         *
+         * @param structureType the structure type of the header just found, e.g., <code>StructureType.BANK</code>.
+         * @param header the header just found. Its tag, num, length, and data type are available.
+         * @return <code>true</code> if the structure should be created and parsed.
+         * @see EventParser#setPruning(bool)
+         */
+        virtual bool acceptHeader(StructureType const & /*structureType*/, BaseStructureHeader const & /*header*/) {
+            return true;
+        }
     };
 
 }
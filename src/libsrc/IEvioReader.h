@@ -231,6 +231,35 @@ namespace evio {
          */
         virtual std::shared_ptr<EvioEvent> parseNextEvent() = 0;
 
+        /**
+         * Retrieve the next event from the file/buffer and parse it into the given event,
+         * reusing that object and the structures it held from the last call, instead
+         * of making a new tree (see {@link EventParser#parseEvent(const uint8_t *, size_t,
+         * ByteOrder const &, std::shared_ptr<EvioEvent> &)}). Structures gotten from the
+         * event before this call must not be kept.
+         *
+         * @param evioEvent event to fill, reused from call to call. If null, a new one is made.
+         * @return true if an event was parsed, false at end of file/buffer.
+         * @throws EvioException if failed file access;
+         *                       if read failure or bad format;
+         *                       if object closed
+         */
+        virtual bool parseNextEvent(std::shared_ptr<EvioEvent> & evioEvent) = 0;
+
+        /**
+         * Retrieve the desired event from the file/buffer and parse it into the given event,
+         * reusing that object and the structures it held, as in
+         * {@link #parseNextEvent(std::shared_ptr<EvioEvent> &)}.
+         *
+         * @param  index     number of event desired, starting at 1, from beginning of file/buffer
+         * @param  evioEvent event to fill, reused from call to call. If null, a new one is made.
+         * @throws EvioException if failed file access;
+         *                       if failed read due to bad file/buffer format;
+         *                       if index out of bounds;
+         *                       if object closed
+         */
+        virtual void parseEvent(size_t index, std::shared_ptr<EvioEvent> & evioEvent) = 0;
+
         /**
          * This will parse an event, SAX-like. It will drill down and uncover all structures
          * (banks, segments, and tagsegments) and notify any interested listeners.<p>
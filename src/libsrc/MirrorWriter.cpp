@@ -0,0 +1,597 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "MirrorWriter.h"
+
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+namespace evio {
+
+
+    /** Most vectors of written records kept for reuse. */
+    static const size_t MAX_SPARE_VECTORS = 16;
+
+
+    /**
+     * Constructor which mirrors files into a directory.
+     * @param directory existing directory in which to write files.
+     * @throws EvioException if directory does not exist.
+     */
+    MirrorWriter::MirrorWriter(std::string const & directory) :
+            destination(TO_DIRECTORY), directory(directory) {
+
+        struct stat info {};
+        if (directory.empty() || ::stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+            throw EvioException("no directory " + directory);
+        }
+
+        recordLengths = std::make_shared<std::vector<uint32_t>>();
+        startThread();
+    }
+
+
+    /**
+     * Constructor which mirrors files over a TCP socket to a {@link SocketReader}.
+     * @param host name or address of host to connect to.
+     * @param port port to connect to.
+     * @throws EvioException if cannot connect.
+     */
+    MirrorWriter::MirrorWriter(std::string const & host, uint16_t port) : destination(TO_SOCKET) {
+        connectTo(host, port);
+        recordLengths = std::make_shared<std::vector<uint32_t>>();
+        startThread();
+    }
+
+
+    /**
+     * Constructor which mirrors files over an already connected TCP socket.
+     * The socket is closed by this object.
+     * @param socketFd connected socket's file descriptor.
+     * @throws EvioException if socketFd is negative.
+     */
+    MirrorWriter::MirrorWriter(int socketFd) : destination(TO_SOCKET), sock(socketFd) {
+        if (socketFd < 0) {
+            throw EvioException("bad socket file descriptor");
+        }
+        recordLengths = std::make_shared<std::vector<uint32_t>>();
+        startThread();
+    }
+
+
+    /** Destructor, which closes this mirror if not already done. */
+    MirrorWriter::~MirrorWriter() {
+        try {
+            close();
+        }
+        catch (std::exception & e) {}
+    }
+
+
+    /**
+     * Connect to a host's port.
+     * @param host name or address of host.
+     * @param port port number.
+     * @throws EvioException if cannot connect.
+     */
+    void MirrorWriter::connectTo(std::string const & host, uint16_t port) {
+        struct addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        struct addrinfo *result = nullptr;
+        std::string service = std::to_string(port);
+        int err = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+        if (err != 0) {
+            throw EvioException("cannot find host " + host + ": " + gai_strerror(err));
+        }
+
+        for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                sock = fd;
+                break;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(result);
+
+        if (sock < 0) {
+            throw EvioException("cannot connect to " + host + ":" + service + ", " + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Set what to do once the queue of records waiting to be written is full.
+     *
+     * @param policy            wait for room with BLOCK, or with DROP, wait at most
+     *                          dropTimeoutMillis and then stop mirroring.
+     * @param maxQueueBytes     max bytes of records waiting to be written,
+     *                          0 to leave as is (default {@link #DEFAULT_QUEUE_BYTES}).
+     *                          A record larger than this is still queued once the queue is empty.
+     * @param dropTimeoutMillis with DROP, milliseconds to wait for room before dropping out,
+     *                          0 to drop out as soon as a record does not fit.
+     */
+    void MirrorWriter::setBackpressure(Backpressure policy, size_t maxQueueBytes, uint32_t dropTimeoutMillis) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        backpressure = policy;
+        if (maxQueueBytes > 0) {
+            this->maxQueueBytes = maxQueueBytes;
+        }
+        this->dropTimeoutMillis = dropTimeoutMillis;
+        roomInQueue.notify_all();
+    }
+
+
+    /** @return why mirroring stopped, or blank if it has not. */
+    std::string MirrorWriter::getError() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return error;
+    }
+
+
+    /** @return bytes of records waiting to be written. */
+    size_t MirrorWriter::getQueuedBytes() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return queuedBytes;
+    }
+
+
+    /**
+     * Stop mirroring, throwing away everything not yet written. Called while holding queueMutex.
+     * @param reason why mirroring stopped.
+     */
+    void MirrorWriter::dropOut(std::string const & reason) {
+        if (droppedOut) return;
+
+        error = reason;
+        droppedOut = true;
+        std::cout << "MirrorWriter: stopped mirroring, " << reason << std::endl;
+
+        for (auto & task : queue) {
+            if (task.kind == Task::RECORD) recordsDropped++;
+        }
+        queue.clear();
+        queuedBytes = 0;
+
+        // Don't leave the mirror thread stuck sending to a peer which stopped reading
+        if (sock >= 0) {
+            ::shutdown(sock, SHUT_RDWR);
+        }
+
+        roomInQueue.notify_all();
+        tasksWaiting.notify_all();
+    }
+
+
+    /**
+     * Get a vector, reused if possible, holding the given number of bytes.
+     * Called while holding queueMutex.
+     * @param bytes number of bytes.
+     * @return vector.
+     */
+    std::vector<uint8_t> MirrorWriter::spareVector(size_t bytes) {
+        std::vector<uint8_t> vec;
+        if (!spareBytes.empty()) {
+            vec = std::move(spareBytes.back());
+            spareBytes.pop_back();
+        }
+        vec.resize(bytes);
+        return vec;
+    }
+
+
+    /**
+     * Start mirroring a file which the writer has just created.
+     * @param fileName name of writer's file.
+     * @param header   file header written to it, including any user header.
+     * @param bytes    number of bytes in header.
+     * @throws EvioException if this object is closed.
+     */
+    void MirrorWriter::openFile(std::string const & fileName, const uint8_t *header, size_t bytes) {
+        if (closed) {
+            throw EvioException("mirror closed");
+        }
+
+        fileOpen = true;
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (droppedOut) return;
+
+        Task task;
+        task.kind = Task::OPEN;
+        task.fileName = fileName;
+        task.bytes.assign(header, header + bytes);
+        queue.push_back(std::move(task));
+        tasksWaiting.notify_all();
+    }
+
+
+    /**
+     * Copy a record, which the writer is writing to its file, into the queue to be mirrored.
+     * If the queue is full, this waits or drops out according to the {@link Backpressure} policy.
+     *
+     * @param record built record being written to file.
+     * @return true if record will be mirrored, false if mirroring has stopped or no
+     *         file is being mirrored.
+     * @throws EvioException if this object is closed.
+     */
+    bool MirrorWriter::writeRecord(RecordOutput & record) {
+        if (closed) {
+            throw EvioException("mirror closed");
+        }
+
+        if (!fileOpen) return false;
+
+        auto & header = record.getHeader();
+        size_t length = header->getLength();
+
+        std::unique_lock<std::mutex> lock(queueMutex);
+
+        auto room = [this, length] {
+            return droppedOut || queuedBytes == 0 || queuedBytes + length <= maxQueueBytes;
+        };
+
+        if (backpressure == BLOCK) {
+            roomInQueue.wait(lock, room);
+        }
+        else if (!roomInQueue.wait_for(lock, std::chrono::milliseconds(dropTimeoutMillis), room)) {
+            dropOut("fell behind by " + std::to_string(queuedBytes) + " bytes");
+        }
+
+        if (droppedOut) {
+            recordsDropped++;
+            return false;
+        }
+
+        Task task;
+        task.kind = Task::RECORD;
+        task.entries = header->getEntries();
+        task.bytes = spareVector(length);
+        queuedBytes += length;
+
+        // Copy without keeping the mirror thread waiting
+        lock.unlock();
+        uint8_t *dest = task.bytes.data();
+        record.getSegments(segments);
+        for (auto & seg : segments) {
+            std::memcpy(dest, seg.data(), seg.size());
+            dest += seg.size();
+        }
+        lock.lock();
+
+        // Dropped out in the meantime, by the mirror thread
+        if (droppedOut) {
+            recordsDropped++;
+            return false;
+        }
+
+        queue.push_back(std::move(task));
+        tasksWaiting.notify_all();
+        return true;
+    }
+
+
+    /**
+     * Finish mirroring the file which the writer is closing.
+     * @param recordNumber record number of the file's trailer.
+     * @param trailer      write a trailer?
+     * @param trailerIndex write an index of all records in trailer?
+     * @throws EvioException if this object is closed.
+     */
+    void MirrorWriter::closeFile(uint32_t recordNumber, bool trailer, bool trailerIndex) {
+        if (closed) {
+            throw EvioException("mirror closed");
+        }
+
+        if (!fileOpen) return;
+        fileOpen = false;
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (droppedOut) return;
+
+        Task task;
+        task.kind = Task::CLOSE;
+        task.recordNumber = recordNumber;
+        task.trailer = trailer;
+        task.trailerIndex = trailerIndex;
+        queue.push_back(std::move(task));
+        tasksWaiting.notify_all();
+    }
+
+
+    /**
+     * Write everything queued, end a socket's stream with a trailer, wait for the mirror
+     * thread to finish, and close the socket. Called by {@link EventWriter#close()}.
+     */
+    void MirrorWriter::close() {
+        if (closed) return;
+        closed = true;
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+            tasksWaiting.notify_all();
+        }
+
+        if (thd.joinable()) {
+            thd.join();
+        }
+
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        if (sock >= 0) {
+            ::close(sock);
+            sock = -1;
+        }
+    }
+
+
+    /** Create and start the thread which writes to the destination. */
+    void MirrorWriter::startThread() {
+        thd = boost::thread([this]() {this->run();});
+    }
+
+
+    /** Method run by the mirror thread, which does the tasks in the queue until closed. */
+    void MirrorWriter::run() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                tasksWaiting.wait(lock, [this] {return stopping || !queue.empty();});
+                if (queue.empty()) break;
+
+                task = std::move(queue.front());
+                queue.pop_front();
+                if (task.kind == Task::RECORD) {
+                    queuedBytes -= task.bytes.size();
+                    roomInQueue.notify_all();
+                }
+            }
+
+            if (droppedOut) continue;
+
+            try {
+                switch (task.kind) {
+                    case Task::OPEN:
+                        openMirrorFile(task);
+                        break;
+
+                    case Task::CLOSE:
+                        closeMirrorFile(task);
+                        break;
+
+                    default:
+                        if (destination == TO_SOCKET || fd >= 0) {
+                            writeAll(task.bytes.data(), task.bytes.size());
+                            recordLengths->push_back(task.bytes.size());
+                            recordLengths->push_back(task.entries);
+                            filePosition += task.bytes.size();
+                            recordsWritten++;
+                        }
+                }
+            }
+            catch (std::exception & e) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                dropOut(e.what());
+            }
+
+            if (task.kind == Task::RECORD) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (spareBytes.size() < MAX_SPARE_VECTORS) {
+                    spareBytes.push_back(std::move(task.bytes));
+                }
+            }
+        }
+
+        // End the stream
+        if (destination == TO_SOCKET && headerSent && !droppedOut) {
+            try {
+                sendTrailer();
+            }
+            catch (std::exception & e) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                dropOut(e.what());
+            }
+        }
+    }
+
+
+    /**
+     * Create the mirror of a file and write its file header or,
+     * for a socket, send the file header if not already done.
+     * @param task OPEN task.
+     * @throws EvioException if file cannot be created, is the one being mirrored, or written to.
+     */
+    void MirrorWriter::openMirrorFile(Task & task) {
+        ByteBuffer buf(task.bytes.size());
+        std::memcpy(buf.array(), task.bytes.data(), task.bytes.size());
+
+        if (destination == TO_SOCKET) {
+            if (headerSent) return;
+            fileHeader.readHeader(buf, 0);
+            byteOrder = fileHeader.getByteOrder();
+            writeAll(task.bytes.data(), task.bytes.size());
+            headerSent = true;
+            return;
+        }
+
+        // Not closed by the writer, which does not happen
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+
+        size_t slash = task.fileName.find_last_of('/');
+        std::string baseName = slash == std::string::npos ? task.fileName : task.fileName.substr(slash + 1);
+        mirrorFileName = directory + "/" + baseName;
+
+        // Writing over the very file being mirrored would destroy both
+        char realFile[PATH_MAX], realDir[PATH_MAX];
+        if (::realpath(task.fileName.c_str(), realFile) != nullptr &&
+            ::realpath(directory.c_str(), realDir) != nullptr &&
+            std::string(realDir) + "/" + baseName == realFile) {
+            throw EvioException("mirror file " + mirrorFileName + " is the file being mirrored");
+        }
+
+        fd = ::open(mirrorFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw EvioException("cannot create " + mirrorFileName + ", " + std::strerror(errno));
+        }
+
+        fileHeader.readHeader(buf, 0);
+        byteOrder = fileHeader.getByteOrder();
+        recordLengths->clear();
+        filePosition = 0;
+
+        writeAll(task.bytes.data(), task.bytes.size());
+        filePosition = task.bytes.size();
+    }
+
+
+    /**
+     * Write the trailer of a mirror file, update its file header the same way as the
+     * writer's, and close it. Nothing is done for a socket.
+     * @param task CLOSE task.
+     * @throws EvioException if file cannot be written to or closed.
+     */
+    void MirrorWriter::closeMirrorFile(Task & task) {
+        if (destination == TO_SOCKET || fd < 0) return;
+
+        if (task.trailer) {
+            uint64_t trailerPosition = filePosition;
+
+            size_t bytes = RecordHeader::HEADER_SIZE_BYTES;
+            if (task.trailerIndex) {
+                bytes += 4*recordLengths->size();
+            }
+            ByteBuffer buf(bytes);
+            buf.order(byteOrder);
+            RecordHeader::writeTrailer(buf, 0, task.recordNumber,
+                                       task.trailerIndex ? recordLengths : nullptr);
+            writeAll(buf.array(), bytes);
+
+            // Update file header's trailer position word
+            if (!byteOrder.isLocalEndian()) {
+                trailerPosition = SWAP_64(trailerPosition);
+            }
+            writeAt(&trailerPosition, sizeof(trailerPosition), FileHeader::TRAILER_POSITION_OFFSET);
+
+            // Update file header's bit-info word
+            if (task.trailerIndex) {
+                uint32_t bitInfo = fileHeader.setBitInfo(fileHeader.hasFirstEvent(),
+                                                         fileHeader.hasDictionary(), true);
+                if (!byteOrder.isLocalEndian()) {
+                    bitInfo = SWAP_32(bitInfo);
+                }
+                writeAt(&bitInfo, sizeof(bitInfo), FileHeader::BIT_INFO_OFFSET);
+            }
+        }
+
+        // Update file header's record count word
+        uint32_t recordCount = task.recordNumber - 1;
+        if (!byteOrder.isLocalEndian()) {
+            recordCount = SWAP_32(recordCount);
+        }
+        writeAt(&recordCount, sizeof(recordCount), FileHeader::RECORD_COUNT_OFFSET);
+
+        int err = ::close(fd);
+        fd = -1;
+        if (err != 0) {
+            throw EvioException("error closing " + mirrorFileName + ", " + std::strerror(errno));
+        }
+        filesWritten++;
+    }
+
+
+    /**
+     * Send a trailer without an index, ending the stream of a socket.
+     * @throws EvioException if error sending.
+     */
+    void MirrorWriter::sendTrailer() {
+        ByteBuffer buf(RecordHeader::HEADER_SIZE_BYTES);
+        buf.order(byteOrder);
+        RecordHeader::writeTrailer(buf, 0, (uint32_t)recordsWritten + 1, nullptr);
+        writeAll(buf.array(), RecordHeader::HEADER_SIZE_BYTES);
+    }
+
+
+    /**
+     * Write all given bytes to the end of the mirror file or to the socket.
+     * @param data pointer to data.
+     * @param len  number of bytes to write.
+     * @throws EvioException if error writing.
+     */
+    void MirrorWriter::writeAll(const uint8_t *data, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n;
+            if (destination == TO_SOCKET) {
+                n = ::send(sock, data + done, len - done, MSG_NOSIGNAL);
+            }
+            else {
+                n = ::write(fd, data + done, len - done);
+            }
+
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException("error writing " +
+                                    (destination == TO_SOCKET ? std::string("to socket") : mirrorFileName) +
+                                    ", " + std::strerror(errno));
+            }
+            done += n;
+        }
+        bytesWritten += len;
+    }
+
+
+    /**
+     * Write all given bytes to the mirror file at the given position.
+     * @param data     pointer to data.
+     * @param len      number of bytes to write.
+     * @param position position in file.
+     * @throws EvioException if error writing.
+     */
+    void MirrorWriter::writeAt(const void *data, size_t len, uint64_t position) {
+        auto *bytes = static_cast<const uint8_t *>(data);
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = ::pwrite(fd, bytes + done, len - done, position + done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException("error writing " + mirrorFileName + ", " + std::strerror(errno));
+            }
+            done += n;
+        }
+    }
+
+}
@@ -0,0 +1,268 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_MIRRORWRITER_H
+#define EVIO_6_0_MIRRORWRITER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+#include "boost/thread.hpp"
+
+
+#include "ByteBufferView.h"
+#include "ByteOrder.h"
+#include "FileHeader.h"
+#include "RecordHeader.h"
+#include "RecordOutput.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class writes a second copy of what an {@link EventWriter} writes to its files,
+     * to another directory or over a TCP socket, so that records are compressed only once
+     * for both. It's given to the writer with {@link EventWriter#addMirror}, after which the
+     * writer hands it each file header, each record as it's written, and each file's end.
+     * Several mirrors may be given to one writer.<p>
+     *
+     * Each mirror copies what it's handed into a queue and writes it with its own thread,
+     * so a slow mirror does not slow things down until its queue is full. Then, depending
+     * on the {@link Backpressure} policy, the writer either waits for room
+     * ({@link #BLOCK}), or waits at most a given time after which the mirror drops out
+     * ({@link #DROP}) and ignores everything after. A mirror also drops out on any error
+     * writing, leaving the writer's own files unaffected.<p>
+     *
+     * A directory mirror writes a file with the same name for each file written, split when
+     * it is, each with its own trailer and file header updates. A socket mirror sends a
+     * single stream readable by a {@link SocketReader}: the file header of the first file,
+     * every record of every file, and a trailer once closed.<p>
+     *
+     * Only files created by the writer are mirrored, not one appended to.
+     */
+    class MirrorWriter {
+
+    public:
+
+        /** What to do once a mirror's queue is full. */
+        enum Backpressure {
+            /** Wait for room in the queue, which slows down the writer. */
+            BLOCK = 0,
+            /** Wait at most the drop timeout for room, then stop mirroring. */
+            DROP
+        };
+
+        /** Kinds of destinations. */
+        enum Destination {
+            /** Files in a directory. */
+            TO_DIRECTORY = 0,
+            /** A TCP socket. */
+            TO_SOCKET
+        };
+
+        /** Default max bytes of records waiting to be written. */
+        static const size_t DEFAULT_QUEUE_BYTES = 64*1024*1024;
+
+    private:
+
+        /** Something for the mirror's thread to do. */
+        struct Task {
+            /** Kinds of tasks. */
+            enum Kind {OPEN, RECORD, CLOSE};
+            /** Kind of task. */
+            Kind kind = RECORD;
+            /** For OPEN, name of the writer's file. */
+            std::string fileName;
+            /** For OPEN, file header; for RECORD, record. */
+            std::vector<uint8_t> bytes;
+            /** For RECORD, number of events in it. */
+            uint32_t entries = 0;
+            /** For CLOSE, record number of trailer. */
+            uint32_t recordNumber = 0;
+            /** For CLOSE, write trailer? */
+            bool trailer = false;
+            /** For CLOSE, write index of records in trailer? */
+            bool trailerIndex = false;
+        };
+
+        /** Kind of destination. */
+        Destination destination;
+
+        /** Directory in which to write files. */
+        std::string directory;
+
+        /** Socket file descriptor, -1 if none. */
+        int sock = -1;
+
+        /** What to do once queue is full. */
+        Backpressure backpressure = BLOCK;
+
+        /** Max bytes of records waiting to be written. */
+        size_t maxQueueBytes = DEFAULT_QUEUE_BYTES;
+
+        /** With DROP, milliseconds to wait for room in queue before dropping out. */
+        uint32_t dropTimeoutMillis = 0;
+
+        //----------------------------------------------
+        // Shared by calling and mirror thread
+        //----------------------------------------------
+
+        /** Protects everything shared by calling and mirror thread. */
+        std::mutex queueMutex;
+
+        /** Notifies mirror thread of new tasks. */
+        std::condition_variable tasksWaiting;
+
+        /** Notifies calling thread of room in queue. */
+        std::condition_variable roomInQueue;
+
+        /** Tasks not yet done. */
+        std::deque<Task> queue;
+
+        /** Vectors of tasks already done, to be reused. */
+        std::vector<std::vector<uint8_t>> spareBytes;
+
+        /** Bytes of records in queue. */
+        size_t queuedBytes = 0;
+
+        /** Set by {@link #close()}, after which the mirror thread ends once queue is empty. */
+        bool stopping = false;
+
+        /** Has mirroring stopped because of falling behind or an error? */
+        std::atomic_bool droppedOut {false};
+
+        /** Why mirroring stopped. */
+        std::string error;
+
+        //----------------------------------------------
+        // Used by calling thread only
+        //----------------------------------------------
+
+        /** Has a file been opened and not yet closed? */
+        bool fileOpen = false;
+
+        /** Parts of the record being copied. */
+        std::vector<ByteBufferView> segments;
+
+        /** Has close() been called? */
+        bool closed = false;
+
+        //----------------------------------------------
+        // Used by mirror thread only
+        //----------------------------------------------
+
+        /** File descriptor of mirror file, -1 if none open. */
+        int fd = -1;
+
+        /** Name of mirror file being written. */
+        std::string mirrorFileName;
+
+        /** Header of first file (socket) or current file (directory). */
+        FileHeader fileHeader;
+
+        /** Byte order of data. */
+        ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
+
+        /** Position in current file at which the next record is written. */
+        uint64_t filePosition = 0;
+
+        /** Lengths and event counts of current file's records, for the trailer's index. */
+        std::shared_ptr<std::vector<uint32_t>> recordLengths;
+
+        /** For a socket, has the file header been sent? */
+        bool headerSent = false;
+
+        /** Thread writing to destination. */
+        boost::thread thd;
+
+        //----------------------------------------------
+        // Statistics
+        //----------------------------------------------
+
+        /** Total bytes written. */
+        std::atomic<uint64_t> bytesWritten {0};
+
+        /** Total records written. */
+        std::atomic<uint64_t> recordsWritten {0};
+
+        /** Total files written, for a directory. */
+        std::atomic<uint64_t> filesWritten {0};
+
+        /** Total records not mirrored, because of dropping out. */
+        std::atomic<uint64_t> recordsDropped {0};
+
+    public:
+
+        explicit MirrorWriter(std::string const & directory);
+        MirrorWriter(std::string const & host, uint16_t port);
+        explicit MirrorWriter(int socketFd);
+
+        MirrorWriter(const MirrorWriter & other) = delete;
+        MirrorWriter & operator=(const MirrorWriter & other) = delete;
+        ~MirrorWriter();
+
+        void setBackpressure(Backpressure policy, size_t maxQueueBytes = 0, uint32_t dropTimeoutMillis = 0);
+
+        /** @return kind of destination. */
+        Destination getDestination()   const {return destination;}
+        /** @return what to do once queue is full. */
+        Backpressure getBackpressure() const {return backpressure;}
+        /** @return max bytes of records waiting to be written. */
+        size_t getMaxQueueBytes()      const {return maxQueueBytes;}
+        /** @return total bytes written. */
+        uint64_t getBytesWritten()     const {return bytesWritten;}
+        /** @return total records written. */
+        uint64_t getRecordsWritten()   const {return recordsWritten;}
+        /** @return total files written, for a directory. */
+        uint64_t getFilesWritten()     const {return filesWritten;}
+        /** @return total records not mirrored, because of dropping out. */
+        uint64_t getRecordsDropped()   const {return recordsDropped;}
+        /** @return true if mirroring stopped because of falling behind or an error. */
+        bool isDroppedOut()            const {return droppedOut;}
+        /** @return true if close() has been called. */
+        bool isClosed()                const {return closed;}
+
+        std::string getError();
+        size_t getQueuedBytes();
+
+        void openFile(std::string const & fileName, const uint8_t *header, size_t bytes);
+        bool writeRecord(RecordOutput & record);
+        void closeFile(uint32_t recordNumber, bool trailer, bool trailerIndex);
+        void close();
+
+    private:
+
+        void connectTo(std::string const & host, uint16_t port);
+        void startThread();
+        void run();
+        void dropOut(std::string const & reason);
+        std::vector<uint8_t> spareVector(size_t bytes);
+
+        void openMirrorFile(Task & task);
+        void closeMirrorFile(Task & task);
+        void sendTrailer();
+        void writeAll(const uint8_t *data, size_t len);
+        void writeAt(const void *data, size_t len, uint64_t position);
+    };
+
+}
+
+
+#endif //EVIO_6_0_MIRRORWRITER_H
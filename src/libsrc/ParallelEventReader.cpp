@@ -0,0 +1,317 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "ParallelEventReader.h"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <boost/thread.hpp>
+
+#include "Reader.h"
+#include "RecordInput.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** One record to be read by a worker thread. */
+        struct RecordTask {
+            uint32_t fileIndex;
+            uint32_t recordIndex;
+            size_t   position;
+            uint64_t firstEvent;
+            /** Trained dictionary of the record's file, null if none. */
+            std::shared_ptr<CompressionDictionary> dictionary;
+        };
+
+
+        /** State shared by the calling thread and workers. */
+        struct SharedState {
+            std::mutex mtx;
+            std::condition_variable cond;
+            std::exception_ptr error;
+            std::atomic<bool> stop {false};
+            std::atomic<size_t> nextTask {0};
+            std::atomic<uint64_t> eventCount {0};
+
+            /** Remember the first error and tell everyone to quit. */
+            void setError(std::exception_ptr e) {
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!error) error = e;
+                    stop = true;
+                }
+                cond.notify_all();
+            }
+        };
+
+
+        /**
+         * Find all records in the given files by scanning each with a Reader
+         * (which uses the file's index if it has one).
+         * @param files names of files.
+         * @return list of records in file and file position order.
+         */
+        std::vector<RecordTask> findRecords(std::vector<std::string> const & files) {
+            std::vector<RecordTask> tasks;
+            for (uint32_t f=0; f < files.size(); f++) {
+                Reader reader(files[f]);
+                uint64_t firstEvent = 0;
+                auto dictionary = reader.getCompressionDictionary();
+                auto & positions = reader.getRecordPositions();
+                for (uint32_t r=0; r < positions.size(); r++) {
+                    tasks.push_back({f, r, positions[r].getPosition(), firstEvent, dictionary});
+                    firstEvent += positions[r].getCount();
+                }
+                reader.close();
+            }
+            return tasks;
+        }
+
+
+        /**
+         * Run worker threads, each reading records handed out in order, until all records
+         * are read or one of them stops. The first exception thrown is saved in state.
+         *
+         * @param files   names of files.
+         * @param tasks   records to read.
+         * @param threads number of worker threads.
+         * @param state   shared state.
+         * @param waitTurn  called with a task's index before it's read, returns false to quit.
+         * @param doRecord  called with a task's index, the record read, and thread number.
+         * @return running threads.
+         */
+        std::vector<boost::thread> startWorkers(std::vector<std::string> const & files,
+                                                std::vector<RecordTask> const & tasks,
+                                                uint32_t threads, SharedState & state,
+                                                std::function<bool(size_t)> const & waitTurn,
+                                                std::function<void(size_t, RecordInput &, uint32_t)> const & doRecord) {
+            std::vector<boost::thread> workers;
+            for (uint32_t t=0; t < threads; t++) {
+                workers.emplace_back([&files, &tasks, &state, waitTurn, doRecord, t]() {
+                    // Each thread has its own file stream and record so reads can happen simultaneously
+                    std::ifstream file;
+                    uint32_t openFile = UINT32_MAX;
+                    RecordInput record;
+
+                    try {
+                        while (!state.stop) {
+                            size_t index = state.nextTask++;
+                            if (index >= tasks.size()) break;
+                            if (!waitTurn(index)) break;
+
+                            RecordTask const & task = tasks[index];
+                            if (task.fileIndex != openFile) {
+                                file.close();
+                                file.clear();
+                                file.open(files[task.fileIndex], std::ios::binary);
+                                if (!file.is_open()) {
+                                    throw EvioException("cannot open file " + files[task.fileIndex]);
+                                }
+                                file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+                                openFile = task.fileIndex;
+                            }
+
+                            record.setCompressionDictionary(task.dictionary);
+                            record.readRecord(file, task.position);
+                            doRecord(index, record, t);
+                        }
+                    }
+                    catch (...) {
+                        state.setError(std::current_exception());
+                    }
+                });
+            }
+            return workers;
+        }
+
+
+        /** Wait for all workers to finish and rethrow the first error, if any. */
+        void joinWorkers(std::vector<boost::thread> & workers, SharedState & state) {
+            for (auto & w : workers) {
+                if (w.joinable()) w.join();
+            }
+            if (state.error) {
+                std::rethrow_exception(state.error);
+            }
+        }
+    }
+
+
+    /**
+     * Pass every event of the given files to a handler, in parallel, in no particular order.
+     * Files are read one after another, each worker thread reading whole records.
+     *
+     * @param files    names of evio version 6 files.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @param handler  called, in a worker thread, with each event.
+     *                 The event view is valid only during the call.
+     * @return number of events handled.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format.
+     *         Rethrows any exception thrown by the handler.
+     */
+    uint64_t ParallelEventReader::forEachEvent(std::vector<std::string> const & files, uint32_t threads,
+                                               EventHandler const & handler) {
+
+        if (threads == 0) threads = std::max(1U, boost::thread::hardware_concurrency());
+
+        auto tasks = findRecords(files);
+        SharedState state;
+
+        auto workers = startWorkers(files, tasks, threads, state,
+            [](size_t) {return true;},
+            [&tasks, &state, &handler](size_t index, RecordInput & record, uint32_t thread) {
+                RecordTask const & task = tasks[index];
+                EventInfo info {task.fileIndex, task.recordIndex, task.firstEvent, thread};
+                uint32_t count = record.getEntries();
+                for (uint32_t i=0; i < count && !state.stop; i++) {
+                    info.eventIndex = task.firstEvent + i;
+                    handler(record.getEventView(i), info);
+                }
+                state.eventCount += count;
+            });
+
+        joinWorkers(workers, state);
+        return state.eventCount;
+    }
+
+
+    /**
+     * Pass every record of the given files to a handler, in parallel, in no particular order.
+     * Files are read one after another, each worker thread reading whole records.
+     *
+     * @param files    names of evio version 6 files.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @param handler  called, in a worker thread, with each record read and uncompressed.
+     *                 The record is valid only during the call.
+     * @return number of events in the records handled.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format.
+     *         Rethrows any exception thrown by the handler.
+     */
+    uint64_t ParallelEventReader::forEachRecord(std::vector<std::string> const & files, uint32_t threads,
+                                                RecordHandler const & handler) {
+
+        if (threads == 0) threads = std::max(1U, boost::thread::hardware_concurrency());
+
+        auto tasks = findRecords(files);
+        SharedState state;
+
+        auto workers = startWorkers(files, tasks, threads, state,
+            [](size_t) {return true;},
+            [&tasks, &state, &handler](size_t index, RecordInput & record, uint32_t thread) {
+                RecordTask const & task = tasks[index];
+                EventInfo info {task.fileIndex, task.recordIndex, task.firstEvent, thread};
+                handler(record, info);
+                state.eventCount += record.getEntries();
+            });
+
+        joinWorkers(workers, state);
+        return state.eventCount;
+    }
+
+
+    /**
+     * Transform every event of the given files in parallel, then pass each result
+     * to a sink in the calling thread in the order of the events in the files.
+     * Results of at most maxBufferedRecords records are held while waiting for
+     * earlier records to finish; workers wait when that limit is reached.
+     *
+     * @param files    names of evio version 6 files.
+     * @param threads  number of worker threads, 0 for one per cpu core.
+     * @param transform called, in a worker thread, with each event.
+     *                  The event view is valid only during the call.
+     *                  Returns a result or nullptr if there is none, for example if event is filtered out.
+     * @param sink     called, in the calling thread, with each non-null result in event order.
+     * @param maxBufferedRecords  max number of records processed ahead of the sink, 0 for 4 per thread.
+     * @return number of events transformed.
+     * @throws EvioException if a file cannot be opened or is not evio version 6 format.
+     *         Rethrows any exception thrown by transform or sink.
+     */
+    uint64_t ParallelEventReader::forEachEvent(std::vector<std::string> const & files, uint32_t threads,
+                                               EventTransform const & transform, EventSink const & sink,
+                                               uint32_t maxBufferedRecords) {
+
+        if (threads == 0) threads = std::max(1U, boost::thread::hardware_concurrency());
+        if (maxBufferedRecords == 0) maxBufferedRecords = 4*threads;
+
+        typedef std::vector<std::pair<std::shared_ptr<ByteBuffer>, EventInfo>> Results;
+
+        auto tasks = findRecords(files);
+        SharedState state;
+
+        // Reorder buffer, results of each record by task index, and next one for the sink
+        std::map<size_t, Results> finished;
+        size_t nextToSink = 0;
+
+        auto workers = startWorkers(files, tasks, threads, state,
+            [&state, &nextToSink, maxBufferedRecords](size_t index) {
+                // Don't get too far ahead of the sink. The earliest unfinished record never waits.
+                std::unique_lock<std::mutex> lock(state.mtx);
+                state.cond.wait(lock, [&] {return state.stop || index < nextToSink + maxBufferedRecords;});
+                return !state.stop;
+            },
+            [&tasks, &state, &transform, &finished](size_t index, RecordInput & record, uint32_t thread) {
+                RecordTask const & task = tasks[index];
+                EventInfo info {task.fileIndex, task.recordIndex, task.firstEvent, thread};
+                Results results;
+                uint32_t count = record.getEntries();
+                for (uint32_t i=0; i < count && !state.stop; i++) {
+                    info.eventIndex = task.firstEvent + i;
+                    auto result = transform(record.getEventView(i), info);
+                    if (result != nullptr) {
+                        results.emplace_back(std::move(result), info);
+                    }
+                }
+                state.eventCount += count;
+                {
+                    std::lock_guard<std::mutex> lock(state.mtx);
+                    finished[index] = std::move(results);
+                }
+                state.cond.notify_all();
+            });
+
+        try {
+            while (nextToSink < tasks.size()) {
+                Results results;
+                {
+                    std::unique_lock<std::mutex> lock(state.mtx);
+                    state.cond.wait(lock, [&] {return state.stop || finished.count(nextToSink) > 0;});
+                    if (state.stop) break;
+                    auto it = finished.find(nextToSink);
+                    results = std::move(it->second);
+                    finished.erase(it);
+                }
+
+                for (auto & r : results) {
+                    sink(r.first, r.second);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(state.mtx);
+                    nextToSink++;
+                }
+                state.cond.notify_all();
+            }
+        }
+        catch (...) {
+            state.setError(std::current_exception());
+        }
+
+        joinWorkers(workers, state);
+        return state.eventCount;
+    }
+
+}
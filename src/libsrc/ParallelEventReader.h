@@ -0,0 +1,107 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_PARALLELEVENTREADER_H
+#define EVIO_6_0_PARALLELEVENTREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    class RecordInput;
+
+
+    /**
+     * This class processes all the events of an evio version 6 file, or set of files,
+     * in parallel. Since a {@link Reader} is not thread-safe, whole records are handed
+     * out to worker threads instead, each of which has its own file stream and
+     * {@link RecordInput} to read and decompress them. The events of each record are
+     * passed, one by one, to a user's callback in that same thread.<p>
+     *
+     * The order in which events are handled is not defined by
+     * {@link #forEachEvent(std::vector<std::string> const &, uint32_t, EventHandler const &)}.
+     * For jobs which read, filter, and rewrite events, the
+     * {@link #forEachEvent(std::vector<std::string> const &, uint32_t, EventTransform const &, EventSink const &)}
+     * form transforms events in parallel and then hands each result, in the original order of the events,
+     * to a sink running in the calling thread. A reorder buffer holding the results of a limited
+     * number of records makes that possible.<p>
+     *
+     * Jobs which handle a whole record at a time, rather than event by event, can use
+     * {@link #forEachRecord(std::vector<std::string> const &, uint32_t, RecordHandler const &)}.<p>
+     *
+     * If a callback or reading a record throws an exception, all threads are stopped and
+     * that exception is rethrown to the caller.
+     *
+     * <pre><code>
+     *    ParallelEventReader::forEachEvent(files, 8,
+     *        [](ByteBufferView const & event, ParallelEventReader::EventInfo const & info) {
+     *            // analyze event
+     *        });
+     * </code></pre>
+     */
+    class ParallelEventReader {
+
+    public:
+
+        /** Where an event handed to a callback comes from. */
+        struct EventInfo {
+            /** Index into the list of files. */
+            uint32_t fileIndex;
+            /** Index of the event's record in its file. */
+            uint32_t recordIndex;
+            /** Index of the event in its file. */
+            uint64_t eventIndex;
+            /** Number of worker thread calling back, starting at 0. */
+            uint32_t threadNumber;
+        };
+
+        /** Callback handed each event, as a view valid only during the call, in a worker thread. */
+        typedef std::function<void(ByteBufferView const & event, EventInfo const & info)> EventHandler;
+
+        /** Callback handed each event, in a worker thread, returning its result or nullptr to drop it. */
+        typedef std::function<std::shared_ptr<ByteBuffer>(ByteBufferView const & event,
+                                                          EventInfo const & info)> EventTransform;
+
+        /** Callback handed each non-null result of an {@link EventTransform}, in event order, in the calling thread. */
+        typedef std::function<void(std::shared_ptr<ByteBuffer> & result, EventInfo const & info)> EventSink;
+
+        /**
+         * Callback handed each record read, valid only during the call, in a worker thread.
+         * The info's eventIndex is that of the record's first event.
+         */
+        typedef std::function<void(RecordInput & record, EventInfo const & info)> RecordHandler;
+
+        static uint64_t forEachEvent(std::vector<std::string> const & files, uint32_t threads,
+                                     EventHandler const & handler);
+
+        static uint64_t forEachRecord(std::vector<std::string> const & files, uint32_t threads,
+                                      RecordHandler const & handler);
+
+        static uint64_t forEachEvent(std::vector<std::string> const & files, uint32_t threads,
+                                     EventTransform const & transform, EventSink const & sink,
+                                     uint32_t maxBufferedRecords = 0);
+    };
+
+}
+
+
+#endif //EVIO_6_0_PARALLELEVENTREADER_H
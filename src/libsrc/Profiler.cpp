@@ -0,0 +1,119 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "Profiler.h"
+
+#include <sstream>
+#include <iomanip>
+
+
+namespace evio {
+
+
+    Profiler::Counter Profiler::counters[Profiler::STAGE_COUNT];
+
+
+    /**
+     * Add one call to a stage's counter.
+     * @param stage stage.
+     * @param nanos time the call took in nanoseconds.
+     */
+    void Profiler::add(Stage stage, uint64_t nanos) {
+        Counter & c = counters[stage];
+        c.calls.fetch_add(1, std::memory_order_relaxed);
+        c.nanos.fetch_add(nanos, std::memory_order_relaxed);
+
+        uint64_t max = c.maxNanos.load(std::memory_order_relaxed);
+        while (nanos > max && !c.maxNanos.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {}
+    }
+
+
+    /** Set all counters back to zero. */
+    void Profiler::reset() {
+        for (auto & c : counters) {
+            c.calls.store(0, std::memory_order_relaxed);
+            c.nanos.store(0, std::memory_order_relaxed);
+            c.maxNanos.store(0, std::memory_order_relaxed);
+        }
+    }
+
+
+    /**
+     * Get the number of calls of a stage.
+     * @param stage stage.
+     * @return number of calls.
+     */
+    uint64_t Profiler::getCalls(Stage stage) {return counters[stage].calls.load(std::memory_order_relaxed);}
+
+
+    /**
+     * Get the total time spent in a stage.
+     * @param stage stage.
+     * @return total time in nanoseconds.
+     */
+    uint64_t Profiler::getNanos(Stage stage) {return counters[stage].nanos.load(std::memory_order_relaxed);}
+
+
+    /**
+     * Get the time of the longest call of a stage.
+     * @param stage stage.
+     * @return time of longest call in nanoseconds.
+     */
+    uint64_t Profiler::getMaxNanos(Stage stage) {return counters[stage].maxNanos.load(std::memory_order_relaxed);}
+
+
+    /**
+     * Get the name of a stage.
+     * @param stage stage.
+     * @return name of stage.
+     */
+    const char * Profiler::getName(Stage stage) {
+        static const char * names[STAGE_COUNT] = {
+                "Reader::readRecord",
+                "RecordInput read i/o",
+                "RecordInput decompress",
+                "RecordOutput build copy",
+                "RecordOutput build compress",
+                "EventParser::parseEvent",
+                "EvioSwap",
+                "file write"
+        };
+        return (stage < STAGE_COUNT) ? names[stage] : "unknown";
+    }
+
+
+    /**
+     * Get a table of all stages with their calls, total, average and longest times.
+     * @return table of counters.
+     */
+    std::string Profiler::toString() {
+        std::stringstream ss;
+        if (!isEnabled()) {
+            ss << "evio profiling not compiled in (EVIO_PROFILE)" << std::endl;
+        }
+
+        ss << std::left << std::setw(28) << "stage" << std::right
+           << std::setw(12) << "calls" << std::setw(14) << "total ms"
+           << std::setw(12) << "avg ns" << std::setw(14) << "max ns" << std::endl;
+
+        for (int i=0; i < STAGE_COUNT; i++) {
+            auto stage = static_cast<Stage>(i);
+            uint64_t calls = getCalls(stage);
+            uint64_t nanos = getNanos(stage);
+            ss << std::left << std::setw(28) << getName(stage) << std::right
+               << std::setw(12) << calls
+               << std::setw(14) << std::fixed << std::setprecision(3) << nanos/1.e6
+               << std::setw(12) << (calls > 0 ? nanos/calls : 0)
+               << std::setw(14) << getMaxNanos(stage) << std::endl;
+        }
+        return ss.str();
+    }
+
+}
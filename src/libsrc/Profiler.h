@@ -0,0 +1,174 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_PROFILER_H
+#define EVIO_6_0_PROFILER_H
+
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <chrono>
+
+
+#ifdef EVIO_USE_TRACY
+    #include <tracy/Tracy.hpp>
+#endif
+
+
+namespace evio {
+
+
+    /**
+     * This class keeps nanosecond-timed counters of the main stages of reading and writing,
+     * so it's easy to see which stage got slower from one version to the next.
+     * Each stage counts calls, total time and the longest call. Counters are global,
+     * shared by all threads, and updated with relaxed atomics.<p>
+     *
+     * Stages are timed by the EVIO_PROFILE_* macros placed in the code. They compile to
+     * nothing unless EVIO_PROFILE is defined, which the cmake option of the same name does,
+     * so there's no cost otherwise.
+     * If EVIO_USE_TRACY is also defined, each timed stage is also a Tracy zone.
+     *
+     * <pre><code>
+     *    Profiler::reset();
+     *    ... read a file ...
+     *    std::cout << Profiler::toString();
+     * </code></pre>
+     */
+    class Profiler {
+
+    public:
+
+        /** Stages timed. */
+        enum Stage {
+            /** Reader::readRecord, finding and reading one record. */
+            READER_READ_RECORD = 0,
+            /** RecordInput::readRecord, reading a record from file. */
+            RECORD_READ_IO,
+            /** RecordInput::readRecord, decompressing or copying a record's data. */
+            RECORD_DECOMPRESS,
+            /** RecordOutput::build, copying index and events into place. */
+            RECORD_BUILD_COPY,
+            /** RecordOutput::build, compressing. */
+            RECORD_BUILD_COMPRESS,
+            /** EventParser::parseEvent, making an event's tree of structures. */
+            EVENT_PARSE,
+            /** EvioSwap, swapping an event or structure. */
+            SWAP,
+            /** Writing a record to file. */
+            FILE_WRITE,
+            /** Number of stages. */
+            STAGE_COUNT
+        };
+
+
+        /** Measures the time until it's stopped or goes out of scope. */
+        class Scope {
+            Stage stage;
+            std::chrono::steady_clock::time_point start;
+            bool running;
+
+        public:
+
+            /**
+             * @param s        stage being timed.
+             * @param startNow if false, don't start timing until {@link #begin()} is called.
+             */
+            explicit Scope(Stage s, bool startNow = true) : stage(s), running(startNow) {
+                if (startNow) start = std::chrono::steady_clock::now();
+            }
+            ~Scope() {stop();}
+
+            /** Start, or start over, timing. */
+            void begin() {
+                running = true;
+                start = std::chrono::steady_clock::now();
+            }
+
+            /** Stop timing and add the time to the stage's counter. */
+            void stop() {
+                if (!running) return;
+                running = false;
+                auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start).count();
+                add(stage, (uint64_t)nanos);
+            }
+        };
+
+    private:
+
+        /** Counter of one stage. */
+        struct Counter {
+            std::atomic<uint64_t> calls {0};
+            std::atomic<uint64_t> nanos {0};
+            std::atomic<uint64_t> maxNanos {0};
+        };
+
+        /** Counters of all stages. */
+        static Counter counters[STAGE_COUNT];
+
+    public:
+
+        static void add(Stage stage, uint64_t nanos);
+        static void reset();
+
+        static uint64_t getCalls(Stage stage);
+        static uint64_t getNanos(Stage stage);
+        static uint64_t getMaxNanos(Stage stage);
+        static const char * getName(Stage stage);
+
+        /** @return true if the library was compiled with profiling on. */
+        static bool isEnabled() {
+#ifdef EVIO_PROFILE
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        static std::string toString();
+    };
+
+}
+
+
+#define EVIO_PROFILE_CONCAT2(a, b) a##b
+#define EVIO_PROFILE_CONCAT(a, b) EVIO_PROFILE_CONCAT2(a, b)
+
+#ifdef EVIO_USE_TRACY
+    #define EVIO_PROFILE_ZONE(stage) ZoneScopedN(#stage)
+#else
+    #define EVIO_PROFILE_ZONE(stage)
+#endif
+
+#ifdef EVIO_PROFILE
+    /** Time the rest of the enclosing block as the given Profiler::Stage. */
+    #define EVIO_PROFILE_SCOPE(stage) \
+        evio::Profiler::Scope EVIO_PROFILE_CONCAT(evioProfileScope, __LINE__)(evio::Profiler::stage); \
+        EVIO_PROFILE_ZONE(stage)
+    /** Start timing a stretch of code, named so it can be ended before the end of the block. */
+    #define EVIO_PROFILE_BEGIN(name, stage) evio::Profiler::Scope name(evio::Profiler::stage)
+    /** Stop timing a stretch of code started by EVIO_PROFILE_BEGIN. */
+    #define EVIO_PROFILE_END(name) name.stop()
+    /** Declare a timer without starting it, for code whose stretches can't each be a block. */
+    #define EVIO_PROFILE_DECLARE(name, stage) evio::Profiler::Scope name(evio::Profiler::stage, false)
+    /** Start a declared timer. */
+    #define EVIO_PROFILE_START(name) name.begin()
+#else
+    #define EVIO_PROFILE_SCOPE(stage)
+    #define EVIO_PROFILE_BEGIN(name, stage)
+    #define EVIO_PROFILE_END(name)
+    #define EVIO_PROFILE_DECLARE(name, stage)
+    #define EVIO_PROFILE_START(name)
+#endif
+
+
+#endif //EVIO_6_0_PROFILER_H
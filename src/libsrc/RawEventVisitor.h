@@ -0,0 +1,367 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RAWEVENTVISITOR_H
+#define EVIO_6_0_RAWEVENTVISITOR_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+#include "ByteOrder.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "DataType.h"
+#include "StructureType.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * Description of one bank, segment, or tagsegment found by {@link RawEventVisitor}
+     * in raw evio data. It only points into that data and is only valid during the
+     * call it's handed to.
+     */
+    class RawStructure {
+
+        friend class RawEventVisitor;
+
+    private:
+
+        /** Start of header. */
+        const uint8_t *start = nullptr;
+
+        /** Byte order of data. */
+        ByteOrder const *byteOrder = &ByteOrder::ENDIAN_LOCAL;
+
+        /** Number of bytes of header and data, padding included. */
+        uint32_t totalBytes = 0;
+
+        /** Number of bytes of header. */
+        uint32_t headerBytes = 0;
+
+        /** Tag. */
+        uint16_t tag = 0;
+
+        /** Num, 0 for segments and tagsegments. */
+        uint8_t num = 0;
+
+        /** Type of data, as in the header. */
+        uint8_t dataType = 0;
+
+        /** Number of bytes of padding at the end of data. */
+        uint8_t padding = 0;
+
+        /** Bank, segment, or tagsegment. */
+        StructureType const *structureType = &StructureType::STRUCT_BANK;
+
+        /** Number of levels below the structure the walk started at. */
+        uint32_t depth = 0;
+
+    public:
+
+        /** @return bank, segment, or tagsegment. */
+        StructureType const & getStructureType() const {return *structureType;}
+        /** @return true if this is a bank. */
+        bool isBank()       const {return structureType == &StructureType::STRUCT_BANK;}
+        /** @return true if this is a segment. */
+        bool isSegment()    const {return structureType == &StructureType::STRUCT_SEGMENT;}
+        /** @return true if this is a tagsegment. */
+        bool isTagSegment() const {return structureType == &StructureType::STRUCT_TAGSEGMENT;}
+
+        /** @return tag. */
+        uint16_t getTag()   const {return tag;}
+        /** @return num, which only banks have, else 0. */
+        uint8_t  getNum()   const {return num;}
+
+        /** @return type of data as the value in the header. */
+        uint32_t getDataTypeValue()       const {return dataType;}
+        /** @return type of data. */
+        DataType const & getDataType()    const {return DataType::getDataType(dataType);}
+        /** @return true if this holds banks, segments, or tagsegments. */
+        bool isContainer()                const {return DataType::isStructure(dataType);}
+
+        /** @return number of bytes of padding at the end of the data. */
+        uint32_t getPadding()             const {return padding;}
+        /** @return number of levels below the structure the walk started at, 0 for that one. */
+        uint32_t getDepth()               const {return depth;}
+
+        /** @return byte order of the data. */
+        ByteOrder const & order()         const {return *byteOrder;}
+        /** @return pointer to the first byte of the header. */
+        const uint8_t * getHeader()       const {return start;}
+        /** @return number of bytes of header. */
+        uint32_t getHeaderBytes()         const {return headerBytes;}
+        /** @return number of bytes of header and data, padding included. */
+        uint32_t getTotalBytes()          const {return totalBytes;}
+
+        /** @return pointer to the first byte of data. */
+        const uint8_t * data()            const {return start + headerBytes;}
+        /** @return number of bytes of data, padding excluded. */
+        uint32_t getDataBytes()           const {return totalBytes - headerBytes - padding;}
+
+        /** @return view of the data's bytes, padding excluded. */
+        ByteBufferView view() const {return ByteBufferView(data(), getDataBytes(), *byteOrder);}
+
+        /**
+         * Get a view of the data as values of type T, swapped only as they're read.
+         * The type is not checked against {@link #getDataType()}.
+         * @tparam T int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t, float or double.
+         * @return typed view of the data.
+         */
+        template<typename T> TypedView<T> as() const {
+            return TypedView<T>(data(), getDataBytes() / sizeof(T), *byteOrder);
+        }
+    };
+
+
+    /**
+     * This class walks raw evio data, an event or any structure in it, without creating
+     * headers, structures, or nodes the way {@link EventParser} and {@link EvioCompactReader}
+     * do. It reads each header in place just as {@link EventHeaderParser} does and calls the
+     * given callables, which the compiler can inline since they are template parameters,
+     * on entering and leaving each bank, segment, and tagsegment, depth first.
+     * Nothing at all is allocated, which makes it the fastest way to write a decoder:
+     * <pre>
+     *   uint64_t sum = 0;
+     *   RawEventVisitor::visit(eventBytes, eventLength, order,
+     *       [&sum](RawStructure const & s) {
+     *           if (s.getDataType() == DataType::UINT32) {
+     *               auto vals = s.as&lt;uint32_t&gt;();
+     *               for (size_t i=0; i &lt; vals.size(); i++) sum += vals[i];
+     *           }
+     *       });
+     * </pre>
+     *
+     * If the enter callable returns bool, returning false skips the children of that
+     * structure. The leave callable is called for every structure entered, after its
+     * children, so calls always pair up.
+     */
+    class RawEventVisitor {
+
+    public:
+
+        /** Default leave callable, which does nothing. */
+        struct NoOp {
+            void operator()(RawStructure const &) const {}
+        };
+
+        /** Nesting of structures deeper than this is taken as bad data. */
+        static const uint32_t MAX_DEPTH = 1000;
+
+
+        /**
+         * Walk an event, which is a bank.
+         *
+         * @param event  pointer to the event's bank header.
+         * @param length number of bytes available, at least the event's length.
+         * @param order  byte order of data.
+         * @param enter  called with each structure on entering it.
+         * @param leave  called with each structure on leaving it.
+         * @throws EvioException if data is not in evio format.
+         */
+        template<typename Enter, typename Leave = NoOp>
+        static void visit(const uint8_t *event, size_t length, ByteOrder const & order,
+                          Enter && enter, Leave && leave = Leave()) {
+            visit(StructureType::STRUCT_BANK, event, length, order,
+                  std::forward<Enter>(enter), std::forward<Leave>(leave));
+        }
+
+
+        /**
+         * Walk an event, which is a bank, viewed from its first byte.
+         *
+         * @param event view of the event, in its byte order.
+         * @param enter called with each structure on entering it.
+         * @param leave called with each structure on leaving it.
+         * @throws EvioException if data is not in evio format.
+         */
+        template<typename Enter, typename Leave = NoOp>
+        static void visit(ByteBufferView const & event, Enter && enter, Leave && leave = Leave()) {
+            visit(StructureType::STRUCT_BANK, event.data(), event.size(), event.order(),
+                  std::forward<Enter>(enter), std::forward<Leave>(leave));
+        }
+
+
+        /**
+         * Walk an event, which is a bank, starting at a buffer's position.
+         *
+         * @param buf   buffer holding the event from its position on.
+         * @param enter called with each structure on entering it.
+         * @param leave called with each structure on leaving it.
+         * @throws EvioException if data is not in evio format.
+         */
+        template<typename Enter, typename Leave = NoOp>
+        static void visit(ByteBuffer const & buf, Enter && enter, Leave && leave = Leave()) {
+            visit(StructureType::STRUCT_BANK, buf.array() + buf.arrayOffset() + buf.position(),
+                  buf.remaining(), buf.order(), std::forward<Enter>(enter), std::forward<Leave>(leave));
+        }
+
+
+        /**
+         * Walk any structure.
+         *
+         * @param type   type of the structure at data.
+         * @param data   pointer to the structure's header.
+         * @param length number of bytes available, at least the structure's length.
+         * @param order  byte order of data.
+         * @param enter  called with each structure on entering it.
+         * @param leave  called with each structure on leaving it.
+         * @throws EvioException if data is not in evio format or type is STRUCT_UNKNOWN32.
+         */
+        template<typename Enter, typename Leave = NoOp>
+        static void visit(StructureType const & type, const uint8_t *data, size_t length,
+                          ByteOrder const & order, Enter && enter, Leave && leave = Leave()) {
+            if (data == nullptr) {
+                throw EvioException("null data");
+            }
+            walk(type, data, data + length, order, 0, enter, leave);
+        }
+
+
+    private:
+
+
+        /** Read a 32 bit word, swapping if not in the local byte order. */
+        static uint32_t readWord(const uint8_t *p, bool swap) {
+            uint32_t word;
+            std::memcpy(&word, p, 4);
+            return swap ? SWAP_32(word) : word;
+        }
+
+
+        /**
+         * Read the header of a structure, just as in {@link EventHeaderParser}.
+         * @return number of bytes of structure, header included.
+         */
+        static uint32_t readHeader(StructureType const & type, const uint8_t *p, const uint8_t *end,
+                                   ByteOrder const & order, uint32_t depth, RawStructure & s) {
+
+            bool swap = !order.isLocalEndian();
+            size_t available = end - p;
+            uint32_t words;
+
+            s.start = p;
+            s.byteOrder = &order;
+            s.depth = depth;
+
+            if (type == StructureType::STRUCT_BANK) {
+                if (available < 8) {
+                    throw EvioException("bank header extends past its container");
+                }
+                uint32_t len  = readWord(p, swap);
+                uint32_t word = readWord(p + 4, swap);
+                uint32_t dt   = (word >> 8) & 0xff;
+                s.structureType = &StructureType::STRUCT_BANK;
+                s.headerBytes = 8;
+                s.tag = word >> 16;
+                s.num = word & 0xff;
+                s.dataType = dt & 0x3f;
+                s.padding  = dt >> 6;
+                words = len;
+                if (len < 1 || len > (available / 4) - 1) {
+                    throw EvioException("bank length of " + std::to_string(len) +
+                                        " words is bad or extends past its container");
+                }
+            }
+            else {
+                if (available < 4) {
+                    throw EvioException("header extends past its container");
+                }
+                uint32_t word = readWord(p, swap);
+                words = word & 0xffff;
+                s.headerBytes = 4;
+                s.num = 0;
+                if (type == StructureType::STRUCT_SEGMENT) {
+                    uint32_t dt = (word >> 16) & 0xff;
+                    s.structureType = &StructureType::STRUCT_SEGMENT;
+                    s.tag = word >> 24;
+                    s.dataType = dt & 0x3f;
+                    s.padding  = dt >> 6;
+                }
+                else if (type == StructureType::STRUCT_TAGSEGMENT) {
+                    s.structureType = &StructureType::STRUCT_TAGSEGMENT;
+                    s.tag = word >> 20;
+                    s.dataType = (word >> 16) & 0xf;
+                    s.padding  = 0;
+                }
+                else {
+                    throw EvioException("unknown structure type");
+                }
+                if (words > (available / 4) - 1) {
+                    throw EvioException("length of " + std::to_string(words) +
+                                        " words extends past its container");
+                }
+            }
+
+            s.totalBytes = 4 * (words + 1);
+            if (s.padding > s.totalBytes - s.headerBytes) {
+                throw EvioException("padding larger than data");
+            }
+            return s.totalBytes;
+        }
+
+
+        /** Type of structure a container holds. */
+        static StructureType const & childType(uint32_t dataType) {
+            if (DataType::isBank(dataType))    return StructureType::STRUCT_BANK;
+            if (DataType::isSegment(dataType)) return StructureType::STRUCT_SEGMENT;
+            return StructureType::STRUCT_TAGSEGMENT;
+        }
+
+
+        /**
+         * Visit the structure at p and, recursively, its children.
+         * @return number of bytes of structure, header included.
+         */
+        template<typename Enter, typename Leave>
+        static uint32_t walk(StructureType const & type, const uint8_t *p, const uint8_t *end,
+                             ByteOrder const & order, uint32_t depth, Enter & enter, Leave & leave) {
+
+            if (depth > MAX_DEPTH) {
+                throw EvioException("structures nested over " + std::to_string(MAX_DEPTH) + " deep");
+            }
+
+            RawStructure s;
+            uint32_t bytes = readHeader(type, p, end, order, depth, s);
+
+            bool descend = true;
+            if constexpr (std::is_same<decltype(enter(s)), bool>::value) {
+                descend = enter(s);
+            }
+            else {
+                enter(s);
+            }
+
+            if (descend && s.isContainer()) {
+                StructureType const & kidType = childType(s.dataType);
+                const uint8_t *kid = s.data();
+                const uint8_t *kidsEnd = p + bytes;
+                while (kid < kidsEnd) {
+                    kid += walk(kidType, kid, kidsEnd, order, depth + 1, enter, leave);
+                }
+            }
+
+            leave(s);
+            return bytes;
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_RAWEVENTVISITOR_H
@@ -0,0 +1,559 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "RdmaConnection.h"
+
+
+#ifdef USE_RDMA
+
+
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+namespace evio {
+
+
+    /** Times a completion queue is polled before blocking on its channel. */
+    static const int SPIN_POLLS = 4096;
+
+    /** Max bytes of data sent inline with a work request. */
+    static const uint32_t MAX_INLINE_BYTES = 64;
+
+
+    /** Put a 16, 32, or 64 bit value into a byte array, big endian. */
+    template<typename T> static uint8_t * putBig(uint8_t *p, T val) {
+        for (int i = sizeof(T) - 1; i >= 0; i--) {
+            *p++ = (uint8_t)(val >> (8*i));
+        }
+        return p;
+    }
+
+    /** Get a 16, 32, or 64 bit big endian value from a byte array. */
+    template<typename T> static const uint8_t * getBig(const uint8_t *p, T & val) {
+        val = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            val = (T)((val << 8) | *p++);
+        }
+        return p;
+    }
+
+
+    /**
+     * Constructor which opens an RDMA device and creates an RC queue pair on it,
+     * ready to have receives posted but not yet connected.
+     *
+     * @param device    name of device (see ibv_devices), or empty for the first one found.
+     * @param ibPort    port of device, starting at 1.
+     * @param gidIndex  index of port's global id to use, which RoCE needs.
+     *                  Use -1 on InfiniBand to address by local id alone.
+     * @param sendDepth max number of send work requests outstanding.
+     * @param recvDepth max number of receive work requests outstanding.
+     * @throws EvioException if no device is found or any verbs object cannot be created.
+     */
+    RdmaConnection::RdmaConnection(std::string const & device, uint8_t ibPort, int gidIndex,
+                                   uint32_t sendDepth, uint32_t recvDepth) :
+            ibPort(ibPort), gidIndex(gidIndex) {
+
+        int count = 0;
+        ibv_device **list = ibv_get_device_list(&count);
+        if (list == nullptr || count < 1) {
+            if (list != nullptr) ibv_free_device_list(list);
+            throw EvioException("no RDMA devices found");
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (device.empty() || device == ibv_get_device_name(list[i])) {
+                context = ibv_open_device(list[i]);
+                break;
+            }
+        }
+        ibv_free_device_list(list);
+
+        if (context == nullptr) {
+            throw EvioException("cannot open RDMA device " + (device.empty() ? std::string("") : device));
+        }
+
+        try {
+            ibv_device_attr devAttr {};
+            ibv_port_attr portAttr {};
+            if (ibv_query_device(context, &devAttr) != 0 ||
+                ibv_query_port(context, ibPort, &portAttr) != 0) {
+                throw EvioException("cannot query RDMA device port " + std::to_string(ibPort));
+            }
+            if (portAttr.state != IBV_PORT_ACTIVE) {
+                throw EvioException("RDMA device port " + std::to_string(ibPort) + " is not active");
+            }
+
+            mtu = portAttr.active_mtu;
+            lid = portAttr.lid;
+            if (gidIndex >= 0) {
+                if (ibv_query_gid(context, ibPort, gidIndex, &gid) != 0) {
+                    throw EvioException("cannot get RDMA gid " + std::to_string(gidIndex));
+                }
+            }
+            else if (portAttr.link_layer == IBV_LINK_LAYER_ETHERNET) {
+                throw EvioException("RoCE needs a gid index");
+            }
+
+            auto maxWr = (uint32_t) devAttr.max_qp_wr;
+            sendDepth = std::max(1U, std::min(sendDepth, maxWr));
+            recvDepth = std::max(1U, std::min(recvDepth, maxWr));
+
+            pd = ibv_alloc_pd(context);
+            sendChannel = ibv_create_comp_channel(context);
+            recvChannel = ibv_create_comp_channel(context);
+            if (pd == nullptr || sendChannel == nullptr || recvChannel == nullptr) {
+                throw EvioException("cannot create RDMA protection domain or channels");
+            }
+
+            sendCq = ibv_create_cq(context, sendDepth, nullptr, sendChannel, 0);
+            recvCq = ibv_create_cq(context, recvDepth, nullptr, recvChannel, 0);
+            if (sendCq == nullptr || recvCq == nullptr) {
+                throw EvioException("cannot create RDMA completion queues");
+            }
+
+            ibv_qp_init_attr init {};
+            init.send_cq = sendCq;
+            init.recv_cq = recvCq;
+            init.qp_type = IBV_QPT_RC;
+            init.sq_sig_all = 1;
+            init.cap.max_send_wr  = sendDepth;
+            init.cap.max_recv_wr  = recvDepth;
+            init.cap.max_send_sge = 1;
+            init.cap.max_recv_sge = 1;
+            init.cap.max_inline_data = MAX_INLINE_BYTES;
+
+            qp = ibv_create_qp(pd, &init);
+            if (qp == nullptr) {
+                throw EvioException(std::string("cannot create RDMA queue pair, ") + std::strerror(errno));
+            }
+            this->sendDepth = init.cap.max_send_wr;
+            this->recvDepth = init.cap.max_recv_wr;
+
+            ibv_qp_attr attr {};
+            attr.qp_state = IBV_QPS_INIT;
+            attr.pkey_index = 0;
+            attr.port_num = ibPort;
+            attr.qp_access_flags = IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE;
+            if (ibv_modify_qp(qp, &attr, IBV_QP_STATE | IBV_QP_PKEY_INDEX |
+                                         IBV_QP_PORT  | IBV_QP_ACCESS_FLAGS) != 0) {
+                throw EvioException("cannot move RDMA queue pair to init");
+            }
+
+            std::random_device rd;
+            packetSequence = rd() & 0xffffff;
+        }
+        catch (EvioException & e) {
+            release();
+            throw;
+        }
+    }
+
+
+    /** Destructor which frees all verbs objects. */
+    RdmaConnection::~RdmaConnection() {release();}
+
+
+    /** Free all verbs objects. */
+    void RdmaConnection::release() {
+        if (qp != nullptr)          {ibv_destroy_qp(qp); qp = nullptr;}
+        if (sendCq != nullptr)      {ibv_destroy_cq(sendCq); sendCq = nullptr;}
+        if (recvCq != nullptr)      {ibv_destroy_cq(recvCq); recvCq = nullptr;}
+        if (sendChannel != nullptr) {ibv_destroy_comp_channel(sendChannel); sendChannel = nullptr;}
+        if (recvChannel != nullptr) {ibv_destroy_comp_channel(recvChannel); recvChannel = nullptr;}
+        if (pd != nullptr)          {ibv_dealloc_pd(pd); pd = nullptr;}
+        if (context != nullptr)     {ibv_close_device(context); context = nullptr;}
+    }
+
+
+    /**
+     * Register memory so it can be the source or target of RDMA.
+     * The memory is pinned until deregistered and must stay allocated until then.
+     *
+     * @param address     start of memory.
+     * @param bytes       number of bytes.
+     * @param remoteWrite if true, the other end may write into it.
+     * @return memory region, to be given to {@link #deregisterMemory(ibv_mr *)}.
+     * @throws EvioException if memory cannot be registered.
+     */
+    ibv_mr * RdmaConnection::registerMemory(void *address, size_t bytes, bool remoteWrite) {
+        int access = IBV_ACCESS_LOCAL_WRITE;
+        if (remoteWrite) access |= IBV_ACCESS_REMOTE_WRITE;
+
+        ibv_mr *mr = ibv_reg_mr(pd, address, bytes, access);
+        if (mr == nullptr) {
+            throw EvioException("cannot register " + std::to_string(bytes) + " bytes for RDMA, " +
+                                std::strerror(errno));
+        }
+        return mr;
+    }
+
+
+    /**
+     * Deregister memory registered by {@link #registerMemory(void *, size_t, bool)}.
+     * @param mr memory region, may be null.
+     */
+    void RdmaConnection::deregisterMemory(ibv_mr *mr) {
+        if (mr != nullptr) ibv_dereg_mr(mr);
+    }
+
+
+    /**
+     * Get what to tell the other end about this one.
+     * @param address   address of memory the other end may write into.
+     * @param rkey      remote key of that memory.
+     * @param slotCount number of record slots at address, 0 if not a reader.
+     * @param slotBytes bytes in each record slot, 0 if not a reader.
+     * @return this end's endpoint.
+     */
+    RdmaConnection::Endpoint RdmaConnection::localEndpoint(uint64_t address, uint32_t rkey,
+                                                           uint32_t slotCount, uint32_t slotBytes) const {
+        Endpoint ep;
+        ep.qpNumber = qp->qp_num;
+        ep.packetSequence = packetSequence;
+        ep.lid = lid;
+        std::memcpy(ep.gid, gid.raw, 16);
+        ep.address = address;
+        ep.rkey = rkey;
+        ep.slotCount = slotCount;
+        ep.slotBytes = slotBytes;
+        ep.mtu = mtu;
+        return ep;
+    }
+
+
+    /**
+     * Send this end's endpoint over a connected TCP socket and receive the other's.
+     * Values are sent big endian so hosts of either byte order can talk.
+     *
+     * @param sock   connected TCP socket.
+     * @param local  this end's endpoint.
+     * @param remote filled with the other end's endpoint.
+     * @throws EvioException if error sending or receiving.
+     */
+    void RdmaConnection::exchange(int sock, Endpoint const & local, Endpoint & remote) {
+        uint8_t out[ENDPOINT_BYTES], in[ENDPOINT_BYTES];
+
+        uint8_t *p = out;
+        p = putBig(p, local.qpNumber);
+        p = putBig(p, local.packetSequence);
+        p = putBig(p, local.lid);
+        std::memcpy(p, local.gid, 16); p += 16;
+        p = putBig(p, local.address);
+        p = putBig(p, local.rkey);
+        p = putBig(p, local.slotCount);
+        p = putBig(p, local.slotBytes);
+        putBig(p, local.mtu);
+
+        sendAll(sock, out, ENDPOINT_BYTES);
+        receiveAll(sock, in, ENDPOINT_BYTES, false);
+
+        const uint8_t *q = in;
+        q = getBig(q, remote.qpNumber);
+        q = getBig(q, remote.packetSequence);
+        q = getBig(q, remote.lid);
+        std::memcpy(remote.gid, q, 16); q += 16;
+        q = getBig(q, remote.address);
+        q = getBig(q, remote.rkey);
+        q = getBig(q, remote.slotCount);
+        q = getBig(q, remote.slotBytes);
+        getBig(q, remote.mtu);
+    }
+
+
+    /**
+     * Connect the queue pair to the other end's, moving it through ready-to-receive
+     * to ready-to-send.
+     * @param remote the other end's endpoint.
+     * @throws EvioException if the queue pair cannot be connected.
+     */
+    void RdmaConnection::connect(Endpoint const & remote) {
+        ibv_qp_attr attr {};
+        attr.qp_state = IBV_QPS_RTR;
+        attr.path_mtu = std::min(mtu, (ibv_mtu) remote.mtu);
+        attr.dest_qp_num = remote.qpNumber;
+        attr.rq_psn = remote.packetSequence;
+        attr.max_dest_rd_atomic = 1;
+        attr.min_rnr_timer = 12;
+        attr.ah_attr.dlid = remote.lid;
+        attr.ah_attr.sl = 0;
+        attr.ah_attr.src_path_bits = 0;
+        attr.ah_attr.port_num = ibPort;
+        if (gidIndex >= 0) {
+            attr.ah_attr.is_global = 1;
+            std::memcpy(attr.ah_attr.grh.dgid.raw, remote.gid, 16);
+            attr.ah_attr.grh.sgid_index = gidIndex;
+            attr.ah_attr.grh.hop_limit = 64;
+        }
+
+        if (ibv_modify_qp(qp, &attr, IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU |
+                                     IBV_QP_DEST_QPN | IBV_QP_RQ_PSN |
+                                     IBV_QP_MAX_DEST_RD_ATOMIC | IBV_QP_MIN_RNR_TIMER) != 0) {
+            throw EvioException("cannot move RDMA queue pair to ready-to-receive");
+        }
+
+        attr = {};
+        attr.qp_state = IBV_QPS_RTS;
+        attr.timeout = 14;
+        attr.retry_cnt = 7;
+        attr.rnr_retry = 7;
+        attr.sq_psn = packetSequence;
+        attr.max_rd_atomic = 1;
+
+        if (ibv_modify_qp(qp, &attr, IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT |
+                                     IBV_QP_RNR_RETRY | IBV_QP_SQ_PSN | IBV_QP_MAX_QP_RD_ATOMIC) != 0) {
+            throw EvioException("cannot move RDMA queue pair to ready-to-send");
+        }
+    }
+
+
+    /**
+     * Post an RDMA write which also consumes one of the other end's receives,
+     * handing it the immediate value.
+     *
+     * @param source        data to write.
+     * @param bytes         number of bytes.
+     * @param lkey          local key of the memory region holding source.
+     * @param remoteAddress where to write at the other end.
+     * @param rkey          remote key of that memory.
+     * @param imm           value given to the other end's receive.
+     * @throws EvioException if the work request cannot be posted.
+     */
+    void RdmaConnection::postWriteWithImm(const void *source, uint32_t bytes, uint32_t lkey,
+                                          uint64_t remoteAddress, uint32_t rkey, uint32_t imm) {
+        ibv_sge sge {};
+        sge.addr = reinterpret_cast<uintptr_t>(source);
+        sge.length = bytes;
+        sge.lkey = lkey;
+
+        ibv_send_wr wr {}, *bad = nullptr;
+        wr.sg_list = &sge;
+        wr.num_sge = 1;
+        wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
+        wr.send_flags = IBV_SEND_SIGNALED;
+        wr.imm_data = htonl(imm);
+        wr.wr.rdma.remote_addr = remoteAddress;
+        wr.wr.rdma.rkey = rkey;
+
+        int err = ibv_post_send(qp, &wr, &bad);
+        if (err != 0) {
+            throw EvioException(std::string("cannot post RDMA write, ") + std::strerror(err));
+        }
+    }
+
+
+    /**
+     * Post an RDMA write of a few bytes which are copied when posted, so the source
+     * need not be registered or kept.
+     *
+     * @param source        data to write, at most 64 bytes.
+     * @param bytes         number of bytes.
+     * @param remoteAddress where to write at the other end.
+     * @param rkey          remote key of that memory.
+     * @throws EvioException if the work request cannot be posted.
+     */
+    void RdmaConnection::postWriteInline(const void *source, uint32_t bytes,
+                                         uint64_t remoteAddress, uint32_t rkey) {
+        ibv_sge sge {};
+        sge.addr = reinterpret_cast<uintptr_t>(source);
+        sge.length = bytes;
+
+        ibv_send_wr wr {}, *bad = nullptr;
+        wr.sg_list = &sge;
+        wr.num_sge = 1;
+        wr.opcode = IBV_WR_RDMA_WRITE;
+        wr.send_flags = IBV_SEND_SIGNALED | IBV_SEND_INLINE;
+        wr.wr.rdma.remote_addr = remoteAddress;
+        wr.wr.rdma.rkey = rkey;
+
+        int err = ibv_post_send(qp, &wr, &bad);
+        if (err != 0) {
+            throw EvioException(std::string("cannot post RDMA write, ") + std::strerror(err));
+        }
+    }
+
+
+    /**
+     * Post a receive with no buffer, to be consumed by the other end's write with immediate.
+     * @param id id returned in its completion.
+     * @throws EvioException if the work request cannot be posted.
+     */
+    void RdmaConnection::postReceive(uint64_t id) {
+        ibv_recv_wr wr {}, *bad = nullptr;
+        wr.wr_id = id;
+        wr.sg_list = nullptr;
+        wr.num_sge = 0;
+
+        int err = ibv_post_recv(qp, &wr, &bad);
+        if (err != 0) {
+            throw EvioException(std::string("cannot post RDMA receive, ") + std::strerror(err));
+        }
+    }
+
+
+    /**
+     * Get completions of sends.
+     * @param wc    array of completions to fill.
+     * @param max   max number of completions.
+     * @param block if true, wait for at least one.
+     * @param sock  if >= 0, TCP socket to the other end, watched while waiting.
+     * @return number of completions, or -1 if the other end closed its socket with none waiting.
+     * @throws EvioException if a work request failed.
+     */
+    int RdmaConnection::pollSend(ibv_wc *wc, int max, bool block, int sock) {
+        return poll(sendCq, sendChannel, wc, max, block, sock);
+    }
+
+
+    /**
+     * Get completions of receives.
+     * @param wc    array of completions to fill.
+     * @param max   max number of completions.
+     * @param block if true, wait for at least one.
+     * @param sock  if >= 0, TCP socket to the other end, watched while waiting.
+     * @return number of completions, or -1 if the other end closed its socket with none waiting.
+     * @throws EvioException if a work request failed.
+     */
+    int RdmaConnection::pollRecv(ibv_wc *wc, int max, bool block, int sock) {
+        return poll(recvCq, recvChannel, wc, max, block, sock);
+    }
+
+
+    /**
+     * Get completions from a queue, spinning a while and then sleeping on its channel if
+     * blocking. If a socket is given, its closing by the other end ends the wait.
+     */
+    int RdmaConnection::poll(ibv_cq *cq, ibv_comp_channel *channel, ibv_wc *wc, int max,
+                             bool block, int sock) {
+        int spins = 0;
+        bool peerClosed = false;
+
+        while (true) {
+            int n = ibv_poll_cq(cq, max, wc);
+            if (n < 0) {
+                throw EvioException("cannot poll RDMA completion queue");
+            }
+            if (n > 0) {
+                for (int i = 0; i < n; i++) {
+                    if (wc[i].status != IBV_WC_SUCCESS) {
+                        throw EvioException(std::string("RDMA work request failed, ") +
+                                            ibv_wc_status_str(wc[i].status));
+                    }
+                }
+                return n;
+            }
+            if (!block) return 0;
+            if (peerClosed) return -1;
+            if (++spins < SPIN_POLLS) continue;
+
+            // Ask to be told of the next completion, then look once more before sleeping
+            if (ibv_req_notify_cq(cq, 0) != 0) {
+                throw EvioException("cannot arm RDMA completion queue");
+            }
+            n = ibv_poll_cq(cq, max, wc);
+            if (n != 0) continue;
+
+            struct pollfd fds[2];
+            fds[0].fd = channel->fd;
+            fds[0].events = POLLIN;
+            fds[1].fd = sock;
+            fds[1].events = POLLIN;
+            int nfds = (sock >= 0) ? 2 : 1;
+
+            if (::poll(fds, nfds, 1000) < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error waiting for RDMA completion, ") + std::strerror(errno));
+            }
+
+            if (fds[0].revents & POLLIN) {
+                ibv_cq *evCq;
+                void *evContext;
+                if (ibv_get_cq_event(channel, &evCq, &evContext) == 0) {
+                    ibv_ack_cq_events(evCq, 1);
+                }
+            }
+
+            if (nfds > 1 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                // Nothing more is sent over TCP once connected, so this is the other end leaving
+                uint8_t discard[64];
+                ssize_t got = ::recv(sock, discard, sizeof(discard), MSG_DONTWAIT);
+                if (got <= 0 && !(got < 0 && (errno == EAGAIN || errno == EINTR))) {
+                    // Take any completions which came before it left
+                    peerClosed = true;
+                }
+            }
+        }
+    }
+
+
+    /**
+     * Send bytes over a TCP socket.
+     * @param sock  connected socket.
+     * @param data  bytes to send.
+     * @param bytes number of bytes.
+     * @throws EvioException if error writing.
+     */
+    void RdmaConnection::sendAll(int sock, const void *data, size_t bytes) {
+        auto p = static_cast<const uint8_t *>(data);
+        while (bytes > 0) {
+            ssize_t n = ::send(sock, p, bytes, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error writing to socket, ") + std::strerror(errno));
+            }
+            p += n;
+            bytes -= n;
+        }
+    }
+
+
+    /**
+     * Receive exactly the given number of bytes from a TCP socket.
+     * @param sock  connected socket.
+     * @param data  where to put the bytes.
+     * @param bytes number of bytes.
+     * @param eofOk if true, the other end closing before any bytes are read is not an error.
+     * @return true if all bytes read, false if closed before any were read and eofOk is true.
+     * @throws EvioException if error reading, or closed in the middle of the data.
+     */
+    bool RdmaConnection::receiveAll(int sock, void *data, size_t bytes, bool eofOk) {
+        auto p = static_cast<uint8_t *>(data);
+        size_t got = 0;
+        while (got < bytes) {
+            ssize_t n = ::recv(sock, p + got, bytes - got, 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error reading from socket, ") + std::strerror(errno));
+            }
+            if (n == 0) {
+                if (got == 0 && eofOk) return false;
+                throw EvioException("connection closed in middle of data");
+            }
+            got += n;
+        }
+        return true;
+    }
+
+}
+
+
+#endif // USE_RDMA
@@ -0,0 +1,163 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RDMACONNECTION_H
+#define EVIO_6_0_RDMACONNECTION_H
+
+
+#ifdef USE_RDMA
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <algorithm>
+#include <infiniband/verbs.h>
+
+
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class holds the InfiniBand verbs objects of one end of a reliable connection
+     * (RC queue pair) used by {@link RdmaWriter} and {@link RdmaReader}, over InfiniBand
+     * or RoCE. The two ends find each other through an ordinary TCP socket over which
+     * they trade an {@link Endpoint}, after which records go only over RDMA.<p>
+     *
+     * Sends and receives each have their own completion queue and channel so that a
+     * thread can block on either without spinning. This class is not thread-safe.
+     */
+    class RdmaConnection {
+
+    public:
+
+        /** What each end of a connection tells the other over TCP. */
+        struct Endpoint {
+            /** Queue pair number. */
+            uint32_t qpNumber = 0;
+            /** Starting packet sequence number. */
+            uint32_t packetSequence = 0;
+            /** Local id of port, 0 on RoCE. */
+            uint16_t lid = 0;
+            /** Global id of port, needed on RoCE. */
+            uint8_t gid[16] {};
+            /** Address of memory the other end may write into. */
+            uint64_t address = 0;
+            /** Remote key of that memory. */
+            uint32_t rkey = 0;
+            /** Reader: number of record slots at address. Writer: 0. */
+            uint32_t slotCount = 0;
+            /** Reader: bytes in each record slot. Writer: 0. */
+            uint32_t slotBytes = 0;
+            /** Active mtu of port, an ibv_mtu value. */
+            uint32_t mtu = IBV_MTU_1024;
+        };
+
+        /** Number of bytes an Endpoint takes when sent. */
+        static const size_t ENDPOINT_BYTES = 4 + 4 + 2 + 16 + 8 + 4 + 4 + 4 + 4;
+
+    private:
+
+        /** Device opened. */
+        ibv_context *context = nullptr;
+
+        /** Protection domain of all memory registered. */
+        ibv_pd *pd = nullptr;
+
+        /** Channel telling of send completions. */
+        ibv_comp_channel *sendChannel = nullptr;
+
+        /** Channel telling of receive completions. */
+        ibv_comp_channel *recvChannel = nullptr;
+
+        /** Send completion queue. */
+        ibv_cq *sendCq = nullptr;
+
+        /** Receive completion queue. */
+        ibv_cq *recvCq = nullptr;
+
+        /** Reliable connected queue pair. */
+        ibv_qp *qp = nullptr;
+
+        /** Port of device used. */
+        uint8_t ibPort = 1;
+
+        /** Index of port's global id used, or -1 to use only the local id. */
+        int gidIndex = 0;
+
+        /** Our starting packet sequence number. */
+        uint32_t packetSequence = 0;
+
+        /** Max number of send work requests outstanding. */
+        uint32_t sendDepth = 0;
+
+        /** Max number of receive work requests outstanding. */
+        uint32_t recvDepth = 0;
+
+        /** Mtu of port used. */
+        ibv_mtu mtu = IBV_MTU_1024;
+
+        /** Local id of port used. */
+        uint16_t lid = 0;
+
+        /** Global id of port used. */
+        ibv_gid gid {};
+
+    public:
+
+        RdmaConnection(std::string const & device, uint8_t ibPort, int gidIndex,
+                       uint32_t sendDepth, uint32_t recvDepth);
+
+        RdmaConnection(const RdmaConnection & other) = delete;
+        RdmaConnection & operator=(const RdmaConnection & other) = delete;
+
+        ~RdmaConnection();
+
+        /** @return max number of send work requests outstanding. */
+        uint32_t getSendDepth() const {return sendDepth;}
+        /** @return max number of receive work requests outstanding. */
+        uint32_t getRecvDepth() const {return recvDepth;}
+
+        ibv_mr * registerMemory(void *address, size_t bytes, bool remoteWrite);
+        static void deregisterMemory(ibv_mr *mr);
+
+        Endpoint localEndpoint(uint64_t address, uint32_t rkey,
+                               uint32_t slotCount = 0, uint32_t slotBytes = 0) const;
+        static void exchange(int sock, Endpoint const & local, Endpoint & remote);
+        void connect(Endpoint const & remote);
+
+        void postWriteWithImm(const void *source, uint32_t bytes, uint32_t lkey,
+                              uint64_t remoteAddress, uint32_t rkey, uint32_t imm);
+        void postWriteInline(const void *source, uint32_t bytes,
+                             uint64_t remoteAddress, uint32_t rkey);
+        void postReceive(uint64_t id);
+
+        int pollSend(ibv_wc *wc, int max, bool block, int sock = -1);
+        int pollRecv(ibv_wc *wc, int max, bool block, int sock = -1);
+
+        static void sendAll(int sock, const void *data, size_t bytes);
+        static bool receiveAll(int sock, void *data, size_t bytes, bool eofOk);
+
+    private:
+
+        int poll(ibv_cq *cq, ibv_comp_channel *channel, ibv_wc *wc, int max, bool block, int sock);
+        void release();
+    };
+
+}
+
+
+#endif // USE_RDMA
+
+
+#endif //EVIO_6_0_RDMACONNECTION_H
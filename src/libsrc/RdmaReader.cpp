@@ -0,0 +1,320 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "RdmaReader.h"
+
+
+#ifdef USE_RDMA
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <endian.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which sets up the RDMA connection with an {@link RdmaWriter} over an
+     * already connected TCP socket and reads the file header. Use
+     * {@link SocketReader#listenOn(uint16_t, int)} and {@link SocketReader#acceptConnection(int)}
+     * to get the socket. This object takes over the socket and closes it when done.
+     *
+     * @param socketFd  file descriptor of connected socket.
+     * @param slotCount number of records the writer may have in this reader's memory at once.
+     * @param slotBytes bytes in each record slot, which must hold the writer's largest record.
+     * @param device    name of RDMA device, or empty for the first one found.
+     * @param ibPort    port of RDMA device, starting at 1.
+     * @param gidIndex  index of port's global id, which RoCE needs, or -1 on InfiniBand to use local ids.
+     * @throws EvioException if socketFd < 0, slots are too few or small, RDMA connection
+     *                       cannot be made, or the stream does not start with an evio file header.
+     */
+    RdmaReader::RdmaReader(int socketFd, uint32_t slotCount, uint32_t slotBytes,
+                           std::string const & device, uint8_t ibPort, int gidIndex) :
+            sock(socketFd), slotCount(slotCount), slotBytes(slotBytes) {
+
+        if (sock < 0) {
+            throw EvioException("bad socket");
+        }
+        if (slotCount < 1 || slotBytes < RecordHeader::HEADER_SIZE_BYTES) {
+            throw EvioException("need at least one slot big enough for a record header");
+        }
+
+        // Keep every slot cache line aligned
+        this->slotBytes = (slotBytes + 63) & ~63U;
+
+        try {
+            setUp(device, ibPort, gidIndex);
+        }
+        catch (EvioException & e) {
+            release();
+            throw;
+        }
+    }
+
+
+    /** Destructor which closes the connection. */
+    RdmaReader::~RdmaReader() {close();}
+
+
+    /**
+     * Register the ring of slots, trade endpoints with the writer and read the file header.
+     * @param device   name of RDMA device, or empty for the first one found.
+     * @param ibPort   port of RDMA device.
+     * @param gidIndex index of port's global id, or -1.
+     * @throws EvioException if RDMA connection cannot be made or file header not read.
+     */
+    void RdmaReader::setUp(std::string const & device, uint8_t ibPort, int gidIndex) {
+        // One receive is used up by each record written
+        connection = std::make_unique<RdmaConnection>(device, ibPort, gidIndex, slotCount + 1, slotCount);
+        slotCount = std::min(slotCount, connection->getRecvDepth());
+
+        size_t ringBytes = (size_t)slotCount * slotBytes;
+        void *mem = nullptr;
+        if (posix_memalign(&mem, 4096, ringBytes) != 0) {
+            throw EvioException("cannot allocate " + std::to_string(ringBytes) + " bytes of record slots");
+        }
+        ring = static_cast<uint8_t *>(mem);
+        ringMr = connection->registerMemory(ring, ringBytes, true);
+
+        slots.clear();
+        for (uint32_t i = 0; i < slotCount; i++) {
+            std::shared_ptr<uint8_t> slotMem(ring + (size_t)i*slotBytes, [](uint8_t *) {});
+            slots.push_back(std::make_shared<ByteBuffer>(slotMem, slotBytes));
+            connection->postReceive(i);
+        }
+
+        auto local = connection->localEndpoint(reinterpret_cast<uintptr_t>(ring), ringMr->rkey,
+                                               slotCount, slotBytes);
+        RdmaConnection::exchange(sock, local, remote);
+        connection->connect(remote);
+
+        // Tell the writer it may start
+        uint8_t ready = 1;
+        RdmaConnection::sendAll(sock, &ready, 1);
+
+        readFileHeader();
+    }
+
+
+    /** Free all RDMA resources and close the socket. */
+    void RdmaReader::release() {
+        RdmaConnection::deregisterMemory(ringMr);
+        ringMr = nullptr;
+        connection.reset();
+
+        slots.clear();
+        std::free(ring);
+        ring = nullptr;
+
+        if (sock >= 0) {
+            ::close(sock);
+            sock = -1;
+        }
+    }
+
+
+    /**
+     * Read the file header and anything following it, sent over TCP.
+     * @throws EvioException if the stream does not start with an evio file header.
+     */
+    void RdmaReader::readFileHeader() {
+        ByteBuffer buf(FileHeader::HEADER_SIZE_BYTES);
+        RdmaConnection::receiveAll(sock, buf.array(), FileHeader::HEADER_SIZE_BYTES, false);
+        buf.limit(FileHeader::HEADER_SIZE_BYTES);
+        bytesReceived += FileHeader::HEADER_SIZE_BYTES;
+
+        // Sets the byte order
+        fileHeader.readHeader(buf, 0);
+        if (!fileHeader.getHeaderType().isEvioFileHeader()) {
+            throw EvioException("stream does not start with an evio file header");
+        }
+
+        uint32_t extra = fileHeader.getLength() - FileHeader::HEADER_SIZE_BYTES;
+        if (extra > 0) {
+            userHeader.resize(extra);
+            RdmaConnection::receiveAll(sock, userHeader.data(), extra, false);
+            bytesReceived += extra;
+        }
+    }
+
+
+    /**
+     * Get back completions of writes handing slots back to the writer.
+     * @param block if true, wait for at least one.
+     * @throws EvioException if a write failed or the writer went away.
+     */
+    void RdmaReader::reapCredits(bool block) {
+        ibv_wc wc[16];
+        while (creditsInFlight > 0) {
+            int n = connection->pollSend(wc, 16, block, sock);
+            if (n < 0) {
+                throw EvioException("writer closed connection");
+            }
+            if (n == 0) return;
+            creditsInFlight -= n;
+            if (block) return;
+        }
+    }
+
+
+    /**
+     * Hand the current record's slot back to the writer to be written into again.
+     * @throws EvioException if error writing to the writer.
+     */
+    void RdmaReader::freeSlot() {
+        // Ready for the record which will be written into it
+        connection->postReceive(nextSlot);
+        nextSlot = (nextSlot + 1) % slotCount;
+        slotsFreed++;
+
+        if (creditsInFlight + 1 >= connection->getSendDepth()) {
+            reapCredits(true);
+        }
+
+        // The count is copied when posted, so a local will do
+        uint64_t count = htobe64(slotsFreed);
+        connection->postWriteInline(&count, sizeof(count), remote.address, remote.rkey);
+        creditsInFlight++;
+        reapCredits(false);
+    }
+
+
+    /**
+     * Wait for the next record, replacing the previous one, whose slot is handed back
+     * to the writer. Events of the previous record not yet obtained are skipped.
+     *
+     * @return true if a record was read, false if the trailer or end of stream was reached.
+     * @throws EvioException if error reading, or data is not in evio format.
+     */
+    bool RdmaReader::readRecord() {
+        if (finished) return false;
+
+        if (haveRecord) {
+            haveRecord = false;
+            freeSlot();
+        }
+
+        ibv_wc wc;
+        int n = connection->pollRecv(&wc, 1, true, sock);
+        if (n < 0) {
+            // Writer left between records
+            finished = true;
+            return false;
+        }
+        if (wc.opcode != IBV_WC_RECV_RDMA_WITH_IMM) {
+            throw EvioException("unexpected RDMA completion");
+        }
+
+        uint32_t recordBytes = ntohl(wc.imm_data);
+        if (recordBytes < RecordHeader::HEADER_SIZE_BYTES || recordBytes > slotBytes) {
+            throw EvioException("bad record length, " + std::to_string(recordBytes));
+        }
+        bytesReceived += recordBytes;
+
+        auto & slot = slots[nextSlot];
+        slot->clear();
+        slot->limit(recordBytes);
+
+        RecordHeader header;
+        header.readHeader(*slot, 0);
+        if (header.getLength() != recordBytes) {
+            throw EvioException("record length " + std::to_string(header.getLength()) +
+                                " does not match " + std::to_string(recordBytes) + " bytes written");
+        }
+
+        if (header.getHeaderType().isTrailer()) {
+            finished = true;
+            return false;
+        }
+
+        haveRecord = true;
+        inputRecord.readRecordInPlace(slot, 0);
+        nextEvent = 0;
+        recordsReceived++;
+        eventsReceived += inputRecord.getEntries();
+        return true;
+    }
+
+
+    /**
+     * Get the last record read, whose data is valid until the next record is read.
+     * @return last record read.
+     * @throws EvioException if no record has been read.
+     */
+    RecordInput & RdmaReader::getRecord() {
+        if (!haveRecord) {
+            throw EvioException("no record read");
+        }
+        return inputRecord;
+    }
+
+
+    /**
+     * Make sure the current record has another event, reading records as needed.
+     * @return true if an event is available, false if the end of stream was reached.
+     * @throws EvioException if error reading.
+     */
+    bool RdmaReader::nextEventReady() {
+        while (!haveRecord || nextEvent >= inputRecord.getEntries()) {
+            if (!readRecord()) return false;
+        }
+        return true;
+    }
+
+
+    /**
+     * Get a copy of the next event in the stream, reading records as needed.
+     * @param len pointer to int which gets filled with the event size in bytes.
+     * @return next event, or nullptr at the end of the stream.
+     * @throws EvioException if error reading.
+     */
+    std::shared_ptr<uint8_t> RdmaReader::getNextEvent(uint32_t * len) {
+        auto view = getNextEventView();
+        if (len != nullptr) *len = view.size();
+        if (view.empty()) {
+            return nullptr;
+        }
+
+        // Copied, since the slot will be written into again
+        std::shared_ptr<uint8_t> event(new uint8_t[view.size()], std::default_delete<uint8_t[]>());
+        std::memcpy(event.get(), view.data(), view.size());
+        return event;
+    }
+
+
+    /**
+     * Get a view of the next event in the stream, reading records as needed.
+     * The view is valid until the next record is read.
+     * @return view of next event, empty at the end of the stream.
+     * @throws EvioException if error reading.
+     */
+    ByteBufferView RdmaReader::getNextEventView() {
+        if (!nextEventReady()) {
+            return ByteBufferView();
+        }
+        return inputRecord.getEventView(nextEvent++);
+    }
+
+
+    /** Close the connection and free the record slots. */
+    void RdmaReader::close() {
+        haveRecord = false;
+        release();
+    }
+
+}
+
+
+#endif // USE_RDMA
@@ -0,0 +1,168 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RDMAREADER_H
+#define EVIO_6_0_RDMAREADER_H
+
+
+#ifdef USE_RDMA
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "ByteOrder.h"
+#include "FileHeader.h"
+#include "RecordHeader.h"
+#include "RecordInput.h"
+#include "RdmaConnection.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads evio version 6 data sent over RDMA (InfiniBand or RoCE) by an
+     * {@link RdmaWriter}. It registers a ring of record slots with the device, tells the
+     * writer where they are over a TCP socket, on which the writer then sends the file
+     * header, and from then on each record arrives by RDMA write into the next slot
+     * without this end's cpu or kernel being involved.<p>
+     *
+     * Each record is read in place (see {@link RecordInput#readRecordInPlace}) so an
+     * uncompressed record's events are looked at right where the writer put them. A slot
+     * is handed back to the writer when the next record is read, so views obtained from
+     * {@link #getNextEventView()} or {@link #getRecord()} are valid only until then.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class RdmaReader {
+
+    private:
+
+        /** Socket to writer used to connect, -1 if closed. */
+        int sock = -1;
+
+        /** Verbs objects of this end. */
+        std::unique_ptr<RdmaConnection> connection;
+
+        /** The writer's end, holding its count of freed slots. */
+        RdmaConnection::Endpoint remote;
+
+        /** Number of record slots. */
+        uint32_t slotCount;
+
+        /** Bytes in each record slot. */
+        uint32_t slotBytes;
+
+        /** Memory of all slots. */
+        uint8_t *ring = nullptr;
+
+        /** Registration of ring. */
+        ibv_mr *ringMr = nullptr;
+
+        /** Buffer wrapping each slot. */
+        std::vector<std::shared_ptr<ByteBuffer>> slots;
+
+        /** Index of the slot the next record arrives in. */
+        uint32_t nextSlot = 0;
+
+        /** Number of slots handed back to the writer. */
+        uint64_t slotsFreed = 0;
+
+        /** Number of credit writes to the writer not yet completed. */
+        uint32_t creditsInFlight = 0;
+
+        /** Header which started the stream. */
+        FileHeader fileHeader;
+
+        /** Index and user header following the file header, if any. */
+        std::vector<uint8_t> userHeader;
+
+        /** Last record read. */
+        RecordInput inputRecord;
+
+        /** Index of next event in current record. */
+        uint32_t nextEvent = 0;
+
+        /** Is a slot held by the current record? */
+        bool haveRecord = false;
+
+        /** Has the trailer or end of stream been reached? */
+        bool finished = false;
+
+        /** Total bytes received. */
+        uint64_t bytesReceived = 0;
+
+        /** Total records received, not including the trailer. */
+        uint64_t recordsReceived = 0;
+
+        /** Total events received. */
+        uint64_t eventsReceived = 0;
+
+    public:
+
+        explicit RdmaReader(int socketFd, uint32_t slotCount = 16, uint32_t slotBytes = 16*1024*1024,
+                            std::string const & device = "", uint8_t ibPort = 1, int gidIndex = 0);
+
+        RdmaReader(const RdmaReader & other) = delete;
+        RdmaReader & operator=(const RdmaReader & other) = delete;
+
+        ~RdmaReader();
+
+        /** @return header which started the stream. */
+        FileHeader & getFileHeader() {return fileHeader;}
+        /** @return index and user header following the file header, if any. */
+        const std::vector<uint8_t> & getUserHeader() const {return userHeader;}
+        /** @return byte order of data received. */
+        const ByteOrder & getByteOrder() const {return fileHeader.getByteOrder();}
+        /** @return number of record slots. */
+        uint32_t getSlotCount()         const {return slotCount;}
+        /** @return bytes in each record slot. */
+        uint32_t getSlotBytes()         const {return slotBytes;}
+        /** @return true if the trailer or end of stream has been reached. */
+        bool isFinished()               const {return finished;}
+        /** @return total bytes received. */
+        uint64_t getBytesReceived()     const {return bytesReceived;}
+        /** @return total records received, not including the trailer. */
+        uint64_t getRecordsReceived()   const {return recordsReceived;}
+        /** @return total events received. */
+        uint64_t getEventsReceived()    const {return eventsReceived;}
+
+        bool readRecord();
+        RecordInput & getRecord();
+
+        std::shared_ptr<uint8_t> getNextEvent(uint32_t * len);
+        ByteBufferView getNextEventView();
+
+        void close();
+
+    private:
+
+        void setUp(std::string const & device, uint8_t ibPort, int gidIndex);
+        void readFileHeader();
+        void freeSlot();
+        void reapCredits(bool block);
+        bool nextEventReady();
+        void release();
+    };
+
+}
+
+
+#endif // USE_RDMA
+
+
+#endif //EVIO_6_0_RDMAREADER_H
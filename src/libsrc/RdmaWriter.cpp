@@ -0,0 +1,642 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "RdmaWriter.h"
+
+
+#ifdef USE_RDMA
+
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <endian.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+
+namespace evio {
+
+
+    /** Most records of a supply sent before waiting for their writes to complete. */
+    static const uint32_t MAX_BATCH_RECORDS = 64;
+
+    /** Max number of RDMA writes outstanding. */
+    static const uint32_t SEND_DEPTH = 128;
+
+    /** Registrations kept, beyond which those of buffers no longer used are dropped. */
+    static const size_t MAX_REGISTRATIONS = 256;
+
+
+    /**
+     * Constructor which connects to an {@link RdmaReader}, sets up the RDMA connection
+     * and sends the file header.
+     *
+     * @param host name or dotted-decimal address of host to connect to.
+     * @param port TCP port to connect to.
+     * @param order byte order of data sent.
+     * @param maxEventCount max number of events an internal record can hold.
+     *                      Value of 0 means use default (1M).
+     * @param maxBufferSize max number of uncompressed data bytes an internal record can hold.
+     *                      Value of 0 means use default (8MB).
+     * @param compressionType type of data compression for records built here.
+     * @param device   name of RDMA device, or empty for the first one found.
+     * @param ibPort   port of RDMA device, starting at 1.
+     * @param gidIndex index of port's global id, which RoCE needs, or -1 on InfiniBand to use local ids.
+     * @throws EvioException if host cannot be connected to, or RDMA connection cannot be made.
+     */
+    RdmaWriter::RdmaWriter(std::string const & host, uint16_t port, const ByteOrder & order,
+                           uint32_t maxEventCount, uint32_t maxBufferSize,
+                           Compressor::CompressionType compressionType,
+                           std::string const & device, uint8_t ibPort, int gidIndex) :
+            byteOrder(order), compressionType(compressionType) {
+
+        connectTo(host, port);
+        setUp(maxEventCount, maxBufferSize, device, ibPort, gidIndex);
+    }
+
+
+    /**
+     * Constructor which sets up the RDMA connection over an already connected TCP socket
+     * and sends the file header. This object takes over the socket and closes it when done.
+     *
+     * @param socketFd file descriptor of connected socket.
+     * @param order byte order of data sent.
+     * @param maxEventCount max number of events an internal record can hold.
+     *                      Value of 0 means use default (1M).
+     * @param maxBufferSize max number of uncompressed data bytes an internal record can hold.
+     *                      Value of 0 means use default (8MB).
+     * @param compressionType type of data compression for records built here.
+     * @param device   name of RDMA device, or empty for the first one found.
+     * @param ibPort   port of RDMA device, starting at 1.
+     * @param gidIndex index of port's global id, which RoCE needs, or -1 on InfiniBand to use local ids.
+     * @throws EvioException if socketFd < 0, or RDMA connection cannot be made.
+     */
+    RdmaWriter::RdmaWriter(int socketFd, const ByteOrder & order,
+                           uint32_t maxEventCount, uint32_t maxBufferSize,
+                           Compressor::CompressionType compressionType,
+                           std::string const & device, uint8_t ibPort, int gidIndex) :
+            sock(socketFd), byteOrder(order), compressionType(compressionType) {
+
+        if (sock < 0) {
+            throw EvioException("bad socket");
+        }
+        setUp(maxEventCount, maxBufferSize, device, ibPort, gidIndex);
+    }
+
+
+    /** Destructor which calls {@link #close()}, ignoring errors. */
+    RdmaWriter::~RdmaWriter() {
+        try {
+            close();
+        }
+        catch (EvioException & e) {}
+        release();
+    }
+
+
+    /**
+     * Connect to the given host and port.
+     * @param host name or dotted-decimal address of host to connect to.
+     * @param port TCP port to connect to.
+     * @throws EvioException if host cannot be found or connected to.
+     */
+    void RdmaWriter::connectTo(std::string const & host, uint16_t port) {
+        struct addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        struct addrinfo *result = nullptr;
+        std::string service = std::to_string(port);
+        int err = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+        if (err != 0) {
+            throw EvioException("cannot find host " + host + ": " + gai_strerror(err));
+        }
+
+        for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                sock = fd;
+                break;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(result);
+
+        if (sock < 0) {
+            throw EvioException("cannot connect to " + host + ":" + service + ", " + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Make the RDMA connection, trading endpoints over the TCP socket, then send the file header.
+     * @param maxEvents max number of events an internal record can hold, 0 for default.
+     * @param maxBytes max number of uncompressed data bytes an internal record can hold, 0 for default.
+     * @param device   name of RDMA device, or empty for the first one found.
+     * @param ibPort   port of RDMA device.
+     * @param gidIndex index of port's global id, or -1.
+     * @throws EvioException if RDMA connection cannot be made or file header cannot be sent.
+     */
+    void RdmaWriter::setUp(uint32_t maxEvents, uint32_t maxBytes,
+                           std::string const & device, uint8_t ibPort, int gidIndex) {
+        if (maxEvents > 0) maxEventCount = maxEvents;
+        if (maxBytes  > 0) maxBufferSize = maxBytes;
+
+        try {
+            connection = std::make_unique<RdmaConnection>(device, ibPort, gidIndex, SEND_DEPTH, 1);
+
+            // The reader keeps this count of slots it's done with up to date
+            slotsFreed = new uint64_t(0);
+            slotsFreedMr = connection->registerMemory(slotsFreed, sizeof(uint64_t), true);
+
+            auto local = connection->localEndpoint(reinterpret_cast<uintptr_t>(slotsFreed), slotsFreedMr->rkey);
+            RdmaConnection::exchange(sock, local, remote);
+            if (remote.slotCount < 1 || remote.slotBytes < RecordHeader::HEADER_SIZE_BYTES) {
+                throw EvioException("reader has no room for records");
+            }
+            connection->connect(remote);
+
+            // Wait until the reader is connected too
+            uint8_t ready = 0;
+            RdmaConnection::receiveAll(sock, &ready, 1, false);
+
+            staging = std::make_shared<ByteBuffer>(remote.slotBytes);
+            stagingMr = connection->registerMemory(staging->array(), remote.slotBytes, false);
+
+            FileHeader fileHeader(true);
+            fileHeader.setBitInfo(false, false, false);
+            fileHeader.setUserHeaderLength(0);
+
+            ByteBuffer buf(fileHeader.getLength());
+            buf.order(byteOrder);
+            fileHeader.writeHeader(buf, 0);
+            RdmaConnection::sendAll(sock, buf.array(), fileHeader.getLength());
+            bytesSent += fileHeader.getLength();
+
+            outputRecord = spareRecord();
+        }
+        catch (EvioException & e) {
+            release();
+            throw;
+        }
+    }
+
+
+    /** Free all RDMA resources and close the socket. */
+    void RdmaWriter::release() {
+        for (auto & entry : registrations) {
+            RdmaConnection::deregisterMemory(entry.second.mr);
+        }
+        registrations.clear();
+
+        RdmaConnection::deregisterMemory(stagingMr);
+        stagingMr = nullptr;
+        RdmaConnection::deregisterMemory(slotsFreedMr);
+        slotsFreedMr = nullptr;
+        delete slotsFreed;
+        slotsFreed = nullptr;
+
+        inFlight.clear();
+        connection.reset();
+
+        if (sock >= 0) {
+            ::close(sock);
+            sock = -1;
+        }
+    }
+
+
+    /**
+     * Get a record to fill, reusing one already sent if possible.
+     * @return empty record.
+     */
+    std::shared_ptr<RecordOutput> RdmaWriter::spareRecord() {
+        // Rather than make more records, get back one being sent
+        if (spareRecords.empty() && inFlight.size() > 1) {
+            waitForWrites(inFlight.size() - 1);
+        }
+
+        if (!spareRecords.empty()) {
+            auto rec = spareRecords.back();
+            spareRecords.pop_back();
+            rec->reset();
+            return rec;
+        }
+        return std::make_shared<RecordOutput>(byteOrder, maxEventCount, maxBufferSize, compressionType);
+    }
+
+
+    /**
+     * Get the registration of a record's binary buffer, registering it the first time.
+     * @param record record.
+     * @param start  start of the built record.
+     * @param bytes  length of the built record.
+     * @return memory region, or null if the built record is not in its binary buffer.
+     * @throws EvioException if memory cannot be registered.
+     */
+    ibv_mr * RdmaWriter::registrationFor(RecordOutput & record, const uint8_t *start, uint32_t bytes) {
+        auto buf = record.getBinaryBuffer();
+        if (buf == nullptr) return nullptr;
+
+        const uint8_t *base = buf->array();
+        size_t capacity = buf->capacity();
+        if (start < base || start + bytes > base + capacity) {
+            return nullptr;
+        }
+
+        auto it = registrations.find(buf.get());
+        if (it != registrations.end()) {
+            if (it->second.start == base && it->second.bytes == capacity) {
+                return it->second.mr;
+            }
+            // Buffer's memory was replaced since it was registered
+            RdmaConnection::deregisterMemory(it->second.mr);
+            registrations.erase(it);
+        }
+
+        // Drop registrations of buffers records no longer use
+        if (registrations.size() >= MAX_REGISTRATIONS) {
+            for (auto iter = registrations.begin(); iter != registrations.end(); ) {
+                if (iter->second.buffer.use_count() == 1) {
+                    RdmaConnection::deregisterMemory(iter->second.mr);
+                    iter = registrations.erase(iter);
+                }
+                else {
+                    ++iter;
+                }
+            }
+        }
+
+        Registration reg;
+        reg.buffer = buf;
+        reg.start = base;
+        reg.bytes = capacity;
+        reg.mr = connection->registerMemory(const_cast<uint8_t *>(base), capacity, false);
+        registrations[buf.get()] = reg;
+        return reg.mr;
+    }
+
+
+    /**
+     * Wait until the reader has a free slot.
+     * @throws EvioException if the reader goes away.
+     */
+    void RdmaWriter::waitForSlot() {
+        uint32_t spins = 0;
+        while (slotsUsed - be64toh(__atomic_load_n(slotsFreed, __ATOMIC_ACQUIRE)) >= remote.slotCount) {
+            if (++spins < 1024) continue;
+
+            // Check now and then that the reader is still there
+            if ((spins & 0xffff) == 0) {
+                uint8_t b;
+                ssize_t n = ::recv(sock, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    throw EvioException("reader closed connection");
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+
+    /**
+     * Write a record into the reader's next slot, where it is.
+     * @param data  start of record.
+     * @param bytes length of record.
+     * @param lkey  local key of memory region holding the record.
+     * @param owner record to get back once written, may be null.
+     * @throws EvioException if record is larger than a slot or error writing.
+     */
+    void RdmaWriter::postBytes(const uint8_t *data, uint32_t bytes, uint32_t lkey,
+                               std::shared_ptr<RecordOutput> const & owner) {
+        if (bytes > remote.slotBytes) {
+            throw EvioException("record of " + std::to_string(bytes) + " bytes larger than reader's " +
+                                std::to_string(remote.slotBytes) + " byte slots");
+        }
+
+        if (inFlight.size() >= connection->getSendDepth()) {
+            waitForWrites(connection->getSendDepth() - 1);
+        }
+        waitForSlot();
+
+        uint64_t address = remote.address + (slotsUsed % remote.slotCount) * (uint64_t)remote.slotBytes;
+        connection->postWriteWithImm(data, bytes, lkey, address, remote.rkey, bytes);
+        slotsUsed++;
+        inFlight.push_back(owner);
+        bytesSent += bytes;
+    }
+
+
+    /**
+     * Write a built record into the reader's next slot, from its binary buffer if
+     * possible, else copied into the staging buffer.
+     * @param record built record.
+     * @param owner  record to get back once written, may be null.
+     * @throws EvioException if record is larger than a slot or error writing.
+     */
+    void RdmaWriter::postRecord(RecordOutput & record, std::shared_ptr<RecordOutput> const & owner) {
+        record.getSegments(segments);
+
+        if (segments.size() == 1) {
+            auto & seg = segments[0];
+            ibv_mr *mr = registrationFor(record, seg.data(), seg.size());
+            if (mr != nullptr) {
+                postBytes(seg.data(), seg.size(), mr->lkey, owner);
+                return;
+            }
+        }
+
+        uint32_t bytes = record.getHeader()->getLength();
+        if (bytes > remote.slotBytes) {
+            throw EvioException("record of " + std::to_string(bytes) + " bytes larger than reader's " +
+                                std::to_string(remote.slotBytes) + " byte slots");
+        }
+
+        // The staging buffer is free once everything before is written
+        waitForWrites(0);
+        size_t offset = 0;
+        for (auto & seg : segments) {
+            std::memcpy(staging->array() + offset, seg.data(), seg.size());
+            offset += seg.size();
+        }
+        postBytes(staging->array(), bytes, stagingMr->lkey, owner);
+    }
+
+
+    /**
+     * Wait until no more than the given number of writes are outstanding.
+     * Records of internal writes which are done are made spares.
+     * @param count number of writes which may still be outstanding.
+     * @throws EvioException if a write failed or the reader went away.
+     */
+    void RdmaWriter::waitForWrites(size_t count) {
+        ibv_wc wc[16];
+        while (inFlight.size() > count) {
+            int n = connection->pollSend(wc, 16, true, sock);
+            if (n < 0) {
+                throw EvioException("reader closed connection");
+            }
+            for (int i = 0; i < n && !inFlight.empty(); i++) {
+                // Completions come in the order posted
+                if (inFlight.front() != nullptr) {
+                    spareRecords.push_back(inFlight.front());
+                }
+                inFlight.pop_front();
+            }
+        }
+    }
+
+
+    /**
+     * Build the internal record, if it has any events, and write it.
+     * @throws EvioException if error writing.
+     */
+    void RdmaWriter::sendInternalRecord() {
+        if (outputRecord->getEventCount() < 1) return;
+
+        auto & header = outputRecord->getHeader();
+        header->setCompressionType(compressionType);
+        header->setRecordNumber(recordNumber++);
+        outputRecord->build();
+
+        postRecord(*outputRecord, outputRecord);
+        recordsSent++;
+        eventsSent += header->getEntries();
+        outputRecord = spareRecord();
+    }
+
+
+    /**
+     * Add an event to the internal record, writing it first if the event does not fit.
+     * @param buffer array containing event.
+     * @param length length of event in bytes.
+     * @throws EvioException if closed, error writing, or event too large for a record.
+     */
+    void RdmaWriter::addEvent(const uint8_t* buffer, uint32_t length) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+
+        if (!outputRecord->addEvent(buffer, length)) {
+            sendInternalRecord();
+            if (!outputRecord->addEvent(buffer, length)) {
+                throw EvioException("event too large for record");
+            }
+        }
+    }
+
+
+    /**
+     * Add an event to the internal record, writing it first if the event does not fit.
+     * The event is taken from the buffer's position to its limit.
+     * @param buffer buffer containing event.
+     * @throws EvioException if closed, error writing, or event too large for a record.
+     */
+    void RdmaWriter::addEvent(ByteBuffer & buffer) {
+        addEvent(buffer.array() + buffer.arrayOffset() + buffer.position(), buffer.remaining());
+    }
+
+
+    /**
+     * Add an event to the internal record, writing it first if the event does not fit.
+     * The event is taken from the buffer's position to its limit.
+     * @param buffer buffer containing event.
+     * @throws EvioException if closed, error writing, or event too large for a record.
+     */
+    void RdmaWriter::addEvent(std::shared_ptr<ByteBuffer> & buffer) {
+        addEvent(*buffer);
+    }
+
+
+    /**
+     * Build and write the given record right away, after any records already waiting.
+     * The record's compression type is kept, but it is given the next record number.
+     * It is copied into a registered buffer, since this object does not keep it,
+     * and may be reused once this returns.
+     * Events already added to the internal record are sent first to keep them in order.
+     * @param record record to send.
+     * @throws EvioException if closed, error writing, or record larger than a slot.
+     */
+    void RdmaWriter::writeRecord(RecordOutput & record) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+
+        sendInternalRecord();
+
+        auto & header = record.getHeader();
+        header->setRecordNumber(recordNumber++);
+        record.build();
+
+        uint32_t bytes = header->getLength();
+        if (bytes > remote.slotBytes) {
+            throw EvioException("record of " + std::to_string(bytes) + " bytes larger than reader's " +
+                                std::to_string(remote.slotBytes) + " byte slots");
+        }
+
+        waitForWrites(0);
+        record.getSegments(segments);
+        size_t offset = 0;
+        for (auto & seg : segments) {
+            std::memcpy(staging->array() + offset, seg.data(), seg.size());
+            offset += seg.size();
+        }
+        postBytes(staging->array(), bytes, stagingMr->lkey, nullptr);
+        waitForWrites(0);
+
+        recordsSent++;
+        eventsSent += header->getEntries();
+    }
+
+
+    /**
+     * Start a thread which writes every record that comes out of the given supply
+     * once it has been compressed, in place of a thread writing them to file.
+     * Each record goes out from its ring item's own registered buffer without a copy.
+     * Records are reset and released back to the supply once written.
+     * Records are sent in the order of the supply, keeping their record numbers.
+     * Events already added to this object are sent first.
+     * Call {@link #waitForSupply()} once the last record has been published.
+     *
+     * @param recordSupply supply of records to send.
+     * @throws EvioException if closed, already sending a supply, or error writing.
+     */
+    void RdmaWriter::startSending(std::shared_ptr<RecordSupply> & recordSupply) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+        if (supply != nullptr) {
+            throw EvioException("already sending a supply");
+        }
+
+        sendInternalRecord();
+        waitForWrites(0);
+
+        supply = recordSupply;
+        lastSeqProcessed = -1;
+        supplyError.clear();
+        supplyFailed = false;
+        supplyThread = boost::thread([this]() {this->runSupply();});
+    }
+
+
+    /**
+     * Wait for every record published to the supply to be sent, then stop the sending thread.
+     * @throws EvioException if the sending thread quit because of an error.
+     */
+    void RdmaWriter::waitForSupply() {
+        if (supply == nullptr) return;
+
+        while (!supplyFailed && supply->getLastSequence() > lastSeqProcessed.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        supplyThread.interrupt();
+        supplyThread.join();
+        supply = nullptr;
+
+        if (supplyFailed) {
+            throw EvioException(supplyError);
+        }
+    }
+
+
+    /** Write records from the supply until interrupted. Run in supplyThread. */
+    void RdmaWriter::runSupply() {
+        try {
+            while (true) {
+
+                // Get the records ready to send, waiting for the first if necessary
+                int64_t first;
+                uint32_t count = supply->getToWrite(MAX_BATCH_RECORDS, first);
+
+                {
+                    // Only allow interruption when blocked on trying to get first item
+                    boost::this_thread::disable_interruption d1;
+
+                    for (int64_t seq = first; seq < first + count; seq++) {
+                        auto & record = supply->getItem(seq)->getRecord();
+                        postRecord(*record, nullptr);
+                    }
+
+                    // Ring items may only be reused once their records are written
+                    waitForWrites(0);
+
+                    for (int64_t seq = first; seq < first + count; seq++) {
+                        auto & record = supply->getItem(seq)->getRecord();
+                        auto & header = record->getHeader();
+                        recordsSent++;
+                        eventsSent += header->getEntries();
+                        // Trailer follows the last record number used
+                        if (header->getRecordNumber() >= recordNumber) {
+                            recordNumber = header->getRecordNumber() + 1;
+                        }
+                        record->reset();
+                    }
+
+                    supply->releaseWriter(first, count);
+                    lastSeqProcessed = first + count - 1;
+                }
+            }
+        }
+        catch (boost::thread_interrupted & e) {}
+        catch (EvioException & e) {
+            supplyError = e.what();
+            supplyFailed = true;
+        }
+    }
+
+
+    /**
+     * Write the partially filled internal record and wait for all writes to complete.
+     * @throws EvioException if error writing.
+     */
+    void RdmaWriter::flush() {
+        if (closed) return;
+        sendInternalRecord();
+        waitForWrites(0);
+    }
+
+
+    /**
+     * Write everything waiting to be sent, followed by a trailer, then close the connection.
+     * Any supply being sent is waited on first.
+     * @throws EvioException if error writing.
+     */
+    void RdmaWriter::close() {
+        if (closed) return;
+        closed = true;
+
+        try {
+            waitForSupply();
+            sendInternalRecord();
+            waitForWrites(0);
+
+            RecordHeader::writeTrailer(staging->array(), remote.slotBytes, recordNumber, byteOrder, nullptr);
+            postBytes(staging->array(), RecordHeader::HEADER_SIZE_BYTES, stagingMr->lkey, nullptr);
+            waitForWrites(0);
+        }
+        catch (EvioException & e) {
+            release();
+            throw;
+        }
+
+        release();
+    }
+
+}
+
+
+#endif // USE_RDMA
@@ -0,0 +1,230 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RDMAWRITER_H
+#define EVIO_6_0_RDMAWRITER_H
+
+
+#ifdef USE_RDMA
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+
+
+#include "boost/thread.hpp"
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "ByteOrder.h"
+#include "FileHeader.h"
+#include "RecordHeader.h"
+#include "RecordOutput.h"
+#include "RecordSupply.h"
+#include "RecordRingItem.h"
+#include "RdmaConnection.h"
+#include "Compressor.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class writes evio version 6 data over RDMA (InfiniBand or RoCE) to an
+     * {@link RdmaReader}, for links too fast for {@link SocketWriter} to keep busy without
+     * burning the cpu. The two first connect over TCP, where the file header is sent, and
+     * from then on each record is put straight into one of a ring of slots in the reader's
+     * memory by an RDMA write, which the reader hands back once done with it.<p>
+     *
+     * A record's binary buffer is registered with the device the first time it's sent and the
+     * registration kept for as long as the buffer is, so records, and in particular those of a
+     * {@link RecordSupply}'s ring (see {@link #startSending(std::shared_ptr<RecordSupply> &)}),
+     * go out from where they were built with no copy and no system call. Records built for
+     * gathering (see {@link RecordOutput#setGatherOutput(bool)}) and those given to
+     * {@link #writeRecord(RecordOutput &)} are first copied into one registered buffer.<p>
+     *
+     * Each record must fit into one of the reader's slots.
+     * This class is not thread-safe.
+     */
+    class RdmaWriter {
+
+    private:
+
+        /** Registration of a record's binary buffer. */
+        struct Registration {
+            /** Buffer registered, kept so its memory cannot be freed while registered. */
+            std::shared_ptr<ByteBuffer> buffer;
+            /** Start of memory registered. */
+            const uint8_t *start = nullptr;
+            /** Number of bytes registered. */
+            size_t bytes = 0;
+            /** Memory region. */
+            ibv_mr *mr = nullptr;
+        };
+
+        /** Socket to reader used to connect, -1 if closed. */
+        int sock = -1;
+
+        /** Verbs objects of this end. */
+        std::unique_ptr<RdmaConnection> connection;
+
+        /** The reader's end, the ring of slots records are written into. */
+        RdmaConnection::Endpoint remote;
+
+        /** Count of slots the reader has handed back, big endian, written by the reader. */
+        uint64_t *slotsFreed = nullptr;
+
+        /** Registration of slotsFreed. */
+        ibv_mr *slotsFreedMr = nullptr;
+
+        /** Number of records written into slots. */
+        uint64_t slotsUsed = 0;
+
+        /** Registrations of record buffers, by buffer. */
+        std::unordered_map<const ByteBuffer *, Registration> registrations;
+
+        /** Registered buffer records are copied into when they can't be sent from where they are. */
+        std::shared_ptr<ByteBuffer> staging;
+
+        /** Registration of staging. */
+        ibv_mr *stagingMr = nullptr;
+
+        /** Records written but whose writes have not completed, oldest first. */
+        std::deque<std::shared_ptr<RecordOutput>> inFlight;
+
+        /** Byte order of data sent. */
+        ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
+
+        /** Type of compression used on records this object builds. */
+        Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED;
+
+        /** Max number of events an internal record can hold. */
+        uint32_t maxEventCount = 1000000;
+
+        /** Max number of uncompressed data bytes an internal record can hold. */
+        uint32_t maxBufferSize = 8*1024*1024;
+
+        /** Number which is incremented and stored with each successive record starting at 1. */
+        uint32_t recordNumber = 1;
+
+        /** Internal record that events are added to. */
+        std::shared_ptr<RecordOutput> outputRecord;
+
+        /** Records already sent which may be reused. */
+        std::vector<std::shared_ptr<RecordOutput>> spareRecords;
+
+        /** Parts of records being sent. */
+        std::vector<ByteBufferView> segments;
+
+        /** Total bytes sent. */
+        std::atomic<uint64_t> bytesSent {0};
+
+        /** Total records sent, not including the trailer. */
+        std::atomic<uint64_t> recordsSent {0};
+
+        /** Total events sent. */
+        std::atomic<uint64_t> eventsSent {0};
+
+        /** Thread sending records from a supply. */
+        boost::thread supplyThread;
+
+        /** Supply being sent by supplyThread. */
+        std::shared_ptr<RecordSupply> supply;
+
+        /** Highest sequence of supply which has been sent. */
+        std::atomic_long lastSeqProcessed {-1};
+
+        /** Error stopping the supply thread, if any. */
+        std::string supplyError;
+
+        /** Set once supplyError is set. */
+        std::atomic_bool supplyFailed {false};
+
+        /** Has close() been called? */
+        bool closed = false;
+
+    public:
+
+        RdmaWriter(std::string const & host, uint16_t port,
+                   const ByteOrder & order = ByteOrder::ENDIAN_LOCAL,
+                   uint32_t maxEventCount = 0, uint32_t maxBufferSize = 0,
+                   Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED,
+                   std::string const & device = "", uint8_t ibPort = 1, int gidIndex = 0);
+
+        explicit RdmaWriter(int socketFd,
+                            const ByteOrder & order = ByteOrder::ENDIAN_LOCAL,
+                            uint32_t maxEventCount = 0, uint32_t maxBufferSize = 0,
+                            Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED,
+                            std::string const & device = "", uint8_t ibPort = 1, int gidIndex = 0);
+
+        RdmaWriter(const RdmaWriter & other) = delete;
+        RdmaWriter & operator=(const RdmaWriter & other) = delete;
+
+        ~RdmaWriter();
+
+        /** @return byte order of data sent. */
+        const ByteOrder & getByteOrder() const {return byteOrder;}
+        /** @return number of the reader's record slots. */
+        uint32_t getSlotCount()     const {return remote.slotCount;}
+        /** @return bytes in each of the reader's record slots, the largest record that can be sent. */
+        uint32_t getSlotBytes()     const {return remote.slotBytes;}
+        /** @return total bytes sent. */
+        uint64_t getBytesSent()     const {return bytesSent;}
+        /** @return total records sent, not including the trailer. */
+        uint64_t getRecordsSent()   const {return recordsSent;}
+        /** @return total events sent. */
+        uint64_t getEventsSent()    const {return eventsSent;}
+        /** @return true if close() has been called. */
+        bool isClosed()             const {return closed;}
+
+        void addEvent(const uint8_t* buffer, uint32_t length);
+        void addEvent(ByteBuffer & buffer);
+        void addEvent(std::shared_ptr<ByteBuffer> & buffer);
+
+        void writeRecord(RecordOutput & record);
+
+        void startSending(std::shared_ptr<RecordSupply> & recordSupply);
+        void waitForSupply();
+
+        void flush();
+        void close();
+
+    private:
+
+        void connectTo(std::string const & host, uint16_t port);
+        void setUp(uint32_t maxEvents, uint32_t maxBytes,
+                   std::string const & device, uint8_t ibPort, int gidIndex);
+        void release();
+
+        void waitForSlot();
+        void postRecord(RecordOutput & record, std::shared_ptr<RecordOutput> const & owner);
+        void postBytes(const uint8_t *data, uint32_t bytes, uint32_t lkey,
+                       std::shared_ptr<RecordOutput> const & owner);
+        void waitForWrites(size_t count);
+        void sendInternalRecord();
+        void runSupply();
+
+        ibv_mr * registrationFor(RecordOutput & record, const uint8_t *start, uint32_t bytes);
+        std::shared_ptr<RecordOutput> spareRecord();
+    };
+
+}
+
+
+#endif // USE_RDMA
+
+
+#endif //EVIO_6_0_RDMAWRITER_H
@@ -9,6 +9,20 @@
 
 
 #include "Reader.h"
+#include "EvioBinaryDictionary.h"
+#include "Profiler.h"
+
+#include <cerrno>
+#include <cmath>
+#include <unordered_set>
+#include <unordered_map>
+#include <exception>
+#include <chrono>
+#include <boost/thread.hpp>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 
 namespace evio {
@@ -22,6 +36,12 @@ namespace evio {
     Reader::Reader() {}
 
 
+    /** Destructor. Stops any decompression threads. */
+    Reader::~Reader() {
+        stopDecompression();
+    }
+
+
     /**
      * Constructor with filename. Creates instance and opens
      * the input stream with given name. Uses existing indexes
@@ -40,11 +60,14 @@ namespace evio {
      * the input stream with given name.
      * @param filename input file name.
      * @param forceScan if true, force a scan of file, else use existing indexes first.
+     * @param memoryMap if true, memory map the file and read uncompressed records in place
+     *                  instead of copying them out of the file.
      * @throws IOException   if error reading file
-     * @throws EvioException if file is not in the proper format or earlier than version 6
+     * @throws EvioException if file is not in the proper format or earlier than version 6,
+     *                       or file cannot be memory mapped.
      */
-    Reader::Reader(std::string const & filename, bool forceScan) {
-        open(filename, false);
+    Reader::Reader(std::string const & filename, bool forceScan, bool memoryMap) {
+        open(filename, false, memoryMap);
         scanFile(forceScan);
     }
 
@@ -62,8 +85,32 @@ namespace evio {
      * @throws EvioException if buffer too small, not in the proper format, or earlier than version 6;
      *                       if checkRecordNumSeq is true and records are out of sequence.
      */
-    Reader::Reader(std::shared_ptr<ByteBuffer> & buffer, bool checkRecordNumSeq) {
+    Reader::Reader(std::shared_ptr<ByteBuffer> & buffer, bool checkRecordNumSeq) :
+            Reader(buffer, nullptr, checkRecordNumSeq) {}
+
+
+    /**
+     * Constructor for reading buffer with evio data.
+     * Buffer must be ready to read with position and limit set properly.
+     * If the given buffer contains compressed data, it is uncompressed into another buffer.
+     * The buffer containing the newly uncompressed data then becomes the internal buffer of
+     * this object. It can be obtained by calling {@link #getBuffer}.<p>
+     *
+     * The EvioNodes representing events are taken from the given pool, which is reset
+     * each time a buffer is scanned, so no nodes need be allocated once it has grown
+     * large enough. Nodes from a previous buffer must not be used after that.
+     *
+     * @param buffer buffer with evio data.
+     * @param pool   source of EvioNode objects, null to create them.
+     * @param checkRecordNumSeq if true, check to see if all record numbers are in order,
+     *                          if not throw exception.
+     * @throws EvioException if buffer too small, not in the proper format, or earlier than version 6;
+     *                       if checkRecordNumSeq is true and records are out of sequence.
+     */
+    Reader::Reader(std::shared_ptr<ByteBuffer> & buffer, std::shared_ptr<EvioNodeSource> const & pool,
+                   bool checkRecordNumSeq) {
         this->buffer = buffer;
+        nodePool = pool;
         bufferOffset = buffer->position();
         bufferLimit  = buffer->limit();
         byteOrder = buffer->order();
@@ -84,15 +131,27 @@ namespace evio {
     /**
      * Opens an input stream in binary mode. Scans for
      * records in the file and stores record information
-     * in internal array. Each record can be read from the file.
+     * in internal array. Each record can be read from the file.<p>
+     *
+     * If the file is memory mapped, uncompressed records are not copied when read,
+     * and the events returned by {@link #getEvent(uint32_t, uint32_t *)} and
+     * {@link #getNextEvent(uint32_t *)} point directly into the mapped memory.
+     * The mapping is private, so changing such an event's bytes never alters the file,
+     * but it is seen by later calls returning the same event.
+     *
      * @param filename input file name
      * @param scan if true, call scanFile(false).
+     * @param memoryMap if true, memory map the file.
      * @throws EvioException if error handling file
      */
-    void Reader::open(std::string const & filename, bool scan) {
+    void Reader::open(std::string const & filename, bool scan, bool memoryMap) {
         // Throw exception if logical or read/write error on io operation
         inStreamRandom.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
+        // Decompression threads are tied to the file currently open
+        stopDecompression();
+        sampledRecord = -1;
+
         try {
             if (inStreamRandom.is_open()) {
 //std::cout << "[READER] ---> closing current file : " << fileName << std::endl;
@@ -101,11 +160,18 @@ namespace evio {
 
             // This may be called after using a buffer as input, so zero some things out
             buffer = nullptr;
+            mappedFile = nullptr;
             bufferOffset = 0;
             bufferLimit  = 0;
             fromFile = true;
+            // Records of this file must not be decompressed with that of another
+            compressionDictionary = nullptr;
+            inputRecordStream.setCompressionDictionary(nullptr);
 
             fileName = filename;
+            cacheFileId = RecordCache::getFileId(filename);
+            seekableBlocks = nullptr;
+            partialOffsets.clear();
 
 //std::cout << "[READER] ---> opening file : " << filename << std::endl;
             // "ate" mode flag will go immediately to file's end (do this to get its size)
@@ -115,6 +181,13 @@ namespace evio {
             // Go back to beginning of file
             inStreamRandom.seekg(0);
             fromFile = true;
+            closed = false;
+
+            memoryMapped = memoryMap;
+            if (memoryMapped) {
+                mapFile();
+            }
+
             if (scan) {
                 scanFile(false);
             }
@@ -131,14 +204,48 @@ namespace evio {
             return;
         }
 
+        stopDecompression();
+
         if (fromFile) {
             inStreamRandom.close();
+            // Memory is unmapped once no event or record refers to it any longer
+            mappedFile = nullptr;
+            seekableBlocks = nullptr;
+            partialOffsets.clear();
         }
 
         closed = true;
     }
 
 
+    /**
+     * Memory map the file being read and wrap it in {@link #mappedFile}.
+     * The mapping is private and copy-on-write so that events handed out
+     * can be changed (e.g. swapped) without affecting the file.
+     * @throws EvioException if file cannot be opened or mapped.
+     */
+    void Reader::mapFile() {
+        if (fileSize < 1) {
+            throw EvioException("cannot map empty file " + fileName);
+        }
+
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw EvioException("cannot open file " + fileName);
+        }
+
+        void *pmem = ::mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // Mapping stays valid after fd is closed
+        ::close(fd);
+
+        if (pmem == MAP_FAILED) {
+            throw EvioException("cannot map file " + fileName);
+        }
+
+        mappedFile = std::make_shared<ByteBuffer>(static_cast<char *>(pmem), fileSize, true);
+    }
+
+
     /**
      * Has {@link #close()} been called (without reopening by calling
      * {@link #setBuffer(std::shared_ptr<ByteBuffer> &)})?
@@ -155,6 +262,489 @@ namespace evio {
     bool Reader::isFile() const {return fromFile;}
 
 
+    /**
+     * Is the file being read memory mapped?
+     * @return {@code true} if the file being read is memory mapped, else {@code false}.
+     */
+    bool Reader::isMemoryMapped() const {return fromFile && memoryMapped;}
+
+
+    /**
+     * Set the number of threads used to read and decompress records of a compressed file
+     * ahead of the records being accessed. Records are decompressed in parallel but
+     * delivered in order, so this benefits sequential reading through
+     * {@link #getNextEvent(uint32_t *)} and the like. Random access to a record
+     * not coming next is done, as usual, in the caller's thread. Has no effect
+     * when reading a buffer or an uncompressed file.
+     * @param threadCount number of decompression threads, 0 to decompress
+     *                    in the caller's thread (default).
+     */
+    void Reader::setDecompressionThreads(uint32_t threadCount) {
+        stopDecompression();
+        decompressionThreadCount = threadCount;
+    }
+
+
+    /**
+     * Get the number of threads used to read and decompress records ahead of their access.
+     * @return number of threads used to read and decompress records ahead of their access.
+     */
+    uint32_t Reader::getDecompressionThreads() const {return decompressionThreadCount;}
+
+
+    /**
+     * Set how far ahead of sequential reading records of a file are read (and
+     * decompressed) by a background thread. Once set, a consumer calling
+     * {@link #getNextEvent(uint32_t *)} should rarely wait on the file when moving
+     * into a new record. If the file is compressed, the records are decompressed by
+     * the number of threads set in {@link #setDecompressionThreads(uint32_t)},
+     * otherwise by 1 thread. Has no effect when reading a buffer.
+     * Setting both args to 0 turns off reading ahead unless decompression threads are set.
+     *
+     * @param recordCount max number of records to read ahead, 0 for no limit.
+     * @param byteCount   max number of bytes (as stored in file) of records to read ahead,
+     *                    0 for no limit. At least one record is always read ahead.
+     */
+    void Reader::setReadAhead(uint32_t recordCount, size_t byteCount) {
+        stopDecompression();
+        readAheadRecords = recordCount;
+        readAheadBytes = byteCount;
+    }
+
+
+    /**
+     * Get the max number of records read ahead of sequential reading.
+     * @return max number of records read ahead of sequential reading, 0 if not set.
+     */
+    uint32_t Reader::getReadAheadRecords() const {return readAheadRecords;}
+
+
+    /**
+     * Get the max number of file bytes read ahead of sequential reading.
+     * @return max number of file bytes read ahead of sequential reading, 0 if not set.
+     */
+    size_t Reader::getReadAheadBytes() const {return readAheadBytes;}
+
+
+    /**
+     * Read a file while it is still being written, for example by {@link EventWriter},
+     * as for online monitoring. When sequential reading with {@link #getNextEvent(uint32_t *)}
+     * or {@link #getNextEventView()} runs out of events, the file is looked at again and
+     * any records completely written since are added to the ones already known, without
+     * scanning the file from the start. If there are none, it waits, looking at the file
+     * every pollPeriod milliseconds, until there are or until the timeout runs out.
+     * Waiting ends for good once the trailer, or a record marked as last, is found.
+     * If reading ahead is set (see {@link #setReadAhead(uint32_t, size_t)}), the new records
+     * are handed to the read ahead threads as soon as they're found.<p>
+     *
+     * Call this before {@link #open(std::string const &, bool, bool)}
+     * so space reserved but not yet written at the end of the file is not mistaken
+     * for a damaged record. Has no effect when reading a buffer or a memory mapped file,
+     * whose size is fixed when mapped.
+     *
+     * @param follow     if true, follow a file as it is written.
+     * @param timeout    milliseconds to wait for more events, 0 to only look once,
+     *                   &lt; 0 to wait until the file is finished.
+     * @param pollPeriod milliseconds between looks at the file while waiting, 0 is treated as 1.
+     */
+    void Reader::setFollowMode(bool follow, int32_t timeout, uint32_t pollPeriod) {
+        followMode = follow;
+        followTimeout = timeout;
+        followPollPeriod = pollPeriod < 1 ? 1 : pollPeriod;
+    }
+
+
+    /**
+     * Is a file being followed as it's written?
+     * @return true if following a file as it's written.
+     */
+    bool Reader::isFollowing() const {return followMode && fromFile && !memoryMapped;}
+
+
+    /**
+     * Read only some of the records when sequentially reading with {@link #getNextEvent(uint32_t *)},
+     * {@link #getNextEvent(uint32_t *, uint16_t, uint8_t)}, {@link #getNextEventView()}, or
+     * {@link #getNextEventNode()}, as for online monitoring of a file written faster than
+     * it can be fully analyzed. All events of a record picked are returned, while the
+     * records passed over are found in the record position table and never read or
+     * decompressed. Random access with {@link #getEvent(uint32_t, uint32_t *)} is unaffected.<p>
+     *
+     * A fraction below 1 picks records evenly spread through the file, always starting with
+     * the first, so 0.01 reads 1 of every 100 records. An interval above 0 picks a record
+     * only if at least that many milliseconds of the caller's time have passed since the
+     * last one picked, which, when following a file with {@link #setFollowMode}, keeps
+     * up with the writer at a steady rate. If both are given, a record must meet both.<p>
+     *
+     * Since most records are passed over, records are not read ahead or decompressed
+     * by other threads while subsampling.
+     *
+     * @param fraction       fraction of records read, greater than 0 and no more than 1.
+     *                       1 with an interval of 0 turns subsampling off.
+     * @param intervalMillis least milliseconds between records read, 0 for no limit.
+     * @throws EvioException if fraction &lt;= 0 or &gt; 1.
+     */
+    void Reader::setSubsampling(double fraction, uint32_t intervalMillis) {
+        if (!(fraction > 0. && fraction <= 1.)) {
+            throw EvioException("fraction must be > 0 and <= 1");
+        }
+
+        stopDecompression();
+        subsampleFraction = fraction;
+        subsampleInterval = intervalMillis;
+        sampledRecord = -1;
+        recordsNotSampled = 0;
+    }
+
+
+    /**
+     * Are only some of the records read when sequentially reading?
+     * @return true if subsampling.
+     */
+    bool Reader::isSubsampling() const {return subsampleFraction < 1. || subsampleInterval > 0;}
+
+
+    /**
+     * Get the fraction of records read when subsampling.
+     * @return fraction of records read, 1 if all.
+     */
+    double Reader::getSubsampleFraction() const {return subsampleFraction;}
+
+
+    /**
+     * Get the least milliseconds between records read when subsampling.
+     * @return least milliseconds between records read, 0 if no limit.
+     */
+    uint32_t Reader::getSubsampleInterval() const {return subsampleInterval;}
+
+
+    /**
+     * Get the number of records passed over by subsampling since it was set.
+     * @return number of records passed over by subsampling.
+     */
+    uint64_t Reader::getRecordsNotSampled() const {return recordsNotSampled;}
+
+
+    /**
+     * Is the record with the given index picked by subsampling?
+     * Called once for each record as sequential reading enters it.
+     * @param index index of record.
+     * @return true if record is to be read.
+     */
+    bool Reader::isSampledRecord(uint32_t index) {
+        if (subsampleFraction < 1. && index > 0) {
+            // Pick a record each time the running count of records times fraction goes up by 1
+            if (std::floor(index * subsampleFraction) == std::floor((index - 1) * subsampleFraction)) {
+                return false;
+            }
+        }
+
+        if (subsampleInterval > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (sampledRecord >= 0 && now - sampledTime < std::chrono::milliseconds(subsampleInterval)) {
+                return false;
+            }
+            sampledTime = now;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * When subsampling, move the index of sequential reading past
+     * the records not picked, to the first event of the next one that is.
+     * When following a file, this waits for records to be written as needed.
+     */
+    void Reader::skipUnsampledRecords() {
+        if (!isSubsampling()) {
+            return;
+        }
+
+        while (true) {
+            if (isFollowing() && sequentialIndex >= (int32_t)eventIndex.getMaxEvents()) {
+                waitForEvent(sequentialIndex);
+            }
+            if (sequentialIndex >= (int32_t)eventIndex.getMaxEvents()) {
+                return;
+            }
+
+            // Each record is looked at once, as we enter it
+            uint32_t record = eventIndex.getRecordOfEvent(sequentialIndex);
+            if ((int64_t)record == sampledRecord) {
+                return;
+            }
+            if (isSampledRecord(record)) {
+                sampledRecord = record;
+                return;
+            }
+
+            recordsNotSampled++;
+            sequentialIndex = eventIndex.getFirstEventOfRecord(record + 1);
+        }
+    }
+
+
+    /**
+     * Has the end of the file being read been found? This is the case once its trailer,
+     * or a record marked as last, has been found, or if it has an index of its records.
+     * @return true if file being read is finished.
+     */
+    bool Reader::isFileFinished() const {return lastRecordFound;}
+
+
+    /**
+     * Look for records completely written to the file since it was last looked at,
+     * and add them to the records already known. Called by the sequential read methods
+     * when following a file, but it may be called at any time.
+     * @return number of records found.
+     */
+    uint32_t Reader::findNewRecords() {
+        if (!isFollowing() || closed || lastRecordFound) {
+            return 0;
+        }
+
+        struct stat st;
+        if (::stat(fileName.c_str(), &st) != 0) {
+            return 0;
+        }
+        fileSize = st.st_size;
+
+        ByteBuffer headerBuffer(RecordHeader::HEADER_SIZE_BYTES);
+        auto headerBytes = reinterpret_cast<char *>(headerBuffer.array());
+        RecordHeader recordHeader;
+        uint32_t found = 0;
+
+        while (scanEnd + RecordHeader::HEADER_SIZE_BYTES <= fileSize) {
+            try {
+                // Reading past the previous end of file may have left the stream in a failed state
+                inStreamRandom.clear();
+                inStreamRandom.seekg(scanEnd);
+                inStreamRandom.read(headerBytes, RecordHeader::HEADER_SIZE_BYTES);
+                recordHeader.readHeader(headerBuffer);
+            }
+            catch (std::exception & e) {
+                // Header not written yet
+                inStreamRandom.clear();
+                break;
+            }
+
+            if (recordHeader.getHeaderType().isTrailer()) {
+                lastRecordFound = true;
+                break;
+            }
+
+            uint32_t recordLen = recordHeader.getLength();
+            if (recordLen < RecordHeader::HEADER_SIZE_BYTES || scanEnd + recordLen > fileSize) {
+                break;
+            }
+
+            if (recordPositions.empty()) {
+                firstRecordHeader = std::make_shared<RecordHeader>(recordHeader);
+                compressed = firstRecordHeader->getCompressionType() != Compressor::UNCOMPRESSED;
+            }
+
+            recordPositions.emplace_back(scanEnd, recordLen, recordHeader.getEntries());
+            eventIndex.addEventSize(recordHeader.getEntries());
+            scanEnd += recordLen;
+            found++;
+
+            if (recordHeader.isLastRecord()) {
+                lastRecordFound = true;
+                break;
+            }
+        }
+
+        // Let the read ahead threads get started on the new records
+        if (found > 0 && decompressSupply != nullptr) {
+            fillDecompressionSupply();
+        }
+
+        return found;
+    }
+
+
+    /**
+     * When following a file, wait for the event with the given index to be written.
+     * @param index index of event.
+     * @return true if event is in the file, false if it did not show up in time
+     *         or the file is finished.
+     */
+    bool Reader::waitForEvent(uint32_t index) {
+        auto start = std::chrono::steady_clock::now();
+
+        while (true) {
+            findNewRecords();
+            if (index < eventIndex.getMaxEvents()) return true;
+            if (lastRecordFound || followTimeout == 0) return false;
+
+            if (followTimeout > 0 &&
+                std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(followTimeout)) {
+                return false;
+            }
+
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(followPollPeriod));
+        }
+    }
+
+
+    /**
+     * Are records to be read by background threads? This is the case when reading
+     * a file which is either compressed and decompression threads are set,
+     * or for which reading ahead is set, and which is not being subsampled.
+     * @return true if records are to be read by background threads.
+     */
+    bool Reader::useDecompressionSupply() const {
+        if (!fromFile || isSubsampling()) return false;
+        return (compressed && decompressionThreadCount > 0) || readAheadRecords > 0 || readAheadBytes > 0;
+    }
+
+
+    /**
+     * Start threads which read and decompress records in parallel, beginning with the given one.
+     * @param firstRecord index of first record to decompress.
+     */
+    void Reader::startDecompression(uint32_t firstRecord) {
+        // Reading ahead an uncompressed file is limited by I/O, so use only 1 thread
+        uint32_t threadCount = 1;
+        if (compressed && decompressionThreadCount > 0) {
+            threadCount = decompressionThreadCount;
+        }
+
+        // Ring must hold more records than threads to keep them all busy, and be a power of 2.
+        // Each item's record has its own buffers, so don't make it larger than necessary.
+        uint32_t ringSize = threadCount + 1;
+        if (readAheadRecords > ringSize) {
+            ringSize = readAheadRecords;
+        }
+        else if (readAheadRecords == 0 && readAheadBytes > 0 && !recordPositions.empty()) {
+            // Estimate record count from average record length
+            size_t avgLength = (recordPositions.back().getPosition() + recordPositions.back().getLength() -
+                                recordPositions.front().getPosition()) / recordPositions.size();
+            if (avgLength > 0 && readAheadBytes/avgLength + 1 > ringSize) {
+                ringSize = readAheadBytes/avgLength + 1;
+            }
+        }
+        ringSize = Disruptor::Util::ceilingNextPowerOfTwo(ringSize);
+
+        decompressSupply = std::make_shared<RecordInputSupply>(ringSize, threadCount);
+        decompressSupply->setVerifyChecksum(verifyChecksums);
+        loadCompressionDictionary();
+        decompressSupply->setCompressionDictionary(compressionDictionary);
+
+        // Vector must not reallocate once threads are started since they refer to its elements
+        decompressorThreads.reserve(threadCount);
+        for (uint32_t i=0; i < threadCount; i++) {
+            decompressorThreads.emplace_back(i, fileName, mappedFile, decompressSupply);
+        }
+        for (uint32_t i=0; i < threadCount; i++) {
+            decompressorThreads[i].startThread();
+        }
+
+        nextDecompressedRecord = nextRecordToDecompress = firstRecord;
+        bytesAhead = 0;
+        fillDecompressionSupply();
+    }
+
+
+    /**
+     * Hand out records to the decompression threads until the ring is full
+     * or the read ahead limits are reached.
+     */
+    void Reader::fillDecompressionSupply() {
+        while (nextRecordToDecompress < recordPositions.size()) {
+            uint32_t recordsAhead = nextRecordToDecompress - nextDecompressedRecord;
+            uint32_t length = recordPositions[nextRecordToDecompress].getLength();
+
+            if (recordsAhead >= decompressSupply->getRingSize()) break;
+            if (recordsAhead > 0) {
+                if (readAheadRecords > 0 && recordsAhead >= readAheadRecords) break;
+                if (readAheadBytes > 0 && bytesAhead + length > readAheadBytes) break;
+            }
+
+            size_t pos = recordPositions[nextRecordToDecompress].getPosition();
+            if (memoryMapped) {
+                // Have the kernel start reading in the pages, which in place reading doesn't touch
+                size_t pageSize = ::sysconf(_SC_PAGESIZE);
+                size_t start = pos - pos % pageSize;
+                ::madvise(mappedFile->array() + start, pos + length - start, MADV_WILLNEED);
+            }
+
+            auto item = decompressSupply->get();
+            item->setRecord(nextRecordToDecompress, pos);
+            decompressSupply->publish(item);
+            nextRecordToDecompress++;
+            bytesAhead += length;
+        }
+    }
+
+
+    /** Stop any threads reading and decompressing records and discard their records. */
+    void Reader::stopDecompression() {
+        if (decompressSupply == nullptr) {
+            return;
+        }
+
+        // Wake up any threads waiting for records
+        decompressSupply->errorAlert();
+        for (RecordDecompressor & thd : decompressorThreads) {
+            thd.stopThread();
+        }
+        decompressorThreads.clear();
+        decompressSupply = nullptr;
+    }
+
+
+    /**
+     * Get the record with the given index from the decompression threads,
+     * and make it the current record.
+     * @param index index of record to get.
+     * @return true if record obtained, false if the record is not (or no longer)
+     *         in the supply or an error occurred, in which case it must be read directly.
+     */
+    bool Reader::readDecompressedRecord(uint32_t index) {
+        // Has record already been handed out or is it behind us?
+        if (index < nextDecompressedRecord) {
+            return false;
+        }
+
+        // Jumping ahead past the records in the supply, so restart with this one
+        if (index >= nextRecordToDecompress) {
+            stopDecompression();
+            startDecompression(index);
+        }
+
+        while (true) {
+            auto item = decompressSupply->getToRead();
+
+            if (decompressSupply->haveError()) {
+                // Stop using threads and let the caller's thread run into the error, if any
+                std::cout << "Reader: decompression error, " << decompressSupply->getError() << std::endl;
+                stopDecompression();
+                decompressionThreadCount = 0;
+                readAheadRecords = 0;
+                readAheadBytes = 0;
+                return false;
+            }
+
+            uint32_t recordIndex = item->getRecordIndex();
+            if (recordIndex == index) {
+                // Old current record goes back into the supply to be reused
+                std::swap(inputRecordStream, *(item->getRecord()));
+            }
+            decompressSupply->releaseReader(item);
+            nextDecompressedRecord++;
+            bytesAhead -= recordPositions[recordIndex].getLength();
+
+            // Replace the record just taken with the next in line
+            fillDecompressionSupply();
+
+            if (recordIndex == index) {
+                return true;
+            }
+        }
+    }
+
+
     /**
      * This method can be used to avoid creating additional Reader
      * objects by reusing this one with another buffer.
@@ -173,8 +763,13 @@ namespace evio {
             throw EvioException("null buf arg");
         }
 
+        stopDecompression();
+        sampledRecord = -1;
+
         // Possible no-arg constructor set this to true, change it now
         fromFile = false;
+        memoryMapped = false;
+        mappedFile = nullptr;
 
         close();
 
@@ -185,11 +780,16 @@ namespace evio {
 
         eventIndex.clear();
         eventNodes.clear();
+        recordNodesFound.clear();
+        clearDemandNodes();
         recordPositions.clear();
 
         compressed = false;
         firstEvent = nullptr;
         dictionaryXML.clear();
+        binaryDictionary = nullptr;
+        compressionDictionary = nullptr;
+        inputRecordStream.setCompressionDictionary(nullptr);
         // TODO: set to -1 ???
         sequentialIndex = 0;
         if (firstRecordHeader != nullptr) {
@@ -210,6 +810,31 @@ namespace evio {
     }
 
 
+    /**
+     * Same as {@link #setBuffer(std::shared_ptr<ByteBuffer> &)} except the EvioNodes
+     * representing events are taken from the given pool. It is reset each time a buffer
+     * is scanned, so nodes from a previous buffer must not be used after that.
+     * The pool is kept for following calls to the other setBuffer.
+     *
+     * @param buf  ByteBuffer to be read
+     * @param pool source of EvioNode objects, null to create them.
+     * @throws underflow_error if not enough data in buffer.
+     * @throws EvioException if buf arg is null,
+     *                       not in the proper format, or earlier than version 6
+     */
+    void Reader::setBuffer(std::shared_ptr<ByteBuffer> & buf, std::shared_ptr<EvioNodeSource> const & pool) {
+        nodePool = pool;
+        setBuffer(buf);
+    }
+
+
+    /**
+     * Get the source of EvioNode objects used when scanning buffers, if any.
+     * @return source of EvioNode objects, or null if they are created.
+     */
+    std::shared_ptr<EvioNodeSource> Reader::getNodePool() {return nodePool;}
+
+
     /**
      * Get the name of the file being read.
      * @return name of the file being read or null if none.
@@ -224,6 +849,160 @@ namespace evio {
     size_t Reader::getFileSize() const {return fileSize;}
 
 
+    /**
+     * Send part of an open file to a socket. On Linux, the data is moved by the
+     * kernel with sendfile, otherwise it's read into a buffer and written.
+     * @param fd     file descriptor of file.
+     * @param sock   socket file descriptor.
+     * @param offset position in file in bytes of data to send.
+     * @param bytes  number of bytes to send.
+     * @throws EvioException if error reading file or writing to socket.
+     */
+    void Reader::sendFileBytes(int fd, int sock, size_t offset, size_t bytes) {
+#ifdef __linux__
+        auto off = (off_t) offset;
+        while (bytes > 0) {
+            // Linux sends at most about 2GB in one call
+            size_t chunk = bytes > 0x40000000 ? 0x40000000 : bytes;
+            ssize_t n = ::sendfile(sock, fd, &off, chunk);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error sending file, ") + std::strerror(errno));
+            }
+            if (n == 0) {
+                throw EvioException("file shorter than expected");
+            }
+            bytes -= n;
+        }
+#else
+        std::vector<char> buf(65536);
+        while (bytes > 0) {
+            size_t chunk = bytes > buf.size() ? buf.size() : bytes;
+            ssize_t n = ::pread(fd, buf.data(), chunk, (off_t) offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error reading file, ") + std::strerror(errno));
+            }
+            if (n == 0) {
+                throw EvioException("file shorter than expected");
+            }
+            for (ssize_t sent = 0; sent < n; ) {
+                ssize_t w = ::write(sock, buf.data() + sent, n - sent);
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    throw EvioException(std::string("error writing to socket, ") + std::strerror(errno));
+                }
+                sent += w;
+            }
+            offset += n;
+            bytes  -= n;
+        }
+#endif
+    }
+
+
+    /**
+     * Send the file being read over a socket in the form read by a {@link SocketReader}:
+     * the file header and whatever follows it, each record, and a trailer. The data goes
+     * straight from the file to the socket (by way of sendfile on Linux) without being
+     * read into this process, which makes this a fast way to forward a closed file, and
+     * it doesn't change the state of this reader.<p>
+     *
+     * Records are sent as found when the file was scanned. The file's own trailer is sent
+     * if it follows the last record. If it doesn't, as when the file's writer never closed
+     * it, a trailer header with no index is made and sent in its place.
+     *
+     * @param sock connected socket file descriptor.
+     * @return number of bytes sent.
+     * @throws EvioException if not reading a file, this reader is closed,
+     *                       or error reading file or writing to socket.
+     */
+    size_t Reader::sendToSocket(int sock) {
+        if (!fromFile) {
+            throw EvioException("not reading a file");
+        }
+        if (closed) {
+            throw EvioException("object closed");
+        }
+
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw EvioException("cannot open " + fileName + ", " + std::strerror(errno));
+        }
+
+        size_t sent = 0;
+        try {
+            struct stat fileInfo {};
+            if (::fstat(fd, &fileInfo) != 0) {
+                throw EvioException(std::string("cannot find file size, ") + std::strerror(errno));
+            }
+            auto size = (size_t) fileInfo.st_size;
+
+            // File header, index and user header, then records, sent in contiguous pieces
+            size_t start = 0;
+            size_t end = recordPositions.empty() ? fileHeader.getLength() :
+                                                   recordPositions.front().getPosition();
+            uint32_t recordCount = 0;
+            for (auto & rec : recordPositions) {
+                // Leave off an incomplete last record
+                if (rec.getPosition() + rec.getLength() > size) break;
+                recordCount++;
+
+                if (rec.getPosition() != end) {
+                    sendFileBytes(fd, sock, start, end - start);
+                    sent += end - start;
+                    start = rec.getPosition();
+                }
+                end = rec.getPosition() + rec.getLength();
+            }
+            sendFileBytes(fd, sock, start, end - start);
+            sent += end - start;
+
+            // Is the file's trailer right after the last record?
+            uint32_t trailerBytes = 0;
+            if (end + RecordHeader::HEADER_SIZE_BYTES <= size) {
+                ByteBuffer buf(RecordHeader::HEADER_SIZE_BYTES);
+                if (::pread(fd, buf.array(), RecordHeader::HEADER_SIZE_BYTES, (off_t) end) ==
+                        (ssize_t) RecordHeader::HEADER_SIZE_BYTES) {
+                    try {
+                        RecordHeader header;
+                        header.readHeader(buf, 0);
+                        if (header.getHeaderType().isTrailer() && end + header.getLength() <= size) {
+                            trailerBytes = header.getLength();
+                        }
+                    }
+                    catch (EvioException & e) {}
+                }
+            }
+
+            if (trailerBytes > 0) {
+                sendFileBytes(fd, sock, end, trailerBytes);
+                sent += trailerBytes;
+            }
+            else {
+                std::vector<uint8_t> trailer(RecordHeader::HEADER_SIZE_BYTES);
+                RecordHeader::writeTrailer(trailer, 0, recordCount + 1, byteOrder, nullptr);
+                for (size_t done = 0; done < trailer.size(); ) {
+                    ssize_t w = ::write(sock, trailer.data() + done, trailer.size() - done);
+                    if (w < 0) {
+                        if (errno == EINTR) continue;
+                        throw EvioException(std::string("error writing to socket, ") + std::strerror(errno));
+                    }
+                    done += w;
+                }
+                sent += trailer.size();
+            }
+        }
+        catch (EvioException & e) {
+            ::close(fd);
+            throw;
+        }
+
+        ::close(fd);
+        return sent;
+    }
+
+
     /**
      * Get the buffer being read, if any.
      * This may not be the buffer given in the constructor or in {@link #setBuffer} if
@@ -291,6 +1070,8 @@ namespace evio {
 
     /**
      * Get the XML format dictionary if there is one.
+     * Programs opening many files with the same dictionary can parse it only once
+     * with {@link EvioXMLDictionary#intern(std::string const &)}.
      * @return XML format dictionary, else null.
      */
     std::string Reader::getDictionary() {
@@ -313,6 +1094,30 @@ namespace evio {
     }
 
 
+    /**
+     * Get the binary form of the dictionary if there is one.
+     * It is stored by {@link EventWriter} after any xml dictionary and first event,
+     * and takes far less time to load than parsing the xml.
+     * @return binary dictionary, else null.
+     */
+    std::shared_ptr<EvioBinaryDictionary> Reader::getBinaryDictionary() {
+        extractDictionaryAndFirstEvent();
+        return binaryDictionary;
+    }
+
+
+    /**
+     * Get the trained dictionary the file's records were compressed with, if any.
+     * It is stored by {@link EventWriter} after any dictionaries and first event,
+     * and is loaded automatically before decompressing records which need it.
+     * @return trained compression dictionary, else null.
+     */
+    std::shared_ptr<CompressionDictionary> Reader::getCompressionDictionary() {
+        extractDictionaryAndFirstEvent();
+        return compressionDictionary;
+    }
+
+
     /**
      * Get a byte array representing the first event.
      * @param size pointer filled with the size, in bytes, of the first event (0 if none).
@@ -374,12 +1179,137 @@ namespace evio {
     std::vector<Reader::RecordPosition> & Reader::getRecordPositions() {return recordPositions;}
 
 
+    /**
+     * Get the sidecar index used to find the records of the file,
+     * if the file had no usable index of its own.
+     * @return sidecar index, or null if none was used.
+     */
+    std::shared_ptr<EventIndexFile> Reader::getSidecarIndex() {return sidecarIndex;}
+
+
     /**
      * Get a reference to the list of EvioNode objects contained in the buffer being read.
      * To be used internally to evio.
      * @return list of EvioNode objects contained in the buffer being read.
      */
-    std::vector<std::shared_ptr<EvioNode>> & Reader::getEventNodes() {return eventNodes;}
+    std::vector<std::shared_ptr<EvioNode>> & Reader::getEventNodes() {
+        findAllEventNodes();
+        return eventNodes;
+    }
+
+
+    /**
+     * Set whether the EvioNode objects representing the events of a buffer are created
+     * when it's scanned, or only when needed. If lazy, scanning an uncompressed buffer
+     * reads just its record headers, and the nodes of all events in a record are
+     * created the first time one of them is asked for. This makes setting a buffer much
+     * faster when few of its events are looked at. Since events are then not checked
+     * until used, {@link #isEvioFormat()} only reflects the records looked at so far.
+     * Takes effect the next time a buffer is set.
+     *
+     * @param lazy if true, create event nodes only when needed.
+     */
+    void Reader::setLazyEventNodes(bool lazy) {lazyEventNodes = lazy;}
+
+
+    /**
+     * Are the EvioNode objects representing the events of a buffer created only when needed?
+     * @return true if event nodes are created only when needed.
+     */
+    bool Reader::isLazyEventNodes() const {return lazyEventNodes;}
+
+
+    /**
+     * Set whether the EvioNode objects representing the events of an uncompressed buffer
+     * are created one at a time, only when asked for. Scanning then reads just record headers.
+     * The first time an event of a record is asked for, an array of the offsets of that
+     * record's events is made from its index, and a node is created for just that event.
+     * Memory used thus grows with the events looked at, not with the size of the buffer.
+     * Takes precedence over {@link #setLazyEventNodes(bool)}.
+     * Calling {@link #getEventNodes()}, or editing the buffer, creates the nodes of all events.
+     * Since events are not checked until used, {@link #isEvioFormat()} only reflects
+     * the events looked at so far. Takes effect the next time a buffer is set.
+     *
+     * @param onDemand if true, create each event's node only when it's asked for.
+     */
+    void Reader::setOnDemandEventNodes(bool onDemand) {onDemandEventNodes = onDemand;}
+
+
+    /**
+     * Are the EvioNode objects representing the events of a buffer created one at a time,
+     * only when asked for?
+     * @return true if each event's node is created only when it's asked for.
+     */
+    bool Reader::isOnDemandEventNodes() const {return onDemandEventNodes;}
+
+
+    /**
+     * Check the data of each record read against the CRC32C in its header, if it
+     * has one (see {@link Writer#setChecksum(bool)}), throwing an exception on
+     * a mismatch instead of handing out corrupted events. Applies to records read
+     * one at a time to get events, not to the scan of an uncompressed buffer.
+     * Should be called before the first read-ahead starts.
+     *
+     * @param verify if true, check records against their checksums.
+     */
+    void Reader::setVerifyChecksums(bool verify) {
+        verifyChecksums = verify;
+        inputRecordStream.setVerifyChecksum(verify);
+    }
+
+
+    /**
+     * Are records read checked against the checksums in their headers?
+     * @return true if records read are checked against their checksums.
+     */
+    bool Reader::getVerifyChecksums() const {return verifyChecksums;}
+
+
+    /**
+     * Read events of uncompressed records in a file without reading their whole record.
+     * Once the header and index of a record are read, {@link #getEvent(uint32_t, uint32_t *)}
+     * reads only the bytes of the event asked for, along with following events up to
+     * minReadBytes in all, so that those close by are got without another read.
+     * Over network filesystems far fewer bytes are then read for random access.
+     * Not done if the file is memory mapped, records are decompressed ahead by threads,
+     * checksums are verified (which needs the whole record), or the shared
+     * {@link RecordCache} is on. Events got other ways still load their whole record.
+     *
+     * @param partial      if true, read uncompressed records in part.
+     * @param minReadBytes fewest bytes read at once, 0 for only the event asked for.
+     */
+    void Reader::setPartialRecordReads(bool partial, uint32_t minReadBytes) {
+        partialReads = partial;
+        partialReadBytes = minReadBytes;
+        partialOffsets.clear();
+        partialData.clear();
+    }
+
+
+    /**
+     * Are events of uncompressed records in a file read without reading their whole record?
+     * @return true if uncompressed records are read in part.
+     */
+    bool Reader::getPartialRecordReads() const {return partialReads;}
+
+
+    /**
+     * Get the node of an event of the buffer, creating the nodes of its record if necessary.
+     * @param index index of event.
+     * @return reference to event's node.
+     */
+    std::shared_ptr<EvioNode> & Reader::eventNodeAt(uint32_t index) {
+        if (nodesOnDemand) {
+            return demandEventNode(index);
+        }
+        if (!recordNodesFound.empty()) {
+            uint32_t record = eventIndex.getRecordOfEvent(index);
+            if (!recordNodesFound[record]) {
+                findEventNodes(record);
+            }
+        }
+        return eventNodes[index];
+    }
 
 
     /**
@@ -390,54 +1320,351 @@ namespace evio {
 
 
     /**
-     * Get the number of events remaining in the file/buffer.
-     * Useful only if doing a sequential read.
-     *
-     * @return number of events remaining in the file/buffer
+     * Get the number of events remaining in the file/buffer.
+     * Useful only if doing a sequential read.
+     *
+     * @return number of events remaining in the file/buffer
+     */
+    uint32_t Reader::getNumEventsRemaining() const {return (eventIndex.getMaxEvents() - sequentialIndex);}
+
+
+    // Methods for current record
+
+
+    /**
+     * Get a byte array representing the next event from the file/buffer while sequentially reading.
+     * If the previous call was to {@link #getPrevEvent}, this will get the event
+     * past what that returned. Once the last event is returned, this will return null.
+     * @param len pointer to int that gets filled with the returned event's len in bytes.
+     * @return byte array representing the next event or null if there is none.
+     * @throws EvioException if file/buffer not in hipo format
+     */
+    std::shared_ptr<uint8_t> Reader::getNextEvent(uint32_t * len) {
+
+        // If the last method called was getPrev, not getNext,
+        // we don't want to get the same event twice in a row, so
+        // increment index. Take into account if this is the
+        // first time getNextEvent or getPrevEvent called.
+        if (sequentialIndex < 0) {
+            sequentialIndex = 0;
+//std::cout << "getNextEvent first time index set to " << sequentialIndex << std::endl;
+        }
+        // else if last call was to getPrevEvent ...
+        else if (!lastCalledSeqNext) {
+            sequentialIndex++;
+//std::cout << "getNextEvent extra increment to " << sequentialIndex << std::endl;
+        }
+
+        skipUnsampledRecords();
+
+        if (isFollowing() && sequentialIndex >= (int32_t)eventIndex.getMaxEvents()) {
+            waitForEvent(sequentialIndex);
+        }
+
+        auto array = getEvent(sequentialIndex++, len);
+        lastCalledSeqNext = true;
+
+        if (array == nullptr) {
+//std::cout << "getNextEvent hit limit at index " << (sequentialIndex - 1) <<
+//             ", set to " << (sequentialIndex - 1) << std::endl << std::endl;
+            sequentialIndex--;
+        }
+//        else {
+//            if (debug) std::cout << "getNextEvent got event " << (sequentialIndex - 1) << std::endl << std::endl;
+//        }
+
+        return array;
+    }
+
+
+    /**
+     * Get a view of the next event from the file/buffer while sequentially reading,
+     * without copying it. This steps through events just as {@link #getNextEvent(uint32_t *)} does.
+     * The view is valid only until another record is read.
+     * @return view of the next event's bytes, empty if there is none.
+     * @throws EvioException if file/buffer not in hipo format
+     */
+    ByteBufferView Reader::getNextEventView() {
+
+        if (sequentialIndex < 0) {
+            sequentialIndex = 0;
+        }
+        else if (!lastCalledSeqNext) {
+            sequentialIndex++;
+        }
+
+        skipUnsampledRecords();
+
+        if (isFollowing() && sequentialIndex >= (int32_t)eventIndex.getMaxEvents()) {
+            waitForEvent(sequentialIndex);
+        }
+
+        auto view = getEventView(sequentialIndex++);
+        lastCalledSeqNext = true;
+
+        if (view.empty()) {
+            sequentialIndex--;
+        }
+
+        return view;
+    }
+
+
+    /**
+     * Get a byte array representing the next event, whose top-level bank has the given
+     * tag and num, from the file/buffer while sequentially reading. Events that do not
+     * match are passed over. Records whose header has a tag filter
+     * (see {@link RecordOutput#setTagFilter(bool)}) showing that they contain no match
+     * are skipped without being read or decompressed.
+     * Once the last matching event is returned, this will return null.
+     *
+     * @param len pointer to int that gets filled with the returned event's len in bytes.
+     * @param tag tag of event's top-level bank.
+     * @param num num of event's top-level bank.
+     * @return byte array representing the next matching event or null if there is none.
+     * @throws EvioException if file/buffer not in hipo format
+     */
+    std::shared_ptr<uint8_t> Reader::getNextEvent(uint32_t * len, uint16_t tag, uint8_t num) {
+
+        if (sequentialIndex < 0) {
+            sequentialIndex = 0;
+        }
+        else if (!lastCalledSeqNext) {
+            sequentialIndex++;
+        }
+        lastCalledSeqNext = true;
+
+        uint32_t maxEvents = eventIndex.getMaxEvents();
+        int64_t checkedRecord = -1;
+        uint32_t wanted = (static_cast<uint32_t>(tag) << 16) | num;
+
+        while (true) {
+            skipUnsampledRecords();
+            maxEvents = eventIndex.getMaxEvents();
+            if ((uint32_t)sequentialIndex >= maxEvents) break;
+
+            // Check each record's filter once, as we enter it
+            uint32_t record = eventIndex.getRecordOfEvent(sequentialIndex);
+            if ((int64_t)record != checkedRecord) {
+                checkedRecord = record;
+                if (!recordMayContain(record, tag, num)) {
+                    sequentialIndex = eventIndex.getFirstEventOfRecord(record + 1);
+                    continue;
+                }
+            }
+
+            auto array = getEvent(sequentialIndex++, len);
+            if (array == nullptr) {
+                sequentialIndex--;
+                return nullptr;
+            }
+
+            if (*len > 7) {
+                // Tag & num are in the 2nd word of an evio bank
+                uint32_t word;
+                std::memcpy(&word, array.get() + 4, 4);
+                if (byteOrder != ByteOrder::ENDIAN_LOCAL) {
+                    word = SWAP_32(word);
+                }
+                if ((word & 0xffff00ff) == wanted) {
+                    return array;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+
+    /**
+     * Read the header of the record at the given index.
+     * If that record is the one currently loaded, its header is simply copied.
+     * @param index  index of record.
+     * @param header header to fill.
+     * @throws EvioException if header cannot be read.
+     */
+    void Reader::readRecordHeader(uint32_t index, RecordHeader & header) {
+        if (index == currentRecordLoaded && inputRecordStream.getEntries() > 0) {
+            header = *(inputRecordStream.getHeader());
+            return;
+        }
+
+        size_t pos = recordPositions[index].getPosition();
+        if (fromFile && memoryMapped) {
+            header.readHeader(*(mappedFile.get()), pos);
+        }
+        else if (fromFile) {
+            // Read any optional header words too
+            size_t bytes = RecordHeader::MAX_HEADER_SIZE_BYTES;
+            if (fileSize > pos && fileSize - pos < bytes) {
+                bytes = std::max<size_t>(fileSize - pos, RecordHeader::HEADER_SIZE_BYTES);
+            }
+            ByteBuffer headerBuffer(bytes);
+            inStreamRandom.seekg(pos);
+            inStreamRandom.read(reinterpret_cast<char *>(headerBuffer.array()), bytes);
+            header.readHeader(headerBuffer);
+        }
+        else {
+            header.readHeader(*(buffer.get()), pos);
+        }
+    }
+
+
+    /**
+     * Get a record exactly as it is in the file or buffer, header and all, still compressed
+     * if it was, so it can be copied elsewhere without being decompressed or parsed
+     * (see {@link Writer#writeRecord(ByteBufferView const &)}). If reading a buffer or
+     * a memory mapped file, the returned view is of the record in place and storage is
+     * not used. Otherwise the record is read into storage.
+     *
+     * @param index   index of record.
+     * @param storage vector into which the record is read if necessary.
+     * @return view of the record, valid until storage or this reader's buffer or file change.
+     * @throws EvioException if index out of bounds or record cannot be read.
+     */
+    ByteBufferView Reader::getRawRecord(uint32_t index, std::vector<uint8_t> & storage) {
+        if (index >= recordPositions.size()) {
+            throw EvioException("index out of bounds");
+        }
+
+        size_t pos = recordPositions[index].getPosition();
+        uint32_t len = recordPositions[index].getLength();
+
+        if (fromFile && !memoryMapped) {
+            storage.resize(len);
+            inStreamRandom.seekg(pos);
+            inStreamRandom.read(reinterpret_cast<char *>(storage.data()), len);
+            if (inStreamRandom.fail()) {
+                inStreamRandom.clear();
+                throw EvioException("cannot read record " + std::to_string(index));
+            }
+            return ByteBufferView(storage.data(), len, byteOrder);
+        }
+
+        ByteBuffer & buf = fromFile ? *(mappedFile.get()) : *(buffer.get());
+        if (pos + len > buf.limit()) {
+            throw EvioException("record " + std::to_string(index) + " extends past end of data");
+        }
+        return ByteBufferView(buf.array() + buf.arrayOffset() + pos, len, byteOrder);
+    }
+
+
+    /**
+     * Might the record at the given index contain an event whose top-level bank
+     * has the given tag and num? Only the record's header is read, and its tag filter
+     * (see {@link RecordOutput#setTagFilter(bool)}) checked.
+     * @param index index of record.
+     * @param tag   tag to look for.
+     * @param num   num to look for.
+     * @return false if record contains no such event, true if it might
+     *         or if the record has no tag filter.
+     * @throws EvioException if index out of bounds or header cannot be read.
+     */
+    bool Reader::recordMayContain(uint32_t index, uint16_t tag, uint8_t num) {
+        if (index >= recordPositions.size()) {
+            throw EvioException("index out of bounds");
+        }
+        RecordHeader header;
+        readRecordHeader(index, header);
+        return header.mayContain(tag, num);
+    }
+
+
+    /**
+     * Might the record at the given index contain an event whose top-level bank
+     * has the given tag, whatever its num? Only the record's header is read,
+     * and its tag filter (see {@link RecordOutput#setTagFilter(bool)}) checked.
+     * @param index index of record.
+     * @param tag   tag to look for.
+     * @return false if record contains no such event, true if it might
+     *         or if the record has no tag filter.
+     * @throws EvioException if index out of bounds or header cannot be read.
+     */
+    bool Reader::recordMayContainTag(uint32_t index, uint16_t tag) {
+        if (index >= recordPositions.size()) {
+            throw EvioException("index out of bounds");
+        }
+        RecordHeader header;
+        readRecordHeader(index, header);
+        return header.mayContainTag(tag);
+    }
+
+
+    /**
+     * Might the record at the given index contain an event whose timestamp is in the given range?
+     * Only the record's header is read, and its timestamp range
+     * (see {@link RecordOutput#setTimestampExtractor(RecordOutput::TimestampExtractor)}) checked.
+     * @param index index of record.
+     * @param t0    start of range.
+     * @param t1    end of range, inclusive.
+     * @return false if record contains no such event, true if it might
+     *         or if the record has no timestamp range.
+     * @throws EvioException if index out of bounds or header cannot be read.
      */
-    uint32_t Reader::getNumEventsRemaining() const {return (eventIndex.getMaxEvents() - sequentialIndex);}
-
-
-    // Methods for current record
+    bool Reader::recordMayContainTime(uint32_t index, uint64_t t0, uint64_t t1) {
+        if (index >= recordPositions.size()) {
+            throw EvioException("index out of bounds");
+        }
+        RecordHeader header;
+        readRecordHeader(index, header);
+        return header.mayContainTime(t0, t1);
+    }
 
 
     /**
-     * Get a byte array representing the next event from the file/buffer while sequentially reading.
-     * If the previous call was to {@link #getPrevEvent}, this will get the event
-     * past what that returned. Once the last event is returned, this will return null.
-     * @param len pointer to int that gets filled with the returned event's len in bytes.
-     * @return byte array representing the next event or null if there is none.
-     * @throws EvioException if file/buffer not in hipo format
+     * Find the records which may hold events with timestamps in the given range,
+     * using the timestamp range in each record's header
+     * (see {@link RecordOutput#setTimestampExtractor(RecordOutput::TimestampExtractor)}).
+     * Records are taken to be in time order, as streamed data is, so the first one is
+     * found by a binary search and only the headers of a few records outside the range are read.
+     * Records without a timestamp range, such as one holding only a dictionary,
+     * may contain anything and are included if met. Read the events of each record found with
+     * {@link #readRecord(uint32_t)} or {@link #getEvent(uint32_t, uint32_t *)}.
+     *
+     * @param t0      start of range.
+     * @param t1      end of range, inclusive.
+     * @param records vector filled with the indexes of records, in order.
+     * @throws EvioException if a header cannot be read.
      */
-    std::shared_ptr<uint8_t> Reader::getNextEvent(uint32_t * len) {
+    void Reader::getRecordsInTimeRange(uint64_t t0, uint64_t t1, std::vector<uint32_t> & records) {
+        records.clear();
+        if (t0 > t1) return;
+
+        RecordHeader header;
+        auto count = (uint32_t) recordPositions.size();
+
+        // Find the first record whose latest time is not before t0. Records in between
+        // without a timestamp range don't steer the search.
+        uint32_t lo = 0, hi = count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo)/2;
+            uint32_t probe = mid;
+            for (; probe < hi; probe++) {
+                readRecordHeader(probe, header);
+                if (header.hasTimeRange()) break;
+            }
 
-        // If the last method called was getPrev, not getNext,
-        // we don't want to get the same event twice in a row, so
-        // increment index. Take into account if this is the
-        // first time getNextEvent or getPrevEvent called.
-        if (sequentialIndex < 0) {
-            sequentialIndex = 0;
-//std::cout << "getNextEvent first time index set to " << sequentialIndex << std::endl;
-        }
-        // else if last call was to getPrevEvent ...
-        else if (!lastCalledSeqNext) {
-            sequentialIndex++;
-//std::cout << "getNextEvent extra increment to " << sequentialIndex << std::endl;
+            if (probe == hi) {
+                hi = mid;
+            }
+            else if (header.getTimeMax() < t0) {
+                lo = probe + 1;
+            }
+            else {
+                hi = mid;
+            }
         }
 
-        auto array = getEvent(sequentialIndex++, len);
-        lastCalledSeqNext = true;
-
-        if (array == nullptr) {
-//std::cout << "getNextEvent hit limit at index " << (sequentialIndex - 1) <<
-//             ", set to " << (sequentialIndex - 1) << std::endl << std::endl;
-            sequentialIndex--;
+        // Gather records until one starts past t1
+        for (uint32_t i = lo; i < count; i++) {
+            readRecordHeader(i, header);
+            if (header.hasTimeRange() && header.getTimeMin() > t1) {
+                break;
+            }
+            if (header.mayContainTime(t0, t1)) {
+                records.push_back(i);
+            }
         }
-//        else {
-//            if (debug) std::cout << "getNextEvent got event " << (sequentialIndex - 1) << std::endl << std::endl;
-//        }
-
-        return array;
     }
 
 
@@ -506,7 +1733,11 @@ namespace evio {
         }
 
         lastCalledSeqNext = true;
-        return eventNodes[sequentialIndex++];
+        skipUnsampledRecords();
+        if (sequentialIndex >= (int32_t)eventIndex.getMaxEvents()) {
+            return nullptr;
+        }
+        return eventNodeAt(sequentialIndex++);
     }
 
 
@@ -567,14 +1798,23 @@ namespace evio {
             return nullptr;
         }
 
-        if (eventIndex.setEvent(index)) {
-            // If here, the event is in another record
-//std::cout << "[READER] getEvent: read record at index = " << eventIndex.getRecordNumber() << std::endl;
-            readRecord(eventIndex.getRecordNumber());
-        }
+        bool otherRecord = eventIndex.setEvent(index);
+        if (otherRecord || inputRecordStream.getEntries() == 0 ||
+            currentRecordLoaded != eventIndex.getRecordNumber()) {
+            // If the record is seekable, decompress only what holds the event
+            auto event = getSeekableEvent(eventIndex.getRecordNumber(),
+                                          eventIndex.getRecordEventNumber(), len);
+            if (event != nullptr) {
+                return event;
+            }
 
-        if (inputRecordStream.getEntries() == 0) {
-//std::cout << "[READER] getEvent: first time reading record at index = " << eventIndex.getRecordNumber() << std::endl;
+            // If the record is uncompressed, read only what holds the event
+            event = getPartialEvent(eventIndex.getRecordNumber(),
+                                    eventIndex.getRecordEventNumber(), len);
+            if (event != nullptr) {
+                return event;
+            }
+//std::cout << "[READER] getEvent: read record at index = " << eventIndex.getRecordNumber() << std::endl;
             readRecord(eventIndex.getRecordNumber());
         }
 
@@ -583,6 +1823,189 @@ namespace evio {
     }
 
 
+    /**
+     * Get an event of a seekable record (see {@link SeekableCompression}) in a file,
+     * decompressing only the blocks holding the index up to it and the event itself,
+     * without loading the record. The blocks are kept for other events of the same record.
+     * Not done if records are decompressed ahead by threads, if checksums are verified
+     * (which needs the whole record), or if the shared {@link RecordCache} is on,
+     * since whole records are then worth decompressing.
+     *
+     * @param recordIndex index of record.
+     * @param eventNumber index of event in record.
+     * @param len         pointer to int that gets filled with the returned event's len in bytes.
+     * @return copy of the event, or null if record is not seekable or not read this way.
+     * @throws EvioException if record data is malformed.
+     */
+    std::shared_ptr<uint8_t> Reader::getSeekableEvent(uint32_t recordIndex, uint32_t eventNumber, uint32_t *len) {
+        if (!fromFile || useDecompressionSupply() || verifyChecksums ||
+            RecordCache::getInstance().isEnabled()) {
+            return nullptr;
+        }
+
+        // Record already known to be uncompressed and being read in part
+        if (!partialOffsets.empty() && partialRecord == recordIndex) {
+            return nullptr;
+        }
+
+        if (seekableBlocks == nullptr || seekableBlocksRecord != recordIndex) {
+            seekableBlocks = nullptr;
+
+            RecordHeader hdr;
+            readRecordHeader(recordIndex, hdr);
+            if (!hdr.isSeekable() || hdr.getIndexLength() == 0 ||
+                hdr.getPreFilter() != Compressor::NO_FILTER) {
+                return nullptr;
+            }
+
+            loadCompressionDictionary();
+            if (hdr.hasCompressionDictionary() && compressionDictionary == nullptr) {
+                // Let readRecord() report it
+                return nullptr;
+            }
+
+            size_t dataPos = recordPositions[recordIndex].getPosition() + hdr.getHeaderLength();
+            SeekableCompression::DataSource source;
+            if (memoryMapped) {
+                auto file = mappedFile;
+                source = [file, dataPos](uint32_t pos, uint8_t *dest, uint32_t bytes) {
+                    std::memcpy(dest, file->array() + file->arrayOffset() + dataPos + pos, bytes);
+                };
+            }
+            else {
+                source = [this, dataPos](uint32_t pos, uint8_t *dest, uint32_t bytes) {
+                    inStreamRandom.seekg(dataPos + pos);
+                    inStreamRandom.read(reinterpret_cast<char *>(dest), bytes);
+                };
+            }
+
+            uint32_t dataLength = hdr.getIndexLength() + 4*hdr.getUserHeaderLengthWords() +
+                                  4*hdr.getDataLengthWords();
+            seekableBlocks = std::make_shared<SeekableCompression::BlockReader>(
+                    source, hdr.getCompressedDataLength(), dataLength, hdr.getByteOrder(),
+                    hdr.hasCompressionDictionary() ? compressionDictionary.get() : nullptr);
+            seekableBlocksRecord = recordIndex;
+            seekableEventsOffset = hdr.getIndexLength() + 4*hdr.getUserHeaderLengthWords();
+            seekableEntries = hdr.getEntries();
+        }
+
+        if (eventNumber >= seekableEntries) {
+            return nullptr;
+        }
+
+        // The index holds event lengths, so offset of event is the sum of those before it
+        uint32_t offset = 0;
+        for (uint32_t i=0; i < eventNumber; i++) {
+            offset += seekableBlocks->readInt(4*i);
+        }
+        uint32_t length = seekableBlocks->readInt(4*eventNumber);
+
+        auto event = std::shared_ptr<uint8_t>(new uint8_t[length], std::default_delete<uint8_t[]>());
+        seekableBlocks->read(seekableEventsOffset + offset, event.get(), length);
+
+        if (len != nullptr) {
+            *len = length;
+        }
+        return event;
+    }
+
+
+    /**
+     * Get an event of an uncompressed record in a file, reading only the record's header
+     * and index, then the event along with those following it up to
+     * {@link #partialReadBytes}, without loading the record. The index and the bytes
+     * read are kept for other events of the same record.
+     * Only done if set by {@link #setPartialRecordReads(bool, uint32_t)}, and not if reading
+     * a memory mapped file, records are decompressed ahead by threads, checksums are
+     * verified, or the shared {@link RecordCache} is on.
+     *
+     * @param recordIndex index of record.
+     * @param eventNumber index of event in record.
+     * @param len         pointer to int that gets filled with the returned event's len in bytes.
+     * @return copy of the event, or null if record is compressed or not read this way.
+     * @throws EvioException if record index is malformed or file cannot be read.
+     */
+    std::shared_ptr<uint8_t> Reader::getPartialEvent(uint32_t recordIndex, uint32_t eventNumber, uint32_t *len) {
+        if (!partialReads || !fromFile || memoryMapped || useDecompressionSupply() ||
+            verifyChecksums || RecordCache::getInstance().isEnabled()) {
+            return nullptr;
+        }
+
+        if (partialOffsets.empty() || partialRecord != recordIndex) {
+            partialOffsets.clear();
+            partialData.clear();
+
+            RecordHeader hdr;
+            readRecordHeader(recordIndex, hdr);
+            uint32_t entries = hdr.getEntries();
+            if (hdr.isCompressed() || entries == 0 || hdr.getIndexLength() != 4*entries) {
+                return nullptr;
+            }
+
+            size_t indexPos = recordPositions[recordIndex].getPosition() + hdr.getHeaderLength();
+            ByteBuffer index(hdr.getIndexLength());
+            index.order(hdr.getByteOrder());
+            inStreamRandom.seekg(indexPos);
+            inStreamRandom.read(reinterpret_cast<char *>(index.array()), hdr.getIndexLength());
+            if (!inStreamRandom) {
+                inStreamRandom.clear();
+                throw EvioException("cannot read index of record " + std::to_string(recordIndex));
+            }
+
+            // The index holds event lengths, so offset of event is the sum of those before it
+            uint64_t dataBytes = 4*(uint64_t)hdr.getDataLengthWords();
+            uint64_t offset = 0;
+            partialOffsets.resize(entries + 1);
+            for (uint32_t i=0; i < entries; i++) {
+                partialOffsets[i] = offset;
+                offset += index.getUInt(4*i);
+                if (offset > dataBytes) {
+                    partialOffsets.clear();
+                    throw EvioException("bad index in record " + std::to_string(recordIndex));
+                }
+            }
+            partialOffsets[entries] = offset;
+
+            partialEventsPos = indexPos + hdr.getIndexLength() + 4*hdr.getUserHeaderLengthWords();
+            partialRecord = recordIndex;
+        }
+
+        if (eventNumber + 1 >= partialOffsets.size()) {
+            return nullptr;
+        }
+
+        uint32_t start = partialOffsets[eventNumber];
+        uint32_t end   = partialOffsets[eventNumber + 1];
+
+        if (partialData.empty() || start < partialDataStart ||
+            end > partialDataStart + partialData.size()) {
+
+            // Bring along the following events, as far as the record goes
+            uint64_t readEnd = std::min<uint64_t>((uint64_t)start + partialReadBytes, partialOffsets.back());
+            readEnd = std::max<uint64_t>(readEnd, end);
+
+            partialData.resize(readEnd - start);
+            partialDataStart = start;
+            inStreamRandom.seekg(partialEventsPos + start);
+            inStreamRandom.read(reinterpret_cast<char *>(partialData.data()), partialData.size());
+            if (!inStreamRandom) {
+                inStreamRandom.clear();
+                partialData.clear();
+                throw EvioException("cannot read events of record " + std::to_string(recordIndex));
+            }
+        }
+
+        uint32_t length = end - start;
+        auto event = std::shared_ptr<uint8_t>(new uint8_t[length], std::default_delete<uint8_t[]>());
+        std::memcpy(event.get(), partialData.data() + (start - partialDataStart), length);
+
+        if (len != nullptr) {
+            *len = length;
+        }
+        return event;
+    }
+
+
     /**
      * Get a byte array representing the specified event from the file/buffer
      * and place it in the given buf.
@@ -607,7 +2030,8 @@ namespace evio {
             // If here, the event is in the next record
             readRecord(eventIndex.getRecordNumber());
         }
-        if (inputRecordStream.getEntries() == 0) {
+        // The record may not be loaded if its events were got by getSeekableEvent()
+        if (inputRecordStream.getEntries() == 0 || currentRecordLoaded != eventIndex.getRecordNumber()) {
             //std::cout << "[READER] first time reading buffer" << std::endl;
             readRecord(eventIndex.getRecordNumber());
         }
@@ -636,6 +2060,32 @@ namespace evio {
     }
 
 
+    /**
+     * Get a view of the specified event from the file/buffer without copying it.
+     * The view is valid only until another record is read, that is,
+     * until an event in a different record is asked for.
+     * @param index index of specified event within the entire file/buffer,
+     *              contiguous starting at 0.
+     * @return view of the event's bytes, empty if index is out of bounds.
+     * @throws EvioException if file/buffer not in hipo format.
+     */
+    ByteBufferView Reader::getEventView(uint32_t index) {
+
+        if (index >= eventIndex.getMaxEvents()) {
+            return ByteBufferView();
+        }
+
+        if (eventIndex.setEvent(index)) {
+            // If here, the event is in another record
+            readRecord(eventIndex.getRecordNumber());
+        }
+        if (inputRecordStream.getEntries() == 0 || currentRecordLoaded != eventIndex.getRecordNumber()) {
+            readRecord(eventIndex.getRecordNumber());
+        }
+        return inputRecordStream.getEventView(eventIndex.getRecordEventNumber());
+    }
+
+
     /**
      * Returns the length of the event with given index.
      * @param index index of the event
@@ -654,7 +2104,7 @@ namespace evio {
 //std::cout << "[READER] getEventLength: read record" << std::endl;
             readRecord(eventIndex.getRecordNumber());
         }
-        if (inputRecordStream.getEntries() == 0) {
+        if (inputRecordStream.getEntries() == 0 || currentRecordLoaded != eventIndex.getRecordNumber()) {
             // First time reading buffer
 //std::cout << "[READER] getEventLength: first time reading record" << std::endl;
             readRecord(eventIndex.getRecordNumber());
@@ -666,6 +2116,7 @@ namespace evio {
     /**
      * Get an EvioNode representing the specified event from the buffer.
      * If index is out of bounds, nullptr is returned.
+     * If an EvioNodeSource was given, the node is only valid until the next buffer is scanned.
      * @param index index of specified event within the entire buffer,
      *              starting at 0.
      * @return EvioNode representing the specified event or null if
@@ -679,7 +2130,7 @@ namespace evio {
             throw EvioException("index too large or reading from file");
         }
 //std::cout << "     getEventNode: Getting node at index = " << index << std::endl;
-        return eventNodes[index];
+        return eventNodeAt(index);
     }
 
 
@@ -725,16 +2176,47 @@ namespace evio {
      * @throws EvioException if file/buffer not in hipo format
      */
     bool Reader::readRecord(uint32_t index) {
+        EVIO_PROFILE_SCOPE(READER_READ_RECORD);
 //std::cout << "Reader.readRecord:  index = " << index << ", recPos.size() = " << recordPositions.size() <<
 // ", rec pos = " << recordPositions[index].getPosition() << std::endl;
 
         if (index < recordPositions.size()) {
             size_t pos = recordPositions[index].getPosition();
-            if (fromFile) {
-                inputRecordStream.readRecord(inStreamRandom, pos);
+
+            // Another reader of this file may have decompressed this record already
+            bool useCache = fromFile && cacheFileId != 0 && RecordCache::getInstance().isEnabled();
+            if (useCache) {
+                auto entry = RecordCache::getInstance().get(cacheFileId, pos);
+                if (entry != nullptr) {
+                    inputRecordStream.readCachedRecord(entry);
+                    currentRecordLoaded = index;
+                    return true;
+                }
             }
-            else {
-                inputRecordStream.readRecord(*(buffer.get()), pos);
+
+            loadCompressionDictionary();
+            bool loaded = false;
+            if (useDecompressionSupply()) {
+                if (decompressSupply == nullptr) {
+                    startDecompression(index);
+                }
+                loaded = readDecompressedRecord(index);
+            }
+
+            if (!loaded) {
+                if (fromFile && memoryMapped) {
+                    inputRecordStream.readRecordInPlace(mappedFile, pos);
+                }
+                else if (fromFile) {
+                    inputRecordStream.readRecord(inStreamRandom, pos);
+                }
+                else {
+                    inputRecordStream.readRecord(*(buffer.get()), pos);
+                }
+            }
+
+            if (useCache) {
+                RecordCache::getInstance().put(cacheFileId, pos, inputRecordStream.makeCacheEntry());
             }
             currentRecordLoaded = index;
             return true;
@@ -746,7 +2228,7 @@ namespace evio {
     /** Extract dictionary and first event from file/buffer if possible, else do nothing. */
     void Reader::extractDictionaryAndFirstEvent() {
         // If already read & parsed ...
-        if (dictionaryXML.length() > 0 || firstEvent != nullptr) {
+        if (dictionaryXML.length() > 0 || firstEvent != nullptr || compressionDictionary != nullptr) {
             return;
         }
 
@@ -808,9 +2290,13 @@ namespace evio {
 
         // First event comes next
         if (firstRecordHeader->hasFirstEvent()) {
-            firstEvent = record.getEvent(evIndex, &len);
+            firstEvent = record.getEvent(evIndex++, &len);
             firstEventSize = len;
         }
+
+        if (firstRecordHeader->hasDictionary()) {
+            extractBinaryDictionary(record, evIndex);
+        }
     }
 
 
@@ -819,7 +2305,8 @@ namespace evio {
 //std::cout << "extractDictionaryFromFile: IN, hasFirst = " << fileHeader.hasFirstEvent() << std::endl;
 
         // If no dictionary or first event ...
-        if (!fileHeader.hasDictionary() && !fileHeader.hasFirstEvent()) {
+        if (!fileHeader.hasDictionary() && !fileHeader.hasFirstEvent() &&
+            !fileHeader.hasCompressionDictionary()) {
             return;
         }
 
@@ -866,9 +2353,81 @@ namespace evio {
 
         // First event comes next
         if (fileHeader.hasFirstEvent()) {
-            firstEvent = record.getEvent(evIndex, &len);
+            firstEvent = record.getEvent(evIndex++, &len);
             firstEventSize = len;
         }
+
+        if (fileHeader.hasDictionary()) {
+            extractBinaryDictionary(record, evIndex);
+        }
+
+        if (fileHeader.hasCompressionDictionary()) {
+            extractCompressionDictionary(record, evIndex);
+        }
+    }
+
+
+    /**
+     * Look for a binary form of the dictionary in the common record, following
+     * the xml dictionary and first event. Older files won't have one.
+     * @param record common record.
+     * @param index  index of event in record which may be the binary dictionary.
+     */
+    void Reader::extractBinaryDictionary(RecordInput & record, uint32_t index) {
+        if (index >= record.getEntries()) {
+            return;
+        }
+
+        uint32_t len;
+        auto bytes = record.getEvent(index, &len);
+        if (!EvioBinaryDictionary::isBinaryDictionary(bytes.get(), len)) {
+            return;
+        }
+
+        try {
+            binaryDictionary = std::make_shared<EvioBinaryDictionary>(
+                    std::vector<uint8_t>(bytes.get(), bytes.get() + len));
+        }
+        catch (EvioException & e) {
+            // Not in proper format, xml dictionary is still there
+            binaryDictionary = nullptr;
+        }
+    }
+
+
+    /**
+     * Look for the trained compression dictionary in the common record,
+     * which is its last event, and give it to the record stream.
+     * @param record common record.
+     * @param index  index of first event in record which may be the compression dictionary.
+     */
+    void Reader::extractCompressionDictionary(RecordInput & record, uint32_t index) {
+        uint32_t len;
+        for (uint32_t i = record.getEntries(); i > index; i--) {
+            auto bytes = record.getEvent(i - 1, &len);
+            if (CompressionDictionary::isCompressionDictionary(bytes.get(), len)) {
+                try {
+                    compressionDictionary = CompressionDictionary::fromEvent(bytes.get(), len);
+                    inputRecordStream.setCompressionDictionary(compressionDictionary);
+                }
+                catch (EvioException & e) {
+                    // Records needing it cannot be decompressed, which is reported then
+                    compressionDictionary = nullptr;
+                }
+                return;
+            }
+        }
+    }
+
+
+    /**
+     * If the file's records may be compressed with a trained dictionary,
+     * make sure it's loaded before any is decompressed.
+     */
+    void Reader::loadCompressionDictionary() {
+        if (fromFile && compressionDictionary == nullptr && fileHeader.hasCompressionDictionary()) {
+            extractDictionaryAndFirstEvent();
+        }
     }
 
 
@@ -1089,6 +2648,11 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
         // eventPlace is the place of each event (evio or not) with repect to each other (0, 1, 2 ...)
         uint32_t eventPlace = 0, byteLen;
         eventNodes.clear();
+        recordNodesFound.clear();
+        clearDemandNodes();
+        if (nodePool != nullptr) {
+            nodePool->reset();
+        }
         recordPositions.clear();
         eventIndex.clear();
         // TODO: this should NOT change in records in 1 buffer, only BETWEEN buffers!!!!!!!!!!!!
@@ -1188,7 +2752,10 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
                         // If the event is in evio format, parse it a bit
 //std::cout << "      try extracting event " << i << ", pos = " << position << ", record pos = " << recordPos <<
 //             ", place = " << (eventPlace + i) << std::endl;
-                        auto node = EvioNode::extractEventNode(bigEnoughBuf, recordPos,
+                        auto node = (nodePool == nullptr) ?
+                                    EvioNode::extractEventNode(bigEnoughBuf, recordPos,
+                                                               position, eventPlace + i) :
+                                    EvioNode::extractEventNode(bigEnoughBuf, *nodePool, recordPos,
                                                                position, eventPlace + i);
                         byteLen = node->getTotalBytes();
 //std::cout << "      event (evio)" << i << ", pos = " << node->getPosition() <<
@@ -1266,15 +2833,20 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
 
         // Start at the buffer's initial position
         size_t position  = bufferOffset;
-        size_t recordPos = bufferOffset;
         ssize_t bytesLeft = bufferLimit - bufferOffset;
 
         // Keep track of the # of records, events, and valid words in file/buffer
         uint32_t eventPlace = 0;
         eventNodes.clear();
+        recordNodesFound.clear();
+        clearDemandNodes();
+        if (nodePool != nullptr) {
+            nodePool->reset();
+        }
         recordPositions.clear();
         eventIndex.clear();
         recordNumberExpected = 1;
+        nodesOnDemand = onDemandEventNodes;
 
         while (bytesLeft >= RecordHeader::HEADER_SIZE_BYTES) {
 
@@ -1285,7 +2857,6 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
             // Only sets the byte order of headerBuffer
             recordHeader.readHeader(headerBuffer);
             uint32_t eventCount = recordHeader.getEntries();
-            uint32_t recordHeaderLen = recordHeader.getHeaderLength();
             uint32_t recordBytes = recordHeader.getLength();
 
             // Save the first record header
@@ -1319,78 +2890,255 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
             // Track # of events in this record for event index handling
             eventIndex.addEventSize(eventCount);
 
-            // Find & store the index of event sizes (words)
-            std::vector<uint32_t> eventLengths;
-            if (eventCount > 0) {
-                // Place in buffer to start reading event lengths (
-                uint32_t lenIndex = position + recordHeaderLen;
+            if (nodesOnDemand) {
+                // Offsets of this record's events are found when first needed
+                recordEventOffsets.emplace_back();
+                position  += recordBytes;
+                bytesLeft -= recordBytes;
+            }
+            else if (lazyEventNodes) {
+                // Leave room for this record's nodes, found when first needed
+                eventNodes.resize(eventPlace + eventCount);
+                recordNodesFound.push_back(eventCount == 0);
+                position  += recordBytes;
+                bytesLeft -= recordBytes;
+            }
+            else {
+                position  = extractEventNodes(position, recordHeader, eventPlace, eventNodes);
+                bytesLeft = bufferLimit - position;
+            }
+
+            eventPlace += eventCount;
+        }
+
+        buffer->position(bufferOffset);
+    }
+
+
+    /**
+     * Create the EvioNode objects of all events in one record of the uncompressed buffer.
+     * Nodes are not created for events not in evio format, in which case {@link #evioFormat}
+     * is set to false.
+     *
+     * @param recordPos    position of record in buffer.
+     * @param recordHeader header of record, already read.
+     * @param eventPlace   index of record's first event in buffer.
+     * @param nodes        vector to which nodes are added.
+     * @return position in buffer just past record's last event.
+     * @throws EvioException if buffer not in the proper format.
+     */
+    size_t Reader::extractEventNodes(size_t recordPos, RecordHeader & recordHeader, uint32_t eventPlace,
+                                     std::vector<std::shared_ptr<EvioNode>> & nodes) {
+
+        uint32_t eventCount = recordHeader.getEntries();
+
+        // Find & store the index of event sizes (words)
+        std::vector<uint32_t> eventLengths;
+        if (eventCount > 0) {
+            // Place in buffer to start reading event lengths (
+            uint32_t lenIndex = recordPos + recordHeader.getHeaderLength();
+
+            for (int i=0; i < eventCount; i++) {
+                uint32_t evLen = buffer->getUInt(lenIndex);
+                eventLengths.push_back(evLen);
+                lenIndex += 4;
+            }
+        }
+
+        // Hop over record header, user header, and index to events
+        size_t position = recordPos +
+                          recordHeader.getHeaderLength() +
+                          4*recordHeader.getUserHeaderLengthWords() + // This takes padding into account
+                          recordHeader.getIndexLength();
+
+        // Do this because extractEventNode uses the buffer position
+        buffer->position(position);
+
+        // For each event in record, store its location
+        for (int i=0; i < eventCount; i++) {
+
+            uint32_t byteLen;
+
+            // Is the length we get from the first word of an evio bank/event (bytes)
+            // the same as the length we got from the record header? If not, it's not evio.
+            bool isEvio = 4*(buffer->getUInt(position) + 1) == eventLengths[i];
+
+            if (isEvio) {
+                try {
+                    // If the event is in evio format, parse it a bit
+                    auto node = (nodePool == nullptr) ?
+                           EvioNode::extractEventNode(buffer, recordPos,
+                                                      position, eventPlace + i) :
+                           EvioNode::extractEventNode(buffer, *nodePool, recordPos,
+                                                      position, eventPlace + i);
+                    byteLen = node->getTotalBytes();
+                    nodes.push_back(node);
+                }
+                catch (std::exception & e) {
+                    // If we're here, the event is not in evio format
+
+                    // The problem with doing things in the following way
+                    // (throwing an exception if the event is NOT is evio format)
+                    // is that the exception throwing mechanism is not a good way to
+                    // handle normal logic flow. But not sure what else can be done.
+                    // This should only happen very, very seldom.
+
+                    byteLen = eventLengths[i];
+                    evioFormat = false;
+                }
+            }
+            else {
+                // If we're here, the event is not in evio format, so just use the length we got
+                // previously from the record index.
+                byteLen = eventLengths[i];
+                evioFormat = false;
+            }
+
+            // Hop over event
+            position += byteLen;
+            if (byteLen < 8 || position > bufferLimit) {
+                throw EvioException("Bad evio format: bad bank length");
+            }
+        }
+
+        return position;
+    }
+
+
+    /**
+     * Create the EvioNode objects of all events in one record of the uncompressed buffer
+     * if {@link #setLazyEventNodes(bool)} kept them from being created when it was scanned.
+     * @param recordIndex index of record.
+     * @throws EvioException if buffer not in the proper format.
+     */
+    void Reader::findEventNodes(uint32_t recordIndex) {
+        if (recordIndex >= recordNodesFound.size() || recordNodesFound[recordIndex]) return;
+
+        ByteBuffer headerBuffer(RecordHeader::HEADER_SIZE_BYTES);
+        RecordHeader recordHeader;
+
+        size_t recordPos = recordPositions[recordIndex].getPosition();
+        buffer->position(recordPos);
+        buffer->getBytes(headerBuffer.array(), RecordHeader::HEADER_SIZE_BYTES);
+        recordHeader.readHeader(headerBuffer);
+
+        uint32_t eventPlace = eventIndex.getFirstEventOfRecord(recordIndex);
+        std::vector<std::shared_ptr<EvioNode>> nodes;
+        nodes.reserve(recordHeader.getEntries());
+        extractEventNodes(recordPos, recordHeader, eventPlace, nodes);
+        buffer->position(bufferOffset);
+
+        // Nodes are missing for any events not in evio format
+        if (nodes.size() == recordHeader.getEntries()) {
+            std::move(nodes.begin(), nodes.end(), eventNodes.begin() + eventPlace);
+        }
+        recordNodesFound[recordIndex] = true;
+    }
+
+
+    /**
+     * Get the node of an event of the buffer when nodes are created on demand,
+     * creating it, and the offsets of its record's events, if necessary.
+     * @param index index of event.
+     * @return reference to event's node, null if event is not in evio format.
+     * @throws EvioException if buffer not in the proper format.
+     */
+    std::shared_ptr<EvioNode> & Reader::demandEventNode(uint32_t index) {
+        auto it = demandNodes.find(index);
+        if (it != demandNodes.end()) {
+            return it->second;
+        }
+
+        ByteBuffer headerBuffer(RecordHeader::HEADER_SIZE_BYTES);
+        RecordHeader recordHeader;
 
-                for (int i=0; i < eventCount; i++) {
-                    uint32_t evLen = buffer->getUInt(lenIndex);
-                    eventLengths.push_back(evLen);
-                    lenIndex += 4;
-                }
-            }
+        uint32_t record = eventIndex.getRecordOfEvent(index);
+        size_t recordPos = recordPositions[record].getPosition();
+        buffer->position(recordPos);
+        buffer->getBytes(headerBuffer.array(), RecordHeader::HEADER_SIZE_BYTES);
+        recordHeader.readHeader(headerBuffer);
 
-            // Hop over record header, user header, and index to events
-            uint32_t byteLen =   recordHeader.getHeaderLength() +
-                               4*recordHeader.getUserHeaderLengthWords() + // This takes padding into account
-                                 recordHeader.getIndexLength();
-            position  += byteLen;
-            bytesLeft -= byteLen;
+        // Offsets of events come from the index of event lengths
+        auto & offsets = recordEventOffsets[record];
+        if (offsets.empty()) {
+            uint32_t eventCount = recordHeader.getEntries();
+            size_t lenIndex = recordPos + recordHeader.getHeaderLength();
+            offsets.reserve(eventCount + 1);
+            offsets.push_back(0);
+            for (uint32_t i=0; i < eventCount; i++) {
+                offsets.push_back(offsets.back() + buffer->getUInt(lenIndex + 4*i));
+            }
+        }
 
-            // Do this because extractEventNode uses the buffer position
-            buffer->position(position);
+        uint32_t i = index - eventIndex.getFirstEventOfRecord(record);
+        uint32_t eventLength = offsets[i+1] - offsets[i];
+        size_t position = recordPos +
+                          recordHeader.getHeaderLength() +
+                          4*recordHeader.getUserHeaderLengthWords() +
+                          recordHeader.getIndexLength() + offsets[i];
+        if (eventLength < 8 || position + eventLength > bufferLimit) {
+            buffer->position(bufferOffset);
+            throw EvioException("Bad evio format: bad bank length");
+        }
 
-            // For each event in record, store its location
-            for (int i=0; i < eventCount; i++) {
+        auto & node = demandNodes[index];
 
-                // Is the length we get from the first word of an evio bank/event (bytes)
-                // the same as the length we got from the record header? If not, it's not evio.
-                bool isEvio = 4*(buffer->getUInt(position) + 1) == eventLengths[i];
+        // Is the first word of an evio bank/event the same length as in the index?
+        if (4*(buffer->getUInt(position) + 1) == eventLength) {
+            try {
+                buffer->position(position);
+                node = (nodePool == nullptr) ?
+                       EvioNode::extractEventNode(buffer, recordPos, position, index) :
+                       EvioNode::extractEventNode(buffer, *nodePool, recordPos, position, index);
+            }
+            catch (std::exception & e) {
+                evioFormat = false;
+            }
+        }
+        else {
+            evioFormat = false;
+        }
 
-                std::shared_ptr<EvioNode> node;
+        buffer->position(bufferOffset);
+        return node;
+    }
 
-                if (isEvio) {
-                    try {
-                        // If the event is in evio format, parse it a bit
-                        node = EvioNode::extractEventNode(buffer, recordPos,
-                                                      position, eventPlace + i);
-                        byteLen = node->getTotalBytes();
-                        eventNodes.push_back(node);
-                    }
-                    catch (std::exception & e) {
-                        // If we're here, the event is not in evio format
 
-                        // The problem with doing things in the following way
-                        // (throwing an exception if the event is NOT is evio format)
-                        // is that the exception throwing mechanism is not a good way to
-                        // handle normal logic flow. But not sure what else can be done.
-                        // This should only happen very, very seldom.
+    /** Forget the nodes, and event offsets, created on demand. */
+    void Reader::clearDemandNodes() {
+        nodesOnDemand = false;
+        recordEventOffsets.clear();
+        demandNodes.clear();
+    }
 
-                        byteLen = eventLengths[i];
-                        evioFormat = false;
-                    }
-                }
-                else {
-                    // If we're here, the event is not in evio format, so just use the length we got
-                    // previously from the record index.
-                    byteLen = eventLengths[i];
-                    evioFormat = false;
-                }
 
-                // Hop over event
-                position  += byteLen;
-                bytesLeft -= byteLen;
-                if (byteLen < 8 || bytesLeft < 0) {
-                    throw EvioException("Bad evio format: bad bank length");
+    /** Create the EvioNode objects of all events not yet created because of lazy scanning. */
+    void Reader::findAllEventNodes() {
+        if (nodesOnDemand) {
+            uint32_t eventCount = eventIndex.getMaxEvents();
+            eventNodes.clear();
+            eventNodes.reserve(eventCount);
+            for (uint32_t i=0; i < eventCount; i++) {
+                auto & node = demandEventNode(i);
+                // Nodes weren't created for any events not in evio format
+                if (node != nullptr) {
+                    eventNodes.push_back(std::move(node));
                 }
+                demandNodes.erase(i);
             }
+            clearDemandNodes();
+            return;
+        }
 
-            eventPlace += eventCount;
+        if (recordNodesFound.empty()) return;
+
+        for (uint32_t i=0; i < recordNodesFound.size(); i++) {
+            findEventNodes(i);
         }
+        recordNodesFound.clear();
 
-        buffer->position(bufferOffset);
+        // Nodes weren't created for any events not in evio format
+        eventNodes.erase(std::remove(eventNodes.begin(), eventNodes.end(), nullptr), eventNodes.end());
     }
 
 
@@ -1439,10 +3187,23 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
                                 fileHeader.getUserHeaderLengthPadding();
 
         int recordCount = 0;
+        scanEnd = recordPosition;
+        lastRecordFound = false;
         while (recordPosition < maximumSize) {
             inStreamRandom.seekg(recordPosition);
             inStreamRandom.read(headerBytes, RecordHeader::HEADER_SIZE_BYTES);
-            recordHeader.readHeader(headerBuffer);
+            if (followMode) {
+                // Space past what has been written may be reserved and empty
+                try {
+                    recordHeader.readHeader(headerBuffer);
+                }
+                catch (EvioException & e) {
+                    break;
+                }
+            }
+            else {
+                recordHeader.readHeader(headerBuffer);
+            }
 //std::cout << "forceScanFile: record header " << recordCount << " @ pos = " <<
 //     recordPosition << " -->" << std::endl << recordHeader.toString() << std::endl;
             recordCount++;
@@ -1470,19 +3231,249 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
             }
 
             recordLen = recordHeader.getLength();
+            // A file still being written may end in a partial record, leave it for later
+            if (recordLen < (int)RecordHeader::HEADER_SIZE_BYTES || recordPosition + recordLen > fileSize) {
+                break;
+            }
             // Create a new RecordPosition object and store in vector
             recordPositions.emplace_back(recordPosition, recordLen, recordHeader.getEntries());
             // Track # of events in this record for event index handling
             eventIndex.addEventSize(recordHeader.getEntries());
             recordPosition += recordLen;
+            scanEnd = recordPosition;
+
+            if (recordHeader.getHeaderType().isTrailer() || recordHeader.isLastRecord()) {
+                lastRecordFound = true;
+                break;
+            }
         }
 //std::cout << "NUMBER OF RECORDS " << recordPositions.size() << std::endl;
     }
 
 
+    /**
+     * Find the records of a damaged file, for example one left without a trailer and cut
+     * short when its writer crashed, or one with corrupted records. Unlike
+     * {@link #forceScanFile()}, which hops from header to header and stops at the first bad
+     * one, this reads the whole file. The file is split into one chunk per thread and each
+     * thread looks for the record magic number at every word of its chunk, keeping candidates
+     * which read as a valid record header and fit in the file. The chain of records is then
+     * followed from the first record. Where it is broken, it continues at the next candidate
+     * past the damage, so only records which are damaged or cut short are lost.
+     * Trailers are left out.<p>
+     *
+     * Nothing else about the file is checked. Use {@link EventIndexFile#recover} to make a
+     * sidecar index of the records found so that a Reader can open the file.
+     *
+     * @param fileName name of evio version 6 file.
+     * @param threads  number of threads to search with, 0 for one per cpu core.
+     * @return position, length and event count of each record found, in file order.
+     * @throws EvioException if file cannot be read or its file header is not evio version 6.
+     */
+    std::vector<Reader::RecordPosition> Reader::recoverRecords(std::string const & fileName, uint32_t threads) {
+
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            throw EvioException("error opening file " + fileName);
+        }
+        size_t fileSz = file.tellg();
+
+        ByteBuffer headerBuffer(FileHeader::HEADER_SIZE_BYTES);
+        file.seekg(0L);
+        file.read(reinterpret_cast<char *>(headerBuffer.array()), FileHeader::HEADER_SIZE_BYTES);
+        if (file.fail()) {
+            throw EvioException("error reading file header of " + fileName);
+        }
+        FileHeader fHeader;
+        fHeader.readHeader(headerBuffer);
+        ByteOrder order = fHeader.getByteOrder();
+
+        size_t firstPosition = fHeader.getHeaderLength() +
+                               fHeader.getUserHeaderLength() +
+                               fHeader.getIndexLength() +
+                               fHeader.getUserHeaderLengthPadding();
+
+        std::vector<RecordPosition> records;
+        if (firstPosition + RecordHeader::HEADER_SIZE_BYTES > fileSz) {
+            return records;
+        }
+
+        if (threads == 0) threads = std::max(1U, boost::thread::hardware_concurrency());
+
+        // Records start on word boundaries, so chunks do too
+        size_t words = (fileSz - firstPosition) / 4;
+        size_t chunkWords = (words + threads - 1) / threads;
+
+        // Magic # as it appears in memory when read from the file
+        uint32_t magic = order.isLocalEndian() ? RecordHeader::HEADER_MAGIC :
+                                                 SWAP_32(RecordHeader::HEADER_MAGIC);
+
+        std::vector<std::vector<RecordPosition>> found(threads);
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<boost::thread> workers;
+
+        for (uint32_t t=0; t < threads; t++) {
+            size_t start = firstPosition + 4*std::min(words, t*chunkWords);
+            size_t end   = firstPosition + 4*std::min(words, (t+1)*chunkWords);
+
+            workers.emplace_back([&, t, start, end]() {
+                try {
+                    std::ifstream in(fileName, std::ios::binary);
+                    if (!in.is_open()) {
+                        throw EvioException("error opening file " + fileName);
+                    }
+                    ByteBuffer header(RecordHeader::HEADER_SIZE_BYTES);
+                    RecordHeader recordHeader;
+
+                    // Read in blocks, each overlapping the next by a header so none is missed
+                    const size_t blockBytes = 16*1024*1024;
+                    std::vector<uint32_t> block((blockBytes + RecordHeader::HEADER_SIZE_BYTES)/4);
+
+                    for (size_t blockStart = start; blockStart < end; blockStart += blockBytes) {
+                        size_t bytes = std::min(blockBytes + RecordHeader::HEADER_SIZE_BYTES,
+                                                fileSz - blockStart);
+                        in.seekg(blockStart);
+                        in.read(reinterpret_cast<char *>(block.data()), bytes);
+                        if (in.fail()) {
+                            throw EvioException("error reading " + fileName);
+                        }
+
+                        size_t scanBytes = std::min(blockBytes, end - blockStart);
+                        for (size_t i=0; 4*i < scanBytes; i++) {
+                            size_t magicWord = i + RecordHeader::MAGIC_OFFSET/4;
+                            if (4*i + RecordHeader::HEADER_SIZE_BYTES > bytes || block[magicWord] != magic) continue;
+
+                            size_t position = blockStart + 4*i;
+                            std::memcpy(header.array(), &block[i], RecordHeader::HEADER_SIZE_BYTES);
+                            try {
+                                recordHeader.readHeader(header);
+                            }
+                            catch (EvioException & e) {
+                                continue;
+                            }
+
+                            uint32_t len = recordHeader.getLength();
+                            if (recordHeader.getHeaderType().isTrailer() ||
+                                recordHeader.getHeaderLength() < RecordHeader::HEADER_SIZE_BYTES ||
+                                len < recordHeader.getHeaderLength() || position + len > fileSz) {
+                                continue;
+                            }
+                            found[t].emplace_back(position, len, recordHeader.getEntries());
+                        }
+                    }
+                }
+                catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+
+        for (auto & w : workers) {
+            w.join();
+        }
+        for (auto & e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+
+        // Chunks are in file order
+        std::vector<RecordPosition> candidates;
+        for (auto & f : found) {
+            candidates.insert(candidates.end(), f.begin(), f.end());
+        }
+
+        // Follow the chain of records. Candidates inside an accepted record are
+        // false ones in its data. If a record is missing, continue past it.
+        size_t position = firstPosition;
+        auto it = candidates.begin();
+        while (true) {
+            it = std::lower_bound(it, candidates.end(), position,
+                                  [](RecordPosition const & r, size_t pos) {return r.getPosition() < pos;});
+            if (it == candidates.end()) break;
+
+            records.push_back(*it);
+            position = it->getPosition() + it->getLength();
+        }
+
+        return records;
+    }
+
+
+    /**
+     * Find all records from the sidecar index file, if any, instead of scanning the file.
+     * The index is checked against the file by reading its first and last record headers.
+     * If the file was cut short, the records lost are dropped from the index.
+     * Must be called after the file header has been read.
+     *
+     * @return true if records were found from a sidecar index, false if there is
+     *         no such index or it does not match the file.
+     */
+    bool Reader::loadSidecarIndex() {
+        if (!fromFile) return false;
+
+        auto index = std::make_shared<EventIndexFile>();
+        if (!index->read(EventIndexFile::sidecarName(fileName))) {
+            return false;
+        }
+
+        index->truncate(fileSize);
+        if (index->getRecordCount() < 1) {
+            return false;
+        }
+
+        // First record comes right after file's header + index + user header
+        size_t firstPosition = fileHeader.getHeaderLength() +
+                               fileHeader.getUserHeaderLength() +
+                               fileHeader.getIndexLength() +
+                               fileHeader.getUserHeaderLengthPadding();
+        if (index->getRecordPosition(0) != firstPosition) {
+            return false;
+        }
+
+        ByteBuffer headerBuffer(RecordHeader::HEADER_SIZE_BYTES);
+        auto headerBytes = reinterpret_cast<char *>(headerBuffer.array());
+        uint32_t last = index->getRecordCount() - 1;
+        RecordHeader lastHeader;
+
+        try {
+            inStreamRandom.seekg(index->getRecordPosition(last));
+            inStreamRandom.read(headerBytes, RecordHeader::HEADER_SIZE_BYTES);
+            lastHeader.readHeader(headerBuffer);
+
+            inStreamRandom.seekg(firstPosition);
+            inStreamRandom.read(headerBytes, RecordHeader::HEADER_SIZE_BYTES);
+            firstRecordHeader = std::make_shared<RecordHeader>();
+            firstRecordHeader->readHeader(headerBuffer);
+        }
+        catch (EvioException & e) {
+            return false;
+        }
+
+        if (lastHeader.getLength()  != index->getRecordLength(last) ||
+            lastHeader.getEntries() != index->getRecordEventCount(last)) {
+            return false;
+        }
+
+        compressed = firstRecordHeader->getCompressionType() != Compressor::UNCOMPRESSED;
+
+        eventIndex.clear();
+        recordPositions.clear();
+        for (uint32_t i=0; i < index->getRecordCount(); i++) {
+            recordPositions.emplace_back(index->getRecordPosition(i), index->getRecordLength(i),
+                                         index->getRecordEventCount(i));
+            eventIndex.addEventSize(index->getRecordEventCount(i));
+        }
+
+        // Only record info is needed here, so keep event offsets & lengths small
+        index->compact();
+        sidecarIndex = index;
+        return true;
+    }
+
+
     /**
      * Scans the file to index all the record positions.
-     * It takes advantage of any existing indexes in file.
+     * It takes advantage of any existing indexes in file,
+     * or of a sidecar index file if the file has no usable index of its own.
      * @param force if true, force a file scan even if header
      *              or trailer have index info.
      * @throws IOException   if error reading file
@@ -1498,6 +3489,9 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
 
         eventIndex.clear();
         recordPositions.clear();
+        sidecarIndex = nullptr;
+        // An index, in the file or beside it, is only written once the file is complete
+        lastRecordFound = true;
         // recordNumberExpected = 1;
 
 //std::cout << "\n\nscanFile ---> scanning the file" << std::endl;
@@ -1524,10 +3518,12 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
 //             ", has trailer with index =  " << fileHeader.hasTrailerWithIndex() <<
 //             ", file header has index " << fileHeader.hasIndex() << std::endl;
 
-        // If there is no index, scan file
+        // If there is no index, use a sidecar index or scan file
         if (!fileHasIndex) {
 //std::cout << "scanFile: CALL forceScanFile" << std::endl;
-            forceScanFile();
+            if (!loadSidecarIndex()) {
+                forceScanFile();
+            }
             return;
         }
 
@@ -1544,14 +3540,16 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
                 }
                 else {
                     // Scan if no viable index exists
-                    forceScanFile();
+                    if (!loadSidecarIndex()) {
+                        forceScanFile();
+                    }
                     return;
                 }
             }
         }
 
         // First record position (past file's header + index + user header)
-        uint32_t recordPosition = fileHeader.getLength();
+        size_t recordPosition = fileHeader.getLength();
 //std::cout << "scanFile: record position (past file's header + index + user header) = " << recordPosition << std::endl;
 
         // Move to first record and save the header
@@ -1583,15 +3581,15 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
             indexLength = fileHeader.getIndexLength();
         }
 
-        // Read indexes
-        char index[indexLength];
-        inStreamRandom.read(index, indexLength);
+        // Read indexes (on the heap, since they can be large)
+        std::vector<char> index(indexLength);
+        inStreamRandom.read(index.data(), indexLength);
         // Turn bytes into record lengths & event counts
-        uint32_t intData[indexLength/4];
+        std::vector<uint32_t> intData(indexLength/4);
 
         try {
 //std::cout << "scanFile: transform int array from " << fileHeader.getByteOrder().getName() << std::endl;
-            Util::toIntArray(index, indexLength, fileHeader.getByteOrder(), intData);
+            Util::toIntArray(index.data(), indexLength, fileHeader.getByteOrder(), intData.data());
 
             // Turn record lengths into file positions and store in list
             recordPositions.clear();
@@ -1621,8 +3619,10 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
 
     /**
      * This method removes the data, represented by the given node, from the buffer.
-     * It also marks all nodes taken from that buffer as obsolete.
-     * They must not be used anymore.<p>
+     * It also marks the node and its descendants as obsolete. They must not be used
+     * anymore. All other nodes taken from the buffer stay valid, their positions and lengths
+     * updated. To remove or add many structures, collect them in a {@link StructureEdits}
+     * object and call {@link #applyEdits(StructureEdits const &)} which moves the data only once.<p>
      *
      * @param  removeNode  evio structure to remove from buffer
      * @return ByteBuffer updated to reflect the node removal
@@ -1641,89 +3641,9 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
             return buffer;
         }
 
-        if (firstRecordHeader->getCompressionType() != Compressor::UNCOMPRESSED) {
-            throw EvioException("cannot remove node from buffer of compressed data");
-        }
-
-        bool foundNode = false;
-
-        // Locate the node to be removed ...
-        for (auto & ev : eventNodes) {
-            // See if it's an event ...
-            if (removeNode == ev) {
-                foundNode = true;
-                break;
-            }
-
-            for (std::shared_ptr<EvioNode> const & nd : ev->getAllNodes()) {
-                // The first node in allNodes is the event node
-                if (removeNode == nd) {
-                    foundNode = true;
-                    break;
-                }
-            }
-
-            if (foundNode) {
-                break;
-            }
-        }
-
-        if (!foundNode) {
-            throw EvioException("removeNode not found in any event");
-        }
-
-        // The data these nodes represent will be removed from the buffer,
-        // so the node will be obsolete along with all its descendants.
-        removeNode->setObsolete(true);
-
-        //---------------------------------------------------
-        // Remove structure. Keep using current buffer.
-        // We'll move all data that came after removed node
-        // to where removed node used to be.
-        //---------------------------------------------------
-
-        // Amount of data being removed
-        uint32_t removeDataLen = removeNode->getTotalBytes();
-
-        // Just after removed node (start pos of data being moved)
-        uint32_t startPos = removeNode->getPosition() + removeDataLen;
-
-        // Duplicate buffer shares data, but we need to copy it so use copy constructor.
-        ByteBuffer moveBuffer(*(buffer.get()));
-        // Prepare to move data currently sitting past the removed node
-        moveBuffer.limit(bufferLimit).position(startPos);
-
-        // Set place to put the data being moved - where removed node starts
-        buffer->position(removeNode->getPosition());
-        // Copy it over
-        buffer->put(moveBuffer);
-
-        // Reset some buffer values
-        buffer->position(bufferOffset);
-        bufferLimit -= removeDataLen;
-        buffer->limit(bufferLimit);
-
-        // Reduce lengths of parent node
-        removeNode->getParentNode()->updateLengths(-removeDataLen);
-
-        // Reduce containing record's length
-        uint32_t pos = removeNode->getRecordPosition();
-        // Header length in words
-        uint32_t oldLen = 4*buffer->getInt(pos);
-        buffer->putInt(pos, (oldLen - removeDataLen)/4);
-        // Uncompressed data length in bytes
-        oldLen = buffer->getInt(pos + RecordHeader::UNCOMPRESSED_LENGTH_OFFSET);
-        buffer->putInt(pos + RecordHeader::UNCOMPRESSED_LENGTH_OFFSET, oldLen - removeDataLen);
-
-        // Invalidate all nodes obtained from the last buffer scan
-        for (auto & ev : eventNodes) {
-            ev->setObsolete(true);
-        }
-
-        // Now the evio data in buffer is in a valid state so rescan buffer to update everything
-        scanBuffer();
-
-        return buffer;
+        StructureEdits edits;
+        edits.remove(removeNode);
+        return applyEdits(edits);
     }
 
 
@@ -1741,6 +3661,8 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
      *
      * The given buffer argument must be ready to read with its position and limit
      * defining the limits of the data to copy.
+     * All nodes taken from the buffer stay valid, their positions and lengths updated,
+     * and refer to the new buffer.
      *
      * @param eventNumber number of event to which addBuffer is to be added
      * @param addBuffer buffer containing evio data to add (<b>not</b> evio file format,
@@ -1756,82 +3678,348 @@ std::cout << "findRecInfo: buf cap = " << buf.capacity() << ", offset = " << off
      *                       if object closed
      */
     std::shared_ptr<ByteBuffer> & Reader::addStructure(uint32_t eventNumber, ByteBuffer & addBuffer) {
+        StructureEdits edits;
+        edits.add(eventNumber, addBuffer);
+        return applyEdits(edits);
+    }
+
+
+    /**
+     * This method makes all the given removals and additions of evio structures at once.
+     * Data is moved only once, in a single pass over the buffer. If no more data is added
+     * than removed ahead of any point in the buffer, that is done in place. Otherwise a
+     * new buffer is created and the data copied into it.<p>
+     *
+     * The lengths of all structures containing removed or added ones are updated,
+     * as are the lengths of their records, the records' indexes of event lengths and,
+     * if events are removed, the records' event counts.
+     * The nodes of removed structures, and of all they contain, are obsolete.
+     * All other nodes stay valid, their positions, lengths and places updated,
+     * and refer to the new buffer if one was created. If an event was already scanned,
+     * nodes are made for the structures added to it.
+     *
+     * @param edits removals and additions to make.
+     * @return buffer updated to reflect the edits, new if one was created.
+     * @throws EvioException if object closed;
+     *                       if buffer has compressed data or non-evio format events;
+     *                       if a node to remove was not found in any event;
+     *                       if an event to add to does not exist or is being removed;
+     *                       if data to add is opposite endian to the buffer.
+     */
+    std::shared_ptr<ByteBuffer> & Reader::applyEdits(StructureEdits const & edits) {
 
-        if (addBuffer.remaining() < 8) {
-            throw EvioException("empty or non-evio format buffer arg");
+        if (closed) {
+            throw EvioException("object closed");
         }
 
-        if (addBuffer.order() != byteOrder) {
-            throw EvioException("trying to add wrong endian buffer");
+        if (firstRecordHeader->getCompressionType() != Compressor::UNCOMPRESSED) {
+            throw EvioException("cannot edit buffer of compressed data");
         }
 
-        if (eventNumber < 1 || eventNumber > eventNodes.size()) {
-            throw EvioException("event number out of bounds");
+        if (edits.empty()) {
+            return buffer;
         }
 
-        if (closed) {
-            throw EvioException("object closed");
+        findAllEventNodes();
+        if (!evioFormat) {
+            throw EvioException("cannot edit buffer containing non-evio format events");
+        }
+
+        // Record of each event, and first event of each record
+        size_t recordCount = recordPositions.size();
+        std::vector<uint32_t> recordOf(eventNodes.size());
+        std::vector<uint32_t> firstEventOf(recordCount);
+        uint32_t evNum = 0;
+        for (size_t r = 0; r < recordCount; r++) {
+            firstEventOf[r] = evNum;
+            for (uint32_t i = 0; i < recordPositions[r].getCount() && evNum < eventNodes.size(); i++) {
+                recordOf[evNum++] = r;
+            }
+        }
+
+        // Region of the old buffer to remove and/or data to insert in its place
+        struct Cut {
+            size_t pos;
+            size_t removeBytes;
+            uint8_t const *data;
+            size_t dataBytes;
+        };
+        std::vector<Cut> cuts;
+
+        // Change in each record's length in bytes, and number of its events removed
+        std::vector<int64_t> recordDelta(recordCount, 0);
+        std::vector<uint32_t> recordEventsRemoved(recordCount, 0);
+        std::vector<bool> recordEdited(recordCount, false);
+
+        // Nodes whose length changed
+        std::unordered_set<EvioNode *> changed;
+
+        //---------------------------------------------------
+        // Find what to remove, only the outermost of nested
+        // structures, and make sure each is one of ours
+        //---------------------------------------------------
+        std::unordered_set<EvioNode *> removing;
+        for (auto const & node : edits.getRemovals()) {
+            if (!node->obsolete) removing.insert(node.get());
+        }
+
+        std::vector<std::shared_ptr<EvioNode>> removed;
+        std::unordered_set<EvioNode *> removedSet;
+        for (auto const & node : edits.getRemovals()) {
+            if (node->obsolete || removedSet.count(node.get()) > 0) continue;
+
+            EvioNode *ev = node->izEvent ? node.get() : node->eventNode.get();
+            if (ev == nullptr || ev->place >= eventNodes.size() || eventNodes[ev->place].get() != ev) {
+                throw EvioException("node to remove not found in any event");
+            }
+
+            bool inRemoved = false;
+            for (EvioNode *p = node->parentNode.get(); p != nullptr; p = p->parentNode.get()) {
+                if (removing.count(p) > 0) {
+                    inRemoved = true;
+                    break;
+                }
+            }
+            if (inRemoved) continue;
+
+            removed.push_back(node);
+            removedSet.insert(node.get());
+        }
+
+        //---------------------------------------------------
+        // Additions, placed at the end of events as they are now
+        //---------------------------------------------------
+        std::unordered_map<EvioNode *, uint32_t> addedWords;
+        for (auto const & add : edits.getAdditions()) {
+            if (add.eventNumber < 1 || add.eventNumber > eventNodes.size()) {
+                throw EvioException("event number out of bounds");
+            }
+            if (add.order != byteOrder) {
+                throw EvioException("trying to add wrong endian buffer");
+            }
+
+            auto & ev = eventNodes[add.eventNumber - 1];
+            if (removedSet.count(ev.get()) > 0) {
+                throw EvioException("cannot add to event " + std::to_string(add.eventNumber) +
+                                    " which is being removed");
+            }
+
+            cuts.push_back({ev->pos + ev->getTotalBytes(), 0, add.data.data(), add.data.size()});
+            addedWords[ev.get()] += add.data.size()/4;
+            recordDelta[recordOf[ev->place]] += add.data.size();
+            recordEdited[recordOf[ev->place]] = true;
+        }
+
+        for (auto & ev : addedWords) {
+            ev.first->len     += ev.second;
+            ev.first->dataLen += ev.second;
+            ev.first->data.clear();
+            changed.insert(ev.first);
+        }
+
+        //---------------------------------------------------
+        // Removals, reducing the lengths of all containers
+        //---------------------------------------------------
+        for (auto & node : removed) {
+            uint32_t bytes = node->getTotalBytes();
+            // Position is that of the removed node's event
+            uint32_t r = recordOf[node->izEvent ? node->place : node->eventNode->place];
+
+            cuts.push_back({node->pos, bytes, nullptr, 0});
+            recordEdited[r] = true;
+
+            if (node->izEvent) {
+                // Also remove the event's entry in its record's index of event lengths
+                size_t recPos = recordPositions[r].getPosition();
+                size_t entry = recPos + 4*buffer->getUInt(recPos + RecordHeader::HEADER_LENGTH_OFFSET) +
+                               4*(node->place - firstEventOf[r]);
+                cuts.push_back({entry, 4, nullptr, 0});
+                recordDelta[r] -= bytes + 4;
+                recordEventsRemoved[r]++;
+                continue;
+            }
+
+            for (EvioNode *p = node->parentNode.get(); p != nullptr; p = p->parentNode.get()) {
+                p->len     -= bytes/4;
+                p->dataLen -= bytes/4;
+                p->data.clear();
+                changed.insert(p);
+            }
+            recordDelta[r] -= bytes;
+        }
+
+        if (cuts.empty()) {
+            return buffer;
         }
 
-        auto & eventNode = eventNodes[eventNumber - 1];
+        // In buffer order, insertions before any removal at the same place
+        std::stable_sort(cuts.begin(), cuts.end(), [](Cut const & a, Cut const & b) {
+            if (a.pos != b.pos) return a.pos < b.pos;
+            return a.removeBytes == 0 && b.removeBytes > 0;
+        });
 
-        // Position in byteBuffer just past end of event
-        uint32_t endPos = eventNode->getDataPosition() + 4*eventNode->getDataLength();
+        //---------------------------------------------------
+        // Move data, in place if it never has to move toward the end
+        //---------------------------------------------------
+        int64_t growth = 0;
+        bool inPlace = true;
+        for (auto const & c : cuts) {
+            growth += (int64_t)c.dataBytes - (int64_t)c.removeBytes;
+            if (growth > 0) inPlace = false;
+        }
+
+        std::shared_ptr<ByteBuffer> newBuffer = buffer;
+        size_t read, write;
+        if (inPlace) {
+            read = write = cuts.front().pos;
+        }
+        else {
+            newBuffer = std::make_shared<ByteBuffer>(bufferLimit - bufferOffset + growth);
+            newBuffer->order(byteOrder);
+            read  = bufferOffset;
+            write = 0;
+        }
+
+        uint8_t *src = buffer->array() + buffer->arrayOffset();
+        uint8_t *dst = newBuffer->array() + newBuffer->arrayOffset();
+
+        // Old position just past each cut and how far data after it moves
+        int64_t firstShift = (int64_t)write - (int64_t)read;
+        std::vector<size_t> cutEnds;
+        std::vector<int64_t> shifts;
+        cutEnds.reserve(cuts.size());
+        shifts.reserve(cuts.size());
+
+        for (auto const & c : cuts) {
+            size_t bytes = c.pos - read;
+            std::memmove(dst + write, src + read, bytes);
+            write += bytes;
+            if (c.dataBytes > 0) {
+                std::memcpy(dst + write, c.data, c.dataBytes);
+                write += c.dataBytes;
+            }
+            read = c.pos + c.removeBytes;
+            cutEnds.push_back(read);
+            shifts.push_back((int64_t)write - (int64_t)read);
+        }
+        std::memmove(dst + write, src + read, bufferLimit - read);
+        write += bufferLimit - read;
 
-        // How many bytes are we adding?
-        size_t appendDataLen = addBuffer.remaining();
+        // New position of something not removed, given its old position
+        auto remap = [&cutEnds, &shifts, firstShift](size_t oldPos) -> size_t {
+            size_t k = std::upper_bound(cutEnds.begin(), cutEnds.end(), oldPos) - cutEnds.begin();
+            return oldPos + (k == 0 ? firstShift : shifts[k - 1]);
+        };
 
-        // Make sure it's a multiple of 4
-        if (appendDataLen % 4 != 0) {
-            throw EvioException("data added is not in evio format");
+        if (!inPlace) {
+            bufferOffset = 0;
+            buffer = newBuffer;
+        }
+        bufferLimit = write;
+        buffer->limit(bufferLimit).position(bufferOffset);
+
+        //---------------------------------------------------
+        // Removed nodes are obsolete and no longer in their event
+        //---------------------------------------------------
+        for (auto & node : removed) {
+            node->setObsolete(true);
+            if (!node->izEvent) {
+                auto ev = node->eventNode;
+                node->parentNode->removeChild(node);
+                if (ev != nullptr) ev->removeFromAllNodes(node);
+            }
         }
 
-        //--------------------------------------------
-        // Add new structure to end of specified event
-        //--------------------------------------------
+        //---------------------------------------------------
+        // Remap the rest
+        //---------------------------------------------------
+        std::vector<std::shared_ptr<EvioNode>> keptEvents;
+        keptEvents.reserve(eventNodes.size());
+        std::vector<std::vector<EvioNode *>> recordEvents(recordCount);
+        uint32_t removedBefore = 0;
 
-        // Create a new buffer
-        std::shared_ptr<ByteBuffer> newBuffer = std::make_shared<ByteBuffer>(bufferLimit - bufferOffset + appendDataLen);
-        newBuffer->order(byteOrder);
+        for (auto & ev : eventNodes) {
+            if (ev->obsolete) {
+                if ((int32_t)ev->place < sequentialIndex) removedBefore++;
+                continue;
+            }
 
-        // Copy beginning part of existing buffer into new buffer
-        buffer->limit(endPos).position(bufferOffset);
-        newBuffer->put(buffer);
+            uint32_t r = recordOf[ev->place];
+            uint32_t newPlace = keptEvents.size();
+            for (auto & nd : ev->getAllNodes()) {
+                size_t newPos = remap(nd->pos);
+                nd->dataPos   = newPos + (nd->dataPos - nd->pos);
+                nd->pos       = newPos;
+                nd->recordPos = remap(nd->recordPos);
+                nd->place     = newPlace;
+                if (!inPlace) nd->setBuffer(buffer);
+            }
 
-        // Copy new structure into new buffer
-        newBuffer->put(addBuffer);
+            recordEvents[r].push_back(ev.get());
+            keptEvents.push_back(ev);
+        }
 
-        // Copy ending part of existing buffer into new buffer
-        buffer->limit(bufferLimit).position(endPos);
-        newBuffer->put(buffer);
+        eventNodes.swap(keptEvents);
+        if (sequentialIndex > 0) sequentialIndex -= removedBefore;
 
-        // Get new buffer ready for reading
-        newBuffer->flip();
-        bufferOffset = 0;
-        bufferLimit  = newBuffer->limit();
-        buffer = newBuffer;
+        // Write new lengths of containers
+        for (EvioNode *nd : changed) {
+            uint32_t typ = nd->type;
+            if ((typ == DataType::BANK.getValue()) || (typ == DataType::ALSOBANK.getValue())) {
+                buffer->putInt(nd->pos, nd->len);
+            }
+            else if (buffer->order() == ByteOrder::ENDIAN_BIG) {
+                buffer->putShort(nd->pos + 2, (short) nd->len);
+            }
+            else {
+                buffer->putShort(nd->pos, (short) nd->len);
+            }
+        }
 
-        // Increase lengths of parent nodes
-        auto & addToNode = eventNodes[eventNumber];
-        auto parent = addToNode->getParentNode();
-        parent->updateLengths(appendDataLen);
+        //---------------------------------------------------
+        // Update records' headers and indexes
+        //---------------------------------------------------
+        eventIndex.clear();
+        for (size_t r = 0; r < recordCount; r++) {
+            auto & rp = recordPositions[r];
+            size_t recPos = remap(rp.getPosition());
+            rp.setPosition(recPos);
+
+            if (recordEdited[r]) {
+                uint32_t length = rp.getLength() + recordDelta[r];
+                uint32_t count  = rp.getCount() - recordEventsRemoved[r];
+                rp.setLength(length);
+                rp.setCount(count);
+
+                // Record length in words, uncompressed data length in bytes
+                buffer->putInt(recPos + RecordHeader::RECORD_LENGTH_OFFSET, length/4);
+                uint32_t oldLen = buffer->getUInt(recPos + RecordHeader::UNCOMPRESSED_LENGTH_OFFSET);
+                buffer->putInt(recPos + RecordHeader::UNCOMPRESSED_LENGTH_OFFSET, oldLen + recordDelta[r]);
+
+                if (recordEventsRemoved[r] > 0) {
+                    buffer->putInt(recPos + RecordHeader::EVENT_COUNT_OFFSET, count);
+                    oldLen = buffer->getUInt(recPos + RecordHeader::INDEX_ARRAY_OFFSET);
+                    buffer->putInt(recPos + RecordHeader::INDEX_ARRAY_OFFSET, oldLen - 4*recordEventsRemoved[r]);
+                }
 
-        // Increase containing record's length
-        uint32_t pos = addToNode->getRecordPosition();
-        // Header length in words
-        uint32_t oldLen = 4*buffer->getInt(pos);
-        buffer->putInt(pos, (oldLen + appendDataLen)/4);
-        // Uncompressed data length in bytes
-        oldLen = buffer->getInt(pos + RecordHeader::UNCOMPRESSED_LENGTH_OFFSET);
-        buffer->putInt(pos + RecordHeader::UNCOMPRESSED_LENGTH_OFFSET, oldLen + appendDataLen);
+                // Index of event lengths in bytes
+                size_t entry = recPos + 4*buffer->getUInt(recPos + RecordHeader::HEADER_LENGTH_OFFSET);
+                for (EvioNode *ev : recordEvents[r]) {
+                    buffer->putInt(entry, ev->getTotalBytes());
+                    entry += 4;
+                }
+            }
 
-        // Invalidate all nodes obtained from the last buffer scan
-        for (auto const & ev : eventNodes) {
-            ev->setObsolete(true);
+            eventIndex.addEventSize(rp.getCount());
         }
 
-        // Now the evio data in buffer is in a valid state so rescan buffer to update everything
-        scanBuffer();
+        // Make nodes for what was added to events already scanned
+        for (auto & ev : addedWords) {
+            if (!ev.first->scanned) continue;
+            auto node = ev.first->getThis();
+            EvioNode::scanStructure(node, nodePool.get(),
+                                    node->dataPos + 4*(node->dataLen - ev.second));
+        }
 
         return buffer;
     }
@@ -16,11 +16,17 @@
 #include <cstring>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <fstream>
 #include <ios>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 
 #include "ByteOrder.h"
@@ -28,15 +34,24 @@
 #include "FileHeader.h"
 #include "RecordHeader.h"
 #include "FileEventIndex.h"
+#include "EventIndexFile.h"
 #include "RecordInput.h"
+#include "RecordCache.h"
+#include "SeekableCompression.h"
+#include "RecordInputSupply.h"
+#include "RecordDecompressor.h"
 #include "EvioException.h"
 #include "EvioNode.h"
+#include "EvioNodeSource.h"
+#include "StructureEdits.h"
 #include "IBlockHeader.h"
 #include "Util.h"
 
 
 namespace evio {
 
+    class EvioBinaryDictionary;
+
     /**
      * Reader class that reads files stored in the HIPO format.<p>
      *
@@ -198,10 +213,39 @@ namespace evio {
         std::string fileName {""};
         /** File size in bytes. */
         size_t fileSize = 0;
+        /** Id of file in the shared {@link RecordCache}, 0 if not reading a file. */
+        uint64_t cacheFileId = 0;
         /** File header. */
         FileHeader fileHeader;
         /** Are we reading from file (true) or buffer? */
         bool fromFile = true;
+        /** If true, the file is memory mapped and uncompressed records are read in place. */
+        bool memoryMapped = false;
+        /** Buffer wrapping the memory mapped file if {@link #memoryMapped} is true. */
+        std::shared_ptr<ByteBuffer> mappedFile = nullptr;
+        /** Blocks of the last seekable record events were got from without loading it. */
+        std::shared_ptr<SeekableCompression::BlockReader> seekableBlocks = nullptr;
+        /** Index of record of {@link #seekableBlocks}. */
+        uint32_t seekableBlocksRecord = 0;
+        /** Offset of events in the uncompressed data of {@link #seekableBlocks}. */
+        uint32_t seekableEventsOffset = 0;
+        /** Number of events in the record of {@link #seekableBlocks}. */
+        uint32_t seekableEntries = 0;
+        /** If true, events of uncompressed records in a file are read without loading their records. */
+        bool partialReads = false;
+        /** Fewest bytes read at once when reading part of a record, so nearby events come along. */
+        uint32_t partialReadBytes = 65536;
+        /** Index of record whose event offsets are in {@link #partialOffsets}. */
+        uint32_t partialRecord = 0;
+        /** File position of the first event of {@link #partialRecord}. */
+        size_t partialEventsPos = 0;
+        /** Offsets of that record's events from its first, with one more entry for the end.
+         *  Empty if none read. */
+        std::vector<uint32_t> partialOffsets;
+        /** Bytes of that record's events last read from the file. */
+        std::vector<uint8_t> partialData;
+        /** Offset of {@link #partialData} from that record's first event. */
+        uint32_t partialDataStart = 0;
 
 
         /** Buffer being read. */
@@ -225,10 +269,58 @@ namespace evio {
         bool checkRecordNumberSequence = false;
         /** Object to handle event indexes in context of file and having to change records. */
         FileEventIndex eventIndex;
+        /** Sidecar index used to find records if file has no usable index of its own. */
+        std::shared_ptr<EventIndexFile> sidecarIndex = nullptr;
+
+
+        /** Number of threads decompressing records ahead of sequential reading (0 = none). */
+        uint32_t decompressionThreadCount = 0;
+        /** Supply of records read and decompressed by {@link #decompressorThreads}. */
+        std::shared_ptr<RecordInputSupply> decompressSupply = nullptr;
+        /** Threads reading and decompressing records ahead of sequential reading. */
+        std::vector<RecordDecompressor> decompressorThreads;
+        /** Index of next record to be handed to the decompression threads. */
+        uint32_t nextRecordToDecompress = 0;
+        /** Index of next record to come out of the decompression threads. */
+        uint32_t nextDecompressedRecord = 0;
+        /** Max number of records to read ahead of sequential reading (0 = no limit set). */
+        uint32_t readAheadRecords = 0;
+        /** Max number of file bytes to read ahead of sequential reading (0 = no limit set). */
+        size_t readAheadBytes = 0;
+        /** Number of file bytes of records handed out, but not yet taken back. */
+        size_t bytesAhead = 0;
+
+
+        /** If true, the file is still being written and sequential reading waits for more records. */
+        bool followMode = false;
+        /** Milliseconds to wait for more records while following, &lt; 0 means until file is finished. */
+        int32_t followTimeout = 0;
+        /** Milliseconds between looks at the file size while waiting for more records. */
+        uint32_t followPollPeriod = 100;
+        /** File position just past the last complete record found. */
+        size_t scanEnd = 0;
+        /** Has the trailer or a record marked as last been found? */
+        bool lastRecordFound = false;
+
+
+        /** Fraction of records read when sequentially reading, 1 = all. */
+        double subsampleFraction = 1.;
+        /** Least milliseconds between records read when sequentially reading, 0 = no limit. */
+        uint32_t subsampleInterval = 0;
+        /** Index of the record last picked by subsampling, -1 if none. */
+        int64_t sampledRecord = -1;
+        /** When the record last picked by subsampling was picked. */
+        std::chrono::steady_clock::time_point sampledTime;
+        /** Number of records passed over by subsampling. */
+        uint64_t recordsNotSampled = 0;
 
 
         /** Files may have an xml format dictionary in the user header of the file header. */
         std::string dictionaryXML {""};
+        /** Binary form of dictionary, if EventWriter stored one after the xml & first event. */
+        std::shared_ptr<EvioBinaryDictionary> binaryDictionary = nullptr;
+        /** Trained dictionary needed to decompress records, if EventWriter stored one after the dictionaries. */
+        std::shared_ptr<CompressionDictionary> compressionDictionary = nullptr;
         /** Each file of a set of split CODA files may have a "first" event common to all. */
         std::shared_ptr<uint8_t> firstEvent = nullptr;
         /** First event size in bytes. */
@@ -238,6 +330,25 @@ namespace evio {
 
         /** Stores info of all the (top-level) events in a scanned buffer. */
         std::vector<std::shared_ptr<EvioNode>> eventNodes;
+        /** If not null, source of the EvioNodes in eventNodes, reset each time a buffer is scanned. */
+        std::shared_ptr<EvioNodeSource> nodePool = nullptr;
+        /** If true, the EvioNodes of an uncompressed buffer's events are not created when
+         *  it's scanned, but one record at a time when first asked for. */
+        bool lazyEventNodes = false;
+        /** When lazily creating EvioNodes, which records already have theirs. */
+        std::vector<bool> recordNodesFound;
+        /** If true, the EvioNodes of an uncompressed buffer's events are created one at a time
+         *  when asked for, and only the offsets of events in records looked at are kept. */
+        bool onDemandEventNodes = false;
+        /** Are the EvioNodes of the buffer scanned being created one at a time when asked for? */
+        bool nodesOnDemand = false;
+        /** When creating EvioNodes on demand, offsets of each record's events from its first,
+         *  with one more entry for the end. Empty for records not yet looked at. */
+        std::vector<std::vector<uint32_t>> recordEventOffsets;
+        /** When creating EvioNodes on demand, those created so far, by event index. */
+        std::unordered_map<uint32_t, std::shared_ptr<EvioNode>> demandNodes;
+        /** If true, check each record read against any checksum in its header. */
+        bool verifyChecksums = false;
 
 
         /** Is this object currently closed? */
@@ -267,6 +378,15 @@ namespace evio {
 
 
         void setByteOrder(ByteOrder & order);
+        void mapFile();
+        void startDecompression(uint32_t firstRecord);
+        void stopDecompression();
+        bool readDecompressedRecord(uint32_t index);
+        void fillDecompressionSupply();
+        bool useDecompressionSupply() const;
+        bool waitForEvent(uint32_t index);
+        bool isSampledRecord(uint32_t index);
+        void skipUnsampledRecords();
         static uint32_t getTotalByteCounts(ByteBuffer & buf, uint32_t* info, uint32_t infoLen);
         static uint32_t getTotalByteCounts(std::shared_ptr<ByteBuffer> & buf, uint32_t* info, uint32_t infoLen);
         //static std::string getStringArray(ByteBuffer & buffer, int wrap, int max);
@@ -276,21 +396,52 @@ namespace evio {
 
         Reader();
         explicit Reader(std::string const & filename);
-        Reader(std::string const & filename, bool forceScan);
+        Reader(std::string const & filename, bool forceScan, bool memoryMap = false);
         explicit Reader(std::shared_ptr<ByteBuffer> & buffer, bool checkRecordNumSeq = false);
+        Reader(std::shared_ptr<ByteBuffer> & buffer, std::shared_ptr<EvioNodeSource> const & pool,
+               bool checkRecordNumSeq = false);
 
-        ~Reader() = default;
+        ~Reader();
 
-        void open(std::string const & filename, bool scan = true);
+        void open(std::string const & filename, bool scan = true, bool memoryMap = false);
         void close();
 
         bool isClosed() const;
         bool isFile() const;
+        bool isMemoryMapped() const;
+
+        void setDecompressionThreads(uint32_t threadCount);
+        uint32_t getDecompressionThreads() const;
+        void setReadAhead(uint32_t recordCount, size_t byteCount = 0);
+        uint32_t getReadAheadRecords() const;
+        size_t getReadAheadBytes() const;
+
+        void setFollowMode(bool follow, int32_t timeout = -1, uint32_t pollPeriod = 100);
+        bool isFollowing() const;
+        bool isFileFinished() const;
+        uint32_t findNewRecords();
+
+        void setSubsampling(double fraction, uint32_t intervalMillis = 0);
+        bool isSubsampling() const;
+        double getSubsampleFraction() const;
+        uint32_t getSubsampleInterval() const;
+        uint64_t getRecordsNotSampled() const;
 
         std::string getFileName() const;
         size_t getFileSize() const;
+        size_t sendToSocket(int sock);
 
         void setBuffer(std::shared_ptr<ByteBuffer> & buf);
+        void setBuffer(std::shared_ptr<ByteBuffer> & buf, std::shared_ptr<EvioNodeSource> const & pool);
+        std::shared_ptr<EvioNodeSource> getNodePool();
+        void setLazyEventNodes(bool lazy);
+        bool isLazyEventNodes() const;
+        void setOnDemandEventNodes(bool onDemand);
+        bool isOnDemandEventNodes() const;
+        void setVerifyChecksums(bool verify);
+        bool getVerifyChecksums() const;
+        void setPartialRecordReads(bool partial, uint32_t minReadBytes = 65536);
+        bool getPartialRecordReads() const;
         std::shared_ptr<ByteBuffer> getBuffer();
         size_t getBufferOffset() const;
 
@@ -303,6 +454,8 @@ namespace evio {
         bool isEvioFormat() const;
         std::string getDictionary();
         bool hasDictionary() const;
+        std::shared_ptr<EvioBinaryDictionary> getBinaryDictionary();
+        std::shared_ptr<CompressionDictionary> getCompressionDictionary();
 
         std::shared_ptr<uint8_t> & getFirstEvent(uint32_t *size);
         uint32_t getFirstEventSize();
@@ -312,6 +465,8 @@ namespace evio {
         uint32_t getRecordCount() const;
 
         std::vector<RecordPosition> & getRecordPositions();
+        static std::vector<RecordPosition> recoverRecords(std::string const & fileName, uint32_t threads = 0);
+        std::shared_ptr<EventIndexFile> getSidecarIndex();
         std::vector<std::shared_ptr<EvioNode>> & getEventNodes();
 
         bool getCheckRecordNumberSequence() const;
@@ -319,14 +474,22 @@ namespace evio {
         uint32_t getNumEventsRemaining() const;
 
         std::shared_ptr<uint8_t> getNextEvent(uint32_t * len);
+        std::shared_ptr<uint8_t> getNextEvent(uint32_t * len, uint16_t tag, uint8_t num);
+        ByteBufferView getNextEventView();
         std::shared_ptr<uint8_t> getPrevEvent(uint32_t * len);
 
+        bool recordMayContain(uint32_t index, uint16_t tag, uint8_t num);
+        bool recordMayContainTag(uint32_t index, uint16_t tag);
+        bool recordMayContainTime(uint32_t index, uint64_t t0, uint64_t t1);
+        void getRecordsInTimeRange(uint64_t t0, uint64_t t1, std::vector<uint32_t> & records);
+
         std::shared_ptr<EvioNode> getNextEventNode();
         std::shared_ptr<ByteBuffer> readUserHeader();
 
         std::shared_ptr<uint8_t> getEvent(uint32_t index, uint32_t * len);
         ByteBuffer & getEvent(ByteBuffer & buf, uint32_t index);
         std::shared_ptr<ByteBuffer> getEvent(std::shared_ptr<ByteBuffer> & buf, uint32_t index);
+        ByteBufferView getEventView(uint32_t index);
         uint32_t getEventLength(uint32_t index);
         std::shared_ptr<EvioNode> getEventNode(uint32_t index);
 
@@ -337,13 +500,20 @@ namespace evio {
         uint32_t getCurrentRecord() const;
         RecordInput & getCurrentRecordStream();
         bool readRecord(uint32_t index);
+        ByteBufferView getRawRecord(uint32_t index, std::vector<uint8_t> & storage);
 
 
     protected:
 
+        static void sendFileBytes(int fd, int sock, size_t offset, size_t bytes);
         void extractDictionaryAndFirstEvent();
         void extractDictionaryFromBuffer();
         void extractDictionaryFromFile();
+        void extractBinaryDictionary(RecordInput & record, uint32_t index);
+        void extractCompressionDictionary(RecordInput & record, uint32_t index);
+        void loadCompressionDictionary();
+        std::shared_ptr<uint8_t> getSeekableEvent(uint32_t recordIndex, uint32_t eventNumber, uint32_t *len);
+        std::shared_ptr<uint8_t> getPartialEvent(uint32_t recordIndex, uint32_t eventNumber, uint32_t *len);
 
 
         static void findRecordInfo(std::shared_ptr<ByteBuffer> & buf, uint32_t offset,
@@ -354,8 +524,17 @@ namespace evio {
 
         std::shared_ptr<ByteBuffer> scanBuffer();
         void scanUncompressedBuffer();
+        size_t extractEventNodes(size_t recordPos, RecordHeader & recordHeader, uint32_t eventPlace,
+                                 std::vector<std::shared_ptr<EvioNode>> & nodes);
+        void findEventNodes(uint32_t recordIndex);
+        void findAllEventNodes();
+        std::shared_ptr<EvioNode> & eventNodeAt(uint32_t index);
+        std::shared_ptr<EvioNode> & demandEventNode(uint32_t index);
+        void clearDemandNodes();
         void forceScanFile();
         void scanFile(bool force);
+        bool loadSidecarIndex();
+        void readRecordHeader(uint32_t index, RecordHeader & header);
 
         // The next 2 methods will not work on events which are not evio format data.
         // They are included here so other classes, like EvioCompactReader and EvioReader,
@@ -364,6 +543,7 @@ namespace evio {
         // these methods violates that.
         std::shared_ptr<ByteBuffer> & addStructure(uint32_t eventNumber, ByteBuffer & addBuffer);
         std::shared_ptr<ByteBuffer> & removeStructure(std::shared_ptr<EvioNode> & removeNode);
+        std::shared_ptr<ByteBuffer> & applyEdits(StructureEdits const & edits);
 
         void show() const;
 
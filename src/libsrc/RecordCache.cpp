@@ -0,0 +1,176 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "RecordCache.h"
+
+#include <sys/stat.h>
+
+
+namespace evio {
+
+
+    /**
+     * Get an id for a file, the same for all paths to it, which changes if the file is modified.
+     * It's made from the file's device, inode, size and modification time.
+     * @param fileName name of file.
+     * @return file's id, or 0 if file cannot be found.
+     */
+    uint64_t RecordCache::getFileId(const std::string & fileName) {
+        struct stat st;
+        if (::stat(fileName.c_str(), &st) != 0) {
+            return 0;
+        }
+
+        // FNV-1a hash of the values identifying this version of the file
+        uint64_t values[4] = {(uint64_t)st.st_dev, (uint64_t)st.st_ino,
+                              (uint64_t)st.st_size, (uint64_t)st.st_mtime};
+        uint64_t id = 14695981039346656037ULL;
+        for (uint64_t v : values) {
+            for (int i=0; i < 8; i++) {
+                id ^= (v >> (8*i)) & 0xff;
+                id *= 1099511628211ULL;
+            }
+        }
+        return id == 0 ? 1 : id;
+    }
+
+
+    /**
+     * Set the max bytes of records held. Records are dropped, least recently used first,
+     * to fit. Setting 0 turns the cache off and empties it.
+     * @param budget max bytes of records held, 0 for no cache.
+     */
+    void RecordCache::setByteBudget(size_t budget) {
+        byteBudget = budget;
+        std::lock_guard<std::mutex> lock(mtx);
+        shrink(budget);
+    }
+
+
+    /**
+     * Get the max bytes of records held.
+     * @return max bytes of records held, 0 if cache is off.
+     */
+    size_t RecordCache::getByteBudget() const {return byteBudget;}
+
+
+    /**
+     * Is the cache on?
+     * @return true if cache has a budget.
+     */
+    bool RecordCache::isEnabled() const {return byteBudget.load(std::memory_order_relaxed) > 0;}
+
+
+    /**
+     * Drop records, least recently used first, until no more than budget bytes are held.
+     * Must be called with mtx locked.
+     * @param budget max bytes to hold.
+     */
+    void RecordCache::shrink(size_t budget) {
+        while (bytes > budget && !lru.empty()) {
+            auto & last = lru.back();
+            bytes -= last.second->getBytes();
+            entries.erase(last.first);
+            lru.pop_back();
+            evictions++;
+        }
+    }
+
+
+    /**
+     * Get a record, making it the most recently used.
+     * @param fileId   id of record's file.
+     * @param position position of record in file.
+     * @return record, null if not in cache.
+     */
+    std::shared_ptr<const RecordCache::Entry> RecordCache::get(uint64_t fileId, uint64_t position) {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        auto it = entries.find(Key(fileId, position));
+        if (it == entries.end()) {
+            misses++;
+            return nullptr;
+        }
+
+        lru.splice(lru.begin(), lru, it->second);
+        hits++;
+        return it->second->second;
+    }
+
+
+    /**
+     * Add a record as the most recently used, dropping others to stay within budget.
+     * A record larger than the whole budget is not added.
+     * @param fileId   id of record's file.
+     * @param position position of record in file.
+     * @param entry    record, which must not be changed afterwards.
+     */
+    void RecordCache::put(uint64_t fileId, uint64_t position, std::shared_ptr<const Entry> const & entry) {
+        size_t budget = byteBudget;
+        if (entry == nullptr || entry->getBytes() > budget) return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+
+        Key key(fileId, position);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            // Another reader got here first
+            lru.splice(lru.begin(), lru, it->second);
+            return;
+        }
+
+        shrink(budget - entry->getBytes());
+        lru.emplace_front(key, entry);
+        entries[key] = lru.begin();
+        bytes += entry->getBytes();
+    }
+
+
+    /** Drop all records. Those still held by a {@link RecordInput} stay valid. */
+    void RecordCache::clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        lru.clear();
+        entries.clear();
+        bytes = 0;
+    }
+
+
+    /**
+     * Get the bytes of records held.
+     * @return bytes of records held.
+     */
+    size_t RecordCache::getBytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return bytes;
+    }
+
+
+    /**
+     * Get the number of records held.
+     * @return number of records held.
+     */
+    size_t RecordCache::getEntryCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return lru.size();
+    }
+
+
+    /** @return number of records found in cache. */
+    uint64_t RecordCache::getHits() const {return hits;}
+
+
+    /** @return number of records looked for but not found. */
+    uint64_t RecordCache::getMisses() const {return misses;}
+
+
+    /** @return number of records dropped to stay within budget. */
+    uint64_t RecordCache::getEvictions() const {return evictions;}
+
+}
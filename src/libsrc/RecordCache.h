@@ -0,0 +1,135 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RECORDCACHE_H
+#define EVIO_6_0_RECORDCACHE_H
+
+
+#include <cstdint>
+#include <string>
+#include <list>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+
+#include "ByteOrder.h"
+#include "ByteBuffer.h"
+#include "RecordHeader.h"
+
+
+namespace evio {
+
+
+    /**
+     * This singleton class is a process-wide, thread-safe cache of decompressed records,
+     * shared by all {@link Reader}s. Tools opening many Readers on the same files then
+     * decompress each hot record only once. Records are keyed by the id of their file
+     * (see {@link #getFileId(const std::string &)}) and their position in it. When the bytes
+     * held exceed the budget, the least recently used records are dropped.<p>
+     *
+     * Each record is held through a shared pointer. A {@link RecordInput} given a cached record
+     * holds it too, so that views into its events stay valid after it's dropped from the cache,
+     * until that RecordInput reads another record. Cached records are never modified.<p>
+     *
+     * The cache is off until given a budget with {@link #setByteBudget(size_t)}.
+     */
+    class RecordCache {
+
+    public:
+
+        /** A decompressed record, as laid out in a {@link RecordInput}, never changed once cached. */
+        class Entry {
+        public:
+            /** Header of record. */
+            std::shared_ptr<RecordHeader> header;
+            /** Index array (converted to event offsets), user header and events. */
+            std::shared_ptr<ByteBuffer> data;
+            /** Number of events. */
+            uint32_t entries = 0;
+            /** Offset in data of the user header. */
+            uint32_t userHeaderOffset = 0;
+            /** Offset in data of the events. */
+            uint32_t eventsOffset = 0;
+            /** Bytes of events. */
+            uint32_t eventsLength = 0;
+            /** Byte order of data. */
+            ByteOrder order {ByteOrder::ENDIAN_LOCAL};
+
+            /** @return bytes of memory held. */
+            size_t getBytes() const {return data == nullptr ? 0 : data->capacity();}
+        };
+
+        /**
+         * Get the instance of this singleton class.
+         * @return the instance of this singleton class.
+         */
+        static RecordCache & getInstance() {
+            static RecordCache theCache;
+            return theCache;
+        }
+
+    private:
+
+        /** Key of a record: file id and position in file. */
+        typedef std::pair<uint64_t, uint64_t> Key;
+
+        /** Records, most recently used first. */
+        std::list<std::pair<Key, std::shared_ptr<const Entry>>> lru;
+
+        /** Where each record is in lru. */
+        std::map<Key, std::list<std::pair<Key, std::shared_ptr<const Entry>>>::iterator> entries;
+
+        /** Guards lru, entries and bytes. */
+        std::mutex mtx;
+
+        /** Max bytes of records held, 0 if cache is off. */
+        std::atomic<size_t> byteBudget{0};
+        /** Bytes of records held. */
+        size_t bytes = 0;
+
+        /** Number of records found in cache. */
+        std::atomic<uint64_t> hits{0};
+        /** Number of records looked for but not found. */
+        std::atomic<uint64_t> misses{0};
+        /** Number of records dropped to stay within budget. */
+        std::atomic<uint64_t> evictions{0};
+
+        RecordCache() = default;
+        RecordCache(const RecordCache &) = delete;
+        RecordCache & operator=(const RecordCache &) = delete;
+
+        void shrink(size_t budget);
+
+    public:
+
+        static uint64_t getFileId(const std::string & fileName);
+
+        void   setByteBudget(size_t budget);
+        size_t getByteBudget() const;
+        bool   isEnabled() const;
+
+        std::shared_ptr<const Entry> get(uint64_t fileId, uint64_t position);
+        void put(uint64_t fileId, uint64_t position, std::shared_ptr<const Entry> const & entry);
+        void clear();
+
+        size_t getBytes();
+        size_t getEntryCount();
+        uint64_t getHits() const;
+        uint64_t getMisses() const;
+        uint64_t getEvictions() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_RECORDCACHE_H
@@ -16,6 +16,7 @@
 #include <iomanip>
 #include <string>
 #include <thread>
+#include <chrono>
 #include <memory>
 
 
@@ -23,6 +24,7 @@
 #include "RecordHeader.h"
 #include "Compressor.h"
 #include "RecordSupply.h"
+#include "Util.h"
 
 
 #include "Disruptor/Util.h"
@@ -45,6 +47,9 @@ namespace evio {
 
     private:
 
+        /** Max number of records taken from the supply, and released to it, at once. */
+        static const uint32_t MAX_BATCH = 4;
+
         /** Keep track of this thread with id number. */
         uint32_t threadNumber;
         /** Type of compression to perform. */
@@ -98,6 +103,27 @@ namespace evio {
             thd = boost::thread([this]() {this->run();});
         }
 
+        /**
+         * Restrict this thread, once started, to run only on the given CPUs (Linux only).
+         * Optionally place the memory of this thread's share of records on the NUMA
+         * node of those CPUs. This must be done before any events are written.
+         * @param cpus ids of CPUs this thread may run on.
+         * @param numaLocalRecords if true, place this thread's share of records' memory local to cpus.
+         */
+        void setAffinity(const std::vector<uint32_t> & cpus, bool numaLocalRecords = false) {
+            Util::setThreadAffinity(thd.native_handle(), cpus);
+
+            if (numaLocalRecords && !cpus.empty()) {
+                // A page is placed on the node of the thread first writing to it,
+                // so have a thread running on the same CPUs do the first writing.
+                std::thread placer([this, &cpus]() {
+                    Util::setThreadAffinity(pthread_self(), cpus);
+                    supply->touchRecords(threadNumber);
+                });
+                placer.join();
+            }
+        }
+
         /** Stop the thread. */
         void stopThread() {
             // Send signal to interrupt it
@@ -111,41 +137,54 @@ namespace evio {
 
             try {
 
-                // The first time through, we need to release all records coming before
-                // our first in case there are < threadNumber records before close() is called.
-                // This way close() is not waiting for thread #12 to get and subsequently
-                // release items 0 - 11 when there were only 5 records total.
-                // (threadNumber starts at 0).
-
-                // Be careful when dealing with negative numbers and unsigned ints ...
-                int64_t seqNumber = (int64_t)threadNumber - 1;
-                supply->release(threadNumber, seqNumber);
-
                 while (true) {
 
-                    // Get the next record for this thread to compress
-                    auto item = supply->getToCompress(threadNumber);
+                    // Wait here, without claiming a record, while this thread is parked
+                    supply->waitWhileParked(threadNumber);
+
+                    // Get the next records, already available, not yet taken by another thread
+                    // to compress. Only the first is waited for.
+                    int64_t first;
+                    uint32_t count = supply->getToCompress(threadNumber, MAX_BATCH, first);
 
                     {
                         // Only allow interruption when blocked on trying to get item
                         boost::this_thread::disable_interruption d1;
 
-                        // Pull record out of wrapping object
-                        std::shared_ptr<RecordOutput> & record = item->getRecord();
-                        // Set compression type
-                        auto & header = record->getHeader();
-                        header->setCompressionType(compressionType);
+                        for (int64_t seq = first; seq < first + count; seq++) {
+                            // Pull record out of wrapping object
+                            std::shared_ptr<RecordOutput> & record = supply->getItem(seq)->getRecord();
+                            // Set compression type
+                            auto & header = record->getHeader();
+                            header->setCompressionType(compressionType);
+                            // Go easy on compression if records are backing up
+                            record->setFastCompression(supply->useFastCompression());
 //cout << "RecordCompressor thd " << threadNumber << ": got record, set rec # to " << header->getRecordNumber() << endl;
-                        // Do compression
-                        record->build();
-                        // Release back to supply
-                        supply->releaseCompressor(item);
+                            // Do compression
+                            uint32_t bytesIn = record->getUncompressedSize();
+                            auto t1 = std::chrono::steady_clock::now();
+                            record->build();
+                            supply->addCompressionStats(threadNumber,
+                                                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                std::chrono::steady_clock::now() - t1).count(),
+                                                        bytesIn, header->getLength());
+                        }
+
+                        // Release all back to supply
+                        supply->releaseCompressor(first, count);
                     }
                 }
             }
             catch (boost::thread_interrupted & e) {
 //cout << "RecordCompressor thd " << threadNumber << ": INTERRUPTED, return" << endl;
             }
+            catch (std::exception & e) {
+                // Such as thrown by a user's record processor. Alert the writer's threads.
+                std::string err = std::string("error compressing record: ") + e.what();
+                supply->setError(err);
+                supply->haveError(true);
+                supply->errorAlert();
+            }
         }
     };
 
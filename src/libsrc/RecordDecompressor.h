@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#ifndef EVIO_6_0_RECORDDECOMPRESSOR_H
+#define EVIO_6_0_RECORDDECOMPRESSOR_H
+
+
+#include <string>
+#include <fstream>
+#include <memory>
+
+
+#include "RecordInput.h"
+#include "RecordInputSupply.h"
+#include "ByteBuffer.h"
+#include "EvioException.h"
+
+
+#include "Disruptor/Util.h"
+#include "Disruptor/AlertException.h"
+#include <boost/thread.hpp>
+
+
+namespace evio {
+
+
+    /**
+     * Class used to create a thread which takes records designated in a
+     * RecordInputSupply, reads them from a file, decompresses them,
+     * and places them back into the supply for in-order reading.
+     * It is an interruptible thread from the boost library.
+     * <b>This of use internally only.</b>
+     */
+    class RecordDecompressor {
+
+    private:
+
+        /** Keep track of this thread with id number. */
+        uint32_t threadNumber;
+        /** Name of file to read. */
+        std::string fileName;
+        /** If not null, the memory mapped file to read instead of using a file stream. */
+        std::shared_ptr<ByteBuffer> mappedFile;
+        /** Supply of RecordInputRingItems. */
+        std::shared_ptr<RecordInputSupply> supply;
+        /** Thread which does the decompression. */
+        boost::thread thd;
+
+    public:
+
+        /**
+         * Constructor.
+         * @param thdNum        unique thread number starting at 0.
+         * @param file          name of file to read.
+         * @param mapped        memory mapped file, if any, which is read instead of opening file.
+         * @param recordSupply  supply of records to decompress.
+         */
+        RecordDecompressor(uint32_t thdNum, std::string const & file,
+                           std::shared_ptr<ByteBuffer> & mapped,
+                           std::shared_ptr<RecordInputSupply> & recordSupply) :
+                threadNumber(thdNum),
+                fileName(file),
+                mappedFile(mapped),
+                supply(recordSupply) {
+        }
+
+        RecordDecompressor(RecordDecompressor && obj) noexcept :
+                threadNumber(obj.threadNumber),
+                fileName(std::move(obj.fileName)),
+                mappedFile(std::move(obj.mappedFile)),
+                supply(std::move(obj.supply)),
+                thd(std::move(obj.thd)) {
+        }
+
+        RecordDecompressor & operator=(RecordDecompressor && obj) noexcept {
+            if (this != &obj) {
+                threadNumber = obj.threadNumber;
+                fileName = std::move(obj.fileName);
+                mappedFile = std::move(obj.mappedFile);
+                supply = std::move(obj.supply);
+                thd  = std::move(obj.thd);
+            }
+            return *this;
+        }
+
+        ~RecordDecompressor() {
+            thd.interrupt();
+            if (thd.joinable() && !thd.try_join_for(boost::chrono::milliseconds(500))) {
+                std::cout << "RecordDecompressor thread did not quit after 1/2 sec" << std::endl;
+            }
+        }
+
+        /** Create and start a thread to execute the run() method of this class. */
+        void startThread() {
+            thd = boost::thread([this]() {this->run();});
+        }
+
+        /** Stop the thread. Call {@link RecordInputSupply#errorAlert()} first if it may be waiting. */
+        void stopThread() {
+            thd.interrupt();
+            if (thd.joinable()) thd.join();
+        }
+
+        /** Method to run in the thread. */
+        void run() {
+
+            // Each thread has its own file stream so reads can happen simultaneously
+            std::ifstream file;
+
+            try {
+                if (mappedFile == nullptr) {
+                    file.open(fileName, std::ios::binary);
+                    if (!file.is_open()) {
+                        supply->setError("cannot open file " + fileName);
+                    }
+                    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+                }
+
+                // Release all records coming before our first (see RecordCompressor)
+                int64_t seqNumber = (int64_t)threadNumber - 1;
+                supply->release(threadNumber, seqNumber);
+
+                while (true) {
+
+                    // Get the next record for this thread to decompress
+                    auto item = supply->getToDecompress(threadNumber);
+
+                    {
+                        // Only allow interruption when blocked on trying to get item
+                        boost::this_thread::disable_interruption d1;
+
+                        if (!supply->haveError()) {
+                            try {
+                                if (mappedFile != nullptr) {
+                                    item->getRecord()->readRecordInPlace(mappedFile, item->getPosition());
+                                }
+                                else {
+                                    item->getRecord()->readRecord(file, item->getPosition());
+                                }
+                            }
+                            catch (std::exception & e) {
+                                // Reader sees the error when it gets to this record
+                                supply->setError(e.what());
+                            }
+                        }
+
+                        // Release back to supply
+                        supply->releaseDecompressor(item);
+                    }
+                }
+            }
+            catch (Disruptor::AlertException & e) {
+                // Supply is being shut down
+            }
+            catch (boost::thread_interrupted & e) {
+            }
+        }
+    };
+
+
+}
+
+
+#endif //EVIO_6_0_RECORDDECOMPRESSOR_H
@@ -0,0 +1,150 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RECORDFILLSTATS_H
+#define EVIO_6_0_RECORDFILLSTATS_H
+
+
+#include <cstdint>
+#include <atomic>
+
+
+#include "WriterMetrics.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class counts, for a writer, the sizes of the events added to its records, how full
+     * its records are when built, and why events did not fit. It's shared by all the
+     * {@link RecordOutput} objects of one writer, which add to it as events are added and
+     * records built, possibly in different threads, so counters are relaxed atomics.
+     * The writer copies them into its {@link WriterMetrics}.
+     */
+    class RecordFillStats {
+
+    private:
+
+        std::atomic<uint64_t> events {0};
+        std::atomic<uint64_t> eventBytes {0};
+        std::atomic<uint64_t> maxEventBytes {0};
+        std::atomic<uint64_t> sizeBins[WriterMetrics::EVENT_SIZE_BINS] {};
+
+        std::atomic<uint64_t> records {0};
+        std::atomic<uint64_t> recordEvents {0};
+        std::atomic<uint64_t> recordBytes {0};
+        std::atomic<uint64_t> recordCapacity {0};
+        std::atomic<uint64_t> fillBins[WriterMetrics::RECORD_FILL_BINS] {};
+
+        std::atomic<uint64_t> fullByCount {0};
+        std::atomic<uint64_t> fullBySize {0};
+        std::atomic<uint64_t> oversized {0};
+
+
+        static void add(std::atomic<uint64_t> & counter, uint64_t n) {
+            counter.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        static uint64_t get(std::atomic<uint64_t> const & counter) {
+            return counter.load(std::memory_order_relaxed);
+        }
+
+    public:
+
+        /**
+         * Count an event added to a record.
+         * @param bytes size of event in bytes.
+         */
+        void addEvent(uint32_t bytes) {
+            add(events, 1);
+            add(eventBytes, bytes);
+
+            // Bin i holds sizes of 2^i up to 2^(i+1) - 1 bytes
+            uint32_t bin = 0;
+            for (uint32_t b = bytes; b > 1; b >>= 1) bin++;
+            add(sizeBins[bin], 1);
+
+            uint64_t max = maxEventBytes.load(std::memory_order_relaxed);
+            while (bytes > max && !maxEventBytes.compare_exchange_weak(max, bytes, std::memory_order_relaxed)) {}
+        }
+
+        /**
+         * Count an event which did not fit into a record already holding others,
+         * and so must start the next one.
+         * @param byCount true if the record had its max number of events, false if not enough memory.
+         */
+        void refuseEvent(bool byCount) {add(byCount ? fullByCount : fullBySize, 1);}
+
+        /** Count an event too large for an empty record, whose memory was expanded to hold it. */
+        void addOversizedEvent() {add(oversized, 1);}
+
+        /**
+         * Count a record built.
+         * @param eventCount number of events in record.
+         * @param bytes      bytes of events and index in record.
+         * @param capacity   max bytes of events and index record could hold.
+         */
+        void addRecord(uint32_t eventCount, uint32_t bytes, uint32_t capacity) {
+            add(records, 1);
+            add(recordEvents, eventCount);
+            add(recordBytes, bytes);
+            add(recordCapacity, capacity);
+
+            uint32_t bin = capacity > 0 ? (uint32_t)((uint64_t)bytes * WriterMetrics::RECORD_FILL_BINS / capacity) : 0;
+            if (bin >= WriterMetrics::RECORD_FILL_BINS) bin = WriterMetrics::RECORD_FILL_BINS - 1;
+            add(fillBins[bin], 1);
+        }
+
+
+        /** Set all counters back to zero. */
+        void reset() {
+            for (auto * c : {&events, &eventBytes, &maxEventBytes, &records, &recordEvents,
+                             &recordBytes, &recordCapacity, &fullByCount, &fullBySize, &oversized}) {
+                c->store(0, std::memory_order_relaxed);
+            }
+            for (auto & c : sizeBins) c.store(0, std::memory_order_relaxed);
+            for (auto & c : fillBins) c.store(0, std::memory_order_relaxed);
+        }
+
+
+        /**
+         * Copy the counters into the record filling values of the given metrics.
+         * @param metrics object in which to place values.
+         */
+        void getMetrics(WriterMetrics & metrics) const {
+            metrics.eventsAdded   = get(events);
+            metrics.eventBytes    = get(eventBytes);
+            metrics.maxEventBytes = get(maxEventBytes);
+            metrics.eventSizeHistogram.resize(WriterMetrics::EVENT_SIZE_BINS);
+            for (uint32_t i=0; i < WriterMetrics::EVENT_SIZE_BINS; i++) {
+                metrics.eventSizeHistogram[i] = get(sizeBins[i]);
+            }
+
+            metrics.recordsBuilt = get(records);
+            uint64_t capacity = get(recordCapacity);
+            metrics.avgRecordFill = capacity > 0 ? (double)get(recordBytes) / (double)capacity : 0.;
+            metrics.avgEventsPerRecord = metrics.recordsBuilt > 0 ?
+                                         (double)get(recordEvents) / (double)metrics.recordsBuilt : 0.;
+            metrics.recordFillHistogram.resize(WriterMetrics::RECORD_FILL_BINS);
+            for (uint32_t i=0; i < WriterMetrics::RECORD_FILL_BINS; i++) {
+                metrics.recordFillHistogram[i] = get(fillBins[i]);
+            }
+
+            metrics.recordsFullByCount = get(fullByCount);
+            metrics.recordsFullBySize  = get(fullBySize);
+            metrics.oversizedEvents    = get(oversized);
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_RECORDFILLSTATS_H
@@ -10,6 +10,9 @@
 
 #include "RecordHeader.h"
 
+#include <cstring>
+#include <cstddef>
+
 
 using namespace std;
 
@@ -70,6 +73,9 @@ namespace evio {
             recordLengthWords        = head.recordLengthWords;
             recordUserRegisterFirst  = head.recordUserRegisterFirst;
             recordUserRegisterSecond = head.recordUserRegisterSecond;
+            checksum                 = head.checksum;
+            timeMin                  = head.timeMin;
+            timeMax                  = head.timeMax;
 
             entries                   = head.entries;
             bitInfo                   = head.bitInfo;
@@ -106,6 +112,9 @@ namespace evio {
             recordLengthWords        = head.recordLengthWords;
             recordUserRegisterFirst  = head.recordUserRegisterFirst;
             recordUserRegisterSecond = head.recordUserRegisterSecond;
+            checksum                 = head.checksum;
+            timeMin                  = head.timeMin;
+            timeMax                  = head.timeMax;
 
             entries                   = head.entries;
             bitInfo                   = head.bitInfo;
@@ -148,6 +157,9 @@ namespace evio {
             recordLengthWords        = head->recordLengthWords;
             recordUserRegisterFirst  = head->recordUserRegisterFirst;
             recordUserRegisterSecond = head->recordUserRegisterSecond;
+            checksum                 = head->checksum;
+            timeMin                  = head->timeMin;
+            timeMax                  = head->timeMax;
 
             entries                   = head->entries;
             bitInfo                   = head->bitInfo;
@@ -190,6 +202,9 @@ namespace evio {
         recordLengthWords = 0;
         recordUserRegisterFirst = 0ULL;
         recordUserRegisterSecond = 0ULL;
+        checksum = 0;
+        timeMin = 0ULL;
+        timeMax = 0ULL;
 
         entries = 0;
         bitInfoInit();
@@ -293,7 +308,7 @@ namespace evio {
 
 
     /**
-     * Get the type of compression used. 0=none, 1=LZ4 fast, 2=LZ4 best, 3=gzip.
+     * Get the type of compression used. 0=none, 1=LZ4 fast, 2=LZ4 best, 3=gzip, 4=zstd.
      * @return type of compression used.
      */
     Compressor::CompressionType  RecordHeader::getCompressionType() const {return compressionType;}
@@ -397,6 +412,37 @@ namespace evio {
     uint64_t  RecordHeader::getUserRegisterSecond() const {return recordUserRegisterSecond;}
 
 
+    /**
+     * Get the CRC32C of the data following this header, valid only if {@link #hasChecksum()}.
+     * @return CRC32C of the data following this header.
+     */
+    uint32_t  RecordHeader::getChecksum() const {return checksum;}
+
+
+    /**
+     * Get the smallest timestamp of the record's events, valid only if {@link #hasTimeRange()}.
+     * @return smallest timestamp of the record's events.
+     */
+    uint64_t  RecordHeader::getTimeMin() const {return timeMin;}
+
+
+    /**
+     * Get the largest timestamp of the record's events, valid only if {@link #hasTimeRange()}.
+     * @return largest timestamp of the record's events.
+     */
+    uint64_t  RecordHeader::getTimeMax() const {return timeMax;}
+
+
+    /**
+     * Get the byte offset from the beginning of the header to the timestamp range,
+     * which follows the checksum if there is one.
+     * @return byte offset from beginning of header to the timestamp range.
+     */
+    uint32_t  RecordHeader::getTimeRangeOffset() const {
+        return hasChecksum() ? CHECKSUM_OFFSET + 4 : CHECKSUM_OFFSET;
+    }
+
+
     /**
      * Get the type of header this is.
      * @return type of header this is.
@@ -673,6 +719,313 @@ namespace evio {
     bool RecordHeader::isLastRecord(uint32_t bitInfo) {return ((bitInfo & LAST_RECORD_BIT) != 0);}
 
 
+    /**
+     * Set the bit which says user register 2 holds a filter of event tags and nums.
+     * @param hasFilter  true if user register 2 holds a filter of event tags and nums.
+     * @return new bitInfo word.
+     */
+    uint32_t RecordHeader::hasTagFilter(bool hasFilter) {
+        if (hasFilter) {
+            // set bit
+            bitInfo |= TAG_FILTER_BIT;
+        }
+        else {
+            // clear bit
+            bitInfo &= ~TAG_FILTER_BIT;
+        }
+
+        return bitInfo;
+    }
+
+
+    /**
+     * Does user register 2 of this header hold a filter of event tags and nums?
+     * @return true if user register 2 holds a filter of event tags and nums, else false.
+     */
+    bool RecordHeader::hasTagFilter() const {return ((bitInfo & TAG_FILTER_BIT) != 0);}
+
+
+    /**
+     * Does this bitInfo arg indicate user register 2 holds a filter of event tags and nums?
+     * @param bitInfo bitInfo word.
+     * @return true if user register 2 holds a filter of event tags and nums, else false.
+     */
+    bool RecordHeader::hasTagFilter(uint32_t bitInfo) {return ((bitInfo & TAG_FILTER_BIT) != 0);}
+
+
+    /**
+     * Get the 2 bits of the 64 bit tag filter which are set for the given key.
+     * @param key tag and num, or tag alone, turned into a single value.
+     * @return 2 bits of the tag filter.
+     */
+    uint64_t RecordHeader::tagFilterKeyBits(uint32_t key) {
+        // Fibonacci hashing, top 6 bits give 1 bit, the next 6 give the other
+        uint64_t hash = (key + 1) * 0x9E3779B97F4A7C15ULL;
+        return (1ULL << (hash >> 58)) | (1ULL << ((hash >> 52) & 0x3f));
+    }
+
+
+    /**
+     * Get the bits to be set in a record's tag filter for an event whose
+     * top-level bank has the given tag and num. Both the tag and num together,
+     * and the tag alone, are entered into the filter.
+     * @param tag tag of event's bank.
+     * @param num num of event's bank.
+     * @return bits of the tag filter to set.
+     */
+    uint64_t RecordHeader::tagFilterBits(uint16_t tag, uint8_t num) {
+        return tagFilterKeyBits((static_cast<uint32_t>(tag) << 8) | num) |
+               tagFilterKeyBits(0x1000000 | tag);
+    }
+
+
+    /**
+     * Store a filter of the tags and nums of this record's events in user register 2,
+     * and set the bit saying so.
+     * @param filter OR of {@link #tagFilterBits(uint16_t, uint8_t)} for all events.
+     */
+    void RecordHeader::setTagFilter(uint64_t filter) {
+        recordUserRegisterSecond = filter;
+        hasTagFilter(true);
+    }
+
+
+    /**
+     * Might this record contain an event whose top-level bank has the given tag and num?
+     * If there is no tag filter, it might.
+     * @param tag tag to look for.
+     * @param num num to look for.
+     * @return false if record contains no such event, true if it might.
+     */
+    bool RecordHeader::mayContain(uint16_t tag, uint8_t num) const {
+        if (!hasTagFilter()) return true;
+        uint64_t bits = tagFilterKeyBits((static_cast<uint32_t>(tag) << 8) | num);
+        return (recordUserRegisterSecond & bits) == bits;
+    }
+
+
+    /**
+     * Might this record contain an event whose top-level bank has the given tag, whatever its num?
+     * If there is no tag filter, it might.
+     * @param tag tag to look for.
+     * @return false if record contains no such event, true if it might.
+     */
+    bool RecordHeader::mayContainTag(uint16_t tag) const {
+        if (!hasTagFilter()) return true;
+        uint64_t bits = tagFilterKeyBits(0x1000000 | tag);
+        return (recordUserRegisterSecond & bits) == bits;
+    }
+
+
+    /**
+     * Set the bit which says this header has a 15th word holding the CRC32C of the
+     * record's data. The header length is changed to match.
+     * @param hasSum  true if header is to hold a checksum.
+     * @return new bitInfo word.
+     */
+    uint32_t RecordHeader::hasChecksum(bool hasSum) {
+        if (hasSum) {
+            // set bit
+            bitInfo |= CHECKSUM_BIT;
+        }
+        else {
+            // clear bit
+            bitInfo &= ~CHECKSUM_BIT;
+        }
+
+        setExtendedHeaderLength();
+        return bitInfo;
+    }
+
+
+    /**
+     * Does this header hold a checksum of the record's data?
+     * @return true if this header holds a checksum, else false.
+     */
+    bool RecordHeader::hasChecksum() const {return ((bitInfo & CHECKSUM_BIT) != 0);}
+
+
+    /**
+     * Does this bitInfo arg indicate the header holds a checksum of the record's data?
+     * @param bitInfo bitInfo word.
+     * @return true if the header holds a checksum, else false.
+     */
+    bool RecordHeader::hasChecksum(uint32_t bitInfo) {return ((bitInfo & CHECKSUM_BIT) != 0);}
+
+
+    /**
+     * Set the header length to the standard size plus any optional words
+     * (checksum, timestamp range) flagged in the bit info word.
+     */
+    void RecordHeader::setExtendedHeaderLength() {
+        uint32_t len = HEADER_SIZE_BYTES;
+        if (hasChecksum())  len += 4;
+        if (hasTimeRange()) len += 16;
+        setHeaderLength(len);
+    }
+
+
+    /**
+     * Set the bit which says this header has 4 more words, following the checksum if any,
+     * holding the min and max timestamps of the record's events.
+     * The header length is changed to match.
+     * @param hasRange  true if header is to hold a timestamp range.
+     * @return new bitInfo word.
+     */
+    uint32_t RecordHeader::hasTimeRange(bool hasRange) {
+        if (hasRange) {
+            // set bit
+            bitInfo |= TIME_RANGE_BIT;
+        }
+        else {
+            // clear bit
+            bitInfo &= ~TIME_RANGE_BIT;
+        }
+
+        setExtendedHeaderLength();
+        return bitInfo;
+    }
+
+
+    /**
+     * Does this header hold the min and max timestamps of the record's events?
+     * @return true if this header holds a timestamp range, else false.
+     */
+    bool RecordHeader::hasTimeRange() const {return ((bitInfo & TIME_RANGE_BIT) != 0);}
+
+
+    /**
+     * Does this bitInfo arg indicate the header holds the min and max timestamps of the record's events?
+     * @param bitInfo bitInfo word.
+     * @return true if the header holds a timestamp range, else false.
+     */
+    bool RecordHeader::hasTimeRange(uint32_t bitInfo) {return ((bitInfo & TIME_RANGE_BIT) != 0);}
+
+
+    /**
+     * Store the min and max timestamps of this record's events, and set the bit saying so.
+     * @param min smallest timestamp.
+     * @param max largest timestamp.
+     */
+    void RecordHeader::setTimeRange(uint64_t min, uint64_t max) {
+        timeMin = min;
+        timeMax = max;
+        hasTimeRange(true);
+    }
+
+
+    /**
+     * Might this record contain an event with a timestamp in the given range?
+     * If there is no timestamp range in the header, it might.
+     * @param t0 start of range.
+     * @param t1 end of range, inclusive.
+     * @return false if record contains no such event, true if it might.
+     */
+    bool RecordHeader::mayContainTime(uint64_t t0, uint64_t t1) const {
+        if (!hasTimeRange()) return true;
+        return timeMin <= t1 && timeMax >= t0;
+    }
+
+
+    /**
+     * Set the bit which says this record's data was compressed with the trained
+     * dictionary stored in the file header's user header.
+     * @param hasDict  true if data was compressed with the trained dictionary.
+     * @return new bitInfo word.
+     */
+    uint32_t RecordHeader::hasCompressionDictionary(bool hasDict) {
+        if (hasDict) {
+            // set bit
+            bitInfo |= COMPRESSION_DICT_BIT;
+        }
+        else {
+            // clear bit
+            bitInfo &= ~COMPRESSION_DICT_BIT;
+        }
+
+        return bitInfo;
+    }
+
+
+    /**
+     * Was this record's data compressed with the trained compression dictionary?
+     * @return true if data was compressed with the trained dictionary, else false.
+     */
+    bool RecordHeader::hasCompressionDictionary() const {return ((bitInfo & COMPRESSION_DICT_BIT) != 0);}
+
+
+    /**
+     * Does this bitInfo arg indicate the record's data was compressed with the
+     * trained compression dictionary?
+     * @param bitInfo bitInfo word.
+     * @return true if data was compressed with the trained dictionary, else false.
+     */
+    bool RecordHeader::hasCompressionDictionary(uint32_t bitInfo) {return ((bitInfo & COMPRESSION_DICT_BIT) != 0);}
+
+
+    /**
+     * Set the bit which says this record's data was lz4 compressed in independent
+     * blocks so that any part of it can be decompressed alone.
+     * @param seekable  true if data was compressed in independent blocks.
+     * @return new bitInfo word.
+     */
+    uint32_t RecordHeader::isSeekable(bool seekable) {
+        if (seekable) {
+            // set bit
+            bitInfo |= SEEKABLE_BIT;
+        }
+        else {
+            // clear bit
+            bitInfo &= ~SEEKABLE_BIT;
+        }
+
+        return bitInfo;
+    }
+
+
+    /**
+     * Was this record's data lz4 compressed in independent blocks?
+     * @return true if data was compressed in independent blocks, else false.
+     */
+    bool RecordHeader::isSeekable() const {return ((bitInfo & SEEKABLE_BIT) != 0);}
+
+
+    /**
+     * Does this bitInfo arg indicate the record's data was lz4 compressed in independent blocks?
+     * @param bitInfo bitInfo word.
+     * @return true if data was compressed in independent blocks, else false.
+     */
+    bool RecordHeader::isSeekable(uint32_t bitInfo) {return ((bitInfo & SEEKABLE_BIT) != 0);}
+
+
+    /**
+     * Set the bits which say what filter was applied to this record's data
+     * before it was compressed.
+     * @param filter  {@link Compressor::PreFilter} value, 0 for none.
+     * @return new bitInfo word.
+     */
+    uint32_t RecordHeader::setPreFilter(uint32_t filter) {
+        bitInfo = (bitInfo & (~PRE_FILTER_MASK)) | ((filter << 26) & PRE_FILTER_MASK);
+        return bitInfo;
+    }
+
+
+    /**
+     * Get the filter applied to this record's data before it was compressed.
+     * @return {@link Compressor::PreFilter} value, 0 for none.
+     */
+    uint32_t RecordHeader::getPreFilter() const {return ((bitInfo & PRE_FILTER_MASK) >> 26);}
+
+
+    /**
+     * Get the filter which this bitInfo arg says was applied to a record's data
+     * before it was compressed.
+     * @param bitInfo bitInfo word.
+     * @return {@link Compressor::PreFilter} value, 0 for none.
+     */
+    uint32_t RecordHeader::getPreFilter(uint32_t bitInfo) {return ((bitInfo & PRE_FILTER_MASK) >> 26);}
+
+
     /**
      * Clear the bit in the given arg to indicate it is NOT the last record.
      * @param i integer in which to clear the last-record bit
@@ -703,10 +1056,17 @@ namespace evio {
 
 
     /**
-     * Is this header an evio record?
+     * Is this header an evio record, whether or not its data is grouped by column?
      * @return true if this is an evio record, else false.
      */
-    bool RecordHeader::isEvioRecord() const {return headerType == HeaderType::EVIO_RECORD;}
+    bool RecordHeader::isEvioRecord() const {return headerType.isEvioRecord();}
+
+
+    /**
+     * Is this header an evio record whose data is grouped by column (see {@link ColumnLayout})?
+     * @return true if this is an evio record grouped by column, else false.
+     */
+    bool RecordHeader::isColumnar() const {return headerType == HeaderType::EVIO_COLUMN_RECORD;}
 
 
     /**
@@ -742,7 +1102,7 @@ namespace evio {
      * @return true if arg represents an evio record, else false.
      */
     bool RecordHeader::isEvioRecord(uint32_t bitInfo) {
-        return ((bitInfo >> 28) & 0xf) == HeaderType::EVIO_RECORD.getValue();
+        return HeaderType::getHeaderType((bitInfo >> 28) & 0xf).isEvioRecord();
     }
 
 
@@ -910,8 +1270,9 @@ namespace evio {
 
 
     /**
-     * Set the compression type. 0=none, 1=LZ4 fast, 2=LZ4 best, 3=gzip.
-     * No compression for other values.
+     * Set the compression type. 0=none, 1=LZ4 fast, 2=LZ4 best, 3=gzip, 4=zstd.
+     * No compression for other values, or if the type is not compiled in
+     * (gzip needs USE_GZIP and zstd needs USE_ZSTD).
      * @param type compression type.
      * @return this object.
      */
@@ -921,6 +1282,11 @@ namespace evio {
         //cout << "Doesn't make sense to set compressed data if trailer" << endl;
         //    }
 
+        // Don't write records which could not be compressed
+        if (!Compressor::isSupported(type)) {
+            type = Compressor::UNCOMPRESSED;
+        }
+
         compressionType = type;
         return *this;
     }
@@ -988,6 +1354,18 @@ namespace evio {
     }
 
 
+    /**
+     * Set the CRC32C of the data following this header.
+     * Only written if {@link #hasChecksum(bool)} has been set.
+     * @param sum  CRC32C of the data following this header.
+     * @return this object.
+     */
+    RecordHeader & RecordHeader::setChecksum(uint32_t sum) {
+        checksum = sum;
+        return *this;
+    }
+
+
     //-------------------------------------------------
 
 
@@ -1001,27 +1379,18 @@ namespace evio {
     void RecordHeader::writeHeader(ByteBuffer & buf, size_t off) {
 
         // Check args
-        if ((buf.limit() - off) < HEADER_SIZE_BYTES) {
+        if ((buf.limit() - off) < headerLength) {
             throw EvioException("buffer too small");
         }
 
-        uint32_t compressedWord = (compressedDataLengthWords & 0x0FFFFFFF) |
-                                  (compressionType << 28);
-
         // Endian issues must be handled explicitly!
-
-        buf.putInt (     off, recordLengthWords);        //  0*4
-        buf.putInt ( 4 + off, recordNumber);             //  1*4
-        buf.putInt ( 8 + off, headerLengthWords);        //  2*4
-        buf.putInt (12 + off, entries);                  //  3*4
-        buf.putInt (16 + off, indexLength);              //  4*4
-        buf.putInt (20 + off, getBitInfoWord());         //  5*4
-        buf.putInt (24 + off, userHeaderLength);         //  6*4
-        buf.putInt (28 + off, headerMagicWord);          //  7*4
-        buf.putInt (32 + off, dataLength);               //  8*4
-        buf.putInt (36 + off, compressedWord);           //  9*4
-        buf.putLong(40 + off, recordUserRegisterFirst);  // 10*4
-        buf.putLong(48 + off, recordUserRegisterSecond); // 12*4
+        uint8_t *dest = buf.array() + buf.arrayOffset() + off;
+        if (buf.isSwapped()) {
+            writeHeaderWords<true>(dest);
+        }
+        else {
+            writeHeaderWords<false>(dest);
+        }
     }
 
 
@@ -1051,24 +1420,81 @@ namespace evio {
             throw EvioException("null or too small array arg");
         }
 
-        uint32_t compressedWord = (compressedDataLengthWords & 0x0FFFFFFF) |
-                                  (compressionType << 28);
-
         // Endian issues must be handled explicitly!
+        if (order.isLocalEndian()) {
+            writeHeaderWords<false>(array);
+        }
+        else {
+            writeHeaderWords<true>(array);
+        }
+    }
+
+
+    /**
+     * Swap each of the header words, if need be.
+     *
+     * @tparam SWAP  true if words must be swapped.
+     * @param words  header words.
+     */
+    template<bool SWAP>
+    void RecordHeader::swapWords(Words & words) {
+        if constexpr (SWAP) {
+            words.recordLength     = SWAP_32(words.recordLength);
+            words.recordNumber     = SWAP_32(words.recordNumber);
+            words.headerLength     = SWAP_32(words.headerLength);
+            words.entries          = SWAP_32(words.entries);
+            words.indexLength      = SWAP_32(words.indexLength);
+            words.bitInfo          = SWAP_32(words.bitInfo);
+            words.userHeaderLength = SWAP_32(words.userHeaderLength);
+            words.magic            = SWAP_32(words.magic);
+            words.dataLength       = SWAP_32(words.dataLength);
+            words.compressionWord  = SWAP_32(words.compressionWord);
+            words.register1        = SWAP_64(words.register1);
+            words.register2        = SWAP_64(words.register2);
+            words.checksum         = SWAP_32(words.checksum);
+        }
+    }
 
-        Util::toBytes(recordLengthWords,    order, array);            // 0*4
-        Util::toBytes(recordNumber,         order, array +  4); // 1*4
-        Util::toBytes(headerLengthWords,    order, array +  8); // 2*4
-        Util::toBytes(entries,              order, array + 12); // 3*4
-        Util::toBytes(indexLength,          order, array + 16); // 4*4
-        Util::toBytes(getBitInfoWord(),     order, array + 20); // 5*4
-        Util::toBytes(userHeaderLength,     order, array + 24); // 6*4
-        Util::toBytes(headerMagicWord,      order, array + 28); // 7*4
 
-        Util::toBytes(dataLength,           order, array +  4); // 8*4
-        Util::toBytes(compressedWord,       order, array +  4); // 9*4
-        Util::toBytes(recordUserRegisterFirst,  order, array +  4); // 10*4
-        Util::toBytes(recordUserRegisterSecond, order, array +  4); // 12*4
+    /**
+     * Writes the header words, in one copy, with byte order known at compile time.
+     *
+     * @tparam SWAP  true if data must be swapped into the local byte order.
+     * @param dest   where to write, with room for the header (optional words included if set).
+     */
+    template<bool SWAP>
+    void RecordHeader::writeHeaderWords(uint8_t *dest) const {
+        static_assert(offsetof(Words, register1) == REGISTER1_OFFSET &&
+                      offsetof(Words, checksum)  == CHECKSUM_OFFSET, "Words misaligned");
+
+        Words words;
+        words.recordLength     = recordLengthWords;
+        words.recordNumber     = recordNumber;
+        words.headerLength     = headerLengthWords;
+        words.entries          = entries;
+        words.indexLength      = indexLength;
+        words.bitInfo          = bitInfo;
+        words.userHeaderLength = userHeaderLength;
+        words.magic            = headerMagicWord;
+        words.dataLength       = dataLength;
+        words.compressionWord  = (compressedDataLengthWords & 0x0FFFFFFF) | (compressionType << 28);
+        words.register1        = recordUserRegisterFirst;
+        words.register2        = recordUserRegisterSecond;
+        words.checksum         = checksum;
+        swapWords<SWAP>(words);
+
+        // The checksum is only written if flagged
+        std::memcpy(dest, &words, hasChecksum() ? CHECKSUM_OFFSET + 4 : HEADER_SIZE_BYTES);
+
+        // As is the timestamp range, past any checksum
+        if (hasTimeRange()) {
+            uint64_t range[2] = {timeMin, timeMax};
+            if constexpr (SWAP) {
+                range[0] = SWAP_64(range[0]);
+                range[1] = SWAP_64(range[1]);
+            }
+            std::memcpy(dest + getTimeRangeOffset(), range, 16);
+        }
     }
 
 
@@ -1360,8 +1786,38 @@ namespace evio {
             byteOrder = buffer.order();
         }
 
+        // Optional words past the standard size header are only read if in the buffer
+        size_t available = buffer.limit() > offset ? buffer.limit() - offset : 0;
+
+        // Byte order is now known, so read the rest without testing it for each word
+        const uint8_t *src = buffer.array() + buffer.arrayOffset() + offset;
+        if (buffer.isSwapped()) {
+            readHeaderWords<true>(src, available);
+        }
+        else {
+            readHeaderWords<false>(src, available);
+        }
+    }
+
+
+    /**
+     * Reads the header words, in one copy, following the magic word's determination of byte order.
+     *
+     * @tparam SWAP  true if data must be swapped.
+     * @param src    header to read from, at least {@link #HEADER_SIZE_BYTES} long.
+     * @param available number of bytes readable at src. Optional words flagged in the header
+     *                  (checksum, timestamp range) are only read if within this.
+     * @throws EvioException if version earlier than 6.
+     */
+    template<bool SWAP>
+    void RecordHeader::readHeaderWords(const uint8_t *src, size_t available) {
+        Words words;
+        std::memcpy(&words, src, HEADER_SIZE_BYTES);
+        words.checksum = 0;
+        swapWords<SWAP>(words);
+
         // Look at the bit-info word
-        bitInfo = buffer.getInt(BIT_INFO_OFFSET + offset);   // 5*4
+        bitInfo = words.bitInfo;                                    //  5*4
 
         // Set padding and header type
         decodeBitInfoWord(bitInfo);
@@ -1371,31 +1827,51 @@ namespace evio {
             throw EvioException("buffer is in evio format version " + to_string(bitInfo & 0xff));
         }
 
-        recordLengthWords   = buffer.getInt(RECORD_LENGTH_OFFSET + offset);         //  0*4
+        recordLengthWords   = words.recordLength;                   //  0*4
         recordLength        = 4*recordLengthWords;
-        recordNumber        = buffer.getInt( RECORD_NUMBER_OFFSET + offset);        //  1*4
-        headerLengthWords   = buffer.getInt( HEADER_LENGTH_OFFSET + offset);        //  2*4
+        recordNumber        = words.recordNumber;                   //  1*4
+        headerLengthWords   = words.headerLength;                   //  2*4
         setHeaderLength(4*headerLengthWords);
-        entries             = buffer.getInt(EVENT_COUNT_OFFSET + offset);           //  3*4
+        entries             = words.entries;                        //  3*4
 
-        indexLength         = buffer.getInt(INDEX_ARRAY_OFFSET + offset);           //  4*4
-        //cout << "readHeader (Record): indexLen = " << indexLength << endl;
+        indexLength         = words.indexLength;                    //  4*4
         setIndexLength(indexLength);
 
-        userHeaderLength    = buffer.getInt(USER_LENGTH_OFFSET + offset);           //  6*4
+        userHeaderLength    = words.userHeaderLength;               //  6*4
         setUserHeaderLength(userHeaderLength);
 
         // uncompressed data length
-        dataLength          = buffer.getInt(UNCOMPRESSED_LENGTH_OFFSET + offset);   //  8*4
+        dataLength          = words.dataLength;                     //  8*4
         setDataLength(dataLength);
 
-        uint32_t compressionWord = buffer.getInt(COMPRESSION_TYPE_OFFSET + offset); //  9*4
+        uint32_t compressionWord = words.compressionWord;           //  9*4
         compressionType = Compressor::toCompressionType((compressionWord >> 28) & 0xf);
         compressedDataLengthWords = (compressionWord & 0x0FFFFFFF);
         compressedDataLengthPadding = (bitInfo >> 24) & 0x3;
         compressedDataLength = compressedDataLengthWords*4 - compressedDataLengthPadding;
-        recordUserRegisterFirst  = buffer.getLong(REGISTER1_OFFSET + offset);       // 10*4
-        recordUserRegisterSecond = buffer.getLong(REGISTER2_OFFSET + offset);       // 12*4
+        recordUserRegisterFirst  = words.register1;                 // 10*4
+        recordUserRegisterSecond = words.register2;                 // 12*4
+
+        // The optional words are only there if flagged, and may be read separately
+        // by a caller which only read the standard size header.
+        checksum = 0;
+        if (hasChecksum() && available >= CHECKSUM_OFFSET + 4) {
+            std::memcpy(&checksum, src + CHECKSUM_OFFSET, 4);       // 14*4
+            if constexpr (SWAP) checksum = SWAP_32(checksum);
+        }
+
+        timeMin = timeMax = 0;
+        uint32_t timeOffset = getTimeRangeOffset();
+        if (hasTimeRange() && available >= timeOffset + 16) {
+            uint64_t range[2];
+            std::memcpy(range, src + timeOffset, 16);
+            timeMin = range[0];
+            timeMax = range[1];
+            if constexpr (SWAP) {
+                timeMin = SWAP_64(timeMin);
+                timeMax = SWAP_64(timeMax);
+            }
+        }
     }
 
 
@@ -1456,41 +1932,13 @@ namespace evio {
             byteOrder = order;
         }
 
-        // Look at the bit-info word
-        bitInfo = Util::toInt(src + BIT_INFO_OFFSET, order);
-
-        // Set padding and header type
-        decodeBitInfoWord(bitInfo);
-
-        // Look at the version #
-        if (headerVersion < 6) {
-            throw EvioException("buffer is in evio format version " + to_string(bitInfo & 0xff));
+        // Byte order is now known, so read the rest without testing it for each word
+        if (order.isLocalEndian()) {
+            readHeaderWords<false>(src, MAX_HEADER_SIZE_BYTES);
+        }
+        else {
+            readHeaderWords<true>(src, MAX_HEADER_SIZE_BYTES);
         }
-
-        recordLengthWords   = Util::toInt(src + RECORD_LENGTH_OFFSET, order);     //  0*4
-        recordLength        = 4*recordLengthWords;
-        recordNumber        = Util::toInt(src + RECORD_NUMBER_OFFSET, order);     //  1*4
-        headerLengthWords   = Util::toInt(src + HEADER_LENGTH_OFFSET, order);     //  2*4
-        setHeaderLength(4*headerLengthWords);
-        entries             = Util::toInt(src + EVENT_COUNT_OFFSET, order);      //  3*4
-        indexLength         = Util::toInt(src + INDEX_ARRAY_OFFSET, order);      //  4*4
-        //cout << "readHeader (Record): indexLen = " << indexLength << endl;
-        setIndexLength(indexLength);
-        userHeaderLength    = Util::toInt(src + USER_LENGTH_OFFSET, order);      //  6*4
-        setUserHeaderLength(userHeaderLength);
-
-        // uncompressed data length
-        dataLength          = Util::toInt(src + UNCOMPRESSED_LENGTH_OFFSET, order);    //  8*4
-        setDataLength(dataLength);
-
-        uint32_t compressionWord = Util::toInt(src + COMPRESSION_TYPE_OFFSET, order);  //  9*4
-        compressionType = Compressor::toCompressionType((compressionWord >> 28) & 0xf);
-        compressedDataLengthWords = (compressionWord & 0x0FFFFFFF);
-        compressedDataLengthPadding = (bitInfo >> 24) & 0x3;
-        compressedDataLength = compressedDataLengthWords*4 - compressedDataLengthPadding;
-
-        recordUserRegisterFirst  = Util::toLong(src + REGISTER1_OFFSET, order);  // 10*4
-        recordUserRegisterSecond = Util::toLong(src + REGISTER2_OFFSET, order);  // 12*4
     }
 
 
@@ -1541,6 +1989,12 @@ namespace evio {
         ss << hex;
         ss << setw(24) << "user register #1"   << "   : " << recordUserRegisterFirst << endl;
         ss << setw(24) << "user register #2"   << "   : " << recordUserRegisterSecond << endl;
+        if (hasChecksum()) {
+            ss << setw(24) << "checksum"       << "   : " << checksum << endl;
+        }
+        if (hasTimeRange()) {
+            ss << setw(24) << "time range"     << "   : " << timeMin << " - " << timeMax << endl;
+        }
 
         return ss.str();
     }
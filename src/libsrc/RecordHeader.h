@@ -69,6 +69,8 @@ namespace evio {
      *    +--                              --+
      * 14 +                                  |
      *    +----------------------------------+
+     * 15 +        Optional Checksum         | // CRC32C of data following header, if bit 16 set
+     *    +----------------------------------+
      *
      * -------------------
      *   Compression Type
@@ -77,6 +79,7 @@ namespace evio {
      *     1  = LZ4 fastest
      *     2  = LZ4 best
      *     3  = gzip
+     *     4  = zstd (not readable by jevio or evio 6.0)
      *
      * -------------------
      *   Bit Info Word
@@ -92,15 +95,24 @@ namespace evio {
      *                                      4 = User
      *                                      5 = Control
      *                                     15 = Other
-     *    15-19 = reserved
+     *    15    = true if user register 2 holds a filter of the tags/nums of the events
+     *    16    = true if the header is 15 words with the last holding a checksum
+     *    17    = true if the data was compressed with the file's trained compression dictionary
+     *    18    = true if the data was lz4 compressed in independent blocks
+     *    19    = true if the header has 4 more words holding the min & max event timestamps
      *    20-21 = pad 1
      *    22-23 = pad 2
      *    24-25 = pad 3
-     *    26-27 = reserved
+     *    26-27 = filter applied to the data before it was compressed: 0 = none,
+     *                                                                 1 = 16 bit byte shuffle
+     *                                                                 2 = 32 bit byte shuffle
+     *                                                                 3 = 32 bit delta, then byte shuffle
      *    28-31 = general header type: 0 = Evio record,
      *                                 3 = Evio file trailer
      *                                 4 = HIPO record,
      *                                 7 = HIPO file trailer
+     *                                 8 = Evio record with data grouped by column
+     *                                     (rejected by readers which predate it)
      *
      * ------------------------------------------------------------
      * ------------------------------------------------------------
@@ -186,6 +198,8 @@ namespace evio {
         /** Array to help find number of bytes to pad data. */
         static uint32_t padValue[4];
 
+        static uint64_t tagFilterKeyBits(uint32_t key);
+
     public:
 
         /** Number of 32-bit words in a normal sized header. */
@@ -221,6 +235,10 @@ namespace evio {
         static const uint32_t   REGISTER1_OFFSET = 40;
         /** Byte offset from beginning of header to the user register #2. */
         static const uint32_t   REGISTER2_OFFSET = 48;
+        /** Byte offset from beginning of header to the optional checksum. */
+        static const uint32_t   CHECKSUM_OFFSET = 56;
+        /** Number of bytes in the largest header, with checksum and timestamp range. */
+        static const uint32_t   MAX_HEADER_SIZE_BYTES = 76;
 
         // Bits in bit info word
 
@@ -246,6 +264,30 @@ namespace evio {
         /** 11-14th bits in bitInfo word in record header for CODA data type, other = 15. */
         static const uint32_t   DATA_OTHER_BITS   = 0x7800;
 
+        /** 15th bit set in bitInfo word in header means user register 2 holds a
+         *  Bloom filter of the tags and nums of the top-level banks of its events. */
+        static const uint32_t   TAG_FILTER_BIT = 0x8000;
+
+        /** 16th bit set in bitInfo word in header means the header has a 15th word
+         *  holding the CRC32C of the record's data which follows the header. */
+        static const uint32_t   CHECKSUM_BIT = 0x10000;
+
+        /** 17th bit set in bitInfo word in header means the record's data was compressed
+         *  with the trained dictionary stored in the file header's user header. */
+        static const uint32_t   COMPRESSION_DICT_BIT = 0x20000;
+
+        /** 18th bit set in bitInfo word in header means the record's data was lz4 compressed
+         *  in independent blocks preceded by a table of their lengths (see {@link SeekableCompression}). */
+        static const uint32_t   SEEKABLE_BIT = 0x40000;
+
+        /** 19th bit set in bitInfo word in header means the header has 4 more words, following
+         *  the checksum if any, holding the min and max 64-bit timestamps of the record's events. */
+        static const uint32_t   TIME_RANGE_BIT = 0x80000;
+
+        /** 26-27th bits in bitInfo word in header hold the {@link Compressor::PreFilter}
+         *  applied to the record's data before it was compressed. */
+        static const uint32_t   PRE_FILTER_MASK = 0x0C000000;
+
         // Bit masks
 
         /** Mask to get version number from 6th int in header. */
@@ -270,6 +312,12 @@ namespace evio {
         uint64_t recordUserRegisterFirst = 0ULL;
         /** Second user-defined 64-bit register. 13th and 14th words. */
         uint64_t recordUserRegisterSecond = 0ULL;
+        /** CRC32C of the data following the header. Optional 15th word. */
+        uint32_t checksum = 0;
+        /** Smallest timestamp of the record's events. Optional, past any checksum. */
+        uint64_t timeMin = 0ULL;
+        /** Largest timestamp of the record's events. Optional, following timeMin. */
+        uint64_t timeMax = 0ULL;
         /** Position of this header in a file. */
         size_t position = 0ULL;
         /** Length of the entire record this header is a part of (bytes). */
@@ -333,7 +381,7 @@ namespace evio {
         /** Byte order of file/buffer this header was read from. */
         ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
 
-        /** Type of data compression (0=none, 1=LZ4 fast, 2=LZ4 best, 3=gzip).
+        /** Type of data compression (0=none, 1=LZ4 fast, 2=LZ4 best, 3=gzip, 4=zstd).
           * Highest 4 bits of 10th word. */
         Compressor::CompressionType compressionType {Compressor::UNCOMPRESSED};
 
@@ -352,6 +400,36 @@ namespace evio {
 
         void bitInfoInit();
         void decodeBitInfoWord(uint32_t word);
+        void setExtendedHeaderLength();
+
+        /**
+         * The words of a record header laid out just as in a buffer, so all of them
+         * are read or written with one copy and, if need be, swapped in place.
+         */
+        struct Words {
+            uint32_t recordLength;       //  0*4
+            uint32_t recordNumber;       //  1*4
+            uint32_t headerLength;       //  2*4
+            uint32_t entries;            //  3*4
+            uint32_t indexLength;        //  4*4
+            uint32_t bitInfo;            //  5*4
+            uint32_t userHeaderLength;   //  6*4
+            uint32_t magic;              //  7*4
+            uint32_t dataLength;         //  8*4
+            uint32_t compressionWord;    //  9*4
+            uint64_t register1;          // 10*4
+            uint64_t register2;          // 12*4
+            uint32_t checksum;           // 14*4
+        };
+
+        template<bool SWAP>
+        static void swapWords(Words & words);
+
+        template<bool SWAP>
+        void readHeaderWords(const uint8_t *src, size_t available);
+
+        template<bool SWAP>
+        void writeHeaderWords(uint8_t *dest) const;
 
     public:
 
@@ -385,6 +463,10 @@ namespace evio {
         uint32_t  getRecordNumber() const;
         uint64_t  getUserRegisterFirst() const;
         uint64_t  getUserRegisterSecond() const;
+        uint32_t  getChecksum() const;
+        uint64_t  getTimeMin() const;
+        uint64_t  getTimeMax() const;
+        uint32_t  getTimeRangeOffset() const;
         size_t    getPosition() const;
         Compressor::CompressionType  getCompressionType() const;
 
@@ -415,10 +497,42 @@ namespace evio {
         bool        isLastRecord() const;
         static bool isLastRecord(uint32_t bitInfo);
 
+        uint32_t    hasTagFilter(bool hasFilter);
+        bool        hasTagFilter() const;
+        static bool hasTagFilter(uint32_t bitInfo);
+
+        static uint64_t tagFilterBits(uint16_t tag, uint8_t num);
+        void  setTagFilter(uint64_t filter);
+        bool  mayContain(uint16_t tag, uint8_t num) const;
+        bool  mayContainTag(uint16_t tag) const;
+
+        uint32_t    hasChecksum(bool hasSum);
+        bool        hasChecksum() const;
+        static bool hasChecksum(uint32_t bitInfo);
+
+        uint32_t    hasTimeRange(bool hasRange);
+        bool        hasTimeRange() const;
+        static bool hasTimeRange(uint32_t bitInfo);
+        void  setTimeRange(uint64_t min, uint64_t max);
+        bool  mayContainTime(uint64_t t0, uint64_t t1) const;
+
+        uint32_t    hasCompressionDictionary(bool hasDict);
+        bool        hasCompressionDictionary() const;
+        static bool hasCompressionDictionary(uint32_t bitInfo);
+
+        uint32_t    isSeekable(bool seekable);
+        bool        isSeekable() const;
+        static bool isSeekable(uint32_t bitInfo);
+
+        uint32_t    setPreFilter(uint32_t filter);
+        uint32_t    getPreFilter() const;
+        static uint32_t getPreFilter(uint32_t bitInfo);
+
         bool        isCompressed() const;
 
         bool        isEvioTrailer() const;
         bool        isEvioRecord()  const;
+        bool        isColumnar()    const;
         bool        isHipoTrailer() const;
         bool        isHipoRecord()  const;
 
@@ -445,6 +559,7 @@ namespace evio {
         RecordHeader & setHeaderLength(uint32_t length);
         RecordHeader & setUserRegisterFirst(uint64_t reg);
         RecordHeader & setUserRegisterSecond(uint64_t reg);
+        RecordHeader & setChecksum(uint32_t sum);
 
 
         void writeHeader(ByteBuffer & buf, size_t off = 0);
@@ -13,6 +13,10 @@
 
 
 #include "RecordInput.h"
+#include "Profiler.h"
+#include "Crc32c.h"
+#include "SeekableCompression.h"
+#include "ColumnLayout.h"
 
 
 namespace evio {
@@ -64,6 +68,12 @@ namespace evio {
             eventsOffset             = srcRec.eventsOffset;
             uncompressedEventsLength = srcRec.uncompressedEventsLength;
             byteOrder                = srcRec.byteOrder;
+            viewBuffer               = srcRec.viewBuffer;
+            viewOffset               = srcRec.viewOffset;
+            verifyChecksum           = srcRec.verifyChecksum;
+            compressionDictionary    = srcRec.compressionDictionary;
+            cached                   = srcRec.cached;
+            ownDataBuffer            = srcRec.ownDataBuffer;
         }
     }
 
@@ -98,6 +108,12 @@ namespace evio {
             eventsOffset             = other.eventsOffset;
             uncompressedEventsLength = other.uncompressedEventsLength;
             byteOrder                = other.byteOrder;
+            viewBuffer               = other.viewBuffer;
+            viewOffset               = other.viewOffset;
+            verifyChecksum           = other.verifyChecksum;
+            compressionDictionary    = other.compressionDictionary;
+            cached                   = other.cached;
+            ownDataBuffer            = other.ownDataBuffer;
         }
         return *this;
     }
@@ -121,6 +137,12 @@ namespace evio {
             eventsOffset             = other.eventsOffset;
             uncompressedEventsLength = other.uncompressedEventsLength;
             byteOrder                = other.byteOrder;
+            viewBuffer               = other.viewBuffer;
+            viewOffset               = other.viewOffset;
+            verifyChecksum           = other.verifyChecksum;
+            compressionDictionary    = other.compressionDictionary;
+            cached                   = other.cached;
+            ownDataBuffer            = other.ownDataBuffer;
         }
         return *this;
     }
@@ -156,14 +178,276 @@ namespace evio {
      * Get the buffer with all uncompressed data in it.
      * It's position and limit are set to read only event data.
      * That means no header, index, or user-header.
+     * If the record was read in place, it views the buffer read from, such as a
+     * memory mapped file, which it keeps alive as long as it is around.
      * @return  the buffer with uncompressed event data in it.
      */
     std::shared_ptr<ByteBuffer> RecordInput::getUncompressedDataBuffer() {
+        if (viewBuffer != nullptr) {
+            // Data was never copied, return a view into the buffer it lives in.
+            // Unlike a duplicate, the view shares ownership of that buffer, as events do,
+            // so memory mapped data stays mapped as long as the view is around.
+            auto view = std::make_shared<ByteBuffer>(
+                    std::shared_ptr<uint8_t>(viewBuffer, viewBuffer->array() + viewBuffer->arrayOffset()),
+                    viewBuffer->capacity());
+            view->order(viewBuffer->order());
+            view->limit(viewOffset + eventsOffset + uncompressedEventsLength).
+                  position(viewOffset + eventsOffset);
+            return view;
+        }
+        if (cached != nullptr) {
+            // Cached data is shared with other readers, so leave its position and limit alone
+            auto view = dataBuffer->duplicate();
+            view->limit(eventsOffset + uncompressedEventsLength).position(eventsOffset);
+            return view;
+        }
         dataBuffer->limit(eventsOffset + uncompressedEventsLength).position(eventsOffset);
         return dataBuffer;
     }
 
 
+    /**
+     * Get a pointer to the beginning of this record's uncompressed data
+     * (index array, if not read in place, followed by user header and events).
+     * @return pointer to the beginning of this record's uncompressed data.
+     */
+    uint8_t * RecordInput::dataArray() const {
+        if (viewBuffer != nullptr) {
+            return viewBuffer->array() + viewBuffer->arrayOffset() + viewOffset;
+        }
+        return dataBuffer->array();
+    }
+
+
+    /**
+     * Was the current record read in place with {@link #readRecordInPlace}
+     * so that its event data is not copied, but viewed in the buffer it was read from?
+     * @return true if current record's data are viewed in place, else false.
+     */
+    bool RecordInput::isInPlace() const {return viewBuffer != nullptr;}
+
+
+    /**
+     * Is the current record one taken from the {@link RecordCache}
+     * with {@link #readCachedRecord}?
+     * @return true if current record is cached.
+     */
+    bool RecordInput::isCached() const {return cached != nullptr;}
+
+
+    /**
+     * Before reading a record, go back to this object's own data buffer
+     * if the last record read was a cached one.
+     */
+    void RecordInput::releaseCached() {
+        if (cached == nullptr) return;
+        dataBuffer = ownDataBuffer;
+        ownDataBuffer = nullptr;
+        cached = nullptr;
+    }
+
+
+    /**
+     * Make a record taken from the {@link RecordCache} the current record, without copying.
+     * Its data is viewed, never written to, until the next record is read.
+     * @param entry cached record.
+     */
+    void RecordInput::readCachedRecord(std::shared_ptr<const RecordCache::Entry> const & entry) {
+        if (cached == nullptr) {
+            ownDataBuffer = dataBuffer;
+        }
+        cached     = entry;
+        dataBuffer = entry->data;
+        viewBuffer = nullptr;
+
+        // Cached data buffer already has the right order, don't touch it
+        byteOrder = entry->order;
+        recordBuffer.order(byteOrder);
+        headerBuffer.order(byteOrder);
+
+        header->copy(entry->header);
+        nEntries                 = entry->entries;
+        userHeaderOffset         = entry->userHeaderOffset;
+        eventsOffset             = entry->eventsOffset;
+        uncompressedEventsLength = entry->eventsLength;
+    }
+
+
+    /**
+     * Copy the current record into an object which can be placed in the {@link RecordCache}.
+     * Only compressed records are worth caching. Uncompressed ones cost about as much to
+     * read again as to copy, and those read in place are not copied at all.
+     * @return cached form of current record, null if not worth caching.
+     */
+    std::shared_ptr<const RecordCache::Entry> RecordInput::makeCacheEntry() const {
+        if (cached != nullptr) {
+            return cached;
+        }
+        if (viewBuffer != nullptr || !header->isCompressed()) {
+            return nullptr;
+        }
+
+        auto entry = std::make_shared<RecordCache::Entry>();
+        entry->header = std::make_shared<RecordHeader>();
+        entry->header->copy(header);
+
+        // Index (converted to offsets), user header and events
+        size_t length = eventsOffset + uncompressedEventsLength;
+        entry->data = std::make_shared<ByteBuffer>(length);
+        entry->data->order(byteOrder);
+        std::memcpy((void *)entry->data->array(), (const void *)dataBuffer->array(), length);
+
+        entry->entries          = nEntries;
+        entry->userHeaderOffset = userHeaderOffset;
+        entry->eventsOffset     = eventsOffset;
+        entry->eventsLength     = uncompressedEventsLength;
+        entry->order            = byteOrder;
+        return entry;
+    }
+
+
+    /**
+     * Check the data of each record read against the CRC32C in its header, if it has one.
+     * See {@link RecordOutput#setChecksum(bool)}. Records without a checksum are read as usual.
+     * @param verify true if records' data are to be checked against their checksums.
+     */
+    void RecordInput::setVerifyChecksum(bool verify) {verifyChecksum = verify;}
+
+
+    /**
+     * Is the data of each record read checked against the checksum in its header?
+     * @return true if records' data are checked against their checksums.
+     */
+    bool RecordInput::getVerifyChecksum() const {return verifyChecksum;}
+
+
+    /**
+     * Set the trained dictionary, stored in the file header's user header, which is
+     * needed to decompress records with {@link RecordHeader#COMPRESSION_DICT_BIT} set.
+     * See {@link RecordOutput#setCompressionDictionary(std::shared_ptr<CompressionDictionary>)}.
+     * @param dict trained compression dictionary, or null if none.
+     */
+    void RecordInput::setCompressionDictionary(std::shared_ptr<CompressionDictionary> dict) {
+        compressionDictionary = std::move(dict);
+    }
+
+
+    /**
+     * Get the trained dictionary used to decompress records.
+     * @return trained compression dictionary, or null if none.
+     */
+    std::shared_ptr<CompressionDictionary> RecordInput::getCompressionDictionary() const {
+        return compressionDictionary;
+    }
+
+
+    /**
+     * Get the dictionary to decompress the record of the given header with.
+     * @param hdr  header of record to decompress.
+     * @param dict trained compression dictionary available, or null if none.
+     * @return dictionary to decompress with, or nullptr if record was compressed without one.
+     * @throws EvioException if record was compressed with a dictionary, but none is available.
+     */
+    const CompressionDictionary * RecordInput::dictionaryFor(const RecordHeader & hdr,
+                                                             const std::shared_ptr<CompressionDictionary> & dict) {
+        if (!hdr.hasCompressionDictionary()) {
+            return nullptr;
+        }
+        if (dict == nullptr) {
+            throw EvioException("record #" + std::to_string(hdr.getRecordNumber()) +
+                                " needs a compression dictionary");
+        }
+        return dict.get();
+    }
+
+
+    /**
+     * If verifying, and the current header has a checksum, check it against the
+     * record's data as read, before any decompression.
+     * @param data   pointer to record's data just past its header.
+     * @param length number of bytes of data covered by the checksum.
+     * @throws EvioException if the checksum does not match.
+     */
+    void RecordInput::checkChecksum(const uint8_t *data, uint32_t length) const {
+        if (!verifyChecksum || !header->hasChecksum()) {
+            return;
+        }
+        if (Crc32c::compute(data, length) != header->getChecksum()) {
+            throw EvioException("record #" + std::to_string(header->getRecordNumber()) +
+                                " checksum mismatch");
+        }
+    }
+
+
+    /**
+     * Decompress the lz4 data of a record, which may be seekable
+     * (see {@link RecordHeader#isSeekable()}), into dst at its position.
+     * Like {@link Compressor#uncompressLZ4(ByteBuffer &, int, int, ByteBuffer &, const CompressionDictionary *)},
+     * dst's limit is set to the end of the data and its position left at the start.
+     *
+     * @param hdr     header of record.
+     * @param src     buffer, in the record's byte order, of compressed data.
+     * @param srcOff  offset in src of compressed data.
+     * @param srcSize bytes of compressed data.
+     * @param dst     buffer to write uncompressed data into.
+     * @param dict    dictionary data was compressed with, or nullptr if none.
+     * @return bytes of uncompressed data.
+     * @throws EvioException if dst is too small or data is malformed.
+     */
+    int RecordInput::uncompressLZ4(const RecordHeader & hdr, ByteBuffer & src, size_t srcOff, uint32_t srcSize,
+                                   ByteBuffer & dst, const CompressionDictionary *dict) {
+        if (!hdr.isSeekable()) {
+            return Compressor::getInstance().uncompressLZ4(src, srcOff, srcSize, dst, dict);
+        }
+
+        size_t dstOff = dst.position();
+        uint32_t size = SeekableCompression::uncompress(src.array() + srcOff, srcSize,
+                                                        dst.array() + dstOff, dst.remaining(),
+                                                        src.order(), dict);
+        dst.limit(dstOff + size).position(dstOff);
+        return size;
+    }
+
+
+    /**
+     * Undo, in place, any filter applied to a record's data before it was compressed
+     * (see {@link RecordHeader#getPreFilter()}).
+     * @param hdr   header of record.
+     * @param data  uncompressed data of record, starting with its index.
+     * @param order byte order of record.
+     */
+    void RecordInput::unfilterData(const RecordHeader & hdr, uint8_t *data, ByteOrder const & order) {
+        if (!hdr.isCompressed() || hdr.getPreFilter() == Compressor::NO_FILTER) return;
+
+        // Exactly the bytes which were filtered: index, padded user header, unpadded events
+        uint32_t len = hdr.getIndexLength() + 4*hdr.getUserHeaderLengthWords() + hdr.getDataLength();
+        Compressor::unfilter(Compressor::toPreFilter(hdr.getPreFilter()), data, len, order);
+    }
+
+
+    /**
+     * Decompress the data of a record whose banks are grouped by column
+     * (see {@link RecordHeader#isColumnar()}), putting its events back together.
+     *
+     * @param hdr         header of record.
+     * @param src         compressed data.
+     * @param srcSize     bytes of compressed data.
+     * @param dst         where to write the index, user header and events.
+     * @param dstCapacity bytes available in dst.
+     * @param order       byte order of record.
+     * @param dict        dictionary data was compressed with, or nullptr if none.
+     * @return bytes of uncompressed data.
+     * @throws EvioException if dst is too small or data is malformed.
+     */
+    uint32_t RecordInput::uncompressColumns(const RecordHeader & hdr, const uint8_t *src, uint32_t srcSize,
+                                            uint8_t *dst, size_t dstCapacity, ByteOrder const & order,
+                                            const CompressionDictionary *dict) {
+        return ColumnLayout::uncompress(src, srcSize, dst, dstCapacity,
+                                        Compressor::toCompressionType(hdr.getCompressionType()),
+                                        order, dict);
+    }
+
+
     /**
      * Does this record contain an event index?
      * @return true if record contains an event index, else false.
@@ -202,19 +486,50 @@ namespace evio {
         uint32_t length = lastPosition - firstPosition;
         uint32_t offset = eventsOffset + firstPosition;
 
+        if (len != nullptr) {
+            *len = length;
+        }
+
+        if (viewBuffer != nullptr) {
+            // No copy, share ownership of the buffer the data lives in
+            return std::shared_ptr<uint8_t>(viewBuffer, dataArray() + offset);
+        }
+
         // TODO: Allocating memory here!!!
         auto event = std::shared_ptr<uint8_t>(new uint8_t[length], std::default_delete<uint8_t[]>());
 
         std::memcpy((void *)event.get(), (const void *)(dataBuffer->array() + offset), length);
-        if (len != nullptr) {
-            *len = length;
-        }
 
 //std::cout << "getEvent: reading from " << offset << ",  length = " << length << std::endl;
         return event;
     }
 
 
+    /**
+     * Get a view of the event at the given index without copying it.
+     * The view is valid only until the next record is read into this object.
+     *
+     * @param index index of event starting at 0.
+     * @return view of event's bytes in this record's byte order.
+     * @throws EvioException if index too large.
+     */
+    ByteBufferView RecordInput::getEventView(uint32_t index) const {
+
+        if (index >= header->getEntries()) {
+            throw EvioException("index too large");
+        }
+
+        uint32_t firstPosition = 0;
+        if (index > 0) {
+            firstPosition = dataBuffer->getUInt((index - 1) * 4);
+        }
+        uint32_t lastPosition = dataBuffer->getUInt(index * 4);
+
+        return ByteBufferView(dataArray() + eventsOffset + firstPosition,
+                              lastPosition - firstPosition, byteOrder);
+    }
+
+
     /**
      * Returns the length of the event with given index.
      * @param index index of the event
@@ -292,7 +607,7 @@ namespace evio {
         buffer.order(byteOrder);
 
         std::memcpy((void *)(buffer.array() + buffer.arrayOffset() + bufOffset),
-                    (const void *)(dataBuffer->array() + offset), length);
+                    (const void *)(dataArray() + offset), length);
 
         // Make buffer ready to read.
         // Always set limit first, else you can cause exception.
@@ -311,7 +626,7 @@ namespace evio {
         uint32_t length = header->getUserHeaderLength();
         auto userHeader = std::shared_ptr<uint8_t>(new uint8_t[length], std::default_delete<uint8_t[]>());
         std::memcpy((void *)(userHeader.get()),
-                    (const void *)(dataBuffer->array() + userHeaderOffset), length);
+                    (const void *)(dataArray() + userHeaderOffset), length);
 
         return userHeader;
     }
@@ -361,7 +676,7 @@ namespace evio {
         buffer.order(byteOrder);
 
         std::memcpy((void *)(buffer.array() + buffer.arrayOffset() + bufOffset),
-                    (const void *)(dataBuffer->array() + userHeaderOffset), length);
+                    (const void *)(dataArray() + userHeaderOffset), length);
 
         // Make buffer ready to read.
         // Always set limit first, else you can cause exception.
@@ -418,10 +733,16 @@ namespace evio {
      */
     void RecordInput::readRecord(std::ifstream & file, size_t position) {
 
+        // Never write into a cached record's data
+        releaseCached();
+
         // Read header
         if (!file.is_open()) {
             throw EvioException("file not open");
         }
+        viewBuffer = nullptr;
+        EVIO_PROFILE_BEGIN(io, RECORD_READ_IO);
+        EVIO_PROFILE_DECLARE(decompress, RECORD_DECOMPRESS);
         file.seekg(position);
         file.read(reinterpret_cast<char *>(headerBuffer.array()), RecordHeader::HEADER_SIZE_BYTES);
 
@@ -435,6 +756,16 @@ namespace evio {
         uint32_t headerLength      = header->getHeaderLength();
         uint32_t cLength           = header->getCompressedDataLength();
 
+        // The checksum is past the standard size header just read
+        if (verifyChecksum && header->hasChecksum()) {
+            uint32_t sum;
+            file.read(reinterpret_cast<char *>(&sum), sizeof(sum));
+            if (headerBuffer.isSwapped()) {
+                sum = SWAP_32(sum);
+            }
+            header->setChecksum(sum);
+        }
+
         // How many bytes will the expanded record take?
         // Just data:
         uncompressedEventsLength = 4*header->getDataLengthWords();
@@ -456,13 +787,26 @@ namespace evio {
         file.seekg(position + headerLength);
 
         // Decompress data
-        switch (header->getCompressionType()) {
+        if (header->isColumnar()) {
+            file.read(reinterpret_cast<char *>(recordBuffer.array()), cLength);
+            EVIO_PROFILE_END(io);
+            EVIO_PROFILE_START(decompress);
+            checkChecksum(recordBuffer.array(), cLength);
+            uncompressColumns(*header, recordBuffer.array(), cLength,
+                              dataBuffer->array(), dataBuffer->capacity(), headerBuffer.order(),
+                              dictionaryFor(*header, compressionDictionary));
+        }
+        else switch (header->getCompressionType()) {
             case 1:
             case 2:
                 // LZ4
                 // Read compressed data
                 file.read(reinterpret_cast<char *>(recordBuffer.array()), cLength);
-                Compressor::getInstance().uncompressLZ4(recordBuffer, cLength, *(dataBuffer.get()));
+                EVIO_PROFILE_END(io);
+                EVIO_PROFILE_START(decompress);
+                checkChecksum(recordBuffer.array(), cLength);
+                uncompressLZ4(*header, recordBuffer, recordBuffer.position(), cLength, *(dataBuffer.get()),
+                              dictionaryFor(*header, compressionDictionary));
                 break;
 
             case 3:
@@ -470,6 +814,9 @@ namespace evio {
 #ifdef USE_GZIP
                 {
             file.read(reinterpret_cast<char *>(recordBuffer.array()), cLength);
+            EVIO_PROFILE_END(io);
+            EVIO_PROFILE_START(decompress);
+            checkChecksum(recordBuffer.array(), cLength);
             // size of destination buffer on entry, uncompressed bytes on exit
             uint32_t uncompLen = recordBuffer.capacity();
             uint8_t* ungzipped = Compressor::getInstance().uncompressGZIP(recordBuffer.array(), 0,
@@ -481,12 +828,30 @@ namespace evio {
 #endif
                 break;
 
+            case 4:
+                // Zstandard
+#ifdef USE_ZSTD
+                file.read(reinterpret_cast<char *>(recordBuffer.array()), cLength);
+                EVIO_PROFILE_END(io);
+                EVIO_PROFILE_START(decompress);
+                checkChecksum(recordBuffer.array(), cLength);
+                Compressor::getInstance().uncompressZstd(recordBuffer, 0, cLength, *(dataBuffer.get()),
+                                                         dictionaryFor(*header, compressionDictionary));
+#else
+                throw EvioException("zstd compressed data, but zstd not compiled in");
+#endif
+                break;
+
             case 0:
             default:
                 // None
                 // Read uncompressed data - rest of record
                 file.read(reinterpret_cast<char *>(dataBuffer->array()), recordLengthBytes - headerLength);
+                EVIO_PROFILE_END(io);
+                checkChecksum(dataBuffer->array(), recordLengthBytes - headerLength);
         }
+        unfilterData(*header, dataBuffer->array(), headerBuffer.order());
+        EVIO_PROFILE_END(decompress);
 
         // Number of entries in index
         nEntries = header->getEntries();
@@ -495,13 +860,7 @@ namespace evio {
         // Offset from just past header to data (past index + user header)
         eventsOffset = userHeaderOffset + header->getUserHeaderLengthWords()*4;
 
-        // Overwrite event lengths with event offsets
-        int event_pos = 0;
-        for(int i = 0; i < nEntries; i++){
-            int   size = dataBuffer->getInt(i*4);
-            event_pos += size;
-            dataBuffer->putInt(i*4, event_pos);
-        }
+        convertIndex();
     }
 
 
@@ -518,6 +877,11 @@ namespace evio {
      */
     void RecordInput::readRecord(ByteBuffer & buffer, size_t offset) {
 
+        // Never write into a cached record's data
+        releaseCached();
+
+        viewBuffer = nullptr;
+
         // This will switch buffer to proper byte order
         header->readHeader(buffer, offset);
 
@@ -530,6 +894,9 @@ namespace evio {
         uint32_t cLength           = header->getCompressedDataLength();
 
         size_t compDataOffset = offset + headerLength;
+
+        checkChecksum(buffer.array() + buffer.arrayOffset() + compDataOffset,
+                      header->isCompressed() ? cLength : recordLengthBytes - headerLength);
 //std::cout << "readRecord: copy uncompressed data from pos = " << compDataOffset << " = ?" << std::endl;
 //std::cout << "readRecord: offset to header = " << offset << " + headerLen of " << headerLength << std::endl;
 
@@ -546,11 +913,18 @@ namespace evio {
         }
 
         // Decompress data
-        switch (header->getCompressionType()) {
+        EVIO_PROFILE_BEGIN(decompress, RECORD_DECOMPRESS);
+        if (header->isColumnar()) {
+            uncompressColumns(*header, buffer.array() + buffer.arrayOffset() + compDataOffset, cLength,
+                              dataBuffer->array(), dataBuffer->capacity(), buffer.order(),
+                              dictionaryFor(*header, compressionDictionary));
+        }
+        else switch (header->getCompressionType()) {
             case 1:
             case 2:
                 // Read LZ4 compressed data (WARNING: this does set limit on dataBuffer!)
-                Compressor::getInstance().uncompressLZ4(buffer, compDataOffset, cLength, *(dataBuffer.get()));
+                uncompressLZ4(*header, buffer, compDataOffset, cLength, *(dataBuffer.get()),
+                              dictionaryFor(*header, compressionDictionary));
                 break;
 
             case 3:
@@ -566,6 +940,16 @@ namespace evio {
 #endif
                 break;
 
+            case 4:
+                // Read zstd compressed data (this also sets limit on dataBuffer)
+#ifdef USE_ZSTD
+                Compressor::getInstance().uncompressZstd(buffer, compDataOffset, cLength, *(dataBuffer.get()),
+                                                         dictionaryFor(*header, compressionDictionary));
+#else
+                throw EvioException("zstd compressed data, but zstd not compiled in");
+#endif
+                break;
+
             case 0:
             default:
                 // TODO: See if we can avoid this unnecessary copy!
@@ -578,6 +962,8 @@ namespace evio {
                 std::memcpy((void *)dataBuffer->array(),
                             (const void *)(buffer.array() + buffer.arrayOffset() + compDataOffset), len);
         }
+        unfilterData(*header, dataBuffer->array(), buffer.order());
+        EVIO_PROFILE_END(decompress);
 
         // Number of entries in index
         nEntries = header->getEntries();
@@ -588,7 +974,223 @@ namespace evio {
 //std::cout << "readRecord: eventsOffset = " << eventsOffset << std::endl;
 
         // TODO: How do we handle trailers???
-        // Overwrite event lengths with event offsets
+        convertIndex();
+    }
+
+
+    /**
+     * Reads record from the given buffer at the given offset, but without copying
+     * any uncompressed data. Instead the event data and user header are accessed in place,
+     * and only the index array is copied into an internal buffer. This is meant for
+     * large buffers, such as a memory mapped file, in which the data are already in
+     * memory. Compressed data is decompressed just as in
+     * {@link #readRecord(ByteBuffer &, size_t)}.<p>
+     *
+     * Note that events obtained through {@link #getEvent(uint32_t, uint32_t *)} from an
+     * in place record share ownership of the given buffer and are not copies of its data.
+     *
+     * @param buffer buffer containing record data.
+     * @param offset offset in buffer to the beginning of record data.
+     * @throws EvioException if buffer contains too little data,
+     *                       if the input data was corrupted (including if the input data is
+     *                       an incomplete stream),
+     *                       is not in proper format, or version earlier than 6;
+     *                       error in uncompressing gzipped data.
+     */
+    void RecordInput::readRecordInPlace(std::shared_ptr<ByteBuffer> & buffer, size_t offset) {
+
+        // Never write into a cached record's data
+        releaseCached();
+
+        // This will switch buffer to proper byte order
+        header->readHeader(*(buffer.get()), offset);
+
+        if (header->getCompressionType() != Compressor::UNCOMPRESSED) {
+            // Decompression needs a destination, so there is nothing to gain here
+            readRecord(*(buffer.get()), offset);
+            return;
+        }
+
+        // Make sure all internal buffers have the same byte order
+        setByteOrder(buffer->order());
+
+        uint32_t indexLength = header->getIndexLength();
+        size_t dataOffset = offset + header->getHeaderLength();
+
+        if (offset + header->getLength() > buffer->limit()) {
+            throw EvioException("buffer too small to contain record");
+        }
+
+        checkChecksum(buffer->array() + buffer->arrayOffset() + dataOffset,
+                      header->getLength() - header->getHeaderLength());
+
+        // Only the index is copied since it gets converted into event offsets
+        dataBuffer->clear();
+        if (dataBuffer->capacity() < indexLength) {
+            allocate(indexLength);
+        }
+        std::memcpy((void *)dataBuffer->array(),
+                    (const void *)(buffer->array() + buffer->arrayOffset() + dataOffset), indexLength);
+
+        viewBuffer = buffer;
+        viewOffset = dataOffset;
+
+        uncompressedEventsLength = 4*header->getDataLengthWords();
+        nEntries = header->getEntries();
+        userHeaderOffset = nEntries*4;
+        eventsOffset = userHeaderOffset + header->getUserHeaderLengthWords()*4;
+
+        convertIndex();
+    }
+
+
+    /**
+     * Reads a record from the given buffer at the given offset, decompressing its data,
+     * or copying it if uncompressed, straight into a buffer supplied by the caller, such
+     * as pinned memory registered for DMA to a device. The index array, user header and
+     * events land in dest, starting at destOffset, just as they are laid out in the record
+     * (index entries are still event lengths). Only the index array is also copied into an
+     * internal buffer and converted into event offsets, which
+     * {@link #getEventOffsets(std::vector<uint32_t> &)} returns.
+     * Events can then be viewed in place in dest, as after {@link #readRecordInPlace},
+     * until the next record is read.
+     *
+     * @param buffer     buffer containing record data.
+     * @param offset     offset in buffer to the beginning of record data.
+     * @param dest       buffer into which record data is written. Its byte order is set
+     *                   to that of the record.
+     * @param destOffset offset in dest at which to write.
+     * @return number of bytes written into dest.
+     * @throws EvioException if buffer contains too little data, dest is too small,
+     *                       data is not in proper format or is corrupted,
+     *                       or version earlier than 6.
+     */
+    uint32_t RecordInput::readRecordInto(ByteBuffer & buffer, size_t offset,
+                                         std::shared_ptr<ByteBuffer> & dest, size_t destOffset) {
+
+        // Never write into a cached record's data
+        releaseCached();
+
+        viewBuffer = nullptr;
+
+        // This will switch buffer to proper byte order
+        header->readHeader(buffer, offset);
+
+        // Make sure all internal buffers have the same byte order
+        setByteOrder(buffer.order());
+        dest->order(buffer.order());
+
+        uint32_t recordLengthBytes = header->getLength();
+        uint32_t headerLength      = header->getHeaderLength();
+        uint32_t cLength           = header->getCompressedDataLength();
+        uint32_t indexLength       = header->getIndexLength();
+
+        if (offset + recordLengthBytes > buffer.limit()) {
+            throw EvioException("buffer too small to contain record");
+        }
+
+        uint8_t *src = buffer.array() + buffer.arrayOffset() + offset + headerLength;
+        checkChecksum(src, header->isCompressed() ? cLength : recordLengthBytes - headerLength);
+
+        // Everything except the header & don't forget padding
+        uint32_t neededSpace = indexLength +
+                               4*header->getUserHeaderLengthWords() +
+                               4*header->getDataLengthWords();
+
+        if (destOffset + neededSpace > dest->capacity()) {
+            throw EvioException("destination buffer too small");
+        }
+        uint8_t *dst = dest->array() + dest->arrayOffset() + destOffset;
+        int dstCapacity = (int)(dest->capacity() - destOffset);
+
+        if (header->isColumnar()) {
+            uncompressColumns(*header, src, cLength, dst, dstCapacity, buffer.order(),
+                              dictionaryFor(*header, compressionDictionary));
+        }
+        else switch (header->getCompressionType()) {
+            case 1:
+            case 2:
+                if (header->isSeekable()) {
+                    SeekableCompression::uncompress(src, cLength, dst, dstCapacity, buffer.order(),
+                                                    dictionaryFor(*header, compressionDictionary));
+                }
+                else {
+                    Compressor::uncompressLZ4(src, 0, cLength, dst, 0, dstCapacity,
+                                              dictionaryFor(*header, compressionDictionary));
+                }
+                break;
+
+            case 3:
+#ifdef USE_GZIP
+            {
+                uint32_t uncompLen = neededSpace;
+                buffer.limit(offset + headerLength + cLength).position(offset + headerLength);
+                uint8_t* ungzipped = Compressor::getInstance().uncompressGZIP(buffer, &uncompLen);
+                std::memcpy(dst, ungzipped, uncompLen);
+                delete[] ungzipped;
+                buffer.limit(buffer.capacity());
+            }
+#endif
+                break;
+
+            case 4:
+#ifdef USE_ZSTD
+                Compressor::uncompressZstd(src, 0, cLength, dst, 0, dstCapacity,
+                                           dictionaryFor(*header, compressionDictionary));
+#else
+                throw EvioException("zstd compressed data, but zstd not compiled in");
+#endif
+                break;
+
+            case 0:
+            default:
+                std::memcpy(dst, src, recordLengthBytes - headerLength);
+        }
+        unfilterData(*header, dst, buffer.order());
+
+        // Only the index is copied since it gets converted into event offsets
+        dataBuffer->clear();
+        if (dataBuffer->capacity() < indexLength) {
+            allocate(indexLength);
+        }
+        std::memcpy((void *)dataBuffer->array(), (const void *)dst, indexLength);
+
+        viewBuffer = dest;
+        viewOffset = destOffset;
+
+        uncompressedEventsLength = 4*header->getDataLengthWords();
+        nEntries = header->getEntries();
+        userHeaderOffset = nEntries*4;
+        eventsOffset = userHeaderOffset + header->getUserHeaderLengthWords()*4;
+
+        convertIndex();
+        return neededSpace;
+    }
+
+
+    /**
+     * Get the position of every event in the current record, measured from the beginning
+     * of its data (the start of the index array). Event i occupies the bytes from
+     * offsets[i] up to offsets[i+1]. For a record read with
+     * {@link #readRecordInto(ByteBuffer &, size_t, std::shared_ptr<ByteBuffer> &, size_t)},
+     * add the destination offset to get positions in the destination buffer.
+     *
+     * @param offsets vector filled with getEntries() + 1 offsets in bytes.
+     */
+    void RecordInput::getEventOffsets(std::vector<uint32_t> & offsets) const {
+        offsets.resize(nEntries + 1);
+        offsets[0] = eventsOffset;
+        for (uint32_t i=0; i < nEntries; i++) {
+            offsets[i+1] = eventsOffset + dataBuffer->getUInt(i*4);
+        }
+    }
+
+
+    /**
+     * Overwrite the event lengths of the index array, at the beginning of dataBuffer,
+     * with the offset of each event's end, measured from the beginning of the events.
+     */
+    void RecordInput::convertIndex() {
         int event_pos = 0;
         for(int i = 0; i < nEntries; i++){
             int   size = dataBuffer->getInt(i*4);
@@ -609,14 +1211,17 @@ namespace evio {
      * @param srcOff offset into srcBuf to beginning of record data.
      * @param dstBuf buffer into which the record is uncompressed.
      * @param hdr    RecordHeader to be used to read the record header in srcBuf.
+     * @param dict   trained dictionary needed if record was compressed with one, else null.
      * @return the original record size in srcBuf (bytes).
      * @throws EvioException if srcBuf contains too little data,
-     *                       is not in proper format, or version earlier than 6.
+     *                       is not in proper format, or version earlier than 6,
+     *                       or record needs a compression dictionary and dict is null.
      */
     uint32_t RecordInput::uncompressRecord(std::shared_ptr<ByteBuffer> & srcBuf, size_t srcOff,
                                            std::shared_ptr<ByteBuffer> & dstBuf,
-                                           RecordHeader & hdr) {
-        return uncompressRecord(*(srcBuf.get()), srcOff, *(dstBuf.get()), hdr);
+                                           RecordHeader & hdr,
+                                           const std::shared_ptr<CompressionDictionary> & dict) {
+        return uncompressRecord(*(srcBuf.get()), srcOff, *(dstBuf.get()), hdr, dict);
     }
 
 
@@ -631,12 +1236,15 @@ namespace evio {
      * @param srcOff offset into srcBuf to beginning of record data.
      * @param dstBuf buffer into which the record is uncompressed.
      * @param hdr    RecordHeader to be used to read the record header in srcBuf.
+     * @param dict   trained dictionary needed if record was compressed with one, else null.
      * @return the original record size in srcBuf (bytes).
      * @throws EvioException if srcBuf contains too little data,
-     *                       is not in proper format, or version earlier than 6.
+     *                       is not in proper format, or version earlier than 6,
+     *                       or record needs a compression dictionary and dict is null.
      */
     uint32_t RecordInput::uncompressRecord(ByteBuffer & srcBuf, size_t srcOff, ByteBuffer & dstBuf,
-                                           RecordHeader & hdr) {
+                                           RecordHeader & hdr,
+                                           const std::shared_ptr<CompressionDictionary> & dict) {
 
         size_t dstOff = dstBuf.position();
 
@@ -677,12 +1285,21 @@ namespace evio {
         }
 
         // Decompress data
-        switch (compressionType) {
+        bool columnar = hdr.isColumnar();
+        if (columnar) {
+            size_t dstPos = dstBuf.position();
+            uncompressColumns(hdr, srcBuf.array() + srcBuf.arrayOffset() + compressedDataOffset,
+                              compressedDataLength,
+                              dstBuf.array() + dstBuf.arrayOffset() + dstPos, dstBuf.capacity() - dstPos,
+                              srcBuf.order(), dictionaryFor(hdr, dict));
+        }
+        else switch (compressionType) {
             case 1:
             case 2:
                 // Read LZ4 compressed data
-                Compressor::getInstance().uncompressLZ4(srcBuf, compressedDataOffset,
-                                                        compressedDataLength, dstBuf);
+                uncompressLZ4(hdr, srcBuf, compressedDataOffset,
+                              compressedDataLength, dstBuf,
+                              dictionaryFor(hdr, dict));
                 dstBuf.limit(dstBuf.capacity());
                 break;
 
@@ -699,11 +1316,24 @@ namespace evio {
 #endif
                 break;
 
+            case 4:
+                // Read zstd compressed data
+#ifdef USE_ZSTD
+                Compressor::getInstance().uncompressZstd(srcBuf, compressedDataOffset,
+                                                         compressedDataLength, dstBuf,
+                                                         dictionaryFor(hdr, dict));
+                dstBuf.limit(dstBuf.capacity());
+#else
+                throw EvioException("zstd compressed data, but zstd not compiled in");
+#endif
+                break;
+
             case 0:
             default:
                 // Everything copied over above
                 break;
         }
+        unfilterData(hdr, dstBuf.array() + dstBuf.arrayOffset() + dstOff + headerBytes, srcBuf.order());
 
         srcBuf.limit(srcBuf.capacity());
 
@@ -714,7 +1344,12 @@ namespace evio {
         // Reset the compression type and length in header to 0
         dstBuf.putInt(dstOff + RecordHeader::COMPRESSION_TYPE_OFFSET, 0);
         hdr.setCompressionType(Compressor::UNCOMPRESSED).setCompressedDataLength(0);
-        // The previous call updated the bitinfo word in hdr. Write this into buf:
+        hdr.setPreFilter(Compressor::NO_FILTER);
+        // Events are back in their usual layout
+        if (columnar) {
+            hdr.setHeaderType(HeaderType::EVIO_RECORD);
+        }
+        // The previous calls updated the bitinfo word in hdr. Write this into buf:
         dstBuf.putInt(dstOff + RecordHeader::BIT_INFO_OFFSET, hdr.getBitInfoWord());
 
         // Reset the header length
@@ -759,5 +1394,67 @@ namespace evio {
         std::cout << std::endl;
     }
 
-}
 
+    /**
+     * Get the keys of the columns of a record whose banks are grouped by column
+     * (see {@link ColumnLayout#makeKey(uint16_t, uint8_t)}), in the order they are stored.
+     *
+     * @param buffer buffer containing record.
+     * @param offset offset into buffer to beginning of record.
+     * @param keys   filled with keys of columns.
+     * @throws EvioException if buffer contains too little data, record is not
+     *                       grouped by column, or its data is malformed.
+     */
+    void RecordInput::getColumnKeys(ByteBuffer & buffer, size_t offset, std::vector<uint32_t> & keys) {
+        RecordHeader hdr;
+        hdr.readHeader(buffer, offset);
+        if (!hdr.isColumnar()) {
+            throw EvioException("record is not grouped by column");
+        }
+        if (offset + hdr.getLength() > buffer.limit()) {
+            throw EvioException("buffer too small to contain record");
+        }
+
+        ColumnLayout::getKeys(buffer.array() + buffer.arrayOffset() + offset + hdr.getHeaderLength(),
+                              hdr.getCompressedDataLength(), buffer.order(), keys);
+    }
+
+
+    /**
+     * Decompress only the payloads of the banks with the given tag and num found one level
+     * down in the events of a record whose banks are grouped by column, leaving the rest
+     * of the record compressed. The payloads in event i are the bytes of data from
+     * eventOffsets[i] up to eventOffsets[i+1], in the record's byte order.
+     * Banks of events which are not banks of banks are not part of any column.
+     *
+     * @param buffer       buffer containing record.
+     * @param offset       offset into buffer to beginning of record.
+     * @param tag          tag of banks.
+     * @param num          num of banks.
+     * @param data         filled with payloads of banks.
+     * @param eventOffsets filled with getEntries() + 1 offsets into data.
+     * @param dict         trained dictionary needed if record was compressed with one, else null.
+     * @return bytes of payloads, 0 if the record has no such banks.
+     * @throws EvioException if buffer contains too little data, record is not
+     *                       grouped by column, or its data is malformed.
+     */
+    uint32_t RecordInput::readColumn(ByteBuffer & buffer, size_t offset, uint16_t tag, uint8_t num,
+                                     std::vector<uint8_t> & data, std::vector<uint32_t> & eventOffsets,
+                                     const std::shared_ptr<CompressionDictionary> & dict) {
+        RecordHeader hdr;
+        hdr.readHeader(buffer, offset);
+        if (!hdr.isColumnar()) {
+            throw EvioException("record is not grouped by column");
+        }
+        if (offset + hdr.getLength() > buffer.limit()) {
+            throw EvioException("buffer too small to contain record");
+        }
+
+        return ColumnLayout::readColumn(buffer.array() + buffer.arrayOffset() + offset + hdr.getHeaderLength(),
+                                        hdr.getCompressedDataLength(), ColumnLayout::makeKey(tag, num),
+                                        data, eventOffsets,
+                                        Compressor::toCompressionType(hdr.getCompressionType()),
+                                        buffer.order(), dictionaryFor(hdr, dict));
+    }
+
+}
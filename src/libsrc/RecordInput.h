@@ -15,12 +15,16 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <vector>
 
 
 #include "ByteOrder.h"
 #include "ByteBuffer.h"
+#include "ByteBufferView.h"
 #include "RecordHeader.h"
 #include "Compressor.h"
+#include "CompressionDictionary.h"
+#include "RecordCache.h"
 #include "EvioException.h"
 
 
@@ -138,12 +142,46 @@ namespace evio {
         /** Record's header is read into this buffer. */
         ByteBuffer headerBuffer;
 
+        /** If not null, buffer (usually a memory mapped file) whose memory holds the
+         *  uncompressed data of the current record. Data is read from it in place instead
+         *  of from dataBuffer which then only contains the index array. */
+        std::shared_ptr<ByteBuffer> viewBuffer = nullptr;
+
+        /** Position in viewBuffer of the current record's data (just past its header). */
+        size_t viewOffset = 0;
+
+        /** If true, check the data of each record read against any checksum in its header. */
+        bool verifyChecksum = false;
+
+        /** Trained dictionary needed to decompress records which have
+         *  {@link RecordHeader#COMPRESSION_DICT_BIT} set, else null. */
+        std::shared_ptr<CompressionDictionary> compressionDictionary = nullptr;
+
+        /** If not null, cached record whose data buffer is dataBuffer. It's never written to,
+         *  and holding it keeps views into its events valid after it's dropped from the cache. */
+        std::shared_ptr<const RecordCache::Entry> cached = nullptr;
+
+        /** This object's own data buffer, put aside while dataBuffer is that of a cached record. */
+        std::shared_ptr<ByteBuffer> ownDataBuffer = nullptr;
+
 
     private:
 
         void allocate(size_t size);
         void setByteOrder(const ByteOrder & order);
         void showIndex() const;
+        void convertIndex();
+        uint8_t * dataArray() const;
+        void checkChecksum(const uint8_t *data, uint32_t length) const;
+        void releaseCached();
+        static const CompressionDictionary * dictionaryFor(const RecordHeader & hdr,
+                                                           const std::shared_ptr<CompressionDictionary> & dict);
+        static int uncompressLZ4(const RecordHeader & hdr, ByteBuffer & src, size_t srcOff, uint32_t srcSize,
+                                 ByteBuffer & dst, const CompressionDictionary *dict);
+        static void unfilterData(const RecordHeader & hdr, uint8_t *data, ByteOrder const & order);
+        static uint32_t uncompressColumns(const RecordHeader & hdr, const uint8_t *src, uint32_t srcSize,
+                                          uint8_t *dst, size_t dstCapacity, ByteOrder const & order,
+                                          const CompressionDictionary *dict);
 
     public:
 
@@ -171,6 +209,7 @@ namespace evio {
         ByteBuffer & getUserHeader(ByteBuffer & buffer, size_t bufOffset = 0);
 
         std::shared_ptr<uint8_t> getEvent(uint32_t index, uint32_t * len);
+        ByteBufferView getEventView(uint32_t index) const;
         uint32_t getEventLength(uint32_t index) const;
         uint32_t getEntries() const;
 
@@ -179,13 +218,34 @@ namespace evio {
 
         void readRecord(std::ifstream & file, size_t position);
         void readRecord(ByteBuffer & buffer, size_t offset);
+        void readRecordInPlace(std::shared_ptr<ByteBuffer> & buffer, size_t offset);
+        uint32_t readRecordInto(ByteBuffer & buffer, size_t offset,
+                                std::shared_ptr<ByteBuffer> & dest, size_t destOffset = 0);
+        bool isInPlace() const;
+        bool isCached() const;
+        void readCachedRecord(std::shared_ptr<const RecordCache::Entry> const & entry);
+        std::shared_ptr<const RecordCache::Entry> makeCacheEntry() const;
+        void getEventOffsets(std::vector<uint32_t> & offsets) const;
+
+        void setVerifyChecksum(bool verify);
+        bool getVerifyChecksum() const;
+
+        void setCompressionDictionary(std::shared_ptr<CompressionDictionary> dict);
+        std::shared_ptr<CompressionDictionary> getCompressionDictionary() const;
 
         static uint32_t uncompressRecord(std::shared_ptr<ByteBuffer> & srcBuf, size_t srcOff,
                                                std::shared_ptr<ByteBuffer> & dstBuf,
-                                               RecordHeader & hdr);
+                                               RecordHeader & hdr,
+                                               const std::shared_ptr<CompressionDictionary> & dict = nullptr);
        static uint32_t uncompressRecord(ByteBuffer & srcBuf, size_t srcOff,
                                         ByteBuffer & dstBuf,
-                                        RecordHeader & header);
+                                        RecordHeader & header,
+                                        const std::shared_ptr<CompressionDictionary> & dict = nullptr);
+
+       static void getColumnKeys(ByteBuffer & buffer, size_t offset, std::vector<uint32_t> & keys);
+       static uint32_t readColumn(ByteBuffer & buffer, size_t offset, uint16_t tag, uint8_t num,
+                                  std::vector<uint8_t> & data, std::vector<uint32_t> & eventOffsets,
+                                  const std::shared_ptr<CompressionDictionary> & dict = nullptr);
     };
 
 }
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#include "RecordInputRingItem.h"
+
+
+namespace evio {
+
+
+    /** Function to create RecordInputRingItems by RingBuffer. */
+    const std::function< std::shared_ptr<RecordInputRingItem> () >& RecordInputRingItem::eventFactory() {
+        static std::function< std::shared_ptr<RecordInputRingItem> () > result([] {
+            return std::make_shared<RecordInputRingItem>();
+        });
+        return result;
+    }
+
+
+    /** Default constructor.
+     *  Used in RecordInputSupply by eventFactory to create RecordInputRingItems for supply. */
+    RecordInputRingItem::RecordInputRingItem() {
+        record = std::make_shared<RecordInput>();
+    }
+
+
+    /** Method to reset this item each time it is retrieved from the supply. */
+    void RecordInputRingItem::reset() {
+        recordIndex = 0;
+        position = 0;
+        sequence = 0L;
+        sequenceObj = nullptr;
+    }
+
+
+    /**
+     * Get the contained record.
+     * @return contained record.
+     */
+    std::shared_ptr<RecordInput> & RecordInputRingItem::getRecord() {return record;}
+
+
+    /**
+     * Get the index of the contained record in the file being read.
+     * @return index of the contained record in the file being read (starting at 0).
+     */
+    uint32_t RecordInputRingItem::getRecordIndex() const {return recordIndex;}
+
+
+    /**
+     * Get the position of the contained record in the file being read.
+     * @return position of the contained record in the file being read.
+     */
+    size_t RecordInputRingItem::getPosition() const {return position;}
+
+
+    /**
+     * Set which record of the file is to be read into this item.
+     * @param index index of the record in the file (starting at 0).
+     * @param pos   position of the record in the file.
+     */
+    void RecordInputRingItem::setRecord(uint32_t index, size_t pos) {
+        recordIndex = index;
+        position = pos;
+    }
+
+
+    /**
+     * Get the sequence at which this object was taken from ring by one of the "get" calls.
+     * @return sequence at which this object was taken from ring by one of the "get" calls.
+     */
+    int64_t RecordInputRingItem::getSequence() const {return sequence;}
+
+
+    /**
+     * Get the Sequence object allowing ring consumer to get/release this item.
+     * @return Sequence object allowing ring consumer to get/release this item.
+     */
+    std::shared_ptr<Disruptor::ISequence> & RecordInputRingItem::getSequenceObj() {return sequenceObj;}
+
+
+    /**
+     * Set the sequence of an item obtained through {@link RecordInputSupply#get()}.
+     * @param seq sequence used to get item.
+     */
+    void RecordInputRingItem::fromProducer(int64_t seq) {sequence = seq;}
+
+
+    /**
+     * Set the sequence of an item obtained through
+     * {@link RecordInputSupply#getToDecompress(uint32_t)} or {@link RecordInputSupply#getToRead()}.
+     * @param seq sequence used to get item.
+     * @param seqObj sequence object used to get/release item.
+     */
+    void RecordInputRingItem::fromConsumer(int64_t seq, std::shared_ptr<Disruptor::ISequence> & seqObj) {
+        sequence = seq;
+        sequenceObj = seqObj;
+    }
+
+}
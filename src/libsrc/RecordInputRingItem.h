@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#ifndef EVIO_6_0_RECORDINPUTRINGITEM_H
+#define EVIO_6_0_RECORDINPUTRINGITEM_H
+
+
+#include <memory>
+#include <functional>
+
+
+#include "Disruptor/Sequence.h"
+#include "RecordInput.h"
+#include "ByteOrder.h"
+
+
+namespace evio {
+
+    /**
+     * This class provides the items which are supplied by the RecordInputSupply class.
+     * Each contains a record read from a file and, if necessary, decompressed.
+     */
+    class RecordInputRingItem {
+
+    private:
+
+        /** Record object, needs shared outside access. */
+        std::shared_ptr<RecordInput> record;
+
+        /** Index of the record in the file being read (starting at 0). */
+        uint32_t recordIndex = 0;
+
+        /** Position of the record in the file being read. */
+        size_t position = 0;
+
+        /** Sequence at which this object was taken from ring by one of the "get" calls. */
+        int64_t sequence = 0UL;
+
+        /** Sequence object allowing ring consumer to get/release this item. */
+        std::shared_ptr<Disruptor::ISequence> sequenceObj = nullptr;
+
+
+    public:
+
+        static const std::function< std::shared_ptr<RecordInputRingItem> () >& eventFactory();
+
+        RecordInputRingItem();
+        ~RecordInputRingItem() = default;
+
+        RecordInputRingItem(const RecordInputRingItem & item) = delete;
+        RecordInputRingItem & operator=(const RecordInputRingItem & other) = delete;
+
+        void reset();
+
+        std::shared_ptr<RecordInput> & getRecord();
+
+        uint32_t getRecordIndex() const;
+        size_t getPosition() const;
+        void setRecord(uint32_t index, size_t pos);
+
+        int64_t getSequence() const;
+        std::shared_ptr<Disruptor::ISequence> & getSequenceObj();
+
+        void fromProducer(int64_t seq);
+        void fromConsumer(int64_t seq, std::shared_ptr<Disruptor::ISequence> & seqObj);
+    };
+
+}
+
+
+#endif //EVIO_6_0_RECORDINPUTRINGITEM_H
@@ -0,0 +1,268 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#include "RecordInputSupply.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param ringSize     number of RecordInputRingItem objects in ring buffer.
+     * @param threadCount  number of threads simultaneously doing decompression.
+     *                     Must be <= ringSize.
+     * @throws EvioException if ringSize not power of 2 or threadCount > ringSize.
+     */
+    RecordInputSupply::RecordInputSupply(uint32_t ringSize, uint32_t threadCount) {
+
+        if (!Disruptor::Util::isPowerOf2(ringSize)) {
+            throw EvioException("ringSize must be a power of 2");
+        }
+
+        if (ringSize < threadCount) {
+            throw EvioException("threadCount must be <= ringSize");
+        }
+
+        // # decompression threads defaults to 1 if given bad value
+        if (threadCount > 0) {
+            decompressionThreadCount = threadCount;
+        }
+
+        this->ringSize = ringSize;
+
+        // Spin first then block
+        auto blockingStrategy = std::make_shared< Disruptor::BlockingWaitStrategy >();
+        auto waitStrategy = std::make_shared< Disruptor::SpinCountBackoffWaitStrategy >(10000, blockingStrategy);
+        // Create ring buffer with "ringSize" # of elements
+        ringBuffer = Disruptor::RingBuffer<std::shared_ptr<RecordInputRingItem>>::createSingleProducer(
+                RecordInputRingItem::eventFactory(), ringSize, waitStrategy);
+
+        // Barrier & sequences so record-DECOMPRESSING threads can get records.
+        decompressBarrier = ringBuffer->newBarrier();
+        decompressSeqs.reserve(decompressionThreadCount);
+        nextDecompressSeqs.reserve(decompressionThreadCount);
+        availableDecompressSeqs.reserve(decompressionThreadCount);
+
+        for (uint32_t i=0; i < decompressionThreadCount; i++) {
+            auto seq = std::make_shared<Disruptor::Sequence>(Disruptor::Sequence::InitialCursorValue);
+
+            // Each thread will get different records from each other.
+            // First thread gets 0, 2nd thread gets 1, etc.
+            int64_t firstSeqToGet = Disruptor::Sequence::InitialCursorValue + 1 + i;
+            nextDecompressSeqs.push_back(firstSeqToGet);
+            // Release, in advance, records to be skipped next. Keeps things from hanging up.
+            if (i != 0) {
+                seq->setValue(firstSeqToGet - 1);
+            }
+            decompressSeqs.push_back(seq);
+            availableDecompressSeqs.push_back(-1);
+        }
+
+        // Barrier & sequence so a single record-READING thread can get records
+        // only after all decompressing threads have released them.
+        readBarrier = ringBuffer->newBarrier(decompressSeqs);
+        auto seq = std::make_shared<Disruptor::Sequence>(Disruptor::Sequence::InitialCursorValue);
+        nextReadSeq = Disruptor::Sequence::InitialCursorValue + 1;
+        readSeqs.push_back(seq);
+        availableReadSeq = -1L;
+        // After the reading thread releases a record, make it available for re-filling.
+        ringBuffer->addGatingSequences(readSeqs);
+    }
+
+
+    /**
+     * Method to have sequence barriers throw a Disruptor's AlertException.
+     * This allows any threads waiting in {@link #getToDecompress(uint32_t)} and
+     * {@link #getToRead()} to wake up, clean up, and exit.
+     */
+    void RecordInputSupply::errorAlert() {
+        readBarrier->alert();
+        decompressBarrier->alert();
+    }
+
+
+    /**
+     * Get the number of records in this supply.
+     * @return number of records in this supply.
+     */
+    uint32_t RecordInputSupply::getRingSize() const {return ringSize;}
+
+
+    /**
+     * Check each record read into this supply against the checksum in its header
+     * (see {@link RecordInput#setVerifyChecksum(bool)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param verify true if records' data are to be checked against their checksums.
+     */
+    void RecordInputSupply::setVerifyChecksum(bool verify) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setVerifyChecksum(verify);
+        }
+    }
+
+
+    /**
+     * Give each record read into this supply the trained dictionary needed to decompress it
+     * (see {@link RecordInput#setCompressionDictionary(std::shared_ptr<CompressionDictionary>)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param dict trained compression dictionary, or null if none.
+     */
+    void RecordInputSupply::setCompressionDictionary(const std::shared_ptr<CompressionDictionary> & dict) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setCompressionDictionary(dict);
+        }
+    }
+
+
+    /**
+     * Get the next available record item from the ring buffer
+     * in order to set which record is to be read into it.
+     * @return next available record item in ring buffer.
+     */
+    std::shared_ptr<RecordInputRingItem> RecordInputSupply::get() {
+        int64_t getSequence = ringBuffer->next();
+        std::shared_ptr<RecordInputRingItem> & bufItem = (*ringBuffer.get())[getSequence];
+        bufItem->reset();
+        bufItem->fromProducer(getSequence);
+        return bufItem;
+    }
+
+
+    /**
+     * Tell consumers that the record item is ready for consumption.
+     * To be used in conjunction with {@link #get()}.
+     * @param item record item available for consumers' use.
+     */
+    void RecordInputSupply::publish(std::shared_ptr<RecordInputRingItem> & item) {
+        ringBuffer->publish(item->getSequence());
+    }
+
+
+    /**
+     * Get the next available record item from the ring buffer
+     * in order to read and decompress the record it designates.
+     * @param threadNumber number of thread (0,1, ...) used to decompress.
+     *                     This number cannot exceed (decompressionThreadCount - 1).
+     * @return next available record item in ring buffer.
+     * @throws Disruptor::AlertException  if {@link #errorAlert()} called.
+     */
+    std::shared_ptr<RecordInputRingItem> RecordInputSupply::getToDecompress(uint32_t threadNumber) {
+
+        try  {
+            if (availableDecompressSeqs[threadNumber] < nextDecompressSeqs[threadNumber]) {
+                availableDecompressSeqs[threadNumber] = decompressBarrier->waitFor(nextDecompressSeqs[threadNumber]);
+            }
+
+            std::shared_ptr<RecordInputRingItem> & item = (*ringBuffer.get())[nextDecompressSeqs[threadNumber]];
+            item->fromConsumer(nextDecompressSeqs[threadNumber], decompressSeqs[threadNumber]);
+            nextDecompressSeqs[threadNumber] += decompressionThreadCount;
+            return item;
+        }
+        catch (Disruptor::TimeoutException & ex) {
+            std::cout << ex.message() << std::endl;
+        }
+
+        return nullptr;
+    }
+
+
+    /**
+     * Get the next available record item from the ring buffer in order to read its events.
+     * Records are always returned in the order they were published.
+     * @return next available record item in ring buffer.
+     * @throws Disruptor::AlertException  if {@link #errorAlert()} called.
+     */
+    std::shared_ptr<RecordInputRingItem> RecordInputSupply::getToRead() {
+
+        try  {
+            if (availableReadSeq < nextReadSeq) {
+                availableReadSeq = readBarrier->waitFor(nextReadSeq);
+            }
+
+            std::shared_ptr<RecordInputRingItem> & item = (*ringBuffer.get())[nextReadSeq];
+            item->fromConsumer(nextReadSeq++, readSeqs[0]);
+            return item;
+        }
+        catch (Disruptor::TimeoutException & ex) {
+            std::cout << ex.message() << std::endl;
+        }
+
+        return nullptr;
+    }
+
+
+    /**
+     * A decompressing thread releases its claim on the given ring buffer item
+     * so it becomes available to the reading thread. As in
+     * {@link RecordSupply#releaseCompressor(const std::shared_ptr<RecordRingItem> &)},
+     * the records this thread will skip over next are released as well.
+     * To be used in conjunction with {@link #getToDecompress(uint32_t)}.
+     * @param item item in ring buffer to release.
+     */
+    void RecordInputSupply::releaseDecompressor(std::shared_ptr<RecordInputRingItem> & item) {
+        item->getSequenceObj()->setValue(item->getSequence() + decompressionThreadCount - 1);
+    }
+
+
+    /**
+     * The reading thread releases its claim on the given ring buffer item
+     * so it becomes available for reuse by the producer.
+     * Items must be released in the order obtained from {@link #getToRead()}.
+     * @param item item in ring buffer to release for reuse.
+     */
+    void RecordInputSupply::releaseReader(std::shared_ptr<RecordInputRingItem> & item) {
+        if (item == nullptr) return;
+        item->getSequenceObj()->setValue(item->getSequence());
+    }
+
+
+    /**
+     * Release claim on ring items up to sequenceNum for the given decompressor thread.
+     * For internal use only - to free up records that the decompressor thread will skip
+     * over anyway.
+     * @param threadNum    decompressor thread number.
+     * @param sequenceNum  sequence to release.
+     */
+    void RecordInputSupply::release(uint32_t threadNum, int64_t sequenceNum) {
+        if (sequenceNum < 0) return;
+        decompressSeqs[threadNum]->setValue(sequenceNum);
+    }
+
+
+    /**
+     * Has an error occurred in reading or decompressing data?
+     * @return {@code true} if an error occurred in reading or decompressing data, else {@code false}.
+     */
+    bool RecordInputSupply::haveError() {return haveErrorCondition.load();}
+
+
+    /**
+     * If there is an error, this contains the error message.
+     * @return error message if there is an error.
+     */
+    std::string RecordInputSupply::getError() {
+        std::lock_guard<std::mutex> lock(supplyMutex);
+        return error;
+    }
+
+
+    /**
+     * Set the error message and the error condition.
+     * @param err error message.
+     */
+    void RecordInputSupply::setError(std::string const & err) {
+        std::lock_guard<std::mutex> lock(supplyMutex);
+        error = err;
+        haveErrorCondition.store(true);
+    }
+
+}
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#ifndef EVIO_6_0_RECORDINPUTSUPPLY_H
+#define EVIO_6_0_RECORDINPUTSUPPLY_H
+
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+
+
+#include "RecordInputRingItem.h"
+#include "EvioException.h"
+#include "Disruptor/Util.h"
+#include "Disruptor/Sequence.h"
+#include "Disruptor/ISequence.h"
+#include "Disruptor/RingBuffer.h"
+#include "Disruptor/ISequenceBarrier.h"
+#include "Disruptor/TimeoutException.h"
+#include "Disruptor/SpinCountBackoffWaitStrategy.h"
+
+
+namespace evio {
+
+
+    /**
+     * This thread-safe, lock-free class is the reading counterpart of {@link RecordSupply}.
+     * It provides a very fast supply of RecordInputRingItems which are reused
+     * (using Disruptor software package).<p>
+     *
+     * A single producer does a {@link #get()}, sets which record of a file is to be read,
+     * and does a {@link #publish(std::shared_ptr<RecordInputRingItem> &)}.<p>
+     *
+     * The first type of consumer is a thread which reads a record and decompresses its data.
+     * The number of such consumers is set in the constructor.
+     * Each of these will call {@link #getToDecompress(uint32_t)} to get a record
+     * and eventually call {@link #releaseDecompressor(std::shared_ptr<RecordInputRingItem> &)}
+     * when the record is ready to be read.<p>
+     *
+     * The second type of consumer is a single thread which reads the events of all records
+     * in order. This will call {@link #getToRead()} to get a record and eventually call
+     * {@link #releaseReader(std::shared_ptr<RecordInputRingItem> &)} to return it to the producer.<p>
+     *
+     * Errors in decompressing threads are reported through {@link #setError(std::string const &)}
+     * and {@link #haveError()}.
+     *
+     * <pre><code>
+     *
+     *   (1) The producer who calls get() will get a ring item and set which record
+     *       is to be read into it. That same user does a publish() when done.
+     *
+     *   (2) The consumer who calls getToDecompress() will get that ring item, read
+     *       the record and decompress it. There may be any number of decompression threads
+     *       as long as <b># threads <= # of ring items!!!</b>.
+     *       That same user does a releaseDecompressor() when done with the record.
+     *
+     *   (3) The consumer who calls getToRead() will get that ring item and read
+     *       its events. There may be only 1 such thread, and it is usually the same
+     *       thread as the producer. It does a releaseReader() when done with the record.
+     *
+     * </code></pre>
+     */
+    class RecordInputSupply {
+
+    private:
+
+        /** Mutex for thread safety when setting error. */
+        std::mutex supplyMutex;
+
+        /** Number of threads doing decompression simultaneously. */
+        uint32_t decompressionThreadCount = 1;
+        /** Number of records held in this supply. */
+        uint32_t ringSize = 0;
+
+        /** Ring buffer. Variable ringSize needs to be defined first. */
+        std::shared_ptr<Disruptor::RingBuffer<std::shared_ptr<RecordInputRingItem>>> ringBuffer = nullptr;
+
+        // Stuff for reporting errors
+
+        /** Do we have an error reading and/or decompressing data? */
+        std::atomic<bool> haveErrorCondition{false};
+        /** Error string. No atomic<string> in C++, so protect with mutex. */
+        std::string error {""};
+
+        // Stuff for decompression threads
+
+        /** Ring barrier to prevent records from being used by reading thread
+         *  before decompression threads release them. */
+        std::shared_ptr<Disruptor::ISequenceBarrier> decompressBarrier;
+        /** Sequences for decompressing data, one per decompression thread. */
+        std::vector<std::shared_ptr<Disruptor::ISequence>> decompressSeqs;
+        /** Array of next sequences (index of next item desired),
+         *  one per decompression thread. */
+        std::vector<int64_t> nextDecompressSeqs;
+        /** Array of available sequences (largest index of sequentially available items),
+         *  one per decompression thread. */
+        std::vector<int64_t> availableDecompressSeqs;
+
+        // Stuff for reading thread
+
+        /** Ring barrier to prevent records from being re-used by producer
+         *  before reading thread releases them. */
+        std::shared_ptr<Disruptor::ISequenceBarrier> readBarrier;
+        /** Sequence for reading data. */
+        std::vector<std::shared_ptr<Disruptor::ISequence>> readSeqs;
+        /** Index of next item desired. */
+        int64_t nextReadSeq = 0L;
+        /** Largest index of sequentially available items. */
+        int64_t availableReadSeq = 0L;
+
+
+    public:
+
+        RecordInputSupply(const RecordInputSupply & supply) = delete;
+        RecordInputSupply(uint32_t ringSize, uint32_t threadCount);
+
+        ~RecordInputSupply() {
+            decompressSeqs.clear();
+            nextDecompressSeqs.clear();
+            availableDecompressSeqs.clear();
+            readSeqs.clear();
+            ringBuffer.reset();
+        }
+
+        void errorAlert();
+
+        uint32_t getRingSize() const;
+        void setVerifyChecksum(bool verify);
+        void setCompressionDictionary(const std::shared_ptr<CompressionDictionary> & dict);
+
+        std::shared_ptr<RecordInputRingItem> get();
+        void publish(std::shared_ptr<RecordInputRingItem> & item);
+        std::shared_ptr<RecordInputRingItem> getToDecompress(uint32_t threadNumber);
+        std::shared_ptr<RecordInputRingItem> getToRead();
+
+        void releaseDecompressor(std::shared_ptr<RecordInputRingItem> & item);
+        void releaseReader(std::shared_ptr<RecordInputRingItem> & item);
+        void release(uint32_t threadNum, int64_t sequenceNum);
+
+        bool haveError();
+        std::string getError();
+        void setError(std::string const & err);
+    };
+
+}
+
+
+#endif //EVIO_6_0_RECORDINPUTSUPPLY_H
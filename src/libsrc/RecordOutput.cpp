@@ -9,6 +9,11 @@
 
 
 #include "RecordOutput.h"
+#include "SeekableCompression.h"
+#include "ColumnLayout.h"
+#include "Crc32c.h"
+#include "Profiler.h"
+#include "EvioSwap.h"
 
 
 namespace evio {
@@ -28,7 +33,7 @@ namespace evio {
      *                      Value <= O means use default (1M).
      * @param maxBufferSize max number of uncompressed data bytes this record can hold.
      *                      Value of < 8MB results in default of 8MB.
-     * @param compressionType type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip).
+     * @param compressionType type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd).
      * @param hType           type of record header to use.
      */
     RecordOutput::RecordOutput(const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
@@ -57,6 +62,8 @@ namespace evio {
             // we have a place to put its larger size.
             RECORD_BUFFER_SIZE = (int) (1.1 * MAX_BUFFER_SIZE);
         }
+        nominalBufferSize = MAX_BUFFER_SIZE;
+        nominalRecordBufferSize = RECORD_BUFFER_SIZE;
 
         recordIndex = std::make_shared<ByteBuffer>(MAX_EVENT_COUNT * 4);
         recordIndex->order(byteOrder);
@@ -71,7 +78,7 @@ namespace evio {
      *               Must have position and limit set to accept new data.
      * @param maxEventCount max number of events this record can hold.
      *                      Value <= O means use default (1M).
-     * @param compressionType type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip).
+     * @param compressionType type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd).
      * @param hType           type of record header to use.
      */
     RecordOutput::RecordOutput(std::shared_ptr<ByteBuffer> & buffer, uint32_t maxEventCount,
@@ -162,10 +169,19 @@ namespace evio {
             MAX_EVENT_COUNT    = other.MAX_EVENT_COUNT;
             MAX_BUFFER_SIZE    = other.MAX_BUFFER_SIZE;
             RECORD_BUFFER_SIZE = other.RECORD_BUFFER_SIZE;
+            nominalBufferSize  = other.nominalBufferSize;
+            nominalRecordBufferSize = other.nominalRecordBufferSize;
 
             userBufferSize     = other.userBufferSize;
             startingPosition   = other.startingPosition;
             userProvidedBuffer = other.userProvidedBuffer;
+            maxCompressionRatio = other.maxCompressionRatio;
+            fastCompression    = other.fastCompression;
+            tagFilter          = other.tagFilter;
+            checksum           = other.checksum;
+            timestampExtractor = std::move(other.timestampExtractor);
+            recordProcessor    = std::move(other.recordProcessor);
+            compressionDictionary = other.compressionDictionary;
 
             // Copy construct header (nothing needs moving)
             header = std::make_shared<RecordHeader>(*(other.header.get()));
@@ -271,6 +287,20 @@ namespace evio {
         eventSize  = rec.eventSize;
         byteOrder  = rec.byteOrder;
         startingPosition = rec.startingPosition;
+        maxCompressionRatio = rec.maxCompressionRatio;
+        fastCompression  = rec.fastCompression;
+        tagFilter        = rec.tagFilter;
+        checksum         = rec.checksum;
+        timestampExtractor = rec.timestampExtractor;
+        recordProcessor  = rec.recordProcessor;
+        compressionDictionary = rec.compressionDictionary;
+        gatherOutput     = rec.gatherOutput;
+        gathered         = rec.gathered;
+        fillStats        = rec.fillStats;
+        targetRecordBytes = rec.targetRecordBytes;
+        seekableBlockSize = rec.seekableBlockSize;
+        preFilter        = rec.preFilter;
+        columnLayout     = rec.columnLayout;
 
         // Copy construct header
         header = std::make_shared<RecordHeader>(*(rec.header.get()));
@@ -371,6 +401,17 @@ namespace evio {
     uint32_t RecordOutput::getEventCount() const {return eventCount;}
 
 
+    /**
+     * Get the length of an event written into this record.
+     * @param index index of event starting at 0.
+     * @return length of event in bytes, or 0 if index is too large.
+     */
+    uint32_t RecordOutput::getEventLength(uint32_t index) const {
+        if (index >= eventCount) return 0;
+        return recordIndex->getUInt(4*index);
+    }
+
+
     /**
      * Get the internal ByteBuffer used to construct binary representation of this record.
      * @return internal ByteBuffer used to construct binary representation of this record.
@@ -378,6 +419,14 @@ namespace evio {
     const std::shared_ptr<ByteBuffer> RecordOutput::getBinaryBuffer() const {return recordBinary;}
 
 
+    /**
+     * Get the internal ByteBuffer holding only the events, one after another, of this record.
+     * Data starts at position 0 and is in this record's byte order.
+     * @return internal ByteBuffer holding the events of this record.
+     */
+    const std::shared_ptr<ByteBuffer> RecordOutput::getEventBuffer() const {return recordEvents;}
+
+
     /**
      * Get the compression type of the contained record.
      * Implemented to allow "const" in {@link RecordRingItem} equal operator
@@ -400,6 +449,392 @@ namespace evio {
     }
 
 
+    /**
+     * Get the largest fraction of its uncompressed size that a record's compressed data
+     * may be and still be stored compressed. Return of 0 means adaptive compression is off.
+     * @return largest allowed ratio of compressed to uncompressed size, or 0 if off.
+     */
+    float RecordOutput::getMaxCompressionRatio() const {return maxCompressionRatio;}
+
+
+    /**
+     * Turn adaptive compression on or off.
+     * When on, a record whose compressed data are larger than the given fraction of its
+     * uncompressed data is stored uncompressed and has its header's compression type set to
+     * {@link Compressor#UNCOMPRESSED}. For the slower compression types (lz4 best, gzip & zstd),
+     * a sample of the data is first compressed with fast lz4 and, if it does not compress
+     * well enough, the full compression is skipped altogether.
+     * The writers set the compression type of each record before building it, so a record
+     * stored uncompressed does not affect the next one.
+     *
+     * @param ratio largest allowed ratio of compressed to uncompressed size (e.g. 0.9).
+     *              Value &lt;= 0 turns adaptive compression off, values &gt; 1 are set to 1.
+     */
+    void RecordOutput::setMaxCompressionRatio(float ratio) {
+        if (ratio <= 0.F) {
+            maxCompressionRatio = 0.F;
+        }
+        else {
+            maxCompressionRatio = ratio > 1.F ? 1.F : ratio;
+        }
+    }
+
+
+    /**
+     * Will the next record be built with the fastest lz4 compression
+     * regardless of the compression type set in its header?
+     * @return true if next record will be built with the fastest lz4 compression.
+     */
+    bool RecordOutput::getFastCompression() const {return fastCompression;}
+
+
+    /**
+     * Build the next record with the fastest lz4 compression in place of whatever
+     * compression type is set in its header (unless that type is {@link Compressor#UNCOMPRESSED}).
+     * Used by {@link RecordCompressor} to lighten the load when records back up in the
+     * {@link RecordSupply}.
+     * @param fast true if next record is to be built with the fastest lz4 compression.
+     */
+    void RecordOutput::setFastCompression(bool fast) {fastCompression = fast;}
+
+
+    /**
+     * Is a filter of the tags and nums of this record's events stored in its header when built?
+     * @return true if a tag filter is stored in this record's header when built.
+     */
+    bool RecordOutput::getTagFilter() const {return tagFilter;}
+
+
+    /**
+     * Store a Bloom filter of the tags and nums of the top-level banks of this record's
+     * events in user register 2 of its header when built, so readers can skip records
+     * containing none of the events they want without decompressing them.
+     * Only done for evio records.
+     * Anything else placed in user register 2 is overwritten.
+     * @param filter true if a tag filter is to be stored in this record's header when built.
+     */
+    void RecordOutput::setTagFilter(bool filter) {tagFilter = filter;}
+
+
+    /**
+     * Get the callback finding the timestamps of events stored, as a range, in the header.
+     * @return callback finding the timestamps of events, empty if none.
+     */
+    RecordOutput::TimestampExtractor RecordOutput::getTimestampExtractor() const {return timestampExtractor;}
+
+
+    /**
+     * Store the min and max timestamps of this record's events, as found by the given callback,
+     * in its header when built (see {@link RecordHeader#TIME_RANGE_BIT}), so readers can find
+     * the records of a time window without reading any others. Events without a timestamp
+     * are left out of the range. If none has one, no range is stored.
+     * See {@link #bankTimestamp(uint16_t)} for a ready made callback.
+     * @param extractor callback finding the timestamp of an event, empty to store none.
+     */
+    void RecordOutput::setTimestampExtractor(TimestampExtractor extractor) {
+        timestampExtractor = std::move(extractor);
+    }
+
+
+    /**
+     * Get the callback run on the events of this record when built.
+     * @return callback run on the events when built, empty if none.
+     */
+    RecordOutput::RecordProcessor RecordOutput::getRecordProcessor() const {return recordProcessor;}
+
+
+    /**
+     * Run the given callback on this record's events each time it is built, before the
+     * header is filled in and the data compressed. It may drop or rewrite events with
+     * {@link #editEvents(EventEditor const &)} and add more, such as a summary bank,
+     * with {@link #addEvent(const uint8_t *, uint32_t, uint32_t)}, as long as they fit.
+     * When records are built by compression threads the callback runs on them,
+     * so it must be thread safe.
+     * @param processor callback run on the events when built, empty for none.
+     */
+    void RecordOutput::setRecordProcessor(RecordProcessor processor) {
+        recordProcessor = std::move(processor);
+    }
+
+
+    /**
+     * Get a callback which takes as an event's timestamp the first 64-bit word of data
+     * of the first bank with the given tag: either the event's top-level bank itself,
+     * or one of its children. Banks holding other structures are passed over.
+     * @param tag tag of bank whose first 64-bit word is the timestamp.
+     * @return callback for {@link #setTimestampExtractor(TimestampExtractor)}.
+     */
+    RecordOutput::TimestampExtractor RecordOutput::bankTimestamp(uint16_t tag) {
+        return [tag](const uint8_t *event, uint32_t length, ByteOrder const & order, uint64_t & timestamp) {
+            if (length < 16) return false;
+
+            // Tag & type are in the 2nd word of an evio bank
+            uint32_t word = Util::toInt(event + 4, order);
+            uint32_t type = (word >> 8) & 0x3f;
+            if ((word >> 16) == tag && !DataType::isStructure(type)) {
+                timestamp = Util::toLong(event + 8, order);
+                return true;
+            }
+
+            if (!DataType::isBank(type)) return false;
+
+            // Look through the children
+            uint32_t end = std::min(length, 4*(Util::toInt(event, order) + 1));
+            uint32_t pos = 8;
+            while (pos + 16 <= end) {
+                uint32_t len = Util::toInt(event + pos, order);
+                word = Util::toInt(event + pos + 4, order);
+                if ((word >> 16) == tag && len > 2 && !DataType::isStructure((word >> 8) & 0x3f)) {
+                    timestamp = Util::toLong(event + pos + 8, order);
+                    return true;
+                }
+                pos += 4*(len + 1);
+            }
+            return false;
+        };
+    }
+
+
+    /**
+     * Is a CRC32C of this record's data stored in its header when built?
+     * @return true if a checksum is stored in this record's header when built.
+     */
+    bool RecordOutput::getChecksum() const {return checksum;}
+
+
+    /**
+     * Store a CRC32C of this record's data, as written, in an additional 15th word of
+     * its header when built, so readers can detect records corrupted in storage or
+     * transit. Readers which do not check it skip it as part of the header.
+     * @param sum true if a checksum is to be stored in this record's header when built.
+     */
+    void RecordOutput::setChecksum(bool sum) {checksum = sum;}
+
+
+    /**
+     * Get the trained dictionary that data is compressed with.
+     * @return trained dictionary that data is compressed with, or null if none.
+     */
+    std::shared_ptr<CompressionDictionary> RecordOutput::getCompressionDictionary() const {
+        return compressionDictionary;
+    }
+
+
+    /**
+     * Compress this record's data, if LZ4 or zstd, starting from a trained dictionary.
+     * This is much more effective on small records than compressing each from scratch.
+     * Records built this way have {@link RecordHeader#COMPRESSION_DICT_BIT} set
+     * and can only be read with the same dictionary. Gzip ignores it.
+     * @param dict trained dictionary, or null to compress without one.
+     */
+    void RecordOutput::setCompressionDictionary(std::shared_ptr<CompressionDictionary> dict) {
+        compressionDictionary = std::move(dict);
+    }
+
+
+    /**
+     * Are uncompressed records built for writing by gathering their parts?
+     * @return true if uncompressed records are built for writing by gathering their parts.
+     */
+    bool RecordOutput::getGatherOutput() const {return gatherOutput;}
+
+
+    /**
+     * Build uncompressed records for writing by gathering their parts. When set, building
+     * an uncompressed record without a user header writes only its header into the binary
+     * buffer. Its index and events are not copied next to it, but are written straight from
+     * the internal buffers they were added to. Whoever writes such a record must then use
+     * {@link #getSegments(std::vector<ByteBufferView> &)} instead of the binary buffer,
+     * and must do so before this record is reset. Compressed records are unaffected.
+     * @param gather true if uncompressed records are to be built for writing by gathering their parts.
+     */
+    void RecordOutput::setGatherOutput(bool gather) {gatherOutput = gather;}
+
+
+    /**
+     * Get the object counting event sizes and record fill, shared by all records of a writer.
+     * @return object counting event sizes and record fill, null if none.
+     */
+    RecordFillStats * RecordOutput::getFillStats() const {return fillStats;}
+
+
+    /**
+     * Set the object in which to count the sizes of events added and how full records are
+     * when built. It must outlive this record.
+     * @param stats object counting event sizes and record fill, or null for none.
+     */
+    void RecordOutput::setFillStats(RecordFillStats * stats) {fillStats = stats;}
+
+
+    /**
+     * Get the size at which this record is considered full, if less than its memory.
+     * @return size in bytes of header, index and events, 0 if record fills its memory.
+     */
+    uint32_t RecordOutput::getTargetRecordBytes() const {return targetRecordBytes;}
+
+
+    /**
+     * Set a size, less than its memory, at which this record is considered full.
+     * Once it holds an event, no other is added which would take it past this size.
+     * Smaller records are filled, and so written, sooner when data is slow in coming.
+     * A single event larger than this is still accepted into an empty record.
+     * @param bytes size in bytes of header, index and events, 0 to fill the record's memory.
+     */
+    void RecordOutput::setTargetRecordBytes(uint32_t bytes) {targetRecordBytes = bytes;}
+
+
+    /**
+     * Get the uncompressed bytes in each block of seekable lz4 records.
+     * @return uncompressed bytes in each block, 0 if records are not seekable.
+     */
+    uint32_t RecordOutput::getSeekableCompression() const {return seekableBlockSize;}
+
+
+    /**
+     * Set whether lz4 records are compressed as independent blocks, so a reader can
+     * decompress a single event without the rest of the record.
+     * See {@link SeekableCompression}. Such records cannot be read by versions of evio
+     * which do not know of {@link RecordHeader#SEEKABLE_BIT}.
+     * Records of other compression types are not affected.
+     * @param blockSize uncompressed bytes in each block, 0 for ordinary records.
+     */
+    void RecordOutput::setSeekableCompression(uint32_t blockSize) {seekableBlockSize = blockSize;}
+
+
+    /**
+     * Get the filter applied to the data of compressed records before compressing it.
+     * @return filter applied to data.
+     */
+    Compressor::PreFilter RecordOutput::getPreFilter() const {return preFilter;}
+
+
+    /**
+     * Set a filter to rearrange the data of compressed records, before compressing it,
+     * so it compresses better. Arrays of 16 or 32 bit ADC values compress much better,
+     * and lz4 runs faster on them, once their bytes are grouped by significance.
+     * Readers undo the filter, which is noted in each record's header
+     * (see {@link RecordHeader#PRE_FILTER_MASK}). Such records cannot be read by versions
+     * of evio which do not know of it. Records stored uncompressed are never filtered.
+     * @param filter filter to apply, NO_FILTER for none.
+     */
+    void RecordOutput::setPreFilter(Compressor::PreFilter filter) {preFilter = filter;}
+
+
+    /**
+     * Are the banks of compressed evio records grouped by column?
+     * @return true if banks of compressed records are grouped by column.
+     */
+    bool RecordOutput::getColumnLayout() const {return columnLayout;}
+
+
+    /**
+     * Set whether the payloads of banks one level down in the events of compressed evio
+     * records are grouped by tag and num into separately compressed columns.
+     * Data of each detector then compresses better and a reader can decompress only the
+     * columns it wants (see {@link ColumnLayout}). Such records, whose header type is
+     * {@link HeaderType#EVIO_COLUMN_RECORD}, cannot be read by versions of evio which do
+     * not know of it. They are neither pre-filtered nor seekable. Records none of whose
+     * events is a bank of banks are written as usual.
+     * @param byColumn true to group banks by column.
+     */
+    void RecordOutput::setColumnLayout(bool byColumn) {columnLayout = byColumn;}
+
+
+    /**
+     * Did the last build leave this record's index and events out of the binary buffer?
+     * If so, the record must be written through
+     * {@link #getSegments(std::vector<ByteBufferView> &)}.
+     * @return true if the last build left index and events out of the binary buffer.
+     */
+    bool RecordOutput::isGathered() const {return gathered;}
+
+
+    /**
+     * If a tag filter is wanted, go through this record's events and store the
+     * filter of their tags and nums in the header.
+     */
+    void RecordOutput::buildTagFilter() {
+        if (!tagFilter || !header->isEvioRecord()) {
+            return;
+        }
+
+        uint64_t filter = 0;
+        uint32_t offset = 0;
+        for (uint32_t i=0; i < eventCount; i++) {
+            uint32_t len = recordIndex->getUInt(4*i);
+            if (len > 7) {
+                // Tag & num are in the 2nd word of an evio bank
+                uint32_t word = recordEvents->getUInt(offset + 4);
+                filter |= RecordHeader::tagFilterBits(word >> 16, word & 0xff);
+            }
+            offset += len;
+        }
+        header->setTagFilter(filter);
+    }
+
+
+    /**
+     * If a timestamp extractor is set, go through this record's events and store the
+     * range of their timestamps in the header. Done before the record is laid out,
+     * since the range makes the header longer.
+     */
+    void RecordOutput::buildTimeRange() {
+        header->hasTimeRange(false);
+        if (!timestampExtractor) {
+            return;
+        }
+
+        uint64_t min = UINT64_MAX, max = 0, timestamp;
+        bool found = false;
+        const uint8_t *events = recordEvents->array() + recordEvents->arrayOffset();
+        uint32_t offset = 0;
+        for (uint32_t i=0; i < eventCount; i++) {
+            uint32_t len = recordIndex->getUInt(4*i);
+            if (timestampExtractor(events + offset, len, byteOrder, timestamp)) {
+                min = std::min(min, timestamp);
+                max = std::max(max, timestamp);
+                found = true;
+            }
+            offset += len;
+        }
+
+        if (found) {
+            header->setTimeRange(min, max);
+        }
+    }
+
+
+    /**
+     * If a checksum is wanted, calculate the CRC32C of the data following the header
+     * exactly as it will be written and store it in the header. That is the compressed
+     * data if compressed, else the index, user header and events, including padding.
+     */
+    void RecordOutput::buildChecksum() {
+        if (!checksum) {
+            return;
+        }
+
+        uint32_t hdrBytes = header->getHeaderLength();
+        uint32_t sum;
+
+        if (gathered) {
+            static const uint8_t padding[4] = {0,0,0,0};
+            uint32_t pad = header->getLength() - hdrBytes - indexSize - eventSize;
+            sum = Crc32c::compute(recordIndex->array(), indexSize);
+            sum = Crc32c::compute(recordEvents->array(), eventSize, sum);
+            sum = Crc32c::compute(padding, pad, sum);
+        }
+        else {
+            uint32_t len = header->getCompressionType() == Compressor::UNCOMPRESSED ?
+                           header->getLength() - hdrBytes : header->getCompressedDataLength();
+            sum = Crc32c::compute(recordBinary->array() + recordBinary->arrayOffset() +
+                                  startingPosition + hdrBytes, len);
+        }
+
+        header->setChecksum(sum);
+    }
+
+
     /**
      * Was the internal buffer provided by the user?
      * @return true if internal buffer provided by user.
@@ -433,12 +868,20 @@ namespace evio {
     /**
      * Is there room in this record's memory for an additional event
      * of the given length in bytes (length NOT including accompanying index).
+     * If the record already holds an event, the room is limited by any target size
+     * (see {@link #setTargetRecordBytes(uint32_t)}).
      * @param length length of data to add in bytes
      * @return {@code true} if room in record, else {@code false}.
      */
     bool RecordOutput::roomForEvent(uint32_t length) const {
+        // Once holding an event, a record may be considered full before its memory is
+        uint32_t limit = MAX_BUFFER_SIZE;
+        if (eventCount > 0 && targetRecordBytes > 0 && targetRecordBytes < limit) {
+            limit = targetRecordBytes;
+        }
+
         // Account for this record's header including index
-        return ((indexSize + 4 + eventSize + RecordHeader::HEADER_SIZE_BYTES + length) <= MAX_BUFFER_SIZE);
+        return ((indexSize + 4 + eventSize + RecordHeader::HEADER_SIZE_BYTES + length) <= limit);
     }
 
 
@@ -460,6 +903,53 @@ namespace evio {
     }
 
 
+    /**
+     * Edit each event already added to this record, in order, in place.
+     * The editor is given each event's bytes, which it may change, and returns its new
+     * length, no more than its old, or 0 to drop it. The events kept are moved together.
+     *
+     * @param editor callback editing each event.
+     * @return number of events dropped.
+     * @throws EvioException if an event's new length is larger than its old,
+     *                       in which case it and the events after it are dropped.
+     */
+    uint32_t RecordOutput::editEvents(EventEditor const & editor) {
+        uint8_t *events = recordEvents->array() + recordEvents->arrayOffset();
+        uint32_t count = eventCount;
+        uint32_t kept = 0, src = 0, dst = 0;
+        bool tooLong = false;
+
+        for (uint32_t i=0; i < count; i++) {
+            uint32_t len = recordIndex->getUInt(4*i);
+            uint32_t newLen = editor(events + src, len, byteOrder);
+            if (newLen > len) {
+                tooLong = true;
+                break;
+            }
+
+            if (newLen > 0) {
+                if (dst != src) {
+                    std::memmove(events + dst, events + src, newLen);
+                }
+                recordIndex->putInt(4*kept, newLen);
+                kept++;
+                dst += newLen;
+            }
+            src += len;
+        }
+
+        eventCount = kept;
+        indexSize  = 4*kept;
+        eventSize  = dst;
+        recordEvents->position(dst);
+
+        if (tooLong) {
+            throw EvioException("edited event is longer than before");
+        }
+        return count - kept;
+    }
+
+
     /**
      * Adds an event's ByteBuffer into the record.
      * Can specify the length of additional data to follow the event
@@ -492,12 +982,14 @@ namespace evio {
             // Allocate roughly what we need + 1MB
             MAX_BUFFER_SIZE = eventLen + ONE_MEG;
             RECORD_BUFFER_SIZE = MAX_BUFFER_SIZE + ONE_MEG;
+            if (fillStats != nullptr) fillStats->addOversizedEvent();
             allocate();
             // This does NOT reset record type, compression type, or byte order
             reset();
         }
 
         if (oneTooMany() || !roomForEvent(eventLen)) {
+            if (fillStats != nullptr) fillStats->refuseEvent(oneTooMany());
             return false;
         }
 
@@ -510,6 +1002,7 @@ namespace evio {
         recordIndex->putInt(indexSize, eventLen);
         indexSize += 4;
         eventCount++;
+        if (fillStats != nullptr) fillStats->addEvent(eventLen);
 
         return true;
     }
@@ -568,7 +1061,7 @@ namespace evio {
      * more memory is allocated.
      * On the other hand, if the buffer was provided by the user,
      * then obviously the buffer cannot be expanded and false is returned.<p>
-     * <b>The byte order of event must match the byte order given in constructor!</b>
+     * An event in the opposite byte order of this record is swapped while being copied in.
      *
      * @param event        event's ByteBuffer object.
      * @param extraDataLen additional data bytes to follow event (e.g. trailer length).
@@ -587,11 +1080,13 @@ namespace evio {
 
             MAX_BUFFER_SIZE = eventLen + ONE_MEG;
             RECORD_BUFFER_SIZE = MAX_BUFFER_SIZE + ONE_MEG;
+            if (fillStats != nullptr) fillStats->addOversizedEvent();
             allocate();
             reset();
         }
 
         if (oneTooMany() || !roomForEvent(eventLen)) {
+            if (fillStats != nullptr) fillStats->refuseEvent(oneTooMany());
             return false;
         }
 
@@ -599,9 +1094,9 @@ namespace evio {
         size_t pos = recordEvents->position();
 
 //std::cout << "\nRecordOutput::addEvent(buf): write (in recordEvents) to pos = " << pos << std::endl;
-        std::memcpy((void *)(recordEvents->array() + pos),
-                    reinterpret_cast<void *>(event.array() + event.arrayOffset() + event.position()),
-                    eventLen);
+        copyEvent(recordEvents->array() + pos,
+                  event.array() + event.arrayOffset() + event.position(),
+                  eventLen, event.order());
 
         recordEvents->position(pos + eventLen);
 
@@ -609,6 +1104,7 @@ namespace evio {
         recordIndex->putInt(indexSize, eventLen);
         indexSize += 4;
         eventCount++;
+        if (fillStats != nullptr) fillStats->addEvent(eventLen);
 
         return true;
     }
@@ -623,7 +1119,7 @@ namespace evio {
      * more memory is allocated.
      * On the other hand, if the buffer was provided by the user,
      * then obviously the buffer cannot be expanded and false is returned.<p>
-     * <b>The byte order of event must match the byte order given in constructor!</b>
+     * An event in the opposite byte order of this record is swapped while being copied in.
      *
      * @param event        event's ByteBuffer object.
      * @param extraDataLen additional data bytes to follow event (e.g. trailer length).
@@ -645,9 +1141,8 @@ namespace evio {
      * more memory is allocated.
      * On the other hand, if the buffer was provided by the user,
      * then obviously the buffer cannot be expanded and false is returned.<p>
-     * <b>The byte order of event must match the byte order given in constructor!</b>
-     * This method is not thread-safe with respect to the node as it's backing
-     * ByteBuffer's limit and position may be concurrently changed.
+     * An event in the opposite byte order of this record is swapped while being copied in.
+     * The node's backing buffer is read without changing its position or limit.
      *
      * @param node         event's EvioNode object
      * @param extraDataLen additional data bytes to follow event (e.g. trailer length).
@@ -671,23 +1166,25 @@ namespace evio {
 
             MAX_BUFFER_SIZE = eventLen + ONE_MEG;
             RECORD_BUFFER_SIZE = MAX_BUFFER_SIZE + ONE_MEG;
+            if (fillStats != nullptr) fillStats->addOversizedEvent();
             allocate();
             reset();
         }
 
         if (oneTooMany() || !roomForEvent(eventLen)) {
+            if (fillStats != nullptr) fillStats->refuseEvent(oneTooMany());
             return false;
         }
 
 
-        ByteBuffer buf(eventLen);
-        node.getStructureBuffer(buf, false);
+        // Copy straight from node's backing buffer, leaving its position and limit alone
+        auto buf = node.getBuffer();
         size_t pos = recordEvents->position();
 
 //std::cout << "\nRecordOutput::addEvent(node): write (in recordEvents)to pos = " << pos << std::endl;
-        std::memcpy((void *)(recordEvents->array() + pos),
-                    (const void *)(buf.array() + buf.arrayOffset() + buf.position()),
-                    eventLen);
+        copyEvent(recordEvents->array() + pos,
+                  buf->array() + buf->arrayOffset() + node.getPosition(),
+                  eventLen, buf->order());
 
         recordEvents->position(pos + eventLen);
 
@@ -695,6 +1192,7 @@ namespace evio {
         recordIndex->putInt(indexSize, eventLen);
         indexSize += 4;
         eventCount++;
+        if (fillStats != nullptr) fillStats->addEvent(eventLen);
 
         return true;
     }
@@ -709,9 +1207,8 @@ namespace evio {
      * more memory is allocated.
      * On the other hand, if the buffer was provided by the user,
      * then obviously the buffer cannot be expanded and false is returned.<p>
-     * <b>The byte order of event must match the byte order given in constructor!</b>
-     * This method is not thread-safe with respect to the node as it's backing
-     * ByteBuffer's limit and position may be concurrently changed.
+     * An event in the opposite byte order of this record is swapped while being copied in.
+     * The node's backing buffer is read without changing its position or limit.
      *
      * @param node         event's EvioNode object
      * @param extraDataLen additional data bytes to follow event (e.g. trailer length).
@@ -734,7 +1231,9 @@ namespace evio {
      * more memory is allocated.
      * On the other hand, if the buffer was provided by the user,
      * then obviously the buffer cannot be expanded and false is returned.<p>
-     * <b>The byte order of event must match the byte order given in constructor!</b>
+     * The event is written straight into the record by {@link BaseStructure#writeDirect},
+     * swapped if necessary, in one pass which also sets all its header lengths.
+     * So {@link BaseStructure#setAllHeaderLengths()} need not be called first.
      *
      * @param event        event's EvioBank object.
      * @param extraDataLen additional data bytes to follow event (e.g. trailer length).
@@ -744,31 +1243,55 @@ namespace evio {
      */
     bool RecordOutput::addEvent(EvioBank & event, uint32_t extraDataLen) {
 
-        uint32_t eventLen = event.getTotalBytes();
+        if (oneTooMany()) {
+            if (fillStats != nullptr) fillStats->refuseEvent(true);
+            return false;
+        }
 
-        if (eventCount < 1 && !roomForEvent(eventLen + extraDataLen)) {
+        // Write the event straight into the record in one pass which also sets
+        // all its header lengths, so they need not be up to date beforehand.
+        size_t rePos = recordEvents->position();
+        size_t used = indexSize + 4 + eventSize + RecordHeader::HEADER_SIZE_BYTES;
+        size_t room = used >= MAX_BUFFER_SIZE ? 0 : MAX_BUFFER_SIZE - used;
+        room = std::min(room, recordEvents->capacity() - rePos);
+
+        uint32_t eventLen = event.writeDirect(recordEvents->array() + rePos, room, recordEvents->order());
+
+        // If we receive a single event larger than our memory, we must accommodate this
+        // by increasing our internal buffer size(s), as for any other kind of event.
+        if (eventCount < 1 && (eventLen == 0 || !roomForEvent(eventLen + extraDataLen))) {
             if (userProvidedBuffer) {
                 return false;
             }
 
+            if (eventLen == 0) {
+                event.setAllHeaderLengths();
+                eventLen = event.getTotalBytes();
+            }
+
             MAX_BUFFER_SIZE = eventLen + ONE_MEG;
             RECORD_BUFFER_SIZE = MAX_BUFFER_SIZE + ONE_MEG;
+            if (fillStats != nullptr) fillStats->addOversizedEvent();
             allocate();
             reset();
+
+            rePos = recordEvents->position();
+            eventLen = event.writeDirect(recordEvents->array() + rePos,
+                                         recordEvents->capacity() - rePos, recordEvents->order());
         }
 
-        if (oneTooMany() || !roomForEvent(eventLen)) {
+        if (eventLen == 0) {
+            if (fillStats != nullptr) fillStats->refuseEvent(false);
             return false;
         }
 
-        size_t rePos = recordEvents->position();
-        event.write(recordEvents->array() + rePos, recordEvents->order());
         recordEvents->position(rePos + eventLen);
 
         eventSize += eventLen;
         recordIndex->putInt(indexSize, eventLen);
         indexSize += 4;
         eventCount++;
+        if (fillStats != nullptr) fillStats->addEvent(eventLen);
 
         return true;
     }
@@ -796,12 +1319,395 @@ namespace evio {
     }
 
 
+    /**
+     * Adds an event built from fragments which are left where they are into the record.
+     * The event's header is written and each fragment copied straight into the record,
+     * once, so the event is never put together anywhere else first.
+     * A fragment in the opposite byte order of this record is swapped while being copied in,
+     * and any new tag and num it's given are set in the copy.
+     * Can specify the length of additional data to follow the event
+     * (such as an evio trailer record) to see if by adding this event
+     * everything will fit in the available memory.<p>
+     * If a single event is too large for the internal buffers,
+     * more memory is allocated.
+     * On the other hand, if the buffer was provided by the user,
+     * then obviously the buffer cannot be expanded and false is returned.
+     *
+     * @param event        description of event and its fragments.
+     * @param extraDataLen additional data bytes to follow event (e.g. trailer length).
+     * @return true if event was added; false if the event was not added because the
+     *         count limit would be exceeded or the buffer is full and cannot be
+     *         expanded since it's user-provided.
+     */
+    bool RecordOutput::addEvent(GatheredEvent const & event, uint32_t extraDataLen) {
+
+        uint32_t eventLen = event.getTotalBytes();
+
+        if (eventCount < 1 && !roomForEvent(eventLen + extraDataLen)) {
+            if (userProvidedBuffer) {
+                return false;
+            }
+
+            MAX_BUFFER_SIZE = eventLen + ONE_MEG;
+            RECORD_BUFFER_SIZE = MAX_BUFFER_SIZE + ONE_MEG;
+            if (fillStats != nullptr) fillStats->addOversizedEvent();
+            allocate();
+            reset();
+        }
+
+        if (oneTooMany() || !roomForEvent(eventLen)) {
+            if (fillStats != nullptr) fillStats->refuseEvent(oneTooMany());
+            return false;
+        }
+
+        // recordEvents backing array's offset = 0
+        size_t pos = recordEvents->position();
+        event.writeHeader(recordEvents->array() + pos, byteOrder);
+        size_t fragPos = pos + 8;
+
+        for (auto const & frag : event.getFragments()) {
+            copyEvent(recordEvents->array() + fragPos, frag.data, frag.length,
+                      frag.bigEndian ? ByteOrder::ENDIAN_BIG : ByteOrder::ENDIAN_LITTLE);
+
+            if (frag.retag) {
+                // Keep the type and padding, which sit between tag and num
+                uint32_t word = recordEvents->getUInt(fragPos + 4);
+                word = ((uint32_t)frag.tag << 16) | (word & 0xff00) | frag.num;
+                recordEvents->putInt(fragPos + 4, word);
+            }
+            fragPos += frag.length;
+        }
+
+        recordEvents->position(pos + eventLen);
+
+        eventSize += eventLen;
+        recordIndex->putInt(indexSize, eventLen);
+        indexSize += 4;
+        eventCount++;
+        if (fillStats != nullptr) fillStats->addEvent(eventLen);
+
+        return true;
+    }
+
+
+    /**
+     * Get the number of bytes still available in this record for event data and index entries.
+     * @return number of bytes still available in this record for event data and index entries.
+     */
+    uint32_t RecordOutput::bytesAvailable() const {
+        uint32_t used = indexSize + eventSize + RecordHeader::HEADER_SIZE_BYTES;
+        return used >= MAX_BUFFER_SIZE ? 0 : MAX_BUFFER_SIZE - used;
+    }
+
+
+    /**
+     * Find how many of the given events, taken in order, fit into this record
+     * given both its memory and event count limits.
+     * @param eventLens array of event lengths in bytes.
+     * @param count     number of lengths in eventLens.
+     * @param bytes     filled with the total number of event bytes that fit.
+     * @return number of events that fit.
+     */
+    uint32_t RecordOutput::eventsThatFit(const uint32_t* eventLens, uint32_t count, uint32_t *bytes) const {
+        uint32_t maxCount = MAX_EVENT_COUNT > eventCount ? MAX_EVENT_COUNT - eventCount : 0;
+        if (count > maxCount) count = maxCount;
+
+        // Each event also takes up 4 bytes of index
+        uint64_t room = bytesAvailable();
+        uint64_t total = 0;
+        uint32_t n = 0;
+        for (; n < count; n++) {
+            if (total + eventLens[n] + 4 > room) break;
+            total += eventLens[n] + 4;
+        }
+
+        *bytes = total - 4*n;
+        return n;
+    }
+
+
+    /**
+     * Copy one event (bank) into the record's event buffer.
+     * If the event is in the opposite byte order of this record,
+     * it is swapped straight into place while being copied, in one pass.
+     * Being structure-aware, the swap follows the event's banks, segments and tagsegments
+     * and does each leaf's data with the vectorized kernels of {@link ByteOrder}.
+     *
+     * @param dst      where to place the event in the record's event buffer.
+     * @param src      event's bytes.
+     * @param eventLen event's length in bytes.
+     * @param srcOrder event's byte order.
+     */
+    void RecordOutput::copyEvent(uint8_t *dst, const uint8_t *src, uint32_t eventLen,
+                                 ByteOrder const & srcOrder) const {
+        if (srcOrder == byteOrder) {
+            std::memcpy((void *)dst, (const void *)src, eventLen);
+            return;
+        }
+
+        // src is read, never written, since dst is not null
+        EvioSwap::swapEvent(reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(src)),
+                            !srcOrder.isLocalEndian(),
+                            reinterpret_cast<uint32_t *>(dst));
+    }
+
+
+    /**
+     * Adds a batch of events, stored one after another in a single array, into the record.
+     * As many events as fit, in order, are copied in with a single memcpy and all their
+     * index entries are written at once. This is much faster than adding small events one
+     * at a time. If the first event is too large for an empty record, it is handled as in
+     * {@link #addEvent(const uint8_t*, uint32_t, uint32_t)}.<p>
+     * <b>The byte order of events must match the byte order given in constructor!</b>
+     *
+     * @param events    array holding events back to back.
+     * @param eventLens array of each event's length in bytes.
+     * @param count     number of events in array.
+     * @return number of events added, which may be less than count if the record
+     *         filled up or reached its event count limit.
+     */
+    uint32_t RecordOutput::addEvents(const uint8_t* events, const uint32_t* eventLens, uint32_t count) {
+
+        if (count < 1) return 0;
+
+        uint32_t added = 0;
+
+        // A single event larger than an empty record may need more memory
+        if (eventCount < 1 && !roomForEvent(eventLens[0])) {
+            if (!addEvent(events, eventLens[0])) {
+                return 0;
+            }
+            events += eventLens[0];
+            added++;
+        }
+
+        uint32_t bytes;
+        uint32_t n = eventsThatFit(eventLens + added, count - added, &bytes);
+        if (n < 1) return added;
+
+        size_t pos = recordEvents->position();
+        std::memcpy((void *)(recordEvents->array() + pos), (const void *)events, bytes);
+        recordEvents->position(pos + bytes);
+        eventSize += bytes;
+
+        // Write all index entries, which are ints in this record's byte order
+        if (byteOrder == ByteOrder::ENDIAN_LOCAL) {
+            std::memcpy((void *)(recordIndex->array() + indexSize), (const void *)(eventLens + added), 4*n);
+            indexSize += 4*n;
+        }
+        else {
+            for (uint32_t i = added; i < added + n; i++) {
+                recordIndex->putInt(indexSize, eventLens[i]);
+                indexSize += 4;
+            }
+        }
+
+        eventCount += n;
+        return added + n;
+    }
+
+
+    /**
+     * Adds a batch of events, each in its own ByteBuffer, into the record.
+     * As many events as fit, in order starting at offset, are added after checking
+     * the record's limits once for the whole batch. Each event is taken from its buffer's
+     * position to limit. If the first event is too large for an empty record, it is handled
+     * as in {@link #addEvent(const ByteBuffer &, uint32_t)}.<p>
+     * Events in the opposite byte order of this record are swapped while being copied in.<p>
+     *
+     * @param events vector of events.
+     * @param offset index into vector of first event to add.
+     * @param count  max number of events to add, defaults to all from offset on.
+     * @return number of events added, which may be less than count if the record
+     *         filled up or reached its event count limit.
+     */
+    uint32_t RecordOutput::addEvents(const std::vector<std::shared_ptr<ByteBuffer>> & events,
+                                     size_t offset, size_t count) {
+
+        if (offset >= events.size()) return 0;
+        count = std::min(count, events.size() - offset);
+
+        uint32_t added = 0;
+
+        if (eventCount < 1 && !roomForEvent(events[offset]->remaining())) {
+            if (!addEvent(*(events[offset]))) {
+                return 0;
+            }
+            added++;
+        }
+
+        uint32_t maxCount = MAX_EVENT_COUNT > eventCount ? MAX_EVENT_COUNT - eventCount : 0;
+        uint64_t room  = bytesAvailable();
+        uint64_t total = 0;
+        size_t last = offset + added;
+        size_t end  = offset + std::min(count, (size_t)added + maxCount);
+        for (; last < end; last++) {
+            total += events[last]->remaining() + 4;
+            if (total > room) break;
+        }
+
+        size_t pos = recordEvents->position();
+        uint8_t *dst = recordEvents->array() + pos;
+
+        for (size_t i = offset + added; i < last; i++) {
+            auto & event = *(events[i]);
+            uint32_t eventLen = event.remaining();
+            copyEvent(dst, event.array() + event.arrayOffset() + event.position(),
+                      eventLen, event.order());
+            dst += eventLen;
+            recordIndex->putInt(indexSize, eventLen);
+            indexSize += 4;
+        }
+
+        uint32_t n = last - offset - added;
+        size_t bytes = dst - (recordEvents->array() + pos);
+        recordEvents->position(pos + bytes);
+        eventSize  += bytes;
+        eventCount += n;
+
+        return added + n;
+    }
+
+
+    /**
+     * Adds a batch of events, each an EvioNode, into the record.
+     * As many events as fit, in order starting at offset, are added after checking
+     * the record's limits once for the whole batch. Each node's data is copied directly
+     * from its backing buffer whose position and limit are left untouched.
+     * If the first event is too large for an empty record, it is handled
+     * as in {@link #addEvent(EvioNode &, uint32_t)}.<p>
+     * Events in the opposite byte order of this record are swapped while being copied in.<p>
+     *
+     * @param nodes  vector of events.
+     * @param offset index into vector of first event to add.
+     * @param count  max number of events to add, defaults to all from offset on.
+     * @return number of events added, which may be less than count if the record
+     *         filled up or reached its event count limit.
+     * @throws EvioException if a node does not correspond to a bank.
+     */
+    uint32_t RecordOutput::addEvents(const std::vector<std::shared_ptr<EvioNode>> & nodes,
+                                     size_t offset, size_t count) {
+
+        if (offset >= nodes.size()) return 0;
+        count = std::min(count, nodes.size() - offset);
+
+        uint32_t added = 0;
+
+        if (eventCount < 1 && !roomForEvent(nodes[offset]->getTotalBytes())) {
+            if (!addEvent(*(nodes[offset]))) {
+                return 0;
+            }
+            added++;
+        }
+
+        uint32_t maxCount = MAX_EVENT_COUNT > eventCount ? MAX_EVENT_COUNT - eventCount : 0;
+        uint64_t room  = bytesAvailable();
+        uint64_t total = 0;
+        size_t last = offset + added;
+        size_t end  = offset + std::min(count, (size_t)added + maxCount);
+        for (; last < end; last++) {
+            if (!nodes[last]->getTypeObj().isBank()) {
+                throw EvioException("node does not represent a bank (" +
+                                    nodes[last]->getTypeObj().toString() + ")");
+            }
+            total += nodes[last]->getTotalBytes() + 4;
+            if (total > room) break;
+        }
+
+        size_t pos = recordEvents->position();
+        uint8_t *dst = recordEvents->array() + pos;
+
+        for (size_t i = offset + added; i < last; i++) {
+            auto & node = *(nodes[i]);
+            auto buf = node.getBuffer();
+            uint32_t eventLen = node.getTotalBytes();
+            copyEvent(dst, buf->array() + buf->arrayOffset() + node.getPosition(),
+                      eventLen, buf->order());
+            dst += eventLen;
+            recordIndex->putInt(indexSize, eventLen);
+            indexSize += 4;
+        }
+
+        uint32_t n = last - offset - added;
+        size_t bytes = dst - (recordEvents->array() + pos);
+        recordEvents->position(pos + bytes);
+        eventSize  += bytes;
+        eventCount += n;
+
+        return added + n;
+    }
+
+
+    /**
+     * Adds a batch of events, each an EvioBank, into the record.
+     * As many events as fit, in order starting at offset, are added after checking
+     * the record's limits once for the whole batch.
+     * If the first event is too large for an empty record, it is handled
+     * as in {@link #addEvent(EvioBank &, uint32_t)}.
+     *
+     * @param events vector of events.
+     * @param offset index into vector of first event to add.
+     * @param count  max number of events to add, defaults to all from offset on.
+     * @return number of events added, which may be less than count if the record
+     *         filled up or reached its event count limit.
+     */
+    uint32_t RecordOutput::addEvents(const std::vector<std::shared_ptr<EvioBank>> & events,
+                                     size_t offset, size_t count) {
+
+        if (offset >= events.size()) return 0;
+        count = std::min(count, events.size() - offset);
+
+        uint32_t added = 0;
+
+        if (eventCount < 1 && !roomForEvent(events[offset]->getTotalBytes())) {
+            if (!addEvent(*(events[offset]), 0)) {
+                return 0;
+            }
+            added++;
+        }
+
+        uint32_t maxCount = MAX_EVENT_COUNT > eventCount ? MAX_EVENT_COUNT - eventCount : 0;
+        uint64_t room  = bytesAvailable();
+        uint64_t total = 0;
+        size_t last = offset + added;
+        size_t end  = offset + std::min(count, (size_t)added + maxCount);
+        for (; last < end; last++) {
+            total += events[last]->getTotalBytes() + 4;
+            if (total > room) break;
+        }
+
+        size_t pos = recordEvents->position();
+        uint8_t *dst = recordEvents->array() + pos;
+
+        for (size_t i = offset + added; i < last; i++) {
+            uint32_t eventLen = events[i]->getTotalBytes();
+            events[i]->write(dst, recordEvents->order());
+            dst += eventLen;
+            recordIndex->putInt(indexSize, eventLen);
+            indexSize += 4;
+        }
+
+        uint32_t n = last - offset - added;
+        size_t bytes = dst - (recordEvents->array() + pos);
+        recordEvents->position(pos + bytes);
+        eventSize  += bytes;
+        eventCount += n;
+
+        return added + n;
+    }
+
+
     /**
      * Reset internal buffers. The buffer is ready to receive new data.
      * Also resets the header including removing any compression.
      * If data buffer externally provided, the starting position is set to 0.
      */
     void RecordOutput::reset() {
+        // Buffers grown for a large event are shrunk once events are small again
+        if (eventCount > 0 && !userProvidedBuffer && MAX_BUFFER_SIZE > nominalBufferSize) {
+            shrinkBuffers();
+        }
+
         indexSize  = 0;
         eventSize  = 0;
         eventCount = 0;
@@ -817,6 +1723,72 @@ namespace evio {
     }
 
 
+    /**
+     * Called by reset() while buffers are larger than constructed, before the events of the
+     * record just finished are forgotten. Grown buffers are not shrunk as soon as the large
+     * event which grew them is gone, since another may follow. Only once
+     * {@link #SHRINK_AFTER_RECORDS} records in a row have each had all events fit easily
+     * into buffers half the size are they shrunk, to the size of those events plus 1MB,
+     * but not below the constructed size.
+     */
+    void RecordOutput::shrinkBuffers() {
+        uint32_t largest = 0;
+        for (uint32_t i = 0; i < indexSize; i += 4) {
+            largest = std::max(largest, (uint32_t) recordIndex->getInt(i));
+        }
+
+        if (largest + ONE_MEG > MAX_BUFFER_SIZE / 2) {
+            smallRecordCount = 0;
+            largestRecentEvent = 0;
+            return;
+        }
+
+        largestRecentEvent = std::max(largestRecentEvent, largest);
+        if (++smallRecordCount < SHRINK_AFTER_RECORDS) {
+            return;
+        }
+
+        if (largestRecentEvent + ONE_MEG <= nominalBufferSize) {
+            MAX_BUFFER_SIZE = nominalBufferSize;
+            RECORD_BUFFER_SIZE = nominalRecordBufferSize;
+        }
+        else {
+            MAX_BUFFER_SIZE = largestRecentEvent + ONE_MEG;
+            RECORD_BUFFER_SIZE = MAX_BUFFER_SIZE + ONE_MEG;
+        }
+        allocate();
+
+        smallRecordCount = 0;
+        largestRecentEvent = 0;
+    }
+
+
+    /**
+     * Write zeros into all internal buffers. Since the OS places a page of memory on
+     * the NUMA node of the thread first writing to it, calling this from a thread
+     * placed on a given node, before the buffers are otherwise used, puts them there.
+     * A user-provided buffer is left alone. Nothing is done if the record has events.
+     * @param reallocate if true, allocate new buffers first, since memory
+     *                   which has already been touched stays where it is.
+     */
+    void RecordOutput::touchBuffers(bool reallocate) {
+        if (eventCount > 0) return;
+
+        if (reallocate) {
+            allocate();
+            recordIndex = std::make_shared<ByteBuffer>(MAX_EVENT_COUNT * 4);
+            recordIndex->order(byteOrder);
+        }
+
+        std::memset(recordData->array(),   0, recordData->capacity());
+        std::memset(recordIndex->array(),  0, recordIndex->capacity());
+        std::memset(recordEvents->array(), 0, recordEvents->capacity());
+        if (!userProvidedBuffer) {
+            std::memset(recordBinary->array(), 0, recordBinary->capacity());
+        }
+    }
+
+
     /**
      * Set the starting position of the user-given buffer being written into.
      * Calling this may be necessary from EventWriter(Unsync) when a common record
@@ -832,6 +1804,131 @@ namespace evio {
     }
 
 
+    /**
+     * Choose the compression actually used to build the record with the given data
+     * waiting in recordData. If fast compression is set, the slower types are replaced
+     * by fast lz4. If adaptive compression is on, a sample of the data is compressed
+     * with fast lz4 before spending time on one of the slower types. If that sample
+     * does not compress well enough, the data are stored uncompressed.
+     *
+     * @param compressionType compression type set in header (not UNCOMPRESSED).
+     * @param dataSize        number of bytes in recordData to be compressed.
+     * @param dstOffAbsolute  offset into recordBinary's backing array where
+     *                        compressed data will go, used as scratch space for the sample.
+     * @return compression type to use.
+     */
+    uint32_t RecordOutput::adaptCompressionType(uint32_t compressionType, uint32_t dataSize,
+                                                size_t dstOffAbsolute) {
+
+        if (fastCompression) {
+            return Compressor::LZ4;
+        }
+
+        // Fast lz4 is cheap enough to simply try on the whole record
+        if (maxCompressionRatio <= 0.F || compressionType == Compressor::LZ4) {
+            return compressionType;
+        }
+
+        // Bytes of data to trial compress, taken from the middle of the record
+        // where they are least likely to be dominated by headers
+        const uint32_t sampleSize = 64*1024;
+        if (dataSize < 4*sampleSize) {
+            return compressionType;
+        }
+
+        try {
+            int sampleCompressed = Compressor::getInstance().compressLZ4(
+                    recordData->array(), (dataSize - sampleSize)/2, sampleSize,
+                    recordBinary->array(), dstOffAbsolute,
+                    (recordBinary->capacity() - dstOffAbsolute),
+                    compressionDictionary.get());
+
+            if (compressedTooLarge(sampleCompressed, sampleSize)) {
+                return Compressor::UNCOMPRESSED;
+            }
+        }
+        catch (EvioException & e) {/* should not happen */}
+
+        return compressionType;
+    }
+
+
+    /**
+     * Is compressed data too large compared to the uncompressed data to be worth keeping?
+     * Always false if adaptive compression is off.
+     * @param compressedSize size of compressed data in bytes.
+     * @param dataSize       size of uncompressed data in bytes.
+     * @return true if compressed data is too large to be worth keeping.
+     */
+    bool RecordOutput::compressedTooLarge(uint32_t compressedSize, uint32_t dataSize) const {
+        return (maxCompressionRatio > 0.F) && (compressedSize > maxCompressionRatio * dataSize);
+    }
+
+
+    /**
+     * Copy the uncompressed data waiting in recordData directly past the record header
+     * in recordBinary, and set the header to describe an uncompressed record.
+     * Used when compression is not worth it.
+     * @param dataSize      number of valid bytes in recordData.
+     * @param recBinPastHdr position in recordBinary just past the record header.
+     */
+    void RecordOutput::storeUncompressed(uint32_t dataSize, size_t recBinPastHdr) {
+        recordBinary->clear();
+        recordBinary->position(recBinPastHdr);
+        recordBinary->put(recordData->array(), dataSize);
+
+        header->setCompressionType(Compressor::UNCOMPRESSED);
+        header->setCompressedDataLength(0);
+        // The uncompressed data size may not be padded to a 4byte boundary
+        int words = dataSize/4;
+        if (dataSize % 4 != 0) words++;
+        header->setLength(words*4 + header->getHeaderLength());
+    }
+
+
+    /**
+     * Compress the data waiting in recordData into recordBinary as independent lz4 blocks.
+     * @param best           if true, use lz4's highest compression, else its fastest.
+     * @param dataSize       number of valid bytes in recordData.
+     * @param dstOffAbsolute offset into recordBinary's backing array just past the record header.
+     * @return size of compressed data in bytes, 0 if it does not fit.
+     */
+    uint32_t RecordOutput::compressSeekable(bool best, uint32_t dataSize, size_t dstOffAbsolute) {
+        uint32_t room = recordBinary->capacity() - dstOffAbsolute;
+        if (SeekableCompression::maxCompressedLength(dataSize, seekableBlockSize) > room) {
+            return 0;
+        }
+        return SeekableCompression::compress(recordData->array(), dataSize,
+                                             recordBinary->array() + dstOffAbsolute, room,
+                                             seekableBlockSize, best, recordBinary->order(),
+                                             compressionDictionary.get());
+    }
+
+
+    /**
+     * Compress the data waiting in recordData into recordBinary with the banks of its
+     * events grouped by column.
+     * @param compressionType type of compression.
+     * @param dataSize        number of valid bytes in recordData.
+     * @param eventsOffset    bytes of index and padded user header in recordData.
+     * @param dstOffAbsolute  offset into recordBinary's backing array just past the record header.
+     * @return size of compressed data in bytes, 0 if no event holds banks or it does not fit.
+     */
+    uint32_t RecordOutput::compressColumns(uint32_t compressionType, uint32_t dataSize,
+                                           uint32_t eventsOffset, size_t dstOffAbsolute) {
+        try {
+            return ColumnLayout::compress(recordData->array(), dataSize, eventCount, eventsOffset,
+                                          recordBinary->array() + dstOffAbsolute,
+                                          recordBinary->capacity() - dstOffAbsolute,
+                                          Compressor::toCompressionType(compressionType),
+                                          recordBinary->order(), compressionDictionary.get());
+        }
+        catch (EvioException & e) {
+            return 0;
+        }
+    }
+
+
     /**
      * Builds the record. Compresses data, header is constructed,
      * then header & data written into internal buffer.
@@ -840,15 +1937,31 @@ namespace evio {
      */
     void RecordOutput::build() {
 
+        if (recordProcessor) {
+            recordProcessor(*this);
+        }
+
+        gathered = false;
+        // A checksum makes the header one word longer, a time range 4 words
+        header->hasChecksum(checksum);
+        buildTimeRange();
+        header->hasCompressionDictionary(false);
+        header->isSeekable(false);
+        header->setPreFilter(Compressor::NO_FILTER);
+        if (header->isColumnar()) {
+            header->setHeaderType(HeaderType::EVIO_RECORD);
+        }
+
         // If no events have been added yet, just write a header
         if (eventCount < 1) {
             header->setEntries(0);
             header->setDataLength(0);
             header->setIndexLength(0);
             header->setCompressedDataLength(0);
-            header->setLength(RecordHeader::HEADER_SIZE_BYTES);
-            recordBinary->limit(startingPosition + RecordHeader::HEADER_SIZE_BYTES);
+            header->setLength(header->getHeaderLength());
+            recordBinary->limit(startingPosition + header->getHeaderLength());
             recordBinary->position(startingPosition);
+            buildChecksum();
             try {
                 header->writeHeader(recordBinary, 0);
             }
@@ -858,10 +1971,14 @@ namespace evio {
             return;
         }
 
+        if (fillStats != nullptr) {
+            fillStats->addRecord(eventCount, eventSize + indexSize, MAX_BUFFER_SIZE - RecordHeader::HEADER_SIZE_BYTES);
+        }
+
         uint32_t compressionType = header->getCompressionType();
 
         // Position in recordBinary buffer of just past the record header
-        size_t recBinPastHdr = startingPosition + RecordHeader::HEADER_SIZE_BYTES;
+        size_t recBinPastHdr = startingPosition + header->getHeaderLength();
 //std::cout << "build: pos past header = " << recBinPastHdr << std::endl;
 
         // Position in recordBinary buffer's backing array of just past the record header.
@@ -871,6 +1988,7 @@ namespace evio {
         size_t recBinPastHdrAbsolute = recBinPastHdr + recordBinary->arrayOffset();
 
         // Write index & event arrays
+        EVIO_PROFILE_BEGIN(copy, RECORD_BUILD_COPY);
 
         // If compressing data ...
         if (compressionType != Compressor::UNCOMPRESSED) {
@@ -880,6 +1998,12 @@ namespace evio {
             recordData->put( recordIndex->array(), indexSize);
             recordData->put(recordEvents->array(), eventSize);
         }
+        // If NOT compressing data, but writing it by gathering its parts,
+        // the index and events stay where they are
+        else if (gatherOutput) {
+            recordBinary->clear();
+            gathered = true;
+        }
         // If NOT compressing data ...
         else {
 //std::cout << "build: recordBinary len = " << userBufferSize <<
@@ -899,39 +2023,85 @@ namespace evio {
 
             recordBinary->put(recordEvents->array(), eventSize);
         }
+        EVIO_PROFILE_END(copy);
 
         // Evio data is padded, but not necessarily all hipo data.
         // Uncompressed data length is NOT padded, but the record length is.
         uint32_t uncompressedDataSize = indexSize + eventSize;
         uint32_t compressedSize = 0;
+#ifdef USE_GZIP
         uint8_t* gzippedData;
+#endif
 //std::cout << "build: writing index of size " << indexSize << ", events of size " <<
 //             eventSize << ", total = " << uncompressedDataSize << std::endl;
 
         // Compress that temporary buffer into destination buffer
         // (skipping over where record header will be written).
+        // Settings for adaptive or fast compression may change the type used
+        EVIO_PROFILE_BEGIN(compress, RECORD_BUILD_COMPRESS);
+        uint32_t requestedType = compressionType;
+        // Banks are grouped by column straight from the events, which filtering would scramble
+        bool byColumn = columnLayout && header->isEvioRecord();
+        Compressor::PreFilter filter = byColumn ? Compressor::NO_FILTER : preFilter;
+        if (compressionType != Compressor::UNCOMPRESSED) {
+            Compressor::filter(filter, recordData->array(), uncompressedDataSize, recordBinary->order());
+            compressionType = adaptCompressionType(compressionType, uncompressedDataSize,
+                                                   recBinPastHdrAbsolute);
+        }
+
+        // Unless none of its events holds banks to group, the record is laid out by column
+        bool columnar = false;
+        if (byColumn && compressionType != Compressor::UNCOMPRESSED) {
+            compressedSize = compressColumns(compressionType, uncompressedDataSize,
+                                             uncompressedDataSize - eventSize, recBinPastHdrAbsolute);
+            columnar = compressedSize > 0;
+        }
+
+        // Lz4 data is compressed as independent blocks if asked to be seekable,
+        // or if large enough for several threads to share the work
+        bool seekable = !columnar &&
+                        (seekableBlockSize > 0 || SeekableCompression::isParallel(uncompressedDataSize)) &&
+                        (compressionType == Compressor::LZ4 || compressionType == Compressor::LZ4_BEST);
+
         try {
-            switch (compressionType) {
+            if (columnar) {
+                header->setCompressedDataLength(compressedSize);
+                header->setLength(4*header->getCompressedDataLengthWords() +
+                                  header->getHeaderLength());
+            }
+            else switch (compressionType) {
                 case 1:
                     // LZ4 fastest compression
-                    compressedSize = Compressor::getInstance().compressLZ4(
-                            recordData->array(), 0, uncompressedDataSize,
-                            recordBinary->array(), recBinPastHdrAbsolute,
-                            (recordBinary->capacity() - recBinPastHdrAbsolute));
+                    if (seekable) {
+                        compressedSize = compressSeekable(false, uncompressedDataSize, recBinPastHdrAbsolute);
+                    }
+                    else {
+                        compressedSize = Compressor::getInstance().compressLZ4(
+                                recordData->array(), 0, uncompressedDataSize,
+                                recordBinary->array(), recBinPastHdrAbsolute,
+                                (recordBinary->capacity() - recBinPastHdrAbsolute),
+                                compressionDictionary.get());
+                    }
 
                     // Length of compressed data in bytes
                     header->setCompressedDataLength(compressedSize);
                     // Length of entire record in bytes (don't forget padding!)
                     header->setLength(4*header->getCompressedDataLengthWords() +
-                                      RecordHeader::HEADER_SIZE_BYTES);
+                                      header->getHeaderLength());
                     break;
 
                 case 2:
                     // LZ4 highest compression
-                    compressedSize = Compressor::getInstance().compressLZ4Best(
-                            recordData->array(), 0, uncompressedDataSize,
-                            recordBinary->array(), recBinPastHdrAbsolute,
-                            (recordBinary->capacity() - recBinPastHdrAbsolute));
+                    if (seekable) {
+                        compressedSize = compressSeekable(true, uncompressedDataSize, recBinPastHdrAbsolute);
+                    }
+                    else {
+                        compressedSize = Compressor::getInstance().compressLZ4Best(
+                                recordData->array(), 0, uncompressedDataSize,
+                                recordBinary->array(), recBinPastHdrAbsolute,
+                                (recordBinary->capacity() - recBinPastHdrAbsolute),
+                                compressionDictionary.get());
+                    }
 
 //std::cout << "Compressing data array from offset = 0, size = " << uncompressedDataSize <<
 //             " to output.array offset = " << recBinPastHdrAbsolute << ", compressed size = " <<  compressedSize <<
@@ -943,7 +2113,7 @@ namespace evio {
 
                     header->setCompressedDataLength(compressedSize);
                     header->setLength(4*header->getCompressedDataLengthWords() +
-                                      RecordHeader::HEADER_SIZE_BYTES);
+                                      header->getHeaderLength());
 
 //std::cout << "AFTER setting, read back from header: comp size = " << header->getCompressedDataLength() <<
 //             ", comp words = " << header->getCompressedDataLengthWords() << ", padding = " <<
@@ -961,7 +2131,22 @@ namespace evio {
                 delete[] gzippedData;
                 header->setCompressedDataLength(compressedSize);
                 header->setLength(4*header->getCompressedDataLengthWords() +
-                                 RecordHeader::HEADER_SIZE_BYTES);
+                                 header->getHeaderLength());
+#endif
+                    break;
+
+                case 4:
+                    // Zstandard compression
+#ifdef USE_ZSTD
+                    compressedSize = Compressor::getInstance().compressZstd(
+                            recordData->array(), 0, uncompressedDataSize,
+                            recordBinary->array(), recBinPastHdrAbsolute,
+                            (recordBinary->capacity() - recBinPastHdrAbsolute),
+                            compressionDictionary.get());
+
+                    header->setCompressedDataLength(compressedSize);
+                    header->setLength(4*header->getCompressedDataLengthWords() +
+                                      header->getHeaderLength());
 #endif
                     break;
 
@@ -972,11 +2157,35 @@ namespace evio {
                     header->setCompressedDataLength(0);
                     int words = uncompressedDataSize/4;
                     if (uncompressedDataSize % 4 != 0) words++;
-                    header->setLength(words*4 + RecordHeader::HEADER_SIZE_BYTES);
+                    header->setLength(words*4 + header->getHeaderLength());
 //std::cout << "  build(): set header length = " << header->getLength() << ", uncompressed data size = " << uncompressedDataSize << std::endl;
             }
         }
         catch (EvioException & e) {/* should not happen */}
+        EVIO_PROFILE_END(compress);
+
+        if (requestedType != Compressor::UNCOMPRESSED) {
+            if (compressionType == Compressor::UNCOMPRESSED ||
+                (seekable && compressedSize == 0) ||
+                compressedTooLarge(compressedSize, uncompressedDataSize)) {
+                // Data waiting in recordData is stored as it was before being filtered
+                Compressor::unfilter(filter, recordData->array(), uncompressedDataSize, recordBinary->order());
+                storeUncompressed(uncompressedDataSize, recBinPastHdr);
+            }
+            else {
+                if (compressionType != requestedType) {
+                    header->setCompressionType(Compressor::toCompressionType(compressionType));
+                }
+                // Readers need the dictionary to decompress it
+                header->hasCompressionDictionary(compressionDictionary != nullptr &&
+                                                 compressionType != Compressor::GZIP);
+                header->isSeekable(seekable);
+                header->setPreFilter(filter);
+                if (columnar) {
+                    header->setHeaderType(HeaderType::EVIO_COLUMN_RECORD);
+                }
+            }
+        }
 
         // Set the rest of the header values
         header->setEntries(eventCount);
@@ -987,6 +2196,9 @@ namespace evio {
 //             compressionType << "  uncompressed = " << uncompressedDataSize <<
 //             " record bytes = " << header->getLength() << std::endl << std::endl;
 
+        buildTagFilter();
+        buildChecksum();
+
         // Go back and write header into destination buffer
         try {
             // Does NOT change recordBinary pos or lim
@@ -995,7 +2207,12 @@ namespace evio {
         catch (EvioException & e) {/* never happen */}
 
         // Make ready to read
-        recordBinary->limit(startingPosition + header->getLength()).position(0);
+        if (gathered) {
+            recordBinary->limit(startingPosition + header->getHeaderLength()).position(0);
+        }
+        else {
+            recordBinary->limit(startingPosition + header->getLength()).position(0);
+        }
     }
 
 
@@ -1032,6 +2249,21 @@ namespace evio {
             return;
         }
 
+        if (recordProcessor) {
+            recordProcessor(*this);
+        }
+
+        // A user header is always written next to the header
+        gathered = false;
+        header->hasChecksum(checksum);
+        buildTimeRange();
+        header->hasCompressionDictionary(false);
+        header->isSeekable(false);
+        header->setPreFilter(Compressor::NO_FILTER);
+        if (header->isColumnar()) {
+            header->setHeaderType(HeaderType::EVIO_RECORD);
+        }
+
 //std::cout << "  buld: indexSize = " << indexSize << ", index + userHeader =  " << (indexSize + userHeaderSize) <<
 //             ",  userheader = " << userHeaderSize << std::endl;
 
@@ -1039,7 +2271,7 @@ namespace evio {
         uint32_t uncompressedDataSize = indexSize;
 
         // Position in recordBinary buffer of just past the record header
-        size_t recBinPastHdr = startingPosition + RecordHeader::HEADER_SIZE_BYTES;
+        size_t recBinPastHdr = startingPosition + header->getHeaderLength();
 
         // Position in recordBinary buffer's backing array of just past the record header.
         // Usually the same as the corresponding buffer position. But need to
@@ -1050,6 +2282,7 @@ namespace evio {
         size_t recBinPastHdrAbsolute = recBinPastHdr + recordBinary->arrayOffset();
 
         // If compressing data ...
+        EVIO_PROFILE_BEGIN(copy, RECORD_BUILD_COPY);
         if (compressionType != Compressor::UNCOMPRESSED) {
             recordData->clear();
             recordBinary->clear();
@@ -1097,38 +2330,84 @@ namespace evio {
             // May not be padded ...
             uncompressedDataSize += eventSize;
         }
+        EVIO_PROFILE_END(copy);
 
         // Compress that temporary buffer into destination buffer
         // (skipping over where record header will be written).
         uint32_t compressedSize = 0;
+#ifdef USE_GZIP
         uint8_t* gzippedData;
+#endif
+
+        // Settings for adaptive or fast compression may change the type used
+        EVIO_PROFILE_BEGIN(compress, RECORD_BUILD_COMPRESS);
+        uint32_t requestedType = compressionType;
+        // Banks are grouped by column straight from the events, which filtering would scramble
+        bool byColumn = columnLayout && header->isEvioRecord();
+        Compressor::PreFilter filter = byColumn ? Compressor::NO_FILTER : preFilter;
+        if (compressionType != Compressor::UNCOMPRESSED) {
+            Compressor::filter(filter, recordData->array(), uncompressedDataSize, recordBinary->order());
+            compressionType = adaptCompressionType(compressionType, uncompressedDataSize,
+                                                   recBinPastHdrAbsolute);
+        }
+
+        // Unless none of its events holds banks to group, the record is laid out by column
+        bool columnar = false;
+        if (byColumn && compressionType != Compressor::UNCOMPRESSED) {
+            compressedSize = compressColumns(compressionType, uncompressedDataSize,
+                                             uncompressedDataSize - eventSize, recBinPastHdrAbsolute);
+            columnar = compressedSize > 0;
+        }
+
+        // Lz4 data is compressed as independent blocks if asked to be seekable,
+        // or if large enough for several threads to share the work
+        bool seekable = !columnar &&
+                        (seekableBlockSize > 0 || SeekableCompression::isParallel(uncompressedDataSize)) &&
+                        (compressionType == Compressor::LZ4 || compressionType == Compressor::LZ4_BEST);
 
         try {
-            switch (compressionType) {
+            if (columnar) {
+                header->setCompressedDataLength(compressedSize);
+                header->setLength(4*header->getCompressedDataLengthWords() +
+                                  header->getHeaderLength());
+            }
+            else switch (compressionType) {
                 case 1:
                     // LZ4 fastest compression
-                    compressedSize = Compressor::getInstance().compressLZ4(
-                            recordData->array(), 0, uncompressedDataSize,
-                            recordBinary->array(), recBinPastHdrAbsolute,
-                            (recordBinary->capacity() - recBinPastHdrAbsolute));
+                    if (seekable) {
+                        compressedSize = compressSeekable(false, uncompressedDataSize, recBinPastHdrAbsolute);
+                    }
+                    else {
+                        compressedSize = Compressor::getInstance().compressLZ4(
+                                recordData->array(), 0, uncompressedDataSize,
+                                recordBinary->array(), recBinPastHdrAbsolute,
+                                (recordBinary->capacity() - recBinPastHdrAbsolute),
+                                compressionDictionary.get());
+                    }
 
                     // Length of compressed data in bytes
                     header->setCompressedDataLength(compressedSize);
                     // Length of entire record in bytes (don't forget padding!)
                     header->setLength(4*header->getCompressedDataLengthWords() +
-                                      RecordHeader::HEADER_SIZE_BYTES);
+                                      header->getHeaderLength());
                     break;
 
                 case 2:
                     // LZ4 highest compression
-                    compressedSize = Compressor::getInstance().compressLZ4Best(
-                            recordData->array(), 0, uncompressedDataSize,
-                            recordBinary->array(), recBinPastHdrAbsolute,
-                            (recordBinary->capacity() - recBinPastHdrAbsolute));
+                    if (seekable) {
+                        compressedSize = compressSeekable(true, uncompressedDataSize, recBinPastHdrAbsolute);
+                    }
+                    else {
+                        compressedSize = Compressor::getInstance().compressLZ4Best(
+                                recordData->array(), 0, uncompressedDataSize,
+                                recordBinary->array(), recBinPastHdrAbsolute,
+                                (recordBinary->capacity() - recBinPastHdrAbsolute),
+                                compressionDictionary.get());
+                    }
 
                     header->setCompressedDataLength(compressedSize);
                     header->setLength(4*header->getCompressedDataLengthWords() +
-                                      RecordHeader::HEADER_SIZE_BYTES);
+                                      header->getHeaderLength());
                     break;
 
                 case 3:
@@ -1141,7 +2420,22 @@ namespace evio {
                 delete[] gzippedData;
                 header->setCompressedDataLength(compressedSize);
                 header->setLength(4*header->getCompressedDataLengthWords() +
-                                 RecordHeader::HEADER_SIZE_BYTES);
+                                 header->getHeaderLength());
+#endif
+                    break;
+
+                case 4:
+                    // Zstandard compression
+#ifdef USE_ZSTD
+                    compressedSize = Compressor::getInstance().compressZstd(
+                            recordData->array(), 0, uncompressedDataSize,
+                            recordBinary->array(), recBinPastHdrAbsolute,
+                            (recordBinary->capacity() - recBinPastHdrAbsolute),
+                            compressionDictionary.get());
+
+                    header->setCompressedDataLength(compressedSize);
+                    header->setLength(4*header->getCompressedDataLengthWords() +
+                                      header->getHeaderLength());
 #endif
                     break;
 
@@ -1152,10 +2446,34 @@ namespace evio {
                     header->setCompressedDataLength(0);
                     int words = uncompressedDataSize/4;
                     if (uncompressedDataSize % 4 != 0) words++;
-                    header->setLength(words*4 + RecordHeader::HEADER_SIZE_BYTES);
+                    header->setLength(words*4 + header->getHeaderLength());
             }
         }
         catch (EvioException & e) {/* should not happen */}
+        EVIO_PROFILE_END(compress);
+
+        if (requestedType != Compressor::UNCOMPRESSED) {
+            if (compressionType == Compressor::UNCOMPRESSED ||
+                (seekable && compressedSize == 0) ||
+                compressedTooLarge(compressedSize, uncompressedDataSize)) {
+                // Data waiting in recordData is stored as it was before being filtered
+                Compressor::unfilter(filter, recordData->array(), uncompressedDataSize, recordBinary->order());
+                storeUncompressed(uncompressedDataSize, recBinPastHdr);
+            }
+            else {
+                if (compressionType != requestedType) {
+                    header->setCompressionType(Compressor::toCompressionType(compressionType));
+                }
+                // Readers need the dictionary to decompress it
+                header->hasCompressionDictionary(compressionDictionary != nullptr &&
+                                                 compressionType != Compressor::GZIP);
+                header->isSeekable(seekable);
+                header->setPreFilter(filter);
+                if (columnar) {
+                    header->setHeaderType(HeaderType::EVIO_COLUMN_RECORD);
+                }
+            }
+        }
 
         //std::cout << " COMPRESSED SIZE = " << compressedSize << std::endl;
 
@@ -1164,6 +2482,9 @@ namespace evio {
         header->setDataLength(eventSize);
         header->setIndexLength(indexSize);
 
+        buildTagFilter();
+        buildChecksum();
+
         // Go back and write header into destination buffer
         try {
             header->writeHeader(recordBinary, startingPosition);
@@ -1174,4 +2495,42 @@ namespace evio {
         recordBinary->limit(startingPosition + header->getLength()).position(0);
     }
 
+
+    /**
+     * Get the parts of the last built record in the order they are to be written.
+     * If the record was built for gathering (see {@link #setGatherOutput(bool)}), these are
+     * the header, index, events and any padding, none of which were copied to be next to
+     * each other. Otherwise the whole record in the binary buffer is the only part.
+     * The parts are valid until this record is reset or more events are added.
+     *
+     * @param segments vector filled with views of each part of the record, in order.
+     * @return number of parts.
+     */
+    uint32_t RecordOutput::getSegments(std::vector<ByteBufferView> & segments) const {
+        // Padding at the end of uncompressed data
+        static const uint8_t padding[4] = {0,0,0,0};
+
+        segments.clear();
+        const uint8_t *start = recordBinary->array() + recordBinary->arrayOffset() + startingPosition;
+
+        if (!gathered) {
+            segments.emplace_back(start, header->getLength(), byteOrder);
+            return 1;
+        }
+
+        size_t hdrBytes = header->getHeaderLength();
+        segments.emplace_back(start, hdrBytes, byteOrder);
+        if (indexSize > 0) {
+            segments.emplace_back(recordIndex->array(), indexSize, byteOrder);
+        }
+        if (eventSize > 0) {
+            segments.emplace_back(recordEvents->array(), eventSize, byteOrder);
+        }
+        uint32_t pad = header->getLength() - hdrBytes - indexSize - eventSize;
+        if (pad > 0) {
+            segments.emplace_back(padding, pad, byteOrder);
+        }
+        return segments.size();
+    }
+
 }
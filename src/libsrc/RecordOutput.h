@@ -15,17 +15,24 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <functional>
 
 
 #include "ByteBuffer.h"
 #include "ByteOrder.h"
+#include "ByteBufferView.h"
 #include "EvioBank.h"
 #include "EvioNode.h"
+#include "GatheredEvent.h"
 #include "RecordHeader.h"
 #include "FileHeader.h"
 #include "Compressor.h"
+#include "CompressionDictionary.h"
+#include "RecordFillStats.h"
 #include "EvioException.h"
 
 
@@ -98,6 +105,12 @@ namespace evio {
      *    +----------------------------------+
      * </pre>
      *
+     * Compression may be made adaptive by calling {@link #setMaxCompressionRatio(float)}.
+     * Records whose data do not compress well enough are then stored uncompressed,
+     * with their header's compression type set accordingly. Since each record has
+     * its own compression type, mixing compressed and uncompressed records in one file
+     * is perfectly legal.<p>
+     *
      * @version 6.0
      * @since 6.0 4/9/2019
      * @author timmer
@@ -106,6 +119,27 @@ namespace evio {
 
     public:
 
+        /**
+         * Callback which finds the timestamp of an event, given its bytes, length in bytes
+         * and byte order, so the range of each record's timestamps can be stored in its header.
+         * Returns false if the event has no timestamp.
+         */
+        typedef std::function<bool(const uint8_t *event, uint32_t length, ByteOrder const & order,
+                                   uint64_t & timestamp)> TimestampExtractor;
+
+        /**
+         * Callback which edits an event in place, given its bytes, length in bytes and byte order.
+         * Returns its new length, which may be no more than its old, or 0 to drop it.
+         */
+        typedef std::function<uint32_t(uint8_t *event, uint32_t length, ByteOrder const & order)> EventEditor;
+
+        /**
+         * Callback run on a record's events when it is built, before it is compressed.
+         * Through {@link #editEvents(EventEditor const &)} and
+         * {@link #addEvent(const uint8_t *, uint32_t, uint32_t)} it may drop, rewrite or add events.
+         */
+        typedef std::function<void(RecordOutput & record)> RecordProcessor;
+
         /** Maximum number of events per record. */
         static constexpr int ONE_MEG = 1024*1024;
 
@@ -132,6 +166,22 @@ namespace evio {
          */
         uint32_t RECORD_BUFFER_SIZE = 9*ONE_MEG;
 
+        /** Number of records in a row, each of whose events would easily fit into buffers half
+         *  the size, after which buffers grown to take in a large event are shrunk. */
+        static constexpr uint32_t SHRINK_AFTER_RECORDS = 16;
+
+        /** Value of {@link #MAX_BUFFER_SIZE} as constructed, to which grown buffers shrink back. */
+        uint32_t nominalBufferSize = 8*ONE_MEG;
+
+        /** Value of {@link #RECORD_BUFFER_SIZE} as constructed, to which grown buffers shrink back. */
+        uint32_t nominalRecordBufferSize = 9*ONE_MEG;
+
+        /** Largest event of the records counted in {@link #smallRecordCount}. */
+        uint32_t largestRecentEvent = 0;
+
+        /** Number of records in a row, since buffers grew, whose events fit into half the buffers. */
+        uint32_t smallRecordCount = 0;
+
         /** The number of initially available bytes to be written into in the user-given buffer,
          *  that go from position to limit. The user-given buffer is stored in recordBinary.
          */
@@ -173,6 +223,56 @@ namespace evio {
         /** Is recordBinary a user provided buffer? */
         bool userProvidedBuffer = false;
 
+        /**
+         * Adaptive compression. If compressed data would be larger than this fraction
+         * of the uncompressed data, the record is stored uncompressed instead.
+         * A value of 0 turns adaptive compression off.
+         */
+        float maxCompressionRatio = 0.F;
+
+        /** If true, and compressing, build the next record with the fastest lz4 compression
+         *  regardless of the type set in its header. */
+        bool fastCompression = false;
+
+        /** If true, store a filter of the tags and nums of the events in the header when building. */
+        bool tagFilter = false;
+
+        /** If true, store a CRC32C of the data in the header when building. */
+        bool checksum = false;
+
+        /** If set, store the range of the events' timestamps it finds in the header when building. */
+        TimestampExtractor timestampExtractor;
+
+        /** If set, run on the events when building, before anything else is done. */
+        RecordProcessor recordProcessor;
+
+        /** If not null, and compressing with LZ4 or zstd, compress starting from this trained dictionary. */
+        std::shared_ptr<CompressionDictionary> compressionDictionary;
+
+        /** If true, and not compressing, build only the header into recordBinary and
+         *  leave index and events where they are so they can be written by gathering them. */
+        bool gatherOutput = false;
+
+        /** Did the last build leave index and events out of recordBinary? */
+        bool gathered = false;
+
+        /** If not null, where sizes of events added and fill of records built are counted. */
+        RecordFillStats *fillStats = nullptr;
+
+        /** If not 0, bytes of header, index and events beyond which no event is added to a
+         *  record already holding one, even if there's memory for it. */
+        uint32_t targetRecordBytes = 0;
+
+        /** If not 0, uncompressed bytes in each independently compressed block of
+         *  lz4 records, which makes them seekable. */
+        uint32_t seekableBlockSize = 0;
+
+        /** Filter applied to data of compressed records before compressing it. */
+        Compressor::PreFilter preFilter = Compressor::NO_FILTER;
+
+        /** Are banks of compressed evio records grouped by column? */
+        bool columnLayout = false;
+
 
     public:
 
@@ -201,9 +301,24 @@ namespace evio {
 
 
         void allocate();
+        void shrinkBuffers();
         bool allowedIntoRecord(uint32_t length);
         void copy(const RecordOutput & rec);
 
+        uint32_t adaptCompressionType(uint32_t compressionType, uint32_t dataSize, size_t dstOffAbsolute);
+        bool compressedTooLarge(uint32_t compressedSize, uint32_t dataSize) const;
+        void storeUncompressed(uint32_t dataSize, size_t recBinPastHdr);
+        uint32_t compressSeekable(bool best, uint32_t dataSize, size_t dstOffAbsolute);
+        uint32_t compressColumns(uint32_t compressionType, uint32_t dataSize,
+                                 uint32_t eventsOffset, size_t dstOffAbsolute);
+        void buildTagFilter();
+        void buildTimeRange();
+        void buildChecksum();
+
+        uint32_t bytesAvailable() const;
+        uint32_t eventsThatFit(const uint32_t* eventLens, uint32_t count, uint32_t *bytes) const;
+        void copyEvent(uint8_t *dst, const uint8_t *src, uint32_t eventLen, ByteOrder const & srcOrder) const;
+
 
     public:
 
@@ -216,13 +331,44 @@ namespace evio {
         uint32_t getInternalBufferCapacity() const;
         uint32_t getMaxEventCount() const;
         uint32_t getEventCount() const;
+        uint32_t getEventLength(uint32_t index) const;
 
         std::shared_ptr<RecordHeader> & getHeader();
         const ByteOrder & getByteOrder() const;
         const std::shared_ptr<ByteBuffer> getBinaryBuffer() const;
+        const std::shared_ptr<ByteBuffer> getEventBuffer() const;
         const Compressor::CompressionType getCompressionType() const;
         const HeaderType getHeaderType() const;
 
+        float getMaxCompressionRatio() const;
+        void  setMaxCompressionRatio(float ratio);
+        bool  getFastCompression() const;
+        void  setFastCompression(bool fast);
+        bool  getTagFilter() const;
+        void  setTagFilter(bool filter);
+        bool  getChecksum() const;
+        void  setChecksum(bool sum);
+        TimestampExtractor getTimestampExtractor() const;
+        void  setTimestampExtractor(TimestampExtractor extractor);
+        static TimestampExtractor bankTimestamp(uint16_t tag);
+        RecordProcessor getRecordProcessor() const;
+        void  setRecordProcessor(RecordProcessor processor);
+        std::shared_ptr<CompressionDictionary> getCompressionDictionary() const;
+        void  setCompressionDictionary(std::shared_ptr<CompressionDictionary> dict);
+        bool  getGatherOutput() const;
+        void  setGatherOutput(bool gather);
+        bool  isGathered() const;
+        RecordFillStats * getFillStats() const;
+        void  setFillStats(RecordFillStats * stats);
+        uint32_t getTargetRecordBytes() const;
+        void  setTargetRecordBytes(uint32_t bytes);
+        uint32_t getSeekableCompression() const;
+        void  setSeekableCompression(uint32_t blockSize);
+        Compressor::PreFilter getPreFilter() const;
+        void  setPreFilter(Compressor::PreFilter filter);
+        bool  getColumnLayout() const;
+        void  setColumnLayout(bool byColumn);
+
         bool hasUserProvidedBuffer() const;
         bool roomForEvent(uint32_t length) const;
         bool oneTooMany() const;
@@ -241,7 +387,20 @@ namespace evio {
         bool addEvent(EvioBank & event, uint32_t extraDataLen);
         bool addEvent(std::shared_ptr<EvioBank> & event, uint32_t extraDataLen = 0);
 
+        bool addEvent(GatheredEvent const & event, uint32_t extraDataLen = 0);
+
+        uint32_t editEvents(EventEditor const & editor);
+
+        uint32_t addEvents(const uint8_t* events, const uint32_t* eventLens, uint32_t count);
+        uint32_t addEvents(const std::vector<std::shared_ptr<ByteBuffer>> & events,
+                           size_t offset = 0, size_t count = SIZE_MAX);
+        uint32_t addEvents(const std::vector<std::shared_ptr<EvioNode>> & nodes,
+                           size_t offset = 0, size_t count = SIZE_MAX);
+        uint32_t addEvents(const std::vector<std::shared_ptr<EvioBank>> & events,
+                           size_t offset = 0, size_t count = SIZE_MAX);
+
         void reset();
+        void touchBuffers(bool reallocate = false);
 
         void setStartingBufferPosition(size_t pos);
 
@@ -249,6 +408,8 @@ namespace evio {
         void build(std::shared_ptr<ByteBuffer> userHeader);
         void build(const ByteBuffer & userHeader);
 
+        uint32_t getSegments(std::vector<ByteBufferView> & segments) const;
+
     };
 
 }
@@ -21,14 +21,7 @@ namespace evio {
     uint64_t RecordRingItem::idValue = 0ULL;
 
 
-    // Set default values for RecordRingItems
-    int       RecordRingItem::factoryMaxEventCount {0};
-    int       RecordRingItem::factoryMaxBufferSize {0};
-    ByteOrder RecordRingItem::factoryByteOrder {ByteOrder::ENDIAN_LOCAL};
-    Compressor::CompressionType RecordRingItem::factoryCompressionType {Compressor::UNCOMPRESSED};
-
-
-    /** Function to create RecordRingItems by RingBuffer. */
+    /** Function to create RecordRingItems, with default settings, by RingBuffer. */
     const std::function< std::shared_ptr<RecordRingItem> () >& RecordRingItem::eventFactory() {
         static std::function< std::shared_ptr<RecordRingItem> () > result([] {
             return std::move(std::make_shared<RecordRingItem>());
@@ -37,36 +30,48 @@ namespace evio {
     }
 
 
-    // --------------------------------
-
-
     /**
-     * Method to set RecordRingItem parameters for objects created by eventFactory.
+     * Get a function to create RecordRingItems by RingBuffer, each with a record of the given settings.
+     * Each RecordSupply has its own so that supplies of different settings can exist together.
+     *
      * @param order           byte order.
      * @param maxEventCount   max number of events each record can hold.
      *                        Value <= O means use default (1M).
      * @param maxBufferSize   max number of uncompressed data bytes each record can hold.
      *                        Value of < 8MB results in default of 8MB.
      * @param compressionType type of data compression to do.
+     * @return function to create RecordRingItems.
      */
-    void RecordRingItem::setEventFactorySettings(ByteOrder & order,
-                                                 uint32_t maxEventCount, uint32_t maxBufferSize,
-                                                 Compressor::CompressionType & compressionType) {
-        RecordRingItem::factoryByteOrder = order;
-        RecordRingItem::factoryMaxEventCount = maxEventCount;
-        RecordRingItem::factoryMaxBufferSize = maxBufferSize;
-        RecordRingItem::factoryCompressionType = compressionType;
+    std::function< std::shared_ptr<RecordRingItem> () >
+            RecordRingItem::eventFactory(const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
+                                         Compressor::CompressionType compressionType) {
+        return [order, maxEventCount, maxBufferSize, compressionType] {
+            return std::make_shared<RecordRingItem>(order, maxEventCount, maxBufferSize, compressionType);
+        };
     }
 
 
-    /** Default constructor.
-     *  Used in RecordSupply by eventFactory to create RecordRingItems for supply. */
-    RecordRingItem::RecordRingItem() : order(ByteOrder::ENDIAN_LITTLE) {
+    // --------------------------------
+
 
-        record = std::make_shared<RecordOutput>(RecordRingItem::factoryByteOrder,
-                                                RecordRingItem::factoryMaxEventCount,
-                                                RecordRingItem::factoryMaxBufferSize,
-                                                RecordRingItem::factoryCompressionType);
+    /** Default constructor. Record is local endian, uncompressed, and of default size. */
+    RecordRingItem::RecordRingItem() :
+            RecordRingItem(ByteOrder::ENDIAN_LOCAL, 0, 0, Compressor::UNCOMPRESSED) {}
+
+
+    /**
+     * Constructor used in RecordSupply by eventFactory to create RecordRingItems for supply.
+     * @param order           byte order.
+     * @param maxEventCount   max number of events each record can hold.
+     *                        Value <= O means use default (1M).
+     * @param maxBufferSize   max number of uncompressed data bytes each record can hold.
+     *                        Value of < 8MB results in default of 8MB.
+     * @param compressionType type of data compression to do.
+     */
+    RecordRingItem::RecordRingItem(const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
+                                   Compressor::CompressionType compressionType) : order(ByteOrder::ENDIAN_LITTLE) {
+
+        record = std::make_shared<RecordOutput>(order, maxEventCount, maxBufferSize, compressionType);
         id = idValue++;
     }
 
@@ -86,6 +91,7 @@ namespace evio {
         if (this != &item) {
             id = item.id;
             order = item.order;
+            writeStartTime = item.writeStartTime;
             sequence = item.sequence;
             lastItem.store(item.lastItem);
             checkDisk.store(item.checkDisk);
@@ -166,7 +172,7 @@ namespace evio {
      * Get the Sequence object allowing ring consumer to get/release this item.
      * @return Sequence object allowing ring consumer to get/release this item.
      */
-    std::shared_ptr<Disruptor::ISequence> & RecordRingItem::getSequenceObj() {return sequenceObj;}
+    Disruptor::ISequence * RecordRingItem::getSequenceObj() {return sequenceObj;}
 
 
     /**
@@ -181,7 +187,7 @@ namespace evio {
      * @param seq sequence used to get item.
      * @param seqObj sequence object used to get/release item.
      */
-    void RecordRingItem::fromConsumer(int64_t seq, std::shared_ptr<Disruptor::ISequence> & seqObj) {
+    void RecordRingItem::fromConsumer(int64_t seq, Disruptor::ISequence *seqObj) {
         sequence = seq;
         sequenceObj = seqObj;
     }
@@ -278,4 +284,22 @@ namespace evio {
      */
     void RecordRingItem::setId(uint64_t idVal) {id = idVal;}
 
+
+    /**
+     * Get the time at which the writing thread took this item.
+     * @return time at which the writing thread took this item.
+     */
+    const std::chrono::steady_clock::time_point & RecordRingItem::getWriteStartTime() const {
+        return writeStartTime;
+    }
+
+
+    /**
+     * Set the time at which the writing thread took this item.
+     * @param time time at which the writing thread took this item.
+     */
+    void RecordRingItem::setWriteStartTime(const std::chrono::steady_clock::time_point & time) {
+        writeStartTime = time;
+    }
+
 }
@@ -15,6 +15,7 @@
 #include <memory>
 #include <atomic>
 #include <functional>
+#include <chrono>
 
 
 #include "Disruptor/Sequence.h"
@@ -35,19 +36,6 @@ namespace evio {
 
     private:
 
-        // These static members are NOT THREAD SAFE! Fortunately, the chances that an
-        // application uses more than one RecordSupply is remote. The chances that
-        // their construction occurs at the same time is even more remote.
-
-        /** Byte order to be used by factory creating these RecordRingItems. */
-        static ByteOrder factoryByteOrder;
-        /** MaxEventCount to be used by factory creating these RecordRingItems. */
-        static int factoryMaxEventCount;
-        /** MaxBufferSize to be used by factory creating these RecordRingItems. */
-        static int factoryMaxBufferSize;
-        /** CompressionType to be used by factory creating these RecordRingItems. */
-        static Compressor::CompressionType factoryCompressionType;
-
         /** Assign each record a unique id for debugging purposes. */
         static uint64_t idValue;
 
@@ -61,8 +49,9 @@ namespace evio {
         /** Sequence at which this object was taken from ring by one of the "get" calls. */
         int64_t sequence = 0UL;
 
-        /** Sequence object allowing ring consumer to get/release this item. */
-        std::shared_ptr<Disruptor::ISequence> sequenceObj = nullptr;
+        /** Sequence object allowing ring consumer to get/release this item.
+         *  Owned by the supply, so it is not reference counted for each item. */
+        Disruptor::ISequence *sequenceObj = nullptr;
 
         /** Do we split a file after writing this record? */
         std::atomic<bool> splitFileAfterWriteBool{false};
@@ -86,17 +75,23 @@ namespace evio {
         /** We may want to track a particular record for debugging. */
         uint64_t id = 0;
 
+        /** Time at which the writing thread took this item, for measuring write latency. */
+        std::chrono::steady_clock::time_point writeStartTime;
+
 
     public:
 
 
         static const std::function< std::shared_ptr<RecordRingItem> () >& eventFactory();
 
-        static void setEventFactorySettings(ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
-                                            Compressor::CompressionType & compressionType);
+        static std::function< std::shared_ptr<RecordRingItem> () >
+                eventFactory(const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
+                             Compressor::CompressionType compressionType);
 
 
         RecordRingItem();
+        RecordRingItem(const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
+                       Compressor::CompressionType compressionType);
         RecordRingItem(const RecordRingItem & item);
         ~RecordRingItem() = default;
 
@@ -107,10 +102,10 @@ namespace evio {
         std::shared_ptr<RecordOutput> & getRecord();
         ByteOrder & getOrder();
         int64_t getSequence() const;
-        std::shared_ptr<Disruptor::ISequence> & getSequenceObj();
+        Disruptor::ISequence * getSequenceObj();
 
         void fromProducer(int64_t seq);
-        void fromConsumer(int64_t seq, std::shared_ptr<Disruptor::ISequence> & seqObj);
+        void fromConsumer(int64_t seq, Disruptor::ISequence *seqObj);
 
         bool splitFileAfterWrite();
         void splitFileAfterWrite(bool split);
@@ -130,6 +125,9 @@ namespace evio {
         uint64_t getId() const;
         void setId(uint64_t idVal);
 
+        const std::chrono::steady_clock::time_point & getWriteStartTime() const;
+        void setWriteStartTime(const std::chrono::steady_clock::time_point & time);
+
     };
 
 }
@@ -11,6 +11,8 @@
 
 #include "RecordSupply.h"
 
+#include <boost/thread.hpp>
+
 
 namespace evio {
 
@@ -35,16 +37,31 @@ namespace evio {
      * @param maxBufferSize   max number of uncompressed data bytes each record can hold.
      *                        Value of < 8MB results in default of 8MB.
      * @param compressionType type of data compression to do.
+     * @param multiProducer   if true, allow multiple threads to get, fill and publish
+     *                        records simultaneously.
+     * @param waitStrategy    how compression and writing threads wait for records.
+     * @param waitTimeout     if &gt; 0, max microseconds a blocking wait lasts before the
+     *                        waiting thread wakes up and waits again. Only used with
+     *                        {@link #BLOCKING} and {@link #SPIN_THEN_BLOCK}.
+     * @param passThrough     if true, and there's no compression, producers build records as they
+     *                        publish them and the writing thread takes them straight from producers.
+     *                        No compression threads are to be started.
      * @throws EvioException if args < 1, ringSize not power of 2,
-     *                                  threadCount > ringSize.
+     *                                  threadCount > ringSize, or passThrough with compression.
      */
     RecordSupply::RecordSupply(uint32_t ringSize, ByteOrder order,
                                uint32_t threadCount, uint32_t maxEventCount, uint32_t maxBufferSize,
-                               Compressor::CompressionType & compressionType) :
+                               Compressor::CompressionType & compressionType,
+                               bool multiProducer, WaitStrategyType waitStrategy, uint32_t waitTimeout,
+                               bool passThrough) :
 
             order(order), maxEventCount(maxEventCount), maxBufferSize(maxBufferSize),
-            compressionType(compressionType)
+            compressionType(compressionType), multiProducer(multiProducer),
+            passThrough(passThrough), waitStrategyType(waitStrategy)
     {
+        if (passThrough && compressionType != Compressor::UNCOMPRESSED) {
+            throw EvioException("pass-through supply cannot compress records");
+        }
 
         if (!Disruptor::Util::isPowerOf2(ringSize)) {
             throw EvioException("ringSize must be a power of 2");
@@ -60,47 +77,44 @@ namespace evio {
         }
 
         this->ringSize = ringSize;
+        compressorCounters.reset(new CompressorCounters[compressionThreadCount]);
+        activeCompressors = compressionThreadCount;
+
+        // Items of this supply are each made with these settings
+        auto factory = RecordRingItem::eventFactory(order, maxEventCount, maxBufferSize, compressionType);
 
-        // Set RecordRingItem static values to be used when eventFactory is creating RecordRingItem objects
-        RecordRingItem::setEventFactorySettings(order, maxEventCount, maxBufferSize, compressionType);
+        auto strategy = createWaitStrategy(waitStrategy, waitTimeout);
 
-        // Spin first then block
-        auto blockingStrategy = std::make_shared< Disruptor::BlockingWaitStrategy >();
-        auto waitStrategy = std::make_shared< Disruptor::SpinCountBackoffWaitStrategy >(10000, blockingStrategy);
         // Create ring buffer with "ringSize" # of elements
-        ringBuffer = Disruptor::RingBuffer<std::shared_ptr<RecordRingItem>>::createSingleProducer(
-                RecordRingItem::eventFactory(), ringSize, waitStrategy);
+        if (multiProducer) {
+            // Sequences are claimed with a CAS so any thread may be a producer
+            ringBuffer = Disruptor::RingBuffer<std::shared_ptr<RecordRingItem>>::createMultiProducer(
+                    factory, ringSize, strategy);
+        }
+        else {
+            ringBuffer = Disruptor::RingBuffer<std::shared_ptr<RecordRingItem>>::createSingleProducer(
+                    factory, ringSize, strategy);
+        }
 
-        // Thread which fills records is considered the "producer" and doesn't need a barrier
+        // Threads which fill records are considered "producers" and don't need a barrier
 
         // Barrier & sequences so record-COMPRESSING threads can get records.
         // This is the first group of consumers which all share the same barrier.
         compressBarrier = ringBuffer->newBarrier();
-        compressSeqs.reserve(compressionThreadCount);
-        nextCompressSeqs.reserve(compressionThreadCount);
-        availableCompressSeqs.reserve(compressionThreadCount);
-
-        for (int i=0; i < compressionThreadCount; i++) {
-            // Create seq with usual initial value
-            auto seq = std::make_shared<Disruptor::Sequence>(Disruptor::Sequence::InitialCursorValue);
-
-            // Each thread will get different records from each other.
-            // First thread gets 0, 2nd thread gets 1, etc.
-            int64_t firstSeqToGet = Disruptor::Sequence::InitialCursorValue + 1 + i;
-            nextCompressSeqs.push_back(firstSeqToGet);
-            // Release, in advance, records to be skipped next. Keeps things from hanging up.
-            if (i != 0) {
-                seq->setValue(firstSeqToGet - 1);
-            }
-            compressSeqs.push_back(seq);
-            // Initialize with -1's
-            availableCompressSeqs.push_back(-1);
+        // Create seq with usual initial value
+        compressSeqs.push_back(std::make_shared<Disruptor::Sequence>(Disruptor::Sequence::InitialCursorValue));
+        // Initialize with -1's
+        availableCompressSeqs.assign(compressionThreadCount, -1);
+        compressedSeqs.reset(new std::atomic<int64_t>[ringSize]);
+        for (uint32_t i=0; i < ringSize; i++) {
+            compressedSeqs[i] = -1;
         }
 
         // Barrier & sequence so a single record-WRITING thread can get records.
         // This barrier comes after all compressing threads and depends on them
-        // first releasing their records.
-        writeBarrier = ringBuffer->newBarrier(compressSeqs);
+        // first releasing their records. With no compression stage, it depends
+        // only on records being published.
+        writeBarrier = passThrough ? ringBuffer->newBarrier() : ringBuffer->newBarrier(compressSeqs);
         auto seq = std::make_shared<Disruptor::Sequence>(Disruptor::Sequence::InitialCursorValue);
         nextWriteSeq = Disruptor::Sequence::InitialCursorValue + 1;
         writeSeqs.push_back(seq);
@@ -111,6 +125,42 @@ namespace evio {
     }
 
 
+    /**
+     * Create a Disruptor wait strategy.
+     * @param type          type of wait strategy.
+     * @param timeoutMicros if &gt; 0, max microseconds a blocking wait lasts before the
+     *                      waiting thread wakes up. Only used with {@link #BLOCKING}
+     *                      and {@link #SPIN_THEN_BLOCK}.
+     * @return wait strategy.
+     */
+    std::shared_ptr<Disruptor::IWaitStrategy> RecordSupply::createWaitStrategy(WaitStrategyType type,
+                                                                               uint32_t timeoutMicros) {
+        std::shared_ptr<Disruptor::IWaitStrategy> blockingStrategy;
+        if (timeoutMicros > 0) {
+            blockingStrategy = std::make_shared< Disruptor::TimeoutBlockingWaitStrategy >(
+                                       std::chrono::microseconds(timeoutMicros));
+        }
+        else {
+            blockingStrategy = std::make_shared< Disruptor::BlockingWaitStrategy >();
+        }
+
+        switch (type) {
+            case BLOCKING:
+                return blockingStrategy;
+            case SLEEPING:
+                return std::make_shared< Disruptor::SleepingWaitStrategy >();
+            case YIELDING:
+                return std::make_shared< Disruptor::YieldingWaitStrategy >();
+            case BUSY_SPIN:
+                return std::make_shared< Disruptor::BusySpinWaitStrategy >();
+            case SPIN_THEN_BLOCK:
+            default:
+                // Spin first then block
+                return std::make_shared< Disruptor::SpinCountBackoffWaitStrategy >(10000, blockingStrategy);
+        }
+    }
+
+
     /**
      * Method to have sequence barriers throw a Disruptor's AlertException.
      * In this case, we can use it to warn write and compress threads which
@@ -139,6 +189,59 @@ namespace evio {
     uint32_t RecordSupply::getRingSize() {return ringSize;}
 
 
+    /**
+     * Can multiple threads get and publish records simultaneously?
+     * @return true if multiple threads can get and publish records simultaneously.
+     */
+    bool RecordSupply::isMultiProducer() const {return multiProducer;}
+
+
+    /**
+     * Are records built by producers as they're published and handed straight to the
+     * writing thread, with no compression threads?
+     * @return true if records skip the compression stage.
+     */
+    bool RecordSupply::isPassThrough() const {return passThrough;}
+
+
+    /**
+     * Get how threads wait for ring items.
+     * @return how threads wait for ring items.
+     */
+    RecordSupply::WaitStrategyType RecordSupply::getWaitStrategy() const {return waitStrategyType;}
+
+
+    /**
+     * Get the total time producers spent waiting in {@link #get()} for an empty record,
+     * which happens when all records are being compressed or written.
+     * @return total producer wait time in microseconds.
+     */
+    uint64_t RecordSupply::getProducerWaitTime() const {return producerWaitNanos / 1000;}
+
+
+    /**
+     * Get the total time compression threads spent waiting for records to compress.
+     * This is the sum over all compression threads.
+     * @return total compression thread wait time in microseconds.
+     */
+    uint64_t RecordSupply::getCompressWaitTime() const {return compressWaitNanos / 1000;}
+
+
+    /**
+     * Get the total time the writing thread spent waiting for records to write.
+     * @return total writing thread wait time in microseconds.
+     */
+    uint64_t RecordSupply::getWriteWaitTime() const {return writeWaitNanos / 1000;}
+
+
+    /** Set all accumulated wait times back to 0. */
+    void RecordSupply::resetWaitTimes() {
+        producerWaitNanos  = 0;
+        compressWaitNanos = 0;
+        writeWaitNanos    = 0;
+    }
+
+
     /**
      * Get the byte order of all records in this supply.
      * @return byte order of all records in this supply.
@@ -161,6 +264,8 @@ namespace evio {
 
     /**
      * Get the sequence of last ring buffer item published (seq starts at 0).
+     * If multi-producer, this is the last item taken by {@link #get()}
+     * which may not have been published yet.
      * @return sequence of last ring buffer item published (seq starts at 0).
      */
     int64_t RecordSupply::getLastSequence() {
@@ -168,20 +273,93 @@ namespace evio {
     }
 
 
+    /**
+     * Get the ring item at the given place in the ring buffer without claiming it.
+     * Only meant for looking at the items' resources before any thread uses the ring,
+     * (e.g. to register their buffers), not for handling data.
+     * @param index place in ring buffer (0 to ringSize - 1).
+     * @return ring item at the given place in the ring buffer.
+     * @throws EvioException if index >= ringSize.
+     */
+    std::shared_ptr<RecordRingItem> & RecordSupply::getRingItem(uint32_t index) {
+        if (index >= ringSize) {
+            throw EvioException("index must be < ringSize");
+        }
+        return (*ringBuffer.get())[index];
+    }
+
+
+    /**
+     * Write zeros into all buffers of the given compression thread's share of records.
+     * When called from a thread running on the same NUMA node as that compression thread,
+     * before the ring is used, this places the records' memory local to it.
+     * Their buffers are allocated anew first, since memory touched
+     * earlier (see {@link #touchRecords()}) would stay where it is.
+     * Since any thread may compress any record, this only spreads the records evenly
+     * over the nodes of the compression threads. Thread n's share is every Nth record
+     * starting with record n, where N is the number of compression threads.
+     * This is only done if N divides the ring size.
+     * @param threadNumber number of compression thread (0,1, ...).
+     * @return true if records were touched, false if N does not divide the ring size.
+     */
+    bool RecordSupply::touchRecords(uint32_t threadNumber) {
+        if (ringSize % compressionThreadCount != 0) {
+            return false;
+        }
+
+        // Pages already touched stay where they are, so start with new ones
+        for (uint32_t i = threadNumber; i < ringSize; i += compressionThreadCount) {
+            (*ringBuffer.get())[i]->getRecord()->touchBuffers(true);
+        }
+        return true;
+    }
+
+
+    /**
+     * Write zeros into all buffers of all records so that the OS maps their memory now,
+     * instead of each page faulting the first time a record fills that far.
+     * Meant to be called before the ring is used.
+     */
+    void RecordSupply::touchRecords() {
+        for (uint32_t i = 0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->touchBuffers();
+        }
+    }
+
+
+    /**
+     * Get the ring item of the given sequence, for handling the items
+     * of a batch obtained from {@link #get(uint32_t)},
+     * {@link #getToCompress(uint32_t, uint32_t, int64_t &)} or {@link #getToWrite(uint32_t, int64_t &)}.
+     * The caller must hold the claim on that sequence.
+     * @param sequence sequence of item.
+     * @return ring item of the given sequence.
+     */
+    std::shared_ptr<RecordRingItem> & RecordSupply::getItem(int64_t sequence) {
+        return (*ringBuffer.get())[sequence];
+    }
+
+
     /**
      * Get the next available record item from the ring buffer.
      * Use it to write data into the record.
+     * The returned reference is to the item's slot in the ring, which stays in place
+     * for the life of this object, so it may be held without copying the shared pointer.
      * @return next available record item in ring buffer in order to write data into it.
      */
-    std::shared_ptr<RecordRingItem> RecordSupply::get() {
+    const std::shared_ptr<RecordRingItem> & RecordSupply::get() {
         // Producer gets next available record
+        auto t1 = std::chrono::steady_clock::now();
         int64_t getSequence = ringBuffer->next();
+        producerWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - t1).count();
 
         // Get object in that position (sequence) of ring buffer
         std::shared_ptr<RecordRingItem> & bufItem = (*ringBuffer.get())[getSequence];
 
         // This reset does not change compression type, fileId, or header type
         bufItem->reset();
+        bufItem->getRecord()->setTargetRecordBytes(targetRecordBytes.load(std::memory_order_relaxed));
 
         // Store sequence for later releasing of record
         bufItem->fromProducer(getSequence);
@@ -190,49 +368,220 @@ namespace evio {
     }
 
 
+    /**
+     * Get a number of consecutive record items from the ring buffer, all claimed with
+     * one wait. Use them to write data into the records, then publish them all with
+     * {@link #publish(int64_t, uint32_t)}. Each is found with {@link #getItem(int64_t)}.
+     * Consumers can't have any of them until all are published.
+     * @param count number of items to get.
+     * @return sequence of the first item.
+     * @throws EvioException if count is 0 or larger than the ring.
+     */
+    int64_t RecordSupply::get(uint32_t count) {
+        if (count < 1 || count > ringSize) {
+            throw EvioException("count must be > 0 and <= ringSize");
+        }
+
+        auto t1 = std::chrono::steady_clock::now();
+        int64_t last = ringBuffer->next((int32_t)count);
+        producerWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - t1).count();
+
+        int64_t first = last - count + 1;
+        uint32_t target = targetRecordBytes.load(std::memory_order_relaxed);
+        for (int64_t seq = first; seq <= last; seq++) {
+            std::shared_ptr<RecordRingItem> & bufItem = (*ringBuffer.get())[seq];
+            bufItem->reset();
+            bufItem->getRecord()->setTargetRecordBytes(target);
+            bufItem->fromProducer(seq);
+        }
+
+        return first;
+    }
+
+
     /**
      * Tell consumers that the record item is ready for consumption.
      * To be used in conjunction with {@link #get()}.
      * @param item record item available for consumers' use.
      */
-    void RecordSupply::publish(std::shared_ptr<RecordRingItem> & item) {
+    void RecordSupply::publish(const std::shared_ptr<RecordRingItem> & item) {
+        if (passThrough) {
+            buildForWriter(item);
+        }
         ringBuffer->publish(item->getSequence());
+        if (publishListener) {
+            publishListener(item);
+        }
+    }
+
+
+    /**
+     * Tell consumers that a number of consecutive record items are ready for consumption.
+     * To be used in conjunction with {@link #get(uint32_t)}.
+     * @param first sequence of the first item.
+     * @param count number of items.
+     */
+    void RecordSupply::publish(int64_t first, uint32_t count) {
+        if (count < 1) return;
+
+        int64_t last = first + count - 1;
+        if (passThrough) {
+            for (int64_t seq = first; seq <= last; seq++) {
+                buildForWriter((*ringBuffer.get())[seq]);
+            }
+        }
+        ringBuffer->publish(first, last);
+        if (publishListener) {
+            for (int64_t seq = first; seq <= last; seq++) {
+                publishListener((*ringBuffer.get())[seq]);
+            }
+        }
+    }
+
+
+    /**
+     * In a pass-through supply, build a record in the producer's thread just before publishing
+     * it, doing what a compression thread would otherwise do. Records which are not compressed
+     * are quick to build, so this only adds a little to publishing.
+     * If building fails, as when a user's record processor throws, the writing
+     * thread is alerted as it would be by a compression thread.
+     * @param item item holding the record to build.
+     * @throws EvioException if record could not be built.
+     */
+    void RecordSupply::buildForWriter(const std::shared_ptr<RecordRingItem> & item) {
+        try {
+            item->getRecord()->build();
+        }
+        catch (std::exception & e) {
+            std::string err = std::string("error building record: ") + e.what();
+            setError(err);
+            haveError(true);
+            errorAlert();
+            throw EvioException(err);
+        }
+    }
+
+
+    /**
+     * Set a function to be called with each record published. A pool of compression
+     * threads shared by many supplies uses it to learn of records to compress,
+     * which it then releases with {@link #releaseCompressor(const std::shared_ptr<RecordRingItem> &)}.
+     * Only meant to be set before any record is published, or once the last has been.
+     * @param listener function called with each record published, or null for none.
+     */
+    void RecordSupply::setPublishListener(std::function<void(const std::shared_ptr<RecordRingItem> &)> listener) {
+        publishListener = std::move(listener);
     }
 
 
     /**
      * Get the next available record item from the ring buffer
      * in order to compress the data already in it.
+     * Records are handed out in order to whichever thread calls this next.
      * @param threadNumber number of thread (0,1, ...) used to compress.
      *                     This number cannot exceed (compressionThreadCount - 1).
      * @return next available record item in ring buffer
-     *         in order to compress data already in it.
+     *         in order to compress data already in it, or null if none could be had.
      * @throws Disruptor::AlertException  if {@link #errorAlert()} called.
      */
-    std::shared_ptr<RecordRingItem> RecordSupply::getToCompress(uint32_t threadNumber) {
+    const std::shared_ptr<RecordRingItem> & RecordSupply::getToCompress(uint32_t threadNumber) {
+
+        // Claim the next record no other compression thread has
+        int64_t seq = nextCompressSeq++;
 
         try  {
             // Only wait for read of volatile memory if necessary ...
-            if (availableCompressSeqs[threadNumber] < nextCompressSeqs[threadNumber]) {
-                // Return # of largest consecutively available item
-                availableCompressSeqs[threadNumber] = compressBarrier->waitFor(nextCompressSeqs[threadNumber]);
+            if (availableCompressSeqs[threadNumber] < seq) {
+                auto t1 = std::chrono::steady_clock::now();
+                while (true) {
+                    try {
+                        // Return # of largest consecutively available item
+                        availableCompressSeqs[threadNumber] = compressBarrier->waitFor(seq);
+                        break;
+                    }
+                    catch (Disruptor::TimeoutException & ex) {
+                        // Timeout wait strategy, just wait again
+                    }
+                }
+                compressWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - t1).count();
             }
 
             // Get the item since we know it's available
-            std::shared_ptr<RecordRingItem> & item = (*ringBuffer.get())[nextCompressSeqs[threadNumber]];
+            std::shared_ptr<RecordRingItem> & item = (*ringBuffer.get())[seq];
             // Store variables that will help free this item when release is called
-            item->fromConsumer(nextCompressSeqs[threadNumber], compressSeqs[threadNumber]);
-            // Set the next item we'll be trying to get.
-            // Note that different compression threads get different items.
-            nextCompressSeqs[threadNumber] += compressionThreadCount;
+            item->fromConsumer(seq, compressSeqs[0].get());
             return item;
         }
         catch (Disruptor::TimeoutException & ex) {
-            // Never happen since we don't use timeout wait strategy
+            // Never happen since timeouts are handled above
             std::cout << ex.message() << std::endl;
         }
 
-        return nullptr;
+        return noItem;
+    }
+
+
+    /**
+     * Get the record items available to compress, up to a given number, waiting only
+     * for the first. Each is found with {@link #getItem(int64_t)} and all are released
+     * with {@link #releaseCompressor(int64_t, uint32_t)}. So that other compression threads
+     * are not left idle, a thread only takes its share of the items available,
+     * split among the active compression threads, but always at least one.
+     * @param threadNumber number of thread (0,1, ...) used to compress.
+     *                     This number cannot exceed (compressionThreadCount - 1).
+     * @param maxCount     max number of items to get.
+     * @param first        filled with the sequence of the first item.
+     * @return number of items gotten, all with consecutive sequences.
+     * @throws Disruptor::AlertException  if {@link #errorAlert()} called.
+     */
+    uint32_t RecordSupply::getToCompress(uint32_t threadNumber, uint32_t maxCount, int64_t & first) {
+
+        if (maxCount < 1) maxCount = 1;
+
+        try  {
+            while (true) {
+                int64_t seq = nextCompressSeq.load();
+
+                // Wait for the first record, without claiming it yet
+                if (availableCompressSeqs[threadNumber] < seq) {
+                    auto t1 = std::chrono::steady_clock::now();
+                    while (true) {
+                        try {
+                            availableCompressSeqs[threadNumber] = compressBarrier->waitFor(seq);
+                            break;
+                        }
+                        catch (Disruptor::TimeoutException & ex) {
+                            // Timeout wait strategy, just wait again
+                        }
+                    }
+                    compressWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::steady_clock::now() - t1).count();
+                }
+
+                // Take this thread's share of what's available
+                int64_t share = (availableCompressSeqs[threadNumber] - seq + 1) / std::max<uint32_t>(1, activeCompressors.load());
+                uint32_t count = (uint32_t) std::max<int64_t>(1, std::min<int64_t>(maxCount, share));
+
+                // Claim them, unless another thread got there first
+                if (!nextCompressSeq.compare_exchange_weak(seq, seq + count)) {
+                    continue;
+                }
+
+                for (int64_t s = seq; s < seq + count; s++) {
+                    (*ringBuffer.get())[s]->fromConsumer(s, compressSeqs[0].get());
+                }
+                first = seq;
+                return count;
+            }
+        }
+        catch (Disruptor::TimeoutException & ex) {
+            // Never happen since timeouts are handled above
+            std::cout << ex.message() << std::endl;
+        }
+
+        return 0;
     }
 
 
@@ -240,44 +589,225 @@ namespace evio {
      * Get the next available record item from the ring buffer
      * in order to write data into it.
      * @return next available record item in ring buffer
-     *         in order to write data into it.
+     *         in order to write data into it, or null if none could be had.
      * @throws Disruptor::AlertException  if {@link #errorAlert()} called.
      */
-    std::shared_ptr<RecordRingItem> RecordSupply::getToWrite() {
+    const std::shared_ptr<RecordRingItem> & RecordSupply::getToWrite() {
 
         try  {
             if (availableWriteSeq < nextWriteSeq) {
-                availableWriteSeq = writeBarrier->waitFor(nextWriteSeq);
+                auto t1 = std::chrono::steady_clock::now();
+                while (true) {
+                    try {
+                        availableWriteSeq = writeBarrier->waitFor(nextWriteSeq);
+                        break;
+                    }
+                    catch (Disruptor::TimeoutException & ex) {
+                        // Timeout wait strategy, just wait again
+                    }
+                }
+                writeWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now() - t1).count();
             }
 
             std::shared_ptr<RecordRingItem> & item = ((*ringBuffer.get())[nextWriteSeq]);
-            item->fromConsumer(nextWriteSeq++, writeSeqs[0]);
+            item->fromConsumer(nextWriteSeq++, writeSeqs[0].get());
+            item->setWriteStartTime(std::chrono::steady_clock::now());
             return item;
         }
         catch (Disruptor::TimeoutException & ex) {
-            // Never happen since we don't use timeout wait strategy
+            // Never happen since timeouts are handled above
             std::cout << ex.message() << std::endl;
         }
 
-        return nullptr;
+        return noItem;
+    }
+
+
+    /**
+     * Get all record items available to write, up to a given number, waiting only
+     * for the first. Each is found with {@link #getItem(int64_t)} and all are released
+     * with {@link #releaseWriter(int64_t, uint32_t)}. Consecutive records can thus
+     * be written with one call.
+     * @param maxCount max number of items to get.
+     * @param first    filled with the sequence of the first item.
+     * @return number of items gotten, all with consecutive sequences.
+     * @throws Disruptor::AlertException  if {@link #errorAlert()} called.
+     */
+    uint32_t RecordSupply::getToWrite(uint32_t maxCount, int64_t & first) {
+
+        if (maxCount < 1) maxCount = 1;
+
+        try  {
+            if (availableWriteSeq < nextWriteSeq) {
+                auto t1 = std::chrono::steady_clock::now();
+                while (true) {
+                    try {
+                        availableWriteSeq = writeBarrier->waitFor(nextWriteSeq);
+                        break;
+                    }
+                    catch (Disruptor::TimeoutException & ex) {
+                        // Timeout wait strategy, just wait again
+                    }
+                }
+                writeWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now() - t1).count();
+            }
+
+            uint32_t count = (uint32_t) std::min<int64_t>(maxCount, availableWriteSeq - nextWriteSeq + 1);
+            auto now = std::chrono::steady_clock::now();
+
+            first = nextWriteSeq;
+            for (uint32_t i = 0; i < count; i++) {
+                std::shared_ptr<RecordRingItem> & item = (*ringBuffer.get())[nextWriteSeq];
+                item->fromConsumer(nextWriteSeq++, writeSeqs[0].get());
+                item->setWriteStartTime(now);
+            }
+            return count;
+        }
+        catch (Disruptor::TimeoutException & ex) {
+            // Never happen since timeouts are handled above
+            std::cout << ex.message() << std::endl;
+        }
+
+        return 0;
+    }
+
+
+    /**
+     * Account for the completed write of the given item, called when it's released.
+     * Write latency is the time from the writing thread taking the item to its release.
+     * @param item item whose write is complete.
+     */
+    void RecordSupply::writeDone(const std::shared_ptr<RecordRingItem> & item) {
+        uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - item->getWriteStartTime()).count();
+        recordsWritten++;
+        writeLatencyNanos += nanos;
+        lastWriteLatencyNanos = nanos;
+
+        uint64_t max = maxWriteLatencyNanos.load();
+        while (nanos > max && !maxWriteLatencyNanos.compare_exchange_weak(max, nanos)) {}
+    }
+
+
+    /**
+     * Add to the running totals of a compression thread.
+     * Called by the compression thread after building each record.
+     * @param threadNumber number of compression thread (0,1, ...).
+     * @param nanos        time taken to compress record in nanoseconds.
+     * @param bytesIn      uncompressed size of record.
+     * @param bytesOut     compressed size of record including its header.
+     */
+    void RecordSupply::addCompressionStats(uint32_t threadNumber, uint64_t nanos,
+                                           uint32_t bytesIn, uint32_t bytesOut) {
+        if (threadNumber >= compressionThreadCount) return;
+
+        CompressorCounters & c = compressorCounters[threadNumber];
+        c.busyNanos += nanos;
+        c.bytesIn   += bytesIn;
+        c.bytesOut  += bytesOut;
+        c.records++;
+    }
+
+
+    /**
+     * Fill in the ring, compression, write and wait values of the given metrics.
+     * This may be called from any thread. Since values are read while changing,
+     * counts of records in the various stages are approximate.
+     * @param metrics object in which to place values.
+     */
+    void RecordSupply::getMetrics(WriterMetrics & metrics) const {
+        metrics.ringSize = ringSize;
+
+        if (ringBuffer == nullptr || compressorCounters == nullptr) return;
+
+        // Sequences of the last record filled, compressed (with all before it) and written
+        int64_t filled  = ringBuffer->cursor();
+        int64_t written = writeSeqs.empty() ? filled : writeSeqs[0]->value();
+        int64_t compressed = filled;
+        for (auto & seq : compressSeqs) {
+            compressed = std::min(compressed, seq->value());
+        }
+        compressed = passThrough ? filled : std::max(compressed, written);
+
+        metrics.ringOccupancy     = (uint32_t) std::max((int64_t)0, filled - written);
+        metrics.waitingToCompress = (uint32_t) std::max((int64_t)0, filled - compressed);
+        metrics.waitingToWrite    = (uint32_t) (compressed - written);
+
+        uint64_t in = 0, out = 0;
+        uint32_t compressors = passThrough ? 0 : compressionThreadCount;
+        metrics.compressors.resize(compressors);
+        for (uint32_t i=0; i < compressors; i++) {
+            CompressorCounters & c = compressorCounters[i];
+            WriterMetrics::CompressorStats & stats = metrics.compressors[i];
+            stats.busyTime = c.busyNanos / 1000;
+            stats.bytesIn  = c.bytesIn;
+            stats.bytesOut = c.bytesOut;
+            stats.records  = c.records;
+            in  += stats.bytesIn;
+            out += stats.bytesOut;
+        }
+        metrics.compressionRatio = in > 0 ? (double)out / (double)in : 0.;
+
+        metrics.recordsWritten   = recordsWritten;
+        metrics.lastWriteLatency = lastWriteLatencyNanos / 1000;
+        metrics.maxWriteLatency  = maxWriteLatencyNanos / 1000;
+        metrics.avgWriteLatency  = metrics.recordsWritten > 0 ?
+                                   writeLatencyNanos / 1000 / metrics.recordsWritten : 0;
+
+        metrics.producerWaitTime = getProducerWaitTime();
+        metrics.compressWaitTime = getCompressWaitTime();
+        metrics.writeWaitTime    = getWriteWaitTime();
+        metrics.diskFull         = diskFull;
+
+        metrics.activeCompressors = activeCompressors;
+        metrics.targetRecordBytes = targetRecordBytes;
     }
 
 
     /**
      * A compressing thread releases its claim on the given ring buffer item
      * so it becomes available for use by writing thread behind the write barrier.
-     * Because a compressing thread gets only every Nth record where
-     * N = compressionThreadCount, once it releases this record it also
-     * needs to release all events coming after, up until the one it will
-     * take next. In other words, also release the records it will skip over
-     * next. This allows close() to be called at any time without things
-     * hanging up.<p>
+     * Records may be released out of order since a small one may be compressed
+     * sooner than a larger one claimed before it. The writing thread only gets
+     * a record once it and all records before it have been released.<p>
      *
      * To be used in conjunction with {@link #getToCompress(uint32_t)}.
      * @param item item in ring buffer to release for reuse.
      */
-    void RecordSupply::releaseCompressor(std::shared_ptr<RecordRingItem> & item) {
-        item->getSequenceObj()->setValue(item->getSequence() + compressionThreadCount - 1);
+    void RecordSupply::releaseCompressor(const std::shared_ptr<RecordRingItem> & item) {
+        int64_t seq = item->getSequence();
+        compressedSeqs[seq & (ringSize - 1)].store(seq, std::memory_order_release);
+        compressedUpTo();
+    }
+
+
+    /**
+     * A compressing thread releases its claim on a number of consecutive ring buffer items
+     * so they become available for use by writing thread behind the write barrier.
+     * To be used in conjunction with {@link #getToCompress(uint32_t, uint32_t, int64_t &)}.
+     * @param first sequence of the first item.
+     * @param count number of items.
+     */
+    void RecordSupply::releaseCompressor(int64_t first, uint32_t count) {
+        if (count < 1) return;
+
+        for (int64_t seq = first; seq < first + count; seq++) {
+            compressedSeqs[seq & (ringSize - 1)].store(seq, std::memory_order_release);
+        }
+        compressedUpTo();
+    }
+
+
+    /** Move the compression sequence past all records compressed in a row. */
+    void RecordSupply::compressedUpTo() {
+        std::lock_guard<std::mutex> lock(compressMutex);
+        int64_t next = compressSeqs[0]->value() + 1;
+        while (compressedSeqs[next & (ringSize - 1)].load(std::memory_order_acquire) == next) {
+            next++;
+        }
+        compressSeqs[0]->setValue(next - 1);
     }
 
 
@@ -290,13 +820,14 @@ namespace evio {
      * This method may only be called if the writing is done IN THE SAME THREAD
      * as the calling of this method so that items are released in sequence
      * as ensured by the caller.
-     * Otherwise use {@link #releaseWriter(std::shared_ptr<RecordRingItem> &)}.
+     * Otherwise use {@link #releaseWriter(const std::shared_ptr<RecordRingItem> &)}.
      *
      * @param item item in ring buffer to release for reuse.
      * @return false if item not released or item is null, else true.
      */
-    bool RecordSupply::releaseWriterSequential(std::shared_ptr<RecordRingItem> & item) {
+    bool RecordSupply::releaseWriterSequential(const std::shared_ptr<RecordRingItem> & item) {
         if (item == nullptr || item->isAlreadyReleased()) return false;
+        writeDone(item);
         item->getSequenceObj()->setValue(item->getSequence());
         return true;
     }
@@ -329,57 +860,74 @@ namespace evio {
      * @param item item in ring buffer to release for reuse.
      * @return false if item or released since item is null, else true.
      */
-    bool RecordSupply::releaseWriter(std::shared_ptr<RecordRingItem> & item) {
+    bool RecordSupply::releaseWriter(const std::shared_ptr<RecordRingItem> & item) {
 
         if (item == nullptr || item->isAlreadyReleased()) {
             //cout << "RecordSupply: item already released!" << endl;
             return false;
         }
 
+        writeDone(item);
+
         supplyMutex.lock();
-        {
-            int64_t seq = item->getSequence();
-
-            // If we got a new max ...
-            if (seq > maxSequence) {
-                // If the old max was > the last released ...
-                if (maxSequence > lastSequenceReleased) {
-                    // we now have another sequence between last released & new max
-                    between++;
-                }
+        writtenUpTo(item->getSequence());
+        supplyMutex.unlock();
 
-                // Set the new max
-                maxSequence = seq;
-            }
-                // If we're < max and > last, then we're in between
-            else if (seq > lastSequenceReleased) {
-                between++;
-            }
+        return true;
+    }
 
-            // If we now have everything between last & max, release it all.
-            // This way higher sequences are never released before lower.
-            if ((maxSequence - lastSequenceReleased - 1L) == between) {
-                item->getSequenceObj()->setValue(maxSequence);
-                lastSequenceReleased = maxSequence;
-                between = 0;
-            }
+
+    /**
+     * A writer thread releases its claim on a number of consecutive ring buffer items
+     * so they become available for reuse by the producer. As with
+     * {@link #releaseWriter(const std::shared_ptr<RecordRingItem> &)}, items are only released in sequence,
+     * so batches may be released out of order. Items already released are skipped.
+     * To be used in conjunction with {@link #getToWrite(uint32_t, int64_t &)}.
+     * @param first sequence of the first item.
+     * @param count number of items.
+     */
+    void RecordSupply::releaseWriter(int64_t first, uint32_t count) {
+        supplyMutex.lock();
+        for (int64_t seq = first; seq < first + count; seq++) {
+            std::shared_ptr<RecordRingItem> & item = (*ringBuffer.get())[seq];
+            if (item->isAlreadyReleased()) continue;
+            writeDone(item);
+            writtenUpTo(seq);
         }
         supplyMutex.unlock();
-
-        return true;
     }
 
 
     /**
-     * Release claim on ring items up to sequenceNum for the given compressor thread.
-     * For internal use only - to free up records that the compressor thread will skip
-     * over anyway.
-     * @param threadNum    compressor thread number.
-     * @param sequenceNum  sequence to release.
+     * Account for the write of the record of the given sequence and release, for reuse
+     * by the producer, all records written in a row up to it.
+     * Higher sequences are thus never released before lower.
+     * Must be called with supplyMutex held.
+     * @param seq sequence of the record written.
      */
-    void RecordSupply::release(uint32_t threadNum, int64_t sequenceNum) {
-        if (sequenceNum < 0) return;
-        compressSeqs[threadNum]->setValue(sequenceNum);
+    void RecordSupply::writtenUpTo(int64_t seq) {
+        // If we got a new max ...
+        if (seq > maxSequence) {
+            // If the old max was > the last released ...
+            if (maxSequence > lastSequenceReleased) {
+                // we now have another sequence between last released & new max
+                between++;
+            }
+
+            // Set the new max
+            maxSequence = seq;
+        }
+            // If we're < max and > last, then we're in between
+        else if (seq > lastSequenceReleased) {
+            between++;
+        }
+
+        // If we now have everything between last & max, release it all.
+        if ((maxSequence - lastSequenceReleased - 1L) == between) {
+            writeSeqs[0]->setValue(maxSequence);
+            lastSequenceReleased = maxSequence;
+            between = 0;
+        }
     }
 
 
@@ -437,6 +985,269 @@ namespace evio {
      */
     void RecordSupply::setDiskFull(bool full) {diskFull.store(full);}
 
-}
 
+    /**
+     * Set adaptive compression for all records in this supply.
+     * Only meant to be called before any thread uses the ring.
+     * A record whose compressed data are larger than maxRatio times its uncompressed
+     * data is stored uncompressed (see {@link RecordOutput#setMaxCompressionRatio(float)}).
+     * Once the ring's fill level reaches fillLevel percent, the compression threads switch
+     * to the fastest lz4 compression, and switch back to the original compression type
+     * once the fill level has dropped to half of that.
+     *
+     * @param maxRatio  largest allowed ratio of compressed to uncompressed size
+     *                  (e.g. 0.9), &lt;= 0 for no limit.
+     * @param fillLevel ring fill level in percent at which to compress with the fastest lz4,
+     *                  0 for never.
+     */
+    void RecordSupply::setAdaptiveCompression(float maxRatio, uint32_t fillLevel) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setMaxCompressionRatio(maxRatio);
+        }
+        fastCompressionFillLevel.store(fillLevel > 100 ? 100 : fillLevel);
+        compressingFast.store(false);
+    }
+
+
+    /**
+     * Store a filter of the tags and nums of its events in the header of each
+     * record built (see {@link RecordOutput#setTagFilter(bool)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param filter true if a tag filter is to be stored in each record's header.
+     */
+    void RecordSupply::setTagFilter(bool filter) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setTagFilter(filter);
+        }
+    }
+
+
+    /**
+     * Store a CRC32C of its data in the header of each record built
+     * (see {@link RecordOutput#setChecksum(bool)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param sum true if a checksum is to be stored in each record's header.
+     */
+    void RecordSupply::setChecksum(bool sum) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setChecksum(sum);
+        }
+    }
+
+
+    /**
+     * Store the range of its events' timestamps in the header of each record built
+     * (see {@link RecordOutput#setTimestampExtractor(RecordOutput::TimestampExtractor)}).
+     * The callback is called by the compression threads, so it must be thread safe.
+     * Only meant to be called before any thread uses the ring.
+     * @param extractor callback finding the timestamp of an event, empty to store none.
+     */
+    void RecordSupply::setTimestampExtractor(RecordOutput::TimestampExtractor const & extractor) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setTimestampExtractor(extractor);
+        }
+    }
+
+
+    /**
+     * Run a user stage on the events of each record as it is built, before it is compressed
+     * (see {@link RecordOutput#setRecordProcessor(RecordOutput::RecordProcessor)}), which may
+     * drop, rewrite or add events. Since the compression threads build the records, this work
+     * is spread over them instead of being done by the producer.
+     * The callback is called by several threads at once, so it must be thread safe.
+     * Only meant to be called before any thread uses the ring.
+     * @param processor callback run on each record's events, empty for none.
+     */
+    void RecordSupply::setRecordProcessor(RecordOutput::RecordProcessor const & processor) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setRecordProcessor(processor);
+        }
+    }
+
+
+    /**
+     * Compress each lz4 record built as independent blocks, so single events can be read
+     * without decompressing the whole record
+     * (see {@link RecordOutput#setSeekableCompression(uint32_t)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param blockSize uncompressed bytes in each block, 0 for ordinary records.
+     */
+    void RecordSupply::setSeekableCompression(uint32_t blockSize) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setSeekableCompression(blockSize);
+        }
+    }
+
+
+    /**
+     * Rearrange the data of each compressed record built, before compressing it,
+     * so it compresses better (see {@link RecordOutput#setPreFilter(Compressor::PreFilter)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param filter filter to apply, NO_FILTER for none.
+     */
+    void RecordSupply::setPreFilter(Compressor::PreFilter filter) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setPreFilter(filter);
+        }
+    }
+
+
+    /**
+     * Set whether the banks of each compressed record built are grouped by column
+     * (see {@link RecordOutput#setColumnLayout(bool)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param byColumn true to group banks by column.
+     */
+    void RecordSupply::setColumnLayout(bool byColumn) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setColumnLayout(byColumn);
+        }
+    }
+
+
+    /**
+     * Compress each record built starting from a trained dictionary
+     * (see {@link RecordOutput#setCompressionDictionary(std::shared_ptr<CompressionDictionary>)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param dict trained compression dictionary, or null for none.
+     */
+    void RecordSupply::setCompressionDictionary(const std::shared_ptr<CompressionDictionary> & dict) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setCompressionDictionary(dict);
+        }
+    }
+
+
+    /**
+     * Build uncompressed records so they're written by gathering their parts instead of
+     * first copying them together (see {@link RecordOutput#setGatherOutput(bool)}).
+     * Since a ring item is not reused until released by its writer, the parts stay
+     * untouched while being written.
+     * Only meant to be called before any thread uses the ring.
+     * @param gather true if uncompressed records are to be written by gathering their parts.
+     */
+    void RecordSupply::setGatherOutput(bool gather) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setGatherOutput(gather);
+        }
+    }
+
+
+    /**
+     * Count event sizes and record fill of all records in the ring in the given object
+     * (see {@link RecordOutput#setFillStats(RecordFillStats *)}).
+     * Only meant to be called before any thread uses the ring.
+     * @param stats object counting event sizes and record fill, or null for none.
+     */
+    void RecordSupply::setFillStats(RecordFillStats * stats) {
+        for (uint32_t i=0; i < ringSize; i++) {
+            (*ringBuffer.get())[i]->getRecord()->setFillStats(stats);
+        }
+    }
+
+
+    /**
+     * Should the next record be compressed with the fastest lz4 because records are
+     * backing up in the ring? Called by each compression thread before compressing a record.
+     * @return true if the next record should be compressed with the fastest lz4.
+     */
+    bool RecordSupply::useFastCompression() {
+        uint32_t level = fastCompressionFillLevel.load();
+        if (level == 0) {
+            return false;
+        }
 
+        uint64_t fill = getFillLevel();
+        if (fill >= level) {
+            compressingFast.store(true);
+        }
+        else if (fill <= level/2) {
+            compressingFast.store(false);
+        }
+        return compressingFast.load();
+    }
+
+
+
+    /**
+     * Get the max number of uncompressed data bytes each record holds unless
+     * expanded for a single large event.
+     * @return max number of uncompressed data bytes of each record.
+     */
+    uint32_t RecordSupply::getMaxBufferSize() const {
+        return std::max(maxBufferSize, (uint32_t)(8*RecordOutput::ONE_MEG));
+    }
+
+
+    /**
+     * Get the number of compression threads this supply was made for.
+     * @return number of compression threads.
+     */
+    uint32_t RecordSupply::getCompressionThreadCount() const {return compressionThreadCount;}
+
+
+    /**
+     * Get the number of compression threads currently allowed to compress.
+     * @return number of active compression threads.
+     */
+    uint32_t RecordSupply::getActiveCompressors() const {return activeCompressors;}
+
+
+    /**
+     * Set the number of compression threads allowed to compress. Threads numbered
+     * count and above are parked once done with their current record and use no CPU
+     * until allowed again. Since records go to whichever active thread asks next,
+     * this may be changed at any time while writing.
+     * @param count number of active compression threads, limited to 1 up to the number of threads.
+     */
+    void RecordSupply::setActiveCompressors(uint32_t count) {
+        count = std::max(1U, std::min(count, compressionThreadCount));
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            activeCompressors = count;
+        }
+        parkCond.notify_all();
+    }
+
+
+    /**
+     * Called by a compression thread before asking for a record to compress.
+     * If the thread is parked, wait until it's allowed to compress again.
+     * Since it has not yet claimed a record, it holds up no others while parked.
+     * The wait is a boost interruption point so the thread can still be stopped.
+     * @param threadNumber number of compression thread (0,1, ...).
+     * @throws boost::thread_interrupted if thread is interrupted while parked.
+     */
+    void RecordSupply::waitWhileParked(uint32_t threadNumber) {
+        if (threadNumber < activeCompressors.load(std::memory_order_relaxed)) return;
+
+        auto t1 = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(parkMutex);
+        while (threadNumber >= activeCompressors) {
+            // Wake up now and then to see if thread is being stopped
+            parkCond.wait_for(lock, std::chrono::milliseconds(100));
+            lock.unlock();
+            boost::this_thread::interruption_point();
+            lock.lock();
+        }
+        compressWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - t1).count();
+    }
+
+
+    /**
+     * Get the target size given to each record as it's taken by a producer.
+     * @return target size in bytes, 0 if records fill their memory.
+     */
+    uint32_t RecordSupply::getTargetRecordBytes() const {return targetRecordBytes;}
+
+
+    /**
+     * Set the target size given to each record as it's taken by a producer
+     * (see {@link RecordOutput#setTargetRecordBytes(uint32_t)}). Records already taken keep theirs.
+     * Since it's only handed to records in {@link #get()}, this may be changed at any time while writing.
+     * @param bytes target size in bytes, 0 for records to fill their memory.
+     */
+    void RecordSupply::setTargetRecordBytes(uint32_t bytes) {targetRecordBytes = bytes;}
+
+}
@@ -17,11 +17,16 @@
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <functional>
 
 
 #include "ByteOrder.h"
 #include "Compressor.h"
 #include "RecordRingItem.h"
+#include "WriterMetrics.h"
 #include "EvioException.h"
 #include "Disruptor/Util.h"
 #include "Disruptor/Sequence.h"
@@ -30,6 +35,11 @@
 #include "Disruptor/ISequenceBarrier.h"
 #include "Disruptor/TimeoutException.h"
 #include "Disruptor/SpinCountBackoffWaitStrategy.h"
+#include "Disruptor/BlockingWaitStrategy.h"
+#include "Disruptor/TimeoutBlockingWaitStrategy.h"
+#include "Disruptor/SleepingWaitStrategy.h"
+#include "Disruptor/YieldingWaitStrategy.h"
+#include "Disruptor/BusySpinWaitStrategy.h"
 
 
 namespace evio {
@@ -40,19 +50,28 @@ namespace evio {
      * of RecordRingItems which are reused (using Disruptor software package).<p>
      *
      * It is a supply of RecordRingItems in which a single producer does a {@link #get()},
-     * fills the record with data, and finally does a {@link #publish(std::shared_ptr<RecordRingItem> &)}
-     * to let consumers know the data is ready.<p>
+     * fills the record with data, and finally does a {@link #publish(const std::shared_ptr<RecordRingItem> &)}
+     * to let consumers know the data is ready. If created for multiple producers, any number of
+     * threads may simultaneously get, fill and publish their own records. Each claims its ring
+     * sequence without locking and records are consumed in the order they were claimed.<p>
+     *
+     * Records may also be handled in batches of consecutive sequences. A producer may claim
+     * several records at once with {@link #get(uint32_t)} and publish them all with
+     * {@link #publish(int64_t, uint32_t)}. Consumers may take all records already available
+     * with {@link #getToCompress(uint32_t, uint32_t, int64_t &)} or {@link #getToWrite(uint32_t, int64_t &)},
+     * waiting only for the first, and release them together. Each item of a batch is
+     * found with {@link #getItem(int64_t)}.<p>
      *
      * This class is setup to handle 2 types of consumers.
      * The first type is a thread which compresses a record's data.
      * The number of such consumers is set in the constructor.
      * Each of these will call {@link #getToCompress(uint32_t)} to get a record
-     * and eventually call {@link #releaseCompressor(std::shared_ptr<RecordRingItem> &)} to indicate it is
+     * and eventually call {@link #releaseCompressor(const std::shared_ptr<RecordRingItem> &)} to indicate it is
      * finished compressing and the record is available for writing to disk.<p>
      *
      * The second type of consumer is a single thread which writes all compressed
      * records to a file. This will call {@link #getToWrite()} to get a record
-     * and eventually call {@link #releaseWriter(std::shared_ptr<RecordRingItem> &)} to indicate it is
+     * and eventually call {@link #releaseWriter(const std::shared_ptr<RecordRingItem> &)} to indicate it is
      * finished writing and the record is available for being filled with new data.<p>
      *
      * Due to the multithreaded nature of writing files using this class, a mechanism
@@ -61,7 +80,16 @@ namespace evio {
      * compression or write threads that an error has occurred. That way these threads
      * can clean up and exit.<p>
      *
-     * It transparently makes sure that all records are written in the proper order.
+     * It transparently makes sure that all records are written in the proper order.<p>
+     *
+     * If created as a pass-through supply, for records which are not compressed, there is
+     * no compression stage. Each producer builds its own record when publishing it, and the
+     * writing thread gets records straight from the producers, its barrier depending only on
+     * the ring's cursor. No compression threads may then be used.<p>
+     *
+     * How idle compression and writing threads wait for records is set by the
+     * constructor's wait strategy. The time each type of thread spends waiting
+     * is accumulated so the choice can be tuned.
      *
      * <pre><code>
      *
@@ -74,6 +102,9 @@ namespace evio {
      *       compress its data. There may be any number of compression threads
      *       as long as <b># threads <= # of ring items!!!</b>.
      *       That same user does a releaseCompressor() when done with the record.
+     *       Each record goes to whichever compression thread asks for one next, so a thread
+     *       slowed by a large record holds up no others. Records may finish compressing
+     *       out of order, but only pass the compressBarrier once all before them have.
      *
      *   (3) The consumer who calls getToWrite() will get that ring item and will
      *       write its data to a file or another buffer. There may be only 1
@@ -100,6 +131,25 @@ namespace evio {
      */
     class RecordSupply {
 
+    public:
+
+        /** How threads wait for a ring item to become available. */
+        enum WaitStrategyType {
+            /** Spin 10000 times, then block (default). */
+            SPIN_THEN_BLOCK = 0,
+            /** Block on a condition variable, uses least CPU. */
+            BLOCKING,
+            /** Spin, then yield, then sleep briefly. */
+            SLEEPING,
+            /** Spin, then yield the thread. */
+            YIELDING,
+            /** Busy spin, lowest latency but uses a full core per waiting thread. */
+            BUSY_SPIN
+        };
+
+        static std::shared_ptr<Disruptor::IWaitStrategy> createWaitStrategy(WaitStrategyType type,
+                                                                            uint32_t timeoutMicros = 0);
+
     private:
 
         /** Mutex for thread safety when setting error code or releasing resources. */
@@ -114,17 +164,58 @@ namespace evio {
         /** Max number of uncompressed data bytes each record can hold.
          *  Value of < 8MB results in default of 8MB. */
         uint32_t maxBufferSize = 0;
-        /** Type type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip). */
+        /** Type type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd). */
         Compressor::CompressionType compressionType {Compressor::UNCOMPRESSED};
         /** Number of threads doing compression simultaneously. */
         uint32_t compressionThreadCount = 1;
         /** Number of records held in this supply. */
         uint32_t ringSize = 0;
+        /** Can multiple threads get and publish records simultaneously? */
+        bool multiProducer = false;
+
+        /** Are records built by producers and handed straight to the writing thread? */
+        bool passThrough = false;
+        /** How threads wait for ring items. */
+        WaitStrategyType waitStrategyType = SPIN_THEN_BLOCK;
+
+        // Time spent waiting, in nanoseconds
+
+        /** Time producers spent waiting for an empty record in {@link #get()}. */
+        std::atomic<uint64_t> producerWaitNanos{0};
+        /** Time compression threads spent waiting for a record to compress. */
+        std::atomic<uint64_t> compressWaitNanos{0};
+        /** Time the writing thread spent waiting for a record to write. */
+        std::atomic<uint64_t> writeWaitNanos{0};
+
+        // Metrics
+
+        /** Running totals of a single compression thread. */
+        struct CompressorCounters {
+            std::atomic<uint64_t> busyNanos{0};
+            std::atomic<uint64_t> bytesIn{0};
+            std::atomic<uint64_t> bytesOut{0};
+            std::atomic<uint64_t> records{0};
+        };
+
+        /** Running totals, one per compression thread. */
+        std::unique_ptr<CompressorCounters[]> compressorCounters;
+
+        /** Number of records whose write has completed. */
+        std::atomic<uint64_t> recordsWritten{0};
+        /** Total time from the writing thread taking records to their release. */
+        std::atomic<uint64_t> writeLatencyNanos{0};
+        /** Write latency of the most recently released record. */
+        std::atomic<uint64_t> lastWriteLatencyNanos{0};
+        /** Longest write latency of any record. */
+        std::atomic<uint64_t> maxWriteLatencyNanos{0};
 
 
         /** Ring buffer. Variable ringSize needs to be defined first. */
         std::shared_ptr<Disruptor::RingBuffer<std::shared_ptr<RecordRingItem>>> ringBuffer = nullptr;
 
+        /** Returned by the "get" calls instead of a ring slot if no item could be had. */
+        const std::shared_ptr<RecordRingItem> noItem;
+
 
         // Stuff for reporting errors
 
@@ -139,19 +230,47 @@ namespace evio {
          * due to the disk partition being full. */
         std::atomic<bool> diskFull{false};
 
+        //---------------------------------
+        // Adaptive compression
+        //---------------------------------
+
+        /** Ring fill level (percent) at or above which records are compressed
+         *  with the fastest lz4. Value of 0 means never. */
+        std::atomic<uint32_t> fastCompressionFillLevel{0};
+
+        /** Are records currently being compressed with the fastest lz4 due to a backlog? */
+        std::atomic<bool> compressingFast{false};
+
+        //---------------------------------
+        // Auto-tuning
+        //---------------------------------
+
+        /** Number of compression threads allowed to compress, the others are parked. */
+        std::atomic<uint32_t> activeCompressors{1};
+        /** Guards parking and unparking compression threads. */
+        std::mutex parkMutex;
+        /** Wakes parked compression threads. */
+        std::condition_variable parkCond;
+        /** Target size handed to each record as it's taken by a producer, 0 for none. */
+        std::atomic<uint32_t> targetRecordBytes{0};
+
         // Stuff for compression threads
 
         /** Ring barrier to prevent records from being used by write thread
          *  before compression threads release them. */
         std::shared_ptr<Disruptor::ISequenceBarrier> compressBarrier;
-        /** Sequences for compressing data, one per compression thread. */
+        /** Sequence of the last record which, along with all before it, has been compressed.
+         *  Only one, shared by all compression threads. */
         std::vector<std::shared_ptr<Disruptor::ISequence>> compressSeqs;
-        /** Array of next sequences (index of next item desired),
-         *  one per compression thread. */
-        std::vector<int64_t> nextCompressSeqs;
+        /** Next sequence (index of next item) to be claimed by any compression thread. */
+        std::atomic<int64_t> nextCompressSeq{0};
         /** Array of available sequences (largest index of sequentially available items),
          *  one per compression thread. */
         std::vector<int64_t> availableCompressSeqs;
+        /** For each place in the ring, the sequence of the last record compressed there. */
+        std::unique_ptr<std::atomic<int64_t>[]> compressedSeqs;
+        /** Guards moving compressSeqs past records compressed out of order. */
+        std::mutex compressMutex;
 
         // Stuff for writing thread
 
@@ -176,6 +295,16 @@ namespace evio {
         uint32_t between = 0;
 
 
+        /** If set, called with each record published, for compressing by a shared pool
+         *  (see {@link CompressionExecutor}) instead of this supply's own compression threads. */
+        std::function<void(const std::shared_ptr<RecordRingItem> &)> publishListener;
+
+
+        void writeDone(const std::shared_ptr<RecordRingItem> & item);
+        void compressedUpTo();
+        void writtenUpTo(int64_t seq);
+        void buildForWriter(const std::shared_ptr<RecordRingItem> & item);
+
     public:
 
         RecordSupply();
@@ -183,12 +312,14 @@ namespace evio {
         RecordSupply(const RecordSupply & supply) = delete;
         RecordSupply(uint32_t ringSize, ByteOrder order,
                      uint32_t threadCount, uint32_t maxEventCount, uint32_t maxBufferSize,
-                     Compressor::CompressionType & compressionType);
+                     Compressor::CompressionType & compressionType,
+                     bool multiProducer = false,
+                     WaitStrategyType waitStrategy = SPIN_THEN_BLOCK,
+                     uint32_t waitTimeout = 0,
+                     bool passThrough = false);
 
         ~RecordSupply() {
             compressSeqs.clear();
-            nextCompressSeqs.clear();
-            nextCompressSeqs.clear();
             availableCompressSeqs.clear();
             writeSeqs.clear();
             ringBuffer.reset();
@@ -198,19 +329,40 @@ namespace evio {
 
         uint32_t getMaxRingBytes();
         uint32_t getRingSize();
+        bool isMultiProducer() const;
+        bool isPassThrough() const;
+        WaitStrategyType getWaitStrategy() const;
+        uint64_t getProducerWaitTime() const;
+        uint64_t getCompressWaitTime() const;
+        uint64_t getWriteWaitTime() const;
+        void resetWaitTimes();
+        bool touchRecords(uint32_t threadNumber);
+        void touchRecords();
+
+        void addCompressionStats(uint32_t threadNumber, uint64_t nanos, uint32_t bytesIn, uint32_t bytesOut);
+        void getMetrics(WriterMetrics & metrics) const;
         ByteOrder & getOrder();
         uint64_t getFillLevel();
         int64_t getLastSequence();
-
-        std::shared_ptr<RecordRingItem> get();
-        void publish(std::shared_ptr<RecordRingItem> & item);
-        std::shared_ptr<RecordRingItem> getToCompress(uint32_t threadNumber);
-        std::shared_ptr<RecordRingItem> getToWrite();
-
-        void releaseCompressor(std::shared_ptr<RecordRingItem> & item);
-        bool releaseWriterSequential(std::shared_ptr<RecordRingItem> & item);
-        bool releaseWriter(std::shared_ptr<RecordRingItem> & item);
-        void release(uint32_t threadNum, int64_t sequenceNum);
+        std::shared_ptr<RecordRingItem> & getRingItem(uint32_t index);
+
+        std::shared_ptr<RecordRingItem> & getItem(int64_t sequence);
+
+        const std::shared_ptr<RecordRingItem> & get();
+        int64_t get(uint32_t count);
+        void publish(const std::shared_ptr<RecordRingItem> & item);
+        void publish(int64_t first, uint32_t count);
+        void setPublishListener(std::function<void(const std::shared_ptr<RecordRingItem> &)> listener);
+        const std::shared_ptr<RecordRingItem> & getToCompress(uint32_t threadNumber);
+        uint32_t getToCompress(uint32_t threadNumber, uint32_t maxCount, int64_t & first);
+        const std::shared_ptr<RecordRingItem> & getToWrite();
+        uint32_t getToWrite(uint32_t maxCount, int64_t & first);
+
+        void releaseCompressor(const std::shared_ptr<RecordRingItem> & item);
+        void releaseCompressor(int64_t first, uint32_t count);
+        bool releaseWriterSequential(const std::shared_ptr<RecordRingItem> & item);
+        bool releaseWriter(const std::shared_ptr<RecordRingItem> & item);
+        void releaseWriter(int64_t first, uint32_t count);
 
         bool haveError();
         void haveError(bool err);
@@ -220,6 +372,27 @@ namespace evio {
         bool isDiskFull();
         void setDiskFull(bool full);
 
+        void setAdaptiveCompression(float maxRatio, uint32_t fillLevel = 0);
+        void setTagFilter(bool filter);
+        void setChecksum(bool sum);
+        void setTimestampExtractor(RecordOutput::TimestampExtractor const & extractor);
+        void setRecordProcessor(RecordOutput::RecordProcessor const & processor);
+        void setSeekableCompression(uint32_t blockSize);
+        void setPreFilter(Compressor::PreFilter filter);
+        void setColumnLayout(bool byColumn);
+        void setCompressionDictionary(const std::shared_ptr<CompressionDictionary> & dict);
+        void setGatherOutput(bool gather);
+        void setFillStats(RecordFillStats * stats);
+        bool useFastCompression();
+
+        uint32_t getMaxBufferSize() const;
+        uint32_t getCompressionThreadCount() const;
+        uint32_t getActiveCompressors() const;
+        void setActiveCompressors(uint32_t count);
+        void waitWhileParked(uint32_t threadNumber);
+        uint32_t getTargetRecordBytes() const;
+        void setTargetRecordBytes(uint32_t bytes);
+
     };
 
 }
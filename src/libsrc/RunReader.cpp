@@ -0,0 +1,291 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "RunReader.h"
+
+#include <fstream>
+#include <algorithm>
+
+#include "Util.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which finds all the split files of a run, named the same way that
+     * {@link EventWriter} names them, starting with the given split and stopping at the
+     * first one that doesn't exist.
+     *
+     * @param baseName       base file name, as given to EventWriter.
+     * @param runNumber      run number.
+     * @param runType        run type, substituted for any "%s" in baseName.
+     * @param streamId       stream id, used if streamCount > 1.
+     * @param streamCount    total number of streams.
+     * @param splitNumber    number of first split file.
+     * @param splitIncrement amount split number increases from one file to the next.
+     * @param prefetch       if true, open the next file in another thread while reading the current one.
+     * @throws EvioException if no files are found, or a file is not in evio version 6 format.
+     */
+    RunReader::RunReader(std::string const & baseName, uint32_t runNumber,
+                         std::string const & runType, uint32_t streamId, uint32_t streamCount,
+                         uint32_t splitNumber, uint32_t splitIncrement, bool prefetch) :
+            fileNames(findSplitFiles(baseName, runNumber, runType, streamId, streamCount,
+                                     splitNumber, splitIncrement)),
+            prefetch(prefetch) {
+
+        if (fileNames.empty()) {
+            throw EvioException("no split files found for run " + std::to_string(runNumber) +
+                                " of " + baseName);
+        }
+        buildIndex();
+    }
+
+
+    /**
+     * Constructor.
+     * @param files     names of files, in the order their events are to be numbered.
+     * @param prefetch  if true, open the next file in another thread while reading the current one.
+     * @throws EvioException if no files are given, or a file is not in evio version 6 format.
+     */
+    RunReader::RunReader(std::vector<std::string> const & files, bool prefetch) :
+            fileNames(files), prefetch(prefetch) {
+
+        if (fileNames.empty()) {
+            throw EvioException("no files given");
+        }
+        buildIndex();
+    }
+
+
+    /** Destructor. */
+    RunReader::~RunReader() {close();}
+
+
+    /**
+     * Find the names of all the existing split files of a run, named the same way that
+     * {@link EventWriter} names them.
+     *
+     * @param baseName       base file name, as given to EventWriter.
+     * @param runNumber      run number.
+     * @param runType        run type, substituted for any "%s" in baseName.
+     * @param streamId       stream id, used if streamCount > 1.
+     * @param streamCount    total number of streams.
+     * @param splitNumber    number of first split file.
+     * @param splitIncrement amount split number increases from one file to the next.
+     * @return names of files found, in split order, up to the first one missing.
+     * @throws EvioException if baseName is improperly formatted, or splitIncrement < 1.
+     */
+    std::vector<std::string> RunReader::findSplitFiles(std::string const & baseName, uint32_t runNumber,
+                                                       std::string const & runType,
+                                                       uint32_t streamId, uint32_t streamCount,
+                                                       uint32_t splitNumber, uint32_t splitIncrement) {
+        if (splitIncrement < 1) {
+            throw EvioException("splitIncrement < 1");
+        }
+
+        std::string baseFileName;
+        int specifierCount = Util::generateBaseFileName(baseName, runType, baseFileName);
+
+        std::vector<std::string> files;
+        while (true) {
+            // Any non-zero split size generates split file names
+            std::string name = Util::generateFileName(baseFileName, specifierCount, runNumber,
+                                                      1, splitNumber, streamId, streamCount);
+            std::ifstream f(name);
+            if (!f.good()) break;
+            files.push_back(name);
+            splitNumber += splitIncrement;
+        }
+        return files;
+    }
+
+
+    /** Count the events of each file, keeping the first file open for reading. */
+    void RunReader::buildIndex() {
+        for (size_t i=0; i < fileNames.size(); i++) {
+            auto r = std::make_shared<Reader>(fileNames[i]);
+            firstEvents.push_back(firstEvents.back() + r->getEventCount());
+            if (i == 0) {
+                reader = r;
+                currentFile = 0;
+            }
+            else {
+                r->close();
+            }
+        }
+        if (prefetch) startPrefetch(1);
+    }
+
+
+    /** Close the file being read and stop any prefetching. */
+    void RunReader::close() {
+        cancelPrefetch();
+        if (reader != nullptr) {
+            reader->close();
+            reader = nullptr;
+        }
+        currentFile = -1;
+    }
+
+
+    /**
+     * Start opening the file of the given index in another thread.
+     * @param index index of file.
+     */
+    void RunReader::startPrefetch(uint32_t index) {
+        if (index >= fileNames.size() || (int32_t)index == nextFile) return;
+        cancelPrefetch();
+        std::string name = fileNames[index];
+        nextReader = std::async(std::launch::async, [name]() {return std::make_shared<Reader>(name);});
+        nextFile = index;
+    }
+
+
+    /** Wait for any file being prefetched and discard it. */
+    void RunReader::cancelPrefetch() {
+        if (nextReader.valid()) {
+            try {
+                auto r = nextReader.get();
+                r->close();
+            }
+            catch (std::exception & e) {
+                // Its error shows up if the file is ever opened for reading
+            }
+        }
+        nextFile = -1;
+    }
+
+
+    /**
+     * Make the file of the given index the one being read, using it if already prefetched.
+     * @param index index of file.
+     * @return reader of file.
+     * @throws EvioException if file cannot be opened or is not evio version 6 format.
+     */
+    Reader & RunReader::selectFile(uint32_t index) {
+        if ((int32_t)index == currentFile && reader != nullptr) {
+            return *reader;
+        }
+
+        if (reader != nullptr) {
+            reader->close();
+            reader = nullptr;
+        }
+
+        if ((int32_t)index == nextFile && nextReader.valid()) {
+            nextFile = -1;
+            reader = nextReader.get();
+        }
+        else {
+            reader = std::make_shared<Reader>(fileNames[index]);
+        }
+        currentFile = index;
+
+        if (prefetch) startPrefetch(index + 1);
+        return *reader;
+    }
+
+
+    /**
+     * Get the index of the file containing the given event.
+     * @param event global event number.
+     * @return index of file.
+     * @throws EvioException if event is out of bounds.
+     */
+    uint32_t RunReader::getFileOfEvent(uint64_t event) const {
+        if (event >= getEventCount()) {
+            throw EvioException("event " + std::to_string(event) + " out of bounds");
+        }
+        // First file whose first event is beyond this one, minus one
+        auto it = std::upper_bound(firstEvents.begin(), firstEvents.end(), event);
+        return (uint32_t)(it - firstEvents.begin()) - 1;
+    }
+
+
+    /**
+     * Get the reader of the given file, making it the one being read.
+     * @param index index of file.
+     * @return reader of file.
+     * @throws EvioException if index out of bounds, or file cannot be opened.
+     */
+    std::shared_ptr<Reader> RunReader::getReader(uint32_t index) {
+        if (index >= fileNames.size()) {
+            throw EvioException("file index " + std::to_string(index) + " out of bounds");
+        }
+        selectFile(index);
+        return reader;
+    }
+
+
+    /**
+     * Get a byte array representing the specified event.
+     * @param event global event number, starting at 0.
+     * @param len pointer to int which gets filled with the event's length in bytes.
+     * @return byte array representing the event, or nullptr if event is out of bounds.
+     * @throws EvioException if file cannot be opened or is not evio version 6 format.
+     */
+    std::shared_ptr<uint8_t> RunReader::getEvent(uint64_t event, uint32_t * len) {
+        if (event >= getEventCount()) return nullptr;
+        uint32_t file = getFileOfEvent(event);
+        return selectFile(file).getEvent(event - firstEvents[file], len);
+    }
+
+
+    /**
+     * Get a view of the specified event without copying it.
+     * It is valid only until another record is read.
+     * @param event global event number, starting at 0.
+     * @return view of the event, empty if event is out of bounds.
+     * @throws EvioException if file cannot be opened or is not evio version 6 format.
+     */
+    ByteBufferView RunReader::getEventView(uint64_t event) {
+        if (event >= getEventCount()) return ByteBufferView();
+        uint32_t file = getFileOfEvent(event);
+        return selectFile(file).getEventView(event - firstEvents[file]);
+    }
+
+
+    /**
+     * Get the length of the specified event.
+     * @param event global event number, starting at 0.
+     * @return length of the event in bytes, 0 if event is out of bounds.
+     * @throws EvioException if file cannot be opened or is not evio version 6 format.
+     */
+    uint32_t RunReader::getEventLength(uint64_t event) {
+        if (event >= getEventCount()) return 0;
+        uint32_t file = getFileOfEvent(event);
+        return selectFile(file).getEventLength(event - firstEvents[file]);
+    }
+
+
+    /**
+     * Get the next event in sequence, going from file to file.
+     * @param len pointer to int which gets filled with the event's length in bytes.
+     * @return byte array representing the event, or nullptr if there are no more.
+     * @throws EvioException if file cannot be opened or is not evio version 6 format.
+     */
+    std::shared_ptr<uint8_t> RunReader::getNextEvent(uint32_t * len) {
+        if (sequentialEvent >= getEventCount()) return nullptr;
+        return getEvent(sequentialEvent++, len);
+    }
+
+
+    /**
+     * Is there another event to get with {@link #getNextEvent(uint32_t *)}?
+     * @return true if there is another event.
+     */
+    bool RunReader::hasNext() const {return sequentialEvent < getEventCount();}
+
+
+    /** Make {@link #getNextEvent(uint32_t *)} start again with the first event. */
+    void RunReader::rewind() {sequentialEvent = 0;}
+
+}
@@ -0,0 +1,126 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_RUNREADER_H
+#define EVIO_6_0_RUNREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+
+
+#include "Reader.h"
+#include "ByteBufferView.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads all the split files of a run, as written by {@link EventWriter},
+     * as if they were a single file. Events are numbered globally, from 0 for the first
+     * event of the first split to one less than the total of all splits.<p>
+     *
+     * When constructed, each file is opened in turn to count its events, which uses its
+     * trailer index (or sidecar index) if it has one. Finding the file holding any event
+     * is then a binary search and finding the event in that file is done by its
+     * {@link Reader}, so random access takes O(log n) time. Only one file is open for reading
+     * at a time. While it is being read, the next file is opened and scanned in a separate
+     * thread so it's ready to go when needed.<p>
+     *
+     * Like {@link Reader}, this class is not thread-safe.
+     */
+    class RunReader {
+
+    private:
+
+        /** Names of the files in split order. */
+        std::vector<std::string> fileNames;
+
+        /** Global number of the first event of each file, one entry larger than number of files. */
+        std::vector<uint64_t> firstEvents {0};
+
+        /** Reader of current file. */
+        std::shared_ptr<Reader> reader;
+
+        /** Index of current file, -1 if none. */
+        int32_t currentFile = -1;
+
+        /** Reader of next file being opened in another thread. */
+        std::future<std::shared_ptr<Reader>> nextReader;
+
+        /** Index of file being opened by nextReader, -1 if none. */
+        int32_t nextFile = -1;
+
+        /** Open the next file ahead of time? */
+        bool prefetch = true;
+
+        /** Global number of next event returned by {@link #getNextEvent(uint32_t *)}. */
+        uint64_t sequentialEvent = 0;
+
+    public:
+
+        RunReader(std::string const & baseName, uint32_t runNumber,
+                  std::string const & runType = "", uint32_t streamId = 0, uint32_t streamCount = 1,
+                  uint32_t splitNumber = 0, uint32_t splitIncrement = 1, bool prefetch = true);
+
+        explicit RunReader(std::vector<std::string> const & files, bool prefetch = true);
+
+        ~RunReader();
+
+        RunReader(const RunReader &) = delete;
+        RunReader & operator=(const RunReader &) = delete;
+
+        static std::vector<std::string> findSplitFiles(std::string const & baseName, uint32_t runNumber,
+                                                       std::string const & runType = "",
+                                                       uint32_t streamId = 0, uint32_t streamCount = 1,
+                                                       uint32_t splitNumber = 0, uint32_t splitIncrement = 1);
+
+        void close();
+
+        /** @return number of files in this run. */
+        uint32_t getFileCount()                   const {return fileNames.size();}
+        /** @param index file index. @return name of file. */
+        std::string const & getFileName(uint32_t index) const {return fileNames[index];}
+        /** @return total number of events in all files. */
+        uint64_t getEventCount()                  const {return firstEvents.back();}
+        /** @param index file index. @return global number of first event of file. */
+        uint64_t getFirstEventOfFile(uint32_t index) const {return firstEvents[index];}
+        /** @return index of file currently being read, -1 if none. */
+        int32_t getCurrentFile()                  const {return currentFile;}
+
+        uint32_t getFileOfEvent(uint64_t event) const;
+
+        std::shared_ptr<uint8_t> getEvent(uint64_t event, uint32_t * len);
+        ByteBufferView getEventView(uint64_t event);
+        uint32_t getEventLength(uint64_t event);
+
+        std::shared_ptr<uint8_t> getNextEvent(uint32_t * len);
+        bool hasNext() const;
+        void rewind();
+
+        std::shared_ptr<Reader> getReader(uint32_t index);
+
+    private:
+
+        void buildIndex();
+        Reader & selectFile(uint32_t index);
+        void startPrefetch(uint32_t index);
+        void cancelPrefetch();
+    };
+
+}
+
+
+#endif //EVIO_6_0_RUNREADER_H
@@ -0,0 +1,406 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "SeekableCompression.h"
+
+#include <cstring>
+#include <algorithm>
+#include <future>
+
+#include "Compressor.h"
+
+
+namespace evio {
+
+
+    namespace {
+
+        /** Get an int stored in the given byte order. */
+        uint32_t getInt(const uint8_t *p, ByteOrder const & order) {
+            uint32_t i;
+            std::memcpy(&i, p, 4);
+            return (order != ByteOrder::ENDIAN_LOCAL) ? SWAP_32(i) : i;
+        }
+
+        /** Put an int in the given byte order. */
+        void putInt(uint8_t *p, uint32_t i, ByteOrder const & order) {
+            if (order != ByteOrder::ENDIAN_LOCAL) i = SWAP_32(i);
+            std::memcpy(p, &i, 4);
+        }
+
+        /** Largest result of compressing n bytes with lz4. */
+        uint32_t lz4Bound(uint32_t n) {return n + n/255 + 16;}
+    }
+
+
+    // Serial by default
+    std::atomic<int> SeekableCompression::workers {0};
+    std::atomic<uint32_t> SeekableCompression::parallelMinBytes {DEFAULT_PARALLEL_MIN_BYTES};
+
+
+    /**
+     * Get the number of threads compressing or decompressing the blocks of one record.
+     * @return number of threads, 0 or 1 if done by the calling thread alone.
+     */
+    int SeekableCompression::getWorkers() {return workers;}
+
+
+    /**
+     * Set the number of threads compressing or decompressing the blocks of one record
+     * at least {@link #getParallelMinBytes()} long. The calling thread is one of them.
+     * Lz4 records that long are then always written as independent blocks.
+     * This applies to all records of all writers and readers.
+     * @param threads number of threads, 0 or 1 for the calling thread alone.
+     */
+    void SeekableCompression::setWorkers(int threads) {workers = threads < 0 ? 0 : threads;}
+
+
+    /**
+     * Get the bytes of data at or above which blocks are done by several threads.
+     * @return bytes of data.
+     */
+    uint32_t SeekableCompression::getParallelMinBytes() {return parallelMinBytes;}
+
+
+    /**
+     * Set the bytes of data at or above which blocks are done by several threads.
+     * Starting threads for smaller records costs more than it saves.
+     * @param bytes bytes of data.
+     */
+    void SeekableCompression::setParallelMinBytes(uint32_t bytes) {parallelMinBytes = bytes;}
+
+
+    /**
+     * Is data of this length compressed as independent blocks by several threads?
+     * @param srcLen bytes of uncompressed data.
+     * @return true if its blocks are compressed by several threads.
+     */
+    bool SeekableCompression::isParallel(uint32_t srcLen) {
+        return workers > 1 && srcLen >= parallelMinBytes;
+    }
+
+
+    /**
+     * Are the blocks of data of this length done by several threads?
+     * @param srcLen bytes of uncompressed data.
+     * @param blocks number of blocks.
+     * @return true if done by several threads.
+     */
+    bool SeekableCompression::useWorkers(uint32_t srcLen, uint32_t blocks) {
+        return blocks > 1 && isParallel(srcLen);
+    }
+
+
+    /**
+     * Get the most bytes that compressing data of the given length could take, table included.
+     * @param srcLen    bytes of data.
+     * @param blockSize uncompressed bytes in each block.
+     * @return max bytes of compressed data.
+     */
+    uint32_t SeekableCompression::maxCompressedLength(uint32_t srcLen, uint32_t blockSize) {
+        if (blockSize == 0) blockSize = DEFAULT_BLOCK_SIZE;
+        uint32_t blocks = (srcLen + blockSize - 1) / blockSize;
+        uint32_t full = srcLen / blockSize;
+        uint32_t bytes = 8 + 4*blocks + full*lz4Bound(blockSize);
+        if (blocks > full) bytes += lz4Bound(srcLen - full*blockSize);
+        return bytes;
+    }
+
+
+    /**
+     * Compress data as independent lz4 blocks preceded by a table of their lengths.
+     *
+     * @param src         data to compress.
+     * @param srcLen      bytes of data.
+     * @param dst         where to write the table and the compressed blocks.
+     * @param dstCapacity bytes available in dst.
+     * @param blockSize   uncompressed bytes in each block, 0 for {@link #DEFAULT_BLOCK_SIZE}.
+     * @param best        if true, use lz4's highest compression, else its fastest.
+     * @param order       byte order of record in which to write the table.
+     * @param dict        trained dictionary to start each block with, or null.
+     * @return bytes written into dst.
+     * @throws EvioException if dst is too small or compression fails.
+     */
+    uint32_t SeekableCompression::compress(const uint8_t *src, uint32_t srcLen,
+                                           uint8_t *dst, uint32_t dstCapacity,
+                                           uint32_t blockSize, bool best,
+                                           ByteOrder const & order,
+                                           const CompressionDictionary *dict) {
+        if (blockSize == 0) blockSize = DEFAULT_BLOCK_SIZE;
+        uint32_t blocks = (srcLen + blockSize - 1) / blockSize;
+        uint32_t tableBytes = 8 + 4*blocks;
+        if (tableBytes > dstCapacity) {
+            throw EvioException("buffer too small for block table");
+        }
+
+        putInt(dst, blocks, order);
+        putInt(dst + 4, blockSize, order);
+
+        uint8_t *in = const_cast<uint8_t *>(src);
+
+        if (useWorkers(srcLen, blocks) && maxCompressedLength(srcLen, blockSize) <= dstCapacity) {
+            // Each block is compressed into its own slot, big enough for the worst case,
+            // then the blocks are moved down to be back to back
+            uint32_t slot = lz4Bound(blockSize);
+            uint32_t threads = std::min((uint32_t)workers.load(), blocks);
+            std::vector<int> sizes(blocks);
+
+            auto work = [&](uint32_t first) {
+                for (uint32_t b = first; b < blocks; b += threads) {
+                    uint32_t start = b*blockSize;
+                    uint32_t len = std::min(blockSize, srcLen - start);
+                    uint32_t slotOffset = tableBytes + b*slot;
+                    sizes[b] = best ?
+                            Compressor::compressLZ4Best(in, start, len, dst, slotOffset, lz4Bound(len), dict) :
+                            Compressor::compressLZ4(in, start, len, dst, slotOffset, lz4Bound(len), dict);
+                }
+            };
+
+            {
+                // Futures wait for their threads when destroyed, even if work throws
+                std::vector<std::future<void>> others;
+                for (uint32_t t=1; t < threads; t++) {
+                    others.push_back(std::async(std::launch::async, work, t));
+                }
+                work(0);
+                for (auto & f : others) {
+                    f.get();
+                }
+            }
+
+            uint32_t offset = tableBytes;
+            for (uint32_t b=0; b < blocks; b++) {
+                std::memmove(dst + offset, dst + tableBytes + b*slot, sizes[b]);
+                putInt(dst + 8 + 4*b, sizes[b], order);
+                offset += sizes[b];
+            }
+            return offset;
+        }
+
+        uint32_t offset = tableBytes;
+        for (uint32_t b=0; b < blocks; b++) {
+            uint32_t start = b*blockSize;
+            uint32_t len = std::min(blockSize, srcLen - start);
+
+            int size = best ?
+                    Compressor::compressLZ4Best(in, start, len, dst, offset, dstCapacity - offset, dict) :
+                    Compressor::compressLZ4(in, start, len, dst, offset, dstCapacity - offset, dict);
+
+            putInt(dst + 8 + 4*b, size, order);
+            offset += size;
+        }
+
+        return offset;
+    }
+
+
+    /**
+     * Decompress all blocks of data compressed with
+     * {@link #compress(const uint8_t *, uint32_t, uint8_t *, uint32_t, uint32_t, bool, ByteOrder const &, const CompressionDictionary *)}.
+     *
+     * @param src         compressed data, table included.
+     * @param srcLen      bytes of compressed data.
+     * @param dst         where to write the uncompressed data.
+     * @param dstCapacity bytes available in dst.
+     * @param order       byte order of record.
+     * @param dict        trained dictionary data was compressed with, or null.
+     * @return bytes of uncompressed data.
+     * @throws EvioException if data is malformed or dst is too small.
+     */
+    uint32_t SeekableCompression::uncompress(const uint8_t *src, uint32_t srcLen,
+                                             uint8_t *dst, uint32_t dstCapacity,
+                                             ByteOrder const & order,
+                                             const CompressionDictionary *dict) {
+        if (srcLen < 8) {
+            throw EvioException("seekable data too short for block table");
+        }
+
+        uint32_t blocks = getInt(src, order);
+        uint32_t offset = 8 + 4*blocks;
+        if (blocks > srcLen/4 || offset > srcLen) {
+            throw EvioException("seekable data too short for block table");
+        }
+
+        uint8_t *in = const_cast<uint8_t *>(src);
+        uint32_t blockSize = getInt(src + 4, order);
+
+        uint64_t dataBound = (uint64_t)blocks * blockSize;
+        if (blockSize > 0 && dataBound <= (uint64_t)dstCapacity + blockSize &&
+            useWorkers((uint32_t)std::min(dataBound, (uint64_t)dstCapacity), blocks)) {
+            // Where each block starts in src, and each goes in dst, is known from the table
+            std::vector<uint32_t> offsets(blocks + 1);
+            offsets[0] = offset;
+            for (uint32_t b=0; b < blocks; b++) {
+                offsets[b+1] = offsets[b] + getInt(src + 8 + 4*b, order);
+                if (offsets[b+1] > srcLen || offsets[b+1] < offsets[b]) {
+                    throw EvioException("seekable block past end of data");
+                }
+            }
+
+            uint32_t threads = std::min((uint32_t)workers.load(), blocks);
+            std::vector<int> sizes(blocks);
+
+            auto work = [&](uint32_t first) {
+                for (uint32_t b = first; b < blocks; b += threads) {
+                    uint32_t start = b*blockSize;
+                    uint32_t room = std::min(blockSize, dstCapacity - start);
+                    sizes[b] = Compressor::uncompressLZ4(in, offsets[b], offsets[b+1] - offsets[b],
+                                                         dst, start, room, dict);
+                }
+            };
+
+            {
+                std::vector<std::future<void>> others;
+                for (uint32_t t=1; t < threads; t++) {
+                    others.push_back(std::async(std::launch::async, work, t));
+                }
+                work(0);
+                for (auto & f : others) {
+                    f.get();
+                }
+            }
+
+            uint32_t written = 0;
+            for (uint32_t b=0; b < blocks; b++) {
+                // All but the last block are full
+                if (b < blocks - 1 && (uint32_t)sizes[b] != blockSize) {
+                    throw EvioException("seekable block has wrong length");
+                }
+                written += sizes[b];
+            }
+            return written;
+        }
+
+        uint32_t written = 0;
+        for (uint32_t b=0; b < blocks; b++) {
+            uint32_t len = getInt(src + 8 + 4*b, order);
+            if (offset + len > srcLen) {
+                throw EvioException("seekable block past end of data");
+            }
+            written += Compressor::uncompressLZ4(in, offset, len, dst, written, dstCapacity - written, dict);
+            offset += len;
+        }
+
+        return written;
+    }
+
+
+    //////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Constructor which reads the block table.
+     *
+     * @param source           reads the compressed data.
+     * @param compressedLength bytes of compressed data.
+     * @param dataLength       bytes of uncompressed data.
+     * @param order            byte order of record.
+     * @param dict             trained dictionary data was compressed with, or null.
+     * @throws EvioException if table is malformed.
+     */
+    SeekableCompression::BlockReader::BlockReader(DataSource const & source,
+                                                  uint32_t compressedLength, uint32_t dataLength,
+                                                  ByteOrder const & order,
+                                                  const CompressionDictionary *dict) :
+            source(source), order(order), dictionary(dict), dataLength(dataLength) {
+
+        if (compressedLength < 8) {
+            throw EvioException("seekable data too short for block table");
+        }
+
+        uint8_t word[8];
+        source(0, word, 8);
+        uint32_t count = getInt(word, order);
+        blockSize = getInt(word + 4, order);
+
+        if (count > compressedLength/4 || 8 + 4*count > compressedLength || blockSize == 0 ||
+            (uint64_t)count * blockSize < dataLength) {
+            throw EvioException("bad seekable block table");
+        }
+
+        std::vector<uint8_t> table(4*count);
+        if (count > 0) source(8, table.data(), 4*count);
+
+        blockOffsets.resize(count + 1);
+        blockOffsets[0] = 8 + 4*count;
+        for (uint32_t b=0; b < count; b++) {
+            blockOffsets[b+1] = blockOffsets[b] + getInt(table.data() + 4*b, order);
+        }
+        if (blockOffsets[count] > compressedLength) {
+            throw EvioException("seekable block past end of data");
+        }
+        blocks.resize(count);
+    }
+
+
+    /**
+     * Get a decompressed block, decompressing it if not done already.
+     * @param block index of block.
+     * @return uncompressed data of block.
+     * @throws EvioException if data is malformed.
+     */
+    std::vector<uint8_t> const & SeekableCompression::BlockReader::getBlock(uint32_t block) {
+        auto & data = blocks[block];
+        if (!data.empty()) return data;
+
+        uint32_t start = blockOffsets[block];
+        uint32_t len = blockOffsets[block + 1] - start;
+        std::vector<uint8_t> compressed(len);
+        source(start, compressed.data(), len);
+
+        uint32_t expected = std::min(blockSize, dataLength - block*blockSize);
+        data.resize(expected);
+        uint32_t size = Compressor::uncompressLZ4(compressed.data(), 0, len, data.data(), 0, expected, dictionary);
+        if (size != expected) {
+            data.clear();
+            throw EvioException("seekable block has wrong length");
+        }
+        return data;
+    }
+
+
+    /**
+     * Copy uncompressed data, decompressing only the blocks holding it.
+     * @param pos  position in uncompressed data.
+     * @param dest where to copy.
+     * @param len  bytes to copy.
+     * @throws EvioException if range is past the end of the data or data is malformed.
+     */
+    void SeekableCompression::BlockReader::read(uint32_t pos, uint8_t *dest, uint32_t len) {
+        if ((uint64_t)pos + len > dataLength) {
+            throw EvioException("read past end of seekable data");
+        }
+
+        while (len > 0) {
+            uint32_t block = pos / blockSize;
+            uint32_t inBlock = pos - block*blockSize;
+            auto const & data = getBlock(block);
+            uint32_t n = std::min(len, (uint32_t)data.size() - inBlock);
+            std::memcpy(dest, data.data() + inBlock, n);
+            dest += n;
+            pos  += n;
+            len  -= n;
+        }
+    }
+
+
+    /**
+     * Read an int of uncompressed data in the record's byte order.
+     * @param pos position in uncompressed data.
+     * @return int.
+     * @throws EvioException if position is past the end of the data or data is malformed.
+     */
+    uint32_t SeekableCompression::BlockReader::readInt(uint32_t pos) {
+        uint8_t word[4];
+        read(pos, word, 4);
+        return getInt(word, order);
+    }
+
+}
@@ -0,0 +1,147 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SEEKABLECOMPRESSION_H
+#define EVIO_6_0_SEEKABLECOMPRESSION_H
+
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <atomic>
+
+
+#include "ByteOrder.h"
+#include "CompressionDictionary.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class compresses and decompresses the data of a record (index, user header and
+     * events) as independent lz4 blocks, so that any part of it can be decompressed without the
+     * rest. This is the layout of records whose header has {@link RecordHeader#SEEKABLE_BIT} set.
+     * A reader fetching one event decompresses only the blocks holding the index up to
+     * that event and the blocks holding the event itself, instead of the whole record.<p>
+     *
+     * The compressed data consists of, all in the record's byte order:
+     *
+     * <pre><code>
+     *    +----------------------------------+
+     *    |        Number of blocks, N       |
+     *    +----------------------------------+
+     *    |  Uncompressed bytes per block    |  // last block may hold fewer
+     *    +----------------------------------+
+     *    |  Compressed length of block 0    |
+     *    |               ...                |
+     *    | Compressed length of block N-1   |
+     *    +----------------------------------+
+     *    |    Block 0 ... block N-1         |  // back to back, no padding
+     *    +----------------------------------+
+     * </code></pre>
+     *
+     * Smaller blocks compress a bit less well, since lz4 finds no matches across them.<p>
+     *
+     * Since the blocks are independent, several threads may compress and decompress them
+     * at once (see {@link #setWorkers(int)}). Records at least {@link #getParallelMinBytes()}
+     * long are then written in this layout even if not asked to be seekable, so that one
+     * very large record, such as one holding a single huge event, does not keep one thread
+     * busy for long while the others wait on it.<p>
+     */
+    class SeekableCompression {
+
+    public:
+
+        /** Default uncompressed bytes in each block. */
+        static const uint32_t DEFAULT_BLOCK_SIZE = 64*1024;
+
+        /** Default bytes of data at or above which blocks are done by several threads. */
+        static const uint32_t DEFAULT_PARALLEL_MIN_BYTES = 4*1024*1024;
+
+        /** Reads len bytes starting at pos, relative to the start of the compressed data, into dest. */
+        typedef std::function<void(uint32_t pos, uint8_t *dest, uint32_t len)> DataSource;
+
+
+        /**
+         * This class holds the block table of one record's compressed data
+         * and decompresses parts of it on demand, keeping the blocks it decompressed.
+         */
+        class BlockReader {
+
+        private:
+
+            /** Reads compressed data. */
+            DataSource source;
+            /** Byte order of record. */
+            ByteOrder order;
+            /** Dictionary of compression, may be null. */
+            const CompressionDictionary *dictionary;
+            /** Uncompressed bytes in each block. */
+            uint32_t blockSize = 0;
+            /** Total uncompressed bytes. */
+            uint32_t dataLength = 0;
+            /** Offset of each block in the compressed data, with one more entry for the end. */
+            std::vector<uint32_t> blockOffsets;
+            /** Decompressed blocks, empty if not yet decompressed. */
+            std::vector<std::vector<uint8_t>> blocks;
+
+            std::vector<uint8_t> const & getBlock(uint32_t block);
+
+        public:
+
+            BlockReader(DataSource const & source, uint32_t compressedLength, uint32_t dataLength,
+                        ByteOrder const & order, const CompressionDictionary *dict);
+
+            /** @return number of blocks. */
+            uint32_t getBlockCount() const {return (uint32_t)blockOffsets.size() - 1;}
+
+            void read(uint32_t pos, uint8_t *dest, uint32_t len);
+            uint32_t readInt(uint32_t pos);
+        };
+
+
+    private:
+
+        /** Number of threads compressing or decompressing the blocks of one record. */
+        static std::atomic<int> workers;
+
+        /** Bytes of data at or above which blocks are done by several threads. */
+        static std::atomic<uint32_t> parallelMinBytes;
+
+        static bool useWorkers(uint32_t srcLen, uint32_t blocks);
+
+    public:
+
+        static int  getWorkers();
+        static void setWorkers(int threads);
+        static uint32_t getParallelMinBytes();
+        static void setParallelMinBytes(uint32_t bytes);
+        static bool isParallel(uint32_t srcLen);
+
+        static uint32_t maxCompressedLength(uint32_t srcLen, uint32_t blockSize);
+
+        static uint32_t compress(const uint8_t *src, uint32_t srcLen,
+                                 uint8_t *dst, uint32_t dstCapacity,
+                                 uint32_t blockSize, bool best,
+                                 ByteOrder const & order,
+                                 const CompressionDictionary *dict = nullptr);
+
+        static uint32_t uncompress(const uint8_t *src, uint32_t srcLen,
+                                   uint8_t *dst, uint32_t dstCapacity,
+                                   ByteOrder const & order,
+                                   const CompressionDictionary *dict = nullptr);
+    };
+
+}
+
+
+#endif //EVIO_6_0_SEEKABLECOMPRESSION_H
@@ -0,0 +1,303 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "SharedMemoryReader.h"
+
+
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boost/thread.hpp>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which attaches to a shared memory ring created by a {@link SharedMemoryWriter}.
+     * Reading starts with the first record published after attaching.
+     *
+     * @param name     name of segment, a "/" is prepended if missing.
+     * @param blocking if true, hold the writer back rather than miss records.
+     * @throws EvioException if segment cannot be opened or mapped, is not an evio ring,
+     *                       or already has the max number of consumers.
+     */
+    SharedMemoryReader::SharedMemoryReader(std::string const & name, bool blocking) :
+            name(name.empty() || name[0] != '/' ? "/" + name : name), blocking(blocking) {
+
+        int fd = ::shm_open(this->name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw EvioException("cannot open shared memory " + this->name + ", " + std::strerror(errno));
+        }
+
+        // The writer may still be setting things up
+        size_t pageSize = ::sysconf(_SC_PAGESIZE);
+        struct stat st {};
+        for (int i=0; i < 1000; i++) {
+            if (::fstat(fd, &st) == 0 && (size_t)st.st_size >= pageSize) break;
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+        }
+        if ((size_t)st.st_size < pageSize) {
+            ::close(fd);
+            throw EvioException("shared memory " + this->name + " not set up");
+        }
+
+        // Look at the start of the control area to find out how big it is
+        void *mem = ::mmap(nullptr, pageSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED) {
+            ::close(fd);
+            throw EvioException("cannot map shared memory " + this->name);
+        }
+        auto header = static_cast<SharedMemoryRing *>(mem);
+        for (int i=0; i < 1000; i++) {
+            if (header->magic.load(std::memory_order_acquire) == SharedMemoryRing::MAGIC) break;
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+        }
+        bool ok = header->magic.load(std::memory_order_acquire) == SharedMemoryRing::MAGIC &&
+                  header->version == SharedMemoryRing::VERSION;
+        slotCount    = header->slotCount;
+        slotBytes    = header->slotBytes;
+        controlBytes = header->slotsOffset;
+        ::munmap(mem, pageSize);
+        if (!ok) {
+            ::close(fd);
+            throw EvioException(this->name + " is not an evio shared memory ring");
+        }
+
+        // Control area is shared read-write for the cursors, records are read-only
+        mem = ::mmap(nullptr, controlBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED) {
+            ::close(fd);
+            throw EvioException("cannot map shared memory " + this->name);
+        }
+        ring = static_cast<SharedMemoryRing *>(mem);
+
+        size_t dataBytes = (size_t)slotCount * slotBytes;
+        mem = ::mmap(nullptr, dataBytes, PROT_READ, MAP_SHARED, fd, controlBytes);
+        // Mappings stay valid after fd is closed
+        ::close(fd);
+        if (mem == MAP_FAILED) {
+            ::munmap(ring, controlBytes);
+            ring = nullptr;
+            throw EvioException("cannot map shared memory " + this->name);
+        }
+        slots = std::make_shared<ByteBuffer>(static_cast<uint8_t *>(mem), dataBytes, true);
+
+        // Claim a free consumer entry
+        uint32_t state = blocking ? SharedMemoryRing::CONSUMER_BLOCKING : SharedMemoryRing::CONSUMER_NONBLOCKING;
+        for (auto & c : ring->consumers) {
+            uint32_t expected = SharedMemoryRing::CONSUMER_FREE;
+            if (c.state.compare_exchange_strong(expected, state, std::memory_order_acq_rel)) {
+                consumer = &c;
+                break;
+            }
+        }
+        if (consumer == nullptr) {
+            close();
+            throw EvioException("too many consumers of " + this->name);
+        }
+
+        // Until the cursor is set, the writer may see an older one, which only makes it wait longer
+        currentSequence = ring->published.load(std::memory_order_acquire);
+        consumer->pid.store(::getpid(), std::memory_order_release);
+        consumer->cursor.store(currentSequence, std::memory_order_release);
+    }
+
+
+    /** Destructor which detaches from the ring. */
+    SharedMemoryReader::~SharedMemoryReader() {close();}
+
+
+    /**
+     * Wait for the record with the given sequence to be published.
+     * @param sequence sequence of record.
+     * @return true if published, false if the writer closed first or the timeout ran out.
+     */
+    bool SharedMemoryReader::waitForRecord(int64_t sequence) {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t tries = 0;
+
+        while (ring->published.load(std::memory_order_acquire) < sequence) {
+            if (ring->writerClosed.load(std::memory_order_acquire) != 0) {
+                // Anything published before closing is seen by now
+                if (ring->published.load(std::memory_order_acquire) >= sequence) return true;
+                finished = true;
+                return false;
+            }
+
+            if (timeout >= 0 &&
+                std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeout)) {
+                return false;
+            }
+
+            // Spin briefly, then stop eating cpu
+            if (++tries < 100) {
+                boost::this_thread::yield();
+            }
+            else {
+                boost::this_thread::sleep_for(boost::chrono::microseconds(50));
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     * Read the next record out of the ring, waiting for it to be published if necessary.
+     * The slot of the previous record is given back to the writer.
+     * @return true if a record was read, false if the writer has closed and every record
+     *         has been read, or the timeout ran out.
+     * @throws EvioException if reader closed or record is not in evio format.
+     */
+    bool SharedMemoryReader::readRecord() {
+        if (ring == nullptr) {
+            throw EvioException("reader closed");
+        }
+        if (finished) return false;
+
+        // Done with the current record, so the writer may reuse its slot
+        consumer->cursor.store(currentSequence, std::memory_order_release);
+        haveRecord = false;
+
+        int64_t want = currentSequence + 1;
+        uint32_t mask = slotCount - 1;
+
+        while (true) {
+            if (!waitForRecord(want)) return false;
+
+            auto & slot = ring->slots()[want & mask];
+            size_t offset = (size_t)(want & mask) * slotBytes;
+            bool overwritten = slot.sequence.load(std::memory_order_acquire) != want;
+
+            if (!overwritten && !blocking) {
+                // Copy it out, then make sure the writer didn't start overwriting it meanwhile
+                uint32_t length = slot.length.load(std::memory_order_relaxed);
+                if (recordCopy == nullptr || recordCopy->capacity() < length) {
+                    recordCopy = std::make_shared<ByteBuffer>(length);
+                }
+                std::memcpy(recordCopy->array(), slots->array() + offset, length);
+                recordCopy->limit(length).position(0);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                overwritten = slot.sequence.load(std::memory_order_relaxed) != want;
+            }
+
+            if (overwritten) {
+                // Fell behind, skip to the oldest record which is safe to read
+                int64_t oldest = ring->published.load(std::memory_order_acquire) - slotCount + 2;
+                if (oldest <= want) oldest = want + 1;
+                recordsMissed += oldest - want;
+                want = oldest;
+                consumer->cursor.store(want - 1, std::memory_order_release);
+                continue;
+            }
+
+            if (blocking) {
+                inputRecord.readRecordInPlace(slots, offset);
+            }
+            else {
+                inputRecord.readRecordInPlace(recordCopy, 0);
+                consumer->cursor.store(want, std::memory_order_release);
+            }
+            break;
+        }
+
+        currentSequence = want;
+        nextEvent = 0;
+        haveRecord = true;
+        recordsRead++;
+        eventsRead += inputRecord.getEntries();
+        return true;
+    }
+
+
+    /**
+     * Get the last record read.
+     * @return last record read.
+     * @throws EvioException if no record has been read.
+     */
+    RecordInput & SharedMemoryReader::getRecord() {
+        if (!haveRecord) {
+            throw EvioException("no record read");
+        }
+        return inputRecord;
+    }
+
+
+    /**
+     * Make sure the current record has another event, reading records as needed.
+     * @return true if an event is available, false if the writer has closed
+     *         and every record has been read, or the timeout ran out.
+     * @throws EvioException if error reading.
+     */
+    bool SharedMemoryReader::nextEventReady() {
+        while (!haveRecord || nextEvent >= inputRecord.getEntries()) {
+            if (!readRecord()) return false;
+        }
+        return true;
+    }
+
+
+    /**
+     * Get a copy of the next event, reading records as needed.
+     * @param len pointer to int which gets filled with the event size in bytes.
+     * @return next event, or nullptr if there is none.
+     * @throws EvioException if error reading.
+     */
+    std::shared_ptr<uint8_t> SharedMemoryReader::getNextEvent(uint32_t * len) {
+        if (!nextEventReady()) {
+            if (len != nullptr) *len = 0;
+            return nullptr;
+        }
+
+        // The slot will be reused, so don't share it
+        auto view = inputRecord.getEventView(nextEvent++);
+        std::shared_ptr<uint8_t> event(new uint8_t[view.size()], std::default_delete<uint8_t[]>());
+        std::memcpy(event.get(), view.data(), view.size());
+        if (len != nullptr) *len = view.size();
+        return event;
+    }
+
+
+    /**
+     * Get a view of the next event, reading records as needed. For a blocking reader
+     * of an uncompressed record, this points straight into shared memory.
+     * The view is valid until the next record is read.
+     * @return view of next event, empty if there is none.
+     * @throws EvioException if error reading.
+     */
+    ByteBufferView SharedMemoryReader::getNextEventView() {
+        if (!nextEventReady()) {
+            return ByteBufferView();
+        }
+        return inputRecord.getEventView(nextEvent++);
+    }
+
+
+    /** Give up this reader's entry in the ring and unmap the segment. */
+    void SharedMemoryReader::close() {
+        if (ring == nullptr) return;
+
+        if (consumer != nullptr) {
+            consumer->state.store(SharedMemoryRing::CONSUMER_FREE, std::memory_order_release);
+            consumer = nullptr;
+        }
+        haveRecord = false;
+        inputRecord = RecordInput();
+        slots.reset();
+        ::munmap(ring, controlBytes);
+        ring = nullptr;
+    }
+
+}
@@ -0,0 +1,145 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SHAREDMEMORYREADER_H
+#define EVIO_6_0_SHAREDMEMORYREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <memory>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "RecordInput.h"
+#include "SharedMemoryRing.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads evio records published into shared memory by a
+     * {@link SharedMemoryWriter} in another process on the same node. Each reader has its
+     * own cursor into the ring, so any number of them may read the same records.
+     * The records slots are mapped read-only.<p>
+     *
+     * A blocking reader sees every record and reads uncompressed records in place, without
+     * copying them, but holds the writer back if it falls behind. Events viewed through
+     * {@link #getNextEventView()} stay valid until the next record is read.
+     * A non-blocking reader never holds the writer back. It copies each record out of the
+     * ring and, if it falls so far behind that records it has not read are overwritten,
+     * skips ahead to the oldest record left, counting those it missed.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class SharedMemoryReader {
+
+    private:
+
+        /** Name of shared memory segment. */
+        std::string name;
+
+        /** Control area at the start of the segment, mapped read-write. */
+        SharedMemoryRing *ring = nullptr;
+
+        /** Size of control area in bytes. */
+        size_t controlBytes = 0;
+
+        /** All slots, mapped read-only, which this buffer unmaps when done. */
+        std::shared_ptr<ByteBuffer> slots;
+
+        /** Copy of the current record if non-blocking. */
+        std::shared_ptr<ByteBuffer> recordCopy;
+
+        /** This reader's entry in the control area. */
+        SharedMemoryRing::Consumer *consumer = nullptr;
+
+        /** Does this reader hold the writer back? */
+        bool blocking;
+
+        /** Number of slots. */
+        uint32_t slotCount = 0;
+
+        /** Size of each slot in bytes. */
+        uint32_t slotBytes = 0;
+
+        /** Milliseconds to wait for a record, &lt; 0 means forever. */
+        int32_t timeout = -1;
+
+        /** Sequence of the current record, -1 if none. */
+        int64_t currentSequence = -1;
+
+        /** Current record. */
+        RecordInput inputRecord;
+
+        /** Index of next event in current record. */
+        uint32_t nextEvent = 0;
+
+        /** Has a record been read? */
+        bool haveRecord = false;
+
+        /** Has the writer closed and every record been read? */
+        bool finished = false;
+
+        /** Total records read. */
+        uint64_t recordsRead = 0;
+
+        /** Total records overwritten before they could be read. */
+        uint64_t recordsMissed = 0;
+
+        /** Total events read. */
+        uint64_t eventsRead = 0;
+
+    public:
+
+        explicit SharedMemoryReader(std::string const & name, bool blocking = true);
+
+        SharedMemoryReader(const SharedMemoryReader & other) = delete;
+        SharedMemoryReader & operator=(const SharedMemoryReader & other) = delete;
+
+        ~SharedMemoryReader();
+
+        /** @param millisec milliseconds to wait for a record, &lt; 0 to wait until the writer closes. */
+        void setTimeout(int32_t millisec) {timeout = millisec;}
+
+        /** @return name of shared memory segment. */
+        std::string const & getName()  const {return name;}
+        /** @return true if this reader holds the writer back. */
+        bool isBlocking()              const {return blocking;}
+        /** @return true if the writer has closed and every record has been read. */
+        bool isFinished()              const {return finished;}
+        /** @return total records read. */
+        uint64_t getRecordsRead()      const {return recordsRead;}
+        /** @return total records overwritten before they could be read. */
+        uint64_t getRecordsMissed()    const {return recordsMissed;}
+        /** @return total events read. */
+        uint64_t getEventsRead()       const {return eventsRead;}
+
+        bool readRecord();
+        RecordInput & getRecord();
+
+        std::shared_ptr<uint8_t> getNextEvent(uint32_t * len);
+        ByteBufferView getNextEventView();
+
+        void close();
+
+    private:
+
+        bool waitForRecord(int64_t sequence);
+        bool nextEventReady();
+    };
+
+}
+
+
+#endif //EVIO_6_0_SHAREDMEMORYREADER_H
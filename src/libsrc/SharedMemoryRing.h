@@ -0,0 +1,124 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SHAREDMEMORYRING_H
+#define EVIO_6_0_SHAREDMEMORYRING_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <unistd.h>
+
+
+namespace evio {
+
+
+    /**
+     * This class describes the layout of a POSIX shared memory segment through which a
+     * {@link SharedMemoryWriter} hands evio records to any number of
+     * {@link SharedMemoryReader}s in other processes on the same node.<p>
+     *
+     * The segment starts with a control area, mapped read-write by everyone, holding this
+     * object: the ring's geometry, the sequence of the last record published, the state
+     * of each slot and a cursor for each consumer. Following it, starting on a page boundary,
+     * are the slots themselves, each holding one complete record. Readers map the slots
+     * read-only.<p>
+     *
+     * Record n goes into slot n % slotCount. A blocking consumer holds the writer back,
+     * so no slot is reused until every blocking consumer's cursor has moved past it.
+     * A non-blocking consumer never holds the writer back but may fall behind, in which
+     * case records it has not read are overwritten. It notices this when a slot's sequence
+     * is no longer that of the record it wants, and skips ahead.
+     */
+    class SharedMemoryRing {
+
+    public:
+
+        /** Magic number identifying an evio shared memory ring ("EVMR"). */
+        static const uint32_t MAGIC = 0x45564D52;
+        /** Version of the shared memory layout. */
+        static const uint32_t VERSION = 1;
+        /** Max number of consumers attached at once. */
+        static const uint32_t MAX_CONSUMERS = 32;
+
+        /** State of an unused consumer entry. */
+        static const uint32_t CONSUMER_FREE = 0;
+        /** State of a consumer which holds the writer back. */
+        static const uint32_t CONSUMER_BLOCKING = 1;
+        /** State of a consumer which may miss records. */
+        static const uint32_t CONSUMER_NONBLOCKING = 2;
+
+
+        /** Cursor of one consumer, on its own cache line. */
+        struct alignas(64) Consumer {
+            /** CONSUMER_FREE, CONSUMER_BLOCKING or CONSUMER_NONBLOCKING. */
+            std::atomic<uint32_t> state;
+            /** Process id of consumer, so the writer can free entries of dead processes. */
+            std::atomic<int32_t>  pid;
+            /** Sequence of the last record the consumer is done with. */
+            std::atomic<int64_t>  cursor;
+        };
+
+
+        /** State of one slot. */
+        struct Slot {
+            /** Sequence of record in slot, -1 while being written. */
+            std::atomic<int64_t>  sequence;
+            /** Length of record in slot in bytes. */
+            std::atomic<uint32_t> length;
+            uint32_t reserved;
+        };
+
+
+        /** Magic number, written last by the writer once everything else is set. */
+        std::atomic<uint32_t> magic;
+        /** Version of layout. */
+        uint32_t version;
+        /** Number of slots, a power of 2. */
+        uint32_t slotCount;
+        /** Size of each slot in bytes. */
+        uint32_t slotBytes;
+        uint32_t reserved;
+        /** Non-zero once the writer is done. */
+        std::atomic<uint32_t> writerClosed;
+        /** Offset from the segment start to the first slot, a multiple of the page size. */
+        uint64_t slotsOffset;
+
+        /** Sequence of the last record published, -1 if none. */
+        alignas(64) std::atomic<int64_t> published;
+
+        /** Cursors of all consumers. */
+        Consumer consumers[MAX_CONSUMERS];
+
+        // Followed by slotCount Slot entries
+
+
+        /** @return state of each slot, which follows this object. */
+        Slot * slots() {return reinterpret_cast<Slot *>(this + 1);}
+
+
+        /**
+         * Get the size of the control area, which is a whole number of pages
+         * so that the slots may be mapped separately.
+         * @param slots number of slots.
+         * @return size of control area in bytes.
+         */
+        static size_t controlBytes(uint32_t slots) {
+            size_t pageSize = ::sysconf(_SC_PAGESIZE);
+            size_t bytes = sizeof(SharedMemoryRing) + slots*sizeof(Slot);
+            return (bytes + pageSize - 1) / pageSize * pageSize;
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_SHAREDMEMORYRING_H
@@ -0,0 +1,232 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "SharedMemoryWriter.h"
+
+
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <iostream>
+#include <chrono>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <boost/thread.hpp>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which creates the shared memory segment, replacing any left
+     * behind under the same name by a writer which did not close.
+     *
+     * @param name      name of segment, a "/" is prepended if missing.
+     * @param slotCount number of records the ring holds, rounded up to a power of 2.
+     * @param slotBytes max size of a record in bytes, rounded up to a multiple of 64.
+     * @throws EvioException if slotCount or slotBytes is 0, or segment cannot be created.
+     */
+    SharedMemoryWriter::SharedMemoryWriter(std::string const & name, uint32_t slotCount, uint32_t slotBytes) :
+            name(name.empty() || name[0] != '/' ? "/" + name : name) {
+
+        if (slotCount < 1 || slotBytes < 1) {
+            throw EvioException("slot count and size must be > 0");
+        }
+
+        // Power of 2 so sequences map onto slots with a mask
+        uint32_t count = 1;
+        while (count < slotCount) count <<= 1;
+        this->slotCount = count;
+        this->slotBytes = (slotBytes + 63) / 64 * 64;
+
+        size_t control = SharedMemoryRing::controlBytes(this->slotCount);
+        segmentBytes = control + (size_t)this->slotCount * this->slotBytes;
+
+        ::shm_unlink(this->name.c_str());
+        int fd = ::shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            throw EvioException("cannot create shared memory " + this->name + ", " + std::strerror(errno));
+        }
+
+        if (::ftruncate(fd, segmentBytes) != 0) {
+            std::string err = std::strerror(errno);
+            ::close(fd);
+            ::shm_unlink(this->name.c_str());
+            throw EvioException("cannot size shared memory " + this->name + ", " + err);
+        }
+
+        void *mem = ::mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        // Mapping stays valid after fd is closed
+        ::close(fd);
+        if (mem == MAP_FAILED) {
+            ::shm_unlink(this->name.c_str());
+            throw EvioException("cannot map shared memory " + this->name);
+        }
+
+        // Segment starts out zeroed, so all consumers are free
+        ring = new (mem) SharedMemoryRing;
+        slotData = static_cast<uint8_t *>(mem) + control;
+
+        ring->version     = SharedMemoryRing::VERSION;
+        ring->slotCount   = this->slotCount;
+        ring->slotBytes   = this->slotBytes;
+        ring->slotsOffset = control;
+        ring->writerClosed.store(0);
+        ring->published.store(-1);
+        for (uint32_t i=0; i < this->slotCount; i++) {
+            ring->slots()[i].sequence.store(-1);
+            ring->slots()[i].length.store(0);
+        }
+
+        // Readers wait for this before looking at anything else
+        ring->magic.store(SharedMemoryRing::MAGIC, std::memory_order_release);
+    }
+
+
+    /** Destructor which closes this writer. */
+    SharedMemoryWriter::~SharedMemoryWriter() {close();}
+
+
+    /**
+     * Get the number of consumers attached.
+     * @return number of consumers attached.
+     */
+    uint32_t SharedMemoryWriter::getConsumerCount() const {
+        if (closed) return 0;
+        uint32_t count = 0;
+        for (auto & c : ring->consumers) {
+            if (c.state.load(std::memory_order_acquire) != SharedMemoryRing::CONSUMER_FREE) count++;
+        }
+        return count;
+    }
+
+
+    /**
+     * Get the lowest cursor of all blocking consumers.
+     * @return lowest cursor of blocking consumers, or the last sequence published if there are none.
+     */
+    int64_t SharedMemoryWriter::minBlockingCursor() {
+        int64_t min = nextSequence - 1;
+        for (auto & c : ring->consumers) {
+            if (c.state.load(std::memory_order_acquire) == SharedMemoryRing::CONSUMER_BLOCKING) {
+                int64_t cursor = c.cursor.load(std::memory_order_acquire);
+                if (cursor < min) min = cursor;
+            }
+        }
+        return min;
+    }
+
+
+    /** Free the entries of consumers whose processes no longer exist. */
+    void SharedMemoryWriter::freeDeadConsumers() {
+        for (auto & c : ring->consumers) {
+            if (c.state.load(std::memory_order_acquire) == SharedMemoryRing::CONSUMER_FREE) continue;
+            int32_t pid = c.pid.load(std::memory_order_acquire);
+            if (pid > 0 && ::kill(pid, 0) != 0 && errno == ESRCH) {
+                std::cout << "SharedMemoryWriter: freeing consumer of dead process " << pid << std::endl;
+                c.state.store(SharedMemoryRing::CONSUMER_FREE, std::memory_order_release);
+            }
+        }
+    }
+
+
+    /**
+     * Wait until all blocking consumers are done with the record last held by the slot
+     * which the record with the given sequence goes into.
+     * @param sequence sequence of record about to be published.
+     */
+    void SharedMemoryWriter::waitForSlot(int64_t sequence) {
+        int64_t wrapPoint = sequence - slotCount;
+        if (cachedMinCursor >= wrapPoint) return;
+
+        auto start = std::chrono::steady_clock::now();
+        auto lastCheck = start;
+        uint32_t tries = 0;
+
+        while ((cachedMinCursor = minBlockingCursor()) < wrapPoint) {
+            // Spin briefly, then stop eating cpu
+            if (++tries < 100) {
+                boost::this_thread::yield();
+                continue;
+            }
+            boost::this_thread::sleep_for(boost::chrono::microseconds(50));
+
+            // A consumer which died must not hold things up forever
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastCheck > std::chrono::seconds(1)) {
+                freeDeadConsumers();
+                lastCheck = now;
+            }
+        }
+    }
+
+
+    /**
+     * Publish a built record to all consumers. This waits until every blocking consumer
+     * is done with the slot it goes into. A record too large for a slot is not published.
+     *
+     * @param record built record, compressed or not.
+     * @return true if record was published, false if it is too large for a slot.
+     * @throws EvioException if writer closed.
+     */
+    bool SharedMemoryWriter::publish(RecordOutput & record) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+
+        uint32_t length = record.getHeader()->getLength();
+        if (length > slotBytes) {
+            recordsTooLarge++;
+            return false;
+        }
+
+        int64_t seq = nextSequence;
+        waitForSlot(seq);
+
+        // Mark slot as being written so non-blocking consumers still reading it notice
+        auto & slot = ring->slots()[seq & (slotCount - 1)];
+        slot.sequence.store(-1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint8_t *dest = slotData + (size_t)(seq & (slotCount - 1)) * slotBytes;
+        record.getSegments(segments);
+        for (auto & seg : segments) {
+            std::memcpy(dest, seg.data(), seg.size());
+            dest += seg.size();
+        }
+
+        slot.length.store(length, std::memory_order_relaxed);
+        slot.sequence.store(seq, std::memory_order_release);
+        ring->published.store(seq, std::memory_order_release);
+
+        nextSequence++;
+        recordsPublished++;
+        return true;
+    }
+
+
+    /**
+     * Let consumers know no more records are coming, unmap the segment and remove it.
+     * Consumers still attached keep their mappings.
+     */
+    void SharedMemoryWriter::close() {
+        if (closed) return;
+        closed = true;
+
+        ring->writerClosed.store(1, std::memory_order_release);
+        ::munmap(ring, segmentBytes);
+        ::shm_unlink(name.c_str());
+        ring = nullptr;
+        slotData = nullptr;
+    }
+
+}
@@ -0,0 +1,127 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SHAREDMEMORYWRITER_H
+#define EVIO_6_0_SHAREDMEMORYWRITER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+
+
+#include "ByteBufferView.h"
+#include "RecordOutput.h"
+#include "SharedMemoryRing.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class publishes evio records into a ring in POSIX shared memory, from which
+     * any number of {@link SharedMemoryReader}s in other processes on the same node take
+     * them. Each record is copied once, into its slot, and is read from there in place by
+     * every consumer, giving fan-out to local monitoring, event display and filtering
+     * processes without reading back the file written to disk.<p>
+     *
+     * Records are published by calling {@link #publish(RecordOutput &)} with a built record,
+     * or by handing this object to {@link EventWriter#setSharedMemoryWriter}, which then
+     * publishes each record as it's written to file. Before reusing a slot, the writer waits
+     * for all blocking consumers to be done with it. Non-blocking consumers never hold it back.
+     * The entries of consumers whose processes have died are freed so they can't stall it.<p>
+     *
+     * The segment is removed when this object is closed. Consumers still attached keep their
+     * mappings and can read the records left in the ring.<p>
+     *
+     * Only one thread may publish at a time.
+     */
+    class SharedMemoryWriter {
+
+    private:
+
+        /** Name of shared memory segment. */
+        std::string name;
+
+        /** Control area at the start of the segment. */
+        SharedMemoryRing *ring = nullptr;
+
+        /** Start of the first slot. */
+        uint8_t *slotData = nullptr;
+
+        /** Size of the whole segment in bytes. */
+        size_t segmentBytes = 0;
+
+        /** Number of slots. */
+        uint32_t slotCount;
+
+        /** Size of each slot in bytes. */
+        uint32_t slotBytes;
+
+        /** Sequence of next record published. */
+        int64_t nextSequence = 0;
+
+        /** Lowest cursor of blocking consumers when last looked at. */
+        int64_t cachedMinCursor = -1;
+
+        /** Parts of the record being published. */
+        std::vector<ByteBufferView> segments;
+
+        /** Total records published. */
+        std::atomic<uint64_t> recordsPublished {0};
+
+        /** Total records too large for a slot, which were not published. */
+        std::atomic<uint64_t> recordsTooLarge {0};
+
+        /** Has close() been called? */
+        bool closed = false;
+
+    public:
+
+        explicit SharedMemoryWriter(std::string const & name, uint32_t slotCount = 32,
+                                    uint32_t slotBytes = 8*1024*1024);
+
+        SharedMemoryWriter(const SharedMemoryWriter & other) = delete;
+        SharedMemoryWriter & operator=(const SharedMemoryWriter & other) = delete;
+
+        ~SharedMemoryWriter();
+
+        /** @return name of shared memory segment. */
+        std::string const & getName()   const {return name;}
+        /** @return number of slots in ring. */
+        uint32_t getSlotCount()         const {return slotCount;}
+        /** @return size of each slot in bytes. */
+        uint32_t getSlotBytes()         const {return slotBytes;}
+        /** @return total records published. */
+        uint64_t getRecordsPublished()  const {return recordsPublished;}
+        /** @return total records too large for a slot, which were not published. */
+        uint64_t getRecordsTooLarge()   const {return recordsTooLarge;}
+        /** @return true if close() has been called. */
+        bool isClosed()                 const {return closed;}
+
+        uint32_t getConsumerCount() const;
+
+        bool publish(RecordOutput & record);
+
+        void close();
+
+    private:
+
+        void waitForSlot(int64_t sequence);
+        int64_t minBlockingCursor();
+        void freeDeadConsumers();
+    };
+
+}
+
+
+#endif //EVIO_6_0_SHAREDMEMORYWRITER_H
@@ -0,0 +1,287 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "SocketReader.h"
+
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which reads the file header from an already connected socket.
+     * This object takes over the socket and closes it when done.
+     *
+     * @param socketFd file descriptor of connected socket.
+     * @throws EvioException if socketFd < 0, or the stream does not start with an evio file header.
+     */
+    SocketReader::SocketReader(int socketFd) : sock(socketFd) {
+        if (sock < 0) {
+            throw EvioException("bad socket");
+        }
+        recordBuffer = std::make_shared<ByteBuffer>(RecordHeader::HEADER_SIZE_BYTES);
+        readFileHeader();
+    }
+
+
+    /** Destructor which closes the socket. */
+    SocketReader::~SocketReader() {close();}
+
+
+    /**
+     * Create a TCP socket listening on all interfaces at the given port.
+     * Give the socket returned by {@link #acceptConnection(int)} to the constructor.
+     *
+     * @param port TCP port to listen on. If 0, the system picks a port, see getsockname().
+     * @param receiveBufferSize if > 0, size of receive buffer (SO_RCVBUF) of accepted sockets.
+     *                          Setting it here, before connecting, allows larger TCP windows.
+     * @return file descriptor of listening socket.
+     * @throws EvioException if socket cannot listen on port.
+     */
+    int SocketReader::listenOn(uint16_t port, int receiveBufferSize) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw EvioException(std::string("cannot create socket, ") + std::strerror(errno));
+        }
+
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (receiveBufferSize > 0) {
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+        }
+
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+
+        if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+            ::listen(fd, 8) < 0) {
+            std::string err = std::strerror(errno);
+            ::close(fd);
+            throw EvioException("cannot listen on port " + std::to_string(port) + ", " + err);
+        }
+        return fd;
+    }
+
+
+    /**
+     * Wait for and accept one connection on a listening socket.
+     * @param listenFd file descriptor of listening socket.
+     * @return file descriptor of connected socket.
+     * @throws EvioException if error accepting.
+     */
+    int SocketReader::acceptConnection(int listenFd) {
+        while (true) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) return fd;
+            if (errno != EINTR) {
+                throw EvioException(std::string("error accepting connection, ") + std::strerror(errno));
+            }
+        }
+    }
+
+
+    /**
+     * Set the size of the socket's receive buffer (SO_RCVBUF).
+     * @param bytes size of receive buffer in bytes.
+     * @throws EvioException if socket closed or option cannot be set.
+     */
+    void SocketReader::setReceiveBufferSize(int bytes) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+        if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) < 0) {
+            throw EvioException(std::string("cannot set receive buffer size, ") + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Read exactly the given number of bytes from the socket.
+     * @param dest where to put the data.
+     * @param bytes number of bytes to read.
+     * @param eofOk if true, the other end closing the connection before any bytes are read
+     *              is not an error.
+     * @return true if all bytes read, false if connection closed before any bytes were read
+     *         and eofOk is true.
+     * @throws EvioException if socket closed, error reading, or connection
+     *                       closed in the middle of the data.
+     */
+    bool SocketReader::receiveAll(uint8_t *dest, size_t bytes, bool eofOk) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+
+        size_t got = 0;
+        while (got < bytes) {
+            ssize_t n = ::recv(sock, dest + got, bytes - got, 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error reading from socket, ") + std::strerror(errno));
+            }
+            if (n == 0) {
+                if (got == 0 && eofOk) return false;
+                throw EvioException("connection closed in middle of data");
+            }
+            got += n;
+        }
+
+        bytesReceived += got;
+        return true;
+    }
+
+
+    /**
+     * Read the file header and anything following it up to the first record.
+     * @throws EvioException if the stream does not start with an evio file header.
+     */
+    void SocketReader::readFileHeader() {
+        ByteBuffer buf(FileHeader::HEADER_SIZE_BYTES);
+        receiveAll(buf.array(), FileHeader::HEADER_SIZE_BYTES, false);
+        buf.limit(FileHeader::HEADER_SIZE_BYTES);
+
+        // Sets the byte order
+        fileHeader.readHeader(buf, 0);
+        if (!fileHeader.getHeaderType().isEvioFileHeader()) {
+            throw EvioException("stream does not start with an evio file header");
+        }
+
+        uint32_t extra = fileHeader.getLength() - FileHeader::HEADER_SIZE_BYTES;
+        if (extra > 0) {
+            userHeader.resize(extra);
+            receiveAll(userHeader.data(), extra, false);
+        }
+    }
+
+
+    /**
+     * Read the next record from the socket, replacing the previous one.
+     * Events of the previous record not yet obtained through
+     * {@link #getNextEvent(uint32_t *)} are skipped.
+     *
+     * @return true if a record was read, false if the trailer or end of stream was reached.
+     * @throws EvioException if error reading, or data is not in evio format.
+     */
+    bool SocketReader::readRecord() {
+        if (finished) return false;
+
+        uint32_t hdrBytes = RecordHeader::HEADER_SIZE_BYTES;
+        recordBuffer->clear();
+        if (!receiveAll(recordBuffer->array(), hdrBytes, true)) {
+            finished = true;
+            haveRecord = false;
+            return false;
+        }
+        recordBuffer->limit(hdrBytes);
+
+        RecordHeader header;
+        header.readHeader(*recordBuffer, 0);
+        uint32_t recordBytes = header.getLength();
+        if (recordBytes < hdrBytes) {
+            throw EvioException("bad record length, " + std::to_string(recordBytes));
+        }
+
+        // Make room for the whole record, keeping the header already read
+        if (recordBuffer->capacity() < recordBytes) {
+            auto bigger = std::make_shared<ByteBuffer>(recordBytes);
+            std::memcpy(bigger->array(), recordBuffer->array(), hdrBytes);
+            bigger->order(recordBuffer->order());
+            recordBuffer = bigger;
+        }
+        receiveAll(recordBuffer->array() + hdrBytes, recordBytes - hdrBytes, false);
+        recordBuffer->limit(recordBytes);
+
+        if (header.getHeaderType().isTrailer()) {
+            finished = true;
+            haveRecord = false;
+            return false;
+        }
+
+        inputRecord.readRecord(*recordBuffer, 0);
+        nextEvent = 0;
+        haveRecord = true;
+        recordsReceived++;
+        eventsReceived += inputRecord.getEntries();
+        return true;
+    }
+
+
+    /**
+     * Get the last record read.
+     * @return last record read.
+     * @throws EvioException if no record has been read.
+     */
+    RecordInput & SocketReader::getRecord() {
+        if (!haveRecord) {
+            throw EvioException("no record read");
+        }
+        return inputRecord;
+    }
+
+
+    /**
+     * Make sure the current record has another event, reading records as needed.
+     * @return true if an event is available, false if the end of stream was reached.
+     * @throws EvioException if error reading.
+     */
+    bool SocketReader::nextEventReady() {
+        while (!haveRecord || nextEvent >= inputRecord.getEntries()) {
+            if (!readRecord()) return false;
+        }
+        return true;
+    }
+
+
+    /**
+     * Get a copy of the next event in the stream, reading records as needed.
+     * @param len pointer to int which gets filled with the event size in bytes.
+     * @return next event, or nullptr at the end of the stream.
+     * @throws EvioException if error reading.
+     */
+    std::shared_ptr<uint8_t> SocketReader::getNextEvent(uint32_t * len) {
+        if (!nextEventReady()) {
+            if (len != nullptr) *len = 0;
+            return nullptr;
+        }
+        return inputRecord.getEvent(nextEvent++, len);
+    }
+
+
+    /**
+     * Get a view of the next event in the stream, reading records as needed.
+     * The view is valid until the next record is read.
+     * @return view of next event, empty at the end of the stream.
+     * @throws EvioException if error reading.
+     */
+    ByteBufferView SocketReader::getNextEventView() {
+        if (!nextEventReady()) {
+            return ByteBufferView();
+        }
+        return inputRecord.getEventView(nextEvent++);
+    }
+
+
+    /** Close the socket. */
+    void SocketReader::close() {
+        if (sock >= 0) {
+            ::close(sock);
+            sock = -1;
+        }
+    }
+
+}
@@ -0,0 +1,130 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SOCKETREADER_H
+#define EVIO_6_0_SOCKETREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "ByteOrder.h"
+#include "FileHeader.h"
+#include "RecordHeader.h"
+#include "RecordInput.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads evio version 6 data sent over a TCP socket by a {@link SocketWriter}
+     * or by anything else sending the contents of an evio file. The stream starts with a
+     * file header, which is read when this object is created, followed by records which
+     * are read one at a time as their events are asked for. The stream ends with a trailer,
+     * or when the other end closes the connection between records.<p>
+     *
+     * Each record is read straight into a buffer which is reused, and uncompressed if
+     * necessary, so events can be looked at in place through
+     * {@link #getNextEventView()} until the next record is read.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class SocketReader {
+
+    private:
+
+        /** Socket file descriptor, -1 if closed. */
+        int sock = -1;
+
+        /** Header which started the stream. */
+        FileHeader fileHeader;
+
+        /** Index and user header following the file header, if any. */
+        std::vector<uint8_t> userHeader;
+
+        /** Buffer holding the last record read exactly as received. */
+        std::shared_ptr<ByteBuffer> recordBuffer;
+
+        /** Last record read. */
+        RecordInput inputRecord;
+
+        /** Index of next event in current record. */
+        uint32_t nextEvent = 0;
+
+        /** Has a record been read? */
+        bool haveRecord = false;
+
+        /** Has the trailer or end of stream been reached? */
+        bool finished = false;
+
+        /** Total bytes received. */
+        uint64_t bytesReceived = 0;
+
+        /** Total records received, not including the trailer. */
+        uint64_t recordsReceived = 0;
+
+        /** Total events received. */
+        uint64_t eventsReceived = 0;
+
+    public:
+
+        explicit SocketReader(int socketFd);
+
+        SocketReader(const SocketReader & other) = delete;
+        SocketReader & operator=(const SocketReader & other) = delete;
+
+        ~SocketReader();
+
+        static int listenOn(uint16_t port, int receiveBufferSize = 0);
+        static int acceptConnection(int listenFd);
+
+        void setReceiveBufferSize(int bytes);
+
+        /** @return header which started the stream. */
+        FileHeader & getFileHeader() {return fileHeader;}
+        /** @return index and user header following the file header, if any. */
+        const std::vector<uint8_t> & getUserHeader() const {return userHeader;}
+        /** @return byte order of data received. */
+        const ByteOrder & getByteOrder() const {return fileHeader.getByteOrder();}
+        /** @return true if the trailer or end of stream has been reached. */
+        bool isFinished()               const {return finished;}
+        /** @return total bytes received. */
+        uint64_t getBytesReceived()     const {return bytesReceived;}
+        /** @return total records received, not including the trailer. */
+        uint64_t getRecordsReceived()   const {return recordsReceived;}
+        /** @return total events received. */
+        uint64_t getEventsReceived()    const {return eventsReceived;}
+
+        bool readRecord();
+        RecordInput & getRecord();
+
+        std::shared_ptr<uint8_t> getNextEvent(uint32_t * len);
+        ByteBufferView getNextEventView();
+
+        void close();
+
+    private:
+
+        bool receiveAll(uint8_t *dest, size_t bytes, bool eofOk);
+        void readFileHeader();
+        bool nextEventReady();
+    };
+
+}
+
+
+#endif //EVIO_6_0_SOCKETREADER_H
@@ -0,0 +1,554 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "SocketWriter.h"
+
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+namespace evio {
+
+
+    /** Most records handed to the kernel in one system call. */
+    static const size_t MAX_BATCH_RECORDS = 64;
+
+
+    /**
+     * Constructor which connects to a {@link SocketReader} and sends the file header.
+     *
+     * @param host name or dotted-decimal address of host to connect to.
+     * @param port TCP port to connect to.
+     * @param order byte order of data sent.
+     * @param maxEventCount max number of events an internal record can hold.
+     *                      Value of 0 means use default (1M).
+     * @param maxBufferSize max number of uncompressed data bytes an internal record can hold.
+     *                      Value of 0 means use default (8MB).
+     * @param compressionType type of data compression for records built here.
+     * @param mode whether to send records one at a time or in batches.
+     * @throws EvioException if host cannot be found or connected to.
+     */
+    SocketWriter::SocketWriter(std::string const & host, uint16_t port, const ByteOrder & order,
+                               uint32_t maxEventCount, uint32_t maxBufferSize,
+                               Compressor::CompressionType compressionType, SendMode mode) :
+            byteOrder(order), compressionType(compressionType), sendMode(mode) {
+
+        connectTo(host, port);
+        configure(maxEventCount, maxBufferSize);
+    }
+
+
+    /**
+     * Constructor which sends the file header over an already connected socket.
+     * This object takes over the socket and closes it when done.
+     *
+     * @param socketFd file descriptor of connected socket.
+     * @param order byte order of data sent.
+     * @param maxEventCount max number of events an internal record can hold.
+     *                      Value of 0 means use default (1M).
+     * @param maxBufferSize max number of uncompressed data bytes an internal record can hold.
+     *                      Value of 0 means use default (8MB).
+     * @param compressionType type of data compression for records built here.
+     * @param mode whether to send records one at a time or in batches.
+     * @throws EvioException if socketFd < 0 or file header cannot be sent.
+     */
+    SocketWriter::SocketWriter(int socketFd, const ByteOrder & order,
+                               uint32_t maxEventCount, uint32_t maxBufferSize,
+                               Compressor::CompressionType compressionType, SendMode mode) :
+            sock(socketFd), byteOrder(order), compressionType(compressionType), sendMode(mode) {
+
+        if (sock < 0) {
+            throw EvioException("bad socket");
+        }
+        configure(maxEventCount, maxBufferSize);
+    }
+
+
+    /** Destructor which calls {@link #close()}, ignoring errors. */
+    SocketWriter::~SocketWriter() {
+        try {
+            close();
+        }
+        catch (EvioException & e) {}
+    }
+
+
+    /**
+     * Connect to the given host and port.
+     * @param host name or dotted-decimal address of host to connect to.
+     * @param port TCP port to connect to.
+     * @throws EvioException if host cannot be found or connected to.
+     */
+    void SocketWriter::connectTo(std::string const & host, uint16_t port) {
+        struct addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        struct addrinfo *result = nullptr;
+        std::string service = std::to_string(port);
+        int err = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+        if (err != 0) {
+            throw EvioException("cannot find host " + host + ": " + gai_strerror(err));
+        }
+
+        for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                sock = fd;
+                break;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(result);
+
+        if (sock < 0) {
+            throw EvioException("cannot connect to " + host + ":" + service + ", " + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Set socket options, create the internal record and send the file header.
+     * @param maxEvents max number of events an internal record can hold, 0 for default.
+     * @param maxBytes max number of uncompressed data bytes an internal record can hold, 0 for default.
+     * @throws EvioException if file header cannot be sent.
+     */
+    void SocketWriter::configure(uint32_t maxEvents, uint32_t maxBytes) {
+        if (maxEvents > 0) maxEventCount = maxEvents;
+        if (maxBytes  > 0) maxBufferSize = maxBytes;
+
+        int on = 1;
+        if (sendMode == IMMEDIATE) {
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+#ifdef SO_NOSIGPIPE
+        setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        outputRecord = spareRecord();
+        sendFileHeader();
+    }
+
+
+    /**
+     * Set the size of the socket's send buffer (SO_SNDBUF).
+     * Larger buffers keep a fast link busy when records are large.
+     * @param bytes size of send buffer in bytes.
+     * @throws EvioException if socket closed or option cannot be set.
+     */
+    void SocketWriter::setSendBufferSize(int bytes) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+        if (setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) < 0) {
+            throw EvioException(std::string("cannot set send buffer size, ") + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * In {@link #BATCHED} mode, set the number of waiting bytes which cause them to be sent.
+     * @param bytes number of bytes, at least 1.
+     */
+    void SocketWriter::setMaxBatchBytes(size_t bytes) {
+        maxBatchBytes = bytes < 1 ? 1 : bytes;
+    }
+
+
+    /**
+     * Get a record to fill, reusing one already sent if possible.
+     * @return empty record.
+     */
+    std::shared_ptr<RecordOutput> SocketWriter::spareRecord() {
+        if (!spareRecords.empty()) {
+            auto rec = spareRecords.back();
+            spareRecords.pop_back();
+            rec->reset();
+            return rec;
+        }
+        auto rec = std::make_shared<RecordOutput>(byteOrder, maxEventCount, maxBufferSize, compressionType);
+        // Uncompressed events are sent straight from where they were added
+        rec->setGatherOutput(true);
+        return rec;
+    }
+
+
+    /**
+     * Add the parts of a built record to the buffers to be sent.
+     * @param record built record.
+     * @param segs vector used to hold the parts of the record.
+     * @param iov buffers to be sent.
+     */
+    void SocketWriter::addSegments(RecordOutput & record, std::vector<ByteBufferView> & segs,
+                                   std::vector<struct iovec> & iov) {
+        record.getSegments(segs);
+        for (auto & seg : segs) {
+            iov.push_back({const_cast<uint8_t *>(seg.data()), seg.size()});
+        }
+    }
+
+
+    /**
+     * Write the given buffers completely, retrying after partial writes and interruptions.
+     * The iovec array is modified.
+     * @param iov array of buffers.
+     * @param count number of buffers.
+     * @throws EvioException if socket closed or error writing.
+     */
+    void SocketWriter::sendAll(struct iovec *iov, int count) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+
+        while (count > 0) {
+            struct msghdr msg {};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+
+            ssize_t n = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw EvioException(std::string("error writing to socket, ") + std::strerror(errno));
+            }
+            bytesSent += n;
+
+            // Skip over what's been written
+            while (count > 0 && (size_t)n >= iov->iov_len) {
+                n -= iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + n;
+                iov->iov_len -= n;
+            }
+        }
+    }
+
+
+    /**
+     * Send the file header which starts the stream.
+     * @throws EvioException if error writing.
+     */
+    void SocketWriter::sendFileHeader() {
+        FileHeader fileHeader(true);
+        fileHeader.setBitInfo(false, false, false);
+        fileHeader.setUserHeaderLength(0);
+
+        auto buf = std::make_shared<ByteBuffer>(fileHeader.getLength());
+        buf->order(byteOrder);
+        fileHeader.writeHeader(buf, 0);
+
+        struct iovec iov;
+        iov.iov_base = buf->array();
+        iov.iov_len  = fileHeader.getLength();
+        sendAll(&iov, 1);
+    }
+
+
+    /**
+     * Send or queue a built record, depending on the send mode.
+     * This object keeps the record until it's sent.
+     * @param record built record.
+     * @throws EvioException if error writing.
+     */
+    void SocketWriter::sendBuiltRecord(std::shared_ptr<RecordOutput> & record) {
+        pendingRecords.push_back(record);
+        pendingBytes += record->getHeader()->getLength();
+
+        if (sendMode == IMMEDIATE || pendingBytes >= maxBatchBytes ||
+            pendingRecords.size() >= MAX_BATCH_RECORDS) {
+            sendPending();
+        }
+    }
+
+
+    /**
+     * Send all queued records with one system call.
+     * @throws EvioException if error writing.
+     */
+    void SocketWriter::sendPending() {
+        if (pendingRecords.empty()) return;
+
+        iovecs.clear();
+        for (auto & rec : pendingRecords) {
+            addSegments(*rec, segments, iovecs);
+        }
+        sendAll(iovecs.data(), iovecs.size());
+
+        for (auto & rec : pendingRecords) {
+            recordsSent++;
+            eventsSent += rec->getHeader()->getEntries();
+            spareRecords.push_back(rec);
+        }
+        pendingRecords.clear();
+        pendingBytes = 0;
+    }
+
+
+    /**
+     * Build the internal record, if it has any events, and send it.
+     * @throws EvioException if error writing.
+     */
+    void SocketWriter::sendInternalRecord() {
+        if (outputRecord->getEventCount() < 1) return;
+
+        auto & header = outputRecord->getHeader();
+        header->setCompressionType(compressionType);
+        header->setRecordNumber(recordNumber++);
+        outputRecord->build();
+
+        sendBuiltRecord(outputRecord);
+        outputRecord = spareRecord();
+    }
+
+
+    /**
+     * Add an event to the internal record, sending it first if the event does not fit.
+     * @param buffer array containing event.
+     * @param length length of event in bytes.
+     * @throws EvioException if closed, error writing, or event too large for a record.
+     */
+    void SocketWriter::addEvent(const uint8_t* buffer, uint32_t length) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+
+        if (!outputRecord->addEvent(buffer, length)) {
+            sendInternalRecord();
+            if (!outputRecord->addEvent(buffer, length)) {
+                throw EvioException("event too large for record");
+            }
+        }
+    }
+
+
+    /**
+     * Add an event to the internal record, sending it first if the event does not fit.
+     * The event is taken from the buffer's position to its limit.
+     * @param buffer buffer containing event.
+     * @throws EvioException if closed, error writing, or event too large for a record.
+     */
+    void SocketWriter::addEvent(ByteBuffer & buffer) {
+        addEvent(buffer.array() + buffer.arrayOffset() + buffer.position(), buffer.remaining());
+    }
+
+
+    /**
+     * Add an event to the internal record, sending it first if the event does not fit.
+     * The event is taken from the buffer's position to its limit.
+     * @param buffer buffer containing event.
+     * @throws EvioException if closed, error writing, or event too large for a record.
+     */
+    void SocketWriter::addEvent(std::shared_ptr<ByteBuffer> & buffer) {
+        addEvent(*buffer);
+    }
+
+
+    /**
+     * Build and send the given record right away, after any records already waiting.
+     * The record's compression type is kept, but it is given the next record number.
+     * If built for gathering (see {@link RecordOutput#setGatherOutput(bool)}),
+     * its parts are sent without being copied together.
+     * Events already added to the internal record are sent first to keep them in order.
+     * @param record record to send.
+     * @throws EvioException if closed or error writing.
+     */
+    void SocketWriter::writeRecord(RecordOutput & record) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+
+        sendInternalRecord();
+        sendPending();
+
+        auto & header = record.getHeader();
+        header->setRecordNumber(recordNumber++);
+        record.build();
+
+        iovecs.clear();
+        addSegments(record, segments, iovecs);
+        sendAll(iovecs.data(), iovecs.size());
+
+        recordsSent++;
+        eventsSent += header->getEntries();
+    }
+
+
+    /**
+     * Start a thread which sends every record that comes out of the given supply
+     * once it has been compressed, in place of a thread writing them to file.
+     * Records are reset and released back to the supply once sent.
+     * Records are sent in the order of the supply, keeping their record numbers.
+     * Events already added to this object are sent first.
+     * Call {@link #waitForSupply()} once the last record has been published.
+     *
+     * @param recordSupply supply of records to send.
+     * @throws EvioException if closed, already sending a supply, or error writing.
+     */
+    void SocketWriter::startSending(std::shared_ptr<RecordSupply> & recordSupply) {
+        if (closed) {
+            throw EvioException("writer closed");
+        }
+        if (supply != nullptr) {
+            throw EvioException("already sending a supply");
+        }
+
+        sendInternalRecord();
+        sendPending();
+
+        supply = recordSupply;
+        lastSeqProcessed = -1;
+        supplyError.clear();
+        supplyFailed = false;
+        supplyThread = boost::thread([this]() {this->runSupply();});
+    }
+
+
+    /**
+     * Wait for every record published to the supply to be sent, then stop the sending thread.
+     * @throws EvioException if the sending thread quit because of an error.
+     */
+    void SocketWriter::waitForSupply() {
+        if (supply == nullptr) return;
+
+        while (!supplyFailed && supply->getLastSequence() > lastSeqProcessed.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        supplyThread.interrupt();
+        supplyThread.join();
+        supply = nullptr;
+
+        if (supplyFailed) {
+            throw EvioException(supplyError);
+        }
+    }
+
+
+    /** Send records from the supply until interrupted. Run in supplyThread. */
+    void SocketWriter::runSupply() {
+        std::vector<ByteBufferView> segs;
+        std::vector<struct iovec> iov;
+        uint32_t maxCount = (sendMode == BATCHED) ? MAX_BATCH_RECORDS : 1;
+
+        try {
+            while (true) {
+
+                // Get the records ready to send, waiting for the first if necessary
+                int64_t first;
+                uint32_t count = supply->getToWrite(maxCount, first);
+
+                {
+                    // Only allow interruption when blocked on trying to get first item
+                    boost::this_thread::disable_interruption d1;
+
+                    // Send them in groups of up to maxBatchBytes
+                    int64_t end = first + count;
+                    while (first < end) {
+                        int64_t last = first;
+                        size_t bytes = 0;
+                        iov.clear();
+                        while (true) {
+                            auto & record = supply->getItem(last)->getRecord();
+                            addSegments(*record, segs, iov);
+                            bytes += record->getHeader()->getLength();
+                            if (last + 1 == end || bytes >= maxBatchBytes) break;
+                            last++;
+                        }
+                        sendAll(iov.data(), iov.size());
+
+                        for (int64_t seq = first; seq <= last; seq++) {
+                            auto & record = supply->getItem(seq)->getRecord();
+                            auto & header = record->getHeader();
+                            recordsSent++;
+                            eventsSent += header->getEntries();
+                            // Trailer follows the last record number used
+                            if (header->getRecordNumber() >= recordNumber) {
+                                recordNumber = header->getRecordNumber() + 1;
+                            }
+                            record->reset();
+                        }
+
+                        supply->releaseWriter(first, last - first + 1);
+                        lastSeqProcessed = last;
+                        first = last + 1;
+                    }
+                }
+            }
+        }
+        catch (boost::thread_interrupted & e) {}
+        catch (EvioException & e) {
+            supplyError = e.what();
+            supplyFailed = true;
+        }
+    }
+
+
+    /**
+     * Send everything waiting to be sent, including the partially filled internal record.
+     * @throws EvioException if error writing.
+     */
+    void SocketWriter::flush() {
+        if (closed) return;
+        sendInternalRecord();
+        sendPending();
+    }
+
+
+    /**
+     * Send everything waiting to be sent, followed by a trailer, then close the socket.
+     * Any supply being sent is waited on first.
+     * @throws EvioException if error writing.
+     */
+    void SocketWriter::close() {
+        if (closed) return;
+        closed = true;
+
+        try {
+            waitForSupply();
+            sendInternalRecord();
+            sendPending();
+
+            std::vector<uint8_t> trailer(RecordHeader::HEADER_SIZE_BYTES);
+            RecordHeader::writeTrailer(trailer, 0, recordNumber, byteOrder, nullptr);
+
+            struct iovec iov;
+            iov.iov_base = trailer.data();
+            iov.iov_len  = trailer.size();
+            sendAll(&iov, 1);
+        }
+        catch (EvioException & e) {
+            ::close(sock);
+            sock = -1;
+            throw;
+        }
+
+        ::close(sock);
+        sock = -1;
+    }
+
+}
@@ -0,0 +1,212 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SOCKETWRITER_H
+#define EVIO_6_0_SOCKETWRITER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <sys/uio.h>
+
+
+#include "boost/thread.hpp"
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "ByteOrder.h"
+#include "FileHeader.h"
+#include "RecordHeader.h"
+#include "RecordOutput.h"
+#include "RecordSupply.h"
+#include "RecordRingItem.h"
+#include "Compressor.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class writes evio version 6 data over a TCP socket to a {@link SocketReader}.
+     * The stream has the same format as a file: a file header, followed by records,
+     * followed by a trailer. That way, anything sent can also be saved on the other end
+     * and read as an ordinary evio file.<p>
+     *
+     * Events may be added one at a time, in which case they are collected into an internal
+     * record which is sent once full, or already built records may be written directly. Either
+     * way, records are sent in the way selected by the {@link SendMode}. When sending one
+     * at a time ({@link #IMMEDIATE}), Nagle's algorithm is turned off on the socket so each
+     * record leaves as soon as it's written. When batching ({@link #BATCHED}), several records
+     * are gathered and sent by a single writev-style system call once
+     * {@link #setMaxBatchBytes(size_t)} bytes are waiting, or when {@link #flush()} is called.
+     * Uncompressed records are sent by gathering their header, index and events from where
+     * they are, without first copying them into one buffer.<p>
+     *
+     * With {@link #startSending(std::shared_ptr<RecordSupply> &)}, this object takes the place
+     * of a file writing thread and sends records as they come out of a {@link RecordSupply},
+     * after any compression threads are done with them. Adding events and writing records
+     * directly must not be done while doing so.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class SocketWriter {
+
+    public:
+
+        /** How records are sent over the socket. */
+        enum SendMode {
+            /** Send each record as soon as it's complete with Nagle's algorithm off. */
+            IMMEDIATE = 0,
+            /** Gather records and send them with one system call. */
+            BATCHED
+        };
+
+    private:
+
+        /** Socket file descriptor, -1 if closed. */
+        int sock = -1;
+
+        /** Byte order of data sent. */
+        ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
+
+        /** Type of compression used on records this object builds. */
+        Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED;
+
+        /** How records are sent. */
+        SendMode sendMode = IMMEDIATE;
+
+        /** In BATCHED mode, number of bytes waiting which cause them to be sent. */
+        size_t maxBatchBytes = 4*1024*1024;
+
+        /** Max number of events an internal record can hold. */
+        uint32_t maxEventCount = 1000000;
+
+        /** Max number of uncompressed data bytes an internal record can hold. */
+        uint32_t maxBufferSize = 8*1024*1024;
+
+        /** Number which is incremented and stored with each successive record starting at 1. */
+        uint32_t recordNumber = 1;
+
+        /** Internal record that events are added to. */
+        std::shared_ptr<RecordOutput> outputRecord;
+
+        /** Built records waiting to be sent in BATCHED mode. */
+        std::vector<std::shared_ptr<RecordOutput>> pendingRecords;
+
+        /** Records already sent which may be reused. */
+        std::vector<std::shared_ptr<RecordOutput>> spareRecords;
+
+        /** Parts of records being sent, used by the calling thread. */
+        std::vector<ByteBufferView> segments;
+
+        /** Buffers being sent, used by the calling thread. */
+        std::vector<struct iovec> iovecs;
+
+        /** Number of bytes in pendingRecords. */
+        size_t pendingBytes = 0;
+
+        /** Total bytes sent. */
+        std::atomic<uint64_t> bytesSent {0};
+
+        /** Total records sent, not including the trailer. */
+        std::atomic<uint64_t> recordsSent {0};
+
+        /** Total events sent. */
+        std::atomic<uint64_t> eventsSent {0};
+
+        /** Thread sending records from a supply. */
+        boost::thread supplyThread;
+
+        /** Supply being sent by supplyThread. */
+        std::shared_ptr<RecordSupply> supply;
+
+        /** Highest sequence of supply which has been sent. */
+        std::atomic_long lastSeqProcessed {-1};
+
+        /** Error stopping the supply thread, if any. */
+        std::string supplyError;
+
+        /** Set once supplyError is set. */
+        std::atomic_bool supplyFailed {false};
+
+        /** Has close() been called? */
+        bool closed = false;
+
+    public:
+
+        SocketWriter(std::string const & host, uint16_t port,
+                     const ByteOrder & order = ByteOrder::ENDIAN_LOCAL,
+                     uint32_t maxEventCount = 0, uint32_t maxBufferSize = 0,
+                     Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED,
+                     SendMode mode = IMMEDIATE);
+
+        explicit SocketWriter(int socketFd,
+                              const ByteOrder & order = ByteOrder::ENDIAN_LOCAL,
+                              uint32_t maxEventCount = 0, uint32_t maxBufferSize = 0,
+                              Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED,
+                              SendMode mode = IMMEDIATE);
+
+        SocketWriter(const SocketWriter & other) = delete;
+        SocketWriter & operator=(const SocketWriter & other) = delete;
+
+        ~SocketWriter();
+
+        void setSendBufferSize(int bytes);
+        void setMaxBatchBytes(size_t bytes);
+
+        /** @return how records are sent. */
+        SendMode getSendMode()      const {return sendMode;}
+        /** @return byte order of data sent. */
+        const ByteOrder & getByteOrder() const {return byteOrder;}
+        /** @return total bytes sent. */
+        uint64_t getBytesSent()     const {return bytesSent;}
+        /** @return total records sent, not including the trailer. */
+        uint64_t getRecordsSent()   const {return recordsSent;}
+        /** @return total events sent. */
+        uint64_t getEventsSent()    const {return eventsSent;}
+        /** @return true if close() has been called. */
+        bool isClosed()             const {return closed;}
+
+        void addEvent(const uint8_t* buffer, uint32_t length);
+        void addEvent(ByteBuffer & buffer);
+        void addEvent(std::shared_ptr<ByteBuffer> & buffer);
+
+        void writeRecord(RecordOutput & record);
+
+        void startSending(std::shared_ptr<RecordSupply> & recordSupply);
+        void waitForSupply();
+
+        void flush();
+        void close();
+
+    private:
+
+        void connectTo(std::string const & host, uint16_t port);
+        void configure(uint32_t maxEvents, uint32_t maxBytes);
+        void sendFileHeader();
+        void sendBuiltRecord(std::shared_ptr<RecordOutput> & record);
+        void sendPending();
+        void sendInternalRecord();
+        void runSupply();
+        void addSegments(RecordOutput & record, std::vector<ByteBufferView> & segs,
+                         std::vector<struct iovec> & iov);
+        void sendAll(struct iovec *iov, int count);
+
+        std::shared_ptr<RecordOutput> spareRecord();
+    };
+
+}
+
+
+#endif //EVIO_6_0_SOCKETWRITER_H
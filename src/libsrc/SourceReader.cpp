@@ -0,0 +1,485 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "SourceReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "Util.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which fetches the file header and the index of records.
+     *
+     * @param source           source of the file's bytes.
+     * @param parallelRequests max number of requests in flight at once. Values < 1 are set to 1.
+     * @param readAhead        number of records, past the one being read, to fetch ahead.
+     * @param maxRequestBytes  max bytes fetched by one request, unless a single record is larger.
+     * @throws EvioException if source is null, cannot be read,
+     *                       or is not in the proper format or earlier than version 6.
+     */
+    SourceReader::SourceReader(std::shared_ptr<ByteSource> source, uint32_t parallelRequests,
+                               uint32_t readAhead, size_t maxRequestBytes) :
+            source(std::move(source)), parallelRequests(parallelRequests < 1 ? 1 : parallelRequests),
+            readAhead(readAhead), maxRequestBytes(maxRequestBytes) {
+
+        if (this->source == nullptr) {
+            throw EvioException("null source");
+        }
+        sourceSize = this->source->getSize();
+        readIndex();
+
+        record = RecordInput(byteOrder);
+        record.setCompressionDictionary(compressionDictionary);
+    }
+
+
+    /** Destructor which waits for requests still in flight. */
+    SourceReader::~SourceReader() {
+        fetches.clear();
+    }
+
+
+    /**
+     * Fetch bytes from the source into a new buffer. May be run in another thread.
+     * @param position position in the source.
+     * @param length   number of bytes.
+     * @return buffer of the bytes, in the file's byte order.
+     * @throws EvioException if the bytes cannot be read.
+     */
+    std::shared_ptr<ByteBuffer> SourceReader::fetchRange(uint64_t position, size_t length) {
+        auto buf = std::make_shared<ByteBuffer>(length);
+        source->read(position, length, buf->array());
+        buf->order(byteOrder);
+
+        requestCount++;
+        bytesFetched += length;
+        return buf;
+    }
+
+
+    /**
+     * Fetch the file header, with its index and user header, then the trailer's index.
+     * Without either index, the record headers are fetched one by one.
+     * @throws EvioException if source cannot be read, or is not in the proper format.
+     */
+    void SourceReader::readIndex() {
+        if (sourceSize < FileHeader::HEADER_SIZE_BYTES) {
+            throw EvioException(source->getName() + " too small to be evio");
+        }
+
+        auto head = fetchRange(0, std::min<uint64_t>(sourceSize, HEADER_FETCH_BYTES));
+        fileHeader.readHeader(*head);
+        byteOrder = fileHeader.getByteOrder();
+        if (fileHeader.getVersion() < 6) {
+            throw EvioException(source->getName() + " is earlier than evio version 6");
+        }
+
+        // First record position (past file's header + index + user header)
+        uint64_t firstRecord = fileHeader.getLength();
+        if (firstRecord > sourceSize) {
+            throw EvioException(source->getName() + " too short to contain its file header");
+        }
+        if (firstRecord > head->capacity()) {
+            head = fetchRange(0, firstRecord);
+        }
+        head->order(byteOrder);
+        readCommonRecord(*head);
+
+        uint64_t trailerPos = fileHeader.getTrailerPosition();
+        bool useTrailer = fileHeader.hasTrailerWithIndex() && trailerPos > 0 &&
+                          trailerPos + RecordHeader::HEADER_SIZE_BYTES <= sourceSize;
+
+        if (useTrailer) {
+            size_t len = std::min<uint64_t>(sourceSize - trailerPos, HEADER_FETCH_BYTES);
+            auto tail = fetchRange(trailerPos, len);
+            RecordHeader trailer;
+            trailer.readHeader(*tail);
+
+            size_t needed = trailer.getHeaderLength() + trailer.getIndexLength();
+            if (needed > len) {
+                if (trailerPos + needed > sourceSize) {
+                    throw EvioException(source->getName() + " too short to contain its trailer");
+                }
+                tail = fetchRange(trailerPos, needed);
+            }
+            addIndex(tail->array() + trailer.getHeaderLength(), trailer.getIndexLength(), firstRecord);
+        }
+        else if (fileHeader.hasIndex()) {
+            addIndex(head->array() + fileHeader.getHeaderLength(), fileHeader.getIndexLength(), firstRecord);
+        }
+        else {
+            scanRecords(firstRecord);
+        }
+    }
+
+
+    /**
+     * Add the records of an index of record lengths and event counts.
+     * @param index       index, in the file's byte order.
+     * @param indexLength length of index in bytes.
+     * @param firstRecord position of the first record.
+     */
+    void SourceReader::addIndex(const uint8_t *index, uint32_t indexLength, uint64_t firstRecord) {
+        std::vector<uint32_t> intData(indexLength/4);
+        Util::toIntArray(reinterpret_cast<const char *>(index), indexLength, byteOrder, intData.data());
+
+        uint64_t position = firstRecord;
+        records.reserve(intData.size()/2);
+        firstEvents.assign(1, 0);
+        for (size_t i=0; i + 1 < intData.size(); i += 2) {
+            records.push_back({position, intData[i], intData[i+1]});
+            firstEvents.push_back(firstEvents.back() + intData[i+1]);
+            position += intData[i];
+        }
+    }
+
+
+    /**
+     * Find the records of a file without an index by fetching each record header.
+     * This takes one request per record, so remote files are best written with a trailer index.
+     * @param position position of the first record.
+     * @throws EvioException if source cannot be read.
+     */
+    void SourceReader::scanRecords(uint64_t position) {
+        firstEvents.assign(1, 0);
+        RecordHeader header;
+
+        while (position + RecordHeader::HEADER_SIZE_BYTES <= sourceSize) {
+            auto buf = fetchRange(position, RecordHeader::HEADER_SIZE_BYTES);
+            try {
+                header.readHeader(*buf);
+            }
+            catch (EvioException & e) {
+                break;
+            }
+
+            uint32_t len = header.getLength();
+            // A file still being written may end in a partial record
+            if (len < RecordHeader::HEADER_SIZE_BYTES || position + len > sourceSize ||
+                header.getHeaderType().isTrailer()) {
+                break;
+            }
+            records.push_back({position, len, header.getEntries()});
+            firstEvents.push_back(firstEvents.back() + header.getEntries());
+            position += len;
+
+            if (header.isLastRecord()) break;
+        }
+    }
+
+
+    /**
+     * Extract the dictionary, first event and compression dictionary from the record
+     * which is the file header's user header, if there is one.
+     * @param head buffer with the file header, index and user header.
+     */
+    void SourceReader::readCommonRecord(ByteBuffer & head) {
+        if (!fileHeader.hasDictionary() && !fileHeader.hasFirstEvent() &&
+            !fileHeader.hasCompressionDictionary()) {
+            return;
+        }
+
+        uint32_t userLen = fileHeader.getUserHeaderLength();
+        // 8 byte min for evio event, more for xml dictionary
+        if (userLen < 8) {
+            return;
+        }
+
+        RecordInput common(byteOrder);
+        try {
+            ByteBuffer userBuffer(userLen);
+            std::memcpy(userBuffer.array(),
+                        head.array() + fileHeader.getHeaderLength() + fileHeader.getIndexLength(),
+                        userLen);
+            userBuffer.order(byteOrder);
+            common.readRecord(userBuffer, 0);
+        }
+        catch (EvioException & e) {
+            // Not in proper format
+            return;
+        }
+
+        uint32_t evIndex = 0;
+        uint32_t len;
+
+        // Dictionary always comes first in record
+        if (fileHeader.hasDictionary()) {
+            auto dict = common.getEvent(evIndex++, &len);
+            dictionaryXML = std::string(reinterpret_cast<const char *>(dict.get()), len);
+        }
+
+        // First event comes next
+        if (fileHeader.hasFirstEvent()) {
+            firstEvent = common.getEvent(evIndex++, &len);
+            firstEventSize = len;
+        }
+
+        // Compression dictionary is last
+        if (fileHeader.hasCompressionDictionary()) {
+            for (uint32_t i = common.getEntries(); i > evIndex; i--) {
+                auto bytes = common.getEvent(i - 1, &len);
+                if (CompressionDictionary::isCompressionDictionary(bytes.get(), len)) {
+                    try {
+                        compressionDictionary = CompressionDictionary::fromEvent(bytes.get(), len);
+                    }
+                    catch (EvioException & e) {
+                        // Records needing it cannot be decompressed, which is reported then
+                        compressionDictionary = nullptr;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+
+    /**
+     * Make sure the records from the given one through the read-ahead window are
+     * fetched or being fetched, with no more than parallelRequests requests at once.
+     * Records next to each other are fetched together up to maxRequestBytes.
+     * @param index index of record being read, which must be the first not yet dropped.
+     */
+    void SourceReader::fetchAhead(uint32_t index) {
+        uint32_t end = (uint32_t) std::min<uint64_t>(records.size(), (uint64_t)index + readAhead + 1);
+
+        while (fetches.size() < parallelRequests && nextToFetch < end) {
+            uint32_t first = nextToFetch;
+            uint32_t last  = first;
+            size_t bytes = 0;
+            while (last < end && (last == first || bytes + records[last].length <= maxRequestBytes)) {
+                bytes += records[last].length;
+                last++;
+            }
+
+            uint64_t position = records[first].position;
+            Fetch f;
+            f.first = first;
+            f.last  = last;
+            f.future = std::async(std::launch::async, [this, position, bytes]() {
+                return this->fetchRange(position, bytes);
+            });
+            fetches.push_back(std::move(f));
+            nextToFetch = last;
+        }
+    }
+
+
+    /**
+     * Read a record, fetching ahead the records following it.
+     * The record stays valid until another is read.
+     * @param index index of record.
+     * @return record read.
+     * @throws EvioException if index out of bounds, or record cannot be fetched or is malformed.
+     */
+    RecordInput & SourceReader::readRecord(uint32_t index) {
+        if (index >= records.size()) {
+            throw EvioException("index out of bounds");
+        }
+
+        if (haveRecord && recordIndex == index) {
+            return record;
+        }
+        haveRecord = false;
+
+        // Drop records before this one. If it's not among the rest, start over from it.
+        while (!fetches.empty() && fetches.front().last <= index) {
+            fetches.pop_front();
+        }
+        if (fetches.empty() || fetches.front().first > index) {
+            fetches.clear();
+            nextToFetch = index;
+        }
+        fetchAhead(index);
+
+        Fetch & f = fetches.front();
+        try {
+            if (f.buffer == nullptr) {
+                f.buffer = f.future.get();
+            }
+        }
+        catch (...) {
+            fetches.clear();
+            nextToFetch = index;
+            throw;
+        }
+
+        record.readRecord(*(f.buffer.get()), records[index].position - records[f.first].position);
+        recordIndex = index;
+        haveRecord = true;
+        return record;
+    }
+
+
+    /**
+     * Find the record holding an event.
+     * @param index of event in file.
+     * @return index of record.
+     */
+    uint32_t SourceReader::findRecord(uint32_t index) const {
+        // Last record starting at or before index, which skips over any with no events
+        auto it = std::upper_bound(firstEvents.begin(), firstEvents.end(), index);
+        return (uint32_t)(it - firstEvents.begin()) - 1;
+    }
+
+
+    /**
+     * Read the record holding an event.
+     * @param index         index of event in file.
+     * @param eventInRecord set to index of event in record.
+     * @return record read.
+     * @throws EvioException if record cannot be fetched or is malformed.
+     */
+    RecordInput & SourceReader::loadEventRecord(uint32_t index, uint32_t & eventInRecord) {
+        uint32_t recIndex = findRecord(index);
+        eventInRecord = index - firstEvents[recIndex];
+        return readRecord(recIndex);
+    }
+
+
+    /**
+     * Get the name of the source being read.
+     * @return name of source.
+     */
+    std::string SourceReader::getName() const {return source->getName();}
+
+
+    /**
+     * Get the byte order of the file.
+     * @return byte order of file.
+     */
+    const ByteOrder & SourceReader::getByteOrder() const {return byteOrder;}
+
+
+    /**
+     * Get the file header.
+     * @return file header.
+     */
+    FileHeader & SourceReader::getFileHeader() {return fileHeader;}
+
+
+    /**
+     * Get the number of events in the file.
+     * @return number of events in file.
+     */
+    uint32_t SourceReader::getEventCount() const {return firstEvents.back();}
+
+
+    /**
+     * Get the number of records in the file.
+     * @return number of records in file.
+     */
+    uint32_t SourceReader::getRecordCount() const {return (uint32_t)records.size();}
+
+
+    /**
+     * Get the xml format dictionary, if any.
+     * @return xml format dictionary, else an empty string.
+     */
+    std::string SourceReader::getDictionary() const {return dictionaryXML;}
+
+
+    /**
+     * Does the file have an xml format dictionary?
+     * @return true if file has an xml format dictionary.
+     */
+    bool SourceReader::hasDictionary() const {return !dictionaryXML.empty();}
+
+
+    /**
+     * Get the first event, if any.
+     * @param size pointer to int that gets filled with the first event's size in bytes.
+     * @return first event, else null.
+     */
+    std::shared_ptr<uint8_t> SourceReader::getFirstEvent(uint32_t *size) {
+        if (size != nullptr) *size = firstEventSize;
+        return firstEvent;
+    }
+
+
+    /**
+     * Does the file have a first event?
+     * @return true if file has a first event.
+     */
+    bool SourceReader::hasFirstEvent() const {return firstEvent != nullptr;}
+
+
+    /**
+     * Get a copy of an event.
+     * @param index index of event in file, starting at 0.
+     * @param len   pointer to int that gets filled with the event's length in bytes.
+     * @return event, or null if index is out of bounds.
+     * @throws EvioException if record cannot be fetched or is malformed.
+     */
+    std::shared_ptr<uint8_t> SourceReader::getEvent(uint32_t index, uint32_t *len) {
+        if (index >= getEventCount()) {
+            return nullptr;
+        }
+
+        uint32_t eventInRecord;
+        RecordInput & rec = loadEventRecord(index, eventInRecord);
+        return rec.getEvent(eventInRecord, len);
+    }
+
+
+    /**
+     * Get a view of an event without copying it.
+     * The view is valid only until another record is read.
+     * @param index index of event in file, starting at 0.
+     * @return view of the event's bytes, empty if index is out of bounds.
+     * @throws EvioException if record cannot be fetched or is malformed.
+     */
+    ByteBufferView SourceReader::getEventView(uint32_t index) {
+        if (index >= getEventCount()) {
+            return ByteBufferView();
+        }
+
+        uint32_t eventInRecord;
+        RecordInput & rec = loadEventRecord(index, eventInRecord);
+        return rec.getEventView(eventInRecord);
+    }
+
+
+    /**
+     * Get the length of an event.
+     * @param index index of event in file, starting at 0.
+     * @return length of event in bytes, 0 if index is out of bounds.
+     * @throws EvioException if record cannot be fetched or is malformed.
+     */
+    uint32_t SourceReader::getEventLength(uint32_t index) {
+        if (index >= getEventCount()) {
+            return 0;
+        }
+
+        uint32_t eventInRecord;
+        RecordInput & rec = loadEventRecord(index, eventInRecord);
+        return rec.getEventLength(eventInRecord);
+    }
+
+
+    /**
+     * Get the number of requests made to the source.
+     * @return number of requests made to the source.
+     */
+    uint64_t SourceReader::getRequestCount() const {return requestCount;}
+
+
+    /**
+     * Get the number of bytes fetched from the source.
+     * @return number of bytes fetched from the source.
+     */
+    uint64_t SourceReader::getBytesFetched() const {return bytesFetched;}
+
+}
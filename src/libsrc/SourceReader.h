@@ -0,0 +1,189 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_SOURCEREADER_H
+#define EVIO_6_0_SOURCEREADER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <future>
+#include <atomic>
+
+
+#include "ByteSource.h"
+#include "ByteOrder.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "FileHeader.h"
+#include "RecordHeader.h"
+#include "RecordInput.h"
+#include "CompressionDictionary.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads the events of an evio version 6 file through a {@link ByteSource},
+     * so that a file behind a remote gateway (XRootD, S3, ...) can be streamed instead of
+     * being staged to local disk first. Every access to the source is a range request,
+     * which is costly, so they are kept few and large:
+     * <ul>
+     *     <li>The file header, its index and user header are fetched first, in one request,
+     *         then the trailer and its index of records, in another. Only files without
+     *         an index are scanned, one request per record header.</li>
+     *     <li>Records next to each other are coalesced into one request of up to
+     *         maxRequestBytes.</li>
+     *     <li>As a record is read, the records following it, up to readAhead of them,
+     *         are fetched ahead by up to parallelRequests requests in flight at once.</li>
+     * </ul>
+     * Reading records in order thus rarely waits on the source. Jumping elsewhere in the file
+     * drops what was fetched ahead and starts over there.<p>
+     *
+     * Use an object of this class from one thread at a time.
+     */
+    class SourceReader {
+
+    public:
+
+        /** Default max number of requests in flight at once. */
+        static const uint32_t DEFAULT_PARALLEL_REQUESTS = 4;
+
+        /** Default number of records, past the one being read, to fetch ahead. */
+        static const uint32_t DEFAULT_READ_AHEAD = 16;
+
+        /** Default max bytes fetched by one request, unless a single record is larger. */
+        static const size_t DEFAULT_MAX_REQUEST_BYTES = 8*1024*1024;
+
+        /** Bytes fetched at the start and at the trailer, which usually hold everything needed. */
+        static const size_t HEADER_FETCH_BYTES = 64*1024;
+
+    private:
+
+        /** Place and size of a record in the file. */
+        struct RecordEntry {
+            /** Position in file. */
+            uint64_t position;
+            /** Length in bytes, header included. */
+            uint32_t length;
+            /** Number of events. */
+            uint32_t count;
+        };
+
+        /** Records fetched, or being fetched, by one request. */
+        struct Fetch {
+            /** Index of first record. */
+            uint32_t first;
+            /** Index of record past the last. */
+            uint32_t last;
+            /** Bytes of the records, once fetched. */
+            std::future<std::shared_ptr<ByteBuffer>> future;
+            /** Bytes of the records, once taken from future. */
+            std::shared_ptr<ByteBuffer> buffer = nullptr;
+        };
+
+        /** Source of file's bytes. */
+        std::shared_ptr<ByteSource> source;
+        /** Size of the source. */
+        uint64_t sourceSize = 0;
+
+        /** File header. */
+        FileHeader fileHeader;
+        /** Byte order of file. */
+        ByteOrder byteOrder {ByteOrder::ENDIAN_LOCAL};
+
+        /** Records in the file, in order. */
+        std::vector<RecordEntry> records;
+        /** Index of each record's first event in the file, with one more entry for the total. */
+        std::vector<uint32_t> firstEvents {0};
+
+        /** Xml dictionary, if any. */
+        std::string dictionaryXML;
+        /** First event, if any. */
+        std::shared_ptr<uint8_t> firstEvent = nullptr;
+        /** Size of first event in bytes. */
+        uint32_t firstEventSize = 0;
+        /** Trained dictionary needed to decompress records, else null. */
+        std::shared_ptr<CompressionDictionary> compressionDictionary = nullptr;
+
+        /** Max number of requests in flight at once. */
+        uint32_t parallelRequests;
+        /** Number of records to fetch ahead of the one being read. */
+        uint32_t readAhead;
+        /** Max bytes fetched by one request. */
+        size_t maxRequestBytes;
+
+        /** Requests fetched or in flight, in file order. */
+        std::deque<Fetch> fetches;
+        /** Index of the next record to fetch. */
+        uint32_t nextToFetch = 0;
+
+        /** Record read last, decompressed. */
+        RecordInput record;
+        /** Index of record read last. */
+        uint32_t recordIndex = 0;
+        /** Has a record been read? */
+        bool haveRecord = false;
+
+        /** Number of requests made to the source. */
+        std::atomic<uint64_t> requestCount{0};
+        /** Number of bytes fetched from the source. */
+        std::atomic<uint64_t> bytesFetched{0};
+
+        std::shared_ptr<ByteBuffer> fetchRange(uint64_t position, size_t length);
+        void readIndex();
+        void addIndex(const uint8_t *index, uint32_t indexLength, uint64_t firstRecord);
+        void scanRecords(uint64_t position);
+        void readCommonRecord(ByteBuffer & head);
+        void fetchAhead(uint32_t index);
+        uint32_t findRecord(uint32_t index) const;
+        RecordInput & loadEventRecord(uint32_t index, uint32_t & eventInRecord);
+
+    public:
+
+        explicit SourceReader(std::shared_ptr<ByteSource> source,
+                              uint32_t parallelRequests = DEFAULT_PARALLEL_REQUESTS,
+                              uint32_t readAhead = DEFAULT_READ_AHEAD,
+                              size_t maxRequestBytes = DEFAULT_MAX_REQUEST_BYTES);
+        ~SourceReader();
+
+        SourceReader(const SourceReader &) = delete;
+        SourceReader & operator=(const SourceReader &) = delete;
+
+        std::string getName() const;
+        const ByteOrder & getByteOrder() const;
+        FileHeader & getFileHeader();
+        uint32_t getEventCount() const;
+        uint32_t getRecordCount() const;
+
+        std::string getDictionary() const;
+        bool hasDictionary() const;
+        std::shared_ptr<uint8_t> getFirstEvent(uint32_t *size);
+        bool hasFirstEvent() const;
+
+        RecordInput & readRecord(uint32_t index);
+
+        std::shared_ptr<uint8_t> getEvent(uint32_t index, uint32_t *len);
+        ByteBufferView getEventView(uint32_t index);
+        uint32_t getEventLength(uint32_t index);
+
+        uint64_t getRequestCount() const;
+        uint64_t getBytesFetched() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_SOURCEREADER_H
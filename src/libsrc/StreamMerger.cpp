@@ -0,0 +1,360 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StreamMerger.h"
+
+#include <fstream>
+
+#include "RunReader.h"
+#include "Util.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor merging streams which are each a single file.
+     *
+     * @param files     names of files, one per stream.
+     * @param key       finds the key of each event.
+     * @param readAhead number of records of each stream to read and decompress ahead,
+     *                  0 for none.
+     * @throws EvioException if no files are given.
+     */
+    StreamMerger::StreamMerger(std::vector<std::string> const & files, KeyExtractor key,
+                               uint32_t readAhead) :
+            keyOf(std::move(key)), readAhead(readAhead) {
+
+        if (files.empty()) {
+            throw EvioException("no files given");
+        }
+
+        streams.resize(files.size());
+        for (size_t i=0; i < files.size(); i++) {
+            streams[i].files.push_back(files[i]);
+        }
+    }
+
+
+    /**
+     * Constructor merging streams which are each a list of split files.
+     *
+     * @param streamFiles names of each stream's files in split order.
+     * @param key         finds the key of each event.
+     * @param readAhead   number of records of each stream to read and decompress ahead,
+     *                    0 for none.
+     * @throws EvioException if no streams are given or a stream has no files.
+     */
+    StreamMerger::StreamMerger(std::vector<std::vector<std::string>> const & streamFiles,
+                               KeyExtractor key, uint32_t readAhead) :
+            keyOf(std::move(key)), readAhead(readAhead) {
+
+        if (streamFiles.empty()) {
+            throw EvioException("no streams given");
+        }
+
+        streams.resize(streamFiles.size());
+        for (size_t i=0; i < streamFiles.size(); i++) {
+            if (streamFiles[i].empty()) {
+                throw EvioException("no files given for stream " + std::to_string(i));
+            }
+            streams[i].files = streamFiles[i];
+        }
+    }
+
+
+    /**
+     * Constructor which finds the split files of each stream of a run, named the same way
+     * that {@link EventWriter} names them (see {@link RunReader#findSplitFiles}),
+     * or its single file if it was not split.
+     *
+     * @param baseName    base file name, as given to EventWriter.
+     * @param runNumber   run number.
+     * @param runType     run type, substituted for any "%s" in baseName.
+     * @param streamCount total number of streams.
+     * @param key         finds the key of each event.
+     * @param readAhead   number of records of each stream to read and decompress ahead,
+     *                    0 for none.
+     * @throws EvioException if streamCount is 0, or no files are found for a stream.
+     */
+    StreamMerger::StreamMerger(std::string const & baseName, uint32_t runNumber,
+                               std::string const & runType, uint32_t streamCount,
+                               KeyExtractor key, uint32_t readAhead) :
+            keyOf(std::move(key)), readAhead(readAhead) {
+
+        if (streamCount < 1) {
+            throw EvioException("no streams given");
+        }
+
+        std::string baseFileName;
+        int specifierCount = Util::generateBaseFileName(baseName, runType, baseFileName);
+
+        streams.resize(streamCount);
+        for (uint32_t i=0; i < streamCount; i++) {
+            streams[i].files = RunReader::findSplitFiles(baseName, runNumber, runType, i, streamCount);
+            if (streams[i].files.empty()) {
+                // Stream was not split into several files
+                std::string name = Util::generateFileName(baseFileName, specifierCount, runNumber,
+                                                          0, 0, i, streamCount);
+                if (std::ifstream(name).good()) {
+                    streams[i].files.push_back(name);
+                }
+            }
+            if (streams[i].files.empty()) {
+                throw EvioException("no files found for stream " + std::to_string(i) +
+                                    " of run " + std::to_string(runNumber) + " of " + baseName);
+            }
+        }
+    }
+
+
+    /** Destructor. */
+    StreamMerger::~StreamMerger() {close();}
+
+
+    /** Close all files. Nothing more can be merged. */
+    void StreamMerger::close() {
+        for (auto & s : streams) {
+            if (s.nextReader.valid()) {
+                try {
+                    s.nextReader.get()->close();
+                }
+                catch (std::exception & e) {
+                    // It was never read from
+                }
+            }
+            if (s.reader != nullptr) {
+                s.reader->close();
+                s.reader = nullptr;
+            }
+            s.record = nullptr;
+        }
+
+        heads = decltype(heads)();
+        lastStream = -1;
+        started = true;
+    }
+
+
+    /**
+     * Open a file, set to read ahead.
+     * @param file name of file.
+     * @return reader of file.
+     * @throws EvioException if file cannot be opened or is not evio version 6 format.
+     */
+    std::shared_ptr<Reader> StreamMerger::openFile(std::string const & file) const {
+        auto reader = std::make_shared<Reader>(file);
+        if (readAhead > 0) {
+            reader->setReadAhead(readAhead);
+        }
+        return reader;
+    }
+
+
+    /** Open the first file of each stream and find the key of its first event. */
+    void StreamMerger::start() {
+        started = true;
+
+        for (uint32_t i=0; i < streams.size(); i++) {
+            auto & s = streams[i];
+            s.reader = openFile(s.files[0]);
+            if (s.files.size() > 1) {
+                std::string name = s.files[1];
+                s.nextReader = std::async(std::launch::async, [this, name]() {return openFile(name);});
+            }
+
+            if (loadRecord(s)) {
+                findKey(s, 0, s.key);
+                heads.emplace(s.key, i);
+            }
+        }
+    }
+
+
+    /**
+     * Read the next record of a stream with any events, going on to its next file if needed.
+     * @param s stream.
+     * @return false if the stream has no more events.
+     * @throws EvioException if a file cannot be opened or read.
+     */
+    bool StreamMerger::loadRecord(Stream & s) {
+        s.record = nullptr;
+        s.eventCount = 0;
+        s.eventIndex = 0;
+
+        while (s.reader != nullptr) {
+            if (s.nextRecord < s.reader->getRecordCount()) {
+                s.reader->readRecord(s.nextRecord++);
+                s.record = &s.reader->getCurrentRecordStream();
+                s.eventCount = s.record->getEntries();
+                if (s.eventCount > 0) {
+                    return true;
+                }
+                continue;
+            }
+
+            // On to the next split file, opening the one after it in the background
+            s.reader->close();
+            s.reader = nullptr;
+            s.record = nullptr;
+            s.nextRecord = 0;
+
+            if (++s.fileIndex < s.files.size()) {
+                s.reader = s.nextReader.valid() ? s.nextReader.get() : openFile(s.files[s.fileIndex]);
+                if (s.fileIndex + 1 < s.files.size()) {
+                    std::string name = s.files[s.fileIndex + 1];
+                    s.nextReader = std::async(std::launch::async, [this, name]() {return openFile(name);});
+                }
+            }
+        }
+
+        return false;
+    }
+
+
+    /**
+     * Find the key of an event of a stream's current record.
+     * @param s     stream.
+     * @param index index of event in record.
+     * @param key   set to key of event, or left as is if event has none.
+     */
+    void StreamMerger::findKey(Stream & s, uint32_t index, uint64_t & key) {
+        if (!keyOf) return;
+        auto event = s.record->getEventView(index);
+        uint64_t k;
+        if (keyOf(event.data(), event.size(), event.order(), k)) {
+            key = k;
+        }
+    }
+
+
+    /**
+     * Move a stream past events merged and, if it has any left, put its next one on the heap.
+     * @param stream index of stream.
+     * @param events number of events merged.
+     * @throws EvioException if a file cannot be opened or read.
+     */
+    void StreamMerger::advance(uint32_t stream, uint32_t events) {
+        auto & s = streams[stream];
+        s.eventIndex += events;
+        if (s.eventIndex >= s.eventCount && !loadRecord(s)) {
+            return;
+        }
+        findKey(s, s.eventIndex, s.key);
+        heads.emplace(s.key, stream);
+    }
+
+
+    /**
+     * Get the next event of the merged streams.
+     * The view is valid only until the next call to this object.
+     * @return next event, empty if there are no more.
+     * @throws EvioException if a file cannot be opened or read.
+     */
+    ByteBufferView StreamMerger::getNextEvent() {
+        uint64_t key;
+        return getNextEvent(key);
+    }
+
+
+    /**
+     * Get the next event of the merged streams.
+     * The view is valid only until the next call to this object.
+     * @param key set to the key of the event returned.
+     * @return next event, empty if there are no more.
+     * @throws EvioException if a file cannot be opened or read.
+     */
+    ByteBufferView StreamMerger::getNextEvent(uint64_t & key) {
+        if (!started) {
+            start();
+        }
+
+        // The stream whose event was returned last is moved on now, so that that event's
+        // record isn't replaced before the caller is done with it.
+        if (lastStream >= 0) {
+            advance(lastStream, 1);
+            lastStream = -1;
+        }
+
+        if (heads.empty()) {
+            return ByteBufferView();
+        }
+
+        Head head = heads.top();
+        heads.pop();
+
+        auto & s = streams[head.second];
+        lastStream = head.second;
+        key = head.first;
+        eventsMerged++;
+        return s.record->getEventView(s.eventIndex);
+    }
+
+
+    /**
+     * Write all the events, not yet gotten, of the merged streams to an EventWriter.
+     * Each run of consecutive events of one record which come before the next event of all
+     * other streams is written as one block. The writer is neither flushed nor closed.
+     *
+     * @param writer writer of events.
+     * @return number of events written, less than all if the writer, writing to a buffer, is full.
+     * @throws EvioException if a file cannot be opened or read, or error writing.
+     */
+    uint64_t StreamMerger::mergeTo(EventWriter & writer) {
+        if (!started) {
+            start();
+        }
+
+        if (lastStream >= 0) {
+            advance(lastStream, 1);
+            lastStream = -1;
+        }
+
+        uint64_t written = 0;
+
+        while (!heads.empty()) {
+            Head head = heads.top();
+            heads.pop();
+
+            // This stream goes first until one of its events comes after the next of another
+            auto & s = streams[head.second];
+            auto first = s.record->getEventView(s.eventIndex);
+            const uint8_t *end = first.data() + first.size();
+            uint64_t key = head.first;
+
+            runLengths.clear();
+            runLengths.push_back(first.size());
+
+            for (uint32_t i = s.eventIndex + 1; i < s.eventCount; i++) {
+                auto event = s.record->getEventView(i);
+                findKey(s, i, key);
+                if (event.data() != end || (!heads.empty() && Head(key, head.second) > heads.top())) {
+                    break;
+                }
+                runLengths.push_back(event.size());
+                end += event.size();
+            }
+
+            auto count = (uint32_t) runLengths.size();
+            uint32_t n = writer.writeEvents(first.data(), runLengths.data(), count, first.order());
+            blocksWritten++;
+            eventsMerged += n;
+            written += n;
+
+            advance(head.second, n);
+            if (n < count) {
+                break;
+            }
+        }
+
+        return written;
+    }
+
+}
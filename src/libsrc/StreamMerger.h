@@ -0,0 +1,157 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STREAMMERGER_H
+#define EVIO_6_0_STREAMMERGER_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <queue>
+#include <utility>
+#include <functional>
+
+
+#include "Reader.h"
+#include "RecordInput.h"
+#include "RecordOutput.h"
+#include "EventWriter.h"
+#include "ByteBufferView.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class merges the parallel streams of a run, as written by an {@link EventWriter}
+     * with streamCount > 1, back into a single sequence ordered by a key taken from each
+     * event, such as its timestamp or event number. The events of each stream must already
+     * be in key order, as they are when written. A heap holding the next event of each
+     * stream gives a k-way merge in O(log k) time per event.<p>
+     *
+     * Each stream is one file or a list of split files, read by its own {@link Reader}
+     * whose records are read and decompressed ahead by a background thread
+     * (see {@link Reader#setReadAhead(uint32_t, size_t)}), while the next split file is opened
+     * in yet another. Merging to an EventWriter with {@link #mergeTo(EventWriter &)}
+     * hands over every run of consecutive events of one record, which comes before the next
+     * event of all other streams, as a single block
+     * (see {@link EventWriter#writeEvents(const uint8_t *, const uint32_t *, uint32_t, ByteOrder const &, bool)}).
+     * Streams which overlap little in time are thus copied almost record by record.<p>
+     *
+     * An event whose key cannot be found keeps its place in its stream, taking the key
+     * of the event before it. Keys which are equal are ordered by stream.
+     * Like {@link Reader}, this class is not thread-safe.
+     */
+    class StreamMerger {
+
+    public:
+
+        /**
+         * Finds the key of an event, returning false if it has none.
+         * See {@link RecordOutput#bankTimestamp(uint16_t)} for one taking it from a bank.
+         */
+        typedef RecordOutput::TimestampExtractor KeyExtractor;
+
+        /** Default number of records of each stream to read and decompress ahead. */
+        static const uint32_t DEFAULT_READ_AHEAD = 2;
+
+    private:
+
+        /** One stream being merged. */
+        struct Stream {
+            /** Names of the stream's files in split order. */
+            std::vector<std::string> files;
+            /** Index of file being read. */
+            uint32_t fileIndex = 0;
+            /** Reader of file being read. */
+            std::shared_ptr<Reader> reader;
+            /** Reader of next file being opened in another thread. */
+            std::future<std::shared_ptr<Reader>> nextReader;
+            /** Index of next record to read from reader. */
+            uint32_t nextRecord = 0;
+            /** Record being merged, owned by reader. */
+            RecordInput *record = nullptr;
+            /** Number of events in record being merged. */
+            uint32_t eventCount = 0;
+            /** Index in record of next event to merge. */
+            uint32_t eventIndex = 0;
+            /** Key of next event to merge. */
+            uint64_t key = 0;
+        };
+
+        /** Next event of a stream: its key and the stream's index. */
+        typedef std::pair<uint64_t, uint32_t> Head;
+
+        /** Streams being merged. */
+        std::vector<Stream> streams;
+        /** Finds the key of each event. */
+        KeyExtractor keyOf;
+        /** Number of records of each stream to read ahead. */
+        uint32_t readAhead;
+
+        /** Next event of each stream not yet finished, smallest key on top. */
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        /** Have the streams been opened? */
+        bool started = false;
+        /** Index of the stream whose event was returned last by getNextEvent, else -1. */
+        int32_t lastStream = -1;
+
+        /** Lengths of the events of a run handed to the writer. */
+        std::vector<uint32_t> runLengths;
+
+        /** Number of events merged. */
+        uint64_t eventsMerged = 0;
+        /** Number of blocks of events handed to an EventWriter. */
+        uint64_t blocksWritten = 0;
+
+        void start();
+        std::shared_ptr<Reader> openFile(std::string const & file) const;
+        bool loadRecord(Stream & s);
+        void findKey(Stream & s, uint32_t index, uint64_t & key);
+        void advance(uint32_t stream, uint32_t events);
+
+    public:
+
+        StreamMerger(std::vector<std::string> const & files, KeyExtractor key,
+                     uint32_t readAhead = DEFAULT_READ_AHEAD);
+
+        StreamMerger(std::vector<std::vector<std::string>> const & streamFiles, KeyExtractor key,
+                     uint32_t readAhead = DEFAULT_READ_AHEAD);
+
+        StreamMerger(std::string const & baseName, uint32_t runNumber, std::string const & runType,
+                     uint32_t streamCount, KeyExtractor key, uint32_t readAhead = DEFAULT_READ_AHEAD);
+
+        ~StreamMerger();
+
+        StreamMerger(const StreamMerger &) = delete;
+        StreamMerger & operator=(const StreamMerger &) = delete;
+
+        /** @return number of streams being merged. */
+        uint32_t getStreamCount()   const {return streams.size();}
+        /** @return number of events merged so far. */
+        uint64_t getEventsMerged()  const {return eventsMerged;}
+        /** @return number of blocks of events handed to an EventWriter so far. */
+        uint64_t getBlocksWritten() const {return blocksWritten;}
+
+        ByteBufferView getNextEvent();
+        ByteBufferView getNextEvent(uint64_t & key);
+        uint64_t mergeTo(EventWriter & writer);
+
+        void close();
+    };
+
+}
+
+
+#endif //EVIO_6_0_STREAMMERGER_H
@@ -0,0 +1,185 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRINGARRAYVIEW_H
+#define EVIO_6_0_STRINGARRAYVIEW_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+
+
+namespace evio {
+
+
+    /**
+     * Lightweight, read-only view of the strings of evio string array data (type CHARSTAR8),
+     * each a std::string_view of the bytes in place, so nothing is copied. Evio strings are each
+     * ended by a null and the whole array is padded with 1 to 4 ASCII 4's. In the legacy format,
+     * without a final 4, only one string exists ending at the first null.<p>
+     *
+     * The bytes are checked in one pass, 8 at a time, for the nulls and for any non-printing
+     * characters, written as a string array or not, as
+     * {@link Util#stringBuilderToStrings} would do. If the data is not in a valid format,
+     * the view holds one string with all the bytes and {@link #isBadFormat()} returns true.<p>
+     *
+     * The view follows the same lifetime rules as {@link ByteBufferView},
+     * it's valid only as long as the bytes it looks at are.
+     */
+    class StringArrayView {
+
+    private:
+
+        /** Strings viewed. */
+        std::vector<std::string_view> strings;
+
+        /** Is the data not in a valid evio string array format? */
+        bool badFormat = false;
+
+        /** Number of bytes up to and including the last null, not counting padding. */
+        size_t stringEnd = 0;
+
+
+        /**
+         * Find the first byte, at or past a given position, which is not a printing ASCII character.
+         * 8 bytes are checked at once, while all are printing.
+         *
+         * @param data   bytes to search.
+         * @param pos    position at which to start.
+         * @param length number of bytes in data.
+         * @return position of first non-printing character, or length if none.
+         */
+        static size_t skipPrintable(const uint8_t *data, size_t pos, size_t length) {
+            const uint64_t ones  = 0x0101010101010101ULL;
+            const uint64_t highs = 0x8080808080808080ULL;
+
+            for (; pos + 8 <= length; pos += 8) {
+                uint64_t x;
+                std::memcpy(&x, data + pos, 8);
+                // Is any byte < 32, or > 126 (127 or top bit set)?
+                uint64_t low  = (x - 32*ones) & ~x & highs;
+                uint64_t high = ((x + ones) | x) & highs;
+                if ((low | high) != 0) break;
+            }
+
+            while (pos < length && data[pos] >= 32 && data[pos] <= 126) {
+                pos++;
+            }
+            return pos;
+        }
+
+
+    public:
+
+        /** Default constructor of an empty view. */
+        StringArrayView() = default;
+
+        /**
+         * Constructor.
+         * @param data   raw evio string data, not including any header.
+         * @param length number of bytes of data.
+         */
+        StringArrayView(const uint8_t *data, size_t length) {
+            if (data == nullptr || length == 0) return;
+
+            const char *chars = reinterpret_cast<const char *>(data);
+            bool noEnding4 = (data[length - 1] != 4);
+            size_t first = 0, pos = 0;
+            badFormat = true;
+
+            while ((pos = skipPrintable(data, pos, length)) < length) {
+                uint8_t c = data[pos];
+
+                // One string for each null
+                if (c == 0) {
+                    strings.emplace_back(chars + first, pos - first);
+                    first = ++pos;
+                    // If evio v2 or 3, only 1 null terminated string exists
+                    // and padding is just junk or nonexistent.
+                    if (noEnding4) {
+                        badFormat = false;
+                        break;
+                    }
+                    continue;
+                }
+
+                // Allow tab & newline
+                if (c == 9 || c == 10) {
+                    pos++;
+                    continue;
+                }
+
+                // Anything else non-printing is bad unless after a null
+                // and it starts the padding of no more than four 4's
+                if (!strings.empty() && c == 4 && length - pos <= 4) {
+                    badFormat = false;
+                    for (size_t i = pos + 1; i < length; i++) {
+                        if (data[i] != 4) {
+                            badFormat = true;
+                            break;
+                        }
+                    }
+                }
+                break;
+            }
+
+            if (badFormat) {
+                strings.clear();
+                strings.emplace_back(chars, length);
+                return;
+            }
+
+            stringEnd = first;
+        }
+
+        /** @return number of strings viewed. */
+        size_t size()  const {return strings.size();}
+        /** @return true if no strings are viewed. */
+        bool empty()   const {return strings.empty();}
+        /** @return true if the data is not in a valid evio string array format,
+         *          in which case one string with all the data is viewed. */
+        bool isBadFormat() const {return badFormat;}
+        /** @return number of bytes up to and including the last null, not counting padding,
+         *          or 0 if bad format. */
+        size_t getStringEnd() const {return stringEnd;}
+
+        /** @param index index of string, unchecked. @return view of string. */
+        std::string_view operator[] (size_t index) const {return strings[index];}
+
+        /** @param index index of string. @return view of string.
+         *  @throws std::out_of_range if out of bounds. */
+        std::string_view at(size_t index) const {return strings.at(index);}
+
+        /** @return iterator to the first string. */
+        std::vector<std::string_view>::const_iterator begin() const {return strings.begin();}
+        /** @return iterator past the last string. */
+        std::vector<std::string_view>::const_iterator end()   const {return strings.end();}
+
+        /**
+         * Copy the strings viewed onto the end of a vector.
+         * @param vec vector to add strings to.
+         */
+        void appendTo(std::vector<std::string> & vec) const {
+            vec.reserve(vec.size() + strings.size());
+            for (auto const & s : strings) {
+                vec.emplace_back(s);
+            }
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRINGARRAYVIEW_H
@@ -0,0 +1,239 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StripeManifest.h"
+
+
+namespace evio {
+
+
+    /**
+     * Get the name of the manifest file belonging to a set of striped files.
+     * @param fileName name of first file of first stripe.
+     * @return name of its manifest file.
+     */
+    std::string StripeManifest::manifestName(std::string const & fileName) {
+        return fileName + ".stripes";
+    }
+
+
+    /** Remove all files and runs from this manifest, keeping the number of stripes. */
+    void StripeManifest::clear() {
+        for (auto & files : stripeFiles) files.clear();
+        runStripes.clear();
+        runCounts.clear();
+        eventCount = 0;
+    }
+
+
+    /**
+     * Add a file to the end of a stripe's list of files.
+     * @param stripe   stripe index.
+     * @param fileName name of file.
+     * @throws EvioException if stripe is out of range.
+     */
+    void StripeManifest::addFile(uint32_t stripe, std::string const & fileName) {
+        if (stripe >= stripeFiles.size()) {
+            throw EvioException("stripe " + std::to_string(stripe) + " out of range");
+        }
+        stripeFiles[stripe].push_back(fileName);
+    }
+
+
+    /**
+     * Add a run of events written to one stripe. If the previous run went
+     * to the same stripe, the two are merged.
+     * @param stripe stripe index.
+     * @param events number of events in run.
+     * @throws EvioException if stripe is out of range.
+     */
+    void StripeManifest::addRun(uint32_t stripe, uint32_t events) {
+        if (stripe >= stripeFiles.size()) {
+            throw EvioException("stripe " + std::to_string(stripe) + " out of range");
+        }
+        if (events == 0) return;
+
+        if (!runStripes.empty() && runStripes.back() == stripe) {
+            runCounts.back() += events;
+        }
+        else {
+            runStripes.push_back(stripe);
+            runCounts.push_back(events);
+        }
+        eventCount += events;
+    }
+
+
+    /**
+     * Write this manifest into a file.
+     * @param fileName name of file to write.
+     * @throws EvioException if file cannot be written.
+     */
+    void StripeManifest::write(std::string const & fileName) const {
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc | std::ios::out);
+        if (!file.is_open()) {
+            throw EvioException("cannot open manifest file " + fileName);
+        }
+
+        // Lay out the names section first since its length goes into the header
+        std::vector<uint32_t> names;
+        for (auto const & files : stripeFiles) {
+            names.push_back(files.size());
+            for (auto const & name : files) {
+                uint32_t words = (name.size() + 3) / 4;
+                names.push_back(name.size());
+                size_t pos = names.size();
+                names.resize(pos + words, 0);
+                std::memcpy(names.data() + pos, name.data(), name.size());
+            }
+        }
+
+        uint32_t header[HEADER_WORDS] = {MAGIC, VERSION, getStripeCount(), getRunCount(),
+                                         static_cast<uint32_t>(eventCount),
+                                         static_cast<uint32_t>(eventCount >> 32),
+                                         static_cast<uint32_t>(4*names.size()), 0};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+        uint32_t runs = getRunCount();
+        file.write(reinterpret_cast<const char *>(names.data()),      4*names.size());
+        file.write(reinterpret_cast<const char *>(runStripes.data()), 4*runs);
+        file.write(reinterpret_cast<const char *>(runCounts.data()),  4*runs);
+
+        file.close();
+        if (file.fail()) {
+            throw EvioException("error writing manifest file " + fileName);
+        }
+    }
+
+
+    /**
+     * Replace the contents of this manifest with those read from a file.
+     * On failure this manifest is left empty.
+     * @param fileName name of file to read.
+     * @return true if file was read, false if it does not exist or is not a valid manifest file.
+     */
+    bool StripeManifest::read(std::string const & fileName) {
+        stripeFiles.clear();
+        clear();
+
+        std::ifstream file(fileName, std::ios::binary | std::ios::in);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        uint32_t header[HEADER_WORDS];
+        file.read(reinterpret_cast<char *>(header), sizeof(header));
+        if (!file.good()) {
+            return false;
+        }
+
+        bool swap = false;
+        if (header[0] == SWAP_32(MAGIC)) {
+            swap = true;
+            for (uint32_t &word : header) word = SWAP_32(word);
+        }
+        if (header[0] != MAGIC || header[1] != VERSION || header[6] % 4 != 0) {
+            return false;
+        }
+
+        uint32_t stripes = header[2];
+        uint32_t runs    = header[3];
+        uint64_t events  = (static_cast<uint64_t>(header[5]) << 32) | header[4];
+
+        // Names are bytes, so only their counts and lengths get swapped
+        std::vector<uint32_t> names(header[6] / 4);
+        runStripes.resize(runs);
+        runCounts.resize(runs);
+
+        file.read(reinterpret_cast<char *>(names.data()),      4*names.size());
+        file.read(reinterpret_cast<char *>(runStripes.data()), 4*runs);
+        file.read(reinterpret_cast<char *>(runCounts.data()),  4*runs);
+        if (!file.good()) {
+            clear();
+            return false;
+        }
+
+        if (swap) {
+            for (uint32_t &val : runStripes) val = SWAP_32(val);
+            for (uint32_t &val : runCounts)  val = SWAP_32(val);
+        }
+
+        size_t pos = 0;
+        stripeFiles.resize(stripes);
+        for (uint32_t i=0; i < stripes; i++) {
+            if (pos >= names.size()) {
+                stripeFiles.clear();
+                clear();
+                return false;
+            }
+            uint32_t fileCount = swap ? SWAP_32(names[pos]) : names[pos];
+            pos++;
+
+            for (uint32_t j=0; j < fileCount; j++) {
+                if (pos >= names.size()) {
+                    stripeFiles.clear();
+                    clear();
+                    return false;
+                }
+                uint32_t len = swap ? SWAP_32(names[pos]) : names[pos];
+                pos++;
+                uint32_t words = (len + 3) / 4;
+                if (pos + words > names.size()) {
+                    stripeFiles.clear();
+                    clear();
+                    return false;
+                }
+                stripeFiles[i].emplace_back(reinterpret_cast<const char *>(names.data() + pos), len);
+                pos += words;
+            }
+        }
+
+        // Run stripes and event counts must agree with the header
+        uint64_t total = 0;
+        for (uint32_t i=0; i < runs; i++) {
+            if (runStripes[i] >= stripes) {
+                stripeFiles.clear();
+                clear();
+                return false;
+            }
+            total += runCounts[i];
+        }
+        if (total != events) {
+            stripeFiles.clear();
+            clear();
+            return false;
+        }
+
+        eventCount = events;
+        return true;
+    }
+
+
+    /**
+     * Obtain a string representation of this manifest.
+     * @return string representation of this manifest.
+     */
+    std::string StripeManifest::toString() const {
+        std::stringstream ss;
+        ss << "StripeManifest of " << getStripeCount() << " stripes, " << getRunCount() <<
+              " runs, " << eventCount << " events" << std::endl;
+        for (uint32_t i=0; i < getStripeCount(); i++) {
+            ss << "  stripe " << i << ":" << std::endl;
+            for (auto const & name : stripeFiles[i]) {
+                ss << "    " << name << std::endl;
+            }
+        }
+        for (uint32_t i=0; i < getRunCount(); i++) {
+            ss << "  run " << i << ": stripe = " << runStripes[i] << ", events = " << runCounts[i] << std::endl;
+        }
+        return ss.str();
+    }
+
+}
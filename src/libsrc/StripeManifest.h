@@ -0,0 +1,116 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRIPEMANIFEST_H
+#define EVIO_6_0_STRIPEMANIFEST_H
+
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+
+
+#include "EvioException.h"
+#include "ByteOrder.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is the manifest of a set of striped files written by {@link StripedEventWriter}.
+     * Events are written in consecutive runs, each run going into the files of a single stripe.
+     * The manifest lists the files of each stripe in split order, followed by the stripe and
+     * number of events of every run, so that {@link StripedReader} can put events back
+     * into the order in which they were written.<p>
+     *
+     * The manifest file is in local byte order, which is detected by its magic number when read.
+     * It consists of an 8 word header followed by the file names and parallel arrays:
+     * <pre><code>
+     *    word 0     magic # (0x4556534D, "EVSM")
+     *    word 1     version
+     *    word 2     number of stripes
+     *    word 3     number of runs
+     *    word 4,5   64 bit total number of events
+     *    word 6     number of bytes in file name section
+     *    word 7     reserved
+     *
+     *    for each stripe: number of files, then for each file its name's length
+     *                     in bytes followed by the name padded to a 4-byte boundary
+     *    stripe of each run
+     *    number of events in each run
+     * </code></pre>
+     */
+    class StripeManifest {
+
+    public:
+
+        /** Magic number identifying a manifest file ("EVSM"). */
+        static const uint32_t MAGIC = 0x4556534D;
+        /** Version of the manifest file format. */
+        static const uint32_t VERSION = 1;
+        /** Number of 32-bit words in the manifest file header. */
+        static const uint32_t HEADER_WORDS = 8;
+
+    private:
+
+        /** Names of the files of each stripe in split order. */
+        std::vector<std::vector<std::string>> stripeFiles;
+
+        /** Stripe of each run. */
+        std::vector<uint32_t> runStripes;
+        /** Number of events in each run. */
+        std::vector<uint32_t> runCounts;
+
+        /** Total number of events in all runs. */
+        uint64_t eventCount = 0;
+
+    public:
+
+        /**
+         * Constructor.
+         * @param stripes number of stripes.
+         */
+        explicit StripeManifest(uint32_t stripes = 0) : stripeFiles(stripes) {}
+
+        static std::string manifestName(std::string const & fileName);
+
+        void clear();
+
+        void addFile(uint32_t stripe, std::string const & fileName);
+        void addRun(uint32_t stripe, uint32_t events);
+
+        void write(std::string const & fileName) const;
+        bool read(std::string const & fileName);
+
+        /** @return number of stripes. */
+        uint32_t getStripeCount()     const {return stripeFiles.size();}
+        /** @return number of runs. */
+        uint32_t getRunCount()        const {return runStripes.size();}
+        /** @return total number of events. */
+        uint64_t getEventCount()      const {return eventCount;}
+
+        /** @param stripe stripe index. @return names of stripe's files in split order. */
+        std::vector<std::string> const & getFiles(uint32_t stripe) const {return stripeFiles[stripe];}
+        /** @param run run index. @return stripe of run. */
+        uint32_t getRunStripe(uint32_t run)     const {return runStripes[run];}
+        /** @param run run index. @return number of events in run. */
+        uint32_t getRunEventCount(uint32_t run) const {return runCounts[run];}
+
+        std::string toString() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRIPEMANIFEST_H
@@ -0,0 +1,262 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StripedEventWriter.h"
+#include "RunReader.h"
+
+
+namespace evio {
+
+
+    /**
+     * Create a writer of one stripe per given directory. All parameters but the directories
+     * are passed on to each stripe's {@link EventWriter}. Stripe k uses stream id k and a
+     * stream count equal to the number of directories.
+     *
+     * @param baseName           base file name used to generate complete file names.
+     * @param directories        directory of each stripe, ideally each on a different device.
+     * @param runType            run type, substituted for any "%s" in baseName.
+     * @param runNumber          number of the CODA run.
+     * @param split              if &lt; 1, do not split files, else split each stripe's files
+     *                           when they reach this size in bytes.
+     * @param maxRecordSize      max number of uncompressed data bytes each record can hold.
+     * @param maxEventCount      max number of events each record can hold.
+     * @param byteOrder          the byte order in which to write the data.
+     * @param xmlDictionary      dictionary in xml format or empty if none.
+     * @param overWriteOK        if false and a file already exists, an exception is thrown.
+     * @param firstEvent         the first event written into each file (after any dictionary).
+     * @param splitNumber        number at which to start the split numbers.
+     * @param splitIncrement     amount by which to increment the split number each time.
+     * @param compressionType    type of data compression to do (one, lz4 fast, lz4 best, gzip).
+     * @param compressionThreads number of threads doing compression simultaneously in each stripe.
+     * @param ringSize           number of records in each stripe's supply ring.
+     * @param bufferSize         number of bytes to make each internal buffer which will
+     *                           be storing events before writing them to a file.
+     * @throws EvioException if no directories are given, or a stripe's writer cannot be created.
+     */
+    StripedEventWriter::StripedEventWriter(std::string const & baseName,
+                                           std::vector<std::string> const & directories,
+                                           const std::string & runType, uint32_t runNumber, uint64_t split,
+                                           uint32_t maxRecordSize, uint32_t maxEventCount,
+                                           const ByteOrder & byteOrder, const std::string & xmlDictionary,
+                                           bool overWriteOK, std::shared_ptr<EvioBank> firstEvent,
+                                           uint32_t splitNumber, uint32_t splitIncrement,
+                                           Compressor::CompressionType compressionType,
+                                           uint32_t compressionThreads, uint32_t ringSize,
+                                           uint32_t bufferSize) :
+            runType(runType), runNumber(runNumber), split(split),
+            splitNumber(splitNumber), splitIncrement(splitIncrement),
+            manifest(directories.size()) {
+
+        if (directories.empty()) {
+            throw EvioException("no stripe directories given");
+        }
+
+        // Move on after about one record's worth of events
+        stripeBytes = maxRecordSize > 0 ? std::min(maxRecordSize, DEFAULT_STRIPE_BYTES) : DEFAULT_STRIPE_BYTES;
+
+        uint32_t stripes = directories.size();
+        for (uint32_t i=0; i < stripes; i++) {
+            writers.push_back(std::make_shared<EventWriter>(baseName, directories[i], runType, runNumber,
+                                                            split, maxRecordSize, maxEventCount, byteOrder,
+                                                            xmlDictionary, overWriteOK, false, firstEvent,
+                                                            i, splitNumber, splitIncrement, stripes,
+                                                            compressionType, compressionThreads,
+                                                            ringSize, bufferSize));
+            baseNames.push_back(directories[i].empty() ? baseName : directories[i] + "/" + baseName);
+        }
+
+        manifestFileName = StripeManifest::manifestName(writers[0]->getCurrentFilename());
+    }
+
+
+    /** Destructor. Closes all stripes and writes the manifest if not done already. */
+    StripedEventWriter::~StripedEventWriter() {
+        try {
+            close();
+        }
+        catch (EvioException & e) {
+            std::cout << "StripedEventWriter: error closing, " << e.what() << std::endl;
+        }
+    }
+
+
+    /**
+     * Set the number of bytes of events written to one stripe before moving on to the next.
+     * Values near the record size keep each stripe's records full.
+     * @param bytes number of bytes, if 0 the default is used.
+     */
+    void StripedEventWriter::setStripeBytes(uint32_t bytes) {
+        stripeBytes = bytes > 0 ? bytes : DEFAULT_STRIPE_BYTES;
+    }
+
+
+    /**
+     * Get the writer of a single stripe.
+     * @param stripe stripe index.
+     * @return writer of stripe.
+     * @throws EvioException if stripe is out of range.
+     */
+    std::shared_ptr<EventWriter> StripedEventWriter::getWriter(uint32_t stripe) {
+        if (stripe >= writers.size()) {
+            throw EvioException("stripe " + std::to_string(stripe) + " out of range");
+        }
+        return writers[stripe];
+    }
+
+
+    /**
+     * Write an event, contained in a buffer, to the current stripe.
+     * @param bankBuffer buffer containing event to write, from its position to its limit.
+     * @param force      if true, force the stripe to write the event's record to disk.
+     * @return true if event was written, false if the stripe's disk is full.
+     * @throws EvioException if this writer is closed, or as thrown by {@link EventWriter}.
+     */
+    bool StripedEventWriter::writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer, bool force) {
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+        uint32_t bytes = bankBuffer->remaining();
+        if (!writers[currentStripe]->writeEvent(bankBuffer, force)) return false;
+        eventWritten(bytes);
+        return true;
+    }
+
+
+    /**
+     * Write an event to the current stripe.
+     * @param bank  event to write.
+     * @param force if true, force the stripe to write the event's record to disk.
+     * @return true if event was written, false if the stripe's disk is full.
+     * @throws EvioException if this writer is closed, or as thrown by {@link EventWriter}.
+     */
+    bool StripedEventWriter::writeEvent(std::shared_ptr<EvioBank> bank, bool force) {
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+        uint32_t bytes = bank->getTotalBytes();
+        if (!writers[currentStripe]->writeEvent(bank, force)) return false;
+        eventWritten(bytes);
+        return true;
+    }
+
+
+    /**
+     * Write an event, described by an EvioNode, to the current stripe.
+     * @param node  node of event to write.
+     * @param force if true, force the stripe to write the event's record to disk.
+     * @return true if event was written, false if the stripe's disk is full.
+     * @throws EvioException if this writer is closed, or as thrown by {@link EventWriter}.
+     */
+    bool StripedEventWriter::writeEvent(std::shared_ptr<EvioNode> & node, bool force) {
+        if (closed) {
+            throw EvioException("close() has already been called");
+        }
+        uint32_t bytes = node->getTotalBytes();
+        if (!writers[currentStripe]->writeEvent(node, force)) return false;
+        eventWritten(bytes);
+        return true;
+    }
+
+
+    /**
+     * Count an event written to the current stripe and move on to the
+     * next stripe once enough bytes have gone into this one.
+     * @param bytes size of event in bytes.
+     */
+    void StripedEventWriter::eventWritten(uint32_t bytes) {
+        runEvents++;
+        runBytes += bytes;
+        eventsWritten++;
+
+        if (runBytes >= stripeBytes) {
+            nextStripe();
+        }
+    }
+
+
+    /** End the current run of events and pick the stripe to write the next run to. */
+    void StripedEventWriter::nextStripe() {
+        manifest.addRun(currentStripe, runEvents);
+        runEvents = 0;
+        runBytes  = 0;
+
+        uint32_t stripes = writers.size();
+        if (stripes < 2) return;
+
+        if (policy == LEAST_LOADED) {
+            // Look at the others in turn so ties go round robin
+            uint32_t best = (currentStripe + 1) % stripes;
+            uint32_t leastLoad = writers[best]->getMetrics().ringOccupancy;
+            for (uint32_t i=2; i < stripes && leastLoad > 0; i++) {
+                uint32_t stripe = (currentStripe + i) % stripes;
+                uint32_t load = writers[stripe]->getMetrics().ringOccupancy;
+                if (load < leastLoad) {
+                    leastLoad = load;
+                    best = stripe;
+                }
+            }
+            currentStripe = best;
+        }
+        else {
+            currentStripe = (currentStripe + 1) % stripes;
+        }
+    }
+
+
+    /** Flush the events of all stripes to their files. */
+    void StripedEventWriter::flush() {
+        if (closed) return;
+        for (auto & w : writers) {
+            w->flush();
+        }
+    }
+
+
+    /**
+     * Close all stripes and write the manifest.
+     * Calling this more than once has no effect.
+     * @throws EvioException if manifest cannot be written.
+     */
+    void StripedEventWriter::close() {
+        if (closed) return;
+        closed = true;
+
+        manifest.addRun(currentStripe, runEvents);
+        runEvents = 0;
+        runBytes  = 0;
+
+        for (auto & w : writers) {
+            w->close();
+        }
+
+        addFilesToManifest();
+        manifest.write(manifestFileName);
+    }
+
+
+    /** Add the names of all files written by each stripe to the manifest. */
+    void StripedEventWriter::addFilesToManifest() {
+        uint32_t stripes = writers.size();
+        for (uint32_t i=0; i < stripes; i++) {
+            if (split < 1) {
+                manifest.addFile(i, writers[i]->getCurrentFilename());
+                continue;
+            }
+
+            auto files = RunReader::findSplitFiles(baseNames[i], runNumber, runType, i, stripes,
+                                                   splitNumber, splitIncrement);
+            for (auto const & name : files) {
+                manifest.addFile(i, name);
+            }
+        }
+    }
+
+}
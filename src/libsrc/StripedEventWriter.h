@@ -0,0 +1,172 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRIPEDEVENTWRITER_H
+#define EVIO_6_0_STRIPEDEVENTWRITER_H
+
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+
+
+#include "EventWriter.h"
+#include "StripeManifest.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class writes events into K evio files at once, each on its own disk or mount point,
+     * to get past the bandwidth limit of a single device. Each of these "stripes" is an
+     * independent {@link EventWriter}, with its own compression threads, record ring
+     * and file writing thread, and splits its files on its own.<p>
+     *
+     * Events go to one stripe until roughly a record's worth of bytes (see
+     * {@link #setStripeBytes(uint32_t)}) has been written to it, then the next stripe takes over.
+     * It is either the next one in turn or, in the LEAST_LOADED policy, the one with the fewest
+     * records waiting to be written. Each of these runs of events is kept in a
+     * {@link StripeManifest} which is written next to the first file of the first stripe when
+     * this writer is closed. {@link StripedReader} uses it to read all events back in the order
+     * they were written.<p>
+     *
+     * Stripe k uses stream id k and a stream count of K, so the default file naming adds
+     * the stripe to each file's name (see {@link Util#generateFileName}).
+     * Like {@link EventWriter}, this class is not thread-safe.
+     */
+    class StripedEventWriter {
+
+    public:
+
+        /** How to pick the stripe to write the next run of events to. */
+        enum StripePolicy {
+            /** Each stripe in turn. */
+            ROUND_ROBIN = 0,
+            /** Stripe with the fewest records waiting to be written. */
+            LEAST_LOADED
+        };
+
+        /** Default number of bytes of events written to one stripe before moving on, if not set otherwise. */
+        static const uint32_t DEFAULT_STRIPE_BYTES = 8000000;
+
+    private:
+
+        /** Writer of each stripe. */
+        std::vector<std::shared_ptr<EventWriter>> writers;
+
+        /** Base file name, including directory, of each stripe. */
+        std::vector<std::string> baseNames;
+
+        /** Run type, substituted for any "%s" in base file names. */
+        std::string runType;
+
+        /** Run number. */
+        uint32_t runNumber;
+
+        /** Split size in bytes, 0 if not splitting. */
+        uint64_t split;
+
+        /** Number of first split file. */
+        uint32_t splitNumber;
+
+        /** Amount split number increases from one file to the next. */
+        uint32_t splitIncrement;
+
+        /** Files and event runs of all stripes. */
+        StripeManifest manifest;
+
+        /** Name of manifest file, by default next to first file of first stripe. */
+        std::string manifestFileName;
+
+        /** Policy used to pick the next stripe. */
+        StripePolicy policy = ROUND_ROBIN;
+
+        /** Number of bytes of events written to one stripe before moving on. */
+        uint32_t stripeBytes;
+
+        /** Stripe currently written to. */
+        uint32_t currentStripe = 0;
+
+        /** Number of events in current run. */
+        uint32_t runEvents = 0;
+
+        /** Number of bytes in current run. */
+        uint64_t runBytes = 0;
+
+        /** Total number of events written. */
+        uint64_t eventsWritten = 0;
+
+        /** Has close() been called? */
+        bool closed = false;
+
+    public:
+
+        StripedEventWriter(std::string const & baseName, std::vector<std::string> const & directories,
+                           const std::string & runType, uint32_t runNumber, uint64_t split,
+                           uint32_t maxRecordSize, uint32_t maxEventCount,
+                           const ByteOrder & byteOrder = ByteOrder::nativeOrder(),
+                           const std::string & xmlDictionary = "", bool overWriteOK = true,
+                           std::shared_ptr<EvioBank> firstEvent = nullptr,
+                           uint32_t splitNumber = 0, uint32_t splitIncrement = 1,
+                           Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED,
+                           uint32_t compressionThreads = 1, uint32_t ringSize = 16,
+                           uint32_t bufferSize = 0);
+
+        ~StripedEventWriter();
+
+        StripedEventWriter(const StripedEventWriter &) = delete;
+        StripedEventWriter & operator=(const StripedEventWriter &) = delete;
+
+        void setStripeBytes(uint32_t bytes);
+        /** @return number of bytes of events written to one stripe before moving on. */
+        uint32_t getStripeBytes()      const {return stripeBytes;}
+
+        /** @param p policy used to pick the next stripe. */
+        void setStripePolicy(StripePolicy p) {policy = p;}
+        /** @return policy used to pick the next stripe. */
+        StripePolicy getStripePolicy() const {return policy;}
+
+        /** @param fileName name of manifest file, written when this writer is closed. */
+        void setManifestName(std::string const & fileName) {manifestFileName = fileName;}
+        /** @return name of manifest file, written when this writer is closed. */
+        std::string const & getManifestName() const {return manifestFileName;}
+
+        /** @return number of stripes. */
+        uint32_t getStripeCount()      const {return writers.size();}
+        /** @return total number of events written. */
+        uint64_t getEventsWritten()    const {return eventsWritten;}
+        /** @return stripe currently being written to. */
+        uint32_t getCurrentStripe()    const {return currentStripe;}
+        /** @return files and event runs written so far. */
+        StripeManifest const & getManifest() const {return manifest;}
+
+        std::shared_ptr<EventWriter> getWriter(uint32_t stripe);
+
+        bool writeEvent(std::shared_ptr<ByteBuffer> & bankBuffer, bool force = false);
+        bool writeEvent(std::shared_ptr<EvioBank> bank, bool force = false);
+        bool writeEvent(std::shared_ptr<EvioNode> & node, bool force = false);
+
+        void flush();
+        void close();
+
+    private:
+
+        void eventWritten(uint32_t bytes);
+        void nextStripe();
+        void addFilesToManifest();
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRIPEDEVENTWRITER_H
@@ -0,0 +1,144 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StripedReader.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor.
+     * @param manifestFile name of manifest file written by {@link StripedEventWriter}.
+     * @param prefetch     if true, each stripe opens its next file in another thread
+     *                     while reading the current one.
+     * @throws EvioException if manifest cannot be read, a stripe's files cannot be read,
+     *                       or they hold fewer events than the manifest says.
+     */
+    StripedReader::StripedReader(std::string const & manifestFile, bool prefetch) {
+        if (!manifest.read(manifestFile)) {
+            throw EvioException("cannot read manifest file " + manifestFile);
+        }
+
+        uint32_t stripes = manifest.getStripeCount();
+        for (uint32_t i=0; i < stripes; i++) {
+            auto const & files = manifest.getFiles(i);
+            readers.push_back(files.empty() ? nullptr : std::make_shared<RunReader>(files, prefetch));
+        }
+
+        // Number each run globally and within its stripe
+        std::vector<uint64_t> stripeEvents(stripes, 0);
+        uint32_t runs = manifest.getRunCount();
+        stripeFirstEvents.reserve(runs);
+        firstEvents.reserve(runs + 1);
+        for (uint32_t i=0; i < runs; i++) {
+            uint32_t stripe = manifest.getRunStripe(i);
+            uint32_t count  = manifest.getRunEventCount(i);
+            stripeFirstEvents.push_back(stripeEvents[stripe]);
+            stripeEvents[stripe] += count;
+            firstEvents.push_back(firstEvents.back() + count);
+        }
+
+        for (uint32_t i=0; i < stripes; i++) {
+            uint64_t available = readers[i] == nullptr ? 0 : readers[i]->getEventCount();
+            if (available < stripeEvents[i]) {
+                throw EvioException("stripe " + std::to_string(i) + " has " + std::to_string(available) +
+                                    " events, manifest expects " + std::to_string(stripeEvents[i]));
+            }
+        }
+    }
+
+
+    /** Close the files of all stripes. */
+    void StripedReader::close() {
+        for (auto & r : readers) {
+            if (r != nullptr) r->close();
+        }
+    }
+
+
+    /**
+     * Get the reader of a single stripe.
+     * @param stripe stripe index.
+     * @return reader of stripe, null if stripe has no files.
+     * @throws EvioException if stripe is out of range.
+     */
+    std::shared_ptr<RunReader> StripedReader::getStripeReader(uint32_t stripe) {
+        if (stripe >= readers.size()) {
+            throw EvioException("stripe " + std::to_string(stripe) + " out of range");
+        }
+        return readers[stripe];
+    }
+
+
+    /**
+     * Get the index of the run holding the given event.
+     * @param event global event number.
+     * @return index of run.
+     * @throws EvioException if event out of bounds.
+     */
+    uint32_t StripedReader::getRunOfEvent(uint64_t event) const {
+        if (event >= getEventCount()) {
+            throw EvioException("event " + std::to_string(event) + " out of bounds");
+        }
+        // First run whose first event is beyond this one, minus one
+        auto it = std::upper_bound(firstEvents.begin(), firstEvents.end(), event);
+        return (uint32_t)(it - firstEvents.begin()) - 1;
+    }
+
+
+    /**
+     * Get an event in the order it was written.
+     * @param event global event number, starting at 0.
+     * @param len   pointer to int which gets filled with the event's length in bytes.
+     * @return event data.
+     * @throws EvioException if event out of bounds, or its file cannot be read.
+     */
+    std::shared_ptr<uint8_t> StripedReader::getEvent(uint64_t event, uint32_t * len) {
+        uint32_t run = getRunOfEvent(event);
+        uint32_t stripe = manifest.getRunStripe(run);
+        return readers[stripe]->getEvent(stripeFirstEvents[run] + (event - firstEvents[run]), len);
+    }
+
+
+    /**
+     * Get the next event in the order it was written.
+     * @param len pointer to int which gets filled with the event's length in bytes.
+     * @return next event data, or null if there are no more events.
+     * @throws EvioException if its file cannot be read.
+     */
+    std::shared_ptr<uint8_t> StripedReader::getNextEvent(uint32_t * len) {
+        if (sequentialEvent >= getEventCount()) return nullptr;
+
+        // Runs are visited in order, so skip the binary search
+        while (sequentialEvent >= firstEvents[sequentialRun + 1]) {
+            sequentialRun++;
+        }
+        uint32_t stripe = manifest.getRunStripe(sequentialRun);
+        uint64_t index  = stripeFirstEvents[sequentialRun] + (sequentialEvent - firstEvents[sequentialRun]);
+        sequentialEvent++;
+        return readers[stripe]->getEvent(index, len);
+    }
+
+
+    /**
+     * Is there another event to get with {@link #getNextEvent(uint32_t *)}?
+     * @return true if there is another event.
+     */
+    bool StripedReader::hasNext() const {return sequentialEvent < getEventCount();}
+
+
+    /** Make {@link #getNextEvent(uint32_t *)} start again with the first event. */
+    void StripedReader::rewind() {
+        sequentialEvent = 0;
+        sequentialRun = 0;
+    }
+
+}
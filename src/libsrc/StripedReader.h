@@ -0,0 +1,91 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRIPEDREADER_H
+#define EVIO_6_0_STRIPEDREADER_H
+
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+
+
+#include "RunReader.h"
+#include "StripeManifest.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class reads the files of all stripes written by {@link StripedEventWriter},
+     * returning events in the order in which they were written. The files of each stripe
+     * are read as one by a {@link RunReader} and the {@link StripeManifest} tells which
+     * stripe holds each run of events. Events are numbered globally, from 0 to one less
+     * than the total number of events in the manifest.<p>
+     *
+     * Like {@link RunReader}, this class is not thread-safe.
+     */
+    class StripedReader {
+
+    private:
+
+        /** Files and event runs of all stripes. */
+        StripeManifest manifest;
+
+        /** Reader of each stripe, null if stripe has no files. */
+        std::vector<std::shared_ptr<RunReader>> readers;
+
+        /** Global number of the first event of each run, one entry larger than number of runs. */
+        std::vector<uint64_t> firstEvents {0};
+
+        /** Number of the first event of each run within its stripe. */
+        std::vector<uint64_t> stripeFirstEvents;
+
+        /** Run holding next event returned by {@link #getNextEvent(uint32_t *)}. */
+        uint32_t sequentialRun = 0;
+
+        /** Global number of next event returned by {@link #getNextEvent(uint32_t *)}. */
+        uint64_t sequentialEvent = 0;
+
+    public:
+
+        explicit StripedReader(std::string const & manifestFile, bool prefetch = true);
+
+        StripedReader(const StripedReader &) = delete;
+        StripedReader & operator=(const StripedReader &) = delete;
+
+        void close();
+
+        /** @return number of stripes. */
+        uint32_t getStripeCount()  const {return manifest.getStripeCount();}
+        /** @return total number of events in all stripes. */
+        uint64_t getEventCount()   const {return firstEvents.back();}
+        /** @return files and event runs of all stripes. */
+        StripeManifest const & getManifest() const {return manifest;}
+
+        std::shared_ptr<RunReader> getStripeReader(uint32_t stripe);
+
+        std::shared_ptr<uint8_t> getEvent(uint64_t event, uint32_t * len);
+        std::shared_ptr<uint8_t> getNextEvent(uint32_t * len);
+        bool hasNext() const;
+        void rewind();
+
+    private:
+
+        uint32_t getRunOfEvent(uint64_t event) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRIPEDREADER_H
@@ -0,0 +1,66 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StructureEdits.h"
+
+#include <cstring>
+
+
+namespace evio {
+
+
+    /**
+     * Remove the evio structure this node represents, an event or any structure in an event,
+     * along with everything in it.
+     * Removing a node more than once, or a node inside one being removed, does nothing more.
+     * @param node node of structure to remove.
+     * @throws EvioException if node is null.
+     */
+    void StructureEdits::remove(std::shared_ptr<EvioNode> const & node) {
+        if (node == nullptr) {
+            throw EvioException("null node arg");
+        }
+        removals.push_back(node);
+    }
+
+
+    /**
+     * Add an evio container (bank, segment, or tag segment) as the last structure
+     * contained in an event. The data between the buffer's position and limit is copied.
+     * It must be valid evio data of a structure (or structures) compatible with the type of
+     * data stored in the event (not in file format with record header and the like).
+     *
+     * @param eventNumber number of event to add to, starting at 1.
+     * @param addBuffer   buffer containing evio data to add, ready to read.
+     * @throws EvioException if addBuffer is empty, has non-evio format or length
+     *                       is not a multiple of 4 bytes.
+     */
+    void StructureEdits::add(size_t eventNumber, ByteBuffer & addBuffer) {
+        size_t bytes = addBuffer.remaining();
+        if (bytes < 8) {
+            throw EvioException("empty or non-evio format buffer arg");
+        }
+        if (bytes % 4 != 0) {
+            throw EvioException("data added is not in evio format");
+        }
+
+        Addition addition {eventNumber, std::vector<uint8_t>(bytes), addBuffer.order()};
+        std::memcpy(addition.data.data(), addBuffer.array() + addBuffer.arrayOffset() + addBuffer.position(), bytes);
+        additions.push_back(std::move(addition));
+    }
+
+
+    /** Forget all edits. */
+    void StructureEdits::clear() {
+        removals.clear();
+        additions.clear();
+    }
+
+}
@@ -0,0 +1,93 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRUCTUREEDITS_H
+#define EVIO_6_0_STRUCTUREEDITS_H
+
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+
+#include "ByteBuffer.h"
+#include "ByteOrder.h"
+#include "EvioNode.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class collects removals and additions of evio structures from/to a buffer
+     * so they can all be made at once. Applying them with
+     * {@link EvioCompactReaderV6#applyEdits(StructureEdits &)} moves the buffer's data
+     * only once, no matter how many edits there are, and keeps all nodes of the structures
+     * not removed valid, with their positions and lengths updated.
+     * Removing each of many banks with {@link EvioCompactReaderV6#removeStructure} instead
+     * moves the data after each one.<p>
+     *
+     * A structure to be added is appended to the end of an event, after any others
+     * added to the same event earlier, just as
+     * {@link EvioCompactReaderV6#addStructure(size_t, ByteBuffer &)} does.
+     * Its data is copied when it's added here.
+     *
+     * <pre><code>
+     *    StructureEdits edits;
+     *    std::vector<std::shared_ptr<EvioNode>> found;
+     *    reader.searchEvent(ev, tag, num, found);
+     *    for (auto & node : found) edits.remove(node);
+     *    edits.add(ev, newBankBuffer);
+     *    reader.applyEdits(edits);
+     * </code></pre>
+     */
+    class StructureEdits {
+
+    public:
+
+        /** Structure to add to the end of an event. */
+        struct Addition {
+            /** Number of event to add to, starting at 1. */
+            size_t eventNumber;
+            /** Evio data of structure(s) to add. */
+            std::vector<uint8_t> data;
+            /** Byte order of data. */
+            ByteOrder order;
+        };
+
+    private:
+
+        /** Structures to remove. */
+        std::vector<std::shared_ptr<EvioNode>> removals;
+
+        /** Structures to add, in the order added. */
+        std::vector<Addition> additions;
+
+    public:
+
+        void remove(std::shared_ptr<EvioNode> const & node);
+        void add(size_t eventNumber, ByteBuffer & addBuffer);
+        void clear();
+
+        /** @return true if there are no edits. */
+        bool empty() const {return removals.empty() && additions.empty();}
+
+        /** @return structures to remove. */
+        std::vector<std::shared_ptr<EvioNode>> const & getRemovals() const {return removals;}
+
+        /** @return structures to add, in the order added. */
+        std::vector<Addition> const & getAdditions() const {return additions;}
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRUCTUREEDITS_H
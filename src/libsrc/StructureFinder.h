@@ -21,6 +21,7 @@
 #include "EvioXMLDictionary.h"
 #include "BaseStructure.h"
 #include "StructureType.h"
+#include "StructureQueryIndex.h"
 
 
 namespace evio {
@@ -31,7 +32,12 @@ namespace evio {
      * within an event, bank, segment, or tagsegment that match certain criteria. For the most
      * part it uses the <code>{@link BaseStructure#getMatchingStructures()}</code>
      * method on the provided <code>EvioEvent</code> object by constructing the
-     * appropriate filter.
+     * appropriate filter.<p>
+     *
+     * Searches by tag, by bank tag and num, and by dictionary name of a structure with no
+     * parent, such as an event, instead use its {@link StructureQueryIndex}, which is made
+     * on the first search and used until the event changes. Repeated searches of the same
+     * event then cost a hash lookup plus copying the results.
      *
      * @author heddle
      * @author timmer
@@ -69,6 +75,14 @@ namespace evio {
                                      uint16_t tag, uint8_t num,
                                      std::vector<std::shared_ptr<BaseStructure>> & vec) {
 
+            if (structure != nullptr) {
+                auto index = structure->getQueryIndex();
+                if (index != nullptr) {
+                    index->getBanks(structure, tag, num, vec);
+                    return;
+                }
+            }
+
             class myFilter : public IEvioFilter {
                 uint16_t tag; uint8_t num;
             public:
@@ -93,6 +107,14 @@ namespace evio {
         static void getMatchingStructures(std::shared_ptr<BaseStructure> structure, uint16_t tag,
                                           std::vector<std::shared_ptr<BaseStructure>> & vec) {
 
+            if (structure != nullptr) {
+                auto index = structure->getQueryIndex();
+                if (index != nullptr) {
+                    index->getStructures(structure, tag, vec);
+                    return;
+                }
+            }
+
             class myFilter : public IEvioFilter {
                 uint16_t tag;
             public:
@@ -116,6 +138,14 @@ namespace evio {
         static void getMatchingNonBanks(std::shared_ptr<BaseStructure> structure, uint16_t tag,
                                         std::vector<std::shared_ptr<BaseStructure>> & vec) {
 
+            if (structure != nullptr) {
+                auto index = structure->getQueryIndex();
+                if (index != nullptr) {
+                    index->getNonBanks(structure, tag, vec);
+                    return;
+                }
+            }
+
             class myFilter : public IEvioFilter {
                 uint16_t tag;
             public:
@@ -142,15 +172,23 @@ namespace evio {
          */
         static void getMatchingStructures(std::shared_ptr<BaseStructure> structure,
                                           std::string name,
-                                          EvioXMLDictionary & dictionary,
+                                          EvioXMLDictionary const & dictionary,
                                           std::vector<std::shared_ptr<BaseStructure>> & vec) {
 
+            if (structure != nullptr) {
+                auto index = structure->getQueryIndex();
+                if (index != nullptr) {
+                    index->getStructures(structure, name, dictionary, vec);
+                    return;
+                }
+            }
+
             // This IEvioFilter selects structures that match the given dictionary name
             class myFilter : public IEvioFilter {
                 std::string name;
-                EvioXMLDictionary & dict;
+                EvioXMLDictionary const & dict;
             public:
-                myFilter(std::string const & name, EvioXMLDictionary & dict) :
+                myFilter(std::string const & name, EvioXMLDictionary const & dict) :
                         name(name), dict(dict) {}
 
                 bool accept(StructureType const & structureType,
@@ -176,15 +214,15 @@ namespace evio {
          */
         static void getMatchingParent(std::shared_ptr<BaseStructure> structure,
                                      std::string parentName,
-                                     EvioXMLDictionary & dictionary,
+                                     EvioXMLDictionary const & dictionary,
                                      std::vector<std::shared_ptr<BaseStructure>> & vec) {
 
             // This IEvioFilter selects structures whose parent has the given dictionary name
             class myFilter : public IEvioFilter {
                 std::string name;
-                EvioXMLDictionary & dict;
+                EvioXMLDictionary const & dict;
             public:
-                myFilter(std::string const & name, EvioXMLDictionary & dict) :
+                myFilter(std::string const & name, EvioXMLDictionary const & dict) :
                         name(name), dict(dict) {}
 
                 bool accept(StructureType const & structureType,
@@ -216,26 +254,26 @@ namespace evio {
          */
         static void getMatchingChild(std::shared_ptr<BaseStructure> structure,
                                      std::string childName,
-                                     EvioXMLDictionary & dictionary,
+                                     EvioXMLDictionary const & dictionary,
                                      std::vector<std::shared_ptr<BaseStructure>> & vec) {
 
             // This IEvioFilter selects structures who have a child with the given dictionary name
             class myFilter : public IEvioFilter {
                 std::string name;
-                EvioXMLDictionary & dict;
+                EvioXMLDictionary const & dict;
             public:
-                myFilter(std::string const & name, EvioXMLDictionary & dict) :
+                myFilter(std::string const & name, EvioXMLDictionary const & dict) :
                         name(name), dict(dict) {}
 
                 bool accept(StructureType const & structureType,
                             std::shared_ptr<BaseStructure> struc) override {
 
-                    auto children = struc->getChildren();
+                    auto const & children = struc->getChildren();
                     if (children.empty()) {
                         return false;
                     }
 
-                    for (auto child : children) {
+                    for (auto const & child : children) {
                         if (name == dict.getName(child)) {
                             // If this child matches the name, add it to the list
                             return true;
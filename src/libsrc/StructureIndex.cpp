@@ -0,0 +1,146 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StructureIndex.h"
+
+
+namespace evio {
+
+
+    /** Remove all structures from this index, keeping its memory for reuse. */
+    void StructureIndex::clear() {
+        tags.clear();
+        nums.clear();
+        types.clear();
+        dataTypes.clear();
+        pads.clear();
+        positions.clear();
+        lengths.clear();
+        parents.clear();
+    }
+
+
+    /**
+     * Reserve memory for a number of structures.
+     * @param count number of structures to make room for.
+     */
+    void StructureIndex::reserve(size_t count) {
+        tags.reserve(count);
+        nums.reserve(count);
+        types.reserve(count);
+        dataTypes.reserve(count);
+        pads.reserve(count);
+        positions.reserve(count);
+        lengths.reserve(count);
+        parents.reserve(count);
+    }
+
+
+    /**
+     * Add a structure to the end of this index.
+     *
+     * @param tag       tag of structure.
+     * @param num       num of structure.
+     * @param type      type of structure (bank, segment or tagsegment) as a DataType value.
+     * @param dataType  type of data contained in structure as a DataType value.
+     * @param pad       padding of structure's data in bytes.
+     * @param position  position of structure's header in buffer in bytes.
+     * @param length    length of structure in 32-bit words, as found in its header.
+     * @param parent    index of parent, or NO_PARENT if structure is the event.
+     * @return index of added structure.
+     */
+    uint32_t StructureIndex::add(uint16_t tag, uint8_t num, uint8_t type, uint8_t dataType, uint8_t pad,
+                                 size_t position, uint32_t length, int32_t parent) {
+        tags.push_back(tag);
+        nums.push_back(num);
+        types.push_back(type);
+        dataTypes.push_back(dataType);
+        pads.push_back(pad);
+        positions.push_back(position);
+        lengths.push_back(length);
+        parents.push_back(parent);
+        return tags.size() - 1;
+    }
+
+
+    /**
+     * Find all structures with the given tag and num.
+     * @param tag tag to match.
+     * @param num num to match.
+     * @param vec vector to be filled with indexes of matching structures (empty if none found).
+     */
+    void StructureIndex::search(uint16_t tag, uint8_t num, std::vector<uint32_t> & vec) const {
+        vec.clear();
+        const size_t count = tags.size();
+        const uint16_t *t = tags.data();
+        const uint8_t  *n = nums.data();
+
+        for (size_t i=0; i < count; i++) {
+            if (t[i] == tag && n[i] == num) {
+                vec.push_back(i);
+            }
+        }
+    }
+
+
+    /**
+     * Find all structures with the given tag, regardless of num.
+     * @param tag tag to match.
+     * @param vec vector to be filled with indexes of matching structures (empty if none found).
+     */
+    void StructureIndex::search(uint16_t tag, std::vector<uint32_t> & vec) const {
+        vec.clear();
+        const size_t count = tags.size();
+        const uint16_t *t = tags.data();
+
+        for (size_t i=0; i < count; i++) {
+            if (t[i] == tag) {
+                vec.push_back(i);
+            }
+        }
+    }
+
+
+    /**
+     * Find the immediate children of a structure.
+     * Since descendants directly follow a structure, only those are looked at.
+     * @param index index of structure.
+     * @param vec vector to be filled with indexes of children (empty if none).
+     */
+    void StructureIndex::getChildren(uint32_t index, std::vector<uint32_t> & vec) const {
+        vec.clear();
+        size_t end = positions[index] + getTotalBytes(index);
+
+        for (size_t i = index + 1; i < tags.size() && positions[i] < end; i++) {
+            if (parents[i] == (int32_t)index) {
+                vec.push_back(i);
+            }
+        }
+    }
+
+
+    /**
+     * Obtain a string representation of this index.
+     * @return string representation of this index.
+     */
+    std::string StructureIndex::toString() const {
+        std::stringstream ss;
+        ss << "StructureIndex of " << size() << " structures:" << std::endl;
+        for (size_t i=0; i < size(); i++) {
+            ss << "  [" << i << "] " << DataType::getDataType(types[i]).toString() <<
+                  ": tag = " << tags[i] << ", num = " << +nums[i] <<
+                  ", data type = " << DataType::getDataType(dataTypes[i]).toString() <<
+                  ", pos = " << positions[i] << ", len = " << lengths[i] <<
+                  ", parent = " << parents[i] << std::endl;
+        }
+        return ss.str();
+    }
+
+}
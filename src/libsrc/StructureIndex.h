@@ -0,0 +1,196 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRUCTUREINDEX_H
+#define EVIO_6_0_STRUCTUREINDEX_H
+
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <sstream>
+
+
+#include "DataType.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a flat index of all the evio structures in a single event.
+     * It is a lighter alternative to the tree of {@link EvioNode} objects produced by scanning.
+     * Each structure's tag, num, structure type, data type, padding, position in the buffer,
+     * length and index of its parent are kept in parallel arrays. Structures are stored in the
+     * same order as in EvioNode's allNodes list: the event first, then each structure
+     * followed by its descendants. Searching is a linear pass over these arrays.<p>
+     *
+     * An index is filled by {@link EventHeaderParser#indexEvent} or
+     * {@link IEvioCompactReader#indexEvent} and may be reused for event after event.
+     * It holds no reference to the buffer it describes.
+     */
+    class StructureIndex {
+
+    public:
+
+        /** Parent index of the event, which has no parent. */
+        static const int32_t NO_PARENT = -1;
+
+    private:
+
+        /** Tag of each structure. */
+        std::vector<uint16_t> tags;
+        /** Num of each structure (0 for segments and tagsegments). */
+        std::vector<uint8_t>  nums;
+        /** Type of each structure (bank, segment or tagsegment), as a DataType value. */
+        std::vector<uint8_t>  types;
+        /** Type of data contained in each structure, as a DataType value. */
+        std::vector<uint8_t>  dataTypes;
+        /** Padding of each structure's data in bytes. */
+        std::vector<uint8_t>  pads;
+        /** Position of each structure's header in the buffer in bytes. */
+        std::vector<size_t>   positions;
+        /** Length of each structure in 32-bit words, as found in its header (so not including its first word). */
+        std::vector<uint32_t> lengths;
+        /** Index of each structure's parent, or NO_PARENT for the event. */
+        std::vector<int32_t>  parents;
+
+    public:
+
+        StructureIndex() = default;
+
+        void clear();
+        void reserve(size_t count);
+
+        uint32_t add(uint16_t tag, uint8_t num, uint8_t type, uint8_t dataType, uint8_t pad,
+                     size_t position, uint32_t length, int32_t parent);
+
+        /**
+         * Get the number of structures in this index.
+         * @return number of structures in this index.
+         */
+        size_t size() const {return tags.size();}
+
+        /**
+         * Is this index empty?
+         * @return true if this index is empty.
+         */
+        bool empty() const {return tags.empty();}
+
+        /**
+         * Get the tag of a structure.
+         * @param index index of structure.
+         * @return tag of structure.
+         */
+        uint16_t getTag(size_t index) const {return tags[index];}
+
+        /**
+         * Get the num of a structure.
+         * @param index index of structure.
+         * @return num of structure (0 for segments and tagsegments).
+         */
+        uint8_t getNum(size_t index) const {return nums[index];}
+
+        /**
+         * Get the type of a structure (bank, segment or tagsegment) as a DataType value.
+         * @param index index of structure.
+         * @return type of structure.
+         */
+        uint8_t getType(size_t index) const {return types[index];}
+
+        /**
+         * Get the type of data contained in a structure as a DataType value.
+         * @param index index of structure.
+         * @return type of data contained in structure.
+         */
+        uint8_t getDataType(size_t index) const {return dataTypes[index];}
+
+        /**
+         * Get the padding of a structure's data.
+         * @param index index of structure.
+         * @return padding of structure's data in bytes.
+         */
+        uint8_t getPad(size_t index) const {return pads[index];}
+
+        /**
+         * Get the position of a structure's header in the buffer.
+         * @param index index of structure.
+         * @return position of structure's header in bytes.
+         */
+        size_t getPosition(size_t index) const {return positions[index];}
+
+        /**
+         * Get the length of a structure, as found in its header.
+         * @param index index of structure.
+         * @return length of structure in 32-bit words, not including its first header word.
+         */
+        uint32_t getLength(size_t index) const {return lengths[index];}
+
+        /**
+         * Get the index of a structure's parent.
+         * @param index index of structure.
+         * @return index of parent, or NO_PARENT if structure is the event.
+         */
+        int32_t getParent(size_t index) const {return parents[index];}
+
+        /**
+         * Get the position of a structure's data in the buffer.
+         * @param index index of structure.
+         * @return position of structure's data in bytes.
+         */
+        size_t getDataPosition(size_t index) const {
+            return positions[index] + (types[index] == DataType::BANK.getValue() ? 8 : 4);
+        }
+
+        /**
+         * Get the length of a structure's data.
+         * @param index index of structure.
+         * @return length of structure's data in 32-bit words.
+         */
+        uint32_t getDataLength(size_t index) const {
+            return types[index] == DataType::BANK.getValue() ? lengths[index] - 1 : lengths[index];
+        }
+
+        /**
+         * Get the total length of a structure including its header.
+         * @param index index of structure.
+         * @return total length of structure in bytes.
+         */
+        uint32_t getTotalBytes(size_t index) const {return 4*(lengths[index] + 1);}
+
+        /**
+         * Get the tags of all structures.
+         * @return tags of all structures.
+         */
+        const std::vector<uint16_t> & getTags() const {return tags;}
+
+        /**
+         * Get the nums of all structures.
+         * @return nums of all structures.
+         */
+        const std::vector<uint8_t> & getNums() const {return nums;}
+
+        /**
+         * Get the parent indexes of all structures.
+         * @return parent indexes of all structures.
+         */
+        const std::vector<int32_t> & getParents() const {return parents;}
+
+        void search(uint16_t tag, uint8_t num, std::vector<uint32_t> & vec) const;
+        void search(uint16_t tag, std::vector<uint32_t> & vec) const;
+        void getChildren(uint32_t index, std::vector<uint32_t> & vec) const;
+
+        std::string toString() const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRUCTUREINDEX_H
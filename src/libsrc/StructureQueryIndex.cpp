@@ -0,0 +1,166 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "StructureQueryIndex.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which indexes all structures below the given one and
+     * ties the headers of all of them, including its own, to this index.
+     * @param top top structure of tree, normally an event.
+     */
+    StructureQueryIndex::StructureQueryIndex(BaseStructure & top) : stamp(std::make_shared<uint64_t>(0)) {
+        top.getHeader()->indexStamp = stamp;
+        for (auto it = top.childrenBegin(); it != top.childrenEnd(); ++it) {
+            add(**it);
+        }
+    }
+
+
+    /**
+     * Add a structure and all its descendants, depth first.
+     * @param structure structure to add.
+     */
+    void StructureQueryIndex::add(BaseStructure & structure) {
+        auto header = structure.getHeader();
+        header->indexStamp = stamp;
+
+        auto index = (uint32_t) descendants.size();
+        descendants.push_back(structure.getThis());
+
+        byTag[header->getTag()].push_back(index);
+        if (structure.getStructureType() == StructureType::STRUCT_BANK) {
+            byTagNum[(uint32_t)header->getTag() << 8 | header->getNumber()].push_back(index);
+        }
+
+        for (auto it = structure.childrenBegin(); it != structure.childrenEnd(); ++it) {
+            add(**it);
+        }
+    }
+
+
+    /**
+     * Is this index still an index of the given tree? It's not if a structure has been
+     * added or removed, or if a tag, num, or data type has been changed, since it was made.
+     * @param top top structure of tree.
+     * @return true if up to date.
+     */
+    bool StructureQueryIndex::isValid(BaseStructure const & top) const {
+        return top.getHeader()->indexStamp == stamp && *stamp == 0;
+    }
+
+
+    /**
+     * Append the indexed structures to a vector.
+     * @param indexes indexes into descendants, or null if none.
+     * @param vec     vector to append to.
+     */
+    void StructureQueryIndex::copy(std::vector<uint32_t> const * indexes,
+                                   std::vector<std::shared_ptr<BaseStructure>> & vec) const {
+        if (indexes == nullptr) return;
+        vec.reserve(vec.size() + indexes->size());
+        for (uint32_t i : *indexes) {
+            vec.push_back(descendants[i]);
+        }
+    }
+
+
+    /**
+     * Get all structures with the given tag.
+     * @param top top structure of indexed tree.
+     * @param tag tag to match.
+     * @param vec vector which is cleared, then filled with matching structures.
+     */
+    void StructureQueryIndex::getStructures(std::shared_ptr<BaseStructure> const & top, uint16_t tag,
+                                            std::vector<std::shared_ptr<BaseStructure>> & vec) const {
+        vec.clear();
+        if (top->getHeader()->getTag() == tag) {
+            vec.push_back(top);
+        }
+        auto it = byTag.find(tag);
+        copy(it == byTag.end() ? nullptr : &it->second, vec);
+    }
+
+
+    /**
+     * Get all banks with the given tag and num.
+     * @param top top structure of indexed tree.
+     * @param tag tag to match.
+     * @param num num to match.
+     * @param vec vector which is cleared, then filled with matching banks.
+     */
+    void StructureQueryIndex::getBanks(std::shared_ptr<BaseStructure> const & top, uint16_t tag, uint8_t num,
+                                       std::vector<std::shared_ptr<BaseStructure>> & vec) const {
+        vec.clear();
+        auto const & header = top->getHeader();
+        if (top->getStructureType() == StructureType::STRUCT_BANK &&
+            header->getTag() == tag && header->getNumber() == num) {
+            vec.push_back(top);
+        }
+        auto it = byTagNum.find((uint32_t)tag << 8 | num);
+        copy(it == byTagNum.end() ? nullptr : &it->second, vec);
+    }
+
+
+    /**
+     * Get all segments and tagsegments with the given tag.
+     * @param top top structure of indexed tree.
+     * @param tag tag to match.
+     * @param vec vector which is cleared, then filled with matching structures.
+     */
+    void StructureQueryIndex::getNonBanks(std::shared_ptr<BaseStructure> const & top, uint16_t tag,
+                                          std::vector<std::shared_ptr<BaseStructure>> & vec) const {
+        vec.clear();
+        if (top->getStructureType() != StructureType::STRUCT_BANK && top->getHeader()->getTag() == tag) {
+            vec.push_back(top);
+        }
+        auto it = byTag.find(tag);
+        if (it == byTag.end()) return;
+        for (uint32_t i : it->second) {
+            if (descendants[i]->getStructureType() != StructureType::STRUCT_BANK) {
+                vec.push_back(descendants[i]);
+            }
+        }
+    }
+
+
+    /**
+     * Get all structures with the given name in a dictionary.
+     * The names of all structures are found the first time this is called
+     * with a dictionary and then kept until called with another.
+     * @param top        top structure of indexed tree.
+     * @param name       dictionary name to match.
+     * @param dictionary dictionary to use.
+     * @param vec        vector which is cleared, then filled with matching structures.
+     */
+    void StructureQueryIndex::getStructures(std::shared_ptr<BaseStructure> const & top, std::string const & name,
+                                            EvioXMLDictionary const & dictionary,
+                                            std::vector<std::shared_ptr<BaseStructure>> & vec) {
+        if (nameDictionary != &dictionary) {
+            byName.clear();
+            for (uint32_t i = 0; i < descendants.size(); i++) {
+                byName[dictionary.getName(descendants[i])].push_back(i);
+            }
+            nameDictionary = &dictionary;
+        }
+
+        vec.clear();
+        auto t = top;
+        if (dictionary.getName(t) == name) {
+            vec.push_back(top);
+        }
+        auto it = byName.find(name);
+        copy(it == byName.end() ? nullptr : &it->second, vec);
+    }
+
+}
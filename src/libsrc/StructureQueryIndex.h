@@ -0,0 +1,99 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_STRUCTUREQUERYINDEX_H
+#define EVIO_6_0_STRUCTUREQUERYINDEX_H
+
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+
+#include "BaseStructure.h"
+#include "EvioXMLDictionary.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is an index of the structures in a tree of {@link BaseStructure}s, normally an
+     * event, by tag, by bank tag and num, and by dictionary name. It lets {@link StructureFinder}
+     * answer repeated searches of the same event with a hash lookup instead of walking the
+     * whole tree through an {@link IEvioFilter} each time. Results are in the same order
+     * as a walk would give them, the top structure first, then depth first.<p>
+     *
+     * An index is gotten from {@link BaseStructure#getQueryIndex()}, which makes one as needed.
+     * All headers in the tree share a change counter with the index, so adding or removing a
+     * structure anywhere in it, or changing a tag or num, marks the index as out of date and
+     * the next call to getQueryIndex() makes a new one. Names are indexed the first time they're
+     * asked for with a given dictionary object.<p>
+     *
+     * To avoid a reference cycle, the index does not hold its top structure, which
+     * must be passed into each search. This class is not thread-safe.
+     */
+    class StructureQueryIndex {
+
+    private:
+
+        /** Change counter shared with all headers of the indexed tree, 0 while up to date. */
+        std::shared_ptr<uint64_t> stamp;
+
+        /** All structures below the top, depth first. */
+        std::vector<std::shared_ptr<BaseStructure>> descendants;
+
+        /** Indexes into descendants of structures with each tag. */
+        std::unordered_map<uint16_t, std::vector<uint32_t>> byTag;
+
+        /** Indexes into descendants of banks with each tag and num (tag << 8 | num). */
+        std::unordered_map<uint32_t, std::vector<uint32_t>> byTagNum;
+
+        /** Indexes into descendants of structures with each name in nameDictionary. */
+        std::unordered_map<std::string, std::vector<uint32_t>> byName;
+
+        /** Dictionary used to make byName, or null if not made yet. */
+        const EvioXMLDictionary *nameDictionary = nullptr;
+
+    public:
+
+        explicit StructureQueryIndex(BaseStructure & top);
+
+        bool isValid(BaseStructure const & top) const;
+
+        /** @return number of structures in index, including the top. */
+        size_t size() const {return descendants.size() + 1;}
+
+        void getStructures(std::shared_ptr<BaseStructure> const & top, uint16_t tag,
+                           std::vector<std::shared_ptr<BaseStructure>> & vec) const;
+
+        void getBanks(std::shared_ptr<BaseStructure> const & top, uint16_t tag, uint8_t num,
+                      std::vector<std::shared_ptr<BaseStructure>> & vec) const;
+
+        void getNonBanks(std::shared_ptr<BaseStructure> const & top, uint16_t tag,
+                         std::vector<std::shared_ptr<BaseStructure>> & vec) const;
+
+        void getStructures(std::shared_ptr<BaseStructure> const & top, std::string const & name,
+                           EvioXMLDictionary const & dictionary,
+                           std::vector<std::shared_ptr<BaseStructure>> & vec);
+
+    private:
+
+        void add(BaseStructure & structure);
+        void copy(std::vector<uint32_t> const * indexes,
+                  std::vector<std::shared_ptr<BaseStructure>> & vec) const;
+    };
+
+}
+
+
+#endif //EVIO_6_0_STRUCTUREQUERYINDEX_H
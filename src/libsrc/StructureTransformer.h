@@ -24,13 +24,18 @@
 #include "EvioBank.h"
 #include "EvioSegment.h"
 #include "EvioTagSegment.h"
+#include "EvioNode.h"
+#include "EvioException.h"
+#include "Util.h"
 
 
 namespace evio {
 
     /**
      * This class contains methods to transform structures from one type to another,
-     * for example, changing an EvioSegment into an EvioBank.
+     * for example, changing an EvioSegment into an EvioBank. Structures still in buffer
+     * form, as EvioNode objects, can be transformed by rewriting only their headers,
+     * without creating any objects or parsing their data.
      *
      * @author timmer
      * @date 6/3/2020 (10/1/2010 original java)
@@ -429,6 +434,223 @@ namespace evio {
             tagsegment->transform(bank);
         }
 
+        //---------------------------------------------------------------
+        // Buffer level transforms of EvioNode regions
+        //---------------------------------------------------------------
+
+    private:
+
+        /**
+         * Turn BANK & ALSOBANK into BANK, SEGMENT & ALSOSEGMENT into SEGMENT,
+         * and make sure the type is that of a structure.
+         * @param structType type of structure.
+         * @return value of BANK, SEGMENT, or TAGSEGMENT.
+         * @throws EvioException if structType is not a structure.
+         */
+        static uint32_t structureValue(DataType const & structType) {
+            if (structType == DataType::BANK || structType == DataType::ALSOBANK) {
+                return DataType::BANK.getValue();
+            }
+            else if (structType == DataType::SEGMENT || structType == DataType::ALSOSEGMENT) {
+                return DataType::SEGMENT.getValue();
+            }
+            else if (structType == DataType::TAGSEGMENT) {
+                return DataType::TAGSEGMENT.getValue();
+            }
+            throw EvioException("cannot transform into a " + structType.toString());
+        }
+
+
+        /**
+         * Create the header words of a node's structure as another type of structure.
+         * Tags are masked to the bits available just as when writing out a header object.
+         *
+         * @param node     node of structure.
+         * @param toType   BANK, SEGMENT, or TAGSEGMENT value.
+         * @param num      num of bank, ignored otherwise.
+         * @param words    2 words filled with the header, only the first if not a bank.
+         * @return number of header words, 2 for a bank, else 1.
+         * @throws EvioException if data too big for a segment or tagsegment.
+         */
+        static uint32_t headerWords(EvioNode const & node, uint32_t toType, uint8_t num, uint32_t *words) {
+            uint32_t dataLen  = node.getDataLength();
+            uint32_t dataType = node.getDataType();
+            uint32_t pad      = node.getPad();
+            uint32_t tag      = node.getTag();
+
+            if (toType == DataType::BANK.getValue()) {
+                words[0] = dataLen + 1;
+                words[1] = tag << 16 | (pad & 0x3) << 14 | (dataType & 0x3f) << 8 | num;
+                return 2;
+            }
+
+            if (dataLen > 65535) {
+                throw EvioException("structure is too long to transform into segment or tagsegment");
+            }
+
+            if (toType == DataType::SEGMENT.getValue()) {
+                words[0] = (tag & 0xff) << 24 | (pad & 0x3) << 22 | (dataType & 0x3f) << 16 | dataLen;
+                return 1;
+            }
+
+            // Change 6 bit content type to equivalent 4 bits
+            if (dataType == DataType::BANK.getValue()) {
+                dataType = DataType::ALSOBANK.getValue();
+            }
+            else if (dataType == DataType::SEGMENT.getValue()) {
+                dataType = DataType::ALSOSEGMENT.getValue();
+            }
+            words[0] = (tag & 0xfff) << 20 | (dataType & 0xf) << 16 | dataLen;
+            return 1;
+        }
+
+    public:
+
+        /**
+         * Get the number of bytes the structure an EvioNode represents takes up
+         * when transformed into another type of structure.
+         *
+         * @param node       node of structure to transform.
+         * @param structType BANK, SEGMENT, or TAGSEGMENT.
+         * @return number of bytes, header included.
+         * @throws EvioException if structType is not a structure.
+         */
+        static uint32_t transformedBytes(std::shared_ptr<EvioNode> const & node, DataType const & structType) {
+            uint32_t headerLen = structureValue(structType) == DataType::BANK.getValue() ? 2 : 1;
+            return 4*(headerLen + node->getDataLength());
+        }
+
+
+        /**
+         * Write the evio structure an EvioNode represents as another type of structure,
+         * bank, segment, or tagsegment, without creating any objects. In buffer form such a
+         * change only rewrites a header word or two and shifts the data (children included)
+         * by 4 bytes, so the new header is written followed by a straight copy of the node's data,
+         * all in the byte order of the node's buffer. The TAG, NUM, LENGTH and TYPE notes of the
+         * object transforms above apply, with the tag masked to the bits of the new header.
+         * A tagsegment has no padding, so a segment or bank made from one has none either.<p>
+         *
+         * Dest may overlap the node's bytes, so a structure can be shifted in its own buffer.
+         * The node itself is not changed.
+         *
+         * @param node       node of structure to transform.
+         * @param structType BANK, SEGMENT, or TAGSEGMENT.
+         * @param num        num of the created bank, ignored otherwise.
+         * @param dest       where to write, with room for
+         *                   {@link #transformedBytes(std::shared_ptr<EvioNode> const &, DataType const &)} bytes.
+         * @return number of bytes written.
+         * @throws EvioException if node or dest is null, structType is not a structure,
+         *                       or node's data is too long for a segment or tagsegment.
+         */
+        static uint32_t transform(std::shared_ptr<EvioNode> const & node, DataType const & structType,
+                                  uint8_t num, uint8_t *dest) {
+            if (node == nullptr || dest == nullptr) {
+                throw EvioException("null arg(s)");
+            }
+
+            uint32_t words[2];
+            uint32_t headerLen = headerWords(*node, structureValue(structType), num, words);
+            uint32_t dataBytes = 4*node->getDataLength();
+
+            auto buf = node->getBuffer();
+            ByteOrder const & order = buf->order();
+
+            // Data first, since dest may overlap the old header
+            std::memmove(dest + 4*headerLen,
+                         buf->array() + buf->arrayOffset() + node->getDataPosition(),
+                         dataBytes);
+
+            for (uint32_t i=0; i < headerLen; i++) {
+                Util::toBytes(words[i], order, dest + 4*i);
+            }
+
+            return 4*headerLen + dataBytes;
+        }
+
+
+        /**
+         * Write the evio structure an EvioNode represents as another type of structure
+         * into a buffer at its position, which is then moved past what was written.
+         * Used to stream structures, one after another, into a buffer.
+         * See {@link #transform(std::shared_ptr<EvioNode> const &, DataType const &, uint8_t, uint8_t *)}.
+         *
+         * @param node       node of structure to transform.
+         * @param structType BANK, SEGMENT, or TAGSEGMENT.
+         * @param num        num of the created bank, ignored otherwise.
+         * @param dest       buffer to write into, with same byte order as node's buffer.
+         * @return number of bytes written.
+         * @throws EvioException if node is null, structType is not a structure,
+         *                       node's data is too long for a segment or tagsegment,
+         *                       dest has too little room or a different byte order.
+         */
+        static uint32_t transform(std::shared_ptr<EvioNode> const & node, DataType const & structType,
+                                  uint8_t num, ByteBuffer & dest) {
+            if (node == nullptr) {
+                throw EvioException("null arg");
+            }
+            if (dest.order() != node->getBuffer()->order()) {
+                throw EvioException("dest byte order differs from node's buffer");
+            }
+
+            uint32_t bytes = transformedBytes(node, structType);
+            if (dest.remaining() < bytes) {
+                throw EvioException("dest too small");
+            }
+
+            transform(node, structType, num, dest.array() + dest.arrayOffset() + dest.position());
+            dest.position(dest.position() + bytes);
+            return bytes;
+        }
+
+
+        /**
+         * Change, in its buffer, the segment or tagsegment an EvioNode represents into the other,
+         * by rewriting its one header word. Both have the same size,
+         * so nothing else in the buffer, including the lengths of any containing
+         * structures, changes. The node is updated to match.
+         * Banks, with their 2 word headers, must be written elsewhere with
+         * {@link #transform(std::shared_ptr<EvioNode> const &, DataType const &, uint8_t, ByteBuffer &)}.
+         *
+         * @param node       node of segment or tagsegment to transform.
+         * @param structType SEGMENT or TAGSEGMENT.
+         * @throws EvioException if node is null, node is or structType is a bank,
+         *                       or structType is not a structure.
+         */
+        static void transformInPlace(std::shared_ptr<EvioNode> const & node, DataType const & structType) {
+            if (node == nullptr) {
+                throw EvioException("null arg");
+            }
+
+            uint32_t toType = structureValue(structType);
+            uint32_t fromType = node->getType();
+            if (toType == DataType::BANK.getValue() ||
+                fromType == DataType::BANK.getValue() ||
+                fromType == DataType::ALSOBANK.getValue()) {
+                throw EvioException("banks cannot be transformed in place");
+            }
+
+            uint32_t word;
+            headerWords(*node, toType, 0, &word);
+            node->getBuffer()->putInt(node->getPosition(), word);
+
+            // Keep node consistent with its new header
+            node->type = toType;
+            if (toType == DataType::SEGMENT.getValue()) {
+                node->tag &= 0xff;
+            }
+            else {
+                node->pad = 0;
+                if (node->dataType == DataType::BANK.getValue()) {
+                    node->dataType = DataType::ALSOBANK.getValue();
+                }
+                else if (node->dataType == DataType::SEGMENT.getValue()) {
+                    node->dataType = DataType::ALSOSEGMENT.getValue();
+                }
+            }
+        }
+
+
+
 
     };
 
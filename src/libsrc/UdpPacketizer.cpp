@@ -0,0 +1,329 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "UdpPacketizer.h"
+
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which opens a UDP socket sending to the given host and port,
+     * normally those of a load balancer.
+     *
+     * @param host    name or dotted-decimal address of host to send to.
+     * @param port    UDP port to send to.
+     * @param mtu     largest IP packet, including IP and UDP headers, to send.
+     * @param dataId  id of this sender put into each packet.
+     * @param entropy entropy put into each packet.
+     * @throws EvioException if mtu too small, or host cannot be found.
+     */
+    UdpPacketizer::UdpPacketizer(std::string const & host, uint16_t port, uint32_t mtu,
+                                 uint16_t dataId, uint16_t entropy) :
+            mtu(mtu), dataId(dataId), entropy(entropy) {
+
+        if (mtu < IP_UDP_HEADER_BYTES + HEADER_BYTES + 64) {
+            throw EvioException("mtu too small, " + std::to_string(mtu));
+        }
+        maxPayload = mtu - IP_UDP_HEADER_BYTES - HEADER_BYTES;
+
+        // Batch's headers must not move once pointed to
+        headers.resize(MAX_BATCH_PACKETS * HEADER_BYTES);
+        packetStarts.reserve(MAX_BATCH_PACKETS + 1);
+        iov.reserve(4 * MAX_BATCH_PACKETS);
+
+        connectTo(host, port);
+    }
+
+
+    /** Destructor which closes the socket. */
+    UdpPacketizer::~UdpPacketizer() {close();}
+
+
+    /**
+     * Open a socket which sends to the given host and port.
+     * @param host name or dotted-decimal address of host to send to.
+     * @param port UDP port to send to.
+     * @throws EvioException if host cannot be found.
+     */
+    void UdpPacketizer::connectTo(std::string const & host, uint16_t port) {
+        struct addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        struct addrinfo *result = nullptr;
+        std::string service = std::to_string(port);
+        int err = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+        if (err != 0) {
+            throw EvioException("cannot find host " + host + ": " + gai_strerror(err));
+        }
+
+        // Connecting a UDP socket only fixes the destination, so no address goes with each packet
+        for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                sock = fd;
+                break;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(result);
+
+        if (sock < 0) {
+            throw EvioException("cannot send to " + host + ":" + service + ", " + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Set the size of the socket's kernel send buffer.
+     * A large one keeps a burst of packets from a big record from being held up.
+     * @param bytes size in bytes.
+     * @throws EvioException if socket closed or option cannot be set.
+     */
+    void UdpPacketizer::setSendBufferSize(int bytes) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+        if (setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) < 0) {
+            throw EvioException(std::string("cannot set send buffer size, ") + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Write the load balancer and reassembly headers of a packet.
+     * @param dest   where to write them.
+     * @param offset offset of packet's data in record.
+     * @param length bytes in whole record.
+     * @param tick   tick of record.
+     */
+    void UdpPacketizer::writeHeaders(uint8_t *dest, uint32_t offset, uint32_t length, uint64_t tick) const {
+        dest[0] = 'L';
+        dest[1] = 'B';
+        dest[2] = LB_VERSION;
+        dest[3] = LB_PROTOCOL;
+        dest[4] = 0;
+        dest[5] = 0;
+        dest[6] = entropy >> 8;
+        dest[7] = entropy;
+        for (int i = 0; i < 8; i++) {
+            dest[8 + i]  = tick >> (56 - 8*i);
+            dest[28 + i] = tick >> (56 - 8*i);
+        }
+
+        uint8_t *re = dest + LB_HEADER_BYTES;
+        re[0] = RE_VERSION << 4;
+        re[1] = 0;
+        re[2] = dataId >> 8;
+        re[3] = dataId;
+        for (int i = 0; i < 4; i++) {
+            re[4 + i] = offset >> (24 - 8*i);
+            re[8 + i] = length >> (24 - 8*i);
+        }
+    }
+
+
+    /**
+     * Hand the packets of the current batch to the kernel.
+     * @throws EvioException if socket closed or error writing.
+     */
+    void UdpPacketizer::sendBatch() {
+        size_t count = packetStarts.size();
+        if (count == 0) return;
+
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+
+        // End of last packet
+        packetStarts.push_back(iov.size());
+
+#ifdef __linux__
+        struct mmsghdr msgs[MAX_BATCH_PACKETS];
+        std::memset(msgs, 0, count * sizeof(struct mmsghdr));
+        for (size_t i = 0; i < count; i++) {
+            msgs[i].msg_hdr.msg_iov = &iov[packetStarts[i]];
+            msgs[i].msg_hdr.msg_iovlen = packetStarts[i+1] - packetStarts[i];
+        }
+
+        size_t sent = 0;
+        while (sent < count) {
+            int n = ::sendmmsg(sock, msgs + sent, count - sent, 0);
+            if (n < 0) {
+                // An unreachable receiver is reported once, by a later send
+                if (errno == EINTR || errno == ECONNREFUSED) continue;
+                throw EvioException(std::string("error writing to socket, ") + std::strerror(errno));
+            }
+            for (int i = 0; i < n; i++) {
+                bytesSent += msgs[sent + i].msg_len;
+            }
+            sent += n;
+        }
+#else
+        for (size_t i = 0; i < count; i++) {
+            struct msghdr msg {};
+            msg.msg_iov = &iov[packetStarts[i]];
+            msg.msg_iovlen = packetStarts[i+1] - packetStarts[i];
+
+            ssize_t n = ::sendmsg(sock, &msg, 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == ECONNREFUSED) {
+                    i--;
+                    continue;
+                }
+                throw EvioException(std::string("error writing to socket, ") + std::strerror(errno));
+            }
+            bytesSent += n;
+        }
+#endif
+
+        packetsSent += count;
+        packetStarts.clear();
+        iov.clear();
+    }
+
+
+    /**
+     * Split the given data into packets and send them.
+     * @param segs  parts of the record, sent one after the other.
+     * @param bytes bytes in all parts.
+     * @param tick  tick of record.
+     * @throws EvioException if error writing.
+     */
+    void UdpPacketizer::sendSegments(std::vector<ByteBufferView> const & segs, uint32_t bytes, uint64_t tick) {
+        size_t seg = 0, segOffset = 0;
+        uint32_t offset = 0;
+
+        while (offset < bytes) {
+            if (packetStarts.size() == MAX_BATCH_PACKETS) {
+                sendBatch();
+            }
+
+            uint8_t *hdr = headers.data() + packetStarts.size() * HEADER_BYTES;
+            writeHeaders(hdr, offset, bytes, tick);
+            packetStarts.push_back(iov.size());
+            iov.push_back({hdr, HEADER_BYTES});
+
+            // A packet's data may come from more than one part
+            uint32_t room = std::min(maxPayload, bytes - offset);
+            offset += room;
+            while (room > 0 && seg < segs.size()) {
+                auto const & s = segs[seg];
+                size_t take = std::min((size_t)room, s.size() - segOffset);
+                if (take > 0) {
+                    iov.push_back({const_cast<uint8_t *>(s.data()) + segOffset, take});
+                    segOffset += take;
+                    room -= take;
+                }
+                if (segOffset == s.size()) {
+                    seg++;
+                    segOffset = 0;
+                }
+            }
+        }
+
+        sendBatch();
+        recordsSent++;
+    }
+
+
+    /**
+     * Send a built record, giving it the next tick.
+     * @param record built record.
+     * @return tick the record was sent with.
+     * @throws EvioException if error writing.
+     */
+    uint64_t UdpPacketizer::send(RecordOutput & record) {
+        uint64_t tick = nextTick;
+        send(record, tick);
+        return tick;
+    }
+
+
+    /**
+     * Send a built record with the given tick. Following records not given a tick
+     * get those after it. The record's data is sent from where it is, even if
+     * it was built for gathering.
+     * @param record built record.
+     * @param tick   tick of record.
+     * @throws EvioException if error writing.
+     */
+    void UdpPacketizer::send(RecordOutput & record, uint64_t tick) {
+        record.getSegments(segments);
+        sendSegments(segments, record.getHeader()->getLength(), tick);
+        nextTick = tick + 1;
+    }
+
+
+    /**
+     * Send a record, or any other data, giving it the next tick.
+     * @param data  data to send.
+     * @param bytes number of bytes to send.
+     * @return tick the data was sent with.
+     * @throws EvioException if error writing.
+     */
+    uint64_t UdpPacketizer::send(const uint8_t *data, uint32_t bytes) {
+        uint64_t tick = nextTick;
+        send(data, bytes, tick);
+        return tick;
+    }
+
+
+    /**
+     * Send a record, or any other data, with the given tick.
+     * Following records not given a tick get those after it.
+     * @param data  data to send.
+     * @param bytes number of bytes to send.
+     * @param tick  tick of data.
+     * @throws EvioException if error writing.
+     */
+    void UdpPacketizer::send(const uint8_t *data, uint32_t bytes, uint64_t tick) {
+        segments.clear();
+        segments.emplace_back(data, bytes);
+        sendSegments(segments, bytes, tick);
+        nextTick = tick + 1;
+    }
+
+
+    /**
+     * Send the data between the buffer's position and limit, giving it the next tick.
+     * The buffer's position is not changed.
+     * @param buffer buffer containing record.
+     * @return tick the data was sent with.
+     * @throws EvioException if error writing.
+     */
+    uint64_t UdpPacketizer::send(ByteBuffer & buffer) {
+        return send(buffer.array() + buffer.arrayOffset() + buffer.position(), buffer.remaining());
+    }
+
+
+    /** Close the socket. */
+    void UdpPacketizer::close() {
+        if (sock >= 0) {
+            ::close(sock);
+            sock = -1;
+        }
+        packetStarts.clear();
+        iov.clear();
+    }
+
+}
@@ -0,0 +1,201 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_UDPPACKETIZER_H
+#define EVIO_6_0_UDPPACKETIZER_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "RecordOutput.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class splits finished records into UDP packets small enough for the network's
+     * MTU and sends them to a hardware load balancer or straight to a {@link UdpReassembler}.
+     * Each packet starts with a load balancer header, which the load balancer uses to pick
+     * the farm node all packets of a record go to, followed by a reassembly header giving
+     * where the packet's data goes in the record:
+     *
+     * <pre><code>
+     *    Load balancer header, 16 bytes:
+     *
+     *    0                   1                   2                   3
+     *    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |       L       |       B       |    Version    |    Protocol   |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |            Reserved           |            Entropy            |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |                              Tick                             |
+     *   +                                                               +
+     *   |                                                               |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *
+     *    Reassembly header, 20 bytes:
+     *
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |Version|        Reserved       |            Data Id            |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |                     Offset of data in record                  |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |                        Length of record                       |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     *   |                              Tick                             |
+     *   +                                                               +
+     *   |                                                               |
+     *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     * </code></pre>
+     *
+     * All header fields are big endian. The tick identifies the record, is the same in all of
+     * its packets, and unless given explicitly goes up by one with each record sent. The data id
+     * tells records from different senders apart, and the entropy lets the load balancer spread
+     * one sender's records over several ports of a node.<p>
+     *
+     * A record's data is taken from where it was built, gathered together with each packet's
+     * headers, and up to {@link #MAX_BATCH_PACKETS} packets are handed to the kernel by one
+     * sendmmsg call. Nothing is resent; a record losing a packet is dropped by the receiver.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class UdpPacketizer {
+
+    public:
+
+        /** Bytes in the load balancer header. */
+        static const uint32_t LB_HEADER_BYTES = 16;
+
+        /** Bytes in the reassembly header. */
+        static const uint32_t RE_HEADER_BYTES = 20;
+
+        /** Bytes of both headers at the start of every packet. */
+        static const uint32_t HEADER_BYTES = LB_HEADER_BYTES + RE_HEADER_BYTES;
+
+        /** Version of the load balancer header. */
+        static const uint8_t LB_VERSION = 2;
+
+        /** Protocol of the load balancer header, which says a reassembly header follows. */
+        static const uint8_t LB_PROTOCOL = 1;
+
+        /** Version of the reassembly header. */
+        static const uint8_t RE_VERSION = 1;
+
+        /** Bytes of IPv4 and UDP headers taken out of the MTU. */
+        static const uint32_t IP_UDP_HEADER_BYTES = 20 + 8;
+
+        /** Most packets handed to the kernel in one system call. */
+        static const uint32_t MAX_BATCH_PACKETS = 64;
+
+    private:
+
+        /** Socket file descriptor, -1 if closed. */
+        int sock = -1;
+
+        /** Largest IP packet, including IP and UDP headers. */
+        uint32_t mtu;
+
+        /** Most record bytes in one packet. */
+        uint32_t maxPayload;
+
+        /** Id of this sender put into each packet. */
+        uint16_t dataId;
+
+        /** Entropy put into each packet. */
+        uint16_t entropy;
+
+        /** Tick of the next record if not given explicitly. */
+        uint64_t nextTick = 0;
+
+        /** Headers of packets in the current batch. */
+        std::vector<uint8_t> headers;
+
+        /** Buffers of packets in the current batch, headers and data. */
+        std::vector<struct iovec> iov;
+
+        /** Index into iov where each packet of the current batch starts. */
+        std::vector<uint32_t> packetStarts;
+
+        /** Parts of the record being sent. */
+        std::vector<ByteBufferView> segments;
+
+        /** Total bytes sent, including headers. */
+        uint64_t bytesSent = 0;
+
+        /** Total packets sent. */
+        uint64_t packetsSent = 0;
+
+        /** Total records sent. */
+        uint64_t recordsSent = 0;
+
+    public:
+
+        UdpPacketizer(std::string const & host, uint16_t port, uint32_t mtu = 9000,
+                      uint16_t dataId = 0, uint16_t entropy = 0);
+
+        UdpPacketizer(const UdpPacketizer & other) = delete;
+        UdpPacketizer & operator=(const UdpPacketizer & other) = delete;
+
+        ~UdpPacketizer();
+
+        void setSendBufferSize(int bytes);
+
+        /** @return largest IP packet sent, including IP and UDP headers. */
+        uint32_t getMtu()               const {return mtu;}
+        /** @return most record bytes in one packet. */
+        uint32_t getMaxPayload()        const {return maxPayload;}
+        /** @return id of this sender put into each packet. */
+        uint16_t getDataId()            const {return dataId;}
+        /** @return entropy put into each packet. */
+        uint16_t getEntropy()           const {return entropy;}
+        /** @return tick of the next record if not given explicitly. */
+        uint64_t getNextTick()          const {return nextTick;}
+        /** @return total bytes sent, including headers. */
+        uint64_t getBytesSent()         const {return bytesSent;}
+        /** @return total packets sent. */
+        uint64_t getPacketsSent()       const {return packetsSent;}
+        /** @return total records sent. */
+        uint64_t getRecordsSent()       const {return recordsSent;}
+
+        /** @param e entropy to put into following packets. */
+        void setEntropy(uint16_t e)     {entropy = e;}
+        /** @param tick tick of the next record if not given explicitly. */
+        void setNextTick(uint64_t tick) {nextTick = tick;}
+
+        uint64_t send(RecordOutput & record);
+        void send(RecordOutput & record, uint64_t tick);
+        uint64_t send(const uint8_t *data, uint32_t bytes);
+        void send(const uint8_t *data, uint32_t bytes, uint64_t tick);
+        uint64_t send(ByteBuffer & buffer);
+
+        void close();
+
+    private:
+
+        void connectTo(std::string const & host, uint16_t port);
+        void sendSegments(std::vector<ByteBufferView> const & segs, uint32_t bytes, uint64_t tick);
+        void writeHeaders(uint8_t *dest, uint32_t offset, uint32_t length, uint64_t tick) const;
+        void sendBatch();
+    };
+
+}
+
+
+#endif //EVIO_6_0_UDPPACKETIZER_H
@@ -0,0 +1,325 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "UdpReassembler.h"
+
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+#include "ByteBufferPool.h"
+
+
+namespace evio {
+
+
+    /**
+     * Constructor which binds a UDP socket to the given port on all interfaces.
+     *
+     * @param port           UDP port to receive on, 0 for any free one (see {@link #getPort()}).
+     * @param maxRecordBytes largest record accepted, packets of bigger ones are dropped.
+     * @param allocator      source of record buffers. If null, ByteBuffer's default
+     *                       allocator is used, or if that's not set, a new ByteBufferPool.
+     * @throws EvioException if socket cannot be bound to port.
+     */
+    UdpReassembler::UdpReassembler(uint16_t port, uint32_t maxRecordBytes,
+                                   std::shared_ptr<ByteBufferAllocator> allocator) :
+            maxRecordBytes(maxRecordBytes), allocator(std::move(allocator)) {
+
+        if (this->allocator == nullptr) {
+            this->allocator = ByteBuffer::getDefaultAllocator();
+            if (this->allocator == nullptr) {
+                this->allocator = std::make_shared<ByteBufferPool>();
+            }
+        }
+
+        packetMemory.resize((size_t)UdpPacketizer::MAX_BATCH_PACKETS * MAX_PACKET_BYTES);
+        packetIov.resize(UdpPacketizer::MAX_BATCH_PACKETS);
+        for (uint32_t i = 0; i < UdpPacketizer::MAX_BATCH_PACKETS; i++) {
+            packetIov[i].iov_base = packetMemory.data() + (size_t)i * MAX_PACKET_BYTES;
+            packetIov[i].iov_len  = MAX_PACKET_BYTES;
+        }
+
+        bindTo(port);
+    }
+
+
+    /** Destructor which closes the socket. */
+    UdpReassembler::~UdpReassembler() {close();}
+
+
+    /**
+     * Open a socket receiving on the given port.
+     * @param p UDP port, 0 for any free one.
+     * @throws EvioException if socket cannot be bound to port.
+     */
+    void UdpReassembler::bindTo(uint16_t p) {
+        int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            throw EvioException(std::string("cannot create socket, ") + std::strerror(errno));
+        }
+
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(p);
+
+        socklen_t len = sizeof(addr);
+        if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+            ::getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) < 0) {
+            std::string err = std::strerror(errno);
+            ::close(fd);
+            throw EvioException("cannot bind to port " + std::to_string(p) + ", " + err);
+        }
+
+        sock = fd;
+        port = ntohs(addr.sin_port);
+    }
+
+
+    /**
+     * Set the size of the socket's kernel receive buffer (SO_RCVBUF).
+     * It must hold the packets arriving while records are being processed, else they're lost.
+     * @param bytes size of receive buffer in bytes.
+     * @throws EvioException if socket closed or option cannot be set.
+     */
+    void UdpReassembler::setReceiveBufferSize(int bytes) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+        if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) < 0) {
+            throw EvioException(std::string("cannot set receive buffer size, ") + std::strerror(errno));
+        }
+    }
+
+
+    /**
+     * Copy one packet's data to its place in its record.
+     * @param packet packet received.
+     * @param bytes  bytes in packet.
+     */
+    void UdpReassembler::addPacket(const uint8_t *packet, size_t bytes) {
+        packetsReceived++;
+        bytesReceived += bytes;
+
+        const uint8_t *re = packet + UdpPacketizer::LB_HEADER_BYTES;
+        if (bytes <= UdpPacketizer::HEADER_BYTES ||
+            packet[0] != 'L' || packet[1] != 'B' ||
+            packet[3] != UdpPacketizer::LB_PROTOCOL ||
+            (re[0] >> 4) != UdpPacketizer::RE_VERSION) {
+            packetsDropped++;
+            return;
+        }
+
+        uint16_t dataId = (re[2] << 8) | re[3];
+        uint32_t offset = 0, length = 0;
+        uint64_t tick = 0;
+        for (int i = 0; i < 4; i++) {
+            offset = (offset << 8) | re[4 + i];
+            length = (length << 8) | re[8 + i];
+        }
+        for (int i = 0; i < 8; i++) {
+            tick = (tick << 8) | re[12 + i];
+        }
+
+        uint32_t payload = bytes - UdpPacketizer::HEADER_BYTES;
+        if (length == 0 || length > maxRecordBytes || (uint64_t)offset + payload > length) {
+            packetsDropped++;
+            return;
+        }
+
+        auto key = std::make_pair(dataId, tick);
+        auto it = pending.find(key);
+        if (it == pending.end()) {
+            if (pending.size() >= maxPendingRecords) {
+                // Make room by dropping the record which started arriving first
+                auto oldest = pending.begin();
+                for (auto p = pending.begin(); p != pending.end(); ++p) {
+                    if (p->second.started < oldest->second.started) oldest = p;
+                }
+                pending.erase(oldest);
+                recordsDropped++;
+            }
+
+            Assembly assembly;
+            assembly.buffer = std::make_shared<ByteBuffer>(allocator->allocate(length), length);
+            assembly.length = length;
+            assembly.started = std::chrono::steady_clock::now();
+            it = pending.emplace(key, std::move(assembly)).first;
+        }
+
+        Assembly & assembly = it->second;
+        if (assembly.length != length) {
+            packetsDropped++;
+            return;
+        }
+
+        std::memcpy(assembly.buffer->array() + offset, packet + UdpPacketizer::HEADER_BYTES, payload);
+        assembly.received += payload;
+
+        if (assembly.received >= assembly.length) {
+            completed.push_back({std::move(assembly.buffer), tick, dataId});
+            pending.erase(it);
+            recordsReceived++;
+        }
+    }
+
+
+    /** Drop records which have been missing packets for too long. */
+    void UdpReassembler::dropStale() {
+        if (pending.empty()) return;
+
+        auto tooOld = std::chrono::steady_clock::now() - std::chrono::milliseconds(recordTimeout);
+        for (auto it = pending.begin(); it != pending.end(); ) {
+            if (it->second.started < tooOld) {
+                it = pending.erase(it);
+                recordsDropped++;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+
+    /**
+     * Wait for packets, then take all that are waiting, up to a batch, from the kernel.
+     * @param timeoutMillis milliseconds to wait, -1 for no limit.
+     * @return false if none arrived in time.
+     * @throws EvioException if socket closed or error reading.
+     */
+    bool UdpReassembler::receiveBatch(int timeoutMillis) {
+        if (sock < 0) {
+            throw EvioException("socket closed");
+        }
+
+        struct pollfd pfd {sock, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, timeoutMillis);
+        if (ready < 0) {
+            if (errno == EINTR) return false;
+            throw EvioException(std::string("error waiting on socket, ") + std::strerror(errno));
+        }
+        if (ready == 0) return false;
+
+        const uint32_t batch = UdpPacketizer::MAX_BATCH_PACKETS;
+
+#ifdef __linux__
+        struct mmsghdr msgs[batch];
+        std::memset(msgs, 0, sizeof(msgs));
+        for (uint32_t i = 0; i < batch; i++) {
+            msgs[i].msg_hdr.msg_iov = &packetIov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = ::recvmmsg(sock, msgs, batch, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) return false;
+            throw EvioException(std::string("error reading from socket, ") + std::strerror(errno));
+        }
+        for (int i = 0; i < n; i++) {
+            addPacket(static_cast<uint8_t *>(packetIov[i].iov_base), msgs[i].msg_len);
+        }
+#else
+        for (uint32_t i = 0; i < batch; i++) {
+            ssize_t n = ::recv(sock, packetIov[0].iov_base, MAX_PACKET_BYTES, MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) break;
+                throw EvioException(std::string("error reading from socket, ") + std::strerror(errno));
+            }
+            addPacket(static_cast<uint8_t *>(packetIov[0].iov_base), n);
+        }
+#endif
+
+        dropStale();
+        return true;
+    }
+
+
+    /**
+     * Get the next finished record, waiting for its packets if necessary.
+     * Records are returned in the order they were finished, which need not be the order
+     * they were sent in. The buffer's position is 0 and its limit the record's length.
+     *
+     * @param timeoutMillis most milliseconds to wait for, -1 for no limit.
+     * @param tick   if not null, filled with the tick the record was sent with.
+     * @param dataId if not null, filled with the id of the record's sender.
+     * @return buffer containing record, or null if none was finished in time.
+     * @throws EvioException if socket closed or error reading.
+     */
+    std::shared_ptr<ByteBuffer> UdpReassembler::getRecord(int timeoutMillis, uint64_t *tick, uint16_t *dataId) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+
+        while (completed.empty()) {
+            int wait = timeoutMillis;
+            if (timeoutMillis >= 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()).count();
+                if (left < 0) return nullptr;
+                wait = (int)left;
+            }
+
+            // Wake up to drop stale records even if nothing arrives
+            if (!pending.empty() && (wait < 0 || (uint32_t)wait > recordTimeout)) {
+                wait = (int)recordTimeout;
+            }
+
+            if (!receiveBatch(wait)) {
+                dropStale();
+                if (timeoutMillis == 0) return nullptr;
+            }
+        }
+
+        Completed c = std::move(completed.front());
+        completed.pop_front();
+        if (tick != nullptr) *tick = c.tick;
+        if (dataId != nullptr) *dataId = c.dataId;
+        return c.buffer;
+    }
+
+
+    /**
+     * Wait for the next finished record and have the given reader read it in buffer mode.
+     * The record is that reader's buffer until it is given another.
+     *
+     * @param reader        reader given the record.
+     * @param timeoutMillis most milliseconds to wait for, -1 for no limit.
+     * @return false if no record was finished in time.
+     * @throws EvioException if socket closed, error reading, or record not in evio format.
+     */
+    bool UdpReassembler::readRecord(Reader & reader, int timeoutMillis) {
+        auto buffer = getRecord(timeoutMillis);
+        if (buffer == nullptr) {
+            return false;
+        }
+        reader.setBuffer(buffer);
+        return true;
+    }
+
+
+    /** Close the socket and drop any records being put together. */
+    void UdpReassembler::close() {
+        if (sock >= 0) {
+            ::close(sock);
+            sock = -1;
+        }
+        pending.clear();
+    }
+
+}
@@ -0,0 +1,183 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_UDPREASSEMBLER_H
+#define EVIO_6_0_UDPREASSEMBLER_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <utility>
+#include <sys/uio.h>
+
+
+#include "ByteBuffer.h"
+#include "ByteBufferAllocator.h"
+#include "Reader.h"
+#include "UdpPacketizer.h"
+#include "EvioException.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class receives the UDP packets sent by a {@link UdpPacketizer}, whether directly or
+     * through a load balancer, and puts them back together into records. Packets may arrive in
+     * any order and packets of different records may be mixed. Up to
+     * {@link UdpPacketizer#MAX_BATCH_PACKETS} packets are taken from the kernel by one recvmmsg
+     * call and each one's data copied to its place in the record's buffer.<p>
+     *
+     * Record buffers come from a {@link ByteBufferAllocator}, by default a
+     * {@link ByteBufferPool}, so once records are done with, their memory is used for
+     * the following ones. A finished record may be handed to a {@link Reader} by
+     * {@link #readRecord(Reader &, int)}, which uses its buffer mode.<p>
+     *
+     * Since nothing is resent, a record which is still missing packets after
+     * {@link #setRecordTimeout(uint32_t)} milliseconds, or which is the oldest when too many
+     * are being put together at once, is dropped. Duplicate packets are not detected.<p>
+     *
+     * This class is not thread-safe.
+     */
+    class UdpReassembler {
+
+    public:
+
+        /** Bytes of each packet receive buffer, enough for any UDP packet. */
+        static const uint32_t MAX_PACKET_BYTES = 65536;
+
+    private:
+
+        /** Record being put together. */
+        struct Assembly {
+            /** Buffer holding the record. */
+            std::shared_ptr<ByteBuffer> buffer;
+            /** Bytes in the record. */
+            uint32_t length = 0;
+            /** Bytes of the record received so far. */
+            uint32_t received = 0;
+            /** When the first packet arrived. */
+            std::chrono::steady_clock::time_point started;
+        };
+
+        /** Finished record. */
+        struct Completed {
+            /** Buffer holding the record. */
+            std::shared_ptr<ByteBuffer> buffer;
+            /** Tick it was sent with. */
+            uint64_t tick;
+            /** Id of its sender. */
+            uint16_t dataId;
+        };
+
+        /** Socket file descriptor, -1 if closed. */
+        int sock = -1;
+
+        /** UDP port bound to. */
+        uint16_t port = 0;
+
+        /** Largest record accepted. */
+        uint32_t maxRecordBytes;
+
+        /** Source of record buffers. */
+        std::shared_ptr<ByteBufferAllocator> allocator;
+
+        /** Milliseconds a record may take to arrive before it's dropped. */
+        uint32_t recordTimeout = 1000;
+
+        /** Most records put together at once. */
+        size_t maxPendingRecords = 64;
+
+        /** Memory of packet receive buffers. */
+        std::vector<uint8_t> packetMemory;
+
+        /** One buffer for each packet received in a batch. */
+        std::vector<struct iovec> packetIov;
+
+        /** Records being put together, by sender id and tick. */
+        std::map<std::pair<uint16_t, uint64_t>, Assembly> pending;
+
+        /** Finished records not yet taken, oldest first. */
+        std::deque<Completed> completed;
+
+        /** Total bytes received, including headers. */
+        uint64_t bytesReceived = 0;
+
+        /** Total packets received. */
+        uint64_t packetsReceived = 0;
+
+        /** Total packets thrown away for bad headers or lengths. */
+        uint64_t packetsDropped = 0;
+
+        /** Total records put together. */
+        uint64_t recordsReceived = 0;
+
+        /** Total records dropped because of lost packets. */
+        uint64_t recordsDropped = 0;
+
+    public:
+
+        explicit UdpReassembler(uint16_t port, uint32_t maxRecordBytes = 64*1024*1024,
+                                std::shared_ptr<ByteBufferAllocator> allocator = nullptr);
+
+        UdpReassembler(const UdpReassembler & other) = delete;
+        UdpReassembler & operator=(const UdpReassembler & other) = delete;
+
+        ~UdpReassembler();
+
+        void setReceiveBufferSize(int bytes);
+
+        /** @param millis milliseconds a record may take to arrive before it's dropped. */
+        void setRecordTimeout(uint32_t millis)   {recordTimeout = millis;}
+        /** @param count most records put together at once, at least 1. */
+        void setMaxPendingRecords(size_t count)  {maxPendingRecords = count < 1 ? 1 : count;}
+
+        /** @return UDP port bound to. */
+        uint16_t getPort()                  const {return port;}
+        /** @return largest record accepted. */
+        uint32_t getMaxRecordBytes()        const {return maxRecordBytes;}
+        /** @return milliseconds a record may take to arrive before it's dropped. */
+        uint32_t getRecordTimeout()         const {return recordTimeout;}
+        /** @return number of records being put together. */
+        size_t getPendingRecords()          const {return pending.size();}
+        /** @return total bytes received, including headers. */
+        uint64_t getBytesReceived()         const {return bytesReceived;}
+        /** @return total packets received. */
+        uint64_t getPacketsReceived()       const {return packetsReceived;}
+        /** @return total packets thrown away for bad headers or lengths. */
+        uint64_t getPacketsDropped()        const {return packetsDropped;}
+        /** @return total records put together. */
+        uint64_t getRecordsReceived()       const {return recordsReceived;}
+        /** @return total records dropped because of lost packets. */
+        uint64_t getRecordsDropped()        const {return recordsDropped;}
+
+        std::shared_ptr<ByteBuffer> getRecord(int timeoutMillis = -1,
+                                              uint64_t *tick = nullptr, uint16_t *dataId = nullptr);
+        bool readRecord(Reader & reader, int timeoutMillis = -1);
+
+        void close();
+
+    private:
+
+        void bindTo(uint16_t port);
+        bool receiveBatch(int timeoutMillis);
+        void addPacket(const uint8_t *packet, size_t bytes);
+        void dropStale();
+    };
+
+}
+
+
+#endif //EVIO_6_0_UDPREASSEMBLER_H
@@ -0,0 +1,384 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#include "UringFileWriteBackend.h"
+
+
+#ifdef EVIO_HAVE_IO_URING
+
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+
+// System call numbers are the same on all architectures for io_uring,
+// but older C libraries do not define them.
+#ifndef __NR_io_uring_setup
+    #define __NR_io_uring_setup    425
+#endif
+#ifndef __NR_io_uring_enter
+    #define __NR_io_uring_enter    426
+#endif
+#ifndef __NR_io_uring_register
+    #define __NR_io_uring_register 427
+#endif
+
+
+namespace evio {
+
+
+    /**
+     * Constructor. Creates the io_uring and maps its queues into memory.
+     * @param queueDepth max number of writes in flight at once.
+     * @throws EvioException if io_uring not supported or allowed.
+     */
+    UringFileWriteBackend::UringFileWriteBackend(uint32_t queueDepth) : FileWriteBackend(queueDepth) {
+
+        struct io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        ringFd = (int) syscall(__NR_io_uring_setup, this->queueDepth, &params);
+        if (ringFd < 0) {
+            throw EvioException("io_uring_setup failed: " + std::string(std::strerror(errno)));
+        }
+
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes = params.cq_off.cqes  + params.cq_entries * sizeof(struct io_uring_cqe);
+
+        // Newer kernels map both rings with a single call
+        bool singleMmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+        singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqRingBytes = cqRingBytes = sqRingBytes > cqRingBytes ? sqRingBytes : cqRingBytes;
+        }
+#endif
+
+        void *pmem = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (pmem == MAP_FAILED) {
+            unmapRings();
+            throw EvioException("io_uring submission queue mmap failed");
+        }
+        sqRing = pmem;
+
+        if (singleMmap) {
+            cqRing = sqRing;
+        }
+        else {
+            pmem = mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (pmem == MAP_FAILED) {
+                unmapRings();
+                throw EvioException("io_uring completion queue mmap failed");
+            }
+            cqRing = pmem;
+        }
+
+        sqesBytes = params.sq_entries * sizeof(struct io_uring_sqe);
+        pmem = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (pmem == MAP_FAILED) {
+            unmapRings();
+            throw EvioException("io_uring submission entries mmap failed");
+        }
+        sqes = static_cast<struct io_uring_sqe *>(pmem);
+
+        auto sq = static_cast<uint8_t *>(sqRing);
+        sqHead  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sqTail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+        auto cq = static_cast<uint8_t *>(cqRing);
+        cqHead  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes    = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // Slots are never reallocated as the kernel may refer to their iovecs
+        slots.resize(this->queueDepth);
+        freeSlots.reserve(this->queueDepth);
+        for (uint32_t i = this->queueDepth; i > 0; i--) {
+            freeSlots.push_back(i - 1);
+        }
+    }
+
+
+    /** Destructor. Waits for writes in flight, then tears down the io_uring. */
+    UringFileWriteBackend::~UringFileWriteBackend() {
+        try {
+            waitForAll();
+        }
+        catch (EvioException & e) {}
+        unmapRings();
+    }
+
+
+    /**
+     * Unmap the queues and close the io_uring, which also unregisters any buffers.
+     * Call while holding writeMutex (or during construction).
+     */
+    void UringFileWriteBackend::unmapRings() {
+        if (sqes != nullptr) munmap(sqes, sqesBytes);
+        if (cqRing != nullptr && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+        if (sqRing != nullptr) munmap(sqRing, sqRingBytes);
+        sqes   = nullptr;
+        cqRing = nullptr;
+        sqRing = nullptr;
+
+        if (ringFd > -1) {
+            ::close(ringFd);
+            ringFd = -1;
+        }
+
+        registeredIovs.clear();
+        registeredBuffers.clear();
+    }
+
+
+    /**
+     * Get the type of this backend.
+     * @return IO_URING.
+     */
+    FileWriteBackend::Type UringFileWriteBackend::getType() const {return IO_URING;}
+
+
+    /** {@inheritDoc} */
+    void UringFileWriteBackend::registerWithKernel(std::vector<std::shared_ptr<ByteBuffer>> & buffers) {
+        if (ringFd < 0 || !registeredIovs.empty() || !inFlight.empty()) return;
+
+        std::vector<struct iovec> iovs;
+        std::vector<std::shared_ptr<ByteBuffer>> bufs;
+        for (auto & buf : buffers) {
+            if (buf == nullptr || buf->array() == nullptr || buf->capacity() < 1) continue;
+            iovs.push_back({buf->array() + buf->arrayOffset(), buf->capacity()});
+            bufs.push_back(buf);
+        }
+        if (iovs.empty()) return;
+
+        // Pinning this memory may exceed RLIMIT_MEMLOCK, in which case just don't use it
+        int ret = (int) syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS,
+                                iovs.data(), (unsigned)iovs.size());
+        if (ret < 0) {
+            std::cout << "UringFileWriteBackend: cannot register buffers, " <<
+                         std::strerror(errno) << std::endl;
+            return;
+        }
+
+        registeredIovs = std::move(iovs);
+        registeredBuffers = std::move(bufs);
+    }
+
+
+    /**
+     * Find the registered buffer which holds all the given data.
+     * @param data pointer to data.
+     * @param len  number of bytes.
+     * @return index of registered buffer, or -1 if none.
+     */
+    int UringFileWriteBackend::findRegisteredBuffer(const uint8_t *data, size_t len) const {
+        for (size_t i=0; i < registeredIovs.size(); i++) {
+            auto start = static_cast<const uint8_t *>(registeredIovs[i].iov_base);
+            if (data >= start && data + len <= start + registeredIovs[i].iov_len) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+
+    /**
+     * Submit to the kernel the remaining data of the write in the given slot.
+     * Call while holding writeMutex.
+     * @param slot index of slot.
+     * @throws EvioException if the kernel refuses the submission.
+     */
+    void UringFileWriteBackend::submit(uint32_t slot) {
+
+        PendingWrite & w = slots[slot];
+
+        // Only this thread moves the tail, the kernel moves the head
+        unsigned tail  = *sqTail;
+        unsigned index = tail & *sqMask;
+        struct io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+
+        sqe->fd = fd;
+        sqe->off = w.position;
+        sqe->user_data = slot;
+
+        if (w.bufIndex > -1) {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(w.iov.iov_base);
+            sqe->len = (uint32_t) w.iov.iov_len;
+            sqe->buf_index = (uint16_t) w.bufIndex;
+        }
+        else {
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(&w.iov);
+            sqe->len = 1;
+        }
+
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        while (syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                throw EvioException("io_uring_enter failed: " + std::string(std::strerror(errno)));
+            }
+        }
+    }
+
+
+    /**
+     * Submit the rest of an unfinished write. If that fails, the write is
+     * finished with an error. Call while holding writeMutex.
+     * @param slot index of slot.
+     */
+    void UringFileWriteBackend::resubmit(uint32_t slot) {
+        try {
+            submit(slot);
+        }
+        catch (EvioException & e) {
+            setError(e.what());
+            slots[slot].done = true;
+        }
+    }
+
+
+    /**
+     * Wait for at least one completion, then handle all those available.
+     * Partial writes are resubmitted. Call while holding writeMutex.
+     * @throws EvioException if the kernel cannot be waited on.
+     */
+    void UringFileWriteBackend::reap() {
+
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+        if (head == tail) {
+            if (syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR) {
+                throw EvioException("io_uring_enter failed: " + std::string(std::strerror(errno)));
+            }
+            head = *cqHead;
+            tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        }
+
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &cqes[head & *cqMask];
+            auto slot = (uint32_t) cqe->user_data;
+            int res = cqe->res;
+
+            // Give entry back to kernel before any resubmission
+            __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+
+            PendingWrite & w = slots[slot];
+
+            if (res == -EINTR || res == -EAGAIN) {
+                resubmit(slot);
+            }
+            else if (res <= 0) {
+                setError("error writing to file: " +
+                         std::string(res < 0 ? std::strerror(-res) : "no bytes written"));
+                w.done = true;
+            }
+            else if ((size_t)res < w.iov.iov_len) {
+                w.iov.iov_base = static_cast<uint8_t *>(w.iov.iov_base) + res;
+                w.iov.iov_len -= res;
+                w.position += res;
+                resubmit(slot);
+            }
+            else {
+                w.done = true;
+            }
+        }
+    }
+
+
+    /**
+     * Free, in the order written, the slots of completed writes and release their ring items.
+     * Call while holding writeMutex.
+     */
+    void UringFileWriteBackend::releaseCompleted() {
+        while (!inFlight.empty() && slots[inFlight.front()].done) {
+            uint32_t slot = inFlight.front();
+            inFlight.pop_front();
+            writeDone(slots[slot].item);
+            freeSlots.push_back(slot);
+        }
+    }
+
+
+    /** {@inheritDoc} */
+    void UringFileWriteBackend::queueWrite(const uint8_t *data, size_t len, uint64_t position,
+                                           std::shared_ptr<RecordRingItem> const & item) {
+        if (ringFd < 0) {
+            throw EvioException("file not open");
+        }
+
+        while (freeSlots.empty()) {
+            reap();
+            releaseCompleted();
+        }
+        throwIfError();
+
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+
+        PendingWrite & w = slots[slot];
+        w.item = item;
+        w.iov.iov_base = const_cast<uint8_t *>(data);
+        w.iov.iov_len = len;
+        w.position = position;
+        w.bufIndex = findRegisteredBuffer(data, len);
+        w.done = (len == 0);
+        inFlight.push_back(slot);
+        writesQueued++;
+
+        if (w.done) {
+            releaseCompleted();
+            return;
+        }
+
+        try {
+            submit(slot);
+        }
+        catch (EvioException & e) {
+            w.done = true;
+            releaseCompleted();
+            throw;
+        }
+    }
+
+
+    /** {@inheritDoc} */
+    void UringFileWriteBackend::waitForWrites(uint64_t count) {
+        while (!inFlight.empty() && writesCompleted < count) {
+            reap();
+            releaseCompleted();
+        }
+    }
+
+
+    /** Tear down the io_uring once the file is closed. */
+    void UringFileWriteBackend::shutdown() {
+        unmapRings();
+    }
+
+}
+
+
+#endif // EVIO_HAVE_IO_URING
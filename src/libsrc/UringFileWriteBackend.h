@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2020, Jefferson Science Associates
+//
+// Thomas Jefferson National Accelerator Facility
+// EPSCI Group
+//
+// 12000, Jefferson Ave, Newport News, VA 23606
+// Phone : (757)-269-7100
+//
+
+
+#ifndef EVIO_6_0_URINGFILEWRITEBACKEND_H
+#define EVIO_6_0_URINGFILEWRITEBACKEND_H
+
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define EVIO_HAVE_IO_URING 1
+    #endif
+#endif
+
+
+#ifdef EVIO_HAVE_IO_URING
+
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+
+#include "FileWriteBackend.h"
+
+
+namespace evio {
+
+
+    /**
+     * This class is a {@link FileWriteBackend} which submits writes to the Linux kernel
+     * through an io_uring, keeping up to queueDepth writes in flight without any extra threads.
+     * It talks to the kernel directly through its system calls so that liburing is not needed.<p>
+     *
+     * Buffers given to {@link #registerBuffers} (i.e. those of the RecordSupply's ring items,
+     * or the staging buffers for direct I/O)
+     * are registered with the kernel once, and writes from them use IORING_OP_WRITE_FIXED.
+     * If registration is refused (e.g. by RLIMIT_MEMLOCK), or data comes from elsewhere,
+     * IORING_OP_WRITEV is used instead.<p>
+     *
+     * Completions may arrive in any order, but ring items are released in the order written.
+     * Requires a 5.1 or later kernel; the constructor throws if io_uring is unavailable.
+     */
+    class UringFileWriteBackend : public FileWriteBackend {
+
+    private:
+
+        /** A write in flight. */
+        struct PendingWrite {
+            /** Ring item being written, may be null. */
+            std::shared_ptr<RecordRingItem> item;
+            /** Remaining data to be written. */
+            struct iovec iov {nullptr, 0};
+            /** File position at which remaining data is to be written. */
+            uint64_t position = 0;
+            /** Index of registered buffer holding data, or -1 if none. */
+            int bufIndex = -1;
+            /** Is the write complete? */
+            bool done = false;
+        };
+
+        /** File descriptor of the io_uring. */
+        int ringFd = -1;
+
+        /** Memory mapped submission queue ring. */
+        void *sqRing = nullptr;
+        /** Size in bytes of mapped submission queue ring. */
+        size_t sqRingBytes = 0;
+        /** Memory mapped completion queue ring (may be same as sqRing). */
+        void *cqRing = nullptr;
+        /** Size in bytes of mapped completion queue ring. */
+        size_t cqRingBytes = 0;
+        /** Memory mapped array of submission queue entries. */
+        struct io_uring_sqe *sqes = nullptr;
+        /** Size in bytes of mapped submission queue entries. */
+        size_t sqesBytes = 0;
+
+        // Pointers into the mapped rings
+        unsigned *sqHead  = nullptr;
+        unsigned *sqTail  = nullptr;
+        unsigned *sqMask  = nullptr;
+        unsigned *sqArray = nullptr;
+        unsigned *cqHead  = nullptr;
+        unsigned *cqTail  = nullptr;
+        unsigned *cqMask  = nullptr;
+        struct io_uring_cqe *cqes = nullptr;
+
+        /** One slot for each write which may be in flight. */
+        std::vector<PendingWrite> slots;
+        /** Indexes of free slots. */
+        std::vector<uint32_t> freeSlots;
+        /** Indexes of slots in flight, in the order written. */
+        std::deque<uint32_t> inFlight;
+
+        /** Buffers registered with the kernel, kept alive while registered. */
+        std::vector<std::shared_ptr<ByteBuffer>> registeredBuffers;
+        /** Memory of registered buffers. */
+        std::vector<struct iovec> registeredIovs;
+
+        void unmapRings();
+        int findRegisteredBuffer(const uint8_t *data, size_t len) const;
+        void submit(uint32_t slot);
+        void resubmit(uint32_t slot);
+        void reap();
+        void releaseCompleted();
+
+    protected:
+
+        void queueWrite(const uint8_t *data, size_t len, uint64_t position,
+                        std::shared_ptr<RecordRingItem> const & item) override;
+        void waitForWrites(uint64_t count) override;
+        void registerWithKernel(std::vector<std::shared_ptr<ByteBuffer>> & buffers) override;
+        void shutdown() override;
+
+    public:
+
+        explicit UringFileWriteBackend(uint32_t queueDepth);
+        ~UringFileWriteBackend() override;
+
+        Type getType() const override;
+    };
+
+}
+
+
+#endif // EVIO_HAVE_IO_URING
+
+
+#endif //EVIO_6_0_URINGFILEWRITEBACKEND_H
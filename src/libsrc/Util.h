@@ -15,10 +15,15 @@
 #include <iomanip>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <regex>
 #include <vector>
 #include <fstream>
+#include <pthread.h>
+#ifdef __linux__
+    #include <sched.h>
+#endif
 
 #include "EvioException.h"
 #include "ByteOrder.h"
@@ -26,6 +31,7 @@
 #include "EvioNode.h"
 #include "IBlockHeader.h"
 #include "DataType.h"
+#include "StringArrayView.h"
 
 
 namespace evio {
@@ -644,6 +650,28 @@ namespace evio {
         }
 
 
+        /**
+         * Restrict a thread to run only on the given CPUs.
+         * Only implemented on Linux, elsewhere this does nothing.
+         * @param thread native handle of thread (e.g. from std::thread::native_handle()).
+         * @param cpus   ids of CPUs the thread may run on. If empty, nothing is done.
+         * @return true if thread was pinned, else false.
+         */
+        static bool setThreadAffinity(pthread_t thread, const std::vector<uint32_t> & cpus) {
+            if (cpus.empty()) return false;
+#ifdef __linux__
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (uint32_t cpu : cpus) {
+                CPU_SET(cpu, &cpuSet);
+            }
+            return pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+            return false;
+#endif
+        }
+
+
         /**
          * Return the power of 2 closest to the given argument.
          *
@@ -776,55 +804,76 @@ namespace evio {
 
         /**
          * This method transforms an array/vector of strings into raw evio format data,
-         * not including header.
+         * not including header, written straight into the destination in one pass.
          *
          * @param strings vector of strings to transform.
-         * @param bytes   vector of bytes to contain evio formatted strings.
+         * @param dest    where to write the evio formatted strings, with room for
+         *                {@link #stringsToRawSize} bytes.
+         * @return number of bytes written, 0 if vector empty.
          */
-        static void stringsToRawBytes(std::vector<std::string> & strings,
-                                      std::vector<uint8_t> & bytes) {
+        static uint32_t stringsToRawBytes(std::vector<std::string> const & strings, uint8_t *dest) {
 
             if (strings.empty()) {
-                bytes.clear();
-                return;
+                return 0;
             }
 
-            // create some storage
-            int dataLen = stringsToRawSize(strings);
-            std::string strData;
-            strData.reserve(dataLen);
-
+            uint8_t *p = dest;
             for (std::string const & s : strings) {
-                // add string
-                strData.append(s);
-                // add ending null
-                strData.append(1, '\000');
+                // add string and ending null
+                std::memcpy(p, s.data(), s.length());
+                p += s.length();
+                *p++ = 0;
             }
 
             // Add any necessary padding to 4 byte boundaries.
             // IMPORTANT: There must be at least one '\004'
             // character at the end. This distinguishes evio
             // string array version from earlier version.
-            int pads[] = {4,3,2,1};
-            switch (pads[strData.length()%4]) {
-                case 4:
-                    strData.append(4, '\004');
-                    break;
-                case 3:
-                    strData.append(3, '\004');
-                    break;
-                case 2:
-                    strData.append(2, '\004');
-                    break;
-                case 1:
-                    strData.append(1, '\004');
-            }
+            uint32_t len = p - dest;
+            uint32_t pad = 4 - len%4;
+            std::memset(p, 4, pad);
+
+            return len + pad;
+        }
+
 
-            // Transform to ASCII
-            bytes.resize(dataLen);
-            for (int i=0; i < strData.length(); i++) {
-                bytes[i] = strData[i];
+        /**
+         * This method transforms an array/vector of strings into raw evio format data,
+         * not including header.
+         *
+         * @param strings vector of strings to transform.
+         * @param bytes   vector of bytes to contain evio formatted strings.
+         */
+        static void stringsToRawBytes(std::vector<std::string> const & strings,
+                                      std::vector<uint8_t> & bytes) {
+            bytes.resize(stringsToRawSize(strings));
+            stringsToRawBytes(strings, bytes.data());
+        }
+
+
+        /**
+         * This method extracts an array of strings from raw evio string data.
+         * Properly formatted data is split in place with a {@link StringArrayView}
+         * and only the resulting strings are copied.
+         * Otherwise it's handled by {@link #stringBuilderToStrings}.
+         *
+         * @param bytes          raw evio string data.
+         * @param length         length of data in bytes.
+         * @param onlyGoodChars  if true and non-printable chars found,
+         *                       only 1 string with printable ASCII chars will be returned.
+         * @param strData        vector in which to place extracted strings.
+         */
+        static void unpackStrings(const uint8_t *bytes, size_t length, bool onlyGoodChars,
+                                  std::vector<std::string> & strData) {
+            strData.clear();
+            StringArrayView view(bytes, length);
+            if (!view.isBadFormat()) {
+                view.appendTo(strData);
+                return;
             }
+
+            std::string sData(reinterpret_cast<const char *>(bytes), length);
+            stringBuilderToStrings(sData, onlyGoodChars, strData);
         }
 
 
@@ -860,8 +909,7 @@ namespace evio {
             // Don't read read more than maxLength ASCII characters
             length = length > maxLength ? maxLength : length;
 
-            std::string sData(reinterpret_cast<const char *>(bytes.data()) + offset, length);
-            return stringBuilderToStrings(sData, true, strData);
+            unpackStrings(bytes.data() + offset, length, true, strData);
         }
 
 
@@ -877,10 +925,7 @@ namespace evio {
         static void unpackRawBytesToStrings(uint8_t *bytes, size_t length,
                                             std::vector<std::string> & strData) {
             if (bytes == nullptr) return;
-
-            std::string sData(reinterpret_cast<const char *>(bytes), length);
-           // std::cout << "unpackRawBytesToStrings: string = " << sData << std::endl;
-            return stringBuilderToStrings(sData, true, strData);
+            unpackStrings(bytes, length, true, strData);
         }
 
 
@@ -897,9 +942,7 @@ namespace evio {
                                             std::vector<std::string> & strData) {
 
             if (length < 4) return;
-
-            std::string sData(reinterpret_cast<const char *>(buffer.array() + buffer.arrayOffset()) + pos, length);
-            return stringBuilderToStrings(sData, false, strData);
+            unpackStrings(buffer.array() + buffer.arrayOffset() + pos, length, false, strData);
         }
 
 
@@ -94,7 +94,8 @@ namespace evio {
 
 
         recordLengths = std::make_shared<std::vector<uint32_t>>();
-        unusedRecord = std::make_shared<RecordOutput>();
+        // Records take turns being filled, so all must be in the same byte order
+        unusedRecord = std::make_shared<RecordOutput>(order, maxEventCount, maxBufferSize, compType, hType);
         outputRecord = std::make_shared<RecordOutput>(order, maxEventCount, maxBufferSize, compType, hType);
         headerArray.resize(RecordHeader::HEADER_SIZE_BYTES);
 
@@ -173,7 +174,7 @@ namespace evio {
 
         recordLengths = std::make_shared<std::vector<uint32_t>>();
         headerArray.resize(RecordHeader::HEADER_SIZE_BYTES);
-        unusedRecord = std::make_shared<RecordOutput>();
+        unusedRecord = std::make_shared<RecordOutput>(byteOrder, maxEventCount, maxBufferSize, Compressor::UNCOMPRESSED);
         outputRecord = std::make_shared<RecordOutput>(byteOrder, maxEventCount, maxBufferSize, Compressor::UNCOMPRESSED);
 
         haveDictionary = !dictionary.empty();
@@ -304,6 +305,11 @@ namespace evio {
             addTrailerIndex = other.addTrailerIndex;
             closed = other.closed;
             opened = other.opened;
+            directIO = other.directIO;
+            backgroundCompression = other.backgroundCompression;
+            durability = other.durability;
+            durabilityMillis = other.durabilityMillis;
+            durabilityBytes = other.durabilityBytes;
 
             if (opened) {
                 if (toFile) {
@@ -329,9 +335,54 @@ namespace evio {
      * @param pWriter pointer to this object.
      * @param data    pointer to data.
      * @param len     number of bytes to write.
+     * @param end     file position just past the data, reported to any syncer.
      */
-    void Writer::staticWriteFunction(Writer *pWriter, const char* data, size_t len) {
+    void Writer::staticWriteFunction(Writer *pWriter, const char* data, size_t len, uint64_t end) {
         pWriter->outFile.write(data, len);
+        if (pWriter->syncer != nullptr) {
+            // Hand the data to the operating system before it can be synced
+            pWriter->outFile.flush();
+            if (!pWriter->outFile.fail()) {
+                pWriter->syncer->written(end);
+            }
+        }
+    }
+
+
+    /**
+     * Function to build (compress) a record and then write it to file,
+     * used with background compression in place of {@link #staticWriteFunction}.
+     * The record's place in the file is only known once it's built, so the bookkeeping
+     * done for each record written is done here too. This is safe since the thread
+     * filling records always waits for this to finish before looking at any of it.
+     *
+     * @param pWriter pointer to this object.
+     * @param record  record to build and write, already numbered.
+     */
+    void Writer::staticBuildWriteFunction(Writer *pWriter, RecordOutput *record) {
+        record->setGatherOutput(pWriter->directWriter != nullptr);
+        record->build();
+
+        auto & header = record->getHeader();
+        uint32_t bytesToWrite = header->getLength();
+
+        // Trailer's index has length followed by count
+        pWriter->recordLengths->push_back(bytesToWrite);
+        pWriter->recordLengths->push_back(header->getEntries());
+        uint64_t position = pWriter->writerBytesWritten;
+        pWriter->writerBytesWritten += bytesToWrite;
+        if (pWriter->sidecarIndex != nullptr) {
+            pWriter->sidecarIndex->addRecord(position, *record);
+        }
+
+        if (pWriter->directWriter != nullptr) {
+            record->getSegments(pWriter->segments);
+            pWriter->directWriter->write(pWriter->segments, position, nullptr);
+            return;
+        }
+
+        staticWriteFunction(pWriter, reinterpret_cast<const char *>(record->getBinaryBuffer()->array()),
+                            bytesToWrite, pWriter->writerBytesWritten);
     }
 
 
@@ -392,6 +443,169 @@ namespace evio {
     }
 
 
+    /**
+     * Get the largest allowed ratio of compressed to uncompressed record size
+     * for adaptive compression.
+     * @return largest allowed ratio of compressed to uncompressed record size, 0 if off.
+     */
+    float Writer::getMaxCompressionRatio() const {return maxCompressionRatio;}
+
+
+    /**
+     * Make compression adaptive. A record whose compressed data would be larger than
+     * maxRatio times its uncompressed data is stored uncompressed, saving both space and,
+     * for the slower compression types, the time spent on data that do not compress.
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param maxRatio largest allowed ratio of compressed to uncompressed size (e.g. 0.9).
+     *                 Value &lt;= 0 turns this off, values &gt; 1 are set to 1.
+     */
+    void Writer::setMaxCompressionRatio(float maxRatio) {
+        maxCompressionRatio = maxRatio <= 0.F ? 0.F : (maxRatio > 1.F ? 1.F : maxRatio);
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setMaxCompressionRatio(maxCompressionRatio);
+            }
+        }
+    }
+
+
+    /**
+     * Is a filter of the tags and nums of its events stored in each record's header?
+     * @return true if a tag filter is stored in each record's header.
+     */
+    bool Writer::getTagFilter() const {return tagFilter;}
+
+
+    /**
+     * Store a Bloom filter of the tags and nums of the top-level banks of each record's
+     * events in user register 2 of its header, letting {@link Reader} skip records
+     * without any wanted events without decompressing them.
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param filter true if a tag filter is to be stored in each record's header.
+     */
+    void Writer::setTagFilter(bool filter) {
+        tagFilter = filter;
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setTagFilter(tagFilter);
+            }
+        }
+    }
+
+
+    /**
+     * Is a CRC32C of its data stored in each record's header?
+     * @return true if a checksum is stored in each record's header.
+     */
+    bool Writer::getChecksum() const {return checksum;}
+
+
+    /**
+     * Store a CRC32C of each record's data in its header so that corruption
+     * can be detected when read (see {@link Reader#setVerifyChecksums(bool)}).
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param sum true if a checksum is to be stored in each record's header.
+     */
+    void Writer::setChecksum(bool sum) {
+        checksum = sum;
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setChecksum(checksum);
+            }
+        }
+    }
+
+
+    /**
+     * Store the min and max timestamps of each record's events in its header
+     * (see {@link RecordOutput#setTimestampExtractor(RecordOutput::TimestampExtractor)}),
+     * letting {@link Reader#getRecordsInTimeRange} find the records of a time window
+     * without reading any others.
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param extractor callback finding the timestamp of an event, empty to store none.
+     */
+    void Writer::setTimestampExtractor(RecordOutput::TimestampExtractor extractor) {
+        timestampExtractor = std::move(extractor);
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setTimestampExtractor(timestampExtractor);
+            }
+        }
+    }
+
+
+    /**
+     * Get the uncompressed bytes in each block of seekable lz4 records.
+     * @return uncompressed bytes in each block, 0 if records are not seekable.
+     */
+    uint32_t Writer::getSeekableCompression() const {return seekableBlockSize;}
+
+
+    /**
+     * Compress lz4 records as independent blocks so that
+     * {@link Reader#getEvent(uint32_t, uint32_t *)} decompresses only the blocks holding an event,
+     * not the whole record (see {@link SeekableCompression}).
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param blockSize uncompressed bytes in each block, 0 for ordinary records.
+     */
+    void Writer::setSeekableCompression(uint32_t blockSize) {
+        seekableBlockSize = blockSize;
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setSeekableCompression(seekableBlockSize);
+            }
+        }
+    }
+
+
+    /**
+     * Get the filter applied to the data of compressed records before compressing it.
+     * @return filter applied to data.
+     */
+    Compressor::PreFilter Writer::getPreFilter() const {return preFilter;}
+
+
+    /**
+     * Rearrange the data of compressed records, before compressing it, so it compresses better.
+     * Arrays of 16 or 32 bit ADC values compress much better once their bytes are grouped
+     * by significance (see {@link RecordOutput#setPreFilter(Compressor::PreFilter)}).
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param filter filter to apply, NO_FILTER for none.
+     */
+    void Writer::setPreFilter(Compressor::PreFilter filter) {
+        preFilter = filter;
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setPreFilter(preFilter);
+            }
+        }
+    }
+
+
+    /**
+     * Are the banks of compressed records grouped by column?
+     * @return true if banks of compressed records are grouped by column.
+     */
+    bool Writer::getColumnLayout() const {return columnLayout;}
+
+
+    /**
+     * Group the payloads of banks one level down in the events of compressed records by
+     * tag and num into separately compressed columns
+     * (see {@link RecordOutput#setColumnLayout(bool)}).
+     * Has no effect on records given to {@link #writeRecord(RecordOutput &)}.
+     * @param byColumn true to group banks by column.
+     */
+    void Writer::setColumnLayout(bool byColumn) {
+        columnLayout = byColumn;
+        for (auto & rec : {outputRecord, unusedRecord, beingWrittenRecord}) {
+            if (rec != nullptr) {
+                rec->setColumnLayout(columnLayout);
+            }
+        }
+    }
+
+
     /**
      * Does this writer add a trailer to the end of the file/buffer?
      * @return true if this writer adds a trailer to the end of the file/buffer, else false.
@@ -439,6 +653,108 @@ namespace evio {
     }
 
 
+    /**
+     * Does this writer bypass the page cache (O_DIRECT) when writing to file?
+     * @return true if this writer bypasses the page cache when writing to file.
+     */
+    bool Writer::isDirectIO() const {return directIO;}
+
+
+    /**
+     * Set whether this writer bypasses the page cache (O_DIRECT) when writing to file,
+     * so that writing large files does not push everything else out of memory.
+     * Records are then copied into aligned staging buffers which are written in
+     * large blocks. If the file system does not support it, the page cache is used.
+     * Takes effect with the next call to open().
+     * @param direct true if this writer is to bypass the page cache.
+     */
+    void Writer::setDirectIO(bool direct) {directIO = direct;}
+
+
+    /**
+     * Does this writer compress records in the background when writing to file?
+     * @return true if this writer compresses records in the background.
+     */
+    bool Writer::isBackgroundCompression() const {return backgroundCompression;}
+
+
+    /**
+     * Set whether this writer compresses records in the background when writing to file.
+     * Normally a full record is compressed by the thread adding events, and only its
+     * writing is done by a separate thread. With background compression, that separate
+     * thread compresses the record too, so the caller can go on filling the next record
+     * in the meantime. This nearly doubles the rate at which compressed files can be
+     * written without the multiple threads of {@link WriterMT}.
+     * It changes nothing if writing to a buffer.
+     * Only call before events are added.
+     * @param background true if this writer is to compress records in the background.
+     */
+    void Writer::setBackgroundCompression(bool background) {backgroundCompression = background;}
+
+
+    /**
+     * Set the policy for forcing the written file physically to disk. By default it's left
+     * to the operating system (FileSyncer::NO_SYNC). With FileSyncer::SYNC_ON_CLOSE,
+     * the file is synced by {@link #close()}. With FileSyncer::GROUP_COMMIT, a separate
+     * thread also syncs it (fdatasync) every intervalMillis milliseconds or intervalBytes
+     * bytes, whichever comes first, so that writing never waits on the disk.
+     * {@link #getDurableOffset()} then tells how much of the file is safely on disk.
+     * Takes effect with the next call to open(). Ignored when writing to a buffer.
+     *
+     * @param policy         policy for forcing data to disk.
+     * @param intervalMillis with GROUP_COMMIT, max milliseconds between syncs, 0 for no limit.
+     * @param intervalBytes  with GROUP_COMMIT, max bytes written between syncs, 0 for no limit.
+     */
+    void Writer::setDurability(FileSyncer::Durability policy, uint32_t intervalMillis, uint64_t intervalBytes) {
+        durability = policy;
+        durabilityMillis = intervalMillis;
+        durabilityBytes = intervalBytes;
+    }
+
+
+    /**
+     * Get the policy for forcing the written file to disk.
+     * @return policy for forcing the written file to disk.
+     */
+    FileSyncer::Durability Writer::getDurability() const {return durability;}
+
+
+    /**
+     * Get the position in the file up to which all records written are known to be on disk.
+     * Once closed, it's that of the file closed. Always 0 with FileSyncer::NO_SYNC.
+     * Call from the thread writing events.
+     * @return position in the file up to which all records are on disk.
+     */
+    uint64_t Writer::getDurableOffset() const {
+        if (directWriter != nullptr) return directWriter->getDurableOffset();
+        if (syncer != nullptr) return syncer->getDurableOffset();
+        return closedDurableOffset;
+    }
+
+
+    /**
+     * Write a sidecar index file next to the file written, holding the position,
+     * length and event count of each record as well as the offset and length of each event.
+     * A {@link Reader} uses it to find records if the file has no index of its own,
+     * for example if it has no trailer or was cut short. It's saved by {@link #close()}.
+     * Ignored if records have already been written or if writing to a buffer.
+     *
+     * @param write    if true, write a sidecar index.
+     * @param withTags if true, also save the tag and num of each event.
+     */
+    void Writer::setSidecarIndex(bool write, bool withTags) {
+        if (recordNumber > 1) return;
+        sidecarIndex = write ? std::make_shared<EventIndexFile>(withTags) : nullptr;
+    }
+
+
+    /**
+     * Is a sidecar index file written along with the file?
+     * @return true if a sidecar index file is written along with the file.
+     */
+    bool Writer::isWritingSidecarIndex() const {return sidecarIndex != nullptr;}
+
+
     /**
      * Open a new file and write file header with no user header.
      * @param filename output file name
@@ -509,12 +825,37 @@ namespace evio {
             throw EvioException("error opening file " + filename);
         }
 
-        outFile.write(reinterpret_cast<const char*>(fileHeaderBuffer->array() +
-                                                       fileHeaderBuffer->arrayOffset() +
-                                                       fileHeaderBuffer->position()),
-                         fileHeaderBuffer->remaining());
-        if (outFile.fail()) {
-            throw EvioException("error writing to file " + filename);
+        // If bypassing the page cache, outFile is only used to update the file header in close()
+        if (directIO) {
+            directWriter = FileWriteBackend::create(FileWriteBackend::ASYNC, 1);
+            directWriter->setDurability(durability, durabilityMillis, durabilityBytes);
+            directWriter->open(filename, true);
+            if (!directWriter->isDirect()) {
+                directWriter->close();
+                directWriter = nullptr;
+            }
+        }
+
+        // Records written through outFile are synced separately
+        closedDurableOffset = 0;
+        syncer = nullptr;
+        if (directWriter == nullptr && durability != FileSyncer::NO_SYNC) {
+            syncer = std::make_shared<FileSyncer>(filename, durability, durabilityMillis, durabilityBytes);
+        }
+
+        if (directWriter != nullptr) {
+            directWriter->write(fileHeaderBuffer->array() + fileHeaderBuffer->arrayOffset() +
+                                fileHeaderBuffer->position(),
+                                fileHeaderBuffer->remaining(), 0, nullptr);
+        }
+        else {
+            outFile.write(reinterpret_cast<const char*>(fileHeaderBuffer->array() +
+                                                           fileHeaderBuffer->arrayOffset() +
+                                                           fileHeaderBuffer->position()),
+                             fileHeaderBuffer->remaining());
+            if (outFile.fail()) {
+                throw EvioException("error writing to file " + filename);
+            }
         }
 
         writerBytesWritten = (size_t) fileHeader.getLength();
@@ -893,7 +1234,10 @@ namespace evio {
             // TODO: not really necessary to keep track here?
             writerBytesWritten += RecordHeader::HEADER_SIZE_BYTES;
 
-            if (toFile) {
+            if (toFile && directWriter != nullptr) {
+                directWriter->write(&headerArray[0], RecordHeader::HEADER_SIZE_BYTES, trailerPos, nullptr);
+            }
+            else if (toFile) {
                 outFile.write(reinterpret_cast<const char*>(&headerArray[0]), RecordHeader::HEADER_SIZE_BYTES);
                 //outFile.write(reinterpret_cast<const char*>(headerArray.data()), RecordHeader::HEADER_SIZE_BYTES);
                 if (outFile.fail()) {
@@ -925,7 +1269,10 @@ namespace evio {
 
         // TODO: not really necessary to keep track here?
         writerBytesWritten += dataBytes;
-        if (toFile) {
+        if (toFile && directWriter != nullptr) {
+            directWriter->write(&headerArray[0], dataBytes, trailerPos, nullptr);
+        }
+        else if (toFile) {
 //std::cout << "    writeTrailer: write into file, " << dataBytes << " bytes" << std::endl;
             outFile.write(reinterpret_cast<const char*>(&headerArray[0]), dataBytes);
             //outFile.write(reinterpret_cast<const char*>(headerArray.data()), dataBytes);
@@ -984,18 +1331,147 @@ namespace evio {
         recordLengths->push_back(bytesToWrite);
         // Followed by events in record
         recordLengths->push_back(header->getEntries());
+        uint64_t position = writerBytesWritten;
         writerBytesWritten += bytesToWrite;
+        if (toFile && sidecarIndex != nullptr) {
+            sidecarIndex->addRecord(position, rec);
+        }
 //std::cout << "writeRecord: bytes to write = " << bytesToWrite << std::endl;
 //std::cout << "writeRecord: new record header = \n" << header->toString() << std::endl;
 
-        if (toFile) {
-            outFile.write(reinterpret_cast<const char *>(rec.getBinaryBuffer()->array()), bytesToWrite);
+        // Record may have been built to be written by gathering its parts
+        rec.getSegments(segments);
+
+        if (toFile && directWriter != nullptr) {
+            directWriter->write(segments, position, nullptr);
+        }
+        else if (toFile) {
+            for (auto & seg : segments) {
+                outFile.write(reinterpret_cast<const char *>(seg.data()), seg.size());
+            }
+        }
+        else {
+            for (auto & seg : segments) {
+                buffer->put(seg.data(), seg.size());
+            }
+        }
+    }
+
+    /**
+     * Copy a record, such as one from {@link Reader#getRawRecord}, as is into the file or buffer,
+     * without decompressing or parsing it. Only its record number is changed, to follow those
+     * already written, and its last-record bit cleared. Events already added to the internal
+     * record are written first. Both must have this writer's byte order and compression type,
+     * so the result is the same as if the record's events had been written one by one.
+     * If keeping a sidecar index, the record must not be compressed since its events' lengths
+     * are then only known after decompression.
+     *
+     * @param record view of the whole record, header included.
+     * @throws EvioException if record is not in evio version 6 format, has the wrong byte order
+     *                       or compression type, is compressed when keeping a sidecar index,
+     *                       or there's a problem writing to file.
+     */
+    void Writer::writeRecord(ByteBufferView const & record) {
+
+        if (record.order() != byteOrder) {
+            throw EvioException("record byte order is wrong");
+        }
+
+        if (record.size() < RecordHeader::HEADER_SIZE_BYTES ||
+            record.getInt(RecordHeader::MAGIC_OFFSET) != RecordHeader::HEADER_MAGIC ||
+            4*(size_t)record.getInt(RecordHeader::RECORD_LENGTH_OFFSET) != record.size()) {
+            throw EvioException("not an evio version 6 record");
+        }
+
+        uint32_t compressionWord = record.getInt(RecordHeader::COMPRESSION_TYPE_OFFSET);
+        if (Compressor::toCompressionType((compressionWord >> 28) & 0xf) != compressionType) {
+            throw EvioException("record compression type is wrong");
+        }
+
+        uint32_t bytesToWrite = record.size();
+        uint32_t eventCount = record.getInt(RecordHeader::EVENT_COUNT_OFFSET);
+        uint32_t headerBytes = 4*record.getInt(RecordHeader::HEADER_LENGTH_OFFSET);
+
+        // Event lengths for a sidecar index are in the index array, if it's not compressed
+        std::vector<uint32_t> lengths, tagNums;
+        uint32_t dataOffset = 0;
+        if (toFile && sidecarIndex != nullptr) {
+            if (compressionType != Compressor::UNCOMPRESSED) {
+                throw EvioException("cannot index events of compressed record");
+            }
+            uint32_t indexBytes = record.getInt(RecordHeader::INDEX_ARRAY_OFFSET);
+            uint32_t userBytes = record.getInt(RecordHeader::USER_LENGTH_OFFSET);
+            dataOffset = headerBytes + indexBytes + ((userBytes + 3) & ~3U);
+            uint32_t offset = dataOffset;
+            for (uint32_t i=0; i < eventCount && 4*i < indexBytes; i++) {
+                uint32_t len = record.getInt(headerBytes + 4*i);
+                lengths.push_back(len);
+                // Tag & num are in the 2nd word of an evio bank
+                uint32_t word = len > 7 ? record.getInt(offset + 4) : 0;
+                tagNums.push_back((word & 0xffff0000) | (word & 0xff));
+                offset += len;
+            }
+        }
+
+        // If we have already written stuff into our current internal record,
+        // write that first.
+        if (outputRecord->getEventCount() > 0) {
+            writeOutput();
+        }
+
+        // Wait for previous (if any) write to finish
+        if (toFile && future.valid()) {
+            future.get();
+            unusedRecord = beingWrittenRecord;
+
+            if (outFile.fail()) {
+                throw EvioException("problem writing to file");
+            }
+        }
+
+        // Renumber a copy of the fixed part of the header, the rest is written as is
+        ByteBuffer header(RecordHeader::HEADER_SIZE_BYTES);
+        header.order(byteOrder);
+        header.put(record.data(), RecordHeader::HEADER_SIZE_BYTES);
+        header.putInt(RecordHeader::RECORD_NUMBER_OFFSET, recordNumber++);
+        header.putInt(RecordHeader::BIT_INFO_OFFSET,
+                      record.getInt(RecordHeader::BIT_INFO_OFFSET) & ~RecordHeader::LAST_RECORD_BIT);
+
+        // Trailer's index has length followed by count
+        recordLengths->push_back(bytesToWrite);
+        recordLengths->push_back(eventCount);
+        uint64_t position = writerBytesWritten;
+        writerBytesWritten += bytesToWrite;
+        if (toFile && sidecarIndex != nullptr) {
+            sidecarIndex->addRecord(position, bytesToWrite, dataOffset, lengths, tagNums);
+        }
+
+        segments.clear();
+        segments.emplace_back(header.array(), header.capacity(), byteOrder);
+        segments.push_back(record.subView(RecordHeader::HEADER_SIZE_BYTES,
+                                          bytesToWrite - RecordHeader::HEADER_SIZE_BYTES));
+
+        if (toFile && directWriter != nullptr) {
+            // Neither the header copy nor the caller's record outlive this call
+            directWriter->write(segments, position, nullptr);
+            directWriter->waitForAll();
+        }
+        else if (toFile) {
+            for (auto & seg : segments) {
+                outFile.write(reinterpret_cast<const char *>(seg.data()), seg.size());
+            }
+            if (outFile.fail()) {
+                throw EvioException("problem writing to file");
+            }
         }
         else {
-            buffer->put(rec.getBinaryBuffer()->array(), bytesToWrite);
+            for (auto & seg : segments) {
+                buffer->put(seg.data(), seg.size());
+            }
         }
     }
 
+
     // Use internal outputRecordStream to write individual events
 
     /**
@@ -1121,6 +1597,97 @@ namespace evio {
     }
 
 
+    /**
+     * Add an event built from fragments, each left where it is, to the internal record.
+     * The fragments are copied straight into the record, swapped and given new tags
+     * and nums if so described (see {@link GatheredEvent}). If the event does not fit,
+     * the record will be written to the file (compressed if the flag is set).
+     * Internal record will be reset to receive new buffers.
+     * Using this method in conjunction with writeRecord() is not thread-safe.
+     *
+     * @param event description of event and its fragments.
+     * @throws EvioException if cannot write to file.
+     */
+    void Writer::addEvent(GatheredEvent const & event) {
+        bool status = outputRecord->addEvent(event);
+        if (!status){
+            writeOutput();
+            outputRecord->addEvent(event);
+        }
+    }
+
+
+    /**
+     * Add a batch of events, each in its own ByteBuffer, to the internal record.
+     * Events are added as many at a time as fit in the record, with its
+     * limits checked once per record instead of once per event. Each time the
+     * record fills, it is written to the file (compressed if the flag is set).
+     * Using this method in conjunction with writeRecord() is not thread-safe.
+     * <b>The byte order of events must match the byte order given in constructor!</b>
+     *
+     * @param buffers events to add to the file.
+     * @throws EvioException if a buffer's byte order is wrong or cannot write to file.
+     */
+    void Writer::addEvents(const std::vector<std::shared_ptr<ByteBuffer>> & buffers) {
+        for (auto & buf : buffers) {
+            if (buf->order() != byteOrder) {
+                throw EvioException("buf arg byte order is wrong");
+            }
+        }
+
+        size_t added = 0;
+        while (added < buffers.size()) {
+            added += outputRecord->addEvents(buffers, added);
+            if (added < buffers.size()) {
+                writeOutput();
+            }
+        }
+    }
+
+
+    /**
+     * Add a batch of EvioNodes to the internal record.
+     * Events are added as many at a time as fit in the record, with its
+     * limits checked once per record instead of once per event. Each time the
+     * record fills, it is written to the file (compressed if the flag is set).
+     * Using this method in conjunction with writeRecord() is not thread-safe.
+     * <b>The byte order of nodes' data must match the byte order given in constructor!</b>
+     *
+     * @param nodes events to add to the file.
+     * @throws EvioException if a node does not correspond to a bank or cannot write to file.
+     */
+    void Writer::addEvents(const std::vector<std::shared_ptr<EvioNode>> & nodes) {
+        size_t added = 0;
+        while (added < nodes.size()) {
+            added += outputRecord->addEvents(nodes, added);
+            if (added < nodes.size()) {
+                writeOutput();
+            }
+        }
+    }
+
+
+    /**
+     * Add a batch of EvioBanks to the internal record.
+     * Events are added as many at a time as fit in the record, with its
+     * limits checked once per record instead of once per event. Each time the
+     * record fills, it is written to the file (compressed if the flag is set).
+     * Using this method in conjunction with writeRecord() is not thread-safe.
+     *
+     * @param banks events to add to the file.
+     * @throws EvioException if cannot write to file.
+     */
+    void Writer::addEvents(const std::vector<std::shared_ptr<EvioBank>> & banks) {
+        size_t added = 0;
+        while (added < banks.size()) {
+            added += outputRecord->addEvents(banks, added);
+            if (added < banks.size()) {
+                writeOutput();
+            }
+        }
+    }
+
+
     /**
      * Write internal record with incremented record # to file or buffer.
      * Not thread safe with {@link #writeRecord}.
@@ -1152,6 +1719,20 @@ namespace evio {
 
         header->setRecordNumber(recordNumber++);
         header->setCompressionType(compressionType);
+
+        // Have the writing thread build the record too, while the next is being filled
+        if (backgroundCompression) {
+            future = std::future<void>(
+                    std::async(std::launch::async, staticBuildWriteFunction, this, outputRecord.get()));
+
+            beingWrittenRecord = outputRecord;
+            outputRecord = unusedRecord;
+            outputRecord->reset();
+            return;
+        }
+
+        // Records copied into staging buffers need not be copied together first
+        outputRecord->setGatherOutput(directWriter != nullptr);
         outputRecord->build();
 
         uint32_t bytesToWrite = header->getLength();
@@ -1161,7 +1742,20 @@ namespace evio {
         // Trailer's index has length followed by count
         recordLengths->push_back(bytesToWrite);
         recordLengths->push_back(eventCount);
+        uint64_t position = writerBytesWritten;
         writerBytesWritten += bytesToWrite;
+        if (sidecarIndex != nullptr) {
+            sidecarIndex->addRecord(position, *outputRecord);
+        }
+
+        // If bypassing the page cache, the record is copied into a staging buffer before
+        // this returns and the staging buffer written asynchronously. So it can be refilled now.
+        if (directWriter != nullptr) {
+            outputRecord->getSegments(segments);
+            directWriter->write(segments, position, nullptr);
+            outputRecord->reset();
+            return;
+        }
 
         // Launch async write in separate thread. That way the current thread can be filling
         // and compressing one record while another is simultaneously being written.
@@ -1173,7 +1767,7 @@ namespace evio {
                            staticWriteFunction, // function to run
                            this,                // arguments to function ...
                            reinterpret_cast<const char *>(outputRecord->getBinaryBuffer()->array()),
-                           bytesToWrite));
+                           bytesToWrite, writerBytesWritten));
 
         // Keep track of which record is being written.
         beingWrittenRecord = outputRecord;
@@ -1223,6 +1817,44 @@ namespace evio {
 
     //---------------------------------------------------------------------
 
+    /**
+     * If bypassing the page cache, write everything still staged and close the file
+     * descriptor used to do so. This must be done before the file header is
+     * updated through outFile.
+     * @throws EvioException if error writing to file.
+     */
+    void Writer::closeDirectWriter() {
+        if (directWriter != nullptr) {
+            auto writer = directWriter;
+            directWriter = nullptr;
+            writer->close();
+        }
+    }
+
+
+    /**
+     * Force the file just closed to disk, unless the durability policy is
+     * FileSyncer::NO_SYNC. Its header was updated after all records were written.
+     * @throws EvioException if error syncing file.
+     */
+    void Writer::syncClosedFile() {
+        if (durability == FileSyncer::NO_SYNC) return;
+
+        if (syncer != nullptr) {
+            auto s = syncer;
+            syncer = nullptr;
+            // Syncing through its own descriptor takes in writes made up to now
+            s->written(writerBytesWritten);
+            s->finish();
+            closedDurableOffset = s->getDurableOffset();
+        }
+        else {
+            FileSyncer::syncFile(fileName);
+            closedDurableOffset = writerBytesWritten;
+        }
+    }
+
+
     /** Get this object ready for re-use.
      * Follow calling this with call to {@link #open(const std::string &)}. */
     void Writer::reset() {
@@ -1231,6 +1863,7 @@ namespace evio {
         writerBytesWritten = 0L;
         recordNumber = 1;
         addingTrailer = false;
+        if (sidecarIndex != nullptr) sidecarIndex->clear();
         firstRecordWritten = false;
 
         closed = false;
@@ -1275,6 +1908,8 @@ namespace evio {
             writeTrailer(addTrailerIndex, recordCount, trailerPosition);
 
             if (toFile) {
+                closeDirectWriter();
+
                 // Find & update file header's trailer position word
                 if (byteOrder != ByteOrder::ENDIAN_LOCAL) {
                     trailerPosition = SWAP_64(trailerPosition);
@@ -1299,6 +1934,8 @@ namespace evio {
         }
 
         if (toFile) {
+            closeDirectWriter();
+
             // Need to update the record count in file header
             if (byteOrder != ByteOrder::ENDIAN_LOCAL) {
                 recordCount = SWAP_32(recordCount);
@@ -1309,6 +1946,14 @@ namespace evio {
 
             outFile.close();
             recordLengths->clear();
+            syncClosedFile();
+
+            if (sidecarIndex != nullptr) {
+                if (sidecarIndex->getRecordCount() > 0) {
+                    sidecarIndex->write(EventIndexFile::sidecarName(fileName));
+                }
+                sidecarIndex->clear();
+            }
         }
         else {
             // Get it ready for reading
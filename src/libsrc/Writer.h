@@ -30,6 +30,9 @@
 #include "RecordOutput.h"
 #include "RecordHeader.h"
 #include "Compressor.h"
+#include "SeekableCompression.h"
+#include "FileWriteBackend.h"
+#include "EventIndexFile.h"
 #include "Util.h"
 #include "EvioException.h"
 
@@ -63,6 +66,24 @@ namespace evio {
         std::future<void> future;
         /** Temp storage for next record to be written to. */
         std::shared_ptr<RecordOutput> unusedRecord = nullptr;
+        /** Compress each record in the thread writing it, instead of the caller's? */
+        bool backgroundCompression = false;
+        /** Bypass the page cache when writing file (O_DIRECT)? */
+        bool directIO = false;
+        /** Used instead of outFile to write header, records and trailer if bypassing page cache. */
+        std::shared_ptr<FileWriteBackend> directWriter = nullptr;
+        /** Policy for forcing written file to disk. */
+        FileSyncer::Durability durability = FileSyncer::NO_SYNC;
+        /** With FileSyncer::GROUP_COMMIT, max milliseconds between syncs. */
+        uint32_t durabilityMillis = FileSyncer::DEFAULT_INTERVAL_MILLIS;
+        /** With FileSyncer::GROUP_COMMIT, max bytes written between syncs. */
+        uint64_t durabilityBytes = FileSyncer::DEFAULT_INTERVAL_BYTES;
+        /** Syncs file written through outFile, null with NO_SYNC or if bypassing page cache. */
+        std::shared_ptr<FileSyncer> syncer = nullptr;
+        /** Durable offset of file last closed. */
+        uint64_t closedDurableOffset = 0;
+        /** Parts of the record being written, see {@link RecordOutput#getSegments}. */
+        std::vector<ByteBufferView> segments;
 
         // If writing to buffer ...
 
@@ -100,10 +121,36 @@ namespace evio {
         /** Type of compression to use on file. Default is none. */
         Compressor::CompressionType compressionType {Compressor::UNCOMPRESSED};
 
+        /** Adaptive compression: records whose compressed data are larger than this
+         *  fraction of their uncompressed data are stored uncompressed. 0 means off. */
+        float maxCompressionRatio = 0.F;
+
+        /** Store a filter of the tags and nums of its events in each record's header? */
+        bool tagFilter = false;
+
+        /** Store a CRC32C of its data in each record's header? */
+        bool checksum = false;
+
+        /** If set, finds the event timestamps whose range is stored in each record's header. */
+        RecordOutput::TimestampExtractor timestampExtractor;
+
+        /** If not 0, uncompressed bytes in each block of seekable lz4 records. */
+        uint32_t seekableBlockSize = 0;
+
+        /** Filter applied to data of compressed records before compressing it. */
+        Compressor::PreFilter preFilter = Compressor::NO_FILTER;
+
+        /** Are banks of compressed records grouped by column? */
+        bool columnLayout = false;
+
         /** List of record lengths interspersed with record event counts
          * to be optionally written in trailer. */
         std::shared_ptr<std::vector<uint32_t>> recordLengths;
 
+        /** Index of the records and events written to file, saved to a sidecar
+         *  file on closing. Null if not writing a sidecar index. */
+        std::shared_ptr<EventIndexFile> sidecarIndex = nullptr;
+
         /** Number of bytes written to file/buffer at current moment. */
         size_t writerBytesWritten = 0;
         /** Number which is incremented and stored with each successive written record starting at 1. */
@@ -173,7 +220,8 @@ namespace evio {
         void writeOutput();
         void writeOutputToBuffer();
 
-        static void staticWriteFunction(Writer *pWriter, const char* data, size_t len);
+        static void staticWriteFunction(Writer *pWriter, const char* data, size_t len, uint64_t end);
+        static void staticBuildWriteFunction(Writer *pWriter, RecordOutput *record);
 
     public:
 
@@ -184,12 +232,40 @@ namespace evio {
 //    RecordOutput & getRecord();
         Compressor::CompressionType getCompressionType();
         void setCompressionType(Compressor::CompressionType compression);
+        float getMaxCompressionRatio() const;
+        void setMaxCompressionRatio(float maxRatio);
+        bool getTagFilter() const;
+        void setTagFilter(bool filter);
+        bool getChecksum() const;
+        void setChecksum(bool sum);
+        void setTimestampExtractor(RecordOutput::TimestampExtractor extractor);
+        uint32_t getSeekableCompression() const;
+        void setSeekableCompression(uint32_t blockSize = SeekableCompression::DEFAULT_BLOCK_SIZE);
+        Compressor::PreFilter getPreFilter() const;
+        void setPreFilter(Compressor::PreFilter filter);
+        bool getColumnLayout() const;
+        void setColumnLayout(bool byColumn);
 
         bool addTrailer() const;
         void addTrailer(bool add);
         bool addTrailerWithIndex();
         void addTrailerWithIndex(bool addTrailingIndex);
 
+        bool isDirectIO() const;
+        void setDirectIO(bool direct);
+
+        bool isBackgroundCompression() const;
+        void setBackgroundCompression(bool background);
+
+        void setDurability(FileSyncer::Durability policy,
+                           uint32_t intervalMillis = FileSyncer::DEFAULT_INTERVAL_MILLIS,
+                           uint64_t intervalBytes  = FileSyncer::DEFAULT_INTERVAL_BYTES);
+        FileSyncer::Durability getDurability() const;
+        uint64_t getDurableOffset() const;
+
+        void setSidecarIndex(bool write, bool withTags = false);
+        bool isWritingSidecarIndex() const;
+
         void open(const std::string & filename);
         void open(const std::string & filename, uint8_t* userHdr, uint32_t len);
         void open(std::shared_ptr<ByteBuffer> & buf,  uint8_t* userHdr, uint32_t len);
@@ -206,6 +282,7 @@ namespace evio {
         void createHeader(ByteBuffer & buf, ByteBuffer & userHdr);
 
         void writeRecord(RecordOutput & record);
+        void writeRecord(ByteBufferView const & record);
 
         // Use internal RecordOutput to write individual events
 
@@ -215,6 +292,11 @@ namespace evio {
         void addEvent(std::shared_ptr<EvioBank> & bank);
         void addEvent(std::shared_ptr<EvioNode> & node);
         void addEvent(EvioNode & node);
+        void addEvent(GatheredEvent const & event);
+
+        void addEvents(const std::vector<std::shared_ptr<ByteBuffer>> & buffers);
+        void addEvents(const std::vector<std::shared_ptr<EvioNode>> & nodes);
+        void addEvents(const std::vector<std::shared_ptr<EvioBank>> & banks);
 
         void reset();
         void close();
@@ -222,6 +304,8 @@ namespace evio {
     private:
 
         void writeTrailer(bool writeIndex, uint32_t recordNum, uint64_t trailerPos);
+        void closeDirectWriter();
+        void syncClosedFile();
 
     };
 
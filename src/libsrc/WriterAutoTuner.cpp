@@ -0,0 +1,147 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#include "WriterAutoTuner.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace evio {
+
+
+    /**
+     * Constructor. Call {@link #startThread()} to start tuning.
+     * @param recordSupply supply of records of the writer to tune.
+     * @param stats        where events added to the writer's records are counted.
+     *                     It must outlive this object.
+     * @param config       goals of tuning.
+     */
+    WriterAutoTuner::WriterAutoTuner(std::shared_ptr<RecordSupply> & recordSupply,
+                                     RecordFillStats const & stats,
+                                     AutoTuneConfig const & config) :
+            supply(recordSupply), fillStats(&stats), config(config),
+            maxRecordBytes(recordSupply->getMaxBufferSize()) {
+
+        if (this->config.interval < 1) this->config.interval = 1;
+        if (this->config.maxBusy <= 0. || this->config.maxBusy > 1.) this->config.maxBusy = 1.;
+    }
+
+
+    /** Destructor which stops the thread if running. */
+    WriterAutoTuner::~WriterAutoTuner() {
+        if (thd.joinable()) {
+            stopThread();
+        }
+    }
+
+
+    /** Create and start a thread which reviews the writer's metrics once every interval. */
+    void WriterAutoTuner::startThread() {
+        supply->getMetrics(lastMetrics);
+        fillStats->getMetrics(lastMetrics);
+        lastTime = std::chrono::steady_clock::now();
+        thd = boost::thread([this]() {this->run();});
+    }
+
+
+    /**
+     * Stop the thread, then make all compression threads active
+     * and let records fill their memory again.
+     */
+    void WriterAutoTuner::stopThread() {
+        thd.interrupt();
+        thd.join();
+
+        supply->setActiveCompressors(supply->getCompressionThreadCount());
+        supply->setTargetRecordBytes(0);
+    }
+
+
+    /** Method to run in the thread. */
+    void WriterAutoTuner::run() {
+        try {
+            while (true) {
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(config.interval));
+                review();
+            }
+        }
+        catch (boost::thread_interrupted & e) {}
+    }
+
+
+    /** Compare the writer's metrics to those of the last review and adjust it. */
+    void WriterAutoTuner::review() {
+        WriterMetrics metrics;
+        supply->getMetrics(metrics);
+        fillStats->getMetrics(metrics);
+
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastTime).count();
+        if (seconds <= 0.) return;
+
+        // Rate of data coming in
+        double inRate = (double)(metrics.eventBytes - lastMetrics.eventBytes) / seconds;
+
+        // Rate at which one thread compresses, kept from before if none compressed since
+        uint64_t busy = 0, bytesIn = 0;
+        for (size_t i=0; i < metrics.compressors.size() && i < lastMetrics.compressors.size(); i++) {
+            busy    += metrics.compressors[i].busyTime - lastMetrics.compressors[i].busyTime;
+            bytesIn += metrics.compressors[i].bytesIn  - lastMetrics.compressors[i].bytesIn;
+        }
+        if (busy > 0 && bytesIn > 0) {
+            threadRate = (double)bytesIn / ((double)busy / 1.e6);
+        }
+
+        lastMetrics = metrics;
+        lastTime = now;
+
+        //------------------------------------
+        // Number of compression threads
+        //------------------------------------
+        uint32_t total  = supply->getCompressionThreadCount();
+        uint32_t active = supply->getActiveCompressors();
+        uint32_t least  = std::max(1U, std::min(config.minCompressors, total));
+
+        uint32_t needed = active;
+        if (threadRate > 0.) {
+            double rate = std::max(inRate, (double)config.minThroughput);
+            needed = (uint32_t) std::min((double)total, std::ceil(rate / (threadRate * config.maxBusy)));
+        }
+        needed = std::max(needed, least);
+
+        // Records backing up means more help is needed, whatever was measured
+        if (metrics.waitingToCompress > active) {
+            needed = std::max(needed, active + 1);
+        }
+
+        if (needed > active) {
+            supply->setActiveCompressors(needed);
+        }
+        else if (needed < active) {
+            // Park gradually
+            supply->setActiveCompressors(active - 1);
+        }
+
+        //------------------------------------
+        // Target record size
+        //------------------------------------
+        if (config.maxLatency > 0) {
+            double bytes = inRate * (double)config.maxLatency / 1.e6;
+            uint32_t target = 0;
+            if (bytes < (double)maxRecordBytes) {
+                target = std::max(config.minRecordBytes, (uint32_t)bytes);
+                if (target >= maxRecordBytes) target = 0;
+            }
+            supply->setTargetRecordBytes(target);
+        }
+    }
+
+}
@@ -0,0 +1,125 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_WRITERAUTOTUNER_H
+#define EVIO_6_0_WRITERAUTOTUNER_H
+
+
+#include <cstdint>
+#include <memory>
+#include <chrono>
+
+
+#include "RecordSupply.h"
+#include "RecordFillStats.h"
+#include "WriterMetrics.h"
+
+
+#include <boost/thread.hpp>
+
+
+namespace evio {
+
+
+    /**
+     * This class holds the goals of a writer's auto-tuning
+     * (see {@link WriterAutoTuner}).
+     */
+    class AutoTuneConfig {
+
+    public:
+
+        /** Time between reviews of the writer's metrics in milliseconds. */
+        uint32_t interval = 500;
+
+        /** Rate of incoming data in bytes/sec the compression threads must be ready for,
+         *  even if less is coming in. 0 to size them to the rate measured. */
+        uint64_t minThroughput = 0;
+
+        /** Fraction of time at most the active compression threads should be busy.
+         *  Above this a thread is added, well below it one is parked. */
+        double maxBusy = 0.8;
+
+        /** Least number of active compression threads. */
+        uint32_t minCompressors = 1;
+
+        /** Time in microseconds an event should wait at most for its record to fill.
+         *  Records are made smaller to fill within this time at the rate measured.
+         *  0 to always fill records' memory, giving the best throughput and compression. */
+        uint64_t maxLatency = 0;
+
+        /** Smallest target size of records in bytes when limiting latency. */
+        uint32_t minRecordBytes = 256*1024;
+    };
+
+
+    /**
+     * This class is a thread which adjusts a writer to its data rate as it runs.
+     * Once every interval it reviews the writer's metrics and:
+     * <ul>
+     * <li>sets the number of active compression threads to what the incoming data rate needs,
+     *     given the rate at which a thread has been compressing, so that they are busy no more than
+     *     {@link AutoTuneConfig#maxBusy} of the time. Threads not needed are parked and use no CPU.
+     *     One is added at once if records back up waiting to be compressed, and
+     *     at most one is parked each interval so a short lull does not park them all;</li>
+     * <li>if {@link AutoTuneConfig#maxLatency} is set, sets the target size of records so that,
+     *     at the incoming data rate, a record fills within that time.</li>
+     * </ul>
+     * It works through the writer's {@link RecordSupply}, so only when compressing with a ring of
+     * records. When stopped, all compression threads are made active and records fill their memory.
+     */
+    class WriterAutoTuner {
+
+    private:
+
+        /** Supply of records of the writer being tuned. */
+        std::shared_ptr<RecordSupply> supply;
+        /** Where events added to the writer's records are counted. */
+        RecordFillStats const * fillStats;
+        /** Goals of tuning. */
+        AutoTuneConfig config;
+        /** Largest target record size, from the memory of a record. */
+        uint32_t maxRecordBytes;
+
+        /** Thread which does the tuning. */
+        boost::thread thd;
+
+        /** Metrics of the last review. */
+        WriterMetrics lastMetrics;
+        /** Time of the last review. */
+        std::chrono::steady_clock::time_point lastTime;
+        /** Bytes one thread compresses per second, measured so far, 0 if not yet known. */
+        double threadRate = 0.;
+
+        void run();
+        void review();
+
+    public:
+
+        WriterAutoTuner(std::shared_ptr<RecordSupply> & recordSupply,
+                        RecordFillStats const & stats,
+                        AutoTuneConfig const & config);
+
+        WriterAutoTuner(const WriterAutoTuner & tuner) = delete;
+        WriterAutoTuner & operator=(const WriterAutoTuner & tuner) = delete;
+
+        ~WriterAutoTuner();
+
+        void startThread();
+        void stopThread();
+
+        /** @return goals of tuning. */
+        AutoTuneConfig const & getConfig() const {return config;}
+    };
+
+}
+
+
+#endif //EVIO_6_0_WRITERAUTOTUNER_H
@@ -66,13 +66,19 @@ namespace evio {
      * @param compressionThreads number of threads doing compression simultaneously
      * @param addTrailerIndex if true, we add a record index to the trailer.
      * @param ringSize      number of records in supply ring, must be multiple of 2
-     *                      and >= compressionThreads.
+     *                      and >= compressionThreads. In {@link #PER_PRODUCER_ORDER} mode each
+     *                      producer holds a record, so it should be >= compressionThreads +
+     *                      number of producers + 1 to keep producers from blocking each other.
+     * @param producerOrder how events added by multiple threads are ordered.
+     * @param waitStrategy  how compression and writing threads wait for records.
+     * @param waitTimeout   if &gt; 0, max microseconds a blocking wait lasts before waiting again.
      */
     WriterMT::WriterMT(const HeaderType & hType, const ByteOrder & order,
                        uint32_t maxEventCount, uint32_t maxBufferSize,
                        const std::string & dictionary, uint8_t* firstEvent, uint32_t firstEventLen,
                        Compressor::CompressionType compType, uint32_t compressionThreads,
-                       bool addTrailerIndex, uint32_t ringSize) {
+                       bool addTrailerIndex, uint32_t ringSize, ProducerOrder producerOrder,
+                       RecordSupply::WaitStrategyType waitStrategy, uint32_t waitTimeout) {
 
         byteOrder = order;
         this->dictionary = dictionary;
@@ -84,6 +90,7 @@ namespace evio {
         this->maxEventCount = maxEventCount;
         this->maxBufferSize = maxBufferSize;
         this->addTrailerIndex = addTrailerIndex;
+        this->producerOrder = producerOrder;
 
         compressionType = compType;
         compressionThreadCount = compressionThreads;
@@ -105,6 +112,7 @@ namespace evio {
         }
         else {
             // Tell open() there is no dictionary/first event data
+            dictionaryFirstEventBuffer = std::make_shared<ByteBuffer>(1);
             dictionaryFirstEventBuffer->limit(0);
         }
 
@@ -124,11 +132,25 @@ namespace evio {
         supply = std::make_shared<RecordSupply>(finalRingSize, byteOrder,
                                                 compressionThreads,
                                                 maxEventCount, maxBufferSize,
-                                                compressionType);
-
-        // Get a single blank record to start writing into
-        ringItem = supply->get();
-        outputRecord = ringItem->getRecord();
+                                                compressionType,
+                                                producerOrder == PER_PRODUCER_ORDER,
+                                                waitStrategy, waitTimeout,
+                                                compressionType == Compressor::UNCOMPRESSED);
+
+        // Map the ring's memory now rather than page by page while writing
+        supply->touchRecords();
+        supply->setFillStats(&fillStats);
+
+        if (producerOrder == PER_PRODUCER_ORDER) {
+            // Producers only take records from the supply when they have events for them
+            defaultProducer = std::make_shared<Producer>(supply, byteOrder);
+            producers.push_back(defaultProducer);
+        }
+        else {
+            // Get a single blank record to start writing into
+            ringItem = supply->get();
+            outputRecord = ringItem->getRecord();
+        }
 
         // TODO: start up threads ?????
     }
@@ -156,7 +178,7 @@ namespace evio {
      *                      Value of O means use default (1M).
      * @param maxBufferSize max number of uncompressed data bytes a record can hold.
      *                      Value of < 8MB results in default of 8MB.
-     * @param compType      type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip)
+     * @param compType      type of data compression to do (0=none, 1=lz4 fast, 2=lz4 best, 3=gzip, 4=zstd)
      * @param compressionThreads number of threads doing compression simultaneously
      */
     WriterMT::WriterMT(const std::string & filename, const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
@@ -168,6 +190,127 @@ namespace evio {
     }
 
 
+    /** Destructor, which leaves the shared compression pool if never closed. */
+    WriterMT::~WriterMT() {
+        if (sharedCompression) {
+            CompressionExecutor::getInstance().removeSupply(supply);
+        }
+    }
+
+
+    //////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Constructor.
+     * @param recordSupply supply of records shared with the writer.
+     * @param order byte order that all added events must have.
+     */
+    WriterMT::Producer::Producer(std::shared_ptr<RecordSupply> & recordSupply, const ByteOrder & order) :
+            supply(recordSupply), order(order) {
+    }
+
+
+    /**
+     * Take an empty record from the supply. This claims the record's place in the file.
+     * This may block if threads are busy compressing and/or writing all records in supply.
+     */
+    void WriterMT::Producer::claimRecord() {
+        item = supply->get();
+        record = item->getRecord();
+    }
+
+
+    /**
+     * Add a byte array to this producer's current record. If the record is full,
+     * it's handed off to be compressed and written, and another is taken from the supply.
+     *
+     * @param buffer array to add to the file.
+     * @param offset offset into array from which to start writing data.
+     * @param length number of bytes to write from array.
+     */
+    void WriterMT::Producer::addEvent(uint8_t *buffer, uint32_t offset, uint32_t length) {
+        if (item == nullptr) {
+            claimRecord();
+        }
+
+        // If record is full ...
+        if (!record->addEvent(buffer + offset, length)) {
+            supply->publish(item);
+            claimRecord();
+            // Adding the first event to a record is guaranteed to work
+            record->addEvent(buffer + offset, length);
+        }
+    }
+
+
+    /**
+     * Add a ByteBuffer to this producer's current record. If the record is full,
+     * it's handed off to be compressed and written, and another is taken from the supply.
+     * <b>The byte order of event's data must match the byte order of the writer!</b>
+     *
+     * @param buffer buffer to add to the file.
+     * @throws EvioException if buffer arg's byte order is wrong.
+     */
+    void WriterMT::Producer::addEvent(ByteBuffer & buffer) {
+        if (buffer.order() != order) {
+            throw EvioException("buffer arg byte order is wrong");
+        }
+
+        if (item == nullptr) {
+            claimRecord();
+        }
+
+        if (!record->addEvent(buffer)) {
+            supply->publish(item);
+            claimRecord();
+            record->addEvent(buffer);
+        }
+    }
+
+
+    /**
+     * Add an EvioNode to this producer's current record. If the record is full,
+     * it's handed off to be compressed and written, and another is taken from the supply.
+     * <b>The byte order of node's data must match the byte order of the writer!</b>
+     *
+     * @param node node to add to the file.
+     * @throws EvioException if node arg's byte order is wrong.
+     */
+    void WriterMT::Producer::addEvent(EvioNode & node) {
+        if (node.getBuffer()->order() != order) {
+            throw EvioException("buffer arg byte order is wrong");
+        }
+
+        if (item == nullptr) {
+            claimRecord();
+        }
+
+        if (!record->addEvent(node)) {
+            supply->publish(item);
+            claimRecord();
+            record->addEvent(node);
+        }
+    }
+
+
+    /**
+     * Hand off the current record, if any, to be compressed and written.
+     * A producer which stops adding events for a while should call this so the
+     * records of other producers are not kept from being written.
+     * Must not be called simultaneously with this producer's addEvent methods.
+     */
+    void WriterMT::Producer::flush() {
+        // Once taken from the supply a record must be published,
+        // even if empty, or the writing thread will wait for it forever.
+        if (item != nullptr) {
+            supply->publish(item);
+            item = nullptr;
+            record = nullptr;
+        }
+    }
+
+
     //////////////////////////////////////////////////////////////////////
 
 
@@ -205,6 +348,107 @@ namespace evio {
     Compressor::CompressionType WriterMT::getCompressionType() {return compressionType;}
 
 
+    /**
+     * Make compression adaptive. A record whose compressed data would be larger than
+     * maxRatio times its uncompressed data is stored uncompressed. Records may also be
+     * compressed with the fastest lz4 whenever they back up in the internal ring.
+     * This starts once the percentage of filled but unwritten records in the ring
+     * reaches fillLevel, and stops once it drops to half of that.
+     * Should be called before any events are added.
+     *
+     * @param maxRatio  largest allowed ratio of compressed to uncompressed size (e.g. 0.9).
+     *                  Value &lt;= 0 turns this off, values &gt; 1 are set to 1.
+     * @param fillLevel ring fill level in percent at which to compress with the fastest lz4,
+     *                  0 for never.
+     */
+    void WriterMT::setAdaptiveCompression(float maxRatio, uint32_t fillLevel) {
+        supply->setAdaptiveCompression(maxRatio, fillLevel);
+    }
+
+
+    /**
+     * Store a Bloom filter of the tags and nums of the top-level banks of each record's
+     * events in user register 2 of its header, letting {@link Reader} skip records
+     * without any wanted events without decompressing them.
+     * Should be called before any events are added.
+     * @param filter true if a tag filter is to be stored in each record's header.
+     */
+    void WriterMT::setTagFilter(bool filter) {
+        supply->setTagFilter(filter);
+    }
+
+
+    /**
+     * Store a CRC32C of each record's data in its header so that corruption
+     * can be detected when read (see {@link Reader#setVerifyChecksums(bool)}).
+     * Should be called before any events are added.
+     * @param sum true if a checksum is to be stored in each record's header.
+     */
+    void WriterMT::setChecksum(bool sum) {
+        supply->setChecksum(sum);
+    }
+
+
+    /**
+     * Store the min and max timestamps of each record's events in its header
+     * (see {@link RecordOutput#setTimestampExtractor(RecordOutput::TimestampExtractor)}),
+     * letting {@link Reader#getRecordsInTimeRange} find the records of a time window
+     * without reading any others.
+     * Should be called before any events are added.
+     * @param extractor callback finding the timestamp of an event, empty to store none.
+     */
+    void WriterMT::setTimestampExtractor(RecordOutput::TimestampExtractor extractor) {
+        supply->setTimestampExtractor(extractor);
+    }
+
+
+    /**
+     * Run a user stage on the events of each record, on the compression threads, before it is
+     * compressed (see {@link RecordOutput#setRecordProcessor(RecordOutput::RecordProcessor)}).
+     * It may drop, rewrite or add events, and must be thread safe.
+     * Should be called before any events are added.
+     * @param processor callback run on each record's events, empty for none.
+     */
+    void WriterMT::setRecordProcessor(RecordOutput::RecordProcessor processor) {
+        supply->setRecordProcessor(processor);
+    }
+
+
+    /**
+     * Compress lz4 records as independent blocks so that
+     * {@link Reader#getEvent(uint32_t, uint32_t *)} decompresses only the blocks holding an event,
+     * not the whole record (see {@link SeekableCompression}).
+     * Should be called before any events are added.
+     * @param blockSize uncompressed bytes in each block, 0 for ordinary records.
+     */
+    void WriterMT::setSeekableCompression(uint32_t blockSize) {
+        supply->setSeekableCompression(blockSize);
+    }
+
+
+    /**
+     * Rearrange the data of compressed records, before compressing it, so it compresses better
+     * (see {@link RecordOutput#setPreFilter(Compressor::PreFilter)}).
+     * Should be called before any events are added.
+     * @param filter filter to apply, NO_FILTER for none.
+     */
+    void WriterMT::setPreFilter(Compressor::PreFilter filter) {
+        supply->setPreFilter(filter);
+    }
+
+
+    /**
+     * Group the payloads of banks one level down in the events of compressed records
+     * by tag and num into separately compressed columns
+     * (see {@link RecordOutput#setColumnLayout(bool)}).
+     * Should be called before any events are added.
+     * @param byColumn true to group banks by column.
+     */
+    void WriterMT::setColumnLayout(bool byColumn) {
+        supply->setColumnLayout(byColumn);
+    }
+
+
     /**
      * Does this writer add a trailer to the end of the file/buffer?
      * @return true if this writer adds a trailer to the end of the file/buffer, else false.
@@ -212,6 +456,125 @@ namespace evio {
     bool WriterMT::addTrailer() const {return addingTrailer;}
 
 
+    /**
+     * Get how events added by multiple threads are ordered.
+     * @return how events added by multiple threads are ordered.
+     */
+    WriterMT::ProducerOrder WriterMT::getProducerOrder() const {return producerOrder;}
+
+
+    /**
+     * Pin compression and writing threads to sets of CPUs (Linux only).
+     * May be called before or after {@link #open(const std::string &)}.
+     * Optionally, spread the memory of the records in the internal ring evenly over the
+     * NUMA nodes of the compression threads. Since records go to whichever compression
+     * thread is free, a record is not always compressed on the node holding it.
+     * This only works if the number of compression threads divides the ring size
+     * (e.g. both are powers of 2) and is only done if called before open().
+     *
+     * @param compressorCpus   CPU sets for compression threads. Thread n uses set
+     *                         n modulo (number of sets). Empty for no pinning.
+     * @param writerCpus       CPU set for writing thread. Empty for no pinning.
+     * @param numaLocalRecords if true, spread records' memory over the compression threads' nodes.
+     */
+    void WriterMT::setThreadAffinity(const std::vector<std::vector<uint32_t>> & compressorCpus,
+                                     const std::vector<uint32_t> & writerCpus,
+                                     bool numaLocalRecords) {
+        this->compressorCpus   = compressorCpus;
+        this->writerCpus       = writerCpus;
+        this->numaLocalRecords = numaLocalRecords;
+
+        if (opened) {
+            // Records may already be in use, so leave their memory alone
+            applyThreadAffinity(false);
+        }
+    }
+
+
+    /**
+     * Pin running compression and writing threads as set in {@link #setThreadAffinity}.
+     * @param placeRecords if true, also place records' memory if so requested.
+     */
+    void WriterMT::applyThreadAffinity(bool placeRecords) {
+        if (!compressorCpus.empty()) {
+            for (uint32_t i=0; i < recordCompressorThreads.size(); i++) {
+                recordCompressorThreads[i].setAffinity(compressorCpus[i % compressorCpus.size()],
+                                                       numaLocalRecords && placeRecords);
+            }
+        }
+
+        if (!recordWriterThreads.empty()) {
+            recordWriterThreads[0].setAffinity(writerCpus);
+        }
+    }
+
+
+    /**
+     * Turn auto-tuning on or off. While on, and the file is open, a thread adjusts the number of
+     * active compression threads, and optionally the size of records, to the incoming data rate
+     * (see {@link WriterAutoTuner}). May be called before or after {@link #open(const std::string &)}.
+     * When turned off, all compression threads are made active and records fill their memory.
+     * @param tune   if true, auto-tune, else stop.
+     * @param config goals of tuning.
+     */
+    void WriterMT::setAutoTune(bool tune, const AutoTuneConfig & config) {
+        if (autoTuner != nullptr) {
+            autoTuner->stopThread();
+            autoTuner.reset();
+        }
+
+        autoTune = tune;
+        autoTuneConfig = config;
+
+        if (autoTune && opened) {
+            autoTuner = std::make_unique<WriterAutoTuner>(supply, fillStats, autoTuneConfig);
+            autoTuner->startThread();
+        }
+    }
+
+
+    /**
+     * Is auto-tuning on?
+     * @return true if auto-tuning is on.
+     */
+    bool WriterMT::getAutoTune() const {return autoTune;}
+
+
+    /**
+     * Get the total time spent waiting for an empty record to fill,
+     * which happens when all records are being compressed or written.
+     * @return total producer wait time in microseconds.
+     */
+    uint64_t WriterMT::getProducerWaitTime() const {return supply->getProducerWaitTime();}
+
+
+    /**
+     * Get the total time compression threads spent idle, waiting for records to compress.
+     * @return total compression thread wait time in microseconds, summed over all threads.
+     */
+    uint64_t WriterMT::getCompressWaitTime() const {return supply->getCompressWaitTime();}
+
+
+    /**
+     * Get the total time the writing thread spent idle, waiting for records to write.
+     * @return total writing thread wait time in microseconds.
+     */
+    uint64_t WriterMT::getWriteWaitTime() const {return supply->getWriteWaitTime();}
+
+
+    /**
+     * Get a snapshot of the state of the ring, compression threads and writing.
+     * May be called from any thread.
+     * @return current metrics.
+     */
+    WriterMetrics WriterMT::getMetrics() const {
+        WriterMetrics metrics;
+        supply->getMetrics(metrics);
+        fillStats.getMetrics(metrics);
+        return metrics;
+    }
+
+
     /**
      * Set whether this writer adds a trailer to the end of the file/buffer.
      * @param add if true, at the end of file/buffer, add an ending header (trailer)
@@ -316,21 +679,36 @@ namespace evio {
 
         writerBytesWritten = (size_t) (fileHeader.getLength());
 
-        // Create compression threads
-        recordCompressorThreads.reserve(compressionThreadCount);
-        for (int i=0; i < compressionThreadCount; i++) {
-            recordCompressorThreads.emplace_back(i, compressionType, supply);
+        // Have the shared pool, if any, compress records, else our own threads.
+        // There are none to compress if they go straight to the writing thread.
+        sharedCompression = !supply->isPassThrough() && CompressionExecutor::getInstance().isEnabled();
+        if (sharedCompression) {
+            CompressionExecutor::getInstance().addSupply(supply, compressionType);
         }
+        else if (!supply->isPassThrough()) {
+            // Create compression threads
+            recordCompressorThreads.reserve(compressionThreadCount);
+            for (int i=0; i < compressionThreadCount; i++) {
+                recordCompressorThreads.emplace_back(i, compressionType, supply);
+            }
 
-        // Start compression threads
-        for (int i=0; i < compressionThreadCount; i++) {
-            recordCompressorThreads[i].startThread();
+            // Start compression threads
+            for (int i=0; i < compressionThreadCount; i++) {
+                recordCompressorThreads[i].startThread();
+            }
         }
 
         // Create & start writing thread
         recordWriterThreads.emplace_back(this,supply);
         recordWriterThreads[0].startThread();
 
+        applyThreadAffinity(true);
+
+        if (autoTune) {
+            autoTuner = std::make_unique<WriterAutoTuner>(supply, fillStats, autoTuneConfig);
+            autoTuner->startThread();
+        }
+
         opened = true;
     }
 
@@ -517,7 +895,8 @@ namespace evio {
 
     /**
      * Appends the record to the file.
-     * Using this method in conjunction with {@link #addEvent()} is not thread-safe.
+     * Using this method in conjunction with {@link #addEvent()} is only thread-safe
+     * if not constructed with {@link #SINGLE_PRODUCER}.
      * @param rec record object
      * @throws EvioException if record's byte order is opposite to output endian.
      */
@@ -527,6 +906,20 @@ namespace evio {
             throw EvioException("record byte order is wrong");
         }
 
+        std::unique_lock<std::mutex> lock(producerMutex, std::defer_lock);
+        if (producerOrder != SINGLE_PRODUCER) {
+            lock.lock();
+        }
+
+        if (producerOrder == PER_PRODUCER_ORDER) {
+            // Keep this record after the events already added through this object
+            defaultProducer->flush();
+            auto & item = supply->get();
+            item->getRecord()->transferDataForReading(rec);
+            supply->publish(item);
+            return;
+        }
+
         // If we have already written stuff into our current internal record ...
         if (outputRecord->getEventCount() > 0) {
             // Put it back in supply for compressing
@@ -556,16 +949,27 @@ namespace evio {
      * the buffer exceeds the maximum size of the record, the record
      * will be written to the file (compressed if the flag is set).
      * And another record will be obtained from the supply to receive the buffer.
-     * Using this method in conjunction with {@link #writeRecord(RecordOutput &)}
-     * is not thread-safe.
+     * This method may be called by multiple threads simultaneously (and in conjunction
+     * with {@link #writeRecord(RecordOutput &)}) only if not constructed with
+     * {@link #SINGLE_PRODUCER}.
      *
      * @param buffer array to add to the file.
      * @param offset offset into array from which to start writing data.
      * @param length number of bytes to write from array.
      */
     void WriterMT::addEvent(uint8_t *buffer, uint32_t offset, uint32_t length) {
+        std::unique_lock<std::mutex> lock(producerMutex, std::defer_lock);
+        if (producerOrder != SINGLE_PRODUCER) {
+            lock.lock();
+        }
+
+        if (producerOrder == PER_PRODUCER_ORDER) {
+            defaultProducer->addEvent(buffer, offset, length);
+            return;
+        }
+
         // Try putting data into current record being filled
-        bool status = outputRecord->addEvent(buffer, offset, length);
+        bool status = outputRecord->addEvent(buffer + offset, length);
 
         // If record is full ...
         if (!status) {
@@ -579,7 +983,7 @@ namespace evio {
             outputRecord = ringItem->getRecord();
 
             // Adding the first event to a record is guaranteed to work
-            outputRecord->addEvent(buffer, offset, length);
+            outputRecord->addEvent(buffer + offset, length);
         }
     }
 
@@ -589,7 +993,8 @@ namespace evio {
      * the buffer exceeds the maximum size of the record, the record
      * will be written to the file (compressed if the flag is set).
      * Internal record will be reset to receive new buffers.
-     * Using this method in conjunction with writeRecord() is not thread-safe.
+     * Using this method from multiple threads or in conjunction with writeRecord()
+     * is only thread-safe if not constructed with {@link #SINGLE_PRODUCER}.
      * <b>The byte order of event's data must
      * match the byte order given in constructor!</b>
      *
@@ -602,6 +1007,16 @@ namespace evio {
             throw EvioException("buffer arg byte order is wrong");
         }
 
+        std::unique_lock<std::mutex> lock(producerMutex, std::defer_lock);
+        if (producerOrder != SINGLE_PRODUCER) {
+            lock.lock();
+        }
+
+        if (producerOrder == PER_PRODUCER_ORDER) {
+            defaultProducer->addEvent(buffer);
+            return;
+        }
+
         bool status = outputRecord->addEvent(buffer);
 
         // If record is full ...
@@ -626,7 +1041,8 @@ namespace evio {
      * the data exceeds the maximum size of the record, the record
      * will be written to the file (compressed if the flag is set).
      * Internal record will be reset to receive new buffers.
-     * Using this method in conjunction with writeRecord() is not thread-safe.
+     * Using this method from multiple threads or in conjunction with writeRecord()
+     * is only thread-safe if not constructed with {@link #SINGLE_PRODUCER}.
      * <b>The byte order of node's data must
      * match the byte order given in constructor!</b>
      *
@@ -639,6 +1055,16 @@ namespace evio {
             throw EvioException("buffer arg byte order is wrong");
         }
 
+        std::unique_lock<std::mutex> lock(producerMutex, std::defer_lock);
+        if (producerOrder != SINGLE_PRODUCER) {
+            lock.lock();
+        }
+
+        if (producerOrder == PER_PRODUCER_ORDER) {
+            defaultProducer->addEvent(node);
+            return;
+        }
+
         bool status = outputRecord->addEvent(node);
 
         // If record is full ...
@@ -658,13 +1084,38 @@ namespace evio {
     }
 
 
+    /**
+     * Create a producer through which a single thread adds events to this writer.
+     * Each thread should have its own. All producers must be done adding events
+     * before {@link #close()} is called, which flushes them.
+     *
+     * @return new producer.
+     * @throws EvioException if not constructed with {@link #PER_PRODUCER_ORDER} or closed.
+     */
+    std::shared_ptr<WriterMT::Producer> WriterMT::createProducer() {
+        if (producerOrder != PER_PRODUCER_ORDER) {
+            throw EvioException("producers require PER_PRODUCER_ORDER");
+        }
+        if (closed) {
+            throw EvioException("writer is closed");
+        }
+
+        auto producer = std::make_shared<Producer>(supply, byteOrder);
+        std::lock_guard<std::mutex> lock(producerMutex);
+        producers.push_back(producer);
+        return producer;
+    }
+
+
     //---------------------------------------------------------------------
 
 
     /** Get this object ready for re-use.
      * Follow calling this with call to {@link #open(const std::string &)}. */
     void WriterMT::reset() {
-        outputRecord->reset();
+        if (outputRecord != nullptr) {
+            outputRecord->reset();
+        }
         fileHeader.reset();
         writerBytesWritten = 0L;
         recordNumber = 1;
@@ -685,8 +1136,22 @@ namespace evio {
     void WriterMT::close() {
         if (closed) return;
 
+        // Finish with all compression threads active
+        if (autoTuner != nullptr) {
+            autoTuner->stopThread();
+            autoTuner.reset();
+        }
+
+        if (producerOrder == PER_PRODUCER_ORDER) {
+            // Every record taken by a producer must be sent off, since the
+            // writing thread processes them in order, up to the last one taken.
+            std::lock_guard<std::mutex> lock(producerMutex);
+            for (auto & producer : producers) {
+                producer->flush();
+            }
+        }
         // If we're in the middle of building a record, send it off since we're done
-        if (outputRecord->getEventCount() > 0) {
+        else if (outputRecord->getEventCount() > 0) {
             // Put it in queue for compressing
             supply->publish(ringItem);
         }
@@ -699,6 +1164,10 @@ namespace evio {
         for (RecordCompressor &thd : recordCompressorThreads) {
             thd.stopThread();
         }
+        if (sharedCompression) {
+            CompressionExecutor::getInstance().removeSupply(supply);
+            sharedCompression = false;
+        }
 
         // Don't hang on to thread objects and therefore boost threads & RecordSupply objects
         recordCompressorThreads.clear();
@@ -22,6 +22,7 @@
 #include <chrono>
 #include <memory>
 #include <atomic>
+#include <mutex>
 
 
 #include "FileHeader.h"
@@ -30,9 +31,12 @@
 #include "RecordOutput.h"
 #include "RecordHeader.h"
 #include "Compressor.h"
+#include "SeekableCompression.h"
 #include "Writer.h"
 #include "RecordSupply.h"
 #include "RecordCompressor.h"
+#include "CompressionExecutor.h"
+#include "WriterAutoTuner.h"
 #include "Util.h"
 #include "EvioException.h"
 
@@ -56,7 +60,15 @@ namespace evio {
     * After compression, it's again placed back into the ring and waits for a final thread to
     * write it to file. After being written, the record is freed up for reuse.
     * This entire ring functionality is encapsulated in 2 classes,
-    * {@link RecordSupply} and {@link RecordRingItem}.
+    * {@link RecordSupply} and {@link RecordRingItem}.<p>
+    *
+    * Events may be added by more than one thread. If constructed with {@link #ARRIVAL_ORDER},
+    * threads take turns filling the one current record so events are written in the exact order
+    * their addEvent calls were made. If constructed with {@link #PER_PRODUCER_ORDER}, each thread
+    * obtains its own {@link Producer} through {@link #createProducer()}. A producer fills its own
+    * records and claims their place in the ring without locking. Events from one producer stay in
+    * the order it added them, while whole records from different producers are written in the
+    * order they were claimed.
     *
     * @version 6.0
     * @since 6.0 5/13/19
@@ -65,6 +77,56 @@ namespace evio {
     class WriterMT {
 
 
+    public:
+
+        /** How events added by multiple threads are ordered in the file. */
+        enum ProducerOrder {
+            /** Only one thread adds events or records (default). */
+            SINGLE_PRODUCER = 0,
+            /** Threads share the current record, events are written in the order they arrive. */
+            ARRIVAL_ORDER,
+            /** Each thread fills its own records through a {@link Producer}, lock-free. */
+            PER_PRODUCER_ORDER
+        };
+
+
+        /**
+         * Class used by a single thread to add events to a WriterMT constructed with
+         * {@link #PER_PRODUCER_ORDER}. It fills its own records taken from the writer's
+         * RecordSupply, and gives each back to be compressed and written when it's full.
+         * A record is only taken from the supply once there is an event to put into it.
+         * Since the writing thread handles records in the order they were taken,
+         * a producer which is holding a partially filled record and goes idle will hold up
+         * the writing of others' records until it calls {@link #flush()}.
+         * Create with {@link WriterMT#createProducer()}.
+         */
+        class Producer {
+
+        private:
+
+            /** Supply of RecordRingItems shared with the writer and other producers. */
+            std::shared_ptr<RecordSupply> supply;
+            /** Ring item currently being filled, null if none. */
+            std::shared_ptr<RecordRingItem> item;
+            /** Record of the current ring item. */
+            std::shared_ptr<RecordOutput> record;
+            /** Byte order that all added events must have. */
+            ByteOrder order {ByteOrder::ENDIAN_LOCAL};
+
+            void claimRecord();
+
+        public:
+
+            Producer(std::shared_ptr<RecordSupply> & recordSupply, const ByteOrder & order);
+
+            void addEvent(uint8_t* buffer, uint32_t offset, uint32_t length);
+            void addEvent(ByteBuffer & buffer);
+            void addEvent(EvioNode & node);
+
+            void flush();
+        };
+
+
     private:
 
         /**
@@ -131,6 +193,14 @@ namespace evio {
                 thd = boost::thread([this]() {this->run();});
             }
 
+            /**
+             * Restrict this thread, once started, to run only on the given CPUs (Linux only).
+             * @param cpus ids of CPUs this thread may run on.
+             */
+            void setAffinity(const std::vector<uint32_t> & cpus) {
+                Util::setThreadAffinity(thd.native_handle(), cpus);
+            }
+
             /** Stop the thread. */
             void stopThread() {
                 // Send signal to interrupt it
@@ -158,42 +228,44 @@ namespace evio {
                 try {
                     while (true) {
 
-                        std::cout << "   RecordWriter: try getting record to write" << std::endl;
-                        // Get the next record for this thread to write
-                        auto item = supply->getToWrite();
+                        //std::cout << "   RecordWriter: try getting record to write" << std::endl;
+                        // Get all records ready for this thread to write, waiting for the first
+                        int64_t first;
+                        uint32_t count = supply->getToWrite(supply->getRingSize(), first);
 
                         {
                             // Only allow interruption when blocked on trying to get item
                             boost::this_thread::disable_interruption d1;
 
-                            currentSeq = item->getSequence();
-                            // Pull record out of wrapping object
-                            std::shared_ptr<RecordOutput> & record = item->getRecord();
-
-                            // Do write
-                            auto & header = record->getHeader();
-                            int bytesToWrite = header->getLength();
-                            // Record length of this record
-                            writer->recordLengths->push_back(bytesToWrite);
-                            // Followed by events in record
-                            writer->recordLengths->push_back(header->getEntries());
-                            writer->writerBytesWritten += bytesToWrite;
-
-                            auto buf = record->getBinaryBuffer();
-                            std::cout << "   RecordWriter: use outFile to write file, buf pos = " << buf->position() <<
-                                 ", lim = " << buf->limit() << ", bytesToWrite = " << bytesToWrite << std::endl;
-                            writer->outFile.write(reinterpret_cast<const char *>(buf->array()), bytesToWrite);
-                            if (writer->outFile.fail()) {
-                                throw EvioException("failed write to file");
+                            for (currentSeq = first; currentSeq < first + count; currentSeq++) {
+                                // Pull record out of wrapping object
+                                std::shared_ptr<RecordOutput> & record = supply->getItem(currentSeq)->getRecord();
+
+                                // Do write
+                                auto & header = record->getHeader();
+                                int bytesToWrite = header->getLength();
+                                // Record length of this record
+                                writer->recordLengths->push_back(bytesToWrite);
+                                // Followed by events in record
+                                writer->recordLengths->push_back(header->getEntries());
+                                writer->writerBytesWritten += bytesToWrite;
+
+                                auto buf = record->getBinaryBuffer();
+                                //std::cout << "   RecordWriter: use outFile to write file, buf pos = " << buf->position() <<
+                                //     ", lim = " << buf->limit() << ", bytesToWrite = " << bytesToWrite << std::endl;
+                                writer->outFile.write(reinterpret_cast<const char *>(buf->array()), bytesToWrite);
+                                if (writer->outFile.fail()) {
+                                    throw EvioException("failed write to file");
+                                }
+
+                                record->reset();
                             }
 
-                            record->reset();
+                            // Release all back to supply
+                            supply->releaseWriter(first, count);
 
-                            // Release back to supply
-                            supply->releaseWriter(item);
-
-                            // Now we're done with this sequence
-                            lastSeqProcessed = currentSeq;
+                            // Now we're done with these sequences
+                            lastSeqProcessed = first + count - 1;
                         }
                     }
                 }
@@ -256,6 +328,16 @@ namespace evio {
         /** Fast, thread-safe, lock-free supply of records. */
         std::shared_ptr<RecordSupply> supply;
 
+        /** Sizes of events added and fill of records built, counted by all records. */
+        RecordFillStats fillStats;
+
+        /** Goals of auto-tuning. */
+        AutoTuneConfig autoTuneConfig;
+        /** Is auto-tuning to run while the file is open? */
+        bool autoTune = false;
+        /** Thread adjusting compression threads and record size while open, null if none. */
+        std::unique_ptr<WriterAutoTuner> autoTuner;
+
         /** Vector to hold thread used to write data to file/buffer.
          *  Easier to use vector here so we don't have to construct it immediately. */
         std::vector<RecordWriter> recordWriterThreads;
@@ -263,9 +345,32 @@ namespace evio {
         /** Threads used to compress data. */
         std::vector<RecordCompressor> recordCompressorThreads;
 
+        /** Are records compressed by the process-wide {@link CompressionExecutor}
+         *  instead of recordCompressorThreads? */
+        bool sharedCompression = false;
+
         /** Current ring Item from which current record is taken. */
         std::shared_ptr<RecordRingItem> ringItem;
 
+        /** How events from multiple threads are ordered. */
+        ProducerOrder producerOrder = SINGLE_PRODUCER;
+
+        /** Mutex serializing producer threads when not in {@link #SINGLE_PRODUCER} mode. */
+        std::mutex producerMutex;
+
+        /** All producers created, used to flush them on close. */
+        std::vector<std::shared_ptr<Producer>> producers;
+
+        /** Producer used by this object's own addEvent methods in {@link #PER_PRODUCER_ORDER} mode. */
+        std::shared_ptr<Producer> defaultProducer;
+
+        /** CPUs to pin each compression thread to, indexed by thread number modulo size. */
+        std::vector<std::vector<uint32_t>> compressorCpus;
+        /** CPUs to pin writing thread to. */
+        std::vector<uint32_t> writerCpus;
+        /** Spread the records' memory over the NUMA nodes of the compression threads? */
+        bool numaLocalRecords = false;
+
 
         /** Do we add a last header or trailer to file/buffer? */
         bool addingTrailer = true;
@@ -303,14 +408,17 @@ namespace evio {
                 Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED,
                 uint32_t compressionThreads = 1,
                 bool addTrailerIndex = false,
-                uint32_t ringSize = 16);
+                uint32_t ringSize = 16,
+                ProducerOrder producerOrder = SINGLE_PRODUCER,
+                RecordSupply::WaitStrategyType waitStrategy = RecordSupply::SPIN_THEN_BLOCK,
+                uint32_t waitTimeout = 0);
 
         explicit WriterMT(const std::string & filename);
 
         WriterMT(const std::string & filename, const ByteOrder & order, uint32_t maxEventCount, uint32_t maxBufferSize,
                  Compressor::CompressionType compressionType, uint32_t compressionThreads);
 
-        ~WriterMT() = default;
+        ~WriterMT();
 
 //////////////////////////////////////////////////////////////////////
 
@@ -318,6 +426,7 @@ namespace evio {
 
         std::shared_ptr<ByteBuffer> createDictionaryRecord();
         void writeTrailer(bool writeIndex, uint32_t recordNum);
+        void applyThreadAffinity(bool placeRecords);
 
     public:
 
@@ -327,6 +436,27 @@ namespace evio {
 //    RecordHeader & getRecordHeader();
 //    RecordOutput & getRecord();
         Compressor::CompressionType getCompressionType();
+        void setAdaptiveCompression(float maxRatio, uint32_t fillLevel = 0);
+        void setTagFilter(bool filter);
+        void setChecksum(bool sum);
+        void setTimestampExtractor(RecordOutput::TimestampExtractor extractor);
+        void setRecordProcessor(RecordOutput::RecordProcessor processor);
+        void setSeekableCompression(uint32_t blockSize = SeekableCompression::DEFAULT_BLOCK_SIZE);
+        void setPreFilter(Compressor::PreFilter filter);
+        void setColumnLayout(bool byColumn);
+        ProducerOrder getProducerOrder() const;
+
+        void setThreadAffinity(const std::vector<std::vector<uint32_t>> & compressorCpus,
+                               const std::vector<uint32_t> & writerCpus,
+                               bool numaLocalRecords = false);
+
+        void setAutoTune(bool tune, const AutoTuneConfig & config = AutoTuneConfig());
+        bool getAutoTune() const;
+
+        uint64_t getProducerWaitTime() const;
+        uint64_t getCompressWaitTime() const;
+        uint64_t getWriteWaitTime() const;
+        WriterMetrics getMetrics() const;
 
         bool addTrailer() const;
         void addTrailer(bool add);
@@ -348,6 +478,8 @@ namespace evio {
 //    void addEvent(EvioBank & bank);
         void addEvent(EvioNode & node);
 
+        std::shared_ptr<Producer> createProducer();
+
         void reset();
         void close();
 
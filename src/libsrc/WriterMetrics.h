@@ -0,0 +1,157 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+#ifndef EVIO_6_0_WRITERMETRICS_H
+#define EVIO_6_0_WRITERMETRICS_H
+
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <vector>
+
+
+namespace evio {
+
+
+    /**
+     * This class is a snapshot of the state of a writer's pipeline of
+     * filling, compressing and writing records. It's obtained by polling a writer
+     * or is handed to a callback registered with it. The ring and compression
+     * values are only filled in when compressing with multiple threads.
+     * All times are in microseconds.
+     */
+    class WriterMetrics {
+
+    public:
+
+        /** Number of bins of the event size histogram, bin i counting events of 2^i to 2^(i+1) - 1 bytes. */
+        static const uint32_t EVENT_SIZE_BINS = 32;
+        /** Number of bins of the record fill histogram, each a tenth of a record's capacity. */
+        static const uint32_t RECORD_FILL_BINS = 10;
+
+        /** Statistics of a single compression thread. */
+        struct CompressorStats {
+            /** Time spent compressing. */
+            uint64_t busyTime = 0;
+            /** Uncompressed bytes taken in. */
+            uint64_t bytesIn = 0;
+            /** Compressed bytes put out, including record headers. */
+            uint64_t bytesOut = 0;
+            /** Records compressed. */
+            uint64_t records = 0;
+        };
+
+        /** Number of records in the ring. */
+        uint32_t ringSize = 0;
+        /** Number of records filled but not yet written. */
+        uint32_t ringOccupancy = 0;
+        /** Number of records waiting to be compressed. */
+        uint32_t waitingToCompress = 0;
+        /** Number of compressed records waiting to be written. */
+        uint32_t waitingToWrite = 0;
+
+        /** Statistics of each compression thread. */
+        std::vector<CompressorStats> compressors;
+        /** Ratio of compressed to uncompressed bytes of all compressed records, 0 if none. */
+        double compressionRatio = 0.;
+        /** Number of compression threads not parked. */
+        uint32_t activeCompressors = 0;
+        /** Target size of records being filled in bytes, 0 if they fill their memory. */
+        uint32_t targetRecordBytes = 0;
+
+        /** Number of records written. */
+        uint64_t recordsWritten = 0;
+        /** Time taken to write the most recent record. */
+        uint64_t lastWriteLatency = 0;
+        /** Longest time taken to write a record. */
+        uint64_t maxWriteLatency = 0;
+        /** Average time taken to write a record. */
+        uint64_t avgWriteLatency = 0;
+
+        /** Time producers spent blocked waiting for an empty record. */
+        uint64_t producerWaitTime = 0;
+        /** Time compression threads spent idle, summed over all threads. */
+        uint64_t compressWaitTime = 0;
+        /** Time the writing thread spent idle. */
+        uint64_t writeWaitTime = 0;
+
+        /** Number of events added to records. */
+        uint64_t eventsAdded = 0;
+        /** Bytes of all events added to records. */
+        uint64_t eventBytes = 0;
+        /** Size of largest event in bytes. */
+        uint64_t maxEventBytes = 0;
+        /** Number of events in each size bin, see {@link #EVENT_SIZE_BINS}. */
+        std::vector<uint64_t> eventSizeHistogram;
+
+        /** Number of records built holding at least one event. */
+        uint64_t recordsBuilt = 0;
+        /** Average fraction of a record's capacity filled by events and index when built. */
+        double avgRecordFill = 0.;
+        /** Average number of events in a record built. */
+        double avgEventsPerRecord = 0.;
+        /** Number of records built in each fill bin, see {@link #RECORD_FILL_BINS}. */
+        std::vector<uint64_t> recordFillHistogram;
+
+        /** Times an event had to start a new record because the last reached its max event count. */
+        uint64_t recordsFullByCount = 0;
+        /** Times an event had to start a new record because it did not fit in the last one's memory. */
+        uint64_t recordsFullBySize = 0;
+        /** Events too large for an empty record, whose memory had to be expanded. */
+        uint64_t oversizedEvents = 0;
+
+        /** Number of files created so far by splitting. */
+        uint32_t splitCount = 0;
+        /** Has writing been held up because the disk is full? */
+        bool diskFull = false;
+
+
+        /**
+         * Obtain a string representation of these metrics.
+         * @return string representation of these metrics.
+         */
+        std::string toString() const {
+            std::stringstream ss;
+            ss << "ring: size = " << ringSize << ", occupied = " << ringOccupancy <<
+                  ", to compress = " << waitingToCompress << ", to write = " << waitingToWrite << std::endl;
+            for (size_t i=0; i < compressors.size(); i++) {
+                ss << "compressor " << i << ": busy = " << compressors[i].busyTime <<
+                      " us, records = " << compressors[i].records << ", in = " << compressors[i].bytesIn <<
+                      ", out = " << compressors[i].bytesOut << std::endl;
+            }
+            ss << "compression ratio = " << compressionRatio << ", active compressors = " << activeCompressors <<
+                  ", target record bytes = " << targetRecordBytes << std::endl;
+            ss << "records written = " << recordsWritten << ", write latency (us): last = " << lastWriteLatency <<
+                  ", max = " << maxWriteLatency << ", avg = " << avgWriteLatency << std::endl;
+            ss << "wait (us): producer = " << producerWaitTime << ", compress = " << compressWaitTime <<
+                  ", write = " << writeWaitTime << std::endl;
+            ss << "events = " << eventsAdded << ", bytes = " << eventBytes <<
+                  ", max event = " << maxEventBytes << std::endl;
+            ss << "event sizes (bytes >= 2^i):";
+            for (size_t i=0; i < eventSizeHistogram.size(); i++) {
+                if (eventSizeHistogram[i] > 0) ss << " " << i << ":" << eventSizeHistogram[i];
+            }
+            ss << std::endl;
+            ss << "records built = " << recordsBuilt << ", avg fill = " << avgRecordFill <<
+                  ", avg events = " << avgEventsPerRecord << ", fill (10% bins):";
+            for (auto n : recordFillHistogram) ss << " " << n;
+            ss << std::endl;
+            ss << "new record forced: by count = " << recordsFullByCount << ", by size = " << recordsFullBySize <<
+                  ", oversized events = " << oversizedEvents << std::endl;
+            ss << "splits = " << splitCount << ", disk full = " << diskFull;
+            return ss.str();
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_WRITERMETRICS_H
@@ -16,25 +16,48 @@
 #include "BaseStructure.h"
 #include "BaseStructureHeader.h"
 #include "ByteBuffer.h"
+#include "ByteBufferAllocator.h"
+#include "ByteBufferPool.h"
+#include "ByteBufferView.h"
+#include "StringArrayView.h"
 #include "ByteOrder.h"
 
+#include "ColumnarExporter.h"
 #include "CompactEventBuilder.h"
 #include "CompositeData.h"
+#include "CompositeFormat.h"
+#include "CompositeCursor.h"
+#include "CompositeBatchDecoder.h"
 #include "Compressor.h"
+#include "CompressionDictionary.h"
+#include "Crc32c.h"
 #include "DataType.h"
 
 #include "EventBuilder.h"
+#include "EventDumper.h"
 #include "EventHeaderParser.h"
+#include "EventIndexFile.h"
+#include "EventQuery.h"
+#include "BankAggregator.h"
+#include "StructureIndex.h"
+#include "StructureQueryIndex.h"
 #include "EventParser.h"
+#include "RawEventVisitor.h"
 #include "EventWriter.h"
+#include "GatheredEvent.h"
 
 #include "EvioBank.h"
+#include "EvioCBridge.h"
 #include "EvioCompactReader.h"
 #include "EvioDictionaryEntry.h"
 #include "EvioXMLDictionary.h"
+#include "EvioBinaryDictionary.h"
+#include "EvioSchema.h"
 #include "EvioEvent.h"
 #include "EvioException.h"
 #include "EvioNode.h"
+#include "EvioNodeSource.h"
+#include "EvioNodePool.h"
 #include "EvioReader.h"
 #include "EvioSegment.h"
 #include "EvioSwap.h"
@@ -42,12 +65,50 @@
 
 #include "FileEventIndex.h"
 #include "FileHeader.h"
+#include "FileWriteBackend.h"
 #include "HeaderType.h"
 
 #include "Reader.h"
 #include "RecordCompressor.h"
+#include "RecordDecompressor.h"
+#include "ParallelEventReader.h"
+#include "RunReader.h"
+#include "StreamMerger.h"
+#include "StripeManifest.h"
+#include "StripedEventWriter.h"
+#include "StripedReader.h"
+#include "SocketWriter.h"
+#include "SocketReader.h"
+#include "RdmaWriter.h"
+#include "RdmaReader.h"
+#include "UdpPacketizer.h"
+#include "UdpReassembler.h"
+#include "SharedMemoryRing.h"
+#include "SharedMemoryWriter.h"
+#include "MirrorWriter.h"
+#include "SharedMemoryReader.h"
+#include "Profiler.h"
+#include "EvioConverter.h"
+#include "StructureEdits.h"
+#include "HipoSchema.h"
+#include "HipoEvent.h"
+#include "HipoReader.h"
+#include "RecordFillStats.h"
+#include "WriterAutoTuner.h"
+#include "AsyncReader.h"
+#include "RecordCache.h"
+#include "SeekableCompression.h"
+#include "ColumnLayout.h"
+#include "ConcurrentReader.h"
+#include "CompactEventIndex.h"
+#include "CompressionExecutor.h"
+#include "FileSyncer.h"
+#include "ByteSource.h"
+#include "FileByteSource.h"
+#include "SourceReader.h"
 #include "RecordHeader.h"
 #include "RecordInput.h"
+#include "RecordInputSupply.h"
 #include "RecordNode.h"
 #include "RecordOutput.h"
 
@@ -0,0 +1,394 @@
+#
+# Copyright 2020, Jefferson Science Associates, LLC.
+# Subject to the terms in the LICENSE file found in the top-level directory.
+#
+# EPSCI Group
+# Thomas Jefferson National Accelerator Facility
+# 12000, Jefferson Ave, Newport News, VA 23606
+# (757)-269-7100
+
+"""
+Python access to evio files through the C interface of the evio C++ library
+(see EvioCBridge.h), so files are read, decompressed and parsed at C++ speed.
+
+Events and structure data are NumPy arrays pointing straight into the library's
+record or file buffers, with the NumPy type of their evio data type and the
+file's byte order. Nothing is copied. An array is only valid until the object
+that gave it reads something else (or is closed): call copy() on it to keep it.
+
+    import evio
+
+    with evio.CompactReader("run.evio") as reader:
+        for i in range(len(reader)):
+            for bank in reader.banks(i, tag=5):
+                energies = bank.data          # e.g. float32 array
+
+    def analyze(record):                      # called with records read in parallel
+        for event in record:
+            ...
+    evio.for_each_record(["run.evio"], analyze, threads=8)
+
+    columns = evio.export_columns(["run.evio"], [(1, 0, "FLOAT32", "energy")])
+    offsets, values = columns["energy"]
+
+The library is found by ctypes.util.find_library("eviocc"), unless the
+EVIO_LIBRARY environmental variable gives its path.
+"""
+
+import os
+import sys
+import ctypes
+import ctypes.util
+
+import numpy as np
+
+
+__all__ = ["EvioError", "Reader", "CompactReader", "Node", "Record",
+           "for_each_record", "export_columns"]
+
+
+_OK = 0
+_END = -2
+
+# Evio data type of each name
+TYPES = {"UNKNOWN32": 0x0, "UINT32": 0x1, "FLOAT32": 0x2, "CHARSTAR8": 0x3,
+         "SHORT16": 0x4, "USHORT16": 0x5, "CHAR8": 0x6, "UCHAR8": 0x7,
+         "DOUBLE64": 0x8, "LONG64": 0x9, "ULONG64": 0xa, "INT32": 0xb,
+         "TAGSEGMENT": 0xc, "ALSOSEGMENT": 0xd, "ALSOBANK": 0xe, "COMPOSITE": 0xf,
+         "BANK": 0x10, "SEGMENT": 0x20}
+
+# NumPy type of each evio data type holding numbers, anything else is bytes
+_DTYPES = {0x1: "u4", 0x2: "f4", 0x3: "u1", 0x4: "i2", 0x5: "u2", 0x6: "i1",
+           0x7: "u1", 0x8: "f8", 0x9: "i8", 0xa: "u8", 0xb: "i4"}
+
+_LOCAL = "<" if sys.byteorder == "little" else ">"
+_OTHER = ">" if _LOCAL == "<" else "<"
+
+
+class EvioError(Exception):
+    """Error reported by the evio library."""
+
+
+class _CNode(ctypes.Structure):
+    """Mirror of evioCNode."""
+    _fields_ = [("data", ctypes.c_void_p),
+                ("bytes", ctypes.c_uint32),
+                ("dataType", ctypes.c_uint32),
+                ("tag", ctypes.c_uint16),
+                ("num", ctypes.c_uint8),
+                ("parent", ctypes.c_int32)]
+
+
+_RECORD_HANDLER = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32,
+                                   ctypes.c_uint64, ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32),
+                                   ctypes.c_uint32, ctypes.c_int)
+
+
+def _load():
+    path = os.environ.get("EVIO_LIBRARY") or ctypes.util.find_library("eviocc") or "libeviocc.so"
+    lib = ctypes.CDLL(path)
+
+    vp, u32, u64, i32 = ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint64, ctypes.c_int
+    pp = ctypes.POINTER(ctypes.c_void_p)
+    pu32, pu64 = ctypes.POINTER(u32), ctypes.POINTER(u64)
+    names = ctypes.POINTER(ctypes.c_char_p)
+
+    signatures = {
+        "evioCGetError":                   (ctypes.c_char_p, []),
+        "evioCReaderOpen":                 (i32, [ctypes.c_char_p, pp]),
+        "evioCReaderGetEvent":             (i32, [vp, u32, pp, pu32]),
+        "evioCReaderIsSwapped":            (i32, [vp]),
+        "evioCReaderGetEventCount":        (u32, [vp]),
+        "evioCReaderGetRecordCount":       (u32, [vp]),
+        "evioCReaderClose":                (i32, [vp]),
+        "evioCCompactReaderOpen":          (i32, [ctypes.c_char_p, pp]),
+        "evioCCompactReaderGetEventCount": (u32, [vp]),
+        "evioCCompactReaderIsSwapped":     (i32, [vp]),
+        "evioCCompactReaderGetNodes":      (i32, [vp, u32, ctypes.POINTER(ctypes.POINTER(_CNode)), pu32]),
+        "evioCCompactReaderClose":         (i32, [vp]),
+        "evioCForEachRecord":              (i32, [names, u32, u32, _RECORD_HANDLER, vp]),
+        "evioCExportColumns":              (i32, [names, u32, ctypes.POINTER(ctypes.c_uint16),
+                                                  ctypes.POINTER(ctypes.c_uint8), pu32, u32, u32, pp]),
+        "evioCColumnsGetCount":            (u32, [vp]),
+        "evioCColumnsGet":                 (i32, [vp, u32, pp, pu64, pu32,
+                                                  ctypes.POINTER(ctypes.POINTER(ctypes.c_int64)), pu64]),
+        "evioCColumnsFree":                (None, [vp]),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        func = getattr(lib, name)
+        func.restype = restype
+        func.argtypes = argtypes
+    return lib
+
+
+_lib = _load()
+
+
+def _check(status):
+    if status < 0 and status != _END:
+        raise EvioError(_lib.evioCGetError().decode(errors="replace"))
+    return status
+
+
+def _names(files):
+    if isinstance(files, (str, bytes, os.PathLike)):
+        files = [files]
+    encoded = [os.fsencode(f) for f in files]
+    return (ctypes.c_char_p * len(encoded))(*encoded), len(encoded)
+
+
+class _Memory:
+    """Memory of the library seen by NumPy through the array interface, keeping its owner alive."""
+
+    def __init__(self, address, count, typestr, owner):
+        self.__array_interface__ = {"shape": (count,), "typestr": typestr,
+                                    "data": (address, True), "version": 3}
+        self.owner = owner
+
+
+def _array(address, nbytes, data_type, swapped, owner):
+    """Read-only array over nbytes of library memory, typed by evio data type, without copying."""
+    dtype = _DTYPES.get(data_type, "u1")
+    size = int(dtype[1])
+    typestr = ("|" if size == 1 else (_OTHER if swapped else _LOCAL)) + dtype
+    count = nbytes // size
+    if count == 0 or not address:
+        return np.empty(0, dtype=np.dtype(typestr))
+    return np.asarray(_Memory(address, count, typestr, owner))
+
+
+def _type_code(data_type):
+    if isinstance(data_type, str):
+        return TYPES[data_type.upper()]
+    return int(data_type)
+
+
+class Reader:
+    """Reads the events of an evio version 6 file with the C++ Reader."""
+
+    def __init__(self, file_name):
+        self.file_name = os.fspath(file_name)
+        self._handle = ctypes.c_void_p()
+        _check(_lib.evioCReaderOpen(os.fsencode(self.file_name), ctypes.byref(self._handle)))
+        self.swapped = bool(_lib.evioCReaderIsSwapped(self._handle))
+
+    def __len__(self):
+        return _lib.evioCReaderGetEventCount(self._handle)
+
+    @property
+    def record_count(self):
+        """Number of records in the file."""
+        return _lib.evioCReaderGetRecordCount(self._handle)
+
+    def event(self, index):
+        """Event as an array of 32 bit words in the file's byte order, or None if no such event.
+        Valid until the next event is gotten."""
+        if self._handle is None:
+            raise EvioError("reader is closed")
+        address = ctypes.c_void_p()
+        nbytes = ctypes.c_uint32()
+        if _check(_lib.evioCReaderGetEvent(self._handle, index, ctypes.byref(address),
+                                           ctypes.byref(nbytes))) == _END:
+            return None
+        return _array(address.value, nbytes.value, TYPES["UINT32"], self.swapped, self)
+
+    def __getitem__(self, index):
+        if index < 0:
+            index += len(self)
+        event = self.event(index)
+        if event is None:
+            raise IndexError("event index out of range")
+        return event
+
+    def __iter__(self):
+        for i in range(len(self)):
+            yield self.event(i)
+
+    def for_each_record(self, handler, threads=4):
+        """Hand each record of the file, read in parallel, to handler (see for_each_record)."""
+        return for_each_record([self.file_name], handler, threads)
+
+    def close(self):
+        if self._handle is not None:
+            handle, self._handle = self._handle, None
+            _check(_lib.evioCReaderClose(handle))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
+
+
+class Node:
+    """One structure (bank, segment or tagsegment) of an event."""
+
+    __slots__ = ("tag", "num", "data_type", "parent", "data")
+
+    def __init__(self, tag, num, data_type, parent, data):
+        self.tag = tag
+        self.num = num
+        self.data_type = data_type
+        self.parent = parent
+        self.data = data
+
+    def is_container(self):
+        """Does this structure hold other structures?"""
+        return self.data_type in (0xc, 0xd, 0xe, 0x10, 0x20)
+
+    def __repr__(self):
+        return "Node(tag=%d, num=%d, type=0x%x, parent=%d, len=%d)" % (
+            self.tag, self.num, self.data_type, self.parent, len(self.data))
+
+
+class CompactReader:
+    """Reads the structures of the events of an evio version 6 file in place, as C++ EvioNodes."""
+
+    def __init__(self, file_name):
+        self.file_name = os.fspath(file_name)
+        self._handle = ctypes.c_void_p()
+        _check(_lib.evioCCompactReaderOpen(os.fsencode(self.file_name), ctypes.byref(self._handle)))
+        self.swapped = bool(_lib.evioCCompactReaderIsSwapped(self._handle))
+
+    def __len__(self):
+        return _lib.evioCCompactReaderGetEventCount(self._handle)
+
+    def nodes(self, index):
+        """All structures of an event, the event first, each before those it holds.
+        Each one's data is an array of its data type. Valid until the next event is gotten."""
+        if self._handle is None:
+            raise EvioError("reader is closed")
+        array = ctypes.POINTER(_CNode)()
+        count = ctypes.c_uint32()
+        if _check(_lib.evioCCompactReaderGetNodes(self._handle, index, ctypes.byref(array),
+                                                  ctypes.byref(count))) == _END:
+            raise IndexError("event index out of range")
+        nodes = []
+        for i in range(count.value):
+            n = array[i]
+            nodes.append(Node(n.tag, n.num, n.dataType, n.parent,
+                              _array(n.data, n.bytes, n.dataType, self.swapped, self)))
+        return nodes
+
+    def banks(self, index, tag, num=None):
+        """Structures of an event with the given tag and, if given, num."""
+        return [n for n in self.nodes(index) if n.tag == tag and (num is None or n.num == num)]
+
+    def close(self):
+        if self._handle is not None:
+            handle, self._handle = self._handle, None
+            _check(_lib.evioCCompactReaderClose(handle))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
+
+
+class Record:
+    """The events of one record, handed to the handler of for_each_record.
+    Valid only during the call."""
+
+    def __init__(self, file_index, record_index, first_event, address, lengths, swapped):
+        self.file_index = file_index
+        self.record_index = record_index
+        self.first_event = first_event
+        self.swapped = swapped
+        self.lengths = lengths
+        self.offsets = np.zeros(len(lengths) + 1, dtype=np.int64)
+        np.cumsum(lengths, out=self.offsets[1:])
+        self.bytes = _array(address, int(self.offsets[-1]), TYPES["UCHAR8"], swapped, self)
+        self._word = np.dtype((_OTHER if swapped else _LOCAL) + "u4")
+
+    def __len__(self):
+        return len(self.lengths)
+
+    def event(self, index):
+        """Event as an array of 32 bit words in the file's byte order."""
+        start, end = self.offsets[index], self.offsets[index + 1]
+        return self.bytes[start:end].view(self._word)
+
+    def __iter__(self):
+        for i in range(len(self)):
+            yield self.event(i)
+
+
+def for_each_record(files, handler, threads=4):
+    """Read and decompress the records of evio version 6 files in several C++ threads,
+    calling handler(record) with each Record. Records arrive in no set order, and the
+    handler runs holding the GIL, so keep it short or hand work to NumPy.
+    An exception raised by the handler stops all reading and is raised again here."""
+    names, count = _names(files)
+    errors = []
+
+    def call(arg, file_index, record_index, first_event, events, lengths, event_count, swapped):
+        try:
+            lens = np.ctypeslib.as_array(lengths, shape=(event_count,)) if event_count else \
+                np.empty(0, dtype=np.uint32)
+            handler(Record(file_index, record_index, first_event, events, lens, bool(swapped)))
+            return 0
+        except BaseException as e:
+            errors.append(e)
+            return 1
+
+    callback = _RECORD_HANDLER(call)
+    status = _check(_lib.evioCForEachRecord(names, count, threads, callback, None))
+    if errors:
+        raise errors[0]
+    return status == _OK
+
+
+class _Columns:
+    """Columns exported by the library, freed once no array uses them."""
+
+    def __init__(self, handle):
+        self.handle = handle
+
+    def __del__(self):
+        _lib.evioCColumnsFree(self.handle)
+
+
+def export_columns(files, selectors, threads=4):
+    """Copy the data of selected banks of all events of evio version 6 files into columns,
+    using the C++ ColumnarExporter in several threads. Each selector is (tag, num, type, name),
+    type being an evio data type or its name. Returns a dict of name to (offsets, values):
+    a row's (event's) values are values[offsets[row]:offsets[row+1]], local endian.
+    The arrays share the library's memory."""
+    names, count = _names(files)
+    n = len(selectors)
+    tags = (ctypes.c_uint16 * n)(*[s[0] for s in selectors])
+    nums = (ctypes.c_uint8 * n)(*[s[1] for s in selectors])
+    types = (ctypes.c_uint32 * n)(*[_type_code(s[2]) for s in selectors])
+
+    handle = ctypes.c_void_p()
+    _check(_lib.evioCExportColumns(names, count, tags, nums, types, n, threads, ctypes.byref(handle)))
+    owner = _Columns(handle)
+
+    columns = {}
+    for i, selector in enumerate(selectors):
+        values = ctypes.c_void_p()
+        value_count = ctypes.c_uint64()
+        value_bytes = ctypes.c_uint32()
+        offsets = ctypes.POINTER(ctypes.c_int64)()
+        rows = ctypes.c_uint64()
+        _check(_lib.evioCColumnsGet(handle, i, ctypes.byref(values), ctypes.byref(value_count),
+                                    ctypes.byref(value_bytes), ctypes.byref(offsets), ctypes.byref(rows)))
+        offset_array = np.asarray(_Memory(ctypes.cast(offsets, ctypes.c_void_p).value,
+                                          rows.value + 1, _LOCAL + "i8", owner))
+        value_array = _array(values.value, value_count.value * value_bytes.value,
+                             _type_code(selector[2]), False, owner)
+        columns[selector[3] if len(selector) > 3 else str(i)] = (offset_array, value_array)
+    return columns
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "eviocc.h"
+#include "TestEvents.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of events written. */
+    static const uint32_t EVENTS = 100;
+
+
+    /**
+     * Read all events of an uncompressed file, memory mapped, so they are read in place,
+     * half with a session of its own and half with one from the pool. Keep the events
+     * once the sessions and the reader are gone and the file is removed. They must still
+     * hold what was written since they keep the file mapped.
+     *
+     * @return 0 if successful, else 1.
+     */
+    static int eventLifetimeTest() {
+
+        std::string fileName = "./concurrentReaderTest.evio";
+        // Several records, so events are read from more than one
+        TestEvents::writeFile(fileName, EVENTS, 10);
+
+        std::vector<std::shared_ptr<uint8_t>> events;
+        std::vector<uint32_t> lengths;
+        {
+            auto reader = std::make_shared<ConcurrentReader>(fileName, true);
+            if (!reader->isMemoryMapped() || reader->getEventCount() != EVENTS) {
+                cout << "FAILED: file not mapped or wrong number of events" << endl;
+                remove(fileName.c_str());
+                return 1;
+            }
+
+            ConcurrentReader::Session session;
+            for (uint32_t ev=0; ev < EVENTS; ev++) {
+                uint32_t len;
+                auto event = (ev % 2) ? reader->getEvent(session, ev, &len) : reader->getEvent(ev, &len);
+                events.push_back(event);
+                lengths.push_back(len);
+            }
+        }
+
+        // Nothing but the events refers to the mapping now
+        remove(fileName.c_str());
+
+        uint32_t differ = 0;
+        for (uint32_t ev=0; ev < EVENTS; ev++) {
+            auto expected = TestEvents::makeEvent(ev);
+            if (lengths[ev] != expected->limit() ||
+                std::memcmp(events[ev].get(), expected->array(), lengths[ev]) != 0) {
+                if (differ++ < 5) cout << "   event " << ev << " differs from the one written" << endl;
+            }
+        }
+
+        if (differ > 0) {
+            cout << "FAILED: " << differ << " events read in place changed once their reader was gone" << endl;
+            return 1;
+        }
+
+        cout << "Events read in place outlive their reader" << endl;
+        return 0;
+    }
+
+}
+
+
+
+int main() {
+    return evio::eventLifetimeTest();
+}
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <memory>
+
+#include "eviocc.h"
+#include "TestEvents.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of events written. */
+    static const uint32_t EVENTS = 1000;
+
+    /** Number of events in each record. */
+    static const uint32_t EVENTS_PER_RECORD = 10;
+
+    /** Number of checks which failed. */
+    static uint32_t failures = 0;
+
+
+    /** Count a failed check, describing the first few. */
+    static void check(bool ok, std::string const & what, uint32_t threads, uint32_t ev) {
+        if (ok) return;
+        if (failures++ < 10) {
+            cout << "   " << threads << " threads, event " << ev << ": " << what << endl;
+        }
+    }
+
+
+    /**
+     * Read all events of a compressed file in order, with records decompressed
+     * by the given number of threads, and check each against the one written.
+     * @param fileName name of file.
+     * @param threads  number of decompression threads.
+     */
+    static void sequentialTest(std::string const & fileName, uint32_t threads) {
+        Reader reader(fileName);
+        reader.setDecompressionThreads(threads);
+        check(reader.isCompressed(), "file not compressed", threads, 0);
+        check(reader.getDecompressionThreads() == threads, "thread count not set", threads, 0);
+
+        uint32_t len, count = 0;
+        std::shared_ptr<uint8_t> event;
+        while ((event = reader.getNextEvent(&len)) != nullptr) {
+            check(TestEvents::matches(event, len, count), "differs from the one written", threads, count);
+            count++;
+        }
+        check(count == EVENTS, "wrong number of events read", threads, count);
+    }
+
+
+    /**
+     * Read events of a compressed file by index, with records decompressed by the given
+     * number of threads. Jump forward past the records being decompressed ahead, so
+     * they're started again from there, then back to records already handed out,
+     * which are read in this thread, then forward again. Check each event read.
+     * @param fileName name of file.
+     * @param threads  number of decompression threads.
+     */
+    static void jumpTest(std::string const & fileName, uint32_t threads) {
+        Reader reader(fileName);
+        reader.setDecompressionThreads(threads);
+
+        uint32_t len;
+        auto readRange = [&](uint32_t first, uint32_t last) {
+            for (uint32_t ev = first; ev < last; ev++) {
+                auto event = reader.getEvent(ev, &len);
+                check(TestEvents::matches(event, len, ev), "differs from the one written", threads, ev);
+            }
+        };
+
+        readRange(0, 3*EVENTS_PER_RECORD);
+        // Far past any records read ahead
+        readRange(EVENTS/2, EVENTS/2 + 3*EVENTS_PER_RECORD);
+        // Back to records already used
+        readRange(EVENTS_PER_RECORD + 5, 2*EVENTS_PER_RECORD);
+        readRange(5, EVENTS_PER_RECORD);
+        // Forward again, to the end
+        readRange(3*EVENTS/4, EVENTS);
+    }
+
+
+    /**
+     * Read an LZ4 compressed file with several numbers of decompression threads,
+     * both sequentially and jumping around, and check all events read.
+     * @return 0 if successful, else 1.
+     */
+    static int decompressionThreadsTest() {
+
+        std::string fileName = "./decompressionThreadsTest.evio";
+        TestEvents::writeFile(fileName, EVENTS, EVENTS_PER_RECORD, Compressor::LZ4);
+
+        uint32_t threadCounts[] = {1, 2, 3, 8};
+        for (uint32_t threads : threadCounts) {
+            sequentialTest(fileName, threads);
+            jumpTest(fileName, threads);
+        }
+
+        remove(fileName.c_str());
+
+        if (failures > 0) {
+            cout << "FAILED: " << failures << " events not read as written" << endl;
+            return 1;
+        }
+
+        cout << "Events decompressed by other threads are read as written" << endl;
+        return 0;
+    }
+
+}
+
+
+
+int main() {
+    return evio::decompressionThreadsTest();
+}
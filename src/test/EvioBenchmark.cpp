@@ -0,0 +1,822 @@
+//
+// Copyright 2020, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+//
+// EPSCI Group
+// Thomas Jefferson National Accelerator Facility
+// 12000, Jefferson Ave, Newport News, VA 23606
+// (757)-269-7100
+
+
+/**
+ * Benchmarks of evio's hot paths, run in the manner of Google Benchmark:
+ * each benchmark's iteration count is tuned until a run lasts at least a minimum time,
+ * then the run is repeated and the median and minimum time per iteration are reported.
+ * All data are generated from fixed seeds so numbers are comparable between releases.<p>
+ *
+ * Usage: EvioBenchmark [--filter=&lt;regex&gt;] [--min_time=&lt;sec&gt;] [--repetitions=&lt;n&gt;]
+ *                      [--dir=&lt;directory for files&gt;] [--csv] [--json] [--list]
+ *
+ * With --json the results are printed in the same JSON form as the C library's
+ * evBenchmark --json so that the C and C++ paths can be compared on the same hardware.
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <regex>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Keeps results from being optimized away. */
+    static volatile uint64_t benchmarkSink = 0;
+
+
+    /**
+     * State of one run of a benchmark. The code to be timed is placed in a
+     * <code>while (state.keepRunning())</code> loop. Timing starts with the first call
+     * to keepRunning so any setup before the loop is not counted.
+     */
+    class BenchmarkState {
+
+    private:
+
+        uint64_t maxIterations;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        chrono::steady_clock::time_point start, stop;
+
+    public:
+
+        explicit BenchmarkState(uint64_t iterations) : maxIterations(iterations) {}
+
+        /**
+         * Is another iteration to be run?
+         * @return true if another iteration is to be run.
+         */
+        bool keepRunning() {
+            if (count == 0) {
+                start = chrono::steady_clock::now();
+            }
+            if (count++ < maxIterations) {
+                return true;
+            }
+            stop = chrono::steady_clock::now();
+            return false;
+        }
+
+        /** @return number of iterations to run. */
+        uint64_t iterations() const {return maxIterations;}
+
+        /** @param b number of bytes processed in each iteration. */
+        void setBytesPerIteration(uint64_t b) {bytes = b;}
+
+        /** @return number of bytes processed in each iteration. */
+        uint64_t getBytesPerIteration() const {return bytes;}
+
+        /** @return time taken by all iterations in seconds. */
+        double seconds() const {return chrono::duration<double>(stop - start).count();}
+    };
+
+
+    /** Runs registered benchmarks and reports their results. */
+    class BenchmarkRunner {
+
+    private:
+
+        struct Benchmark {
+            string name;
+            function<void (BenchmarkState &)> func;
+        };
+
+        vector<Benchmark> benchmarks;
+
+        double minTime = 0.5;
+        uint32_t repetitions = 5;
+        bool csv = false;
+        bool json = false;
+        /** Has a result been printed as JSON? */
+        bool jsonStarted = false;
+
+    public:
+
+        void setMinTime(double t)          {minTime = t;}
+        void setRepetitions(uint32_t reps) {repetitions = reps < 1 ? 1 : reps;}
+        void setCsv(bool c)                {csv = c;}
+        void setJson(bool j)               {json = j;}
+        bool isJson() const                {return json;}
+
+        /**
+         * Register a benchmark.
+         * @param name name of benchmark.
+         * @param func function containing the timed loop.
+         */
+        void add(string const & name, function<void (BenchmarkState &)> func) {
+            benchmarks.push_back(Benchmark{name, std::move(func)});
+        }
+
+        /** Print the names of all registered benchmarks. */
+        void list() const {
+            for (auto const & b : benchmarks) {
+                cout << b.name << endl;
+            }
+        }
+
+
+        /**
+         * Run all benchmarks whose names match a regular expression.
+         * @param filter regular expression to match.
+         */
+        void run(string const & filter) {
+            regex re(filter);
+
+            if (json) {
+                cout << "{\n  \"context\": {\"program\": \"EvioBenchmark\", \"cpus\": " <<
+                        thread::hardware_concurrency() << ", \"big_endian\": " <<
+                        (ByteOrder::isLocalHostBigEndian() ? "true" : "false") <<
+                        ", \"byte_swapping\": \"" << ByteOrder::getSwapImplementation() <<
+                        "\"},\n  \"benchmarks\": [\n";
+                jsonStarted = false;
+            }
+            else if (csv) {
+                cout << "name,iterations,median_ns,min_ns,bytes_per_second" << endl;
+            }
+            else {
+                cout << left << setw(56) << "Benchmark" << right << setw(16) << "Time (median)" <<
+                        setw(16) << "Time (min)" << setw(14) << "Iterations" << setw(14) << "Throughput" << endl;
+                cout << string(116, '-') << endl;
+            }
+
+            for (auto & b : benchmarks) {
+                if (!regex_search(b.name, re)) continue;
+
+                try {
+                    runOne(b);
+                }
+                catch (EvioException & e) {
+                    if (json) {
+                        cout << (jsonStarted ? ",\n" : "") << "    {\"name\": \"" << b.name <<
+                                "\", \"error\": true}";
+                        jsonStarted = true;
+                    }
+                    else {
+                        cout << left << setw(56) << b.name << " ERROR: " << e.what() << endl;
+                    }
+                }
+            }
+
+            if (json) {
+                cout << "\n  ]\n}" << endl;
+            }
+        }
+
+    private:
+
+        /**
+         * Find the number of iterations needed for a run to last minTime,
+         * then do the runs and report.
+         * @param b benchmark to run.
+         */
+        void runOne(Benchmark & b) {
+            uint64_t iterations = 1;
+            double secs;
+
+            while (true) {
+                BenchmarkState state(iterations);
+                b.func(state);
+                secs = state.seconds();
+                if (secs >= minTime || iterations >= 1000000000ULL) break;
+
+                // Grow by the amount needed to reach minTime plus a margin, but at most 10x
+                double mult = (secs <= 0.) ? 10. : min(10., 1.4 * minTime / secs);
+                iterations = max(iterations + 1, (uint64_t)(iterations * mult));
+            }
+
+            vector<double> nsPerIter;
+            uint64_t bytes = 0;
+            for (uint32_t i = 0; i < repetitions; i++) {
+                BenchmarkState state(iterations);
+                b.func(state);
+                nsPerIter.push_back(1.e9 * state.seconds() / iterations);
+                bytes = state.getBytesPerIteration();
+            }
+
+            sort(nsPerIter.begin(), nsPerIter.end());
+            double median = nsPerIter[nsPerIter.size()/2];
+            if (nsPerIter.size() % 2 == 0) {
+                median = (median + nsPerIter[nsPerIter.size()/2 - 1]) / 2.;
+            }
+            double bytesPerSec = (bytes > 0 && median > 0.) ? 1.e9 * bytes / median : 0.;
+
+            if (json) {
+                cout << (jsonStarted ? ",\n" : "") << "    {\"name\": \"" << b.name <<
+                        "\", \"iterations\": " << iterations << ", \"median_ns\": " <<
+                        fixed << setprecision(1) << median << ", \"min_ns\": " << nsPerIter[0] <<
+                        ", \"bytes_per_second\": " << setprecision(0) << bytesPerSec << "}" << flush;
+                jsonStarted = true;
+                return;
+            }
+
+            if (csv) {
+                cout << b.name << "," << iterations << "," << fixed << setprecision(1) <<
+                        median << "," << nsPerIter[0] << "," << setprecision(0) << bytesPerSec << endl;
+                return;
+            }
+
+            cout << left << setw(56) << b.name << right << setw(16) << formatTime(median) <<
+                    setw(16) << formatTime(nsPerIter[0]) << setw(14) << iterations <<
+                    setw(14) << formatRate(bytesPerSec) << endl;
+        }
+
+
+        static string formatTime(double ns) {
+            string unit = " ns";
+            if (ns >= 1.e7)      {ns /= 1.e6; unit = " ms";}
+            else if (ns >= 1.e4) {ns /= 1.e3; unit = " us";}
+
+            stringstream ss;
+            ss << fixed << setprecision(ns < 10. ? 2 : (ns < 100. ? 1 : 0)) << ns << unit;
+            return ss.str();
+        }
+
+
+        static string formatRate(double bytesPerSec) {
+            if (bytesPerSec <= 0.) return "";
+            stringstream ss;
+            ss << fixed << setprecision(1);
+            if (bytesPerSec < 1.e9) ss << bytesPerSec/1.e6 << " MB/s";
+            else                    ss << bytesPerSec/1.e9 << " GB/s";
+            return ss.str();
+        }
+    };
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//  Data generation
+///////////////////////////////////////////////////////////////////////////////////////////
+
+
+    /** Simple, repeatable random number generator. */
+    class Lcg {
+        uint64_t state;
+    public:
+        explicit Lcg(uint64_t seed) : state(seed) {}
+        uint32_t next() {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return (uint32_t)(state >> 33);
+        }
+    };
+
+
+    /**
+     * Create an event resembling detector data: a bank of banks each holding
+     * a bank of uint32 hits, a segment of shorts and a tagsegment of doubles.
+     *
+     * @param banks    number of banks in event.
+     * @param hitWords number of words of hits in each bank.
+     * @param seed     seed for the data.
+     * @param order    byte order of event.
+     * @return buffer containing event.
+     */
+    static shared_ptr<ByteBuffer> generateEvent(uint32_t banks, uint32_t hitWords, uint64_t seed,
+                                                ByteOrder const & order = ByteOrder::ENDIAN_LOCAL) {
+        Lcg rand(seed);
+        vector<uint32_t> hits(hitWords);
+        uint16_t shorts[8];
+        double doubles[4];
+
+        size_t bytes = 8 + banks * (8 + 8 + 4*hitWords + 8 + 16 + 4 + 4 + 32) + 1024;
+        CompactEventBuilder builder(bytes, order, false);
+        builder.openBank(1, DataType::BANK, 1);
+
+        for (uint32_t i = 0; i < banks; i++) {
+            builder.openBank(10 + i % 16, DataType::BANK, i);
+
+            // Hits have a slowly varying channel and small adc values, so they compress
+            builder.openBank(100, DataType::UINT32, 0);
+            for (uint32_t j = 0; j < hitWords; j++) {
+                hits[j] = (j << 16) | (rand.next() & 0xfff);
+            }
+            builder.addIntData(hits.data(), hitWords);
+            builder.closeStructure();
+
+            builder.openBank(101, DataType::SEGMENT, 0);
+            builder.openSegment(102, DataType::USHORT16);
+            for (auto & s : shorts) s = rand.next() & 0xff;
+            builder.addShortData(shorts, 8);
+            builder.closeStructure();
+            builder.closeStructure();
+
+            builder.openBank(103, DataType::TAGSEGMENT, 0);
+            builder.openTagSegment(104, DataType::DOUBLE64);
+            for (auto & d : doubles) d = (rand.next() & 0xffff) / 16.;
+            builder.addDoubleData(doubles, 4);
+            builder.closeStructure();
+            builder.closeStructure();
+
+            builder.closeStructure();
+        }
+
+        builder.closeAll();
+        return builder.getBuffer();
+    }
+
+
+    /**
+     * Write events into a buffer in evio 6 format.
+     * @param count  number of events.
+     * @param banks  number of banks in each event.
+     * @return buffer containing events.
+     */
+    static shared_ptr<ByteBuffer> generateEvioBuffer(uint32_t count, uint32_t banks) {
+        auto buf = make_shared<ByteBuffer>(count * (banks * 200 + 1024) + 1000000);
+        EventWriter writer(buf);
+        for (uint32_t i = 0; i < count; i++) {
+            auto ev = generateEvent(banks, 16, i);
+            writer.writeEvent(ev);
+        }
+        writer.close();
+        return writer.getByteBuffer();
+    }
+
+
+    static string compressionName(Compressor::CompressionType type) {
+        switch (type) {
+            case Compressor::LZ4:      return "LZ4";
+            case Compressor::LZ4_BEST: return "LZ4_BEST";
+            case Compressor::GZIP:     return "GZIP";
+            case Compressor::ZSTD:     return "ZSTD";
+            default:                   return "NONE";
+        }
+    }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//  Benchmarks
+///////////////////////////////////////////////////////////////////////////////////////////
+
+
+    static void addRecordBenchmarks(BenchmarkRunner & runner) {
+
+        for (uint32_t eventBanks : {1, 16, 128}) {
+            auto ev = generateEvent(eventBanks, 16, 1);
+            string name = "RecordOutput/addEvent/bytes:" + to_string(ev->remaining());
+
+            runner.add(name, [ev](BenchmarkState & state) {
+                RecordOutput record(ByteOrder::ENDIAN_LOCAL);
+                const uint8_t *data = ev->array() + ev->arrayOffset() + ev->position();
+                uint32_t len = ev->remaining();
+                state.setBytesPerIteration(len);
+
+                while (state.keepRunning()) {
+                    if (!record.addEvent(data, len)) {
+                        record.reset();
+                        record.addEvent(data, len);
+                    }
+                }
+            });
+        }
+
+        // Build 1000 events of ~8kB into a record
+        vector<shared_ptr<ByteBuffer>> events;
+        size_t totalBytes = 0;
+        for (uint32_t i = 0; i < 1000; i++) {
+            events.push_back(generateEvent(32, 48, i));
+            totalBytes += events.back()->remaining();
+        }
+
+        for (auto type : {Compressor::UNCOMPRESSED, Compressor::LZ4, Compressor::LZ4_BEST,
+                          Compressor::GZIP, Compressor::ZSTD}) {
+            if (!Compressor::isSupported(type)) continue;
+
+            runner.add("RecordOutput/build/" + compressionName(type), [events, totalBytes, type](BenchmarkState & state) {
+                RecordOutput record(ByteOrder::ENDIAN_LOCAL, 1000000, 16*1024*1024, type);
+                state.setBytesPerIteration(totalBytes);
+
+                while (state.keepRunning()) {
+                    record.reset();
+                    for (auto const & ev : events) {
+                        record.addEvent(ev);
+                    }
+                    record.build();
+                }
+                benchmarkSink += record.getBinaryBuffer()->limit();
+            });
+        }
+    }
+
+
+    static void addCompressorBenchmarks(BenchmarkRunner & runner) {
+
+        // 1 MB of evio data
+        auto evioBuf = generateEvioBuffer(128, 32);
+        auto src = make_shared<vector<uint8_t>>(evioBuf->array(), evioBuf->array() + min((size_t)1000000, evioBuf->limit()));
+        int srcSize = src->size();
+
+        runner.add("Compressor/LZ4/roundTrip", [src, srcSize](BenchmarkState & state) {
+            vector<uint8_t> comp(Compressor::getMaxCompressedLength(Compressor::LZ4, srcSize));
+            vector<uint8_t> uncomp(srcSize);
+            state.setBytesPerIteration(srcSize);
+
+            while (state.keepRunning()) {
+                int compSize = Compressor::compressLZ4(src->data(), 0, srcSize, comp.data(), 0, comp.size());
+                benchmarkSink += Compressor::uncompressLZ4(comp.data(), 0, compSize, uncomp.data(), 0, srcSize);
+            }
+        });
+
+        runner.add("Compressor/LZ4_BEST/roundTrip", [src, srcSize](BenchmarkState & state) {
+            vector<uint8_t> comp(Compressor::getMaxCompressedLength(Compressor::LZ4_BEST, srcSize));
+            vector<uint8_t> uncomp(srcSize);
+            state.setBytesPerIteration(srcSize);
+
+            while (state.keepRunning()) {
+                int compSize = Compressor::compressLZ4Best(src->data(), 0, srcSize, comp.data(), 0, comp.size());
+                benchmarkSink += Compressor::uncompressLZ4(comp.data(), 0, compSize, uncomp.data(), 0, srcSize);
+            }
+        });
+
+#ifdef USE_GZIP
+        runner.add("Compressor/GZIP/roundTrip", [src, srcSize](BenchmarkState & state) {
+            vector<uint8_t> comp(Compressor::getMaxCompressedLength(Compressor::GZIP, srcSize));
+            vector<uint8_t> uncomp(srcSize);
+            state.setBytesPerIteration(srcSize);
+
+            while (state.keepRunning()) {
+                uint32_t compSize = comp.size();
+                Compressor::compressGZIP(comp.data(), &compSize, src->data(), srcSize);
+                uint32_t uncompSize = uncomp.size();
+                Compressor::uncompressGZIP(uncomp.data(), &uncompSize, comp.data(), &compSize, srcSize);
+                benchmarkSink += uncompSize;
+            }
+        });
+#endif
+
+#ifdef USE_ZSTD
+        runner.add("Compressor/ZSTD/roundTrip", [src, srcSize](BenchmarkState & state) {
+            vector<uint8_t> comp(Compressor::getMaxCompressedLength(Compressor::ZSTD, srcSize));
+            vector<uint8_t> uncomp(srcSize);
+            state.setBytesPerIteration(srcSize);
+
+            while (state.keepRunning()) {
+                int compSize = Compressor::compressZstd(src->data(), 0, srcSize, comp.data(), 0, comp.size());
+                benchmarkSink += Compressor::uncompressZstd(comp.data(), 0, compSize, uncomp.data(), 0, srcSize);
+            }
+        });
+#endif
+    }
+
+
+    static void addSwapBenchmarks(BenchmarkRunner & runner) {
+
+        for (uint32_t hitWords : {16, 1024}) {
+            auto ev = generateEvent(64, hitWords, 2);
+            runner.add("EvioSwap/swapEvent/bytes:" + to_string(ev->remaining()), [ev](BenchmarkState & state) {
+                uint32_t words = ev->remaining() / 4;
+                vector<uint32_t> src(words), dst(words);
+                memcpy(src.data(), ev->array() + ev->arrayOffset() + ev->position(), 4*words);
+                state.setBytesPerIteration(4*words);
+
+                while (state.keepRunning()) {
+                    EvioSwap::swapEvent(src.data(), 0, dst.data());
+                }
+                benchmarkSink += dst[0];
+            });
+        }
+
+        runner.add("ByteOrder/byteSwap32/words:262144", [](BenchmarkState & state) {
+            vector<uint32_t> src(262144), dst(262144);
+            Lcg rand(3);
+            for (auto & i : src) i = rand.next();
+            state.setBytesPerIteration(4*src.size());
+
+            while (state.keepRunning()) {
+                ByteOrder::byteSwap32(src.data(), src.size(), dst.data());
+            }
+            benchmarkSink += dst[0];
+        });
+    }
+
+
+    static void addParserBenchmarks(BenchmarkRunner & runner) {
+
+        for (uint32_t banks : {8, 128}) {
+            auto buf = generateEvioBuffer(100, banks);
+
+            runner.add("EventParser/parseEvent/banks:" + to_string(banks), [buf](BenchmarkState & state) {
+                auto readBuf = make_shared<ByteBuffer>(*buf);
+                EvioReader reader(readBuf);
+                EventParser parser;
+                size_t count = reader.getEventCount();
+                size_t evNum = 0;
+
+                while (state.keepRunning()) {
+                    auto ev = reader.getEvent(evNum++ % count + 1);
+                    parser.parseEvent(ev);
+                    benchmarkSink += ev->getChildCount();
+                }
+            });
+        }
+    }
+
+
+    static void addCompactReaderBenchmarks(BenchmarkRunner & runner) {
+
+        for (uint32_t banks : {8, 128}) {
+            auto buf = generateEvioBuffer(100, banks);
+            string suffix = "/banks:" + to_string(banks);
+
+            runner.add("EvioCompactReader/getScannedEvent" + suffix, [buf](BenchmarkState & state) {
+                auto readBuf = make_shared<ByteBuffer>(*buf);
+                EvioCompactReader reader(readBuf);
+                size_t count = reader.getEventCount();
+                size_t evNum = 0;
+
+                while (state.keepRunning()) {
+                    auto node = reader.getScannedEvent(evNum++ % count + 1);
+                    benchmarkSink += node->getAllNodes().size();
+                }
+            });
+
+            runner.add("EvioCompactReader/getScannedEvent/pool" + suffix, [buf](BenchmarkState & state) {
+                auto readBuf = make_shared<ByteBuffer>(*buf);
+                auto pool = make_shared<EvioNodePool>();
+                EvioCompactReader reader(readBuf, pool);
+                size_t count = reader.getEventCount();
+                size_t evNum = 0;
+
+                while (state.keepRunning()) {
+                    // Scan each event only once per buffer as pooled nodes are not released
+                    if (evNum % count == 0) {
+                        reader.setBuffer(readBuf, pool);
+                    }
+                    auto node = reader.getScannedEvent(evNum++ % count + 1);
+                    benchmarkSink += node->getAllNodes().size();
+                }
+            });
+
+            runner.add("EvioCompactReader/searchEvent" + suffix, [buf](BenchmarkState & state) {
+                auto readBuf = make_shared<ByteBuffer>(*buf);
+                EvioCompactReader reader(readBuf);
+                vector<shared_ptr<EvioNode>> found;
+                size_t count = reader.getEventCount();
+                size_t evNum = 0;
+
+                while (state.keepRunning()) {
+                    reader.searchEvent(evNum++ % count + 1, 104, 0, found);
+                    benchmarkSink += found.size();
+                }
+            });
+
+            runner.add("EvioCompactReader/indexEvent+search" + suffix, [buf](BenchmarkState & state) {
+                auto readBuf = make_shared<ByteBuffer>(*buf);
+                EvioCompactReader reader(readBuf);
+                StructureIndex index;
+                vector<uint32_t> found;
+                size_t count = reader.getEventCount();
+                size_t evNum = 0;
+
+                while (state.keepRunning()) {
+                    reader.indexEvent(evNum++ % count + 1, index);
+                    index.search(104, 0, found);
+                    benchmarkSink += found.size();
+                }
+            });
+        }
+    }
+
+
+    static void addCompositeBenchmarks(BenchmarkRunner & runner) {
+
+        // 100 composite data items each with 50 rows of (int, float, 2 shorts, double)
+        string format = "N(I,F,2S,D)";
+        vector<shared_ptr<CompositeData>> items;
+        Lcg rand(4);
+
+        for (int i = 0; i < 100; i++) {
+            CompositeData::Data data;
+            data.addN(50);
+            for (int j = 0; j < 50; j++) {
+                data.addInt(rand.next());
+                data.addFloat((rand.next() & 0xffff) / 8.f);
+                data.addShort(rand.next() & 0x7fff);
+                data.addShort(rand.next() & 0x7fff);
+                data.addDouble((rand.next() & 0xffff) / 16.);
+            }
+            items.push_back(CompositeData::getInstance(format, data, 1, 2, 3));
+        }
+
+        auto raw = make_shared<vector<uint8_t>>();
+        ByteOrder order = ByteOrder::ENDIAN_LOCAL;
+        CompositeData::generateRawBytes(items, *raw, order);
+
+        runner.add("CompositeData/parse", [raw](BenchmarkState & state) {
+            vector<shared_ptr<CompositeData>> list;
+            state.setBytesPerIteration(raw->size());
+
+            while (state.keepRunning()) {
+                CompositeData::parse(raw->data(), raw->size(), ByteOrder::ENDIAN_LOCAL, list);
+                benchmarkSink += list.size();
+            }
+        });
+
+        runner.add("CompositeData/swapAll", [raw](BenchmarkState & state) {
+            vector<uint8_t> src(*raw), dst(raw->size());
+            state.setBytesPerIteration(src.size());
+
+            while (state.keepRunning()) {
+                CompositeData::swapAll(src.data(), dst.data(), src.size()/4, true);
+            }
+            benchmarkSink += dst[0];
+        });
+    }
+
+
+    static void addWriterReaderBenchmarks(BenchmarkRunner & runner, string const & dir) {
+
+        // 2000 events of ~8kB, ~16MB of data in each iteration
+        auto events = make_shared<vector<shared_ptr<ByteBuffer>>>();
+        size_t totalBytes = 0;
+        for (uint32_t i = 0; i < 2000; i++) {
+            events->push_back(generateEvent(32, 48, i));
+            totalBytes += events->back()->remaining();
+        }
+
+        string fileName = "evioBenchmark.evio";
+        string filePath = dir + "/" + fileName;
+
+        struct Config {
+            Compressor::CompressionType type;
+            uint32_t threads;
+            uint32_t ringSize;
+        };
+
+        vector<Config> configs {
+            {Compressor::UNCOMPRESSED, 1, 0},
+            {Compressor::LZ4, 1, 0},
+            {Compressor::LZ4, 2, 8},
+            {Compressor::LZ4, 2, 32},
+            {Compressor::LZ4, 4, 8},
+            {Compressor::LZ4, 4, 32},
+            {Compressor::LZ4, 8, 32},
+        };
+
+        for (auto const & c : configs) {
+            string name = "EventWriter/write/" + compressionName(c.type) +
+                          "/threads:" + to_string(c.threads);
+            if (c.threads > 1) name += "/ring:" + to_string(c.ringSize);
+
+            runner.add(name, [events, totalBytes, fileName, dir, c](BenchmarkState & state) {
+                string dictionary;
+                state.setBytesPerIteration(totalBytes);
+
+                while (state.keepRunning()) {
+                    EventWriter writer(fileName, dir, "", 0, 0, 0, 0,
+                                       ByteOrder::ENDIAN_LOCAL, dictionary, true, false,
+                                       nullptr, 0, 0, 1, 1, c.type, c.threads, c.ringSize, 0);
+                    for (auto & ev : *events) {
+                        writer.writeEvent(ev);
+                    }
+                    writer.close();
+                }
+            });
+        }
+
+        // Same events written as one batch
+        for (uint32_t threads : {1, 4}) {
+            runner.add("EventWriter/writeEvents/LZ4/threads:" + to_string(threads),
+                       [events, totalBytes, fileName, dir, threads](BenchmarkState & state) {
+                string dictionary;
+                state.setBytesPerIteration(totalBytes);
+
+                while (state.keepRunning()) {
+                    EventWriter writer(fileName, dir, "", 0, 0, 0, 0,
+                                       ByteOrder::ENDIAN_LOCAL, dictionary, true, false,
+                                       nullptr, 0, 0, 1, 1, Compressor::LZ4, threads, 0, 0);
+                    writer.writeEvents(*events);
+                    writer.close();
+                }
+            });
+        }
+
+        for (auto type : {Compressor::UNCOMPRESSED, Compressor::LZ4}) {
+            runner.add("Reader/getNextEvent/" + compressionName(type),
+                       [events, totalBytes, fileName, filePath, dir, type](BenchmarkState & state) {
+                string dictionary;
+                {
+                    EventWriter writer(fileName, dir, "", 0, 0, 0, 0,
+                                       ByteOrder::ENDIAN_LOCAL, dictionary, true, false,
+                                       nullptr, 0, 0, 1, 1, type, 1, 0, 0);
+                    for (auto & ev : *events) {
+                        writer.writeEvent(ev);
+                    }
+                    writer.close();
+                }
+                state.setBytesPerIteration(totalBytes);
+
+                while (state.keepRunning()) {
+                    Reader reader(filePath, false);
+                    uint32_t len;
+                    while (reader.getNextEvent(&len) != nullptr) {
+                        benchmarkSink += len;
+                    }
+                }
+            });
+        }
+    }
+
+
+    static void printContext() {
+        cout << "EvioBenchmark running on " << thread::hardware_concurrency() << " cpus" << endl;
+        cout << "Byte swapping: " << ByteOrder::getSwapImplementation() << endl;
+        cout << "Compression available: NONE, LZ4, LZ4_BEST";
+        if (Compressor::isSupported(Compressor::GZIP)) cout << ", GZIP";
+        if (Compressor::isSupported(Compressor::ZSTD)) cout << ", ZSTD";
+        cout << endl << endl;
+    }
+
+
+    static void usage() {
+        cout << "Usage: EvioBenchmark [--filter=<regex>] [--min_time=<sec>] [--repetitions=<n>]" << endl;
+        cout << "                     [--dir=<directory for files>] [--csv] [--json] [--list]" << endl;
+    }
+
+}
+
+
+int main(int argc, char **argv) {
+
+    using namespace evio;
+
+    string filter = ".*";
+    string dir = "/tmp";
+    bool listOnly = false;
+    BenchmarkRunner runner;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg.rfind("--filter=", 0) == 0) {
+            filter = arg.substr(9);
+        }
+        else if (arg.rfind("--min_time=", 0) == 0) {
+            runner.setMinTime(stod(arg.substr(11)));
+        }
+        else if (arg.rfind("--repetitions=", 0) == 0) {
+            runner.setRepetitions(stoul(arg.substr(14)));
+        }
+        else if (arg.rfind("--dir=", 0) == 0) {
+            dir = arg.substr(6);
+        }
+        else if (arg == "--csv") {
+            runner.setCsv(true);
+        }
+        else if (arg == "--json") {
+            runner.setJson(true);
+        }
+        else if (arg == "--list") {
+            listOnly = true;
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    addRecordBenchmarks(runner);
+    addCompressorBenchmarks(runner);
+    addSwapBenchmarks(runner);
+    addParserBenchmarks(runner);
+    addCompactReaderBenchmarks(runner);
+    addCompositeBenchmarks(runner);
+    addWriterReaderBenchmarks(runner, dir);
+
+    if (listOnly) {
+        runner.list();
+        return 0;
+    }
+
+    if (!runner.isJson()) {
+        printContext();
+    }
+    runner.run(filter);
+    remove((dir + "/evioBenchmark.evio").c_str());
+    return 0;
+}
@@ -0,0 +1,352 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <random>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of random changes made to the event. */
+    static const uint32_t CHANGES = 3000;
+
+    /** Most structures the event may hold before changes only remove or replace. */
+    static const size_t MAX_STRUCTURES = 80;
+
+    /** Random numbers, always the same sequence. */
+    static std::mt19937 rng(17);
+
+
+    /**
+     * Description of a structure of the event, kept alongside the event being changed,
+     * from which the same event can be built again from scratch.
+     */
+    struct Node {
+        /** Structure in the event being changed. */
+        std::shared_ptr<BaseStructure> live;
+        /** Type of structure. */
+        StructureType structType = StructureType::STRUCT_BANK;
+        /** Type of data or, for containers, of children. */
+        DataType dataType = DataType::BANK;
+        /** Structure tag. */
+        uint16_t tag = 0;
+        /** Data of an INT32 leaf. */
+        std::vector<int32_t> ints;
+        /** Data of a SHORT16 leaf. */
+        std::vector<int16_t> shorts;
+        /** Data of a UCHAR8 leaf. */
+        std::vector<unsigned char> chars;
+        /** Parent, null for the event. */
+        Node *parent = nullptr;
+        /** Children. */
+        std::vector<std::unique_ptr<Node>> children;
+
+        bool isContainer() const {return dataType.isStructure();}
+    };
+
+
+    /** Make a new structure of the given kind. */
+    static std::shared_ptr<BaseStructure> makeStructure(StructureType const & structType,
+                                                        uint16_t tag, DataType const & dataType) {
+        if (structType == StructureType::STRUCT_SEGMENT) {
+            return EvioSegment::getInstance(tag, dataType);
+        }
+        else if (structType == StructureType::STRUCT_TAGSEGMENT) {
+            return EvioTagSegment::getInstance(tag, dataType);
+        }
+        return EvioBank::getInstance(tag, dataType, 0);
+    }
+
+
+    /** Put all nodes of the tree into the given list, parents first. */
+    static void listNodes(Node *node, std::vector<Node *> & list) {
+        list.push_back(node);
+        for (auto & child : node->children) {
+            listNodes(child.get(), list);
+        }
+    }
+
+
+    /** Make some random data for a leaf. */
+    template<typename T>
+    static std::vector<T> randomData() {
+        std::vector<T> data(rng() % 12);
+        for (auto & d : data) d = (T) rng();
+        return data;
+    }
+
+
+    /**
+     * Build a structure and all its descendants from scratch, as described by the nodes,
+     * without ever looking at lengths. Only once all are in place does anything set them,
+     * in one full pass.
+     */
+    static std::shared_ptr<BaseStructure> buildFresh(Node const & node) {
+        std::shared_ptr<BaseStructure> s;
+        if (node.parent == nullptr) {
+            s = EvioEvent::getInstance(node.tag, node.dataType, 0);
+        }
+        else {
+            s = makeStructure(node.structType, node.tag, node.dataType);
+        }
+
+        if (node.dataType == DataType::INT32) {
+            auto & v = s->getIntData();
+            v.insert(v.end(), node.ints.begin(), node.ints.end());
+            s->updateIntData();
+        }
+        else if (node.dataType == DataType::SHORT16) {
+            auto & v = s->getShortData();
+            v.insert(v.end(), node.shorts.begin(), node.shorts.end());
+            s->updateShortData();
+        }
+        else if (node.dataType == DataType::UCHAR8) {
+            auto & v = s->getUCharData();
+            v.insert(v.end(), node.chars.begin(), node.chars.end());
+            s->updateUCharData();
+        }
+
+        for (auto & child : node.children) {
+            s->add(buildFresh(*child));
+        }
+        return s;
+    }
+
+
+    /**
+     * Compare the header lengths of two trees of the same shape.
+     * @return number of structures whose lengths differ.
+     */
+    static uint32_t compareLengths(std::shared_ptr<BaseStructure> const & live,
+                                   std::shared_ptr<BaseStructure> const & fresh) {
+        uint32_t differ = 0;
+        if (live->getHeader()->getLength() != fresh->getHeader()->getLength() ||
+            live->getChildCount() != fresh->getChildCount()) {
+            differ++;
+        }
+        for (size_t i=0; i < live->getChildCount() && i < fresh->getChildCount(); i++) {
+            differ += compareLengths(live->getChildAt(i), fresh->getChildAt(i));
+        }
+        return differ;
+    }
+
+
+    /** Add a new child, leaf or container, to the given container. */
+    static void addChild(EventBuilder & builder, Node *parent) {
+        auto node = std::unique_ptr<Node>(new Node);
+        node->parent = parent;
+        node->tag = (uint16_t) (rng() % 1000);
+
+        if (parent->dataType == DataType::SEGMENT) {
+            node->structType = StructureType::STRUCT_SEGMENT;
+        }
+        else if (parent->dataType == DataType::TAGSEGMENT) {
+            node->structType = StructureType::STRUCT_TAGSEGMENT;
+        }
+
+        // Tagsegments can only hold data, the others their own kind too
+        static const DataType types[] = {DataType::INT32, DataType::SHORT16, DataType::UCHAR8,
+                                         DataType::BANK, DataType::SEGMENT, DataType::TAGSEGMENT};
+        uint32_t typeCount = node->structType == StructureType::STRUCT_TAGSEGMENT ? 3 : 6;
+        node->dataType = types[rng() % typeCount];
+        if (node->structType == StructureType::STRUCT_SEGMENT && node->dataType == DataType::BANK) {
+            node->dataType = DataType::SEGMENT;
+        }
+
+        node->live = makeStructure(node->structType, node->tag, node->dataType);
+
+        // Set data either before the child is added or after
+        bool dataFirst = rng() % 2;
+        if (dataFirst && node->dataType == DataType::INT32) {
+            node->ints = randomData<int32_t>();
+            node->live->setIntData(std::vector<int32_t>(node->ints));
+        }
+
+        builder.addChild(parent->live, node->live);
+
+        if (!dataFirst && node->dataType == DataType::INT32) {
+            node->ints = randomData<int32_t>();
+            builder.setIntData(node->live, node->ints.data(), node->ints.size());
+        }
+        else if (node->dataType == DataType::SHORT16) {
+            node->shorts = randomData<int16_t>();
+            builder.setShortData(node->live, node->shorts.data(), node->shorts.size());
+        }
+        else if (node->dataType == DataType::UCHAR8) {
+            node->chars = randomData<unsigned char>();
+            builder.setUCharData(node->live, node->chars.data(), node->chars.size());
+        }
+
+        parent->children.push_back(std::move(node));
+    }
+
+
+    /** Replace, append to, or clear the data of the given leaf. */
+    static void changeData(EventBuilder & builder, Node *leaf) {
+        uint32_t how = rng() % 4;
+
+        if (how == 3) {
+            builder.clearData(leaf->live);
+            leaf->ints.clear();
+            leaf->shorts.clear();
+            leaf->chars.clear();
+        }
+        else if (leaf->dataType == DataType::INT32) {
+            auto data = randomData<int32_t>();
+            if (how == 0) {
+                leaf->ints = data;
+                builder.setIntData(leaf->live, data.data(), data.size());
+            }
+            else if (how == 1) {
+                leaf->ints = data;
+                builder.setIntData(leaf->live, std::move(data));
+            }
+            else {
+                leaf->ints.insert(leaf->ints.end(), data.begin(), data.end());
+                builder.appendIntData(leaf->live, data.data(), data.size());
+            }
+        }
+        else if (leaf->dataType == DataType::SHORT16) {
+            auto data = randomData<int16_t>();
+            if (how == 2) {
+                leaf->shorts.insert(leaf->shorts.end(), data.begin(), data.end());
+                builder.appendShortData(leaf->live, data.data(), data.size());
+            }
+            else {
+                leaf->shorts = data;
+                builder.setShortData(leaf->live, data.data(), data.size());
+            }
+        }
+        else {
+            auto data = randomData<unsigned char>();
+            if (how == 2) {
+                leaf->chars.insert(leaf->chars.end(), data.begin(), data.end());
+                builder.appendUCharData(leaf->live, data.data(), data.size());
+            }
+            else {
+                leaf->chars = data;
+                builder.setUCharData(leaf->live, std::move(data));
+            }
+        }
+    }
+
+
+    /** Remove the given structure, and its descendants, from the event. */
+    static void removeNode(EventBuilder & builder, Node *node) {
+        builder.remove(node->live);
+        auto & siblings = node->parent->children;
+        for (auto it = siblings.begin(); it != siblings.end(); ++it) {
+            if (it->get() == node) {
+                siblings.erase(it);
+                break;
+            }
+        }
+    }
+
+
+    /**
+     * Make many random changes to an event through an EventBuilder, which keeps its header
+     * lengths up to date incrementally. After each, compare its lengths to those of the same
+     * event built from scratch and given its lengths by one full pass, and compare the bytes
+     * each writes.
+     * @return 0 if successful, else 1.
+     */
+    static int headerLengthTest() {
+
+        Node root;
+        root.structType = StructureType::STRUCT_BANK;
+        root.dataType = DataType::BANK;
+        root.tag = 1;
+        auto event = EvioEvent::getInstance(root.tag, root.dataType, 0);
+        root.live = event;
+        EventBuilder builder(event);
+
+        uint32_t badChanges = 0, badWrites = 0, maxStructures = 0;
+        uint32_t adds = 0, removes = 0, dataChanges = 0;
+
+        for (uint32_t change=0; change < CHANGES; change++) {
+            std::vector<Node *> nodes;
+            listNodes(&root, nodes);
+            maxStructures = std::max(maxStructures, (uint32_t)nodes.size());
+
+            Node *node = nodes[rng() % nodes.size()];
+            uint32_t what = rng() % 10;
+
+            if (node->isContainer()) {
+                if (what < 8 && nodes.size() < MAX_STRUCTURES) {
+                    addChild(builder, node);
+                    adds++;
+                }
+                else if (node->parent != nullptr) {
+                    removeNode(builder, node);
+                    removes++;
+                }
+            }
+            else if (what < 2) {
+                removeNode(builder, node);
+                removes++;
+            }
+            else {
+                changeData(builder, node);
+                dataChanges++;
+            }
+
+            auto fresh = buildFresh(root);
+            fresh->setAllHeaderLengths();
+
+            if (compareLengths(event, fresh) > 0) {
+                if (badChanges++ < 5) {
+                    cout << "   lengths differ from full recompute after change " << change << endl;
+                }
+                continue;
+            }
+
+            std::vector<uint8_t> liveBytes(event->getTotalBytes());
+            std::vector<uint8_t> freshBytes(fresh->getTotalBytes());
+            event->write(liveBytes.data(), ByteOrder::ENDIAN_LOCAL);
+            fresh->write(freshBytes.data(), ByteOrder::ENDIAN_LOCAL);
+            if (liveBytes != freshBytes) {
+                if (badWrites++ < 5) {
+                    cout << "   written event differs from full recompute after change " << change << endl;
+                }
+            }
+        }
+
+        cout << "Made " << adds << " adds, " << removes << " removes, " << dataChanges <<
+                " data changes, with up to " << maxStructures << " structures: " <<
+                badChanges << " had wrong lengths, " << badWrites << " wrote differently" << endl;
+
+        if (badChanges > 0 || badWrites > 0) {
+            cout << "FAILED: incremental header lengths differ from full recompute" << endl;
+            return 1;
+        }
+
+        cout << "Incremental header lengths match full recompute" << endl;
+        return 0;
+    }
+
+}
+
+
+
+int main() {
+    return evio::headerLengthTest();
+}
@@ -394,6 +394,13 @@ namespace evio {
                 reader.getEvent(bb2, 0);
                 std::cout << "createCompactEvents: event 1,  bb2 limit ->\n" << bb2->limit() << std::endl;
 
+                // Read same event from memory mapped file, which is not copied out of the file
+                Reader mappedReader(writeFileName1, false, true);
+                uint32_t mappedLen;
+                std::shared_ptr<uint8_t> mappedBytes = mappedReader.getEvent(0, &mappedLen);
+                bool sameEvent = (mappedLen == len) && (std::memcmp(mappedBytes.get(), bytes2.get(), len) == 0);
+                std::cout << "createCompactEvents: event 1 same when memory mapped? " << sameEvent << std::endl;
+
 
 
                 //                // Write into a buffer
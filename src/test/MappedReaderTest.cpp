@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "eviocc.h"
+#include "TestEvents.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of events written. */
+    static const uint32_t EVENTS = 100;
+
+    /** Number of events in each record. */
+    static const uint32_t EVENTS_PER_RECORD = 10;
+
+
+    /**
+     * Read the records of an uncompressed file with a memory mapped Reader, so they are
+     * read in place. Keep each record's uncompressed data buffer, and its first event,
+     * once the reader is closed and gone and the file removed. They must still hold
+     * what was written since they keep the file mapped.
+     *
+     * @return 0 if successful, else 1.
+     */
+    static int mappedLifetimeTest() {
+
+        std::string fileName = "./mappedReaderTest.evio";
+        TestEvents::writeFile(fileName, EVENTS, EVENTS_PER_RECORD);
+
+        std::vector<std::shared_ptr<ByteBuffer>> records;
+        std::vector<std::shared_ptr<uint8_t>> firstEvents;
+        {
+            auto reader = std::make_shared<Reader>(fileName, false, true);
+            if (!reader->isMemoryMapped() || reader->getEventCount() != EVENTS) {
+                cout << "FAILED: file not mapped or wrong number of events" << endl;
+                remove(fileName.c_str());
+                return 1;
+            }
+
+            for (uint32_t r=0; r < reader->getRecordCount(); r++) {
+                reader->readRecord(r);
+                if (!reader->getCurrentRecordStream().isInPlace()) {
+                    cout << "FAILED: record " << r << " not read in place" << endl;
+                    remove(fileName.c_str());
+                    return 1;
+                }
+                records.push_back(reader->getCurrentRecordStream().getUncompressedDataBuffer());
+                uint32_t len;
+                firstEvents.push_back(reader->getEvent(r * EVENTS_PER_RECORD, &len));
+            }
+            reader->close();
+        }
+
+        // Nothing but the buffers and events refers to the mapping now
+        remove(fileName.c_str());
+
+        uint32_t differ = 0;
+        for (uint32_t r=0; r < firstEvents.size(); r++) {
+            auto first = TestEvents::makeEvent(r * EVENTS_PER_RECORD);
+            if (std::memcmp(firstEvents[r].get(), first->array(), first->limit()) != 0) {
+                if (differ++ < 5) cout << "   first event of record " << r << " differs from the one written" << endl;
+            }
+        }
+
+        // Each buffer must keep the mapping on its own
+        firstEvents.clear();
+
+        for (uint32_t r=0; r < records.size(); r++) {
+            // Events of a record follow one another in its data
+            std::vector<uint8_t> expected;
+            for (uint32_t ev = r * EVENTS_PER_RECORD; ev < (r + 1) * EVENTS_PER_RECORD; ev++) {
+                auto event = TestEvents::makeEvent(ev);
+                expected.insert(expected.end(), event->array(), event->array() + event->limit());
+            }
+
+            auto & data = records[r];
+            if (data->remaining() != expected.size() ||
+                std::memcmp(data->array() + data->arrayOffset() + data->position(),
+                            expected.data(), expected.size()) != 0) {
+                if (differ++ < 5) cout << "   record " << r << " differs from the one written" << endl;
+            }
+        }
+
+        if (differ > 0) {
+            cout << "FAILED: " << differ << " records or events read in place changed once their reader was gone" << endl;
+            return 1;
+        }
+
+        cout << "Records and events read in place outlive their reader" << endl;
+        return 0;
+    }
+
+}
+
+
+
+int main() {
+    return evio::mappedLifetimeTest();
+}
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "eviocc.h"
+#include "TestEvents.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of events written. */
+    static const uint32_t EVENTS = 1000;
+
+    /** Number of events in each record. */
+    static const uint32_t EVENTS_PER_RECORD = 10;
+
+    /** Number of checks which failed. */
+    static uint32_t failures = 0;
+
+
+    /** Count a failed check, describing the first few. */
+    static void check(bool ok, std::string const & what, std::string const & test, uint32_t ev) {
+        if (ok) return;
+        if (failures++ < 10) {
+            cout << "   " << test << ", event " << ev << ": " << what << endl;
+        }
+    }
+
+
+    /** Is the event read the same as the one read without reading ahead? */
+    static bool same(std::shared_ptr<uint8_t> const & event, uint32_t len, std::vector<uint8_t> const & plain) {
+        return event != nullptr && len == plain.size() && std::memcmp(event.get(), plain.data(), len) == 0;
+    }
+
+
+    /**
+     * Read a file with records read ahead, sequentially and then jumping forward
+     * past the records read ahead, and compare every event with the one read
+     * without reading ahead.
+     *
+     * @param fileName    name of file.
+     * @param memoryMap   if true, memory map the file.
+     * @param records     max number of records to read ahead.
+     * @param bytes       max number of bytes to read ahead.
+     * @param plain       events read without reading ahead.
+     */
+    static void readAheadTest(std::string const & fileName, bool memoryMap, uint32_t records, size_t bytes,
+                              std::vector<std::vector<uint8_t>> const & plain) {
+
+        std::string test = std::string(memoryMap ? "mapped" : "file") +
+                           ", " + std::to_string(records) + " records, " + std::to_string(bytes) + " bytes";
+        uint32_t len, count = 0;
+
+        {
+            Reader reader(fileName, false, memoryMap);
+            reader.setReadAhead(records, bytes);
+            check(reader.isMemoryMapped() == memoryMap, "wrong mapping", test, 0);
+
+            std::shared_ptr<uint8_t> event;
+            while ((event = reader.getNextEvent(&len)) != nullptr) {
+                check(count < plain.size() && same(event, len, plain[count]),
+                      "differs from plain read", test, count);
+                count++;
+            }
+            check(count == plain.size(), "wrong number of events read", test, count);
+        }
+
+        {
+            Reader reader(fileName, false, memoryMap);
+            reader.setReadAhead(records, bytes);
+
+            // Start reading ahead, then jump far past the records read ahead and go on from there
+            for (uint32_t ev = 0; ev < 2*EVENTS_PER_RECORD; ev++) {
+                auto event = reader.getEvent(ev, &len);
+                check(same(event, len, plain[ev]), "differs from plain read", test, ev);
+            }
+            for (uint32_t ev = EVENTS/2; ev < EVENTS; ev++) {
+                auto event = reader.getEvent(ev, &len);
+                check(same(event, len, plain[ev]), "differs from plain read after jump", test, ev);
+            }
+        }
+    }
+
+
+    /**
+     * Read an uncompressed file, as a file and memory mapped, with records read
+     * ahead by count and by size, and check every event against a plain read.
+     * @return 0 if successful, else 1.
+     */
+    static int readAheadTests() {
+
+        std::string fileName = "./readAheadTest.evio";
+        TestEvents::writeFile(fileName, EVENTS, EVENTS_PER_RECORD);
+
+        // Read without reading ahead
+        std::vector<std::vector<uint8_t>> plain;
+        {
+            Reader reader(fileName);
+            uint32_t len;
+            for (uint32_t ev = 0; ev < reader.getEventCount(); ev++) {
+                auto event = reader.getEvent(ev, &len);
+                check(TestEvents::matches(event, len, ev), "plain read differs from the one written", "plain", ev);
+                plain.emplace_back(event.get(), event.get() + len);
+            }
+            check(plain.size() == EVENTS, "wrong number of events read", "plain", (uint32_t) plain.size());
+        }
+
+        for (bool memoryMap : {false, true}) {
+            readAheadTest(fileName, memoryMap, 4, 0, plain);
+            readAheadTest(fileName, memoryMap, 0, 1000, plain);
+        }
+
+        remove(fileName.c_str());
+
+        if (failures > 0) {
+            cout << "FAILED: " << failures << " events read ahead not the same as read plainly" << endl;
+            return 1;
+        }
+
+        cout << "Events read ahead are the same as read plainly" << endl;
+        return 0;
+    }
+
+}
+
+
+
+int main() {
+    return evio::readAheadTests();
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <sys/stat.h>
+
+#include "eviocc.h"
+#include "TestEvents.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of bursts of events written, with a pause after each. */
+    static const uint32_t BURSTS = 5;
+
+    /** Number of events in each burst. */
+    static const uint32_t EVENTS_PER_BURST = 10;
+
+    /** Max time events may wait in a record in milliseconds. */
+    static const uint32_t MAX_AGE = 20;
+
+
+    /** @return size of the given file in bytes, 0 if it can't be had. */
+    static size_t fileSize(std::string const & fileName) {
+        struct stat st;
+        if (stat(fileName.c_str(), &st) != 0) return 0;
+        return (size_t) st.st_size;
+    }
+
+
+    /**
+     * Write bursts of events to a file, pausing after each, with records large enough
+     * that none ever fills. With a max record age set, check that each burst reaches
+     * the file while the writer is still open.
+     *
+     * @param fileName           name of file.
+     * @param compressionType    type of compression.
+     * @param compressionThreads number of compression threads.
+     * @param maxAge             max record age in milliseconds, 0 for none.
+     * @return number of bursts which did not reach the file before the pause ended.
+     */
+    static uint32_t writeFile(std::string const & fileName, Compressor::CompressionType compressionType,
+                              uint32_t compressionThreads, uint32_t maxAge) {
+
+        EventWriter writer(fileName, "", "", 1, 0, 8000000, 100000, ByteOrder::ENDIAN_LOCAL,
+                           "", true, false, nullptr, 0, 0, 1, 1,
+                           compressionType, compressionThreads, 0, 0);
+        writer.setMaxRecordAge(maxAge);
+
+        uint32_t late = 0, ev = 0;
+        for (uint32_t b=0; b < BURSTS; b++) {
+            size_t sizeBefore = fileSize(fileName);
+
+            for (uint32_t i=0; i < EVENTS_PER_BURST; i++) {
+                auto event = TestEvents::makeEvent(ev++);
+                writer.writeEvent(event);
+            }
+
+            if (maxAge > 0) {
+                // Give the timer plenty of time to send the record to the file
+                bool grew = false;
+                for (int wait=0; wait < 200 && !grew; wait++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    grew = fileSize(fileName) > sizeBefore;
+                }
+                if (!grew) {
+                    cout << "   burst " << b << " not in file after 2 sec" << endl;
+                    late++;
+                }
+            }
+        }
+
+        writer.close();
+        return late;
+    }
+
+
+    /**
+     * Read all events of a file.
+     * @param fileName     name of file.
+     * @param recordCount  filled with number of records in file.
+     * @return each event's bytes.
+     */
+    static std::vector<std::vector<uint8_t>> readFile(std::string const & fileName, uint32_t & recordCount) {
+        std::vector<std::vector<uint8_t>> events;
+        Reader reader(fileName);
+        recordCount = reader.getRecordCount();
+
+        for (uint32_t i=0; i < reader.getEventCount(); i++) {
+            uint32_t len;
+            std::shared_ptr<uint8_t> data = reader.getEvent(i, &len);
+            events.emplace_back(data.get(), data.get() + len);
+        }
+        return events;
+    }
+
+
+    /**
+     * Write the same events with and without a max record age, and check that
+     * with it each burst reaches the file on its own, in a record of its own,
+     * and that both files hold the same events as were written.
+     *
+     * @param compressionType    type of compression.
+     * @param compressionThreads number of compression threads.
+     * @return 0 if successful, else 1.
+     */
+    static int recordAgeTest(Compressor::CompressionType compressionType, uint32_t compressionThreads) {
+
+        cout << "Max record age of " << MAX_AGE << " ms, " <<
+                (compressionType == Compressor::UNCOMPRESSED ? "uncompressed, " : "compressed, ") <<
+                compressionThreads << " compression thread(s):" << endl;
+
+        std::string agedFile = "./recordAgeTest.evio";
+        std::string plainFile = "./recordAgeTestPlain.evio";
+
+        uint32_t late = writeFile(agedFile, compressionType, compressionThreads, MAX_AGE);
+        writeFile(plainFile, compressionType, compressionThreads, 0);
+
+        uint32_t agedRecords, plainRecords;
+        auto aged = readFile(agedFile, agedRecords);
+        auto plain = readFile(plainFile, plainRecords);
+
+        remove(agedFile.c_str());
+        remove(plainFile.c_str());
+
+        uint32_t differ = 0;
+        for (uint32_t ev=0; ev < aged.size(); ev++) {
+            auto event = TestEvents::makeEvent(ev);
+            std::vector<uint8_t> expected(event->array(), event->array() + event->limit());
+            if (aged[ev] != expected || ev >= plain.size() || plain[ev] != expected) {
+                if (differ++ < 5) cout << "   event " << ev << " differs from the one written" << endl;
+            }
+        }
+
+        cout << "   " << aged.size() << " events in " << agedRecords << " records with a max age, " <<
+                plain.size() << " events in " << plainRecords << " records without, " <<
+                late << " bursts late, " << differ << " events differ" << endl;
+
+        if (late > 0 || differ > 0 ||
+            aged.size() != BURSTS * EVENTS_PER_BURST || plain.size() != aged.size()) {
+            cout << "   FAILED: events not all written in time, or not as written" << endl;
+            return 1;
+        }
+        if (agedRecords < BURSTS || plainRecords >= agedRecords) {
+            cout << "   FAILED: partial records not written on their own" << endl;
+            return 1;
+        }
+
+        cout << "   Each burst was written on its own and read back as written" << endl;
+        return 0;
+    }
+
+}
+
+
+
+int main() {
+    // Single-threaded compression writes aged records directly,
+    // multithreaded compression publishes them to the ring.
+    int status = evio::recordAgeTest(evio::Compressor::UNCOMPRESSED, 1);
+    status |= evio::recordAgeTest(evio::Compressor::LZ4, 2);
+    return status;
+}
@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <random>
+
+#include "eviocc.h"
+
+
+using namespace std;
+
+
+namespace evio {
+
+
+    /** Number of headers with random contents tried in each byte order. */
+    static const uint32_t TRIALS = 500;
+
+    /** Bytes of room for any header, optional words included. */
+    static const size_t ROOM = 128;
+
+    /** Random numbers, always the same sequence. */
+    static std::mt19937_64 rng(29);
+
+    /** Number of checks which failed. */
+    static uint32_t failures = 0;
+
+
+    /** Count a failed check, describing the first few. */
+    static void check(bool ok, std::string const & what, uint32_t trial, ByteOrder const & order) {
+        if (ok) return;
+        if (failures++ < 10) {
+            cout << "   trial " << trial << ", " << order.getName() << ": " << what << endl;
+        }
+    }
+
+
+    /** Give a record header random contents, optional words included now and then. */
+    static void fillRecordHeader(RecordHeader & h, uint32_t trial) {
+        h.setRecordNumber((uint32_t) rng());
+        h.setEntries((uint32_t) rng() % 100000);
+        h.setIndexLength(4 * ((uint32_t) rng() % 1000));
+        h.setUserHeaderLength((uint32_t) rng() % 10000);
+        h.setDataLength((uint32_t) rng() % 10000000);
+        h.setCompressionType(trial % 2 ? Compressor::LZ4 : Compressor::UNCOMPRESSED);
+        h.setCompressedDataLength((uint32_t) rng() % 10000000);
+        h.setUserRegisterFirst(rng());
+        h.setUserRegisterSecond(rng());
+        h.setBitInfo(trial % 5 == 0, trial % 3 == 0, trial % 7 == 0);
+
+        if (trial % 3 == 1) {
+            h.hasChecksum(true);
+            h.setChecksum((uint32_t) rng());
+        }
+        if (trial % 4 == 1) {
+            h.hasTimeRange(true);
+            uint64_t t = rng() >> 1;
+            h.setTimeRange(t, t + (rng() >> 40));
+        }
+
+        h.setLength(4 * ((uint32_t) rng() % 1000000));
+    }
+
+
+    /** Do the two record headers hold the same values? */
+    static bool sameRecordHeader(RecordHeader & a, RecordHeader & b) {
+        return a.getLength()              == b.getLength() &&
+               a.getRecordNumber()        == b.getRecordNumber() &&
+               a.getHeaderLength()        == b.getHeaderLength() &&
+               a.getEntries()             == b.getEntries() &&
+               a.getIndexLength()         == b.getIndexLength() &&
+               a.getBitInfoWord()         == b.getBitInfoWord() &&
+               a.getUserHeaderLength()    == b.getUserHeaderLength() &&
+               a.getDataLength()          == b.getDataLength() &&
+               a.getCompressionType()     == b.getCompressionType() &&
+               a.getCompressedDataLength() == b.getCompressedDataLength() &&
+               a.getUserRegisterFirst()   == b.getUserRegisterFirst() &&
+               a.getUserRegisterSecond()  == b.getUserRegisterSecond() &&
+               a.getChecksum()            == b.getChecksum() &&
+               a.getTimeMin()             == b.getTimeMin() &&
+               a.getTimeMax()             == b.getTimeMax();
+    }
+
+
+    /**
+     * Write record headers with random contents in each byte order. Each word written
+     * must be what reading it on its own, with ByteBuffer.getInt or getLong, says it
+     * should be. Writing to an array must give the same bytes as writing to a buffer,
+     * and reading either back, from buffer or array, must give the same header.
+     */
+    static void recordHeaderTest() {
+
+        for (ByteOrder const & order : {ByteOrder::ENDIAN_BIG, ByteOrder::ENDIAN_LITTLE}) {
+            for (uint32_t trial=0; trial < TRIALS; trial++) {
+                RecordHeader h;
+                fillRecordHeader(h, trial);
+                uint32_t headerBytes = h.getHeaderLength();
+
+                ByteBuffer buf(ROOM);
+                buf.order(order);
+                h.writeHeader(buf, 0);
+
+                // Old way, one word at a time
+                uint32_t compressionWord = (h.getCompressionType() << 28) | h.getCompressedDataLengthWords();
+                check((uint32_t)buf.getInt(RecordHeader::RECORD_LENGTH_OFFSET) == h.getLengthWords(), "record length", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::RECORD_NUMBER_OFFSET) == h.getRecordNumber(), "record number", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::HEADER_LENGTH_OFFSET) == headerBytes/4, "header length", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::EVENT_COUNT_OFFSET) == h.getEntries(), "event count", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::INDEX_ARRAY_OFFSET) == h.getIndexLength(), "index length", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::BIT_INFO_OFFSET) == h.getBitInfoWord(), "bit info", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::USER_LENGTH_OFFSET) == h.getUserHeaderLength(), "user header length", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::MAGIC_OFFSET) == RecordHeader::HEADER_MAGIC, "magic #", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::UNCOMPRESSED_LENGTH_OFFSET) == h.getDataLength(), "data length", trial, order);
+                check((uint32_t)buf.getInt(RecordHeader::COMPRESSION_TYPE_OFFSET) == compressionWord, "compression word", trial, order);
+                check((uint64_t)buf.getLong(RecordHeader::REGISTER1_OFFSET) == h.getUserRegisterFirst(), "register 1", trial, order);
+                check((uint64_t)buf.getLong(RecordHeader::REGISTER2_OFFSET) == h.getUserRegisterSecond(), "register 2", trial, order);
+                if (h.hasChecksum()) {
+                    check((uint32_t)buf.getInt(RecordHeader::CHECKSUM_OFFSET) == h.getChecksum(), "checksum", trial, order);
+                }
+                if (h.hasTimeRange()) {
+                    check((uint64_t)buf.getLong(h.getTimeRangeOffset()) == h.getTimeMin(), "time min", trial, order);
+                    check((uint64_t)buf.getLong(h.getTimeRangeOffset() + 8) == h.getTimeMax(), "time max", trial, order);
+                }
+
+                // Writing to an array, over junk, must give the same bytes
+                uint8_t array[ROOM];
+                std::memset(array, 0xa5, ROOM);
+                h.writeHeader(array, order);
+                check(std::memcmp(array, buf.array(), headerBytes) == 0, "array written differs from buffer", trial, order);
+
+                // Read back from buffer and from array, guessing the wrong order half the time
+                RecordHeader fromBuf, fromArray;
+                fromBuf.readHeader(buf, 0);
+                ByteOrder guess = trial % 2 ? order.getOppositeEndian() : order;
+                fromArray.readHeader(array, guess);
+                check(sameRecordHeader(fromBuf, h), "header read from buffer differs", trial, order);
+                check(sameRecordHeader(fromArray, h), "header read from array differs", trial, order);
+                check(fromArray.getByteOrder() == order, "byte order read from array", trial, order);
+            }
+        }
+    }
+
+
+    /**
+     * Write file headers, word by word, the old way, in each byte order. Reading each must
+     * give back the values written, and writing it must give back the same bytes.
+     */
+    static void fileHeaderTest() {
+
+        for (ByteOrder const & order : {ByteOrder::ENDIAN_BIG, ByteOrder::ENDIAN_LITTLE}) {
+            for (uint32_t trial=0; trial < TRIALS; trial++) {
+                uint32_t fileNumber = (uint32_t) rng();
+                uint32_t entries    = (uint32_t) rng() % 100000;
+                uint32_t indexLen   = 4 * ((uint32_t) rng() % 1000);
+                uint32_t userLen    = (uint32_t) rng() % 10000;
+                uint64_t userReg    = rng();
+                uint64_t trailerPos = rng() >> 8;
+                uint32_t int1       = (uint32_t) rng();
+                uint32_t int2       = (uint32_t) rng();
+                // The user header's padding is part of the bit info word
+                uint32_t bitInfo    = FileHeader::generateBitInfoWord(6, trial % 2 == 0, trial % 3 == 0, trial % 5 == 0) |
+                                      Util::getPadding(userLen) << 20;
+
+                ByteBuffer buf(ROOM);
+                buf.order(order);
+                buf.putInt(FileHeader::FILE_ID_OFFSET, FileHeader::EVIO_FILE_UNIQUE_WORD);
+                buf.putInt(FileHeader::FILE_NUMBER_OFFSET, fileNumber);
+                buf.putInt(FileHeader::HEADER_LENGTH_OFFSET, FileHeader::HEADER_SIZE_WORDS);
+                buf.putInt(FileHeader::RECORD_COUNT_OFFSET, entries);
+                buf.putInt(FileHeader::INDEX_ARRAY_OFFSET, indexLen);
+                buf.putInt(FileHeader::BIT_INFO_OFFSET, bitInfo);
+                buf.putInt(FileHeader::USER_LENGTH_OFFSET, userLen);
+                buf.putInt(FileHeader::MAGIC_OFFSET, FileHeader::HEADER_MAGIC);
+                buf.putLong(FileHeader::REGISTER1_OFFSET, userReg);
+                buf.putLong(FileHeader::TRAILER_POSITION_OFFSET, trailerPos);
+                buf.putInt(FileHeader::INT1_OFFSET, int1);
+                buf.putInt(FileHeader::INT2_OFFSET, int2);
+
+                FileHeader h;
+                h.readHeader(buf, 0);
+                check(h.getFileId() == FileHeader::EVIO_FILE_UNIQUE_WORD, "file id", trial, order);
+                check(h.getFileNumber() == fileNumber, "file number", trial, order);
+                check(h.getHeaderLength() == FileHeader::HEADER_SIZE_BYTES, "header length", trial, order);
+                check(h.getEntries() == entries, "record count", trial, order);
+                check(h.getIndexLength() == indexLen, "index length", trial, order);
+                check(h.getBitInfoWord() == bitInfo, "bit info", trial, order);
+                check(h.getUserHeaderLength() == userLen, "user header length", trial, order);
+                check(h.getUserRegister() == userReg, "user register", trial, order);
+                check(h.getTrailerPosition() == trailerPos, "trailer position", trial, order);
+                check(h.getUserIntFirst() == int1, "user int 1", trial, order);
+                check(h.getUserIntSecond() == int2, "user int 2", trial, order);
+                check(h.getByteOrder() == order, "byte order", trial, order);
+
+                ByteBuffer out(ROOM);
+                out.order(order);
+                h.writeHeader(out, 0);
+                check(std::memcmp(out.array(), buf.array(), FileHeader::HEADER_SIZE_BYTES) == 0,
+                      "header written differs from header read", trial, order);
+            }
+        }
+    }
+
+}
+
+
+
+int main() {
+    evio::recordHeaderTest();
+    evio::fileHeaderTest();
+
+    if (evio::failures > 0) {
+        cout << "FAILED: " << evio::failures << " header checks" << endl;
+        return 1;
+    }
+
+    cout << "Record and file headers encode and decode as written word by word" << endl;
+    return 0;
+}
@@ -23,6 +23,9 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <vector>
 #include <regex>
 #include <limits>
 #include <cstdio>
@@ -41,6 +44,19 @@ using namespace std;
 namespace evio {
 
 
+    /** Number of records passed through the supply. */
+    static const uint32_t RECORD_COUNT = 2000;
+
+    /** Highest id of any record released by a compression thread. */
+    static std::atomic<int64_t> maxReleasedId {-1};
+
+    /** Number of records released by a compression thread after a later record was. */
+    static std::atomic<uint32_t> releasedOutOfOrder {0};
+
+    /** For each record, has a compression thread finished with it? */
+    static std::atomic<bool> compressed[RECORD_COUNT];
+
+
 /////////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -48,6 +64,8 @@ namespace evio {
       * Class used to compressed items, "write" them, and put them back.
       * Last barrier on ring.
       * It is an interruptible thread from the boost library, and only 1 exists.
+      * It checks that records arrive in the order they were published,
+      * and only once compressed.
       */
     class Writer2 {
 
@@ -60,6 +78,13 @@ namespace evio {
 
     public:
 
+        /** Number of records "written". */
+        uint32_t written = 0;
+        /** Number of records which arrived out of order. */
+        uint32_t misordered = 0;
+        /** Number of records which arrived before being compressed. */
+        uint32_t uncompressed = 0;
+
         /**
          * Constructor.
          * @param recSupply
@@ -72,25 +97,30 @@ namespace evio {
             thd = boost::thread([this]() {this->run();});
         }
 
-        /** Stop the thread. */
-        void stopThread() {
-            // Send signal to interrupt it
-            thd.interrupt();
-            // Wait for it to stop
+        /** Wait for the thread to finish. */
+        void joinThread() {
             thd.join();
         }
 
         /** Run this method in thread. */
         void run() {
             try {
-                while (true) {
+                while (written < RECORD_COUNT) {
                     // Get the next record for this thread to write
-                    auto item = supply->getToWrite();
-                    cout << "   W : v" << item->getId() << endl;
+                    auto & item = supply->getToWrite();
+                    if (item->getId() != written) {
+                        cout << "   W : expected v" << written << ", got v" << item->getId() << endl;
+                        misordered++;
+                    }
+                    else if (!compressed[written].load()) {
+                        cout << "   W : got v" << written << " before it was compressed" << endl;
+                        uncompressed++;
+                    }
+                    written++;
                     supply->releaseWriterSequential(item);
                 }
             }
-            catch (boost::thread_interrupted & e) {
+            catch (std::exception & e) {
                 cout << "     Writer: INTERRUPTED, return" << endl;
             }
         }
@@ -102,27 +132,26 @@ namespace evio {
 
     /**
      * Class used to take items from ring buffer, "compress" them, and place them back.
+     * Thread 0 takes longer with every 8th record, so that records after it, taken by
+     * other threads, are released first.
      */
     class Compressor2 {
 
     private:
 
+        /** Keep track of this thread with id number. */
+        uint32_t threadNumber;
         /** Supply of RecordRingItems. */
         std::shared_ptr<RecordSupply> supply;
-        /** Thread which does the file writing. */
+        /** Thread which does the compressing. */
         boost::thread thd;
-        /** Keep track of this thread with id number. */
-        uint32_t threadNumber;
 
     public:
 
           /**
            * Constructor.
            * @param threadNum
-           * @param threadCount
-           * @param ringBuf
-           * @param barrier
-           * @param sequence
+           * @param recSupply
            */
         Compressor2(uint32_t threadNum, std::shared_ptr<RecordSupply> & recSupply) :
                     threadNumber(threadNum), supply(recSupply)  {}
@@ -133,11 +162,8 @@ namespace evio {
             thd = boost::thread([this]() {this->run();});
         }
 
-        /** Stop the thread. */
-        void stopThread() {
-            // Send signal to interrupt it
-            thd.interrupt();
-            // Wait for it to stop
+        /** Wait for the thread to finish. */
+        void joinThread() {
             thd.join();
         }
 
@@ -145,29 +171,28 @@ namespace evio {
         void run() {
 
             try {
+                while (true) {
+                    // Get the next record for any thread to compress,
+                    // no need to release records other threads take first.
+                    auto & item = supply->getToCompress(threadNumber);
+                    int64_t id = (int64_t) item->getId();
 
-                // The first time through, we need to release all records coming before
-                // our first in case there are < threadNumber records before close() is called.
-                // This way close() is not waiting for thread #12 to get and subsequently
-                // release items 0 - 11 when there were only 5 records total.
-                // (threadNumber starts at 0).
-                if (threadNumber > 0) {
-                    supply->release(threadNumber, threadNumber - 1);
-                }
+                    if (threadNumber == 0 && id % 8 == 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    }
 
-                while (true) {
-                    // Get the next record for this thread to compress
-                    auto item = supply->getToCompress(threadNumber);
-                    cout << "   C" << threadNumber << ": v" << item->getId() << endl;
+                    // Note any record finished after one published later
+                    int64_t maxId = maxReleasedId.load();
+                    while (id > maxId && !maxReleasedId.compare_exchange_weak(maxId, id)) {}
+                    if (id < maxId) releasedOutOfOrder++;
+                    compressed[id] = true;
 
                     // Release back to supply
                     supply->releaseCompressor(item);
-
-                    std::this_thread::sleep_for(2s);
                 }
             }
             catch (std::exception & e) {
-                cout << "Com" << threadNumber << ": INTERRUPTED, return" << endl;
+                // errorAlert() called once all records are written
             }
         }
     };
@@ -176,7 +201,7 @@ namespace evio {
 
 
 
-    static void recordSupplyTest() {
+    static int recordSupplyTest() {
 
         /** Threads used to compress data. */
         std::vector<Compressor2> compressorThreads;
@@ -185,7 +210,7 @@ namespace evio {
         std::vector<Writer2> writerThreads;
 
         /** Number of threads doing compression simultaneously. */
-        const uint32_t compressionThreadCount = 2;
+        const uint32_t compressionThreadCount = 4;
 
         /** Number of records held in this supply. */
         const uint32_t ringSize = 32;
@@ -203,12 +228,12 @@ namespace evio {
 
         // Create compression threads
         compressorThreads.reserve(compressionThreadCount);
-        for (int i=0; i < compressionThreadCount; i++) {
+        for (uint32_t i=0; i < compressionThreadCount; i++) {
             compressorThreads.emplace_back(i, supply);
         }
 
         // Start compression threads
-        for (int i=0; i < compressionThreadCount; i++) {
+        for (uint32_t i=0; i < compressionThreadCount; i++) {
             compressorThreads[i].startThread();
         }
 
@@ -216,26 +241,268 @@ namespace evio {
         writerThreads.emplace_back(supply);
         writerThreads[0].startThread();
 
+        for (uint32_t counter = 0; counter < RECORD_COUNT; counter++) {
+            // Producer gets next available record
+            auto & item = supply->get();
+            item->setId(counter);
+            supply->publish(item);
+        }
+
+        // Once all are written, stop the compression threads waiting for more
+        writerThreads[0].joinThread();
+        supply->errorAlert();
+        for (uint32_t i=0; i < compressionThreadCount; i++) {
+            compressorThreads[i].joinThread();
+        }
+
+        Writer2 & writer = writerThreads[0];
+        cout << "Wrote " << writer.written << " records, " << releasedOutOfOrder <<
+                " compressed out of order, " << writer.misordered << " written out of order, " <<
+                writer.uncompressed << " written before being compressed" << endl;
+
+        if (writer.written != RECORD_COUNT || writer.misordered > 0 || writer.uncompressed > 0) {
+            cout << "FAILED: records not written in the order published once compressed" << endl;
+            return 1;
+        }
+        if (releasedOutOfOrder == 0) {
+            cout << "FAILED: no records compressed out of order, ordering not tested" << endl;
+            return 1;
+        }
+
+        cout << "Records compressed out of order were written in order" << endl;
+        return 0;
+    }
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Pass records through the supply in batches: the producer claims and publishes
+     * several at once, compressing threads take up to 4 at once, and the writer
+     * takes all that are compressed. Check that records still reach the writer
+     * in the order published, only once compressed, and that batches were formed.
+     * @return 0 if successful, else 1.
+     */
+    static int batchedSupplyTest() {
+
+        const uint32_t compressionThreadCount = 4;
+        const uint32_t ringSize = 32;
+        ByteOrder byteOrder = ByteOrder::ENDIAN_LITTLE;
+        Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED;
+
+        std::shared_ptr<RecordSupply> supply =
+                std::make_shared<RecordSupply>(ringSize, byteOrder,
+                                               compressionThreadCount,
+                                               0, 0, compressionType);
+
+        for (uint32_t i=0; i < RECORD_COUNT; i++) {
+            compressed[i] = false;
+        }
+
+        // Compressing threads, each taking up to 4 records at a time
+        std::vector<boost::thread> compressorThreads;
+        for (uint32_t t=0; t < compressionThreadCount; t++) {
+            compressorThreads.emplace_back([supply, t]() {
+                try {
+                    while (true) {
+                        int64_t first;
+                        uint32_t count = supply->getToCompress(t, 4, first);
+                        if (t == 0) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        }
+                        for (int64_t seq = first; seq < first + count; seq++) {
+                            compressed[supply->getItem(seq)->getId()] = true;
+                        }
+                        supply->releaseCompressor(first, count);
+                    }
+                }
+                catch (std::exception & e) {
+                    // errorAlert() called once all records are written
+                }
+            });
+        }
+
+        // Writing thread, taking all records available at once
+        uint32_t written = 0, misordered = 0, uncompressed = 0, batches = 0, maxBatch = 0;
+        boost::thread writerThread([&]() {
+            while (written < RECORD_COUNT) {
+                int64_t first;
+                uint32_t count = supply->getToWrite(ringSize, first);
+                batches++;
+                maxBatch = std::max(maxBatch, count);
+                for (int64_t seq = first; seq < first + count; seq++) {
+                    auto & item = supply->getItem(seq);
+                    if (item->getId() != written) {
+                        cout << "   W : expected v" << written << ", got v" << item->getId() << endl;
+                        misordered++;
+                    }
+                    else if (!compressed[written].load()) {
+                        cout << "   W : got v" << written << " before it was compressed" << endl;
+                        uncompressed++;
+                    }
+                    written++;
+                }
+                supply->releaseWriter(first, count);
+            }
+        });
+
+        // Producer claims and publishes 1 to 5 records at a time
         uint32_t counter = 0;
+        while (counter < RECORD_COUNT) {
+            uint32_t count = std::min(1 + counter % 5, RECORD_COUNT - counter);
+            int64_t first = supply->get(count);
+            for (int64_t seq = first; seq < first + count; seq++) {
+                supply->getItem(seq)->setId(counter++);
+            }
+            supply->publish(first, count);
+        }
 
-        while (true) {
-            // Producer gets next available record
-            std::shared_ptr<RecordRingItem> item = supply->get();
-            item->setId(counter++);
-            cout << "P -> " << item->getId() << endl;
+        writerThread.join();
+        supply->errorAlert();
+        for (auto & thd : compressorThreads) {
+            thd.join();
+        }
+
+        cout << "Batched: wrote " << written << " records in " << batches << " batches, up to " <<
+                maxBatch << " at once, " << misordered << " written out of order, " <<
+                uncompressed << " written before being compressed" << endl;
+
+        if (written != RECORD_COUNT || misordered > 0 || uncompressed > 0) {
+            cout << "FAILED: batched records not written in the order published once compressed" << endl;
+            return 1;
+        }
+        if (maxBatch < 2) {
+            cout << "FAILED: writer never took more than one record at once, batching not tested" << endl;
+            return 1;
+        }
+
+        cout << "Batched records were written in order" << endl;
+        return 0;
+    }
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+
+    /**
+     * Fill records with events, pass them through a supply, and copy each record
+     * as its writer gets it. In a pass-through supply the producer builds records
+     * as it publishes them. Otherwise a compression thread builds them.
+     * @param passThrough if true, use a pass-through supply.
+     * @return bytes of each record, in the order written.
+     */
+    static std::vector<std::vector<uint8_t>> passRecords(bool passThrough) {
+
+        const uint32_t recordCount = 200;
+        const uint32_t ringSize = 16;
+        ByteOrder byteOrder = ByteOrder::ENDIAN_LITTLE;
+        Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED;
+
+        std::shared_ptr<RecordSupply> supply =
+                std::make_shared<RecordSupply>(ringSize, byteOrder, 1, 0, 0, compressionType,
+                                               false, RecordSupply::SPIN_THEN_BLOCK, 0, passThrough);
+
+        // The usual compressing thread, only when not passing straight through
+        boost::thread compressorThread;
+        if (!passThrough) {
+            compressorThread = boost::thread([supply]() {
+                try {
+                    while (true) {
+                        auto & item = supply->getToCompress(0);
+                        item->getRecord()->build();
+                        supply->releaseCompressor(item);
+                    }
+                }
+                catch (std::exception & e) {
+                    // errorAlert() called once all records are written
+                }
+            });
+        }
+
+        std::vector<std::vector<uint8_t>> records;
+        uint32_t wrongEvents = 0;
+        boost::thread writerThread([&]() {
+            while (records.size() < recordCount) {
+                auto & item = supply->getToWrite();
+                auto & record = item->getRecord();
+                if (record->getEventCount() != 1 + records.size() % 7) {
+                    cout << "   W : record " << records.size() << " has " << record->getEventCount() << " events" << endl;
+                    wrongEvents++;
+                }
+                const uint8_t *bytes = record->getBinaryBuffer()->array();
+                records.emplace_back(bytes, bytes + record->getHeader()->getLength());
+                supply->releaseWriterSequential(item);
+            }
+        });
+
+        // Each record has 1 to 7 banks of ints whose values depend on record and event
+        for (uint32_t r=0; r < recordCount; r++) {
+            auto & item = supply->get();
+            for (uint32_t ev=0; ev < 1 + r % 7; ev++) {
+                uint32_t words = 1 + ev;
+                ByteBuffer bank(4*(words + 2));
+                bank.order(byteOrder);
+                bank.putInt(words + 1);
+                bank.putInt(1 << 16 | 0x1 << 8 | ev);
+                for (uint32_t i=0; i < words; i++) {
+                    bank.putInt(r * 1000 + ev * 10 + i);
+                }
+                item->getRecord()->addEvent(bank.array(), bank.capacity());
+            }
             supply->publish(item);
         }
 
+        writerThread.join();
+        if (!passThrough) {
+            supply->errorAlert();
+            compressorThread.join();
+        }
 
+        // Spoil the result if any record lost events
+        if (wrongEvents > 0) records.clear();
+        return records;
     }
 
-}
 
+    /**
+     * Check that records built in a pass-through supply by the producer are
+     * identical to those built by a compression thread.
+     * @return 0 if successful, else 1.
+     */
+    static int passThroughSupplyTest() {
+        auto built = passRecords(false);
+        auto passed = passRecords(true);
+
+        uint32_t differ = 0;
+        for (size_t i=0; i < built.size() && i < passed.size(); i++) {
+            if (built[i] != passed[i]) {
+                if (differ++ < 5) {
+                    cout << "   record " << i << " differs, " << built[i].size() <<
+                            " bytes built by compressor, " << passed[i].size() << " passed through" << endl;
+                }
+            }
+        }
+
+        cout << "Pass-through: " << passed.size() << " records written, " << differ <<
+                " differ from those built by a compressor" << endl;
+
+        if (built.size() != passed.size() || passed.empty() || differ > 0) {
+            cout << "FAILED: pass-through records differ from compressed ones" << endl;
+            return 1;
+        }
 
+        cout << "Pass-through records are the same as those built by a compressor" << endl;
+        return 0;
+    }
 
-int main(int argc, char **argv) {
-    evio::recordSupplyTest();
-    return 0;
 }
 
 
+
+int main() {
+    int status = evio::recordSupplyTest();
+    status |= evio::batchedSupplyTest();
+    status |= evio::passThroughSupplyTest();
+    return status;
+}
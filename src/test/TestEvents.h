@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2026, Jefferson Science Associates
+ *
+ * Thomas Jefferson National Accelerator Facility
+ * Data Acquisition Group
+ *
+ * 12000, Jefferson Ave, Newport News, VA 23606
+ * Phone : (757)-269-7100
+ */
+
+
+#ifndef EVIO_6_0_TESTEVENTS_H
+#define EVIO_6_0_TESTEVENTS_H
+
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "eviocc.h"
+
+
+namespace evio {
+
+
+    /**
+     * Events shared by the tests which write a file and then check what is read back.
+     * Each event is a bank of ints whose size and contents depend only on its event
+     * number, so a test can remake any event it expects to read.
+     */
+    class TestEvents {
+
+    public:
+
+        /**
+         * Make a bank of ints whose contents depend on the event number.
+         * @param ev event number.
+         * @return buffer containing bank.
+         */
+        static std::shared_ptr<ByteBuffer> makeEvent(uint32_t ev) {
+            uint32_t words = 1 + ev % 9;
+            auto bank = std::make_shared<ByteBuffer>(4*(words + 2));
+            bank->order(ByteOrder::ENDIAN_LOCAL);
+            bank->putInt(words + 1);
+            bank->putInt(1 << 16 | 0x1 << 8 | (ev & 0xff));
+            for (uint32_t i=0; i < words; i++) {
+                bank->putInt(ev * 100 + i);
+            }
+            bank->flip();
+            return bank;
+        }
+
+
+        /**
+         * Is the given event the one made for the given event number?
+         * @param data event read.
+         * @param len  length of event read in bytes.
+         * @param ev   event number.
+         * @return true if it's the same as the event made by {@link #makeEvent(uint32_t)}.
+         */
+        static bool matches(std::shared_ptr<uint8_t> const & data, uint32_t len, uint32_t ev) {
+            auto expected = makeEvent(ev);
+            return data != nullptr && len == expected->limit() &&
+                   std::memcmp(data.get(), expected->array(), len) == 0;
+        }
+
+
+        /**
+         * Write events 0 to count-1 to a file.
+         * @param fileName        name of file.
+         * @param count           number of events.
+         * @param eventsPerRecord max number of events in each record.
+         * @param compressionType type of compression, none by default.
+         */
+        static void writeFile(std::string const & fileName, uint32_t count, uint32_t eventsPerRecord,
+                              Compressor::CompressionType compressionType = Compressor::UNCOMPRESSED) {
+            EventWriter writer(fileName, "", "", 1, 0, 8000000, eventsPerRecord, ByteOrder::ENDIAN_LOCAL,
+                               "", true, false, nullptr, 0, 0, 1, 1,
+                               compressionType, 1, 0, 0);
+            for (uint32_t ev=0; ev < count; ev++) {
+                auto event = makeEvent(ev);
+                writer.writeEvent(event);
+            }
+            writer.close();
+        }
+    };
+
+}
+
+
+#endif //EVIO_6_0_TESTEVENTS_H
@@ -0,0 +1,717 @@
+/*-----------------------------------------------------------------------------
+ * Copyright (c) 2026  Jefferson Science Associates
+ *
+ * This software was developed under a United States Government license
+ * described in the NOTICE file included as part of this distribution.
+ *
+ * Data Acquisition Group, 12000 Jefferson Ave., Newport News, VA 23606
+ * Email: coda@jlab.org  Tel: (757) 269-7100
+ *-----------------------------------------------------------------------------
+ *
+ * Description:
+ *  Throughput benchmarks of the C evio library
+ *
+ */
+
+ /**
+  * @file
+  * Benchmarks of evWrite, evRead, evReadNoCopy and evReadRandom to and from
+  * files, buffers, pipes and sockets, run the same way as the C++ EvioBenchmark:
+  * each benchmark's iteration count is tuned until a run lasts at least a minimum
+  * time, then the run is repeated and the median and minimum time per iteration
+  * are reported. One iteration opens a handle, writes or reads the same set of
+  * events, generated from a fixed seed, and closes it.<p>
+  *
+  * Each read benchmark also has a "swap" variant whose data are in the opposite
+  * byte order to the local one, so the cost of swapping is included. The C library
+  * only writes in the local byte order so there are no swapped write benchmarks.<p>
+  *
+  * With --json the results are printed in the same JSON form as EvioBenchmark --json
+  * so the C and C++ paths can be compared on the same hardware.
+  *
+  * Usage: evBenchmark [--filter=&lt;regex&gt;] [--min_time=&lt;sec&gt;] [--repetitions=&lt;n&gt;]
+  *                    [--dir=&lt;directory for files&gt;] [--events=&lt;n&gt;] [--json] [--list]
+  */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <regex.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "evio.h"
+
+
+/* Format constants, as in evio.c */
+#define FILE_TYPE       0x4556494F
+#define LASTBLOCK_MASK  0x400
+#define BANK_TYPE       0x10
+#define UINT32_TYPE     0x1
+#define CHILD_BANKS     4
+
+#define MAX_BENCHMARKS  64
+
+enum {OP_WRITE, OP_READ, OP_READ_NOCOPY, OP_READ_RANDOM};
+enum {MODE_FILE, MODE_FILE_MMAP, MODE_BUFFER, MODE_PIPE, MODE_SOCKET};
+
+static const char *opNames[]   = {"evWrite", "evRead", "evReadNoCopy", "evReadRandom"};
+static const char *modeNames[] = {"file", "file-mmap", "buffer", "pipe", "socket"};
+
+/** One benchmark. */
+typedef struct benchmark_t {
+    char name[64];
+    int  op;
+    int  mode;
+    int  swap;
+} benchmark;
+
+/** Events to write, all in one array. */
+static uint32_t *events;
+static uint32_t *eventStart;
+static uint32_t  eventCount = 10000;
+static uint32_t  maxEventWords;
+static uint64_t  eventBytes;
+
+/** Same events written by evio, in local and swapped byte order. */
+static uint32_t *dataLocal, *dataSwapped;
+static size_t    dataWords;
+static uint32_t *fileLocal, *fileSwapped;
+static size_t    fileWords;
+
+/** Buffers used by benchmarks. */
+static uint32_t *workBuf, *readBuf;
+static size_t    workWords;
+
+static char localFileName[512], swappedFileName[512], outFileName[512];
+static char localPipeCmd[600], swappedPipeCmd[600], outPipeCmd[600];
+
+static double   minTime = 0.5;
+static uint32_t repetitions = 5;
+static int      json = 0;
+
+/** Keeps results from being optimized away. */
+static volatile uint64_t benchmarkSink = 0;
+
+/** Socket listening on a loopback port for socket benchmarks. */
+static int listenFd = -1;
+static struct sockaddr_in listenAddr;
+
+/** Args of thread feeding or draining a socket. */
+typedef struct socketArgs_t {
+    int       fd;
+    uint32_t *data;
+    size_t    bytes;
+} socketArgs;
+
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.e-9*t.tv_nsec;
+}
+
+
+static uint32_t rngState = 0x12345678;
+
+/** Xorshift random numbers from a fixed seed. */
+static uint32_t nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+
+/**
+ * Generate the events, each a bank of 4 banks of 32 bit ints with between
+ * 64 and 4096 bytes in all. Half the data words compress well.
+ */
+static void generateEvents(void) {
+    uint32_t i, j, k, words, totalWords = 0, pos;
+
+    eventStart = (uint32_t *) malloc((eventCount + 1) * sizeof(uint32_t));
+    for (i=0; i < eventCount; i++) {
+        eventStart[i] = totalWords;
+        words = 16 + nextRandom() % (1024 - 16 + 1);
+        totalWords += words;
+    }
+    eventStart[eventCount] = totalWords;
+    events = (uint32_t *) malloc(totalWords * sizeof(uint32_t));
+    eventBytes = 4ULL * totalWords;
+    maxEventWords = 0;
+
+    for (i=0; i < eventCount; i++) {
+        uint32_t *ev = events + eventStart[i];
+        words = eventStart[i+1] - eventStart[i];
+        if (words > maxEventWords) maxEventWords = words;
+
+        ev[0] = words - 1;
+        ev[1] = (1 << 16) | (BANK_TYPE << 8) | (i & 0xff);
+        pos = 2;
+
+        /* Split what's left between the child banks */
+        for (j=0; j < CHILD_BANKS; j++) {
+            uint32_t dataLen = (words - 2) / CHILD_BANKS - 2;
+            if (j == CHILD_BANKS - 1) dataLen = words - pos - 2;
+            ev[pos]   = dataLen + 1;
+            ev[pos+1] = ((j + 2) << 16) | (UINT32_TYPE << 8) | j;
+            pos += 2;
+            for (k=0; k < dataLen; k++) {
+                ev[pos++] = (k % 2) ? nextRandom() : (0x100 + (k & 0xf));
+            }
+        }
+    }
+}
+
+
+/**
+ * Find the number of words of evio data, from the start of a file header
+ * if any, through the last record.
+ */
+static size_t dataLength(const uint32_t *buf) {
+    size_t pos = 0;
+
+    if (buf[0] == FILE_TYPE) {
+        pos = buf[2] + buf[4]/4 + (buf[6] + 3)/4;
+    }
+    while (1) {
+        uint32_t recWords = buf[pos];
+        int last = (buf[pos + 5] & LASTBLOCK_MASK) != 0;
+        pos += recWords;
+        if (last) return pos;
+    }
+}
+
+
+/** Swap the 2 words of each of a number of 64 bit values in place. */
+static void swap64(uint32_t *p, int count) {
+    int i;
+    for (i=0; i < count; i++, p += 2) {
+        uint32_t w0 = p[0];
+        p[0] = EVIO_SWAP32(p[1]);
+        p[1] = EVIO_SWAP32(w0);
+    }
+}
+
+
+/**
+ * Swap evio version 6 data, in local byte order, written by this library:
+ * any file header and its index, the records' headers and indexes, and their events.
+ * User headers are left alone as this program writes none.
+ */
+static void swapData(uint32_t *buf, size_t words) {
+    size_t pos = 0, i;
+
+    if (buf[0] == FILE_TYPE) {
+        uint32_t hdrWords = buf[2], indexWords = buf[4]/4, userWords = (buf[6] + 3)/4;
+        for (i=0; i < 8; i++) buf[i] = EVIO_SWAP32(buf[i]);
+        swap64(buf + 8, 2);
+        for (i=12; i < hdrWords + indexWords; i++) buf[i] = EVIO_SWAP32(buf[i]);
+        pos = hdrWords + indexWords + userWords;
+    }
+
+    while (pos < words) {
+        uint32_t *rec = buf + pos;
+        uint32_t recWords = rec[0], hdrWords = rec[2], count = rec[3];
+        uint32_t indexWords = rec[4]/4, userWords = (rec[6] + 3)/4;
+        uint32_t *ev = rec + hdrWords + indexWords + userWords;
+
+        for (i=0; i < 10; i++) rec[i] = EVIO_SWAP32(rec[i]);
+        swap64(rec + 10, 2);
+        for (i=hdrWords; i < hdrWords + indexWords; i++) rec[i] = EVIO_SWAP32(rec[i]);
+
+        for (i=0; i < count; i++) {
+            uint32_t evWords = ev[0] + 1;
+            evioswap(ev, 0, NULL);
+            ev += evWords;
+        }
+        pos += recWords;
+    }
+}
+
+
+/** Write all events to an open handle. @return 0 if OK. */
+static int writeEvents(int handle) {
+    uint32_t i;
+    for (i=0; i < eventCount; i++) {
+        if (evWrite(handle, events + eventStart[i]) != S_SUCCESS) return -1;
+    }
+    return 0;
+}
+
+
+/** Read a whole file into memory. @return its words, or NULL if error. */
+static uint32_t *readFile(const char *name, size_t *words) {
+    FILE *f = fopen(name, "r");
+    uint32_t *buf;
+    long bytes;
+
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    bytes = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = (uint32_t *) malloc(bytes);
+    if (fread(buf, 1, bytes, f) != (size_t) bytes) {
+        fclose(f);
+        free(buf);
+        return NULL;
+    }
+    fclose(f);
+    *words = bytes/4;
+    return buf;
+}
+
+
+/** Write memory to a file. @return 0 if OK. */
+static int writeFile(const char *name, const uint32_t *buf, size_t words) {
+    FILE *f = fopen(name, "w");
+    size_t n;
+    if (f == NULL) return -1;
+    n = fwrite(buf, 4, words, f);
+    fclose(f);
+    return n == words ? 0 : -1;
+}
+
+
+/**
+ * Write the events with evio into a buffer and a file, and make swapped copies.
+ * @return 0 if OK.
+ */
+static int prepareData(const char *dir) {
+    int handle;
+
+    sprintf(localFileName,   "%s/evBenchmark.ev", dir);
+    sprintf(swappedFileName, "%s/evBenchmarkSwapped.ev", dir);
+    sprintf(outFileName,     "%s/evBenchmarkOut.ev", dir);
+    sprintf(localPipeCmd,    "|cat %s", localFileName);
+    sprintf(swappedPipeCmd,  "|cat %s", swappedFileName);
+    sprintf(outPipeCmd,      "|cat > /dev/null");
+
+    /* Room for the events plus headers */
+    workWords = eventBytes/4 + eventBytes/16 + 1024*1024;
+    workBuf = (uint32_t *) malloc(4*workWords);
+    readBuf = (uint32_t *) malloc(4*maxEventWords);
+
+    if (evOpenBuffer((char *) workBuf, workWords, "w", &handle) != S_SUCCESS) return -1;
+    if (writeEvents(handle) != 0) return -1;
+    evClose(handle);
+
+    dataWords   = dataLength(workBuf);
+    dataLocal   = (uint32_t *) malloc(4*dataWords);
+    dataSwapped = (uint32_t *) malloc(4*dataWords);
+    memcpy(dataLocal, workBuf, 4*dataWords);
+    memcpy(dataSwapped, workBuf, 4*dataWords);
+    swapData(dataSwapped, dataWords);
+
+    if (evOpen(localFileName, "w", &handle) != S_SUCCESS) return -1;
+    if (writeEvents(handle) != 0) return -1;
+    evClose(handle);
+
+    fileLocal = readFile(localFileName, &fileWords);
+    if (fileLocal == NULL) return -1;
+    fileSwapped = (uint32_t *) malloc(4*fileWords);
+    memcpy(fileSwapped, fileLocal, 4*fileWords);
+    swapData(fileSwapped, fileWords);
+    return writeFile(swappedFileName, fileSwapped, fileWords);
+}
+
+
+/** Start listening on a loopback port for socket benchmarks. @return 0 if OK. */
+static int startListening(void) {
+    socklen_t len = sizeof(listenAddr);
+
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return -1;
+
+    memset(&listenAddr, 0, sizeof(listenAddr));
+    listenAddr.sin_family      = AF_INET;
+    listenAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listenAddr.sin_port        = 0;
+
+    if (bind(listenFd, (struct sockaddr *) &listenAddr, sizeof(listenAddr)) < 0 ||
+        listen(listenFd, 1) < 0 ||
+        getsockname(listenFd, (struct sockaddr *) &listenAddr, &len) < 0) {
+        close(listenFd);
+        listenFd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+
+/** Connect a pair of TCP sockets over loopback. @return 0 if OK. */
+static int connectSockets(int *readFd, int *writeFd) {
+    *writeFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (*writeFd < 0) return -1;
+    if (connect(*writeFd, (struct sockaddr *) &listenAddr, sizeof(listenAddr)) < 0) {
+        close(*writeFd);
+        return -1;
+    }
+    *readFd = accept(listenFd, NULL, NULL);
+    if (*readFd < 0) {
+        close(*writeFd);
+        return -1;
+    }
+    return 0;
+}
+
+
+/** Thread sending evio data down a socket, then closing it. */
+static void *feedSocket(void *arg) {
+    socketArgs *s = (socketArgs *) arg;
+    const char *p = (const char *) s->data;
+    size_t left = s->bytes;
+
+    while (left > 0) {
+        ssize_t n = write(s->fd, p, left);
+        if (n <= 0) break;
+        p += n;
+        left -= n;
+    }
+    close(s->fd);
+    return NULL;
+}
+
+
+/** Thread reading and throwing away all that's sent down a socket. */
+static void *drainSocket(void *arg) {
+    socketArgs *s = (socketArgs *) arg;
+    char *buf = (char *) malloc(1024*1024);
+
+    while (read(s->fd, buf, 1024*1024) > 0) {}
+    close(s->fd);
+    free(buf);
+    return NULL;
+}
+
+
+/**
+ * Read all events from an open handle.
+ * @return 0 if all were read, else -1.
+ */
+static int readEvents(int handle, int op) {
+    uint32_t i, len;
+    const uint32_t *ev;
+    uint64_t sum = 0;
+
+    if (op == OP_READ_RANDOM) {
+        for (i=1; i <= eventCount; i++) {
+            if (evReadRandom(handle, &ev, &len, i) != S_SUCCESS) return -1;
+            sum += ev[1];
+        }
+    }
+    else {
+        for (i=0; i < eventCount; i++) {
+            if (op == OP_READ) {
+                if (evRead(handle, readBuf, maxEventWords) != S_SUCCESS) return -1;
+                sum += readBuf[1];
+            }
+            else {
+                if (evReadNoCopy(handle, &ev, &len) != S_SUCCESS) return -1;
+                sum += ev[1];
+            }
+        }
+    }
+
+    benchmarkSink += sum;
+    return 0;
+}
+
+
+/**
+ * Run one iteration of a benchmark.
+ * @param b       benchmark.
+ * @param seconds filled with time taken by the timed part.
+ * @return 0 if OK, else -1.
+ */
+static int runIteration(const benchmark *b, double *seconds) {
+    int handle, status = 0, readFd = -1, writeFd = -1;
+    pthread_t thread;
+    socketArgs args;
+    double start;
+    char *flags;
+
+    /* Reading a buffer may swap it in place, so start with a new copy */
+    if (b->mode == MODE_BUFFER && b->op != OP_WRITE) {
+        memcpy(workBuf, b->swap ? dataSwapped : dataLocal, 4*dataWords);
+    }
+
+    if (b->mode == MODE_SOCKET && connectSockets(&readFd, &writeFd) != 0) {
+        return -1;
+    }
+
+    start = now();
+
+    if (b->op == OP_WRITE) {
+        switch (b->mode) {
+            case MODE_FILE:
+                status = evOpen(outFileName, "w", &handle);
+                break;
+            case MODE_FILE_MMAP:
+                status = evOpen(outFileName, "wm", &handle);
+                break;
+            case MODE_BUFFER:
+                status = evOpenBuffer((char *) workBuf, workWords, "w", &handle);
+                break;
+            case MODE_PIPE:
+                status = evOpen(outPipeCmd, "w", &handle);
+                break;
+            default:
+                args.fd = readFd;
+                pthread_create(&thread, NULL, drainSocket, &args);
+                status = evOpenSocket(writeFd, "w", &handle);
+        }
+
+        if (status == S_SUCCESS) {
+            status = writeEvents(handle);
+            evClose(handle);
+        }
+
+        if (b->mode == MODE_SOCKET) {
+            close(writeFd);
+            pthread_join(thread, NULL);
+        }
+    }
+    else {
+        flags = (b->op == OP_READ_RANDOM) ? "ra" : "r";
+        switch (b->mode) {
+            case MODE_FILE:
+                status = evOpen(b->swap ? swappedFileName : localFileName, flags, &handle);
+                break;
+            case MODE_BUFFER:
+                status = evOpenBuffer((char *) workBuf, dataWords, flags, &handle);
+                break;
+            case MODE_PIPE:
+                status = evOpen(b->swap ? swappedPipeCmd : localPipeCmd, flags, &handle);
+                break;
+            default:
+                args.fd    = writeFd;
+                args.data  = b->swap ? dataSwapped : dataLocal;
+                args.bytes = 4*dataWords;
+                pthread_create(&thread, NULL, feedSocket, &args);
+                status = evOpenSocket(readFd, flags, &handle);
+        }
+
+        if (status == S_SUCCESS) {
+            status = readEvents(handle, b->op);
+            evClose(handle);
+        }
+
+        if (b->mode == MODE_SOCKET) {
+            pthread_join(thread, NULL);
+            close(readFd);
+        }
+    }
+
+    *seconds = now() - start;
+    return status == S_SUCCESS ? 0 : -1;
+}
+
+
+/** Run a number of iterations. @return total time in seconds, or -1 if error. */
+static double runIterations(const benchmark *b, uint64_t iterations) {
+    double total = 0., secs;
+    uint64_t i;
+
+    for (i=0; i < iterations; i++) {
+        if (runIteration(b, &secs) != 0) return -1.;
+        total += secs;
+    }
+    return total;
+}
+
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * Find the number of iterations needed for a run to last minTime,
+ * then do the runs and report.
+ * @return 0 if OK, else -1.
+ */
+static int runOne(const benchmark *b, int first) {
+    uint64_t iterations = 1;
+    double secs, median, bytesPerSec, *nsPerIter;
+    uint32_t i;
+
+    while (1) {
+        secs = runIterations(b, iterations);
+        if (secs < 0.) return -1;
+        if (secs >= minTime || iterations >= 1000000000ULL) break;
+
+        /* Grow by the amount needed to reach minTime plus a margin, but at most 10x */
+        {
+            double mult = (secs <= 0.) ? 10. : 1.4 * minTime / secs;
+            uint64_t next;
+            if (mult > 10.) mult = 10.;
+            next = (uint64_t) (iterations * mult);
+            iterations = next > iterations ? next : iterations + 1;
+        }
+    }
+
+    nsPerIter = (double *) malloc(repetitions * sizeof(double));
+    for (i=0; i < repetitions; i++) {
+        secs = runIterations(b, iterations);
+        if (secs < 0.) {
+            free(nsPerIter);
+            return -1;
+        }
+        nsPerIter[i] = 1.e9 * secs / iterations;
+    }
+
+    qsort(nsPerIter, repetitions, sizeof(double), compareDoubles);
+    median = nsPerIter[repetitions/2];
+    if (repetitions % 2 == 0) {
+        median = (median + nsPerIter[repetitions/2 - 1]) / 2.;
+    }
+    bytesPerSec = median > 0. ? 1.e9 * eventBytes / median : 0.;
+
+    if (json) {
+        printf("%s    {\"name\": \"%s\", \"iterations\": %llu, \"median_ns\": %.1f, "
+               "\"min_ns\": %.1f, \"bytes_per_second\": %.0f}",
+               first ? "" : ",\n", b->name, (unsigned long long) iterations,
+               median, nsPerIter[0], bytesPerSec);
+    }
+    else {
+        printf("%-40s %13.3f ms %13.3f ms %12llu %10.1f MB/s\n", b->name, median/1.e6,
+               nsPerIter[0]/1.e6, (unsigned long long) iterations, bytesPerSec/1.e6);
+    }
+
+    free(nsPerIter);
+    return 0;
+}
+
+
+/** Register all benchmarks. @return number of them. */
+static int addBenchmarks(benchmark *list) {
+    int n = 0, op, mode, swap;
+
+    for (op = OP_WRITE; op <= OP_READ_RANDOM; op++) {
+        for (mode = MODE_FILE; mode <= MODE_SOCKET; mode++) {
+            /* Memory mapped writes only, random access only from files and buffers */
+            if (mode == MODE_FILE_MMAP && op != OP_WRITE) continue;
+            if (op == OP_READ_RANDOM && mode != MODE_FILE && mode != MODE_BUFFER) continue;
+
+            for (swap = 0; swap <= (op == OP_WRITE ? 0 : 1); swap++) {
+                list[n].op   = op;
+                list[n].mode = mode;
+                list[n].swap = swap;
+                sprintf(list[n].name, "C/%s/%s%s", opNames[op], modeNames[mode], swap ? "/swap" : "");
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+
+static void usage(void) {
+    printf("Usage: evBenchmark [--filter=<regex>] [--min_time=<sec>] [--repetitions=<n>]\n");
+    printf("                   [--dir=<directory for files>] [--events=<n>] [--json] [--list]\n");
+}
+
+
+int main(int argc, char **argv) {
+    benchmark list[MAX_BENCHMARKS];
+    const char *filter = ".*", *dir = "/tmp";
+    int i, count, listOnly = 0, first = 1;
+    regex_t re;
+
+    for (i=1; i < argc; i++) {
+        if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--min_time=", 11) == 0) {
+            minTime = atof(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--repetitions=", 14) == 0) {
+            repetitions = atoi(argv[i] + 14);
+            if (repetitions < 1) repetitions = 1;
+        }
+        else if (strncmp(argv[i], "--dir=", 6) == 0) {
+            dir = argv[i] + 6;
+        }
+        else if (strncmp(argv[i], "--events=", 9) == 0) {
+            eventCount = atoi(argv[i] + 9);
+            if (eventCount < 1) eventCount = 1;
+        }
+        else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        }
+        else if (strcmp(argv[i], "--list") == 0) {
+            listOnly = 1;
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    count = addBenchmarks(list);
+    if (listOnly) {
+        for (i=0; i < count; i++) printf("%s\n", list[i].name);
+        return 0;
+    }
+
+    if (regcomp(&re, filter, REG_EXTENDED | REG_NOSUB) != 0) {
+        printf("Bad filter %s\n", filter);
+        return 1;
+    }
+
+    generateEvents();
+    if (prepareData(dir) != 0) {
+        printf("Error writing data to %s\n", dir);
+        return 1;
+    }
+    if (startListening() != 0) {
+        printf("Error listening on loopback, socket benchmarks will fail\n");
+    }
+
+    if (json) {
+        printf("{\n  \"context\": {\"program\": \"evBenchmark\", \"cpus\": %ld, \"big_endian\": %s, "
+               "\"events\": %u, \"bytes_per_iteration\": %llu},\n  \"benchmarks\": [\n",
+               sysconf(_SC_NPROCESSORS_ONLN), evioIsLocalHostBigEndian() ? "true" : "false",
+               eventCount, (unsigned long long) eventBytes);
+    }
+    else {
+        printf("evBenchmark running on %ld cpus, %u events of %llu bytes per iteration\n\n",
+               sysconf(_SC_NPROCESSORS_ONLN), eventCount, (unsigned long long) eventBytes);
+        printf("%-40s %16s %16s %12s %15s\n", "Benchmark", "Time (median)", "Time (min)",
+               "Iterations", "Throughput");
+        printf("------------------------------------------------------------------------------------------------------\n");
+    }
+
+    for (i=0; i < count; i++) {
+        if (regexec(&re, list[i].name, 0, NULL, 0) != 0) continue;
+
+        if (runOne(&list[i], first) != 0) {
+            if (json) {
+                printf("%s    {\"name\": \"%s\", \"error\": true}", first ? "" : ",\n", list[i].name);
+            }
+            else {
+                printf("%-40s  ERROR\n", list[i].name);
+            }
+        }
+        first = 0;
+        fflush(stdout);
+    }
+
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+
+    regfree(&re);
+    if (listenFd >= 0) close(listenFd);
+    remove(localFileName);
+    remove(swappedFileName);
+    remove(outFileName);
+    return 0;
+}
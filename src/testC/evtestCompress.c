@@ -0,0 +1,177 @@
+/*-----------------------------------------------------------------------------
+ * Copyright (c) 2026  Jefferson Science Associates
+ *
+ * This software was developed under a United States Government license
+ * described in the NOTICE file included as part of this distribution.
+ *
+ * Data Acquisition Group, 12000 Jefferson Ave., Newport News, VA 23606
+ * Email: coda@jlab.org  Tel: (757) 269-7100
+ *-----------------------------------------------------------------------------
+ *
+ * Description:
+ *	Event I/O test program writing files with compressed records, by 0 to 4
+ *	compressing threads, both as a single file and split into several, then
+ *	reading every event back and comparing it with the one written.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "evio.h"
+
+#define EVENTS             20000
+#define EVENTS_PER_RECORD   2000
+#define MAX_THREADS            4
+#define SPLIT_BYTES       100000
+#define MAX_SPLITS           100
+
+static const char *baseName = "./evtestCompress.ev";
+static int failures = 0;
+
+
+static void fail(const char *test, const char *what, int status) {
+    if (failures++ < 20) {
+        printf("    %s: %s, status = %#x\n", test, what, status);
+    }
+}
+
+
+/** Make a bank of ints whose size and contents depend on the event number. */
+static uint32_t makeEvent(uint32_t *bank, uint32_t ev) {
+    uint32_t i, words = 1 + ev % 9;
+    bank[0] = words + 1;                       /* length */
+    bank[1] = 1 << 16 | 0x1 << 8 | (ev & 0xff); /* tag = 1, unsigned ints, num */
+    for (i=0; i < words; i++) {
+        bank[2 + i] = ev * 100 + i;
+    }
+    return words + 2;
+}
+
+
+/**
+ * Write all events to a file, or to files split every SPLIT_BYTES bytes,
+ * with records compressed by the given type and number of threads.
+ */
+static void writeEvents(const char *test, int type, uint32_t threads, int split) {
+    int handle, status;
+    uint32_t ev, bank[16], arg, comp[2];
+    uint64_t splitBytes = SPLIT_BYTES;
+
+    status = evOpen((char *)baseName, split ? "s" : "w", &handle);
+    if (status != S_SUCCESS) {fail(test, "open for writing", status); return;}
+
+    arg = EVENTS_PER_RECORD;
+    status = evIoctl(handle, "N", &arg);
+    if (status != S_SUCCESS) fail(test, "set events per record", status);
+
+    if (split) {
+        status = evIoctl(handle, "S", &splitBytes);
+        if (status != S_SUCCESS) fail(test, "set split size", status);
+    }
+
+    comp[0] = (uint32_t) type;
+    comp[1] = threads;
+    status = evIoctl(handle, "C", comp);
+    if (status != S_SUCCESS) fail(test, "start compressing", status);
+
+    for (ev=0; ev < EVENTS; ev++) {
+        makeEvent(bank, ev);
+        status = evWrite(handle, bank);
+        if (status != S_SUCCESS) {fail(test, "write", status); break;}
+    }
+
+    status = evClose(handle);
+    if (status != S_SUCCESS) fail(test, "close after writing", status);
+}
+
+
+/**
+ * Read the events of one file, comparing each with the one expected next.
+ * @return number of events read.
+ */
+static uint32_t readFile(const char *test, const char *fileName, uint32_t firstEvent) {
+    int handle, status;
+    uint32_t ev = firstEvent, len, bank[16], event[16];
+
+    status = evOpen((char *)fileName, "r", &handle);
+    if (status != S_SUCCESS) {fail(test, "open for reading", status); return 0;}
+
+    while ((status = evRead(handle, event, 16)) == S_SUCCESS) {
+        len = makeEvent(bank, ev);
+        if (memcmp(bank, event, 4*len) != 0) {
+            printf("    %s: event %u in %s differs from the one written\n", test, ev, fileName);
+            fail(test, "event read differs from event written", status);
+            break;
+        }
+        ev++;
+    }
+    if (status != EOF && status != S_SUCCESS) fail(test, "read", status);
+
+    evClose(handle);
+    return ev - firstEvent;
+}
+
+
+/** Read back all events written, from one file or all split files, then remove them. */
+static void readEvents(const char *test, int split) {
+    uint32_t count = 0;
+    char fileName[256];
+    int i, files = 0;
+    FILE *f;
+
+    if (!split) {
+        count = readFile(test, baseName, 0);
+        remove(baseName);
+    }
+    else {
+        for (i=0; i < MAX_SPLITS; i++) {
+            sprintf(fileName, "%s.%d", baseName, i);
+            if ((f = fopen(fileName, "r")) == NULL) {
+                /* Numbering may start at 1 */
+                if (files > 0 || i > 0) break;
+                continue;
+            }
+            fclose(f);
+            files++;
+            count += readFile(test, fileName, count);
+            remove(fileName);
+        }
+        if (files < 2) fail(test, "file not split", files);
+    }
+
+    if (count != EVENTS) {
+        printf("    %s: read %u of %u events\n", test, count, EVENTS);
+        fail(test, "wrong number of events read", (int) count);
+    }
+}
+
+
+int main()
+{
+    int type, split;
+    uint32_t threads;
+    char test[64];
+
+    printf("\nEvent I/O test of %d events written in compressed records by 0 to %d threads ...\n",
+           EVENTS, MAX_THREADS);
+
+    for (split=0; split < 2; split++) {
+        for (type=1; type <= 3; type++) {
+            for (threads=0; threads <= MAX_THREADS; threads++) {
+                sprintf(test, "type %d, %u threads%s", type, threads, split ? ", split" : "");
+                writeEvents(test, type, threads, split);
+                readEvents(test, split);
+            }
+        }
+    }
+
+    if (failures > 0) {
+        printf("    FAILED, %d errors\n\n", failures);
+        return 1;
+    }
+
+    printf("    All events read back as written\n\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*-----------------------------------------------------------------------------
+ * Copyright (c) 2026  Jefferson Science Associates
+ *
+ * This software was developed under a United States Government license
+ * described in the NOTICE file included as part of this distribution.
+ *
+ * Data Acquisition Group, 12000 Jefferson Ave., Newport News, VA 23606
+ * Email: coda@jlab.org  Tel: (757) 269-7100
+ *-----------------------------------------------------------------------------
+ *
+ * Description:
+ *	Event I/O test program opening, writing, reading and closing buffer
+ *	handles from many threads at once, so the handle table grows while
+ *	other threads are using their handles. Half of the handles are opened
+ *	with mutex locking turned off ("wx", "rx").
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "evio.h"
+
+#define THREADS         32
+#define HANDLES          8
+#define ROUNDS         200
+#define EVENTS          20
+#define BUFFER_WORDS  4096
+
+static int failures = 0;
+static pthread_mutex_t failMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void fail(int thread, int round, const char *what, int status) {
+    pthread_mutex_lock(&failMutex);
+    if (failures++ < 10) {
+        printf("    thread %d, round %d: %s, status = %#x\n", thread, round, what, status);
+    }
+    pthread_mutex_unlock(&failMutex);
+}
+
+
+/** Make a bank of ints whose contents depend on thread, round, handle and event. */
+static void makeEvent(uint32_t *bank, int thread, int round, int h, int ev) {
+    bank[0] = 5;                        /* length = 5 */
+    bank[1] = 1 << 16 | 0x1 << 8 | h;   /* tag = 1, unsigned ints, num = handle index */
+    bank[2] = (uint32_t) thread;
+    bank[3] = (uint32_t) round;
+    bank[4] = (uint32_t) ev;
+    bank[5] = bank[2] ^ bank[3] ^ bank[4];
+}
+
+
+static void *worker(void *arg) {
+    int thread = (int)(size_t)arg;
+    int round, h, ev, status;
+    int handles[HANDLES];
+    uint32_t *buffers[HANDLES], bank[6], event[16];
+
+    for (h=0; h < HANDLES; h++) {
+        buffers[h] = (uint32_t *) calloc(BUFFER_WORDS, sizeof(uint32_t));
+    }
+
+    for (round=0; round < ROUNDS; round++) {
+        /* Hold all handles open at once, so other threads must grow the table */
+        for (h=0; h < HANDLES; h++) {
+            status = evOpenBuffer((char *)buffers[h], BUFFER_WORDS, (h % 2) ? "wx" : "w", &handles[h]);
+            if (status != S_SUCCESS) {fail(thread, round, "open for writing", status); handles[h] = 0;}
+        }
+
+        for (ev=0; ev < EVENTS; ev++) {
+            for (h=0; h < HANDLES; h++) {
+                if (handles[h] == 0) continue;
+                makeEvent(bank, thread, round, h, ev);
+                status = evWrite(handles[h], bank);
+                if (status != S_SUCCESS) fail(thread, round, "write", status);
+            }
+        }
+
+        for (h=0; h < HANDLES; h++) {
+            if (handles[h] == 0) continue;
+            status = evClose(handles[h]);
+            if (status != S_SUCCESS) fail(thread, round, "close after writing", status);
+        }
+
+        /* Read back what was written */
+        for (h=0; h < HANDLES; h++) {
+            status = evOpenBuffer((char *)buffers[h], BUFFER_WORDS, (h % 2) ? "rx" : "r", &handles[h]);
+            if (status != S_SUCCESS) {fail(thread, round, "open for reading", status); continue;}
+
+            ev = 0;
+            while ((status = evRead(handles[h], event, 16)) == S_SUCCESS) {
+                makeEvent(bank, thread, round, h, ev++);
+                if (memcmp(bank, event, sizeof(bank)) != 0) {
+                    fail(thread, round, "event read differs from event written", status);
+                    break;
+                }
+            }
+            if (ev != EVENTS) fail(thread, round, "wrong number of events read", ev);
+
+            status = evClose(handles[h]);
+            if (status != S_SUCCESS) fail(thread, round, "close after reading", status);
+        }
+    }
+
+    for (h=0; h < HANDLES; h++) {
+        free(buffers[h]);
+    }
+    return NULL;
+}
+
+
+int main()
+{
+    int i;
+    pthread_t threads[THREADS];
+
+    printf("\nEvent I/O test of %d threads, each using %d buffer handles %d times ...\n",
+           THREADS, HANDLES, ROUNDS);
+
+    for (i=0; i < THREADS; i++) {
+        if (pthread_create(&threads[i], NULL, worker, (void *)(size_t)i) != 0) {
+            printf("    cannot create thread\n");
+            return 1;
+        }
+    }
+
+    for (i=0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (failures > 0) {
+        printf("    FAILED, %d errors\n\n", failures);
+        return 1;
+    }
+
+    printf("    All events read back as written\n\n");
+    return 0;
+}